@@ -41,8 +41,11 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <algorithm>
+#include <deque>
 #include <list>
 #include <stdexcept>
+#include <vector>
 
 using boost::assign::list_of;
 using namespace std;
@@ -70,6 +73,26 @@ struct ACNode : public Intermediate::Node
      */
     Intermediate::output_p last_output;
 
+    //! Child index entry: input byte and target of that byte's edge.
+    typedef pair<uint8_t, Intermediate::node_p> child_entry_t;
+
+    //! Child index: sorted by input byte.
+    typedef vector<child_entry_t> child_vector_t;
+
+    /**
+     * Index of single value edges, sorted by input.
+     *
+     * Maintained by aho_corasick_add_data() so that descent can binary
+     * search for the next node instead of scanning the edge list; for large
+     * dictionaries shallow nodes have high out degree and the scan
+     * dominates construction time.  Edges created elsewhere (patterns,
+     * edge splitting, deep copies) are not indexed, so the index is only
+     * complete when its size equals the number of edges; users must fall
+     * back to scanning edges() otherwise.  Entries, once added, stay valid
+     * as edges never change target.
+     */
+    child_vector_t children;
+
     /**
      * Prepend an output with content @a content.
      */
@@ -103,6 +126,41 @@ struct ACNode : public Intermediate::Node
     }
 };
 
+//! Order child index entries by input byte.
+struct child_by_input
+{
+    bool operator()(
+        const ACNode::child_entry_t& a,
+        const ACNode::child_entry_t& b
+    ) const
+    {
+        return a.first < b.first;
+    }
+};
+
+/**
+ * Find @a c in the child index of @a node.
+ *
+ * @param[in] node Node to search children of.
+ * @param[in] c    Input to search for.
+ * @return Iterator to entry for @a c or @c node->children.end() if absent.
+ */
+ACNode::child_vector_t::const_iterator find_child(
+    const ACNode* node,
+    uint8_t       c
+)
+{
+    ACNode::child_vector_t::const_iterator it = lower_bound(
+        node->children.begin(), node->children.end(),
+        make_pair(c, Intermediate::node_p()),
+        child_by_input()
+    );
+    if (it != node->children.end() && it->first != c) {
+        it = node->children.end();
+    }
+    return it;
+}
+
 /**
  * Next node for an input of @a c at node @a node or Intermediate::node_p().
  */
@@ -196,6 +254,17 @@ Intermediate::node_p find_next(
     uint8_t       c
 )
 {
+    const ACNode* ac_node = static_cast<const ACNode*>(node.get());
+    ACNode::child_vector_t::const_iterator it = find_child(ac_node, c);
+    if (it != ac_node->children.end()) {
+        return it->second;
+    }
+    if (ac_node->children.size() == node->edges().size()) {
+        // Index covers every edge; definitive miss.
+        return Intermediate::node_p();
+    }
+
+    // Unindexed edges exist, e.g., from patterns; scan the edge list.
     Intermediate::Node::edge_list_t next_edges = node->edges_for(c);
     if (next_edges.empty()) {
         return Intermediate::node_p();
@@ -214,7 +283,7 @@ void deep_copy(
 )
 {
     typedef pair<Intermediate::node_p, Intermediate::node_p> dst_src_t;
-    typedef list<dst_src_t> todo_t;
+    typedef deque<dst_src_t> todo_t;
 
     todo_t todo;
     todo.push_back(make_pair(dst_head, src_head));
@@ -321,7 +390,7 @@ void process_failures(Intermediate::Automata& automata)
 {
     assert(automata.start_node());
 
-    typedef list<Intermediate::node_p> node_list_t;
+    typedef deque<Intermediate::node_p> node_list_t;
     node_list_t todo;
 
     BOOST_FOREACH(
@@ -352,50 +421,69 @@ void process_failures(Intermediate::Automata& automata)
 
             Intermediate::node_p current_node = r->default_target();
             while (! cs.empty()) {
-                BOOST_FOREACH(const Intermediate::Edge& current_edge, current_node->edges()) {
-                    shared_cs.clear();
-                    set_intersection(
-                        current_edge.begin(), current_edge.end(),
-                        cs.begin(), cs.end(),
-                        back_inserter(shared_cs)
-                    );
-
-                    if (shared_cs.empty()) {
-                        // current_edge has no bearing on edge, skip.
-                        continue;
-                    }
-
-                    if (shared_cs.size() == cs.size()) {
-                        // current_edge absorbs everything.
+                const ACNode* current_ac =
+                    static_cast<const ACNode*>(current_node.get());
+                if (
+                    cs.size() == 1 &&
+                    current_ac->children.size() ==
+                        current_node->edges().size()
+                ) {
+                    // Single input and complete child index; binary search
+                    // instead of scanning every edge.  This is the common
+                    // case for dictionary (non-pattern) automata.
+                    ACNode::child_vector_t::const_iterator it =
+                        find_child(current_ac, cs.front());
+                    if (it != current_ac->children.end()) {
                         cs.clear();
-                        set_default_target(s, current_edge.target());
-                        break;
+                        set_default_target(s, it->second);
                     }
-
-                    // current_edge overlaps.  Split edge into overlap and
-                    // remainder.  new_edge will be overlap, edge will
-                    // become remainder.
-
-                    // Should never reach this case in a non-pattern based
-                    // AC run.
-                    Intermediate::Edge new_edge = split_edge(edge, shared_cs);
-                    r->edges().push_front(new_edge);
-                    Intermediate::node_p s2 = new_edge.target();
-                    todo.push_back(s2);
-                    set_default_target(s2, current_edge.target());
-                    // Reduce cs.
-                    remaining_cs.clear();
-                    set_difference(
-                        cs.begin(), cs.end(),
-                        shared_cs.begin(), shared_cs.end(),
-                        back_inserter(remaining_cs)
-                    );
-                    cs.swap(remaining_cs);
-
-                    // If we've handled everything, break early.  Note that while
-                    // loop will immediately terminate.
-                    if (cs.empty()) {
-                        break;
+                }
+                else {
+                    BOOST_FOREACH(const Intermediate::Edge& current_edge, current_node->edges()) {
+                        shared_cs.clear();
+                        set_intersection(
+                            current_edge.begin(), current_edge.end(),
+                            cs.begin(), cs.end(),
+                            back_inserter(shared_cs)
+                        );
+    
+                        if (shared_cs.empty()) {
+                            // current_edge has no bearing on edge, skip.
+                            continue;
+                        }
+    
+                        if (shared_cs.size() == cs.size()) {
+                            // current_edge absorbs everything.
+                            cs.clear();
+                            set_default_target(s, current_edge.target());
+                            break;
+                        }
+    
+                        // current_edge overlaps.  Split edge into overlap and
+                        // remainder.  new_edge will be overlap, edge will
+                        // become remainder.
+    
+                        // Should never reach this case in a non-pattern based
+                        // AC run.
+                        Intermediate::Edge new_edge = split_edge(edge, shared_cs);
+                        r->edges().push_front(new_edge);
+                        Intermediate::node_p s2 = new_edge.target();
+                        todo.push_back(s2);
+                        set_default_target(s2, current_edge.target());
+                        // Reduce cs.
+                        remaining_cs.clear();
+                        set_difference(
+                            cs.begin(), cs.end(),
+                            shared_cs.begin(), shared_cs.end(),
+                            back_inserter(remaining_cs)
+                        );
+                        cs.swap(remaining_cs);
+    
+                        // If we've handled everything, break early.  Note that while
+                        // loop will immediately terminate.
+                        if (cs.empty()) {
+                            break;
+                        }
                     }
                 }
 
@@ -837,6 +925,18 @@ void aho_corasick_add_data(
         Intermediate::Edge& edge = current_node->edges().back();
         edge.target() = boost::make_shared<ACNode>();
         edge.add(c);
+
+        // Keep child index sorted by input.
+        ACNode* ac_node = static_cast<ACNode*>(current_node.get());
+        ac_node->children.insert(
+            lower_bound(
+                ac_node->children.begin(), ac_node->children.end(),
+                make_pair(c, Intermediate::node_p()),
+                child_by_input()
+            ),
+            make_pair(c, edge.target())
+        );
+
         current_node = edge.target();
     }
 
@@ -849,12 +949,12 @@ void aho_corasick_add_pattern(
     const Intermediate::byte_vector_t& data
 )
 {
-    list<Intermediate::node_p> current_nodes;
+    vector<Intermediate::node_p> current_nodes;
     current_nodes.push_back(automata.start_node());
 
     size_t pattern_i = 0;
 
-    list<Intermediate::node_p> next_current_nodes;
+    vector<Intermediate::node_p> next_current_nodes;
     Intermediate::byte_vector_t nodshared_cs;
     Intermediate::byte_vector_t shared_cs;
     Intermediate::byte_vector_t orig_cs;
@@ -924,7 +1024,7 @@ void aho_corasick_add_pattern(
             }
         }
 
-        current_nodes = next_current_nodes;
+        current_nodes.swap(next_current_nodes);
         if (pattern_i == pattern.length()) {
             // handle outputs
             BOOST_FOREACH(const Intermediate::node_p& node, current_nodes) {
@@ -58,6 +58,8 @@ int main(int argc, char **argv)
     size_t id_width = 0;
     size_t align_to = 1;
     double high_node_weight = 1.0;
+    size_t jobs = 1;
+    size_t dense_degree = 0;
 
     po::options_description desc("Options:");
     desc.add_options()
@@ -80,6 +82,15 @@ int main(int argc, char **argv)
             "> 1 favors low nodes; < 1 favors high nodes; 1.0 = smallest; "
             "default 1.0"
         )
+        ("jobs,j", po::value<size_t>(&jobs),
+            "number of threads for the minimal id width search; "
+            "output is identical for any value; default 1"
+        )
+        ("dense,e", po::value<size_t>(&dense_degree),
+            "emit full 256 entry transition tables for nodes of out degree "
+            ">= this with every byte resolved; trades space for a single "
+            "indexed load per byte; 0 = off; default 0"
+        )
         ;
 
     po::positional_options_description pd;
@@ -152,6 +163,8 @@ int main(int argc, char **argv)
         configuration.id_width = id_width;
         configuration.align_to = align_to;
         configuration.high_node_weight = high_node_weight;
+        configuration.jobs = jobs;
+        configuration.dense_degree = dense_degree;
         try {
             result = EudoxusCompiler::compile(automata, configuration);
         }
@@ -48,10 +48,13 @@
 #include <ironautomata/vls.h>
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 struct ia_eudoxus_t
@@ -61,6 +64,14 @@ struct ia_eudoxus_t
      */
     const ia_eudoxus_automata_t *automata;
 
+    /**
+     * If non-zero, @c automata is a mapping of this many bytes and is
+     * released with munmap() rather than free().
+     *
+     * @sa ia_eudoxus_create_from_path_mmap()
+     */
+    size_t mmap_length;
+
     /**
      * Most recent error message.
      *
@@ -80,6 +91,25 @@ struct ia_eudoxus_t
      * otherwise.
      */
     bool free_error_message;
+
+    /**
+     * Is @c start_candidate meaningful?
+     *
+     * Set at creation time when the start node is proved safe to skip
+     * through: it emits no output and every non-candidate byte consumes
+     * one input byte and returns to the start node.
+     */
+    bool start_skip_valid;
+
+    /**
+     * Bytes with an observable transition out of the start node.
+     *
+     * Bit @c b (byte <tt>b / 8</tt>, mask <tt>1 << (b % 8)</tt>) set means
+     * input byte @c b must be run through node dispatch while in the start
+     * node.  Clear means the byte provably self-loops and the execute loop
+     * may skip it.  Only meaningful if @c start_skip_valid is true.
+     */
+    uint8_t start_candidate[32];
 };
 
 struct ia_eudoxus_state_t
@@ -177,6 +207,19 @@ enum ia_eudoxus_extended_command_t
 };
 typedef enum ia_eudoxus_extended_command_t ia_eudoxus_extended_command_t;
 
+/**
+ * Analyze the start node of @a eudoxus for skip-ahead execution.
+ *
+ * Fills in @c start_skip_valid and @c start_candidate.  Defined after the
+ * subengines as it drives them to probe transitions.
+ *
+ * @param[in,out] eudoxus Engine to analyze.
+ */
+static
+void ia_eudoxus_compute_start_skip(
+    ia_eudoxus_t *eudoxus
+);
+
 ia_eudoxus_result_t ia_eudoxus_create(
     ia_eudoxus_t **out_eudoxus,
     char          *data
@@ -195,6 +238,7 @@ ia_eudoxus_result_t ia_eudoxus_create(
     }
 
     eudoxus->automata           = (ia_eudoxus_automata_t *)data;
+    eudoxus->mmap_length        = 0;
     eudoxus->error_message      = NULL;
     eudoxus->free_error_message = false;
 
@@ -208,6 +252,8 @@ ia_eudoxus_result_t ia_eudoxus_create(
         goto finish;
     }
 
+    ia_eudoxus_compute_start_skip(eudoxus);
+
 finish:
     if (rc != IA_EUDOXUS_OK) {
         if (eudoxus != NULL) {
@@ -267,6 +313,47 @@ ia_eudoxus_result_t ia_eudoxus_create_from_path(
     return result;
 }
 
+ia_eudoxus_result_t ia_eudoxus_create_from_path_mmap(
+    ia_eudoxus_t **out_eudoxus,
+    const char    *path
+)
+{
+    int                 fd;
+    struct stat         file_stat;
+    void               *data;
+    ia_eudoxus_result_t rc;
+
+    if (out_eudoxus == NULL || path == NULL) {
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return IA_EUDOXUS_EALLOC;
+    }
+
+    rc = ia_eudoxus_create(out_eudoxus, (char *)data);
+    if (rc != IA_EUDOXUS_OK) {
+        munmap(data, file_stat.st_size);
+        return rc;
+    }
+
+    (*out_eudoxus)->mmap_length = file_stat.st_size;
+
+    return IA_EUDOXUS_OK;
+}
+
 void ia_eudoxus_destroy(
     ia_eudoxus_t *eudoxus
 )
@@ -278,7 +365,12 @@ void ia_eudoxus_destroy(
     /* Better to cast away const here than to not have const checks for
      * all uses. */
     if (eudoxus->automata) {
-        free((void *)eudoxus->automata);
+        if (eudoxus->mmap_length > 0) {
+            munmap((void *)eudoxus->automata, eudoxus->mmap_length);
+        }
+        else {
+            free((void *)eudoxus->automata);
+        }
     }
     if (eudoxus->error_message != NULL && eudoxus->free_error_message) {
         free((void *)eudoxus->error_message);
@@ -464,6 +556,52 @@ ia_eudoxus_result_t ia_eudoxus_execute_impl(
     }
 }
 
+static
+void ia_eudoxus_compute_start_skip(
+    ia_eudoxus_t *eudoxus
+)
+{
+    const ia_eudoxus_node_t *start_node;
+
+    eudoxus->start_skip_valid = false;
+    memset(eudoxus->start_candidate, 0xff, sizeof(eudoxus->start_candidate));
+
+    start_node = (const ia_eudoxus_node_t *)(
+        (const char *)eudoxus->automata + eudoxus->automata->start_index
+    );
+
+    /* A start node with output makes every visit observable; no byte can
+     * be skipped. */
+    if (IA_EUDOXUS_FLAG(start_node->header, 0)) {
+        return;
+    }
+
+    /* Probe each byte through one step of the real engine.  A byte is
+     * skippable exactly when that step consumes it and lands back on the
+     * start node: executing it would have no observable effect. */
+    for (int i = 0; i < 256; ++i) {
+        uint8_t            byte = (uint8_t)i;
+        ia_eudoxus_state_t probe_state;
+        ia_eudoxus_result_t rc;
+
+        memset(&probe_state, 0, sizeof(probe_state));
+        probe_state.eudoxus = eudoxus;
+        probe_state.node    = start_node;
+
+        rc = ia_eudoxus_execute_impl(&probe_state, &byte, 1, false);
+        if (
+            rc == IA_EUDOXUS_OK &&
+            probe_state.node == start_node &&
+            probe_state.byte_index == 0 &&
+            probe_state.remaining_bytes == 0
+        ) {
+            eudoxus->start_candidate[i / 8] &= ~(1 << (i % 8));
+        }
+    }
+
+    eudoxus->start_skip_valid = true;
+}
+
 ia_eudoxus_result_t ia_eudoxus_execute(
     ia_eudoxus_state_t *state,
     const uint8_t      *input,
@@ -482,6 +620,114 @@ ia_eudoxus_result_t ia_eudoxus_execute_without_output(
     return ia_eudoxus_execute_impl(state, input, input_length, false);
 }
 
+ia_eudoxus_result_t ia_eudoxus_execute_vec(
+    ia_eudoxus_state_t *state,
+    const struct iovec *iov,
+    int                 iovcnt
+)
+{
+    ia_eudoxus_result_t rc = IA_EUDOXUS_OK;
+
+    if (state == NULL || (iov == NULL && iovcnt > 0)) {
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    for (int i = 0; i < iovcnt; ++i) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        rc = ia_eudoxus_execute_impl(
+            state,
+            (const uint8_t *)iov[i].iov_base,
+            iov[i].iov_len,
+            true
+        );
+        if (rc != IA_EUDOXUS_OK) {
+            break;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Accumulator behind ia_eudoxus_execute_batched().
+ */
+typedef struct
+{
+    ia_eudoxus_match_t *outputs;  /**< Caller's output array. */
+    size_t               capacity; /**< Entries in @c outputs. */
+    size_t               count;    /**< Entries recorded so far. */
+} ia_eudoxus_batch_t;
+
+/**
+ * Callback recording outputs into an ia_eudoxus_batch_t.
+ *
+ * Stops execution when the array is full.
+ */
+static
+ia_eudoxus_command_t ia_eudoxus_batch_callback(
+    ia_eudoxus_t  *engine,
+    const char    *output,
+    size_t         output_length,
+    const uint8_t *input_location,
+    void          *callback_data
+)
+{
+    ia_eudoxus_batch_t *batch = (ia_eudoxus_batch_t *)callback_data;
+
+    if (batch->count >= batch->capacity) {
+        return IA_EUDOXUS_CMD_STOP;
+    }
+
+    batch->outputs[batch->count].output         = output;
+    batch->outputs[batch->count].output_length  = output_length;
+    batch->outputs[batch->count].input_location = input_location;
+    ++batch->count;
+
+    return IA_EUDOXUS_CMD_CONTINUE;
+}
+
+ia_eudoxus_result_t ia_eudoxus_execute_batched(
+    ia_eudoxus_state_t  *state,
+    const uint8_t       *input,
+    size_t               input_length,
+    ia_eudoxus_match_t *outputs,
+    size_t               capacity,
+    size_t              *num_outputs
+)
+{
+    ia_eudoxus_batch_t    batch;
+    ia_eudoxus_callback_t saved_callback;
+    void                 *saved_callback_data;
+    ia_eudoxus_result_t   rc;
+
+    if (
+        state == NULL ||
+        outputs == NULL || num_outputs == NULL || capacity == 0
+    ) {
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    batch.outputs  = outputs;
+    batch.capacity = capacity;
+    batch.count    = 0;
+
+    saved_callback      = state->callback;
+    saved_callback_data = state->callback_data;
+    state->callback      = ia_eudoxus_batch_callback;
+    state->callback_data = &batch;
+
+    rc = ia_eudoxus_execute_impl(state, input, input_length, true);
+
+    state->callback      = saved_callback;
+    state->callback_data = saved_callback_data;
+
+    *num_outputs = batch.count;
+
+    return rc;
+}
+
 ia_eudoxus_result_t ia_eudoxus_metadata(
     ia_eudoxus_t                   *eudoxus,
     ia_eudoxus_metadata_callback_t  callback,
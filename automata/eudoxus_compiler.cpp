@@ -35,6 +35,7 @@
 #endif
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread.hpp>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
@@ -121,8 +122,10 @@ private:
         static const size_t c_ali_threshold = 32;
 
         //! Constructor.
-        explicit
-        NodeOracle(const Intermediate::node_p& node)
+        NodeOracle(
+            const Intermediate::node_p& node,
+            const configuration_t&      configuration
+        )
         {
             has_nonadvancing = (
                 find_if(node->edges().begin(), node->edges().end(), is_nonadvancing)
@@ -196,6 +199,33 @@ private:
             else {
                 high_node_cost += sizeof(e_id_t) * out_degree;
             }
+
+            /* Dense encoding: a full 256 entry table, no target bitmap
+             * or ALI, so the subengine dispatch is a single indexed
+             * load.  Only valid when every byte resolves to a target,
+             * i.e., full out degree or a default to fill the gaps. */
+            dense = false;
+            dense_has_nonadvancing = false;
+            dense_node_cost = 0;
+            if (
+                configuration.dense_degree > 0 &&
+                out_degree >= configuration.dense_degree &&
+                (out_degree == 256 || node->default_target())
+            ) {
+                dense = true;
+                dense_has_nonadvancing =
+                    has_nonadvancing ||
+                    (out_degree < 256 && ! node->advance_on_default());
+
+                dense_node_cost += sizeof(e_high_node_t);
+                if (node->first_output()) {
+                    dense_node_cost += sizeof(e_id_t);
+                }
+                if (dense_has_nonadvancing) {
+                    dense_node_cost += sizeof(ia_bitmap256_t);
+                }
+                dense_node_cost += sizeof(e_id_t) * 256;
+            }
         }
 
         //! True if there are non-advancing edges (not including default).
@@ -219,6 +249,13 @@ private:
         //! Cost in bytes of representing with a high node.
         size_t high_node_cost;
 
+        //! True if node should be emitted as a dense (full table) node.
+        bool dense;
+        //! True if a dense node needs an advance bitmap.
+        bool dense_has_nonadvancing;
+        //! Cost in bytes of representing with a dense node.
+        size_t dense_node_cost;
+
         //! Targets by input map.
         Intermediate::Node::targets_by_input_t targets_by_input;
     };
@@ -299,10 +336,10 @@ private:
         m_result.pc_nodes_bytes += m_assembler.size() - old_size;
     }
 
-    //! Compile node into a demux (high or low) node.
+    //! Compile node into a demux (dense, high, or low) node.
     void demux_node(const Intermediate::node_p& node)
     {
-        NodeOracle oracle(node);
+        NodeOracle oracle(node, m_configuration);
 
         if (! oracle.deterministic) {
             throw runtime_error(
@@ -315,7 +352,13 @@ private:
         size_t* nodes_counter = NULL;
         size_t cost_prediction = 0;
 
-        if (
+        if (oracle.dense) {
+            cost_prediction = oracle.dense_node_cost;
+            bytes_counter = &m_result.high_nodes_bytes;
+            nodes_counter = &m_result.high_nodes;
+            dense_node(*node, oracle);
+        }
+        else if (
             oracle.high_node_cost * m_configuration.high_node_weight
              > oracle.low_node_cost
         ) {
@@ -555,6 +598,69 @@ private:
         }
     }
 
+    /**
+     * Compile @a node as a dense (full table) high node.
+     *
+     * Emits a high node with no target bitmap, ALI, or default: all 256
+     * bytes resolve through the target table, so the subengine's
+     * dispatch is a single indexed load.  Bytes without an explicit
+     * edge point at the node's default target.  Costs 256 identifiers
+     * regardless of out degree; see configuration_t::dense_degree.
+     *
+     * @param[in] node Intermediate node to compile.
+     */
+    void dense_node(
+        const Intermediate::Node& node,
+        const NodeOracle& oracle
+    )
+    {
+        {
+            e_high_node_t* header =
+                m_assembler.append_object(e_high_node_t());
+
+            header->header = IA_EUDOXUS_HIGH;
+            if (node.first_output()) {
+                header->header = ia_setbit8(header->header, 0 + IA_EUDOXUS_TYPE_WIDTH);
+            }
+            if (oracle.dense_has_nonadvancing) {
+                header->header = ia_setbit8(header->header, 1 + IA_EUDOXUS_TYPE_WIDTH);
+            }
+            /* No default (flag 2), target bitmap (flag 4), or ALI
+             * (flag 5): the table is complete. */
+        }
+
+        if (node.first_output()) {
+            append_output_ref(node.first_output());
+            m_outputs.insert(node.first_output());
+        }
+
+        if (oracle.dense_has_nonadvancing) {
+            ia_bitmap256_t& advance_bm =
+                *m_assembler.append_object(ia_bitmap256_t());
+            for (int c = 0; c < 256; ++c) {
+                bool advance;
+                if (! oracle.targets_by_input[c].empty()) {
+                    advance = oracle.targets_by_input[c].front().second;
+                }
+                else {
+                    advance = node.advance_on_default();
+                }
+                if (advance) {
+                    ia_setbitv64(advance_bm.bits, c);
+                }
+            }
+        }
+
+        for (int c = 0; c < 256; ++c) {
+            if (! oracle.targets_by_input[c].empty()) {
+                append_node_ref(oracle.targets_by_input[c].front().first);
+            }
+            else {
+                append_node_ref(node.default_target());
+            }
+        }
+    }
+
     /**
      * Go back over buffer and fill in the identifiers.
      *
@@ -977,6 +1083,52 @@ void Compiler<id_width>::compile(
     m_result.ids_used += m_node_id_map.size() + m_output_id_map.size();
 }
 
+/**
+ * One id width trial of compile_minimal().
+ *
+ * Each trial owns its result and status, so trials can run on separate
+ * threads; the automata is only read.
+ */
+struct minimal_trial_t
+{
+    //! Trial outcome.
+    enum status_e {
+        PENDING,   //!< Not run yet.
+        SUCCESS,   //!< Compiled; @c result is valid.
+        TOO_SMALL, //!< id width could not hold the automata.
+        ERROR      //!< Other error; @c error holds the message.
+    };
+
+    //! Constructor.
+    minimal_trial_t() : automata(NULL), status(PENDING) {}
+
+    const Intermediate::Automata* automata;      //!< Automata to compile.
+    configuration_t               configuration; //!< With fixed id_width.
+    result_t                      result;        //!< Compilation result.
+    status_e                      status;        //!< Outcome.
+    string                        error;         //!< Message if ERROR.
+
+    //! Run the trial; never throws.
+    void run()
+    {
+        try {
+            result = compile(*automata, configuration);
+            status = SUCCESS;
+        }
+        catch (out_of_range) {
+            status = TOO_SMALL;
+        }
+        catch (const exception& e) {
+            status = ERROR;
+            error  = e.what();
+        }
+        catch (...) {
+            status = ERROR;
+            error  = "Unknown exception.";
+        }
+    }
+};
+
 result_t compile_minimal(
     const Intermediate::Automata& automata,
     configuration_t               configuration
@@ -993,33 +1145,63 @@ result_t compile_minimal(
         );
     }
 
-    result_t result;
-    size_t i;
+    size_t jobs = configuration.jobs;
+    if (jobs < 1) {
+        jobs = 1;
+    }
 
-    for (i = 0; i < c_num_id_widths; ++i) {
-        bool success = true;
-        try {
-            configuration.id_width = c_id_widths[i];
-            result = compile(automata, configuration);
-        }
-        catch (out_of_range) {
-            // move on to next id_width.
-            success = false;
+    minimal_trial_t trials[c_num_id_widths];
+    for (size_t i = 0; i < c_num_id_widths; ++i) {
+        trials[i].automata               = &automata;
+        trials[i].configuration          = configuration;
+        trials[i].configuration.id_width = c_id_widths[i];
+    }
+
+    if (jobs == 1) {
+        /* Sequential: stop at the first width that fits. */
+        for (size_t i = 0; i < c_num_id_widths; ++i) {
+            trials[i].run();
+            if (trials[i].status != minimal_trial_t::TOO_SMALL) {
+                break;
+            }
         }
-        if (success) {
-            break;
+    }
+    else {
+        /* Parallel: run all trials concurrently, at most @c jobs at a
+         * time.  The trials are independent, so the smallest fitting
+         * width -- and thus the output -- is identical to the sequential
+         * search. */
+        for (size_t batch = 0; batch < c_num_id_widths; batch += jobs) {
+            boost::thread_group workers;
+            for (
+                size_t i = batch;
+                i < c_num_id_widths && i < batch + jobs;
+                ++i
+            ) {
+                workers.create_thread(
+                    boost::bind(&minimal_trial_t::run, &trials[i])
+                );
+            }
+            workers.join_all();
         }
     }
 
-    if (i == c_num_id_widths) {
-        throw logic_error(
-            "Insanity error.  "
-            "Could not fit automata in 2**8 bytes?  "
-            "Please report as bug."
-        );
+    /* Report as the sequential search would have: the first width, in
+     * ascending order, that did not run out of range. */
+    for (size_t i = 0; i < c_num_id_widths; ++i) {
+        if (trials[i].status == minimal_trial_t::SUCCESS) {
+            return trials[i].result;
+        }
+        if (trials[i].status == minimal_trial_t::ERROR) {
+            throw runtime_error(trials[i].error);
+        }
     }
 
-    return result; // RVO
+    throw logic_error(
+        "Insanity error.  "
+        "Could not fit automata in 2**8 bytes?  "
+        "Please report as bug."
+    );
 }
 
 } // Anonymous
@@ -1027,7 +1209,9 @@ result_t compile_minimal(
 configuration_t::configuration_t() :
     id_width(0),
     align_to(1),
-    high_node_weight(1.0)
+    high_node_weight(1.0),
+    jobs(1),
+    dense_degree(0)
 {
     // nop
 }
@@ -572,9 +572,42 @@ ia_eudoxus_result_t IA_EUDOXUS(execute)(
         return IA_EUDOXUS_OK;
     }
 
+    const ia_eudoxus_node_t *start_node = (const ia_eudoxus_node_t *)(
+        (const char *)(state->eudoxus->automata) +
+        state->eudoxus->automata->start_index
+    );
+
     while (state->remaining_bytes > 0) {
         ia_eudoxus_result_t result = IA_EUDOXUS_OK;
 
+        /* Skip-ahead: while in the start node, bytes outside the start
+         * candidate set provably self-loop without output, so scan past
+         * them instead of dispatching a node step per byte.  Most input
+         * bytes in real traffic take this path. */
+        if (
+            state->eudoxus->start_skip_valid &&
+            state->node == start_node &&
+            state->byte_index == 0
+        ) {
+            const uint8_t *location  = state->input_location;
+            size_t         remaining = state->remaining_bytes;
+            const uint8_t *candidate = state->eudoxus->start_candidate;
+
+            while (
+                remaining > 0 &&
+                (candidate[*location / 8] & (1 << (*location % 8))) == 0
+            ) {
+                ++location;
+                --remaining;
+            }
+
+            state->input_location  = location;
+            state->remaining_bytes = remaining;
+            if (remaining == 0) {
+                break;
+            }
+        }
+
         /* Update state, including state->remaining_bytes */
         const uint8_t* old_input_location = state->input_location;
         result = IA_EUDOXUS(next)(state);
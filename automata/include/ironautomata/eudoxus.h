@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -154,6 +155,32 @@ ia_eudoxus_result_t ia_eudoxus_create_from_path(
     const char    *path
 );
 
+/**
+ * As ia_eudoxus_create_from_path(), but map the file instead of reading it.
+ *
+ * The automata is mapped read-only with shared semantics: the file is
+ * paged in on demand rather than copied through read(), and every process
+ * on the host that maps the same file shares one physical copy.  The
+ * automata format is position independent (offset based), so it is used
+ * directly from the mapping.  The mapping is released by
+ * ia_eudoxus_destroy().
+ *
+ * @param[out] out_eudoxus Variable to hold pointer to created engine.
+ * @param[in]  path        Path to file on disk holding automata.
+ * @return
+ * - IA_EUDOXUS_EINVAL if @a out_eudoxus or @a path is NULL or the file
+ *   cannot be opened or sized.
+ * - IA_EUDOXUS_EALLOC if the file cannot be mapped.
+ * - Other codes as described in ia_eudoxus_create().
+ *
+ * @sa ia_eudoxus_t
+ * @sa ia_eudoxus_create_from_path()
+ */
+ia_eudoxus_result_t ia_eudoxus_create_from_path_mmap(
+    ia_eudoxus_t **out_eudoxus,
+    const char    *path
+);
+
 /**
  * Destroy engine @a eudoxus, releasing associated memory.
  *
@@ -379,6 +406,73 @@ ia_eudoxus_result_t ia_eudoxus_execute_without_output(
     size_t              input_length
 );
 
+/**
+ * As ia_eudoxus_execute() but over a vector of input buffers.
+ *
+ * Each buffer of @a iov is fed to the automata in order, as if the buffers
+ * were one contiguous input.  Callers holding scatter/gather body chunks
+ * can thus make one call per flush instead of one call per chunk.
+ * Execution stops at the first buffer yielding a result other than
+ * IA_EUDOXUS_OK and that result is returned; remaining buffers are not
+ * consumed.
+ *
+ * @param[in,out] state  State of automata.
+ * @param[in]     iov    Input buffers to execute on.
+ * @param[in]     iovcnt Number of buffers in @a iov.
+ * @return As ia_eudoxus_execute(); IA_EUDOXUS_EINVAL if @a iov is NULL and
+ *         @a iovcnt is positive.
+ */
+ia_eudoxus_result_t ia_eudoxus_execute_vec(
+    ia_eudoxus_state_t *state,
+    const struct iovec *iov,
+    int                 iovcnt
+);
+
+/**
+ * One automata output recorded by ia_eudoxus_execute_batched().
+ */
+struct ia_eudoxus_match_t
+{
+    const char    *output;         /**< Output defined by automata. */
+    size_t         output_length;  /**< Length of @c output. */
+    const uint8_t *input_location; /**< Location in input. */
+};
+typedef struct ia_eudoxus_match_t ia_eudoxus_match_t;
+
+/**
+ * As ia_eudoxus_execute() but accumulate outputs instead of calling back.
+ *
+ * Outputs are recorded into the caller-provided @a outputs array rather
+ * than dispatched through a function pointer per hit, removing the
+ * per-output indirect call from tight scanning loops.  The state's
+ * callback, if any, is not invoked by this method.
+ *
+ * If @a outputs fills, execution stops with IA_EUDOXUS_STOP and can be
+ * resumed, after draining the array, by calling again with a NULL
+ * @a input.  As with a callback-initiated stop, resuming re-delivers the
+ * outputs of the current node, so outputs recorded immediately before the
+ * stop may be seen again; size @a capacity generously to make this case
+ * rare.
+ *
+ * @param[in,out] state       State of automata.
+ * @param[in]     input       Input to execute on.
+ * @param[in]     input_length Length of input.
+ * @param[out]    outputs     Array to record outputs into.
+ * @param[in]     capacity    Number of entries in @a outputs.
+ * @param[out]    num_outputs Number of entries recorded.
+ * @return As ia_eudoxus_execute(); IA_EUDOXUS_STOP when @a outputs filled,
+ *         IA_EUDOXUS_EINVAL if @a outputs or @a num_outputs is NULL or
+ *         @a capacity is 0.
+ */
+ia_eudoxus_result_t ia_eudoxus_execute_batched(
+    ia_eudoxus_state_t  *state,
+    const uint8_t       *input,
+    size_t               input_length,
+    ia_eudoxus_match_t *outputs,
+    size_t               capacity,
+    size_t              *num_outputs
+);
+
 /**
  * Set error for @a eudoxus to @a message (claim ownership version).
  *
@@ -52,6 +52,8 @@ struct configuration_t
      * - id_width = 0, i.e., minimal.
      * - align_to = 1, i.e., no alignment
      * - high_node_weight = 1.0, i.e., optimize space
+     * - jobs = 1, i.e., single threaded
+     * - dense_degree = 0, i.e., no dense nodes
      */
     configuration_t();
 
@@ -107,6 +109,33 @@ struct configuration_t
      * for very low degree.
      */
     double high_node_weight;
+
+    /**
+     * Number of threads to use.
+     *
+     * When id_width is 0, the search for the minimal id width compiles the
+     * automata at several widths; those compilations are independent and
+     * run on up to this many threads.  The output is identical for any
+     * value.  A fixed id_width compiles on the calling thread regardless.
+     */
+    size_t jobs;
+
+    /**
+     * Dense encoding degree threshold.  0 = off.
+     *
+     * When non-zero, nodes with out degree at least this value -- and
+     * whose every byte resolves to a target, i.e., full out degree or a
+     * default transition -- are emitted as full 256 entry transition
+     * tables with no target bitmap or ALI.  Dispatch through such a node
+     * is a single indexed load instead of bitmap tests and popcounts.
+     *
+     * The cost is space: a dense node stores 256 identifiers regardless
+     * of out degree, where the normal encodings store roughly one per
+     * edge.  Low thresholds can inflate an automata severely; this is a
+     * latency-for-memory trade for small, hot automata.  Matching
+     * behavior is unchanged.
+     */
+    size_t dense_degree;
 };
 
 /**
@@ -114,6 +114,17 @@ class TestBasic < CLIPPTest::TestCase
     end
   end
 
+  def test_dense
+    words = ["he", "she", "his", "hers"]
+    text = "she saw his world as he saw hers..."
+
+    # Every node of an Aho-Corasick automata has a default transition, so a
+    # threshold of 1 makes every node dense.  Matches must be identical to
+    # the normal encodings; only size/speed differ.
+    ac_test(words, text, "dense", false, ["-e", "1"])
+    ac_test(words, text, "dense_fast", :fast, ["-e", "1"])
+  end
+
   def test_foo
     words = ["forb"]
     text = "aaa ford bbb"
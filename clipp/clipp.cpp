@@ -78,6 +78,8 @@
 #include <clipp/ironbee.hpp>
 #include <clipp/limit_modifier.hpp>
 #include <clipp/modsec_audit_log_generator.hpp>
+#include <clipp/mpb_consumer.hpp>
+#include <clipp/mpb_generator.hpp>
 #include <clipp/null_consumer.hpp>
 #include <clipp/parse_modifier.hpp>
 #include <clipp/pb_consumer.hpp>
@@ -89,7 +91,9 @@
 #include <clipp/pcap_generator.hpp>
 #endif
 #include <clipp/raw_consumer.hpp>
+#include <clipp/sample_modifier.hpp>
 #include <clipp/raw_generator.hpp>
+#include <clipp/schedule_modifier.hpp>
 #include <clipp/select_modifier.hpp>
 #include <clipp/split_modifier.hpp>
 #include <clipp/suricata_generator.hpp>
@@ -113,12 +117,16 @@
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
+#include <iomanip>
 #include <string>
+#include <vector>
 
 #include <csignal>
 
@@ -226,9 +234,15 @@ component_t construct_component(const string& arg)
 //! Construct threaded IronBee consumer, interpreting @a arg as @e path:n
 component_t construct_ironbee_threaded_consumer(const string& arg);
 
+//! Construct sharded IronBee consumer, interpreting @a arg as @e path:n
+component_t construct_ironbee_sharded_consumer(const string& arg);
+
 //! Construct proxy consumer, interpreting @a arg as @e host:port:listen_port
 component_t construct_proxy_consumer(const string& arg);
 
+//! Construct mpb generator, interpreting @a arg as @e path[:begin[:end]]
+component_t construct_mpb_generator(const string& arg);
+
 //! Construct raw generator, interpreting @a arg as @e request,response.
 component_t construct_raw_generator(const string& arg);
 
@@ -237,6 +251,12 @@ component_t construct_raw_generator(const string& arg);
 component_t construct_pcap_generator(const string& arg);
 #endif
 
+//! Construct schedule modifier, interpreting @a arg as @e mode:args
+component_t construct_schedule_modifier(const string& arg);
+
+//! Construct sample modifier, interpreting @a arg as @e n[:manifest]
+component_t construct_sample_modifier(const string& arg);
+
 //! Construct aggregate modifier.  An empty @a arg is 0, otherwise integer.
 component_t construct_aggregate_modifier(const string& arg);
 
@@ -308,6 +328,13 @@ void help()
     "Flags:\n"
     "  -c <path> -- Load <path> as CLIPP configuration.\n"
     "  -e <path> -- Write last input to <path> as pb and exit on error.\n"
+    "  -p <n>    -- Process generators with <n> parallel workers.\n"
+    "               Workers claim generators from a shared queue, so a\n"
+    "               worker finishing a small file immediately starts on\n"
+    "               the next one.  Input order across generators is not\n"
+    "               preserved; use with order-insensitive consumers such\n"
+    "               as ironbee_threaded.  A merged summary is written to\n"
+    "               standard error at the end of the run.\n"
     "  -v        -- Print version and exit.\n"
     "\n"
     "Generators:\n"
@@ -316,6 +343,13 @@ void help()
     "  burp:<path>     -- Read <path> as a burp proxy file.\n"
 #endif
     "  pb:<path>       -- Read <path> as protobuf.\n"
+    "  mpb:<path>      -- Read <path> as memory-mappable protobuf (see\n"
+    "                     writempb).  Records are iterated in place with\n"
+    "                     no reads or decompression.\n"
+    "  mpb:<path>:<begin>[:<end>] -- As above, but produce only records\n"
+    "                                [<begin>, <end>); omitted <end> means\n"
+    "                                end of file.  Use to shard a large\n"
+    "                                corpus across parallel replays.\n"
     "  modsec:<path>   -- Read <path> as modsec audit log.\n"
     "                     One transaction per connection.\n"
     "  raw:<in>,<out>  -- Read <in>,<out> as raw data in and out.\n"
@@ -334,9 +368,27 @@ void help()
     "\n"
     "Consumers:\n"
     "  ironbee:<path>  -- Internal IronBee using <path> as configuration.\n"
-    "  ironbee_threaded:<path>:<n> -- Internal IronBee using <n> threads\n"
-    "                                 and <path> as configuration.\n"
+    "  ironbee_threaded:<path>:<n> -- Internal IronBee using <n> worker\n"
+    "                                 threads sharing one engine and <path>\n"
+    "                                 as configuration.  Connections are\n"
+    "                                 partitioned by connection hash;\n"
+    "                                 throughput and latency statistics are\n"
+    "                                 reported to stderr on completion.\n"
+    "  ironbee_benchmark:<path> -- Internal IronBee using <path> as\n"
+    "                              configuration.  Times every state\n"
+    "                              notification; per-phase and end-to-end\n"
+    "                              transaction latency percentiles are\n"
+    "                              reported to stderr on completion.  Enable\n"
+    "                              the rule profiler in the configuration\n"
+    "                              for per-rule attribution.\n"
+    "  ironbee_sharded:<path>:<n> -- <n> internal IronBee engines, one per\n"
+    "                                thread, each using <path> as\n"
+    "                                configuration.  Inputs are sharded by\n"
+    "                                connection hash; throughput statistics\n"
+    "                                are reported to stderr on completion.\n"
     "  writepb:<path>  -- Output to protobuf file at <path>.\n"
+    "  writempb:<path> -- Output to memory-mappable protobuf file at\n"
+    "                     <path> (uncompressed, indexed; see mpb).\n"
     "  writehtp:<path> -- Output in HTP test format at <path>.\n"
     "                     Best with unparsed format and only 1 connection.\n"
     "  view            -- Output to stdout for human consumption.\n"
@@ -443,6 +495,22 @@ void help()
     "    and clipp:break stops the current chain.\n"
     "    <behavior> is optional and defaults to 'allow'.\n"
     "  @time -- Output timing of each transaction.\n"
+    "  @sample:<n>[:<manifest>] --\n"
+    "    Emit at most <n> inputs per transaction shape (method, path\n"
+    "    shape, request header names), discarding the rest.  Shrinks\n"
+    "    corpora dominated by identical traffic while keeping rare\n"
+    "    shapes.  If <manifest> is given, write one line per shape with\n"
+    "    counts and sampling weight on completion.\n"
+    "  @schedule:replay:<speedup> --\n"
+    "    Scale recorded event delays by 1/<speedup> so consumers that\n"
+    "    honor delays replay recorded timing <speedup> times faster.\n"
+    "  @schedule:rate:<rps> -- Release inputs at <rps> per second.\n"
+    "  @schedule:poisson:<rps>[:<seed>] --\n"
+    "    Release inputs with Poisson arrivals at mean <rps> per second.\n"
+    "    <seed> (default 0) makes the schedule reproducible.\n"
+    "  @schedule:burst:<rps>:<burst>:<period> --\n"
+    "    As rate, but every <period> seconds spend half the cycle at\n"
+    "    <burst> times <rps>, modeling traffic spikes.\n"
     ;
 }
 
@@ -558,6 +626,305 @@ void handle_signal(int)
     s_received_signal = 1;
 }
 
+//! Per-run statistics; merged across workers in parallel mode.
+struct run_stats_t
+{
+    run_stats_t() :
+        chains(0),
+        inputs(0),
+        consume_errors(0)
+    {
+        // nop
+    }
+
+    //! Chains processed to completion.
+    size_t chains;
+    //! Inputs delivered to the consumer.
+    size_t inputs;
+    //! Inputs the consumer failed on.
+    size_t consume_errors;
+};
+
+/**
+ * Process a single generator chain, feeding every input to @a consumer.
+ *
+ * This is the body of the main processing loop, factored out so that
+ * parallel mode (see parallel_worker()) can run many chains at once.  In
+ * parallel mode @a consumer_mutex serializes the consumer and the
+ * consumer's modifiers, which are shared across chains; generation and
+ * per-chain modifiers run concurrently.
+ *
+ * @param[in] chain                 Chain to process.
+ * @param[in] generator_factory_map Generator factories.
+ * @param[in] modifier_factory_map  Modifier factories.
+ * @param[in] consumer_modifiers    Consumer modifiers, shared across chains.
+ * @param[in] consumer              Consumer, shared across chains.
+ * @param[in] consumer_mutex        Mutex serializing @a consumer and
+ *                                  @a consumer_modifiers, or NULL in
+ *                                  sequential mode.
+ * @param[in] write_on_error        Path to write failing input to, or empty.
+ * @param[in,out] stats             Statistics to accumulate into.
+ * @return 0 on success and 1 on fatal error (stop processing).
+ **/
+int process_chain(
+    const ConfigurationParser::chain_t& chain,
+    const component_factory_map_t&      generator_factory_map,
+    const component_factory_map_t&      modifier_factory_map,
+    const modifier_info_list_t&         consumer_modifiers,
+    component_t&                        consumer,
+    boost::mutex*                       consumer_mutex,
+    const string&                       write_on_error,
+    run_stats_t&                        stats
+)
+{
+    component_t generator;
+    try {
+        generator = build_component(
+            chain.base,
+            generator_factory_map
+        );
+    }
+    CLIPP_CATCH(
+        "Error constructing generator " + chain.base.name,
+        {return 1;}
+    );
+
+    // Generate modifiers.
+    modifier_info_list_t modifiers;
+    try {
+        build_modifiers(
+            modifiers,
+            chain.modifiers,
+            modifier_factory_map
+        );
+    }
+    catch (...) {
+        // build_modifiers() will output error message.
+        return 1;
+    }
+
+    // Index of the first consumer modifier; in parallel mode the consumer
+    // mutex must be held from this modifier on.
+    const size_t shared_begin = modifiers.size();
+
+    // Append consumer modifiers.
+    copy(
+        consumer_modifiers.begin(), consumer_modifiers.end(),
+        back_inserter(modifiers)
+    );
+
+    // Process inputs.
+    input_p input;
+    bool generator_continue = true;
+    bool consumer_continue  = true;
+    bool end_of_generator   = false;
+    while (generator_continue && consumer_continue) {
+        input.reset();
+
+        if (! end_of_generator) {
+            // Make new input for each run.  Extra allocations but avoids
+            // some pitfalls.
+            input = boost::make_shared<Input::Input>();
+
+            try {
+                generator_continue = generator(input);
+            }
+            catch (clipp_break) {
+                break;
+            }
+            catch (clipp_continue) {
+                continue;
+            }
+            CLIPP_CATCH("Error generating input", {continue;});
+
+            if (generator_continue && ! input) {
+                cerr << "Generator said it provided input, but didn't."
+                     << endl;
+                continue;
+            }
+
+            if (! generator_continue) {
+                // Only stop if the singular input reaches the consumer.
+                input.reset();
+                end_of_generator = true;
+            }
+        }
+
+        boost::unique_lock<boost::mutex> consumer_lock;
+        bool modifier_success  = true;
+        bool modifier_break    = false;
+        bool modifier_continue = false;
+        size_t modifier_index  = 0;
+        BOOST_FOREACH(const modifier_info_t& modifier_info, modifiers) {
+            if (consumer_mutex != NULL && modifier_index == shared_begin) {
+                consumer_lock =
+                    boost::unique_lock<boost::mutex>(*consumer_mutex);
+            }
+            ++modifier_index;
+            try {
+                modifier_success = modifier_info.second(input);
+            }
+            catch (clipp_break) {
+                modifier_break = true;
+                break;
+            }
+            catch (clipp_continue) {
+                modifier_continue = true;
+                break;
+            }
+            CLIPP_CATCH(
+                "Error applying modifier " + modifier_info.first + ": ",
+                {modifier_success = false; break;}
+            );
+
+            // If pushing through a singular input, apply to all
+            // modifiers.
+            if (input && ! modifier_success) {
+                break;
+            }
+        }
+        if (modifier_break) {
+            end_of_generator = true;
+            continue;
+        }
+        if (! modifier_success || modifier_continue) {
+            continue;
+        }
+
+        if (! input && end_of_generator) {
+            // Chain complete; leave loop.
+            break;
+        }
+
+        if (! input) {
+            cerr << "Input lost during modification." << endl;
+            continue;
+        }
+
+        if (consumer_mutex != NULL && ! consumer_lock.owns_lock()) {
+            consumer_lock =
+                boost::unique_lock<boost::mutex>(*consumer_mutex);
+        }
+
+        try {
+            consumer_continue = consumer(input);
+        }
+        catch (clipp_break) {
+            end_of_generator = true;
+            continue;
+        }
+        catch (clipp_continue) {
+            continue;
+        }
+        CLIPP_CATCH("Error consuming input", {
+            ++stats.consume_errors;
+            if (write_on_error.empty()) {
+                cout << "Exiting." << endl;
+                break;
+            }
+            else {
+                PBConsumer error_consumer(write_on_error);
+                error_consumer(input);
+                cout << "Wrote last input to " << write_on_error << endl;
+                cout << "Exiting." << endl;
+                break;
+            }
+        });
+
+        ++stats.inputs;
+
+        if (! consumer_continue) {
+            cerr << "Consumer refusing input." << endl;
+        }
+
+        if (s_received_signal == 1) {
+            break;
+        }
+    }
+
+    ++stats.chains;
+    return 0;
+}
+
+//! Shared state for parallel chain processing.
+struct parallel_work_t
+{
+    parallel_work_t() :
+        next(0),
+        exit_status(0)
+    {
+        // nop
+    }
+
+    //! All chains; next is the index of the next unclaimed one.
+    vector<ConfigurationParser::chain_t> chains;
+    size_t                               next;
+    //! Guards next, stats, and exit_status.
+    boost::mutex                         queue_mutex;
+    //! Serializes the consumer and its modifiers.
+    boost::mutex                         consumer_mutex;
+    int                                  exit_status;
+    run_stats_t                          stats;
+};
+
+/**
+ * Parallel worker: claim chains from @a work until none remain.
+ *
+ * Workers steal the next unclaimed chain from the shared queue, so a
+ * worker that drew a small file immediately moves on to the next one
+ * while workers with large files keep processing.  A fatal error in any
+ * worker drains the queue, stopping the others at their next chain
+ * boundary.
+ **/
+void parallel_worker(
+    parallel_work_t&               work,
+    const component_factory_map_t& generator_factory_map,
+    const component_factory_map_t& modifier_factory_map,
+    const modifier_info_list_t&    consumer_modifiers,
+    component_t&                   consumer,
+    const string&                  write_on_error
+)
+{
+    for (;;) {
+        size_t index;
+        {
+            boost::lock_guard<boost::mutex> lock(work.queue_mutex);
+            if (work.next >= work.chains.size()) {
+                return;
+            }
+            index = work.next;
+            ++work.next;
+        }
+        if (s_received_signal == 1) {
+            return;
+        }
+
+        run_stats_t stats;
+        int rc = process_chain(
+            work.chains[index],
+            generator_factory_map,
+            modifier_factory_map,
+            consumer_modifiers,
+            consumer,
+            &work.consumer_mutex,
+            write_on_error,
+            stats
+        );
+
+        boost::lock_guard<boost::mutex> lock(work.queue_mutex);
+        work.stats.chains         += stats.chains;
+        work.stats.inputs         += stats.inputs;
+        work.stats.consume_errors += stats.consume_errors;
+        if (rc != 0 || stats.consume_errors > 0) {
+            work.exit_status = 1;
+        }
+        if (rc != 0) {
+            // Fatal: stop other workers at their next chain boundary.
+            work.next = work.chains.size();
+        }
+    }
+}
+
 /**
  * Main
  *
@@ -593,6 +960,7 @@ int main(int argc, char** argv)
         ("modsec",   construct_component<ModSecAuditLogGenerator>)
         ("raw",      construct_raw_generator)
         ("pb",       construct_component<PBGenerator>)
+        ("mpb",      construct_mpb_generator)
 #ifdef HAVE_LIBXML2
         ("burp",     construct_component<BurpGenerator>)
 #endif
@@ -609,7 +977,10 @@ int main(int argc, char** argv)
     component_factory_map_t consumer_factory_map = boost::assign::map_list_of
         ("ironbee",  construct_component<IronBeeConsumer>)
         ("ironbee_threaded",  construct_ironbee_threaded_consumer)
+        ("ironbee_benchmark",  construct_component<IronBeeBenchmarkConsumer>)
+        ("ironbee_sharded",  construct_ironbee_sharded_consumer)
         ("writepb",  construct_component<PBConsumer>)
+        ("writempb", construct_component<MPBConsumer>)
         ("writehtp", construct_component<HTPConsumer>)
         ("view",     construct_component<ViewConsumer>)
         ("writeraw", construct_component<RawConsumer>)
@@ -638,6 +1009,8 @@ int main(int argc, char** argv)
         ("fillbody",        construct_argless_component<FillBodyModifier>)
         ("ironbee",         construct_ironbee_modifier)
         ("time",            construct_argless_component<TimeModifier>)
+        ("schedule",        construct_schedule_modifier)
+        ("sample",          construct_sample_modifier)
         ;
 
     // Convert argv to args.
@@ -646,6 +1019,7 @@ int main(int argc, char** argv)
     }
 
     string write_on_error;
+    size_t num_workers = 0;
     list<ConfigurationParser::chain_t> chains;
     // Parse flags.
     while (! args.empty() && args.front()[0] == '-') {
@@ -674,6 +1048,21 @@ int main(int argc, char** argv)
             write_on_error = args.front();
             args.pop_front();
         }
+        else if (arg == "-p") {
+            if (args.empty()) {
+                cerr << "-p requires an argument." << endl;
+                help();
+                return 1;
+            }
+            try {
+                num_workers = boost::lexical_cast<size_t>(args.front());
+            }
+            catch (const boost::bad_lexical_cast&) {
+                cerr << "-p argument must be a number." << endl;
+                return 1;
+            }
+            args.pop_front();
+        }
         else if ((arg == "-v") || (arg == "--version")) {
             cerr << "clipp (" IB_PRODUCT_VERSION_NAME ")" << endl;
             cerr << "IronBee Command Line Interface" << endl;
@@ -726,157 +1115,67 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    // Loop through components, generating and processing input generators
-    // as needed to limit the scope of each input generator.  As input
-    // generators can make use of significant memory, it is good to only have
-    // one around at a time.
-    BOOST_FOREACH(const ConfigurationParser::chain_t& chain, chains) {
-        component_t generator;
-        try {
-            generator = build_component(
-                chain.base,
-                generator_factory_map
-            );
+    if (num_workers > 0) {
+        // Parallel mode: workers claim chains from a shared queue and feed
+        // the consumer through a mutex.  See parallel_worker().
+        parallel_work_t work;
+        work.chains.assign(chains.begin(), chains.end());
+
+        boost::posix_time::ptime start_at =
+            boost::posix_time::microsec_clock::universal_time();
+        boost::thread_group workers;
+        for (size_t i = 0; i < num_workers; ++i) {
+            workers.create_thread(boost::bind(
+                &parallel_worker,
+                boost::ref(work),
+                boost::cref(generator_factory_map),
+                boost::cref(modifier_factory_map),
+                boost::cref(consumer_modifiers),
+                boost::ref(consumer),
+                boost::cref(write_on_error)
+            ));
         }
-        CLIPP_CATCH(
-            "Error constructing generator " + chain.base.name,
-            {return 1;}
-        );
+        workers.join_all();
+        double elapsed =
+            (boost::posix_time::microsec_clock::universal_time() - start_at)
+                .total_microseconds() / 1e6;
 
-        // Generate modifiers.
-        modifier_info_list_t modifiers;
-        try {
-            build_modifiers(
-                modifiers,
-                chain.modifiers,
-                modifier_factory_map
-            );
-        }
-        catch (...) {
-            // build_modifiers() will output error message.
-            return 1;
+        if (s_received_signal == 1) {
+            cout << "Received Signal: Exiting." << endl;
+            work.exit_status = 1;
         }
 
-        // Append consumer modifiers.
-        copy(
-            consumer_modifiers.begin(), consumer_modifiers.end(),
-            back_inserter(modifiers)
-        );
-
-        // Process inputs.
-        input_p input;
-        bool generator_continue = true;
-        bool consumer_continue  = true;
-        bool end_of_generator   = false;
-        while (generator_continue && consumer_continue) {
-            input.reset();
-
-            if (! end_of_generator) {
-                // Make new input for each run.  Extra allocations but avoids
-                // some pitfalls.
-                input = boost::make_shared<Input::Input>();
-
-                try {
-                    generator_continue = generator(input);
-                }
-                catch (clipp_break) {
-                    break;
-                }
-                catch (clipp_continue) {
-                    continue;
-                }
-                CLIPP_CATCH("Error generating input", {continue;});
-
-                if (generator_continue && ! input) {
-                    cerr << "Generator said it provided input, but didn't."
-                         << endl;
-                    continue;
-                }
-
-                if (! generator_continue) {
-                    // Only stop if the singular input reaches the consumer.
-                    input.reset();
-                    end_of_generator = true;
-                }
-            }
-
-            bool modifier_success  = true;
-            bool modifier_break    = false;
-            bool modifier_continue = false;
-            BOOST_FOREACH(const modifier_info_t& modifier_info, modifiers) {
-                try {
-                    modifier_success = modifier_info.second(input);
-                }
-                catch (clipp_break) {
-                    modifier_break = true;
-                    break;
-                }
-                catch (clipp_continue) {
-                    modifier_continue = true;
-                    break;
-                }
-                CLIPP_CATCH(
-                    "Error applying modifier " + modifier_info.first + ": ",
-                    {modifier_success = false; break;}
-                );
-
-                // If pushing through a singular input, apply to all
-                // modifiers.
-                if (input && ! modifier_success) {
-                    break;
-                }
-            }
-            if (modifier_break) {
-                end_of_generator = true;
-                continue;
-            }
-            if (! modifier_success || modifier_continue) {
-                continue;
-            }
-
-            if (! input && end_of_generator) {
-                // Chain complete; leave loop.
-                break;
-            }
-
-            if (! input) {
-                cerr << "Input lost during modification." << endl;
-                continue;
-            }
-
-            try {
-                consumer_continue = consumer(input);
-            }
-            catch (clipp_break) {
-                end_of_generator = true;
-                continue;
-            }
-            catch (clipp_continue) {
-                continue;
-            }
-            CLIPP_CATCH("Error consuming input", {
-                if (write_on_error.empty()) {
-                    cout << "Exiting." << endl;
-                    exit_status = 1;
-                    break;
-                }
-                else {
-                    PBConsumer consumer(write_on_error);
-                    consumer(input);
-                    cout << "Wrote last input to " << write_on_error << endl;
-                    cout << "Exiting." << endl;
-                    exit_status = 1;
-                    break;
-                }
-            });
+        // Merged summary.
+        cerr << "clipp: " << num_workers << " workers processed "
+             << work.stats.chains << " chains, "
+             << work.stats.inputs << " inputs";
+        if (work.stats.consume_errors > 0) {
+            cerr << ", " << work.stats.consume_errors << " errors";
+        }
+        cerr << " in " << fixed << setprecision(1) << elapsed << "s"
+             << endl;
 
-            if (! consumer_continue) {
-                cerr << "Consumer refusing input." << endl;
-            }
+        return work.exit_status;
+    }
 
-            if (s_received_signal == 1) {
-                break;
-            }
+    // Sequential mode.  Loop through components, generating and processing
+    // input generators as needed to limit the scope of each input
+    // generator.  As input generators can make use of significant memory,
+    // it is good to only have one around at a time.
+    run_stats_t stats;
+    BOOST_FOREACH(const ConfigurationParser::chain_t& chain, chains) {
+        int rc = process_chain(
+            chain,
+            generator_factory_map,
+            modifier_factory_map,
+            consumer_modifiers,
+            consumer,
+            NULL,
+            write_on_error,
+            stats
+        );
+        if (rc != 0) {
+            return 1;
         }
 
         if (s_received_signal == 1) {
@@ -885,6 +1184,9 @@ int main(int argc, char** argv)
             break;
         }
     }
+    if (stats.consume_errors > 0) {
+        exit_status = 1;
+    }
 
     return exit_status;
 }
@@ -1118,10 +1420,114 @@ component_t construct_ironbee_threaded_consumer(const string& arg)
     else {
         throw runtime_error("Could not parse ironbee_threaded arg: " + arg);
     }
+    if (num_workers == 0) {
+        throw runtime_error("ironbee_threaded requires at least one thread.");
+    }
 
     return IronBeeThreadedConsumer(config_path, num_workers);
 }
 
+component_t construct_ironbee_sharded_consumer(const string& arg)
+{
+    string config_path;
+    size_t num_engines;
+
+    vector<string> subargs = split_on_char(arg, ':');
+    if (subargs.size() == 2) {
+        config_path = subargs[0];
+        num_engines = boost::lexical_cast<size_t>(subargs[1]);
+    }
+    else {
+        throw runtime_error("Could not parse ironbee_sharded arg: " + arg);
+    }
+    if (num_engines == 0) {
+        throw runtime_error("ironbee_sharded requires at least one engine.");
+    }
+
+    return IronBeeShardedConsumer(config_path, num_engines);
+}
+
+component_t construct_sample_modifier(const string& arg)
+{
+    // We don't use split_on_char because the manifest path may itself
+    // contain :s.
+    size_t colon_i = arg.find_first_of(':');
+    if (colon_i == string::npos) {
+        return SampleModifier(boost::lexical_cast<size_t>(arg));
+    }
+    return SampleModifier(
+        boost::lexical_cast<size_t>(arg.substr(0, colon_i)),
+        arg.substr(colon_i + 1)
+    );
+}
+
+component_t construct_schedule_modifier(const string& arg)
+{
+    vector<string> subargs = split_on_char(arg, ':');
+
+    if (subargs.size() == 2 && subargs[0] == "replay") {
+        return ScheduleModifier(
+            ScheduleModifier::REPLAY,
+            boost::lexical_cast<double>(subargs[1])
+        );
+    }
+    else if (subargs.size() == 2 && subargs[0] == "rate") {
+        return ScheduleModifier(
+            ScheduleModifier::RATE,
+            boost::lexical_cast<double>(subargs[1])
+        );
+    }
+    else if (
+        (subargs.size() == 2 || subargs.size() == 3) &&
+        subargs[0] == "poisson"
+    ) {
+        return ScheduleModifier(
+            ScheduleModifier::POISSON,
+            boost::lexical_cast<double>(subargs[1]),
+            1, 1,
+            subargs.size() == 3
+                ? boost::lexical_cast<unsigned>(subargs[2])
+                : 0
+        );
+    }
+    else if (subargs.size() == 4 && subargs[0] == "burst") {
+        return ScheduleModifier(
+            ScheduleModifier::BURST,
+            boost::lexical_cast<double>(subargs[1]),
+            boost::lexical_cast<double>(subargs[2]),
+            boost::lexical_cast<double>(subargs[3])
+        );
+    }
+    else {
+        throw runtime_error("Could not parse schedule arg: " + arg);
+    }
+}
+
+component_t construct_mpb_generator(const string& arg)
+{
+    vector<string> subargs = split_on_char(arg, ':');
+    if (subargs.size() == 1) {
+        return MPBGenerator(subargs[0]);
+    }
+    else if (subargs.size() == 2) {
+        return MPBGenerator(
+            subargs[0],
+            boost::lexical_cast<size_t>(subargs[1]),
+            0
+        );
+    }
+    else if (subargs.size() == 3) {
+        return MPBGenerator(
+            subargs[0],
+            boost::lexical_cast<size_t>(subargs[1]),
+            boost::lexical_cast<size_t>(subargs[2])
+        );
+    }
+    else {
+        throw runtime_error("Could not parse mpb arg: " + arg);
+    }
+}
+
 component_t construct_proxy_consumer(const string& arg)
 {
     string proxy_host;
@@ -35,12 +35,20 @@
 #pragma clang diagnostic ignored "-Wunused-local-typedef"
 #endif
 #endif
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/thread.hpp>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
 using namespace std;
 
 namespace IronBee {
@@ -474,108 +482,327 @@ ib_status_t clipp_close(
 
 } // extern "C"
 
-// Move to new file?
-template <typename WorkType>
-class FunctionWorkerPool :
-    private boost::noncopyable
+/**
+ * Hash an input to a stable shard index in [0, @a num_shards).
+ *
+ * Hashes the remote address and port of the first CONNECTION_OPENED event
+ * (FNV-1a) so every input belonging to the same client lands on the same
+ * shard, as a connection-hashing load balancer would arrange.  Inputs
+ * without a CONNECTION_OPENED event are hashed by their ID instead.
+ **/
+size_t shard_of_input(const Input::input_p& input, size_t num_shards)
 {
-    typedef boost::unique_lock<boost::mutex> lock_t;
+    static const uint64_t c_fnv_basis = 14695981039346656037ULL;
+    static const uint64_t c_fnv_prime = 1099511628211ULL;
+
+    uint64_t h = c_fnv_basis;
+    const Input::ConnectionEvent* opened = NULL;
+
+    BOOST_FOREACH(
+        const Input::event_p& event,
+        input->connection.pre_transaction_events
+    ) {
+        if (event->which == Input::CONNECTION_OPENED) {
+            opened = dynamic_cast<const Input::ConnectionEvent*>(event.get());
+            break;
+        }
+    }
 
-    void do_work()
-    {
-        WorkType local_work;
-        for (;;) {
-            {
-                lock_t lock(m_mutex);
-                ++m_num_workers_available;
+    if (opened) {
+        for (size_t i = 0; i < opened->remote_ip.length; ++i) {
+            h = (h ^ static_cast<uint8_t>(opened->remote_ip.data[i]))
+                * c_fnv_prime;
+        }
+        for (int shift = 0; shift < 32; shift += 8) {
+            h = (h ^ ((opened->remote_port >> shift) & 0xff)) * c_fnv_prime;
+        }
+    }
+    else {
+        for (size_t i = 0; i < input->id.length(); ++i) {
+            h = (h ^ static_cast<uint8_t>(input->id[i])) * c_fnv_prime;
+        }
+    }
 
-            }
-            m_worker_available_cv.notify_one();
+    return h % num_shards;
+}
 
-            {
-                lock_t lock(m_mutex);
-                while (! m_work_available) {
-                    m_work_available_cv.wait(lock);
-                    if (m_shutdown) {
-                        return;
-                    }
-                }
+//! Latency phases recorded by IronBeeBenchmarkConsumer.
+enum benchmark_phase_e {
+    PHASE_CONNECTION_OPENED,
+    PHASE_CONNECTION_CLOSED,
+    PHASE_REQUEST_STARTED,
+    PHASE_REQUEST_HEADER,
+    PHASE_REQUEST_HEADER_FINISHED,
+    PHASE_REQUEST_BODY,
+    PHASE_REQUEST_FINISHED,
+    PHASE_RESPONSE_STARTED,
+    PHASE_RESPONSE_HEADER,
+    PHASE_RESPONSE_HEADER_FINISHED,
+    PHASE_RESPONSE_BODY,
+    PHASE_RESPONSE_FINISHED,
+    PHASE_TRANSACTION,
+    PHASE_COUNT
+};
 
-                local_work = m_work;
-                m_work_available = false;
-                --m_num_workers_available;
-            }
-            m_work_accepted_barrier.wait();
+//! Report names of benchmark_phase_e, in order.
+const char* c_benchmark_phase_name[PHASE_COUNT] = {
+    "connection_opened",
+    "connection_closed",
+    "request_started",
+    "request_header",
+    "request_header_finished",
+    "request_body",
+    "request_finished",
+    "response_started",
+    "response_header",
+    "response_header_finished",
+    "response_body",
+    "response_finished",
+    "transaction"
+};
 
-            m_work_function(local_work);
-        }
+/**
+ * Log-linear latency histogram.
+ *
+ * Values are bucketed HdrHistogram style: exactly below 64 and then into
+ * 32 linear sub-buckets per power of two, bounding the value error of any
+ * quantile to about 3.2% while keeping the bucket count logarithmic in
+ * the largest recorded value.  All values are in microseconds.
+ **/
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() :
+        m_count(0),
+        m_sum(0),
+        m_max(0)
+    {
+        // nop
     }
 
-public:
-    FunctionWorkerPool(
-        size_t                          num_workers,
-        boost::function<void(WorkType)> work_function
-    ) :
-        m_num_workers(num_workers),
-        m_work_function(work_function),
-        m_work_accepted_barrier(2),
-        m_num_workers_available(0),
-        m_work_available(false),
-        m_shutdown(false)
+    //! Record a latency of @a value microseconds.
+    void record(uint64_t value)
     {
-        for (size_t i = 0; i < num_workers; ++i) {
-            m_thread_group.create_thread(boost::bind(
-                &FunctionWorkerPool::do_work,
-                this
-            ));
+        size_t i = index_of(value);
+        if (m_buckets.size() <= i) {
+            m_buckets.resize(i + 1, 0);
+        }
+        ++m_buckets[i];
+        ++m_count;
+        m_sum += value;
+        if (value > m_max) {
+            m_max = value;
         }
     }
 
-    void operator()(WorkType work)
+    //! Number of recorded values.
+    uint64_t count() const
     {
-        {
-            lock_t lock(m_mutex);
+        return m_count;
+    }
+
+    //! Mean of recorded values; 0 if empty.
+    double mean() const
+    {
+        return m_count > 0 ? double(m_sum) / double(m_count) : 0;
+    }
+
+    //! Largest recorded value.
+    uint64_t max() const
+    {
+        return m_max;
+    }
 
-            while (m_num_workers_available == 0) {
-                m_worker_available_cv.wait(lock);
+    //! Value at quantile @a q in [0, 1]; 0 if empty.
+    uint64_t quantile(double q) const
+    {
+        if (m_count == 0) {
+            return 0;
+        }
+        uint64_t rank = uint64_t(q * m_count + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                return value_of(i);
             }
+        }
+        return m_max;
+    }
 
-            m_work           = work;
-            m_work_available = true;
+private:
+    //! Linear sub-buckets per power of two: 2^c_sub_bits.
+    static const unsigned c_sub_bits = 5;
 
-            m_work_available_cv.notify_one();
+    //! Bucket index of @a value.
+    static size_t index_of(uint64_t value)
+    {
+        if (value < (1ULL << (c_sub_bits + 1))) {
+            return size_t(value);
         }
-        m_work_accepted_barrier.wait();
+        unsigned msb = 63 - __builtin_clzll(value);
+        unsigned shift = msb - c_sub_bits;
+        return ((shift + 1) << c_sub_bits)
+            + size_t((value >> shift) & ((1 << c_sub_bits) - 1));
     }
 
-    void shutdown()
+    //! Largest value mapping to bucket @a i; inverse bound of index_of().
+    static uint64_t value_of(size_t i)
     {
-        {
-            lock_t lock(m_mutex);
-            while (m_num_workers_available < m_num_workers) {
-                m_worker_available_cv.wait(lock);
-            }
+        if (i < (1ULL << (c_sub_bits + 1))) {
+            return i;
         }
+        unsigned shift = unsigned(i >> c_sub_bits) - 1;
+        uint64_t sub = (1ULL << c_sub_bits) + (i & ((1 << c_sub_bits) - 1));
+        return ((sub + 1) << shift) - 1;
+    }
 
-        m_shutdown = true;
-        m_work_available_cv.notify_all();
+    std::vector<uint64_t> m_buckets;
+    uint64_t              m_count;
+    uint64_t              m_sum;
+    uint64_t              m_max;
+};
 
-        m_thread_group.join_all();
+/**
+ * Delegate decorator that times each notification of an inner delegate.
+ *
+ * Each event method is forwarded to @a inner and its wall time recorded
+ * into the corresponding phase histogram.  End-to-end transaction latency
+ * (REQUEST_STARTED through RESPONSE_FINISHED inclusive) is recorded into
+ * the PHASE_TRANSACTION histogram.
+ **/
+class TimingDelegate :
+    public Input::Delegate
+{
+public:
+    //! Constructor.  @a histograms must hold PHASE_COUNT entries.
+    TimingDelegate(Input::Delegate& inner, LatencyHistogram* histograms) :
+        m_inner(inner),
+        m_histograms(histograms)
+    {
+        // nop
+    }
+
+    void connection_opened(const Input::ConnectionEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.connection_opened(event);
+        record(PHASE_CONNECTION_OPENED, before);
+    }
+
+    void connection_closed(const Input::NullEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.connection_closed(event);
+        record(PHASE_CONNECTION_CLOSED, before);
+    }
+
+    void connection_data_in(const Input::DataEvent& event)
+    {
+        m_inner.connection_data_in(event);
+    }
+
+    void connection_data_out(const Input::DataEvent& event)
+    {
+        m_inner.connection_data_out(event);
+    }
+
+    void request_started(const Input::RequestEvent& event)
+    {
+        m_transaction_start = now();
+        m_inner.request_started(event);
+        record(PHASE_REQUEST_STARTED, m_transaction_start);
+    }
+
+    void request_header(const Input::HeaderEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.request_header(event);
+        record(PHASE_REQUEST_HEADER, before);
+    }
+
+    void request_header_finished(const Input::NullEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.request_header_finished(event);
+        record(PHASE_REQUEST_HEADER_FINISHED, before);
+    }
+
+    void request_body(const Input::DataEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.request_body(event);
+        record(PHASE_REQUEST_BODY, before);
+    }
+
+    void request_finished(const Input::NullEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.request_finished(event);
+        record(PHASE_REQUEST_FINISHED, before);
+    }
+
+    void response_started(const Input::ResponseEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.response_started(event);
+        record(PHASE_RESPONSE_STARTED, before);
+    }
+
+    void response_header(const Input::HeaderEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.response_header(event);
+        record(PHASE_RESPONSE_HEADER, before);
+    }
+
+    void response_header_finished(const Input::NullEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.response_header_finished(event);
+        record(PHASE_RESPONSE_HEADER_FINISHED, before);
+    }
+
+    void response_body(const Input::DataEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.response_body(event);
+        record(PHASE_RESPONSE_BODY, before);
+    }
+
+    void response_finished(const Input::NullEvent& event)
+    {
+        ptime_t before = now();
+        m_inner.response_finished(event);
+        record(PHASE_RESPONSE_FINISHED, before);
+        if (! m_transaction_start.is_not_a_date_time()) {
+            record(PHASE_TRANSACTION, m_transaction_start);
+            m_transaction_start = ptime_t();
+        }
     }
 
 private:
-    size_t                          m_num_workers;
-    boost::function<void(WorkType)> m_work_function;
-
-    boost::mutex                    m_mutex;
-    boost::condition_variable       m_worker_available_cv;
-    boost::condition_variable       m_work_available_cv;
-    boost::barrier                  m_work_accepted_barrier;
-    boost::thread_group             m_thread_group;
-    size_t                          m_num_workers_available;
-    bool                            m_work_available;
-    bool                            m_shutdown;
-    WorkType                        m_work;
+    typedef boost::posix_time::ptime ptime_t;
+
+    static ptime_t now()
+    {
+        return boost::posix_time::microsec_clock::universal_time();
+    }
+
+    //! Record time since @a before into the @a phase histogram.
+    void record(benchmark_phase_e phase, const ptime_t& before)
+    {
+        m_histograms[phase].record(
+            (now() - before).total_microseconds()
+        );
+    }
+
+    Input::Delegate&  m_inner;
+    LatencyHistogram* m_histograms;
+    ptime_t           m_transaction_start;
 };
 
 } // Anonymous
@@ -678,45 +905,176 @@ bool IronBeeModifier::operator()(Input::input_p& input)
 
 struct IronBeeThreadedConsumer::State
 {
-    void process_input(Input::input_p input)
+    //! Maximum queued inputs per worker before the producer blocks.
+    static const size_t c_max_queue_depth = 128;
+
+    //! A worker thread's queue and statistics; the engine is shared.
+    struct Worker
     {
-        if (! input) {
-            return;
+        Worker() :
+            num_inputs(0),
+            num_transactions(0),
+            busy(boost::posix_time::seconds(0)),
+            max_latency(boost::posix_time::seconds(0)),
+            shutdown(false)
+        {
+            // nop
         }
 
-        IronBeeDelegate delegate(engine);
-        input->connection.dispatch(delegate, true);
+        std::deque<Input::input_p>       queue;
+        boost::mutex                     mutex;
+        boost::condition_variable        cv;
+        uint64_t                         num_inputs;
+        uint64_t                         num_transactions;
+        boost::posix_time::time_duration busy;
+        boost::posix_time::time_duration max_latency;
+        bool                             shutdown;
+    };
+    typedef boost::shared_ptr<Worker> worker_p;
+
+    //! Worker body: drain @a worker's queue into the shared engine.
+    void process_worker(const worker_p& worker)
+    {
+        for (;;) {
+            Input::input_p input;
+            {
+                boost::unique_lock<boost::mutex> lock(worker->mutex);
+                while (worker->queue.empty() && ! worker->shutdown) {
+                    worker->cv.wait(lock);
+                }
+                if (worker->queue.empty()) {
+                    return;
+                }
+                input = worker->queue.front();
+                worker->queue.pop_front();
+            }
+            /* Wake a producer blocked on a full queue. */
+            worker->cv.notify_one();
+
+            if (! input) {
+                continue;
+            }
+
+            boost::posix_time::ptime before =
+                boost::posix_time::microsec_clock::universal_time();
+
+            IronBeeDelegate delegate(engine);
+            input->connection.dispatch(delegate, true);
+
+            boost::posix_time::time_duration latency =
+                boost::posix_time::microsec_clock::universal_time() - before;
+            worker->busy += latency;
+            if (latency > worker->max_latency) {
+                worker->max_latency = latency;
+            }
+            ++worker->num_inputs;
+            worker->num_transactions += input->connection.transactions.size();
+        }
     }
 
     explicit
     State(size_t num_workers) :
-        worker_pool(
-            num_workers,
-            boost::bind(
-                &IronBeeThreadedConsumer::State::process_input,
-                this,
-                _1
-            )
-        ),
         server_value(__FILE__, "clipp")
-
     {
         IronBee::initialize();
         engine = IronBee::Engine::create(server_value.get());
+
+        for (size_t i = 0; i < num_workers; ++i) {
+            workers.push_back(boost::make_shared<Worker>());
+        }
+    }
+
+    //! Start the worker threads; called once the engine is configured.
+    void start()
+    {
+        start_at = boost::posix_time::microsec_clock::universal_time();
+        BOOST_FOREACH(const worker_p& worker, workers) {
+            threads.create_thread(boost::bind(
+                &IronBeeThreadedConsumer::State::process_worker,
+                this,
+                worker
+            ));
+        }
     }
 
     ~State()
     {
-        worker_pool.shutdown();
+        BOOST_FOREACH(const worker_p& worker, workers) {
+            boost::lock_guard<boost::mutex> guard(worker->mutex);
+            worker->shutdown = true;
+            worker->cv.notify_all();
+        }
+        threads.join_all();
+
+        report();
 
         engine.destroy();
         IronBee::shutdown();
     }
 
+    //! Write per-thread and aggregate statistics to standard error.
+    void report() const
+    {
+        boost::posix_time::time_duration elapsed =
+            boost::posix_time::microsec_clock::universal_time() - start_at;
+        double   elapsed_s   = elapsed.total_microseconds() / 1e6;
+        uint64_t total_inputs = 0;
+        uint64_t total_txs    = 0;
+        boost::posix_time::time_duration total_busy(
+            boost::posix_time::seconds(0));
+        boost::posix_time::time_duration max_latency(
+            boost::posix_time::seconds(0));
+
+        cerr << "clipp ironbee_threaded: "
+             << workers.size() << " threads, one engine, "
+             << elapsed_s << " seconds" << endl;
+
+        for (size_t i = 0; i < workers.size(); ++i) {
+            const worker_p& worker = workers[i];
+            double busy_s = worker->busy.total_microseconds() / 1e6;
+            double tx_per_s =
+                busy_s > 0 ? worker->num_transactions / busy_s : 0;
+            double mean_latency_ms =
+                worker->num_inputs > 0
+                ? worker->busy.total_microseconds()
+                    / 1e3 / worker->num_inputs
+                : 0;
+
+            total_inputs += worker->num_inputs;
+            total_txs    += worker->num_transactions;
+            total_busy   += worker->busy;
+            if (worker->max_latency > max_latency) {
+                max_latency = worker->max_latency;
+            }
 
-    FunctionWorkerPool<Input::input_p> worker_pool;
-    IronBee::Engine      engine;
-    IronBee::ServerValue server_value;
+            cerr << "  thread " << i
+                 << ": connections=" << worker->num_inputs
+                 << " transactions=" << worker->num_transactions
+                 << " busy=" << busy_s << "s"
+                 << " tx/s=" << tx_per_s
+                 << " mean-latency=" << mean_latency_ms << "ms"
+                 << " max-latency="
+                 << worker->max_latency.total_microseconds() / 1e3
+                 << "ms" << endl;
+        }
+
+        cerr << "  aggregate: connections=" << total_inputs
+             << " transactions=" << total_txs
+             << " tx/s=" << (elapsed_s > 0 ? total_txs / elapsed_s : 0)
+             << " mean-latency="
+             << (total_inputs > 0
+                 ? total_busy.total_microseconds() / 1e3 / total_inputs
+                 : 0)
+             << "ms max-latency="
+             << max_latency.total_microseconds() / 1e3
+             << "ms" << endl;
+    }
+
+    std::vector<worker_p>    workers;
+    boost::thread_group      threads;
+    IronBee::Engine          engine;
+    IronBee::ServerValue     server_value;
+    boost::posix_time::ptime start_at;
 };
 
 IronBeeThreadedConsumer::IronBeeThreadedConsumer(
@@ -726,11 +1084,288 @@ IronBeeThreadedConsumer::IronBeeThreadedConsumer(
     m_state(boost::make_shared<State>(num_workers))
 {
     load_configuration(m_state->engine, config_path);
+    m_state->start();
 }
 
 bool IronBeeThreadedConsumer::operator()(const Input::input_p& input)
 {
-    m_state->worker_pool(input);
+    if (! input) {
+        return true;
+    }
+
+    /* Hashing the connection keeps a client's connections on one
+     * thread; an input is a whole connection, so its events replay in
+     * order regardless. */
+    State::worker_p worker =
+        m_state->workers[shard_of_input(input, m_state->workers.size())];
+
+    boost::unique_lock<boost::mutex> lock(worker->mutex);
+    while (worker->queue.size() >= State::c_max_queue_depth) {
+        worker->cv.wait(lock);
+    }
+    worker->queue.push_back(input);
+    worker->cv.notify_all();
+
+    return true;
+}
+
+struct IronBeeBenchmarkConsumer::State
+{
+    State() :
+        server_value(__FILE__, "clipp")
+    {
+        IronBee::initialize();
+        engine = IronBee::Engine::create(server_value.get());
+    }
+
+    ~State()
+    {
+        report();
+
+        engine.destroy();
+        IronBee::shutdown();
+    }
+
+    //! Write per-phase latency percentiles to standard error.
+    void report() const
+    {
+        cerr << "clipp ironbee_benchmark: latency in microseconds" << endl;
+        cerr << "  "
+             << left << setw(25) << "phase"
+             << right
+             << setw(10) << "count"
+             << setw(10) << "mean"
+             << setw(10) << "p50"
+             << setw(10) << "p90"
+             << setw(10) << "p99"
+             << setw(10) << "p99.9"
+             << setw(10) << "max"
+             << endl;
+        for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+            const LatencyHistogram& h = histograms[phase];
+            if (h.count() == 0) {
+                continue;
+            }
+            cerr << "  "
+                 << left << setw(25) << c_benchmark_phase_name[phase]
+                 << right
+                 << setw(10) << h.count()
+                 << setw(10) << uint64_t(h.mean() + 0.5)
+                 << setw(10) << h.quantile(0.50)
+                 << setw(10) << h.quantile(0.90)
+                 << setw(10) << h.quantile(0.99)
+                 << setw(10) << h.quantile(0.999)
+                 << setw(10) << h.max()
+                 << endl;
+        }
+    }
+
+    IronBee::Engine      engine;
+    IronBee::ServerValue server_value;
+    LatencyHistogram     histograms[PHASE_COUNT];
+};
+
+IronBeeBenchmarkConsumer::IronBeeBenchmarkConsumer(const string& config_path) :
+    m_state(boost::make_shared<State>())
+{
+    load_configuration(m_state->engine, config_path);
+}
+
+bool IronBeeBenchmarkConsumer::operator()(const Input::input_p& input)
+{
+    if (! input) {
+        return true;
+    }
+
+    IronBeeDelegate delegate(m_state->engine);
+    TimingDelegate timer(delegate, m_state->histograms);
+    input->connection.dispatch(timer, true);
+
+    return true;
+}
+
+struct IronBeeShardedConsumer::State
+{
+    //! Maximum queued inputs per shard before the producer blocks.
+    static const size_t c_max_queue_depth = 128;
+
+    //! A private engine, its worker thread, and its work queue.
+    struct Shard
+    {
+        Shard() :
+            num_inputs(0),
+            num_transactions(0),
+            busy(boost::posix_time::seconds(0)),
+            shutdown(false)
+        {
+            // nop
+        }
+
+        IronBee::Engine                  engine;
+        std::deque<Input::input_p>       queue;
+        boost::mutex                     mutex;
+        boost::condition_variable        cv;
+        uint64_t                         num_inputs;
+        uint64_t                         num_transactions;
+        boost::posix_time::time_duration busy;
+        bool                             shutdown;
+    };
+    typedef boost::shared_ptr<Shard> shard_p;
+
+    //! Worker body: drain @a shard's queue into its engine.
+    void process_shard(const shard_p& shard)
+    {
+        for (;;) {
+            Input::input_p input;
+            {
+                boost::unique_lock<boost::mutex> lock(shard->mutex);
+                while (shard->queue.empty() && ! shard->shutdown) {
+                    shard->cv.wait(lock);
+                }
+                if (shard->queue.empty()) {
+                    return;
+                }
+                input = shard->queue.front();
+                shard->queue.pop_front();
+            }
+            /* Wake a producer blocked on a full queue. */
+            shard->cv.notify_one();
+
+            if (! input) {
+                continue;
+            }
+
+            boost::posix_time::ptime before =
+                boost::posix_time::microsec_clock::universal_time();
+
+            IronBeeDelegate delegate(shard->engine);
+            input->connection.dispatch(delegate, true);
+
+            shard->busy +=
+                boost::posix_time::microsec_clock::universal_time() - before;
+            ++shard->num_inputs;
+            shard->num_transactions += input->connection.transactions.size();
+        }
+    }
+
+    explicit
+    State(size_t num_engines) :
+        server_value(__FILE__, "clipp")
+    {
+        IronBee::initialize();
+
+        for (size_t i = 0; i < num_engines; ++i) {
+            shard_p shard = boost::make_shared<Shard>();
+            shard->engine = IronBee::Engine::create(server_value.get());
+            shards.push_back(shard);
+        }
+
+        start_at = boost::posix_time::microsec_clock::universal_time();
+        BOOST_FOREACH(const shard_p& shard, shards) {
+            threads.create_thread(boost::bind(
+                &IronBeeShardedConsumer::State::process_shard,
+                this,
+                shard
+            ));
+        }
+    }
+
+    ~State()
+    {
+        BOOST_FOREACH(const shard_p& shard, shards) {
+            boost::lock_guard<boost::mutex> guard(shard->mutex);
+            shard->shutdown = true;
+            shard->cv.notify_all();
+        }
+        threads.join_all();
+
+        report();
+
+        BOOST_FOREACH(const shard_p& shard, shards) {
+            shard->engine.destroy();
+        }
+        IronBee::shutdown();
+    }
+
+    //! Write per-engine and aggregate throughput to standard error.
+    void report() const
+    {
+        boost::posix_time::time_duration elapsed =
+            boost::posix_time::microsec_clock::universal_time() - start_at;
+        double   elapsed_s = elapsed.total_microseconds() / 1e6;
+        uint64_t total_inputs = 0;
+        uint64_t total_txs    = 0;
+        double   mean         = 0;
+        double   variance     = 0;
+
+        cerr << "clipp ironbee_sharded: "
+             << shards.size() << " engines, "
+             << elapsed_s << " seconds" << endl;
+
+        for (size_t i = 0; i < shards.size(); ++i) {
+            const shard_p& shard = shards[i];
+            double busy_s = shard->busy.total_microseconds() / 1e6;
+            double tx_per_s =
+                busy_s > 0 ? shard->num_transactions / busy_s : 0;
+
+            total_inputs += shard->num_inputs;
+            total_txs    += shard->num_transactions;
+            mean         += tx_per_s;
+
+            cerr << "  engine " << i
+                 << ": connections=" << shard->num_inputs
+                 << " transactions=" << shard->num_transactions
+                 << " busy=" << busy_s << "s"
+                 << " tx/s=" << tx_per_s << endl;
+        }
+
+        mean /= shards.size();
+        BOOST_FOREACH(const shard_p& shard, shards) {
+            double busy_s = shard->busy.total_microseconds() / 1e6;
+            double tx_per_s =
+                busy_s > 0 ? shard->num_transactions / busy_s : 0;
+            variance += (tx_per_s - mean) * (tx_per_s - mean);
+        }
+        variance /= shards.size();
+
+        cerr << "  aggregate: connections=" << total_inputs
+             << " transactions=" << total_txs
+             << " tx/s=" << (elapsed_s > 0 ? total_txs / elapsed_s : 0)
+             << " per-engine stddev=" << sqrt(variance) << endl;
+    }
+
+    std::vector<shard_p> shards;
+    boost::thread_group  threads;
+    IronBee::ServerValue server_value;
+    boost::posix_time::ptime start_at;
+};
+
+IronBeeShardedConsumer::IronBeeShardedConsumer(
+    const string& config_path,
+    size_t        num_engines
+) :
+    m_state(boost::make_shared<State>(num_engines))
+{
+    BOOST_FOREACH(const State::shard_p& shard, m_state->shards) {
+        load_configuration(shard->engine, config_path);
+    }
+}
+
+bool IronBeeShardedConsumer::operator()(const Input::input_p& input)
+{
+    if (! input) {
+        return true;
+    }
+
+    State::shard_p shard =
+        m_state->shards[shard_of_input(input, m_state->shards.size())];
+
+    boost::unique_lock<boost::mutex> lock(shard->mutex);
+    while (shard->queue.size() >= State::c_max_queue_depth) {
+        shard->cv.wait(lock);
+    }
+    shard->queue.push_back(input);
+    shard->cv.notify_all();
 
     return true;
 }
@@ -63,8 +63,14 @@ private:
  * CLIPP consumer that feeds inputs to an internal threaded IronBee Engine.
  *
  * This consumer is as IronBeeConsumer except that it will spawn multiple
- * threads to feed data to IronBee.  It will wait until at least one thread
- * is free, and then pass on the input and return.
+ * worker threads to feed data to a single shared IronBee engine.  Inputs
+ * are partitioned across workers by a hash of the connection (remote
+ * address and port, falling back to the input ID), so a given connection
+ * always replays on the same thread, in order, through that thread's own
+ * notifier.  It mimics a multi-worker deployment sharing one engine and
+ * is intended for reproducing multi-core contention: on destruction it
+ * reports per-thread and aggregate throughput and per-connection latency
+ * to standard error.
  **/
 class IronBeeThreadedConsumer
 {
@@ -81,6 +87,56 @@ private:
     boost::shared_ptr<State> m_state;
 };
 
+/**
+ * CLIPP consumer that measures IronBee latency.
+ *
+ * This consumer is as IronBeeConsumer except that every state
+ * notification is timed.  Per-phase and end-to-end transaction latencies
+ * are recorded into log-linear histograms (HdrHistogram-style bucketing,
+ * at most 3.2% value error) and percentile reports are written to
+ * standard error on destruction.  Enable the rule profiler in the
+ * IronBee configuration to additionally attribute time to rules.
+ **/
+class IronBeeBenchmarkConsumer
+{
+public:
+    explicit
+    IronBeeBenchmarkConsumer(const std::string& config_path);
+
+    bool operator()(const Input::input_p& input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
+/**
+ * CLIPP consumer that shards inputs across multiple IronBee engines.
+ *
+ * This consumer is as IronBeeThreadedConsumer except that every worker
+ * thread owns a private IronBee engine and inputs are partitioned across
+ * workers by a hash of the connection (remote address and port, falling
+ * back to the input ID), so a given connection always replays against the
+ * same engine.  It mimics an engine-per-thread deployment and is intended
+ * for scalability measurement: on destruction it reports per-engine and
+ * aggregate throughput, along with the cross-engine spread, to standard
+ * error.
+ **/
+class IronBeeShardedConsumer
+{
+public:
+    IronBeeShardedConsumer(
+        const std::string& config_path,
+        size_t             num_engines
+    );
+
+    bool operator()(const Input::input_p& input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
 /**
  * CLIPP modifier that feeds inputs to an internal IronBee Engine.
  *
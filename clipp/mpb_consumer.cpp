@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Memory-Mappable Protobuf Consumer Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include "mpb_consumer.hpp"
+
+#include "pb_codec.hpp"
+
+#include <clipp/clipp.pb.h>
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#if __has_warning("-Wunused-local-typedef")
+#pragma clang diagnostic ignored "-Wunused-local-typedef"
+#endif
+#endif
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace {
+
+//! Magic bytes at the head and tail of an mpb file.
+const char c_mpb_magic[8] = {'C', 'L', 'I', 'P', 'P', 'M', 'P', 'B'};
+
+//! Write @a value to @a out as a big endian uint64.
+void write_u64(ostream& out, uint64_t value)
+{
+    char buffer[8];
+    for (int i = 0; i < 8; ++i) {
+        buffer[i] = char((value >> (56 - 8 * i)) & 0xff);
+    }
+    out.write(buffer, sizeof(buffer));
+}
+
+}
+
+struct MPBConsumer::State
+{
+    explicit
+    State(const std::string& path) :
+        output(path.c_str(), ios::binary | ios::trunc),
+        offset(0)
+    {
+        if (! output) {
+            throw runtime_error("Could not open " + path + " for writing.");
+        }
+        output.write(c_mpb_magic, sizeof(c_mpb_magic));
+        offset = sizeof(c_mpb_magic);
+    }
+
+    ~State()
+    {
+        /* Index and trailer make the file seekable without a scan. */
+        uint64_t index_offset = offset;
+        typedef pair<uint64_t, uint64_t> entry_t;
+        BOOST_FOREACH(const entry_t& entry, index) {
+            write_u64(output, entry.first);
+            write_u64(output, entry.second);
+        }
+        write_u64(output, index_offset);
+        write_u64(output, index.size());
+        output.write(c_mpb_magic, sizeof(c_mpb_magic));
+    }
+
+    ofstream                            output;
+    uint64_t                            offset;
+    vector<pair<uint64_t, uint64_t> >   index;
+};
+
+MPBConsumer::MPBConsumer()
+{
+    // nop
+}
+
+MPBConsumer::MPBConsumer(const std::string& output_path) :
+    m_state(boost::make_shared<State>(output_path))
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+}
+
+bool MPBConsumer::operator()(const Input::input_p& input)
+{
+    if (! m_state || ! m_state->output) {
+        return false;
+    }
+
+    PB::Input pb_input;
+    input_to_pb(*input, pb_input);
+
+    string buffer;
+    if (! pb_input.SerializeToString(&buffer)) {
+        throw runtime_error("Failed to serialize input.");
+    }
+
+    m_state->output.write(buffer.data(), buffer.length());
+    m_state->index.push_back(
+        make_pair(m_state->offset, uint64_t(buffer.length()))
+    );
+    m_state->offset += buffer.length();
+
+    return true;
+}
+
+} // CLIPP
+} // IronBee
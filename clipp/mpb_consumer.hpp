@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Memory-Mappable Protobuf Consumer.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#ifndef __IRONBEE__CLIPP__MPB_CONSUMER__
+#define __IRONBEE__CLIPP__MPB_CONSUMER__
+
+#include <clipp/input.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+namespace IronBee {
+namespace CLIPP {
+
+/**
+ * Consumer that writes inputs in memory-mappable protobuf format.
+ *
+ * The format is designed to be read with zero copies and zero
+ * decompression via MPBGenerator:
+ *
+ * @code
+ * magic           -- 8 bytes: "CLIPPMPB"
+ * records         -- Each record an uncompressed serialized PB::Input.
+ * index           -- One (offset, length) pair of big endian uint64s per
+ *                    record, in record order.
+ * trailer         -- Big endian uint64 offset of index, big endian uint64
+ *                    record count, 8 bytes magic.
+ * @endcode
+ *
+ * The index and trailer are written on destruction, so the file is only
+ * valid once the consumer is destroyed.  Unlike PBConsumer output, the
+ * format is not appendable: the output file is truncated on open.
+ *
+ * @sa MPBGenerator
+ **/
+class MPBConsumer
+{
+public:
+    //! Default Constructor.
+    /**
+     * Behavior except for assigning to is undefined.
+     **/
+    MPBConsumer();
+
+    explicit
+    MPBConsumer(const std::string& output_path);
+
+    bool operator()(const Input::input_p& input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
+} // CLIPP
+} // IronBee
+
+#endif
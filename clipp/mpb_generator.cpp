@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Memory-Mappable Protobuf Generator Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include "mpb_generator.hpp"
+
+#include "pb_codec.hpp"
+
+#include <clipp/clipp.pb.h>
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#if __has_warning("-Wunused-local-typedef")
+#pragma clang diagnostic ignored "-Wunused-local-typedef"
+#endif
+#endif
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace {
+
+//! Magic bytes at the head and tail of an mpb file; see MPBConsumer.
+const char c_mpb_magic[8] = {'C', 'L', 'I', 'P', 'P', 'M', 'P', 'B'};
+
+//! Read a big endian uint64 at @a in.
+uint64_t read_u64(const uint8_t* in)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+struct data_t
+{
+    PB::Input pb_input;
+};
+
+}
+
+struct MPBGenerator::State
+{
+    State(const std::string& path_, size_t begin, size_t end) :
+        path(path_),
+        base(NULL),
+        size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Could not open " + path + " for reading.");
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("Could not stat " + path + ".");
+        }
+        size = st.st_size;
+
+        /* Empty file (magic + trailer) is 2 * 8 + 24 bytes. */
+        if (size < sizeof(c_mpb_magic) + 24) {
+            close(fd);
+            throw runtime_error(path + " is too small to be an mpb file.");
+        }
+
+        void* addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            throw runtime_error("Could not mmap " + path + ".");
+        }
+        base = static_cast<const uint8_t*>(addr);
+
+        if (
+            memcmp(base, c_mpb_magic, sizeof(c_mpb_magic)) != 0 ||
+            memcmp(
+                base + size - sizeof(c_mpb_magic),
+                c_mpb_magic,
+                sizeof(c_mpb_magic)
+            ) != 0
+        ) {
+            throw runtime_error(path + " is not an mpb file.");
+        }
+
+        const uint8_t* trailer = base + size - sizeof(c_mpb_magic) - 16;
+        uint64_t index_offset = read_u64(trailer);
+        uint64_t num_records  = read_u64(trailer + 8);
+        if (
+            index_offset > size ||
+            num_records * 16 != uint64_t(trailer - (base + index_offset))
+        ) {
+            throw runtime_error(path + " has a corrupt index.");
+        }
+        index = base + index_offset;
+
+        current = begin;
+        last = (end == 0 || end > num_records) ? num_records : end;
+    }
+
+    ~State()
+    {
+        if (base != NULL) {
+            munmap(const_cast<uint8_t*>(base), size);
+        }
+    }
+
+    string         path;
+    const uint8_t* base;
+    size_t         size;
+    const uint8_t* index;    //!< Record index: (offset, length) pairs.
+    size_t         current;  //!< Next record to produce.
+    size_t         last;     //!< One past the last record to produce.
+};
+
+MPBGenerator::MPBGenerator()
+{
+    // nop
+}
+
+MPBGenerator::MPBGenerator(const std::string& path) :
+    m_state(boost::make_shared<State>(path, 0, 0))
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+}
+
+MPBGenerator::MPBGenerator(const std::string& path, size_t begin, size_t end) :
+    m_state(boost::make_shared<State>(path, begin, end))
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+}
+
+bool MPBGenerator::operator()(Input::input_p& input)
+{
+    if (m_state->current >= m_state->last) {
+        return false;
+    }
+
+    const uint8_t* entry = m_state->index + 16 * m_state->current;
+    uint64_t offset = read_u64(entry);
+    uint64_t length = read_u64(entry + 8);
+    ++m_state->current;
+
+    if (offset + length > m_state->size) {
+        throw runtime_error(m_state->path + " has a corrupt index.");
+    }
+
+    // Reset Input
+    *input = Input::Input();
+
+    boost::shared_ptr<data_t> data = boost::make_shared<data_t>();
+    input->source = data;
+
+    if (! data->pb_input.ParseFromArray(m_state->base + offset, length)) {
+        throw runtime_error("Failed to parse input.");
+    }
+
+    pb_to_input(data->pb_input, *input);
+
+    return true;
+}
+
+} // CLIPP
+} // IronBee
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Memory-Mappable Protobuf Generator.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#ifndef __IRONBEE__CLIPP__MPB_GENERATOR__
+#define __IRONBEE__CLIPP__MPB_GENERATOR__
+
+#include <clipp/input.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+namespace IronBee {
+namespace CLIPP {
+
+/**
+ * Generator that reads memory-mappable protobuf.
+ *
+ * The file is mapped into memory and iterated via its record index, so
+ * reading issues no read() calls and performs no decompression.  A
+ * record range may be given to replay only a shard of the file, e.g.,
+ * for parallel replay of a large corpus by several processes.
+ *
+ * See MPBConsumer for details on format.
+ * @sa MPBConsumer
+ **/
+class MPBGenerator
+{
+public:
+    //! Default Constructor.
+    /**
+     * Behavior except for assigning to is undefined.
+     **/
+    MPBGenerator();
+
+    //! Constructor.  Produce every record of @a path.
+    explicit
+    MPBGenerator(const std::string& path);
+
+    /**
+     * Constructor.  Produce records [@a begin, @a end) of @a path.
+     *
+     * @param[in] path  File to map.
+     * @param[in] begin Index of first record to produce.
+     * @param[in] end   Index one past the last record to produce; 0 means
+     *                  the end of the file.
+     **/
+    MPBGenerator(const std::string& path, size_t begin, size_t end);
+
+    //! Produce an input.  See input_t and input_generator_t.
+    bool operator()(Input::input_p& out_input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
+} // CLIPP
+} // IronBee
+
+#endif
@@ -0,0 +1,436 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Protobuf Codec Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include "pb_codec.hpp"
+
+#include <clipp/clipp.pb.h>
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#if __has_warning("-Wunused-local-typedef")
+#pragma clang diagnostic ignored "-Wunused-local-typedef"
+#endif
+#endif
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace {
+
+void fill_event(PB::Event& pb_event, const Input::Event& event)
+{
+    if (event.pre_delay > 0) {
+        pb_event.set_pre_delay(event.pre_delay);
+    }
+    if (event.post_delay > 0) {
+        pb_event.set_post_delay(event.post_delay);
+    }
+    pb_event.set_which(event.which);
+}
+
+class PBEncodeDelegate :
+    public Input::Delegate
+{
+public:
+    explicit
+    PBEncodeDelegate(PB::Event& pb_event) :
+        m_pb_event(pb_event)
+    {
+        // nop
+    }
+
+    void connection_opened(const Input::ConnectionEvent& event)
+    {
+        PB::ConnectionEvent& pb_ce = *m_pb_event.mutable_connection_event();
+        if (event.local_ip.length > 0) {
+            pb_ce.set_local_ip(event.local_ip.data, event.local_ip.length);
+        }
+        if (event.remote_ip.length > 0) {
+            pb_ce.set_remote_ip(event.remote_ip.data, event.remote_ip.length);
+        }
+        if (event.local_port > 0) {
+            pb_ce.set_local_port(event.local_port);
+        }
+        if (event.remote_port > 0) {
+            pb_ce.set_remote_port(event.remote_port);
+        }
+    }
+
+    void connection_closed(const Input::NullEvent& event)
+    {
+        // nop
+    }
+
+    void connection_data_in(const Input::DataEvent& event)
+    {
+        PB::DataEvent& pb = *m_pb_event.mutable_data_event();
+        if (event.data.length > 0) {
+            pb.set_data(event.data.data, event.data.length);
+        }
+    }
+
+    void connection_data_out(const Input::DataEvent& event)
+    {
+        // Forward to connection_data_in
+        connection_data_in(event);
+    }
+
+    void request_started(const Input::RequestEvent& event)
+    {
+        PB::RequestEvent& pb =
+            *m_pb_event.mutable_request_event();
+        if (event.raw.length > 0) {
+            pb.set_raw(event.raw.data, event.raw.length);
+        }
+        if (event.method.length > 0) {
+            pb.set_method(event.method.data, event.method.length);
+        }
+        if (event.uri.length > 0) {
+            pb.set_uri(event.uri.data, event.uri.length);
+        }
+        if (event.protocol.length > 0) {
+            pb.set_protocol(event.protocol.data, event.protocol.length);
+        }
+    }
+
+    void request_header(const Input::HeaderEvent& event)
+    {
+        PB::HeaderEvent& pb = *m_pb_event.mutable_header_event();
+        BOOST_FOREACH(const Input::header_t& header, event.headers)
+        {
+            PB::Header& h = *pb.add_header();
+            h.set_name(header.first.data, header.first.length);
+            h.set_value(header.second.data, header.second.length);
+        }
+    }
+
+    void request_header_finished(const Input::NullEvent& event)
+    {
+        // nop
+    }
+
+    void request_body(const Input::DataEvent& event)
+    {
+        // Forward to connection_data_in
+        connection_data_in(event);
+    }
+
+    void request_finished(const Input::NullEvent& event)
+    {
+        // nop
+    }
+
+    void response_started(const Input::ResponseEvent& event)
+    {
+        PB::ResponseEvent& pb =
+            *m_pb_event.mutable_response_event();
+        if (event.raw.length > 0) {
+            pb.set_raw(event.raw.data, event.raw.length);
+        }
+        if (event.protocol.length > 0) {
+            pb.set_protocol(event.protocol.data, event.protocol.length);
+        }
+        if (event.status.length > 0) {
+            pb.set_status(event.status.data, event.status.length);
+        }
+        if (event.message.length > 0) {
+            pb.set_message(event.message.data, event.message.length);
+        }
+    }
+
+    void response_header(const Input::HeaderEvent& event)
+    {
+        // Forward to request_header
+        request_header(event);
+    }
+
+    void response_header_finished(const Input::NullEvent& event)
+    {
+        // nop
+    }
+
+    void response_body(const Input::DataEvent& event)
+    {
+        // Forward to connection_data_in
+        connection_data_in(event);
+    }
+
+    void response_finished(const Input::NullEvent& event)
+    {
+        // nop
+    }
+
+private:
+    PB::Event& m_pb_event;
+};
+
+struct pb_to_event :
+    public unary_function<const PB::Event, Input::event_p>
+{
+    Input::event_p operator()(const PB::Event& pb_event) const
+    {
+        Input::event_p generic;
+
+        Input::event_e which = static_cast<Input::event_e>(pb_event.which());
+        switch (which) {
+            case Input::UNKNOWN:
+                throw runtime_error("Event of UNKNOWN type.");
+            case Input::CONNECTION_DATA_IN:
+            case Input::CONNECTION_DATA_OUT:
+            case Input::REQUEST_BODY:
+            case Input::RESPONSE_BODY:
+            {
+                // DataEvent
+                boost::shared_ptr<Input::DataEvent> specific =
+                    boost::make_shared<Input::DataEvent>(which);
+                generic = specific;
+                if (! pb_event.has_data_event()) {
+                    throw runtime_error("DataEvent lacking specific data.");
+                }
+                const PB::DataEvent& pb = pb_event.data_event();
+                specific->data.data   = pb.data().data();
+                specific->data.length = pb.data().length();
+                break;
+            }
+            case Input::CONNECTION_CLOSED:
+            case Input::REQUEST_HEADER_FINISHED:
+            case Input::RESPONSE_HEADER_FINISHED:
+            case Input::REQUEST_FINISHED:
+            case Input::RESPONSE_FINISHED:
+            {
+                // NullEvent
+                boost::shared_ptr<Input::NullEvent> specific =
+                    boost::make_shared<Input::NullEvent>(which);
+                generic = specific;
+                break;
+            }
+            case Input::CONNECTION_OPENED:
+            {
+                // ConnectionEvent
+                boost::shared_ptr<Input::ConnectionEvent> specific =
+                    boost::make_shared<Input::ConnectionEvent>(which);
+                generic = specific;
+                if (! pb_event.has_connection_event()) {
+                    throw runtime_error(
+                        "ConnectionEvent lacking specific data."
+                    );
+                }
+                const PB::ConnectionEvent& pb = pb_event.connection_event();
+                if (pb.has_local_ip()) {
+                    specific->local_ip = Input::Buffer(pb.local_ip());
+                }
+                if (pb.has_local_port()) {
+                    specific->local_port = pb.local_port();
+                }
+                if (pb.has_remote_ip()) {
+                    specific->remote_ip = Input::Buffer(pb.remote_ip());
+                }
+                if (pb.has_remote_port()) {
+                    specific->remote_port = pb.remote_port();
+                }
+                break;
+            }
+            case Input::REQUEST_STARTED:
+            {
+                // RequestEvent
+                boost::shared_ptr<Input::RequestEvent> specific =
+                    boost::make_shared<Input::RequestEvent>(which);
+                generic = specific;
+                if (! pb_event.has_request_event()) {
+                    throw runtime_error(
+                        "RequestEvent lacking specific data."
+                    );
+                }
+                const PB::RequestEvent& pb = pb_event.request_event();
+                if (pb.has_raw()) {
+                    specific->raw = Input::Buffer(pb.raw());
+                }
+                if (pb.has_method()) {
+                    specific->method = Input::Buffer(pb.method());
+                }
+                if (pb.has_uri()) {
+                    specific->uri = Input::Buffer(pb.uri());
+                }
+                if (pb.has_protocol()) {
+                    specific->protocol = Input::Buffer(pb.protocol());
+                }
+                break;
+            }
+            case Input::RESPONSE_STARTED:
+            {
+                // ResponseEvent
+                boost::shared_ptr<Input::ResponseEvent> specific =
+                    boost::make_shared<Input::ResponseEvent>(which);
+                generic = specific;
+                if (! pb_event.has_response_event()) {
+                    throw runtime_error(
+                        "ResponseEvent lacking specific data."
+                    );
+                }
+                const PB::ResponseEvent& pb = pb_event.response_event();
+                if (pb.has_raw()) {
+                    specific->raw = Input::Buffer(pb.raw());
+                }
+                if (pb.has_status()) {
+                    specific->status = Input::Buffer(pb.status());
+                }
+                if (pb.has_message()) {
+                    specific->message = Input::Buffer(pb.message());
+                }
+                if (pb.has_protocol()) {
+                    specific->protocol = Input::Buffer(pb.protocol());
+                }
+                break;
+            }
+            case Input::REQUEST_HEADER:
+            case Input::RESPONSE_HEADER:
+            {
+                // HeaderEvent
+                boost::shared_ptr<Input::HeaderEvent> specific =
+                    boost::make_shared<Input::HeaderEvent>(which);
+                generic = specific;
+                if (! pb_event.has_header_event()) {
+                    throw runtime_error("HeaderEvent lacking specific data.");
+                }
+                const PB::HeaderEvent& pb = pb_event.header_event();
+                BOOST_FOREACH(const PB::Header& pb_header, pb.header()) {
+                    specific->headers.push_back(Input::header_t());
+                    Input::header_t& header = specific->headers.back();
+                    header.first = Input::Buffer(pb_header.name());
+                    header.second = Input::Buffer(pb_header.value());
+                }
+                break;
+            }
+            default:
+                throw runtime_error(
+                    "Invalid event type: "
+                    + boost::lexical_cast<string>(pb_event.which())
+                );
+        }
+
+        if (pb_event.has_pre_delay()) {
+            generic->pre_delay = pb_event.pre_delay();
+        }
+        if (pb_event.has_post_delay()) {
+            generic->post_delay = pb_event.post_delay();
+        }
+
+        return generic;
+    }
+};
+
+}
+
+void input_to_pb(const Input::Input& input, PB::Input& pb_input)
+{
+    if (! input.id.empty()) {
+        pb_input.set_id(input.id);
+    }
+
+    PB::Connection& pb_connection = *pb_input.mutable_connection();
+
+    BOOST_FOREACH(
+        const Input::event_p event,
+        input.connection.pre_transaction_events
+    )
+    {
+        PB::Event& pb_event = *pb_connection.add_pre_transaction_event();
+        fill_event(pb_event, *event);
+        PBEncodeDelegate delegate(pb_event);
+        event->dispatch(delegate);
+    }
+
+    BOOST_FOREACH(
+        const Input::Transaction& tx,
+        input.connection.transactions
+    )
+    {
+        PB::Transaction& pb_tx = *pb_connection.add_transaction();
+        BOOST_FOREACH(const Input::event_p event, tx.events) {
+            PB::Event& pb_event = *pb_tx.add_event();
+            fill_event(pb_event, *event);
+            PBEncodeDelegate delegate(pb_event);
+            event->dispatch(delegate);
+        }
+    }
+
+    BOOST_FOREACH(
+        const Input::event_p event,
+        input.connection.post_transaction_events
+    )
+    {
+        PB::Event& pb_event = *pb_connection.add_post_transaction_event();
+        fill_event(pb_event, *event);
+        PBEncodeDelegate delegate(pb_event);
+        event->dispatch(delegate);
+    }
+}
+
+void pb_to_input(const PB::Input& pb_input, Input::Input& input)
+{
+    if (pb_input.has_id()) {
+        input.id = pb_input.id();
+    }
+
+    const PB::Connection& pb_conn = pb_input.connection();
+
+    transform(
+        pb_conn.pre_transaction_event().begin(),
+        pb_conn.pre_transaction_event().end(),
+        back_inserter(input.connection.pre_transaction_events),
+        pb_to_event()
+    );
+
+    BOOST_FOREACH(const PB::Transaction& pb_tx, pb_conn.transaction())
+    {
+        Input::Transaction& tx = input.connection.add_transaction();
+        transform(
+            pb_tx.event().begin(), pb_tx.event().end(),
+            back_inserter(tx.events),
+            pb_to_event()
+        );
+    }
+
+    transform(
+        pb_conn.post_transaction_event().begin(),
+        pb_conn.post_transaction_event().end(),
+        back_inserter(input.connection.post_transaction_events),
+        pb_to_event()
+    );
+}
+
+} // CLIPP
+} // IronBee
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Protobuf Codec.
+ *
+ * Conversion between Input::Input and the PB::Input protobuf message,
+ * shared by the protobuf generators and consumers.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#ifndef __IRONBEE__CLIPP__PB_CODEC__
+#define __IRONBEE__CLIPP__PB_CODEC__
+
+#include <clipp/input.hpp>
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace PB {
+class Input;
+}
+
+/**
+ * Fill @a pb_input from @a input.
+ *
+ * @param[in]  input    Input to encode.
+ * @param[out] pb_input Message to fill.
+ **/
+void input_to_pb(const Input::Input& input, PB::Input& pb_input);
+
+/**
+ * Fill @a input from @a pb_input.
+ *
+ * The buffers of @a input alias memory owned by @a pb_input, so
+ * @a pb_input must outlive @a input; generators arrange this by holding
+ * the message in the input's source.
+ *
+ * @param[in]  pb_input Message to decode.
+ * @param[out] input    Input to fill.  Should be freshly reset; events
+ *                      are appended.
+ **/
+void pb_to_input(const PB::Input& pb_input, Input::Input& input);
+
+} // CLIPP
+} // IronBee
+
+#endif
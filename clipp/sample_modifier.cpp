@@ -0,0 +1,225 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Sample Modifier Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "sample_modifier.hpp"
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#if __has_warning("-Wunused-local-typedef")
+#pragma clang diagnostic ignored "-Wunused-local-typedef"
+#endif
+#endif
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace {
+
+const uint64_t c_fnv_basis = 14695981039346656037ULL;
+const uint64_t c_fnv_prime = 1099511628211ULL;
+
+//! Mix @a c into FNV-1a hash @a h.
+void hash_byte(uint64_t& h, uint8_t c)
+{
+    h = (h ^ c) * c_fnv_prime;
+}
+
+//! Mix the path shape of URI @a buffer into @a h.
+/**
+ * Runs of digits collapse to a single @c # and the query string is
+ * dropped, so /item/123 and /item/7?x=1 share a shape.
+ **/
+void hash_path_shape(uint64_t& h, const Input::Buffer& buffer)
+{
+    bool in_digits = false;
+    for (size_t i = 0; i < buffer.length; ++i) {
+        char c = buffer.data[i];
+        if (c == '?') {
+            break;
+        }
+        if (isdigit(c)) {
+            if (! in_digits) {
+                hash_byte(h, '#');
+                in_digits = true;
+            }
+        }
+        else {
+            hash_byte(h, c);
+            in_digits = false;
+        }
+    }
+}
+
+//! Mix the shape of transaction @a tx into @a h.
+void hash_transaction_shape(uint64_t& h, const Input::Transaction& tx)
+{
+    vector<string> header_names;
+
+    BOOST_FOREACH(const Input::event_p& event, tx.events) {
+        if (event->which == Input::REQUEST_STARTED) {
+            const Input::RequestEvent& request =
+                dynamic_cast<const Input::RequestEvent&>(*event);
+            for (size_t i = 0; i < request.method.length; ++i) {
+                hash_byte(h, request.method.data[i]);
+            }
+            hash_byte(h, '|');
+            hash_path_shape(h, request.uri);
+            hash_byte(h, '|');
+        }
+        else if (event->which == Input::REQUEST_HEADER) {
+            const Input::HeaderEvent& header_event =
+                dynamic_cast<const Input::HeaderEvent&>(*event);
+            BOOST_FOREACH(
+                const Input::header_t& header,
+                header_event.headers
+            ) {
+                string name(header.first.data, header.first.length);
+                transform(name.begin(), name.end(), name.begin(), ::tolower);
+                header_names.push_back(name);
+            }
+        }
+    }
+
+    /* Header order is transport noise; the set of names is shape. */
+    sort(header_names.begin(), header_names.end());
+    BOOST_FOREACH(const string& name, header_names) {
+        for (size_t i = 0; i < name.length(); ++i) {
+            hash_byte(h, name[i]);
+        }
+        hash_byte(h, '\n');
+    }
+}
+
+//! Fingerprint of the transaction shapes of @a input.
+uint64_t fingerprint_of_input(const Input::Input& input)
+{
+    uint64_t h = c_fnv_basis;
+    BOOST_FOREACH(const Input::Transaction& tx, input.connection.transactions)
+    {
+        hash_transaction_shape(h, tx);
+        hash_byte(h, ';');
+    }
+    return h;
+}
+
+//! Per-stratum bookkeeping.
+struct stratum_t
+{
+    stratum_t() :
+        seen(0),
+        emitted(0)
+    {
+        // nop
+    }
+
+    uint64_t seen;
+    uint64_t emitted;
+    string   example_id;  //!< ID of first input of stratum.
+};
+
+}
+
+struct SampleModifier::State
+{
+    ~State()
+    {
+        if (manifest_path.empty()) {
+            return;
+        }
+        ofstream manifest(manifest_path.c_str());
+        if (! manifest) {
+            /* Destructor; sampling already happened, so just note it. */
+            cerr << "Could not write manifest to " << manifest_path << endl;
+            return;
+        }
+        manifest << "# fingerprint seen emitted weight example" << endl;
+        typedef map<uint64_t, stratum_t>::value_type entry_t;
+        BOOST_FOREACH(const entry_t& entry, strata) {
+            const stratum_t& stratum = entry.second;
+            manifest << hex << setw(16) << setfill('0') << entry.first
+                     << dec << setfill(' ')
+                     << " " << stratum.seen
+                     << " " << stratum.emitted
+                     << " " << double(stratum.seen) / stratum.emitted
+                     << " " << stratum.example_id
+                     << endl;
+        }
+    }
+
+    size_t                    per_stratum;
+    string                    manifest_path;
+    map<uint64_t, stratum_t>  strata;
+};
+
+SampleModifier::SampleModifier(
+    size_t             per_stratum,
+    const std::string& manifest_path
+) :
+    m_state(boost::make_shared<State>())
+{
+    if (per_stratum == 0) {
+        throw runtime_error("Sample size per stratum must be positive.");
+    }
+    m_state->per_stratum   = per_stratum;
+    m_state->manifest_path = manifest_path;
+}
+
+bool SampleModifier::operator()(Input::input_p& input)
+{
+    if (! input) {
+        return true;
+    }
+
+    stratum_t& stratum = m_state->strata[fingerprint_of_input(*input)];
+    if (stratum.seen == 0) {
+        stratum.example_id = input->id;
+    }
+    ++stratum.seen;
+
+    if (stratum.emitted >= m_state->per_stratum) {
+        return false;
+    }
+    ++stratum.emitted;
+
+    return true;
+}
+
+} // CLIPP
+} // IronBee
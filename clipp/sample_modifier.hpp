@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Sample Modifier
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#ifndef __IRONBEE__CLIPP__SAMPLE_MODIFIER__
+#define __IRONBEE__CLIPP__SAMPLE_MODIFIER__
+
+#include <clipp/input.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+namespace IronBee {
+namespace CLIPP {
+
+/**
+ * Emit a stratified sample of inputs.
+ *
+ * Inputs are grouped into strata by a shape fingerprint of their
+ * transactions: request method, path with digit runs collapsed and the
+ * query string dropped, and the set of request header names.  The first
+ * @a per_stratum inputs of each stratum pass; later inputs of the same
+ * shape are discarded.  Corpora dominated by identical traffic, e.g.,
+ * health checks, thus shrink dramatically while every rare shape is
+ * retained.
+ *
+ * On destruction, a manifest of strata is optionally written: one line
+ * per stratum with its fingerprint, inputs seen, inputs emitted, the
+ * weight (seen / emitted) to scale per-stratum results back to corpus
+ * proportions, and the ID of the first input, as an example.
+ **/
+class SampleModifier
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] per_stratum   Inputs to emit per stratum.  Must be
+     *                          positive.
+     * @param[in] manifest_path Path to write the strata manifest to;
+     *                          empty for no manifest.
+     **/
+    explicit
+    SampleModifier(
+        size_t             per_stratum,
+        const std::string& manifest_path = std::string()
+    );
+
+    //! Process an input.
+    bool operator()(Input::input_p& input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
+} // CLIPP
+} // IronBee
+
+#endif
@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Schedule Modifier Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "schedule_modifier.hpp"
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#if __has_warning("-Wunused-local-typedef")
+#pragma clang diagnostic ignored "-Wunused-local-typedef"
+#endif
+#endif
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/random.hpp>
+#include <boost/thread.hpp>
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace IronBee {
+namespace CLIPP {
+
+namespace {
+
+//! Scale the pre and post delays of every event of @a input.
+void scale_delays(Input::Input& input, double factor)
+{
+    BOOST_FOREACH(Input::event_p& event, input.connection.pre_transaction_events) {
+        event->pre_delay  *= factor;
+        event->post_delay *= factor;
+    }
+    BOOST_FOREACH(Input::Transaction& tx, input.connection.transactions) {
+        BOOST_FOREACH(Input::event_p& event, tx.events) {
+            event->pre_delay  *= factor;
+            event->post_delay *= factor;
+        }
+    }
+    BOOST_FOREACH(Input::event_p& event, input.connection.post_transaction_events) {
+        event->pre_delay  *= factor;
+        event->post_delay *= factor;
+    }
+}
+
+}
+
+struct ScheduleModifier::State
+{
+    State(mode_e mode_, double rate_, double burst_, double period_, unsigned seed) :
+        mode(mode_),
+        rate(rate_),
+        burst(burst_),
+        period(period_),
+        rng(seed),
+        started(false)
+    {
+        // nop
+    }
+
+    //! Seconds until the next release after the current one.
+    double next_interval()
+    {
+        switch (mode) {
+            case RATE:
+                return 1 / rate;
+            case POISSON:
+            {
+                boost::random::exponential_distribution<double> dist(rate);
+                return dist(rng);
+            }
+            case BURST:
+            {
+                /* First half of each cycle at base rate, second half at
+                 * burst * rate. */
+                double cycle_s = fmod(
+                    (next_at - start_at).total_microseconds() / 1e6,
+                    period
+                );
+                return 1 / (cycle_s < period / 2 ? rate : rate * burst);
+            }
+            default:
+                throw logic_error("Unknown mode.  Please report as bug.");
+        }
+    }
+
+    mode_e                    mode;
+    double                    rate;
+    double                    burst;
+    double                    period;
+    boost::random::mt19937    rng;
+    bool                      started;
+    boost::posix_time::ptime  start_at;
+    boost::posix_time::ptime  next_at;
+};
+
+ScheduleModifier::ScheduleModifier(
+    mode_e   mode,
+    double   rate,
+    double   burst,
+    double   period,
+    unsigned seed
+) :
+    m_state(boost::make_shared<State>(mode, rate, burst, period, seed))
+{
+    if (rate <= 0) {
+        throw runtime_error("Schedule rate must be positive.");
+    }
+    if (mode == BURST && (burst < 1 || period <= 0)) {
+        throw runtime_error(
+            "Schedule burst must be at least 1 and period positive."
+        );
+    }
+}
+
+bool ScheduleModifier::operator()(Input::input_p& input)
+{
+    if (! input) {
+        return true;
+    }
+
+    if (m_state->mode == REPLAY) {
+        scale_delays(*input, 1 / m_state->rate);
+        return true;
+    }
+
+    if (! m_state->started) {
+        m_state->started  = true;
+        m_state->start_at = boost::posix_time::microsec_clock::universal_time();
+        m_state->next_at  = m_state->start_at;
+    }
+
+    boost::posix_time::ptime now =
+        boost::posix_time::microsec_clock::universal_time();
+    if (now < m_state->next_at) {
+        boost::this_thread::sleep(m_state->next_at - now);
+    }
+
+    m_state->next_at += boost::posix_time::microseconds(
+        int64_t(m_state->next_interval() * 1e6)
+    );
+
+    return true;
+}
+
+} // CLIPP
+} // IronBee
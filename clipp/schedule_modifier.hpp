@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- CLIPP Schedule Modifier
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#ifndef __IRONBEE__CLIPP__SCHEDULE_MODIFIER__
+#define __IRONBEE__CLIPP__SCHEDULE_MODIFIER__
+
+#include <clipp/input.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+namespace IronBee {
+namespace CLIPP {
+
+/**
+ * Shape the arrival pattern of inputs.
+ *
+ * By default clipp replays inputs as fast as the consumer accepts them,
+ * which does not reproduce production arrival patterns.  This modifier
+ * paces inputs according to a schedule:
+ *
+ * - REPLAY scales the recorded pre and post delays of every event by
+ *   1 / speedup, so consumers that honor delays reproduce the recorded
+ *   intra-connection timing, faster or slower than realtime.
+ * - RATE releases inputs at a constant target rate.
+ * - POISSON releases inputs with exponentially distributed inter-arrival
+ *   times at a target mean rate.  The generator is explicitly seeded so
+ *   a schedule can be replayed exactly.
+ * - BURST alternates each half @a period between the target rate and
+ *   @a burst times the target rate, modeling traffic spikes.
+ *
+ * Pacing delays the pipeline, so inputs are released no faster than the
+ * schedule; a consumer slower than the schedule still applies
+ * backpressure.  Inputs are only modified in REPLAY mode.
+ **/
+class ScheduleModifier
+{
+public:
+    //! Schedule to follow.
+    enum mode_e {
+        REPLAY,
+        RATE,
+        POISSON,
+        BURST
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param[in] mode   Schedule to follow.
+     * @param[in] rate   Target inputs per second; for REPLAY, the speedup
+     *                   factor instead.  Must be positive.
+     * @param[in] burst  BURST only: rate multiplier during bursts.
+     * @param[in] period BURST only: seconds per burst cycle.
+     * @param[in] seed   POISSON only: random seed.
+     **/
+    explicit
+    ScheduleModifier(
+        mode_e   mode,
+        double   rate,
+        double   burst  = 1,
+        double   period = 1,
+        unsigned seed   = 0
+    );
+
+    //! Process an input.
+    bool operator()(Input::input_p& input);
+
+private:
+    struct State;
+    boost::shared_ptr<State> m_state;
+};
+
+} // CLIPP
+} // IronBee
+
+#endif
@@ -0,0 +1,93 @@
+# Pinned corpus for `make perfcheck`.
+#
+# A small, deterministic mix of traffic: simple GETs, GETs with query
+# strings that exercise the ARGS rules, a POST with a urlencoded body,
+# and a request with a long cookie header.  Do not change this file
+# without regenerating perfcheck_baseline.txt; the baselines are only
+# meaningful against this exact corpus.
+#
+# Rendered to protobuf by clippscript.rb; see perfcheck.rb.
+
+200.times do |i|
+  transaction(id: "perfcheck-get-#{i}") do |t|
+    t.request(
+      raw: "GET /index/#{i} HTTP/1.1",
+      headers: {
+        'Host'       => 'perfcheck.example.com',
+        'User-Agent' => 'clipp-perfcheck/1.0',
+        'Accept'     => '*/*'
+      }
+    )
+    t.response(
+      raw: "HTTP/1.1 200 OK",
+      headers: {
+        'Content-Type'   => 'text/html',
+        'Content-Length' => '0'
+      }
+    )
+  end
+end
+
+200.times do |i|
+  transaction(id: "perfcheck-args-#{i}") do |t|
+    t.request(
+      raw: "GET /search?q=term#{i}&page=#{i % 10}&sort=asc HTTP/1.1",
+      headers: {
+        'Host'       => 'perfcheck.example.com',
+        'User-Agent' => 'clipp-perfcheck/1.0',
+        'Referer'    => "http://perfcheck.example.com/index/#{i}"
+      }
+    )
+    t.response(
+      raw: "HTTP/1.1 200 OK",
+      headers: {
+        'Content-Type'   => 'text/html',
+        'Content-Length' => '0'
+      }
+    )
+  end
+end
+
+100.times do |i|
+  body = "user=perfcheck#{i}&comment=" + ("lorem+ipsum+" * 20) + "&submit=1"
+  transaction(id: "perfcheck-post-#{i}") do |t|
+    t.request(
+      raw: "POST /comment HTTP/1.1",
+      headers: {
+        'Host'           => 'perfcheck.example.com',
+        'User-Agent'     => 'clipp-perfcheck/1.0',
+        'Content-Type'   => 'application/x-www-form-urlencoded',
+        'Content-Length' => body.length.to_s
+      },
+      body: body
+    )
+    t.response(
+      raw: "HTTP/1.1 302 Found",
+      headers: {
+        'Location'       => '/comment/done',
+        'Content-Length' => '0'
+      }
+    )
+  end
+end
+
+100.times do |i|
+  transaction(id: "perfcheck-cookie-#{i}") do |t|
+    t.request(
+      raw: "GET /profile HTTP/1.1",
+      headers: {
+        'Host'       => 'perfcheck.example.com',
+        'User-Agent' => 'clipp-perfcheck/1.0',
+        'Cookie'     => "session=#{('%08x' % i) * 8}; theme=dark; " +
+                        "tracker=#{('%04x' % i) * 16}"
+      }
+    )
+    t.response(
+      raw: "HTTP/1.1 200 OK",
+      headers: {
+        'Content-Type'   => 'text/html',
+        'Content-Length' => '0'
+      }
+    )
+  end
+end
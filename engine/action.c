@@ -114,6 +114,13 @@ ib_status_t ib_action_register(
     ib_status_t rc;
     ib_hash_t *action_hash = ib->actions;
 
+    /* The registry is read without locking on per-transaction paths;
+     * it is frozen once configuration completes so that lookups never
+     * race a mutation. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
     rc = ib_hash_get(action_hash, NULL, action->name);
     if (rc == IB_OK) {
         /* Already exists. */
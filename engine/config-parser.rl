@@ -480,6 +480,21 @@ static ib_status_t include_parse_directive_impl(
         goto cleanup;
     }
 
+    /* Serve the include from the per-include parse cache, if enabled. */
+    if (cp->include_cache_dir != NULL) {
+        bool cache_hit = false;
+
+        rc = ib_cfgparser_include_cache_lookup(cp, incfile, node, &cache_hit);
+        if (rc == IB_OK && cache_hit) {
+            ib_cfg_log_debug(
+                cp,
+                "Include file \"%s\" served from parse cache.",
+                incfile);
+            goto cleanup;
+        }
+        rc = IB_OK;
+    }
+
     /* Parse the include file. */
     rc = include_parse_directive_impl_parse(cp, node, mm, incfile);
     if (rc != IB_OK) {
@@ -492,6 +507,21 @@ static ib_status_t include_parse_directive_impl(
         goto cleanup;
     }
 
+    /* Cache the parsed subtree. A failed save only costs a later
+     * reload the cache for this file. */
+    if (cp->include_cache_dir != NULL) {
+        ib_status_t cache_rc;
+
+        cache_rc = ib_cfgparser_include_cache_store(cp, incfile, node);
+        if (cache_rc != IB_OK) {
+            ib_cfg_log_debug(
+                cp,
+                "Failed to cache include file \"%s\": %s",
+                incfile,
+                ib_status_to_string(cache_rc));
+        }
+    }
+
     ib_cfg_log_debug(cp, "Finished processing include file \"%s\"", incfile);
 
 cleanup:
@@ -159,6 +159,12 @@ ib_status_t ib_cfgparser_create(ib_cfgparser_t **pcp, ib_engine_t *ib)
         goto failed;
     }
 
+    /* Create the per-directive timing hash. */
+    rc = ib_hash_create(&(cp->dirstats), cp->mm);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
     /* Other fields are NULLed via calloc */
     *pcp = cp;
     return IB_OK;
@@ -392,6 +398,70 @@ static ib_status_t cfgparser_apply_node_helper(
     ib_engine_t *ib,
     ib_cfgparser_node_t *node);
 
+/**
+ * Dispatch a run of consecutive identical directives to a batch handler.
+ *
+ * Builds an array of the run's parameter lists and invokes the
+ * directive's registered batch callback once, amortizing directive
+ * lookup and dispatch across the run.  On return @a plist_node points
+ * past the run.
+ *
+ * @param[in] cp Configuration parser
+ * @param[in] rec Directive registration with a non-NULL @c fn_batch
+ * @param[in,out] plist_node First node of the run; advanced past it
+ * @param[in] count Number of directives in the run
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Status of the batch callback otherwise.
+ */
+static ib_status_t cfgparser_apply_directive_batch(
+    ib_cfgparser_t *cp,
+    const ib_dirmap_init_t *rec,
+    ib_list_node_t **plist_node,
+    size_t count)
+{
+    const ib_list_t     **arg_lists;
+    ib_cfgparser_node_t  *first;
+    ib_cfgparser_node_t  *prev_curr;
+    size_t                i;
+    ib_status_t           rc;
+
+    arg_lists = ib_mm_alloc(cp->mm, count * sizeof(*arg_lists));
+    if (arg_lists == NULL) {
+        return IB_EALLOC;
+    }
+
+    first = ib_list_node_data(*plist_node);
+    for (i = 0; i < count; ++i) {
+        ib_cfgparser_node_t *n = ib_list_node_data(*plist_node);
+        arg_lists[i] = n->params;
+        *plist_node = ib_list_node_next(*plist_node);
+    }
+
+    /* Report errors against the start of the run. */
+    prev_curr = cp->curr;
+    cp->curr = first;
+    rc = rec->fn_batch(
+        cp,
+        first->directive,
+        arg_lists,
+        count,
+        rec->cbdata_batch);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(
+            cp,
+            "Error processing batch of %zd \"%s\" directives: %s",
+            count,
+            first->directive,
+            ib_status_to_string(rc));
+    }
+    cp->curr = prev_curr;
+
+    return rc;
+}
+
 static ib_status_t cfgparser_apply_node_children_helper(
     ib_cfgparser_t *cp,
     ib_engine_t *ib,
@@ -400,14 +470,50 @@ static ib_status_t cfgparser_apply_node_children_helper(
     ib_list_node_t *list_node;
     ib_status_t rc = IB_OK;
 
-    IB_LIST_LOOP(node->children, list_node) {
+    list_node = ib_list_first(node->children);
+    while (list_node != NULL) {
         ib_cfgparser_node_t *child = ib_list_node_data(list_node);
         ib_status_t tmp_rc;
 
+        /* Hand runs of consecutive identical directives to the
+         * directive's batch handler, when one is registered. */
+        if (child->type == IB_CFGPARSER_NODE_DIRECTIVE) {
+            ib_dirmap_init_t *rec;
+            size_t run = 0;
+
+            tmp_rc = ib_hash_get(ib->dirmap, &rec, child->directive);
+            if (tmp_rc == IB_OK && rec->fn_batch != NULL) {
+                ib_list_node_t *run_node;
+
+                for (run_node = list_node;
+                     run_node != NULL;
+                     run_node = ib_list_node_next(run_node))
+                {
+                    ib_cfgparser_node_t *n = ib_list_node_data(run_node);
+                    if (   (n->type != IB_CFGPARSER_NODE_DIRECTIVE)
+                        || (strcmp(n->directive, child->directive) != 0))
+                    {
+                        break;
+                    }
+                    ++run;
+                }
+            }
+            if (run > 1) {
+                tmp_rc = cfgparser_apply_directive_batch(
+                    cp, rec, &list_node, run);
+                if (rc == IB_OK && tmp_rc != IB_OK) {
+                    rc = tmp_rc;
+                }
+                continue;
+            }
+        }
+
         tmp_rc = cfgparser_apply_node_helper(cp, ib, child);
         if (rc == IB_OK && tmp_rc != IB_OK) {
             rc = tmp_rc;
         }
+
+        list_node = ib_list_node_next(list_node);
     }
 
     return rc;
@@ -724,6 +830,8 @@ ib_status_t ib_config_register_directive(
     rec->cbdata_cb = cbdata_config;
     rec->cbdata_blkend = cbdata_blkend;
     rec->valmap = valmap;
+    rec->fn_batch = NULL;
+    rec->cbdata_batch = NULL;
 
     rc = ib_hash_get(ib->dirmap, NULL, rec->name);
     if (rc == IB_OK) {
@@ -886,6 +994,53 @@ ib_status_t ib_config_directive_type(
     return IB_OK;
 }
 
+/**
+ * Accumulate @a elapsed microseconds against directive @a name.
+ *
+ * Failures are swallowed; timing is advisory and must not fail the
+ * directive being recorded.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name Directive name.  Must have engine lifetime; the
+ *            registered directive name is used.
+ * @param[in] elapsed Handler time in microseconds.
+ */
+static void record_directive_time(
+    ib_cfgparser_t *cp,
+    const char     *name,
+    ib_time_t       elapsed
+)
+{
+    assert(cp != NULL);
+    assert(name != NULL);
+
+    ib_cfgparser_dirstat_t *stat;
+    ib_status_t             rc;
+
+    if (cp->dirstats == NULL) {
+        return;
+    }
+
+    rc = ib_hash_get(cp->dirstats, &stat, name);
+    if (rc == IB_ENOENT) {
+        stat = ib_mm_calloc(cp->mm, 1, sizeof(*stat));
+        if (stat == NULL) {
+            return;
+        }
+        stat->name = name;
+        rc = ib_hash_set(cp->dirstats, name, stat);
+        if (rc != IB_OK) {
+            return;
+        }
+    }
+    else if (rc != IB_OK) {
+        return;
+    }
+
+    ++(stat->count);
+    stat->usec += elapsed;
+}
+
 ib_status_t ib_config_directive_process(ib_cfgparser_t *cp,
                                         const char *name,
                                         ib_list_t *args)
@@ -923,6 +1078,8 @@ ib_status_t ib_config_directive_process(ib_cfgparser_t *cp,
         return rc;
     }
 
+    ib_time_t start_usec = ib_clock_precise_get_time();
+
     switch (rec->type) {
         case IB_DIRTYPE_ONOFF:
             if (nargs != 1) {
@@ -1005,6 +1162,10 @@ ib_status_t ib_config_directive_process(ib_cfgparser_t *cp,
             break;
     }
 
+    record_directive_time(
+        cp, rec->name, ib_clock_precise_get_time() - start_usec
+    );
+
     if (rc != IB_OK) {
         ib_cfg_log_error(
             cp,
@@ -1016,6 +1177,87 @@ ib_status_t ib_config_directive_process(ib_cfgparser_t *cp,
     return rc;
 }
 
+/** qsort comparator: descending total time. */
+static int dirstat_cmp(const void *lhs, const void *rhs)
+{
+    const ib_cfgparser_dirstat_t *l = *(const ib_cfgparser_dirstat_t * const *)lhs;
+    const ib_cfgparser_dirstat_t *r = *(const ib_cfgparser_dirstat_t * const *)rhs;
+
+    if (l->usec > r->usec) {
+        return -1;
+    }
+    if (l->usec < r->usec) {
+        return 1;
+    }
+    return 0;
+}
+
+ib_status_t ib_cfgparser_dirstats(
+    const ib_cfgparser_t *cp,
+    ib_mm_t               mm,
+    const ib_list_t     **stats)
+{
+    assert(cp != NULL);
+    assert(stats != NULL);
+
+    ib_list_t               *result;
+    ib_hash_iterator_t      *iterator;
+    ib_cfgparser_dirstat_t **sorted;
+    size_t                   num_stats;
+    size_t                   i;
+    ib_status_t              rc;
+
+    rc = ib_list_create(&result, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (cp->dirstats == NULL) {
+        *stats = result;
+        return IB_OK;
+    }
+
+    num_stats = ib_hash_size(cp->dirstats);
+    if (num_stats == 0) {
+        *stats = result;
+        return IB_OK;
+    }
+
+    sorted = ib_mm_alloc(mm, num_stats * sizeof(*sorted));
+    if (sorted == NULL) {
+        return IB_EALLOC;
+    }
+
+    iterator = ib_hash_iterator_create(mm);
+    if (iterator == NULL) {
+        return IB_EALLOC;
+    }
+    i = 0;
+    for (
+        ib_hash_iterator_first(iterator, cp->dirstats);
+        ! ib_hash_iterator_at_end(iterator) && i < num_stats;
+        ib_hash_iterator_next(iterator)
+    )
+    {
+        ib_cfgparser_dirstat_t *stat;
+        ib_hash_iterator_fetch(NULL, NULL, &stat, iterator);
+        sorted[i] = stat;
+        ++i;
+    }
+
+    qsort(sorted, i, sizeof(*sorted), dirstat_cmp);
+
+    for (num_stats = i, i = 0; i < num_stats; ++i) {
+        rc = ib_list_push(result, sorted[i]);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *stats = result;
+    return IB_OK;
+}
+
 ib_status_t ib_config_block_start(ib_cfgparser_t *cp,
                                   const char *name,
                                   ib_list_t *args)
@@ -0,0 +1,966 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Configuration parse cache
+ *
+ * Serialization of the configuration parse tree to a versioned binary
+ * image. Loading the image replaces parsing: the deserialized tree is
+ * applied by ib_cfgparser_apply() exactly as a freshly parsed one would
+ * be. Directive handlers still run on every start; what is cached is
+ * the reading, character-level parsing and include traversal of the
+ * configuration text.
+ *
+ * The image records the modification time and size of every file that
+ * contributed to the tree and is declined when any of them change.
+ *
+ * Also here: the per-include parse cache, which images the subtree of
+ * each included file keyed by a content hash, so a full re-parse only
+ * re-lexes the includes that actually changed.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/config.h>
+#include "config_private.h"
+
+#include <ironbee/list.h>
+#include <ironbee/path.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** Magic number opening a cache image. */
+static const uint32_t CACHE_MAGIC = 0x49424343; /* "IBCC" */
+
+/** Format version. Bump on any layout change. */
+static const uint32_t CACHE_VERSION = 1;
+
+/** Length value encoding a NULL string. */
+static const uint32_t NULL_STRING = UINT32_MAX;
+
+/**
+ * Write @a length bytes, reporting short writes as errors.
+ */
+static ib_status_t write_bytes(FILE *fp, const void *data, size_t length)
+{
+    if (length > 0 && fwrite(data, length, 1, fp) != 1) {
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+static ib_status_t write_u8(FILE *fp, uint8_t value)
+{
+    return write_bytes(fp, &value, sizeof(value));
+}
+
+static ib_status_t write_u32(FILE *fp, uint32_t value)
+{
+    return write_bytes(fp, &value, sizeof(value));
+}
+
+static ib_status_t write_u64(FILE *fp, uint64_t value)
+{
+    return write_bytes(fp, &value, sizeof(value));
+}
+
+/**
+ * Write a NUL-terminated string as a length and bytes. NULL is encoded
+ * as the length @ref NULL_STRING.
+ */
+static ib_status_t write_string(FILE *fp, const char *str)
+{
+    ib_status_t rc;
+    size_t      length;
+
+    if (str == NULL) {
+        return write_u32(fp, NULL_STRING);
+    }
+
+    length = strlen(str);
+    rc = write_u32(fp, (uint32_t)length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return write_bytes(fp, str, length);
+}
+
+/**
+ * Read exactly @a length bytes. A short read is IB_EINVAL: the image
+ * is truncated.
+ */
+static ib_status_t read_bytes(FILE *fp, void *data, size_t length)
+{
+    if (length > 0 && fread(data, length, 1, fp) != 1) {
+        return IB_EINVAL;
+    }
+
+    return IB_OK;
+}
+
+static ib_status_t read_u8(FILE *fp, uint8_t *value)
+{
+    return read_bytes(fp, value, sizeof(*value));
+}
+
+static ib_status_t read_u32(FILE *fp, uint32_t *value)
+{
+    return read_bytes(fp, value, sizeof(*value));
+}
+
+static ib_status_t read_u64(FILE *fp, uint64_t *value)
+{
+    return read_bytes(fp, value, sizeof(*value));
+}
+
+/**
+ * Read a string written by write_string() into memory from @a mm.
+ */
+static ib_status_t read_string(FILE *fp, ib_mm_t mm, const char **str)
+{
+    ib_status_t rc;
+    uint32_t    length;
+    char       *buf;
+
+    rc = read_u32(fp, &length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (length == NULL_STRING) {
+        *str = NULL;
+        return IB_OK;
+    }
+
+    buf = ib_mm_alloc(mm, (size_t)length + 1);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = read_bytes(fp, buf, length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    buf[length] = '\0';
+
+    *str = buf;
+    return IB_OK;
+}
+
+/**
+ * Collect the distinct files that contributed to the parse tree.
+ *
+ * Every parsed file produces an @ref IB_CFGPARSER_NODE_FILE node, so
+ * walking the tree for them yields the complete set of inputs.
+ *
+ * @param[in] node Subtree to walk.
+ * @param[in,out] files List of const char * the file names are pushed to.
+ *
+ * @returns IB_OK or IB_EALLOC.
+ */
+static ib_status_t collect_files(
+    const ib_cfgparser_node_t *node,
+    ib_list_t                 *files
+)
+{
+    const ib_list_node_t *list_node;
+    ib_status_t           rc;
+
+    if (node->type == IB_CFGPARSER_NODE_FILE && node->file != NULL) {
+        bool seen = false;
+
+        IB_LIST_LOOP_CONST(files, list_node) {
+            const char *file = ib_list_node_data_const(list_node);
+            if (strcmp(file, node->file) == 0) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) {
+            rc = ib_list_push(files, (void *)node->file);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+    }
+
+    IB_LIST_LOOP_CONST(node->children, list_node) {
+        const ib_cfgparser_node_t *child =
+            ib_list_node_data_const(list_node);
+
+        rc = collect_files(child, files);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Serialize @a node and its children.
+ */
+static ib_status_t write_node(FILE *fp, const ib_cfgparser_node_t *node)
+{
+    const ib_list_node_t *list_node;
+    ib_status_t           rc;
+
+    rc = write_u8(fp, (uint8_t)node->type);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = write_string(fp, node->directive);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = write_string(fp, node->file);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = write_u64(fp, (uint64_t)node->line);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = write_u32(fp, (uint32_t)ib_list_elements(node->params));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    IB_LIST_LOOP_CONST(node->params, list_node) {
+        rc = write_string(fp, ib_list_node_data_const(list_node));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    rc = write_u32(fp, (uint32_t)ib_list_elements(node->children));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    IB_LIST_LOOP_CONST(node->children, list_node) {
+        rc = write_node(fp, ib_list_node_data_const(list_node));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Deserialize one node and its children into @a cp's memory.
+ */
+static ib_status_t read_node(
+    FILE                 *fp,
+    ib_cfgparser_t       *cp,
+    ib_cfgparser_node_t  *parent,
+    ib_cfgparser_node_t **out_node
+)
+{
+    ib_cfgparser_node_t *node;
+    uint8_t              type;
+    uint64_t             line;
+    uint32_t             count;
+    ib_status_t          rc;
+
+    rc = ib_cfgparser_node_create(&node, cp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    node->parent = parent;
+
+    rc = read_u8(fp, &type);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    node->type = (ib_cfgparser_node_type_t)type;
+
+    rc = read_string(fp, cp->mm, &node->directive);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = read_string(fp, cp->mm, &node->file);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = read_u64(fp, &line);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    node->line = (size_t)line;
+
+    rc = read_u32(fp, &count);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const char *param;
+
+        rc = read_string(fp, cp->mm, &param);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_list_push(node->params, (void *)param);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    rc = read_u32(fp, &count);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        ib_cfgparser_node_t *child;
+
+        rc = read_node(fp, cp, node, &child);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_list_push(node->children, child);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *out_node = node;
+    return IB_OK;
+}
+
+ib_status_t ib_cfgparser_cache_save(ib_cfgparser_t *cp, const char *path)
+{
+    assert(cp != NULL);
+    assert(cp->root != NULL);
+    assert(path != NULL);
+
+    FILE        *fp;
+    char        *tmp_path;
+    ib_list_t   *files;
+    const ib_list_node_t *list_node;
+    ib_status_t  rc;
+
+    /* Write to a temporary file and rename it into place so a crash
+     * mid-save never leaves a truncated image behind. */
+    tmp_path = ib_mm_alloc(cp->mm, strlen(path) + sizeof(".tmp"));
+    if (tmp_path == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(tmp_path, "%s.tmp", path);
+
+    rc = ib_list_create(&files, cp->mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = collect_files(cp->root, files);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        return IB_EOTHER;
+    }
+
+    rc = write_u32(fp, CACHE_MAGIC);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+    rc = write_u32(fp, CACHE_VERSION);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
+    /* File manifest: path, mtime and size of every input. */
+    rc = write_u32(fp, (uint32_t)ib_list_elements(files));
+    if (rc != IB_OK) {
+        goto failed;
+    }
+    IB_LIST_LOOP_CONST(files, list_node) {
+        const char  *file = ib_list_node_data_const(list_node);
+        struct stat  file_stat;
+
+        if (stat(file, &file_stat) != 0) {
+            rc = IB_EOTHER;
+            goto failed;
+        }
+
+        rc = write_string(fp, file);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        rc = write_u64(fp, (uint64_t)file_stat.st_mtime);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        rc = write_u64(fp, (uint64_t)file_stat.st_size);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+    }
+
+    rc = write_node(fp, cp->root);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        rc = IB_EOTHER;
+        goto failed;
+    }
+    fp = NULL;
+
+    if (rename(tmp_path, path) != 0) {
+        rc = IB_EOTHER;
+        goto failed;
+    }
+
+    return IB_OK;
+
+failed:
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    unlink(tmp_path);
+
+    return rc;
+}
+
+ib_status_t ib_cfgparser_cache_load(ib_cfgparser_t *cp, const char *path)
+{
+    assert(cp != NULL);
+    assert(path != NULL);
+
+    FILE                *fp;
+    uint32_t             magic;
+    uint32_t             version;
+    uint32_t             nfiles;
+    ib_cfgparser_node_t *root;
+    ib_status_t          rc;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return (errno == ENOENT) ? IB_ENOENT : IB_EOTHER;
+    }
+
+    rc = read_u32(fp, &magic);
+    if (rc != IB_OK || magic != CACHE_MAGIC) {
+        rc = IB_EINVAL;
+        goto cleanup;
+    }
+    rc = read_u32(fp, &version);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    if (version != CACHE_VERSION) {
+        rc = IB_DECLINED;
+        goto cleanup;
+    }
+
+    /* Validate every input file against the manifest. */
+    rc = read_u32(fp, &nfiles);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    for (uint32_t i = 0; i < nfiles; ++i) {
+        const char  *file;
+        uint64_t     mtime;
+        uint64_t     size;
+        struct stat  file_stat;
+
+        rc = read_string(fp, cp->mm, &file);
+        if (rc != IB_OK || file == NULL) {
+            rc = IB_EINVAL;
+            goto cleanup;
+        }
+        rc = read_u64(fp, &mtime);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+        rc = read_u64(fp, &size);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+
+        if (
+            stat(file, &file_stat) != 0 ||
+            (uint64_t)file_stat.st_mtime != mtime ||
+            (uint64_t)file_stat.st_size != size
+        )
+        {
+            rc = IB_DECLINED;
+            goto cleanup;
+        }
+    }
+
+    rc = read_node(fp, cp, NULL, &root);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    if (root->type != IB_CFGPARSER_NODE_ROOT) {
+        rc = IB_EINVAL;
+        goto cleanup;
+    }
+
+    cp->root = root;
+    cp->curr = root;
+
+cleanup:
+    fclose(fp);
+
+    return rc;
+}
+
+ib_status_t ib_cfgparser_parse_cached(
+    ib_cfgparser_t *cp,
+    const char     *file,
+    const char     *cache_path
+)
+{
+    assert(cp != NULL);
+    assert(file != NULL);
+    assert(cache_path != NULL);
+
+    ib_status_t rc;
+
+    rc = ib_cfgparser_cache_load(cp, cache_path);
+    if (rc == IB_OK) {
+        return IB_OK;
+    }
+    if (rc != IB_ENOENT && rc != IB_DECLINED) {
+        ib_cfg_log_warning(
+            cp,
+            "Ignoring unreadable configuration cache %s: %s",
+            cache_path,
+            ib_status_to_string(rc));
+    }
+
+    /* Give includes their own per-file cache beside the whole-tree
+     * image, so an edit to one file does not force re-lexing every
+     * unchanged include on the full parse we are about to do. */
+    {
+        char *dir = ib_mm_alloc(cp->mm, strlen(cache_path) + sizeof(".d"));
+        ib_status_t cache_rc = IB_EALLOC;
+
+        if (dir != NULL) {
+            sprintf(dir, "%s.d", cache_path);
+            cache_rc = ib_cfgparser_include_cache_set(cp, dir);
+        }
+        if (cache_rc != IB_OK) {
+            ib_cfg_log_warning(
+                cp,
+                "Not caching include files under %s.d: %s",
+                cache_path,
+                ib_status_to_string(cache_rc));
+        }
+    }
+
+    rc = ib_cfgparser_parse(cp, file);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* A failed save costs the next start its cache, nothing more. */
+    rc = ib_cfgparser_cache_save(cp, cache_path);
+    if (rc != IB_OK) {
+        ib_cfg_log_warning(
+            cp,
+            "Failed to write configuration cache %s: %s",
+            cache_path,
+            ib_status_to_string(rc));
+    }
+
+    return IB_OK;
+}
+
+/** Magic number opening a per-include cache image. */
+static const uint32_t INCLUDE_CACHE_MAGIC = 0x49424349; /* "IBCI" */
+
+/** Per-include image format version. Bump on any layout change. */
+static const uint32_t INCLUDE_CACHE_VERSION = 1;
+
+/** FNV-1a 64 bit offset basis. */
+static const uint64_t FNV64_OFFSET = 0xcbf29ce484222325ULL;
+
+/** FNV-1a 64 bit prime. */
+static const uint64_t FNV64_PRIME = 0x100000001b3ULL;
+
+/**
+ * Mix @a length bytes of @a data into the FNV-1a hash @a hash.
+ */
+static uint64_t fnv64_update(uint64_t hash, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * Mix the content of the file at @a path into the hash at @a hash.
+ *
+ * @param[in] path File whose content is hashed.
+ * @param[in,out] hash Hash to continue from and update.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EOTHER if the file cannot be read.
+ */
+static ib_status_t fnv64_file(const char *path, uint64_t *hash)
+{
+    FILE     *fp;
+    char      buf[8192];
+    size_t    n;
+    uint64_t  h = *hash;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return IB_EOTHER;
+    }
+
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        h = fnv64_update(h, buf, n);
+    }
+    if (ferror(fp)) {
+        fclose(fp);
+        return IB_EOTHER;
+    }
+    fclose(fp);
+
+    *hash = h;
+    return IB_OK;
+}
+
+/**
+ * Build the cache image path for @a incfile.
+ *
+ * The image is named by a hash of the include file's path and current
+ * content, so a content change simply keys a different image.
+ *
+ * @param[in] cp Configuration parser with an include cache directory set.
+ * @param[in] incfile Resolved path of the include file.
+ * @param[out] out Image path, allocated from @a cp's memory.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation errors.
+ * - IB_EOTHER if @a incfile cannot be read.
+ */
+static ib_status_t include_cache_path(
+    ib_cfgparser_t  *cp,
+    const char      *incfile,
+    const char     **out
+)
+{
+    uint64_t     key = FNV64_OFFSET;
+    char        *path;
+    size_t       len;
+    ib_status_t  rc;
+
+    key = fnv64_update(key, incfile, strlen(incfile));
+    rc = fnv64_file(incfile, &key);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    len = strlen(cp->include_cache_dir) + 1 + 16 + sizeof(".inc");
+    path = ib_mm_alloc(cp->mm, len);
+    if (path == NULL) {
+        return IB_EALLOC;
+    }
+    snprintf(path, len, "%s/%016" PRIx64 ".inc", cp->include_cache_dir, key);
+
+    *out = path;
+    return IB_OK;
+}
+
+ib_status_t ib_cfgparser_include_cache_set(
+    ib_cfgparser_t *cp,
+    const char     *dir
+)
+{
+    assert(cp != NULL);
+
+    char        *slashed;
+    ib_status_t  rc;
+
+    if (dir == NULL) {
+        cp->include_cache_dir = NULL;
+        return IB_OK;
+    }
+
+    /* ib_util_mkpath() creates the components before the final
+     * slash, so append one to create @a dir itself. */
+    slashed = ib_mm_alloc(cp->mm, strlen(dir) + 2);
+    if (slashed == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(slashed, "%s/", dir);
+    rc = ib_util_mkpath(slashed, 0700);
+    if (rc != IB_OK) {
+        return IB_EOTHER;
+    }
+
+    cp->include_cache_dir = ib_mm_strdup(cp->mm, dir);
+    if (cp->include_cache_dir == NULL) {
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_cfgparser_include_cache_lookup(
+    ib_cfgparser_t      *cp,
+    const char          *incfile,
+    ib_cfgparser_node_t *node,
+    bool                *hit
+)
+{
+    assert(cp != NULL);
+    assert(cp->include_cache_dir != NULL);
+    assert(incfile != NULL);
+    assert(node != NULL);
+    assert(hit != NULL);
+
+    FILE                 *fp;
+    uint32_t              magic;
+    uint32_t              version;
+    uint32_t              count;
+    ib_list_t            *children;
+    const ib_list_node_t *list_node;
+    ib_status_t           rc;
+
+    *hit = false;
+
+    {
+        const char *path;
+
+        rc = include_cache_path(cp, incfile, &path);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        fp = fopen(path, "rb");
+    }
+    if (fp == NULL) {
+        /* No image for this content: a miss, not an error. */
+        return IB_OK;
+    }
+
+    rc = read_u32(fp, &magic);
+    if (rc != IB_OK || magic != INCLUDE_CACHE_MAGIC) {
+        goto miss;
+    }
+    rc = read_u32(fp, &version);
+    if (rc != IB_OK || version != INCLUDE_CACHE_VERSION) {
+        goto miss;
+    }
+
+    /* Verify the content hash of every file in the subtree; the key
+     * covers the include file itself but not nested includes. */
+    rc = read_u32(fp, &count);
+    if (rc != IB_OK) {
+        goto miss;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const char *file;
+        uint64_t    stored;
+        uint64_t    hash = FNV64_OFFSET;
+
+        rc = read_string(fp, cp->mm, &file);
+        if (rc != IB_OK || file == NULL) {
+            goto miss;
+        }
+        rc = read_u64(fp, &stored);
+        if (rc != IB_OK) {
+            goto miss;
+        }
+        if (fnv64_file(file, &hash) != IB_OK || hash != stored) {
+            goto miss;
+        }
+    }
+
+    /* Read the subtree aside first so a corrupt image leaves @a node
+     * untouched. */
+    rc = ib_list_create(&children, cp->mm);
+    if (rc != IB_OK) {
+        fclose(fp);
+        return rc;
+    }
+    rc = read_u32(fp, &count);
+    if (rc != IB_OK) {
+        goto miss;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        ib_cfgparser_node_t *child;
+
+        rc = read_node(fp, cp, node, &child);
+        if (rc == IB_EALLOC) {
+            fclose(fp);
+            return rc;
+        }
+        if (rc != IB_OK) {
+            goto miss;
+        }
+        rc = ib_list_push(children, child);
+        if (rc != IB_OK) {
+            fclose(fp);
+            return rc;
+        }
+    }
+    fclose(fp);
+
+    IB_LIST_LOOP_CONST(children, list_node) {
+        rc = ib_list_push(
+            node->children,
+            (void *)ib_list_node_data_const(list_node));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *hit = true;
+    return IB_OK;
+
+miss:
+    fclose(fp);
+    return IB_OK;
+}
+
+ib_status_t ib_cfgparser_include_cache_store(
+    ib_cfgparser_t      *cp,
+    const char          *incfile,
+    ib_cfgparser_node_t *node
+)
+{
+    assert(cp != NULL);
+    assert(cp->include_cache_dir != NULL);
+    assert(incfile != NULL);
+    assert(node != NULL);
+
+    FILE                 *fp;
+    const char           *path;
+    char                 *tmp_path;
+    ib_list_t            *files;
+    const ib_list_node_t *list_node;
+    ib_status_t           rc;
+
+    rc = include_cache_path(cp, incfile, &path);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_list_create(&files, cp->mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = collect_files(node, files);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* As with the whole-tree image, write to a temporary file and
+     * rename it into place. */
+    tmp_path = ib_mm_alloc(cp->mm, strlen(path) + sizeof(".tmp"));
+    if (tmp_path == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(tmp_path, "%s.tmp", path);
+
+    fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        return IB_EOTHER;
+    }
+
+    rc = write_u32(fp, INCLUDE_CACHE_MAGIC);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+    rc = write_u32(fp, INCLUDE_CACHE_VERSION);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
+    /* File manifest: path and content hash of every input. */
+    rc = write_u32(fp, (uint32_t)ib_list_elements(files));
+    if (rc != IB_OK) {
+        goto failed;
+    }
+    IB_LIST_LOOP_CONST(files, list_node) {
+        const char *file = ib_list_node_data_const(list_node);
+        uint64_t    hash = FNV64_OFFSET;
+
+        rc = fnv64_file(file, &hash);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        rc = write_string(fp, file);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        rc = write_u64(fp, hash);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+    }
+
+    rc = write_u32(fp, (uint32_t)ib_list_elements(node->children));
+    if (rc != IB_OK) {
+        goto failed;
+    }
+    IB_LIST_LOOP_CONST(node->children, list_node) {
+        rc = write_node(fp, ib_list_node_data_const(list_node));
+        if (rc != IB_OK) {
+            goto failed;
+        }
+    }
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        rc = IB_EOTHER;
+        goto failed;
+    }
+    fp = NULL;
+
+    if (rename(tmp_path, path) != 0) {
+        rc = IB_EOTHER;
+        goto failed;
+    }
+
+    return IB_OK;
+
+failed:
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    unlink(tmp_path);
+
+    return rc;
+}
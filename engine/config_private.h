@@ -44,4 +44,50 @@
 ib_status_t DLL_LOCAL
 ib_cfgparser_parse_private(ib_cfgparser_t *cp, const char *file, bool eof_mask);
 
+/**
+ * Try to serve the include @a incfile from the per-include parse cache.
+ *
+ * On a hit, the cached subtree is attached under @a node exactly as a
+ * parse of the file would have left it, and @a hit is set to true. A
+ * missing or stale image is not an error: @a hit is set to false and
+ * the caller should parse the file.
+ *
+ * @param[in] cp Configuration parser with an include cache directory set.
+ * @param[in] incfile Resolved path of the include file.
+ * @param[in] node Parse node of the include directive.
+ * @param[out] hit True if the subtree was attached from the cache.
+ *
+ * @returns
+ * - IB_OK on success, whether or not the cache hit.
+ * - IB_EALLOC on allocation errors.
+ * - IB_EOTHER if @a incfile cannot be read.
+ */
+ib_status_t DLL_LOCAL ib_cfgparser_include_cache_lookup(
+    ib_cfgparser_t      *cp,
+    const char          *incfile,
+    ib_cfgparser_node_t *node,
+    bool                *hit);
+
+/**
+ * Save the parsed subtree of the include @a incfile to the cache.
+ *
+ * The image records a content hash of every file contributing to the
+ * subtree, so a later ib_cfgparser_include_cache_lookup() misses when
+ * the file or anything it transitively includes changes.
+ *
+ * @param[in] cp Configuration parser with an include cache directory set.
+ * @param[in] incfile Resolved path of the include file.
+ * @param[in] node Parse node of the include directive, holding the
+ *            freshly parsed subtree.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation errors.
+ * - IB_EOTHER on file system errors.
+ */
+ib_status_t DLL_LOCAL ib_cfgparser_include_cache_store(
+    ib_cfgparser_t      *cp,
+    const char          *incfile,
+    ib_cfgparser_node_t *node);
+
 #endif /* _CONFIG_PRIVATE_H_ */
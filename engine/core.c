@@ -45,6 +45,7 @@
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
 #include <ironbee/flags.h>
+#include <ironbee/flightrec.h>
 #include <ironbee/json.h>
 #include <ironbee/logevent.h>
 #include <ironbee/mm.h>
@@ -100,43 +101,8 @@ static const char * const ib_uuid_default_str = "00000000-0000-0000-0000-0000000
 #define X_RULE_BASE_PATH IB_XSTRINGIFY(RULE_BASE_PATH) "/"
 #endif
 
-#define IB_ALPART_HEADER                  (1<< 0)
-#define IB_ALPART_EVENTS                  (1<< 1)
-#define IB_ALPART_HTTP_REQUEST_METADATA   (1<< 2)
-#define IB_ALPART_HTTP_REQUEST_HEADER     (1<< 3)
-#define IB_ALPART_HTTP_REQUEST_BODY       (1<< 4)
-#define IB_ALPART_HTTP_REQUEST_TRAILER    (1<< 5)
-#define IB_ALPART_HTTP_RESPONSE_METADATA  (1<< 6)
-#define IB_ALPART_HTTP_RESPONSE_HEADER    (1<< 7)
-#define IB_ALPART_HTTP_RESPONSE_BODY      (1<< 8)
-#define IB_ALPART_HTTP_RESPONSE_TRAILER   (1<< 9)
-#define IB_ALPART_DEBUG_FIELDS            (1<<10)
-
-/* NOTE: Make sure to add new parts from above to any groups below. */
-
-#define IB_ALPARTS_ALL \
-    IB_ALPART_HEADER|IB_ALPART_EVENTS| \
-    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
-    IB_ALPART_HTTP_REQUEST_BODY|IB_ALPART_HTTP_REQUEST_TRAILER | \
-    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
-    IB_ALPART_HTTP_RESPONSE_BODY|IB_ALPART_HTTP_RESPONSE_TRAILER | \
-    IB_ALPART_DEBUG_FIELDS
-
-#define IB_ALPARTS_DEFAULT \
-    IB_ALPART_HEADER|IB_ALPART_EVENTS| \
-    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
-    IB_ALPART_HTTP_REQUEST_TRAILER | \
-    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
-    IB_ALPART_HTTP_RESPONSE_TRAILER
-
-#define IB_ALPARTS_REQUEST \
-    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
-    IB_ALPART_HTTP_REQUEST_BODY|IB_ALPART_HTTP_REQUEST_TRAILER
-
-#define IB_ALPARTS_RESPONSE \
-    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
-    IB_ALPART_HTTP_RESPONSE_BODY|IB_ALPART_HTTP_RESPONSE_TRAILER
-
+/* Audit log part flags (IB_ALPART_*) live in core_private.h so other
+ * core translation units (e.g. core_stream_processor.c) can consult them. */
 
 /* Rule log parts amalgamation */
 #define IB_RULE_LOG_FLAGS_REQUEST                               \
@@ -555,6 +521,24 @@ static size_t ib_auditlog_gen_raw_stream(ib_auditlog_part_t *part,
     return dlen;
 }
 
+/**
+ * Generate an audit log part from a NUL-terminated string.
+ *
+ * The part_data is the complete, pre-rendered text of the part.
+ */
+static size_t ib_auditlog_gen_raw_nulstr(ib_auditlog_part_t *part,
+                                         const uint8_t **chunk)
+{
+    if (part->gen_data == AUDITLOG_GEN_FINISHED) {
+        part->gen_data = AUDITLOG_GEN_NOTSTARTED;
+        return 0;
+    }
+    part->gen_data = AUDITLOG_GEN_FINISHED;
+
+    *chunk = (const uint8_t *)part->part_data;
+    return strlen((const char *)part->part_data);
+}
+
 static size_t ib_auditlog_gen_json_flist(ib_auditlog_part_t *part,
                                          const uint8_t **chunk)
 {
@@ -1732,6 +1716,38 @@ static ib_status_t ib_auditlog_add_part_http_response_body(ib_auditlog_t *log)
     return rc;
 }
 
+/**
+ * Add the flight recorder trace to the audit log.
+ *
+ * Renders the calling thread's trace ring from the transaction start
+ * on; a transaction is processed on one thread, so that is this
+ * transaction's trace. Only added for transactions worth diagnosing;
+ * see auditing_hook().
+ *
+ * @param[in,out] log Audit log to log to
+ *
+ * @return Status code
+ */
+static ib_status_t ib_auditlog_add_part_flightrec(ib_auditlog_t *log)
+{
+    const char *dump;
+    ib_status_t rc;
+
+    rc = ib_flightrec_dump(log->mm, log->tx->t.started, &dump);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_auditlog_part_add(log,
+                              "flight-recorder",
+                              "text/plain",
+                              (void *)dump,
+                              ib_auditlog_gen_raw_nulstr,
+                              NULL);
+
+    return rc;
+}
+
 /**
  * Handle writing the logevents that audit IronBee.
  *
@@ -1899,6 +1915,16 @@ static ib_status_t auditing_hook(ib_engine_t *ib,
         }
     }
 
+    /* Add the flight recorder trace for blocked transactions and for
+     * transactions over the configured duration threshold. */
+    if (ib_tx_is_blocked(tx) ||
+        ( (corecfg->flightrec_threshold > 0) &&
+          (tx->t.logtime - tx->t.started >=
+           (ib_time_t)corecfg->flightrec_threshold * 1000) ))
+    {
+        ib_auditlog_add_part_flightrec(log);
+    }
+
     audit_write_log(ib, log);
 
     /* Events */
@@ -3035,6 +3061,100 @@ static ib_status_t core_dir_param1(ib_cfgparser_t *cp,
         rc = ib_context_set_string(ctx, "auditlog_sdir_fmt", p1_unescaped);
         return rc;
     }
+    else if (strcasecmp("AuditLogAsyncWriters", name) == 0) {
+        ib_num_t writers;
+        rc = ib_type_atoi(p1_unescaped, 10, &writers);
+        if ( (rc != IB_OK) || (writers < 0) ) {
+            ib_log_error(ib,
+                         "Invalid writer count: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "auditlog_async", writers);
+        return rc;
+    }
+    else if (strcasecmp("FlightRecorderThreshold", name) == 0) {
+        ib_num_t msec;
+        rc = ib_type_atoi(p1_unescaped, 10, &msec);
+        if ( (rc != IB_OK) || (msec < 0) ) {
+            ib_log_error(ib,
+                         "Invalid duration threshold: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "flightrec_threshold", msec);
+        return rc;
+    }
+    else if (strcasecmp("TxMemoryLimit", name) == 0) {
+        ib_num_t limit;
+        rc = ib_type_atoi(p1_unescaped, 10, &limit);
+        if ( (rc != IB_OK) || (limit < 0) ) {
+            ib_log_error(ib,
+                         "Invalid memory limit: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "tx_memory_limit", limit);
+        return rc;
+    }
+    else if (strcasecmp("AuditLogFormat", name) == 0) {
+        ib_num_t format;
+        if (strcasecmp("multipart", p1_unescaped) == 0) {
+            format = IB_AUDITLOG_FORMAT_MULTIPART;
+        }
+        else if (strcasecmp("binary", p1_unescaped) == 0) {
+            format = IB_AUDITLOG_FORMAT_BINARY;
+        }
+        else {
+            ib_log_error(ib,
+                         "Invalid audit log format: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "auditlog_format", format);
+        return rc;
+    }
+    else if (strcasecmp("EventSampleRate", name) == 0) {
+        ib_num_t pct;
+        rc = ib_type_atoi(p1_unescaped, 10, &pct);
+        if ( (rc != IB_OK) || (pct < 1) || (pct > 100) ) {
+            ib_log_error(ib,
+                         "Invalid sample percentage: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "event_sample_pct", pct);
+        return rc;
+    }
+    else if (strcasecmp("EventRateLimit", name) == 0) {
+        ib_num_t limit;
+        rc = ib_type_atoi(p1_unescaped, 10, &limit);
+        if ( (rc != IB_OK) || (limit < 0) ) {
+            ib_log_error(ib,
+                         "Invalid event rate limit: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "event_rate_limit", limit);
+        return rc;
+    }
+    else if (strcasecmp("EventDedup", name) == 0) {
+        ib_num_t dedup;
+        if (strcasecmp("On", p1_unescaped) == 0) {
+            dedup = 1;
+        }
+        else if (strcasecmp("Off", p1_unescaped) == 0) {
+            dedup = 0;
+        }
+        else {
+            ib_log_error(ib,
+                         "Invalid setting: %s \"%s\"",
+                         name, p1_unescaped);
+            return IB_EINVAL;
+        }
+        rc = ib_context_set_num(ctx, "event_dedup", dedup);
+        return rc;
+    }
     else if (strcasecmp("Log", name) == 0)
     {
         ib_mm_t       mm  = ib_engine_mm_main_get(ib);
@@ -3252,6 +3372,15 @@ static ib_status_t core_dir_param1(ib_cfgparser_t *cp,
 
         corecfg->limits.request_body_log_limit = atoll(p1_unescaped);
     }
+    else if (strcasecmp("BodyBufferSpillThreshold", name) == 0) {
+        rc = ib_core_context_config(ctx, &corecfg);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Could not fetch core module config.");
+            return rc;
+        }
+
+        corecfg->limits.body_buffer_spill_threshold = atoll(p1_unescaped);
+    }
     else {
         ib_log_error(ib, "Unhandled directive: %s %s", name, p1_unescaped);
         rc = IB_EINVAL;
@@ -3800,6 +3929,58 @@ static ib_status_t core_dir_initvar(ib_cfgparser_t *cp,
     return IB_OK;
 }
 
+/**
+ * Process a batch of consecutive InitVar directives.
+ *
+ * Generated configurations commonly emit tens of thousands of
+ * consecutive InitVar directives; handling the run as a batch saves the
+ * per-directive lookup and dispatch (see @ref ib_config_cb_batch_fn_t).
+ *
+ * @param[in] cp Configuration parser
+ * @param[in] directive The directive name.
+ * @param[in] arg_lists Parameter lists, one per InitVar.
+ * @param[in] count Number of entries in @a arg_lists.
+ * @param[in] cbdata User data.
+ */
+static ib_status_t core_dir_initvar_batch(ib_cfgparser_t *cp,
+                                          const char *directive,
+                                          const ib_list_t *const *arg_lists,
+                                          size_t count,
+                                          void *cbdata)
+{
+    assert(cp != NULL);
+    assert(directive != NULL);
+    assert(arg_lists != NULL);
+
+    ib_status_t rc;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        const ib_list_t *args = arg_lists[i];
+        const char      *name;
+        const char      *value;
+
+        if (ib_list_elements(args) != 2) {
+            ib_cfg_log_error(cp,
+                             "Directive \"%s\" "
+                             "takes two parameters, not %zd",
+                             directive, ib_list_elements(args));
+            return IB_EINVAL;
+        }
+        name = (const char *)ib_list_node_data_const(
+            ib_list_first_const(args));
+        value = (const char *)ib_list_node_data_const(
+            ib_list_last_const(args));
+
+        rc = core_dir_initvar(cp, directive, name, value, cbdata);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
 
 /**
  * Mapping of valid debug log levels to numerical value
@@ -4114,6 +4295,41 @@ static IB_DIRMAP_INIT_STRUCTURE(core_directive_map) = {
         core_dir_param1,
         NULL
     ),
+    IB_DIRMAP_INIT_PARAM1(
+        "AuditLogAsyncWriters",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "FlightRecorderThreshold",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "TxMemoryLimit",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "AuditLogFormat",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "EventSampleRate",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "EventRateLimit",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "EventDedup",
+        core_dir_param1,
+        NULL
+    ),
     IB_DIRMAP_INIT_PARAM1(
         "RequestBodyLogLimit",
         core_dir_param1,
@@ -4124,6 +4340,11 @@ static IB_DIRMAP_INIT_STRUCTURE(core_directive_map) = {
         core_dir_param1,
         NULL
     ),
+    IB_DIRMAP_INIT_PARAM1(
+        "BodyBufferSpillThreshold",
+        core_dir_param1,
+        NULL
+    ),
     IB_DIRMAP_INIT_OPFLAGS(
         "AuditLogParts",
         core_dir_auditlogparts,
@@ -4159,9 +4380,11 @@ static IB_DIRMAP_INIT_STRUCTURE(core_directive_map) = {
     ),
 
     /* TX DPI Initializers */
-    IB_DIRMAP_INIT_PARAM2(
+    IB_DIRMAP_INIT_PARAM2_BATCH(
         "InitVar",
         core_dir_initvar,
+        NULL,
+        core_dir_initvar_batch,
         NULL
     ),
 
@@ -4449,6 +4672,13 @@ static ib_status_t core_init(ib_engine_t *ib,
     corecfg->auditlog_parts       = IB_ALPARTS_DEFAULT;
     corecfg->auditlog_dir         = "/var/log/ironbee";
     corecfg->auditlog_sdir_fmt    = "";
+    corecfg->auditlog_async       = 0;
+    corecfg->auditlog_format      = IB_AUDITLOG_FORMAT_MULTIPART;
+    corecfg->flightrec_threshold  = 0;
+    corecfg->tx_memory_limit      = 0;
+    corecfg->event_sample_pct     = 100;
+    corecfg->event_rate_limit     = 0;
+    corecfg->event_dedup          = 0;
     corecfg->auditlog_index_fmt   = IB_LOGFORMAT_DEFAULT;
     corecfg->audit                = MODULE_NAME_STR;
     corecfg->data                 = MODULE_NAME_STR;
@@ -4474,6 +4704,7 @@ static ib_status_t core_init(ib_engine_t *ib,
     corecfg->limits.response_body_buffer_limit_action = IB_BUFFER_LIMIT_ACTION_FLUSH_PARTIAL;
     corecfg->limits.request_body_log_limit            = -1;
     corecfg->limits.response_body_log_limit           = -1;
+    corecfg->limits.body_buffer_spill_threshold       = -1;
 
     /* Initialize vars */
     corecfg->vars = ib_mm_calloc(mm, 1, sizeof(*corecfg->vars));
@@ -4591,7 +4822,14 @@ ib_status_t core_finish(
     void        *cbdata
 )
 {
-    /* Nop. */
+    ib_core_module_data_t *core_data = (ib_core_module_data_t *)m->data;
+
+    /* Drain and stop the asynchronous audit log writer, if running. */
+    if (core_data != NULL && core_data->audit_writer != NULL) {
+        core_audit_writer_destroy(core_data->audit_writer);
+        core_data->audit_writer = NULL;
+    }
+
     return IB_OK;
 }
 
@@ -4683,6 +4921,48 @@ static IB_CFGMAP_INIT_STRUCTURE(core_config_map) = {
         ib_core_cfg_t,
         auditlog_sdir_fmt
     ),
+    IB_CFGMAP_INIT_ENTRY(
+        "auditlog_async",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        auditlog_async
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "flightrec_threshold",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        flightrec_threshold
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "tx_memory_limit",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        tx_memory_limit
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "auditlog_format",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        auditlog_format
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "event_sample_pct",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        event_sample_pct
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "event_rate_limit",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        event_rate_limit
+    ),
+    IB_CFGMAP_INIT_ENTRY(
+        "event_dedup",
+        IB_FTYPE_NUM,
+        ib_core_cfg_t,
+        event_dedup
+    ),
     IB_CFGMAP_INIT_ENTRY(
         "auditlog_index_fmt",
         IB_FTYPE_NULSTR,
@@ -165,6 +165,15 @@ struct setvar_data_t {
     ib_list_t       *transformations; /**< Names of tfns to apply to value. */
     const char      *target_str;      /**< Used in error logging. */
     size_t           target_str_len;  /**< Used in error logging. */
+
+    /**
+     * True for the fully pre-compiled case: a trivial target (plain var
+     * name, no filter, no expansion), no transformations, and a numeric
+     * argument parsed at creation.  Such actions execute against the var
+     * source directly, skipping target expansion and the result list that
+     * ib_var_target_get() builds per firing.
+     */
+    bool             fast;
 };
 typedef struct setvar_data_t setvar_data_t;
 
@@ -474,45 +483,38 @@ static ib_status_t act_event_create(
 }
 
 /**
- * Event action execution callback.
+ * Populate callback finishing a lazily constructed rule event.
  *
- * Create and event and log it.
+ * Expands the rule's message, logdata and tags into @a event.  Only runs
+ * for events that survive the event policy in ib_logevent_add_lazy(); a
+ * suppressed event never pays for any expansion.
  *
- * @param[in] rule_exec The rule execution object
- * @param[in] data Instance data needed for execution.
- * @param[in] cbdata Unused.
+ * @param[in,out] event The event to populate.
+ * @param[in] cbdata The rule execution object (ib_rule_exec_t *).
  *
  * @returns IB_OK if successful.
  */
-static ib_status_t act_event_execute(
-    const ib_rule_exec_t *rule_exec,
-    void *data,
+static ib_status_t act_event_populate(
+    ib_logevent_t *event,
     void *cbdata)
 {
-    assert(rule_exec != NULL);
-    assert(data != NULL);
+    assert(event != NULL);
+    assert(cbdata != NULL);
 
-    ib_status_t  rc;
-    ib_logevent_t *event;
+    ib_status_t rc;
     const char *expanded;
     size_t expanded_size;
+    const ib_rule_exec_t *rule_exec = (const ib_rule_exec_t *)cbdata;
     const ib_rule_t *rule = rule_exec->rule;
     ib_tx_t *tx = rule_exec->tx;
-    const event_data_t *event_data = (const event_data_t *)data;
-    ib_core_cfg_t *corecfg;
-
-    ib_rule_log_debug(rule_exec, "Creating event via action");
-
-    rc = ib_core_context_config(ib_context_main(rule_exec->ib), &corecfg);
-    if (rc != IB_OK) {
-        ib_rule_log_error(rule_exec,
-                          "event: Failed to fetch configuration.: %s",
-                          ib_status_to_string(rc));
-        return rc;
-    }
 
     /* Expand the message string */
     if (rule->meta.msg != NULL) {
+        /* Format buffer matching ib_logevent_create()'s message buffer,
+         * including its truncation behavior. */
+        char buf[1024];
+        int len;
+
         rc = ib_var_expand_execute(
             rule->meta.msg,
             &expanded, &expanded_size,
@@ -525,26 +527,16 @@ static ib_status_t act_event_execute(
                               ib_status_to_string(rc));
             return rc;
         }
-    }
-    else {
-        expanded = "";
-        expanded_size = 0;
-    }
 
-    /* Create the event */
-    rc = ib_logevent_create(
-        &event,
-        tx->mm,
-        ib_rule_id(rule),
-        event_data->event_type,
-        IB_LEVENT_ACTION_UNKNOWN,
-        rule->meta.confidence,
-        rule->meta.severity,
-        "%.*s",
-        (int)expanded_size, expanded
-    );
-    if (rc != IB_OK) {
-        return rc;
+        len = snprintf(buf, sizeof(buf), "%.*s",
+                       (int)expanded_size, expanded);
+        if (len >= (int)sizeof(buf)) {
+            memcpy(buf + sizeof(buf) - 4, "...", 3);
+        }
+        event->msg = ib_mm_strdup(event->mm, buf);
+        if (event->msg == NULL) {
+            return IB_EALLOC;
+        }
     }
 
     /* Set the data */
@@ -570,13 +562,7 @@ static ib_status_t act_event_execute(
         }
     }
 
-    /* Create the destination tag list. */
-    rc = ib_list_create(&(event->tags), tx->mm);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    /* Copy each tag to the new event tag list.
+    /* Copy each tag to the event tag list.
      * If the tag may be expanded using the ib_tx_t's var_store, it is expanded.
      */
     for (
@@ -640,6 +626,57 @@ static ib_status_t act_event_execute(
         }
     }
 
+    return IB_OK;
+}
+
+/**
+ * Event action execution callback.
+ *
+ * Create an event and log it.
+ *
+ * Only a skeleton event -- rule id, type, confidence, severity and the
+ * recommended action -- is built here.  The message, logdata and tag
+ * expansions are deferred to act_event_populate(), which runs only if
+ * the event survives the event policy.
+ *
+ * @param[in] rule_exec The rule execution object
+ * @param[in] data Instance data needed for execution.
+ * @param[in] cbdata Unused.
+ *
+ * @returns IB_OK if successful.
+ */
+static ib_status_t act_event_execute(
+    const ib_rule_exec_t *rule_exec,
+    void *data,
+    void *cbdata)
+{
+    assert(rule_exec != NULL);
+    assert(data != NULL);
+
+    ib_status_t  rc;
+    ib_logevent_t *event;
+    const ib_rule_t *rule = rule_exec->rule;
+    ib_tx_t *tx = rule_exec->tx;
+    const event_data_t *event_data = (const event_data_t *)data;
+
+    ib_rule_log_debug(rule_exec, "Creating event via action");
+
+    /* Create the skeleton event; the message is filled in lazily. */
+    rc = ib_logevent_create(
+        &event,
+        tx->mm,
+        ib_rule_id(rule),
+        event_data->event_type,
+        IB_LEVENT_ACTION_UNKNOWN,
+        rule->meta.confidence,
+        rule->meta.severity,
+        "%s",
+        ""
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* Set the actions if appropriate */
     if (ib_flags_all(tx->flags,
                      (IB_TX_FBLOCK_ADVISORY |
@@ -649,8 +686,9 @@ static ib_status_t act_event_execute(
         event->rec_action = IB_LEVENT_ACTION_BLOCK;
     }
 
-    /* Log the event. */
-    rc = ib_logevent_add(tx, event);
+    /* Log the event, expanding its strings only if it survives. */
+    rc = ib_logevent_add_lazy(
+        tx, event, act_event_populate, (void *)rule_exec);
     if (rc != IB_OK) {
         return rc;
     }
@@ -869,10 +907,209 @@ static ib_status_t act_setvar_create(
     }
 
 success:
+    setvar_data->fast = (
+        setvar_data->op != SETVAR_STRSET &&
+        setvar_data->transformations == NULL &&
+        ib_var_target_trivial(setvar_data->target)
+    );
     *(void **)instance_data = setvar_data;
     return IB_OK;
 }
 
+/**
+ * Apply a setvar operation to the current value of its target.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] setvar_data Setvar data.
+ * @param[in] argument The (possibly expanded and transformed) argument.
+ * @param[in,out] cur_field The current value; NULL if the target is unset.
+ *                On return, the new value.  This is @a *cur_field updated
+ *                in place when its type allows, a new field otherwise.
+ *
+ * @returns Status code
+ */
+static ib_status_t setvar_apply_op(
+    const ib_rule_exec_t *rule_exec,
+    const setvar_data_t  *setvar_data,
+    const ib_field_t     *argument,
+    ib_field_t          **cur_field
+)
+{
+    assert(rule_exec != NULL);
+    assert(setvar_data != NULL);
+    assert(argument != NULL);
+    assert(cur_field != NULL);
+
+    ib_status_t  rc    = IB_OK;
+    ib_tx_t     *tx    = rule_exec->tx;
+    ib_mm_t      mm    = tx->mm;
+    const char  *ts    = setvar_data->target_str;
+    int          tslen = (int)setvar_data->target_str_len;
+
+    switch(setvar_data->op) {
+
+    case SETVAR_STRSET:
+    {
+        rc = ib_field_copy(
+            cur_field,
+            mm,
+            setvar_data->target_str,
+            setvar_data->target_str_len,
+            argument);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        break;
+    }
+
+    case SETVAR_FLOATSET:
+    {
+        ib_float_t flt;
+
+        rc = ib_field_value_type(
+            argument,
+            ib_ftype_float_out(&flt),
+            IB_FTYPE_FLOAT);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        /* Try to re-use the existing field */
+        if (*cur_field != NULL && (*cur_field)->type == IB_FTYPE_FLOAT) {
+            ib_field_setv(*cur_field, ib_ftype_float_in(&flt));
+        }
+        else {
+            rc = ib_field_create(
+                cur_field,
+                tx->mm,
+                "", 0,
+                IB_FTYPE_FLOAT,
+                ib_ftype_float_in(&flt));
+            if (rc != IB_OK) {
+                ib_rule_log_error(
+                    rule_exec,
+                    "setvar %.*s: Failed to create field: %s",
+                    tslen, ts,
+                    ib_status_to_string(rc)
+                );
+                return rc;
+            }
+        }
+        break;
+    }
+
+    case SETVAR_NUMSET:
+    {
+        ib_num_t num;
+
+        rc = ib_field_value_type(
+            argument,
+            ib_ftype_num_out(&num),
+            IB_FTYPE_NUM);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        /* Try to re-use the existing field */
+        if (*cur_field != NULL && (*cur_field)->type == IB_FTYPE_NUM) {
+            ib_field_setv(*cur_field, ib_ftype_num_in(&num));
+        }
+        else {
+            rc = ib_field_create(
+                cur_field,
+                tx->mm,
+                "", 0,
+                IB_FTYPE_NUM,
+                ib_ftype_num_in(&num));
+            if (rc != IB_OK) {
+                ib_rule_log_error(
+                    rule_exec,
+                    "setvar %.*s: Failed to create field: %s",
+                    tslen, ts,
+                    ib_status_to_string(rc)
+                );
+                return rc;
+            }
+        }
+
+        break;
+    }
+    /* Numerical operation : Add */
+    case SETVAR_FLOATADD:
+        rc = setvar_float_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_float_add_op,
+            cur_field);
+        break;
+
+    /* Numerical operation : Sub */
+    case SETVAR_FLOATSUB:
+        rc = setvar_float_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_float_sub_op,
+            cur_field);
+        break;
+
+    /* Numerical operation : Mult */
+    case SETVAR_FLOATMULT:
+        rc = setvar_float_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_float_mult_op,
+            cur_field);
+        break;
+
+    /* Numerical operation : Add */
+    case SETVAR_NUMADD:
+        rc = setvar_num_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_num_add_op,
+            cur_field);
+        break;
+
+    /* Numerical operation : Sub */
+    case SETVAR_NUMSUB:
+        rc = setvar_num_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_num_sub_op,
+            cur_field);
+        break;
+
+    /* Numerical operation : Mult */
+    case SETVAR_NUMMULT:
+        rc = setvar_num_op(
+            tx,
+            rule_exec,
+            argument,
+            &setvar_num_mult_op,
+            cur_field);
+        break;
+    }
+
+    if (rc != IB_OK) {
+        ib_rule_log_error(
+            rule_exec,
+            "setvar %.*s: Failed operate on field: %s",
+            tslen, ts,
+            ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    assert(*cur_field != NULL);
+
+    return IB_OK;
+}
+
 /**
  * Execute function for the "set variable" action
  *
@@ -908,6 +1145,52 @@ static ib_status_t act_setvar_execute(
     const char          *ts          = setvar_data->target_str;
     int                  tslen       = (int)setvar_data->target_str_len;
 
+    /* Pre-compiled plan fast path: operate on the var source directly.
+     * The numeric operations update an existing field of the right type
+     * in place, so the common anomaly-scoring firing is a source slot
+     * read, the arithmetic, and no store write at all. */
+    if (setvar_data->fast) {
+        ib_var_source_t *source = ib_var_target_source(setvar_data->target);
+        ib_field_t      *field;
+
+        rc = ib_var_source_get(source, &field, tx->var_store);
+        if (rc == IB_ENOENT) {
+            field = NULL;
+        }
+        else if (rc != IB_OK) {
+            ib_rule_log_error(
+                rule_exec,
+                "setvar %.*s: Failed to get value: %s",
+                tslen, ts,
+                ib_status_to_string(rc)
+            );
+            return rc;
+        }
+
+        /* A list-valued source operates on its first element; leave that
+         * to the general path below. */
+        if (field == NULL || field->type != IB_FTYPE_LIST) {
+            ib_field_t *new_field = field;
+
+            rc = setvar_apply_op(
+                rule_exec,
+                setvar_data,
+                setvar_data->argument,
+                &new_field
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+
+            /* In-place update: the field is already in the store. */
+            if (new_field == field) {
+                return IB_OK;
+            }
+
+            return ib_var_source_set(source, tx->var_store, new_field);
+        }
+    }
+
     /* Expand target. */
     rc = ib_var_target_expand(
         setvar_data->target,
@@ -1027,167 +1310,21 @@ static ib_status_t act_setvar_execute(
      * Depending on the operation and value, we now need to modify it to
      * represent the new value and then we'll set it back. */
 
-    switch(setvar_data->op) {
-
-    case SETVAR_STRSET:
-    {
-        rc = ib_field_copy(
-            &cur_field,
-            mm,
-            setvar_data->target_str,
-            setvar_data->target_str_len,
-            argument);
-        if (rc != IB_OK) {
-            return rc;
-        }
-        break;
-    }
-
-    case SETVAR_FLOATSET:
-    {
-        ib_float_t flt;
-
-        rc = ib_field_value_type(
-            argument,
-            ib_ftype_float_out(&flt),
-            IB_FTYPE_FLOAT);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        /* Try to re-use the existing field */
-        if (cur_field != NULL && cur_field->type == IB_FTYPE_FLOAT) {
-            ib_field_setv(cur_field, ib_ftype_float_in(&flt));
-        }
-        else {
-            rc = ib_field_create(
-                &cur_field,
-                tx->mm,
-                "", 0,
-                IB_FTYPE_FLOAT,
-                ib_ftype_float_in(&flt));
-            if (rc != IB_OK) {
-                ib_rule_log_error(
-                    rule_exec,
-                    "setvar %.*s: Failed to create field: %s",
-                    tslen, ts,
-                    ib_status_to_string(rc)
-                );
-                return rc;
-            }
-        }
-        break;
-    }
-
-    case SETVAR_NUMSET:
-    {
-        ib_num_t num;
-
-        rc = ib_field_value_type(
-            argument,
-            ib_ftype_num_out(&num),
-            IB_FTYPE_NUM);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        /* Try to re-use the existing field */
-        if (cur_field != NULL && cur_field->type == IB_FTYPE_NUM) {
-            ib_field_setv(cur_field, ib_ftype_num_in(&num));
-            return IB_OK;
-        }
-        else {
-            rc = ib_field_create(
-                &cur_field,
-                tx->mm,
-                "", 0,
-                IB_FTYPE_NUM,
-                ib_ftype_num_in(&num));
-            if (rc != IB_OK) {
-                ib_rule_log_error(
-                    rule_exec,
-                    "setvar %.*s: Failed to create field: %s",
-                    tslen, ts,
-                    ib_status_to_string(rc)
-                );
-                return rc;
-            }
-        }
-
-        break;
-    }
-    /* Numerical operation : Add */
-    case SETVAR_FLOATADD:
-        rc = setvar_float_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_float_add_op,
-            &cur_field);
-        break;
-
-    /* Numerical operation : Sub */
-    case SETVAR_FLOATSUB:
-        rc = setvar_float_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_float_sub_op,
-            &cur_field);
-        break;
-
-    /* Numerical operation : Mult */
-    case SETVAR_FLOATMULT:
-        rc = setvar_float_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_float_mult_op,
-            &cur_field);
-        break;
-
-    /* Numerical operation : Add */
-    case SETVAR_NUMADD:
-        rc = setvar_num_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_num_add_op,
-            &cur_field);
-        break;
-
-    /* Numerical operation : Sub */
-    case SETVAR_NUMSUB:
-        rc = setvar_num_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_num_sub_op,
-            &cur_field);
-        break;
-
-    /* Numerical operation : Mult */
-    case SETVAR_NUMMULT:
-        rc = setvar_num_op(
-            tx,
-            rule_exec,
-            argument,
-            &setvar_num_mult_op,
-            &cur_field);
-        break;
-    }
+    /* Remember the field fetched from the store.  The numeric operations
+     * update such a field in place; when they do, it is already in the
+     * store and the remove-and-set below can be skipped. */
+    ib_field_t *orig_field = cur_field;
 
+    rc = setvar_apply_op(rule_exec, setvar_data, argument, &cur_field);
     if (rc != IB_OK) {
-        ib_rule_log_error(
-            rule_exec,
-            "setvar %.*s: Failed operate on field: %s",
-            tslen, ts,
-            ib_status_to_string(rc)
-        );
         return rc;
     }
 
-    assert(cur_field != NULL);
+    /* If the existing field was updated in place it is still in the store;
+     * a remove-and-set would only reinsert the same pointer. */
+    if (cur_field == orig_field) {
+        return IB_OK;
+    }
 
     rc = ib_var_target_remove_and_set(expanded_target, tx->mm, tx->var_store, cur_field);
     if (rc != IB_OK) {
@@ -38,7 +38,11 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -60,6 +64,18 @@ typedef struct {
 static const char * const ib_pipe_shell = "/bin/sh";
 static const size_t LOGFORMAT_MAX_LINE_LENGTH = 8192;
 
+/* Queue bound of the asynchronous audit log writer pool. */
+static const size_t AUDIT_WRITER_MAX_PENDING = 1024;
+
+/* Capacity of the batched index entry buffer; also its flush threshold. */
+static const size_t AUDIT_INDEX_BUF_SIZE = 8192;
+
+/* Flush batched index entries at least this often, in microseconds. */
+static const ib_time_t AUDIT_INDEX_FLUSH_USEC = 1000000;
+
+/* Guards lazy creation of the per-engine writer pool. */
+static pthread_mutex_t audit_writer_create_lock = PTHREAD_MUTEX_INITIALIZER;
+
 ib_status_t core_audit_open_auditfile(ib_engine_t *ib,
                                       ib_auditlog_t *log,
                                       ib_core_audit_cfg_t *cfg,
@@ -186,17 +202,28 @@ ib_status_t core_audit_open_auditfile(ib_engine_t *ib,
         return IB_EINVAL;
     }
 
-    /* Open the file.  Use open() & fdopen() to avoid chmod() */
-    fd = open(temp_filename,
-              (O_WRONLY|O_APPEND|O_CREAT|O_BINARY),
-              corecfg->auditlog_fmode);
-    if (fd >= 0) {
-        cfg->fp = fdopen(fd, "ab");
-        if (cfg->fp == NULL) {
-            close(fd);
+    /* Asynchronous mode: serialize to memory here and let the writer
+     * pool do the file I/O. The header and part writers are unchanged;
+     * they write through cfg->fp either way. */
+    if (corecfg->auditlog_async > 0) {
+        fd = -1;
+        cfg->mem_buf = NULL;
+        cfg->mem_buf_sz = 0;
+        cfg->fp = open_memstream(&cfg->mem_buf, &cfg->mem_buf_sz);
+    }
+    else {
+        /* Open the file.  Use open() & fdopen() to avoid chmod() */
+        fd = open(temp_filename,
+                  (O_WRONLY|O_APPEND|O_CREAT|O_BINARY),
+                  corecfg->auditlog_fmode);
+        if (fd >= 0) {
+            cfg->fp = fdopen(fd, "ab");
+            if (cfg->fp == NULL) {
+                close(fd);
+            }
         }
     }
-    if ( (fd < 0) || (cfg->fp == NULL) ) {
+    if ( ((corecfg->auditlog_async == 0) && (fd < 0)) || (cfg->fp == NULL) ) {
         sys_rc = errno;
         ib_log_error(log->ib,
                      "Error opening audit log \"%s\": %s (%d)",
@@ -477,13 +504,67 @@ ib_status_t core_audit_open(ib_engine_t *ib,
     return IB_OK;
 }
 
+/*
+ * The binary audit log format is a sequence of length-prefixed records
+ * in host byte order; audit logs are produced and consumed on the same
+ * host (or shipped with the index sidecar that identifies them):
+ *
+ * - File header: u32 magic "IBAL", u32 IB_AUDITLOG_VERSION.
+ * - Part: u32 magic "IBP1", u32 name length, u32 content-type length,
+ *   the name and content-type bytes, then data chunks each prefixed
+ *   with their u32 length, ended by a u32 zero.
+ * - Trailer: u32 magic "IBE1".
+ *
+ * The index sidecar replaces the formatted text line with a
+ * length-prefixed record (see core_audit_build_index_entry()), giving
+ * downstream tooling random access without parsing MIME.
+ */
+
+/** Binary format file header magic: "IBAL". */
+static const uint32_t AUDIT_BIN_MAGIC = 0x4c414249;
+
+/** Binary format part record magic: "IBP1". */
+static const uint32_t AUDIT_BIN_PART = 0x31504249;
+
+/** Binary format trailer magic: "IBE1". */
+static const uint32_t AUDIT_BIN_END = 0x31454249;
+
+/** Binary format index record magic: "IBX1". */
+static const uint32_t AUDIT_BIN_INDEX = 0x31584249;
+
+/**
+ * Write one u32 to the audit log.
+ *
+ * @param[in] fp The audit log.
+ * @param[in] value The value.
+ *
+ * @returns IB_OK or IB_EUNKNOWN on a short write.
+ */
+static ib_status_t audit_write_u32(FILE *fp, uint32_t value)
+{
+    return (fwrite(&value, sizeof(value), 1, fp) == 1) ? IB_OK : IB_EUNKNOWN;
+}
+
 ib_status_t core_audit_write_header(ib_engine_t *ib,
                                     ib_auditlog_t *log)
 {
     ib_core_audit_cfg_t *cfg = (ib_core_audit_cfg_t *)log->cfg_data;
     char header[256];
     size_t hlen;
-    int ret = snprintf(header, sizeof(header),
+    int ret;
+
+    if (cfg->core_cfg->auditlog_format == IB_AUDITLOG_FORMAT_BINARY) {
+        if ( (audit_write_u32(cfg->fp, AUDIT_BIN_MAGIC) != IB_OK) ||
+             (audit_write_u32(cfg->fp, IB_AUDITLOG_VERSION) != IB_OK) )
+        {
+            ib_log_error(ib,  "Failed to write audit log header.");
+            return IB_EUNKNOWN;
+        }
+        fflush(cfg->fp);
+        return IB_OK;
+    }
+
+    ret = snprintf(header, sizeof(header),
                        "MIME-Version: 1.0\r\n"
                        "Content-Type: multipart/mixed; boundary=%s\r\n"
                        "X-IronBee-AuditLog: type=multipart; version=%d\r\n"
@@ -517,6 +598,45 @@ ib_status_t core_audit_write_part(ib_engine_t *ib,
     const uint8_t *chunk;
     size_t chunk_size;
 
+    if (cfg->core_cfg->auditlog_format == IB_AUDITLOG_FORMAT_BINARY) {
+        size_t name_len = strlen(part->name);
+        size_t ctype_len = strlen(part->content_type);
+
+        /* Write the part record header. */
+        if ( (audit_write_u32(cfg->fp, AUDIT_BIN_PART) != IB_OK) ||
+             (audit_write_u32(cfg->fp, (uint32_t)name_len) != IB_OK) ||
+             (audit_write_u32(cfg->fp, (uint32_t)ctype_len) != IB_OK) ||
+             (fwrite(part->name, name_len, 1, cfg->fp) != 1) ||
+             (fwrite(part->content_type, ctype_len, 1, cfg->fp) != 1) )
+        {
+            ib_log_error(ib,  "Failed to write audit log part.");
+            fflush(cfg->fp);
+            return IB_EUNKNOWN;
+        }
+
+        /* Write the part data as length-prefixed chunks. The generator
+         * streams chunks of unknown total size, so a zero length ends
+         * the part rather than an up-front part length. */
+        while ((chunk_size = part->fn_gen(part, &chunk)) != 0) {
+            if ( (audit_write_u32(cfg->fp, (uint32_t)chunk_size) != IB_OK) ||
+                 (fwrite(chunk, chunk_size, 1, cfg->fp) != 1) )
+            {
+                ib_log_error(ib,  "Failed to write audit log part.");
+                fflush(cfg->fp);
+                return IB_EUNKNOWN;
+            }
+            cfg->parts_written++;
+        }
+
+        /* Finish the part. */
+        if (audit_write_u32(cfg->fp, 0) != IB_OK) {
+            ib_log_error(ib,  "Failed to write audit log part.");
+        }
+        fflush(cfg->fp);
+
+        return IB_OK;
+    }
+
     /* Write the MIME boundary and part header */
     fprintf(cfg->fp,
             "\r\n--%s"
@@ -550,7 +670,15 @@ ib_status_t core_audit_write_footer(ib_engine_t *ib,
     ib_core_audit_cfg_t *cfg = (ib_core_audit_cfg_t *)log->cfg_data;
 
     if (cfg->parts_written > 0) {
-        fprintf(cfg->fp, "\r\n--%s--\r\n", cfg->boundary);
+        if (cfg->core_cfg->auditlog_format == IB_AUDITLOG_FORMAT_BINARY) {
+            if (audit_write_u32(cfg->fp, AUDIT_BIN_END) != IB_OK) {
+                ib_log_error(ib,  "Failed to write audit log footer.");
+                return IB_EUNKNOWN;
+            }
+        }
+        else {
+            fprintf(cfg->fp, "\r\n--%s--\r\n", cfg->boundary);
+        }
     }
 
     return IB_OK;
@@ -660,6 +788,338 @@ static ib_status_t core_audit_get_index_line(ib_engine_t *ib,
     return rc;
 }
 
+/**
+ * Build the bytes to append to the audit log index for @a log.
+ *
+ * For the multipart format this is the formatted index line followed
+ * by a newline. For the binary format it is a length-prefixed record:
+ * u32 magic "IBX1", u32 length of the remainder, u64 log time in
+ * microseconds, u32 path length and the audit log path, in host byte
+ * order like the audit log itself.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] log The audit log.
+ * @param[in] corecfg Core configuration; selects the format.
+ * @param[out] entry Buffer the entry is written to.
+ * @param[in] entry_size Size of @a entry. The text form needs two bytes
+ *            of slack for the trailing newline and NUL.
+ * @param[out] entry_len Length of the entry.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ETRUNC if the text index line was truncated; @a entry is usable.
+ * - Other on failure.
+ */
+static ib_status_t core_audit_build_index_entry(ib_engine_t *ib,
+                                                ib_auditlog_t *log,
+                                                const ib_core_cfg_t *corecfg,
+                                                char *entry,
+                                                size_t entry_size,
+                                                size_t *entry_len)
+{
+    ib_status_t rc;
+    size_t len = 0;
+
+    if (corecfg->auditlog_format == IB_AUDITLOG_FORMAT_BINARY) {
+        ib_core_audit_cfg_t *cfg = (ib_core_audit_cfg_t *)log->cfg_data;
+        uint64_t logtime = (uint64_t)log->tx->t.logtime;
+        uint32_t path_len = (uint32_t)strlen(cfg->full_path);
+        uint32_t rec_len = sizeof(logtime) + sizeof(path_len) + path_len;
+        uint32_t magic = AUDIT_BIN_INDEX;
+
+        if (entry_size < (2 * sizeof(uint32_t)) + rec_len) {
+            return IB_ETRUNC;
+        }
+
+        memcpy(entry, &magic, sizeof(magic));
+        len += sizeof(magic);
+        memcpy(entry + len, &rec_len, sizeof(rec_len));
+        len += sizeof(rec_len);
+        memcpy(entry + len, &logtime, sizeof(logtime));
+        len += sizeof(logtime);
+        memcpy(entry + len, &path_len, sizeof(path_len));
+        len += sizeof(path_len);
+        memcpy(entry + len, cfg->full_path, path_len);
+        len += path_len;
+
+        *entry_len = len;
+        return IB_OK;
+    }
+
+    rc = core_audit_get_index_line(ib, log, entry, entry_size - 2, &len);
+    if ( (rc != IB_OK) && (rc != IB_ETRUNC) ) {
+        return rc;
+    }
+
+    entry[len + 0] = '\n';
+    entry[len + 1] = '\0';
+    *entry_len = len + 1;
+
+    return rc;
+}
+
+/**
+ * Fetch the engine's writer pool, creating it on first use.
+ *
+ * Creation is deferred to the first asynchronous audit log so the
+ * writer threads are created in the worker process, not in a server
+ * master that forks after configuration.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] corecfg Core configuration; auditlog_async is the pool size.
+ * @param[out] writer The pool.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Errors of core_audit_writer_create().
+ */
+static ib_status_t audit_writer_acquire(ib_engine_t *ib,
+                                        const ib_core_cfg_t *corecfg,
+                                        core_audit_writer_t **writer)
+{
+    ib_module_t *core_module;
+    ib_core_module_data_t *core_data;
+    ib_status_t rc;
+
+    rc = ib_core_module_data(ib, &core_module, &core_data);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (core_data->audit_writer == NULL) {
+        pthread_mutex_lock(&audit_writer_create_lock);
+        if (core_data->audit_writer == NULL) {
+            rc = core_audit_writer_create(
+                &core_data->audit_writer,
+                ib,
+                (size_t)corecfg->auditlog_async,
+                AUDIT_WRITER_MAX_PENDING);
+        }
+        pthread_mutex_unlock(&audit_writer_create_lock);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *writer = core_data->audit_writer;
+    return IB_OK;
+}
+
+/**
+ * Hand the serialized audit log to the writer pool.
+ *
+ * The index line is materialized here, on the transaction thread, as
+ * it reads transaction data that dies with the transaction; only file
+ * I/O is deferred. A full queue drops the audit log rather than
+ * blocking; the drop is counted by the pool.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] log The audit log.
+ * @param[in] cfg The configuration; holds the serialized bytes.
+ * @param[in] corecfg Core configuration.
+ * @param[in] line Scratch buffer of LOGFORMAT_MAX_LINE_LENGTH + 2.
+ *
+ * @returns
+ * - IB_OK on success, including a counted drop.
+ * - IB_EALLOC on allocation failure.
+ * - Errors of audit_writer_acquire().
+ */
+static ib_status_t core_audit_submit_async(ib_engine_t *ib,
+                                           ib_auditlog_t *log,
+                                           ib_core_audit_cfg_t *cfg,
+                                           ib_core_cfg_t *corecfg,
+                                           char *line)
+{
+    core_audit_writer_t *writer;
+    char *index_line = NULL;
+    size_t index_line_len = 0;
+    char *temp_path;
+    char *full_path;
+    ib_status_t ib_rc;
+
+    ib_rc = audit_writer_acquire(ib, corecfg, &writer);
+    if (ib_rc != IB_OK) {
+        return ib_rc;
+    }
+
+    /* Finalize the serialized log into cfg->mem_buf. */
+    fclose(cfg->fp);
+    cfg->fp = NULL;
+
+    if ((cfg->index_fp != NULL) && (cfg->parts_written > 0)) {
+        size_t len = 0;
+
+        ib_rc = core_audit_build_index_entry(ib, log, corecfg, line,
+                                             LOGFORMAT_MAX_LINE_LENGTH + 2,
+                                             &len);
+        if ( (ib_rc == IB_OK) || (ib_rc == IB_ETRUNC) ) {
+            index_line_len = len;
+            index_line = malloc(index_line_len);
+            if (index_line == NULL) {
+                free(cfg->mem_buf);
+                cfg->mem_buf = NULL;
+                return IB_EALLOC;
+            }
+            memcpy(index_line, line, index_line_len);
+        }
+    }
+
+    temp_path = strdup(cfg->temp_path);
+    full_path = strdup(cfg->full_path);
+    if ( (temp_path == NULL) || (full_path == NULL) ) {
+        free(temp_path);
+        free(full_path);
+        free(index_line);
+        free(cfg->mem_buf);
+        cfg->mem_buf = NULL;
+        return IB_EALLOC;
+    }
+
+    /* The writer owns all buffers from here, even on a full queue. */
+    core_audit_writer_submit(writer,
+                             cfg->mem_buf,
+                             cfg->mem_buf_sz,
+                             temp_path,
+                             full_path,
+                             (int)corecfg->auditlog_fmode,
+                             index_line,
+                             index_line_len,
+                             log->ctx->auditlog);
+    cfg->mem_buf = NULL;
+
+    return IB_OK;
+}
+
+ib_status_t core_audit_index_flush(ib_auditlog_cfg_t *log_cfg)
+{
+    assert(log_cfg != NULL);
+
+    size_t written;
+
+    log_cfg->index_last_flush = ib_clock_get_time();
+
+    if (log_cfg->index_buf_len == 0) {
+        return IB_OK;
+    }
+    if (log_cfg->index_fp == NULL) {
+        /* The index file was closed after the entries were batched
+         * (write error or reconfiguration); they have nowhere to go. */
+        log_cfg->index_buf_len = 0;
+        return IB_OK;
+    }
+
+    written = fwrite(log_cfg->index_buf,
+                     log_cfg->index_buf_len,
+                     1,
+                     log_cfg->index_fp);
+    log_cfg->index_buf_len = 0;
+    if (written == 0) {
+        return IB_EOTHER;
+    }
+    fflush(log_cfg->index_fp);
+
+    return IB_OK;
+}
+
+/**
+ * Memory manager cleanup: flush and free the batched index buffer.
+ *
+ * Registered on the owning context's memory manager when the buffer is
+ * first allocated, so entries batched near shutdown are not lost.
+ *
+ * @param[in] cbdata The ib_auditlog_cfg_t owning the buffer.
+ */
+static void core_audit_index_buf_cleanup(void *cbdata)
+{
+    ib_auditlog_cfg_t *log_cfg = (ib_auditlog_cfg_t *)cbdata;
+    assert(log_cfg != NULL);
+
+    if (ib_lock_lock(log_cfg->index_fp_lock) == IB_OK) {
+        core_audit_index_flush(log_cfg);
+        ib_lock_unlock(log_cfg->index_fp_lock);
+    }
+    free(log_cfg->index_buf);
+    log_cfg->index_buf = NULL;
+}
+
+/**
+ * Batch one index entry, flushing when the buffer fills or time passes.
+ *
+ * The caller must hold @c log_cfg->index_fp_lock. Entries accumulate in
+ * log_cfg->index_buf and reach the file as one contiguous fwrite() when
+ * the buffer cannot hold the next entry, or when AUDIT_INDEX_FLUSH_USEC
+ * has elapsed since the last flush, instead of one write and flush per
+ * transaction.
+ *
+ * @param[in] log_cfg The context's audit log configuration.
+ * @param[in] line The rendered index entry.
+ * @param[in] len Length of @a line.
+ *
+ * @returns
+ * - IB_OK On success, including when the index file is already closed.
+ * - IB_EALLOC On buffer allocation failure.
+ * - IB_EOTHER If writing to the index file fails.
+ */
+static ib_status_t core_audit_index_append(ib_auditlog_cfg_t *log_cfg,
+                                           const char *line,
+                                           size_t len)
+{
+    assert(log_cfg != NULL);
+    assert(line != NULL);
+
+    ib_status_t rc;
+
+    if (log_cfg->index_buf == NULL) {
+        log_cfg->index_buf = malloc(AUDIT_INDEX_BUF_SIZE);
+        if (log_cfg->index_buf == NULL) {
+            return IB_EALLOC;
+        }
+        log_cfg->index_last_flush = ib_clock_get_time();
+        rc = ib_mm_register_cleanup(log_cfg->owner->mm,
+                                    core_audit_index_buf_cleanup,
+                                    log_cfg);
+        if (rc != IB_OK) {
+            free(log_cfg->index_buf);
+            log_cfg->index_buf = NULL;
+            return rc;
+        }
+    }
+
+    /* An entry too large to batch is written through on its own. */
+    if (len >= AUDIT_INDEX_BUF_SIZE) {
+        rc = core_audit_index_flush(log_cfg);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        if (log_cfg->index_fp == NULL) {
+            return IB_OK;
+        }
+        if (fwrite(line, len, 1, log_cfg->index_fp) == 0) {
+            return IB_EOTHER;
+        }
+        fflush(log_cfg->index_fp);
+        return IB_OK;
+    }
+
+    if (log_cfg->index_buf_len + len > AUDIT_INDEX_BUF_SIZE) {
+        rc = core_audit_index_flush(log_cfg);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    memcpy(log_cfg->index_buf + log_cfg->index_buf_len, line, len);
+    log_cfg->index_buf_len += len;
+
+    if (ib_clock_get_time() - log_cfg->index_last_flush >=
+        AUDIT_INDEX_FLUSH_USEC)
+    {
+        return core_audit_index_flush(log_cfg);
+    }
+
+    return IB_OK;
+}
+
 ///! Close the auditlog and write to the index file.
 ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
 {
@@ -694,6 +1154,12 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
         goto cleanup;
     }
 
+    /* Asynchronous mode: defer the file I/O to the writer pool. */
+    if ((corecfg->auditlog_async > 0) && (cfg->fp != NULL)) {
+        ib_rc = core_audit_submit_async(ib, log, cfg, corecfg, line);
+        goto cleanup;
+    }
+
     /* Close the audit log. */
     if (cfg->fp != NULL) {
         fclose(cfg->fp);
@@ -713,27 +1179,23 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
 
     /* Write to the index file if using one. */
     if ((cfg->index_fp != NULL) && (cfg->parts_written > 0)) {
-        size_t written;
-
         ib_rc = ib_lock_lock(log->ctx->auditlog->index_fp_lock);
         if (ib_rc != IB_OK) {
             goto cleanup;
         }
 
-        ib_rc = core_audit_get_index_line(ib, log, line,
-                                          LOGFORMAT_MAX_LINE_LENGTH,
-                                          &len);
-        line[len + 0] = '\n';
-        line[len + 1] = '\0';
+        ib_rc = core_audit_build_index_entry(ib, log, corecfg, line,
+                                             LOGFORMAT_MAX_LINE_LENGTH + 2,
+                                             &len);
 
         if ( (ib_rc != IB_ETRUNC) && (ib_rc != IB_OK) ) {
             ib_lock_unlock(log->ctx->auditlog->index_fp_lock);
             goto cleanup;
         }
 
-        written = fwrite(line, len, 1, cfg->index_fp);
+        ib_rc = core_audit_index_append(log->ctx->auditlog, line, len);
 
-        if (written == 0) {
+        if (ib_rc != IB_OK) {
             sys_rc = errno;
             ib_log_error(log->ib,
                          "Error writing to audit log index: %s (%d)",
@@ -749,7 +1211,6 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
             goto cleanup;
         }
 
-        fflush(cfg->index_fp);
         ib_lock_unlock(log->ctx->auditlog->index_fp_lock);
     }
 
@@ -759,3 +1220,352 @@ cleanup:
     }
     return ib_rc;
 }
+
+/* -- Asynchronous Audit Log Writer Pool -- */
+
+/** One serialized audit log awaiting its file I/O. */
+typedef struct audit_writer_job_t audit_writer_job_t;
+struct audit_writer_job_t {
+    audit_writer_job_t *next;           /**< Next older queued job. */
+    char               *data;           /**< The serialized audit log. */
+    size_t              data_len;       /**< Length of data. */
+    char               *temp_path;      /**< File written first. */
+    char               *full_path;      /**< Rename target. */
+    int                 fmode;          /**< File creation mode. */
+    char               *index_line;     /**< Index line, or NULL. */
+    size_t              index_line_len; /**< Length of index_line. */
+    ib_auditlog_cfg_t  *log_cfg;        /**< Index file and its lock. */
+};
+
+/** Per-thread counters of a writer pool. */
+typedef struct {
+    uint64_t jobs;      /**< Audit logs written by this thread. */
+    uint64_t busy_usec; /**< Useconds spent writing them. */
+} audit_writer_stat_t;
+
+struct core_audit_writer_t {
+    ib_engine_t         *ib;          /**< For logging from the threads. */
+    pthread_mutex_t      lock;        /**< Guards the queue and running. */
+    pthread_cond_t       cond;        /**< Wakes idle writer threads. */
+    audit_writer_job_t  *head;        /**< Oldest queued job. */
+    audit_writer_job_t  *tail;        /**< Newest queued job. */
+    size_t               pending;     /**< Queued job count. */
+    size_t               max_pending; /**< Queue bound. */
+    bool                 running;     /**< False once draining to exit. */
+    size_t               num_writers; /**< Thread count. */
+    pthread_t           *threads;     /**< The writer threads. */
+    audit_writer_stat_t *stats;       /**< One entry per thread. */
+    uint64_t             submitted;   /**< Jobs accepted. */
+    uint64_t             dropped;     /**< Jobs dropped, queue full. */
+    uint64_t             write_errors;/**< Jobs that failed I/O. */
+};
+
+/** Thread argument: the pool and the thread's stats slot. */
+typedef struct {
+    core_audit_writer_t *writer;
+    size_t               slot;
+} audit_writer_arg_t;
+
+/**
+ * Free a job and the buffers it owns.
+ */
+static void audit_writer_job_destroy(audit_writer_job_t *job)
+{
+    if (job == NULL) {
+        return;
+    }
+    free(job->data);
+    free(job->temp_path);
+    free(job->full_path);
+    free(job->index_line);
+    free(job);
+}
+
+/**
+ * Perform one job's file I/O: write, rename, index append.
+ *
+ * @param[in] writer The pool.
+ * @param[in] job The job. Destroyed by the caller.
+ */
+static void audit_writer_job_run(core_audit_writer_t *writer,
+                                 audit_writer_job_t *job)
+{
+    int fd;
+    size_t off = 0;
+    int sys_rc;
+
+    fd = open(job->temp_path,
+              (O_WRONLY|O_APPEND|O_CREAT|O_BINARY),
+              job->fmode);
+    if (fd < 0) {
+        sys_rc = errno;
+        ib_log_error(writer->ib,
+                     "Error opening audit log \"%s\": %s (%d)",
+                     job->temp_path, strerror(sys_rc), sys_rc);
+        __sync_fetch_and_add(&writer->write_errors, 1);
+        return;
+    }
+
+    while (off < job->data_len) {
+        ssize_t written = write(fd, job->data + off, job->data_len - off);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            sys_rc = errno;
+            ib_log_error(writer->ib,
+                         "Error writing audit log \"%s\": %s (%d)",
+                         job->temp_path, strerror(sys_rc), sys_rc);
+            close(fd);
+            __sync_fetch_and_add(&writer->write_errors, 1);
+            return;
+        }
+        off += written;
+    }
+    close(fd);
+
+    sys_rc = rename(job->temp_path, job->full_path);
+    if (sys_rc != 0) {
+        sys_rc = errno;
+        ib_log_error(writer->ib,
+                     "Error renaming auditlog %s: %s (%d)",
+                     job->temp_path, strerror(sys_rc), sys_rc);
+        __sync_fetch_and_add(&writer->write_errors, 1);
+        return;
+    }
+
+    /* Batch the index line under the context's index lock. The index
+     * file pointer is re-checked under the lock; another thread may
+     * have closed it after a write error. */
+    if (job->index_line != NULL) {
+        if (ib_lock_lock(job->log_cfg->index_fp_lock) == IB_OK) {
+            if (job->log_cfg->index_fp != NULL) {
+                if (core_audit_index_append(job->log_cfg,
+                                            job->index_line,
+                                            job->index_line_len) != IB_OK)
+                {
+                    __sync_fetch_and_add(&writer->write_errors, 1);
+                }
+            }
+            ib_lock_unlock(job->log_cfg->index_fp_lock);
+        }
+    }
+}
+
+/**
+ * Main of one writer thread: drain the queue until told to stop.
+ *
+ * The pool drains fully before exiting, so queued audit logs survive
+ * an orderly shutdown.
+ */
+static void *audit_writer_main(void *arg)
+{
+    audit_writer_arg_t *writer_arg = (audit_writer_arg_t *)arg;
+    core_audit_writer_t *writer = writer_arg->writer;
+    audit_writer_stat_t *stat = &writer->stats[writer_arg->slot];
+
+    for (;;) {
+        audit_writer_job_t *job;
+        ib_time_t start;
+
+        pthread_mutex_lock(&writer->lock);
+        while (writer->running && (writer->head == NULL)) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        job = writer->head;
+        if (job == NULL) {
+            /* Not running and drained. */
+            pthread_mutex_unlock(&writer->lock);
+            break;
+        }
+        writer->head = job->next;
+        if (writer->head == NULL) {
+            writer->tail = NULL;
+        }
+        --writer->pending;
+        pthread_mutex_unlock(&writer->lock);
+
+        start = ib_clock_get_time();
+        audit_writer_job_run(writer, job);
+        audit_writer_job_destroy(job);
+        ++stat->jobs;
+        stat->busy_usec += ib_clock_get_time() - start;
+    }
+
+    free(writer_arg);
+    return NULL;
+}
+
+ib_status_t core_audit_writer_create(core_audit_writer_t **writer,
+                                     ib_engine_t *ib,
+                                     size_t num_writers,
+                                     size_t max_pending)
+{
+    assert(writer != NULL);
+    assert(ib != NULL);
+    assert(num_writers > 0);
+
+    core_audit_writer_t *w;
+    size_t started;
+
+    w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        return IB_EALLOC;
+    }
+
+    w->ib          = ib;
+    w->max_pending = max_pending;
+    w->num_writers = num_writers;
+    w->running     = true;
+
+    w->threads = calloc(num_writers, sizeof(*w->threads));
+    w->stats   = calloc(num_writers, sizeof(*w->stats));
+    if ( (w->threads == NULL) || (w->stats == NULL) ) {
+        free(w->threads);
+        free(w->stats);
+        free(w);
+        return IB_EALLOC;
+    }
+
+    if ( (pthread_mutex_init(&w->lock, NULL) != 0) ||
+         (pthread_cond_init(&w->cond, NULL) != 0) )
+    {
+        free(w->threads);
+        free(w->stats);
+        free(w);
+        return IB_EOTHER;
+    }
+
+    for (started = 0; started < num_writers; ++started) {
+        audit_writer_arg_t *arg = malloc(sizeof(*arg));
+
+        if (arg == NULL) {
+            break;
+        }
+        arg->writer = w;
+        arg->slot = started;
+        if (pthread_create(&w->threads[started],
+                           NULL,
+                           audit_writer_main,
+                           arg) != 0)
+        {
+            free(arg);
+            break;
+        }
+    }
+    if (started < num_writers) {
+        /* Roll back the threads that did start. */
+        pthread_mutex_lock(&w->lock);
+        w->running = false;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        for (size_t i = 0; i < started; ++i) {
+            pthread_join(w->threads[i], NULL);
+        }
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w->threads);
+        free(w->stats);
+        free(w);
+        return IB_EOTHER;
+    }
+
+    *writer = w;
+    return IB_OK;
+}
+
+ib_status_t core_audit_writer_submit(core_audit_writer_t *writer,
+                                     char *data,
+                                     size_t data_len,
+                                     char *temp_path,
+                                     char *full_path,
+                                     int fmode,
+                                     char *index_line,
+                                     size_t index_line_len,
+                                     ib_auditlog_cfg_t *log_cfg)
+{
+    assert(writer != NULL);
+    assert(data != NULL);
+    assert(temp_path != NULL);
+    assert(full_path != NULL);
+    assert(log_cfg != NULL);
+
+    audit_writer_job_t *job;
+
+    job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        free(data);
+        free(temp_path);
+        free(full_path);
+        free(index_line);
+        return IB_EALLOC;
+    }
+    job->data           = data;
+    job->data_len       = data_len;
+    job->temp_path      = temp_path;
+    job->full_path      = full_path;
+    job->fmode          = fmode;
+    job->index_line     = index_line;
+    job->index_line_len = index_line_len;
+    job->log_cfg        = log_cfg;
+
+    pthread_mutex_lock(&writer->lock);
+    if (!writer->running || (writer->pending >= writer->max_pending)) {
+        ++writer->dropped;
+        pthread_mutex_unlock(&writer->lock);
+        audit_writer_job_destroy(job);
+        return IB_DECLINED;
+    }
+    if (writer->tail == NULL) {
+        writer->head = job;
+    }
+    else {
+        writer->tail->next = job;
+    }
+    writer->tail = job;
+    ++writer->pending;
+    ++writer->submitted;
+    pthread_cond_signal(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    return IB_OK;
+}
+
+void core_audit_writer_destroy(core_audit_writer_t *writer)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->running = false;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    for (size_t i = 0; i < writer->num_writers; ++i) {
+        pthread_join(writer->threads[i], NULL);
+    }
+
+    for (size_t i = 0; i < writer->num_writers; ++i) {
+        const audit_writer_stat_t *stat = &writer->stats[i];
+
+        ib_log_info(writer->ib,
+                    "Audit writer %zu: %" PRIu64 " logs written,"
+                    " %" PRIu64 " usec average.",
+                    i,
+                    stat->jobs,
+                    (stat->jobs > 0) ? stat->busy_usec / stat->jobs : 0);
+    }
+    ib_log_info(writer->ib,
+                "Audit writer pool: %" PRIu64 " submitted,"
+                " %" PRIu64 " dropped, %" PRIu64 " write errors.",
+                writer->submitted,
+                writer->dropped,
+                writer->write_errors);
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer->threads);
+    free(writer->stats);
+    free(writer);
+}
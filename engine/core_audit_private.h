@@ -25,6 +25,8 @@
 #ifndef _IB_CORE_AUDIT_PRIVATE_H_
 #define _IB_CORE_AUDIT_PRIVATE_H_
 
+#include "engine_private.h"
+
 #include <ironbee/core.h>
 
 #include <stdio.h>
@@ -127,4 +129,94 @@ ib_status_t core_audit_write_footer(ib_engine_t *ib,
  */
 ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log);
 
+/**
+ * Write any batched index entries to the index file.
+ *
+ * Index entries are batched in @a log_cfg and written with one fwrite()
+ * per flush, not one per transaction. The caller must hold
+ * @c log_cfg->index_fp_lock. Call this before closing the index file
+ * pointer so no batched entries are lost.
+ *
+ * @param[in] log_cfg The context's audit log configuration.
+ *
+ * @returns
+ * - IB_OK On success, including when nothing is batched.
+ * - IB_EOTHER If writing to the index file fails.
+ */
+ib_status_t core_audit_index_flush(ib_auditlog_cfg_t *log_cfg);
+
+/**
+ * The asynchronous audit log writer pool.
+ *
+ * When AuditLogAsyncWriters is non-zero the audit log is serialized to
+ * memory on the transaction thread, and the file open, write, rename
+ * and index update are performed by this pool, so a slow disk never
+ * stalls request processing. The queue is bounded: when it is full the
+ * audit log is dropped and counted rather than blocking.
+ */
+typedef struct core_audit_writer_t core_audit_writer_t;
+
+/**
+ * Create a writer pool of @a num_writers threads.
+ *
+ * Threads are created here, so this must run in the process that will
+ * submit jobs (after any server fork).
+ *
+ * @param[out] writer The created pool.
+ * @param[in] ib IronBee engine, for logging from writer threads.
+ * @param[in] num_writers Number of writer threads. At least 1.
+ * @param[in] max_pending Queue bound. Jobs past it are dropped.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure using malloc.
+ * - IB_EOTHER If threads cannot be created.
+ */
+ib_status_t core_audit_writer_create(core_audit_writer_t **writer,
+                                     ib_engine_t *ib,
+                                     size_t num_writers,
+                                     size_t max_pending);
+
+/**
+ * Queue one serialized audit log for writing.
+ *
+ * Ownership of @a data, @a temp_path, @a full_path and @a index_line
+ * (all malloc'ed) passes to the writer on any return code; they are
+ * freed when the job completes or is dropped.
+ *
+ * @param[in] writer The writer pool.
+ * @param[in] data The serialized audit log.
+ * @param[in] data_len Length of @a data.
+ * @param[in] temp_path File written, then renamed to @a full_path.
+ * @param[in] full_path Final audit log path.
+ * @param[in] fmode Creation mode of the audit log file.
+ * @param[in] index_line Index entry to append, or NULL. The text form
+ *            ends in a newline; the binary form is a complete record.
+ * @param[in] index_line_len Length of @a index_line.
+ * @param[in] log_cfg The context's audit log configuration, holding
+ *            the index file pointer and its lock. Outlives the job.
+ *
+ * @returns
+ * - IB_OK If queued.
+ * - IB_DECLINED If the queue is full; the job is dropped and counted.
+ */
+ib_status_t core_audit_writer_submit(core_audit_writer_t *writer,
+                                     char *data,
+                                     size_t data_len,
+                                     char *temp_path,
+                                     char *full_path,
+                                     int fmode,
+                                     char *index_line,
+                                     size_t index_line_len,
+                                     ib_auditlog_cfg_t *log_cfg);
+
+/**
+ * Drain the queue, stop the threads and free the pool.
+ *
+ * Logs the pool's write/drop/latency statistics on the way out.
+ *
+ * @param[in] writer The writer pool. May be NULL.
+ */
+void core_audit_writer_destroy(core_audit_writer_t *writer);
+
 #endif // _IB_CORE_AUDIT_PRIVATE_H_
@@ -110,8 +110,18 @@ typedef struct core_site_selector_t {
     const core_service_t  *service;      /**< Service (IP/Port) */
     const ib_list_t       *hosts;        /**< List of core_host_t* */
     const ib_list_t       *locations;    /**< List of core_location_t* */
+    size_t                 index;        /**< Ordinal in the selector list */
 } core_site_selector_t;
 
+/**
+ * Maximum candidate lists merged by the indexed selection path.
+ *
+ * One for the exact hostname, one for the wildcard/empty-host list, and
+ * one per label boundary in the hostname. Hostnames with more labels
+ * fall back to the linear walk.
+ */
+#define CORE_CTXSEL_MAX_MERGE_LISTS 64
+
 
 /**
  * Find the first 'match any' location for the given site
@@ -323,6 +333,227 @@ static ib_status_t core_create_site_selector(
     return IB_OK;
 }
 
+/**
+ * Append @a selector to the selector list stored in @a hash under @a key.
+ *
+ * The list is created on first use. Because selectors are indexed in
+ * selector list order, every per-key list is ordered by selector
+ * ordinal.
+ *
+ * @param[in,out] hash Hash of ib_list_t keyed by hostname.
+ * @param[in] mm Memory manager lists are created from.
+ * @param[in] key Hostname or suffix to file @a selector under.
+ * @param[in] selector The selector.
+ *
+ * @returns IB_OK or IB_EALLOC.
+ */
+static ib_status_t core_ctxsel_index_push(
+    ib_hash_t *hash,
+    ib_mm_t mm,
+    const char *key,
+    const core_site_selector_t *selector)
+{
+    assert(hash != NULL);
+    assert(key != NULL);
+    assert(selector != NULL);
+
+    ib_list_t *selectors;
+    ib_status_t rc;
+
+    rc = ib_hash_get(hash, &selectors, key);
+    if (rc == IB_ENOENT) {
+        rc = ib_list_create(&selectors, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_hash_set(hash, key, selectors);
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_list_push(selectors, (void *)selector);
+}
+
+/**
+ * Build the host indexes over the selector list.
+ *
+ * Selectors are filed under every exact hostname they serve in
+ * selector_exact_hosts, under every ".suffix" wildcard in
+ * selector_suffix_hosts, and in selector_other_hosts when they match
+ * any host, have no host list, or have a wildcard that does not fall
+ * on a label boundary.  Selection merges the lists relevant to a
+ * hostname instead of walking every selector; the merged candidates
+ * are still verified with the regular match functions, so the indexes
+ * only prune, never decide.
+ *
+ * @param[in] ib IronBee engine
+ * @param[in,out] core_data Core module data
+ *
+ * @returns IB_OK or IB_EALLOC.
+ */
+static ib_status_t core_ctxsel_build_host_index(
+    const ib_engine_t *ib,
+    ib_core_module_data_t *core_data)
+{
+    assert(ib != NULL);
+    assert(core_data != NULL);
+
+    ib_mm_t mm = ib_engine_mm_main_get(ib);
+    const ib_list_node_t *node;
+    size_t index = 0;
+    ib_status_t rc;
+
+    rc = ib_hash_create_nocase(&(core_data->selector_exact_hosts), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_hash_create_nocase(&(core_data->selector_suffix_hosts), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_list_create(&(core_data->selector_other_hosts), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    IB_LIST_LOOP_CONST(core_data->selector_list, node) {
+        core_site_selector_t *selector =
+            (core_site_selector_t *)ib_list_node_data_const(node);
+        const ib_list_node_t *host_node;
+        bool in_other = false;
+
+        selector->index = index;
+        ++index;
+
+        /* No host list: the selector matches any hostname. */
+        if (selector->hosts == NULL) {
+            rc = ib_list_push(core_data->selector_other_hosts, selector);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            continue;
+        }
+
+        IB_LIST_LOOP_CONST(selector->hosts, host_node) {
+            const core_host_t *host =
+                (const core_host_t *)ib_list_node_data_const(host_node);
+
+            if (host->match_any ||
+                (host->host.suffix != NULL && host->host.suffix[0] != '.'))
+            {
+                /* Filed once; the merge also skips duplicate ordinals. */
+                if (! in_other) {
+                    rc = ib_list_push(
+                        core_data->selector_other_hosts,
+                        selector);
+                    if (rc != IB_OK) {
+                        return rc;
+                    }
+                    in_other = true;
+                }
+            }
+            else if (host->host.suffix != NULL) {
+                rc = core_ctxsel_index_push(
+                    core_data->selector_suffix_hosts,
+                    mm,
+                    host->host.suffix,
+                    selector);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+            else {
+                rc = core_ctxsel_index_push(
+                    core_data->selector_exact_hosts,
+                    mm,
+                    host->host.hostname,
+                    selector);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Run the full service/host/location checks against one selector.
+ *
+ * This is the per-selector body of the selection loop, shared by the
+ * indexed and linear selection paths.
+ *
+ * @param[in] ib IronBee engine
+ * @param[in] conn Connection to match
+ * @param[in] tx Transaction to match
+ * @param[in] ip_len Length of the connection's local IP string
+ * @param[in] selector Selector to check
+ * @param[out] location Matching location on a full match, else untouched.
+ *
+ * @returns true on a full match.
+ */
+static bool core_ctxsel_selector_match(
+    const ib_engine_t *ib,
+    const ib_conn_t *conn,
+    const ib_tx_t *tx,
+    size_t ip_len,
+    const core_site_selector_t *selector,
+    const core_location_t **location)
+{
+    assert(ib != NULL);
+    assert(conn != NULL);
+    assert(tx != NULL);
+    assert(selector != NULL);
+    assert(location != NULL);
+
+    const core_service_t *service = selector->service;
+    const core_location_t *match_location;
+    ib_status_t rc;
+    bool match;
+
+    ib_log_debug2(ib, "Looking for matching context against site=%s(%s)",
+                  (selector->site ? selector->site->site.id : "none"),
+                  (selector->site ? selector->site->site.name : "none"));
+
+    /*
+     * Check if the service matches the connection data.
+     */
+    if ( (service != NULL) && (! service->match_any) ) {
+        /* Check that the port matches the service (if specified) */
+        if ( (service->service.port >= 0) &&
+             (service->service.port != conn->local_port) ) {
+            return false;
+        }
+        /* Check that the address matches the service (if specified) */
+        if ( (service->service.ipstr != NULL) &&
+             (service->ip_len == ip_len) &&
+             (strcmp(service->service.ipstr, conn->local_ipstr) != 0) )
+        {
+            return false;
+        }
+    }
+    ib_log_debug2(ib, "Connection %s:%d matched context service.",
+                  conn->local_ipstr, conn->local_port);
+
+    /* Check if the hostname matches the transaction data. */
+    rc = core_ctxsel_match_host(ib, tx, selector->hosts, &match);
+    if ( (rc != IB_OK) || (! match) ) {
+        return false;
+    }
+
+    /* Check if the location matches the transaction data. */
+    rc = core_ctxsel_match_location(
+        ib, tx, selector->locations, &match_location);
+    if ( (rc != IB_OK) || (match_location == NULL) ) {
+        return false;
+    }
+
+    *location = match_location;
+    return true;
+}
+
 /**
  * Finalize the core context selection.
  *
@@ -408,6 +639,14 @@ static ib_status_t core_ctxsel_finalize(
         }
     }
 
+    /* Index the selectors by hostname. */
+    rc = core_ctxsel_build_host_index(ib, core_data);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Error building core site selector host index: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     return IB_OK;
 }
 
@@ -437,7 +676,14 @@ static ib_status_t core_ctxsel_select(
     assert(pctx != NULL);
 
     const ib_list_node_t *node;
+    const ib_list_node_t *cursors[CORE_CTXSEL_MAX_MERGE_LISTS];
+    const core_site_selector_t *matched_selector = NULL;
+    const core_location_t *matched_location = NULL;
+    ib_context_t *ctx;
+    size_t ncursors = 0;
+    size_t examined = 0;
     size_t ip_len;
+    bool use_index;
     ib_status_t rc;
     ib_core_module_data_t *core_data = (ib_core_module_data_t *)common_cb_data;
 
@@ -456,78 +702,122 @@ static ib_status_t core_ctxsel_select(
         goto select_main_context;
     }
 
+    ++(core_data->selections);
+
     /* Get the length of the IP address string before the main loop */
     ip_len = strlen(conn->local_ipstr);
 
     /*
-     * Walk through the list of site selectors, return when the first matching
-     * selector is found.  At any point in the loop if a non-match is found,
-     * we continue to the top of the loop, and try the next selector.
+     * Gather the candidate selector lists for this hostname from the
+     * host indexes: the wildcard/empty-host list, the exact hostname
+     * list, and one suffix list per label boundary.  Each list is
+     * ordered by selector ordinal, so merging them by ordinal visits
+     * the candidates in selector list order and preserves first-match
+     * semantics.  If the indexes are absent or the hostname has too
+     * many labels, fall back to the linear walk below.
      */
-    IB_LIST_LOOP_CONST(core_data->selector_list, node) {
-        const core_site_selector_t *selector =
-            (const core_site_selector_t *)ib_list_node_data_const(node);
-        const core_service_t *service = selector->service;
-        const core_location_t *location;
-        ib_context_t *ctx;
-        bool match;
-
-        ib_log_debug2(ib, "Looking for matching context against site=%s(%s)",
-                      (selector->site ? selector->site->site.id : "none"),
-                      (selector->site ? selector->site->site.name : "none"));
-
-        /*
-         * Check if the service matches the connection data.
-         */
-        if ( (service != NULL) && (! service->match_any) ) {
-            /* Check that the port matches the service (if specified) */
-            if ( (service->service.port >= 0) &&
-                 (service->service.port != conn->local_port) ) {
-                continue;
+    use_index = (core_data->selector_exact_hosts != NULL);
+    if (use_index) {
+        cursors[ncursors] =
+            ib_list_first_const(core_data->selector_other_hosts);
+        ++ncursors;
+
+        if (tx->hostname != NULL) {
+            ib_list_t *selectors;
+
+            rc = ib_hash_get(
+                core_data->selector_exact_hosts, &selectors, tx->hostname);
+            if (rc == IB_OK) {
+                cursors[ncursors] = ib_list_first_const(selectors);
+                ++ncursors;
             }
-            /* Check that the address matches the service (if specified) */
-            if ( (service->service.ipstr != NULL) &&
-                 (service->ip_len == ip_len) &&
-                 (strcmp(service->service.ipstr, conn->local_ipstr) != 0) )
+
+            for (const char *label = strchr(tx->hostname, '.');
+                 label != NULL;
+                 label = strchr(label + 1, '.'))
             {
-                continue;
+                if (ncursors == CORE_CTXSEL_MAX_MERGE_LISTS) {
+                    use_index = false;
+                    break;
+                }
+                rc = ib_hash_get(
+                    core_data->selector_suffix_hosts, &selectors, label);
+                if (rc == IB_OK) {
+                    cursors[ncursors] = ib_list_first_const(selectors);
+                    ++ncursors;
+                }
             }
         }
-        ib_log_debug2(ib, "Connection %s:%d matched context service.",
-                      conn->local_ipstr, conn->local_port);
+    }
 
-        /* Check if the hostname matches the transaction data. */
-        rc = core_ctxsel_match_host(ib, tx, selector->hosts, &match);
-        if (rc != IB_OK) {
-            /* todo: What is the right thing to do here? */
-            continue;
-        }
-        if (! match) {
-            continue;
-        }
+    if (use_index) {
+        for (;;) {
+            const core_site_selector_t *selector = NULL;
 
-        /* Check if the location matches the transaction data. */
-        rc = core_ctxsel_match_location(ib, tx, selector->locations, &location);
-        if (rc != IB_OK) {
-            /* todo: What is the right thing to do here? */
-            continue;
-        }
-        if (location == NULL) {
-            continue;
-        }
+            /* Find the lowest-ordinal candidate among the list heads. */
+            for (size_t i = 0; i < ncursors; ++i) {
+                const core_site_selector_t *head;
 
-        /* Everything matches.  Use this selector's context. */
-        ctx = location->location.context;
+                if (cursors[i] == NULL) {
+                    continue;
+                }
+                head = (const core_site_selector_t *)
+                    ib_list_node_data_const(cursors[i]);
+                if ( (selector == NULL) || (head->index < selector->index) ) {
+                    selector = head;
+                }
+            }
+            if (selector == NULL) {
+                break;
+            }
 
-        ib_log_debug2(ib, "Selected context \"%s\" site=%s(%s) location=%s",
-                      ib_context_full_get(ctx),
-                      (selector->site ? selector->site->site.id : "none"),
-                      (selector->site ? selector->site->site.name : "none"),
-                      location->location.path);
-        *pctx = ctx;
-        return IB_OK;
+            /* Advance every cursor at this ordinal; a selector can be
+             * filed under several of its hostnames. */
+            for (size_t i = 0; i < ncursors; ++i) {
+                const core_site_selector_t *head;
+
+                if (cursors[i] == NULL) {
+                    continue;
+                }
+                head = (const core_site_selector_t *)
+                    ib_list_node_data_const(cursors[i]);
+                if (head->index == selector->index) {
+                    cursors[i] = ib_list_node_next_const(cursors[i]);
+                }
+            }
+
+            ++examined;
+            if (core_ctxsel_selector_match(
+                    ib, conn, tx, ip_len, selector, &matched_location))
+            {
+                matched_selector = selector;
+                goto selector_matched;
+            }
+        }
+    }
+    else {
+        /*
+         * Walk through the list of site selectors, return when the first
+         * matching selector is found.  At any point in the loop if a
+         * non-match is found, we continue to the top of the loop, and try
+         * the next selector.
+         */
+        IB_LIST_LOOP_CONST(core_data->selector_list, node) {
+            const core_site_selector_t *selector =
+                (const core_site_selector_t *)ib_list_node_data_const(node);
+
+            ++examined;
+            if (core_ctxsel_selector_match(
+                    ib, conn, tx, ip_len, selector, &matched_location))
+            {
+                matched_selector = selector;
+                goto selector_matched;
+            }
+        }
     }
 
+    core_data->selectors_examined += examined;
+
     /*
      * If we get here, we've exhausted the list of selectors, with no matching
      * selector found
@@ -542,6 +832,26 @@ select_main_context:
     *pctx = ib_context_main(ib);
 
     return IB_OK;
+
+selector_matched:
+    core_data->selectors_examined += examined;
+
+    /* Everything matches.  Use this selector's context. */
+    ctx = matched_location->location.context;
+
+    ib_log_debug2(ib,
+                  "Selected context \"%s\" site=%s(%s) location=%s"
+                  " (%zd of %zd selectors examined)",
+                  ib_context_full_get(ctx),
+                  (matched_selector->site ?
+                      matched_selector->site->site.id : "none"),
+                  (matched_selector->site ?
+                      matched_selector->site->site.name : "none"),
+                  matched_location->location.path,
+                  examined,
+                  ib_list_elements(core_data->selector_list));
+    *pctx = ctx;
+    return IB_OK;
 }
 
 /**
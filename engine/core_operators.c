@@ -300,6 +300,14 @@ struct numop_instance_data_t {
     /* One of these two fields must be NULL */
     const ib_field_t *f; /**< Number field to compare to. */
     const ib_var_expand_t *expand; /**< Var expand to compare to. */
+
+    /* The parameter value, pre-extracted when @a f is non-NULL.  Rules on
+     * collections invoke these operators once per element; pulling the
+     * value and its type out at creation keeps that per-element call down
+     * to one type check and a compare, with no field conversion. */
+    ib_ftype_t param_type;  /**< IB_FTYPE_NUM or IB_FTYPE_FLOAT. */
+    ib_num_t   param_num;   /**< Value when param_type is NUM. */
+    ib_float_t param_float; /**< Value when param_type is FLOAT. */
 };
 typedef struct numop_instance_data_t numop_instance_data_t;
 
@@ -437,14 +445,11 @@ ib_status_t op_streq_execute(
 
         if (len == expanded_length) {
             if (case_insensitive) {
-                *result = 1;
-                const char *v = (const char *)ib_bytestr_const_ptr(value);
-                for (size_t i = 0; i < len; ++i) {
-                    if (tolower(expanded[i]) != tolower(v[i])) {
-                        *result = 0;
-                        break;
-                    }
-                }
+                *result = ib_streq_nocase(
+                    expanded,
+                    (const char *)ib_bytestr_const_ptr(value),
+                    len
+                );
             }
             else {
                 *result = (
@@ -589,6 +594,10 @@ ib_status_t op_contains_execute(
 /**
  * Create function for the "match" and "imatch" operators.
  *
+ * The space separated parameter words are compiled into a hash once, at
+ * operator creation; execution is a single hash lookup regardless of the
+ * number of words.  For "imatch" the hash is case insensitive.
+ *
  * @param[in]  ctx           The current IronBee context (unused).
  * @param[in]  mm            Memory manager.
  * @param[in]  parameters    Parameters.
@@ -1550,6 +1559,84 @@ ib_status_t execute_compare(
     ib_field_t *rh_field = NULL;
     ib_field_t *lh_field = NULL;
 
+    /* Fast path for literal parameters against scalar fields.  This is
+     * the hot per-element call when a rule targets a collection: the
+     * parameter value was extracted at operator creation, so no operand
+     * preparation or field conversion is needed.  The type rules are the
+     * same as prepare_math_operands(): num/num compares as num, any
+     * float operand promotes both sides to float. */
+    if ( (ndata->expand == NULL) &&
+         (field != NULL) &&
+         (field->type == IB_FTYPE_NUM || field->type == IB_FTYPE_FLOAT) )
+    {
+        if (field->type == IB_FTYPE_NUM &&
+            ndata->param_type == IB_FTYPE_NUM)
+        {
+            ib_num_t value;
+
+            rc = ib_field_value(field, ib_ftype_num_out(&value));
+            if (rc != IB_OK) {
+                return rc;
+            }
+
+            rc = num_compare(value, ndata->param_num, result);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            if (capture != NULL && *result) {
+                rc = ib_capture_clear(capture);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+                rc = capture_num(tx->mm, capture, 0, value);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+        }
+        else {
+            ib_float_t value;
+            ib_float_t param_value;
+
+            if (field->type == IB_FTYPE_FLOAT) {
+                rc = ib_field_value(field, ib_ftype_float_out(&value));
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+            else {
+                ib_num_t num_value;
+                rc = ib_field_value(field, ib_ftype_num_out(&num_value));
+                if (rc != IB_OK) {
+                    return rc;
+                }
+                value = (ib_float_t)num_value;
+            }
+
+            param_value =
+                (ndata->param_type == IB_FTYPE_FLOAT) ?
+                    ndata->param_float :
+                    (ib_float_t)ndata->param_num;
+
+            rc = float_compare(value, param_value, result);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            if (capture != NULL && *result) {
+                rc = ib_capture_clear(capture);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+                rc = capture_float(tx->mm, capture, 0, value);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+        }
+
+        return IB_OK;
+    }
+
     rc = prepare_math_operands(
         tx,
         ndata->expand,
@@ -1945,6 +2032,8 @@ ib_status_t op_numcmp_create(
                 IB_S2SL("param"),
                 IB_FTYPE_NUM,
                 ib_ftype_num_in(&num_value));
+            data->param_type = IB_FTYPE_NUM;
+            data->param_num  = num_value;
         }
         /* If it's a valid float, don't use it for eq and ne operators */
         else if (float_rc == IB_OK) {
@@ -1960,6 +2049,8 @@ ib_status_t op_numcmp_create(
                     IB_S2SL("param"),
                     IB_FTYPE_FLOAT,
                     ib_ftype_float_in(&float_value));
+                data->param_type  = IB_FTYPE_FLOAT;
+                data->param_float = float_value;
             }
         }
         else {
@@ -2030,7 +2121,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "streq",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         strop_create, NULL,
         NULL, NULL,
         op_streq_execute, NULL
@@ -2044,7 +2137,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "istreq",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         strop_create, NULL,
         NULL, NULL,
         op_streq_execute, (void *)1
@@ -2058,7 +2153,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "contains",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         strop_create, NULL,
         NULL, NULL,
         op_contains_execute, NULL
@@ -2072,7 +2169,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "match",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         op_match_create, NULL,
         NULL, NULL,
         op_match_execute, NULL
@@ -2086,7 +2185,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "imatch",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         op_match_create, (void *)1,
         NULL, NULL,
         op_match_execute, /* Note: same as above. */ NULL
@@ -2100,7 +2201,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "ipmatch",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         op_ipmatch_create, NULL,
         NULL, NULL,
         op_ipmatch_execute, NULL
@@ -2114,7 +2217,9 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "ipmatch6",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE |
+          IB_OP_CAPABILITY_MEMOIZE ),
         op_ipmatch6_create, NULL,
         NULL, NULL,
         op_ipmatch6_execute, NULL
@@ -2132,7 +2237,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "eq",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_eq_execute,
         NULL, NULL,
         op_eq_execute, NULL
@@ -2146,7 +2252,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "ne",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_ne_execute,
         NULL, NULL,
         op_ne_execute, NULL
@@ -2160,7 +2267,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "gt",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_gt_execute,
         NULL, NULL,
         op_gt_execute, NULL
@@ -2174,7 +2282,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "lt",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_lt_execute,
         NULL, NULL,
         op_lt_execute, NULL
@@ -2188,7 +2297,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "ge",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_ge_execute,
         NULL, NULL,
         op_ge_execute, NULL
@@ -2202,7 +2312,8 @@ ib_status_t ib_core_operators_init(ib_engine_t *ib, ib_module_t *mod)
         NULL,
         ib,
         "le",
-        IB_OP_CAPABILITY_CAPTURE,
+        ( IB_OP_CAPABILITY_CAPTURE |
+          IB_OP_CAPABILITY_SHAREABLE ),
         op_numcmp_create, op_le_execute,
         NULL, NULL,
         op_le_execute, NULL
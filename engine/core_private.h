@@ -29,9 +29,48 @@
 
 #include <ironbee/context_selection.h>
 #include <ironbee/engine.h>
+#include <ironbee/hash.h>
 #include <ironbee/types.h>
 #include <ironbee/var.h>
 
+/* Audit log parts. */
+#define IB_ALPART_HEADER                  (1<< 0)
+#define IB_ALPART_EVENTS                  (1<< 1)
+#define IB_ALPART_HTTP_REQUEST_METADATA   (1<< 2)
+#define IB_ALPART_HTTP_REQUEST_HEADER     (1<< 3)
+#define IB_ALPART_HTTP_REQUEST_BODY       (1<< 4)
+#define IB_ALPART_HTTP_REQUEST_TRAILER    (1<< 5)
+#define IB_ALPART_HTTP_RESPONSE_METADATA  (1<< 6)
+#define IB_ALPART_HTTP_RESPONSE_HEADER    (1<< 7)
+#define IB_ALPART_HTTP_RESPONSE_BODY      (1<< 8)
+#define IB_ALPART_HTTP_RESPONSE_TRAILER   (1<< 9)
+#define IB_ALPART_DEBUG_FIELDS            (1<<10)
+
+/* NOTE: Make sure to add new parts from above to any groups below. */
+
+#define IB_ALPARTS_ALL \
+    IB_ALPART_HEADER|IB_ALPART_EVENTS| \
+    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
+    IB_ALPART_HTTP_REQUEST_BODY|IB_ALPART_HTTP_REQUEST_TRAILER | \
+    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
+    IB_ALPART_HTTP_RESPONSE_BODY|IB_ALPART_HTTP_RESPONSE_TRAILER | \
+    IB_ALPART_DEBUG_FIELDS
+
+#define IB_ALPARTS_DEFAULT \
+    IB_ALPART_HEADER|IB_ALPART_EVENTS| \
+    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
+    IB_ALPART_HTTP_REQUEST_TRAILER | \
+    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
+    IB_ALPART_HTTP_RESPONSE_TRAILER
+
+#define IB_ALPARTS_REQUEST \
+    IB_ALPART_HTTP_REQUEST_METADATA|IB_ALPART_HTTP_REQUEST_HEADER |\
+    IB_ALPART_HTTP_REQUEST_BODY|IB_ALPART_HTTP_REQUEST_TRAILER
+
+#define IB_ALPARTS_RESPONSE \
+    IB_ALPART_HTTP_RESPONSE_METADATA|IB_ALPART_HTTP_RESPONSE_HEADER | \
+    IB_ALPART_HTTP_RESPONSE_BODY|IB_ALPART_HTTP_RESPONSE_TRAILER
+
 typedef struct {
     const char      *name;          /**< Flag name */
     const char      *tx_name;       /**< Name in the TX "FLAGS" collection */
@@ -48,6 +87,25 @@ typedef struct {
     ib_context_t         *cur_ctx;        /**< Current context */
     ib_site_t            *cur_site;       /**< Current site */
     ib_site_location_t   *cur_location;   /**< Current location */
+
+    /* Host indexes over selector_list, built at finalize. They prune
+     * the selectors examined per selection; each is a hostname keyed
+     * collection of ordered ib_list_t of core_site_selector_t. */
+    ib_hash_t            *selector_exact_hosts;  /**< Exact hostnames */
+    ib_hash_t            *selector_suffix_hosts; /**< ".suffix" wildcards */
+    ib_list_t            *selector_other_hosts;  /**< Other wildcards, none */
+
+    /* Selection-time counters. */
+    uint64_t              selections;          /**< Selections performed */
+    uint64_t              selectors_examined;  /**< Selectors examined */
+
+    /**
+     * Asynchronous audit log writer pool, or NULL.
+     *
+     * Created lazily on the first asynchronous audit log write so the
+     * threads belong to the worker process, not a pre-fork master.
+     */
+    struct core_audit_writer_t *audit_writer;
 } ib_core_module_data_t;
 
 /** Core module transaction data */
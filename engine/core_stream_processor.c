@@ -25,6 +25,12 @@
 
 #include "core_stream_processor_private.h"
 
+#include "core_private.h"
+#include "engine_private.h"
+#include "rule_engine_private.h"
+
+#include <ironbee/flags.h>
+#include <ironbee/metrics.h>
 #include <ironbee/stream_io.h>
 #include <ironbee/stream_processor.h>
 #include <ironbee/stream_pump.h>
@@ -34,11 +40,31 @@
 #include <ironbee/mm_mpool_lite.h>
 
 #include <assert.h>
+#include <string.h>
+#include <sys/mman.h>
 
 static const char *CORE_PROCESSOR_NAME_REQ = "req_raw";
 static const char *CORE_PROCESSOR_NAME_RESP = "resp_raw";
 static const char *CORE_PROCESSOR_TYPE = "raw";
 
+/*! Minimum mapping size of one spill slab. */
+static const size_t SPILL_SLAB_SIZE = 256 * 1024;
+
+/**
+ * One mmap'd slab of spilled body data.
+ *
+ * The payload directly follows this header. Pages are anonymous and
+ * faulted in only as they are written, and every slab is unmapped -
+ * returned to the operating system at once, not to the heap - when the
+ * transaction is destroyed.
+ */
+struct spill_slab_t {
+    struct spill_slab_t *next; /**< Previously filled slab. */
+    size_t               size; /**< Mapping size, header included. */
+    size_t               used; /**< Payload bytes consumed. */
+};
+typedef struct spill_slab_t spill_slab_t;
+
 /**
  * The configuration data for a filter.
  */
@@ -47,9 +73,110 @@ struct inst_t {
     ib_stream_t   *stream;  /**< The stream to append data to. */
     size_t         limit;   /**< The limit of the tx to write to stream. */
     bool           is_request; /**< Is this request or response time? */
+    bool           decided;    /**< Has @ref buffer been computed? */
+    bool           buffer;     /**< Buffer data into @ref stream? */
+
+    /*! Buffered bytes kept in pump buffers before spilling. <0 = off. */
+    ssize_t        spill_threshold;
+    spill_slab_t  *slabs;   /**< Spill slabs, most recent first. */
+    size_t         spilled; /**< Total bytes spilled by this stream. */
 };
 typedef struct inst_t inst_t;
 
+/**
+ * Transaction cleanup handler unmapping all of an instance's slabs.
+ *
+ * @param[in] cbdata The @ref inst_t.
+ */
+static void spill_cleanup(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    inst_t       *inst = (inst_t *)cbdata;
+    spill_slab_t *slab = inst->slabs;
+
+    while (slab != NULL) {
+        spill_slab_t *next = slab->next;
+        munmap(slab, slab->size);
+        slab = next;
+    }
+
+    inst->slabs = NULL;
+}
+
+/**
+ * Copy @a len bytes at @a ptr into the instance's spill slabs.
+ *
+ * A new slab is mapped when the current one cannot hold @a len, sized
+ * at least @ref SPILL_SLAB_SIZE so small segments share pages.
+ *
+ * @param[in] inst The processor instance.
+ * @param[in] ptr The bytes to copy.
+ * @param[in] len The number of bytes at @a ptr.
+ *
+ * @returns The address of the copy or NULL if mapping a slab failed.
+ */
+static uint8_t *spill_write(
+    inst_t        *inst,
+    const uint8_t *ptr,
+    size_t         len
+)
+{
+    assert(inst != NULL);
+    assert(ptr != NULL);
+
+    spill_slab_t *slab = inst->slabs;
+    uint8_t      *dst;
+
+    if (slab == NULL || slab->size - sizeof(*slab) - slab->used < len) {
+        size_t size = sizeof(*slab) + len;
+
+        if (size < SPILL_SLAB_SIZE) {
+            size = SPILL_SLAB_SIZE;
+        }
+
+        slab = mmap(
+            NULL,
+            size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1,
+            0);
+        if (slab == MAP_FAILED) {
+            return NULL;
+        }
+
+        slab->size  = size;
+        slab->used  = 0;
+        slab->next  = inst->slabs;
+        inst->slabs = slab;
+    }
+
+    dst = ((uint8_t *)(slab + 1)) + slab->used;
+    memcpy(dst, ptr, len);
+    slab->used    += len;
+    inst->spilled += len;
+
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "core.body.spill.bytes", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, len);
+    }
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "core.body.spill.high", IB_METRIC_GAUGE_MAX);
+        }
+        ib_metric_max(metric, inst->spilled);
+    }
+
+    return dst;
+}
+
 /**
  * Common constructor code for a core filter intance.
  *
@@ -88,20 +215,45 @@ static ib_status_t processor_create_common_fn(
         return rc;
     }
 
-    /* Here is the difference between a request and response processor. */
+    /* Here is the difference between a request and response processor.
+     * Buffer limits may be overridden at runtime through
+     * ib_engine_tune_set(); the override is read once per transaction,
+     * here. */
     if (is_request) {
         inst->stream = tx->request_body;
-        inst->limit  = inst->corecfg->limits.request_body_log_limit;
+        inst->limit  = (tx->ib->tune.request_body_log_limit >= 0)
+            ? (size_t)tx->ib->tune.request_body_log_limit
+            : (size_t)inst->corecfg->limits.request_body_log_limit;
     }
     else {
         inst->stream = tx->response_body;
-        inst->limit  = inst->corecfg->limits.response_body_log_limit;
+        inst->limit  = (tx->ib->tune.response_body_log_limit >= 0)
+            ? (size_t)tx->ib->tune.response_body_log_limit
+            : (size_t)inst->corecfg->limits.response_body_log_limit;
     }
 
     /* For traceability, record what type of processor we are, internally.
      * You can also strcmp() the name of the processor, but that's expensive. */
     inst->is_request = is_request;
 
+    /* Whether to buffer at all is decided lazily, on the first data
+     * segment, when the final context and audit settings are known. */
+    inst->decided = false;
+    inst->buffer  = true;
+
+    /* Spill state. Bytes buffered past the threshold are copied to
+     * mmap'd slabs so pump buffers are not pinned for the life of the
+     * transaction. */
+    inst->spill_threshold = inst->corecfg->limits.body_buffer_spill_threshold;
+    inst->slabs           = NULL;
+    inst->spilled         = 0;
+    if (inst->spill_threshold >= 0) {
+        rc = ib_mm_register_cleanup(mm, spill_cleanup, inst);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
     /* Hand back the configuration data. */
     *inst_data = inst;
     return IB_OK;
@@ -162,10 +314,12 @@ static ib_status_t processor_create_resp_fn(
  * @param[in] ptr_len Length of the data at @a ptr.
  * @param[in] type The type of @a data. Must be IB_STREAM_IO_DATA or
  *            this does nothing.
- * @param[in] limit The limit of the data to capture.
- * @param[in] stream The stream object to buffer the data into.
- *            Data is aliased by stream's api, so we must increase
- *            the reference count of @a data if we bufffer.
+ * @param[in] inst The processor instance holding the limit, the stream
+ *            to buffer into and the spill state. Small bodies are
+ *            buffered by reference - the stream aliases the data, so
+ *            the reference count of @a data is increased - while bytes
+ *            past the spill threshold are copied into mmap'd slabs so
+ *            the pump's buffers stay reusable.
  *
  * @returns
  * - IB_OK On success.
@@ -178,11 +332,13 @@ static ib_status_t apply_buffering_to_limit(
     uint8_t                    *ptr,
     size_t                      ptr_len,
     ib_stream_io_type_t         type,
-    const size_t                limit,
-    ib_stream_t                *stream
+    inst_t                     *inst
 )
 {
-    ib_status_t rc;
+    ib_status_t  rc;
+    ib_stream_t *stream = inst->stream;
+    const size_t limit  = inst->limit;
+    size_t       write_len;
 
     /* If we are handed empty or non-data data (FLUSH data), return OK. */
     if (ptr == NULL || ptr_len == 0 || type != IB_STREAM_IO_DATA) {
@@ -199,27 +355,96 @@ static ib_status_t apply_buffering_to_limit(
             ptr_len);
         return IB_OK;
     }
-    else {
-        /* Check remaining space, adding only what will fit. */
-        const size_t remaining = limit - stream->slen;
 
-        /* "Say we want a copy of this data forever. */
-        ib_stream_io_data_ref(io_tx, data);
+    /* Check remaining space, adding only what will fit. */
+    write_len = limit - stream->slen;
+    if (write_len > ptr_len) {
+        write_len = ptr_len;
+    }
 
-        rc = ib_stream_push(
-            stream,
-            IB_STREAM_DATA,
-            ptr,
-            (remaining >= ptr_len)?ptr_len : remaining);
-        if (rc != IB_OK) {
-            ib_log_alert_tx(tx, "Failed to add stream data to tx buffer.");
-            return rc;
+    /* Past the spill threshold, copy into slabs instead of pinning the
+     * pump buffer for the rest of the transaction. */
+    if (
+        inst->spill_threshold >= 0 &&
+        stream->slen + write_len > (size_t)inst->spill_threshold
+    )
+    {
+        uint8_t *copy = spill_write(inst, ptr, write_len);
+        if (copy != NULL) {
+            rc = ib_stream_push(stream, IB_STREAM_DATA, copy, write_len);
+            if (rc != IB_OK) {
+                ib_log_alert_tx(tx, "Failed to add stream data to tx buffer.");
+                return rc;
+            }
+            return IB_OK;
         }
+        /* Out of mappings. Fall back to referencing the pump buffer. */
+        ib_log_warning_tx(tx, "Failed to map body spill slab.");
+    }
+
+    /* "Say we want a copy of this data forever. */
+    ib_stream_io_data_ref(io_tx, data);
+
+    rc = ib_stream_push(stream, IB_STREAM_DATA, ptr, write_len);
+    if (rc != IB_OK) {
+        ib_log_alert_tx(tx, "Failed to add stream data to tx buffer.");
+        return rc;
     }
 
     return IB_OK;
 }
 
+/**
+ * Does any consumer of the buffered response body exist for @a tx?
+ *
+ * The buffered stream feeds the response-body audit log part and the
+ * non-streaming response phases.  When the audit log omits the response
+ * body and the transaction's context has no rules (and no injection
+ * callbacks) in those phases, buffering is pure overhead and the
+ * processor can stream the response through untouched, improving
+ * time-to-first-byte on large responses.
+ *
+ * Streaming phases (IB_PHASE_RESPONSE_*_STREAM) see data as it passes
+ * and do not depend on this buffer.
+ *
+ * @param[in] tx The transaction.
+ *
+ * @returns True if the response body must be buffered.
+ */
+static bool response_buffering_required(ib_tx_t *tx)
+{
+    static const ib_rule_phase_num_t phases[] = {
+        IB_PHASE_RESPONSE,
+        IB_PHASE_RESPONSE_PROCESS,
+        IB_PHASE_POSTPROCESS
+    };
+
+    if (ib_flags_all(tx->auditlog_parts, IB_ALPART_HTTP_RESPONSE_BODY)) {
+        return true;
+    }
+
+    for (size_t i = 0; i < sizeof(phases)/sizeof(phases[0]); ++i) {
+        const ib_ruleset_phase_t *ruleset_phase =
+            &(tx->ctx->rules->ruleset.phases[phases[i]]);
+        if (
+            ruleset_phase->rule_list != NULL &&
+            ib_list_elements(ruleset_phase->rule_list) > 0
+        )
+        {
+            return true;
+        }
+        if (
+            tx->ib->rule_engine->injection_cbs[phases[i]] != NULL &&
+            ib_list_elements(tx->ib->rule_engine->injection_cbs[phases[i]]) > 0
+        )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * The processor's implementation.
  *
@@ -253,6 +478,14 @@ static ib_status_t processor_exec_fn(
     assert(inst->corecfg != NULL);
     assert(inst->stream != NULL);
 
+    /* Decide, once per tx, whether anything consumes the buffer. */
+    if (! inst->decided) {
+        if (! inst->is_request) {
+            inst->buffer = response_buffering_required(tx);
+        }
+        inst->decided = true;
+    }
+
     /* For all inputs... */
     while (ib_stream_io_data_depth(io_tx) > 0) {
 
@@ -269,19 +502,20 @@ static ib_status_t processor_exec_fn(
         }
 
         /* Buffer data into tx. */
-        rc = apply_buffering_to_limit(
-            tx,
-            io_tx,
-            data,
-            ptr,
-            len,
-            type,
-            inst->limit,
-            inst->stream
-        );
-        /* On error, pass the error back. */
-        if (rc != IB_OK) {
-            return rc;
+        if (inst->buffer) {
+            rc = apply_buffering_to_limit(
+                tx,
+                io_tx,
+                data,
+                ptr,
+                len,
+                type,
+                inst
+            );
+            /* On error, pass the error back. */
+            if (rc != IB_OK) {
+                return rc;
+            }
         }
 
         /* Forward the data to the output. */
@@ -352,6 +586,22 @@ ib_status_t ib_core_stream_processor_init(
         goto cleanup;
     }
 
+    /* Both processors buffer and forward; they never alter data. */
+    rc = ib_stream_processor_registry_observe_only_set(
+        ib_engine_stream_processor_registry(ib),
+        CORE_PROCESSOR_NAME_REQ,
+        true);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    rc = ib_stream_processor_registry_observe_only_set(
+        ib_engine_stream_processor_registry(ib),
+        CORE_PROCESSOR_NAME_RESP,
+        true);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
 cleanup:
     ib_mpool_lite_destroy(mpl);
     return rc;
@@ -45,6 +45,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <math.h>
+#include <string.h>
 
 /**
  * Function adapter for many string functions.
@@ -211,6 +212,220 @@ static ib_status_t adapt_whitespace_compress(
     return rc;
 }
 
+/*
+ * Byte-level kernels for the fusible transformations below.
+ *
+ * Each mirrors the corresponding execute function but transforms a caller
+ * owned buffer in place, never growing it, so that the rule engine can run
+ * a chain of them over one buffer in a single pass.  See
+ * ib_transformation_set_byte_fn().
+ */
+
+/** In-place kernel matching tfn_lowercase(). */
+static ib_status_t byte_lower(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    for (size_t i = 0; i < dlen_in; ++i) {
+        data[i] = tolower(data[i]);
+    }
+    *dlen_out = dlen_in;
+
+    return IB_OK;
+}
+
+/** In-place kernel matching tfn_trim_left(). */
+static ib_status_t byte_trim_left(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    size_t i = 0;
+
+    while (i < dlen_in && isspace(data[i])) {
+        ++i;
+    }
+    if (i > 0) {
+        memmove(data, data + i, dlen_in - i);
+    }
+    *dlen_out = dlen_in - i;
+
+    return IB_OK;
+}
+
+/** In-place kernel matching tfn_trim_right(). */
+static ib_status_t byte_trim_right(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    while (dlen_in > 0 && isspace(data[dlen_in - 1])) {
+        --dlen_in;
+    }
+    *dlen_out = dlen_in;
+
+    return IB_OK;
+}
+
+/** In-place kernel matching tfn_trim(). */
+static ib_status_t byte_trim_lr(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    ib_status_t rc;
+
+    rc = byte_trim_right(data, dlen_in, &dlen_in, instdata, fndata);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return byte_trim_left(data, dlen_in, dlen_out, instdata, fndata);
+}
+
+/** In-place kernel matching tfn_wspc_remove(). */
+static ib_status_t byte_whitespace_remove(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    size_t out = 0;
+
+    for (size_t i = 0; i < dlen_in; ++i) {
+        uint8_t c = data[i];
+        if (! isspace(c)) {
+            data[out] = c;
+            ++out;
+        }
+    }
+    *dlen_out = out;
+
+    return IB_OK;
+}
+
+/** In-place kernel matching tfn_wspc_compress(). */
+static ib_status_t byte_whitespace_compress(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    size_t out = 0;
+    bool   last_char_is_space = false;
+
+    for (size_t i = 0; i < dlen_in; ++i) {
+        uint8_t c = data[i];
+        if (! isspace(c) || ! last_char_is_space) {
+            data[out] = c;
+            ++out;
+        }
+
+        last_char_is_space = isspace(c);
+    }
+    *dlen_out = out;
+
+    return IB_OK;
+}
+
+/** In-place kernel matching tfn_url_decode(). */
+static ib_status_t byte_url_decode(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    /* ib_util_decode_url() supports decoding in place; the output never
+     * outruns the input. */
+    return ib_util_decode_url(data, dlen_in, data, dlen_out);
+}
+
+/** In-place kernel matching tfn_html_entity_decode(). */
+static ib_status_t byte_html_entity_decode(
+    uint8_t *data, size_t dlen_in, size_t *dlen_out,
+    void *instdata, void *fndata
+)
+{
+    /* As with URL decoding, entity decoding only shrinks and is safe in
+     * place. */
+    return ib_util_decode_html_entity(data, dlen_in, data, dlen_out);
+}
+
+/** Streaming state constructor for urlDecode. */
+static ib_status_t stream_url_decode_create(
+    void **state, ib_mm_t mm, void *instdata, void *fndata
+)
+{
+    /* ib_util_decode_url_stream() wants zeroed state. */
+    *state = ib_mm_calloc(mm, 1, sizeof(ib_decode_url_state_t));
+    if (*state == NULL) {
+        return IB_EALLOC;
+    }
+    return IB_OK;
+}
+
+/** Streaming kernel matching tfn_url_decode(). */
+static ib_status_t stream_url_decode(
+    void *state, ib_mm_t mm,
+    const uint8_t *data_in, size_t dlen_in,
+    const uint8_t **data_out, size_t *dlen_out,
+    bool final,
+    void *instdata, void *fndata
+)
+{
+    uint8_t *buf;
+
+    /* Room for the chunk plus a flushed, partial escape. */
+    buf = ib_mm_alloc(mm, dlen_in + 2);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    *data_out = buf;
+    return ib_util_decode_url_stream(
+        (ib_decode_url_state_t *)state,
+        data_in, dlen_in,
+        buf, dlen_out,
+        final
+    );
+}
+
+/** Streaming state constructor for htmlEntityDecode. */
+static ib_status_t stream_html_entity_decode_create(
+    void **state, ib_mm_t mm, void *instdata, void *fndata
+)
+{
+    *state = ib_mm_calloc(mm, 1, sizeof(ib_decode_html_entity_state_t));
+    if (*state == NULL) {
+        return IB_EALLOC;
+    }
+    return IB_OK;
+}
+
+/** Streaming kernel matching tfn_html_entity_decode(). */
+static ib_status_t stream_html_entity_decode(
+    void *state, ib_mm_t mm,
+    const uint8_t *data_in, size_t dlen_in,
+    const uint8_t **data_out, size_t *dlen_out,
+    bool final,
+    void *instdata, void *fndata
+)
+{
+    uint8_t *buf;
+
+    /* Room for the chunk plus a flushed, partial entity candidate. */
+    buf = ib_mm_alloc(mm, dlen_in + IB_DECODE_HTML_ENTITY_CARRY);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    *data_out = buf;
+    return ib_util_decode_html_entity_stream(
+        (ib_decode_html_entity_state_t *)state,
+        data_in, dlen_in,
+        buf, dlen_out,
+        final
+    );
+}
+
 /**
  * Simple ASCII lowercase function.
  *
@@ -1595,11 +1810,60 @@ static ib_status_t tfn_first(
     return rc;
 }
 
+/**
+ * Create and register a fusible transformation.
+ *
+ * Like ib_transformation_create_and_register() for a simple non-list
+ * transformation, but additionally attaches the byte-level kernel that
+ * lets the rule engine fuse it with adjacent fusible transformations.
+ *
+ * @param[in] ib         IronBee engine.
+ * @param[in] name       Name.
+ * @param[in] execute_fn Execute function.
+ * @param[in] byte_fn    Byte-level kernel.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on memory allocation errors.
+ * - IB_EINVAL if a transformation with same name exists.
+ */
+static ib_status_t register_fusible_tfn(
+    ib_engine_t                    *ib,
+    const char                     *name,
+    ib_transformation_execute_fn_t  execute_fn,
+    ib_transformation_byte_fn_t     byte_fn
+)
+{
+    ib_transformation_t *tfn;
+    ib_status_t rc;
+
+    rc = ib_transformation_create(
+        &tfn,
+        ib_engine_mm_main_get(ib),
+        name,
+        false,
+        NULL, NULL,
+        NULL, NULL,
+        execute_fn, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_transformation_set_byte_fn(tfn, byte_fn, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_transformation_register(ib, tfn);
+}
+
 /**
  * Initialize the core transformations
  **/
 ib_status_t ib_core_transformations_init(ib_engine_t *ib, ib_module_t *mod)
 {
+    ib_transformation_t *tfn;
     ib_status_t rc;
 
     /* First and Last list transformations. */
@@ -1629,80 +1893,37 @@ ib_status_t ib_core_transformations_init(ib_engine_t *ib, ib_module_t *mod)
         return rc;
     }
 
-    /* Define transformations. */
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "lowercase",
-        false,
-        NULL,          NULL,
-        NULL,          NULL,
-        tfn_lowercase, NULL
-    );
+    /* Define transformations.  Byte-level transformations also register
+     * their in-place kernel so that chains of them fuse into one pass. */
+    rc = register_fusible_tfn(ib, "lowercase", tfn_lowercase, byte_lower);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "trimLeft",
-        false,
-        NULL, NULL,
-        NULL, NULL,
-        tfn_trim_left, NULL
-    );
+    rc = register_fusible_tfn(ib, "trimLeft", tfn_trim_left, byte_trim_left);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "trimRight",
-        false,
-        NULL, NULL,
-        NULL, NULL,
-        tfn_trim_right, NULL
-    );
+    rc = register_fusible_tfn(ib, "trimRight", tfn_trim_right, byte_trim_right);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "trim",
-        false,
-        NULL, NULL,
-        NULL, NULL,
-        tfn_trim, NULL
-    );
+    rc = register_fusible_tfn(ib, "trim", tfn_trim, byte_trim_lr);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "removeWhitespace",
-        false,
-        NULL, NULL,
-        NULL, NULL,
-        tfn_wspc_remove, NULL
+    rc = register_fusible_tfn(
+        ib, "removeWhitespace", tfn_wspc_remove, byte_whitespace_remove
     );
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
-        "compressWhitespace",
-        false,
-        NULL, NULL,
-        NULL, NULL,
-        tfn_wspc_compress, NULL
+    rc = register_fusible_tfn(
+        ib, "compressWhitespace", tfn_wspc_compress, byte_whitespace_compress
     );
     if (rc != IB_OK) {
         return rc;
@@ -1760,9 +1981,11 @@ ib_status_t ib_core_transformations_init(ib_engine_t *ib, ib_module_t *mod)
         return rc;
     }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
+    /* The decoders additionally register streaming kernels so that they
+     * can run chunk-at-a-time with carry-over state. */
+    rc = ib_transformation_create(
+        &tfn,
+        ib_engine_mm_main_get(ib),
         "urlDecode",
         false,
         NULL, NULL,
@@ -1772,10 +1995,24 @@ ib_status_t ib_core_transformations_init(ib_engine_t *ib, ib_module_t *mod)
     if (rc != IB_OK) {
         return rc;
     }
+    rc = ib_transformation_set_byte_fn(tfn, byte_url_decode, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_transformation_set_stream_fns(
+        tfn, stream_url_decode_create, stream_url_decode, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_transformation_register(ib, tfn);
+    if (rc != IB_OK) {
+        return rc;
+    }
 
-    rc = ib_transformation_create_and_register(
-        NULL,
-        ib,
+    rc = ib_transformation_create(
+        &tfn,
+        ib_engine_mm_main_get(ib),
         "htmlEntityDecode",
         false,
         NULL, NULL,
@@ -1785,6 +2022,20 @@ ib_status_t ib_core_transformations_init(ib_engine_t *ib, ib_module_t *mod)
     if (rc != IB_OK) {
         return rc;
     }
+    rc = ib_transformation_set_byte_fn(tfn, byte_html_entity_decode, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_transformation_set_stream_fns(
+        tfn, stream_html_entity_decode_create, stream_html_entity_decode, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_transformation_register(ib, tfn);
+    if (rc != IB_OK) {
+        return rc;
+    }
 
     rc = ib_transformation_create_and_register(
         NULL,
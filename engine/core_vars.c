@@ -168,14 +168,54 @@ static ib_tx_flag_map_t core_tx_flag_map[] = {
     { NULL, NULL, IB_TX_FNONE, true, false, NULL },
 };
 
+/** Maximum number of pairs a @ref core_gen_batch_t can hold. */
+#define CORE_GEN_BATCH_MAX 8
+
+/**
+ * Source and field pairs accumulated for a single bulk var store set.
+ *
+ * Filled by core_gen_tx_bytestr_alias() and friends and applied with
+ * ib_var_source_set_many() by core_gen_batch_apply().
+ */
+struct core_gen_batch_t {
+    /*! Pairs accumulated so far. */
+    ib_var_source_set_pair_t pairs[CORE_GEN_BATCH_MAX];
+    size_t                   num; /**< Number of valid pairs. */
+};
+typedef struct core_gen_batch_t core_gen_batch_t;
+
+static void core_gen_batch_apply(ib_tx_t *tx, core_gen_batch_t *batch)
+{
+    assert(tx != NULL);
+    assert(batch != NULL);
+
+    ib_status_t rc;
+
+    if (batch->num == 0) {
+        return;
+    }
+
+    rc = ib_var_source_set_many(tx->var_store, batch->pairs, batch->num);
+    if (rc != IB_OK) {
+        ib_log_notice_tx(tx,
+            "Error adding vars to transaction: %s",
+            ib_status_to_string(rc)
+        );
+    }
+    batch->num = 0;
+}
+
 static void core_gen_tx_bytestr_alias(ib_tx_t *tx,
                                       const char *name,
-                                      ib_bytestr_t *val)
+                                      ib_bytestr_t *val,
+                                      core_gen_batch_t *batch)
 {
 
     assert(tx != NULL);
     assert(name != NULL);
     assert(val != NULL);
+    assert(batch != NULL);
+    assert(batch->num < CORE_GEN_BATCH_MAX);
 
     ib_field_t *f;
     ib_var_source_t *source;
@@ -206,24 +246,22 @@ static void core_gen_tx_bytestr_alias(ib_tx_t *tx,
         return;
     }
 
-    rc = ib_var_source_set(source, tx->var_store, f);
-    if (rc != IB_OK) {
-        ib_log_notice_tx(tx,
-            "Error adding \"%s\" var to transaction: %s",
-            name, ib_status_to_string(rc)
-        );
-    }
+    batch->pairs[batch->num].source = source;
+    batch->pairs[batch->num].field = f;
+    ++batch->num;
 }
 
 static void core_gen_tx_bytestr_alias2(
     ib_tx_t *tx,
     const char *name,
-    const char *val, size_t val_length
+    const char *val, size_t val_length,
+    core_gen_batch_t *batch
 )
 {
     assert(tx != NULL);
     assert(name != NULL);
     assert(val != NULL);
+    assert(batch != NULL);
 
     ib_status_t rc;
     ib_bytestr_t *bytestr;
@@ -240,15 +278,18 @@ static void core_gen_tx_bytestr_alias2(
         return;
     }
 
-    core_gen_tx_bytestr_alias(tx, name, bytestr);
+    core_gen_tx_bytestr_alias(tx, name, bytestr, batch);
 }
 
 static void core_gen_tx_numeric(ib_tx_t *tx,
                                 const char *name,
-                                ib_num_t val)
+                                ib_num_t val,
+                                core_gen_batch_t *batch)
 {
     assert(tx != NULL);
     assert(name != NULL);
+    assert(batch != NULL);
+    assert(batch->num < CORE_GEN_BATCH_MAX);
 
     ib_field_t *f;
     ib_num_t num = val;
@@ -277,13 +318,9 @@ static void core_gen_tx_numeric(ib_tx_t *tx,
         return;
     }
 
-    rc = ib_var_source_set(source, tx->var_store, f);
-    if (rc != IB_OK) {
-        ib_log_notice_tx(tx,
-            "Error adding \"%s\" var to transaction: %s",
-            name, ib_status_to_string(rc)
-        );
-    }
+    batch->pairs[batch->num].source = source;
+    batch->pairs[batch->num].field = f;
+    ++batch->num;
 }
 
 /* -- Hooks -- */
@@ -338,12 +375,17 @@ static ib_status_t core_gen_early_var_sources(ib_engine_t *ib,
     assert(state == tx_started_state);
 
     ib_conn_t *conn = tx->conn;
+    core_gen_batch_t batch = { { { NULL, NULL } }, 0 };
+
+    core_gen_tx_bytestr_alias2(
+        tx, "server_addr", IB_S2SL(conn->local_ipstr), &batch);
+    core_gen_tx_numeric(tx, "server_port", conn->local_port, &batch);
+    core_gen_tx_bytestr_alias2(
+        tx, "remote_addr", IB_S2SL(conn->remote_ipstr), &batch);
+    core_gen_tx_numeric(tx, "remote_port", conn->remote_port, &batch);
+    core_gen_tx_numeric(tx, "conn_tx_count", tx->conn->tx_count, &batch);
 
-    core_gen_tx_bytestr_alias2(tx, "server_addr", IB_S2SL(conn->local_ipstr));
-    core_gen_tx_numeric(tx, "server_port", conn->local_port);
-    core_gen_tx_bytestr_alias2(tx, "remote_addr", IB_S2SL(conn->remote_ipstr));
-    core_gen_tx_numeric(tx, "remote_port", conn->remote_port);
-    core_gen_tx_numeric(tx, "conn_tx_count", tx->conn->tx_count);
+    core_gen_batch_apply(tx, &batch);
 
     return IB_OK;
 }
@@ -417,6 +459,10 @@ static ib_status_t create_header_alias_list(
     ib_status_t rc;
     ib_parsed_header_t *nvpair;
     ib_var_source_t *source;
+    ib_field_bytestr_descr_t *descrs;
+    ib_field_t **fields;
+    size_t count;
+    size_t i;
 
     assert(ib != NULL);
     assert(tx != NULL);
@@ -452,59 +498,46 @@ static ib_status_t create_header_alias_list(
         return rc;
     }
 
-    /* Loop through the list & alias everything */
-    for(nvpair = header->head;  nvpair != NULL;  nvpair = nvpair->next) {
-        assert(nvpair);
+    /* Count the headers, describe them, and alias them in one batch so
+     * all fields come from a single allocation. */
+    count = 0;
+    for (nvpair = header->head;  nvpair != NULL;  nvpair = nvpair->next) {
         assert(nvpair->value);
-        ib_bytestr_t *bs = NULL;
-        if (ib_bytestr_ptr(nvpair->value) != NULL) {
-            rc = ib_bytestr_alias_mem(
-                &bs,
-                tx->mm,
-                ib_bytestr_ptr(nvpair->value),
-                ib_bytestr_length(nvpair->value)
-            );
-        }
-        else {
-            rc = ib_bytestr_dup_mem(&bs, tx->mm, (const uint8_t *)"", 0);
-        }
-        if (rc != IB_OK) {
-            ib_log_error_tx(
-                tx,
-                "Error creating bytestring of '%.*s' for %s: %s",
-                (int)ib_bytestr_length(nvpair->name),
-                (const char *)ib_bytestr_ptr(nvpair->name),
-                name,
-                ib_status_to_string(rc)
-            );
-            return rc;
-        }
+        ++count;
+    }
+    if (count == 0) {
+        return IB_OK;
+    }
 
-        /* Create a byte string field */
-        rc = ib_field_create(
-            &f,
-            tx->mm,
-            (const char *)ib_bytestr_const_ptr(nvpair->name),
-            ib_bytestr_length(nvpair->name),
-            IB_FTYPE_BYTESTR,
-            ib_ftype_bytestr_in(bs)
-        );
-        if (rc != IB_OK) {
-            ib_log_error_tx(tx,
-                            "Error creating field of '%.*s' for %s: %s",
-                            (int)ib_bytestr_length(nvpair->name),
-                            (const char *)ib_bytestr_ptr(nvpair->name),
-                            name,
-                            ib_status_to_string(rc));
-            return rc;
-        }
+    descrs = ib_mm_alloc(tx->mm, count * sizeof(*descrs));
+    if (descrs == NULL) {
+        return IB_EALLOC;
+    }
+    i = 0;
+    for (nvpair = header->head;  nvpair != NULL;  nvpair = nvpair->next) {
+        descrs[i].name  = (const char *)ib_bytestr_const_ptr(nvpair->name);
+        descrs[i].nlen  = ib_bytestr_length(nvpair->name);
+        descrs[i].value = ib_bytestr_const_ptr(nvpair->value);
+        descrs[i].vlen  = ib_bytestr_length(nvpair->value);
+        ++i;
+    }
 
-        /* Add the field to the list */
-        rc = ib_list_push(header_list, f);
+    rc = ib_field_create_bytestr_alias_batch(&fields, tx->mm, descrs, count);
+    if (rc != IB_OK) {
+        ib_log_error_tx(tx,
+                        "Error creating header fields for %s: %s",
+                        name,
+                        ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* Add the fields to the list */
+    for (i = 0; i < count; ++i) {
+        rc = ib_list_push(header_list, fields[i]);
         if (rc != IB_OK) {
             ib_log_error_tx(tx, "Error adding alias of '%.*s' to %s list: %s",
-                            (int)ib_bytestr_length(nvpair->name),
-                            (const char *)ib_bytestr_ptr(nvpair->name),
+                            (int)fields[i]->nlen,
+                            fields[i]->name,
                             name,
                             ib_status_to_string(rc));
             return rc;
@@ -529,17 +562,21 @@ static ib_status_t core_gen_request_header_fields(ib_engine_t *ib,
     assert(tx != NULL);
 
     if (tx->request_line != NULL) {
+        core_gen_batch_t batch = { { { NULL, NULL } }, 0 };
+
         core_gen_tx_bytestr_alias(tx, "request_line",
-                                  tx->request_line->raw);
+                                  tx->request_line->raw, &batch);
 
         core_gen_tx_bytestr_alias(tx, "request_method",
-                                  tx->request_line->method);
+                                  tx->request_line->method, &batch);
 
         core_gen_tx_bytestr_alias(tx, "request_uri_raw",
-                                  tx->request_line->uri);
+                                  tx->request_line->uri, &batch);
 
         core_gen_tx_bytestr_alias(tx, "request_protocol",
-                                  tx->request_line->protocol);
+                                  tx->request_line->protocol, &batch);
+
+        core_gen_batch_apply(tx, &batch);
     }
 
     /* Populate the ARGS collection. */
@@ -656,17 +693,21 @@ static ib_status_t core_gen_response_header_fields(
     assert(tx != NULL);
 
     if (tx->response_line != NULL) {
+        core_gen_batch_t batch = { { { NULL, NULL } }, 0 };
+
         core_gen_tx_bytestr_alias(tx, "response_line",
-                                  tx->response_line->raw);
+                                  tx->response_line->raw, &batch);
 
         core_gen_tx_bytestr_alias(tx, "response_protocol",
-                                  tx->response_line->protocol);
+                                  tx->response_line->protocol, &batch);
 
         core_gen_tx_bytestr_alias(tx, "response_status",
-                                  tx->response_line->status);
+                                  tx->response_line->status, &batch);
 
         core_gen_tx_bytestr_alias(tx, "response_message",
-                                  tx->response_line->msg);
+                                  tx->response_line->msg, &batch);
+
+        core_gen_batch_apply(tx, &batch);
     }
 
     /* Create the aliased response header list */
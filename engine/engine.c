@@ -29,6 +29,7 @@
 #include <ironbee/engine.h>
 #include "engine_private.h"
 
+#include "core_audit_private.h"
 #include "core_private.h"
 #include "module_private.h"
 #include "rule_engine_private.h"
@@ -43,6 +44,8 @@
 #include <ironbee/flags.h>
 #include <ironbee/hash.h>
 #include <ironbee/ip.h>
+#include <ironbee/metrics.h>
+#include <ironbee/mm_budget.h>
 #include <ironbee/mm_mpool.h>
 #include <ironbee/module.h>
 #include <ironbee/server.h>
@@ -224,6 +227,9 @@ static ib_status_t ib_hook_register(
         return rc;
     }
 
+    /* Record that this state now has a subscriber. */
+    ib->hook_mask |= (uint64_t)1 << state;
+
     return IB_OK;
 }
 
@@ -347,6 +353,24 @@ uint32_t ib_engine_abi_number(void) {
     return IB_ABINUM;
 }
 
+/**
+ * Allocator hooks for engine configuration memory pools.
+ *
+ * NULL means the pool default (malloc()/free()).  These are process
+ * wide and must be set before any engine is created.
+ */
+static ib_mpool_malloc_fn_t config_malloc_fn = NULL;
+static ib_mpool_free_fn_t   config_free_fn   = NULL;
+
+void ib_engine_config_allocators_set(
+    ib_mpool_malloc_fn_t malloc_fn,
+    ib_mpool_free_fn_t   free_fn
+)
+{
+    config_malloc_fn = malloc_fn;
+    config_free_fn   = free_fn;
+}
+
 ib_status_t ib_engine_create(ib_engine_t **pib,
                              const ib_server_t *server)
 {
@@ -390,10 +414,15 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
         goto failed;
     }
 
-    /* Create the config memory pool */
-    rc = ib_mpool_create(&(ib->config_mp),
-                         "config",
-                         ib->mp);
+    /* Create the config memory pool.  Allocator hooks, if set, let a
+     * server build configuration into special backing memory such as
+     * a pre-fork shared mapping. */
+    rc = ib_mpool_create_ex(&(ib->config_mp),
+                            "config",
+                            ib->mp,
+                            0,
+                            config_malloc_fn,
+                            config_free_fn);
     if (rc != IB_OK) {
         goto failed;
     }
@@ -425,6 +454,11 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
     ib->ctx = ib->ectx;
     ib->cfg_state = CFG_NOT_STARTED;
 
+    /* No runtime overrides until ib_engine_tune_set() is called. */
+    ib->tune.rule_dlog_level         = -1;
+    ib->tune.request_body_log_limit  = -1;
+    ib->tune.response_body_log_limit = -1;
+
     /* Check server for ABI compatibility with this engine */
     if (server == NULL) {
         ib_log_error(ib,  "Error creating engine: server info required");
@@ -485,12 +519,24 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
         goto failed;
     }
 
+    /* Create a hash to hold shared operator instances */
+    rc = ib_hash_create(&(ib->operator_inst_cache), mm);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
     /* Create a hash to hold actions by name */
     rc = ib_hash_create_nocase(&(ib->actions), mm);
     if (rc != IB_OK) {
         goto failed;
     }
 
+    /* Create a hash to hold runtime control commands by name */
+    rc = ib_hash_create_nocase(&(ib->ctlcmds), mm);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
     /* Create the stream processor registry. */
     rc = ib_stream_processor_registry_create(
         &ib->stream_processor_registry,
@@ -521,6 +567,12 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
         goto failed;
     }
 
+    /* Initialize prewarm callback list. */
+    rc = ib_list_create(&ib->prewarm_handlers, mm);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
     /* Initialize block pre-hooks list. */
     rc = ib_list_create(&(ib->block_pre_hooks), mm);
     if (rc != IB_OK) {
@@ -883,6 +935,13 @@ ib_status_t ib_engine_notify_logevent_register(
     assert(ib->logevent_handlers != NULL);
     assert(fn != NULL);
 
+    /* The handler list is walked without locking per logevent; it is
+     * frozen once configuration completes so that readers never race a
+     * mutation. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
     ib_status_t               rc;
     ib_mm_t                   mm = ib_engine_mm_main_get(ib);
     engine_notify_logevent_t *handler =
@@ -932,6 +991,75 @@ ib_status_t ib_engine_notify_logevent(
     return IB_OK;
 }
 
+struct engine_prewarm_t {
+    ib_engine_prewarm_fn_t  fn;
+    void                   *cbdata;
+};
+
+typedef struct engine_prewarm_t engine_prewarm_t;
+
+ib_status_t ib_engine_prewarm_register(
+    ib_engine_t            *ib,
+    ib_engine_prewarm_fn_t  fn,
+    void                   *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(ib->prewarm_handlers != NULL);
+    assert(fn != NULL);
+
+    /* Prewarming runs once, after configuration; a late registration
+     * would silently never be called. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
+    ib_status_t       rc;
+    ib_mm_t           mm = ib_engine_mm_main_get(ib);
+    engine_prewarm_t *handler =
+        (engine_prewarm_t *)ib_mm_alloc(mm, sizeof(*handler));
+
+    if (handler == NULL) {
+        return IB_EALLOC;
+    }
+
+    handler->fn     = fn;
+    handler->cbdata = cbdata;
+
+    rc = ib_list_push(ib->prewarm_handlers, handler);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_engine_prewarm(
+    ib_engine_t *ib,
+    size_t       concurrency
+)
+{
+    assert(ib != NULL);
+    assert(ib->cfg_state == CFG_FINISHED);
+    assert(ib->prewarm_handlers != NULL);
+
+    const ib_list_node_t *node;
+
+    IB_LIST_LOOP_CONST(ib->prewarm_handlers, node) {
+        ib_status_t rc;
+        const engine_prewarm_t *handler =
+            (const engine_prewarm_t *)ib_list_node_data_const(node);
+
+        rc = handler->fn(ib, concurrency, handler->cbdata);
+        if (rc != IB_OK) {
+            ib_log_error(
+                ib, "Error prewarming engine: %s", ib_status_to_string(rc));
+        }
+    }
+
+    return IB_OK;
+}
+
 void ib_engine_destroy(ib_engine_t *ib)
 {
     size_t ne;
@@ -998,6 +1126,138 @@ const char *ib_engine_instance_id(
     return ib->instance_id;
 }
 
+/**
+ * Map a tunable setting name to its override slot.
+ *
+ * @param[in] ib Engine.
+ * @param[in] name Setting name.
+ *
+ * @returns The slot, or NULL if @a name is not a tunable setting.
+ */
+static volatile ib_num_t *engine_tune_slot(
+    const ib_engine_t *ib,
+    const char        *name
+)
+{
+    /* Cast away constness of the engine; slots are written by
+     * ib_engine_tune_set() only. */
+    ib_engine_t *wib = (ib_engine_t *)ib;
+
+    if (strcasecmp(name, "rule_dlog_level") == 0) {
+        return &wib->tune.rule_dlog_level;
+    }
+    if (strcasecmp(name, "request_body_log_limit") == 0) {
+        return &wib->tune.request_body_log_limit;
+    }
+    if (strcasecmp(name, "response_body_log_limit") == 0) {
+        return &wib->tune.response_body_log_limit;
+    }
+    return NULL;
+}
+
+ib_status_t ib_engine_tune_set(ib_engine_t *ib,
+                               const char *name,
+                               ib_num_t value)
+{
+    assert(ib != NULL);
+    assert(name != NULL);
+
+    volatile ib_num_t *slot = engine_tune_slot(ib, name);
+
+    if (slot == NULL) {
+        return IB_ENOENT;
+    }
+
+    *slot = (value < 0) ? -1 : value;
+
+    return IB_OK;
+}
+
+ib_status_t ib_engine_tune_get(const ib_engine_t *ib,
+                               const char *name,
+                               ib_num_t *pvalue)
+{
+    assert(ib != NULL);
+    assert(name != NULL);
+    assert(pvalue != NULL);
+
+    const volatile ib_num_t *slot = engine_tune_slot(ib, name);
+
+    if (slot == NULL) {
+        return IB_ENOENT;
+    }
+
+    *pvalue = *slot;
+
+    return IB_OK;
+}
+
+/** Registered runtime control command. */
+typedef struct {
+    ib_engine_ctlcmd_fn_t  fn;     /**< Implementation. */
+    void                  *cbdata; /**< Callback data for @c fn. */
+} engine_ctlcmd_t;
+
+ib_status_t ib_engine_ctlcmd_register(
+    ib_engine_t           *ib,
+    const char            *name,
+    ib_engine_ctlcmd_fn_t  fn,
+    void                  *cbdata)
+{
+    assert(ib != NULL);
+    assert(name != NULL);
+    assert(fn != NULL);
+
+    ib_status_t rc;
+    ib_mm_t mm = ib_engine_mm_main_get(ib);
+    engine_ctlcmd_t *cmd;
+    char *name_copy;
+
+    rc = ib_hash_get(ib->ctlcmds, NULL, name);
+    if (rc == IB_OK) {
+        return IB_EINVAL;
+    }
+
+    cmd = ib_mm_alloc(mm, sizeof(*cmd));
+    if (cmd == NULL) {
+        return IB_EALLOC;
+    }
+    cmd->fn = fn;
+    cmd->cbdata = cbdata;
+
+    name_copy = ib_mm_strdup(mm, name);
+    if (name_copy == NULL) {
+        return IB_EALLOC;
+    }
+
+    return ib_hash_set(ib->ctlcmds, name_copy, cmd);
+}
+
+ib_status_t ib_engine_ctlcmd_run(
+    ib_engine_t *ib,
+    const char  *name,
+    const char  *args,
+    ib_mm_t      mm,
+    const char **result)
+{
+    assert(ib != NULL);
+    assert(name != NULL);
+    assert(args != NULL);
+    assert(result != NULL);
+
+    ib_status_t rc;
+    engine_ctlcmd_t *cmd;
+
+    *result = NULL;
+
+    rc = ib_hash_get(ib->ctlcmds, &cmd, name);
+    if (rc != IB_OK) {
+        return IB_ENOENT;
+    }
+
+    return cmd->fn(ib, mm, name, args, result, cmd->cbdata);
+}
+
 ib_status_t ib_conn_generate_id(ib_conn_t *conn)
 {
     return ib_uuid_create_v4(conn->id);
@@ -1029,8 +1289,8 @@ ib_status_t ib_conn_create(ib_engine_t *ib,
     }
 
     /* Mark time. */
-    ib_clock_gettimeofday(&(conn->tv_created));
-    conn->t.started = ib_clock_get_time();
+    conn->t.started = ib_clock_coarse_refresh();
+    ib_clock_coarse_gettimeofday(&(conn->tv_created));
 
     /* Name the connection pool */
     snprintf(namebuf, sizeof(namebuf), "conn[%p]", (void *)conn);
@@ -1155,9 +1415,21 @@ ib_status_t ib_tx_create(ib_tx_t **ptx,
     snprintf(namebuf, sizeof(namebuf), "tx[%p]", (void *)tx);
     ib_mpool_setname(pool, namebuf);
 
+    /* Budget all further tx allocations when a limit is configured.
+     * The tx struct itself and the budget are charged to the pool but
+     * not the budget, so a tiny limit still yields a usable tx. */
+    if (corecfg->tx_memory_limit > 0) {
+        rc = ib_mm_budget_create(
+            &tx->mm_budget, mm, (size_t)corecfg->tx_memory_limit);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        mm = ib_mm_budget_mm(tx->mm_budget);
+    }
+
     /* Mark time. */
-    ib_clock_gettimeofday(&tx->tv_created);
-    tx->t.started = ib_clock_get_time();
+    tx->t.started = ib_clock_coarse_refresh();
+    ib_clock_coarse_gettimeofday(&tx->tv_created);
 
     tx->ib = ib;
     tx->mp = pool;
@@ -1386,6 +1658,22 @@ void ib_tx_destroy(ib_tx_t *tx)
     ib_tx_t *curr;
     ib_tx_t *prev = NULL;
 
+    if (tx->mm_budget != NULL && ib_mm_budget_exceeded(tx->mm_budget)) {
+        ib_log_notice_tx(tx,
+                         "Transaction exceeded its memory budget: "
+                         "%zu of %zu bytes used.",
+                         ib_mm_budget_used(tx->mm_budget),
+                         ib_mm_budget_limit(tx->mm_budget));
+        {
+            static const ib_metric_t *metric = NULL;
+            if (metric == NULL) {
+                metric = ib_metric_acquire(
+                    "tx.budget.exceeded", IB_METRIC_COUNTER);
+            }
+            ib_metric_add(metric, 1);
+        }
+    }
+
     if (   ib_flags_all(tx->flags, IB_TX_FREQ_HAS_DATA)
         || ib_flags_all(tx->flags, IB_TX_FRES_HAS_DATA) )
     {
@@ -2309,6 +2597,209 @@ ib_status_t ib_context_open(ib_context_t *ctx)
     return IB_OK;
 }
 
+/*
+ * Note on parallelizing context close: sibling site/location contexts
+ * are logically independent, but closing them concurrently is not
+ * possible in the current architecture.  Contexts are closed inline as
+ * their configuration blocks end, ordered with the parser's context
+ * stack (see the ib_cfgparser_context_pop() below), close hooks carry
+ * no module identity that could declare thread-safety, and the rule
+ * engine's close handler mutates engine-wide state.  Those would all
+ * have to change before a close thread pool could be considered.
+ */
+/**
+ * True if @a ctx has rules or injection callbacks for @a phase.
+ *
+ * Injection callbacks are engine-wide; when one exists for a phase it
+ * counts for every context, keeping the answer conservative.
+ *
+ * @param[in] ctx The context.
+ * @param[in] phase The phase to check.
+ *
+ * @returns True if the phase can execute rules in @a ctx.
+ */
+static bool context_phase_has_rules(
+    const ib_context_t  *ctx,
+    ib_rule_phase_num_t  phase
+)
+{
+    const ib_ruleset_phase_t *ruleset_phase;
+
+    if (ctx->rules == NULL || ctx->ib->rule_engine == NULL) {
+        /* No rule data to consult. Assume consumers. */
+        return true;
+    }
+
+    ruleset_phase = &(ctx->rules->ruleset.phases[phase]);
+    if (
+        ruleset_phase->rule_list != NULL &&
+        ib_list_elements(ruleset_phase->rule_list) > 0
+    )
+    {
+        return true;
+    }
+
+    if (
+        ctx->ib->rule_engine->injection_cbs[phase] != NULL &&
+        ib_list_elements(ctx->ib->rule_engine->injection_cbs[phase]) > 0
+    )
+    {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * True if any phase in @a phases has rules in @a ctx.
+ *
+ * @param[in] ctx The context.
+ * @param[in] phases The phases to check.
+ * @param[in] num_phases The number of entries in @a phases.
+ *
+ * @returns True if any listed phase can execute rules.
+ */
+static bool context_phases_have_rules(
+    const ib_context_t        *ctx,
+    const ib_rule_phase_num_t *phases,
+    size_t                     num_phases
+)
+{
+    for (size_t i = 0; i < num_phases; ++i) {
+        if (context_phase_has_rules(ctx, phases[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Compute the IB_INSPECT_* profile of @a ctx.
+ *
+ * Called at context close, when the context's rule sets and audit
+ * configuration are final. Body flags follow the same phases the
+ * engine's own body buffering decision consults; header flags are
+ * broader because headers populate the var store that rules in every
+ * later phase may read.
+ *
+ * @param[in] ctx The context being closed.
+ */
+static void context_compute_inspection_profile(ib_context_t *ctx)
+{
+    static const ib_rule_phase_num_t req_body_phases[] = {
+        IB_PHASE_REQUEST,
+        IB_PHASE_REQUEST_PROCESS,
+        IB_PHASE_REQUEST_BODY_STREAM,
+        IB_PHASE_POSTPROCESS
+    };
+    static const ib_rule_phase_num_t resp_header_phases[] = {
+        IB_PHASE_RESPONSE_HEADER,
+        IB_PHASE_RESPONSE_HEADER_PROCESS,
+        IB_PHASE_RESPONSE_HEADER_STREAM,
+        IB_PHASE_RESPONSE,
+        IB_PHASE_RESPONSE_PROCESS,
+        IB_PHASE_RESPONSE_BODY_STREAM,
+        IB_PHASE_POSTPROCESS,
+        IB_PHASE_LOGGING
+    };
+    static const ib_rule_phase_num_t resp_body_phases[] = {
+        IB_PHASE_RESPONSE,
+        IB_PHASE_RESPONSE_PROCESS,
+        IB_PHASE_RESPONSE_BODY_STREAM,
+        IB_PHASE_POSTPROCESS
+    };
+
+    ib_core_cfg_t *corecfg;
+    ib_flags_t     profile = IB_INSPECT_NONE;
+    ib_num_t       parts;
+    bool           any_rules = false;
+    ib_status_t    rc;
+
+    rc = ib_core_context_config(ctx, &corecfg);
+    if (rc != IB_OK) {
+        /* Without configuration, err toward inspection. */
+        ctx->inspection_profile = IB_INSPECT_ALL;
+        return;
+    }
+    parts = corecfg->auditlog_parts;
+
+    for (
+        ib_rule_phase_num_t phase = IB_PHASE_NONE + 1;
+        phase < IB_RULE_PHASE_COUNT;
+        ++phase
+    )
+    {
+        if (context_phase_has_rules(ctx, phase)) {
+            any_rules = true;
+            break;
+        }
+    }
+
+    /* Request headers establish the transaction and its var store;
+     * a policy with any rules at all consumes them. */
+    if (
+        any_rules ||
+        ib_flags_any(
+            parts,
+            IB_ALPART_HEADER |
+            IB_ALPART_HTTP_REQUEST_METADATA |
+            IB_ALPART_HTTP_REQUEST_HEADER |
+            IB_ALPART_HTTP_REQUEST_TRAILER)
+    )
+    {
+        profile |= IB_INSPECT_REQUEST_HEADER;
+    }
+
+    if (
+        context_phases_have_rules(
+            ctx, req_body_phases,
+            sizeof(req_body_phases)/sizeof(req_body_phases[0])) ||
+        ib_flags_any(parts, IB_ALPART_HTTP_REQUEST_BODY)
+    )
+    {
+        profile |= IB_INSPECT_REQUEST_BODY;
+    }
+
+    if (
+        context_phases_have_rules(
+            ctx, resp_header_phases,
+            sizeof(resp_header_phases)/sizeof(resp_header_phases[0])) ||
+        ib_flags_any(
+            parts,
+            IB_ALPART_HTTP_RESPONSE_METADATA |
+            IB_ALPART_HTTP_RESPONSE_HEADER |
+            IB_ALPART_HTTP_RESPONSE_TRAILER)
+    )
+    {
+        profile |= IB_INSPECT_RESPONSE_HEADER;
+    }
+
+    if (
+        context_phases_have_rules(
+            ctx, resp_body_phases,
+            sizeof(resp_body_phases)/sizeof(resp_body_phases[0])) ||
+        ib_flags_any(parts, IB_ALPART_HTTP_RESPONSE_BODY)
+    )
+    {
+        profile |= IB_INSPECT_RESPONSE_BODY;
+    }
+
+    ctx->inspection_profile = profile;
+}
+
+ib_flags_t ib_context_inspection_profile(const ib_context_t *ctx)
+{
+    assert(ctx != NULL);
+
+    /* Before close the profile is unknown. Report full inspection. */
+    if (ctx->state != CTX_CLOSED) {
+        return IB_INSPECT_ALL;
+    }
+
+    return ctx->inspection_profile;
+}
+
 ib_status_t ib_context_close(ib_context_t *ctx)
 {
     ib_engine_t *ib = ctx->ib;
@@ -2323,6 +2814,8 @@ ib_status_t ib_context_close(ib_context_t *ctx)
         return rc;
     }
 
+    context_compute_inspection_profile(ctx);
+
     if (ctx->ctype != IB_CTYPE_ENGINE) {
         rc = ib_cfgparser_context_pop(ib->cfgparser, NULL, NULL);
         if (rc != IB_OK) {
@@ -2483,6 +2976,7 @@ ib_status_t ib_context_set_auditlog_index(ib_context_t *ctx,
 
         /* Close the audit log file if it is open. */
         if (ctx->auditlog->index_fp != NULL) {
+            core_audit_index_flush(ctx->auditlog);
             fclose(ctx->auditlog->index_fp);
             ctx->auditlog->index_fp = NULL;
         }
@@ -2677,6 +3171,19 @@ ib_status_t ib_context_module_config(const ib_context_t *ctx,
         return IB_EINVAL;
     }
 
+    /* Configuration-time callers may write through the returned pointer,
+     * so give the context its own copy of shared (copy-on-write) data
+     * first.  Once the context is closed its configuration is read-only
+     * and contexts that were never written keep sharing their parent's
+     * data. */
+    if (cfgdata->shared && ctx->state != CTX_CLOSED) {
+        rc = ib_module_config_unshare((ib_context_t *)ctx, cfgdata);
+        if (rc != IB_OK) {
+            *(void **)pcfg = NULL;
+            return rc;
+        }
+    }
+
     *(void **)pcfg = cfgdata->data;
 
     return IB_OK;
@@ -2715,6 +3222,14 @@ ib_status_t ib_context_get(ib_context_t *ctx,
     return rc;
 }
 
+ib_status_t ib_context_config_entry(ib_context_t *ctx,
+                                    const char *name,
+                                    ib_field_t **pfield)
+{
+    ib_status_t rc = ib_cfgmap_entry(ctx->cfg, name, pfield);
+    return rc;
+}
+
 /**
  * Set the given tx var flag to the given value (1 or 0).
  */
@@ -40,13 +40,17 @@
 #include <ironbee/release.h>
 #include <ironbee/server.h>
 #include <ironbee/state_notify.h>
+#include <ironbee/string.h>
 
 
 #include <assert.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 /* The manager's engine wrapper type */
@@ -118,6 +122,59 @@ struct ib_manager_t {
     ib_manager_module_create_fn_t  module_fn;
     void                          *module_data; /**< Callback data. */
 
+    /**
+     * Optional path of the configuration parse cache image.
+     *
+     * When set, engine creation loads the configuration from this
+     * image when it is current and rebuilds it after a full parse.
+     *
+     * @sa ib_manager_config_cache_set()
+     */
+    const char *config_cache_path;
+
+    /**
+     * Worker concurrency used to prewarm new engines.
+     *
+     * When non-zero, new engines run ib_engine_prewarm() with this
+     * value after configuration finishes.
+     *
+     * @sa ib_manager_prewarm_set()
+     */
+    size_t prewarm_concurrency;
+
+    /**
+     * Number of engine replicas created per name.
+     *
+     * When greater than one, each call to ib_manager_engine_create()
+     * creates this many engines from the same configuration and
+     * ib_manager_engine_acquire() pins each calling thread to one
+     * replica, keeping per-transaction mutable engine state local to
+     * that thread's cores.
+     *
+     * @sa ib_manager_replicas_set()
+     */
+    size_t replicas;
+
+    /**
+     * Is a standby engine build running in the background?
+     *
+     * This, ib_manager_t::build_name, ib_manager_t::build_rc and
+     * ib_manager_t::build_started are guarded by
+     * ib_manager_t::manager_lck.  ib_manager_t::build_phase is written
+     * only by the builder thread and only ever points at string
+     * constants, so it may be read without the lock; it is
+     * informational only.
+     *
+     * @sa ib_manager_engine_create_background()
+     */
+    bool         build_active;
+    const char  *build_name;    /**< Name of the running or last build. */
+    ib_status_t  build_rc;      /**< Result of the last finished build. */
+    ib_time_t    build_started; /**< When the running build started. */
+
+    //! The stage the running build is in. See ib_manager_t::build_active.
+    const char * volatile build_phase;
+
     //! A list of @ref manager_engine_preconfig_t.
     ib_list_t *preconfig_functions;
 
@@ -375,6 +432,7 @@ ib_status_t ib_manager_create(
     manager->module_fn   = NULL;
     manager->module_data = NULL;
     manager->enabled     = true;
+    manager->replicas    = 1;
 
     /* Hand the new manager off to the caller. */
     *pmanager = manager;
@@ -404,6 +462,60 @@ ib_status_t ib_manager_register_module_fn(
     return IB_OK;
 }
 
+ib_status_t ib_manager_config_cache_set(
+    ib_manager_t *manager,
+    const char   *path
+)
+{
+    assert(manager != NULL);
+
+    if (path == NULL) {
+        manager->config_cache_path = NULL;
+        return IB_OK;
+    }
+
+    manager->config_cache_path = ib_mm_strdup(manager->mm, path);
+    if (manager->config_cache_path == NULL) {
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_manager_prewarm_set(
+    ib_manager_t *manager,
+    size_t        concurrency
+)
+{
+    assert(manager != NULL);
+
+    manager->prewarm_concurrency = concurrency;
+
+    return IB_OK;
+}
+
+ib_status_t ib_manager_replicas_set(
+    ib_manager_t *manager,
+    size_t        replicas
+)
+{
+    assert(manager != NULL);
+
+    if (replicas == 0) {
+        return IB_EINVAL;
+    }
+
+    /* Every create needs slots for all replicas plus, during a reload,
+     * the replicas they replace. */
+    if (replicas * 2 > manager->max_engines) {
+        return IB_EINVAL;
+    }
+
+    manager->replicas = replicas;
+
+    return IB_OK;
+}
+
 void ib_manager_destroy(
     ib_manager_t *manager
 )
@@ -441,6 +553,49 @@ void ib_manager_destroy(
  * @param[in] engine Engine wrapper object.
  *
  */
+/** Next replica slot to hand out to a thread on its first acquire. */
+static size_t g_next_replica_slot = 0;
+
+/** The calling thread's replica slot; SIZE_MAX until assigned. */
+static __thread size_t t_replica_slot = (size_t)-1;
+
+/**
+ * Build the registration name of replica @a replica of @a name.
+ *
+ * Replica 0 uses @a name itself so single-replica operation and
+ * lookups by external tools are unchanged.
+ *
+ * @param[in] mm Memory manager to allocate the name from.
+ * @param[in] name Base engine name.
+ * @param[in] replica Replica index.
+ *
+ * @returns The name or NULL on allocation failure.
+ */
+static const char *replica_engine_name(
+    ib_mm_t     mm,
+    const char *name,
+    size_t      replica
+)
+{
+    assert(name != NULL);
+
+    char   *replica_name;
+    size_t  len;
+
+    if (replica == 0) {
+        return name;
+    }
+
+    len = strlen(name) + 24;
+    replica_name = ib_mm_alloc(mm, len);
+    if (replica_name == NULL) {
+        return NULL;
+    }
+    snprintf(replica_name, len, "%s@%zu", name, replica);
+
+    return replica_name;
+}
+
 static void register_engine(
     ib_manager_t        *manager,
     const char          *name,
@@ -566,6 +721,7 @@ static ib_status_t create_engine(
     ib_engine_t         *engine;
 
     /* Create the engine */
+    manager->build_phase = "creating engine";
     rc = ib_engine_create(&engine, manager->server);
     if (rc != IB_OK) {
         return rc;
@@ -632,24 +788,45 @@ static ib_status_t create_engine(
     ctx = ib_context_main(engine);
     ib_context_set_num(ctx, "logger.log_level", (ib_num_t)IB_LOG_WARNING);
 
-    /* Parse the configuration */
-    rc = ib_cfgparser_parse(parser, config_file);
+    /* Parse the configuration, through the parse cache if one is set. */
+    manager->build_phase = "parsing configuration";
+    if (manager->config_cache_path != NULL) {
+        rc = ib_cfgparser_parse_cached(
+            parser,
+            config_file,
+            manager->config_cache_path);
+    }
+    else {
+        rc = ib_cfgparser_parse(parser, config_file);
+    }
     if (rc != IB_OK) {
         return rc;
     }
 
     /* Report the status to the engine */
+    manager->build_phase = "closing configuration";
     rc = ib_engine_config_finished(engine);
     if (rc != IB_OK) {
         return rc;
     }
 
     /* Run the pre-config functions. */
+    manager->build_phase = "running post-configuration functions";
     rc = manager_run_postconfig_fn(manager, engine);
     if (rc != IB_OK) {
         goto error;
     }
 
+    /* Pre-create per-worker resources so the first requests against
+     * the new engine do not pay resource construction costs. */
+    if (manager->prewarm_concurrency > 0) {
+        manager->build_phase = "prewarming";
+        rc = ib_engine_prewarm(engine, manager->prewarm_concurrency);
+        if (rc != IB_OK) {
+            goto error;
+        }
+    }
+
     /* Fill in the wrapper */
     wrapper->engine = engine;
     wrapper->ref_count = 0;
@@ -708,6 +885,30 @@ ib_status_t ib_manager_engine_create(
     /* ... and register that engine with the manager. */
     register_engine(manager, name, wrapper);
 
+    /* In replicated mode, build the remaining replicas from the same
+     * configuration.  Replica i is registered under "name@i"; acquire
+     * distributes threads across the replica names. */
+    for (size_t i = 1; i < manager->replicas; ++i) {
+        const char *replica_name =
+            replica_engine_name(manager->mm, name, i);
+        if (replica_name == NULL) {
+            rc = IB_EALLOC;
+            goto cleanup;
+        }
+
+        rc = has_engine_slots(manager);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+
+        rc = create_engine(manager, config_file, &wrapper);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+
+        register_engine(manager, replica_name, wrapper);
+    }
+
     /* Destroy any inactive engines. */
     destroy_inactive_engines(manager);
 
@@ -719,6 +920,256 @@ cleanup:
     return rc;
 }
 
+/**
+ * Argument to the standby build thread.
+ *
+ * Owned by the thread; strings are plain strdup() copies so the thread
+ * never allocates from the manager's memory manager without holding
+ * the manager lock.
+ */
+typedef struct manager_build_t {
+    ib_manager_t *manager;     /**< The manager to build for. */
+    char         *name;        /**< Engine name to register under. */
+    char         *config_file; /**< Configuration file to parse. */
+} manager_build_t;
+
+/**
+ * Main function of the standby build thread.
+ *
+ * Builds all replicas of the new engine, including closing their
+ * configuration, without holding the manager lock, so transactions
+ * keep acquiring the current engine while the configuration parses.
+ * Only then is the lock taken, briefly, to flip the name(s) to the
+ * new engine(s).  The thread drops to the idle scheduling class when
+ * available so the build does not compete with traffic.
+ *
+ * @param[in] arg The @ref manager_build_t, which this frees.
+ *
+ * @returns NULL.
+ */
+static void *background_build_main(void *arg)
+{
+    assert(arg != NULL);
+
+    manager_build_t      *build = (manager_build_t *)arg;
+    ib_manager_t         *manager = build->manager;
+    ib_status_t           rc = IB_OK;
+    size_t                built = 0;
+    const size_t          replicas = manager->replicas;
+    ib_manager_engine_t **wrappers;
+
+#ifdef SCHED_IDLE
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+
+        /* Best effort; a normal-priority build is still correct. */
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    }
+#endif
+
+    wrappers = malloc(replicas * sizeof(*wrappers));
+    if (wrappers == NULL) {
+        rc = IB_EALLOC;
+        goto done;
+    }
+
+    /* Build every replica fully before anything is published. */
+    for (built = 0; built < replicas; ++built) {
+        rc = create_engine(manager, build->config_file, &wrappers[built]);
+        if (rc != IB_OK) {
+            goto done;
+        }
+    }
+
+done:
+    manager->build_phase = "registering";
+
+    ib_lock_lock(manager->manager_lck);
+
+    if (rc == IB_OK && ! manager->enabled) {
+        rc = IB_DECLINED;
+    }
+
+    if (rc == IB_OK) {
+
+        /* Atomically flip the name(s) to the standby engine(s). */
+        for (size_t i = 0; i < replicas; ++i) {
+            const char *replica_name =
+                replica_engine_name(manager->mm, build->name, i);
+
+            if (replica_name == NULL) {
+                rc = IB_EALLOC;
+            }
+            else if (has_engine_slots(manager) != IB_OK) {
+                rc = IB_DECLINED;
+            }
+
+            if (rc != IB_OK) {
+                /* Destroy whatever was not registered yet. */
+                for (size_t j = i; j < replicas; ++j) {
+                    ib_engine_destroy(wrappers[j]->engine);
+                }
+                break;
+            }
+
+            register_engine(manager, replica_name, wrappers[i]);
+        }
+    }
+    else if (wrappers != NULL) {
+        for (size_t i = 0; i < built; ++i) {
+            ib_engine_destroy(wrappers[i]->engine);
+        }
+    }
+
+    destroy_inactive_engines(manager);
+
+    manager->build_rc     = rc;
+    manager->build_active = false;
+    manager->build_phase  = "idle";
+
+    ib_lock_unlock(manager->manager_lck);
+
+    free(wrappers);
+    free(build->name);
+    free(build->config_file);
+    free(build);
+
+    return NULL;
+}
+
+ib_status_t ib_manager_engine_create_background(
+    ib_manager_t *manager,
+    const char   *name,
+    const char   *config_file
+)
+{
+    assert(manager != NULL);
+    assert(name != NULL);
+    assert(config_file != NULL);
+
+    ib_status_t      rc;
+    int              sysrc;
+    pthread_t        thread;
+    pthread_attr_t   attr;
+    manager_build_t *build;
+
+    build = malloc(sizeof(*build));
+    if (build == NULL) {
+        return IB_EALLOC;
+    }
+    build->manager     = manager;
+    build->name        = strdup(name);
+    build->config_file = strdup(config_file);
+    if (build->name == NULL || build->config_file == NULL) {
+        rc = IB_EALLOC;
+        goto fail;
+    }
+
+    rc = ib_lock_lock(manager->manager_lck);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    if (! manager->enabled) {
+        rc = IB_DECLINED;
+    }
+    else if (manager->build_active) {
+        /* Only one standby build at a time. */
+        rc = IB_EAGAIN;
+    }
+    else {
+        manager->build_name = ib_mm_strdup(manager->mm, name);
+        if (manager->build_name == NULL) {
+            rc = IB_EALLOC;
+        }
+    }
+
+    if (rc != IB_OK) {
+        ib_lock_unlock(manager->manager_lck);
+        goto fail;
+    }
+
+    manager->build_active  = true;
+    manager->build_rc      = IB_OK;
+    manager->build_started = ib_clock_get_time();
+    manager->build_phase   = "starting";
+
+    ib_lock_unlock(manager->manager_lck);
+
+    /* The thread is detached; completion is observed through
+     * ib_manager_engine_build_status(). */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    sysrc = pthread_create(&thread, &attr, background_build_main, build);
+    pthread_attr_destroy(&attr);
+    if (sysrc != 0) {
+        ib_lock_lock(manager->manager_lck);
+        manager->build_active = false;
+        manager->build_rc     = IB_EOTHER;
+        manager->build_phase  = "idle";
+        ib_lock_unlock(manager->manager_lck);
+        rc = IB_EOTHER;
+        goto fail;
+    }
+
+    return IB_OK;
+
+fail:
+    free(build->name);
+    free(build->config_file);
+    free(build);
+    return rc;
+}
+
+ib_status_t ib_manager_engine_build_status(
+    ib_manager_t  *manager,
+    ib_mm_t        mm,
+    const char   **message
+)
+{
+    assert(manager != NULL);
+    assert(message != NULL);
+
+    ib_status_t rc;
+    size_t      sz = 0;
+
+    rc = ib_lock_lock(manager->manager_lck);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (manager->build_active) {
+        const char *phase = manager->build_phase;
+
+        rc = ib_snprintf(
+            mm,
+            (char **)message,
+            &sz,
+            "building \"%s\": %s, %d seconds elapsed",
+            manager->build_name,
+            (phase != NULL) ? phase : "starting",
+            (int)IB_CLOCK_SECS(ib_clock_get_time() - manager->build_started));
+    }
+    else if (manager->build_name != NULL) {
+        rc = ib_snprintf(
+            mm,
+            (char **)message,
+            &sz,
+            "last build of \"%s\": %s",
+            manager->build_name,
+            ib_status_to_string(manager->build_rc));
+    }
+    else {
+        *message = "no background build has been started";
+        rc = IB_OK;
+    }
+
+    ib_lock_unlock(manager->manager_lck);
+
+    return rc;
+}
+
 ib_status_t ib_manager_enable(
     ib_manager_t *manager
 )
@@ -895,7 +1346,38 @@ ib_status_t ib_manager_engine_acquire(
         rc = manager_engine_acquire_any(manager, &engine);
     }
     else {
-        rc = ib_hash_get(manager->name_to_engine, &engine, name);
+        rc = IB_ENOENT;
+
+        /* In replicated mode, pin this thread to a replica.  Slots are
+         * handed out round-robin on each thread's first acquire, so
+         * threads spread evenly and always return to the same replica. */
+        if (manager->replicas > 1) {
+            char   replica_name[256];
+            size_t replica;
+
+            if (t_replica_slot == (size_t)-1) {
+                t_replica_slot =
+                    __sync_fetch_and_add(&g_next_replica_slot, 1);
+            }
+            replica = t_replica_slot % manager->replicas;
+
+            if (replica > 0 &&
+                strlen(name) + 24 <= sizeof(replica_name))
+            {
+                snprintf(
+                    replica_name, sizeof(replica_name),
+                    "%s@%zu",
+                    name, replica);
+                rc = ib_hash_get(
+                    manager->name_to_engine, &engine, replica_name);
+            }
+        }
+
+        /* Replica 0, non-replicated mode, or fall back to the base
+         * name if this thread's replica is missing. */
+        if (rc != IB_OK) {
+            rc = ib_hash_get(manager->name_to_engine, &engine, name);
+        }
     }
 
     if (rc == IB_OK) {
@@ -26,11 +26,17 @@
 
 #include <ironbee/engine_manager_control_channel.h>
 
+#include <ironbee/engine.h>
 #include <ironbee/engine_manager.h>
 #include <ironbee/hash.h>
+#include <ironbee/logger.h>
+#include <ironbee/type_convert.h>
 #include <ironbee/mm.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/mpool_lite.h>
+#include <ironbee/metrics.h>
+#include <ironbee/mm_profile.h>
+#include <ironbee/profiler.h>
 
 #ifdef HAVE_VALGRIND
 #include <valgrind/memcheck.h>
@@ -39,6 +45,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -230,6 +237,323 @@ static ib_status_t manager_diag_valgrind_added(
     return IB_OK;
 }
 
+/**
+ * Control the built-in sampling profiler.
+ *
+ * The arguments are one of
+ * - @c start [interval_usec] - begin sampling, by default every 1000
+ *   microseconds of process CPU time.
+ * - @c stop - stop sampling, retaining samples.
+ * - @c report - return the folded-stack report.
+ * - @c reset - discard samples.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments.
+ * @param[out] result The command result message or the report.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL on an unknown sub-command or a bad interval.
+ * - Other on profiler failures.
+ */
+static ib_status_t profiler_cmd(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+
+    ib_status_t rc;
+
+    if (strncmp(args, "start", sizeof("start") - 1) == 0) {
+        long interval = 1000;
+
+        if (args[sizeof("start") - 1] == ' ') {
+            interval = strtol(args + sizeof("start"), NULL, 10);
+            if (interval <= 0) {
+                *result = "Invalid profiler interval.";
+                return IB_EINVAL;
+            }
+        }
+
+        rc = ib_profiler_start((uint32_t)interval);
+        *result = (rc == IB_OK) ?
+            "Profiler started." :
+            "Failed to start profiler.";
+        return rc;
+    }
+    else if (strcmp(args, "stop") == 0) {
+        *result = "Profiler stopped.";
+        return ib_profiler_stop();
+    }
+    else if (strcmp(args, "report") == 0) {
+        return ib_profiler_report(mm, result);
+    }
+    else if (strcmp(args, "reset") == 0) {
+        ib_profiler_reset();
+        *result = "Profiler reset.";
+        return IB_OK;
+    }
+
+    *result = "Profiler sub-commands: start [interval_usec], stop, "
+              "report, reset.";
+    return IB_EINVAL;
+}
+
+/**
+ * Control the memory manager allocation profiler.
+ *
+ * The arguments are one of
+ * - @c report - return sampled allocation call sites, sorted by
+ *   sampled bytes descending.
+ * - @c reset - discard samples.
+ *
+ * Sampling itself is compiled in only when the library is built with
+ * @c IB_MM_PROFILE (see mm_profile.h); without it, both sub-commands
+ * report that profiling is not built in.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments.
+ * @param[out] result The command result message or the report.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL on an unknown sub-command.
+ * - IB_ENOTIMPL when profiling is not compiled in.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t mm_profile_cmd(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+
+    if (! ib_mm_profile_enabled()) {
+        *result = "Allocation profiling not compiled in; "
+                  "build with -DIB_MM_PROFILE.";
+        return IB_ENOTIMPL;
+    }
+
+    if (strcmp(args, "report") == 0) {
+        return ib_mm_profile_report(mm, result);
+    }
+    else if (strcmp(args, "reset") == 0) {
+        ib_mm_profile_reset();
+        *result = "Allocation profiler reset.";
+        return IB_OK;
+    }
+
+    *result = "Allocation profiler sub-commands: report, reset.";
+    return IB_EINVAL;
+}
+
+/**
+ * Report the runtime metrics registry.
+ *
+ * The whole registry is rendered into one response so a scraper gets a
+ * consistent snapshot in a single read.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments. Ignored.
+ * @param[out] result The rendered metrics.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t metrics_cmd(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    return ib_metrics_report(mm, result);
+}
+
+/**
+ * Tune a runtime setting on the current engine without a reload.
+ *
+ * The arguments are of the form <tt>setting value</tt>:
+ * - @c loglevel <em>level</em> - engine log level, by name or number.
+ * - Any setting accepted by ib_engine_tune_set() (such as
+ *   @c rule_dlog_level or @c request_body_log_limit), with a numeric
+ *   value.  A negative value clears the override, restoring the
+ *   configured value.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments.
+ * @param[out] result The command result message.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL on malformed arguments.
+ * - IB_ENOENT on an unknown setting or when no engine is active.
+ * - IB_EALLOC on allocation failures.
+ */
+static ib_status_t manager_cmd_tune(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+    ib_engine_t  *ib;
+    ib_status_t   rc;
+    const char   *value;
+    char         *setting;
+
+    value = strchr(args, ' ');
+    if (value == NULL || value[1] == '\0') {
+        *result = "Usage: tune <setting> <value>";
+        return IB_EINVAL;
+    }
+    setting = ib_mm_memdup_to_str(mm, args, value - args);
+    if (setting == NULL) {
+        return IB_EALLOC;
+    }
+    ++value;
+
+    rc = ib_manager_engine_acquire(
+        manager, IB_MANAGER_ENGINE_NAME_ANY, &ib);
+    if (rc != IB_OK) {
+        *result = "No active engine.";
+        return rc;
+    }
+
+    if (strcasecmp(setting, "loglevel") == 0) {
+        ib_logger_t *logger = ib_engine_logger_get(ib);
+
+        ib_logger_level_set(
+            logger,
+            ib_logger_string_to_level(value, ib_logger_level_get(logger)));
+        *result = "Log level set.";
+        rc = IB_OK;
+    }
+    else {
+        ib_num_t num;
+
+        rc = ib_type_atoi(value, 10, &num);
+        if (rc != IB_OK) {
+            *result = "Value is not a number.";
+            rc = IB_EINVAL;
+        }
+        else {
+            rc = ib_engine_tune_set(ib, setting, num);
+            if (rc == IB_ENOENT) {
+                *result = "Unknown setting.";
+            }
+            else if (rc == IB_OK) {
+                *result = (num < 0) ?
+                    "Override cleared." :
+                    "Override applied.";
+            }
+        }
+    }
+
+    ib_manager_engine_release(manager, ib);
+
+    return rc;
+}
+
+/**
+ * Run a runtime control command registered with the current engine.
+ *
+ * The arguments are of the form <tt>command [args]</tt>; the command is
+ * dispatched through ib_engine_ctlcmd_run().  Commands are registered by
+ * modules via ib_engine_ctlcmd_register() to expose operations -- such as
+ * reloading a data file -- on a live engine without a reload.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments.
+ * @param[out] result The command result message.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL on malformed arguments.
+ * - IB_ENOENT on an unknown engine command or when no engine is active.
+ * - Otherwise the return of the engine command.
+ */
+static ib_status_t manager_cmd_engine(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+    ib_engine_t  *ib;
+    ib_status_t   rc;
+    const char   *cmd_args;
+    char         *cmd_name;
+
+    if (*args == '\0') {
+        *result = "Usage: engine <command> [args]";
+        return IB_EINVAL;
+    }
+
+    cmd_args = strchr(args, ' ');
+    if (cmd_args == NULL) {
+        cmd_name = ib_mm_strdup(mm, args);
+        cmd_args = "";
+    }
+    else {
+        cmd_name = ib_mm_memdup_to_str(mm, args, cmd_args - args);
+        ++cmd_args;
+    }
+    if (cmd_name == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_manager_engine_acquire(
+        manager, IB_MANAGER_ENGINE_NAME_ANY, &ib);
+    if (rc != IB_OK) {
+        *result = "No active engine.";
+        return rc;
+    }
+
+    rc = ib_engine_ctlcmd_run(ib, cmd_name, cmd_args, mm, result);
+    if (rc == IB_ENOENT && *result == NULL) {
+        *result = "Unknown engine command.";
+    }
+
+    ib_manager_engine_release(manager, ib);
+
+    return rc;
+}
+
 
 /**
  * Disable manager command.
@@ -347,6 +671,106 @@ static ib_status_t manager_cmd_engine_create(
     return ib_manager_engine_create(manager, name, file);
 }
 
+/**
+ * Call ib_manager_engine_create_background(); Args as for engine_create.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] cmd_name The name this command is called by.
+ * @param[in] args The path to the configuration file to use, optionally
+ *            prefixed with <tt>name=</tt>.
+ * @param[out] result A message saying whether the build was started.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_manager_engine_create_background()
+ *
+ * @returns The return of ib_manager_engine_create_background().
+ */
+static ib_status_t manager_cmd_engine_create_background(
+    ib_mm_t      mm,
+    const char  *cmd_name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+    ib_status_t   rc;
+    char         *name;
+    char         *file;
+
+    /* Copy the argument so we can modify it. */
+    name = ib_mm_strdup(mm, args);
+    if (name == NULL) {
+        return IB_EALLOC;
+    }
+
+    /* Find the first = character. */
+    file = index(name, '=');
+
+    /* If there is no = character, then the whole arg is the file name. */
+    if (file == NULL) {
+        file = name;                           /* Whole string is file. */
+        name = IB_MANAGER_ENGINE_NAME_DEFAULT; /* Use default for name. */
+    }
+
+    /* Otherwise, the first part is `name` and the second part is `file`. */
+    else {
+        *file = '\0'; /* Tag the end of the name with a \0. */
+        ++file;       /* Point file to the start of the file name. */
+    }
+
+    rc = ib_manager_engine_create_background(manager, name, file);
+    switch (rc) {
+    case IB_OK:
+        *result = "Background build started; "
+                  "poll engine_build_status for progress.";
+        break;
+    case IB_EAGAIN:
+        *result = "A background build is already running.";
+        break;
+    case IB_DECLINED:
+        *result = "Manager is disabled.";
+        break;
+    default:
+        break;
+    }
+
+    return rc;
+}
+
+/**
+ * Call ib_manager_engine_build_status().
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args Unused.
+ * @param[out] result The build status message.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_manager_engine_build_status()
+ *
+ * @returns The return of ib_manager_engine_build_status().
+ */
+static ib_status_t manager_cmd_engine_build_status(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+
+    return ib_manager_engine_build_status(manager, mm, result);
+}
+
 /**
  * Call ib_manager_engine_create(); Args is the path to the config file.
  *
@@ -1117,6 +1541,42 @@ ib_status_t ib_engine_manager_control_echo_register(
         echo_cmd, NULL);
 }
 
+ib_status_t ib_engine_manager_control_profiler_register(
+    ib_engine_manager_control_channel_t *channel
+)
+{
+    assert(channel != NULL);
+
+    return ib_engine_manager_control_cmd_register(
+        channel,
+        "profiler",
+        profiler_cmd, NULL);
+}
+
+ib_status_t ib_engine_manager_control_mm_profile_register(
+    ib_engine_manager_control_channel_t *channel
+)
+{
+    assert(channel != NULL);
+
+    return ib_engine_manager_control_cmd_register(
+        channel,
+        "mmprofile",
+        mm_profile_cmd, NULL);
+}
+
+ib_status_t ib_engine_manager_control_metrics_register(
+    ib_engine_manager_control_channel_t *channel
+)
+{
+    assert(channel != NULL);
+
+    return ib_engine_manager_control_cmd_register(
+        channel,
+        "metrics",
+        metrics_cmd, NULL);
+}
+
 
 ib_status_t ib_engine_manager_control_manager_ctrl_register(
     ib_engine_manager_control_channel_t *channel
@@ -1137,7 +1597,11 @@ ib_status_t ib_engine_manager_control_manager_ctrl_register(
         { "disable",       manager_cmd_disable },
         { "cleanup",       manager_cmd_cleanup },
         { "engine_create", manager_cmd_engine_create },
+        { "engine_create_bg", manager_cmd_engine_create_background },
+        { "engine_build_status", manager_cmd_engine_build_status },
         { "engine_status", manager_cmd_engine_status },
+        { "tune",          manager_cmd_tune },
+        { "engine",        manager_cmd_engine },
         { NULL,            NULL }
     };
 
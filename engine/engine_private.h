@@ -58,6 +58,14 @@ struct ib_auditlog_cfg_t {
     FILE         *index_fp;      /**< Index file pointer. */
     ib_lock_t    *index_fp_lock; /**< Lock to protect index_fp. */
     ib_context_t *owner;         /**< Owning context. Only owner should edit. */
+
+    /* Index entries are batched here and written with a single fwrite()
+     * when the buffer fills or a flush interval passes, instead of one
+     * fwrite()+fflush() per transaction. All three fields are protected
+     * by index_fp_lock. Managed by core_audit.c. */
+    char         *index_buf;        /**< Batched index entries. */
+    size_t        index_buf_len;    /**< Bytes pending in index_buf. */
+    ib_time_t     index_last_flush; /**< Time of the last index flush. */
 };
 
 /**
@@ -167,7 +175,17 @@ struct ib_engine_t {
     ib_hash_t             *tfns;            /**< Hash tracking transforms */
     ib_hash_t             *operators;       /**< Operators by name */
     ib_hash_t             *stream_operators;/**< Stream operators by name*/
+
+    /**
+     * Shared operator instances, keyed by operator and parameters.
+     *
+     * Instances of operators with @ref IB_OP_CAPABILITY_SHAREABLE are
+     * interned here during configuration so that every context inheriting
+     * the same rule reuses one instance.  See ib_operator_inst_create().
+     **/
+    ib_hash_t             *operator_inst_cache;
     ib_hash_t             *actions;         /**< Hash tracking rules */
+    ib_hash_t             *ctlcmds;         /**< Runtime control commands */
     ib_rule_engine_t      *rule_engine;     /**< Rule engine data */
     ib_logger_t           *logger;          /**< The engine log object. */
     ib_var_config_t       *var_config;      /**< Data configuration. */
@@ -175,7 +193,17 @@ struct ib_engine_t {
     /* Hooks */
     ib_list_t *hooks[IB_STATE_NUM + 1]; /**< Registered hook callbacks */
 
+    /**
+     * Bit per state with at least one hook in @ref hooks.
+     *
+     * Maintained by hook registration so state dispatch can return
+     * immediately for states nothing subscribed to. @ref IB_STATE_NUM
+     * must stay at or below 64 for this to hold every state.
+     */
+    uint64_t hook_mask;
+
     ib_list_t *logevent_handlers; /**< List of ib_logevent_t callbacks. */
+    ib_list_t *prewarm_handlers;  /**< List of prewarm callbacks. */
 
     /* Context selection function registration; both active and core */
     ib_ctxsel_registration_t act_ctxsel;  /**< Active context selection reg. */
@@ -192,6 +220,21 @@ struct ib_engine_t {
 
     /* Where stream processor definitions are stored. */
     ib_stream_processor_registry_t *stream_processor_registry;
+
+    /**
+     * Runtime-tunable overrides of configured settings.
+     *
+     * Set through ib_engine_tune_set() (e.g. from the engine manager
+     * control channel) without a configuration reload.  A negative
+     * value means "not overridden: use the configured value".  Each
+     * override is a single aligned word, so hot-path readers see either
+     * the old or the new value without locking.
+     */
+    struct {
+        volatile ib_num_t rule_dlog_level;         /**< Rule debug log level */
+        volatile ib_num_t request_body_log_limit;  /**< Request body buffer */
+        volatile ib_num_t response_body_log_limit; /**< Response body buffer */
+    } tune;
 };
 
 /**
@@ -202,8 +245,26 @@ struct ib_context_data_t {
     ib_module_t *module;      /**< Module handle */
     void        *data;        /**< Module config structure */
     size_t       data_length; /**< Length of data */
+    bool         shared;      /**< Data is aliased by/from another context */
 };
 
+/**
+ * Give @a cfgdata its own copy of shared module configuration data.
+ *
+ * Contexts alias their parent's configuration data until something writes
+ * to it (copy-on-write).  This performs the deferred copy, using the
+ * module's @c fn_cfg_copy handler when one is defined, and re-points
+ * @a cfgdata at memory owned by @a ctx.  A no-op if the data is not
+ * shared.
+ *
+ * @param[in] ctx Configuration context owning @a cfgdata
+ * @param[in,out] cfgdata Configuration data to unshare
+ *
+ * @returns Status code
+ */
+ib_status_t ib_module_config_unshare(ib_context_t *ctx,
+                                     ib_context_data_t *cfgdata);
+
 /**
  * Configuration context states
  */
@@ -241,6 +302,13 @@ struct ib_context_t {
 
     /* Rules associated with this context */
     ib_rule_context_t    *rules;       /**< Rule context data */
+
+    /**
+     * IB_INSPECT_* flags computed at context close.
+     *
+     * @sa ib_context_inspection_profile()
+     */
+    ib_flags_t            inspection_profile;
 };
 
 #endif /* _IB_ENGINE_PRIVATE_H_ */
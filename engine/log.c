@@ -35,6 +35,16 @@
 #include <stdlib.h>
 #include <time.h>
 
+bool DLL_PUBLIC ib_log_would_log(
+    const ib_engine_t *ib,
+    ib_logger_level_t  level
+)
+{
+    assert(ib != NULL);
+
+    return level <= ib_logger_level_get(ib_engine_logger_get(ib));
+}
+
 void DLL_PUBLIC ib_log_ex(
     const ib_engine_t *ib,
     ib_logger_level_t  level,
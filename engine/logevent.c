@@ -25,10 +25,14 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/logevent.h>
+#include <ironbee/clock.h>
+#include <ironbee/core.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/state_notify.h>
 
 #include <assert.h>
+#include <stdbool.h>
 #if defined(__cplusplus) && !defined(__STDC_FORMAT_MACROS)
 /* C99 requires that inttypes.h only exposes PRI* macros
  * for C++ implementations if this is defined: */
@@ -146,6 +150,7 @@ ib_status_t ib_logevent_create(ib_logevent_t **ple,
     }
 
     (*ple)->event_id   = 0;
+    (*ple)->suppressed_count = 0;
     (*ple)->mm         = mm;
     (*ple)->rule_id    = ib_mm_strdup(mm, rule_id);
     (*ple)->type       = type;
@@ -219,15 +224,169 @@ ib_status_t ib_logevent_data_set(ib_logevent_t *le,
 }
 
 
-ib_status_t ib_logevent_add(ib_tx_t       *tx,
-                            ib_logevent_t *e)
+/**
+ * Number of per-rule-id rate limit buckets.
+ *
+ * Rule ids hash onto a fixed slot array shared by every engine in the
+ * process; colliding ids share a budget, which only makes the limit
+ * slightly stricter. Must be a power of two.
+ */
+#define LOGEVENT_RATE_SLOTS 256
+
+/** One per-rule-id rate limit bucket: a one second event count window. */
+typedef struct {
+    volatile ib_time_t window; /**< Start of the current window. */
+    volatile uint32_t  count;  /**< Events charged in the window. */
+} logevent_rate_slot_t;
+
+/** The rate limit buckets. See LOGEVENT_RATE_SLOTS. */
+static logevent_rate_slot_t logevent_rate_slots[LOGEVENT_RATE_SLOTS];
+
+/** Process-wide event counter driving sampling. */
+static volatile uint32_t logevent_sample_counter = 0;
+
+/**
+ * Charge one event against @a rule_id's rate bucket.
+ *
+ * Lock free: the window roll is a benign race (a colliding roll loses
+ * at most a window's worth of counting) and the count is atomic.
+ *
+ * @param[in] rule_id The rule id the event is attributed to.
+ * @param[in] limit Maximum events per second for this rule id.
+ *
+ * @returns True if the event is within the limit.
+ */
+static bool logevent_rate_ok(const char *rule_id, ib_num_t limit)
+{
+    uint32_t hash = 5381;
+    const char *p;
+    logevent_rate_slot_t *slot;
+    ib_time_t window;
+
+    for (p = rule_id; *p != '\0'; ++p) {
+        hash = (hash * 33) + (uint8_t)*p;
+    }
+    slot = &logevent_rate_slots[hash & (LOGEVENT_RATE_SLOTS - 1)];
+
+    window = ib_clock_get_time() / 1000000;
+    if (slot->window != window) {
+        slot->count = 0;
+        slot->window = window;
+    }
+
+    return __sync_add_and_fetch(&slot->count, 1) <= (uint32_t)limit;
+}
+
+/**
+ * Apply the context's event policy to @a e before it is dispatched.
+ *
+ * - Aggregation: a duplicate of an event already in @a tx (same rule
+ *   id and type) is merged into the earlier event's suppressed count.
+ * - Sampling: beyond the transaction's first event, only every
+ *   event_sample_pct percent of events survive. The first event of a
+ *   transaction is never sampled away.
+ * - Rate limiting: each rule id is capped at event_rate_limit events
+ *   per second across all transactions.
+ *
+ * Events suppressed by sampling or rate limiting are counted on the
+ * transaction's most recent surviving event when there is one.
+ *
+ * @param[in] tx The transaction.
+ * @param[in] corecfg The context's core configuration.
+ * @param[in] e The candidate event.
+ *
+ * @returns True if @a e survives and should be queued and dispatched.
+ */
+static bool logevent_policy_keep(
+    ib_tx_t             *tx,
+    const ib_core_cfg_t *corecfg,
+    ib_logevent_t       *e
+)
+{
+    ib_logevent_t *survivor;
+
+    /* Aggregate duplicates within the transaction. */
+    if (corecfg->event_dedup != 0) {
+        const ib_list_node_t *node;
+        IB_LIST_LOOP_CONST(tx->logevents, node) {
+            ib_logevent_t *have =
+                (ib_logevent_t *)ib_list_node_data_const(node);
+            if ( (have->type == e->type) &&
+                 (strcmp(have->rule_id, e->rule_id) == 0) )
+            {
+                ++(have->suppressed_count);
+                return false;
+            }
+        }
+    }
+
+    /* Sample events beyond the transaction's first. */
+    if ( (corecfg->event_sample_pct < 100) &&
+         (ib_list_elements(tx->logevents) > 0) &&
+         ((__sync_fetch_and_add(&logevent_sample_counter, 1) % 100) >=
+          (uint32_t)corecfg->event_sample_pct) )
+    {
+        goto suppress;
+    }
+
+    /* Rate limit each rule id across transactions. */
+    if ( (corecfg->event_rate_limit > 0) &&
+         !logevent_rate_ok(e->rule_id, corecfg->event_rate_limit) )
+    {
+        goto suppress;
+    }
+
+    return true;
+
+suppress:
+    if (ib_logevent_get_last(tx, &survivor) == IB_OK) {
+        ++(survivor->suppressed_count);
+    }
+    return false;
+}
+
+/**
+ * Common implementation of ib_logevent_add() and ib_logevent_add_lazy().
+ *
+ * @param[in,out] tx The transaction.
+ * @param[in] e The event.
+ * @param[in] fn If non-NULL, called to populate @a e once it has
+ *            survived the event policy, before it is queued.
+ * @param[in] cbdata Callback data for @a fn.
+ *
+ * @returns Status code
+ */
+static ib_status_t logevent_add_impl(
+    ib_tx_t                   *tx,
+    ib_logevent_t             *e,
+    ib_logevent_populate_fn_t  fn,
+    void                      *cbdata
+)
 {
     ib_status_t rc;
+    ib_core_cfg_t *corecfg = NULL;
 
     if (tx == NULL || e == NULL) {
         return IB_EINVAL;
     }
 
+    /* Apply the context's event policy before any handler runs. */
+    if ( (tx->ctx != NULL) &&
+         (ib_core_context_config(tx->ctx, &corecfg) == IB_OK) )
+    {
+        if (!logevent_policy_keep(tx, corecfg, e)) {
+            return IB_OK;
+        }
+    }
+
+    /* The event survived; finish building it before anyone sees it. */
+    if (fn != NULL) {
+        rc = fn(e, cbdata);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
     /* Ensure there is an event ID and it is unique to this list. */
     if (e->event_id == 0) {
         e->event_id = (uint32_t)ib_list_elements(tx->logevents); /* truncated */
@@ -238,11 +397,35 @@ ib_status_t ib_logevent_add(ib_tx_t       *tx,
         return rc;
     }
 
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire("logevent.count", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+
     rc = ib_engine_notify_logevent(tx->ib, tx, e);
 
     return rc;
 }
 
+ib_status_t ib_logevent_add(ib_tx_t       *tx,
+                            ib_logevent_t *e)
+{
+    return logevent_add_impl(tx, e, NULL, NULL);
+}
+
+ib_status_t ib_logevent_add_lazy(
+    ib_tx_t                   *tx,
+    ib_logevent_t             *e,
+    ib_logevent_populate_fn_t  fn,
+    void                      *cbdata
+)
+{
+    return logevent_add_impl(tx, e, fn, cbdata);
+}
+
 ib_status_t ib_logevent_remove(ib_tx_t *tx,
                                uint32_t id)
 {
@@ -30,8 +30,28 @@
 #include <ironbee/type_convert.h>
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 
+/**
+ * A single-producer, single-consumer ring of formatted log records.
+ *
+ * Each thread that logs to a writer owns one ring: only that thread
+ * pushes records and only the drain in ib_logger_dequeue(), serialized
+ * by ib_logger_writer_t::drain_lck, pops them. A push therefore takes
+ * no lock and never contends with other logging threads.
+ *
+ * Rings stay on the writer's list for the life of the logger, even if
+ * the owning thread exits, so queued records are never orphaned.
+ */
+typedef struct logger_record_ring_t logger_record_ring_t;
+struct logger_record_ring_t {
+    logger_record_ring_t  *next;     /**< Next ring on the writer's list. */
+    void                 **elements; /**< RING_DEPTH record slots. */
+    volatile size_t        head;     /**< Next slot written. Producer's. */
+    volatile size_t        tail;     /**< Next slot read. Consumer's. */
+};
+
 /**
  * A collection of callbacks and function pointer that implement a logger.
  */
@@ -45,8 +65,9 @@ struct ib_logger_writer_t {
     ib_logger_format_t    *format;      /**< Format a message.  */
     ib_logger_record_fn_t  record_fn;   /**< Signal a record is ready. */
     void                  *record_data; /**< Callback data. */
-    ib_queue_t            *records;     /**< Records for the log writer. */
-    ib_lock_t             *records_lck; /**< Guard the queue. */
+    logger_record_ring_t  *rings;       /**< One record ring per thread. */
+    pthread_key_t          ring_key;    /**< This thread's ring in rings. */
+    ib_lock_t             *drain_lck;   /**< Serialize ring drains. */
 };
 
 //! Identify the type of a logger callback function.
@@ -203,18 +224,71 @@ typedef struct logger_write_cbdata_t {
 } logger_write_cbdata_t;
 
 /**
- * The maximum depth of a message queue in a @ref ib_logger_writer_t.
+ * The depth of each per-thread record ring in a @ref ib_logger_writer_t.
  */
-static const size_t MAX_QUEUE_DEPTH = 1000;
+static const size_t RING_DEPTH = 1024;
+
+/**
+ * Get the calling thread's ring for @a writer, creating it on first use.
+ *
+ * Creation happens once per logging thread. It takes the drain lock to
+ * publish the new ring to the drain in ib_logger_dequeue(); after that
+ * the thread reaches its ring through @c pthread_getspecific() alone.
+ *
+ * @param[in] writer The writer whose ring to get.
+ *
+ * @returns The ring, or NULL on allocation or thread key failure.
+ */
+static logger_record_ring_t *logger_ring_acquire(
+    ib_logger_writer_t *writer
+)
+{
+    logger_record_ring_t *ring =
+        (logger_record_ring_t *)pthread_getspecific(writer->ring_key);
+
+    if (ring != NULL) {
+        return ring;
+    }
+
+    ring = (logger_record_ring_t *)malloc(sizeof(*ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->elements = (void **)malloc(sizeof(*(ring->elements)) * RING_DEPTH);
+    if (ring->elements == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+
+    if (pthread_setspecific(writer->ring_key, ring) != 0) {
+        free(ring->elements);
+        free(ring);
+        return NULL;
+    }
+
+    if (ib_lock_lock(writer->drain_lck) != IB_OK) {
+        pthread_setspecific(writer->ring_key, NULL);
+        free(ring->elements);
+        free(ring);
+        return NULL;
+    }
+    ring->next = writer->rings;
+    writer->rings = ring;
+    ib_lock_unlock(writer->drain_lck);
+
+    return ring;
+}
 
 /**
  * The implementation for logger_log().
  *
  * This function will
  * - Format the message stored in @a cbdata as a @ref logger_write_cbdata_t.
- * - Lock the message queue.
- * - Enqueue the formatted message.
- * - If the message is the only message in the queue,
+ * - Push the formatted message onto the calling thread's ring, without
+ *   taking any lock.
+ * - If no drain has records ahead of this one,
  *   ib_logger_writer_t::record_fn is called to signal the
  *   writer that at least one record is available.
  *
@@ -234,6 +308,8 @@ static ib_status_t logger_write(
 {
     ib_status_t rc;
     void *rec = NULL;
+    logger_record_ring_t *ring;
+    size_t slot;
     logger_write_cbdata_t *logger_write_data = (logger_write_cbdata_t *)cbdata;
 
     if (writer->format == NULL) {
@@ -258,43 +334,49 @@ static ib_status_t logger_write(
         return rc;
     }
 
-    rc = ib_lock_lock(writer->records_lck);
-    if (rc != IB_OK) {
-        return rc;
+    ring = logger_ring_acquire(writer);
+    if (ring == NULL) {
+        if (writer->format->format_free_fn != NULL) {
+            writer->format->format_free_fn(
+                logger,
+                rec,
+                writer->format->format_free_cbdata);
+        }
+        return IB_EALLOC;
     }
 
-    /* Busy-wait until the queue has space available.
+    /* Busy-wait until the ring has space available.
      * This is emergency code to avoid a crash at the cost of a slowdown. */
-    while (ib_queue_size(writer->records) >= MAX_QUEUE_DEPTH) {
-        rc = ib_lock_unlock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        /* TODO - The number of times we need to sleep should be
-         *        audited. It is a good indicator of excessive logging or
-         *        proxy load. */
-        sleep(1);
-        rc = ib_lock_lock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
+    while (ring->head - ring->tail >= RING_DEPTH) {
+        /* Prod the writer; for inline writers this drains the rings. */
+        writer->record_fn(logger, writer, writer->record_data);
+
+        if (ring->head - ring->tail >= RING_DEPTH) {
+            /* TODO - The number of times we need to sleep should be
+             *        audited. It is a good indicator of excessive logging or
+             *        proxy load. */
+            sleep(1);
         }
     }
 
-    rc = ib_queue_push_front(writer->records, rec);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    slot = ring->head;
+    ring->elements[slot % RING_DEPTH] = rec;
 
-    /* If the queue is size=1, unlock and notify writers. */
-    if (ib_queue_size(writer->records) == 1) {
-        ib_lock_unlock(writer->records_lck);
+    /* Publish the record before advancing head for the drain. */
+    __sync_synchronize();
+    ring->head = slot + 1;
+    __sync_synchronize();
+
+    /* Notify the writer unless a drain still has records ahead of this
+     * one, in which case that drain will deliver this record too. A
+     * record that races a drain going idle waits for the next
+     * notification; every drain services every ring. */
+    if (ring->tail == slot) {
         rc = writer->record_fn(logger, writer, writer->record_data);
         return rc;
     }
 
-    ib_lock_unlock(writer->records_lck);
-    return rc;
+    return IB_OK;
 }
 
 /**
@@ -384,7 +466,7 @@ void ib_logger_log_msg(
     rec.line_number = line_number;
     rec.file        = file;
     rec.function    = function;
-    rec.timestamp   = ib_clock_get_time();
+    rec.timestamp   = ib_clock_coarse_get_time();
     rec.module      = module;
     rec.conn        = conn;
     rec.tx          = tx;
@@ -521,7 +603,7 @@ void ib_logger_log_va_list(
     rec.line_number = line_number;
     rec.file        = file;
     rec.function    = function;
-    rec.timestamp   = ib_clock_get_time();
+    rec.timestamp   = ib_clock_coarse_get_time();
     rec.module      = module;
     rec.conn        = conn;
     rec.tx          = tx;
@@ -655,6 +737,29 @@ ib_status_t ib_logger_create(
     return IB_OK;
 }
 
+/**
+ * Memory manager cleanup: free a writer's record rings and thread key.
+ *
+ * @param[in] cbdata The @ref ib_logger_writer_t.
+ */
+static void logger_writer_rings_free(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    ib_logger_writer_t   *writer = (ib_logger_writer_t *)cbdata;
+    logger_record_ring_t *ring   = writer->rings;
+
+    while (ring != NULL) {
+        logger_record_ring_t *next = ring->next;
+        free(ring->elements);
+        free(ring);
+        ring = next;
+    }
+    writer->rings = NULL;
+
+    pthread_key_delete(writer->ring_key);
+}
+
 ib_status_t ib_logger_writer_add(
     ib_logger_t           *logger,
     ib_logger_open_fn_t    open_fn,
@@ -688,18 +793,18 @@ ib_status_t ib_logger_writer_add(
     writer->format      = format;
     writer->record_fn   = record_fn;
     writer->record_data = record_data;
-    rc = ib_queue_create(&(writer->records), logger->mm, IB_QUEUE_NEVER_SHRINK);
+    writer->rings       = NULL;
+    if (pthread_key_create(&(writer->ring_key), NULL) != 0) {
+        return IB_EOTHER;
+    }
+    rc = ib_lock_create(&(writer->drain_lck), logger->mm);
     if (rc != IB_OK) {
         return rc;
     }
-    writer->records_lck = ib_mm_alloc(
-        logger->mm,
-        sizeof(*(writer->records_lck)));
-    if (writer->records_lck == NULL) {
-        return IB_EALLOC;
-    }
-    rc = ib_lock_create(&(writer->records_lck), logger->mm)
-    ;
+
+    /* Rings are malloc'ed by their logging threads; free them with the
+     * logger. */
+    rc = ib_mm_register_cleanup(logger->mm, logger_writer_rings_free, writer);
     if (rc != IB_OK) {
         return rc;
     }
@@ -872,9 +977,9 @@ ib_status_t ib_logger_dequeue(
 {
     assert(logger != NULL);
     assert(writer != NULL);
-    assert(writer->records != NULL);
 
-    ib_status_t rc;
+    ib_status_t           rc;
+    logger_record_ring_t *ring;
     logger_handler_cbdata_t logger_handler_cbdata = {
         .logger    = logger,
         .user_fn   = handler,
@@ -883,19 +988,29 @@ ib_status_t ib_logger_dequeue(
         .free_data = writer->format->format_free_cbdata
     };
 
-    rc = ib_lock_lock(writer->records_lck);
+    rc = ib_lock_lock(writer->drain_lck);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_queue_dequeue_all_to_function(
-        writer->records,
-        logger_handler,
-        &logger_handler_cbdata);
+    /* Drain every thread's ring. Records in one ring are handled in
+     * submission order; only this locked drain advances tail, so the
+     * logging threads are never touched. */
+    for (ring = writer->rings; ring != NULL; ring = ring->next) {
+        while (ring->tail != ring->head) {
+            void *element = ring->elements[ring->tail % RING_DEPTH];
 
-    ib_lock_unlock(writer->records_lck);
+            /* Take the record before releasing the slot to its producer. */
+            __sync_synchronize();
+            ring->tail = ring->tail + 1;
 
-    return rc;
+            logger_handler(element, &logger_handler_cbdata);
+        }
+    }
+
+    ib_lock_unlock(writer->drain_lck);
+
+    return IB_OK;
 }
 
 size_t ib_logger_writer_count(ib_logger_t *logger) {
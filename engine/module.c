@@ -30,6 +30,7 @@
 #include "module_private.h"
 #include "engine_private.h"
 
+#include <ironbee/clock.h>
 #include <ironbee/context.h>
 #include <ironbee/dso.h>
 #include <ironbee/mm.h>
@@ -136,6 +137,8 @@ ib_status_t ib_module_register(const ib_module_t *mod, ib_engine_t *ib)
 
     /* Init and register the module */
     if (m->fn_init != NULL) {
+        ib_time_t init_start = ib_clock_get_time();
+
         rc = m->fn_init(ib, m, m->cbdata_init);
         if (rc != IB_OK) {
             ib_log_error(ib, "Error initializing module %s: %s",
@@ -144,6 +147,13 @@ ib_status_t ib_module_register(const ib_module_t *mod, ib_engine_t *ib)
             ib_array_setn(ib->modules, m->idx, NULL);
             return rc;
         }
+
+        /* Expose per-module initialization cost; slow module init
+         * dominates engine startup time. */
+        ib_log_debug2(ib,
+                      "Initialized module %s in %" PRIu64 " usec",
+                      m->name,
+                      (uint64_t)(ib_clock_get_time() - init_start));
     }
 
     return IB_OK;
@@ -297,13 +307,89 @@ void ib_module_unload(ib_module_t *m)
     }
 }
 
+/**
+ * Copy module configuration data into context-owned memory.
+ *
+ * Allocates a fresh copy of @a src_data from the context's memory manager,
+ * copies it via the module's @c fn_cfg_copy handler (or @c memcpy), and
+ * points the context's config map at the new copy.
+ *
+ * @param[in] m Module
+ * @param[in] ctx Configuration context
+ * @param[in,out] cfgdata Configuration data to receive the copy
+ * @param[in] src_data Source configuration data
+ * @param[in] src_length Length of @a src_data
+ *
+ * @returns Status code
+ */
+static ib_status_t module_config_copy(ib_module_t *m,
+                                      ib_context_t *ctx,
+                                      ib_context_data_t *cfgdata,
+                                      const void *src_data,
+                                      size_t src_length)
+{
+    ib_status_t rc;
+
+    cfgdata->data = ib_mm_calloc(ctx->mm, 1, src_length);
+    if (cfgdata->data == NULL) {
+        return IB_EALLOC;
+    }
+    cfgdata->data_length = src_length;
+    if (m->fn_cfg_copy) {
+        rc = m->fn_cfg_copy(
+            m->ib, m,
+            cfgdata->data,
+            src_data, src_length,
+            m->cbdata_cfg_copy
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else {
+        memcpy(
+            cfgdata->data,
+            src_data, src_length
+        );
+    }
+    ib_context_init_cfg(ctx, cfgdata->data, m->cm_init);
+
+    return IB_OK;
+}
+
+ib_status_t ib_module_config_unshare(ib_context_t *ctx,
+                                     ib_context_data_t *cfgdata)
+{
+    assert(ctx != NULL);
+    assert(cfgdata != NULL);
+
+    ib_status_t rc;
+    void *src_data;
+
+    if (! cfgdata->shared) {
+        return IB_OK;
+    }
+
+    src_data = cfgdata->data;
+    rc = module_config_copy(
+        cfgdata->module, ctx, cfgdata,
+        src_data, cfgdata->data_length
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    cfgdata->shared = false;
+
+    return IB_OK;
+}
+
 ib_status_t ib_module_register_context(ib_module_t *m,
                                        ib_context_t *ctx)
 {
     ib_context_data_t *cfgdata;
     ib_status_t rc;
     ib_context_t *p_ctx = ctx->parent;
-    ib_context_data_t *p_cfgdata;
+    ib_context_data_t *p_cfgdata = NULL;
 
     void *src_data = NULL;
     size_t src_length;
@@ -329,29 +415,25 @@ ib_status_t ib_module_register_context(ib_module_t *m,
     }
 
     if (src_length > 0) {
-        cfgdata->data = ib_mm_calloc(ctx->mm, 1, src_length);
-        if (cfgdata->data == NULL) {
-            return IB_EALLOC;
+        if (m->cm_init == NULL) {
+            /* Copy-on-write: alias the source data until something
+             * writes to this context's copy (see
+             * ib_module_config_unshare()).  Modules with a config map
+             * must be copied eagerly as the map's field aliases have to
+             * point into this context's own data. */
+            cfgdata->data = src_data;
+            cfgdata->data_length = src_length;
+            cfgdata->shared = true;
+            if (p_cfgdata != NULL && p_cfgdata->data == src_data) {
+                p_cfgdata->shared = true;
+            }
         }
-        cfgdata->data_length = src_length;
-        if (m->fn_cfg_copy) {
-            rc = m->fn_cfg_copy(
-                m->ib, m,
-                cfgdata->data,
-                src_data, src_length,
-                m->cbdata_cfg_copy
-            );
+        else {
+            rc = module_config_copy(m, ctx, cfgdata, src_data, src_length);
             if (rc != IB_OK) {
                 return rc;
             }
         }
-        else {
-            memcpy(
-                cfgdata->data,
-                src_data, src_length
-            );
-        }
-        ib_context_init_cfg(ctx, cfgdata->data, m->cm_init);
     }
 
     /* Keep track of module specific context data using the
@@ -28,7 +28,12 @@
 
 #include "engine_private.h"
 
+#include <ironbee/context.h>
+#include <ironbee/metrics.h>
+#include <ironbee/mm_mpool_lite.h>
+
 #include <assert.h>
+#include <string.h>
 
 struct ib_operator_t {
     /*! Name of the operator. */
@@ -116,6 +121,13 @@ ib_status_t ib_operator_register(
 
     ib_status_t rc;
 
+    /* The registry is read without locking on per-transaction paths;
+     * it is frozen once configuration completes so that lookups never
+     * race a mutation. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
     rc = ib_hash_get(ib->operators, NULL, op->name);
     if (rc == IB_OK) {
         /* Already exists. */
@@ -137,6 +149,11 @@ ib_status_t ib_operator_stream_register(
 
     ib_status_t rc;
 
+    /* See ib_operator_register(): frozen after configuration. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
     rc = ib_hash_get(ib->stream_operators, NULL, op->name);
     if (rc == IB_OK) {
         /* Already exists. */
@@ -302,12 +319,58 @@ void cleanup_op(
 }
 
 
-ib_status_t ib_operator_inst_create(
+/**
+ * Build the intern table key for a shared operator instance.
+ *
+ * The key is the operator pointer followed by the parameter bytes.
+ *
+ * @param[in] mm Memory manager to allocate the key from.
+ * @param[in] op Operator.
+ * @param[in] parameters Parameters.  May be NULL.
+ * @param[out] key The key.
+ * @param[out] key_length Length of @a key.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t operator_inst_cache_key(
+    ib_mm_t               mm,
+    const ib_operator_t  *op,
+    const char           *parameters,
+    const char          **key,
+    size_t               *key_length
+)
+{
+    size_t parameters_length = (parameters == NULL) ? 0 : strlen(parameters);
+    char *local_key;
+
+    local_key = ib_mm_alloc(mm, sizeof(op) + parameters_length);
+    if (local_key == NULL) {
+        return IB_EALLOC;
+    }
+    memcpy(local_key, &op, sizeof(op));
+    if (parameters_length > 0) {
+        memcpy(local_key + sizeof(op), parameters, parameters_length);
+    }
+
+    *key = local_key;
+    *key_length = sizeof(op) + parameters_length;
+
+    return IB_OK;
+}
+
+/**
+ * Create an operator instance; see ib_operator_inst_create().
+ *
+ * This is the unshared creation path: the capability check has been done
+ * and the intern table has been consulted by the caller.
+ */
+static ib_status_t operator_inst_create_impl(
     ib_operator_inst_t  **op_inst,
     ib_mm_t               mm,
     ib_context_t         *ctx,
     const ib_operator_t  *op,
-    ib_flags_t            required_capabilities,
     const char           *parameters
 )
 {
@@ -315,14 +378,6 @@ ib_status_t ib_operator_inst_create(
     assert(ctx != NULL);
     assert(op != NULL);
 
-    /* Verify that this operator is valid for this rule type */
-    if (
-        (op->capabilities & required_capabilities) !=
-        required_capabilities
-    ) {
-        return IB_EINVAL;
-    }
-
     ib_operator_inst_t *local_op_inst;
     ib_status_t rc;
 
@@ -372,6 +427,92 @@ ib_status_t ib_operator_inst_create(
     return IB_OK;
 }
 
+ib_status_t ib_operator_inst_create(
+    ib_operator_inst_t  **op_inst,
+    ib_mm_t               mm,
+    ib_context_t         *ctx,
+    const ib_operator_t  *op,
+    ib_flags_t            required_capabilities,
+    const char           *parameters
+)
+{
+    assert(op_inst != NULL);
+    assert(ctx != NULL);
+    assert(op != NULL);
+
+    ib_engine_t *ib = ib_context_get_engine(ctx);
+    ib_status_t rc;
+
+    /* Verify that this operator is valid for this rule type */
+    if (
+        (op->capabilities & required_capabilities) !=
+        required_capabilities
+    ) {
+        return IB_EINVAL;
+    }
+
+    /* Intern instances of shareable operators: every context inheriting
+     * a rule with the same operator and parameters reuses one instance.
+     * The cache is only consulted and populated during configuration,
+     * which is single threaded; instances created afterwards are private
+     * to their caller. */
+    if (
+        (op->capabilities & IB_OP_CAPABILITY_SHAREABLE) &&
+        (ib->cfg_state != CFG_FINISHED)
+    ) {
+        ib_mpool_lite_t *mpl;
+        const char *key;
+        size_t key_length;
+        ib_operator_inst_t *shared;
+
+        rc = ib_mpool_lite_create(&mpl);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = operator_inst_cache_key(
+            ib_mm_mpool_lite(mpl), op, parameters, &key, &key_length
+        );
+        if (rc != IB_OK) {
+            ib_mpool_lite_destroy(mpl);
+            return rc;
+        }
+
+        rc = ib_hash_get_ex(ib->operator_inst_cache, &shared, key, key_length);
+        ib_mpool_lite_destroy(mpl);
+        if (rc == IB_OK) {
+            *op_inst = shared;
+            return IB_OK;
+        }
+
+        /* Shared instances live as long as the engine, regardless of the
+         * caller's memory manager. */
+        rc = operator_inst_create_impl(
+            &shared, ib_engine_mm_main_get(ib), ctx, op, parameters
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = operator_inst_cache_key(
+            ib_engine_mm_main_get(ib), op, parameters, &key, &key_length
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_hash_set_ex(
+            ib->operator_inst_cache, key, key_length, shared
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        *op_inst = shared;
+        return IB_OK;
+    }
+
+    return operator_inst_create_impl(op_inst, mm, ctx, op, parameters);
+}
 
 const ib_operator_t *ib_operator_inst_operator(
     const ib_operator_inst_t *op_inst
@@ -413,6 +554,13 @@ ib_status_t ib_operator_inst_execute(
 
     const ib_operator_t *op = ib_operator_inst_operator(op_inst);
 
+    /* Count every operator invocation, streamed or phased. */
+    static const ib_metric_t *metric = NULL;
+    if (metric == NULL) {
+        metric = ib_metric_acquire("operator.invocations", IB_METRIC_COUNTER);
+    }
+    ib_metric_add(metric, 1);
+
     assert(op != NULL);
 
     if (op->execute_fn == NULL) {
@@ -161,6 +161,80 @@ ib_status_t ib_parsed_headers_add(
     return IB_OK;
 }
 
+ib_status_t ib_parsed_headers_add_batch(
+    ib_parsed_headers_t *headers,
+    const struct iovec  *fields,
+    size_t               count
+)
+{
+    assert(headers != NULL);
+    assert(fields != NULL || count == 0);
+
+    ib_status_t         rc;
+    ib_parsed_header_t *eles;
+    uint8_t            *buf;
+    size_t              total = 0;
+    size_t              i;
+
+    if (count == 0) {
+        return IB_OK;
+    }
+
+    /* All list elements come from a single allocation... */
+    eles = ib_mm_alloc(headers->mm, count * sizeof(*eles));
+    if (eles == NULL) {
+        return IB_EALLOC;
+    }
+
+    /* ...as do all of the copied name and value bytes. */
+    for (i = 0; i < 2 * count; ++i) {
+        total += fields[i].iov_len;
+    }
+    buf = ib_mm_alloc(headers->mm, total);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    for (i = 0; i < count; ++i) {
+        ib_parsed_header_t *ele   = &eles[i];
+        const struct iovec *name  = &fields[2 * i];
+        const struct iovec *value = &fields[2 * i + 1];
+
+        assert(name->iov_base  != NULL);
+        assert(value->iov_base != NULL);
+
+        memcpy(buf, name->iov_base, name->iov_len);
+        rc = ib_bytestr_alias_mem(
+            &ele->name, headers->mm, buf, name->iov_len);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        buf += name->iov_len;
+
+        memcpy(buf, value->iov_base, value->iov_len);
+        rc = ib_bytestr_alias_mem(
+            &ele->value, headers->mm, buf, value->iov_len);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        buf += value->iov_len;
+
+        ele->next = (i + 1 < count) ? &eles[i + 1] : NULL;
+    }
+
+    /* Splice the block onto the list in one step. */
+    if (headers->head == NULL) {
+        headers->head = &eles[0];
+    }
+    else {
+        headers->tail->next = &eles[0];
+    }
+    headers->tail  = &eles[count - 1];
+    headers->size += count;
+
+    return IB_OK;
+}
+
 ib_status_t ib_parsed_resp_line_create(
     ib_parsed_resp_line_t **line,
     ib_mm_t                 mm,
@@ -40,9 +40,19 @@
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
 #include <ironbee/flags.h>
+#include <ironbee/flightrec.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool.h>
+#include <ironbee/mpool_lite.h>
 #include <ironbee/operator.h>
+#include <ironbee/profiler.h>
 #include <ironbee/rule_logger.h>
+#include <ironbee/stream_io.h>
+#include <ironbee/stream_processor.h>
+#include <ironbee/stream_pump.h>
 #include <ironbee/string.h>
 #include <ironbee/transformation.h>
 #include <ironbee/util.h>
@@ -324,20 +334,24 @@ typedef struct {
 
 /**
  * Items on the rule execution object stack
+ *
+ * Frames double as their own stack and free list links; popped frames
+ * are recycled through rule_exec->frame_pool instead of reallocated.
  */
-typedef struct {
-    ib_rule_t              *rule;        /**< The currently rule */
-    ib_rule_log_exec_t     *exec_log;    /**< Rule execution logging object */
-    ib_rule_target_t       *target;      /**< The current rule target */
-    ib_num_t                result;      /**< Rule execution result */
-} rule_exec_stack_frame_t;
+typedef struct rule_exec_stack_frame_t rule_exec_stack_frame_t;
+struct rule_exec_stack_frame_t {
+    ib_rule_t               *rule;      /**< The currently rule */
+    ib_rule_log_exec_t      *exec_log;  /**< Rule execution logging object */
+    ib_rule_target_t        *target;    /**< The current rule target */
+    ib_num_t                 result;    /**< Rule execution result */
+    rule_exec_stack_frame_t *next;      /**< Next frame down (or free). */
+};
 
 /**
- * The rule engine uses recursion to walk through lists and chains.  These
- * define the limits of the recursion depth.
+ * The rule engine uses recursion to walk through lists.  This defines
+ * the limit of the recursion depth.  Chains execute iteratively.
  */
 #define MAX_LIST_RECURSION   (5)       /**< Max list recursion limit */
-#define MAX_CHAIN_RECURSION  (10)      /**< Max chain recursion limit */
 
 ib_status_t ib_rule_set_invert(ib_rule_t *rule, bool invert)
 {
@@ -453,6 +467,31 @@ static const char *phase_name(
     }
 }
 
+/**
+ * Profiler tag for rules of @a phase_meta's phase, registered on first
+ * use.
+ *
+ * @param[in] phase_meta Rule phase meta-data
+ *
+ * @returns The profiler tag, or -1 if the tag table is full.
+ */
+static int phase_profiler_tag(const ib_rule_phase_meta_t *phase_meta)
+{
+    /* Cached tags, offset by one so that zero means "not yet looked
+     * up" and -1 means "lookup failed; do not retry". */
+    static int tags[IB_RULE_PHASE_COUNT];
+
+    int entry = tags[phase_meta->phase_num];
+
+    if (entry == 0) {
+        int tag = ib_profiler_tag(phase_name(phase_meta));
+        entry = (tag >= 0) ? tag + 1 : -1;
+        tags[phase_meta->phase_num] = entry;
+    }
+
+    return (entry > 0) ? entry - 1 : -1;
+}
+
 /**
  * Return a phase's description string
  *
@@ -503,35 +542,226 @@ static ib_status_t find_meta(
     return IB_ENOENT;
 }
 
+/**
+ * Name of the capture collection a rule captures to.
+ *
+ * @param[in] rule The rule.
+ * @return The configured collection name or the default.
+ **/
+static const char *capture_collection_name(const ib_rule_t *rule)
+{
+    assert(rule != NULL);
+
+    if (rule->capture_collection != NULL) {
+        return rule->capture_collection;
+    }
+    return IB_TX_CAPTURE;
+}
+
+/**
+ * Seed the capture arena from the var store collection @a name.
+ *
+ * Gives operators that accumulate captures across executions (e.g. the
+ * streaming dfa operator) their previously published items.  A missing
+ * or non-list collection leaves the arena empty.
+ *
+ * @param[in] rule_exec Rule execution environment.
+ * @param[in] name Collection name to seed from.
+ *
+ * @returns Status code
+ **/
+static ib_status_t seed_capture_arena(
+    ib_rule_exec_t *rule_exec,
+    const char     *name
+)
+{
+    assert(rule_exec != NULL);
+    assert(rule_exec->capture_arena != NULL);
+    assert(name != NULL);
+
+    ib_status_t           rc;
+    ib_var_source_t      *source;
+    ib_field_t           *collection = NULL;
+    const ib_list_t      *src_list;
+    ib_list_t            *dst_list = NULL;
+    const ib_list_node_t *node;
+
+    rc = ib_field_mutable_value(
+        rule_exec->capture_arena,
+        ib_ftype_list_mutable_out(&dst_list)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_list_clear(dst_list);
+
+    rc = ib_var_source_acquire(
+        &source,
+        rule_exec->tx->mm,
+        ib_engine_var_config_get(rule_exec->ib),
+        name, strlen(name)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_var_source_get(source, &collection, rule_exec->tx->var_store);
+    if (
+        rc == IB_ENOENT ||
+        (rc == IB_OK && collection->type != IB_FTYPE_LIST)
+    )
+    {
+        return IB_OK;
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_field_value(collection, ib_ftype_list_out(&src_list));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    IB_LIST_LOOP_CONST(src_list, node) {
+        rc = ib_list_push(dst_list, (void *)ib_list_node_data_const(node));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
 /**
  * Get a capture collection for a rule_exec.
  *
+ * Capturing rules share the rule_exec's reusable capture arena, which
+ * is allocated once per transaction and reset (not reallocated) when a
+ * rule names a different collection than the arena currently mirrors.
+ * Operators write captures into it; publish_capture() copies them out
+ * to the transaction var store once the operator has actually matched.
+ *
  * @param[in] rule_exec Rule execution environment.
  * @return Capture collection or NULL if unneeded or error (will log).
  **/
 static ib_field_t *get_capture(ib_rule_exec_t *rule_exec)
 {
-    ib_field_t *capture = NULL;
     ib_status_t rc;
+    const char *name;
+
     if (
-        rule_exec->rule != NULL &&
-        ib_flags_all(rule_exec->rule->flags, IB_RULE_FLAG_CAPTURE)
+        rule_exec->rule == NULL ||
+        ! ib_flags_all(rule_exec->rule->flags, IB_RULE_FLAG_CAPTURE)
     )
     {
-        rc = ib_capture_acquire(
-            rule_exec->tx,
-            rule_exec->rule->capture_collection,
-            &capture
-        );
+        return NULL;
+    }
+
+    if (rule_exec->capture_arena == NULL) {
+        ib_list_t  *list;
+        ib_field_t *arena = NULL;
+
+        rc = ib_list_create(&list, rule_exec->tx->mm);
+        if (rc == IB_OK) {
+            rc = ib_field_create_no_copy(
+                &arena,
+                rule_exec->tx->mm,
+                IB_TX_CAPTURE, strlen(IB_TX_CAPTURE),
+                IB_FTYPE_LIST,
+                ib_ftype_list_mutable_in(list)
+            );
+        }
         if (rc != IB_OK) {
             ib_rule_log_error(rule_exec,
                 "Failed to create capture collection: %s",
                 ib_status_to_string(rc)
             );
-            capture = NULL;
+            return NULL;
+        }
+        rule_exec->capture_arena = arena;
+    }
+
+    /* Reseed the arena when the rule captures to another collection. */
+    name = capture_collection_name(rule_exec->rule);
+    if (
+        rule_exec->capture_arena_owner == NULL ||
+        strcasecmp(rule_exec->capture_arena_owner, name) != 0
+    )
+    {
+        rc = seed_capture_arena(rule_exec, name);
+        if (rc != IB_OK) {
+            ib_rule_log_error(rule_exec,
+                "Failed to seed capture collection: %s",
+                ib_status_to_string(rc)
+            );
+            return NULL;
+        }
+        rule_exec->capture_arena_owner = name;
+    }
+
+    return rule_exec->capture_arena;
+}
+
+/**
+ * Publish the capture arena to the transaction var store.
+ *
+ * Called after a capturing rule's operator returns true.  Copies the
+ * arena's items into the rule's capture collection in the var store,
+ * creating the collection on first use.  The items themselves were
+ * allocated from the transaction memory manager by the operator and
+ * are shared, not duplicated.  Rules whose operators never match pay
+ * no var store work at all.
+ *
+ * @param[in] rule_exec Rule execution environment.
+ *
+ * @returns Status code
+ */
+static ib_status_t publish_capture(ib_rule_exec_t *rule_exec)
+{
+    assert(rule_exec != NULL);
+    assert(rule_exec->rule != NULL);
+
+    ib_status_t           rc;
+    ib_list_t            *list = NULL;
+    const ib_list_node_t *node;
+    ib_field_t           *collection;
+
+    if (rule_exec->capture_arena == NULL) {
+        return IB_OK;
+    }
+
+    rc = ib_field_mutable_value(
+        rule_exec->capture_arena,
+        ib_ftype_list_mutable_out(&list)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    if (ib_list_elements(list) == 0) {
+        return IB_OK;
+    }
+
+    rc = ib_capture_acquire(
+        rule_exec->tx,
+        rule_exec->rule->capture_collection,
+        &collection
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_capture_clear(collection);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    IB_LIST_LOOP_CONST(list, node) {
+        rc = ib_capture_add_item(
+            collection,
+            (ib_field_t *)ib_list_node_data_const(node)
+        );
+        if (rc != IB_OK) {
+            return rc;
         }
     }
-    return capture;
+
+    return IB_OK;
 }
 
 /**
@@ -558,13 +788,9 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
     exec->ib = tx->ib;
     exec->tx = tx;
 
-    /* Create the rule stack */
-    rc = ib_list_create(&(exec->rule_stack), tx->mm);
-    if (rc != IB_OK) {
-        ib_rule_log_tx_error(tx, "Failed to create rule stack: %s",
-                             ib_status_to_string(rc));
-        return rc;
-    }
+    /* Empty rule stack and frame pool; frames allocate on first use. */
+    exec->frame_stack = NULL;
+    exec->frame_pool = NULL;
 
     /* Create the phase rule list */
     rc = ib_list_create(&(exec->phase_rules), tx->mm);
@@ -582,6 +808,31 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
         return rc;
     }
 
+    /* Create the scratch arena; destroyed with the transaction pool. */
+    rc = ib_mpool_create(&(exec->scratch_mp), "rule_exec/scratch", tx->mp);
+    if (rc != IB_OK) {
+        ib_rule_log_tx_error(tx, "Failed to create scratch pool: %s",
+                             ib_status_to_string(rc));
+        return rc;
+    }
+    exec->scratch_mm = ib_mm_mpool(exec->scratch_mp);
+
+    /* Create the transformed value memo. */
+    rc = ib_hash_create(&(exec->tfn_memo), tx->mm);
+    if (rc != IB_OK) {
+        ib_rule_log_tx_error(tx, "Failed to create transformation memo: %s",
+                             ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* Create the operator result memo. */
+    rc = ib_hash_create(&(exec->op_memo), tx->mm);
+    if (rc != IB_OK) {
+        ib_rule_log_tx_error(tx, "Failed to create operator memo: %s",
+                             ib_status_to_string(rc));
+        return rc;
+    }
+
     /* Create the TX log object */
     rc = ib_rule_log_tx_create(exec, &(exec->tx_log));
     if (rc != IB_OK) {
@@ -597,6 +848,8 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
     exec->rule_status = IB_OK;
     exec->rule_result = 0;
     exec->exec_log = NULL;
+    exec->capture_arena = NULL;
+    exec->capture_arena_owner = NULL;
 
 #ifdef IB_RULE_TRACE
     exec->traces = ib_mm_calloc(
@@ -638,12 +891,18 @@ static ib_status_t rule_exec_push_rule(ib_rule_exec_t *rule_exec,
     rule_exec->rule_status = IB_OK;
     rule_exec->rule_result = 0;
 
-    /* Create a new stack frame */
-    frame = ib_mm_alloc(rule_exec->tx->mm, sizeof(*frame));
-    if (frame == NULL) {
-        ib_rule_log_error(rule_exec,
-                          "Rule engine: Failed to allocate stack frame");
-        return IB_EALLOC;
+    /* Reuse a recycled stack frame, allocating only on first use. */
+    frame = (rule_exec_stack_frame_t *)rule_exec->frame_pool;
+    if (frame != NULL) {
+        rule_exec->frame_pool = frame->next;
+    }
+    else {
+        frame = ib_mm_alloc(rule_exec->tx->mm, sizeof(*frame));
+        if (frame == NULL) {
+            ib_rule_log_error(rule_exec,
+                              "Rule engine: Failed to allocate stack frame");
+            return IB_EALLOC;
+        }
     }
 
     /* Fill in the stack frame from the current state and push it */
@@ -651,13 +910,8 @@ static ib_status_t rule_exec_push_rule(ib_rule_exec_t *rule_exec,
     frame->exec_log = rule_exec->exec_log;
     frame->target = rule_exec->target;
     frame->result = rule_exec->rule_result;
-    rc = ib_list_push(rule_exec->rule_stack, frame);
-    if (rc != IB_OK) {
-        ib_rule_log_error(rule_exec,
-                          "Rule engine: Failed to add rule to rule stack: %s",
-                          ib_status_to_string(rc));
-        return rc;
-    }
+    frame->next = (rule_exec_stack_frame_t *)rule_exec->frame_stack;
+    rule_exec->frame_stack = frame;
 
     /* Add the rule to the object *before* creating the rule exec logger */
     rule_exec->rule = (ib_rule_t *)rule;
@@ -686,23 +940,26 @@ static ib_status_t rule_exec_pop_rule(ib_rule_exec_t *rule_exec)
 {
     assert(rule_exec != NULL);
 
-    ib_status_t              rc;
     rule_exec_stack_frame_t *frame;
 
-    rc = ib_list_pop(rule_exec->rule_stack, &frame);
-    if (rc != IB_OK) {
+    frame = (rule_exec_stack_frame_t *)rule_exec->frame_stack;
+    if (frame == NULL) {
         ib_rule_log_error(rule_exec,
                           "Rule engine: Failed to pop rule from stack: %s",
-                          ib_status_to_string(rc));
-        return rc;
+                          ib_status_to_string(IB_ENOENT));
+        return IB_ENOENT;
     }
+    rule_exec->frame_stack = frame->next;
 
     /* Copy the items from the stack frame into the rule execution object */
     rule_exec->rule = frame->rule;
-    rule_exec->rule = frame->rule;
     rule_exec->target = frame->target;
     rule_exec->rule_result = frame->result;
 
+    /* Recycle the frame. */
+    frame->next = (rule_exec_stack_frame_t *)rule_exec->frame_pool;
+    rule_exec->frame_pool = frame;
+
     return IB_OK;
 }
 
@@ -755,6 +1012,284 @@ static void rule_exec_pop_value(ib_rule_exec_t *rule_exec,
     return;
 }
 
+/**
+ * An entry in the per-transaction transformed value memo.
+ *
+ * Keyed by the input field pointer and the transformation chain, an entry
+ * records the transformed result together with enough state to detect that
+ * the input has changed since it was computed: the source generation
+ * catches every change made through the var API, the bytestring data
+ * pointer and length catch in-place re-aliasing, and the element count
+ * catches in-place growth of a collection.
+ */
+typedef struct {
+    uint32_t          generation;  /**< Source generation when computed. */
+    const uint8_t    *data;        /**< Bytestring data, or NULL for lists. */
+    size_t            length;      /**< Bytestring length or element count. */
+    const ib_field_t *result;      /**< The transformed value. */
+} tfn_memo_entry_t;
+
+/**
+ * Can the transformed value of @a value be memoized for @a rule_exec?
+ *
+ * Memoization requires that @a value be exactly the field the target's
+ * source is bound to in the var store -- such fields live for the whole
+ * transaction, so their pointers are stable memo keys.  Temporaries
+ * (filtered results, dynamic query results, list wrappers) come from
+ * shorter lived pools and are never memoized.  The source must also be
+ * indexed so that its generation is available, and only bytestring and
+ * list values are considered; scalars can be mutated in place without any
+ * observable trace.
+ *
+ * @param[in]  rule_exec  The rule execution object.
+ * @param[in]  value      Initial value of the target field.
+ * @param[out] generation Source generation, on true.
+ *
+ * @returns True iff the transformed value may be memoized.
+ */
+static bool tfn_memo_usable(
+    const ib_rule_exec_t *rule_exec,
+    const ib_field_t     *value,
+    uint32_t             *generation
+)
+{
+    assert(rule_exec != NULL);
+    assert(value != NULL);
+    assert(generation != NULL);
+
+    ib_status_t       rc;
+    ib_var_source_t  *source;
+    const ib_field_t *stored = NULL;
+
+    if (value->type != IB_FTYPE_BYTESTR && value->type != IB_FTYPE_LIST) {
+        return false;
+    }
+
+    if (rule_exec->target == NULL || rule_exec->target->target == NULL) {
+        return false;
+    }
+
+    source = ib_var_target_source(rule_exec->target->target);
+    if (source == NULL) {
+        return false;
+    }
+
+    rc = ib_var_source_get_const(source, &stored, rule_exec->tx->var_store);
+    if (rc != IB_OK || stored != value) {
+        return false;
+    }
+
+    rc = ib_var_source_generation(
+        source, rule_exec->tx->var_store, generation
+    );
+
+    return rc == IB_OK;
+}
+
+/**
+ * Build the memo key for @a value and the current target's chain.
+ *
+ * The key is the input field pointer followed by, for each transformation
+ * instance, the transformation pointer (shared across rules via the
+ * engine registry) and the length and bytes of its parameters.  Identical
+ * chains configured on different rules thus produce identical keys.
+ *
+ * @param[in]  rule_exec  The rule execution object.
+ * @param[in]  value      Initial value of the target field.
+ * @param[in]  mm         Memory manager to build the key from.
+ * @param[out] key        The key.
+ * @param[out] key_length Length of @a key.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t tfn_memo_key(
+    const ib_rule_exec_t  *rule_exec,
+    const ib_field_t      *value,
+    ib_mm_t                mm,
+    const uint8_t        **key,
+    size_t                *key_length
+)
+{
+    assert(rule_exec != NULL);
+    assert(value != NULL);
+    assert(key != NULL);
+    assert(key_length != NULL);
+
+    const ib_list_node_t *node;
+    uint8_t              *buf;
+    size_t                length;
+
+    /* Size the key. */
+    length = sizeof(value);
+    IB_LIST_LOOP_CONST(rule_exec->target->tfn_list, node) {
+        const ib_transformation_inst_t *tfn_inst =
+            (const ib_transformation_inst_t *)ib_list_node_data_const(node);
+        const char *parameters =
+            ib_transformation_inst_parameters(tfn_inst);
+
+        length += sizeof(const ib_transformation_t *) + sizeof(size_t);
+        if (parameters != NULL) {
+            length += strlen(parameters);
+        }
+    }
+
+    buf = (uint8_t *)ib_mm_alloc(mm, length);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    /* Fill the key. */
+    length = 0;
+    memcpy(buf + length, &value, sizeof(value));
+    length += sizeof(value);
+    IB_LIST_LOOP_CONST(rule_exec->target->tfn_list, node) {
+        const ib_transformation_inst_t *tfn_inst =
+            (const ib_transformation_inst_t *)ib_list_node_data_const(node);
+        const ib_transformation_t *tfn =
+            ib_transformation_inst_transformation(tfn_inst);
+        const char *parameters =
+            ib_transformation_inst_parameters(tfn_inst);
+        size_t parameters_length =
+            (parameters != NULL) ? strlen(parameters) : 0;
+
+        memcpy(buf + length, &tfn, sizeof(tfn));
+        length += sizeof(tfn);
+        memcpy(buf + length, &parameters_length, sizeof(parameters_length));
+        length += sizeof(parameters_length);
+        if (parameters_length > 0) {
+            memcpy(buf + length, parameters, parameters_length);
+            length += parameters_length;
+        }
+    }
+
+    *key = buf;
+    *key_length = length;
+
+    return IB_OK;
+}
+
+/**
+ * Is @a entry still valid for @a value?
+ *
+ * @param[in] entry      Memo entry.
+ * @param[in] value      Current value of the target field.
+ * @param[in] generation Current source generation.
+ *
+ * @returns True iff @a entry may be reused.
+ */
+static bool tfn_memo_valid(
+    const tfn_memo_entry_t *entry,
+    const ib_field_t       *value,
+    uint32_t                generation
+)
+{
+    assert(entry != NULL);
+    assert(value != NULL);
+
+    ib_status_t rc;
+
+    if (entry->generation != generation) {
+        return false;
+    }
+
+    if (value->type == IB_FTYPE_BYTESTR) {
+        const ib_bytestr_t *bs;
+
+        rc = ib_field_value(value, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK || bs == NULL) {
+            return false;
+        }
+        return
+            entry->data == ib_bytestr_const_ptr(bs) &&
+            entry->length == ib_bytestr_length(bs);
+    }
+    else {
+        const ib_list_t *list;
+
+        rc = ib_field_value(value, ib_ftype_list_out(&list));
+        if (rc != IB_OK || list == NULL) {
+            return false;
+        }
+        return entry->data == NULL &&
+               entry->length == ib_list_elements(list);
+    }
+}
+
+/**
+ * Record the transformed value of @a value in the memo.
+ *
+ * @param[in] rule_exec  The rule execution object.
+ * @param[in] key        Memo key, allocated from scratch memory.
+ * @param[in] key_length Length of @a key.
+ * @param[in] value      Initial value of the target field.
+ * @param[in] generation Source generation.
+ * @param[in] result     The transformed value.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t tfn_memo_set(
+    const ib_rule_exec_t *rule_exec,
+    const uint8_t        *key,
+    size_t                key_length,
+    const ib_field_t     *value,
+    uint32_t              generation,
+    const ib_field_t     *result
+)
+{
+    assert(rule_exec != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+    assert(result != NULL);
+
+    ib_status_t       rc;
+    tfn_memo_entry_t *entry;
+    ib_mm_t           mm = rule_exec->tx->mm;
+
+    entry = (tfn_memo_entry_t *)ib_mm_alloc(mm, sizeof(*entry));
+    if (entry == NULL) {
+        return IB_EALLOC;
+    }
+
+    entry->generation = generation;
+    entry->result = result;
+    if (value->type == IB_FTYPE_BYTESTR) {
+        const ib_bytestr_t *bs;
+
+        rc = ib_field_value(value, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        entry->data = ib_bytestr_const_ptr(bs);
+        entry->length = ib_bytestr_length(bs);
+    }
+    else {
+        const ib_list_t *list;
+
+        assert(value->type == IB_FTYPE_LIST);
+        rc = ib_field_value(value, ib_ftype_list_out(&list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        entry->data = NULL;
+        entry->length = ib_list_elements(list);
+    }
+
+    /* The hash stores the key pointer; give it a transaction lifetime
+     * copy. */
+    key = (const uint8_t *)ib_mm_memdup(mm, key, key_length);
+    if (key == NULL) {
+        return IB_EALLOC;
+    }
+
+    return ib_hash_set_ex(
+        rule_exec->tfn_memo, (const char *)key, key_length, entry
+    );
+}
+
 /**
  * Execute a single transformation on a target.
  *
@@ -843,14 +1378,94 @@ static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
     ib_rule_log_trace(rule_exec, "Executing %zd transformations",
                       ib_list_elements(rule_exec->target->tfn_list));
 
+    /* Reuse a previously transformed value when possible: many rules
+     * apply the identical transformation chain to the same target within
+     * one transaction.  As with fusion below, memoization is skipped when
+     * execution logging is enabled so that every step is still observed. */
+    uint32_t       memo_generation = 0;
+    const uint8_t *memo_key        = NULL;
+    size_t         memo_key_length = 0;
+
+    if (
+        rule_exec->exec_log == NULL &&
+        tfn_memo_usable(rule_exec, value, &memo_generation)
+    ) {
+        rc = tfn_memo_key(
+            rule_exec, value, rule_exec->scratch_mm,
+            &memo_key, &memo_key_length
+        );
+        if (rc == IB_OK) {
+            tfn_memo_entry_t *entry;
+
+            rc = ib_hash_get_ex(
+                rule_exec->tfn_memo,
+                &entry,
+                (const char *)memo_key,
+                memo_key_length
+            );
+            if (rc == IB_OK && tfn_memo_valid(entry, value, memo_generation)) {
+                ib_rule_log_trace(
+                    rule_exec, "Reusing memoized transformed value"
+                );
+                *result = entry->result;
+                return IB_OK;
+            }
+        }
+        else {
+            memo_key = NULL;
+        }
+    }
+
     /*
      * Loop through all of the target's transformations.
      */
     in_field = value;
-    IB_LIST_LOOP_CONST(rule_exec->target->tfn_list, node) {
+    node = ib_list_first_const(rule_exec->target->tfn_list);
+    while (node != NULL) {
         const ib_transformation_inst_t  *tfn_inst =
             (const ib_transformation_inst_t *)ib_list_node_data_const(node);
 
+        /* Fuse runs of byte-level transformations into a single pass over
+         * one buffer.  Only when per-transformation execution logging is
+         * off; the stepwise path below is kept for logging as it
+         * materializes every intermediate value. */
+        if (rule_exec->exec_log == NULL) {
+            size_t                run = 0;
+            const ib_list_node_t *run_node = node;
+
+            while (
+                run_node != NULL &&
+                ib_transformation_fusible(
+                    ib_transformation_inst_transformation(
+                        (const ib_transformation_inst_t *)
+                            ib_list_node_data_const(run_node)
+                    )
+                )
+            )
+            {
+                ++run;
+                run_node = ib_list_node_next_const(run_node);
+            }
+
+            if (run >= 2) {
+                rc = ib_transformation_inst_execute_fused(
+                    node, run, rule_exec->tx->mm, in_field, &out
+                );
+                if (rc != IB_OK) {
+                    ib_rule_log_error(
+                        rule_exec,
+                        "Error executing fused target transformations: %s",
+                        ib_status_to_string(rc)
+                    );
+                    return rc;
+                }
+
+                in_field = out;
+                node = run_node;
+                continue;
+            }
+        }
+
         /* Run it */
         ib_rule_log_trace(
             rule_exec,
@@ -891,10 +1506,24 @@ static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
 
         /* The output of the operator is now input for the next field op. */
         in_field = out;
+        node = ib_list_node_next_const(node);
+    }
+
+    /* Memoize the transformed value for the rest of the transaction. */
+    if (memo_key != NULL) {
+        rc = tfn_memo_set(
+            rule_exec,
+            memo_key, memo_key_length,
+            value, memo_generation,
+            in_field
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
     }
 
     /* The output of the final operator is the result */
-    *result = out;
+    *result = in_field;
 
     /* Done. */
     return IB_OK;
@@ -1438,56 +2067,238 @@ static void exe_op_trace_values(ib_rule_exec_t *rule_exec,
                           target->target_str,
                           num);
     }
-    else if (value->type == IB_FTYPE_NULSTR) {
-        const char* nulstr;
-        const char *escaped;
+    else if (value->type == IB_FTYPE_NULSTR) {
+        const char* nulstr;
+        const char *escaped;
+
+        rc = ib_field_value(value, ib_ftype_nulstr_out(&nulstr));
+        if (rc != IB_OK) {
+            return;
+        }
+
+        escaped = ib_util_hex_escape(rule_exec->tx->mm,
+                                     (const uint8_t *)nulstr,
+                                     strlen(nulstr));
+        if (escaped == NULL) {
+            return;
+        }
+
+        ib_rule_log_trace(rule_exec,
+                          "Exec of op %s on target %s = %s",
+                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
+                          target->target_str,
+                          escaped);
+    }
+    else if (value->type == IB_FTYPE_BYTESTR) {
+        const char         *escaped;
+        const ib_bytestr_t *bytestr;
+
+        rc = ib_field_value(value, ib_ftype_bytestr_out(&bytestr));
+        if ( rc != IB_OK ) {
+            return;
+        }
+
+        escaped = ib_util_hex_escape(rule_exec->tx->mm,
+                                     ib_bytestr_const_ptr(bytestr),
+                                     ib_bytestr_size(bytestr));
+        if (escaped == NULL) {
+            return;
+        }
+        ib_rule_log_trace(rule_exec,
+                          "Exec of op %s on target %s = %s",
+                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
+                          target->target_str,
+                          escaped);
+    }
+    else {
+        ib_rule_log_trace(rule_exec,
+                          "Exec of op %s on target %s = %s",
+                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
+                          target->target_str,
+                          "[cannot decode field type]");
+    }
+}
+
+/**
+ * An entry in the per-transaction operator result memo.
+ *
+ * Keyed by the operator instance and input field pointers, an entry
+ * records the operator's outcome together with the bytestring data
+ * pointer and length observed at the time, so that a field whose value
+ * was replaced in place is detected and re-executed.
+ */
+typedef struct {
+    const uint8_t *data;   /**< Bytestring data when memoized. */
+    size_t         length; /**< Bytestring length when memoized. */
+    ib_status_t    op_rc;  /**< Status the operator returned. */
+    ib_num_t       result; /**< Result the operator produced. */
+} op_memo_entry_t;
+
+/**
+ * Can the operator invocation on @a value be memoized for @a rule_exec?
+ *
+ * Memoization requires an operator that declared its execution pure
+ * (@ref IB_OP_CAPABILITY_MEMOIZE), a non-capturing rule (a memo hit
+ * skips execution and thus any capture writes), and a bytestring input:
+ * scalars can be mutated in place without any observable trace, while a
+ * bytestring replacement is caught by comparing data pointer and length.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] opinst Operator instance about to execute.
+ * @param[in] value Input value, after transformation.
+ *
+ * @returns True iff the invocation may be memoized.
+ */
+static bool op_memo_usable(
+    ib_rule_exec_t           *rule_exec,
+    const ib_operator_inst_t *opinst,
+    const ib_field_t         *value
+)
+{
+    assert(rule_exec != NULL);
+    assert(opinst != NULL);
+
+    if (value == NULL || value->type != IB_FTYPE_BYTESTR) {
+        return false;
+    }
+    if (get_capture(rule_exec) != NULL) {
+        return false;
+    }
+    return ib_flags_all(
+        ib_operator_capabilities(ib_operator_inst_operator(opinst)),
+        IB_OP_CAPABILITY_MEMOIZE
+    );
+}
+
+/**
+ * Build the memo key for @a opinst applied to @a value.
+ *
+ * Operator instances of shareable operators are interned engine-wide,
+ * so rules configured with the same operator and parameters present the
+ * same instance pointer here.
+ *
+ * @param[in]  opinst Operator instance.
+ * @param[in]  value  Input value.
+ * @param[out] key    Key buffer of at least 2 pointers.
+ */
+static void op_memo_key(
+    const ib_operator_inst_t *opinst,
+    const ib_field_t         *value,
+    uint8_t                  *key
+)
+{
+    memcpy(key, &opinst, sizeof(opinst));
+    memcpy(key + sizeof(opinst), &value, sizeof(value));
+}
+
+/**
+ * Look up a memoized outcome of @a opinst on @a value.
+ *
+ * @param[in]  rule_exec The rule execution object.
+ * @param[in]  opinst    Operator instance.
+ * @param[in]  value     Input value.
+ * @param[out] op_rc     Memoized operator status, on true.
+ * @param[out] result    Memoized operator result, on true.
+ *
+ * @returns True iff a valid entry was found.
+ */
+static bool op_memo_get(
+    const ib_rule_exec_t     *rule_exec,
+    const ib_operator_inst_t *opinst,
+    const ib_field_t         *value,
+    ib_status_t              *op_rc,
+    ib_num_t                 *result
+)
+{
+    assert(rule_exec != NULL);
+    assert(opinst != NULL);
+    assert(value != NULL);
+    assert(op_rc != NULL);
+    assert(result != NULL);
+
+    ib_status_t         rc;
+    uint8_t             key[sizeof(opinst) + sizeof(value)];
+    op_memo_entry_t    *entry;
+    const ib_bytestr_t *bs;
+
+    op_memo_key(opinst, value, key);
+    rc = ib_hash_get_ex(
+        rule_exec->op_memo, &entry, (const char *)key, sizeof(key)
+    );
+    if (rc != IB_OK) {
+        return false;
+    }
+
+    rc = ib_field_value(value, ib_ftype_bytestr_out(&bs));
+    if (rc != IB_OK || bs == NULL) {
+        return false;
+    }
+    if ( (entry->data != ib_bytestr_const_ptr(bs))
+         || (entry->length != ib_bytestr_length(bs)) )
+    {
+        return false;
+    }
 
-        rc = ib_field_value(value, ib_ftype_nulstr_out(&nulstr));
-        if (rc != IB_OK) {
-            return;
-        }
+    *op_rc = entry->op_rc;
+    *result = entry->result;
+    return true;
+}
 
-        escaped = ib_util_hex_escape(rule_exec->tx->mm,
-                                     (const uint8_t *)nulstr,
-                                     strlen(nulstr));
-        if (escaped == NULL) {
-            return;
-        }
+/**
+ * Record the outcome of @a opinst on @a value in the memo.
+ *
+ * Failure to record is not reported; the next rule simply re-executes.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] opinst    Operator instance.
+ * @param[in] value     Input value.
+ * @param[in] op_rc     Status the operator returned.
+ * @param[in] result    Result the operator produced.
+ */
+static void op_memo_set(
+    const ib_rule_exec_t     *rule_exec,
+    const ib_operator_inst_t *opinst,
+    const ib_field_t         *value,
+    ib_status_t               op_rc,
+    ib_num_t                  result
+)
+{
+    assert(rule_exec != NULL);
+    assert(opinst != NULL);
+    assert(value != NULL);
 
-        ib_rule_log_trace(rule_exec,
-                          "Exec of op %s on target %s = %s",
-                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
-                          target->target_str,
-                          escaped);
+    ib_status_t         rc;
+    uint8_t             key[sizeof(opinst) + sizeof(value)];
+    uint8_t            *key_copy;
+    op_memo_entry_t    *entry;
+    const ib_bytestr_t *bs;
+    ib_mm_t             mm = rule_exec->tx->mm;
+
+    rc = ib_field_value(value, ib_ftype_bytestr_out(&bs));
+    if (rc != IB_OK || bs == NULL) {
+        return;
     }
-    else if (value->type == IB_FTYPE_BYTESTR) {
-        const char         *escaped;
-        const ib_bytestr_t *bytestr;
-
-        rc = ib_field_value(value, ib_ftype_bytestr_out(&bytestr));
-        if ( rc != IB_OK ) {
-            return;
-        }
 
-        escaped = ib_util_hex_escape(rule_exec->tx->mm,
-                                     ib_bytestr_const_ptr(bytestr),
-                                     ib_bytestr_size(bytestr));
-        if (escaped == NULL) {
-            return;
-        }
-        ib_rule_log_trace(rule_exec,
-                          "Exec of op %s on target %s = %s",
-                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
-                          target->target_str,
-                          escaped);
+    entry = (op_memo_entry_t *)ib_mm_alloc(mm, sizeof(*entry));
+    if (entry == NULL) {
+        return;
     }
-    else {
-        ib_rule_log_trace(rule_exec,
-                          "Exec of op %s on target %s = %s",
-                          ib_operator_name(ib_operator_inst_operator(opinst->opinst)),
-                          target->target_str,
-                          "[cannot decode field type]");
+    entry->data = ib_bytestr_const_ptr(bs);
+    entry->length = ib_bytestr_length(bs);
+    entry->op_rc = op_rc;
+    entry->result = result;
+
+    /* The hash stores the key pointer; give it a transaction lifetime
+     * copy. */
+    op_memo_key(opinst, value, key);
+    key_copy = (uint8_t *)ib_mm_memdup(mm, key, sizeof(key));
+    if (key_copy == NULL) {
+        return;
     }
+
+    ib_hash_set_ex(
+        rule_exec->op_memo, (const char *)key_copy, sizeof(key), entry
+    );
 }
 
 /**
@@ -1589,19 +2400,44 @@ static ib_status_t execute_phase_operator(ib_rule_exec_t *rule_exec,
             }
         }
 
-        /* @todo remove the cast-away of the constness of value */
-        op_rc = ib_operator_inst_execute(
-            opinst->opinst,
-            rule_exec->tx,
-            (ib_field_t *)value,
-            get_capture(rule_exec),
-            &result
-        );
+        /* Reuse a memoized result when a previous rule already executed
+         * this operator instance on this value. */
+        bool memo_usable = op_memo_usable(rule_exec, opinst->opinst, value);
+        bool memo_hit = false;
+        if (memo_usable) {
+            memo_hit = op_memo_get(
+                rule_exec, opinst->opinst, value, &op_rc, &result
+            );
+        }
+
+        if (! memo_hit) {
+            /* @todo remove the cast-away of the constness of value */
+            op_rc = ib_operator_inst_execute(
+                opinst->opinst,
+                rule_exec->tx,
+                (ib_field_t *)value,
+                get_capture(rule_exec),
+                &result
+            );
+            if (memo_usable) {
+                op_memo_set(rule_exec, opinst->opinst, value, op_rc, result);
+            }
+        }
         if (op_rc != IB_OK) {
             ib_rule_log_warn(rule_exec, "Operator returned an error: %s",
                              ib_status_to_string(op_rc));
         }
 
+        /* Copy captures out to the var store only on a match. */
+        if (op_rc == IB_OK && result != 0) {
+            ib_status_t trc = publish_capture(rule_exec);
+            if (trc != IB_OK) {
+                ib_rule_log_error(rule_exec,
+                                  "Failed to publish capture collection: %s",
+                                  ib_status_to_string(trc));
+            }
+        }
+
         {
             ib_list_node_t *node;
             IB_LIST_LOOP(rule_exec->ib->rule_engine->hooks.post_operator, node) {
@@ -1684,6 +2520,16 @@ static ib_status_t execute_ext_phase_rule_targets(
                           "External operator returned an error: %s",
                           ib_status_to_string(op_rc));
     }
+
+    /* Copy captures out to the var store only on a match. */
+    if (op_rc == IB_OK && result != 0) {
+        ib_status_t trc = publish_capture(rule_exec);
+        if (trc != IB_OK) {
+            ib_rule_log_error(rule_exec,
+                              "Failed to publish capture collection: %s",
+                              ib_status_to_string(trc));
+        }
+    }
     rc = ib_rule_log_exec_op(rule_exec->exec_log, opinst, op_rc);
     if (rc != IB_OK) {
         ib_rule_log_error(rule_exec,
@@ -1713,7 +2559,7 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
     ib_rule_t               *rule   = rule_exec->rule;
     ib_rule_operator_inst_t *opinst = rule_exec->rule->opinst;
     ib_status_t              rc     = IB_OK;
-    ib_list_node_t          *node   = NULL;
+    size_t                   target_num;
 
     /* Special case: External rules */
     if (ib_flags_all(rule->flags, IB_RULE_FLAG_EXTERNAL)) {
@@ -1725,14 +2571,28 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
 
     /* If this is a no-target rule (i.e. action), do nothing */
     if (ib_flags_all(rule->flags, IB_RULE_FLAG_NO_TGT)) {
-        assert(ib_list_elements(rule->target_fields) == 1);
+        assert(rule->num_targets == 1);
     }
     else {
-        assert(ib_list_elements(rule->target_fields) != 0);
+        assert(rule->num_targets != 0);
     }
 
+    /* Phase rules only run via plans built at context close, where
+     * freeze_rule_targets() snapshots target_fields into target_array. */
+    assert(rule->target_array != NULL);
+
     ib_rule_log_debug(rule_exec, "Operating on %zd fields.",
-                      ib_list_elements(rule->target_fields));
+                      rule->num_targets);
+
+    /* Target fetch temporaries (result lists, list wrappers, target name
+     * fields) normally die with the rule and come from the scratch arena.
+     * A capturing operator may store its input field in the capture
+     * collection, where it outlives the rule, so capturing rules spill to
+     * the transaction memory manager. */
+    ib_mm_t value_mm =
+        ib_flags_all(rule->flags, IB_RULE_FLAG_CAPTURE)
+        ? tx->mm
+        : rule_exec->scratch_mm;
 
     /* Loop through all of the fields.
      *
@@ -1740,15 +2600,14 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
      * returns an error.  This needs further discussion to determine what the
      * correct behavior should be.
      */
-    IB_LIST_LOOP(rule->target_fields, node) {
+    for (target_num = 0; target_num < rule->num_targets; ++target_num) {
         ib_status_t         getrc;
         ib_list_t          *result     = NULL;
         ib_field_t         *value      = NULL; /* Var. */
         const ib_field_t   *tfnvalue   = NULL; /* Var value after tfns */
         bool                pushed     = true;
         bool                pop_target = false;
-        ib_rule_target_t   *target     =
-            (ib_rule_target_t *)ib_list_node_data(node);
+        ib_rule_target_t   *target     = rule->target_array[target_num];
 
         assert(target != NULL);
 
@@ -1767,7 +2626,7 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
             getrc = ib_var_target_get(
                 target->target,
                 (const ib_list_t **)(&result),
-                tx->mm,
+                value_mm,
                 tx->var_store
             );
         }
@@ -1810,7 +2669,7 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
             else {
                 rc = ib_field_create(
                     &value,
-                    tx->mm,
+                    value_mm,
                     IB_S2SL(""),
                     IB_FTYPE_LIST,
                     ib_ftype_list_in(result)
@@ -1848,7 +2707,7 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
 
                 rc = ib_field_create(
                     &target_field,
-                    tx->mm,
+                    value_mm,
                     target_name,
                     target_name_len,
                     IB_FTYPE_GENERIC,
@@ -1956,21 +2815,73 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
     return rc;
 }
 
+/**
+ * Record one rule execution into the timing statistics
+ *
+ * Only called when timing is enabled; see the "ruletiming" control
+ * command.  All updates are atomic adds so transaction threads never
+ * block each other.
+ *
+ * @param[in] rule_engine Rule engine holding the statistics
+ * @param[in] rule Rule that executed
+ * @param[in] elapsed Wall time of the execution
+ */
+static void rule_timing_record(ib_rule_engine_t *rule_engine,
+                               const ib_rule_t *rule,
+                               ib_time_t elapsed)
+{
+    assert(rule_engine != NULL);
+    assert(rule != NULL);
+
+    ib_rule_timing_t *slot;
+    uint64_t          us = elapsed;
+    uint64_t          prev;
+    size_t            bucket;
+
+    if ( (rule_engine->timing.stats == NULL)
+         || (rule->meta.index >= rule_engine->timing.num_stats) )
+    {
+        return;
+    }
+    slot = &(rule_engine->timing.stats[rule->meta.index]);
+
+    /* Bucket by floor(log2(us)): bucket 0 holds executions under 2us,
+     * the last bucket collects everything at or above 2^(N-1) us. */
+    bucket = 0;
+    while ( ((us >> (bucket + 1)) != 0)
+            && (bucket < IB_RULE_TIMING_BUCKETS - 1) )
+    {
+        ++bucket;
+    }
+
+    __sync_fetch_and_add(&(slot->count), 1);
+    __sync_fetch_and_add(&(slot->total_us), us);
+    __sync_fetch_and_add(&(slot->buckets[bucket]), 1);
+    prev = slot->max_us;
+    while ( (us > prev)
+            && ! __sync_bool_compare_and_swap(&(slot->max_us), prev, us) )
+    {
+        prev = slot->max_us;
+    }
+}
+
 /**
  * Execute a single phase rule, it's actions, and it's chained rules.
  *
+ * Chain links execute iteratively at a single stack level, rather than
+ * by recursion, short-circuiting as soon as a link's result is false.
+ *
  * @param[in] rule_exec Rule execution object
  * @param[in] rule Rule to execute
- * @param[in] recursion Recursion limit
  *
  * @returns Status code
  */
 static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
-                                      const ib_rule_t *rule,
-                                      int recursion)
+                                      const ib_rule_t *rule)
 {
-    ib_status_t         rc = IB_OK;
-    ib_status_t         trc;          /* Temporary status code */
+    ib_status_t      rc = IB_OK;
+    ib_status_t      trc;          /* Temporary status code */
+    const ib_rule_t *link;
 #ifdef IB_RULE_TRACE
     ib_time_t pre_time;
     ib_time_t post_time;
@@ -1980,98 +2891,116 @@ static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
     assert(rule != NULL);
     assert(! rule->phase_meta->is_stream);
 
-    --recursion;
-    if (recursion <= 0) {
-        ib_rule_log_error(rule_exec,
-                          "Rule engine: Phase chain recursion limit reached");
-        return IB_EOTHER;
-    }
-
-    {
-        ib_list_node_t *node;
-        IB_LIST_LOOP(rule_exec->ib->rule_engine->hooks.pre_rule, node) {
-            const ib_rule_pre_rule_hook_t *hook =
-                (const ib_rule_pre_rule_hook_t *)
-                    ib_list_node_data_const(node);
-            hook->fn(rule_exec, hook->data);
-        }
-    }
-
-    /* Set the rule in the execution object */
-    rc = rule_exec_push_rule(rule_exec, rule);
-    if (rc != IB_OK) {
-        ib_rule_log_error(rule_exec,
-                          "Rule engine: "
-                          "Failed to set rule in execution object: %s",
-                          ib_status_to_string(rc));
-        return rc;
-    }
-
     /*
-     * Execute the rule operator on the target fields.
+     * Execute the chain's links in order.  Each link runs its operator
+     * on its targets and then its actions; the next link runs only when
+     * the current link's result is true.
      *
      * @todo The current behavior is to keep running even after an operator
      * returns an error.  This needs further discussion to determine what the
      * correct behavior should be.
      */
+    for (link = rule; link != NULL; link = link->chained_rule) {
+        ib_num_t link_result;
+
+        if (link != rule) {
+            ib_rule_log_debug(rule_exec,
+                              "Chaining to rule \"%s\"",
+                              ib_rule_id(link));
+        }
+
+        {
+            static const ib_metric_t *metric = NULL;
+            if (metric == NULL) {
+                metric = ib_metric_acquire("rule.executions",
+                                           IB_METRIC_COUNTER);
+            }
+            ib_metric_add(metric, 1);
+        }
+        ib_flightrec_record(IB_FLIGHTREC_RULE, link->meta.id, 0);
+
+        {
+            ib_list_node_t *node;
+            IB_LIST_LOOP(rule_exec->ib->rule_engine->hooks.pre_rule, node) {
+                const ib_rule_pre_rule_hook_t *hook =
+                    (const ib_rule_pre_rule_hook_t *)
+                        ib_list_node_data_const(node);
+                hook->fn(rule_exec, hook->data);
+            }
+        }
+
+        /* Set the rule in the execution object */
+        trc = rule_exec_push_rule(rule_exec, link);
+        if (trc != IB_OK) {
+            ib_rule_log_error(rule_exec,
+                              "Rule engine: "
+                              "Failed to set rule in execution object: %s",
+                              ib_status_to_string(trc));
+            return trc;
+        }
+
 #ifdef IB_RULE_TRACE
-    if (rule->flags & IB_RULE_FLAG_TRACE) {
-        pre_time = ib_clock_get_time();
-    }
+        if (link->flags & IB_RULE_FLAG_TRACE) {
+            pre_time = ib_clock_get_time();
+        }
 #endif
-    trc = execute_phase_rule_targets(rule_exec);
-    if (trc != IB_OK) {
-        rc = trc;
-        goto cleanup;
-    }
+        if (rule_exec->ib->rule_engine->timing.enabled) {
+            ib_time_t start = ib_clock_precise_get_time();
+            trc = execute_phase_rule_targets(rule_exec);
+            rule_timing_record(rule_exec->ib->rule_engine, link,
+                               ib_clock_precise_get_time() - start);
+        }
+        else {
+            trc = execute_phase_rule_targets(rule_exec);
+        }
 #ifdef IB_RULE_TRACE
-    if (rule->flags & IB_RULE_FLAG_TRACE) {
-        post_time = ib_clock_get_time();
-        rule_exec->traces[rule->meta.index].rule = rule;
-        rule_exec->traces[rule->meta.index].evaluation_time +=
-            (post_time - pre_time);
-        ++rule_exec->traces[rule->meta.index].evaluation_n;
-    }
+        if ( (trc == IB_OK) && (link->flags & IB_RULE_FLAG_TRACE) ) {
+            post_time = ib_clock_get_time();
+            rule_exec->traces[link->meta.index].rule = link;
+            rule_exec->traces[link->meta.index].evaluation_time +=
+                (post_time - pre_time);
+            ++rule_exec->traces[link->meta.index].evaluation_n;
+        }
 #endif
+        link_result = rule_exec->rule_result;
 
-    /*
-     * Execute chained rule
-     *
-     * @todo The current behavior is to keep running even after a chained rule
-     * returns an error.  This needs further discussion to determine what
-     * the correct behavior should be.
-     *
-     * @note Chaining is currently done via recursion.
-     */
-    if ( (rule_exec->rule_result != 0) && (rule->chained_rule != NULL) ) {
-        ib_rule_log_debug(rule_exec,
-                          "Chaining to rule \"%s\"",
-                          ib_rule_id(rule->chained_rule));
-        trc = execute_phase_rule(rule_exec, rule->chained_rule, recursion);
+        /* Pop the rule from the execution object */
+        {
+            ib_status_t prc = rule_exec_pop_rule(rule_exec);
+            if (prc != IB_OK) {
+                /* Do nothing */
+            }
+        }
+
+        {
+            ib_list_node_t *node;
+            IB_LIST_LOOP(rule_exec->ib->rule_engine->hooks.post_rule, node) {
+                const ib_rule_post_rule_hook_t *hook =
+                    (const ib_rule_post_rule_hook_t *)
+                        ib_list_node_data_const(node);
+                hook->fn(rule_exec, hook->data);
+            }
+        }
 
+        /*
+         * @todo The current behavior is to keep running even after a
+         * chained rule returns an error.  This needs further discussion
+         * to determine what the correct behavior should be.
+         */
         if (trc != IB_OK) {
-            ib_rule_log_error(rule_exec,
-                              "Error executing chained rule \"%s\": %s",
-                              ib_rule_id(rule->chained_rule),
-                              ib_status_to_string(trc));
+            if (link != rule) {
+                ib_rule_log_error(rule_exec,
+                                  "Error executing chained rule \"%s\": %s",
+                                  ib_rule_id(link),
+                                  ib_status_to_string(trc));
+            }
             rc = trc;
+            break;
         }
-    }
 
-    /* Pop the rule from the execution object */
-cleanup:
-    trc = rule_exec_pop_rule(rule_exec);
-    if (trc != IB_OK) {
-        /* Do nothing */
-    }
-
-    {
-        ib_list_node_t *node;
-        IB_LIST_LOOP(rule_exec->ib->rule_engine->hooks.post_rule, node) {
-            const ib_rule_post_rule_hook_t *hook =
-                (const ib_rule_post_rule_hook_t *)
-                    ib_list_node_data_const(node);
-            hook->fn(rule_exec, hook->data);
+        /* Short-circuit the rest of the chain on a false result. */
+        if (link_result == 0) {
+            break;
         }
     }
 
@@ -2241,37 +3170,177 @@ static ib_status_t inject_rules(const ib_engine_t *ib,
 }
 
 /**
- * Append context rules onto the rule execution object's phase rule list
+ * Append a phase's flattened context rules onto the execution rule list
+ *
+ * The flag checking was already done when the array was compiled at
+ * context close (see flatten_phase_rules()), so this is a plain copy.
  *
  * @param[in] ib IronBee engine
- * @param[in] phase_meta Phase meta data
- * @param[in] rule_list List of context rules to append
+ * @param[in] ruleset_phase Phase ruleset holding the flattened rules
  * @param[in,out] rule_exec Rule execution object
  *
  * @returns Status code
  */
 static ib_status_t append_context_rules(const ib_engine_t *ib,
-                                        const ib_rule_phase_meta_t *phase_meta,
-                                        const ib_list_t *rule_list,
+                                        const ib_ruleset_phase_t *ruleset_phase,
                                         ib_rule_exec_t *rule_exec)
 {
     assert(ib != NULL);
-    assert(phase_meta != NULL);
+    assert(ruleset_phase != NULL);
     assert(rule_exec != NULL);
-    assert(rule_list != NULL);
 
-    const ib_list_node_t *node;
+    size_t i;
+
+    for (i = 0; i < ruleset_phase->rule_count; ++i) {
+        ib_list_push(rule_exec->phase_rules, ruleset_phase->rule_array[i].rule);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Check whether any var source read by a plan entry's targets has a value
+ *
+ * ib_var_source_get() is used rather than the const variant so that lazy
+ * sources materialize here exactly as they would inside the target fetch.
+ *
+ * @param[in] entry Execution plan entry
+ * @param[in] store Transaction var store
+ *
+ * @returns true if at least one source has a value
+ */
+static bool plan_entry_sources_present(const ib_rule_plan_entry_t *entry,
+                                       ib_var_store_t *store)
+{
+    assert(entry != NULL);
+    assert(entry->sources != NULL);
+    assert(store != NULL);
 
-    IB_LIST_LOOP_CONST(rule_list, node) {
-        const ib_rule_ctx_data_t *ctx_rule =
-            (const ib_rule_ctx_data_t *)ib_list_node_data_const(node);
+    size_t i;
 
-        if (rule_is_runnable(ctx_rule)) {
-            ib_list_push(rule_exec->phase_rules, ctx_rule->rule);
+    for (i = 0; i < entry->num_sources; ++i) {
+        ib_field_t *field;
+        if (ib_var_source_get(entry->sources[i], &field, store) == IB_OK) {
+            return true;
         }
     }
 
-    return IB_OK;
+    return false;
+}
+
+/**
+ * What the phase rule driver should do after executing one rule.
+ */
+typedef enum {
+    RULE_STEP_CONTINUE, /**< Proceed to the next rule */
+    RULE_STEP_STOP,     /**< Stop the phase; end-of-phase blocking still runs */
+    RULE_STEP_FINISH    /**< Stop the phase; skip end-of-phase blocking */
+} rule_step_t;
+
+/**
+ * Execute one phase rule and apply its resulting allow/block flags
+ *
+ * This is the per-rule body of run_phase_rules(), shared by the loop
+ * over injected rules and the loop over the context's flattened rule
+ * array.
+ *
+ * @param[in] rule_exec Rule execution object
+ * @param[in] meta Phase meta data
+ * @param[in] rule Rule to execute
+ * @param[in,out] rc The first rule execution error is recorded here
+ *
+ * @returns What the driver loop should do next
+ */
+static rule_step_t execute_phase_rule_step(
+    ib_rule_exec_t             *rule_exec,
+    const ib_rule_phase_meta_t *meta,
+    const ib_rule_t            *rule,
+    ib_status_t                *rc
+)
+{
+    assert(rule_exec != NULL);
+    assert(meta != NULL);
+    assert(rule != NULL);
+    assert(rc != NULL);
+
+    ib_tx_t     *tx = rule_exec->tx;
+    ib_status_t  rule_rc;
+
+    assert(
+        rule->meta.phase == meta->phase_num ||
+        rule->meta.phase == IB_PHASE_NONE
+    );
+
+    /* Allow (skip) this phase? */
+    if (rule_allow(tx, meta, true)) {
+        return RULE_STEP_STOP;
+    }
+
+    /* Execute the rule, it's actions and chains */
+    ib_profiler_enter(phase_profiler_tag(meta));
+    rule_rc = execute_phase_rule(rule_exec, rule);
+    ib_profiler_exit();
+
+    /* Release per-rule scratch; the pages are retained for reuse by
+     * the next rule. */
+    ib_mpool_clear(rule_exec->scratch_mp);
+
+    /* Handle block/allow actions. */
+    if (ib_flags_all(tx->flags, IB_TX_FALLOW_ALL) ) {
+        bool allow_rc;
+        ib_rule_log_debug(rule_exec,
+                          "Rule resulted in allow "
+                          "(aborting rule processing): %s",
+                          ib_status_to_string(rule_rc));
+        allow_rc = ib_tx_allow(rule_exec->tx);
+        if (allow_rc != IB_OK && allow_rc != IB_DECLINED) {
+            ib_rule_log_error(rule_exec, "Failed to allow: %s",
+                              ib_status_to_string(allow_rc));
+            if (rule_rc == IB_OK) {
+                rule_rc = allow_rc;
+            }
+        }
+        else {
+            if (allow_rc == IB_DECLINED) {
+                ib_rule_log_info(rule_exec, "Declined to allow.");
+            }
+            return RULE_STEP_FINISH;
+        }
+    }
+    else if (ib_flags_all(tx->flags, IB_TX_FBLOCK_IMMEDIATE) ) {
+        bool block_rc;
+        ib_rule_log_debug(rule_exec,
+                          "Rule resulted in immediate block "
+                          "(aborting rule processing): %s",
+                          ib_status_to_string(rule_rc));
+        block_rc = ib_tx_block(rule_exec->tx);
+        if (block_rc != IB_OK && block_rc != IB_DECLINED) {
+            ib_rule_log_error(rule_exec, "Failed to block: %s",
+                              ib_status_to_string(block_rc));
+            if (rule_rc == IB_OK) {
+                rule_rc = block_rc;
+            }
+        }
+        else {
+            if (block_rc == IB_DECLINED) {
+                ib_rule_log_info(rule_exec, "Declined to block.");
+            }
+            return RULE_STEP_FINISH;
+        }
+    }
+    else if (ib_flags_any(tx->flags, IB_TX_FALLOW_PHASE | IB_TX_FALLOW_REQUEST) ) {
+        ib_rule_log_debug(rule_exec,
+                          "Rule resulted in temporary allow "
+                          "(aborting rule processing for this phase): %s",
+                          ib_status_to_string(rule_rc));
+        return RULE_STEP_STOP;
+    }
+
+    if ( (*rc == IB_OK) && (rule_rc != IB_OK) ) {
+        *rc = rule_rc;
+    }
+
+    return RULE_STEP_CONTINUE;
 }
 
 /**
@@ -2386,14 +3455,12 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
         return IB_EINVAL;
     }
 
-    /* Add all of the enabled "normal" rules to the list */
-    rc = append_context_rules(ib, meta, rules, rule_exec);
-    if (rc != IB_OK) {
-        return IB_EINVAL;
-    }
-
-    /* Walk through the rules & execute them */
-    if (ib_list_elements(rule_exec->phase_rules) == 0) {
+    /* Walk through the rules & execute them.  The injected rules are in
+     * rule_exec->phase_rules; the context's rules were flattened into
+     * ruleset_phase->rule_array at context close and are run in place. */
+    if (ib_list_elements(rule_exec->phase_rules) + ruleset_phase->rule_count
+        == 0)
+    {
         ib_rule_log_tx_debug(tx,
                              "No rules for phase %d/\"%s\" in context \"%s\"",
                              meta->phase_num, phase_name(meta),
@@ -2404,12 +3471,21 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
     ib_rule_log_tx_debug(tx,
                          "Executing %zd rules for phase %d/\"%s\" "
                          "in context \"%s\"",
-                         ib_list_elements(rule_exec->phase_rules),
+                         ib_list_elements(rule_exec->phase_rules) +
+                             ruleset_phase->rule_count,
                          meta->phase_num, phase_name(meta),
                          ib_context_full_get(ctx));
 
+    /* Source-presence skipping hides skipped rules from the per-rule
+     * hooks, so disable it while any are registered (e.g. by profiling
+     * or tracing modules). */
+    const bool check_sources =
+        (ib_list_elements(ib->rule_engine->hooks.pre_rule) == 0) &&
+        (ib_list_elements(ib->rule_engine->hooks.post_rule) == 0);
+
     /*
-     * Loop through all of the rules for this phase, execute them.
+     * Loop through all of the rules for this phase, execute them.  The
+     * injected rules run first, then the context's flattened rule array.
      *
      * @todo The current behavior is to keep running even after rule execution
      * returns an error.  This needs further discussion to determine what the
@@ -2418,77 +3494,42 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
     IB_LIST_LOOP_CONST(rule_exec->phase_rules, node) {
         const ib_rule_t *rule =
             (const ib_rule_t *)ib_list_node_data_const(node);
-        ib_status_t      rule_rc;
-
-        assert(
-            rule->meta.phase == meta->phase_num ||
-            rule->meta.phase == IB_PHASE_NONE
-        );
+        rule_step_t      step;
 
-        /* Allow (skip) this phase? */
-        if (rule_allow(tx, meta, true)) {
-            break;
+        step = execute_phase_rule_step(rule_exec, meta, rule, &rc);
+        if (step == RULE_STEP_STOP) {
+            goto phase_end;
         }
-
-        /* Execute the rule, it's actions and chains */
-        rule_rc = execute_phase_rule(rule_exec, rule, MAX_CHAIN_RECURSION);
-
-        /* Handle block/allow actions. */
-        if (ib_flags_all(tx->flags, IB_TX_FALLOW_ALL) ) {
-            bool allow_rc;
-            ib_rule_log_debug(rule_exec,
-                              "Rule resulted in allow "
-                              "(aborting rule processing): %s",
-                              ib_status_to_string(rule_rc));
-            allow_rc = ib_tx_allow(rule_exec->tx);
-            if (allow_rc != IB_OK && allow_rc != IB_DECLINED) {
-                ib_rule_log_error(rule_exec, "Failed to allow: %s",
-                                  ib_status_to_string(allow_rc));
-                if (rule_rc == IB_OK) {
-                    rule_rc = allow_rc;
-                }
-            }
-            else {
-                if (allow_rc == IB_DECLINED) {
-                    ib_rule_log_info(rule_exec, "Declined to allow.");
-                }
-                goto finish;
-            }
+        if (step == RULE_STEP_FINISH) {
+            goto finish;
         }
-        else if (ib_flags_all(tx->flags, IB_TX_FBLOCK_IMMEDIATE) ) {
-            bool block_rc;
-            ib_rule_log_debug(rule_exec,
-                              "Rule resulted in immediate block "
-                              "(aborting rule processing): %s",
-                              ib_status_to_string(rule_rc));
-            block_rc = ib_tx_block(rule_exec->tx);
-            if (block_rc != IB_OK && block_rc != IB_DECLINED) {
-                ib_rule_log_error(rule_exec, "Failed to block: %s",
-                                  ib_status_to_string(block_rc));
-                if (rule_rc == IB_OK) {
-                    rule_rc = block_rc;
-                }
-            }
-            else {
-                if (block_rc == IB_DECLINED) {
-                    ib_rule_log_info(rule_exec, "Declined to block.");
-                }
-                goto finish;
-            }
+    }
+    for (size_t i = 0; i < ruleset_phase->rule_count; ++i) {
+        const ib_rule_plan_entry_t *entry = &(ruleset_phase->rule_array[i]);
+        rule_step_t step;
+
+        /* Skip rules none of whose target sources have a value; their
+         * operator could not execute against any target.  See
+         * flatten_phase_rules() for which rules are eligible. */
+        if ( check_sources
+             && (entry->sources != NULL)
+             && ! plan_entry_sources_present(entry, tx->var_store) )
+        {
+            continue;
         }
-        else if (ib_flags_any(tx->flags, IB_TX_FALLOW_PHASE | IB_TX_FALLOW_REQUEST) ) {
-            ib_rule_log_debug(rule_exec,
-                              "Rule resulted in temporary allow "
-                              "(aborting rule processing for this phase): %s",
-                              ib_status_to_string(rule_rc));
+
+        step = execute_phase_rule_step(
+            rule_exec, meta, entry->rule, &rc
+        );
+        if (step == RULE_STEP_STOP) {
             break;
         }
-
-        if ( (rc == IB_OK) && (rule_rc != IB_OK) ) {
-            rc = rule_rc;
+        if (step == RULE_STEP_FINISH) {
+            goto finish;
         }
     }
 
+phase_end:
     if (ib_flags_all(tx->flags, IB_TX_FBLOCK_PHASE) ) {
         ib_rule_log_tx_debug(tx, "Rule(s) resulted in phase block");
         rc = ib_tx_block(rule_exec->tx);
@@ -2539,6 +3580,15 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
     ib_num_t         result = 0;
     ib_status_t      op_rc;
 
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire("rule.executions", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+    ib_flightrec_record(IB_FLIGHTREC_RULE, rule->meta.id, 0);
+
     /* Add a target execution result to the log object */
     ib_rule_log_exec_add_stream_tgt(rule_exec->ib, rule_exec->exec_log, value);
 
@@ -2563,6 +3613,16 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
                           ib_status_to_string(op_rc));
         return op_rc;
     }
+
+    /* Copy captures out to the var store only on a match. */
+    if (result != 0) {
+        ib_status_t trc = publish_capture(rule_exec);
+        if (trc != IB_OK) {
+            ib_rule_log_error(rule_exec,
+                              "Failed to publish capture collection: %s",
+                              ib_status_to_string(trc));
+        }
+    }
     rc = ib_rule_log_exec_op(rule_exec->exec_log, rule->opinst, rc);
     if (rc != IB_OK) {
         ib_rule_log_error(rule_exec, "Failed to log operator execution: %s",
@@ -2791,7 +3851,7 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
     }
 
     /* Add all of the enabled "normal" rules to the list */
-    rc = append_context_rules(ib, meta, rules, rule_exec);
+    rc = append_context_rules(ib, ruleset_phase, rule_exec);
     if (rc != IB_OK) {
         return IB_EINVAL;
     }
@@ -2844,12 +3904,14 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
          * operator returns an error.  This needs further discussion to
          * determine what the correct behavior should be.
          */
+        ib_profiler_enter(phase_profiler_tag(meta));
         if (data != NULL) {
             rc = execute_stream_txdata_rule(rule_exec, data, data_length);
         }
         else if (header != NULL) {
             rc = execute_stream_header_rule(rule_exec, header);
         }
+        ib_profiler_exit();
         if (rc != IB_OK) {
             ib_rule_log_error(rule_exec, "Error executing rule: %s",
                               ib_status_to_string(rc));
@@ -2913,38 +3975,270 @@ static ib_status_t run_stream_header_rules(ib_engine_t *ib,
     return rc;
 }
 
+/** Pump processor name for request body stream rules. */
+static const char *c_stream_rules_name_req = "req_stream_rules";
+/** Pump processor name for response body stream rules. */
+static const char *c_stream_rules_name_resp = "resp_stream_rules";
+/** Pump processor type of the stream rules processors. */
+static const char *c_stream_rules_type = "stream_rules";
+
+/**
+ * Pump processor name for a body stream phase.
+ *
+ * @param[in] meta Phase meta of a body stream phase.
+ *
+ * @returns Registered processor name.
+ */
+static const char *stream_rules_processor_name(
+    const ib_rule_phase_meta_t *meta
+)
+{
+    assert(meta != NULL);
+
+    if (meta->phase_num == IB_PHASE_REQUEST_BODY_STREAM) {
+        return c_stream_rules_name_req;
+    }
+    return c_stream_rules_name_resp;
+}
+
+/**
+ * Create a stream rules processor instance.
+ *
+ * The instance data is simply the phase meta the processor runs
+ * rules for.
+ *
+ * @param[out] instance_data Set to @a cbdata.
+ * @param[in] tx Transaction. Unused.
+ * @param[in] cbdata The @ref ib_rule_phase_meta_t of the phase.
+ *
+ * @returns IB_OK
+ */
+static ib_status_t stream_rules_create_fn(
+    void    *instance_data,
+    ib_tx_t *tx,
+    void    *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(cbdata != NULL);
+
+    *(void **)instance_data = cbdata;
+    return IB_OK;
+}
+
+/**
+ * Run body stream rules against data flowing through a pump.
+ *
+ * Each data segment is taken, fed to the stream rules of the phase
+ * recorded in the instance data, and forwarded unmodified.  Because
+ * this processor sits after any transforming processors in the pump,
+ * the rules inspect the data those processors produced rather than
+ * the raw body.  Rule errors are logged and do not stop the body;
+ * this mirrors the error handling of the phase rule runners.
+ *
+ * @param[in] instance_data The @ref ib_rule_phase_meta_t of the phase.
+ * @param[in] tx Transaction.
+ * @param[in] mm_eval Memory manager for this call. Unused.
+ * @param[in] io_tx IO transaction to take data from and put data to.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on IO failures.
+ */
+static ib_status_t stream_rules_exec_fn(
+    void              *instance_data,
+    ib_tx_t           *tx,
+    ib_mm_t            mm_eval,
+    ib_stream_io_tx_t *io_tx,
+    void              *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(tx != NULL);
+    assert(io_tx != NULL);
+
+    const ib_rule_phase_meta_t *meta =
+        (const ib_rule_phase_meta_t *)instance_data;
+    ib_status_t rc;
+
+    while (ib_stream_io_data_depth(io_tx) > 0) {
+        ib_stream_io_data_t *data;
+        uint8_t             *ptr;
+        size_t               len;
+        ib_stream_io_type_t  type;
+
+        rc = ib_stream_io_data_take(io_tx, &data, &ptr, &len, &type);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        if (type == IB_STREAM_IO_DATA && len > 0) {
+            ib_status_t trc;
+
+            ib_flags_clear(tx->flags, IB_TX_FALLOW_PHASE);
+            trc = run_stream_rules(
+                tx->ib, tx, meta->state,
+                (const char *)ptr, len,
+                NULL,
+                meta);
+            ib_flags_clear(tx->flags, IB_TX_FALLOW_PHASE);
+            if (trc != IB_OK) {
+                ib_log_error_tx(tx,
+                                "Error running stream %d/\"%s\" rules: %s",
+                                meta->phase_num, phase_name(meta),
+                                ib_status_to_string(trc));
+            }
+        }
+
+        rc = ib_stream_io_data_put(io_tx, data);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
 /**
- * Run stream TXDATA rules
+ * Attach a stream rules processor to a transaction's body pump.
+ *
+ * Runs after the modules' own attach hooks so that the rules
+ * processor lands behind any transforming processors those hooks
+ * added.  When the transaction's context has no rules and no
+ * injectors in the phase, nothing is attached and the pump stays
+ * as short (and possibly transparent) as the other processors
+ * allow.
  *
  * @param[in] ib Engine.
  * @param[in] tx Transaction.
  * @param[in] state State.
- * @param[in] data Transaction data.
- * @param[in] data_length Length of @a data.
- * @param[in] cbdata Callback data (actually phase_rule_cbdata_t)
+ * @param[in] cbdata The @ref ib_rule_phase_meta_t of the phase.
  *
  * @returns Status code
  */
-static ib_status_t run_stream_txdata_rules(ib_engine_t *ib,
-                                           ib_tx_t *tx,
-                                           ib_state_t state,
-                                           const char *data,
-                                           size_t data_length,
-                                           void *cbdata)
+static ib_status_t stream_rules_attach(ib_engine_t *ib,
+                                       ib_tx_t *tx,
+                                       ib_state_t state,
+                                       void *cbdata)
 {
     assert(ib != NULL);
+    assert(tx != NULL);
+    assert(tx->ctx != NULL);
     assert(cbdata != NULL);
 
-    if (data == NULL) {
+    const ib_rule_phase_meta_t *meta = (const ib_rule_phase_meta_t *)cbdata;
+    const ib_ruleset_phase_t   *ruleset_phase =
+        &(tx->ctx->rules->ruleset.phases[meta->phase_num]);
+    const ib_list_t            *injections =
+        ib->rule_engine->injection_cbs[meta->phase_num];
+    ib_stream_pump_t           *pump;
+    ib_status_t                 rc;
+
+    /* Stay out of the pump when nothing can run in this phase. */
+    if (
+        (
+            ruleset_phase->rule_list == NULL ||
+            ib_list_elements(ruleset_phase->rule_list) == 0
+        ) &&
+        (
+            injections == NULL ||
+            ib_list_elements(injections) == 0
+        )
+    )
+    {
         return IB_OK;
     }
-    const ib_rule_phase_meta_t *meta = (const ib_rule_phase_meta_t *)cbdata;
-    ib_status_t rc;
 
-    ib_flags_clear(tx->flags, IB_TX_FALLOW_PHASE);
-    rc = run_stream_rules(ib, tx, state, data, data_length, NULL, meta);
-    ib_flags_clear(tx->flags, IB_TX_FALLOW_PHASE);
-    return rc;
+    if (meta->phase_num == IB_PHASE_REQUEST_BODY_STREAM) {
+        pump = ib_tx_request_body_pump(tx);
+    }
+    else {
+        pump = ib_tx_response_body_pump(tx);
+    }
+
+    rc = ib_stream_pump_processor_add(pump, stream_rules_processor_name(meta));
+    if (rc != IB_OK) {
+        ib_log_error_tx(tx,
+                        "Failed to add stream rules processor for "
+                        "phase %d/\"%s\": %s",
+                        meta->phase_num, phase_name(meta),
+                        ib_status_to_string(rc));
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Register the pump processor that feeds a body stream phase.
+ *
+ * Registers a per-phase, observe-only processor definition and a
+ * transaction hook that attaches it to the matching body pump.  The
+ * request processor attaches at @ref handle_request_header_state and
+ * the response processor at @ref handle_response_header_state, both
+ * one state after the @c *_finished states modules customarily attach
+ * their own processors in.
+ *
+ * @param[in] ib Engine.
+ * @param[in] meta Phase meta of a body stream phase.
+ *
+ * @returns Status code
+ */
+static ib_status_t register_stream_rules_processor(
+    ib_engine_t                *ib,
+    const ib_rule_phase_meta_t *meta
+)
+{
+    assert(ib != NULL);
+    assert(meta != NULL);
+
+    const char      *name = stream_rules_processor_name(meta);
+    ib_state_t       attach_state;
+    ib_mpool_lite_t *mpl;
+    ib_list_t       *types;
+    ib_status_t      rc;
+
+    if (meta->phase_num == IB_PHASE_REQUEST_BODY_STREAM) {
+        attach_state = handle_request_header_state;
+    }
+    else {
+        attach_state = handle_response_header_state;
+    }
+
+    rc = ib_mpool_lite_create(&mpl);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_list_create(&types, ib_mm_mpool_lite(mpl));
+    if (rc == IB_OK) {
+        rc = ib_list_push(types, (void *)c_stream_rules_type);
+    }
+    if (rc == IB_OK) {
+        rc = ib_stream_processor_registry_register(
+            ib_engine_stream_processor_registry(ib),
+            name,
+            types,
+            stream_rules_create_fn, (void *)meta,
+            stream_rules_exec_fn, NULL,
+            NULL, NULL
+        );
+    }
+    if (rc == IB_OK) {
+        /* Rules inspect the body but never alter it. */
+        rc = ib_stream_processor_registry_observe_only_set(
+            ib_engine_stream_processor_registry(ib),
+            name,
+            true
+        );
+    }
+    ib_mpool_lite_destroy(mpl);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_hook_tx_register(ib, attach_state, stream_rules_attach,
+                               (void *)meta);
 }
 
 /**
@@ -3102,6 +4396,8 @@ static ib_status_t init_ruleset(ib_engine_t *ib,
                          ib_status_to_string(rc));
             return rc;
         }
+        ruleset_phase->rule_array = NULL;
+        ruleset_phase->rule_count = 0;
     }
 
     /* Create a hash to hold rules indexed by ID */
@@ -3164,12 +4460,11 @@ static ib_status_t register_callbacks(ib_engine_t *ib,
                 break;
 
             case IB_STATE_HOOK_TXDATA:
-                rc = ib_hook_txdata_register(
-                    ib,
-                    meta->state,
-                    run_stream_txdata_rules,
-                    (void *)meta);
-                hook_type = "txdata";
+                /* Body data phases are fed from the body stream pump
+                 * rather than the txdata hook, so that rules see the
+                 * data any pump processors produced. */
+                rc = register_stream_rules_processor(ib, meta);
+                hook_type = "pump";
                 break;
 
             case IB_STATE_HOOK_HEADER:
@@ -3617,29 +4912,162 @@ static ib_status_t rule_enable_by_tag_prefix(
         }
     }
 
-    /* Check child rules. */
-    for (
-        ib_rule_t *child = rule->chained_rule;
-        child != NULL;
-        child = child->chained_rule
-    )
-    {
-        IB_LIST_LOOP_CONST(child->meta.tags, node) {
-            const char *ruletag = (const char *)ib_list_node_data_const(node);
-            if (strncasecmp(tag, ruletag, tag_len) == 0) {
-                return IB_OK;
+    /* Check child rules. */
+    for (
+        ib_rule_t *child = rule->chained_rule;
+        child != NULL;
+        child = child->chained_rule
+    )
+    {
+        IB_LIST_LOOP_CONST(child->meta.tags, node) {
+            const char *ruletag = (const char *)ib_list_node_data_const(node);
+            if (strncasecmp(tag, ruletag, tag_len) == 0) {
+                return IB_OK;
+            }
+        }
+    }
+
+    /* Finally, no match */
+    return IB_DECLINED;
+}
+
+
+
+/* End Rule enable functions. */
+
+/**
+ * Per-close indexes from rule id and tag to context rules.
+ *
+ * Built once per context close over the candidate rule list so that
+ * exact id: and tag: enable directives resolve by hash lookup instead
+ * of rescanning every rule per directive.  Values are lists of
+ * @ref ib_rule_ctx_data_t.
+ */
+typedef struct {
+    ib_hash_t *by_id;   /**< Rule id / full id to list of context rules */
+    ib_hash_t *by_tag;  /**< Rule tag to list of context rules */
+} rule_enable_index_t;
+
+/**
+ * Append @a ctx_rule to the list at @a key in @a hash.
+ *
+ * Creates the list on first use.  Skips consecutive duplicates so one
+ * chain contributes a context rule at most once per key.
+ *
+ * @param[in,out] hash Index hash to add to.
+ * @param[in] mm Memory manager for lists.
+ * @param[in] key Id or tag to file @a ctx_rule under.
+ * @param[in] ctx_rule Context rule to add.
+ *
+ * @returns Status code
+ */
+static ib_status_t enable_index_add(
+    ib_hash_t          *hash,
+    ib_mm_t             mm,
+    const char         *key,
+    ib_rule_ctx_data_t *ctx_rule
+)
+{
+    assert(hash != NULL);
+    assert(key != NULL);
+    assert(ctx_rule != NULL);
+
+    ib_status_t  rc;
+    ib_list_t   *list = NULL;
+
+    rc = ib_hash_get(hash, &list, key);
+    if (rc == IB_ENOENT) {
+        rc = ib_list_create(&list, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_hash_set(hash, key, list);
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (
+        ib_list_elements(list) > 0 &&
+        ib_list_node_data(ib_list_last(list)) == ctx_rule
+    )
+    {
+        return IB_OK;
+    }
+
+    return ib_list_push(list, ctx_rule);
+}
+
+/**
+ * Build the id and tag enable indexes over @a ctx_rule_list.
+ *
+ * Every link of a chain is indexed under the chain's context rule,
+ * matching the semantics of ib_rule_id_match() and ib_rule_tag_match().
+ *
+ * @param[in] ctx_rule_list List of @ref ib_rule_ctx_data_t to index.
+ * @param[in] mm Memory manager for the indexes.
+ * @param[out] index Index to populate.
+ *
+ * @returns Status code
+ */
+static ib_status_t build_enable_index(
+    ib_list_t           *ctx_rule_list,
+    ib_mm_t              mm,
+    rule_enable_index_t *index
+)
+{
+    assert(ctx_rule_list != NULL);
+    assert(index != NULL);
+
+    ib_status_t     rc;
+    ib_list_node_t *node;
+
+    rc = ib_hash_create_nocase(&(index->by_id), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_hash_create_nocase(&(index->by_tag), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    IB_LIST_LOOP(ctx_rule_list, node) {
+        ib_rule_ctx_data_t *ctx_rule =
+            (ib_rule_ctx_data_t *)ib_list_node_data(node);
+        const ib_rule_t    *link;
+
+        for (
+            link = ctx_rule->rule;
+            link != NULL;
+            link = link->chained_rule
+        )
+        {
+            const ib_list_node_t *tag_node;
+
+            rc = enable_index_add(index->by_id, mm,
+                                  link->meta.id, ctx_rule);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = enable_index_add(index->by_id, mm,
+                                  link->meta.full_id, ctx_rule);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            IB_LIST_LOOP_CONST(link->meta.tags, tag_node) {
+                const char *tag =
+                    (const char *)ib_list_node_data_const(tag_node);
+                rc = enable_index_add(index->by_tag, mm, tag, ctx_rule);
+                if (rc != IB_OK) {
+                    return rc;
+                }
             }
         }
     }
 
-    /* Finally, no match */
-    return IB_DECLINED;
+    return IB_OK;
 }
 
-
-
-/* End Rule enable functions. */
-
 /**
  * Enable rules that match tag / id
  *
@@ -3647,14 +5075,16 @@ static ib_status_t rule_enable_by_tag_prefix(
  * @param[in] ctx Current IronBee context
  * @param[in] match Enable match data
  * @param[in,out] ctx_rule_list List of rules to search for matches to @a enable
+ * @param[in] index Id/tag indexes over @a ctx_rule_list, or NULL to scan.
  *
  * @returns Status code
  */
 static ib_status_t enable_rules(
-    ib_engine_t            *ib,
-    ib_context_t           *ctx,
-    const ib_rule_enable_t *match,
-    ib_list_t              *ctx_rule_list
+    ib_engine_t               *ib,
+    ib_context_t              *ctx,
+    const ib_rule_enable_t    *match,
+    ib_list_t                 *ctx_rule_list,
+    const rule_enable_index_t *index
 )
 {
     assert(ib != NULL);
@@ -3666,15 +5096,47 @@ static ib_status_t enable_rules(
     unsigned int    matches = 0;
     const char     *lcname = match->enable ? "enable" : "disable";
 
-    IB_LIST_LOOP(ctx_rule_list, node) {
-        ib_rule_ctx_data_t *ctx_rule;
-        ctx_rule = (ib_rule_ctx_data_t *)ib_list_node_data(node);
+    /* Exact id: and tag: directives resolve through the indexes;
+     * prefix and externally supplied match functions still scan. */
+    if (
+        index != NULL &&
+        ( (match->rule_enable_fn == rule_enable_by_id) ||
+          (match->rule_enable_fn == rule_enable_by_tag) )
+    )
+    {
+        ib_hash_t *hash = (match->rule_enable_fn == rule_enable_by_id)
+                          ? index->by_id
+                          : index->by_tag;
+        ib_list_t *matched = NULL;
         ib_status_t rc;
-        rc = match->rule_enable_fn(ctx_rule->rule, match->rule_enable_cbdata);
 
+        rc = ib_hash_get(
+            hash, &matched,
+            (const char *)match->rule_enable_cbdata
+        );
         if (rc == IB_OK) {
-            matches++;
-            set_rule_enable(match->enable, ctx_rule);
+            IB_LIST_LOOP(matched, node) {
+                matches++;
+                set_rule_enable(
+                    match->enable,
+                    (ib_rule_ctx_data_t *)ib_list_node_data(node)
+                );
+            }
+        }
+    }
+    else {
+        IB_LIST_LOOP(ctx_rule_list, node) {
+            ib_rule_ctx_data_t *ctx_rule;
+            ctx_rule = (ib_rule_ctx_data_t *)ib_list_node_data(node);
+            ib_status_t rc;
+            rc = match->rule_enable_fn(
+                ctx_rule->rule, match->rule_enable_cbdata
+            );
+
+            if (rc == IB_OK) {
+                matches++;
+                set_rule_enable(match->enable, ctx_rule);
+            }
         }
     }
 
@@ -3712,6 +5174,210 @@ bool ib_rule_is_marked(const ib_rule_t *rule) {
     return ib_flags_any(rule->flags, IB_RULE_FLAG_MARK);
 }
 
+/**
+ * Compute the var sources a rule's targets read, for execution planning
+ *
+ * Target sources are fixed at configuration time: expansion and filters
+ * only select within a source's value, never which source is read.  The
+ * resulting array lets run_phase_rules() skip the rule when none of its
+ * sources have a value.
+ *
+ * Outputs NULL via @a sources for rules that must always run: external
+ * rules, action (no-target) rules, rules whose operator accepts null
+ * input, and rules with an unresolvable target.
+ *
+ * @param[in] ctx IronBee context (owns the array)
+ * @param[in] rule Rule to examine
+ * @param[out] sources Array of sources, or NULL
+ * @param[out] num_sources Elements in @a sources
+ *
+ * @returns Status code
+ */
+static ib_status_t plan_entry_sources(ib_context_t *ctx,
+                                      ib_rule_t *rule,
+                                      ib_var_source_t ***sources,
+                                      size_t *num_sources)
+{
+    assert(ctx != NULL);
+    assert(rule != NULL);
+    assert(sources != NULL);
+    assert(num_sources != NULL);
+
+    ib_var_source_t **srcs;
+    size_t            count = 0;
+    ib_list_node_t   *node;
+
+    *sources = NULL;
+    *num_sources = 0;
+
+    if (ib_flags_any(rule->flags,
+                     IB_RULE_FLAG_EXTERNAL | IB_RULE_FLAG_NO_TGT))
+    {
+        return IB_OK;
+    }
+    if ( (rule->opinst == NULL) || (rule->opinst->opinst == NULL) ) {
+        return IB_OK;
+    }
+    if (ib_flags_all(
+            ib_operator_capabilities(
+                ib_operator_inst_operator(rule->opinst->opinst)),
+            IB_OP_CAPABILITY_ALLOW_NULL))
+    {
+        return IB_OK;
+    }
+
+    srcs = ib_mm_alloc(
+        ctx->mm,
+        ib_list_elements(rule->target_fields) * sizeof(*srcs)
+    );
+    if (srcs == NULL) {
+        return IB_EALLOC;
+    }
+
+    IB_LIST_LOOP(rule->target_fields, node) {
+        ib_rule_target_t *target =
+            (ib_rule_target_t *)ib_list_node_data(node);
+        ib_var_source_t  *src;
+        size_t            i;
+
+        /* An unresolvable target keeps its current run-and-log path. */
+        if (target->target == NULL) {
+            return IB_OK;
+        }
+
+        src = ib_var_target_source(target->target);
+        for (i = 0; i < count; ++i) {
+            if (srcs[i] == src) {
+                break;
+            }
+        }
+        if (i == count) {
+            srcs[count++] = src;
+        }
+    }
+
+    *sources = srcs;
+    *num_sources = count;
+
+    return IB_OK;
+}
+
+/**
+ * Freeze a rule chain's target lists into contiguous arrays
+ *
+ * Rule targets are fixed once configuration completes, yet
+ * execute_phase_rule_targets() walks them for every rule execution.
+ * Snapshot each chain link's target_fields into target_array so that the
+ * executor scans a contiguous array instead of chasing list nodes.
+ * Idempotent: a rule shared by several contexts is frozen once, from its
+ * owning context's memory manager.
+ *
+ * @param[in,out] rule Head of the rule chain to freeze
+ *
+ * @returns Status code
+ */
+static ib_status_t freeze_rule_targets(ib_rule_t *rule)
+{
+    assert(rule != NULL);
+
+    ib_rule_t *link;
+
+    for (link = rule; link != NULL; link = link->chained_rule) {
+        ib_status_t rc;
+
+        if (link->target_array != NULL) {
+            continue;
+        }
+
+        rc = ib_list_to_array(
+            link->target_fields,
+            link->ctx->mm,
+            (void ***)&(link->target_array)
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+        link->num_targets = ib_list_elements(link->target_fields);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Flatten a context's runnable rules into per-phase arrays
+ *
+ * Called at context close, after enablement and validity are settled.
+ * Fills the rule_array / rule_count members of each phase's ruleset so
+ * that run_phase_rules() iterates a contiguous array per transaction
+ * instead of traversing rule_list and re-checking per-rule flags.  Each
+ * entry also carries the var sources its rule reads, enabling
+ * source-presence skipping; see plan_entry_sources().
+ *
+ * @param[in] ib IronBee engine
+ * @param[in,out] ctx IronBee context
+ *
+ * @returns Status code
+ */
+static ib_status_t flatten_phase_rules(ib_engine_t *ib,
+                                       ib_context_t *ctx)
+{
+    assert(ib != NULL);
+    assert(ctx != NULL);
+
+    size_t phase_num;
+
+    for (phase_num = 0; phase_num < IB_RULE_PHASE_COUNT; ++phase_num) {
+        ib_ruleset_phase_t   *ruleset_phase =
+            &(ctx->rules->ruleset.phases[phase_num]);
+        const ib_list_node_t *node;
+        size_t                count = 0;
+
+        IB_LIST_LOOP_CONST(ruleset_phase->rule_list, node) {
+            const ib_rule_ctx_data_t *ctx_rule =
+                (const ib_rule_ctx_data_t *)ib_list_node_data_const(node);
+            if (rule_is_runnable(ctx_rule)) {
+                ++count;
+            }
+        }
+
+        ruleset_phase->rule_array = NULL;
+        ruleset_phase->rule_count = 0;
+        if (count == 0) {
+            continue;
+        }
+
+        ruleset_phase->rule_array =
+            ib_mm_alloc(ctx->mm, count * sizeof(*(ruleset_phase->rule_array)));
+        if (ruleset_phase->rule_array == NULL) {
+            return IB_EALLOC;
+        }
+
+        IB_LIST_LOOP_CONST(ruleset_phase->rule_list, node) {
+            const ib_rule_ctx_data_t *ctx_rule =
+                (const ib_rule_ctx_data_t *)ib_list_node_data_const(node);
+            ib_rule_plan_entry_t *entry;
+            ib_status_t           rc;
+
+            if (! rule_is_runnable(ctx_rule)) {
+                continue;
+            }
+
+            entry = &(ruleset_phase->rule_array[ruleset_phase->rule_count++]);
+            entry->rule = ctx_rule->rule;
+            rc = plan_entry_sources(
+                ctx, ctx_rule->rule,
+                &(entry->sources), &(entry->num_sources)
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        assert(ruleset_phase->rule_count == count);
+    }
+
+    return IB_OK;
+}
+
 /**
  * Close a context for the rule engine.
  *
@@ -3737,12 +5403,15 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
     ib_list_node_t *node;
     ib_context_t   *main_ctx = ib_context_main(ib);
     ib_status_t     rc;
+    ib_time_t       close_start;
 
     /* Don't enable rules for non-location contexts */
     if (ctx->ctype != IB_CTYPE_LOCATION) {
         return IB_OK;
     }
 
+    close_start = ib_clock_precise_get_time();
+
     /* Create the list of all rules */
     rc = ib_list_create(&all_rules, ctx->mm);
     if (rc != IB_OK) {
@@ -3821,18 +5490,41 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
         }
     }
 
-    /* Step 4: Enable / Disable rules. */
-    IB_LIST_LOOP(ctx->rules->enable_list, node) {
-        const ib_rule_enable_t *enable;
-        enable = (const ib_rule_enable_t *)ib_list_node_data(node);
+    /* Step 4: Enable / Disable rules.
+     *
+     * Index the candidate rules by id and tag first so each exact id:
+     * or tag: directive resolves in time proportional to its matches
+     * rather than rescanning every rule.  The indexes are only needed
+     * for the duration of this step, so they live on a throwaway pool.
+     */
+    if (ib_list_elements(ctx->rules->enable_list) > 0) {
+        ib_mpool_lite_t     *mpl = NULL;
+        rule_enable_index_t  index;
 
-        rc = enable_rules(ib, ctx, enable, all_rules);
+        rc = ib_mpool_lite_create(&mpl);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = build_enable_index(all_rules, ib_mm_mpool_lite(mpl), &index);
         if (rc != IB_OK) {
-            ib_cfg_log_notice_ex(ib, enable->file, enable->lineno,
-                                 "Error apply rule enable/disable "
-                                 "in \"%s\" temp list",
-                                 ib_context_full_get(ctx));
+            ib_mpool_lite_destroy(mpl);
+            return rc;
+        }
+
+        IB_LIST_LOOP(ctx->rules->enable_list, node) {
+            const ib_rule_enable_t *enable;
+            enable = (const ib_rule_enable_t *)ib_list_node_data(node);
+
+            rc = enable_rules(ib, ctx, enable, all_rules, &index);
+            if (rc != IB_OK) {
+                ib_cfg_log_notice_ex(ib, enable->file, enable->lineno,
+                                     "Error apply rule enable/disable "
+                                     "in \"%s\" temp list",
+                                     ib_context_full_get(ctx));
+            }
         }
+
+        ib_mpool_lite_destroy(mpl);
     }
 
     /* Step 5: Add all enabled rules to the appropriate execution list */
@@ -3855,6 +5547,13 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
             continue;
         }
 
+        /* Freeze the chain's target lists before ownership callbacks can
+         * claim the rule, so injected rules execute from arrays too. */
+        rc = freeze_rule_targets(rule);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
         phase_num = rule->meta.phase;
 
         /* Give the ownership functions a shot at the rule */
@@ -3944,6 +5643,16 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
                      ib_context_full_get(ctx));
     }
 
+    /* Step 6: Compile the per-phase execution plan. */
+    rc = flatten_phase_rules(ib, ctx);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error flattening phase rules for context \"%s\": %s",
+                     ib_context_full_get(ctx),
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     /* Initialize var sources */
     {
         ib_rule_engine_t *re = ib->rule_engine;
@@ -3979,6 +5688,11 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
 
     ib_rule_log_flags_dump(ib, ctx);
 
+    ib_log_debug(ib,
+                 "Closed rules for context \"%s\" in %"PRIu64" usec",
+                 ib_context_full_get(ctx),
+                 (uint64_t)(ib_clock_precise_get_time() - close_start));
+
     return IB_OK;
 }
 
@@ -4123,6 +5837,177 @@ static ib_status_t rule_engine_tx_started(ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Build the rule timing report
+ *
+ * One line per rule that has recorded at least one execution:
+ * rule id, execution count, total/mean/max wall time in microseconds,
+ * and the log2-microsecond histogram as comma separated bucket counts.
+ * Counters are read without locking; a report taken while transactions
+ * are in flight may be slightly inconsistent between columns.
+ *
+ * @param[in] ib IronBee engine
+ * @param[in] mm Memory manager for @a result
+ * @param[out] result Report text
+ *
+ * @returns Status code
+ */
+static ib_status_t rule_timing_report(const ib_engine_t *ib,
+                                      ib_mm_t mm,
+                                      const char **result)
+{
+    assert(ib != NULL);
+    assert(result != NULL);
+
+    const ib_rule_engine_t *rule_engine = ib->rule_engine;
+    const ib_list_node_t   *node;
+    char                   *buf;
+    size_t                  size = 128;
+    size_t                  off = 0;
+
+    if (rule_engine->timing.stats == NULL) {
+        *result = "Rule timing has never been enabled.";
+        return IB_OK;
+    }
+
+    /* Upper bound on the report size. */
+    IB_LIST_LOOP_CONST(rule_engine->rule_list, node) {
+        const ib_rule_t *rule =
+            (const ib_rule_t *)ib_list_node_data_const(node);
+        if ( (rule->meta.index >= rule_engine->timing.num_stats)
+             || (rule_engine->timing.stats[rule->meta.index].count == 0) )
+        {
+            continue;
+        }
+        size += strlen(ib_rule_id(rule))
+                + 96
+                + IB_RULE_TIMING_BUCKETS * 21;
+    }
+
+    buf = ib_mm_alloc(mm, size);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    off += snprintf(buf + off, size - off,
+                    "rule-id count total-us mean-us max-us "
+                    "histogram-log2us\n");
+    IB_LIST_LOOP_CONST(rule_engine->rule_list, node) {
+        const ib_rule_t        *rule =
+            (const ib_rule_t *)ib_list_node_data_const(node);
+        const ib_rule_timing_t *slot;
+        size_t                  bucket;
+
+        if (rule->meta.index >= rule_engine->timing.num_stats) {
+            continue;
+        }
+        slot = &(rule_engine->timing.stats[rule->meta.index]);
+        if (slot->count == 0) {
+            continue;
+        }
+
+        off += snprintf(buf + off, size - off,
+                        "%s %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " ",
+                        ib_rule_id(rule),
+                        slot->count,
+                        slot->total_us,
+                        slot->total_us / slot->count,
+                        slot->max_us);
+        for (bucket = 0; bucket < IB_RULE_TIMING_BUCKETS; ++bucket) {
+            off += snprintf(buf + off, size - off,
+                            "%s%" PRIu64,
+                            (bucket == 0) ? "" : ",",
+                            slot->buckets[bucket]);
+        }
+        off += snprintf(buf + off, size - off, "\n");
+        if (off >= size) {
+            break;
+        }
+    }
+
+    *result = buf;
+    return IB_OK;
+}
+
+/**
+ * The "ruletiming" runtime control command
+ *
+ * Usage: <tt>ruletiming enable|disable|reset|report</tt>
+ *
+ * Enabling allocates the per-rule statistics on first use and turns on
+ * recording in execute_phase_rule(); disabling stops recording but
+ * keeps the data.  Reset zeroes the counters non-atomically, so updates
+ * from transactions in flight at that moment may be lost.
+ *
+ * @param[in] ib Engine the command acts on
+ * @param[in] mm Memory manager for @a result
+ * @param[in] name The name this command is called by
+ * @param[in] args The command arguments
+ * @param[out] result Result message
+ * @param[in] cbdata Callback data (unused)
+ *
+ * @returns Status code
+ */
+static ib_status_t rule_timing_cmd(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(args != NULL);
+    assert(result != NULL);
+
+    ib_rule_engine_t *rule_engine = ib->rule_engine;
+
+    if (strcasecmp(args, "enable") == 0) {
+        if (rule_engine->timing.stats == NULL) {
+            ib_rule_timing_t *stats;
+            size_t            num_stats = rule_engine->index_limit;
+
+            if (num_stats == 0) {
+                *result = "No rules are registered.";
+                return IB_OK;
+            }
+            stats = ib_mm_calloc(
+                ib_engine_mm_main_get(ib), num_stats, sizeof(*stats));
+            if (stats == NULL) {
+                return IB_EALLOC;
+            }
+            rule_engine->timing.num_stats = num_stats;
+            rule_engine->timing.stats = stats;
+            /* Publish the statistics before recording starts. */
+            __sync_synchronize();
+        }
+        rule_engine->timing.enabled = 1;
+        *result = "Rule timing enabled.";
+        return IB_OK;
+    }
+    if (strcasecmp(args, "disable") == 0) {
+        rule_engine->timing.enabled = 0;
+        *result = "Rule timing disabled.";
+        return IB_OK;
+    }
+    if (strcasecmp(args, "reset") == 0) {
+        if (rule_engine->timing.stats != NULL) {
+            memset(rule_engine->timing.stats, 0,
+                   rule_engine->timing.num_stats *
+                       sizeof(*rule_engine->timing.stats));
+        }
+        *result = "Rule timing statistics reset.";
+        return IB_OK;
+    }
+    if ( (*args == '\0') || (strcasecmp(args, "report") == 0) ) {
+        return rule_timing_report(ib, mm, result);
+    }
+
+    *result = "Usage: ruletiming enable|disable|reset|report";
+    return IB_EINVAL;
+}
+
 ib_status_t ib_rule_engine_init(ib_engine_t *ib)
 {
     ib_status_t rc;
@@ -4164,6 +6049,15 @@ ib_status_t ib_rule_engine_init(ib_engine_t *ib)
         return rc;
     }
 
+    /* Register the per-rule timing control command. */
+    rc = ib_engine_ctlcmd_register(ib, "ruletiming", rule_timing_cmd, NULL);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error registering ruletiming command: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     return IB_OK;
 }
 
@@ -40,6 +40,61 @@ typedef struct {
     ib_flags_t  flags; /**< Rule flags (IB_RULECTX_FLAG_xx) */
 } ib_rule_ctx_data_t;
 
+/**
+ * One entry of a phase's flattened execution plan.
+ *
+ * Compiled at context close; see flatten_phase_rules() in rule_engine.c.
+ */
+typedef struct {
+    ib_rule_t        *rule;        /**< Rule to execute */
+
+    /**
+     * Var sources the rule's targets read, or NULL to always run.
+     *
+     * When non-NULL and none of the sources have a value in the
+     * transaction's var store, every target fetch would report IB_ENOENT,
+     * the operator would never execute, and no action would fire, so the
+     * whole rule can be skipped.  NULL marks rules that must always run:
+     * external rules, action (no-target) rules, rules whose operator
+     * accepts null input, and rules with an unresolvable target.
+     */
+    ib_var_source_t **sources;
+    size_t            num_sources; /**< Elements in sources */
+} ib_rule_plan_entry_t;
+
+/*
+ * Why the flattened plan executes serially
+ * ----------------------------------------
+ * It is periodically suggested to partition a phase's plan into
+ * setvar/chain-independent groups and fan the groups out to a worker
+ * pool, joining before side-effecting actions run.  The partitioning
+ * itself would be straightforward -- compare each rule's target sources
+ * against the vars earlier setvar actions write, both known at context
+ * close -- but the execution side is not, and it is worth recording why
+ * it has not been done:
+ *
+ * - Everything a rule touches while executing is per-transaction and
+ *   unsynchronized by design: the var store (set_target_fields() writes
+ *   the FIELD* vars for every rule), the transformation and operator
+ *   memos, the capture arena, the rule execution log, and above all the
+ *   transaction memory manager, which every operator allocates from and
+ *   which is a plain pool with no locking.  Running two rules of one
+ *   transaction concurrently means making allocation, var access, and
+ *   logging thread-safe on the hottest paths in the engine, taxing the
+ *   common single-threaded case to benefit the rare parallel one.
+ *
+ * - Servers already parallelize across connections and transactions;
+ *   every worker drives its own transactions, so idle cores mean idle
+ *   traffic.  Intra-transaction parallelism only helps one enormous
+ *   transaction on an otherwise quiet box.
+ *
+ * - For that case the profitable levers reduce work rather than spread
+ *   it: the fast pattern module replaces per-rule fan-out with a single
+ *   automata pass, the plan's source lists skip rules whose inputs are
+ *   unset, and the transformation and operator memos collapse duplicate
+ *   work across rules.
+ */
+
 /**
  * Ruleset for a single phase.
  *  rule_list is a list of pointers to ib_rule_ctx_data_t objects.
@@ -48,6 +103,17 @@ typedef struct {
     ib_rule_phase_num_t         phase_num;   /**< Phase number */
     const ib_rule_phase_meta_t *phase_meta;  /**< Rule phase meta-data */
     ib_list_t                  *rule_list;   /**< Rules to execute in phase */
+
+    /**
+     * The runnable rules of rule_list flattened into a contiguous array.
+     *
+     * Compiled at context close, once enablement and validity are
+     * settled, so that per-transaction execution walks an array instead
+     * of traversing rule_list and re-checking per-rule flags.  NULL
+     * when the phase has no runnable rules.
+     */
+    ib_rule_plan_entry_t       *rule_array;
+    size_t                      rule_count;  /**< Elements in rule_array */
 } ib_ruleset_phase_t;
 
 /**
@@ -79,6 +145,22 @@ struct ib_rule_target_t {
 };
 
 
+/** Number of log2-microsecond histogram buckets per rule. */
+#define IB_RULE_TIMING_BUCKETS 16
+
+/**
+ * Timing statistics for one rule.
+ *
+ * All counters are updated with atomic adds by transaction threads; see
+ * rule_timing_record() in rule_engine.c.
+ */
+typedef struct {
+    uint64_t count;    /**< Executions recorded. */
+    uint64_t total_us; /**< Sum of wall times, in microseconds. */
+    uint64_t max_us;   /**< Slowest execution, in microseconds. */
+    uint64_t buckets[IB_RULE_TIMING_BUCKETS]; /**< log2-usec histogram. */
+} ib_rule_timing_t;
+
 /**
  * Rule engine.
  */
@@ -112,6 +194,21 @@ struct ib_rule_engine_t {
         ib_list_t *pre_operator;
         ib_list_t *post_operator;
     } hooks;
+
+    /**
+     * Opt-in per-rule timing instrumentation.
+     *
+     * Controlled at runtime through the "ruletiming" control command.
+     * stats is allocated on the first enable, sized by index_limit at
+     * that moment (rule indices are fixed once configuration finishes),
+     * and indexed by ib_rule_t::meta.index.  enabled is a single
+     * aligned word so transaction threads read it without locking.
+     */
+    struct {
+        volatile int      enabled;   /**< Record timings when non-zero. */
+        ib_rule_timing_t *stats;     /**< Per-rule statistics, or NULL. */
+        size_t            num_stats; /**< Elements in stats. */
+    } timing;
 };
 
 /**
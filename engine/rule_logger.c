@@ -27,6 +27,7 @@
 #include <ironbee/rule_logger.h>
 #include "rule_logger_private.h"
 #include "rule_engine_private.h"
+#include "engine_private.h"
 
 #include <ironbee/action.h>
 #include <ironbee/bytestr.h>
@@ -407,11 +408,15 @@ static void rule_vlog_tx(
     char *fmtbuf = NULL;
     size_t fmtlen;
     void *freeptr = NULL;
-    ib_rule_dlog_level_t dlog_level =
-        (tx->ctx == NULL) ? IB_RULE_DLOG_INFO : ib_rule_dlog_level(tx->ctx);
 
     /* Ignore this message? */
-    if (rule_log_level > dlog_level) {
+    if (!ib_rule_log_tx_would_log(rule_log_level, tx)) {
+        return;
+    }
+
+    /* Will the engine's logger discard it anyway? Check before the
+     * prefix buffer is built. */
+    if (!ib_log_would_log(tx->ib, log_level)) {
         return;
     }
 
@@ -671,6 +676,43 @@ ib_rule_dlog_level_t ib_rule_dlog_level(const ib_context_t *ctx)
     return corecfg->rule_debug_level;
 }
 
+bool ib_rule_log_tx_would_log(
+    ib_rule_dlog_level_t  level,
+    const ib_tx_t        *tx
+)
+{
+    ib_rule_dlog_level_t dlog_level;
+
+    if (tx == NULL) {
+        /* Always log if there is no transaction. */
+        return true;
+    }
+
+    dlog_level =
+        (tx->ctx == NULL) ? IB_RULE_DLOG_INFO : ib_rule_dlog_level(tx->ctx);
+
+    /* Runtime override, e.g. "tune rule_dlog_level" on the engine
+     * manager control channel. */
+    if (tx->ib->tune.rule_dlog_level >= 0) {
+        dlog_level = (ib_rule_dlog_level_t)tx->ib->tune.rule_dlog_level;
+    }
+
+    return level <= dlog_level;
+}
+
+bool ib_rule_log_exec_would_log(
+    ib_rule_dlog_level_t  level,
+    const ib_rule_exec_t *rule_exec
+)
+{
+    if (rule_exec == NULL) {
+        /* Always log if there is no execution object. */
+        return true;
+    }
+
+    return ib_rule_log_tx_would_log(level, rule_exec->tx);
+}
+
 /* Log TX start */
 ib_status_t ib_rule_log_tx_create(
     const ib_rule_exec_t *rule_exec,
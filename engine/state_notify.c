@@ -33,8 +33,10 @@
 #include <ironbee/engine_state.h>
 #include <ironbee/field.h>
 #include <ironbee/flags.h>
+#include <ironbee/flightrec.h>
 #include <ironbee/log.h>
 #include <ironbee/mm_mpool_lite.h>
+#include <ironbee/profiler.h>
 #include <ironbee/stream_pump.h>
 
 #include <assert.h>
@@ -110,6 +112,46 @@ no_mm_log:
     );
 }
 
+/**
+ * Profiler tag for @a state, registered on first dispatch.
+ *
+ * @param[in] state The state being dispatched.
+ *
+ * @returns The profiler tag, or -1 if the tag table is full.
+ */
+static int state_profiler_tag(ib_state_t state)
+{
+    /* Cached tags, offset by one so that zero means "not yet looked
+     * up" and -1 means "lookup failed; do not retry". */
+    static int tags[IB_STATE_NUM];
+
+    int entry = tags[state];
+
+    if (entry == 0) {
+        int tag = ib_profiler_tag(ib_state_name(state));
+        entry = (tag >= 0) ? tag + 1 : -1;
+        tags[state] = entry;
+    }
+
+    return (entry > 0) ? entry - 1 : -1;
+}
+
+/**
+ * True if any hook subscribes to @a state.
+ *
+ * Checked before dispatch so states nobody registered for skip the
+ * flight recorder, the profiler and the hook walk entirely.
+ *
+ * @param[in] ib The engine.
+ * @param[in] state The state being dispatched.
+ *
+ * @returns True if the state has at least one hook.
+ */
+static bool state_has_hooks(const ib_engine_t *ib, ib_state_t state)
+{
+    return (ib->hook_mask & ((uint64_t)1 << state)) != 0;
+}
+
 static ib_status_t ib_state_notify_null(
     ib_engine_t *ib,
     ib_state_t state
@@ -128,6 +170,13 @@ static ib_status_t ib_state_notify_null(
 
     ib_log_debug3(ib, "NULL EVENT: %s", ib_state_name(state));
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -137,9 +186,11 @@ static ib_status_t ib_state_notify_null(
         }
         else if (rc != IB_OK) {
             log_hook_failure(ib, state, rc, hook->callback.null);
+            ib_profiler_exit();
             return rc;
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -164,6 +215,13 @@ static ib_status_t ib_state_notify_context(
 
     ib_log_debug3(ib, "CTX EVENT: %s", ib_state_name(state));
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -173,9 +231,11 @@ static ib_status_t ib_state_notify_context(
         }
         else if (rc != IB_OK) {
             log_hook_failure(ib, state, rc, hook->callback.ctx);
+            ib_profiler_exit();
             return rc;
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -205,6 +265,13 @@ static ib_status_t ib_state_notify_conn(
         ib_log_notice(ib, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -216,6 +283,7 @@ static ib_status_t ib_state_notify_conn(
             log_hook_failure(ib, state, rc, hook->callback.conn);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -259,6 +327,13 @@ static ib_status_t ib_state_notify_req_line(
         ib_log_notice_tx(tx, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -271,6 +346,7 @@ static ib_status_t ib_state_notify_req_line(
             log_hook_failure(ib, state, rc, hook->callback.requestline);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -324,6 +400,13 @@ static ib_status_t ib_state_notify_resp_line(ib_engine_t *ib,
         ib_log_notice_tx(tx, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -336,6 +419,7 @@ static ib_status_t ib_state_notify_resp_line(ib_engine_t *ib,
             log_hook_failure(ib, state, rc, hook->callback.responseline);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -363,6 +447,13 @@ static ib_status_t ib_state_notify_tx(ib_engine_t *ib,
         ib_log_notice_tx(tx, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -375,6 +466,7 @@ static ib_status_t ib_state_notify_tx(ib_engine_t *ib,
             log_hook_failure(ib, state, rc, hook->callback.tx);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -398,7 +490,7 @@ ib_status_t ib_state_notify_request_started(
     }
 
     /* Mark the time. */
-    tx->t.request_started = ib_clock_get_time();
+    tx->t.request_started = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FREQ_STARTED);
 
@@ -543,7 +635,7 @@ ib_status_t ib_state_notify_conn_closed(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    conn->t.finished = ib_clock_get_time();
+    conn->t.finished = ib_clock_coarse_refresh();
 
     ib_flags_set(conn->flags, IB_CONN_FCLOSED);
 
@@ -590,6 +682,13 @@ static ib_status_t ib_state_notify_header_data(ib_engine_t *ib,
         ib_log_notice_tx(tx, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -603,6 +702,7 @@ static ib_status_t ib_state_notify_header_data(ib_engine_t *ib,
             log_hook_failure(ib, state, rc, hook->callback.headerdata);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -638,6 +738,13 @@ static ib_status_t ib_state_notify_txdata(ib_engine_t *ib,
         ib_log_notice_tx(tx, "Connection context is null.");
     }
 
+    /* Nothing subscribed to this state: skip dispatch entirely. */
+    if (! state_has_hooks(ib, state)) {
+        return IB_OK;
+    }
+
+    ib_flightrec_record(IB_FLIGHTREC_STATE, ib_state_name(state), 0);
+    ib_profiler_enter(state_profiler_tag(state));
     IB_LIST_LOOP_CONST(ib->hooks[state], node) {
         const ib_hook_t *hook =
             (const ib_hook_t *)ib_list_node_data_const(node);
@@ -650,6 +757,7 @@ static ib_status_t ib_state_notify_txdata(ib_engine_t *ib,
             log_hook_failure(ib, state, rc, hook->callback.txdata);
         }
     }
+    ib_profiler_exit();
 
     return IB_OK;
 }
@@ -678,7 +786,7 @@ ib_status_t ib_state_notify_request_header_data(ib_engine_t *ib,
 
     /* Mark the time. */
     if (tx->t.request_started == 0) {
-        tx->t.request_started = ib_clock_get_time();
+        tx->t.request_started = ib_clock_coarse_refresh();
     }
 
     if ( tx->request_header == NULL ) {
@@ -745,7 +853,7 @@ ib_status_t ib_state_notify_request_header_finished(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.request_header = ib_clock_get_time();
+    tx->t.request_header = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FREQ_HEADER);
 
@@ -779,10 +887,34 @@ ib_status_t ib_state_notify_request_header_finished(ib_engine_t *ib,
     return IB_OK;
 }
 
-ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
-                                              ib_tx_t *tx,
-                                              const char *data,
-                                              size_t data_length)
+/**
+ * Release aliased body data on paths that do not reach the pump.
+ *
+ * The pump owns the release once ib_stream_pump_process_alias() is
+ * called. Any return before that point must release here instead.
+ *
+ * @param[in] alias True if the data is aliased, not copied.
+ * @param[in] release_fn Release function. May be NULL.
+ * @param[in] release_cbdata Callback data for @a release_fn.
+ */
+static void body_data_release(
+    bool                       alias,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata)
+{
+    if (alias && release_fn != NULL) {
+        release_fn(release_cbdata);
+    }
+}
+
+static ib_status_t state_notify_request_body_data(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    bool                       alias,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata)
 {
     assert(ib != NULL);
     assert(ib->cfg_state == CFG_FINISHED);
@@ -795,33 +927,39 @@ ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
     if (! ib_flags_all(tx->flags, IB_TX_FREQ_STARTED)) {
         ib_log_debug_tx(tx, "No request started: Ignoring %s",
                         ib_state_name(request_body_data_state));
+        body_data_release(alias, release_fn, release_cbdata);
         return IB_OK;
     }
     if (! ib_flags_all(tx->flags, IB_TX_FREQ_HAS_DATA)) {
         ib_log_debug_tx(tx, "No request data: Ignoring %s",
                         ib_state_name(request_body_data_state));
+        body_data_release(alias, release_fn, release_cbdata);
         return IB_OK;
     }
 
     /* We should never get NULL data. */
     if ( (data == NULL) || (data_length == 0) ) {
         ib_log_debug_tx(tx, "Request body data with no data.  Ignoring.");
+        body_data_release(alias, release_fn, release_cbdata);
         return IB_OK;
     }
 
     if (! ib_flags_all(tx->flags, IB_TX_FREQ_LINE)) {
         if (tx->request_line == NULL) {
             ib_log_error_tx(tx, "Request has no request line.");
+            body_data_release(alias, release_fn, release_cbdata);
             return IB_EINVAL;
         }
 
         rc = ib_state_notify_request_started(ib, tx, tx->request_line);
         if (rc != IB_OK) {
+            body_data_release(alias, release_fn, release_cbdata);
             return rc;
         }
 
         rc = ib_state_notify_request_header_finished(ib, tx);
         if (rc != IB_OK) {
+            body_data_release(alias, release_fn, release_cbdata);
             return rc;
         }
     }
@@ -838,7 +976,7 @@ ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
 
     /* On the first call, record the time and mark that there is a body. */
     if (tx->t.request_body == 0) {
-        tx->t.request_body = ib_clock_get_time();
+        tx->t.request_body = ib_clock_coarse_refresh();
         ib_tx_flags_set(tx, IB_TX_FREQ_BODY);
         tx->request_body_len = data_length;
     }
@@ -849,14 +987,25 @@ ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
     /* Notify the engine and any callbacks of the data. */
     rc = ib_state_notify_txdata(ib, tx, request_body_data_state, data, data_length);
     if (rc != IB_OK) {
+        body_data_release(alias, release_fn, release_cbdata);
         return rc;
     }
 
     /* Pass data through streaming system. */
-    rc = ib_stream_pump_process(
-        ib_tx_request_body_pump(tx),
-        (const uint8_t *)data,
-        data_length);
+    if (alias) {
+        rc = ib_stream_pump_process_alias(
+            ib_tx_request_body_pump(tx),
+            (const uint8_t *)data,
+            data_length,
+            release_fn,
+            release_cbdata);
+    }
+    else {
+        rc = ib_stream_pump_process(
+            ib_tx_request_body_pump(tx),
+            (const uint8_t *)data,
+            data_length);
+    }
     if (rc != IB_OK) {
         return rc;
     }
@@ -864,6 +1013,27 @@ ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
     return IB_OK;
 }
 
+ib_status_t ib_state_notify_request_body_data(ib_engine_t *ib,
+                                              ib_tx_t *tx,
+                                              const char *data,
+                                              size_t data_length)
+{
+    return state_notify_request_body_data(
+        ib, tx, data, data_length, false, NULL, NULL);
+}
+
+ib_status_t ib_state_notify_request_body_data_alias(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata)
+{
+    return state_notify_request_body_data(
+        ib, tx, data, data_length, true, release_fn, release_cbdata);
+}
+
 ib_status_t ib_state_notify_request_finished(ib_engine_t *ib,
                                              ib_tx_t *tx)
 {
@@ -899,7 +1069,7 @@ ib_status_t ib_state_notify_request_finished(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.request_finished = ib_clock_get_time();
+    tx->t.request_finished = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FREQ_FINISHED);
 
@@ -949,7 +1119,7 @@ ib_status_t ib_state_notify_response_started(ib_engine_t *ib,
         return IB_OK;
     }
 
-    tx->t.response_started = ib_clock_get_time();
+    tx->t.response_started = ib_clock_coarse_refresh();
 
     /* Validate. */
     if (ib_flags_all(tx->flags, IB_TX_FRES_STARTED)) {
@@ -969,7 +1139,7 @@ ib_status_t ib_state_notify_response_started(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.response_started = ib_clock_get_time();
+    tx->t.response_started = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FRES_STARTED);
 
@@ -1011,7 +1181,7 @@ ib_status_t ib_state_notify_response_header_data(ib_engine_t *ib,
 
     /* Mark the time. */
     if (tx->t.response_started == 0) {
-        tx->t.response_started = ib_clock_get_time();
+        tx->t.response_started = ib_clock_coarse_refresh();
     }
 
     if ( tx->response_header == NULL ) {
@@ -1101,7 +1271,7 @@ ib_status_t ib_state_notify_response_header_finished(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.response_header = ib_clock_get_time();
+    tx->t.response_header = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FRES_HEADER);
 
@@ -1119,10 +1289,14 @@ ib_status_t ib_state_notify_response_header_finished(ib_engine_t *ib,
     return IB_OK;
 }
 
-ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
-                                               ib_tx_t *tx,
-                                               const char *data,
-                                               size_t data_length)
+static ib_status_t state_notify_response_body_data(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    bool                       alias,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata)
 {
     assert(ib != NULL);
     assert(ib->cfg_state == CFG_FINISHED);
@@ -1135,12 +1309,14 @@ ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
     if (! ib_flags_all(tx->flags, IB_TX_FREQ_HAS_DATA)) {
         ib_log_debug_tx(tx, "No request data: Ignoring %s",
                         ib_state_name(response_body_data_state));
+        body_data_release(alias, release_fn, release_cbdata);
         return IB_OK;
     }
 
     /* We should never get empty data */
     if ( (data == NULL) || (data_length == 0) ) {
         ib_log_debug_tx(tx, "Response body data with no data.  Ignoring.");
+        body_data_release(alias, release_fn, release_cbdata);
         return IB_OK;
     }
 
@@ -1156,18 +1332,20 @@ ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
                 ib_log_notice_tx(tx,
                                  "Attempted to notify response body data"
                                  " before response started.");
+                body_data_release(alias, release_fn, release_cbdata);
                 return IB_EINVAL;
             }
         }
         rc = ib_state_notify_response_header_finished(ib, tx);
         if (rc != IB_OK) {
+            body_data_release(alias, release_fn, release_cbdata);
             return rc;
         }
     }
 
     /* On the first call, record the time and mark that there is a body. */
     if (tx->t.response_body == 0) {
-        tx->t.response_body = ib_clock_get_time();
+        tx->t.response_body = ib_clock_coarse_refresh();
         ib_tx_flags_set(tx, IB_TX_FRES_HAS_DATA);
         ib_tx_flags_set(tx, IB_TX_FRES_BODY);
         tx->response_body_len = data_length;
@@ -1179,14 +1357,25 @@ ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
     /* Notify the engine and any callbacks of the data. */
     rc = ib_state_notify_txdata(ib, tx, response_body_data_state, data, data_length);
     if (rc != IB_OK) {
+        body_data_release(alias, release_fn, release_cbdata);
         return rc;
     }
 
     /* Pass data through streaming system. */
-    rc = ib_stream_pump_process(
-        ib_tx_response_body_pump(tx),
-        (const uint8_t *)data,
-        data_length);
+    if (alias) {
+        rc = ib_stream_pump_process_alias(
+            ib_tx_response_body_pump(tx),
+            (const uint8_t *)data,
+            data_length,
+            release_fn,
+            release_cbdata);
+    }
+    else {
+        rc = ib_stream_pump_process(
+            ib_tx_response_body_pump(tx),
+            (const uint8_t *)data,
+            data_length);
+    }
     if (rc != IB_OK) {
         return rc;
     }
@@ -1194,6 +1383,27 @@ ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
     return IB_OK;
 }
 
+ib_status_t ib_state_notify_response_body_data(ib_engine_t *ib,
+                                               ib_tx_t *tx,
+                                               const char *data,
+                                               size_t data_length)
+{
+    return state_notify_response_body_data(
+        ib, tx, data, data_length, false, NULL, NULL);
+}
+
+ib_status_t ib_state_notify_response_body_data_alias(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata)
+{
+    return state_notify_response_body_data(
+        ib, tx, data, data_length, true, release_fn, release_cbdata);
+}
+
 ib_status_t ib_state_notify_response_finished(ib_engine_t *ib,
                                               ib_tx_t *tx)
 {
@@ -1229,7 +1439,7 @@ ib_status_t ib_state_notify_response_finished(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.response_finished = ib_clock_get_time();
+    tx->t.response_finished = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FRES_FINISHED);
 
@@ -1258,7 +1468,7 @@ ib_status_t ib_state_notify_response_finished(ib_engine_t *ib,
     }
 
     /* Mark the time. */
-    tx->t.finished = ib_clock_get_time();
+    tx->t.finished = ib_clock_coarse_refresh();
 
     /* Signal that all data should leave the pipeline. */
     rc = ib_stream_pump_close(ib_tx_request_body_pump(tx));
@@ -1291,7 +1501,7 @@ ib_status_t ib_state_notify_postprocess(ib_engine_t *ib,
     }
 
     /* Mark time. */
-    tx->t.postprocess = ib_clock_get_time();
+    tx->t.postprocess = ib_clock_coarse_refresh();
 
     ib_tx_flags_set(tx, IB_TX_FPOSTPROCESS);
 
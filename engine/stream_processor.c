@@ -47,6 +47,7 @@ struct ib_stream_processor_def_t {
     void                           *execute_cbdata; /**< Callback data. */
     ib_stream_processor_destroy_fn  destroy_fn;     /**< Destroy function. */
     void                           *destroy_cbdata; /**< Callback data. */
+    bool                            observe_only;   /**< Never alters data. */
 };
 typedef struct ib_stream_processor_def_t ib_stream_processor_def_t;
 
@@ -183,6 +184,7 @@ ib_status_t ib_stream_processor_registry_register(
     def->execute_cbdata = execute_cbdata;
     def->destroy_fn     = destroy_fn;
     def->destroy_cbdata = destroy_cbdata;
+    def->observe_only   = false;
     def->name           = ib_mm_strdup(registry->mm, name);
     if (def->name == NULL) {
         return IB_EALLOC;
@@ -252,6 +254,38 @@ ib_status_t ib_stream_processor_registry_register(
     return IB_OK;
 }
 
+ib_status_t ib_stream_processor_registry_observe_only_set(
+    ib_stream_processor_registry_t *registry,
+    const char                     *name,
+    bool                            observe_only
+)
+{
+    assert(registry != NULL);
+    assert(name != NULL);
+
+    ib_stream_processor_def_t *def;
+    ib_status_t                rc;
+
+    rc = ib_hash_get(registry->processor_by_name, &def, name);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    def->observe_only = observe_only;
+
+    return IB_OK;
+}
+
+bool ib_stream_processor_observe_only(
+    const ib_stream_processor_t *processor
+)
+{
+    assert(processor != NULL);
+    assert(processor->def != NULL);
+
+    return processor->def->observe_only;
+}
+
 static void stream_processor_destroy(void *cbdata) {
 
     ib_stream_processor_t *inst = (ib_stream_processor_t *)cbdata;
@@ -24,11 +24,14 @@
 
 #include "ironbee_config_auto.h"
 
+#include <ironbee/flightrec.h>
 #include <ironbee/list.h>
 #include <ironbee/log.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/mpool_freeable.h>
 #include <ironbee/mpool_lite.h>
+#include <ironbee/profiler.h>
 #include <ironbee/stream_io.h>
 #include <ironbee/stream_pump.h>
 
@@ -50,6 +53,13 @@ struct ib_stream_pump_t {
 
     //! IO System for handling data ownership.
     ib_stream_io_t *io;
+
+    /*! IO transaction reused for every burst.
+     *
+     * A burst leaves both queues empty, so one transaction serves the
+     * life of the pump and its queues keep their grown capacity.
+     * Created on first use. */
+    ib_stream_io_tx_t *io_tx;
 };
 
 ib_status_t ib_stream_pump_create(
@@ -87,11 +97,46 @@ ib_status_t ib_stream_pump_create(
     tmp_pump->mm       = mm;
     tmp_pump->registry = registry;
     tmp_pump->tx       = tx;
+    tmp_pump->io_tx    = NULL;
 
     *pump = tmp_pump;
     return IB_OK;
 }
 
+/**
+ * Get the pump's IO transaction, creating it on first use.
+ *
+ * Processing always ends in ib_stream_io_tx_cleanup(), which empties
+ * both queues, so the same transaction is handed out for every burst
+ * rather than allocating one per burst from the IronBee transaction's
+ * memory manager.
+ *
+ * @param[in] pump The pump.
+ * @param[out] io_tx The IO transaction.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on creation errors.
+ */
+static ib_status_t stream_pump_io_tx(
+    ib_stream_pump_t   *pump,
+    ib_stream_io_tx_t **io_tx
+)
+{
+    assert(pump != NULL);
+    assert(io_tx != NULL);
+
+    if (pump->io_tx == NULL) {
+        ib_status_t rc = ib_stream_io_tx_create(&pump->io_tx, pump->io);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *io_tx = pump->io_tx;
+    return IB_OK;
+}
+
 /**
  * Execute all the pumps and cleanup @a io_tx.
  *
@@ -121,8 +166,15 @@ static ib_status_t stream_pump_process(
         ib_stream_processor_t *processor =
             (ib_stream_processor_t *)ib_list_node_data(node);
 
-        /* Execute a processor on an IO transaction. */
+        /* Execute a processor on an IO transaction.
+         *
+         * The profiler tag lookup hits its lock-free fast path here:
+         * processor names are stable registry strings, so after the
+         * first chunk the name is found by pointer comparison. */
+        ib_profiler_enter(
+            ib_profiler_tag(ib_stream_processor_name(processor)));
         rc = ib_stream_processor_execute(processor, pump->tx, mm_eval, io_tx);
+        ib_profiler_exit();
 
         /* If evaluation of a processor is OK, the tx may be reused. */
         if (rc == IB_OK) {
@@ -229,7 +281,15 @@ ib_status_t ib_stream_pump_process(
         return IB_OK;
     }
 
-    rc = ib_stream_io_tx_create(&io_tx, pump->io);
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire("pump.bytes", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, data_len);
+    }
+
+    rc = stream_pump_io_tx(pump, &io_tx);
     if (rc != IB_OK) {
         ib_log_alert_tx(pump->tx, "Failed to create io transaction.");
         return rc;
@@ -251,6 +311,62 @@ ib_status_t ib_stream_pump_process(
     return rc;
 }
 
+ib_status_t ib_stream_pump_process_alias(
+    ib_stream_pump_t          *pump,
+    const uint8_t             *data,
+    size_t                     data_len,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata
+)
+{
+    assert(pump != NULL);
+
+    ib_status_t        rc;
+    ib_stream_io_tx_t *io_tx;
+
+    /* If the user asked us to operate on nothing, that's OK! Do nothing. */
+    if (data == NULL || data_len == 0) {
+        if (release_fn != NULL) {
+            release_fn(release_cbdata);
+        }
+        return IB_OK;
+    }
+
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire("pump.bytes", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, data_len);
+    }
+
+    rc = stream_pump_io_tx(pump, &io_tx);
+    if (rc != IB_OK) {
+        ib_log_alert_tx(pump->tx, "Failed to create io transaction.");
+        if (release_fn != NULL) {
+            release_fn(release_cbdata);
+        }
+        return rc;
+    }
+
+    /* After this point the stream owns the data and will release it. */
+    rc = ib_stream_io_tx_data_alias_add(
+        io_tx, data, data_len, release_fn, release_cbdata);
+    if (rc != IB_OK) {
+        ib_log_alert_tx(pump->tx, "Failed to add data to io transaction.");
+        return rc;
+    }
+
+    /* Setup and run the processor. */
+    rc = stream_pump_process_setup_and_run(pump, io_tx);
+    if (rc != IB_OK) {
+        ib_log_alert_tx(pump->tx, "Failed to setup and run pump.");
+        return rc;
+    }
+
+    return rc;
+}
+
 ib_status_t ib_stream_pump_flush(
     ib_stream_pump_t *pump
 )
@@ -260,7 +376,7 @@ ib_status_t ib_stream_pump_flush(
     ib_status_t                 rc;
     ib_stream_io_tx_t          *io_tx;
 
-    rc = ib_stream_io_tx_create(&io_tx, pump->io);
+    rc = stream_pump_io_tx(pump, &io_tx);
     if (rc != IB_OK) {
         ib_log_alert_tx(pump->tx, "Failed to create io transaction.");
         return rc;
@@ -272,6 +388,8 @@ ib_status_t ib_stream_pump_flush(
         return rc;
     }
 
+    ib_flightrec_record(IB_FLIGHTREC_PUMP, "flush", 0);
+
     /* Setup and run the processor. */
     rc = stream_pump_process_setup_and_run(pump, io_tx);
     if (rc != IB_OK) {
@@ -291,7 +409,7 @@ ib_status_t ib_stream_pump_close(
     ib_status_t                 rc;
     ib_stream_io_tx_t          *io_tx;
 
-    rc = ib_stream_io_tx_create(&io_tx, pump->io);
+    rc = stream_pump_io_tx(pump, &io_tx);
     if (rc != IB_OK) {
         ib_log_alert_tx(pump->tx, "Failed to create io transaction.");
         return rc;
@@ -303,6 +421,8 @@ ib_status_t ib_stream_pump_close(
         return rc;
     }
 
+    ib_flightrec_record(IB_FLIGHTREC_PUMP, "close", 0);
+
     /* Setup and run the processor. */
     rc = stream_pump_process_setup_and_run(pump, io_tx);
     if (rc != IB_OK) {
@@ -325,7 +445,7 @@ ib_status_t ib_stream_pump_error(
     ib_status_t                 rc;
     ib_stream_io_tx_t          *io_tx;
 
-    rc = ib_stream_io_tx_create(&io_tx, pump->io);
+    rc = stream_pump_io_tx(pump, &io_tx);
     if (rc != IB_OK) {
         ib_log_alert_tx(pump->tx, "Failed to create io transaction.");
         return rc;
@@ -380,6 +500,27 @@ ib_status_t ib_stream_pump_processor_add(
     return IB_OK;
 }
 
+bool ib_stream_pump_transparent(
+    const ib_stream_pump_t *pump
+)
+{
+    assert(pump != NULL);
+    assert(pump->processors != NULL);
+
+    const ib_list_node_t *node;
+
+    IB_LIST_LOOP_CONST(pump->processors, node) {
+        ib_stream_processor_t *processor =
+            (ib_stream_processor_t *)ib_list_node_data_const(node);
+
+        if (! ib_stream_processor_observe_only(processor)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 ib_status_t ib_stream_pump_processor_insert(
     ib_stream_pump_t *pump,
     const char       *name,
@@ -0,0 +1,444 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+/// @file
+/// @brief IronBee --- Microbenchmark driver
+///
+/// Times the hot entry points of the core operators, core transformations,
+/// the hash table and the IP set against representative WAF inputs (header
+/// names, urlencoded bodies, CIDR tables).  Not part of "make check"; build
+/// and run with "make benchmark".
+///
+/// Each benchmark is calibrated to run long enough for a stable per-call
+/// time and the results are emitted as google-benchmark style JSON on
+/// stdout so they can be trended across runs.
+///
+/// @author Craig Forbes <cforbes@qualys.com>
+//////////////////////////////////////////////////////////////////////////////
+
+#include <ironbee/engine.h>
+#include <ironbee/context.h>
+#include <ironbee/field.h>
+#include <ironbee/hash.h>
+#include <ironbee/ip.h>
+#include <ironbee/ipset.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+#include <ironbee/operator.h>
+#include <ironbee/release.h>
+#include <ironbee/server.h>
+#include <ironbee/string.h>
+#include <ironbee/transformation.h>
+#include <ironbee/util.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+namespace {
+
+/* Wall clock in nanoseconds. */
+uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+struct bench_result_t
+{
+    std::string name;       /**< Benchmark name. */
+    uint64_t    iterations; /**< Iterations of the timed run. */
+    double      ns_per_op;  /**< Wall time per iteration. */
+};
+
+std::vector<bench_result_t> g_results;
+
+/* Run @a body repeatedly, scaling the iteration count until the timed run
+ * lasts at least min_run_ns, and record the per-iteration time. */
+template <typename F>
+void run_bench(const std::string& name, const F& body)
+{
+    static const uint64_t min_run_ns = 100000000ULL; /* 100ms */
+
+    uint64_t iterations = 1;
+    for (;;) {
+        uint64_t start = now_ns();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            body();
+        }
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed >= min_run_ns) {
+            bench_result_t result;
+            result.name = name;
+            result.iterations = iterations;
+            result.ns_per_op = (double)elapsed / (double)iterations;
+            g_results.push_back(result);
+            return;
+        }
+        /* Aim past the threshold with headroom; at least double. */
+        uint64_t next = (elapsed > 0)
+            ? iterations * (2 * min_run_ns / elapsed + 1)
+            : iterations * 2;
+        iterations = (next > 2 * iterations) ? next : 2 * iterations;
+    }
+}
+
+void throw_if_error(ib_status_t rc, const char *what)
+{
+    if (rc != IB_OK) {
+        throw std::runtime_error(
+            std::string(what) + ": " + ib_status_to_string(rc)
+        );
+    }
+}
+
+/* Header names as seen on a typical browser request. */
+const char *c_header_names[] = {
+    "Host", "Connection", "Content-Length", "Content-Type", "User-Agent",
+    "Accept", "Accept-Encoding", "Accept-Language", "Accept-Charset",
+    "Cookie", "Referer", "Origin", "Cache-Control", "Pragma",
+    "If-Modified-Since", "If-None-Match", "Upgrade-Insecure-Requests",
+    "X-Requested-With", "X-Forwarded-For", "X-Forwarded-Proto",
+    "X-Real-IP", "Authorization", "Range", "TE", "DNT", "Via",
+    "Transfer-Encoding", "Expect", "Date", "Warning", "Forwarded",
+    "Sec-Fetch-Mode"
+};
+const size_t c_num_header_names =
+    sizeof(c_header_names) / sizeof(*c_header_names);
+
+/* A representative urlencoded POST body. */
+const char c_urlencoded_body[] =
+    "user=alice%40example.com&redirect=%2Faccount%2Fsettings%3Ftab%3D2"
+    "&comment=Hello%20World%21%20%3Cb%3Ebold%3C%2Fb%3E%20%26%20more"
+    "&token=a1b2c3d4e5f60718293a4b5c6d7e8f90&lang=en-US&tz=%2B01%3A00"
+    "&q=select+%2A+from+users+where+id%3D1&submit=Save%20Changes";
+
+/* The same content with HTML entities, as seen in reflected markup. */
+const char c_entity_body[] =
+    "user=alice&#64;example.com&amp;comment=Hello &quot;World&quot; "
+    "&lt;b&gt;bold&lt;/b&gt; &amp; more &#x3C;script&#x3E; &copy; 2014 "
+    "&amp;token=a1b2c3d4e5f60718293a4b5c6d7e8f90&amp;submit=Save";
+
+struct hash_get_hit_body_t
+{
+    explicit hash_get_hit_body_t(const ib_hash_t *hash) : m_hash(hash) {}
+    void operator()() const
+    {
+        for (size_t i = 0; i < c_num_header_names; ++i) {
+            void *v;
+            ib_hash_get(m_hash, &v, c_header_names[i]);
+        }
+    }
+    const ib_hash_t *m_hash;
+};
+
+struct hash_get_miss_body_t
+{
+    explicit hash_get_miss_body_t(const ib_hash_t *hash) : m_hash(hash) {}
+    void operator()() const
+    {
+        void *v;
+        ib_hash_get(m_hash, &v, "X-No-Such-Header");
+    }
+    const ib_hash_t *m_hash;
+};
+
+void bench_hash(ib_mm_t mm)
+{
+    ib_hash_t *hash;
+    ib_status_t rc;
+
+    rc = ib_hash_create_nocase(&hash, mm);
+    throw_if_error(rc, "Failed to create hash");
+
+    for (size_t i = 0; i < c_num_header_names; ++i) {
+        rc = ib_hash_set(hash, c_header_names[i], (void *)c_header_names[i]);
+        throw_if_error(rc, "Failed to populate hash");
+    }
+
+    run_bench("hash/get_hit", hash_get_hit_body_t(hash));
+    run_bench("hash/get_miss", hash_get_miss_body_t(hash));
+}
+
+struct ipset4_query_body_t
+{
+    ipset4_query_body_t(const ib_ipset4_t *set, ib_ip4_t ip) :
+        m_set(set), m_ip(ip)
+    {}
+    void operator()() const
+    {
+        ib_ipset4_query(m_set, m_ip, NULL, NULL, NULL);
+    }
+    const ib_ipset4_t *m_set;
+    ib_ip4_t           m_ip;
+};
+
+void bench_ipset()
+{
+    /* A CIDR table shaped like a geo/deny list: /16s with /24 carve-outs. */
+    static ib_ipset4_entry_t entries[512];
+    ib_ipset4_t set;
+    ib_status_t rc;
+    char buf[32];
+
+    for (int i = 0; i < 256; ++i) {
+        snprintf(buf, sizeof(buf), "10.%d.0.0/16", i);
+        rc = ib_ip4_str_to_net(buf, &entries[i].network);
+        throw_if_error(rc, "Failed to parse network");
+        entries[i].data = NULL;
+    }
+    for (int i = 0; i < 256; ++i) {
+        snprintf(buf, sizeof(buf), "192.168.%d.0/24", i);
+        rc = ib_ip4_str_to_net(buf, &entries[256 + i].network);
+        throw_if_error(rc, "Failed to parse network");
+        entries[256 + i].data = NULL;
+    }
+
+    rc = ib_ipset4_init(&set, NULL, 0, entries, 512);
+    throw_if_error(rc, "Failed to init ipset");
+
+    ib_ip4_t ip_hit;
+    ib_ip4_t ip_miss;
+    rc = ib_ip4_str_to_ip("10.42.17.3", &ip_hit);
+    throw_if_error(rc, "Failed to parse IP");
+    rc = ib_ip4_str_to_ip("172.16.9.1", &ip_miss);
+    throw_if_error(rc, "Failed to parse IP");
+
+    run_bench("ipset4/query_hit", ipset4_query_body_t(&set, ip_hit));
+    run_bench("ipset4/query_miss", ipset4_query_body_t(&set, ip_miss));
+}
+
+struct tfn_execute_body_t
+{
+    tfn_execute_body_t(
+        const ib_transformation_inst_t *tfn_inst,
+        const ib_field_t               *fin,
+        ib_mpool_t                     *pool
+    ) :
+        m_tfn_inst(tfn_inst), m_fin(fin), m_pool(pool)
+    {}
+    void operator()() const
+    {
+        const ib_field_t *fout;
+        ib_transformation_inst_execute(
+            m_tfn_inst, ib_mm_mpool(m_pool), m_fin, &fout
+        );
+        ib_mpool_clear(m_pool);
+    }
+    const ib_transformation_inst_t *m_tfn_inst;
+    const ib_field_t               *m_fin;
+    ib_mpool_t                     *m_pool;
+};
+
+void bench_transformation(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *input,
+    size_t       input_length
+)
+{
+    const ib_transformation_t *tfn;
+    ib_transformation_inst_t *tfn_inst;
+    ib_field_t *fin;
+    ib_bytestr_t *bs;
+    ib_status_t rc;
+
+    rc = ib_transformation_lookup(ib, name, strlen(name), &tfn);
+    throw_if_error(rc, "Failed to lookup transformation");
+    rc = ib_transformation_inst_create(&tfn_inst, mm, tfn, "");
+    throw_if_error(rc, "Failed to create transformation instance");
+
+    rc = ib_bytestr_alias_mem(&bs, mm, (const uint8_t *)input, input_length);
+    throw_if_error(rc, "Failed to create bytestr");
+    rc = ib_field_create(
+        &fin, mm, IB_S2SL("bench"),
+        IB_FTYPE_BYTESTR, ib_ftype_bytestr_in(bs)
+    );
+    throw_if_error(rc, "Failed to create field");
+
+    /* A pool drained every iteration keeps output allocations from
+     * accumulating across the millions of calls. */
+    ib_mpool_t *pool;
+    rc = ib_mpool_create(&pool, "bench", NULL);
+    throw_if_error(rc, "Failed to create pool");
+
+    run_bench(std::string("tfn/") + name,
+              tfn_execute_body_t(tfn_inst, fin, pool));
+
+    ib_mpool_destroy(pool);
+}
+
+struct op_execute_body_t
+{
+    op_execute_body_t(
+        const ib_operator_inst_t *op_inst,
+        const ib_field_t         *input
+    ) :
+        m_op_inst(op_inst), m_input(input)
+    {}
+    void operator()() const
+    {
+        ib_num_t result;
+        ib_operator_inst_execute(m_op_inst, NULL, m_input, NULL, &result);
+    }
+    const ib_operator_inst_t *m_op_inst;
+    const ib_field_t         *m_input;
+};
+
+void bench_operator(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *parameters,
+    ib_field_t  *input
+)
+{
+    const ib_operator_t *op;
+    ib_operator_inst_t *op_inst;
+    ib_status_t rc;
+
+    rc = ib_operator_lookup(ib, name, strlen(name), &op);
+    throw_if_error(rc, "Failed to lookup operator");
+    rc = ib_operator_inst_create(
+        &op_inst, mm, ib_context_main(ib),
+        op, IB_OP_CAPABILITY_NONE, parameters
+    );
+    throw_if_error(rc, "Failed to create operator instance");
+
+    run_bench(std::string("operator/") + name,
+              op_execute_body_t(op_inst, input));
+}
+
+void bench_operators(ib_engine_t *ib, ib_mm_t mm)
+{
+    ib_field_t *agent_field;
+    ib_field_t *num_field;
+    ib_field_t *ip_field;
+    ib_bytestr_t *bs;
+    ib_num_t num = 1;
+    ib_status_t rc;
+
+    static const char c_user_agent[] =
+        "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36"
+        " (KHTML, like Gecko) Chrome/33.0.1750.117 Safari/537.36";
+
+    rc = ib_bytestr_alias_nulstr(&bs, mm, c_user_agent);
+    throw_if_error(rc, "Failed to create bytestr");
+    rc = ib_field_create(
+        &agent_field, mm, IB_S2SL("ua"),
+        IB_FTYPE_BYTESTR, ib_ftype_bytestr_in(bs)
+    );
+    throw_if_error(rc, "Failed to create field");
+
+    rc = ib_field_create(
+        &num_field, mm, IB_S2SL("n"), IB_FTYPE_NUM, ib_ftype_num_in(&num)
+    );
+    throw_if_error(rc, "Failed to create field");
+
+    rc = ib_field_create(
+        &ip_field, mm, IB_S2SL("ip"),
+        IB_FTYPE_NULSTR, ib_ftype_nulstr_in("10.42.17.3")
+    );
+    throw_if_error(rc, "Failed to create field");
+
+    bench_operator(ib, mm, "contains", "Gecko", agent_field);
+    bench_operator(ib, mm, "streq", c_user_agent, agent_field);
+    bench_operator(ib, mm, "istreq", c_user_agent, agent_field);
+    bench_operator(ib, mm, "eq", "1", num_field);
+    bench_operator(ib, mm, "ipmatch",
+                   "10.0.0.0/8 192.168.0.0/16 172.16.0.0/12", ip_field);
+}
+
+void emit_json()
+{
+    time_t t = time(NULL);
+    char date[64];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+
+    printf("{\n");
+    printf("  \"context\": {\n");
+    printf("    \"date\": \"%s\",\n", date);
+    printf("    \"library\": \"ironbee\",\n");
+    printf("    \"library_version\": \"%s\"\n", IB_VERSION);
+    printf("  },\n");
+    printf("  \"benchmarks\": [\n");
+    for (size_t i = 0; i < g_results.size(); ++i) {
+        const bench_result_t& r = g_results[i];
+        printf("    {\n");
+        printf("      \"name\": \"%s\",\n", r.name.c_str());
+        printf("      \"iterations\": %llu,\n",
+               (unsigned long long)r.iterations);
+        printf("      \"real_time\": %.2f,\n", r.ns_per_op);
+        printf("      \"time_unit\": \"ns\"\n");
+        printf("    }%s\n", (i + 1 < g_results.size()) ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    ib_server_t server;
+    ib_engine_t *ib;
+    ib_status_t rc;
+
+    memset(&server, 0, sizeof(server));
+    server.vernum = IB_VERNUM;
+    server.abinum = IB_ABINUM;
+    server.version = IB_VERSION;
+    server.filename = __FILE__;
+    server.name = "benchmark";
+
+    rc = ib_initialize();
+    throw_if_error(rc, "Failed to initialize IronBee");
+    rc = ib_engine_create(&ib, &server);
+    throw_if_error(rc, "Failed to create engine");
+
+    ib_mm_t mm = ib_engine_mm_main_get(ib);
+
+    bench_hash(mm);
+    bench_ipset();
+    bench_transformation(
+        ib, mm, "urlDecode",
+        c_urlencoded_body, sizeof(c_urlencoded_body) - 1
+    );
+    bench_transformation(
+        ib, mm, "htmlEntityDecode",
+        c_entity_body, sizeof(c_entity_body) - 1
+    );
+    bench_transformation(
+        ib, mm, "lowercase",
+        c_urlencoded_body, sizeof(c_urlencoded_body) - 1
+    );
+    bench_operators(ib, mm);
+
+    emit_json();
+
+    ib_engine_destroy(ib);
+    ib_shutdown();
+
+    return 0;
+}
@@ -56,6 +56,24 @@ class TestRegression < CLIPPTest::TestCase
     assert_log_no_match /clipp_announce:failed/
   end
 
+  def test_chained_rule_fires
+    clipp(
+      modules: ['pcre'],
+      default_site_config: <<-EOS
+        Rule REQUEST_METHOD @streq GET id:1 phase:REQUEST_HEADER chain
+        Rule REQUEST_LINE @rx HTTP chain
+        Rule REQUEST_METHOD @streq GET clipp_announce:chain_fired
+      EOS
+    ) do
+      transaction do |t|
+        t.request(raw: "GET / HTTP/1.1\r\nHost: foo\r\n\r\n")
+      end
+    end
+
+    assert_no_issues
+    assert_log_match /CLIPP ANNOUNCE: chain_fired/
+  end
+
   def test_negative_content_length
     request = <<-EOS
       GET / HTTP/1.1
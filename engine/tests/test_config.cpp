@@ -27,6 +27,10 @@
 #include "base_fixture.h"
 #include "mock_module.h"
 
+#include <dirent.h>
+#include <unistd.h>
+
+#include <fstream>
 #include <string>
 #include <utility>
 
@@ -584,3 +588,246 @@ TEST(TestTfnParsing, 2emptyarg) {
     ASSERT_EQ(2U, ib_list_elements(tfns));
     ib_mpool_lite_destroy(mpool_lite);
 }
+
+/////////////////////////////// Parse Cache ///////////////////////////////
+
+namespace {
+
+/* Recursively compare two parse trees. */
+void assert_trees_equal(
+    const ib_cfgparser_node_t *expected,
+    const ib_cfgparser_node_t *actual
+)
+{
+    const ib_list_node_t *expected_node;
+    const ib_list_node_t *actual_node;
+
+    ASSERT_EQ(expected->type, actual->type);
+    if (expected->directive == NULL) {
+        ASSERT_TRUE(actual->directive == NULL);
+    }
+    else {
+        ASSERT_STREQ(expected->directive, actual->directive);
+    }
+    ASSERT_EQ(expected->line, actual->line);
+
+    ASSERT_EQ(
+        ib_list_elements(expected->params),
+        ib_list_elements(actual->params));
+    actual_node = ib_list_first_const(actual->params);
+    IB_LIST_LOOP_CONST(expected->params, expected_node) {
+        ASSERT_STREQ(
+            (const char *)ib_list_node_data_const(expected_node),
+            (const char *)ib_list_node_data_const(actual_node));
+        actual_node = ib_list_node_next_const(actual_node);
+    }
+
+    ASSERT_EQ(
+        ib_list_elements(expected->children),
+        ib_list_elements(actual->children));
+    actual_node = ib_list_first_const(actual->children);
+    IB_LIST_LOOP_CONST(expected->children, expected_node) {
+        assert_trees_equal(
+            (const ib_cfgparser_node_t *)
+                ib_list_node_data_const(expected_node),
+            (const ib_cfgparser_node_t *)
+                ib_list_node_data_const(actual_node));
+        actual_node = ib_list_node_next_const(actual_node);
+    }
+}
+
+}
+
+class ParseCacheTest : public TestConfig { };
+
+TEST_F(ParseCacheTest, RoundTrip) {
+    const char *cache_file = "ParseCacheTest.RoundTrip.cache";
+    ib_cfgparser_t *loaded;
+
+    ASSERT_EQ(
+        IB_OK,
+        config(
+            "LogLevel 9\n"
+            "<Site default>\n"
+            "   Hostname *\n"
+            "   SiteId AAAABBBB-1111-2222-3333-000000000000\n"
+            "</Site>\n",
+            1));
+
+    unlink(cache_file);
+    ASSERT_EQ(IB_OK, ib_cfgparser_cache_save(GetParser(), cache_file));
+
+    ASSERT_EQ(IB_OK, ib_cfgparser_create(&loaded, ib_engine));
+    ASSERT_EQ(IB_OK, ib_cfgparser_cache_load(loaded, cache_file));
+
+    assert_trees_equal(GetParseTree(), loaded->root);
+
+    ASSERT_EQ(IB_OK, ib_cfgparser_destroy(loaded));
+    unlink(cache_file);
+}
+
+namespace {
+
+//! Write @a content to the file at @a path.
+void write_file(const char *path, const char *content)
+{
+    std::ofstream out(path);
+    out << content;
+    ASSERT_TRUE(out.good());
+}
+
+//! Count entries of @a dir ending in ".inc", removing them if @a remove.
+size_t scan_include_cache(const char *dir, bool remove)
+{
+    DIR    *dh = opendir(dir);
+    size_t  count = 0;
+
+    if (dh == NULL) {
+        return 0;
+    }
+    for (struct dirent *entry = readdir(dh); entry != NULL; entry = readdir(dh)) {
+        const char *dot = strrchr(entry->d_name, '.');
+
+        if (dot != NULL && strcmp(dot, ".inc") == 0) {
+            ++count;
+            if (remove) {
+                std::string path = std::string(dir) + "/" + entry->d_name;
+                unlink(path.c_str());
+            }
+        }
+    }
+    closedir(dh);
+
+    return count;
+}
+
+}
+
+TEST_F(ParseCacheTest, IncludeCache) {
+    const char *cache_dir = "ParseCacheTest.IncludeCache.d";
+    const char *main_file = "ParseCacheTest.IncludeCache.conf";
+    const char *inc_file  = "ParseCacheTest.IncludeCache.inc.conf";
+    ib_cfgparser_t *other;
+
+    write_file(
+        main_file,
+        "LogLevel 9\n"
+        "Include ParseCacheTest.IncludeCache.inc.conf\n");
+    write_file(
+        inc_file,
+        "<Site default>\n"
+        "   Hostname *\n"
+        "   SiteId AAAABBBB-1111-2222-3333-000000000000\n"
+        "</Site>\n");
+    scan_include_cache(cache_dir, true);
+
+    ASSERT_EQ(IB_OK, ib_cfgparser_include_cache_set(GetParser(), cache_dir));
+    ASSERT_EQ(IB_OK, configFile(main_file));
+
+    /* The include's subtree was imaged. */
+    ASSERT_EQ(1UL, scan_include_cache(cache_dir, false));
+
+    /* A second parse serves the include from the cache and builds the
+     * same tree. */
+    ASSERT_EQ(IB_OK, ib_cfgparser_create(&other, ib_engine));
+    ASSERT_EQ(IB_OK, ib_cfgparser_include_cache_set(other, cache_dir));
+    ASSERT_EQ(IB_OK, ib_cfgparser_parse(other, main_file));
+
+    assert_trees_equal(GetParseTree(), other->root);
+
+    ASSERT_EQ(IB_OK, ib_cfgparser_destroy(other));
+    scan_include_cache(cache_dir, true);
+    rmdir(cache_dir);
+    unlink(main_file);
+    unlink(inc_file);
+}
+
+TEST_F(ParseCacheTest, MissingImage) {
+    ib_cfgparser_t *loaded;
+
+    ASSERT_EQ(IB_OK, ib_cfgparser_create(&loaded, ib_engine));
+    ASSERT_EQ(
+        IB_ENOENT,
+        ib_cfgparser_cache_load(loaded, "ParseCacheTest.none.cache"));
+    ASSERT_EQ(IB_OK, ib_cfgparser_destroy(loaded));
+}
+
+/////////////////////////////// Directive Batching //////////////////////////
+
+namespace {
+
+struct batch_counts_t {
+    size_t scalar_calls;       /**< Per-directive handler invocations. */
+    size_t batch_calls;        /**< Batch handler invocations. */
+    size_t batched_directives; /**< Directives seen by the batch handler. */
+};
+
+batch_counts_t batch_counts;
+
+ib_status_t batch_scalar_handler(
+    ib_cfgparser_t *cp,
+    const char     *name,
+    const char     *p1,
+    const char     *p2,
+    void           *cbdata
+)
+{
+    ++batch_counts.scalar_calls;
+    return IB_OK;
+}
+
+ib_status_t batch_batch_handler(
+    ib_cfgparser_t          *cp,
+    const char              *name,
+    const ib_list_t *const  *arg_lists,
+    size_t                   count,
+    void                    *cbdata
+)
+{
+    ++batch_counts.batch_calls;
+    batch_counts.batched_directives += count;
+    for (size_t i = 0; i < count; ++i) {
+        if (ib_list_elements(arg_lists[i]) != 2) {
+            return IB_EINVAL;
+        }
+    }
+    return IB_OK;
+}
+
+IB_DIRMAP_INIT_STRUCTURE(batch_test_dirmap) = {
+    IB_DIRMAP_INIT_PARAM2_BATCH(
+        "BatchVar",
+        batch_scalar_handler,
+        NULL,
+        batch_batch_handler,
+        NULL
+    ),
+    IB_DIRMAP_INIT_LAST
+};
+
+}
+
+class DirectiveBatchTest : public TestConfig { };
+
+/* Consecutive runs go to the batch handler; singletons take the
+ * per-directive path. */
+TEST_F(DirectiveBatchTest, ConsecutiveRunsBatched) {
+    batch_counts = batch_counts_t();
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_config_register_directives(ib_engine, batch_test_dirmap));
+    ASSERT_EQ(
+        IB_OK,
+        config(
+            "BatchVar a 1\n"
+            "BatchVar b 2\n"
+            "BatchVar c 3\n"
+            "LogLevel INFO\n"
+            "BatchVar d 4\n",
+            1));
+
+    EXPECT_EQ(1UL, batch_counts.batch_calls);
+    EXPECT_EQ(3UL, batch_counts.batched_directives);
+    EXPECT_EQ(1UL, batch_counts.scalar_calls);
+}
@@ -105,6 +105,93 @@ TEST_P(TransformationParaterizedTest, EmptyStringIsValid) {
     ASSERT_EQ(fin, fout);
 }
 
+TEST_F(TransformationTest, FusedExecutionMatchesStepwise) {
+    const char *tfn_names[] = { "trim", "lowercase", "compressWhitespace" };
+    const size_t num_tfns = sizeof(tfn_names) / sizeof(*tfn_names);
+
+    ib_list_t          *tfn_insts;
+    ib_field_t         *fin;
+    ib_bytestr_t       *bs;
+    const ib_field_t   *fused;
+    const ib_field_t   *stepwise;
+    const ib_bytestr_t *fused_bs;
+    const ib_bytestr_t *stepwise_bs;
+
+    /* Create in field. */
+    ASSERT_EQ(
+        IB_OK,
+        ib_bytestr_alias_nulstr(&bs, MainMM(), "  Hello   WORLD  ")
+    );
+    ASSERT_EQ(
+        IB_OK,
+        ib_field_create(
+            &fin,
+            MainMM(),
+            IB_S2SL("fusable"),
+            IB_FTYPE_BYTESTR,
+            ib_ftype_bytestr_in(bs)
+        )
+    );
+
+    /* Build the transformation instance list. */
+    ASSERT_EQ(IB_OK, ib_list_create(&tfn_insts, MainMM()));
+    for (size_t i = 0; i < num_tfns; ++i) {
+        const ib_transformation_t *tfn;
+        ib_transformation_inst_t  *tfn_inst;
+
+        ASSERT_EQ(
+            IB_OK,
+            ib_transformation_lookup(ib_engine, IB_S2SL(tfn_names[i]), &tfn)
+        );
+        ASSERT_TRUE(ib_transformation_fusible(tfn));
+        ASSERT_EQ(
+            IB_OK,
+            ib_transformation_inst_create(&tfn_inst, MainMM(), tfn, NULL)
+        );
+        ASSERT_EQ(IB_OK, ib_list_push(tfn_insts, tfn_inst));
+    }
+
+    /* Apply one at a time. */
+    stepwise = fin;
+    const ib_list_node_t *node;
+    IB_LIST_LOOP_CONST(tfn_insts, node) {
+        const ib_transformation_inst_t *tfn_inst =
+            (const ib_transformation_inst_t *)ib_list_node_data_const(node);
+        ASSERT_EQ(
+            IB_OK,
+            ib_transformation_inst_execute(
+                tfn_inst, MainMM(), stepwise, &stepwise
+            )
+        );
+    }
+
+    /* Apply as one fused pass. */
+    ASSERT_EQ(
+        IB_OK,
+        ib_transformation_inst_execute_fused(
+            ib_list_first_const(tfn_insts), num_tfns, MainMM(), fin, &fused
+        )
+    );
+
+    ASSERT_EQ(IB_OK, ib_field_value(fused, ib_ftype_bytestr_out(&fused_bs)));
+    ASSERT_EQ(
+        IB_OK,
+        ib_field_value(stepwise, ib_ftype_bytestr_out(&stepwise_bs))
+    );
+
+    std::string fused_str(
+        reinterpret_cast<const char *>(ib_bytestr_const_ptr(fused_bs)),
+        ib_bytestr_length(fused_bs)
+    );
+    std::string stepwise_str(
+        reinterpret_cast<const char *>(ib_bytestr_const_ptr(stepwise_bs)),
+        ib_bytestr_length(stepwise_bs)
+    );
+
+    EXPECT_EQ("hello world", fused_str);
+    EXPECT_EQ(stepwise_str, fused_str);
+}
+
 INSTANTIATE_TEST_CASE_P(
     TransformationsWithEmptyString,
     TransformationParaterizedTest,
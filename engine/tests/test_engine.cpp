@@ -312,3 +312,75 @@ TEST_F(TestIronBee, test_module_data)
     ASSERT_EQ(IB_OK, ib_tx_set_module_data(tx, module, NULL));
     ASSERT_EQ(IB_ENOENT, ib_tx_get_module_data(tx, module, &data));
 }
+
+TEST_F(TestIronBee, test_engine_tune)
+{
+    ib_num_t value;
+
+    /* Nothing overridden by default. */
+    ASSERT_EQ(IB_OK, ib_engine_tune_get(ib_engine, "rule_dlog_level", &value));
+    ASSERT_EQ(-1, value);
+
+    ASSERT_EQ(IB_OK, ib_engine_tune_set(ib_engine, "rule_dlog_level", 3));
+    ASSERT_EQ(IB_OK, ib_engine_tune_get(ib_engine, "rule_dlog_level", &value));
+    ASSERT_EQ(3, value);
+
+    /* A negative value clears the override. */
+    ASSERT_EQ(IB_OK, ib_engine_tune_set(ib_engine, "rule_dlog_level", -5));
+    ASSERT_EQ(IB_OK, ib_engine_tune_get(ib_engine, "rule_dlog_level", &value));
+    ASSERT_EQ(-1, value);
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_engine_tune_set(ib_engine, "request_body_log_limit", 4096));
+    ASSERT_EQ(
+        IB_OK,
+        ib_engine_tune_get(ib_engine, "request_body_log_limit", &value));
+    ASSERT_EQ(4096, value);
+
+    ASSERT_EQ(IB_ENOENT, ib_engine_tune_set(ib_engine, "no_such_setting", 1));
+    ASSERT_EQ(IB_ENOENT, ib_engine_tune_get(ib_engine, "no_such_setting", &value));
+}
+
+namespace {
+
+struct prewarm_record_t {
+    int    calls;
+    size_t concurrency;
+};
+
+extern "C" ib_status_t record_prewarm(
+    ib_engine_t *ib,
+    size_t       concurrency,
+    void        *cbdata
+)
+{
+    prewarm_record_t *record = reinterpret_cast<prewarm_record_t *>(cbdata);
+
+    ++record->calls;
+    record->concurrency = concurrency;
+
+    return IB_OK;
+}
+
+}
+
+TEST_F(TestIronBee, test_engine_prewarm)
+{
+    prewarm_record_t record = { 0, 0 };
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_engine_prewarm_register(ib_engine, record_prewarm, &record));
+
+    configureIronBeeByString(getBasicIronBeeConfig());
+
+    ASSERT_EQ(IB_OK, ib_engine_prewarm(ib_engine, 8));
+    ASSERT_EQ(1, record.calls);
+    ASSERT_EQ(8UL, record.concurrency);
+
+    /* Registration is rejected once configuration has finished. */
+    ASSERT_EQ(
+        IB_EINVAL,
+        ib_engine_prewarm_register(ib_engine, record_prewarm, &record));
+}
@@ -28,6 +28,10 @@
 #include <fstream>
 
 #include <ironbee/engine_manager.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+
+#include <unistd.h>
 
 /**
  * Base class for engine manager tests.
@@ -135,6 +139,50 @@ class EngineManager : public EngineManagerFixture
 {
 };
 
+TEST_F(EngineManager, BackgroundBuild)
+{
+    ib_engine_t     *engine;
+    ib_mpool_lite_t *mp;
+    const char      *message;
+    ib_status_t      rc;
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_manager_engine_create_background(
+            m_manager,
+            IB_MANAGER_ENGINE_NAME_DEFAULT,
+            createIronBeeConfig().c_str()
+        )
+    );
+
+    /* Wait for the detached builder thread to flip the engine in.
+     * The engine is only acquirable after the build has finished. */
+    rc = IB_DECLINED;
+    for (int i = 0; i < 1000 && rc != IB_OK; ++i) {
+        usleep(10000);
+        rc = ib_manager_engine_acquire(
+            m_manager,
+            IB_MANAGER_ENGINE_NAME_DEFAULT,
+            &engine);
+    }
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(IB_OK, ib_manager_engine_release(m_manager, engine));
+
+    /* The finished build reports its result. */
+    ASSERT_EQ(IB_OK, ib_mpool_lite_create(&mp));
+    ASSERT_EQ(
+        IB_OK,
+        ib_manager_engine_build_status(
+            m_manager,
+            ib_mm_mpool_lite(mp),
+            &message)
+    );
+    EXPECT_TRUE(strstr(message, "last build") != NULL);
+    ib_mpool_lite_destroy(mp);
+
+    ib_manager_destroy(m_manager);
+}
+
 TEST_F(EngineManager, MaxEngines)
 {
     std::vector<ib_engine_t *> engines(IB_MANAGER_DEFAULT_MAX_ENGINES);
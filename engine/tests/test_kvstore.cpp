@@ -26,17 +26,23 @@ extern "C" {
 #include "util/kvstore_private.h"
 #include <ironbee/kvstore.h>
 #include <ironbee/kvstore_filesystem.h>
+#include <ironbee/kvstore_journal.h>
+#include <ironbee/kvstore_replica.h>
+#include <ironbee/kvstore_shm.h>
 #include <ironbee/mm.h>
 #include <ironbee/util.h>
 #include <ironbee/uuid.h>
 #include <ironbee/mm_mpool.h>
 
 #include <errno.h>
+#include <unistd.h>
 
 }
 
 #include "gtest/gtest.h"
 
+#include <string>
+
 
 class TestKVStore : public testing::Test
 {
@@ -170,3 +176,462 @@ TEST_F(TestKVStore, test_removes) {
 
     ASSERT_FALSE(result);
 }
+
+class TestKVStoreShm : public testing::Test
+{
+    public:
+
+    ib_kvstore_t kvstore;
+    ib_mpool_t *mp;
+    ib_mm_t mm;
+
+    virtual void SetUp() {
+        unlink("TestKVStoreShm.map");
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_shm_init(&kvstore, "TestKVStoreShm.map", 64, 128));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+        ib_mpool_create(&mp, "TestKVStoreShm", NULL);
+        mm = ib_mm_mpool(mp);
+    }
+
+    virtual void TearDown() {
+        ib_kvstore_destroy(&kvstore);
+        ib_mpool_destroy(mp);
+        unlink("TestKVStoreShm.map");
+    }
+
+    ib_kvstore_key_t *MakeKey(const char *key) {
+        ib_kvstore_key_t *k;
+
+        if (
+            ib_kvstore_key_create(
+                &k,
+                mm,
+                reinterpret_cast<const uint8_t *>(key),
+                strlen(key)) != IB_OK)
+        {
+            return NULL;
+        }
+
+        return k;
+    }
+
+    ib_kvstore_value_t *MakeValue(const char *data, ib_time_t expiration) {
+        ib_kvstore_value_t *val;
+
+        if (ib_kvstore_value_create(&val, mm) != IB_OK) {
+            return NULL;
+        }
+        ib_kvstore_value_value_set(
+            val,
+            reinterpret_cast<const uint8_t *>(data),
+            strlen(data));
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, expiration);
+
+        return val;
+    }
+};
+
+TEST_F(TestKVStoreShm, test_init) {
+    /* Nop */
+}
+
+TEST_F(TestKVStoreShm, test_writes_and_reads) {
+    ib_kvstore_key_t   *key = MakeKey("k1");
+    ib_kvstore_value_t *result;
+    const char    *type;
+    size_t         type_length;
+    const uint8_t *data;
+    size_t         data_length;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value", 0)));
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("Another value", 0)));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+    ASSERT_TRUE(result);
+
+    ib_kvstore_value_type_get(result, &type, &type_length);
+    ib_kvstore_value_value_get(result, &data, &data_length);
+
+    /* The last write replaces the record. */
+    ASSERT_EQ((size_t)3, type_length);
+    ASSERT_EQ((size_t)13, data_length);
+    ASSERT_EQ(0, memcmp("Another value", data, data_length));
+}
+
+TEST_F(TestKVStoreShm, test_removes) {
+    ib_kvstore_key_t   *key = MakeKey("k2");
+    ib_kvstore_value_t *result;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value", 0)));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key));
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+
+    ASSERT_FALSE(result);
+}
+
+TEST_F(TestKVStoreShm, test_expiration) {
+    ib_kvstore_key_t   *key = MakeKey("k3");
+    ib_kvstore_value_t *result;
+
+    ASSERT_TRUE(key);
+
+    /* A 1 usec expiration is in the past by the time of the get. */
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value", 1)));
+    usleep(1000);
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+
+    ASSERT_FALSE(result);
+}
+
+TEST_F(TestKVStoreShm, test_persists_across_reconnect) {
+    ib_kvstore_key_t   *key = MakeKey("k4");
+    ib_kvstore_value_t *result;
+    const uint8_t *data;
+    size_t         data_length;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value", 0)));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_disconnect(&kvstore));
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+    ASSERT_TRUE(result);
+
+    ib_kvstore_value_value_get(result, &data, &data_length);
+    ASSERT_EQ((size_t)7, data_length);
+    ASSERT_EQ(0, memcmp("A value", data, data_length));
+}
+
+TEST_F(TestKVStoreShm, test_mget_mset_fallback) {
+    /* The shm store has no batch methods; this exercises the
+     * per-key fallback paths of ib_kvstore_mset()/ib_kvstore_mget(). */
+    const ib_kvstore_key_t *keys[3] = {
+        MakeKey("m1"), MakeKey("m2"), MakeKey("m3")
+    };
+    ib_kvstore_value_t *set_vals[2] = {
+        MakeValue("value one", 0), MakeValue("value two", 0)
+    };
+    ib_kvstore_value_t *got_vals[3];
+    const uint8_t      *data;
+    size_t              length;
+
+    ASSERT_EQ(IB_OK, ib_kvstore_mset(&kvstore, NULL, keys, set_vals, 2));
+
+    /* m3 was never set; mget reports it as NULL, not an error. */
+    ASSERT_EQ(IB_OK, ib_kvstore_mget(&kvstore, NULL, mm, keys, 3, got_vals));
+
+    ASSERT_TRUE(got_vals[0] != NULL);
+    ib_kvstore_value_value_get(got_vals[0], &data, &length);
+    ASSERT_EQ(
+        std::string("value one"),
+        std::string(reinterpret_cast<const char *>(data), length));
+
+    ASSERT_TRUE(got_vals[1] != NULL);
+    ib_kvstore_value_value_get(got_vals[1], &data, &length);
+    ASSERT_EQ(
+        std::string("value two"),
+        std::string(reinterpret_cast<const char *>(data), length));
+
+    ASSERT_TRUE(got_vals[2] == NULL);
+}
+
+TEST_F(TestKVStoreShm, test_oversize_values_rejected) {
+    ib_kvstore_key_t *key = MakeKey("k5");
+    std::string       big(129, 'x');
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_EINVAL,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue(big.c_str(), 0)));
+}
+
+class TestKVStoreJournal : public testing::Test
+{
+    public:
+
+    ib_kvstore_t kvstore;
+    ib_kvstore_t backing;
+    ib_mpool_t *mp;
+    ib_mm_t mm;
+
+    virtual void SetUp() {
+        system("rm -rf TestKVStoreJournal.d");
+        unlink("TestKVStoreJournal.map");
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_shm_init(&backing, "TestKVStoreJournal.map", 64, 128));
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_journal_init(
+                &kvstore,
+                &backing,
+                "TestKVStoreJournal.d",
+                0));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+        ib_mpool_create(&mp, "TestKVStoreJournal", NULL);
+        mm = ib_mm_mpool(mp);
+    }
+
+    virtual void TearDown() {
+        /* Destroying the journal destroys the backing store it owns. */
+        ib_kvstore_destroy(&kvstore);
+        ib_mpool_destroy(mp);
+        system("rm -rf TestKVStoreJournal.d");
+        unlink("TestKVStoreJournal.map");
+    }
+
+    ib_kvstore_key_t *MakeKey(const char *key) {
+        ib_kvstore_key_t *k;
+
+        if (
+            ib_kvstore_key_create(
+                &k,
+                mm,
+                reinterpret_cast<const uint8_t *>(key),
+                strlen(key)) != IB_OK)
+        {
+            return NULL;
+        }
+
+        return k;
+    }
+
+    ib_kvstore_value_t *MakeValue(const char *data) {
+        ib_kvstore_value_t *val;
+
+        if (ib_kvstore_value_create(&val, mm) != IB_OK) {
+            return NULL;
+        }
+        ib_kvstore_value_value_set(
+            val,
+            reinterpret_cast<const uint8_t *>(data),
+            strlen(data));
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, 0);
+
+        return val;
+    }
+};
+
+TEST_F(TestKVStoreJournal, test_init) {
+    /* Nop */
+}
+
+TEST_F(TestKVStoreJournal, test_writes_and_reads_forwarded) {
+    ib_kvstore_key_t   *key = MakeKey("j1");
+    ib_kvstore_value_t *result;
+    const uint8_t *data;
+    size_t         data_length;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value")));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+    ASSERT_TRUE(result);
+
+    ib_kvstore_value_value_get(result, &data, &data_length);
+    ASSERT_EQ((size_t)7, data_length);
+    ASSERT_EQ(0, memcmp("A value", data, data_length));
+}
+
+TEST_F(TestKVStoreJournal, test_removes_forwarded) {
+    ib_kvstore_key_t   *key = MakeKey("j2");
+    ib_kvstore_value_t *result;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value")));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key));
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+
+    ASSERT_FALSE(result);
+}
+
+TEST_F(TestKVStoreJournal, test_replay_recovers_lost_backing) {
+    ib_kvstore_key_t   *key = MakeKey("j3");
+    ib_kvstore_value_t *result;
+    const uint8_t *data;
+    size_t         data_length;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(
+        IB_OK,
+        ib_kvstore_set(&kvstore, NULL, key, MakeValue("A value")));
+
+    /* Simulate a crash that loses the backing store but not the
+     * journal: the surviving segments are replayed on connect. */
+    ASSERT_EQ(IB_OK, ib_kvstore_disconnect(&kvstore));
+    unlink("TestKVStoreJournal.map");
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+    ASSERT_TRUE(result);
+
+    ib_kvstore_value_value_get(result, &data, &data_length);
+    ASSERT_EQ((size_t)7, data_length);
+    ASSERT_EQ(0, memcmp("A value", data, data_length));
+}
+
+class TestKVStoreReplica : public ::testing::Test
+{
+    public:
+
+    ib_kvstore_t kvstore;
+    ib_kvstore_t local;
+    ib_kvstore_t remote;
+    ib_mpool_t *mp;
+    ib_mm_t mm;
+
+    virtual void SetUp() {
+        unlink("TestKVStoreReplica.local.map");
+        unlink("TestKVStoreReplica.remote.map");
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_shm_init(
+                &local, "TestKVStoreReplica.local.map", 64, 128));
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_shm_init(
+                &remote, "TestKVStoreReplica.remote.map", 64, 128));
+
+        /* A long interval so only the explicit flushes propagate. */
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_replica_init(&kvstore, &local, &remote, 60));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+        ib_mpool_create(&mp, "TestKVStoreReplica", NULL);
+        mm = ib_mm_mpool(mp);
+    }
+
+    virtual void TearDown() {
+        /* Destroying the replica destroys the stores it owns. */
+        ib_kvstore_destroy(&kvstore);
+        ib_mpool_destroy(mp);
+        unlink("TestKVStoreReplica.local.map");
+        unlink("TestKVStoreReplica.remote.map");
+    }
+
+    ib_kvstore_key_t *MakeKey(const char *key) {
+        ib_kvstore_key_t *k;
+
+        if (
+            ib_kvstore_key_create(
+                &k,
+                mm,
+                reinterpret_cast<const uint8_t *>(key),
+                strlen(key)) != IB_OK)
+        {
+            return NULL;
+        }
+
+        return k;
+    }
+
+    ib_kvstore_value_t *MakeValue(const char *data) {
+        ib_kvstore_value_t *val;
+
+        if (ib_kvstore_value_create(&val, mm) != IB_OK) {
+            return NULL;
+        }
+        ib_kvstore_value_value_set(
+            val,
+            reinterpret_cast<const uint8_t *>(data),
+            strlen(data));
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, 0);
+
+        return val;
+    }
+
+    std::string GetString(ib_kvstore_t *store, ib_kvstore_key_t *key) {
+        ib_kvstore_value_t *result;
+        const uint8_t *data;
+        size_t         data_length;
+
+        if (ib_kvstore_get(store, NULL, mm, key, &result) != IB_OK) {
+            return "";
+        }
+        ib_kvstore_value_value_get(result, &data, &data_length);
+        return std::string(
+            reinterpret_cast<const char *>(data), data_length);
+    }
+};
+
+TEST_F(TestKVStoreReplica, test_init) {
+    /* Nop */
+}
+
+TEST_F(TestKVStoreReplica, test_write_behind) {
+    ib_kvstore_key_t   *key = MakeKey("r1");
+    ib_kvstore_value_t *result;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&kvstore, NULL, key, MakeValue("5")));
+
+    /* Reads are served locally; the remote store trails the write. */
+    ASSERT_EQ("5", GetString(&kvstore, key));
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&remote, NULL, mm, key, &result));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_replica_flush(&kvstore));
+    ASSERT_EQ("5", GetString(&remote, key));
+}
+
+TEST_F(TestKVStoreReplica, test_additive_convergence) {
+    ib_kvstore_key_t *key = MakeKey("r2");
+
+    ASSERT_TRUE(key);
+
+    /* Another node already contributed 7 to the shared total. */
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&remote, NULL, key, MakeValue("7")));
+
+    /* This node counts to 5, then propagates. */
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&kvstore, NULL, key, MakeValue("5")));
+    ASSERT_EQ(IB_OK, ib_kvstore_replica_flush(&kvstore));
+
+    /* The remote total is the sum, and it is folded back locally. */
+    ASSERT_EQ("12", GetString(&remote, key));
+    ASSERT_EQ("12", GetString(&kvstore, key));
+}
+
+TEST_F(TestKVStoreReplica, test_remote_miss_seeds_local) {
+    ib_kvstore_key_t *key = MakeKey("r3");
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&remote, NULL, key, MakeValue("9")));
+
+    ASSERT_EQ("9", GetString(&kvstore, key));
+    ASSERT_EQ("9", GetString(&local, key));
+}
+
+TEST_F(TestKVStoreReplica, test_removes_propagate) {
+    ib_kvstore_key_t   *key = MakeKey("r4");
+    ib_kvstore_value_t *result;
+
+    ASSERT_TRUE(key);
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&kvstore, NULL, key, MakeValue("5")));
+    ASSERT_EQ(IB_OK, ib_kvstore_replica_flush(&kvstore));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key));
+    ASSERT_EQ(IB_OK, ib_kvstore_replica_flush(&kvstore));
+
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&kvstore, NULL, mm, key, &result));
+    ASSERT_EQ(IB_ENOENT, ib_kvstore_get(&remote, NULL, mm, key, &result));
+}
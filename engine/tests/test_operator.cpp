@@ -163,6 +163,94 @@ TEST_F(OperatorTest, OperatorCallTest)
 }
 
 
+TEST_F(OperatorTest, InstanceSharingTest)
+{
+    ib_status_t status;
+    ib_operator_t *op;
+    ib_operator_t *op_private;
+    ib_operator_inst_t *opinst1;
+    ib_operator_inst_t *opinst2;
+
+    status = ib_operator_create_and_register(
+        &op,
+        ib_engine,
+        "test_shared_op",
+        IB_OP_CAPABILITY_SHAREABLE,
+        test_create_fn, NULL,
+        NULL, NULL,
+        test_execute_fn, NULL
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    status = ib_operator_create_and_register(
+        &op_private,
+        ib_engine,
+        "test_private_op",
+        IB_OP_CAPABILITY_NONE,
+        test_create_fn, NULL,
+        NULL, NULL,
+        test_execute_fn, NULL
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    /* Equal parameters of a shareable operator intern to one instance. */
+    status = ib_operator_inst_create(
+        &opinst1,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op,
+        IB_OP_CAPABILITY_NONE,
+        "data"
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    status = ib_operator_inst_create(
+        &opinst2,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op,
+        IB_OP_CAPABILITY_NONE,
+        "data"
+    );
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(opinst1, opinst2);
+
+    /* Different parameters do not. */
+    status = ib_operator_inst_create(
+        &opinst2,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op,
+        IB_OP_CAPABILITY_NONE,
+        "other"
+    );
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_NE(opinst1, opinst2);
+
+    /* Non-shareable operators always get fresh instances. */
+    status = ib_operator_inst_create(
+        &opinst1,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op_private,
+        IB_OP_CAPABILITY_NONE,
+        "data"
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    status = ib_operator_inst_create(
+        &opinst2,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op_private,
+        IB_OP_CAPABILITY_NONE,
+        "data"
+    );
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_NE(opinst1, opinst2);
+}
+
+
 class CoreOperatorsTest : public BaseTransactionFixture
 {
     void SetUp()
@@ -218,6 +306,102 @@ TEST_F(CoreOperatorsTest, ContainsTest)
     EXPECT_EQ(0, call_result);
 }
 
+TEST_F(CoreOperatorsTest, MatchTest)
+{
+    ib_status_t status;
+    ib_num_t call_result;
+    const ib_operator_t *op;
+    ib_operator_inst_t *opinst;
+
+    status = ib_operator_lookup(ib_engine, IB_S2SL("match"), &op);
+
+    ASSERT_EQ(IB_OK, status);
+
+    status = ib_operator_inst_create(
+        &opinst,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op,
+        IB_OP_CAPABILITY_NONE,
+        "GET POST HEAD"
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    // call match
+    ib_field_t *field;
+    const char *matching = "POST";
+    const char *nonmatching = "PUT";
+    const char *wrongcase = "post";
+    ib_field_create(
+        &field,
+        ib_engine_mm_main_get(ib_engine),
+        IB_S2SL("testfield"),
+        IB_FTYPE_NULSTR,
+        NULL
+    );
+
+    ib_field_setv(field, ib_ftype_nulstr_in(matching));
+    status = ib_operator_inst_execute(opinst, ib_tx, field, NULL, &call_result);
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(1, call_result);
+
+    ib_field_setv(field, ib_ftype_nulstr_in(nonmatching));
+    status = ib_operator_inst_execute(opinst, ib_tx, field, NULL, &call_result);
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(0, call_result);
+
+    // match is case sensitive.
+    ib_field_setv(field, ib_ftype_nulstr_in(wrongcase));
+    status = ib_operator_inst_execute(opinst, ib_tx, field, NULL, &call_result);
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(0, call_result);
+}
+
+TEST_F(CoreOperatorsTest, IMatchTest)
+{
+    ib_status_t status;
+    ib_num_t call_result;
+    const ib_operator_t *op;
+    ib_operator_inst_t *opinst;
+
+    status = ib_operator_lookup(ib_engine, IB_S2SL("imatch"), &op);
+
+    ASSERT_EQ(IB_OK, status);
+
+    status = ib_operator_inst_create(
+        &opinst,
+        ib_engine_mm_main_get(ib_engine),
+        ib_context_main(ib_engine),
+        op,
+        IB_OP_CAPABILITY_NONE,
+        "GET POST HEAD"
+    );
+    ASSERT_EQ(IB_OK, status);
+
+    // call imatch
+    ib_field_t *field;
+    const char *matching = "post";
+    const char *nonmatching = "put";
+    ib_field_create(
+        &field,
+        ib_engine_mm_main_get(ib_engine),
+        IB_S2SL("testfield"),
+        IB_FTYPE_NULSTR,
+        NULL
+    );
+
+    // imatch is case insensitive.
+    ib_field_setv(field, ib_ftype_nulstr_in(matching));
+    status = ib_operator_inst_execute(opinst, ib_tx, field, NULL, &call_result);
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(1, call_result);
+
+    ib_field_setv(field, ib_ftype_nulstr_in(nonmatching));
+    status = ib_operator_inst_execute(opinst, ib_tx, field, NULL, &call_result);
+    ASSERT_EQ(IB_OK, status);
+    EXPECT_EQ(0, call_result);
+}
+
 TEST_F(CoreOperatorsTest, EqTest)
 {
     ib_status_t status;
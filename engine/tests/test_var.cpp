@@ -109,6 +109,66 @@ TEST(TestVar, Store)
     ASSERT_TRUE(store);
 }
 
+TEST(TestVar, StoreSnapshotRestore)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    ib_var_config_t* config = make_config(mm);
+    ASSERT_TRUE(config);
+
+    ib_var_source_t* a = make_source(config, "a");
+    ib_var_source_t* b = make_source(config, "b");
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+
+    ib_var_store_t* store = make_store(config);
+
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+    data_list.push_back(Field::create_number(smp, "fooA", 4, 5));
+
+    Field fa = Field::create_no_copy_list<Field>(smp, "a", 1, data_list);
+    rc = ib_var_source_set(a, store, fa.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_store_snapshot_t* snapshot = NULL;
+    rc = ib_var_store_snapshot_take(store, &snapshot, mm);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(snapshot);
+
+    /* Mutate: rebind b, append to a's list. */
+    Field fb = Field::create_number(smp, "b", 1, 2);
+    rc = ib_var_source_set(b, store, fb.ib());
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_append(
+        a, store, Field::create_number(smp, "fooB", 4, 6).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(2UL, data_list.size());
+
+    rc = ib_var_store_restore(store, snapshot);
+    ASSERT_EQ(IB_OK, rc);
+
+    /* a is bound to the same field, truncated to one element. */
+    ib_field_t* f = NULL;
+    rc = ib_var_source_get(a, &f, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(fa.ib(), f);
+    EXPECT_EQ(1UL, data_list.size());
+
+    /* b is unset again. */
+    rc = ib_var_source_get(b, NULL, store);
+    EXPECT_EQ(IB_ENOENT, rc);
+
+    /* Restoring a snapshot from another store fails. */
+    ib_var_store_t* other_store = make_store(config);
+    rc = ib_var_store_restore(other_store, snapshot);
+    EXPECT_EQ(IB_EINVAL, rc);
+}
+
 TEST(TestVar, SourceBasic)
 {
     ScopedMemoryPool smp;
@@ -222,6 +282,214 @@ TEST(TestVar, SourceSetGet)
     ASSERT_EQ(b, source);
 }
 
+TEST(TestVar, SourceSetMany)
+{
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    ib_var_config_t* config = make_config(mm);
+    ASSERT_TRUE(config);
+
+    ib_var_source_t* a = make_source(config, "a");
+    ib_var_source_t* b = make_source(config, "b");
+
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+
+    ib_var_store_t* store = make_store(config);
+
+    ib_field_t fa;
+    fa.name = "a";
+    fa.nlen = 1;
+    ib_field_t fb;
+    fb.name = "b";
+    fb.nlen = 1;
+
+    ib_var_source_set_pair_t pairs[2];
+    pairs[0].source = a;
+    pairs[0].field = &fa;
+    pairs[1].source = b;
+    pairs[1].field = &fb;
+
+    rc = ib_var_source_set_many(store, pairs, 2);
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_field_t* f2;
+    rc = ib_var_source_get(a, &f2, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(&fa, f2);
+    rc = ib_var_source_get(b, &f2, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(&fb, f2);
+
+    uint32_t generation = 0;
+    rc = ib_var_source_generation(a, store, &generation);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1UL, generation);
+
+    /* A pair from another config fails validation and nothing is written. */
+    ib_var_config_t* other_config = make_config(mm);
+    ASSERT_TRUE(other_config);
+    ib_var_source_t* c = make_source(other_config, "c");
+    ASSERT_TRUE(c);
+
+    pairs[0].field = NULL;
+    pairs[1].source = c;
+    rc = ib_var_source_set_many(store, pairs, 2);
+    ASSERT_EQ(IB_EINVAL, rc);
+    rc = ib_var_source_get(a, &f2, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(&fa, f2);
+}
+
+TEST(TestVar, SourceGeneration)
+{
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    ib_var_config_t* config = make_config(mm);
+    ASSERT_TRUE(config);
+
+    ib_var_source_t* a = make_source(config, "a");
+    ib_var_source_t* b = make_source(config, "b");
+
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+
+    ib_var_store_t* store = make_store(config);
+
+    uint32_t generation = 17;
+    rc = ib_var_source_generation(a, store, &generation);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(0UL, generation);
+
+    ib_field_t fa;
+    fa.name = "a";
+    fa.nlen = 1;
+
+    rc = ib_var_source_set(a, store, &fa);
+    ASSERT_EQ(IB_OK, rc);
+
+    rc = ib_var_source_generation(a, store, &generation);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1UL, generation);
+    rc = ib_var_source_generation(b, store, &generation);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(0UL, generation);
+
+    rc = ib_var_source_set(a, store, &fa);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_generation(a, store, &generation);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(2UL, generation);
+
+    ib_var_source_t* unindexed;
+    rc = ib_var_source_acquire(&unindexed, mm, config, "c", 1);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_generation(unindexed, store, &generation);
+    ASSERT_EQ(IB_EINVAL, rc);
+
+    ib_var_config_t* other_config = make_config(mm);
+    ib_var_source_t* a2 = make_source(other_config, "a");
+    rc = ib_var_source_generation(a2, store, &generation);
+    ASSERT_EQ(IB_EINVAL, rc);
+}
+
+namespace {
+
+extern "C" ib_status_t test_lazy_fn(
+    ib_field_t            **field,
+    const ib_var_source_t  *source,
+    ib_var_store_t         *store,
+    void                   *cbdata
+)
+{
+    int* num_calls = reinterpret_cast<int*>(cbdata);
+    ib_status_t rc;
+    ib_field_t* f;
+    ib_num_t value = 17;
+
+    ++*num_calls;
+
+    rc = ib_field_create(
+        &f,
+        ib_var_store_mm(store),
+        "", 0,
+        IB_FTYPE_NUM,
+        ib_ftype_num_in(&value)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *field = f;
+    return IB_OK;
+}
+
+}
+
+TEST(TestVar, SourceLazy)
+{
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    ib_var_config_t* config = make_config(mm);
+    ASSERT_TRUE(config);
+
+    int num_calls = 0;
+    ib_var_source_t* lazy = NULL;
+    rc = ib_var_source_register_lazy(
+        &lazy,
+        config,
+        "lazy", 4,
+        IB_PHASE_NONE, IB_PHASE_NONE,
+        test_lazy_fn, &num_calls
+    );
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(lazy);
+
+    ib_var_store_t* store = make_store(config);
+
+    /* Materialized on first get, cached on second. */
+    ib_field_t* f = NULL;
+    rc = ib_var_source_get(lazy, &f, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(f);
+    EXPECT_EQ(1, num_calls);
+    EXPECT_EQ("lazy", string(f->name, f->nlen));
+
+    ib_field_t* f2 = NULL;
+    rc = ib_var_source_get(lazy, &f2, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(f, f2);
+    EXPECT_EQ(1, num_calls);
+
+    /* A fresh store materializes again. */
+    ib_var_store_t* store2 = make_store(config);
+    rc = ib_var_source_get(lazy, &f2, store2);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(2, num_calls);
+
+    /* Setting before the first get suppresses materialization... */
+    ib_var_store_t* store3 = make_store(config);
+    ib_field_t fx;
+    fx.name = "lazy";
+    fx.nlen = 4;
+    rc = ib_var_source_set(lazy, store3, &fx);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_get(lazy, &f2, store3);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(&fx, f2);
+    EXPECT_EQ(2, num_calls);
+
+    /* ...and removal does not resurrect the value. */
+    rc = ib_var_source_set(lazy, store3, NULL);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_get(lazy, NULL, store3);
+    ASSERT_EQ(IB_ENOENT, rc);
+    EXPECT_EQ(2, num_calls);
+}
+
 TEST(TestVar, SourceSetAndGetInvalid)
 {
     ScopedMemoryPool smp;
@@ -558,6 +826,157 @@ TEST(TestVar, Target)
     EXPECT_EQ("fooA", result_list.front().name_as_s());
 }
 
+TEST(TestVar, TargetTrivial)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+
+    ib_var_target_t *target;
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data", 4);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_TRUE(ib_var_target_trivial(target));
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:fooa", 9);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_FALSE(ib_var_target_trivial(target));
+
+    rc = ib_var_target_acquire_from_string(
+        &target, mm, config,
+        IB_S2SL("data:%{expand}")
+    );
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_FALSE(ib_var_target_trivial(target));
+}
+
+TEST(TestVar, TargetGetCached)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    data_list.push_back(Field::create_number(smp, "fooA", 4, 5));
+    data_list.push_back(Field::create_number(smp, "fooB", 4, 6));
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target;
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:fooa", 9);
+    ASSERT_EQ(IB_OK, rc);
+
+    const ib_list_t *result1 = NULL;
+    const ib_list_t *result2 = NULL;
+    rc = ib_var_target_get(target, &result1, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(1UL, ib_list_elements(result1));
+
+    /* Unchanged source: cached resolution is reused. */
+    rc = ib_var_target_get(target, &result2, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(result1, result2);
+
+    /* In-place growth of the collection invalidates. */
+    data_list.push_back(Field::create_number(smp, "fooA", 4, 7));
+    rc = ib_var_target_get(target, &result2, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_NE(result1, result2);
+    EXPECT_EQ(2UL, ib_list_elements(result2));
+
+    /* Resetting the source invalidates. */
+    result1 = result2;
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result2, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_NE(result1, result2);
+    EXPECT_EQ(2UL, ib_list_elements(result2));
+}
+
+TEST(TestVar, TargetGetCollectionIndex)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    /* Large enough collection to be indexed, with a duplicated name. */
+    for (int i = 0; i < 10; ++i) {
+        std::string name = std::string("key") + char('0' + i);
+        data_list.push_back(
+            Field::create_number(smp, name.data(), name.size(), i));
+    }
+    data_list.push_back(Field::create_number(smp, "KEY3", 4, 33));
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target;
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:key3", 9);
+    ASSERT_EQ(IB_OK, rc);
+
+    /* Both elements named key3, case-insensitively, in collection order. */
+    const ib_list_t *result = NULL;
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(2UL, ib_list_elements(result));
+    ConstField first(
+        (const ib_field_t *)ib_list_node_data_const(
+            ib_list_first_const(result)));
+    EXPECT_EQ(3, first.value_as_number());
+
+    /* A different filter on the same collection. */
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:key7", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1UL, ib_list_elements(result));
+
+    /* No match. */
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:nope", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+
+    /* In-place growth invalidates the index. */
+    data_list.push_back(Field::create_number(smp, "nope", 4, 99));
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(1UL, ib_list_elements(result));
+}
+
 TEST(TestVar, TargetRemoveTrivial)
 {
     using namespace IronBee;
@@ -979,6 +1398,77 @@ TEST(TestVar, ExpandFilter)
     EXPECT_EQ("fooA", result_list.front().name_as_s());
 }
 
+TEST(TestVar, ExpandSingleTarget)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+
+    ib_var_config_t* config = make_config(mm);
+    ASSERT_TRUE(config);
+
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+    data_list.push_back(Field::create_number(smp, "fooA", 4, 5));
+
+    ib_var_source_t* a = make_source(config, "a");
+    ib_var_source_t* c = make_source(config, "c");
+    ib_var_source_t* d = make_source(config, "d");
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(c);
+    ASSERT_TRUE(d);
+
+    ib_var_store_t* store = make_store(config);
+
+    rc = ib_var_source_set(a, store,
+        Field::create_number(smp, "a", 1, 17).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_set(c, store,
+        Field::create_byte_string(smp, "c", 1,
+            ByteString::create(smp, "foo")
+        ).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_set(d, store,
+        Field::create_no_copy_list<Field>(smp, "d", 1, data_list).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_expand_t *expand = NULL;
+    const char *result = NULL;
+    size_t result_length;
+
+    /* Numeric fast path. */
+    rc = ib_var_expand_acquire(&expand, mm, "%{a}", 4, config);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_expand_execute(expand, &result, &result_length, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ("17", string(result, result_length));
+
+    /* Bytestring fast path. */
+    rc = ib_var_expand_acquire(&expand, mm, "%{c}", 4, config);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_expand_execute(expand, &result, &result_length, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ("foo", string(result, result_length));
+
+    /* Lists take the general path. */
+    rc = ib_var_expand_acquire(&expand, mm, "%{d}", 4, config);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_expand_execute(expand, &result, &result_length, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ("5", string(result, result_length));
+
+    /* Unset source. */
+    rc = ib_var_expand_acquire(&expand, mm, "%{a2}", 5, config);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_expand_execute(expand, &result, &result_length, mm, store);
+    ASSERT_EQ(IB_ENOENT, rc);
+}
+
 TEST(TestVar, Expand)
 {
     using namespace IronBee;
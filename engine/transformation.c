@@ -30,6 +30,7 @@
 #include "engine_private.h"
 
 #include <assert.h>
+#include <string.h>
 
 struct ib_transformation_t {
     /*! Name of the transformation. */
@@ -65,6 +66,21 @@ struct ib_transformation_t {
 
     /*! Execute callback data. */
     void *execute_cbdata;
+
+    /*! Byte-level kernel; NULL if the transformation is not fusible. */
+    ib_transformation_byte_fn_t byte_fn;
+
+    /*! Byte-level kernel callback data. */
+    void *byte_cbdata;
+
+    /*! Stream state creation; NULL if the transformation cannot stream. */
+    ib_transformation_stream_create_fn_t stream_create_fn;
+
+    /*! Streaming function; NULL if the transformation cannot stream. */
+    ib_transformation_stream_fn_t stream_fn;
+
+    /*! Streaming callback data. */
+    void *stream_cbdata;
 };
 
 struct ib_transformation_inst_t
@@ -113,12 +129,50 @@ ib_status_t ib_transformation_create(
     local_tfn->destroy_cbdata = destroy_cbdata;
     local_tfn->execute_fn     = execute_fn;
     local_tfn->execute_cbdata = execute_cbdata;
+    local_tfn->byte_fn        = NULL;
+    local_tfn->byte_cbdata    = NULL;
+    local_tfn->stream_create_fn = NULL;
+    local_tfn->stream_fn        = NULL;
+    local_tfn->stream_cbdata    = NULL;
 
     *tfn = local_tfn;
 
     return IB_OK;
 }
 
+ib_status_t ib_transformation_set_byte_fn(
+    ib_transformation_t         *tfn,
+    ib_transformation_byte_fn_t  byte_fn,
+    void                        *byte_cbdata
+)
+{
+    assert(tfn     != NULL);
+    assert(byte_fn != NULL);
+
+    tfn->byte_fn     = byte_fn;
+    tfn->byte_cbdata = byte_cbdata;
+
+    return IB_OK;
+}
+
+ib_status_t ib_transformation_set_stream_fns(
+    ib_transformation_t                  *tfn,
+    ib_transformation_stream_create_fn_t  stream_create_fn,
+    ib_transformation_stream_fn_t         stream_fn,
+    void                                 *stream_cbdata
+)
+{
+    assert(tfn              != NULL);
+    assert(stream_create_fn != NULL);
+    assert(stream_fn        != NULL);
+
+    tfn->stream_create_fn = stream_create_fn;
+    tfn->stream_fn        = stream_fn;
+    tfn->stream_cbdata    = stream_cbdata;
+
+    return IB_OK;
+}
+
 ib_status_t ib_transformation_register(
     ib_engine_t               *ib,
     const ib_transformation_t *tfn
@@ -129,6 +183,13 @@ ib_status_t ib_transformation_register(
 
     ib_status_t rc;
 
+    /* The registry is read without locking on per-transaction paths;
+     * it is frozen once configuration completes so that lookups never
+     * race a mutation. */
+    if (ib->cfg_state == CFG_FINISHED) {
+        return IB_EINVAL;
+    }
+
     rc = ib_hash_get(ib->tfns, NULL, ib_transformation_name(tfn));
     if (rc != IB_ENOENT) {
         /* Already exists. */
@@ -216,6 +277,24 @@ bool ib_transformation_handle_list(
     return tfn->handle_list;
 }
 
+bool ib_transformation_fusible(
+    const ib_transformation_t *tfn
+)
+{
+    assert(tfn != NULL);
+
+    return tfn->byte_fn != NULL;
+}
+
+bool ib_transformation_streamable(
+    const ib_transformation_t *tfn
+)
+{
+    assert(tfn != NULL);
+
+    return tfn->stream_fn != NULL;
+}
+
 /*! Cleanup function to destroy transformation. */
 static
 void cleanup_tfn(
@@ -414,3 +493,195 @@ ib_status_t ib_transformation_inst_execute(
 
     return IB_OK;
 }
+
+ib_status_t ib_transformation_inst_stream_state_create(
+    const ib_transformation_inst_t  *tfn_inst,
+    ib_mm_t                          mm,
+    void                           **state
+)
+{
+    assert(tfn_inst != NULL);
+    assert(state    != NULL);
+
+    const ib_transformation_t *tfn =
+        ib_transformation_inst_transformation(tfn_inst);
+
+    assert(tfn->stream_create_fn != NULL);
+
+    return tfn->stream_create_fn(
+        state,
+        mm,
+        ib_transformation_inst_data(tfn_inst),
+        tfn->stream_cbdata
+    );
+}
+
+ib_status_t ib_transformation_inst_stream_execute(
+    const ib_transformation_inst_t  *tfn_inst,
+    void                            *state,
+    ib_mm_t                          mm,
+    const uint8_t                   *data_in,
+    size_t                           dlen_in,
+    const uint8_t                  **data_out,
+    size_t                          *dlen_out,
+    bool                             final
+)
+{
+    assert(tfn_inst != NULL);
+    assert(state    != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+
+    const ib_transformation_t *tfn =
+        ib_transformation_inst_transformation(tfn_inst);
+
+    assert(tfn->stream_fn != NULL);
+
+    return tfn->stream_fn(
+        state,
+        mm,
+        data_in,
+        dlen_in,
+        data_out,
+        dlen_out,
+        final,
+        ib_transformation_inst_data(tfn_inst),
+        tfn->stream_cbdata
+    );
+}
+
+ib_status_t ib_transformation_inst_execute_fused(
+    const ib_list_node_t  *tfn_inst_node,
+    size_t                 num_tfn_insts,
+    ib_mm_t                mm,
+    const ib_field_t      *fin,
+    const ib_field_t     **fout
+)
+{
+    assert(tfn_inst_node != NULL);
+    assert(num_tfn_insts > 0);
+    assert(fin  != NULL);
+    assert(fout != NULL);
+
+    ib_status_t rc;
+
+    if (fin->type == IB_FTYPE_LIST) {
+        /* Byte-level transformations never handle lists; unroll once and
+         * run the whole fused run over each element. */
+        const ib_list_t *value_list;
+        const ib_list_node_t *node;
+        ib_list_t *out_list;
+        ib_field_t *fnew;
+
+        rc = ib_field_value(fin, ib_ftype_list_out(&value_list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = ib_list_create(&out_list, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        IB_LIST_LOOP_CONST(value_list, node) {
+            const ib_field_t *in;
+            const ib_field_t *tfn_out;
+
+            in = (const ib_field_t *)ib_list_node_data_const(node);
+            assert(in != NULL);
+
+            rc = ib_transformation_inst_execute_fused(
+                tfn_inst_node, num_tfn_insts, mm, in, &tfn_out
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+
+            rc = ib_list_push(out_list, (void *)tfn_out);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+
+        rc = ib_field_create(&fnew, mm,
+                             fin->name, fin->nlen,
+                             IB_FTYPE_LIST, ib_ftype_list_in(out_list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        *fout = fnew;
+    }
+    else if (fin->type == IB_FTYPE_BYTESTR) {
+        const ib_bytestr_t *bs;
+        const uint8_t      *din;
+        uint8_t            *buf;
+        size_t              dlen;
+        ib_field_t         *fnew;
+
+        rc = ib_field_value(fin, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        if (bs == NULL) {
+            return IB_EINVAL;
+        }
+
+        dlen = ib_bytestr_length(bs);
+        if (dlen == 0) {
+            /* Do nothing. */
+            *fout = fin;
+            return IB_OK;
+        }
+
+        din = ib_bytestr_const_ptr(bs);
+        if (din == NULL) {
+            return IB_EINVAL;
+        }
+
+        /* The single output allocation; every kernel runs in place over
+         * this buffer.  Kernels may only shrink the data. */
+        buf = (uint8_t *)ib_mm_alloc(mm, dlen);
+        if (buf == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(buf, din, dlen);
+
+        for (size_t i = 0; i < num_tfn_insts; ++i) {
+            const ib_transformation_inst_t *tfn_inst;
+            const ib_transformation_t      *tfn;
+
+            assert(tfn_inst_node != NULL);
+            tfn_inst = (const ib_transformation_inst_t *)
+                ib_list_node_data_const(tfn_inst_node);
+            assert(tfn_inst != NULL);
+            tfn = ib_transformation_inst_transformation(tfn_inst);
+            assert(tfn->byte_fn != NULL);
+
+            rc = tfn->byte_fn(
+                buf,
+                dlen,
+                &dlen,
+                ib_transformation_inst_data(tfn_inst),
+                tfn->byte_cbdata
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+
+            tfn_inst_node = ib_list_node_next_const(tfn_inst_node);
+        }
+
+        rc = ib_field_create_bytestr_alias(&fnew, mm,
+                                           fin->name, fin->nlen,
+                                           buf, dlen);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        *fout = fnew;
+    }
+    else {
+        return IB_EINVAL;
+    }
+
+    return IB_OK;
+}
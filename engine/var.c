@@ -26,14 +26,15 @@
 
 #include <ironbee/var.h>
 
-#include <ironbee/array.h>
 #include <ironbee/hash.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/string_assembly.h>
+#include <ironbee/strintern.h>
 
 #include <assert.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /* types */
 
@@ -47,6 +48,15 @@ struct ib_var_config_t
 
     /** Next index to use. */
     size_t next_index;
+
+    /**
+     * Interning table for configuration-known names.
+     *
+     * Registered source names are canonical copies from this table, so any
+     * two of them can be compared by pointer.  Available to other
+     * configuration-time consumers via ib_var_config_interns().
+     **/
+    ib_strintern_t *interns;
 };
 
 struct ib_var_store_t
@@ -57,8 +67,44 @@ struct ib_var_store_t
     ib_mm_t mm;
     /** Hash of source name to value. Value: `ib_field_t *` */
     ib_hash_t *hash;
-    /** Array of source index to value.  Value: `ib_field_t *` */
-    ib_array_t *array;
+
+    /**
+     * Flat array of source index to value.  Value: `ib_field_t *`.
+     *
+     * One slot per source indexed in @ref config at store acquisition.  A
+     * single contiguous allocation so that the hot get path is a bounds
+     * check and a load.  NULL slot means not set.
+     **/
+    ib_field_t **values;
+
+    /**
+     * Per-slot generation counter; parallel to @ref values.
+     *
+     * Incremented every time ib_var_source_set() writes the slot.  A slot
+     * that has never been set has generation 0.
+     **/
+    uint32_t *generations;
+
+    /** Number of slots in @ref values and @ref generations. */
+    size_t num_slots;
+
+    /**
+     * Cache of resolved constant-filter targets.
+     *
+     * Key: the `ib_var_target_t *` itself, as pointer bytes.  Value:
+     * `target_cache_entry_t *`.  Created lazily on the first cacheable
+     * get.  See ib_var_target_get().
+     **/
+    ib_hash_t *target_cache;
+
+    /**
+     * Sorted indexes over large collections, for binary-search filters.
+     *
+     * Key: the `ib_var_source_t *` of the collection, as pointer bytes.
+     * Value: `collection_index_t *`.  Created lazily on the first filtered
+     * get of a large enough collection.  See ib_var_target_get().
+     **/
+    ib_hash_t *collection_index;
 };
 
 struct ib_var_source_t
@@ -99,6 +145,16 @@ struct ib_var_source_t
      * to allow valgrind to catch inappropriate uses of it.
      **/
     size_t index;
+
+    /**
+     * Materialization callback; NULL for ordinary sources.
+     *
+     * See ib_var_source_register_lazy().
+     **/
+    ib_var_source_lazy_fn_t lazy_fn;
+
+    /** Callback data for @ref lazy_fn. */
+    void *lazy_cbdata;
 };
 
 struct ib_var_filter_t
@@ -141,6 +197,96 @@ struct ib_var_target_t
     const ib_var_filter_t *filter;
 };
 
+struct ib_var_store_snapshot_t
+{
+    /** Store this snapshot was taken from. */
+    const ib_var_store_t *store;
+
+    /** Copy of ib_var_store_t::values.  Field values are shared. */
+    ib_field_t **values;
+
+    /** Copy of ib_var_store_t::generations. */
+    uint32_t *generations;
+
+    /**
+     * Element count of each non-dynamic list value in @ref values at
+     * snapshot time; 0 for other slots.  Used by ib_var_store_restore()
+     * to truncate lists that grew since.
+     **/
+    size_t *num_elements;
+
+    /** Number of slots. */
+    size_t num_slots;
+
+    /** Copy of ib_var_store_t::hash entries.  Value: `ib_field_t *`. */
+    ib_hash_t *hash;
+};
+
+/**
+ * Entry in ib_var_store_t::target_cache.
+ *
+ * A cached result is reused only while the source slot's generation, the
+ * source field itself, and the field's element count are all unchanged, so
+ * both sets through the var API and in-place list growth (e.g., headers
+ * arriving) invalidate it.
+ **/
+typedef struct target_cache_entry_t target_cache_entry_t;
+struct target_cache_entry_t
+{
+    /** Target cached.  Also provides the key bytes of the entry. */
+    const ib_var_target_t *target;
+    /** Generation of the source slot when @ref result was computed. */
+    uint32_t generation;
+    /** Source field @ref result was computed from. */
+    const ib_field_t *field;
+    /** Element count of @ref field when @ref result was computed. */
+    size_t num_elements;
+    /** Cached result of ib_var_target_get(). */
+    const ib_list_t *result;
+};
+
+/**
+ * Minimum collection size for which a sorted index is built.
+ *
+ * Below this a linear scan is cheaper than building and searching an
+ * index.
+ **/
+#define COLLECTION_INDEX_MIN_ELEMENTS 8
+
+/** One element of a @ref collection_index_t. */
+typedef struct collection_index_element_t collection_index_element_t;
+struct collection_index_element_t
+{
+    /** The collection element. */
+    const ib_field_t *field;
+    /** Position in the collection; breaks name ties to keep list order. */
+    size_t pos;
+};
+
+/**
+ * Entry in ib_var_store_t::collection_index.
+ *
+ * A sorted view of a collection's elements, by name, letting every
+ * distinct filter on the collection binary-search instead of scanning.
+ * Validity is judged exactly as for @ref target_cache_entry_t: the index
+ * is rebuilt whenever the source slot's generation, the source field
+ * itself, or the field's element count changes.
+ **/
+typedef struct collection_index_t collection_index_t;
+struct collection_index_t
+{
+    /** Source indexed.  Also provides the key bytes of the entry. */
+    const ib_var_source_t *source;
+    /** Generation of the source slot when the index was built. */
+    uint32_t generation;
+    /** Source field the index was built from. */
+    const ib_field_t *field;
+    /** Number of entries in @ref elements. */
+    size_t num_elements;
+    /** Elements sorted by name, case-insensitive, then by position. */
+    collection_index_element_t *elements;
+};
+
 struct ib_var_expand_t
 {
     /** Text before expansion.  May be NULL. */
@@ -224,6 +370,154 @@ ib_status_t target_filter_get(
 )
 NONNULL_ATTRIBUTE(1, 2, 4);
 
+/**
+ * Advance the generation counter of @a source's slot in @a store, if any.
+ *
+ * No-op for unindexed sources and for sources indexed after @a store was
+ * acquired.
+ *
+ * @param[in] store  Store holding the slot.
+ * @param[in] source Source whose slot to advance.
+ **/
+static
+void store_generation_bump(
+    ib_var_store_t        *store,
+    const ib_var_source_t *source
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Record the resolution of @a target in the cache of @a store.
+ *
+ * Creates the cache on first use and reuses the target's entry on
+ * recomputation.  @a result must have lifetime of at least @a store.
+ *
+ * @param[in] store        Store to cache in.
+ * @param[in] target       Target resolved.
+ * @param[in] field        Source field @a result was computed from.
+ * @param[in] num_elements Element count of @a field at computation.
+ * @param[in] result       Resolution to cache.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t target_cache_set(
+    ib_var_store_t        *store,
+    const ib_var_target_t *target,
+    const ib_field_t      *field,
+    size_t                 num_elements,
+    const ib_list_t       *result
+)
+NONNULL_ATTRIBUTE(1, 2, 3, 5);
+
+/**
+ * Compare two names case-insensitively, then by length.
+ *
+ * @param[in] a        First name.
+ * @param[in] a_length Length of @a a.
+ * @param[in] b        Second name.
+ * @param[in] b_length Length of @a b.
+ * @return Less than, equal to, or greater than zero as @a a sorts before,
+ *         equal to, or after @a b.
+ **/
+static
+int collection_name_cmp(
+    const char *a,
+    size_t      a_length,
+    const char *b,
+    size_t      b_length
+)
+NONNULL_ATTRIBUTE(1, 3);
+
+/**
+ * qsort() comparator for @ref collection_index_element_t.
+ *
+ * Orders by name as collection_name_cmp(), then by position so that
+ * elements with equal names keep their collection order.
+ **/
+static
+int collection_index_element_cmp(const void *a, const void *b);
+
+/**
+ * Get a valid sorted index for @a field, building it if needed.
+ *
+ * Looks up the index of @a source in @a store and reuses it while the
+ * slot's generation, @a field, and @a num_elements are unchanged;
+ * otherwise (re)builds it from @a source_list.
+ *
+ * @param[in]  store        Store to hold the index.
+ * @param[in]  source       Source of the collection.  Must be indexed with
+ *                          a slot in @a store.
+ * @param[in]  field        Source field holding the collection.
+ * @param[in]  source_list  Element list of @a field.
+ * @param[in]  num_elements Element count of @a source_list.
+ * @param[out] index        The valid index.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t collection_index_acquire(
+    ib_var_store_t             *store,
+    const ib_var_source_t      *source,
+    const ib_field_t           *field,
+    const ib_list_t            *source_list,
+    size_t                      num_elements,
+    const collection_index_t  **index
+)
+NONNULL_ATTRIBUTE(1, 2, 3, 4, 6);
+
+/**
+ * Apply a filter to an indexed collection by binary search.
+ *
+ * Equivalent to the linear branch of ib_var_filter_apply() but finds the
+ * matching name range in `O(log n)`.
+ *
+ * @param[in]  index  Index to search.
+ * @param[in]  filter Filter to apply.  Must not be a dynamic access.
+ * @param[in]  mm     Memory manager to allocate @a result from.
+ * @param[out] result Matching elements, in collection order.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t collection_index_apply(
+    const collection_index_t  *index,
+    const ib_var_filter_t     *filter,
+    ib_mm_t                    mm,
+    const ib_list_t          **result
+)
+NONNULL_ATTRIBUTE(1, 2, 4);
+
+/**
+ * Materialize a lazy source in @a store and cache the result.
+ *
+ * Runs the source's materialization callback and records its result via
+ * ib_var_source_set(), advancing the slot's generation so the callback
+ * runs at most once per store even when it produces no value.
+ *
+ * @param[in]  source Source to materialize.  Must have a callback.
+ * @param[out] field  Where to store the value.  May be NULL.
+ * @param[in]  store  Store to materialize in.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_ENOENT if the callback produced no value.
+ * - Any error of the callback or of ib_var_source_set().
+ **/
+static
+ib_status_t source_lazy_materialize(
+    const ib_var_source_t  *source,
+    ib_field_t            **field,
+    ib_var_store_t         *store
+)
+NONNULL_ATTRIBUTE(1, 3);
+
 /* var_config */
 
 ib_status_t ib_var_config_acquire(
@@ -249,6 +543,11 @@ ib_status_t ib_var_config_acquire(
         return rc;
     }
 
+    rc = ib_strintern_create(&local_config->interns, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     *config = local_config;
 
     return IB_OK;
@@ -263,6 +562,15 @@ ib_mm_t ib_var_config_mm(
     return config->mm;
 }
 
+ib_strintern_t *ib_var_config_interns(
+    ib_var_config_t *config
+)
+{
+    assert(config != NULL);
+
+    return config->interns;
+}
+
 /* var_store */
 
 ib_status_t ib_var_store_acquire(
@@ -282,23 +590,35 @@ ib_status_t ib_var_store_acquire(
         return IB_EALLOC;
     }
 
-    local_store->config = config;
-    local_store->mm     = mm;
+    local_store->config       = config;
+    local_store->mm           = mm;
+    local_store->values       = NULL;
+    local_store->generations  = NULL;
+    local_store->num_slots    = config->next_index;
+    local_store->target_cache = NULL;
+    local_store->collection_index = NULL;
 
     rc = ib_hash_create_nocase(&local_store->hash, mm);
     if (rc != IB_OK) {
         return rc;
     }
 
-    if (local_store->config->next_index > 0) {
-        rc = ib_array_create(
-            &local_store->array,
+    if (local_store->num_slots > 0) {
+        local_store->values = ib_mm_calloc(
             mm,
-            local_store->config->next_index,
-            5
+            local_store->num_slots,
+            sizeof(*local_store->values)
         );
-        if (rc != IB_OK) {
-            return rc;
+        if (local_store->values == NULL) {
+            return IB_EALLOC;
+        }
+        local_store->generations = ib_mm_calloc(
+            mm,
+            local_store->num_slots,
+            sizeof(*local_store->generations)
+        );
+        if (local_store->generations == NULL) {
+            return IB_EALLOC;
         }
     }
 
@@ -337,6 +657,180 @@ void ib_var_store_export(
     ib_hash_get_all(store->hash, result);
 }
 
+void store_generation_bump(
+    ib_var_store_t        *store,
+    const ib_var_source_t *source
+)
+{
+    assert(store  != NULL);
+    assert(source != NULL);
+
+    if (source->is_indexed && source->index < store->num_slots) {
+        ++store->generations[source->index];
+    }
+}
+
+ib_status_t ib_var_store_snapshot_take(
+    ib_var_store_t           *store,
+    ib_var_store_snapshot_t **snapshot,
+    ib_mm_t                   mm
+)
+{
+    assert(store    != NULL);
+    assert(snapshot != NULL);
+
+    ib_status_t              rc;
+    ib_var_store_snapshot_t *local_snapshot;
+    ib_hash_iterator_t      *iterator;
+
+    local_snapshot = ib_mm_alloc(mm, sizeof(*local_snapshot));
+    if (local_snapshot == NULL) {
+        return IB_EALLOC;
+    }
+
+    local_snapshot->store        = store;
+    local_snapshot->values       = NULL;
+    local_snapshot->generations  = NULL;
+    local_snapshot->num_elements = NULL;
+    local_snapshot->num_slots    = store->num_slots;
+
+    if (store->num_slots > 0) {
+        local_snapshot->values = ib_mm_memdup(
+            mm,
+            store->values,
+            store->num_slots * sizeof(*store->values)
+        );
+        local_snapshot->generations = ib_mm_memdup(
+            mm,
+            store->generations,
+            store->num_slots * sizeof(*store->generations)
+        );
+        local_snapshot->num_elements = ib_mm_calloc(
+            mm,
+            store->num_slots,
+            sizeof(*local_snapshot->num_elements)
+        );
+        if (
+            local_snapshot->values       == NULL ||
+            local_snapshot->generations  == NULL ||
+            local_snapshot->num_elements == NULL
+        ) {
+            return IB_EALLOC;
+        }
+
+        for (size_t i = 0; i < store->num_slots; ++i) {
+            const ib_field_t *field = store->values[i];
+            const ib_list_t  *list;
+
+            if (
+                field == NULL ||
+                field->type != IB_FTYPE_LIST ||
+                ib_field_is_dynamic(field)
+            ) {
+                continue;
+            }
+            rc = ib_field_value(field, ib_ftype_list_out(&list));
+            /* Can only fail on dynamic field. */
+            assert(rc == IB_OK);
+            local_snapshot->num_elements[i] = ib_list_elements(list);
+        }
+    }
+
+    rc = ib_hash_create_nocase(&local_snapshot->hash, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    iterator = ib_hash_iterator_create(mm);
+    if (iterator == NULL) {
+        return IB_EALLOC;
+    }
+    for (
+        ib_hash_iterator_first(iterator, store->hash);
+        ! ib_hash_iterator_at_end(iterator);
+        ib_hash_iterator_next(iterator)
+    ) {
+        const char *key;
+        size_t      key_length;
+        ib_field_t *value;
+
+        ib_hash_iterator_fetch(&key, &key_length, &value, iterator);
+        /* Keys are source names and outlive both store and snapshot. */
+        rc = ib_hash_set_ex(local_snapshot->hash, key, key_length, value);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *snapshot = local_snapshot;
+
+    return IB_OK;
+}
+
+ib_status_t ib_var_store_restore(
+    ib_var_store_t                *store,
+    const ib_var_store_snapshot_t *snapshot
+)
+{
+    assert(store    != NULL);
+    assert(snapshot != NULL);
+
+    ib_status_t         rc;
+    ib_hash_iterator_t *iterator;
+
+    if (snapshot->store != store || snapshot->num_slots != store->num_slots) {
+        return IB_EINVAL;
+    }
+
+    for (size_t i = 0; i < store->num_slots; ++i) {
+        ib_field_t *field = snapshot->values[i];
+
+        store->values[i]      = field;
+        store->generations[i] = snapshot->generations[i];
+
+        /* Truncate list values that grew since the snapshot. */
+        if (
+            field != NULL &&
+            field->type == IB_FTYPE_LIST &&
+            ! ib_field_is_dynamic(field)
+        ) {
+            ib_list_t *list;
+
+            rc = ib_field_value(field, ib_ftype_list_mutable_out(&list));
+            /* Can only fail on dynamic field. */
+            assert(rc == IB_OK);
+            while (ib_list_elements(list) > snapshot->num_elements[i]) {
+                ib_list_pop(list, NULL);
+            }
+        }
+    }
+
+    ib_hash_clear(store->hash);
+    iterator = ib_hash_iterator_create_malloc();
+    if (iterator == NULL) {
+        return IB_EALLOC;
+    }
+    for (
+        ib_hash_iterator_first(iterator, snapshot->hash);
+        ! ib_hash_iterator_at_end(iterator);
+        ib_hash_iterator_next(iterator)
+    ) {
+        const char *key;
+        size_t      key_length;
+        ib_field_t *value;
+
+        ib_hash_iterator_fetch(&key, &key_length, &value, iterator);
+        rc = ib_hash_set_ex(store->hash, key, key_length, value);
+        if (rc != IB_OK) {
+            free(iterator);
+            return rc;
+        }
+    }
+    free(iterator);
+
+    return IB_OK;
+}
+
 /* var_source */
 
 ib_status_t ib_var_source_register(
@@ -371,12 +865,13 @@ ib_status_t ib_var_source_register(
         return IB_EEXIST;
     }
 
-    local_source->name = ib_mm_memdup(
-        ib_var_config_mm(config),
-        name, name_length
+    rc = ib_strintern_intern(
+        config->interns,
+        name, name_length,
+        &local_source->name
     );
-    if (local_source->name == NULL) {
-        return IB_EALLOC;
+    if (rc != IB_OK) {
+        return rc;
     }
 
     local_source->config        = config;
@@ -385,6 +880,8 @@ ib_status_t ib_var_source_register(
     local_source->final_phase   = final_phase;
     local_source->is_indexed    = true;
     local_source->index         = config->next_index;
+    local_source->lazy_fn       = NULL;
+    local_source->lazy_cbdata   = NULL;
 
     rc = ib_hash_set_ex(
         config->index_by_name,
@@ -404,6 +901,44 @@ ib_status_t ib_var_source_register(
     return IB_OK;
 }
 
+ib_status_t ib_var_source_register_lazy(
+    ib_var_source_t         **source,
+    ib_var_config_t          *config,
+    const char               *name,
+    size_t                    name_length,
+    ib_rule_phase_num_t       initial_phase,
+    ib_rule_phase_num_t       final_phase,
+    ib_var_source_lazy_fn_t   fn,
+    void                     *cbdata
+)
+{
+    assert(config != NULL);
+    assert(name   != NULL);
+    assert(fn     != NULL);
+
+    ib_status_t      rc;
+    ib_var_source_t *local_source;
+
+    rc = ib_var_source_register(
+        &local_source,
+        config,
+        name, name_length,
+        initial_phase, final_phase
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    local_source->lazy_fn     = fn;
+    local_source->lazy_cbdata = cbdata;
+
+    if (source != NULL) {
+        *source = local_source;
+    }
+
+    return IB_OK;
+}
+
 const ib_var_config_t *ib_var_source_config(
     const ib_var_source_t *source
 )
@@ -477,20 +1012,28 @@ ib_status_t ib_var_source_get(
         return IB_EINVAL;
     }
 
-    if (source->is_indexed) {
-        ib_field_t *local_field = NULL;
-        ib_status_t rc;
-
-        rc = ib_array_get(store->array, source->index, &local_field);
-
-        /* Array only errors if out of band, i.e., not set. */
-        if (rc != IB_OK || local_field == NULL) {
+    /* Slots cover every source indexed when the store was acquired.  A
+     * source registered later (which should never happen at evaluation
+     * time) falls back to the hash. */
+    if (source->is_indexed && source->index < store->num_slots) {
+        ib_field_t *local_field = store->values[source->index];
+
+        if (local_field == NULL) {
+            /* Generation 0 means the slot has never been written: a lazy
+             * source materializes now.  A non-zero generation means the
+             * value was removed; do not resurrect it. */
+            if (
+                source->lazy_fn != NULL &&
+                store->generations[source->index] == 0
+            ) {
+                return source_lazy_materialize(source, field, store);
+            }
             return IB_ENOENT;
         }
         if (field != NULL) {
             *field = local_field;
         }
-        return rc;
+        return IB_OK;
     }
     else {
         return ib_hash_get_ex(
@@ -518,6 +1061,33 @@ ib_status_t ib_var_source_get_const(
     );
 }
 
+ib_status_t ib_var_source_generation(
+    const ib_var_source_t *source,
+    const ib_var_store_t  *store,
+    uint32_t              *generation
+)
+{
+    assert(source     != NULL);
+    assert(store      != NULL);
+    assert(generation != NULL);
+
+    if (
+        ib_var_store_config(store) != ib_var_source_config(source) ||
+        ! source->is_indexed
+    ) {
+        return IB_EINVAL;
+    }
+
+    if (source->index >= store->num_slots) {
+        /* Registered after the store was acquired; never set in it. */
+        *generation = 0;
+        return IB_OK;
+    }
+
+    *generation = store->generations[source->index];
+    return IB_OK;
+}
+
 ib_status_t ib_var_source_set(
     const ib_var_source_t *source,
     ib_var_store_t        *store,
@@ -527,8 +1097,6 @@ ib_status_t ib_var_source_set(
     assert(source != NULL);
     assert(store  != NULL);
 
-    ib_status_t rc;
-
     if (ib_var_store_config(store) != ib_var_source_config(source)) {
         return IB_EINVAL;
     }
@@ -538,12 +1106,10 @@ ib_status_t ib_var_source_set(
         field->nlen = source->name_length;
     }
 
-    if (source->is_indexed) {
-        rc = ib_array_setn(store->array, source->index, field);
-        if (rc != IB_OK) {
-            return rc;
-        }
+    if (source->is_indexed && source->index < store->num_slots) {
+        store->values[source->index] = field;
     }
+    store_generation_bump(store, source);
     return ib_hash_set_ex(
         store->hash,
         source->name, source->name_length,
@@ -551,6 +1117,96 @@ ib_status_t ib_var_source_set(
     );
 }
 
+ib_status_t ib_var_source_set_many(
+    ib_var_store_t                 *store,
+    const ib_var_source_set_pair_t *pairs,
+    size_t                          num_pairs
+)
+{
+    assert(store != NULL);
+    assert(pairs != NULL || num_pairs == 0);
+
+    ib_status_t rc;
+    size_t      i;
+
+    /* Validate every pair before writing anything so that a bad entry
+     * does not leave the store partially populated. */
+    for (i = 0; i < num_pairs; ++i) {
+        if (
+            pairs[i].source == NULL ||
+            ib_var_store_config(store) !=
+                ib_var_source_config(pairs[i].source)
+        ) {
+            return IB_EINVAL;
+        }
+    }
+
+    for (i = 0; i < num_pairs; ++i) {
+        const ib_var_source_t *source = pairs[i].source;
+        ib_field_t            *field  = pairs[i].field;
+
+        if (field != NULL) {
+            field->name = source->name;
+            field->nlen = source->name_length;
+        }
+
+        if (source->is_indexed && source->index < store->num_slots) {
+            store->values[source->index] = field;
+        }
+        store_generation_bump(store, source);
+        rc = ib_hash_set_ex(
+            store->hash,
+            source->name, source->name_length,
+            field
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+ib_status_t source_lazy_materialize(
+    const ib_var_source_t  *source,
+    ib_field_t            **field,
+    ib_var_store_t         *store
+)
+{
+    assert(source          != NULL);
+    assert(source->lazy_fn != NULL);
+    assert(store           != NULL);
+
+    ib_status_t  rc;
+    ib_field_t  *local_field = NULL;
+
+    rc = source->lazy_fn(
+        &local_field,
+        source,
+        store,
+        source->lazy_cbdata
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Cache even a NULL result; the generation advancing marks the source
+     * as materialized so the callback runs at most once per store. */
+    rc = ib_var_source_set(source, store, local_field);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (local_field == NULL) {
+        return IB_ENOENT;
+    }
+    if (field != NULL) {
+        *field = local_field;
+    }
+
+    return IB_OK;
+}
+
 ib_status_t ib_var_source_acquire(
     ib_var_source_t       **source,
     ib_mm_t                 mm,
@@ -594,6 +1250,8 @@ ib_status_t ib_var_source_acquire(
         local_source->initial_phase = IB_PHASE_NONE;
         local_source->final_phase   = IB_PHASE_NONE;
         local_source->is_indexed    = false;
+        local_source->lazy_fn       = NULL;
+        local_source->lazy_cbdata   = NULL;
         /* Intentionally leaving index uninitialized so that valgrind can
          * catch invalid uses of it. */
     }
@@ -732,6 +1390,9 @@ ib_status_t ib_var_source_append(
         return rc == IB_EALLOC ? rc : IB_EOTHER;
     }
 
+    /* The value changed even though the slot did not. */
+    store_generation_bump(store, source);
+
     return IB_OK;
 }
 
@@ -810,12 +1471,17 @@ ib_status_t ib_var_filter_apply(
         IB_LIST_LOOP_CONST(answer, node) {
             const ib_field_t *f =
                 (const ib_field_t *)ib_list_node_data_const(node);
+            /* Pointer equality short-circuits the compare when both names
+             * are canonical copies from the same interning table. */
             bool push = (
                 filter->filter_string_length == f->nlen &&
-                strncasecmp(
-                    filter->filter_string,
-                    f->name, f->nlen
-                ) == 0
+                (
+                    filter->filter_string == f->name ||
+                    strncasecmp(
+                        filter->filter_string,
+                        f->name, f->nlen
+                    ) == 0
+                )
             );
             if (push) {
                 /* Discard const because lists are const-generic. */
@@ -873,10 +1539,13 @@ ib_status_t ib_var_filter_remove(
         ib_field_t *f = (ib_field_t *)ib_list_node_data(node);
         if (
             filter->filter_string_length == f->nlen &&
-            strncasecmp(
-                filter->filter_string,
-                f->name, f->nlen
-            ) == 0
+            (
+                filter->filter_string == f->name ||
+                strncasecmp(
+                    filter->filter_string,
+                    f->name, f->nlen
+                ) == 0
+            )
         ) {
             if (result != NULL) {
                 rc = ib_list_push(local_result, (void *)f);
@@ -952,6 +1621,15 @@ ib_var_source_t *ib_var_target_source(
     return target->source;
 }
 
+bool ib_var_target_trivial(
+    const ib_var_target_t *target
+)
+{
+    assert(target != NULL);
+
+    return target->expand == NULL && target->filter == NULL;
+}
+
 ib_status_t ib_var_target_acquire_from_string(
     ib_var_target_t       **target,
     ib_mm_t                 mm,
@@ -997,13 +1675,24 @@ ib_status_t ib_var_target_acquire_from_string(
     if (split_at < target_string_length - 1) {
         const char *filter_string = target_string + split_at + 1;
         size_t filter_string_length = target_string_length - split_at - 1;
-        rc = ib_var_expand_acquire(
-            &expand,
-            mm,
-            filter_string, filter_string_length,
-            config
-        );
-            if (rc != IB_OK) {
+        if (ib_var_expand_test(filter_string, filter_string_length)) {
+            rc = ib_var_expand_acquire(
+                &expand,
+                mm,
+                filter_string, filter_string_length,
+                config
+            );
+        }
+        else {
+            /* Constant filter; compile it now so gets skip expansion and
+             * are eligible for the per-store target cache. */
+            rc = ib_var_filter_acquire(
+                &filter,
+                mm,
+                filter_string, filter_string_length
+            );
+        }
+        if (rc != IB_OK) {
             return rc;
         }
     }
@@ -1063,6 +1752,276 @@ ib_status_t target_filter_get(
     return IB_OK;
 }
 
+ib_status_t target_cache_set(
+    ib_var_store_t        *store,
+    const ib_var_target_t *target,
+    const ib_field_t      *field,
+    size_t                 num_elements,
+    const ib_list_t       *result
+)
+{
+    assert(store  != NULL);
+    assert(target != NULL);
+    assert(field  != NULL);
+    assert(result != NULL);
+
+    ib_status_t           rc;
+    target_cache_entry_t *entry = NULL;
+
+    if (store->target_cache == NULL) {
+        rc = ib_hash_create(&store->target_cache, store->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else {
+        rc = ib_hash_get_ex(
+            store->target_cache,
+            &entry,
+            (const char *)&target, sizeof(target)
+        );
+        if (rc != IB_OK && rc != IB_ENOENT) {
+            return rc;
+        }
+    }
+
+    if (entry == NULL) {
+        entry = ib_mm_alloc(store->mm, sizeof(*entry));
+        if (entry == NULL) {
+            return IB_EALLOC;
+        }
+        entry->target = target;
+        /* Key by the pointer bytes held in the entry; the hash does not
+         * copy keys. */
+        rc = ib_hash_set_ex(
+            store->target_cache,
+            (const char *)&entry->target, sizeof(entry->target),
+            entry
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    entry->generation   = store->generations[target->source->index];
+    entry->field        = field;
+    entry->num_elements = num_elements;
+    entry->result       = result;
+
+    return IB_OK;
+}
+
+int collection_name_cmp(
+    const char *a,
+    size_t      a_length,
+    const char *b,
+    size_t      b_length
+)
+{
+    size_t min_length = (a_length < b_length) ? a_length : b_length;
+    int    cmp        = strncasecmp(a, b, min_length);
+
+    if (cmp != 0) {
+        return cmp;
+    }
+    if (a_length < b_length) {
+        return -1;
+    }
+    if (a_length > b_length) {
+        return 1;
+    }
+    return 0;
+}
+
+int collection_index_element_cmp(const void *a, const void *b)
+{
+    const collection_index_element_t *ea =
+        (const collection_index_element_t *)a;
+    const collection_index_element_t *eb =
+        (const collection_index_element_t *)b;
+
+    int cmp = collection_name_cmp(
+        ea->field->name, ea->field->nlen,
+        eb->field->name, eb->field->nlen
+    );
+    if (cmp != 0) {
+        return cmp;
+    }
+    if (ea->pos < eb->pos) {
+        return -1;
+    }
+    if (ea->pos > eb->pos) {
+        return 1;
+    }
+    return 0;
+}
+
+ib_status_t collection_index_acquire(
+    ib_var_store_t             *store,
+    const ib_var_source_t      *source,
+    const ib_field_t           *field,
+    const ib_list_t            *source_list,
+    size_t                      num_elements,
+    const collection_index_t  **index
+)
+{
+    assert(store       != NULL);
+    assert(source      != NULL);
+    assert(field       != NULL);
+    assert(source_list != NULL);
+    assert(index       != NULL);
+    assert(source->is_indexed && source->index < store->num_slots);
+
+    ib_status_t                 rc;
+    collection_index_t         *entry    = NULL;
+    collection_index_element_t *elements = NULL;
+
+    if (store->collection_index == NULL) {
+        rc = ib_hash_create(&store->collection_index, store->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else {
+        rc = ib_hash_get_ex(
+            store->collection_index,
+            &entry,
+            (const char *)&source, sizeof(source)
+        );
+        if (rc != IB_OK && rc != IB_ENOENT) {
+            return rc;
+        }
+        if (
+            entry != NULL &&
+            entry->generation == store->generations[source->index] &&
+            entry->field == field &&
+            entry->num_elements == num_elements
+        ) {
+            *index = entry;
+            return IB_OK;
+        }
+    }
+
+    /* Build (or rebuild) the sorted element array. */
+    if (num_elements > 0) {
+        const ib_list_node_t *node;
+        size_t                i = 0;
+
+        elements = ib_mm_alloc(
+            store->mm,
+            num_elements * sizeof(*elements)
+        );
+        if (elements == NULL) {
+            return IB_EALLOC;
+        }
+
+        IB_LIST_LOOP_CONST(source_list, node) {
+            elements[i].field =
+                (const ib_field_t *)ib_list_node_data_const(node);
+            elements[i].pos = i;
+            ++i;
+        }
+        assert(i == num_elements);
+
+        qsort(
+            elements,
+            num_elements, sizeof(*elements),
+            collection_index_element_cmp
+        );
+    }
+
+    if (entry == NULL) {
+        entry = ib_mm_alloc(store->mm, sizeof(*entry));
+        if (entry == NULL) {
+            return IB_EALLOC;
+        }
+        entry->source = source;
+        /* Key by the pointer bytes held in the entry; the hash does not
+         * copy keys. */
+        rc = ib_hash_set_ex(
+            store->collection_index,
+            (const char *)&entry->source, sizeof(entry->source),
+            entry
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    entry->generation   = store->generations[source->index];
+    entry->field        = field;
+    entry->num_elements = num_elements;
+    entry->elements     = elements;
+
+    *index = entry;
+    return IB_OK;
+}
+
+ib_status_t collection_index_apply(
+    const collection_index_t  *index,
+    const ib_var_filter_t     *filter,
+    ib_mm_t                    mm,
+    const ib_list_t          **result
+)
+{
+    assert(index  != NULL);
+    assert(filter != NULL);
+    assert(result != NULL);
+
+    ib_status_t  rc;
+    ib_list_t   *local_result;
+    size_t       lo = 0;
+    size_t       hi = index->num_elements;
+
+    rc = ib_list_create(&local_result, mm);
+    if (rc != IB_OK) {
+        assert(rc == IB_EALLOC);
+        return rc;
+    }
+
+    /* Find the first element whose name sorts at or after the filter. */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int    cmp = collection_name_cmp(
+            index->elements[mid].field->name,
+            index->elements[mid].field->nlen,
+            filter->filter_string,
+            filter->filter_string_length
+        );
+        if (cmp < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    /* Equal names are adjacent and in collection order thanks to the
+     * position tie break, so the result matches a linear scan's. */
+    for (
+        size_t i = lo;
+        i < index->num_elements &&
+        collection_name_cmp(
+            index->elements[i].field->name,
+            index->elements[i].field->nlen,
+            filter->filter_string,
+            filter->filter_string_length
+        ) == 0;
+        ++i
+    )
+    {
+        /* Discard const because lists are const-generic. */
+        rc = ib_list_push(local_result, (void *)index->elements[i].field);
+        if (rc != IB_OK) {
+            assert(rc == IB_EALLOC);
+            return rc;
+        }
+    }
+
+    *result = local_result;
+    return IB_OK;
+}
+
 ib_status_t ib_var_target_type(
     ib_var_target_t  *target,
     ib_var_store_t   *store,
@@ -1118,7 +2077,10 @@ ib_status_t ib_var_target_get(
     ib_status_t            rc;
     ib_field_t            *field;
     const ib_list_t       *local_result;
+    const ib_list_t       *source_list = NULL;
     const ib_var_filter_t *filter = NULL;
+    bool                   cacheable;
+    size_t                 num_elements = 0;
 
     rc = ib_var_source_get(
         target->source,
@@ -1129,22 +2091,104 @@ ib_status_t ib_var_target_get(
         return rc;
     }
 
+    /* A constant-filter target on an indexed, non-dynamic list source,
+     * e.g., REQUEST_HEADERS:User-Agent, re-scans the collection linearly
+     * on every get.  Cache its resolution per store, keyed by the target,
+     * so repeated gets by every rule referencing the same target are a
+     * hash lookup instead. */
+    cacheable = (
+        target->filter != NULL &&
+        target->source->is_indexed &&
+        target->source->index < store->num_slots &&
+        field->type == IB_FTYPE_LIST &&
+        ! ib_field_is_dynamic(field)
+    );
+
+    if (cacheable) {
+        rc = ib_field_value(field, ib_ftype_list_out(&source_list));
+        /* Can only fail on dynamic field. */
+        assert(rc == IB_OK);
+        num_elements = ib_list_elements(source_list);
+
+        if (store->target_cache != NULL) {
+            target_cache_entry_t *entry;
+
+            rc = ib_hash_get_ex(
+                store->target_cache,
+                &entry,
+                (const char *)&target, sizeof(target)
+            );
+            if (
+                rc == IB_OK &&
+                entry->generation ==
+                    store->generations[target->source->index] &&
+                entry->field == field &&
+                entry->num_elements == num_elements
+            ) {
+                *result = entry->result;
+                return IB_OK;
+            }
+        }
+    }
+
     rc = target_filter_get(target, &filter, mm, store);
     if (rc != IB_OK) {
         return rc;
     }
 
     if (filter != NULL) {
-        /* Filter list field. */
-        rc = ib_var_filter_apply(
-            filter,
-            &local_result,
-            mm,
-            field
-        );
+        /* Filter list field.  If caching, allocate the result from the
+         * store so that it outlives the caller's memory manager.  Large
+         * collections are filtered through a per-store sorted index so
+         * that each distinct filter binary-searches instead of scanning. */
+        if (
+            cacheable &&
+            num_elements >= COLLECTION_INDEX_MIN_ELEMENTS
+        ) {
+            const collection_index_t *index;
+
+            rc = collection_index_acquire(
+                store,
+                target->source,
+                field,
+                source_list,
+                num_elements,
+                &index
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = collection_index_apply(
+                index,
+                filter,
+                store->mm,
+                &local_result
+            );
+        }
+        else {
+            rc = ib_var_filter_apply(
+                filter,
+                &local_result,
+                cacheable ? store->mm : mm,
+                field
+            );
+        }
         if (rc != IB_OK) {
             return rc;
         }
+
+        if (cacheable) {
+            rc = target_cache_set(
+                store,
+                target,
+                field,
+                num_elements,
+                local_result
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
     }
     else if (field->type == IB_FTYPE_LIST) {
         /* Directly return list field. */
@@ -1279,6 +2323,10 @@ finish:
     if (mpl != NULL) {
         ib_mpool_lite_destroy(mpl);
     }
+    if (rc == IB_OK) {
+        /* The value changed even if the slot did not. */
+        store_generation_bump(store, target->source);
+    }
     if (result != NULL && rc == IB_OK) {
         *result = local_result;
     }
@@ -1408,6 +2456,9 @@ ib_status_t ib_var_target_set(
         return rc == IB_EALLOC ? rc : IB_EOTHER;
     }
 
+    /* The value changed even though the slot did not. */
+    store_generation_bump(store, target->source);
+
     return IB_OK;
 }
 
@@ -1679,6 +2730,64 @@ ib_status_t ib_var_expand_execute(
         return IB_OK;
     }
 
+    /* Single-target expansion of an unfiltered source, e.g. "%{X}" as
+     * setvar and logdata use heavily.  Numeric values convert straight
+     * into @a mm and bytestrings copy once, skipping string assembly and
+     * the temporary pool.  Other types, lists, and errors take the
+     * general path below. */
+    if (
+        expand->next == NULL &&
+        expand->prefix == NULL &&
+        expand->target != NULL &&
+        expand->target->expand == NULL &&
+        expand->target->filter == NULL
+    ) {
+        const ib_field_t *field = NULL;
+
+        rc = ib_var_source_get_const(
+            expand->target->source,
+            &field,
+            store
+        );
+        if (rc == IB_OK) {
+            switch (field->type) {
+            case IB_FTYPE_NUM:
+            case IB_FTYPE_FLOAT:
+                field_to_string(dst, dst_length, field, mm);
+                return IB_OK;
+            case IB_FTYPE_BYTESTR: {
+                const ib_bytestr_t *bs;
+                const char *copy;
+
+                rc = ib_field_value(field, ib_ftype_bytestr_out(&bs));
+                if (rc != IB_OK) {
+                    break;
+                }
+                if (
+                    ib_bytestr_const_ptr(bs) == NULL ||
+                    ib_bytestr_length(bs) == 0
+                ) {
+                    *dst = "";
+                    *dst_length = 0;
+                    return IB_OK;
+                }
+                copy = ib_mm_memdup(
+                    mm,
+                    ib_bytestr_const_ptr(bs), ib_bytestr_length(bs)
+                );
+                if (copy == NULL) {
+                    return IB_EALLOC;
+                }
+                *dst = copy;
+                *dst_length = ib_bytestr_length(bs);
+                return IB_OK;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
     rc = ib_sa_begin(&sa);
     if (rc != IB_OK) {
         assert(rc == IB_EALLOC);
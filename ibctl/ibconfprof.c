@@ -0,0 +1,158 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Configuration Profiler
+ *
+ * Times engine startup against a configuration file and reports where the
+ * time goes: engine creation, configuration parse (parse tree build),
+ * configuration apply (directive handlers, context close, rule compilation),
+ * and a per-directive breakdown sorted by total handler time.
+ *
+ * Usage: ibconfprof &lt;configuration&gt;
+ *
+ * No traffic is sent; the engine is destroyed as soon as configuration
+ * completes.
+ **/
+
+#include <ironbee/clock.h>
+#include <ironbee/config.h>
+#include <ironbee/engine.h>
+#include <ironbee/list.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    /* A minimal server object.  No traffic is sent, so no server callbacks
+     * are needed. */
+    ib_server_t server = {
+        IB_SERVER_HEADER_DEFAULTS,
+        "ibctl/ibconfprof",
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL
+    };
+
+    ib_engine_t     *engine;
+    ib_cfgparser_t  *parser;
+    const ib_list_t *stats;
+    ib_status_t      rc;
+    ib_time_t        t0;
+    ib_time_t        create_usec;
+    ib_time_t        parse_usec;
+    ib_time_t        apply_usec;
+    ib_time_t        handler_usec = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <configuration>\n", argv[0]);
+        return 1;
+    }
+
+    ib_initialize();
+
+    t0 = ib_clock_precise_get_time();
+    rc = ib_engine_create(&engine, &server);
+    create_usec = ib_clock_precise_get_time() - t0;
+    if (rc != IB_OK) {
+        fprintf(stderr,
+                "Error creating engine: %s\n", ib_status_to_string(rc));
+        return 1;
+    }
+
+    rc = ib_cfgparser_create(&parser, engine);
+    if (rc != IB_OK) {
+        fprintf(stderr,
+                "Error creating parser: %s\n", ib_status_to_string(rc));
+        return 1;
+    }
+
+    rc = ib_engine_config_started(engine, parser);
+    if (rc != IB_OK) {
+        fprintf(stderr,
+                "Error starting configuration: %s\n",
+                ib_status_to_string(rc));
+        return 1;
+    }
+
+    /* Parse: builds the parse tree only; no directive handlers run. */
+    t0 = ib_clock_precise_get_time();
+    rc = ib_cfgparser_parse(parser, argv[1]);
+    parse_usec = ib_clock_precise_get_time() - t0;
+    if (rc != IB_OK) {
+        fprintf(stderr,
+                "Error parsing \"%s\": %s\n",
+                argv[1], ib_status_to_string(rc));
+        return 1;
+    }
+
+    /* Apply: directive handlers, context close, rule compilation. */
+    t0 = ib_clock_precise_get_time();
+    rc = ib_engine_config_finished(engine);
+    apply_usec = ib_clock_precise_get_time() - t0;
+    if (rc != IB_OK) {
+        fprintf(stderr,
+                "Error applying configuration: %s\n",
+                ib_status_to_string(rc));
+        return 1;
+    }
+
+    printf("Phase                         Time (ms)\n");
+    printf("engine create              %12.3f\n", create_usec / 1000.0);
+    printf("configuration parse        %12.3f\n", parse_usec  / 1000.0);
+    printf("configuration apply        %12.3f\n", apply_usec  / 1000.0);
+
+    rc = ib_cfgparser_dirstats(parser, ib_engine_mm_main_get(engine), &stats);
+    if (rc == IB_OK && ib_list_elements(stats) > 0) {
+        const ib_list_node_t *node;
+
+        printf("\n");
+        printf("%-30s %8s %12s %12s %7s\n",
+               "Directive", "Count", "Total (ms)", "Mean (us)", "Apply%");
+        IB_LIST_LOOP_CONST(stats, node) {
+            const ib_cfgparser_dirstat_t *stat =
+                ib_list_node_data_const(node);
+            printf("%-30s %8zu %12.3f %12.1f %6.1f%%\n",
+                   stat->name,
+                   stat->count,
+                   stat->usec / 1000.0,
+                   (double)stat->usec / stat->count,
+                   apply_usec > 0
+                       ? 100.0 * stat->usec / apply_usec
+                       : 0.0);
+            handler_usec += stat->usec;
+        }
+        printf("%-30s %8s %12.3f %12s %6.1f%%\n",
+               "(all directive handlers)", "",
+               handler_usec / 1000.0, "",
+               apply_usec > 0
+                   ? 100.0 * handler_usec / apply_usec
+                   : 0.0);
+    }
+
+    ib_cfgparser_destroy(parser);
+    ib_engine_destroy(engine);
+    ib_shutdown();
+
+    return 0;
+}
@@ -152,7 +152,8 @@ NONNULL_ATTRIBUTE(1, 3, 8);
  * @return
  * - IB_OK on success.
  * - IB_EALLOC on allocation failure.
- * - IB_EINVAL if an action with same name already exists.
+ * - IB_EINVAL if an action with same name already exists, or if the
+ *   engine configuration is already finished.
  */
 ib_status_t DLL_PUBLIC ib_action_register(
     ib_engine_t       *ib,
@@ -149,6 +149,30 @@ ib_status_t DLL_PUBLIC ib_bytestr_alias(ib_bytestr_t **pdst,
                                         ib_mm_t mm,
                                         const ib_bytestr_t *src);
 
+/**
+ * Create a read-only byte string that is a view of a sub-range of the
+ * data in another byte string.
+ *
+ * No data is copied: the view references @a src 's storage starting at
+ * @a offset for @a length bytes, so it is only valid as long as that
+ * storage.  The view structure itself is allocated from @a mm; to tie a
+ * capture or transformation result to a transaction, slice a byte string
+ * whose data lives in the transaction memory manager.
+ *
+ * @param pdst Address which new bytestring is written
+ * @param mm Memory manager
+ * @param src Byte string to slice
+ * @param offset Offset of the view in @a src
+ * @param length Length of the view
+ *
+ * @returns Status code; IB_EINVAL if the range does not lie within @a src.
+ */
+ib_status_t DLL_PUBLIC ib_bytestr_alias_range(ib_bytestr_t **pdst,
+                                              ib_mm_t mm,
+                                              const ib_bytestr_t *src,
+                                              size_t offset,
+                                              size_t length);
+
 /**
  * Create a byte string that is an alias (contains a reference) to the
  * data at a given memory location with a given length.
@@ -168,6 +192,36 @@ ib_status_t DLL_PUBLIC ib_bytestr_alias_mem(ib_bytestr_t **pdst,
                                             const uint8_t *data,
                                             size_t dlen);
 
+/**
+ * Size in bytes of an ib_bytestr_t.
+ *
+ * For callers that carve storage for several byte strings out of a single
+ * allocation (see ib_bytestr_alias_mem_init()).  The type is opaque, so
+ * this is the only way to size such storage.
+ *
+ * @returns Size in bytes of an ib_bytestr_t.
+ */
+size_t DLL_PUBLIC ib_bytestr_struct_size(void);
+
+/**
+ * As ib_bytestr_alias_mem(), but initialize caller provided storage
+ * instead of allocating the byte string from @a mm.
+ *
+ * @a dst must point to at least ib_bytestr_struct_size() bytes, aligned
+ * for pointers and sizes.
+ *
+ * @param dst Storage to initialize as a read-only aliasing bytestring
+ * @param mm Memory manager recorded for later append operations
+ * @param data Memory address which contains the data
+ * @param dlen Length of data
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_bytestr_alias_mem_init(ib_bytestr_t *dst,
+                                                 ib_mm_t mm,
+                                                 const uint8_t *data,
+                                                 size_t dlen);
+
 /**
  * Create a byte string that is an alias (contains a reference) to the
  * data in a NUL terminated string.
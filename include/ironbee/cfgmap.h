@@ -225,6 +225,27 @@ ib_status_t DLL_PUBLIC ib_cfgmap_get(const ib_cfgmap_t *cm,
                                      const char *name,
                                      void *out_val, ib_ftype_t *ptype);
 
+/**
+ * Resolve a configuration entry for repeated access.
+ *
+ * ib_cfgmap_get() and ib_cfgmap_set() look @a name up in a hash on every
+ * call.  When an entry is accessed repeatedly, resolve it once with this
+ * function and then read it with ib_field_value() and write it with
+ * ib_field_setv(), skipping the per-access lookup.
+ *
+ * The returned field is the map's own storage for the entry and remains
+ * valid as long as the configuration map.
+ *
+ * @param cm Configuration map
+ * @param name Configuration entry name
+ * @param pfield Address which the entry field is written
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_cfgmap_entry(const ib_cfgmap_t *cm,
+                                       const char *name,
+                                       ib_field_t **pfield);
+
 
 /** @} IronBeeUtilCfgMap */
 
@@ -158,6 +158,40 @@ ib_time_t DLL_PUBLIC ib_clock_get_time(void);
  */
 ib_time_t DLL_PUBLIC ib_clock_precise_get_time(void);
 
+/**
+ * Refresh this thread's coarse clock cache and return the new time.
+ *
+ * Intended to be called at transaction state transitions; consumers that
+ * tolerate ~1ms precision (transaction timestamps, logger records) then
+ * read the cache via ib_clock_coarse_get_time() and
+ * ib_clock_coarse_gettimeofday() without touching the system clock.
+ *
+ * @returns Microsecond time value as from ib_clock_get_time()
+ */
+ib_time_t DLL_PUBLIC ib_clock_coarse_refresh(void);
+
+/**
+ * Get the cached coarse clock time for this thread.
+ *
+ * As ib_clock_get_time() but returns the value cached by the last
+ * ib_clock_coarse_refresh() on this thread, refreshing automatically when
+ * the cache is empty or older than about a millisecond.  Staleness is thus
+ * bounded even on threads that never call ib_clock_coarse_refresh().
+ *
+ * @returns Microsecond time value
+ */
+ib_time_t DLL_PUBLIC ib_clock_coarse_get_time(void);
+
+/**
+ * Get the cached coarse wall time for this thread.
+ *
+ * As ib_clock_gettimeofday() but served from the per-thread cache; see
+ * ib_clock_coarse_refresh().
+ *
+ * @param[out] tp Address which ib_timeval_t is written
+ */
+void DLL_PUBLIC ib_clock_coarse_gettimeofday(ib_timeval_t *tp);
+
 /**
  * IronBee types version of @c gettimeofday() called with
  * NULL timezone parameter.  The returned time is relative to epoch.
@@ -27,6 +27,7 @@
 
 #include <ironbee/build.h>
 #include <ironbee/cfgmap.h>
+#include <ironbee/clock.h>
 #include <ironbee/engine.h>
 #include <ironbee/log.h>
 #include <ironbee/strval.h>
@@ -125,8 +126,36 @@ struct ib_cfgparser_t {
     ib_cfgparser_fsm_t fsm;
 
     ib_vector_t *buffer; /**< Buffer for building tokens. */
+
+    /**
+     * Directory holding per-include parse cache images, or NULL.
+     *
+     * @sa ib_cfgparser_include_cache_set()
+     */
+    const char *include_cache_dir;
+
+    /**
+     * Per-directive timing, keyed by directive name.
+     *
+     * Values are @ref ib_cfgparser_dirstat_t, accumulated as directives
+     * are applied.
+     *
+     * @sa ib_cfgparser_dirstats()
+     */
+    ib_hash_t *dirstats;
 };
 
+/**
+ * Timing statistics for one directive.
+ *
+ * @sa ib_cfgparser_dirstats()
+ */
+typedef struct ib_cfgparser_dirstat_t {
+    const char *name;  /**< Directive name. */
+    size_t      count; /**< Times the directive handler ran. */
+    ib_time_t   usec;  /**< Total handler time in microseconds. */
+} ib_cfgparser_dirstat_t;
+
 /**
  * Directive types.
  */
@@ -237,6 +266,30 @@ typedef ib_status_t (*ib_config_cb_sblk1_fn_t)(ib_cfgparser_t *cp,
                                                const char *p1,
                                                void *cbdata);
 
+/**
+ * Callback for a batch of consecutive identical directives.
+ *
+ * Directives may opt in to vectorized processing by registering a batch
+ * handler in addition to their normal handler.  When the parser applies
+ * a run of two or more consecutive occurrences of such a directive it
+ * invokes the batch handler once with the parameter lists of the whole
+ * run, amortizing directive lookup and dispatch across the run.  The
+ * handler must validate each parameter list itself, as the per-type
+ * argument count checks are bypassed.
+ *
+ * @param[in] cp Configuration parser
+ * @param[in] name Directive name
+ * @param[in] arg_lists Array of parameter lists, one per occurrence,
+ *            in configuration order.  Elements are @c const @c char*.
+ * @param[in] count Number of entries in @a arg_lists
+ * @param[in] cbdata Callback data
+ */
+typedef ib_status_t (*ib_config_cb_batch_fn_t)(ib_cfgparser_t *cp,
+                                               const char *name,
+                                               const ib_list_t *const *arg_lists,
+                                               size_t count,
+                                               void *cbdata);
+
 /**
  * Directive initialization mapping structure.
  */
@@ -264,6 +317,10 @@ struct ib_dirmap_init_t {
     /*! Callback data for blkend. */
     void                         *cbdata_blkend;
     ib_strval_t                  *valmap;    /**< Value map */
+    /*! Optional handler for runs of identical directives (or NULL). */
+    ib_config_cb_batch_fn_t       fn_batch;
+    /*! Callback data for fn_batch. */
+    void                         *cbdata_batch;
     /// @todo Do we need help text or error messages???
 };
 
@@ -297,7 +354,7 @@ struct ib_dirmap_init_t {
  * @param cbdata Callback data
  */
 #define IB_DIRMAP_INIT_ONOFF(name, cb, cbdata) \
-    { (name), IB_DIRTYPE_ONOFF, IB_DIRMAP_INIT_CB_HELPER(fn_onoff, (cb)), NULL, (cbdata), NULL, NULL }
+    { (name), IB_DIRTYPE_ONOFF, IB_DIRMAP_INIT_CB_HELPER(fn_onoff, (cb)), NULL, (cbdata), NULL, NULL, NULL, NULL }
 
 /**
  * Directive with a single string parameter.
@@ -307,7 +364,7 @@ struct ib_dirmap_init_t {
  * @param cbdata Callback data
  */
 #define IB_DIRMAP_INIT_PARAM1(name, cb, cbdata) \
-    { (name), IB_DIRTYPE_PARAM1, IB_DIRMAP_INIT_CB_HELPER(fn_param1, (cb)), NULL, (cbdata), NULL, NULL }
+    { (name), IB_DIRTYPE_PARAM1, IB_DIRMAP_INIT_CB_HELPER(fn_param1, (cb)), NULL, (cbdata), NULL, NULL, NULL, NULL }
 
 /**
  * Directive with two string parameters.
@@ -317,7 +374,7 @@ struct ib_dirmap_init_t {
  * @param cbdata Callback data
  */
 #define IB_DIRMAP_INIT_PARAM2(name, cb, cbdata) \
-    { (name), IB_DIRTYPE_PARAM2, IB_DIRMAP_INIT_CB_HELPER(fn_param2, (cb)), NULL, (cbdata), NULL, NULL }
+    { (name), IB_DIRTYPE_PARAM2, IB_DIRMAP_INIT_CB_HELPER(fn_param2, (cb)), NULL, (cbdata), NULL, NULL, NULL, NULL }
 
 /**
  * Directive with list of string parameters.
@@ -327,7 +384,37 @@ struct ib_dirmap_init_t {
  * @param cbdata Callback data
  */
 #define IB_DIRMAP_INIT_LIST(name, cb, cbdata) \
-    { (name), IB_DIRTYPE_LIST, IB_DIRMAP_INIT_CB_HELPER(fn_list, (cb)), NULL, (cbdata), NULL, NULL }
+    { (name), IB_DIRTYPE_LIST, IB_DIRMAP_INIT_CB_HELPER(fn_list, (cb)), NULL, (cbdata), NULL, NULL, NULL, NULL }
+
+/**
+ * Directive with two string parameters and a batch handler.
+ *
+ * As IB_DIRMAP_INIT_PARAM2(), but runs of consecutive occurrences are
+ * handed to @a batch_cb instead (see @ref ib_config_cb_batch_fn_t).
+ *
+ * @param name Directive name
+ * @param cb Callback
+ * @param cbdata Callback data
+ * @param batch_cb Batch callback
+ * @param batch_cbdata Callback data for @a batch_cb
+ */
+#define IB_DIRMAP_INIT_PARAM2_BATCH(name, cb, cbdata, batch_cb, batch_cbdata) \
+    { (name), IB_DIRTYPE_PARAM2, IB_DIRMAP_INIT_CB_HELPER(fn_param2, (cb)), NULL, (cbdata), NULL, NULL, (batch_cb), (batch_cbdata) }
+
+/**
+ * Directive with list of string parameters and a batch handler.
+ *
+ * As IB_DIRMAP_INIT_LIST(), but runs of consecutive occurrences are
+ * handed to @a batch_cb instead (see @ref ib_config_cb_batch_fn_t).
+ *
+ * @param name Directive name
+ * @param cb Callback
+ * @param cbdata Callback data
+ * @param batch_cb Batch callback
+ * @param batch_cbdata Callback data for @a batch_cb
+ */
+#define IB_DIRMAP_INIT_LIST_BATCH(name, cb, cbdata, batch_cb, batch_cbdata) \
+    { (name), IB_DIRTYPE_LIST, IB_DIRMAP_INIT_CB_HELPER(fn_list, (cb)), NULL, (cbdata), NULL, NULL, (batch_cb), (batch_cbdata) }
 
 /**
  * Directive with list of unique options string parameters which are
@@ -344,7 +431,7 @@ struct ib_dirmap_init_t {
  * @param valmap Array of @ref ib_strval_t structures mapping options to values
  */
 #define IB_DIRMAP_INIT_OPFLAGS(name, cb, cbdata, valmap) \
-    { (name), IB_DIRTYPE_OPFLAGS, IB_DIRMAP_INIT_CB_HELPER(fn_opflags, (cb)), NULL, (cbdata), NULL, (valmap) }
+    { (name), IB_DIRTYPE_OPFLAGS, IB_DIRMAP_INIT_CB_HELPER(fn_opflags, (cb)), NULL, (cbdata), NULL, (valmap), NULL, NULL }
 
 /**
  * Block with single parameter enclosing more directives.
@@ -358,7 +445,7 @@ struct ib_dirmap_init_t {
  * @param blkenddata Callback data for @a blkend
  */
 #define IB_DIRMAP_INIT_SBLK1(name, cb, blkend, cbdata, blkenddata) \
-    { (name), IB_DIRTYPE_SBLK1, IB_DIRMAP_INIT_CB_HELPER(fn_sblk1, (cb)), (blkend), (cbdata), (blkenddata), NULL }
+    { (name), IB_DIRTYPE_SBLK1, IB_DIRMAP_INIT_CB_HELPER(fn_sblk1, (cb)), (blkend), (cbdata), (blkenddata), NULL, NULL, NULL }
 
 /** Required last entry. */
 #define IB_DIRMAP_INIT_LAST { .name = NULL }
@@ -474,6 +561,26 @@ ib_status_t DLL_PUBLIC ib_cfgparser_apply_node(
     ib_cfgparser_node_t *tree,
     ib_engine_t *ib);
 
+/**
+ * Fetch per-directive timing, sorted by total time, descending.
+ *
+ * Timing is accumulated whenever directives are applied, so this is
+ * meaningful after ib_cfgparser_apply().  Use it to attribute
+ * configuration load time to directive handlers.
+ *
+ * @param[in] cp Configuration parser that applied a configuration.
+ * @param[in] mm Memory manager to allocate the result list from.
+ * @param[out] stats List of @ref ib_cfgparser_dirstat_t.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation errors.
+ */
+ib_status_t DLL_PUBLIC ib_cfgparser_dirstats(
+    const ib_cfgparser_t *cp,
+    ib_mm_t               mm,
+    const ib_list_t     **stats);
+
 /**
  * Parse @a buffer.
  *
@@ -490,6 +597,99 @@ ib_status_t DLL_PUBLIC ib_cfgparser_parse_buffer(
     bool more
 );
 
+/**
+ * Serialize the parse tree of @a cp to a versioned binary image.
+ *
+ * The image records the modification time and size of every
+ * configuration file that contributed to the tree, so a later
+ * ib_cfgparser_cache_load() can detect stale images. It is written to
+ * a temporary file and renamed into place.
+ *
+ * Only configuration text is covered: files read by directive handlers
+ * themselves (external rule files, scripts, data files) are not in the
+ * manifest, so remove the image when those change.
+ *
+ * @param[in] cp Configuration parser holding a parsed tree.
+ * @param[in] path Path the image is written to.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation errors.
+ *   - IB_EOTHER on file system errors.
+ */
+ib_status_t DLL_PUBLIC ib_cfgparser_cache_save(
+    ib_cfgparser_t *cp,
+    const char *path);
+
+/**
+ * Load a parse tree image written by ib_cfgparser_cache_save().
+ *
+ * On success the tree of @a cp is replaced by the deserialized tree,
+ * ready for ib_cfgparser_apply(), and no configuration file is read or
+ * parsed.
+ *
+ * @param[in,out] cp Configuration parser to receive the tree.
+ * @param[in] path Path of the image.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_ENOENT if no image exists at @a path.
+ *   - IB_DECLINED if the image is stale: a manifest file changed or is
+ *     missing, or the image format version is not current. The caller
+ *     should fall back to ib_cfgparser_parse().
+ *   - IB_EINVAL if the image is corrupt.
+ *   - IB_EALLOC on allocation errors.
+ *   - IB_EOTHER on file system errors.
+ */
+ib_status_t DLL_PUBLIC ib_cfgparser_cache_load(
+    ib_cfgparser_t *cp,
+    const char *path);
+
+/**
+ * Parse @a file, using and maintaining the cache image at @a cache_path.
+ *
+ * If a current image exists it is loaded and @a file is never opened.
+ * Otherwise @a file is parsed as by ib_cfgparser_parse() and a fresh
+ * image is saved; failure to save is logged and otherwise ignored.
+ *
+ * @param[in,out] cp The configuration parser to be used and populated.
+ * @param[in] file The file to be opened and read.
+ * @param[in] cache_path Path of the cache image.
+ *
+ * @returns As ib_cfgparser_parse().
+ */
+ib_status_t DLL_PUBLIC ib_cfgparser_parse_cached(
+    ib_cfgparser_t *cp,
+    const char *file,
+    const char *cache_path);
+
+/**
+ * Enable the per-include parse cache, storing images under @a dir.
+ *
+ * When enabled, every file pulled in by Include or IncludeIfExists has
+ * its parsed subtree cached in @a dir, keyed by a hash of the file's
+ * path and content. An include whose content (and that of any file it
+ * transitively includes) is unchanged is served from the cache without
+ * being re-lexed. This keeps reloads of include-heavy configurations
+ * fast even when the whole-tree image of ib_cfgparser_parse_cached()
+ * is invalidated by an edit to one file.
+ *
+ * The directory is created if it does not exist. Stale images are
+ * simply never read again; the directory may be deleted at any time.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] dir Directory to hold cache images. NULL disables the
+ *            cache.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation errors.
+ *   - IB_EOTHER if the directory cannot be created.
+ */
+ib_status_t DLL_PUBLIC ib_cfgparser_include_cache_set(
+    ib_cfgparser_t *cp,
+    const char *dir);
+
 /**
  * Push a new context onto the stack and make it the current.
  *
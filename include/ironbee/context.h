@@ -158,6 +158,52 @@ ib_status_t DLL_PUBLIC ib_context_open(ib_context_t *ctx);
  */
 ib_status_t DLL_PUBLIC ib_context_close(ib_context_t *ctx);
 
+/**
+ * @name Inspection profile flags
+ *
+ * What traffic a context's policy actually consumes, computed when the
+ * context closes. Servers may query this right after context selection
+ * and skip feeding the engine data the policy never looks at.
+ */
+
+/**@{*/
+
+/** The policy consumes nothing. */
+#define IB_INSPECT_NONE            (0)
+/** Request headers feed rules or the audit log. */
+#define IB_INSPECT_REQUEST_HEADER  (1 << 0)
+/** Request body feeds rules or the audit log. */
+#define IB_INSPECT_REQUEST_BODY    (1 << 1)
+/** Response headers feed rules or the audit log. */
+#define IB_INSPECT_RESPONSE_HEADER (1 << 2)
+/** Response body feeds rules or the audit log. */
+#define IB_INSPECT_RESPONSE_BODY   (1 << 3)
+/** Everything is consumed. */
+#define IB_INSPECT_ALL \
+    ( IB_INSPECT_REQUEST_HEADER | IB_INSPECT_REQUEST_BODY | \
+      IB_INSPECT_RESPONSE_HEADER | IB_INSPECT_RESPONSE_BODY )
+
+/**@}*/
+
+/**
+ * Get the inspection profile of @a ctx.
+ *
+ * The profile is computed once, when the context closes, from the
+ * phases that hold rules or injection callbacks and from the
+ * configured audit log parts. It errs toward inspection: an open
+ * context, or any doubt about a consumer, reports @ref IB_INSPECT_ALL.
+ *
+ * Note that a rule may read data from a phase earlier than its own
+ * (a response rule targeting a request field); body flags are derived
+ * from the phases in which that body is the subject of inspection,
+ * matching how the engine itself decides whether to buffer.
+ *
+ * @param[in] ctx Config context.
+ *
+ * @returns The profile as IB_INSPECT_* flags.
+ */
+ib_flags_t DLL_PUBLIC ib_context_inspection_profile(const ib_context_t *ctx);
+
 /**
  * Get the parent context.
  *
@@ -395,6 +441,23 @@ ib_status_t DLL_PUBLIC ib_context_get(ib_context_t *ctx,
                                       const char *name,
                                       void *pval, ib_ftype_t *ptype);
 
+/**
+ * Resolve a config context entry for repeated access.
+ *
+ * As ib_cfgmap_entry(), but for the configuration map of @a ctx:
+ * resolves @a name once so later accesses through ib_field_value() and
+ * ib_field_setv() skip the per-access name lookup of ib_context_get().
+ *
+ * @param ctx Configuration context
+ * @param name Variable name
+ * @param pfield Address to which the entry field is written
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_context_config_entry(ib_context_t *ctx,
+                                               const char *name,
+                                               ib_field_t **pfield);
+
 /**
  * @} IronBeeEngine
  * @} IronBee
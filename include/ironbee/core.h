@@ -76,6 +76,8 @@ typedef struct ib_core_cfg_t ib_core_cfg_t;
 struct ib_core_audit_cfg_t {
     FILE                *index_fp;      /**< Index file pointer */
     FILE                *fp;            /**< Audit log file pointer */
+    char                *mem_buf;       /**< Async mode: fp's memory buffer */
+    size_t               mem_buf_sz;    /**< Async mode: mem_buf length */
     const char          *fn;            /**< Audit log file name */
     const char          *full_path;     /**< Audit log full path */
     const char          *temp_path;     /**< Full path to temporary file */
@@ -115,6 +117,14 @@ typedef enum ib_audit_mode_t {
     IB_AUDIT_MODE_ALERTS, /**< Only record if there are alerts. */
 } ib_audit_mode_t;
 
+/**
+ * The serialization formats of the audit log.
+ */
+typedef enum ib_auditlog_format_t {
+    IB_AUDITLOG_FORMAT_MULTIPART, /**< MIME multipart text. The default. */
+    IB_AUDITLOG_FORMAT_BINARY,    /**< Length-prefixed binary records. */
+} ib_auditlog_format_t;
+
 /**
  * InitVar entry.
  **/
@@ -184,6 +194,12 @@ struct ib_core_cfg_t {
     const ib_logformat_t *auditlog_index_hp; /**< Audit log index fmt helper */
     const char       *auditlog_dir;      /**< Audit log base directory */
     const char       *auditlog_sdir_fmt; /**< Audit log sub-directory format */
+    ib_num_t          auditlog_async;    /**< Async writer threads; 0=sync */
+    ib_num_t          auditlog_format;   /**< An ib_auditlog_format_t */
+    ib_num_t          flightrec_threshold; /**< Dump traces for txs over
+                                                this many msec; 0=off */
+    ib_num_t          tx_memory_limit;   /**< Per-tx allocation budget in
+                                              bytes; 0=off */
     /**
      * List of @ref ib_core_auditlog_fn_t and associated callback data.
      *
@@ -198,6 +214,9 @@ struct ib_core_cfg_t {
     const char       *data;              /**< Active data provider key */
     const char       *module_base_path;  /**< Module base path. */
     const char       *rule_base_path;    /**< Rule base path. */
+    ib_num_t          event_sample_pct;  /**< Percent of events kept (1-100) */
+    ib_num_t          event_rate_limit;  /**< Per-rule-id events/sec; 0=off */
+    ib_num_t          event_dedup;       /**< Merge duplicate events in a tx */
     ib_num_t          rule_log_flags;    /**< Rule execution logging flags */
     ib_num_t          rule_log_level;    /**< Rule execution logging level */
     const char       *rule_debug_str;    /**< Rule debug logging level */
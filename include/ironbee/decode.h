@@ -29,6 +29,7 @@
 #include <ironbee/build.h>
 #include <ironbee/types.h>
 
+#include <stdbool.h>
 #include <sys/types.h>
 
 #ifdef __cplusplus
@@ -79,6 +80,89 @@ ib_status_t DLL_PUBLIC ib_util_decode_html_entity(
 )
 NONNULL_ATTRIBUTE(1, 3, 4);
 
+/**
+ * State for ib_util_decode_url_stream().
+ *
+ * Zero initialize before the first call.
+ */
+typedef struct ib_decode_url_state_t {
+    uint8_t pending[2];  /**< Held bytes of a possibly split escape. */
+    size_t  pending_len; /**< Number of held bytes: 0, 1 or 2. */
+} ib_decode_url_state_t;
+
+/**
+ * Decode a URL one chunk at a time.
+ *
+ * Feed consecutive chunks of the input with the same @a state, passing
+ * true for @a final on the last chunk.  The concatenated output is
+ * byte-identical to ib_util_decode_url() of the concatenated input; a
+ * percent escape split across chunks is carried over in @a state.
+ *
+ * @param[in,out] state    Carry-over state.
+ * @param[in]     data_in  Chunk data.  May be NULL if @a dlen_in is 0.
+ * @param[in]     dlen_in  Length of @a data_in.
+ * @param[in]     data_out Where to write output.  Must have room for
+ *                         @a dlen_in + 2 bytes.
+ * @param[out]    dlen_out Bytes written to @a data_out.
+ * @param[in]     final    True on the last chunk; flushes any held bytes.
+ *
+ * @returns IB_OK
+ */
+ib_status_t DLL_PUBLIC ib_util_decode_url_stream(
+    ib_decode_url_state_t *state,
+    const uint8_t         *data_in,
+    size_t                 dlen_in,
+    uint8_t               *data_out,
+    size_t                *dlen_out,
+    bool                   final
+)
+NONNULL_ATTRIBUTE(1, 4, 5);
+
+/** Carry capacity of @ref ib_decode_html_entity_state_t. */
+#define IB_DECODE_HTML_ENTITY_CARRY 32
+
+/**
+ * State for ib_util_decode_html_entity_stream().
+ *
+ * Zero initialize before the first call.
+ */
+typedef struct ib_decode_html_entity_state_t {
+    /*! Held bytes of a possibly split entity, starting with '&'. */
+    uint8_t carry[IB_DECODE_HTML_ENTITY_CARRY];
+    size_t  carry_len; /**< Number of held bytes. */
+} ib_decode_html_entity_state_t;
+
+/**
+ * Decode HTML entities one chunk at a time.
+ *
+ * Feed consecutive chunks of the input with the same @a state, passing
+ * true for @a final on the last chunk.  The concatenated output is
+ * byte-identical to ib_util_decode_html_entity() of the concatenated
+ * input, with one exception: an entity candidate longer than
+ * @ref IB_DECODE_HTML_ENTITY_CARRY bytes (far beyond any real entity) is
+ * emitted verbatim instead of decoded.
+ *
+ * @param[in,out] state    Carry-over state.
+ * @param[in]     data_in  Chunk data.  May be NULL if @a dlen_in is 0.
+ * @param[in]     dlen_in  Length of @a data_in.
+ * @param[in]     data_out Where to write output.  Must have room for
+ *                         @a dlen_in + @ref IB_DECODE_HTML_ENTITY_CARRY
+ *                         bytes.
+ * @param[out]    dlen_out Bytes written to @a data_out.
+ * @param[in]     final    True on the last chunk; flushes any held bytes.
+ *
+ * @returns IB_OK
+ */
+ib_status_t DLL_PUBLIC ib_util_decode_html_entity_stream(
+    ib_decode_html_entity_state_t *state,
+    const uint8_t                 *data_in,
+    size_t                         dlen_in,
+    uint8_t                       *data_out,
+    size_t                        *dlen_out,
+    bool                           final
+)
+NONNULL_ATTRIBUTE(1, 4, 5);
+
 /** @} */
 
 #ifdef __cplusplus
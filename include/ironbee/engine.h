@@ -119,6 +119,25 @@ uint32_t DLL_PUBLIC ib_engine_abi_number(void);
 ib_status_t DLL_PUBLIC ib_engine_create(ib_engine_t **pib,
                                         const ib_server_t *server);
 
+/**
+ * Set allocator hooks for engine configuration memory pools.
+ *
+ * Subsequently created engines allocate configuration pool pages with
+ * @a malloc_fn and release them with @a free_fn.  This lets a server
+ * build configuration into special backing memory, such as a shared
+ * mapping created before fork so worker processes share one copy
+ * (see @ref IronBeeUtilShmArena).
+ *
+ * The hooks are process wide and must be set before any engine is
+ * created.  Pass NULL for both to restore the defaults.
+ *
+ * @param malloc_fn Allocation function, or NULL for malloc().
+ * @param free_fn Matching free function, or NULL for free().
+ */
+void DLL_PUBLIC ib_engine_config_allocators_set(
+    ib_mpool_malloc_fn_t malloc_fn,
+    ib_mpool_free_fn_t   free_fn);
+
 /**
  * Return the server object for an engine.
  *
@@ -166,6 +185,121 @@ ib_logger_t DLL_PUBLIC *ib_engine_logger_get(const ib_engine_t *ib);
  */
 const char DLL_PUBLIC *ib_engine_instance_id(const ib_engine_t *ib);
 
+/**
+ * Override a runtime-tunable setting without a configuration reload.
+ *
+ * Supported setting names:
+ * - @c rule_dlog_level - Rule engine debug log level
+ *   (@ref ib_rule_dlog_level_t numeric value).
+ * - @c request_body_log_limit - Request body buffer limit, in bytes.
+ * - @c response_body_log_limit - Response body buffer limit, in bytes.
+ *
+ * A negative @a value clears the override, restoring the configured
+ * value.  Overrides apply engine-wide, across all contexts, and are
+ * stored as single aligned words so transactions in flight observe
+ * either the old or the new value without locking.
+ *
+ * @param[in] ib Engine handle
+ * @param[in] name Setting name.
+ * @param[in] value Value to apply, or negative to clear the override.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a name is not a tunable setting.
+ */
+ib_status_t DLL_PUBLIC ib_engine_tune_set(ib_engine_t *ib,
+                                          const char *name,
+                                          ib_num_t value);
+
+/**
+ * Get the current override of a runtime-tunable setting.
+ *
+ * @param[in] ib Engine handle
+ * @param[in] name Setting name (see ib_engine_tune_set()).
+ * @param[out] pvalue The override value; negative if not overridden.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a name is not a tunable setting.
+ */
+ib_status_t DLL_PUBLIC ib_engine_tune_get(const ib_engine_t *ib,
+                                          const char *name,
+                                          ib_num_t *pvalue);
+
+/**
+ * Runtime control command implementation.
+ *
+ * Registered by ib_engine_ctlcmd_register() and run by
+ * ib_engine_ctlcmd_run(), typically on behalf of the engine manager
+ * control channel.  Commands run on the control channel's thread while
+ * transactions are in flight; implementations must synchronize with the
+ * data they change.
+ *
+ * @param[in] ib Engine the command acts on.
+ * @param[in] mm Memory manager for @a result and other allocations that
+ *            must live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args The command arguments as a single NUL-terminated string.
+ * @param[out] result Optional result message for the caller.  Initially
+ *             NULL; if left unchanged the return code is reported instead.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns Status code reported to the caller when @a result is not set.
+ */
+typedef ib_status_t (*ib_engine_ctlcmd_fn_t)(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+);
+
+/**
+ * Register a runtime control command with the engine.
+ *
+ * This lets modules expose operations -- reloading a data file, flushing
+ * a cache -- that can be triggered on a live engine without a
+ * configuration reload.  The engine manager control channel dispatches
+ * its @c engine command here.
+ *
+ * @param[in] ib Engine to register with.
+ * @param[in] name Command name; copied.
+ * @param[in] fn Command implementation.
+ * @param[in] cbdata Callback data for @a fn.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if @a name is already registered.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_engine_ctlcmd_register(
+    ib_engine_t           *ib,
+    const char            *name,
+    ib_engine_ctlcmd_fn_t  fn,
+    void                  *cbdata);
+
+/**
+ * Run a registered runtime control command.
+ *
+ * @param[in] ib Engine to run the command against.
+ * @param[in] name Command name.
+ * @param[in] args Command arguments as a single NUL-terminated string;
+ *            may be empty, never NULL.
+ * @param[in] mm Memory manager for @a result.
+ * @param[out] result Result message, or NULL if the command set none.
+ *
+ * @returns
+ * - IB_ENOENT if @a name is not a registered command.
+ * - Otherwise the return of the command.
+ */
+ib_status_t DLL_PUBLIC ib_engine_ctlcmd_run(
+    ib_engine_t *ib,
+    const char  *name,
+    const char  *args,
+    ib_mm_t      mm,
+    const char **result);
+
 /**
  * Inform the engine that the configuration phase is starting
  *
@@ -367,6 +501,71 @@ ib_status_t DLL_PUBLIC ib_engine_notify_logevent(
     ib_logevent_t *logevent
 ) NONNULL_ATTRIBUTE(1, 2, 3);
 
+/**
+ * Callback to pre-create per-worker resources after configuration.
+ *
+ * Modules that build resources on first demand (stack pools, JIT
+ * scratch space, etc) may register one of these to warm those
+ * resources before the engine sees traffic, so that first-request
+ * latency after a deploy or reload matches steady state.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] concurrency The number of workers expected to use the
+ *            engine concurrently. Callbacks should size their
+ *            warming to this value.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on error. Errors are logged and do not abort warming.
+ */
+typedef ib_status_t (*ib_engine_prewarm_fn_t)(
+    ib_engine_t *ib,
+    size_t       concurrency,
+    void        *cbdata
+);
+
+/**
+ * Register a callback to pre-create resources after configuration.
+ *
+ * Registration must happen before configuration finishes.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] fn The function to call from ib_engine_prewarm().
+ * @param[in] cbdata Callback data for @a fn.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If the engine configuration is already finished.
+ * - IB_EALLOC On allocation error.
+ * - Other on unexpected failure.
+ */
+ib_status_t DLL_PUBLIC ib_engine_prewarm_register(
+    ib_engine_t            *ib,
+    ib_engine_prewarm_fn_t  fn,
+    void                   *cbdata
+);
+
+/**
+ * Run all registered prewarm callbacks.
+ *
+ * This may only be called after configuration has finished. It is
+ * normally called by the server or engine manager once the expected
+ * worker concurrency is known. Callback failures are logged and do
+ * not stop the remaining callbacks from running.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] concurrency The number of workers expected to use the
+ *            engine concurrently.
+ *
+ * @returns
+ * - IB_OK On success.
+ */
+ib_status_t DLL_PUBLIC ib_engine_prewarm(
+    ib_engine_t *ib,
+    size_t       concurrency
+);
+
 /**
  * Destroy an engine.
  *
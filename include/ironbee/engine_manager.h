@@ -165,6 +165,79 @@ ib_status_t ib_manager_register_module_fn(
     void                          *module_data
 );
 
+/**
+ * Set the path of the configuration parse cache image.
+ *
+ * When set, engines created by this manager load their configuration
+ * from the image when it is current, skipping the text parse, and
+ * rebuild it after a full parse. See ib_cfgparser_parse_cached() for
+ * what the image covers and when it is declined.
+ *
+ * @param[in] manager Engine manager.
+ * @param[in] path Path of the cache image. NULL disables the cache.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC if the path cannot be copied.
+ */
+ib_status_t DLL_PUBLIC ib_manager_config_cache_set(
+    ib_manager_t *manager,
+    const char   *path
+);
+
+/**
+ * Set the worker concurrency used to prewarm new engines.
+ *
+ * When set to a non-zero value, engines created by this manager run
+ * ib_engine_prewarm() with this concurrency after configuration
+ * finishes, letting modules pre-create per-worker resources before
+ * the engine sees traffic. Servers should set this to their worker
+ * count before the first engine is created.
+ *
+ * @param[in] manager Engine manager.
+ * @param[in] concurrency Expected worker concurrency. 0 disables
+ *            prewarming.
+ *
+ * @returns
+ * - IB_OK on success.
+ */
+ib_status_t DLL_PUBLIC ib_manager_prewarm_set(
+    ib_manager_t *manager,
+    size_t        concurrency
+);
+
+/**
+ * Set the number of engine replicas created per name.
+ *
+ * When set above one, each ib_manager_engine_create() builds this many
+ * engines from the same configuration file.  Replica 0 is registered
+ * under the given name; replica @e i is registered under `name@i`.
+ * ib_manager_engine_acquire() then pins each calling thread to one
+ * replica, assigned round-robin on the thread's first acquire, so
+ * per-transaction mutable engine state (logger queues, connection
+ * registration) stays local to that thread's cores instead of bouncing
+ * between all server threads.  Read-only data with file-backed pages,
+ * such as loaded automata, is shared between replicas by the operating
+ * system; configuration is parsed once per replica.
+ *
+ * Set this before the first ib_manager_engine_create().  The manager's
+ * max engines limit must be at least twice @a replicas so a reload can
+ * hold old and new replicas simultaneously.
+ *
+ * @param[in] manager Engine manager.
+ * @param[in] replicas Replicas per name.  1 restores the default,
+ *            single-engine behavior.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if @a replicas is zero or more than half the manager's
+ *   max engines limit.
+ */
+ib_status_t DLL_PUBLIC ib_manager_replicas_set(
+    ib_manager_t *manager,
+    size_t        replicas
+);
+
 /**
  * A function called before @a ib is configured.
  *
@@ -286,6 +359,65 @@ ib_status_t DLL_PUBLIC ib_manager_engine_create(
 )
 NONNULL_ATTRIBUTE(1,2);
 
+/**
+ * Build a new named IronBee engine in a background thread.
+ *
+ * This does the same work as ib_manager_engine_create() but performs
+ * the expensive part --- creating the engine and parsing its
+ * configuration --- in a detached, low-priority thread that does not
+ * hold the manager lock.  Transactions keep acquiring the current
+ * engine while the standby engine builds; only when the standby engine
+ * is fully configured is the lock taken, briefly, to flip @a name to
+ * it.  On any build failure the current engine is left in place.
+ *
+ * Only one background build may run at a time.  Its progress, and the
+ * result of the last finished build, are reported by
+ * ib_manager_engine_build_status().
+ *
+ * @param[in] manager IronBee engine manager
+ * @param[in] name The name this engine should service.
+ * @param[in] config_file Configuration file path
+ *
+ * @sa ib_manager_engine_create()
+ *
+ * @returns Status code
+ * - IB_OK The build was started. This says nothing about its outcome.
+ * - IB_EAGAIN A background build is already running.
+ * - IB_DECLINED The manager is disabled.
+ * - IB_EALLOC If memory allocation fails.
+ * - IB_EOTHER If the thread cannot be created.
+ */
+ib_status_t DLL_PUBLIC ib_manager_engine_create_background(
+    ib_manager_t *manager,
+    const char   *name,
+    const char   *config_file
+)
+NONNULL_ATTRIBUTE(1,2,3);
+
+/**
+ * Report the state of the background engine build.
+ *
+ * While a build started by ib_manager_engine_create_background() is
+ * running this reports the engine name, the build phase the builder
+ * thread is in, and the elapsed time.  After the build finishes it
+ * reports the result of the last build.
+ *
+ * @param[in] manager IronBee engine manager
+ * @param[in] mm Memory manager to allocate @a message from.
+ * @param[out] message A one-line, human-readable status message.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If @a message cannot be allocated.
+ * - Other on locking error.
+ */
+ib_status_t DLL_PUBLIC ib_manager_engine_build_status(
+    ib_manager_t  *manager,
+    ib_mm_t        mm,
+    const char   **message
+)
+NONNULL_ATTRIBUTE(1,3);
+
 /**
  * Re-enable an manager after a call to ib_manager_disable().
  *
@@ -234,6 +234,65 @@ ib_status_t DLL_PUBLIC ib_engine_manager_control_echo_register(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Register the @c profiler command with this channel.
+ *
+ * This controls the built-in sampling profiler (see ironbee/profiler.h)
+ * with the sub-commands @c start @c [interval_usec], @c stop,
+ * @c report and @c reset. The report is folded stacks, one
+ * "tag;tag count" line per distinct activity, suitable as direct input
+ * to flamegraph.pl.
+ *
+ * @param[in] channel The channel to register this command with.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on registration failure.
+ */
+ib_status_t DLL_PUBLIC ib_engine_manager_control_profiler_register(
+    ib_engine_manager_control_channel_t *channel
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Register the @c mmprofile command with this channel.
+ *
+ * This reports on the memory manager allocation profiler (see
+ * ironbee/mm_profile.h) with the sub-commands @c report and @c reset.
+ * The report is one line per sampled allocation call site, sorted by
+ * sampled bytes descending.  Sampling requires a build with
+ * @c IB_MM_PROFILE; without it the command reports that profiling is
+ * not built in.
+ *
+ * @param[in] channel The channel to register this command with.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on registration failure.
+ */
+ib_status_t DLL_PUBLIC ib_engine_manager_control_mm_profile_register(
+    ib_engine_manager_control_channel_t *channel
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Register the @c metrics command with this channel.
+ *
+ * This returns the runtime metrics registry (see ironbee/metrics.h) in
+ * a single read: one line per counter, gauge or histogram bucket,
+ * aggregated across threads.
+ *
+ * @param[in] channel The channel to register this command with.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on registration failure.
+ */
+ib_status_t DLL_PUBLIC ib_engine_manager_control_metrics_register(
+    ib_engine_manager_control_channel_t *channel
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Register the default manager control commands.
  *
@@ -243,6 +302,10 @@ NONNULL_ATTRIBUTE(1);
  * - cleanup - cleanup old IronBee engines in the manager.
  * - engine_create \<config file\> - Create a new engine.
  *   IronBee must not be disabled for this to succeed.
+ * - tune \<setting\> \<value\> - Override a runtime-tunable setting
+ *   (see ib_engine_tune_set()).
+ * - engine \<command\> [args] - Run a runtime control command registered
+ *   with the current engine (see ib_engine_ctlcmd_register()).
  *
  * @param[in] channel The channel to register this command with.
  *
@@ -29,6 +29,7 @@
 #include <ironbee/clock.h>
 #include <ironbee/hash.h>
 #include <ironbee/mm.h>
+#include <ironbee/mm_budget.h>
 #include <ironbee/mpool.h>
 #include <ironbee/parsed_content.h>
 #include <ironbee/rule_defs.h>
@@ -38,6 +39,7 @@
 #include <ironbee/uuid.h>
 #include <ironbee/var.h>
 
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -249,6 +251,15 @@ struct ib_tx_limits_t {
      * A value of < 0 indicates no limit.
      */
     ssize_t response_body_log_limit;
+
+    /**
+     * Buffered body bytes, per stream, kept in pump buffers before
+     * further bytes spill to an mmap'd region released at transaction
+     * end.
+     *
+     * A value of < 0 disables spilling.
+     */
+    ssize_t body_buffer_spill_threshold;
 };
 typedef struct ib_tx_limits_t ib_tx_limits_t;
 
@@ -269,14 +280,32 @@ typedef struct ib_block_info_t ib_block_info_t;
 
 /** Transaction Structure */
 struct ib_tx_t {
+    /*
+     * Hot section.
+     *
+     * These fields are read on every phase and rule evaluation (flags
+     * alone is checked by the rule engine many times per phase) and are
+     * kept together at the head of the struct so they share as few cache
+     * lines as possible.  Keep new per-evaluation fields here; everything
+     * touched once or twice per transaction belongs below.
+     */
     ib_engine_t        *ib;              /**< Engine handle */
-    ib_mpool_t         *mp;              /**< Transaction memory pool */
+    ib_flags_t          flags;           /**< Transaction flags */
+    ib_var_store_t     *var_store;       /**< Var Store */
+    ib_context_t       *ctx;             /**< Config context */
+    ib_rule_exec_t     *rule_exec;       /**< Rule engine execution object */
+    ib_conn_t          *conn;            /**< Connection */
     ib_mm_t             mm;              /**< Transaction memory manager */
+
+    /*
+     * Cold section: identification, audit, timing, parsed message data
+     * and per-transaction bookkeeping.
+     */
+    ib_mpool_t         *mp;              /**< Transaction memory pool */
+    ib_mm_budget_t     *mm_budget;       /**< Budget behind @c mm, or NULL
+                                              when no TxMemoryLimit is set */
     char                id[IB_UUID_LENGTH]; /**< ID: @sa ib_tx_generate_id() */
-    ib_conn_t          *conn;            /**< Connection */
-    ib_context_t       *ctx;             /**< Config context */
     void               *sctx;            /**< Server context */
-    ib_var_store_t     *var_store;       /**< Var Store */
     char                audit_log_id[IB_UUID_LENGTH]; /**< Auditlog UUID, if available */
     ib_list_t          *logevents;       /**< Log events */
     ib_array_t         *module_data;     /**< Per-module data */
@@ -299,11 +328,8 @@ struct ib_tx_t {
     const char         *hostname;        /**< Hostname used in the request */
     const char         *remote_ipstr;    /**< Transaction remote IP as string */
     const char         *path;            /**< Path used in the request */
-    ib_flags_t          flags;           /**< Transaction flags */
     ib_num_t            auditlog_parts;  /**< Audit log parts */
 
-    ib_rule_exec_t     *rule_exec;       /**< Rule engine execution object */
-
     /**
      * Limits on tx.
      *
@@ -353,6 +379,24 @@ struct ib_tx_t {
     ib_block_info_t     block_info;      /**< Block info if is_blocked */
 };
 
+/*
+ * Keep the ib_tx_t hot section within the first cache line on LP64
+ * platforms.  If one of these fires, a field was added to or moved into
+ * the hot section; either make room by demoting a colder field or widen
+ * the section deliberately.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__cplusplus) && defined(__LP64__)
+_Static_assert(
+    offsetof(ib_tx_t, flags) < 64,
+    "ib_tx_t flags left the first cache line"
+);
+_Static_assert(
+    offsetof(ib_tx_t, conn) + sizeof(ib_conn_t *) <= 64,
+    "ib_tx_t hot section exceeds one cache line"
+);
+#endif
+
 
 /** @} */
 
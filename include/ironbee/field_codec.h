@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_FIELD_CODEC_H_
+#define _IB_FIELD_CODEC_H_
+
+/**
+ * @file
+ * @brief IronBee --- Binary Field Collection Codec
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/field.h>
+#include <ironbee/list.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilFieldCodec Binary Field Collection Codec
+ * @ingroup IronBeeUtil
+ *
+ * A compact binary encoding of lists of @ref ib_field_t, built for
+ * persistence round trips that are too hot for JSON.
+ *
+ * The format is a 2 byte header (a marker byte and a format version)
+ * followed by the fields. Each field is a type tag, a name, and a
+ * type-specific value. Lengths, counts and numbers are varints, signed
+ * numbers are zigzag coded, and repeated field names are interned: a
+ * name is written once and later fields carry only its table index, so
+ * large collections of same-named records stay small.
+ *
+ * Number, float, time, NUL-string, byte-string and list fields are
+ * supported, with lists nesting arbitrarily. Decoding a buffer whose
+ * version byte is not the current version fails cleanly with
+ * IB_EINVAL so the caller can fall back to another codec.
+ *
+ * @{
+ */
+
+/**
+ * The marker value of the first byte of every encoded buffer.
+ *
+ * Callers that accept several formats can sniff this byte to decide
+ * whether a buffer (or file) holds codec output.
+ */
+#define IB_FIELD_CODEC_MARKER 0xf5
+
+/**
+ * The current encoding version, the second byte of every buffer.
+ */
+#define IB_FIELD_CODEC_VERSION 1
+
+/**
+ * Encode a list of fields into a binary buffer.
+ *
+ * @param[in] mm Memory manager @a obuf is allocated from.
+ * @param[in] list List of fields to encode.
+ * @param[out] obuf The encoded buffer.
+ * @param[out] olen Length of @a obuf.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - IB_EINVAL If a field has a type this codec does not support.
+ */
+ib_status_t DLL_PUBLIC ib_field_codec_encode(
+    ib_mm_t           mm,
+    const ib_list_t  *list,
+    uint8_t         **obuf,
+    size_t           *olen
+)
+NONNULL_ATTRIBUTE(2, 3, 4);
+
+/**
+ * Decode a binary buffer into a list of fields.
+ *
+ * @param[in] mm Memory manager decoded fields are allocated from.
+ * @param[in] data_in The encoded buffer.
+ * @param[in] dlen_in Length of @a data_in.
+ * @param[out] list_out Decoded fields are appended to this.
+ * @param[out] error Pointer to error string (or NULL).
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - IB_EINVAL If the buffer is not this codec's format, is from
+ *   another version, or is truncated or corrupt.
+ */
+ib_status_t DLL_PUBLIC ib_field_codec_decode(
+    ib_mm_t         mm,
+    const uint8_t  *data_in,
+    size_t          dlen_in,
+    ib_list_t      *list_out,
+    const char    **error
+)
+NONNULL_ATTRIBUTE(2, 4);
+
+/**
+ * @} IronBeeUtilFieldCodec
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_FIELD_CODEC_H_ */
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_FLIGHTREC_H_
+#define _IB_FLIGHTREC_H_
+
+/**
+ * @file
+ * @brief IronBee --- Flight Recorder
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/clock.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilFlightRec Flight Recorder
+ * @ingroup IronBeeUtil
+ *
+ * An always-on, per-thread ring buffer of compact trace records.
+ *
+ * Recording overwrites a fixed-size slot in a ring owned by the
+ * calling thread, with no locking and no allocation, so it is cheap
+ * enough to leave on for every transaction. The ring is only rendered
+ * when a transaction turns out to be worth diagnosing (slow or
+ * blocked), giving flight-recorder detail without paying logging costs
+ * on the fast majority of transactions.
+ *
+ * A transaction is processed on one thread, so a dump taken while
+ * finishing a transaction renders that transaction's records.
+ *
+ * @{
+ */
+
+/** Records kept per thread. Older records are overwritten. */
+#define IB_FLIGHTREC_RECORDS 512
+
+/** What a trace record describes. */
+typedef enum ib_flightrec_kind_t {
+    IB_FLIGHTREC_STATE, /**< A state dispatch from state_notify.c. */
+    IB_FLIGHTREC_RULE,  /**< A rule execution start. */
+    IB_FLIGHTREC_PUMP,  /**< A stream pump flush or close. */
+} ib_flightrec_kind_t;
+
+/**
+ * Record one trace record in the calling thread's ring.
+ *
+ * @param[in] kind What the record describes.
+ * @param[in] label Static label; not copied, so it must outlive the
+ *            ring (state names, rule ids and literals, in practice).
+ * @param[in] value Kind-specific value, e.g. a byte count. Zero when
+ *            there is nothing to say.
+ */
+void DLL_PUBLIC ib_flightrec_record(
+    ib_flightrec_kind_t  kind,
+    const char          *label,
+    uint64_t             value
+);
+
+/**
+ * Render the calling thread's ring, oldest first, as text.
+ *
+ * Records older than @a since are skipped. Each line is
+ * `+<offset>us <kind> <label>`, where the offset is relative to
+ * @a since, followed by the record's value when it is non-zero.
+ *
+ * @param[in] mm Memory manager to allocate @a dump from.
+ * @param[in] since Only render records at or after this time,
+ *            typically the transaction start time.
+ * @param[out] dump The NUL-terminated dump. Empty when nothing was
+ *             recorded since @a since.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_flightrec_dump(
+    ib_mm_t      mm,
+    ib_time_t    since,
+    const char **dump
+);
+
+/** @} IronBeeUtilFlightRec */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_FLIGHTREC_H_ */
@@ -27,6 +27,7 @@
 
 #include <ironbee/build.h>
 #include <ironbee/ip.h>
+#include <ironbee/mm.h>
 #include <ironbee/types.h>
 
 #include <string.h>
@@ -144,6 +145,11 @@ typedef struct ib_ipset6_t ib_ipset6_t;
  * Patricia tries would also allow for rapid insertion and removal which is
  * impossible with using sorted arrays.  However, the latter is not needed,
  * patricia tries are more complicated, and often use more time and space.
+ * Experience with very large sets (hundreds of thousands of networks) has
+ * since softened this position: ib_ipset4_init_ex() can additionally build a
+ * path-compressed binary trie over the entry arrays, trading memory for
+ * \f$O(\textrm{address length})\f$ lookups.  The sorted arrays remain the
+ * canonical representation; the trie is an optional index over them.
  *
  * Why two arrays instead of a single array of both positive and negative
  * entries?  A single array would change the runtime complexity from
@@ -164,12 +170,18 @@ typedef struct ib_ipset6_t ib_ipset6_t;
  * bound routines, so these would have to be implemented.  As \f$K\f$ is
  * expected to be low, the code complexity was deemed too expensive.
  */
+typedef struct ib_ipset4_node_t ib_ipset4_node_t;
+typedef struct ib_ipset6_node_t ib_ipset6_node_t;
+
 struct ib_ipset4_t
 {
     ib_ipset4_entry_t *positive;
     size_t             num_positive;
     ib_ipset4_entry_t *negative;
     size_t             num_negative;
+    /* Optional trie indexes; NULL unless built by ib_ipset4_init_ex(). */
+    const ib_ipset4_node_t *positive_trie;
+    const ib_ipset4_node_t *negative_trie;
 };
 
 /**
@@ -183,9 +195,29 @@ struct ib_ipset6_t
     size_t             num_positive;
     ib_ipset6_entry_t *negative;
     size_t             num_negative;
+    /* Optional trie indexes; NULL unless built by ib_ipset6_init_ex(). */
+    const ib_ipset6_node_t *positive_trie;
+    const ib_ipset6_node_t *negative_trie;
 };
 
 /** @endcond */
+
+/**
+ * No options; behave as the plain init routines.
+ */
+#define IB_IPSET_NONE (0x0)
+
+/**
+ * Build a path-compressed binary trie index over the entry arrays.
+ *
+ * Queries then descend the trie bit by bit instead of binary searching,
+ * giving \f$O(\textrm{address length})\f$ lookups independent of the number
+ * of entries.  For the negative networks, which are only ever tested for
+ * membership, sibling networks that together cover their parent network are
+ * aggregated so the descent can stop early.  Positive entries are never
+ * aggregated as each carries its own data and identity.
+ */
+#define IB_IPSET_TRIE (1 << 0)
 /**
  * Initialize an IPv4 set.
  *
@@ -225,6 +257,52 @@ ib_status_t ib_ipset4_init(
     size_t             num_positive
 );
 
+/**
+ * As ib_ipset4_init(), with optional acceleration structures.
+ *
+ * Behaves exactly as ib_ipset4_init() and additionally builds any indexes
+ * requested via @a flags from @a mm.  With @ref IB_IPSET_TRIE, a
+ * path-compressed binary trie is built over the (still claimed and sorted)
+ * entry arrays and ib_ipset4_query() descends it instead of binary
+ * searching, making query time \f$O(\textrm{address length})\f$ regardless
+ * of the number of entries.  The trie uses \f$O(N + P)\f$ additional memory.
+ *
+ * Unlike ib_ipset4_init(), this function allocates (from @a mm) when
+ * @a flags requests an index.  The memory behind @a mm must survive at least
+ * as long as @a set.
+ *
+ * ib_ipset4_query() results are the same with and without the index: the
+ * trie locates the most specific matching entry and the outputs are then
+ * derived from the sorted array around it, so [@c *out_general_entry,
+ * @c *out_specific_entry] remains a contiguous array of matching entries.
+ *
+ * @param[out]    set          Set to initialize.
+ * @param[in,out] negative     Negative networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_negative Number of entries in @a negative.
+ * @param[in,out] positive     Positive networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_positive Number of entries in @a positive.
+ * @param[in]     mm           Memory manager to build indexes from.  Only
+ *                             used if @a flags requests an index.
+ * @param[in]     flags        @ref IB_IPSET_NONE or @ref IB_IPSET_TRIE.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL as ib_ipset4_init().
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER if sorting failed; see errno for code.
+ */
+ib_status_t ib_ipset4_init_ex(
+    ib_ipset4_t       *set,
+    ib_ipset4_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset4_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm,
+    ib_flags_t         flags
+);
+
 /**
  * Query @a set for @a ip.
  *
@@ -283,6 +361,23 @@ ib_status_t ib_ipset6_init(
     size_t             num_positive
 );
 
+/**
+ * As ib_ipset4_init_ex() except for v6 addresses.
+ *
+ * See ib_ipset4_init_ex() for documentation.
+ *
+ * @sa ib_ipset4_init_ex()
+ */
+ib_status_t ib_ipset6_init_ex(
+    ib_ipset6_t       *set,
+    ib_ipset6_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset6_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm,
+    ib_flags_t         flags
+);
+
 /**
  * As ib_ipset4_query() except for v6 addresses.
  *
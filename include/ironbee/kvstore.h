@@ -175,6 +175,63 @@ ib_status_t ib_kvstore_set(
     const ib_kvstore_key_t *key,
     ib_kvstore_value_t *val);
 
+/**
+ * Get many values in one batch.
+ *
+ * Implementations that can batch or pipeline requests, such as the
+ * riak store, fetch all keys in one round over pooled connections.
+ * Other implementations fall back to one ib_kvstore_get() per key.
+ *
+ * A key that is not in the store is not an error: its entry in
+ * @a vals is set to NULL and the batch continues.
+ *
+ * @param[in] kvstore The key-value store object.
+ * @param[in] merge_policy The function pointer that merges colliding keys.
+ *            If null then the @c default_merge_policy in kvstore is used.
+ * @param[in] mm The resulting values are allocated from this.
+ * @param[in] keys The keys to get.
+ * @param[in] count The length of @a keys and @a vals.
+ * @param[out] vals Caller-allocated array of @a count entries. Entry i
+ *             receives the merged value stored at keys[i], or NULL if
+ *             the key is absent.
+ * @return
+ *   - IB_OK on success, including when some keys are absent.
+ *   - IB_EALLOC on memory allocation error.
+ *   - Implementation-defined other value.
+ */
+ib_status_t ib_kvstore_mget(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    ib_mm_t                        mm,
+    const ib_kvstore_key_t *const *keys,
+    size_t                         count,
+    ib_kvstore_value_t           **vals);
+
+/**
+ * Set many values in one batch.
+ *
+ * Implementations that can batch or pipeline requests, such as the
+ * riak store, write all keys in one round over pooled connections.
+ * Other implementations fall back to one ib_kvstore_set() per key.
+ *
+ * @param[in] kvstore The key-value store object.
+ * @param[in] merge_policy The function pointer that merges colliding keys.
+ *            If null then the @c default_merge_policy in kvstore is used.
+ * @param[in] keys The keys to set.
+ * @param[in] vals The value to write for each key in @a keys.
+ * @param[in] count The length of @a keys and @a vals.
+ * @return
+ *   - IB_OK on success.
+ *   - IB_EALLOC on memory allocation error.
+ *   - Implementation-defined other value.
+ */
+ib_status_t ib_kvstore_mset(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    const ib_kvstore_key_t *const *keys,
+    ib_kvstore_value_t *const     *vals,
+    size_t                         count);
+
 /**
  * Remove all stored values under the given key.
  *
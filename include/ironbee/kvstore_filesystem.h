@@ -21,6 +21,8 @@
 #include <ironbee/kvstore.h>
 #include <ironbee/types.h>
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -45,6 +47,25 @@ struct ib_kvstore_filesystem_server_t {
     size_t directory_length; /**< Cache the string length of the directory. */
     mode_t fmode; /**< The mode of created files. */
     mode_t dmode; /**< The mode of created directories. */
+
+    /**
+     * Number of key-hash characters used as a shard subdirectory.
+     *
+     * When non-zero, key directories are placed under
+     * @c &lt;directory&gt;/&lt;shard&gt;/ where the shard name is the first
+     * @c fanout characters of the hashed key.  This bounds the number of
+     * entries in any one directory, which keeps directory lookups fast
+     * for stores with many keys.  0 (the default) keeps the original
+     * flat layout.
+     */
+    size_t fanout;
+
+    pthread_t sweeper;         /**< Background expiration sweeper thread. */
+    bool sweeper_running;      /**< True if @c sweeper was started. */
+    bool sweeper_stop;         /**< Set to ask @c sweeper to exit. */
+    ib_time_t sweeper_interval; /**< Time between sweeps in useconds. */
+    pthread_mutex_t sweeper_lock; /**< Guards @c sweeper_cond. */
+    pthread_cond_t sweeper_cond;  /**< Signaled to wake @c sweeper early. */
 };
 typedef struct ib_kvstore_filesystem_server_t ib_kvstore_filesystem_server_t;
 
@@ -56,6 +77,7 @@ typedef struct ib_kvstore_filesystem_server_t ib_kvstore_filesystem_server_t;
  * @returns
  *   - IB_OK on success
  *   - IB_EALLOC on memory allocation failure using malloc.
+ *   - IB_EOTHER if the sweeper synchronization objects cannot be made.
  */
 ib_status_t ib_kvstore_filesystem_init(
     ib_kvstore_t *kvstore,
@@ -76,6 +98,45 @@ void ib_kvstore_filesystem_set_file_mode(ib_kvstore_t *kvstore, mode_t mode);
 void ib_kvstore_filesystem_set_directory_mode(
     ib_kvstore_t *kvstore,
     mode_t mode);
+
+/**
+ * Set the directory fanout used to shard key directories.
+ *
+ * Keys are already hashed to a filesystem-safe string to name their
+ * directory.  A non-zero fanout places each key directory under a
+ * subdirectory named by the first @a fanout characters of that hash,
+ * spreading keys over up to 16^fanout shards.  Change this only on an
+ * empty store; existing entries are not relocated.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] fanout Number of hash characters to shard by. Values
+ *            greater than 8 are clamped to 8. 0 disables sharding.
+ */
+void ib_kvstore_filesystem_set_fanout(ib_kvstore_t *kvstore, size_t fanout);
+
+/**
+ * Start a background thread that removes expired entries.
+ *
+ * Without a sweeper, expired files are unlinked by whichever reader
+ * happens upon them, putting deletion and directory cleanup on the
+ * request path.  With a sweeper running, readers still ignore expired
+ * entries (expiration is encoded in the file name) but leave removal to
+ * this thread.
+ *
+ * The sweeper is stopped and joined when the kvstore is destroyed.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] interval_seconds Seconds between sweeps. Must be greater
+ *            than 0.
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EINVAL if @a interval_seconds is 0 or a sweeper is running.
+ *   - IB_EOTHER if the thread cannot be created.
+ */
+ib_status_t ib_kvstore_filesystem_sweeper_start(
+    ib_kvstore_t *kvstore,
+    uint32_t interval_seconds);
+
  /**
   * @}
   */
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_JOURNAL_H
+#define __IRONBEE__KVSTORE_JOURNAL_H
+
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+#include <pthread.h>
+
+#include <sys/types.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value Journaling Store Interface
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ * @{
+ */
+
+/**
+ * The journal server object.
+ *
+ * This store decorates another key-value store. Writes and removes are
+ * appended to a segment-rotated journal before being forwarded, with
+ * group-commit fsync on an interval rather than per operation. On
+ * connect, surviving journal segments are replayed into the backing
+ * store, so writes the backing store lost in a crash are recovered at
+ * sequential-write cost.
+ */
+struct ib_kvstore_journal_server_t {
+    ib_kvstore_t *backing;    /**< The decorated store. Owned by this. */
+    char         *directory;  /**< Directory holding journal segments. */
+    int           fd;         /**< Current segment, or -1. */
+    uint64_t      seq;        /**< Sequence number of the current segment. */
+    size_t        segment_bytes;  /**< Bytes appended to current segment. */
+    size_t        segment_size;   /**< Rotation threshold in bytes. */
+    ib_time_t     sync_interval;  /**< Useconds between group fsyncs. */
+    ib_time_t     last_sync;      /**< Time of the last fsync. */
+    pthread_mutex_t lock;         /**< Guards appends and rotation. */
+};
+typedef struct ib_kvstore_journal_server_t ib_kvstore_journal_server_t;
+
+/**
+ * Initializes a journaling kvstore decorating @a backing.
+ *
+ * The journal takes ownership of @a backing: connect, disconnect and
+ * destroy are forwarded to it. @a backing must be initialized and not
+ * connected; connecting the journal connects the backing store, then
+ * replays and removes surviving journal segments.
+ *
+ * @param[out] kvstore Initialized with the journal server and callbacks.
+ * @param[in] backing The store to decorate.
+ * @param[in] directory The directory journal segments are written to.
+ *            Created on connect if absent; its parent must exist.
+ * @param[in] sync_interval_seconds At most one fsync per this many
+ *            seconds, issued by whichever writer crosses the interval.
+ *            0 fsyncs on every append.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ *   - IB_EOTHER if the lock cannot be initialized.
+ */
+ib_status_t ib_kvstore_journal_init(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_t *backing,
+    const char   *directory,
+    uint32_t      sync_interval_seconds);
+
+/**
+ * Set the segment size at which the journal rotates to a new file.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] size Rotation threshold in bytes.
+ */
+void ib_kvstore_journal_set_segment_size(ib_kvstore_t *kvstore, size_t size);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_JOURNAL_H */
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_REPLICA_H
+#define __IRONBEE__KVSTORE_REPLICA_H
+
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+#include <pthread.h>
+
+#include <stdbool.h>
+
+/**
+ * @file
+ * @brief IronBee --- Write-Behind Replicated Key-Value Store Interface
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ * @{
+ */
+
+/** A pending write awaiting propagation. Private to the implementation. */
+typedef struct ib_kvstore_replica_delta_t ib_kvstore_replica_delta_t;
+
+/**
+ * The replica server object.
+ *
+ * This store composes two other key-value stores: a local store that is
+ * authoritative for every read and write on this node, and a remote
+ * store shared between nodes. Writes land in the local store
+ * immediately and are queued; a background thread drains the queue on
+ * an interval and propagates the writes to the remote store. Reads are
+ * served locally, falling back to the remote store on a miss and
+ * seeding the local copy.
+ *
+ * Writes whose old and new values are both decimal integers are
+ * propagated as deltas and added to the remote value, so counters
+ * accumulate contributions from every node instead of overwriting each
+ * other; the remote total is pulled back into the local store on each
+ * propagation. Other values propagate as written, last writer wins.
+ */
+struct ib_kvstore_replica_server_t {
+    ib_kvstore_t *local;          /**< Authoritative local store. Owned. */
+    ib_kvstore_t *remote;         /**< Shared remote store. Owned. */
+    ib_time_t     flush_interval; /**< Useconds between propagations. */
+    size_t        max_pending;    /**< Queue bound; exceeding it flushes. */
+
+    ib_kvstore_replica_delta_t *head; /**< Oldest pending delta. */
+    ib_kvstore_replica_delta_t *tail; /**< Newest pending delta. */
+    size_t                      pending; /**< Queued delta count. */
+
+    pthread_mutex_t lock;    /**< Guards the queue and running. */
+    pthread_cond_t  cond;    /**< Wakes the flusher thread. */
+    pthread_t       flusher; /**< The propagation thread. */
+    bool            running; /**< True while the flusher runs. */
+};
+typedef struct ib_kvstore_replica_server_t ib_kvstore_replica_server_t;
+
+/**
+ * Initializes a replicating kvstore over @a local and @a remote.
+ *
+ * The replica takes ownership of both stores: connect, disconnect and
+ * destroy are forwarded to them. Both must be initialized and not
+ * connected. Connecting the replica connects both stores and starts
+ * the propagation thread; disconnecting stops the thread after a final
+ * propagation.
+ *
+ * Propagation is best effort: the remote store may briefly trail the
+ * local one by up to @a flush_interval_seconds plus one retry period,
+ * and concurrent counter updates from many nodes converge rather than
+ * being exact at every instant. The local store alone decides this
+ * node's behavior, so a slow or unreachable remote store never stalls
+ * a transaction; queued deltas are retried on the next interval.
+ *
+ * @param[out] kvstore Initialized with the replica server and callbacks.
+ * @param[in] local The node-local store. Typically the shared memory
+ *            store, so worker processes share the authoritative copy.
+ * @param[in] remote The store shared between nodes.
+ * @param[in] flush_interval_seconds Seconds between propagations of
+ *            queued writes. 0 propagates as soon as the flusher wakes.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ *   - IB_EOTHER if the lock or condition cannot be initialized.
+ */
+ib_status_t ib_kvstore_replica_init(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_t *local,
+    ib_kvstore_t *remote,
+    uint32_t      flush_interval_seconds);
+
+/**
+ * Synchronously propagate all queued writes to the remote store.
+ *
+ * @param[in] kvstore Key-Value store.
+ *
+ * @returns
+ * - IB_OK if the queue drained.
+ * - IB_EOTHER if the remote store rejected a write; the remaining
+ *   deltas stay queued.
+ */
+ib_status_t ib_kvstore_replica_flush(ib_kvstore_t *kvstore);
+
+/**
+ * Set the queue bound at which a write propagates inline.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] max_pending The bound. The default is 4096.
+ */
+void ib_kvstore_replica_set_max_pending(
+    ib_kvstore_t *kvstore,
+    size_t        max_pending);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_REPLICA_H */
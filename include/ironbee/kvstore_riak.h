@@ -52,7 +52,19 @@ struct ib_kvstore_riak_server_t {
     char *bucket_url;      /**< riak_url with the bucket appended. */
     size_t bucket_url_len; /**< Length of bucket_url. */
     ib_mm_t mm;            /**< Memory manager. */
-    CURL *curl;            /**< Curl context for web requests. */
+    CURL *curl;            /**< Curl context for single web requests. */
+
+    /**
+     * Curl multi handle driving batched (mget/mset) requests.
+     *
+     * Pooled easy handles are attached to this, so batch operations
+     * run concurrently and reuse kept-alive connections instead of
+     * paying connection setup per operation.
+     */
+    CURLM *multi;
+    CURL **pool;           /**< Pooled easy handles for batch requests. */
+    size_t pool_size;      /**< Number of handles in pool; the maximum
+                                number of requests in flight. */
     char *client_id;       /**< The Riak client id. */
     char *vclock;          /**< NULL or vector clock for queries to riak. */
     char *etag;            /**< NULL or etag for queries to riak. */
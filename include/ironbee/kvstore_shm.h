@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_SHM_H
+#define __IRONBEE__KVSTORE_SHM_H
+
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value Shared Memory Store Interface
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ * @{
+ */
+
+/**
+ * The maximum key length a shared memory store record can hold.
+ */
+#define IB_KVSTORE_SHM_MAX_KEY 256
+
+/**
+ * The maximum type name length a shared memory store record can hold.
+ */
+#define IB_KVSTORE_SHM_MAX_TYPE 32
+
+/**
+ * The shared memory server object.
+ */
+struct ib_kvstore_shm_server_t {
+    const char *file;         /**< The file backing the mapped segment. */
+    size_t      num_buckets;  /**< Number of buckets in the table. */
+    size_t      data_size;    /**< Maximum value length per record. */
+    size_t      segment_size; /**< Total size of the mapped segment. */
+    int         fd;           /**< Open descriptor of the backing file. */
+    void       *segment;      /**< The mapped segment. NULL when closed. */
+};
+typedef struct ib_kvstore_shm_server_t ib_kvstore_shm_server_t;
+
+/**
+ * Initializes kvstore that stores values in a shared, mapped segment.
+ *
+ * The store is a fixed-size bucket table held in a file-backed memory
+ * mapping shared by all processes that open the same @a file. Readers
+ * take no locks; each record carries a sequence counter (seqlock) that
+ * readers use to validate their copy, so lookups never block on
+ * concurrent writers. Writers serialize on the backing file's lock,
+ * which the kernel releases if a writer dies. Records expire by their
+ * value expiration and expired slots
+ * are reused by subsequent writes.
+ *
+ * If the segment is new, from a different layout version, or was left
+ * half-initialized by a crash, it is rebuilt empty. A record left
+ * mid-write by a crashed writer is skipped by readers and reclaimed by
+ * the next write to its slot.
+ *
+ * Keys longer than @ref IB_KVSTORE_SHM_MAX_KEY and values longer than
+ * @a data_size are rejected at write time with IB_EINVAL.
+ *
+ * @param[out] kvstore Initialized with kvserver and some defaults.
+ * @param[in] file The file to map the segment from, created if absent.
+ * @param[in] num_buckets The number of buckets in the table.
+ * @param[in] data_size The maximum value length, in bytes, per record.
+ * @returns
+ *   - IB_OK on success
+ *   - IB_EINVAL if @a num_buckets or @a data_size is zero.
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ */
+ib_status_t ib_kvstore_shm_init(
+    ib_kvstore_t *kvstore,
+    const char   *file,
+    size_t        num_buckets,
+    size_t        data_size);
+
+ /**
+  * @}
+  */
+#endif /* __IRONBEE__KVSTORE_SHM_H */
@@ -65,6 +65,7 @@ struct ib_list_node_t {
 struct ib_list_t {
     ib_mm_t mm;
     IB_LIST_GEN_REQ_FIELDS(ib_list_node_t);       /* Required fields */
+    ib_list_node_t *free_nodes;               /**< Recycled/spare nodes */
 };
 /** @endcond */
 
@@ -308,6 +309,30 @@ ib_status_t DLL_PUBLIC ib_list_copy(const ib_list_t *src,
                                     ib_mm_t mm,
                                     ib_list_t **pdest);
 
+/**
+ * Snapshot the data pointers of @a list into a contiguous array.
+ *
+ * The array holds ib_list_elements(@a list) entries in list order and is
+ * allocated from @a mm.  It is a snapshot: later changes to @a list are
+ * not reflected in it.  This is intended for lists that are fixed after
+ * configuration but iterated on hot paths, where a linear scan of an
+ * array beats chasing node pointers.
+ *
+ * @param[in]  list List to snapshot
+ * @param[in]  mm Memory manager to allocate the array from
+ * @param[out] parray Address which the array is written; NULL if @a list
+ *             is empty
+ *
+ * @return
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ */
+ib_status_t DLL_PUBLIC ib_list_to_array(
+    const ib_list_t   *list,
+    ib_mm_t            mm,
+    void            ***parray
+) NONNULL_ATTRIBUTE(1, 3);
+
 /**
  * Insert an element into a list and the given index.
  *
@@ -30,6 +30,7 @@
 #include <ironbee/logger.h>
 
 #include <stdarg.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,8 +42,29 @@ extern "C" {
  * @{
  */
 
+/**
+ * Would a message at @a level be logged at all?
+ *
+ * The logging macros below consult this before evaluating their format
+ * arguments, so arguments to a filtered message are never computed.
+ *
+ * @param ib IronBee engine.
+ * @param level Log level of the prospective message.
+ *
+ * @returns True if a message at @a level would reach the log.
+ */
+bool DLL_PUBLIC ib_log_would_log(
+    const ib_engine_t *ib,
+    ib_logger_level_t  level
+);
+
 /** Log Generic */
-#define ib_log(ib, lvl, ...) ib_log_ex((ib), (lvl), __FILE__, __func__, __LINE__, __VA_ARGS__)
+#define ib_log(ib, lvl, ...) \
+    do { \
+        if (ib_log_would_log((ib), (lvl))) { \
+            ib_log_ex((ib), (lvl), __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 /** Log Emergency */
 #define ib_log_emergency(ib, ...) ib_log((ib), IB_LOG_EMERGENCY, __VA_ARGS__)
 /** Log Alert */
@@ -78,7 +100,12 @@ extern "C" {
 #endif
 
 /** Log Generic (Transaction form) */
-#define ib_log_tx(tx, lvl, ...) ib_log_tx_ex(tx,  (lvl), __FILE__, __func__, __LINE__, __VA_ARGS__)
+#define ib_log_tx(tx, lvl, ...) \
+    do { \
+        if (ib_log_would_log((tx)->ib, (lvl))) { \
+            ib_log_tx_ex((tx), (lvl), __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 /** Log Emergency (Transaction form) */
 #define ib_log_emergency_tx(tx, ...) ib_log_tx(tx,  IB_LOG_EMERGENCY, __VA_ARGS__)
 /** Log Alert (Transaction form) */
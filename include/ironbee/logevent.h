@@ -76,6 +76,15 @@ struct ib_logevent_t {
     const char              *msg;        /**< Event message */
     ib_list_t               *tags;       /**< List of tag strings */
     uint32_t                 event_id;   /**< Event ID */
+
+    /**
+     * Events suppressed behind this one by the event policy.
+     *
+     * Counts duplicate events merged into this one and events dropped
+     * by sampling or rate limiting while this was the transaction's
+     * most recent surviving event.
+     */
+    uint32_t                 suppressed_count;
     ib_logevent_type_t       type;       /**< Event type */
     ib_logevent_action_t     rec_action; /**< Recommended action */
     ib_logevent_suppress_t   suppress;   /**< Suppress this event. */
@@ -100,6 +109,45 @@ ib_status_t DLL_PUBLIC ib_logevent_add(
     ib_tx_t                *tx,
     ib_logevent_t          *le);
 
+/**
+ * Callback finishing a lazily constructed event.
+ *
+ * See ib_logevent_add_lazy().
+ *
+ * @param[in,out] le Event to populate.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns Status code
+ */
+typedef ib_status_t (*ib_logevent_populate_fn_t)(
+    ib_logevent_t          *le,
+    void                   *cbdata);
+
+/**
+ * As ib_logevent_add(), but fill in the expensive parts of @a le lazily.
+ *
+ * The event policy (duplicate aggregation, sampling, rate limiting) only
+ * examines the rule id and type of @a le; if it suppresses the event,
+ * @a fn never runs.  Otherwise @a fn is called exactly once, before the
+ * event is queued and the logevent handlers are notified, and should
+ * populate the event's message, data and tags.
+ *
+ * @note This function generates a logevent event.
+ * see ib_engine_notify_logevent().
+ *
+ * @param[in,out] tx Transaction
+ * @param[in] le Event holding at least its rule id and type
+ * @param[in] fn Callback populating @a le if it survives the policy
+ * @param[in] cbdata Callback data for @a fn
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_logevent_add_lazy(
+    ib_tx_t                   *tx,
+    ib_logevent_t             *le,
+    ib_logevent_populate_fn_t  fn,
+    void                      *cbdata);
+
 /**
  * Remove an event from the queue before it is logged.
  *
@@ -85,10 +85,27 @@ typedef struct ib_logformat_item_t {
     } item;
 } ib_logformat_item_t;
 
+/**
+ * Compiled format item.
+ *
+ * Built once at the end of ib_logformat_parse() from the item list.
+ * Literal items have their string pointer and length pre-resolved so that
+ * rendering is a straight memcpy() with no per-item branching on the
+ * short/long literal representation.
+ */
+typedef struct ib_logformat_citem_t {
+    ib_logformat_itype_t  itype;       /**< Item type */
+    const char           *literal;     /**< Resolved literal (literals only) */
+    size_t                literal_len; /**< Literal length (literals only) */
+    ib_logformat_field_t  field;       /**< Field data (format items only) */
+} ib_logformat_citem_t;
+
 struct ib_logformat_t {
     ib_mm_t      mm;
     char        *format;
     ib_list_t   *items;          /* List of pointers to ib_logformat_item_t */
+    const ib_logformat_citem_t *citems; /* Compiled item array */
+    size_t       num_items;      /* Number of entries in citems */
 };
 
 /**
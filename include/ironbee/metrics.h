@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_METRICS_H_
+#define _IB_METRICS_H_
+
+/**
+ * @file
+ * @brief IronBee --- Runtime Metrics Registry
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilMetrics Runtime Metrics
+ * @ingroup IronBeeUtil
+ *
+ * A process-wide registry of named counters, high-water gauges and
+ * power-of-two histograms.
+ *
+ * Metrics are registered once, typically lazily from the site that
+ * updates them, and updated from hot paths. Updates write to a cell
+ * block owned by the calling thread, so they never contend: an update
+ * is a plain read-modify-write of a thread-local 64-bit cell. Reports
+ * sum the cells across all threads; a report racing updates may be off
+ * by in-flight increments, which is acceptable for monitoring.
+ *
+ * Reports are served in one read through the engine manager control
+ * channel's @c metrics command (see engine_manager_control_channel.h).
+ *
+ * @{
+ */
+
+/** Maximum number of registered metrics. */
+#define IB_METRICS_MAX_METRICS 128
+
+/** Cells per thread block. Limits total registered metric width. */
+#define IB_METRICS_MAX_CELLS 1024
+
+/** Buckets per histogram; bucket n counts values below 2^n. */
+#define IB_METRICS_HIST_BUCKETS 32
+
+/** The kinds of metric that may be registered. */
+typedef enum ib_metric_type_t {
+    IB_METRIC_COUNTER,   /**< Monotonic count of events. */
+    IB_METRIC_GAUGE_MAX, /**< High-water mark of an observed value. */
+    IB_METRIC_HISTOGRAM, /**< Power-of-two buckets of observed values. */
+} ib_metric_type_t;
+
+/** A registered metric. */
+typedef struct ib_metric_t ib_metric_t;
+
+/**
+ * Fetch the metric named @a name, registering it on first use.
+ *
+ * This never returns NULL: when the registry is full, a shared sink
+ * metric is returned whose updates are accepted and discarded, so hot
+ * paths need neither error handling nor retries. Callers should cache
+ * the result.
+ *
+ * Registering an existing name with a different @a type also returns
+ * the sink metric.
+ *
+ * @param[in] name Metric name. Not copied; must outlive the process
+ *            (string literals, in practice).
+ * @param[in] type The kind of metric.
+ *
+ * @returns The metric.
+ */
+const ib_metric_t DLL_PUBLIC *ib_metric_acquire(
+    const char       *name,
+    ib_metric_type_t  type
+);
+
+/**
+ * Add @a n to the counter @a metric.
+ *
+ * @param[in] metric The metric to update.
+ * @param[in] n Amount to add.
+ */
+void DLL_PUBLIC ib_metric_add(const ib_metric_t *metric, uint64_t n);
+
+/**
+ * Raise the high-water gauge @a metric to @a value if it is higher.
+ *
+ * The mark is kept per thread; a report takes the highest across
+ * threads.
+ *
+ * @param[in] metric The metric to update.
+ * @param[in] value The observed value.
+ */
+void DLL_PUBLIC ib_metric_max(const ib_metric_t *metric, uint64_t value);
+
+/**
+ * Record @a value into the histogram @a metric.
+ *
+ * @param[in] metric The metric to update.
+ * @param[in] value The observed value.
+ */
+void DLL_PUBLIC ib_metric_record(const ib_metric_t *metric, uint64_t value);
+
+/**
+ * Render all metrics, aggregated across threads, as text.
+ *
+ * One line per datum:
+ * - `counter <name> <value>`
+ * - `gauge <name> <value>`
+ * - `hist <name> <2^n> <count>` for each non-empty bucket, where
+ *   `2^n` is the bucket's exclusive upper bound.
+ *
+ * @param[in] mm Memory manager to allocate @a report from.
+ * @param[out] report The NUL-terminated report. Empty when no metric
+ *             has been registered.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_metrics_report(ib_mm_t mm, const char **report);
+
+/** @} IronBeeUtilMetrics */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_METRICS_H_ */
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_MM_BUDGET_H_
+#define _IB_MM_BUDGET_H_
+
+/**
+ * @file
+ * @brief IronBee --- Memory Manager: Budget Adapter
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup IronBeeUtilMM
+ * @{
+ */
+
+/**
+ * A budget over a backing memory manager.
+ *
+ * Allocations made through the budget's manager are counted against a
+ * byte limit and deterministically fail once the limit is reached,
+ * turning a runaway consumer into an ordinary allocation failure
+ * instead of a process-level out-of-memory condition. Cleanup
+ * registration passes through to the backing manager unbudgeted.
+ *
+ * The budget itself lives in the backing manager and needs no
+ * destruction of its own.
+ **/
+typedef struct ib_mm_budget_t ib_mm_budget_t;
+
+/**
+ * Create a budget of @a limit bytes over @a backing.
+ *
+ * @param[out] budget The budget created.
+ * @param[in] backing Memory manager allocations are drawn from.
+ * @param[in] limit Cumulative bytes allowed through the budget.
+ *            A limit of 0 refuses all allocations.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_mm_budget_create(
+    ib_mm_budget_t **budget,
+    ib_mm_t          backing,
+    size_t           limit
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Get the budgeted memory manager of @a budget.
+ *
+ * @param[in] budget The budget.
+ * @return Memory manager whose allocations count against @a budget.
+ **/
+ib_mm_t DLL_PUBLIC ib_mm_budget_mm(ib_mm_budget_t *budget)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Cumulative bytes allocated through @a budget.
+ *
+ * @param[in] budget The budget.
+ * @return Bytes successfully allocated.
+ **/
+size_t DLL_PUBLIC ib_mm_budget_used(const ib_mm_budget_t *budget)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * The byte limit of @a budget.
+ *
+ * @param[in] budget The budget.
+ * @return The limit given at creation.
+ **/
+size_t DLL_PUBLIC ib_mm_budget_limit(const ib_mm_budget_t *budget)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * True if an allocation was ever refused by @a budget.
+ *
+ * @param[in] budget The budget.
+ * @return True if the budget has been exceeded.
+ **/
+bool DLL_PUBLIC ib_mm_budget_exceeded(const ib_mm_budget_t *budget)
+NONNULL_ATTRIBUTE(1);
+
+/** @} IronBeeUtilMM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_MM_BUDGET_H_ */
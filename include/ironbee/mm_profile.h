@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_MM_PROFILE_H_
+#define _IB_MM_PROFILE_H_
+
+/**
+ * @file
+ * @brief IronBee --- Memory Manager Allocation Profiler
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilMMProfile Memory Manager Allocation Profiler
+ * @ingroup IronBeeUtil
+ *
+ * Attributes memory manager allocations to their call sites.
+ *
+ * When IronBee is built with @c -DIB_MM_PROFILE, ib_mm_alloc() samples
+ * allocations into per-thread tables keyed by caller return address:
+ * one in every #IB_MM_PROFILE_SAMPLE_RATE allocations per thread
+ * records the caller, the requested size, and the identity of the pool
+ * allocated from.  The recording path is lock-free (each thread owns
+ * its table); threads register their tables in a global list on first
+ * use so a report can aggregate across them.
+ *
+ * Without @c IB_MM_PROFILE, ib_mm_alloc() is unchanged and nothing is
+ * recorded; the report and reset entry points remain linkable so
+ * callers (such as the control channel) need no conditional
+ * compilation.
+ *
+ * Reported call sites are raw return addresses.  Resolve them against
+ * the loaded objects with `addr2line` or by symbolizing against
+ * `/proc/<pid>/maps`.
+ *
+ * @{
+ */
+
+/** Record one allocation in every this-many, per thread. */
+#define IB_MM_PROFILE_SAMPLE_RATE 16
+
+/** Call site slots per thread table.  Excess call sites are dropped. */
+#define IB_MM_PROFILE_TABLE_SIZE 1024
+
+/**
+ * Is allocation profiling compiled in?
+ *
+ * @returns true iff the library was built with @c IB_MM_PROFILE.
+ */
+bool DLL_PUBLIC ib_mm_profile_enabled(void);
+
+/**
+ * Record an allocation against @a caller.
+ *
+ * This is the recording primitive behind the sampled calls in
+ * ib_mm_alloc(), exported so tests and custom allocators can feed it
+ * directly.  Records every call; sampling is the caller's concern.
+ *
+ * @param[in] caller Return address of the allocating call site.
+ * @param[in] size Bytes requested.
+ * @param[in] pool Identity of the pool allocated from.  Only
+ *            distinctness matters; the allocation callback data of the
+ *            @ref ib_mm_t is used.
+ */
+void DLL_PUBLIC ib_mm_profile_record(
+    const void *caller,
+    size_t      size,
+    const void *pool
+);
+
+/**
+ * Render sampled allocations, aggregated across threads.
+ *
+ * One line per call site, sorted by sampled bytes descending:
+ * `address  samples  bytes  pools`, where @c pools approximates the
+ * number of distinct pools seen allocating from that site (a small
+ * ring of recent pools suppresses repeats; capped at 255 per thread).
+ * Sampled figures should be scaled by #IB_MM_PROFILE_SAMPLE_RATE to
+ * estimate totals.  Call sites dropped because a thread table was full
+ * are reported in a trailing `(dropped)` line.
+ *
+ * @param[in] mm Memory manager to allocate @a report from.
+ * @param[out] report The NUL-terminated report.  Empty when nothing
+ *             has been recorded.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_mm_profile_report(ib_mm_t mm, const char **report);
+
+/**
+ * Discard all recorded samples on all threads.
+ *
+ * Concurrent allocations may be recorded or lost while a reset is in
+ * progress; counts are exact again once it returns.
+ */
+void DLL_PUBLIC ib_mm_profile_reset(void);
+
+/** @} IronBeeUtilMMProfile */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_MM_PROFILE_H_ */
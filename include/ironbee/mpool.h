@@ -232,6 +232,33 @@ ib_status_t DLL_PUBLIC ib_mpool_prealloc_pages(
     int pages
 );
 
+/**
+ * Set the calling thread's page cache limit.
+ *
+ * Each thread keeps a small cache of pages freed by ib_mpool_destroy() and
+ * serves them to later pools instead of calling malloc, avoiding allocator
+ * lock contention when many worker threads create and destroy a pool per
+ * transaction.  The cache holds at most @a limit pages; a limit of 0
+ * disables caching for the thread.  Excess pages are freed immediately.
+ *
+ * Only pages of pools using the default malloc/free functions pass through
+ * the cache.
+ *
+ * @param[in] limit Maximum number of pages to cache on this thread.
+ */
+void DLL_PUBLIC ib_mpool_pagecache_limit_set(
+    size_t limit
+);
+
+/**
+ * Free every page cached by the calling thread.
+ *
+ * Intended for threads going idle; the cache refills on later use.
+ *
+ * @returns Number of pages freed.
+ */
+size_t DLL_PUBLIC ib_mpool_pagecache_drain(void);
+
 /**
  * Allocate memory from a memory pool.
  *
@@ -133,6 +133,33 @@ NONNULL_ATTRIBUTE(1, 2, 4);
 /*! Supports capture */
 #define IB_OP_CAPABILITY_CAPTURE     (1 << 3)
 
+/**
+ * Instances depend only on the operator and its parameters.
+ *
+ * The create function of such an operator must not read anything from its
+ * context argument beyond the engine, so that two instances created with
+ * equal parameters in different contexts are interchangeable.  The engine
+ * then interns instances: every context inheriting a rule with the same
+ * operator and parameters shares one instance instead of compiling its
+ * own.  Instance data is already required to be read-only at execution
+ * time (one instance serves all concurrent transactions), so sharing
+ * across contexts adds no further requirement there.
+ */
+#define IB_OP_CAPABILITY_SHAREABLE   (1 << 4)
+
+/**
+ * Execution is a pure function of the instance and the input bytes.
+ *
+ * The execute function of such an operator must not read transaction or
+ * other mutable state and must have no effect beyond its result output;
+ * writing to a capture collection is permitted since the engine only
+ * reuses results for non-capturing rules.  The rule engine may then
+ * memoize the result of executing the instance on a given input field
+ * within a transaction instead of re-executing it for every rule that
+ * applies the same operator to the same value.
+ */
+#define IB_OP_CAPABILITY_MEMOIZE     (1 << 5)
+
 /**
  * Create an operator.
  *
@@ -176,7 +203,8 @@ NONNULL_ATTRIBUTE(1, 3);
  *
  * @return
  * - IB_OK on success.
- * - IB_EINVAL if an operator with same name already exists.
+ * - IB_EINVAL if an operator with same name already exists, or if the
+ *   engine configuration is already finished.
  * - IB_EALLOC on allocation failure.
  */
 ib_status_t DLL_PUBLIC ib_operator_register(
@@ -194,7 +222,8 @@ NONNULL_ATTRIBUTE(1, 2);
  * @return
  * - IB_OK on success.
  * - IB_EALLOC on allocation failure.
- * - IB_EINVAL if an operator with same name already exists.
+ * - IB_EINVAL if an operator with same name already exists, or if the
+ *   engine configuration is already finished.
  */
 ib_status_t DLL_PUBLIC ib_operator_stream_register(
     ib_engine_t         *ib,
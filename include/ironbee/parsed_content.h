@@ -31,6 +31,8 @@
 #include <ironbee/mm.h>
 #include <ironbee/types.h>
 
+#include <sys/uio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -143,6 +145,31 @@ ib_status_t DLL_PUBLIC ib_parsed_headers_add(
     size_t               value_len
 );
 
+/**
+ * Add a whole block of headers to @a headers in one call.
+ *
+ * @a fields holds `2 * count` iovecs, alternating header name and
+ * header value.  The buffers are copied, as with
+ * ib_parsed_headers_add(), but all list elements and all copied bytes
+ * come from two allocations, amortizing the per-header cost.  Server
+ * plugins that already hold the complete header block should prefer
+ * this over calling ib_parsed_headers_add() per header.
+ *
+ * On error the header list is unchanged.
+ *
+ * @param[in] headers Headers to add to.
+ * @param[in] fields  `2 * count` iovecs: name, value, name, value, ...
+ * @param[in] count   Number of headers (name-value pairs) in @a fields.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_parsed_headers_add_batch(
+    ib_parsed_headers_t *headers,
+    const struct iovec  *fields,
+    size_t               count
+);
+
 
 /**
  * Append the @a tail list to the @a head list.
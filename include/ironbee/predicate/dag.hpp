@@ -103,6 +103,9 @@ typedef std::list<weak_node_p> weak_node_list_t;
 //! List of const nodes.
 typedef std::list<node_cp> node_clist_t;
 
+//! Contiguous vector of raw node pointers.  See Node::indexed_children().
+typedef std::vector<const Node*> node_ptr_vector_t;
+
 /**
  * A node in the predicate DAG.
  *
@@ -332,6 +335,24 @@ public:
         return m_index;
     }
 
+    /**
+     * Children as a contiguous vector of raw pointers.
+     *
+     * Snapshot of children() taken by set_index(), i.e., once the graph is
+     * frozen and being indexed for evaluation (see make_indexer()).
+     * Evaluation code should prefer this to children(): it walks a
+     * contiguous array rather than chasing list nodes and shared pointer
+     * reference counts, and an index into it is cheap per-transaction
+     * state (see NodeEvalState::state()).
+     *
+     * Only valid after set_index(); empty before.
+     **/
+    // Intentionally inline.
+    const node_ptr_vector_t& indexed_children() const
+    {
+        return m_indexed_children;
+    }
+
     /**
      * Initialize node eval state.
      *
@@ -382,6 +403,8 @@ private:
     node_list_t m_children;
     //! Index.
     size_t m_index;
+    //! Contiguous snapshot of m_children.  See indexed_children().
+    node_ptr_vector_t m_indexed_children;
 };
 
 //! Ostream output operator.
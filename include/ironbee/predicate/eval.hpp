@@ -123,6 +123,20 @@ public:
      **/
     void append_to_list(Value v);
 
+    /**
+     * Add every element of a list to a list.
+     *
+     * Equivalent to calling append_to_list() on each element of @a values,
+     * but does the sanity checks once rather than per element.  Useful for
+     * calls such as cat and flatten that splice entire child lists into
+     * their own value.
+     *
+     * @sa append_to_list()
+     *
+     * @throw einval if called on a finished() node.
+     **/
+    void append_to_list(ConstList<Value> values);
+
     /**
      * Mark node as finished.  Primarily for use with lists.
      *
@@ -371,6 +385,16 @@ public:
      **/
     GraphEvalState(size_t index_limit);
 
+    /**
+     * Reset to freshly constructed state, reusing capacity.
+     *
+     * Equivalent to replacing this GraphEvalState with a newly constructed
+     * one with the same index limit, except that the node state vector and
+     * bitsets keep their allocations.  Allows eval states to be pooled and
+     * reused across transactions instead of reallocated for each one.
+     **/
+    void reset();
+
     /**
      * @name Direct accessors.
      * Routines to directly access eval state.
@@ -560,6 +584,19 @@ private:
     //! Has a node in m_vector and m_graph been initialized.
     boost::dynamic_bitset<> m_initialized;
 
+    /**
+     * Has a node been observed finished and unforwarded by eval().
+     *
+     * A finished node's value can never change again, so once eval()
+     * observes a node finished (and not forwarding; forwarded state is
+     * resolved first) it sets the node's bit here and future eval() calls
+     * return after a single bit test, skipping forwarding resolution,
+     * initialization checks, and phase bookkeeping.  This lets repeated
+     * per-phase evaluation of a mostly settled graph skip settled
+     * subgraphs entirely.
+     **/
+    boost::dynamic_bitset<> m_settled;
+
     //! If true, eval() profiles node evaluation.
     bool m_profile;
 
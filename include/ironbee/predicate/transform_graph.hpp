@@ -56,6 +56,39 @@ bool transform_graph(
     Environment        environment
 );
 
+/**
+ * Transform part of a MergeGraph.
+ *
+ * As transform_graph(), but sweeps up from @a initial instead of the
+ * leaves of the entire graph, so only @a initial and their ancestors are
+ * visited.  Intended for incremental fixpoint passes: a transform can
+ * only change its result when the node or its descendants changed, so
+ * after a pass it suffices to re-seed with the leaves of the subtrees the
+ * pass introduced (see @a changed) rather than re-sweeping the whole
+ * graph.
+ *
+ * @param[in]  reporter     Reporter to use for NodeReporter's.
+ * @param[in]  graph        Graph to transform.
+ * @param[in]  call_factory CallFactory to pass to transform().
+ * @param[in]  environment  Environment to pass to transform().
+ * @param[in]  initial      Nodes to begin the bottom up sweep at.
+ * @param[out] changed      Appended with the post-replacement node of
+ *                          every transform that reported a change.  Note
+ *                          later transforms in the same pass may replace
+ *                          these again; resolve through
+ *                          MergeGraph::find_transform() before reuse.
+ * @return true iff any transform call returned true, i.e., if the graph
+ *         was changed.
+ **/
+bool transform_graph(
+    reporter_t         reporter,
+    MergeGraph&        graph,
+    const CallFactory& call_factory,
+    Environment        environment,
+    const node_list_t& initial,
+    node_list_t&       changed
+);
+
 } // Predicate
 } // IronBee
 
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace IronBee {
 namespace Predicate {
@@ -317,6 +318,24 @@ private:
     ConstField m_field;
 };
 
+//! Contiguous vector of values.
+typedef std::vector<Value> value_vec_t;
+
+/**
+ * Append elements of a list value to a contiguous vector.
+ *
+ * The nodes of a list value are individually allocated from a memory pool,
+ * so every traversal chases a pointer per element.  Copying the elements
+ * out once gives consumers a contiguous array to operate on instead.  Only
+ * sensible for finished lists; elements added to @a from later will not
+ * appear in @a to.
+ *
+ * @param[in]  from List value to copy elements of.
+ * @param[out] to   Vector to append elements to.
+ * @throw einval if @a from is not a list value.
+ **/
+void copy_list_values(Value from, value_vec_t& to);
+
 /**
  * Ostream Outputter.
  *
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_PROFILER_H_
+#define _IB_PROFILER_H_
+
+/**
+ * @file
+ * @brief IronBee --- Sampling Profiler Utility
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilProfiler Sampling Profiler
+ * @ingroup IronBeeUtil
+ *
+ * A built-in sampling CPU profiler for environments where external
+ * profilers (perf, dtrace) cannot be run.
+ *
+ * Engine code marks what it is doing by entering and exiting named tag
+ * scopes.  Each thread keeps a small stack of the tags it is currently
+ * inside; maintaining it costs one thread-local store per scope.  When
+ * the profiler is started a CPU-time interval timer delivers a signal
+ * whose handler copies the interrupted thread's tag stack into a
+ * preallocated sample buffer.  Samples are aggregated on demand into
+ * flame-graph-compatible folded-stack lines ("tag;tag;tag count").
+ *
+ * When the profiler is not started, only the thread-local tag stack is
+ * maintained; no signals, no sampling.
+ *
+ * @{
+ */
+
+/** Maximum number of distinct tags. */
+#define IB_PROFILER_MAX_TAGS 128
+
+/** Maximum recorded tag stack depth. Deeper scopes are truncated. */
+#define IB_PROFILER_MAX_DEPTH 8
+
+/** Number of samples the profiler can hold before dropping. */
+#define IB_PROFILER_MAX_SAMPLES 65536
+
+/**
+ * Find or register the tag named @a name.
+ *
+ * Lookups are lock-free; first-time registration takes a lock.  Callers
+ * on hot paths should cache the returned tag where a stable index (such
+ * as a state or phase number) is available.
+ *
+ * @param[in] name The tag name.  Not copied; must outlive the process
+ *            (string literal or engine-lifetime storage).
+ *
+ * @returns The tag, or -1 if the tag table is full.  A -1 tag may be
+ *          passed to ib_profiler_enter(), which records an anonymous
+ *          scope.
+ */
+int DLL_PUBLIC ib_profiler_tag(const char *name);
+
+/**
+ * Enter tag scope @a tag on the calling thread.
+ *
+ * Must be paired with ib_profiler_exit() on the same thread.
+ *
+ * @param[in] tag Tag from ib_profiler_tag(), or -1 for an anonymous
+ *            scope (depth is tracked; no tag is recorded).
+ */
+void DLL_PUBLIC ib_profiler_enter(int tag);
+
+/**
+ * Exit the current tag scope on the calling thread.
+ */
+void DLL_PUBLIC ib_profiler_exit(void);
+
+/**
+ * Start sampling every @a interval_usec microseconds of CPU time.
+ *
+ * Installs a SIGPROF handler and arms ITIMER_PROF, so the process must
+ * not otherwise use either.
+ *
+ * @param[in] interval_usec Sampling interval in microseconds of
+ *            process CPU time.  Must be greater than zero.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if @a interval_usec is zero or sampling is running.
+ * - IB_EALLOC if the sample buffer cannot be allocated.
+ * - IB_EOTHER if the timer or signal handler cannot be installed.
+ */
+ib_status_t DLL_PUBLIC ib_profiler_start(uint32_t interval_usec);
+
+/**
+ * Stop sampling.
+ *
+ * Collected samples are retained for ib_profiler_report().
+ *
+ * @returns IB_OK.  Stopping a stopped profiler is a no-op.
+ */
+ib_status_t DLL_PUBLIC ib_profiler_stop(void);
+
+/**
+ * Discard all collected samples.
+ */
+void DLL_PUBLIC ib_profiler_reset(void);
+
+/**
+ * Record one sample of the calling thread's tag stack.
+ *
+ * This is the body of the sampling signal handler, exported so tests
+ * and callers with their own sampling trigger can use it.  It is
+ * async-signal-safe and does not allocate.  Does nothing unless
+ * ib_profiler_start() has been called at least once.
+ */
+void DLL_PUBLIC ib_profiler_sample(void);
+
+/**
+ * Render collected samples as folded stacks.
+ *
+ * One line per distinct tag stack, "tag;tag;tag count\n", suitable as
+ * direct input to flamegraph.pl.  Samples with an empty tag stack are
+ * reported as "(untagged)"; samples dropped because the buffer was full
+ * are reported as "(dropped)".
+ *
+ * @param[in] mm Memory manager to allocate @a report from.
+ * @param[out] report The NUL-terminated report.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_profiler_report(ib_mm_t mm, const char **report);
+
+/** @} IronBeeUtilProfiler */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_PROFILER_H_ */
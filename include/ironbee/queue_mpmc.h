@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_QUEUE_MPMC_H_
+#define _IB_QUEUE_MPMC_H_
+
+/**
+ * @file
+ * @brief IronBee --- IronBee Lock-Free MPMC Queue
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilQueueMpmc Lock-Free MPMC Queue
+ * @ingroup IronBeeUtil
+ *
+ * A fixed-capacity multi-producer multi-consumer queue that hands
+ * elements between threads without taking a lock.
+ *
+ * Unlike @ref ib_queue_t, which is a single-threaded dynamic array that
+ * callers must guard with their own lock, this structure may be pushed
+ * to and popped from by any number of threads concurrently.  The price
+ * is a fixed capacity and a queue-only interface: there is no random
+ * access, no front-pushing and no resizing, as none of those can be
+ * provided without serializing the callers again.
+ *
+ * Operations never block.  A push to a full queue and a pop from an
+ * empty queue return immediately; callers that need to wait should back
+ * off and retry.
+ *
+ * @{
+ */
+
+/**
+ * Lock-free queue data structure.
+ */
+typedef struct ib_queue_mpmc_t ib_queue_mpmc_t;
+
+/**
+ * Create a lock-free queue.
+ *
+ * @param[out] queue The created queue.
+ * @param[in] mm The memory manager that @a queue will be allocated from.
+ *            The @a queue is destroyed when @a mm is destroyed; the
+ *            caller must ensure no thread touches it after that.
+ * @param[in] capacity The fixed number of slots.  Must be a power of 2
+ *            and at least 2.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If @a capacity is not a power of 2 or is less than 2.
+ * - IB_EALLOC On allocation errors.
+ */
+ib_status_t DLL_PUBLIC ib_queue_mpmc_create(
+    ib_queue_mpmc_t **queue,
+    ib_mm_t           mm,
+    size_t            capacity
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Enqueue an element without blocking.
+ *
+ * May be called from any number of threads concurrently.
+ *
+ * @param[in] queue The queue.
+ * @param[in] element The element to push.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EAGAIN If the queue is full.
+ */
+ib_status_t DLL_PUBLIC ib_queue_mpmc_try_push(
+    ib_queue_mpmc_t *queue,
+    void            *element
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Dequeue an element without blocking.
+ *
+ * May be called from any number of threads concurrently.
+ *
+ * @param[in] queue The queue.
+ * @param[out] element The element removed from the queue.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If the queue is empty.
+ */
+ib_status_t DLL_PUBLIC ib_queue_mpmc_try_pop(
+    ib_queue_mpmc_t *queue,
+    void           **element
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Return the fixed capacity of the queue.
+ *
+ * @param[in] queue The queue.
+ * @returns The capacity given at creation.
+ */
+size_t DLL_PUBLIC ib_queue_mpmc_capacity(
+    const ib_queue_mpmc_t *queue
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Return the current number of elements in the queue.
+ *
+ * The value is a snapshot; under concurrent pushes and pops it may be
+ * stale by the time the caller examines it.  It is exact when no other
+ * thread is operating on the queue.
+ *
+ * @param[in] queue The queue.
+ * @returns The number of elements in the queue.
+ */
+size_t DLL_PUBLIC ib_queue_mpmc_size(
+    const ib_queue_mpmc_t *queue
+)
+NONNULL_ATTRIBUTE(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* _IB_QUEUE_MPMC_H_ */
@@ -26,6 +26,7 @@
  */
 
 #include <ironbee/build.h>
+#include <ironbee/clock.h>
 #include <ironbee/queue.h>
 #include <ironbee/types.h>
 
@@ -171,6 +172,30 @@ ib_status_t DLL_PUBLIC ib_resource_acquire(
     ib_resource_t **resource
 );
 
+/**
+ * Acquire a resource, waiting up to @a timeout for one to be released.
+ *
+ * Like ib_resource_acquire(), but when the pool is empty and at its
+ * maximum, the caller blocks until another thread releases a resource
+ * or @a timeout passes, instead of immediately returning IB_DECLINED.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] timeout How long to wait, in microseconds. 0 does not
+ *            wait, making this identical to ib_resource_acquire().
+ * @param[out] resource The resource to get.
+ *
+ * @returns
+ * - IB_OK If a resource is acquired.
+ * - IB_ETIMEDOUT If @a timeout passed with no resource released.
+ * - IB_DECLINED If no resource is available and @a timeout is 0.
+ * - Other on unexpected errors.
+ */
+ib_status_t DLL_PUBLIC ib_resource_acquire_timeout(
+    ib_resource_pool_t *resource_pool,
+    ib_time_t timeout,
+    ib_resource_t **resource
+);
+
 /**
  * Return the given resource to its resource pool.
  *
@@ -233,6 +258,20 @@ ib_status_t DLL_PUBLIC ib_resource_pool_set_min(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Get the number of resources the pool tries to keep pre-created.
+ *
+ * @sa ib_resource_pool_set_min()
+ *
+ * @param[in] pool The pool to read the limit from.
+ *
+ * @return The current minimum limit.
+ */
+size_t DLL_PUBLIC ib_resource_pool_min_get(
+    ib_resource_pool_t *pool
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Tell the pool to not allow more than @a limit resources to be created.
  *
@@ -252,6 +291,57 @@ ib_status_t DLL_PUBLIC ib_resource_pool_set_max(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * A snapshot of pool gauges and counters.
+ *
+ * Populated by ib_resource_pool_stats_get(). Counters are cumulative
+ * over the life of the pool.
+ */
+struct ib_resource_pool_stats_t {
+    size_t    count;             /**< Resources currently created. */
+    size_t    free_count;        /**< Resources ready in the free queue. */
+    size_t    waiters;           /**< Threads blocked in a timed acquire. */
+    uint64_t  acquires;          /**< Total acquire calls. */
+    uint64_t  empty_acquires;    /**< Acquires that found the pool empty. */
+    uint64_t  timeouts;          /**< Timed acquires that gave up. */
+    uint64_t  creates;           /**< Calls to the user create function. */
+    ib_time_t create_time_total; /**< Time spent creating, in useconds. */
+};
+typedef struct ib_resource_pool_stats_t ib_resource_pool_stats_t;
+
+/**
+ * Copy the pool's current gauges and counters into @a stats.
+ *
+ * @param[in] pool The pool to report on.
+ * @param[out] stats Populated with a consistent snapshot.
+ */
+void DLL_PUBLIC ib_resource_pool_stats_get(
+    ib_resource_pool_t       *pool,
+    ib_resource_pool_stats_t *stats
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Start a background thread that keeps the free queue topped up.
+ *
+ * The thread pre-creates resources whenever fewer than the pool's
+ * minimum are free (and the maximum permits), so acquiring threads
+ * rarely pay resource construction latency themselves. It is woken
+ * when an acquire drains the free queue below the minimum, and it is
+ * stopped and joined when the pool is destroyed.
+ *
+ * @param[in] pool The pool to replenish.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If a replenisher is already running.
+ * - IB_EOTHER If the thread cannot be created.
+ */
+ib_status_t DLL_PUBLIC ib_resource_pool_replenisher_start(
+    ib_resource_pool_t *pool
+)
+NONNULL_ATTRIBUTE(1);
+
 /** @} IronBeeUtilResourcePool */
 
 #ifdef __cplusplus
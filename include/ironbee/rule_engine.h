@@ -28,6 +28,9 @@
 #include <ironbee/action.h>
 #include <ironbee/build.h>
 #include <ironbee/config.h>
+#include <ironbee/hash.h>
+#include <ironbee/mm.h>
+#include <ironbee/mpool.h>
 #include <ironbee/operator.h>
 #include <ironbee/rule_defs.h>
 #include <ironbee/types.h>
@@ -84,6 +87,10 @@ struct ib_rule_t {
     const ib_rule_phase_meta_t *phase_meta; /**< Phase meta data */
     ib_rule_operator_inst_t *opinst;          /**< Rule operator */
     ib_list_t             *target_fields;   /**< List of targets */
+    ib_rule_target_t     **target_array;    /**< target_fields frozen into a
+                                                 contiguous array at context
+                                                 close */
+    size_t                 num_targets;     /**< Elements in target_array */
     ib_list_t             *true_actions;    /**< Actions if condition True */
     ib_list_t             *false_actions;   /**< Actions if condition False */
     ib_list_t             *aux_actions;     /**< Auxiliary actions */
@@ -153,8 +160,17 @@ struct ib_rule_exec_t {
     /* The below members are for rule engine internal use only, and should
      * never be accessed by actions, injection functions, etc. */
 
-    /* Rule stack (for chains) */
-    ib_list_t              *rule_stack;  /**< Stack of rules */
+    /**
+     * Stack of saved execution state, one frame per executing rule.
+     *
+     * Frames are linked intrusively and recycled through
+     * @ref frame_pool, so steady-state rule execution performs no
+     * per-rule allocation.  Management is private to the rule engine.
+     **/
+    void                   *frame_stack;
+
+    /** Recycled frames for @ref frame_stack. */
+    void                   *frame_pool;
 
     /* List of all rules to run during the current phase. */
     ib_list_t              *phase_rules; /**< List of ib_rule_t */
@@ -164,6 +180,62 @@ struct ib_rule_exec_t {
      */
     ib_list_t              *value_stack;
 
+    /**
+     * Scratch memory for per-rule temporaries.
+     *
+     * Cleared after each phase rule (including its chain) completes,
+     * retaining its pages for reuse by the next rule.  Nothing allocated
+     * from it may outlive the rule's execution; anything stored in the
+     * var store, a capture collection, or the transaction must come from
+     * the transaction memory manager instead.
+     **/
+    ib_mpool_t             *scratch_mp;
+
+    /** Manager view of @ref scratch_mp. */
+    ib_mm_t                 scratch_mm;
+
+    /**
+     * Per-transaction memo of transformed target values.
+     *
+     * Many rules apply the identical transformation chain to the same
+     * target; the transformed value is computed once per transaction and
+     * reused until the underlying var changes.  Key and entry management
+     * is private to the rule engine.
+     **/
+    ib_hash_t              *tfn_memo;
+
+    /**
+     * Per-transaction memo of operator results.
+     *
+     * Rules applying the same operator instance to the same value (after
+     * transformation) reuse the first execution's result instead of
+     * re-executing, for operators with @ref IB_OP_CAPABILITY_MEMOIZE and
+     * non-capturing rules.  Key and entry management is private to the
+     * rule engine.
+     **/
+    ib_hash_t              *op_memo;
+
+    /**
+     * Reusable capture collection for the executing rule.
+     *
+     * Operators of capturing rules write into this collection, which is
+     * allocated once per transaction and reset (not reallocated) between
+     * rules.  Captures are copied out to the transaction var store only
+     * when the operator actually captured something, so rules that do
+     * not fire cost no var store work.  Management is private to the
+     * rule engine.
+     **/
+    ib_field_t             *capture_arena;
+
+    /**
+     * Name of the capture collection @ref capture_arena mirrors.
+     *
+     * When a capturing rule names a different collection the arena is
+     * reseeded from the var store so operators that accumulate captures
+     * across executions (e.g. streaming dfa) keep their prior items.
+     **/
+    const char             *capture_arena_owner;
+
 #ifdef IB_RULE_TRACE
     ib_rule_trace_t        *traces; /**< Rule trace information. */
 #endif
@@ -1319,6 +1391,35 @@ void DLL_PUBLIC ib_rule_log_exec(
     const char                 *fmt, ...
 ) PRINTF_ATTRIBUTE(6, 7);
 
+/**
+ * Would a rule log message at @a level be logged at all?
+ *
+ * The rule logging macros consult this before evaluating their format
+ * arguments, so arguments to a filtered message are never computed.
+ *
+ * @param[in] level Rule log level of the prospective message.
+ * @param[in] tx Transaction, or NULL (NULL always logs).
+ *
+ * @returns True if a message at @a level would reach the log.
+ */
+bool DLL_PUBLIC ib_rule_log_tx_would_log(
+    ib_rule_dlog_level_t  level,
+    const ib_tx_t        *tx
+);
+
+/**
+ * As ib_rule_log_tx_would_log() but taking a rule execution object.
+ *
+ * @param[in] level Rule log level of the prospective message.
+ * @param[in] rule_exec Rule execution object, or NULL (NULL always logs).
+ *
+ * @returns True if a message at @a level would reach the log.
+ */
+bool DLL_PUBLIC ib_rule_log_exec_would_log(
+    ib_rule_dlog_level_t  level,
+    const ib_rule_exec_t *rule_exec
+);
+
 /**
  * Is @a rule the member of a chain and not the first rule in the chain?
  *
@@ -1363,33 +1464,57 @@ void DLL_PUBLIC ib_rule_log_fatal_ex(
 
 /** Rule execution error logging */
 #define ib_rule_log_error(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_ERROR, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_ERROR, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_ERROR, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule execution warning logging */
 #define ib_rule_log_warn(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_WARNING, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_WARNING, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_WARNING, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule execution notice logging */
 #define ib_rule_log_notice(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_NOTICE, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_NOTICE, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_NOTICE, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule execution info logging */
 #define ib_rule_log_info(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_INFO, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_INFO, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_INFO, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule execution debug logging */
 #define ib_rule_log_debug(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_DEBUG, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_DEBUG, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_DEBUG, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule execution trace logging */
 #define ib_rule_log_trace(rule_exec, ...) \
-    ib_rule_log_exec(IB_RULE_DLOG_TRACE, rule_exec, \
-                     __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_exec_would_log(IB_RULE_DLOG_TRACE, (rule_exec))) { \
+            ib_rule_log_exec(IB_RULE_DLOG_TRACE, (rule_exec), \
+                             __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /**
  * Generic Logger for with transaction
@@ -1416,33 +1541,57 @@ void ib_rule_log_tx(ib_rule_dlog_level_t level,
 
 /** Rule error logging (TX version) */
 #define ib_rule_log_tx_error(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_ERROR, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_ERROR, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_ERROR, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule warning logging (TX version) */
 #define ib_rule_log_tx_warn(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_WARNING, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_WARNING, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_WARNING, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule notice logging (TX version) */
 #define ib_rule_log_tx_notice(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_NOTICE, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_NOTICE, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_NOTICE, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule info logging (TX version) */
 #define ib_rule_log_tx_info(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_INFO, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_INFO, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_INFO, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule debug logging (TX version) */
 #define ib_rule_log_tx_debug(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_DEBUG, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_DEBUG, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_DEBUG, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** Rule trace logging (TX version) */
 #define ib_rule_log_tx_trace(tx, ...) \
-    ib_rule_log_tx(IB_RULE_DLOG_TRACE, tx, \
-                   __FILE__, __func__, __LINE__, __VA_ARGS__)
+    do { \
+        if (ib_rule_log_tx_would_log(IB_RULE_DLOG_TRACE, (tx))) { \
+            ib_rule_log_tx(IB_RULE_DLOG_TRACE, (tx), \
+                           __FILE__, __func__, __LINE__, __VA_ARGS__); \
+        } \
+    } while (0)
 
 /** @} */
 
@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_SHM_ARENA_H_
+#define _IB_SHM_ARENA_H_
+
+/**
+ * @file
+ * @brief IronBee --- Shared Memory Arena
+ *
+ * @author Nick Kew <nkew@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/types.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilShmArena Shared Memory Arena
+ * @ingroup IronBeeUtil
+ *
+ * A bump allocator over a shared anonymous mapping.
+ *
+ * The arena is intended for configuration data that is built once in a
+ * master process and then read by many forked workers: a mapping
+ * created with `MAP_SHARED | MAP_ANONYMOUS` before fork is one copy of
+ * physical memory for every worker, where ordinary heap pages are
+ * duplicated by copy-on-write as soon as any process touches them.
+ *
+ * Once configuration is complete the arena is sealed with
+ * ib_shm_arena_seal(): further arena allocations fail, so any later
+ * (re)configuration lands in private memory instead.  The pages are
+ * not hardware write-protected because memory pool bookkeeping is
+ * interleaved with the configuration data and is still written on
+ * pool destruction; after sealing, the mapping must be treated as
+ * read-only by convention.  Individual allocations are never freed;
+ * the whole mapping is released by ib_shm_arena_destroy().
+ *
+ * Because @ref ib_mpool_malloc_fn_t carries no callback data, a single
+ * arena may be selected process-wide with ib_shm_arena_select();
+ * ib_shm_arena_mpool_malloc() and ib_shm_arena_mpool_free() then
+ * adapt it to memory pool allocator hooks, falling back to malloc()
+ * and free() when the arena is sealed, exhausted, or not selected.
+ * Post-fork allocations are safe: the arena bookkeeping lives in the
+ * mapping itself, guarded by a process-shared mutex.
+ *
+ * @{
+ */
+
+//! A shared memory arena.
+typedef struct ib_shm_arena_t ib_shm_arena_t;
+
+/**
+ * Create an arena of @a size bytes over a shared anonymous mapping.
+ *
+ * @param[out] arena The created arena.
+ * @param[in] size Total mapping size in bytes, including one page of
+ *            arena bookkeeping.  Rounded up to a whole page.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If the mapping cannot be created.
+ * - IB_EOTHER If the process-shared mutex cannot be initialized.
+ */
+ib_status_t DLL_PUBLIC ib_shm_arena_create(
+    ib_shm_arena_t **arena,
+    size_t           size
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Allocate @a size bytes from @a arena.
+ *
+ * @param[in] arena The arena.
+ * @param[in] size Bytes to allocate.
+ *
+ * @returns The allocation, or NULL if the arena is sealed or full.
+ */
+void DLL_PUBLIC * ib_shm_arena_malloc(
+    ib_shm_arena_t *arena,
+    size_t          size
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Seal @a arena: all further allocations from it fail.
+ *
+ * @param[in] arena The arena.
+ */
+void DLL_PUBLIC ib_shm_arena_seal(
+    ib_shm_arena_t *arena
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Return true if @a ptr points into @a arena's mapping.
+ *
+ * @param[in] arena The arena.
+ * @param[in] ptr The pointer to test.
+ *
+ * @returns True if @a ptr is inside the mapping.
+ */
+bool DLL_PUBLIC ib_shm_arena_contains(
+    const ib_shm_arena_t *arena,
+    const void           *ptr
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Return the number of payload bytes allocated from @a arena.
+ *
+ * @param[in] arena The arena.
+ *
+ * @returns Bytes allocated.
+ */
+size_t DLL_PUBLIC ib_shm_arena_used(
+    const ib_shm_arena_t *arena
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Unmap @a arena.  The caller must ensure no allocation is in use.
+ *
+ * @param[in] arena The arena.
+ */
+void DLL_PUBLIC ib_shm_arena_destroy(
+    ib_shm_arena_t *arena
+) NONNULL_ATTRIBUTE(1);
+
+/**
+ * Select @a arena as the process-wide arena behind
+ * ib_shm_arena_mpool_malloc() and ib_shm_arena_mpool_free().
+ *
+ * @param[in] arena The arena, or NULL to deselect.
+ */
+void DLL_PUBLIC ib_shm_arena_select(
+    ib_shm_arena_t *arena
+);
+
+/**
+ * Memory pool malloc hook backed by the selected arena.
+ *
+ * Falls back to malloc() when no arena is selected or the arena is
+ * sealed or full, so callers degrade to private memory rather than
+ * failing.
+ *
+ * @param[in] size Bytes to allocate.
+ *
+ * @returns The allocation or NULL.
+ */
+void DLL_PUBLIC * ib_shm_arena_mpool_malloc(size_t size);
+
+/**
+ * Memory pool free hook matching ib_shm_arena_mpool_malloc().
+ *
+ * Arena allocations are never individually freed; anything outside
+ * the selected arena is passed to free().
+ *
+ * @param[in] ptr The allocation to free.
+ */
+void DLL_PUBLIC ib_shm_arena_mpool_free(void *ptr);
+
+/** @} IronBeeUtilShmArena */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _IB_SHM_ARENA_H_ */
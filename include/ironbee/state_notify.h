@@ -21,6 +21,7 @@
 #include <ironbee/engine.h>
 #include <ironbee/field.h>
 #include <ironbee/parsed_content.h>
+#include <ironbee/stream_io.h>
 #include <ironbee/types.h>
 
 #ifdef __cplusplus
@@ -135,6 +136,33 @@ ib_status_t DLL_PUBLIC ib_state_notify_request_body_data(ib_engine_t *ib,
                                                          const char *data,
                                                          size_t data_length);
 
+/**
+ * As ib_state_notify_request_body_data() but without copying @a data.
+ *
+ * The memory behind @a data must remain valid until @a release_fn is
+ * called. Whether or not this call succeeds, @a release_fn is invoked
+ * exactly once; the caller must never release the memory itself. This
+ * lets servers with reference counted buffers avoid a copy per body
+ * chunk when inspection does not modify the data.
+ *
+ * @param ib Engine handle
+ * @param tx Transaction
+ * @param data Transaction data
+ * @param data_length Length of @a data.
+ * @param release_fn Called exactly once when the data is no longer
+ *        referenced. May be NULL if the memory outlives the transaction.
+ * @param release_cbdata Callback data for @a release_fn.
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_state_notify_request_body_data_alias(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata);
+
 /**
  * Notify the state machine that the entire request is finished.
  *
@@ -204,6 +232,30 @@ ib_status_t DLL_PUBLIC ib_state_notify_response_body_data(ib_engine_t *ib,
                                                           const char *data,
                                                           size_t data_length);
 
+/**
+ * As ib_state_notify_response_body_data() but without copying @a data.
+ *
+ * See ib_state_notify_request_body_data_alias() for the ownership
+ * contract.
+ *
+ * @param ib Engine handle
+ * @param tx Transaction
+ * @param data Transaction data
+ * @param data_length Length of @a data
+ * @param release_fn Called exactly once when the data is no longer
+ *        referenced. May be NULL if the memory outlives the transaction.
+ * @param release_cbdata Callback data for @a release_fn.
+ *
+ * @returns Status code
+ */
+ib_status_t DLL_PUBLIC ib_state_notify_response_body_data_alias(
+    ib_engine_t               *ib,
+    ib_tx_t                   *tx,
+    const char                *data,
+    size_t                     data_length,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata);
+
 /**
  * Notify the state machine that the entire response is finished.
  *
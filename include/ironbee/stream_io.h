@@ -75,6 +75,7 @@ extern "C" {
  *
  * - ib_stream_io_tx_create() - Create a io_tx.
  * - ib_stream_io_tx_data_add() - Add data to an io_tx.
+ * - ib_stream_io_tx_data_alias_add() - Add external data without a copy.
  * - ib_stream_io_tx_flush_add() - Add flush to an io_tx input.
  * - ib_stream_io_tx_close_add() - Add close to an io_tx input.
  * - ib_stream_io_tx_error_add() - Add error to an io_tx input.
@@ -103,6 +104,15 @@ typedef struct ib_stream_io_tx_t ib_stream_io_tx_t;
 //! Access to the data managed by an @ref ib_stream_io_t.
 typedef struct ib_stream_io_data_t ib_stream_io_data_t;
 
+/**
+ * Callback to release externally owned memory aliased by a data segment.
+ *
+ * @param[in] cbdata Callback data given when the alias was created.
+ *
+ * @sa ib_stream_io_tx_data_alias_add()
+ */
+typedef void (*ib_stream_io_release_fn_t)(void *cbdata);
+
 /**
  * Create an io object.
  *
@@ -156,6 +166,40 @@ ib_status_t DLL_PUBLIC ib_stream_io_tx_data_add(
     size_t             len
 ) NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * Add externally owned data into the transaction without copying it.
+ *
+ * The data is aliased, not copied. The memory behind @a data must
+ * remain valid until @a release_fn is called. Whether or not this
+ * call succeeds, @a release_fn is invoked exactly once, when the last
+ * reference to the aliased data is dropped or, on error, before this
+ * function returns. The caller must never release the memory itself.
+ *
+ * This allows servers whose buffers are already reference counted
+ * (such as Traffic Server IO buffers) to submit body data for
+ * observation without a copy per chunk.
+ *
+ * @param[in] io_tx The transaction object.
+ * @param[in] data The data to alias into this transaction.
+ * @param[in] len The length of @a data. Must be greater than 0.
+ * @param[in] release_fn Called exactly once when the data is no
+ *            longer referenced. May be NULL if the memory outlives
+ *            the stream (e.g. static data).
+ * @param[in] release_cbdata Callback data for @a release_fn.
+ *
+ * @returns
+ * - IB_OK On succes.
+ * - IB_EALLOC On allocation error.
+ * - Other on another error.
+ */
+ib_status_t DLL_PUBLIC ib_stream_io_tx_data_alias_add(
+    ib_stream_io_tx_t         *io_tx,
+    const uint8_t             *data,
+    size_t                     len,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata
+) NONNULL_ATTRIBUTE(1, 2);
+
 /**
  * Add a flush into the transaction to be processed.
  *
@@ -234,6 +234,41 @@ ib_status_t DLL_PUBLIC ib_stream_processor_registry_register(
     void                           *destroy_cbdata
 ) NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * Declare the processor registered as @a name observe-only.
+ *
+ * An observe-only processor inspects data but always forwards it
+ * unmodified. When every processor in a pump is observe-only the pump
+ * is transparent and a server may keep the body on a kernel zero-copy
+ * path, feeding the engine a read-only tee.
+ *
+ * @sa ib_stream_pump_transparent()
+ *
+ * @param[in] registry The registry holding the definition.
+ * @param[in] name The unique, registered name of the processor.
+ * @param[in] observe_only True if the processor never alters data.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If @a name is not registered.
+ */
+ib_status_t DLL_PUBLIC ib_stream_processor_registry_observe_only_set(
+    ib_stream_processor_registry_t *registry,
+    const char                     *name,
+    bool                            observe_only
+) NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * True if @a processor's definition is declared observe-only.
+ *
+ * @param[in] processor The processor.
+ *
+ * @returns True if the processor never alters data.
+ */
+bool DLL_PUBLIC ib_stream_processor_observe_only(
+    const ib_stream_processor_t *processor
+) NONNULL_ATTRIBUTE(1);
+
 /**
  * Create @a processor from it's registered definition.
  *
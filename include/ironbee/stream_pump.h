@@ -91,6 +91,27 @@ ib_status_t DLL_PUBLIC ib_stream_pump_processor_insert(
     size_t            idx
 ) NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * True if every processor in this pump is declared observe-only.
+ *
+ * A transparent pump never alters the data fed through it, so a
+ * server may forward the body on a kernel zero-copy path (sendfile,
+ * splice) and feed the pump a read-only tee instead of shuttling
+ * every chunk through its output. An empty pump is transparent.
+ *
+ * Query this after transaction setup, when all processors have been
+ * added.
+ *
+ * @sa ib_stream_processor_registry_observe_only_set()
+ *
+ * @param[in] pump The pump.
+ *
+ * @returns True if no processor in the pump alters data.
+ */
+bool DLL_PUBLIC ib_stream_pump_transparent(
+    const ib_stream_pump_t *pump
+) NONNULL_ATTRIBUTE(1);
+
 /**
  * Return the list of @ref ib_stream_processor_t in this processor.
  *
@@ -127,6 +148,34 @@ ib_status_t DLL_PUBLIC ib_stream_pump_process(
     size_t            data_len
 ) NONNULL_ATTRIBUTE(1);
 
+/**
+ * Process @a data through @a pump without copying it.
+ *
+ * Unlike ib_stream_pump_process() the data is aliased. The memory
+ * behind @a data must remain valid until @a release_fn is called.
+ * Whether or not this call succeeds, @a release_fn is invoked
+ * exactly once; the caller must never release the memory itself.
+ *
+ * @param[in] pump The pump that will do the processing.
+ * @param[in] data The data to be processed.
+ * @param[in] data_len The length of data.
+ * @param[in] release_fn Called exactly once when the data is no
+ *            longer referenced. May be NULL if the memory outlives
+ *            the pump.
+ * @param[in] release_cbdata Callback data for @a release_fn.
+ *
+ * @return
+ * - IB_OK On success.
+ * - Other on failure.
+ */
+ib_status_t DLL_PUBLIC ib_stream_pump_process_alias(
+    ib_stream_pump_t          *pump,
+    const uint8_t             *data,
+    size_t                     data_len,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata
+) NONNULL_ATTRIBUTE(1);
+
 /**
  * Send a flush message through @a pump.
  *
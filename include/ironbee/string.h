@@ -30,6 +30,8 @@
 #include <ironbee/field.h>
 #include <ironbee/mm.h>
 
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,6 +73,24 @@ const char DLL_PUBLIC *ib_strstr(
     size_t      needle_len
 );
 
+/**
+ * Compare two byte regions of equal length, ASCII case-insensitively.
+ *
+ * Unlike strncasecmp(3), this does not stop at NUL bytes, so it is safe
+ * for byte strings.
+ *
+ * @param[in] a First region.
+ * @param[in] b Second region.
+ * @param[in] length Length of both @a a and @a b.
+ *
+ * @returns True iff the regions are equal ignoring ASCII case.
+ */
+bool DLL_PUBLIC ib_streq_nocase(
+    const char *a,
+    const char *b,
+    size_t      length
+);
+
 /**
  * Join strings in @a list using @a join_string into a single string.
  *
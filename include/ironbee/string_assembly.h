@@ -25,6 +25,8 @@ extern "C" {
 #include <ironbee/mm.h>
 #include <ironbee/release.h>
 
+#include <stdarg.h>
+
 /**
  * @file
  * @brief IronBee --- String Assembly
@@ -80,6 +82,75 @@ ib_status_t DLL_PUBLIC ib_sa_append(
 )
 NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * Append a copy of data to a string under assembly.
+ *
+ * As ib_sa_append() but copies @a data into storage owned by the assembly
+ * state, so @a data need not outlive this call.  Consecutive copying
+ * appends share writable blocks, so short pieces do not pay a chunk node
+ * each.
+ *
+ * @param[in] sa          String assembly state.
+ * @param[in] data        Data to append.  Copied; may be freed on return.
+ * @param[in] data_length Length of @a data.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_sa_append_copy(
+    ib_sa_t    *sa,
+    const char *data,
+    size_t      data_length
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Append formatted output to a string under assembly.
+ *
+ * Formats directly into the writable tail of the assembly, avoiding the
+ * format-to-temporary-then-append copy.  The result does not include a
+ * NUL terminator.
+ *
+ * @param[in] sa     String assembly state.
+ * @param[in] format Format string as for @c printf().
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL on formatting failure.
+ **/
+ib_status_t DLL_PUBLIC ib_sa_printf(
+    ib_sa_t    *sa,
+    const char *format,
+    ...
+)
+NONNULL_ATTRIBUTE(1, 2)
+PRINTF_ATTRIBUTE(2, 3);
+
+/**
+ * As ib_sa_printf() but takes a @c va_list.
+ *
+ * @param[in] sa     String assembly state.
+ * @param[in] format Format string as for @c printf().
+ * @param[in] ap     Format arguments.
+ * @return As ib_sa_printf().
+ **/
+ib_status_t DLL_PUBLIC ib_sa_vprintf(
+    ib_sa_t    *sa,
+    const char *format,
+    va_list     ap
+)
+NONNULL_ATTRIBUTE(1, 2)
+VPRINTF_ATTRIBUTE(2);
+
+/**
+ * Length, in bytes, of the string assembled so far.
+ *
+ * @param[in] sa String assembly state.
+ * @return Length of assembled string.
+ **/
+size_t DLL_PUBLIC ib_sa_length(const ib_sa_t *sa)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Complete assembly, converting to string.
  *
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_STRINTERN_H_
+#define _IB_STRINTERN_H_
+
+/**
+ * @file
+ * @brief IronBee --- String Interning Utility Functions
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilStrIntern String Interning
+ * @ingroup IronBeeUtil
+ *
+ * A table mapping strings to canonical copies of themselves.
+ *
+ * Interning the same string twice yields the same pointer, so consumers
+ * that hold interned names can compare them by pointer instead of by
+ * contents.  Strings are matched case-insensitively; the spelling of the
+ * first intern becomes the canonical spelling.
+ *
+ * Intended for configuration-known names, e.g., var source names, which
+ * are bounded in number.  Do not intern strings taken from traffic; the
+ * table never shrinks.
+ *
+ * @{
+ */
+
+/**
+ * An interning table.
+ **/
+typedef struct ib_strintern_t ib_strintern_t;
+
+/**
+ * Create an interning table.
+ *
+ * @param[out] interns The new table.
+ * @param[in]  mm      Memory manager canonical copies are allocated from.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_strintern_create(
+    ib_strintern_t **interns,
+    ib_mm_t          mm
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Intern a string.
+ *
+ * If a string case-insensitively equal to @a string has been interned
+ * before, outputs its canonical copy.  Otherwise copies @a string into the
+ * table and outputs the copy.  @a interned is not NUL terminated beyond
+ * what @a string was; its length is @a length.
+ *
+ * @param[in]  interns  Table to intern in.
+ * @param[in]  string   String to intern.
+ * @param[in]  length   Length of @a string.
+ * @param[out] interned Canonical copy; lifetime that of the table.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_strintern_intern(
+    ib_strintern_t  *interns,
+    const char      *string,
+    size_t           length,
+    const char     **interned
+)
+NONNULL_ATTRIBUTE(1, 2, 4);
+
+/**
+ * Look up a string without interning it.
+ *
+ * @param[in]  interns  Table to look in.
+ * @param[in]  string   String to look up.
+ * @param[in]  length   Length of @a string.
+ * @param[out] interned Canonical copy, if any.
+ * @return
+ * - IB_OK if @a string has been interned.
+ * - IB_ENOENT otherwise.
+ **/
+ib_status_t DLL_PUBLIC ib_strintern_lookup(
+    const ib_strintern_t  *interns,
+    const char            *string,
+    size_t                 length,
+    const char           **interned
+)
+NONNULL_ATTRIBUTE(1, 2, 4);
+
+/** @} IronBeeUtilStrIntern */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_STRINTERN_H_ */
@@ -38,6 +38,7 @@
 
 #include <ironbee/build.h>
 #include <ironbee/engine.h>
+#include <ironbee/list.h>
 #include <ironbee/mm.h>
 #include <ironbee/types.h>
 
@@ -129,6 +130,114 @@ typedef ib_status_t (* ib_transformation_execute_fn_t)(
 )
 NONNULL_ATTRIBUTE(3, 4);
 
+/**
+ * Byte-level transformation callback type.
+ *
+ * A transformation may additionally provide a byte-level kernel via
+ * ib_transformation_set_byte_fn().  Such transformations are @e fusible:
+ * when several of them appear consecutively in a target's transformation
+ * list the engine may run all of their kernels over a single buffer in one
+ * pass instead of materializing a field per step.  See
+ * ib_transformation_inst_execute_fused().
+ *
+ * Implementations of this type must follow some basic rules:
+ *
+ * -# Transform @a data in place; the result may not be longer than the
+ *    input.  Write the result length to @a dlen_out.
+ * -# Do not allocate; the caller owns the buffer.
+ * -# Produce exactly the same bytes the execute callback would produce
+ *    for a bytestring input.
+ *
+ * @param[in,out] data          Buffer to transform in place.
+ * @param[in]     dlen_in       Length of the input in @a data.
+ * @param[out]    dlen_out      Length of the result in @a data.
+ * @param[in]     instance_data Instance data.
+ * @param[in]     cbdata        Callback data.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL if the input cannot be transformed.
+ */
+typedef ib_status_t (* ib_transformation_byte_fn_t)(
+    uint8_t *data,
+    size_t   dlen_in,
+    size_t  *dlen_out,
+    void    *instance_data,
+    void    *cbdata
+)
+NONNULL_ATTRIBUTE(1, 3);
+
+/**
+ * Streaming transformation state creation callback.
+ *
+ * Allocates the carry-over state that a streaming transformation
+ * threads through the chunks of one stream.  Allocate from @a mm; the
+ * state lives as long as the stream.
+ *
+ * @param[out] state         Where to store the state.
+ * @param[in]  mm            Memory manager with stream lifetime.
+ * @param[in]  instance_data Instance data.
+ * @param[in]  cbdata        Callback data.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+typedef ib_status_t (* ib_transformation_stream_create_fn_t)(
+    void    **state,
+    ib_mm_t   mm,
+    void     *instance_data,
+    void     *cbdata
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Streaming transformation callback type.
+ *
+ * A transformation may provide a streaming form via
+ * ib_transformation_set_stream_fns(), letting callers feed a value chunk
+ * by chunk -- e.g. a request body as it arrives -- instead of buffering
+ * it whole.
+ *
+ * Implementations of this type must follow some basic rules:
+ *
+ * -# Concatenated over the sequence of calls for one stream, the output
+ *    must equal what the execute callback would produce for the
+ *    concatenated input.  Bytes that cannot be transformed until more
+ *    input arrives are carried over in @a state.
+ * -# Allocate @a data_out from @a mm; a chunk's output may not alias
+ *    @a data_in.
+ * -# When @a final is true, flush everything held in @a state.
+ *
+ * @param[in]  state         Carry-over state for this stream.
+ * @param[in]  mm            Memory manager for the output.
+ * @param[in]  data_in       Chunk data.  May be NULL if @a dlen_in is 0.
+ * @param[in]  dlen_in       Length of @a data_in.
+ * @param[out] data_out      Output for this chunk.  May be NULL if
+ *                           @a dlen_out is 0.
+ * @param[out] dlen_out      Length of @a data_out.
+ * @param[in]  final         True on the last chunk of the stream.
+ * @param[in]  instance_data Instance data.
+ * @param[in]  cbdata        Callback data.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL if the input cannot be transformed.
+ */
+typedef ib_status_t (* ib_transformation_stream_fn_t)(
+    void           *state,
+    ib_mm_t         mm,
+    const uint8_t  *data_in,
+    size_t          dlen_in,
+    const uint8_t **data_out,
+    size_t         *dlen_out,
+    bool            final,
+    void           *instance_data,
+    void           *cbdata
+)
+NONNULL_ATTRIBUTE(1, 5, 6);
+
 /**
  * Create a transformation.
  *
@@ -165,6 +274,50 @@ ib_status_t DLL_PUBLIC ib_transformation_create(
 )
 NONNULL_ATTRIBUTE(1, 3, 9);
 
+/**
+ * Set the byte-level kernel of a transformation, marking it fusible.
+ *
+ * Call between ib_transformation_create() and
+ * ib_transformation_register(); registered transformations are shared and
+ * must not be mutated.
+ *
+ * @param[in] tfn         Transformation.
+ * @param[in] byte_fn     Byte-level kernel.
+ * @param[in] byte_cbdata Callback data for @a byte_fn.
+ *
+ * @return
+ * - IB_OK on success.
+ */
+ib_status_t DLL_PUBLIC ib_transformation_set_byte_fn(
+    ib_transformation_t         *tfn,
+    ib_transformation_byte_fn_t  byte_fn,
+    void                        *byte_cbdata
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Set the streaming form of a transformation, marking it streamable.
+ *
+ * Call between ib_transformation_create() and
+ * ib_transformation_register(); registered transformations are shared and
+ * must not be mutated.
+ *
+ * @param[in] tfn              Transformation.
+ * @param[in] stream_create_fn Stream state creation function.
+ * @param[in] stream_fn        Streaming function.
+ * @param[in] stream_cbdata    Callback data for both functions.
+ *
+ * @return
+ * - IB_OK on success.
+ */
+ib_status_t DLL_PUBLIC ib_transformation_set_stream_fns(
+    ib_transformation_t                  *tfn,
+    ib_transformation_stream_create_fn_t  stream_create_fn,
+    ib_transformation_stream_fn_t         stream_fn,
+    void                                 *stream_cbdata
+)
+NONNULL_ATTRIBUTE(1, 2, 3);
+
 /**
  * Register a transformation with engine.
  *
@@ -173,7 +326,8 @@ NONNULL_ATTRIBUTE(1, 3, 9);
  *
  * @return
  * - IB_OK on success.
- * - IB_EINVAL if a transformation with same name exists.
+ * - IB_EINVAL if a transformation with same name exists, or if the
+ *   engine configuration is already finished.
  * - IB_EALLOC on memory allocation errors.
  */
 ib_status_t DLL_PUBLIC ib_transformation_register(
@@ -268,6 +422,34 @@ bool DLL_PUBLIC ib_transformation_handle_list(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Fusible accessor.
+ *
+ * @sa ib_transformation_set_byte_fn().
+ *
+ * @param[in] tfn Transformation.
+ *
+ * @return True iff @a tfn has a byte-level kernel.
+ */
+bool DLL_PUBLIC ib_transformation_fusible(
+    const ib_transformation_t *tfn
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Streamable accessor.
+ *
+ * @sa ib_transformation_set_stream_fns().
+ *
+ * @param[in] tfn Transformation.
+ *
+ * @return True iff @a tfn has a streaming form.
+ */
+bool DLL_PUBLIC ib_transformation_streamable(
+    const ib_transformation_t *tfn
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Create a transformation instance.
  *
@@ -348,6 +530,90 @@ ib_status_t DLL_PUBLIC ib_transformation_inst_execute(
 )
 NONNULL_ATTRIBUTE(1, 3, 4);
 
+/**
+ * Execute a run of fusible transformation instances as a single pass.
+ *
+ * @a tfn_inst_node must be a node of a list of
+ * @ref ib_transformation_inst_t, and it and the following
+ * @a num_tfn_insts - 1 nodes must all hold fusible transformations (see
+ * ib_transformation_fusible()).  For a bytestring input the input bytes
+ * are copied into one buffer allocated from @a mm and every byte-level
+ * kernel is run over that buffer in place; no intermediate field or
+ * bytestring is created.  List inputs are unrolled once and each element
+ * is transformed the same way.  The result equals applying the
+ * instances one at a time with ib_transformation_inst_execute().
+ *
+ * @param[in]  tfn_inst_node First node of the run.
+ * @param[in]  num_tfn_insts Number of instances in the run.
+ * @param[in]  mm            Memory manager.
+ * @param[in]  fin           Input data field.
+ * @param[out] fout          Output data field; may be set to @a fin.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL if a field is neither a bytestring nor a list.
+ */
+ib_status_t DLL_PUBLIC ib_transformation_inst_execute_fused(
+    const ib_list_node_t  *tfn_inst_node,
+    size_t                 num_tfn_insts,
+    ib_mm_t                mm,
+    const ib_field_t      *fin,
+    const ib_field_t     **fout
+)
+NONNULL_ATTRIBUTE(1, 4, 5);
+
+/**
+ * Create the stream state for a streamable transformation instance.
+ *
+ * Create one state per stream and pass it to every
+ * ib_transformation_inst_stream_execute() call for that stream.
+ *
+ * @param[in]  tfn_inst Transformation instance.  Must be streamable.
+ * @param[in]  mm       Memory manager with stream lifetime.
+ * @param[out] state    The stream state.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_transformation_inst_stream_state_create(
+    const ib_transformation_inst_t  *tfn_inst,
+    ib_mm_t                          mm,
+    void                           **state
+)
+NONNULL_ATTRIBUTE(1, 3);
+
+/**
+ * Transform one chunk of a stream.
+ *
+ * @param[in]  tfn_inst Transformation instance.  Must be streamable.
+ * @param[in]  state    Stream state from
+ *                      ib_transformation_inst_stream_state_create().
+ * @param[in]  mm       Memory manager for the output.
+ * @param[in]  data_in  Chunk data.  May be NULL if @a dlen_in is 0.
+ * @param[in]  dlen_in  Length of @a data_in.
+ * @param[out] data_out Output for this chunk.
+ * @param[out] dlen_out Length of @a data_out.
+ * @param[in]  final    True on the last chunk; flushes held bytes.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Other on other failure.
+ */
+ib_status_t DLL_PUBLIC ib_transformation_inst_stream_execute(
+    const ib_transformation_inst_t  *tfn_inst,
+    void                            *state,
+    ib_mm_t                          mm,
+    const uint8_t                   *data_in,
+    size_t                           dlen_in,
+    const uint8_t                  **data_out,
+    size_t                          *dlen_out,
+    bool                             final
+)
+NONNULL_ATTRIBUTE(1, 2, 6, 7);
+
 #ifdef __cplusplus
 }
 #endif
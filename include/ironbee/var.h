@@ -21,6 +21,7 @@
 #include <ironbee/field.h>
 #include <ironbee/mm.h>
 #include <ironbee/rule_defs.h>
+#include <ironbee/strintern.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -167,6 +168,19 @@ ib_mm_t DLL_PUBLIC ib_var_config_mm(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Access interning table of @a config.
+ *
+ * Registered source names are canonical copies from this table; any two of
+ * them may be compared by pointer.  Other configuration-time consumers may
+ * intern their own configuration-known names here.  Do not intern names
+ * taken from traffic; the table never shrinks.
+ **/
+ib_strintern_t DLL_PUBLIC *ib_var_config_interns(
+    ib_var_config_t *config
+)
+NONNULL_ATTRIBUTE(1);
+
 /**@}*/
 
 /**
@@ -222,6 +236,67 @@ void ib_var_store_export(
 )
 NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * A snapshot of a var store.
+ *
+ * Records which field each source is bound to, the generation counters,
+ * and the element count of each list value, sharing the field values
+ * themselves with the store.  See ib_var_store_snapshot_take().
+ **/
+typedef struct ib_var_store_snapshot_t ib_var_store_snapshot_t;
+
+/**
+ * Take a snapshot of @a store.
+ *
+ * The snapshot is copy-on-write in the sense that field values are shared,
+ * not duplicated; only the bindings of sources to fields and the lengths
+ * of list values are recorded.  Restoring via ib_var_store_restore() thus
+ * undoes the mutations the var API performs -- rebinding a source
+ * (ib_var_source_set(), ib_var_target_set()) and appending to a list value
+ * (ib_var_source_append()) -- at a cost proportional to the number of
+ * sources, not the amount of data.
+ *
+ * Limitations: element removal and modification of a value's contents in
+ * place, bypassing the var API, are not undone.  Sources are recommended
+ * to mutate only by appending (see ib_var_source_register()), for which
+ * restore is exact.
+ *
+ * @param[in]  store    Store to snapshot.
+ * @param[out] snapshot The new snapshot.
+ * @param[in]  mm       Memory manager to allocate snapshot from.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_var_store_snapshot_take(
+    ib_var_store_t           *store,
+    ib_var_store_snapshot_t **snapshot,
+    ib_mm_t                   mm
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Restore @a store to the state recorded in @a snapshot.
+ *
+ * Rebinds every source to the field it was bound to at snapshot time,
+ * restores the generation counters, and truncates list values that grew
+ * since the snapshot back to their recorded length.  May be called any
+ * number of times, e.g., once per shadow policy pass.
+ *
+ * @param[in] store    Store to restore.  Must be the store @a snapshot was
+ *                     taken from.
+ * @param[in] snapshot Snapshot to restore.
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL if @a snapshot was not taken from @a store.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_var_store_restore(
+    ib_var_store_t                *store,
+    const ib_var_store_snapshot_t *snapshot
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /**@}*/
 
 /**
@@ -279,6 +354,70 @@ ib_status_t DLL_PUBLIC ib_var_source_register(
 )
 NONNULL_ATTRIBUTE(2, 3);
 
+/**
+ * Materialization callback for a lazy var source.
+ *
+ * Called by ib_var_source_get() the first time a lazy source is fetched
+ * from a store.  Should construct the value, e.g., from the transaction
+ * the store belongs to, and output it via @a field.  Outputting NULL is
+ * allowed and means the source has no value; the get then reports
+ * IB_ENOENT.  Either way the callback runs at most once per store.
+ *
+ * @param[out] field  Value of the source.  May be set to NULL.
+ * @param[in]  source Source being materialized.
+ * @param[in]  store  Store being fetched from.
+ * @param[in]  cbdata Callback data.
+ * @return
+ * - IB_OK on success.
+ * - Any other status to fail the get with that status.
+ **/
+typedef ib_status_t (*ib_var_source_lazy_fn_t)(
+    ib_field_t            **field,
+    const ib_var_source_t  *source,
+    ib_var_store_t         *store,
+    void                   *cbdata
+);
+
+/**
+ * Register a lazy var source.
+ *
+ * As ib_var_source_register(), but instead of being populated eagerly at
+ * state transitions, the source materializes its value via @a fn on the
+ * first ib_var_source_get() of each store and caches the result in the
+ * store.  Use for derived values that are expensive to compute and rarely
+ * read.
+ *
+ * Setting the source before its first get suppresses materialization, as
+ * does removing it (the value is not resurrected).
+ *
+ * @param[out] source        Source acquired.  Will have lifetime equal to
+ *                           @a config.  May be NULL.
+ * @param[in]  config        Var configuration to acquire source for.
+ * @param[in]  name          Name of source.
+ * @param[in]  name_length   Length of @a name.
+ * @param[in]  initial_phase First phase source has meaningful value in.
+ * @param[in]  final_phase   Last phase source may change value in.  Must be
+ *                           IB_PHASE_NONE or after @a initial_phase.
+ * @param[in]  fn            Materialization callback.
+ * @param[in]  cbdata        Callback data for @a fn.
+ * @return
+ * - IB_OK on success.
+ * - IB_EEXIST if a source named @a name already exists.
+ * - IB_EINVAL if @a initial_phase is after @a final_phase.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_var_source_register_lazy(
+    ib_var_source_t         **source,
+    ib_var_config_t          *config,
+    const char               *name,
+    size_t                    name_length,
+    ib_rule_phase_num_t       initial_phase,
+    ib_rule_phase_num_t       final_phase,
+    ib_var_source_lazy_fn_t   fn,
+    void                     *cbdata
+)
+NONNULL_ATTRIBUTE(2, 3, 7);
+
 /** Access config of @a source. */
 const ib_var_config_t DLL_PUBLIC *ib_var_source_config(
     const ib_var_source_t *source
@@ -363,6 +502,36 @@ ib_status_t DLL_PUBLIC ib_var_source_get_const(
     const ib_var_store_t   *store
 );
 
+/**
+ * Fetch the generation of an indexed source in a store.
+ *
+ * A store keeps a counter per indexed source that is advanced every time
+ * the source is changed through the var API: ib_var_source_set(),
+ * ib_var_source_append(), ib_var_target_set(), and ib_var_target_remove().
+ * Comparing generations observed at two points in time answers "has this
+ * source been changed since?" without fetching or comparing values.  A
+ * source that has never been set has generation 0.
+ *
+ * Note that modifying a field's value directly, bypassing the var API,
+ * does not advance the generation.
+ *
+ * This function is fast (small constant).
+ *
+ * @param[in]  source     Source to fetch generation of.  Must be indexed.
+ * @param[in]  store      Store to fetch generation from.
+ * @param[out] generation Where to store the generation.
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL if @a source is from a different var configuration than
+ *   @a store or is not indexed.
+ **/
+ib_status_t DLL_PUBLIC ib_var_source_generation(
+    const ib_var_source_t *source,
+    const ib_var_store_t  *store,
+    uint32_t              *generation
+)
+NONNULL_ATTRIBUTE(1, 2, 3);
+
 /**
  * Set the value of a source in a store.
  *
@@ -398,6 +567,44 @@ ib_status_t DLL_PUBLIC ib_var_source_set(
 )
 NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * A source and value pair for ib_var_source_set_many().
+ **/
+struct ib_var_source_set_pair_t {
+    const ib_var_source_t *source; /**< Source to set. */
+    ib_field_t            *field;  /**< Value to set it to.  May be NULL. */
+};
+typedef struct ib_var_source_set_pair_t ib_var_source_set_pair_t;
+
+/**
+ * Set the values of several sources in a store in one pass.
+ *
+ * Equivalent to calling ib_var_source_set() for each pair in order, except
+ * that all pairs are validated against @a store before anything is written,
+ * so a bad pair cannot leave the store partially populated.  Intended for
+ * parser population paths that set many sources back to back, e.g. at
+ * transaction start.
+ *
+ * As with ib_var_source_set(), the generation of each written source
+ * advances once.
+ *
+ * @param[in] store     Store to set values in.
+ * @param[in] pairs     Pairs of source and value to set.  May be NULL iff
+ *                      @a num_pairs is 0.
+ * @param[in] num_pairs Number of pairs.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL if any pair has a NULL source or a source from a different
+ *   var configuration than @a store; in this case nothing is written.
+ **/
+ib_status_t DLL_PUBLIC ib_var_source_set_many(
+    ib_var_store_t                 *store,
+    const ib_var_source_set_pair_t *pairs,
+    size_t                          num_pairs
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Acquire a var source.
  *
@@ -665,6 +872,21 @@ ib_var_source_t DLL_PUBLIC *ib_var_target_source(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Is @a target only a source?
+ *
+ * A trivial target has neither a filter nor an expansion: gets and sets
+ * of it behave exactly like gets and sets of its source.
+ *
+ * @param[in] target The target to query.
+ *
+ * @returns true iff @a target has neither a filter nor an expansion.
+ */
+bool DLL_PUBLIC ib_var_target_trivial(
+    const ib_var_target_t *target
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Acquire a target from a specification string.
  *
@@ -720,7 +942,15 @@ NONNULL_ATTRIBUTE(1, 2, 3);
  * The lifetime of @a result will depend on the value.  For non-filtered
  * list fields, the underlying value will be reported directly and @a result
  * will have lifetime equal to that field.  For all other results, the
- * lifetime will equal that of @a mp.
+ * lifetime will be at least that of @a mp.
+ *
+ * Resolutions of targets with a constant (non-expand) filter against an
+ * indexed, non-dynamic list source are cached in @a store: repeated gets
+ * of the same target reuse the previous result, without re-scanning the
+ * collection, until the source changes.  Change is detected via the
+ * source's generation counter (see ib_var_source_generation()) together
+ * with the identity and element count of its value, so both sets through
+ * the var API and in-place growth of the list invalidate the cache.
  *
  * @param[in]  target Target to get values of.
  * @param[out] result Fetched values.  Lifetime will vary.  See above.
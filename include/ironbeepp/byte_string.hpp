@@ -35,6 +35,8 @@
 #include <ironbeepp/exception.hpp>
 #include <ironbeepp/memory_manager.hpp>
 
+#include <boost/range/iterator_range.hpp>
+
 #include <ostream>
 
 // IronBee C
@@ -44,6 +46,18 @@ namespace IronBee {
 
 class ByteString;
 
+/**
+ * Non-owning view of constant memory.
+ *
+ * A span is a pointer/length pair for memory owned elsewhere, usually an
+ * engine structure whose lifetime exceeds the span's use.  Accessors
+ * returning spans do not copy and thus do not allocate; use them on
+ * per-transaction paths in preference to the @c std::string conveniences.
+ *
+ * This is the same representation ParserSuite uses for its results.
+ **/
+typedef boost::iterator_range<const char*> span_t;
+
 /**
  * Const Byte String; equivalent to a const pointer to ib_bytestr_t.
  *
@@ -126,6 +140,17 @@ public:
      **/
     std::string to_s() const;
 
+    /**
+     * Create span version.
+     *
+     * In contrast to to_s(), this aliases the byte string's data rather
+     * than copying it, so it performs no allocation.  The span is valid
+     * only as long as the underlying byte string.
+     *
+     * @returns span aliasing the byte string's data.
+     **/
+    span_t to_span() const;
+
     /**
      * Memory manager.
      *
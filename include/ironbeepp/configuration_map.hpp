@@ -37,8 +37,10 @@
 #define __IBPP__CONFIGURATION_MAP__
 
 #include <ironbeepp/abi_compatibility.hpp>
+#include <ironbeepp/context.hpp>
 #include <ironbeepp/field.hpp>
 #include <ironbeepp/memory_manager.hpp>
+#include <ironbeepp/throw.hpp>
 
 #include <ironbee/cfgmap.h>
 
@@ -589,6 +591,171 @@ private:
     std::list<ib_cfgmap_init_t> m_inits;
 };
 
+namespace Internal {
+/// @cond Internal
+
+/**
+ * Traits mapping entry value types to field types and accessors.
+ *
+ * The primary template is intentionally undefined; only the value types
+ * supported by configuration maps are specialized, so using an
+ * unsupported type fails at compile time.
+ **/
+template <typename T>
+struct configuration_map_entry_traits;
+
+template <>
+struct configuration_map_entry_traits<int64_t>
+{
+    static Field::type_e field_type() { return Field::NUMBER; }
+    static int64_t get(ConstField field) { return field.value_as_number(); }
+    static void set(Field field, int64_t value) { field.set_number(value); }
+};
+
+template <>
+struct configuration_map_entry_traits<long double>
+{
+    static Field::type_e field_type() { return Field::FLOAT; }
+    static long double get(ConstField field) { return field.value_as_float(); }
+    static void set(Field field, long double value)
+    {
+        field.set_float(value);
+    }
+};
+
+template <>
+struct configuration_map_entry_traits<const char*>
+{
+    static Field::type_e field_type() { return Field::NULL_STRING; }
+    static const char* get(ConstField field)
+    {
+        return field.value_as_null_string();
+    }
+    static void set(Field field, const char* value)
+    {
+        field.set_null_string(value);
+    }
+};
+
+template <>
+struct configuration_map_entry_traits<ConstByteString>
+{
+    static Field::type_e field_type() { return Field::BYTE_STRING; }
+    static ConstByteString get(ConstField field)
+    {
+        return field.value_as_byte_string();
+    }
+    static void set(Field field, ConstByteString value)
+    {
+        field.set_byte_string(value);
+    }
+};
+
+/// @endcond
+} // Internal
+
+/**
+ * Resolved configuration map entry.
+ *
+ * ib_cfgmap_get() and ib_cfgmap_set() look the entry name up in a hash on
+ * every access and then dispatch through generic handler trampolines.
+ * The entry and its type are almost always known at compile time, so code
+ * accessing an entry repeatedly should resolve it once --- typically when
+ * the owning directive or module is initialized --- and keep the resolved
+ * entry, whose get() and set() go directly to the entry's storage.
+ *
+ * The value type is selected by the template parameter and checked against
+ * the entry at resolution time rather than per access.
+ *
+ * @tparam T Value type of entry: int64_t (number), long double (real),
+ *         const char* (null string), or ConstByteString (byte string).
+ *         Any other type fails to compile.
+ **/
+template <typename T>
+class ConfigurationMapEntry
+{
+public:
+    //! Value type of entry.
+    typedef T value_t;
+
+    /**
+     * Construct singular ConfigurationMapEntry.
+     *
+     * All behavior of a singular entry is undefined except for assignment
+     * and copying.
+     **/
+    ConfigurationMapEntry()
+    {
+        // nop
+    }
+
+    /**
+     * Resolve entry @a name of configuration map @a cm.
+     *
+     * The entry remains valid as long as the configuration map.
+     *
+     * @param[in] cm   Configuration map to resolve in.
+     * @param[in] name Name of entry.
+     * @throws enoent if there is no entry named @a name.
+     * @throws einval if the entry's type does not match @a T.
+     **/
+    ConfigurationMapEntry(ib_cfgmap_t* cm, const char* name)
+    {
+        ib_field_t* f = NULL;
+        throw_if_error(ib_cfgmap_entry(cm, name, &f));
+        check_and_assign(f);
+    }
+
+    /**
+     * Resolve entry @a name of the configuration map of @a context.
+     *
+     * As above, but resolves in a configuration context, as with
+     * ib_context_config_entry().
+     *
+     * @param[in] context Context to resolve in.
+     * @param[in] name    Name of entry.
+     * @throws enoent if there is no entry named @a name.
+     * @throws einval if the entry's type does not match @a T.
+     **/
+    ConfigurationMapEntry(Context context, const char* name)
+    {
+        ib_field_t* f = NULL;
+        throw_if_error(ib_context_config_entry(context.ib(), name, &f));
+        check_and_assign(f);
+    }
+
+    //! Value of entry; no name lookup.
+    T get() const
+    {
+        return Internal::configuration_map_entry_traits<T>::get(m_field);
+    }
+
+    //! Set value of entry; no name lookup.
+    void set(T value) const
+    {
+        Internal::configuration_map_entry_traits<T>::set(m_field, value);
+    }
+
+private:
+    void check_and_assign(ib_field_t* f)
+    {
+        m_field = Field(f);
+        if (
+            m_field.type() !=
+            Internal::configuration_map_entry_traits<T>::field_type()
+        ) {
+            BOOST_THROW_EXCEPTION(
+                einval() << errinfo_what(
+                    "Configuration map entry type does not match "
+                    "requested type."
+                )
+            );
+        }
+    }
+
+    Field m_field;
+};
+
 // Implementation.
 
 namespace Internal {
@@ -225,6 +225,9 @@ public:
     //! Name as string.
     std::string name_as_s() const;
 
+    //! Name as span; aliases the field's name, no allocation.
+    span_t name_as_span() const;
+
     //! Type of field.
     type_e type() const;
 
@@ -240,6 +243,20 @@ public:
      **/
     std::string to_s() const;
 
+    /**
+     * Create span version of value.
+     *
+     * In contrast to to_s(), this aliases the value rather than copying
+     * it, so it performs no allocation.  As it cannot format, it is
+     * limited to string-valued fields; other types throw einval.  The
+     * span is valid only as long as the underlying field value.
+     *
+     * @returns span aliasing the value of a NULL_STRING or BYTE_STRING
+     *          field.
+     * @throws einval for any other field type.
+     **/
+    span_t value_as_span() const;
+
     //! True if field is dynamic.
     bool is_dynamic() const;
 
@@ -321,6 +338,41 @@ public:
     ) const;
     ///@}
 
+    /**
+     * @name Exception-free Value Getters
+     * Query the value without exceptions.
+     *
+     * These behave as the corresponding value getters above, but report
+     * failure as a status code rather than an exception, and never
+     * allocate.  They are intended for hot paths where a type mismatch
+     * is an expected outcome rather than an error.
+     **/
+    ///@{
+
+    /**
+     * Number value accessor without exceptions.
+     *
+     * @param[out] value Set to the value on IB_OK; untouched otherwise.
+     * @returns
+     * - IB_OK on success.
+     * - IB_EINVAL if the field is not a NUMBER field.
+     * - Other status code from the underlying C API.
+     **/
+    ib_status_t try_value_as_number(int64_t& value) const;
+
+    //! As try_value_as_number() but for TIME fields.
+    ib_status_t try_value_as_time(uint64_t& value) const;
+
+    //! As try_value_as_number() but for FLOAT fields.
+    ib_status_t try_value_as_float(long double& value) const;
+
+    //! As try_value_as_number() but for NULL_STRING fields.
+    ib_status_t try_value_as_null_string(const char*& value) const;
+
+    //! As try_value_as_number() but for BYTE_STRING fields.
+    ib_status_t try_value_as_byte_string(ConstByteString& value) const;
+    ///@}
+
     /**
      * @name C Interoperability
      * Methods to access underlying C types.
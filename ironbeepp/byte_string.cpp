@@ -85,6 +85,12 @@ std::string ConstByteString::to_s() const
     return std::string(const_data(), length());
 }
 
+span_t ConstByteString::to_span() const
+{
+    const char* data = const_data();
+    return span_t(data, data + length());
+}
+
 MemoryManager ConstByteString::memory_manager() const
 {
     return MemoryManager(ib_bytestr_mm(ib()));
@@ -444,6 +444,12 @@ std::string ConstField::name_as_s() const
     return std::string(name(), name_length());
 }
 
+span_t ConstField::name_as_span() const
+{
+    const char* data = name();
+    return span_t(data, data + name_length());
+}
+
 ConstField::type_e ConstField::type() const
 {
     return static_cast<ConstField::type_e>(ib()->type);
@@ -478,6 +484,25 @@ std::string ConstField::to_s() const
     }
 }
 
+span_t ConstField::value_as_span() const
+{
+    switch (type()) {
+        case NULL_STRING: {
+            const char* v = value_as_null_string();
+            return span_t(v, v + strlen(v));
+        }
+        case BYTE_STRING:
+            return value_as_byte_string().to_span();
+        default:
+            BOOST_THROW_EXCEPTION(
+                einval() << errinfo_what(
+                    "ConstField::value_as_span() does not support field "
+                    "type: " + Internal::type_as_s(type())
+                )
+            );
+    }
+}
+
 bool ConstField::is_dynamic() const
 {
     return ib_field_is_dynamic(ib()) == 1;
@@ -622,6 +647,71 @@ ConstByteString ConstField::value_as_byte_string(
     return ConstByteString(v);
 }
 
+ib_status_t ConstField::try_value_as_number(int64_t& value) const
+{
+    if (type() != NUMBER) {
+        return IB_EINVAL;
+    }
+    int64_t v;
+    ib_status_t rc = ib_field_value(ib(), ib_ftype_num_out(&v));
+    if (rc == IB_OK) {
+        value = v;
+    }
+    return rc;
+}
+
+ib_status_t ConstField::try_value_as_time(uint64_t& value) const
+{
+    if (type() != TIME) {
+        return IB_EINVAL;
+    }
+    uint64_t v;
+    ib_status_t rc = ib_field_value(ib(), ib_ftype_time_out(&v));
+    if (rc == IB_OK) {
+        value = v;
+    }
+    return rc;
+}
+
+ib_status_t ConstField::try_value_as_float(long double& value) const
+{
+    if (type() != FLOAT) {
+        return IB_EINVAL;
+    }
+    long double v;
+    ib_status_t rc = ib_field_value(ib(), ib_ftype_float_out(&v));
+    if (rc == IB_OK) {
+        value = v;
+    }
+    return rc;
+}
+
+ib_status_t ConstField::try_value_as_null_string(const char*& value) const
+{
+    if (type() != NULL_STRING) {
+        return IB_EINVAL;
+    }
+    const char* v;
+    ib_status_t rc = ib_field_value(ib(), ib_ftype_nulstr_out(&v));
+    if (rc == IB_OK) {
+        value = v;
+    }
+    return rc;
+}
+
+ib_status_t ConstField::try_value_as_byte_string(ConstByteString& value) const
+{
+    if (type() != BYTE_STRING) {
+        return IB_EINVAL;
+    }
+    const ib_bytestr_t* v;
+    ib_status_t rc = ib_field_value(ib(), ib_ftype_bytestr_out(&v));
+    if (rc == IB_OK) {
+        value = ConstByteString(v);
+    }
+    return rc;
+}
+
 /* Field */
 
 // See api documentation for discussion of const_cast.
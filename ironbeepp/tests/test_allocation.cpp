@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee++ Internals --- Allocation Tests
+ *
+ * Verifies that the span and try_ accessors of ConstByteString and
+ * ConstField stay off the heap, in contrast to their std::string and
+ * throwing counterparts.  The global allocation operators are replaced
+ * with counting versions, so these tests must stay in their own binary.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ **/
+
+#include <ironbeepp/byte_string.hpp>
+#include <ironbeepp/field.hpp>
+#include <ironbeepp/memory_pool.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace std;
+using IronBee::ByteString;
+using IronBee::ConstByteString;
+using IronBee::Field;
+using IronBee::MemoryPool;
+using IronBee::span_t;
+
+namespace {
+
+size_t g_num_allocations = 0;
+
+}
+
+void* operator new(size_t size)
+{
+    ++g_num_allocations;
+    void* p = malloc(size);
+    if (! p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    ++g_num_allocations;
+    void* p = malloc(size);
+    if (! p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+class TestAllocation : public ::testing::Test
+{
+public:
+    TestAllocation()
+    {
+        m_pool = MemoryPool::create();
+        // Long enough to defeat any small string optimization.
+        m_data.assign(64, 'x');
+        m_bs = ByteString::create(m_pool, m_data);
+        m_field = Field::create_byte_string(
+            m_pool,
+            "test_allocation", 15,
+            m_bs
+        );
+    }
+
+    ~TestAllocation()
+    {
+        m_pool.destroy();
+    }
+
+protected:
+    MemoryPool m_pool;
+    string     m_data;
+    ByteString m_bs;
+    Field      m_field;
+};
+
+TEST_F(TestAllocation, ByteStringToSpan)
+{
+    static const size_t c_iterations = 1000;
+
+    size_t before = g_num_allocations;
+    for (size_t i = 0; i < c_iterations; ++i) {
+        span_t span = m_bs.to_span();
+        ASSERT_EQ(m_data.length(), size_t(span.size()));
+    }
+    EXPECT_EQ(before, g_num_allocations);
+
+    // The std::string conversion allocates every call.
+    before = g_num_allocations;
+    for (size_t i = 0; i < c_iterations; ++i) {
+        string s = m_bs.to_s();
+        ASSERT_EQ(m_data.length(), s.length());
+    }
+    EXPECT_LE(before + c_iterations, g_num_allocations);
+}
+
+TEST_F(TestAllocation, FieldNameAsSpan)
+{
+    size_t before = g_num_allocations;
+    span_t name = m_field.name_as_span();
+    EXPECT_EQ(before, g_num_allocations);
+    EXPECT_EQ(string(name.begin(), name.end()), "test_allocation");
+}
+
+TEST_F(TestAllocation, FieldValueAsSpan)
+{
+    size_t before = g_num_allocations;
+    span_t value = m_field.value_as_span();
+    EXPECT_EQ(before, g_num_allocations);
+    EXPECT_EQ(m_data, string(value.begin(), value.end()));
+}
+
+TEST_F(TestAllocation, TryValueGetters)
+{
+    ConstByteString value;
+    int64_t         number = 0;
+
+    size_t before = g_num_allocations;
+    ASSERT_EQ(IB_OK, m_field.try_value_as_byte_string(value));
+    // Type mismatch is a status code, not an exception, and costs nothing.
+    ASSERT_EQ(IB_EINVAL, m_field.try_value_as_number(number));
+    EXPECT_EQ(before, g_num_allocations);
+
+    EXPECT_EQ(m_data.length(), value.length());
+}
@@ -508,3 +508,41 @@ TEST_F(TestConfigurationMap, TestHandle)
     cfgmap_set<ib_num_t>(cm, "s", 19);
     EXPECT_EQ(19, data.s);
 }
+
+TEST_F(TestConfigurationMap, ResolvedEntry)
+{
+    ib_module_t ib_module;
+    ib_module.ib = m_engine.ib();
+    IronBee::Module m(&ib_module);
+    IronBee::MemoryManager mm = m_engine.main_memory_mm();
+
+    IronBee::ConfigurationMapInit<test_data_t> cmi(m.ib()->cm_init, mm);
+
+    cmi.number("s", &test_data_t::s);
+    cmi.null_string("n", &test_data_t::n);
+    cmi.finish();
+
+    test_data_t data;
+    ib_cfgmap_t* cm = setup_cfgmap(ib_module.cm_init, &data);
+    ASSERT_TRUE(cm);
+
+    // Resolved once; accesses skip the name lookup thereafter.
+    IronBee::ConfigurationMapEntry<int64_t> s_entry(cm, "s");
+    data.s = 13;
+    EXPECT_EQ(13, s_entry.get());
+    s_entry.set(19);
+    EXPECT_EQ(19, data.s);
+
+    IronBee::ConfigurationMapEntry<const char*> n_entry(cm, "n");
+    data.n = "Hello World";
+    EXPECT_EQ(string("Hello World"), n_entry.get());
+
+    EXPECT_THROW(
+        IronBee::ConfigurationMapEntry<int64_t>(cm, "xyzzy"),
+        IronBee::enoent
+    );
+    EXPECT_THROW(
+        IronBee::ConfigurationMapEntry<int64_t>(cm, "n"),
+        IronBee::einval
+    );
+}
@@ -0,0 +1,207 @@
+-- =========================================================================
+-- Licensed to Qualys, Inc. (QUALYS) under one or more
+-- contributor license agreements.  See the NOTICE file distributed with
+-- this work for additional information regarding copyright ownership.
+-- QUALYS licenses this file to You under the Apache License, Version 2.0
+-- (the "License"); you may not use this file except in compliance with
+-- the License.  You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing, software
+-- distributed under the License is distributed on an "AS IS" BASIS,
+-- WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+-- See the License for the specific language governing permissions and
+-- limitations under the License.
+--
+-- =========================================================================
+
+-------------------------------------------------------------------
+-- IronBee - Byte String View.
+--
+-- A zero-copy view of an @c ib_bytestr_t as (pointer, length) cdata.
+--
+-- Converting a byte string field to a Lua string interns a copy of the
+-- value; for rules that only examine values (length checks, prefix
+-- tests, substring scans) that copy is pure overhead.  A view aliases
+-- the underlying transaction memory instead and only copies when
+-- tostring() is called explicitly.
+--
+-- Views alias memory owned by the transaction.  They MUST NOT be stored
+-- beyond the event handler they were obtained in; call tostring() to
+-- make a durable Lua string first.
+--
+-- @module ironbee.bytestrview
+--
+-- @copyright Qualys, Inc., 2010-2015
+-- @license Apache License, Version 2.0
+-------------------------------------------------------------------
+
+local ffi = require('ffi')
+
+-- Not part of the generated IronBee FFI header; ignore a redefinition.
+pcall(ffi.cdef, "size_t strlen(const char *s);")
+
+local M = {}
+M.__index = M
+
+-------------------------------------------------------------------
+-- Create a view of a memory region.
+--
+-- @tparam bytestrview self Module table.
+-- @tparam cdata[const char*] ptr Start of the region.
+-- @tparam number len Length of the region in bytes.
+--
+-- @return New view aliasing [ptr, ptr+len).
+-------------------------------------------------------------------
+M.new = function(self, ptr, len)
+    local o = {
+        ptr = ffi.cast("const unsigned char*", ptr),
+        len = tonumber(len)
+    }
+
+    return setmetatable(o, self)
+end
+
+-------------------------------------------------------------------
+-- Create a view of an @c ib_bytestr_t.
+--
+-- @tparam bytestrview self Module table.
+-- @tparam cdata[const ib_bytestr_t*] bs Byte string to view.
+--
+-- @return New view aliasing the byte string's data.
+-------------------------------------------------------------------
+M.of_bytestr = function(self, bs)
+    return self:new(
+        ffi.C.ib_bytestr_const_ptr(bs),
+        ffi.C.ib_bytestr_length(bs))
+end
+
+-------------------------------------------------------------------
+-- The length of the viewed data in bytes.
+--
+-- @tparam bytestrview self The view.
+--
+-- @return Length in bytes.
+-------------------------------------------------------------------
+M.length = function(self)
+    return self.len
+end
+
+-------------------------------------------------------------------
+-- The byte at index @a i as a number.
+--
+-- @tparam bytestrview self The view.
+-- @tparam number i Index, 1-based as string.byte().
+--
+-- @return Byte value or nil if out of range.
+-------------------------------------------------------------------
+M.byte = function(self, i)
+    if i < 1 or i > self.len then
+        return nil
+    end
+
+    return self.ptr[i-1]
+end
+
+-------------------------------------------------------------------
+-- A sub-view of bytes @a i through @a j, without copying.
+--
+-- @tparam bytestrview self The view.
+-- @tparam number i Start index, 1-based.
+-- @tparam number j End index, inclusive. Defaults to the view length.
+--
+-- @return New view aliasing the same memory.
+-------------------------------------------------------------------
+M.sub = function(self, i, j)
+    j = j or self.len
+    if i < 1 then
+        i = 1
+    end
+    if j > self.len then
+        j = self.len
+    end
+    if i > j then
+        return M:new(self.ptr, 0)
+    end
+
+    return M:new(self.ptr + (i-1), j - i + 1)
+end
+
+-------------------------------------------------------------------
+-- Compare the viewed bytes against a Lua string without interning.
+--
+-- @tparam bytestrview self The view.
+-- @tparam string s String to compare against.
+--
+-- @return True if the bytes equal @a s.
+-------------------------------------------------------------------
+M.eq = function(self, s)
+    if self.len ~= #s then
+        return false
+    end
+
+    for i = 1, self.len do
+        if self.ptr[i-1] ~= s:byte(i) then
+            return false
+        end
+    end
+
+    return true
+end
+
+-------------------------------------------------------------------
+-- Find a Lua string in the viewed bytes without interning.
+--
+-- A plain byte search; no patterns. The scan loop is trivially
+-- JIT-compiled, so this avoids both the copy and NUL-termination
+-- issues of string.find on interned values.
+--
+-- @tparam bytestrview self The view.
+-- @tparam string needle Bytes to search for.
+-- @tparam number init Start index, 1-based. Defaults to 1.
+--
+-- @return Index of the first occurrence or nil.
+-------------------------------------------------------------------
+M.find = function(self, needle, init)
+    local nlen = #needle
+    local first = init or 1
+
+    if nlen == 0 then
+        return first
+    end
+
+    for i = first, self.len - nlen + 1 do
+        if self.ptr[i-1] == needle:byte(1) then
+            local match = true
+            for k = 2, nlen do
+                if self.ptr[i+k-2] ~= needle:byte(k) then
+                    match = false
+                    break
+                end
+            end
+            if match then
+                return i
+            end
+        end
+    end
+
+    return nil
+end
+
+-------------------------------------------------------------------
+-- Copy the viewed bytes into a real Lua string.
+--
+-- This is the only operation that interns a copy.
+--
+-- @tparam bytestrview self The view.
+--
+-- @return The viewed bytes as a Lua string.
+-------------------------------------------------------------------
+M.tostring = function(self)
+    return ffi.string(self.ptr, self.len)
+end
+
+M.__tostring = M.tostring
+
+return M
@@ -32,6 +32,7 @@
 local ibutil = require('ironbee/util')
 local ffi = require('ffi')
 local ibcutil = require('ibcutil')
+local bytestrview = require('ironbee/bytestrview')
 
 local M = {}
 M.__index = M
@@ -131,6 +132,47 @@ M.fieldToLua = function(self, field)
     end
 end
 
+-------------------------------------------------------------------
+-- Convert an IronBee field to a Lua type without copying strings.
+--
+-- As fieldToLua(), but byte string and NUL-string fields are returned
+-- as zero-copy ironbee.bytestrview views instead of interned Lua
+-- strings. Views alias transaction memory and must not outlive the
+-- event handler; call tostring() on a view for a durable copy.
+--
+-- @tparam engine self Engine object.
+-- @tparam cdata[ib_field_t*] field IronBee C field.
+--
+-- @return Value of the field as a Lua type or bytestrview.
+-------------------------------------------------------------------
+M.fieldToView = function(self, field)
+
+    if field == nil then
+        return nil
+    elseif not ffi.istype("ib_field_t*", field) then
+        self:logError(
+            "Cdata type  ib_field_t * exepcted. Got %s",
+            tostring(field))
+        return nil
+
+    -- Byte String
+    elseif field.type == ffi.C.IB_FTYPE_BYTESTR then
+        local value = ffi.new("const ib_bytestr_t*[1]")
+        ffi.C.ib_field_value(field, value)
+        return bytestrview:of_bytestr(value[0])
+
+    -- String
+    elseif field.type == ffi.C.IB_FTYPE_NULSTR then
+        local value = ffi.new("const char*[1]")
+        ffi.C.ib_field_value(field, value)
+        return bytestrview:new(value[0], ffi.C.strlen(value[0]))
+
+    -- Everything else copies no string data; share fieldToLua().
+    else
+        return self:fieldToLua(field)
+    end
+end
+
 -------------------------------------------------------------------
 -- Log a formatted error using the IronBee logger.
 --
@@ -396,6 +396,77 @@ M.get = function(self, name)
     return v
 end
 
+-- Get values from the transaction's data instance without copying.
+--
+-- As get(), but byte string and string values are returned as zero-copy
+-- ironbee.bytestrview views instead of interned Lua strings. Views alias
+-- transaction memory and must not be stored beyond the current event
+-- handler; call tostring() on a view for a durable copy.
+--
+-- Body-inspecting rules should prefer this over get() as it avoids
+-- copying every value examined.
+--
+-- @param[in] name The target to fetch all values for.
+--
+-- @returns A value, view, or list of { name, value-or-view } pairs.
+M.getView = function(self, name)
+    local rc
+    local ib_tx     = ffi.cast("ib_tx_t *", self.ib_tx)
+    local ib_list   = ffi.new("ib_list_t*[1]")
+    local ib_field  = ffi.new("ib_field_t*[1]")
+    local ib_target = self:getVarTarget(name)
+    local ib_source = ffi.C.ib_var_target_source(ib_target)
+
+    rc = ffi.C.ib_var_source_get(
+        ib_source,
+        ib_field,
+        ib_tx.var_store)
+    if rc == ffi.C.IB_ENOENT then
+        return nil
+    elseif rc ~= ffi.C.IB_OK then
+        error("Failed to get source of target "..name)
+    end
+
+    rc = ffi.C.ib_var_target_get_const(
+        ib_target,
+        ffi.cast("const ib_list_t**", ib_list),
+        ib_tx.mm,
+        ib_tx.var_store)
+    if rc == ffi.C.IB_ENOENT then
+        return nil
+    elseif rc ~= ffi.C.IB_OK then
+        self:logError(
+            "Could not get value for %s: %s",
+            name,
+            ffi.string(ffi.C.ib_status_to_string(rc)))
+    end
+
+    -- See get() for why ib_list, not ib_field, is used here.
+    if ib_field[0].type ~= ffi.C.IB_FTYPE_LIST then
+        local node = ffi.C.ib_list_first(ib_list[0])
+        local data = ffi.C.ib_list_node_data(node)
+        return self:fieldToView(ffi.cast("ib_field_t*", data))
+    end
+
+    local v = {}
+    if ib_list[0] ~= nil then
+        ibutil.each_list_node(
+            ib_list[0],
+            function(f)
+                table.insert(
+                    v,
+                    {
+                        ffi.string(f.name, f.nlen),
+                        self:fieldToView(f)
+                    }
+                )
+            end
+        )
+    end
+
+    return v
+end
+
 -- Given a field name, this will return a list of the field names
 -- contained in it. If the requested field is a string or an integer, then
 -- a single element list containing name is returned.
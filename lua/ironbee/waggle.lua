@@ -146,8 +146,16 @@ M.StrRule = function(self, rule_id, rule_version)
     return sig
 end
 
+-- Plan loaded from a compiled plan image, if any. When set, M.Plan
+-- returns it instead of running the Planner.
+M.PRECOMPILED_PLAN = nil
+
 -- Return a valid plan against the default database.
 M.Plan = function()
+    if M.PRECOMPILED_PLAN then
+        return M.PRECOMPILED_PLAN
+    end
+
     local p = Planner:new()
     local r = p:plan(M.DEFAULT_RULE_DB)
     if r == nil then
@@ -157,6 +165,42 @@ M.Plan = function()
     end
 end
 
+-- Compile the default database into a plan image.
+--
+-- The image holds the plan and every rule it references, so loading it
+-- with M.LoadCompiled restores both without replanning. This is meant to
+-- run offline (e.g. in policy CI) so engines only validate and build.
+--
+-- @returns The JSON image as a string. Raises an error when planning
+--          fails.
+M.Compile = function()
+    local Compiler = require('ironbee/waggle/compiler')
+
+    local image, err = Compiler:new():compile(M.DEFAULT_RULE_DB)
+    if image == nil then
+        error(err)
+    end
+
+    return image
+end
+
+-- Load a compiled plan image into the default database.
+--
+-- Rules in the image are added to the default database and the stored
+-- plan is used by M.Plan in place of running the Planner.
+--
+-- @param[in] json The JSON image string produced by M.Compile.
+M.LoadCompiled = function(self, json)
+    local Compiler = require('ironbee/waggle/compiler')
+
+    -- Allow for calling M:LoadCompiled or M.LoadCompiled.
+    if type(self) == 'string' then
+        json = self
+    end
+
+    M.PRECOMPILED_PLAN = Compiler:new():load(json, M.DEFAULT_RULE_DB)
+end
+
 M.Generate = function()
     local g = Generator:new()
     return g:generate(M.Plan(), M.DEFAULT_RULE_DB)
@@ -186,6 +230,7 @@ end
 -- Clear the default rule database.
 M.clear_rule_db = function(self)
     M.DEFAULT_RULE_DB:clear()
+    M.PRECOMPILED_PLAN = nil
 end
 
 -- Iterate over all tags.
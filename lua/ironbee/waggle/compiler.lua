@@ -0,0 +1,209 @@
+#!/usr/bin/lua
+
+--[[--------------------------------------------------------------------------
+-- Licensed to Qualys, Inc. (QUALYS) under one or more
+-- contributor license agreements.  See the NOTICE file distributed with
+-- this work for additional information regarding copyright ownership.
+-- QUALYS licenses this file to You under the Apache License, Version 2.0
+-- (the "License"); you may not use this file except in compliance with
+-- the License.  You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing, software
+-- distributed under the License is distributed on an "AS IS" BASIS,
+-- WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+-- See the License for the specific language governing permissions and
+-- limitations under the License.
+--]]--------------------------------------------------------------------------
+
+--
+-- IronBee Waggle --- Compiler
+--
+-- Compile a rule database into a plan image, a JSON document holding the
+-- planned rule execution order together with every rule the plan
+-- references. Building the image runs the Planner once, offline; loading
+-- the image restores the database and the plan without replanning, so an
+-- engine that loads an image skips the planning work on every reload.
+--
+-- @author Sam Baskinger <sbaskinger@qualys.com>
+
+-- ###########################################################################
+-- Compiler - compile a rule database into a plan image.
+-- ###########################################################################
+local ibjson = require('ibjson')
+local Planner = require('ironbee/waggle/planner')
+local Compiler = {}
+Compiler.__index = Compiler
+Compiler.type = 'compiler'
+Compiler.new = function(self)
+    local c = {}
+    return setmetatable(c, self)
+end
+
+-- Image format version. Bumped when the image layout changes.
+Compiler.FORMAT_VERSION = 1
+
+-- Serialize a single rule into a plain table.
+--
+-- Unlike GeneratorJSON, which emits rules for human consumption, this
+-- keeps every field that config/build_rule.lua reads, so a loaded rule
+-- builds exactly as the original would have.
+--
+-- @param[in] self The compiler.
+-- @param[in] rule The waggle rule object.
+--
+-- @returns A table suitable for JSON encoding.
+Compiler.compile_rule = function(self, rule)
+    local t = {
+        id                   = rule.data.id,
+        version              = rule.data.version,
+        rule_type            = rule.data.rule_type,
+        op                   = rule.data.op,
+        op_arg               = rule.data.op_arg,
+        phase                = rule.data.phase,
+        message              = rule.data.message,
+        comment              = rule.data.comment,
+        script               = rule.data.script,
+        has_predicate        = rule.data.has_predicate,
+        waggle_owned         = rule.data.waggle_owned,
+        set_rule_meta_fields = rule.data.set_rule_meta_fields,
+        tags                 = {},
+        actions              = {},
+        fields               = {}
+    }
+
+    for tag, _ in pairs(rule.data.tags) do
+        table.insert(t.tags, tag)
+    end
+
+    for _, act in ipairs(rule.data.actions) do
+        table.insert(t.actions, { name = act.name, argument = act.argument })
+    end
+
+    for _, field in ipairs(rule.data.fields) do
+        table.insert(t.fields, {
+            original       = field.original,
+            collection     = field.collection,
+            selector       = field.selector,
+            transformation = field.transformation
+        })
+    end
+
+    return t
+end
+
+-- Compile a rule database into a plan image.
+--
+-- @param[in] self The compiler.
+-- @param[in] db The SignatureDatabase to compile.
+--
+-- @returns The JSON image as a string, or nil and an error message
+--          when planning fails.
+Compiler.compile = function(self, db)
+    local planner = Planner:new()
+    local plan = planner:plan(db)
+
+    if plan == nil then
+        return nil, planner.error_message
+    end
+
+    local image = {
+        version = Compiler.FORMAT_VERSION,
+        plan    = {},
+        rules   = {}
+    }
+
+    -- Record the plan and the rules it references. Rules the planner
+    -- dropped are not part of the image.
+    for _, chain in ipairs(plan) do
+        local image_chain = {}
+
+        for _, link in ipairs(chain) do
+            table.insert(
+                image_chain,
+                { rule = link.rule, result = link.result })
+            table.insert(
+                image.rules,
+                self:compile_rule(db.db[link.rule]))
+        end
+
+        table.insert(image.plan, image_chain)
+    end
+
+    return ibjson.to_string(image)
+end
+
+-- Load a plan image into a rule database.
+--
+-- @param[in] self The compiler.
+-- @param[in] json The JSON image string produced by Compiler.compile.
+-- @param[in] db The SignatureDatabase to populate.
+--
+-- @returns The plan stored in the image, in the format the Planner
+--          would have produced. Raises an error on a malformed or
+--          incompatible image.
+Compiler.load = function(self, json, db)
+    local image = ibjson.to_value(json)
+
+    if type(image) ~= 'table' or image.version ~= Compiler.FORMAT_VERSION then
+        error("Cannot load plan image: bad or missing format version.")
+    end
+
+    for _, jsonrule in ipairs(image.rules) do
+
+        local sig
+
+        -- Call the matching signature factory against db.
+        if jsonrule.rule_type == 'Rule' then
+            sig = db:Rule(jsonrule.id, jsonrule.version)
+        elseif jsonrule.rule_type == 'RuleExt' then
+            sig = db:RuleExt(jsonrule.id, jsonrule.version)
+        elseif jsonrule.rule_type == 'StreamInspect' then
+            sig = db:StrRule(jsonrule.id, jsonrule.version)
+        elseif jsonrule.rule_type == 'Action' then
+            sig = db:Action(jsonrule.id, jsonrule.version)
+        elseif jsonrule.rule_type == 'Predicate' then
+            sig = db:Predicate(jsonrule.id, jsonrule.version)
+        else
+            error("Cannot load plan image: unknown rule type "..
+                tostring(jsonrule.rule_type))
+        end
+
+        -- Restore the serialized rule data directly. The plan is already
+        -- made, so the ordering inputs (after, before, follows) that the
+        -- DSL would populate stay empty.
+        sig.data.op                   = jsonrule.op
+        sig.data.op_arg               = jsonrule.op_arg
+        sig.data.phase                = jsonrule.phase
+        sig.data.message              = jsonrule.message
+        sig.data.comment              = jsonrule.comment
+        sig.data.script               = jsonrule.script
+        sig.data.has_predicate        = jsonrule.has_predicate
+        sig.data.waggle_owned         = jsonrule.waggle_owned
+        sig.data.set_rule_meta_fields = jsonrule.set_rule_meta_fields
+
+        for _, tag in ipairs(jsonrule.tags) do
+            sig.data.tags[tag] = 1
+        end
+
+        for _, act in ipairs(jsonrule.actions) do
+            table.insert(
+                sig.data.actions,
+                { name = act.name, argument = act.argument })
+        end
+
+        for _, field in ipairs(jsonrule.fields) do
+            table.insert(sig.data.fields, {
+                original       = field.original,
+                collection     = field.collection,
+                selector       = field.selector,
+                transformation = field.transformation
+            })
+        end
+    end
+
+    return image.plan
+end
+
+return Compiler
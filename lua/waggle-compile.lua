@@ -0,0 +1,104 @@
+-- =========================================================================
+-- =========================================================================
+-- Licensed to Qualys, Inc. (QUALYS) under one or more
+-- contributor license agreements.  See the NOTICE file distributed with
+-- this work for additional information regarding copyright ownership.
+-- QUALYS licenses this file to You under the Apache License, Version 2.0
+-- (the "License"); you may not use this file except in compliance with
+-- the License.  You may obtain a copy of the License at
+--
+--     http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing, software
+-- distributed under the License is distributed on an "AS IS" BASIS,
+-- WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+-- See the License for the specific language governing permissions and
+-- limitations under the License.
+-- =========================================================================
+-- =========================================================================
+--
+-- Offline waggle rule-set compiler.
+--
+-- Loads waggle rule files, plans them once, and writes the resulting
+-- plan image to stdout (or to a file given with -o). An engine then
+-- loads the image with LoadCompiled() from a Lua configuration file
+-- instead of replanning the rule set on every reload:
+--
+--     luajit waggle-compile.lua -o rules.plan rules1.lua rules2.lua
+--
+-- Run this with the in-tree Lua modules on the path, e.g. from a built
+-- tree:
+--
+--     LUA_PATH='lua/?.lua' LUA_CPATH='lua/.libs/?.so' luajit ...
+--
+-- Author: Sam Baskinger <sbaskinger@qualys.com>
+-- =========================================================================
+
+local Waggle = require('ironbee/waggle')
+
+-- Export the waggle DSL into the global namespace, as the configuration
+-- DSL does when a rule file is included by the engine.
+for k, v in pairs(Waggle) do
+    _G[k] = v
+end
+
+local output
+local rule_files = {}
+
+-- Parse arguments.
+local i = 1
+while i <= #arg do
+    if arg[i] == '-o' then
+        i = i + 1
+        output = arg[i]
+        if output == nil then
+            error("Option -o requires a file name.")
+        end
+    else
+        table.insert(rule_files, arg[i])
+    end
+    i = i + 1
+end
+
+if #rule_files == 0 then
+    error("Usage: waggle-compile.lua [-o <image file>] <rule file>...")
+end
+
+-- Load each rule file into the default rule database.
+for _, file in ipairs(rule_files) do
+    dofile(file)
+end
+
+-- Report validation problems, failing on errors.
+local validator = Waggle:Validate()
+if type(validator) ~= 'string' then
+    for _, rec in ipairs(validator.warnings) do
+        io.stderr:write(string.format("%s:%d Rule %s %d - %s\n",
+            rec.source,
+            rec.line,
+            rec.sig_id,
+            rec.sig_rev,
+            rec.msg))
+    end
+    if validator:has_errors() then
+        for _, rec in ipairs(validator.errors) do
+            io.stderr:write(string.format("%s:%d Rule %s %d - %s\n",
+                rec.source,
+                rec.line,
+                rec.sig_id,
+                rec.sig_rev,
+                rec.msg))
+        end
+        error("Rule set validation failed.")
+    end
+end
+
+local image = Waggle.Compile()
+
+if output then
+    local fh = assert(io.open(output, 'w'))
+    fh:write(image)
+    fh:close()
+else
+    io.write(image)
+end
@@ -0,0 +1,691 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Block Cache Module
+ *
+ * This module caches block verdicts keyed by client identity so repeat
+ * offenders do not re-run the rule pipeline just to re-arrive at the
+ * same block. Rules opt a block into the cache with the @c cacheBlock
+ * action; when such a transaction ends blocked, (client IP, context) is
+ * recorded with a TTL in a lock-free table in a shared anonymous
+ * mapping. The table is consulted right after transaction context
+ * selection, and a hit blocks the transaction immediately and turns
+ * its inspection flags off, converting full rule evaluation into a
+ * hash probe for the remainder of the block.
+ *
+ * Configuration:
+ * - <tt>BlockCache slots ttl-secs</tt> enables the cache with the given
+ *   table size and default TTL.
+ *
+ * Rules:
+ * - <tt>cacheBlock</tt> (action) marks the transaction's block verdict
+ *   as cacheable; <tt>cacheBlock:secs</tt> overrides the TTL. E.g.
+ *   <tt>rule REMOTE_ADDR \@counterThreshold "rate 100" id:1 block cacheBlock:60</tt>
+ *
+ * Entries are addressed by a 64 bit hash of IP and context with a short
+ * probe sequence, and verified against a second, independent hash so a
+ * collision on the addressing hash cannot serve another client's
+ * verdict; a full table declines new entries, which only costs
+ * re-evaluation. Allow-listing is unaffected: only transactions that
+ * actually end blocked are recorded, and entries expire on their own.
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/action.h>
+#include <ironbee/clock.h>
+#include <ironbee/config.h>
+#include <ironbee/context.h>
+#include <ironbee/engine.h>
+#include <ironbee/engine_state.h>
+#include <ironbee/module.h>
+#include <ironbee/mm.h>
+#include <ironbee/rule_engine.h>
+#include <ironbee/type_convert.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Define the module name as well as a string version of it. */
+#define MODULE_NAME        block_cache
+#define MODULE_NAME_STR    IB_XSTRINGIFY(MODULE_NAME)
+
+/* Declare the public module symbol. */
+IB_MODULE_DECLARE();
+
+/** How many slots are probed before an insert is declined. */
+static const size_t MAX_PROBES = 8;
+
+/**
+ * One cached verdict.
+ *
+ * A slot is empty when @c key is 0 and dead when @c expires is in the
+ * past. Readers and writers race only on benign 64 bit loads and
+ * stores: the worst outcome of a torn view is one extra or one missed
+ * rule evaluation, never a wrong permanent verdict.
+ */
+struct verdict_slot_t {
+    uint64_t key;     /**< Hash of (client IP, context). 0 if unclaimed. */
+    /*! Second, independent hash of the same key. A lookup whose check
+     *  hash does not match is treated as a miss, so a collision on
+     *  @c key cannot serve another client's verdict. 0 while being
+     *  written, which also reads as a miss. */
+    uint64_t check;
+    uint64_t expires; /**< Expiry, epoch seconds. 0 while being written. */
+};
+typedef struct verdict_slot_t verdict_slot_t;
+
+/**
+ * The two hashes identifying a verdict: addressing and verification.
+ */
+struct verdict_key_t {
+    uint64_t hash;  /**< Addressing hash; selects the probe sequence. */
+    uint64_t check; /**< Verification hash; confirms slot ownership. */
+};
+typedef struct verdict_key_t verdict_key_t;
+
+/**
+ * Module configuration.
+ */
+struct block_cache_cfg_t {
+    ib_module_t    *module; /**< This module; for per-tx data. */
+    verdict_slot_t *table;  /**< The shared mapping. NULL if disabled. */
+    size_t          slots;  /**< Slot count; a power of two. */
+    ib_num_t        ttl;    /**< Default TTL of an entry in seconds. */
+};
+typedef struct block_cache_cfg_t block_cache_cfg_t;
+
+/**
+ * Per-transaction mark left by the cacheBlock action.
+ */
+struct cache_mark_t {
+    ib_num_t    ttl;     /**< TTL to record the verdict with. */
+    const char *rule_id; /**< Id of the marking rule, for logging. */
+};
+typedef struct cache_mark_t cache_mark_t;
+
+/**
+ * Hash a key to a non-zero 64 bit value (FNV-1a).
+ *
+ * @param[in] key The key bytes.
+ * @param[in] key_length Length of @a key.
+ * @param[in] basis Offset basis; different bases give independent hashes.
+ *
+ * @returns The hash. Never 0, as 0 marks unclaimed slots.
+ */
+static uint64_t hash_key(const uint8_t *key, size_t key_length, uint64_t basis)
+{
+    uint64_t h = basis;
+
+    for (size_t i = 0; i < key_length; ++i) {
+        h ^= key[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return (h == 0) ? 1 : h;
+}
+
+/** Offset basis of the addressing hash (the FNV-1a basis). */
+static const uint64_t c_hash_basis = 0xcbf29ce484222325ULL;
+
+/** Offset basis of the verification hash. */
+static const uint64_t c_check_basis = 0x9e3779b97f4a7c15ULL;
+
+/**
+ * Compute the verdict key of @a tx: its client IP and context.
+ *
+ * @param[in] tx The transaction.
+ *
+ * @returns The key hashes.
+ */
+static verdict_key_t tx_key(const ib_tx_t *tx)
+{
+    const char    *ctx_name = ib_context_full_get(tx->ctx);
+    const uint8_t *ip = (const uint8_t *)tx->remote_ipstr;
+    size_t         ip_length = strlen(tx->remote_ipstr);
+    size_t         ctx_length = strlen(ctx_name);
+    verdict_key_t  key;
+
+    key.hash  = hash_key(ip, ip_length, c_hash_basis);
+    key.hash ^= hash_key((const uint8_t *)ctx_name, ctx_length, c_hash_basis);
+    if (key.hash == 0) {
+        key.hash = 1;
+    }
+
+    key.check  = hash_key(ip, ip_length, c_check_basis);
+    key.check ^= hash_key((const uint8_t *)ctx_name, ctx_length, c_check_basis);
+    if (key.check == 0) {
+        key.check = 1;
+    }
+
+    return key;
+}
+
+/**
+ * Record a verdict for @a key expiring at @a expires.
+ *
+ * Probes @ref MAX_PROBES slots for the key, an empty slot, or an
+ * expired slot. A full neighborhood declines the insert; the only cost
+ * is that the offender's next request is evaluated again.
+ *
+ * @param[in] cfg Module configuration.
+ * @param[in] key Key hashes from tx_key().
+ * @param[in] now Current time, epoch seconds.
+ * @param[in] expires Expiry, epoch seconds.
+ *
+ * @returns True if the verdict was recorded.
+ */
+static bool verdict_insert(
+    block_cache_cfg_t *cfg,
+    verdict_key_t      key,
+    uint64_t           now,
+    uint64_t           expires
+)
+{
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        verdict_slot_t *slot =
+            &cfg->table[(key.hash + probe) & (cfg->slots - 1)];
+        uint64_t        slot_key = slot->key;
+
+        if (slot_key == key.hash && slot->check == key.check) {
+            /* Refresh. Concurrent refreshes both write a valid expiry. */
+            slot->expires = expires;
+            return true;
+        }
+        if (slot_key == 0 || slot->expires < now) {
+            /* Claim the empty or dead slot. On a lost race, move on;
+             * the winner's verdict is as valid as ours. */
+            if (__sync_bool_compare_and_swap(&slot->key, slot_key, key.hash)) {
+                slot->check   = key.check;
+                slot->expires = expires;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Look up the verdict for @a key.
+ *
+ * @param[in] cfg Module configuration.
+ * @param[in] key Key hashes from tx_key().
+ * @param[in] now Current time, epoch seconds.
+ *
+ * @returns True if a live block verdict is cached.
+ */
+static bool verdict_lookup(
+    block_cache_cfg_t *cfg,
+    verdict_key_t      key,
+    uint64_t           now
+)
+{
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        const verdict_slot_t *slot =
+            &cfg->table[(key.hash + probe) & (cfg->slots - 1)];
+        uint64_t slot_key = slot->key;
+
+        if (slot_key == key.hash) {
+            /* An addressing-hash collision must read as a miss, not as
+             * another client's verdict; the entry for this key, if any,
+             * may sit later in the probe sequence. */
+            if (slot->check != key.check) {
+                continue;
+            }
+            return (slot->expires >= now);
+        }
+        if (slot_key == 0) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Unmap the verdict table when the engine's main memory is released.
+ *
+ * Without this every engine reload would leak the previous table.
+ *
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ */
+static void block_cache_unmap(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+
+    if (cfg->table != NULL) {
+        munmap(cfg->table, cfg->slots * sizeof(verdict_slot_t));
+        cfg->table = NULL;
+    }
+}
+
+/**
+ * Implement the BlockCache directive.
+ *
+ * Usage: @c BlockCache slots ttl-secs
+ *
+ * The slot count is rounded up to a power of two. The mapping is
+ * shared and anonymous; it must be created before server workers fork,
+ * which configuration time guarantees.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] directive BlockCache.
+ * @param[in] p1 The slot count.
+ * @param[in] p2 The default TTL in seconds.
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On bad parameters or if already enabled.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t block_cache_dir(
+    ib_cfgparser_t *cp,
+    const char     *directive,
+    const char     *p1,
+    const char     *p2,
+    void           *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(directive != NULL);
+    assert(p1 != NULL);
+    assert(p2 != NULL);
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+    ib_num_t           slots;
+    ib_num_t           ttl;
+    size_t             rounded;
+    ib_status_t        rc;
+
+    if (cfg->table != NULL) {
+        ib_cfg_log_error(cp, "%s: already enabled.", directive);
+        return IB_EINVAL;
+    }
+
+    rc = ib_type_atoi(p1, 10, &slots);
+    if (rc != IB_OK || slots <= 0) {
+        ib_cfg_log_error(cp, "%s: invalid slot count: %s", directive, p1);
+        return IB_EINVAL;
+    }
+
+    rc = ib_type_atoi(p2, 10, &ttl);
+    if (rc != IB_OK || ttl <= 0) {
+        ib_cfg_log_error(cp, "%s: invalid TTL: %s", directive, p2);
+        return IB_EINVAL;
+    }
+
+    /* Round the slot count up to a power of two for mask addressing. */
+    for (rounded = 1; rounded < (size_t)slots; rounded <<= 1) {
+        /* Nop. */
+    }
+
+    /* A shared mapping so workers forked after configuration share
+     * the verdicts. It is zero-filled, which is the empty state. */
+    cfg->table = mmap(
+        NULL,
+        rounded * sizeof(verdict_slot_t),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (cfg->table == MAP_FAILED) {
+        cfg->table = NULL;
+        ib_cfg_log_error(
+            cp,
+            "%s: failed to map %zu verdict slots.",
+            directive,
+            rounded);
+        return IB_EALLOC;
+    }
+
+    cfg->slots = rounded;
+    cfg->ttl   = ttl;
+
+    rc = ib_mm_register_cleanup(
+        ib_engine_mm_main_get(cp->ib),
+        block_cache_unmap,
+        cfg);
+    if (rc != IB_OK) {
+        block_cache_unmap(cfg);
+        ib_cfg_log_error(
+            cp,
+            "%s: failed to register table cleanup.",
+            directive);
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Create function of the cacheBlock action.
+ *
+ * The optional parameter is a TTL in seconds overriding the BlockCache
+ * default.
+ *
+ * @param[in] mm Memory manager.
+ * @param[in] ctx Context.
+ * @param[in] parameters Parameters.
+ * @param[out] instance_data The TTL, as a value, is placed here.
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On a malformed TTL or if BlockCache is not configured.
+ */
+static ib_status_t cache_block_create(
+    ib_mm_t       mm,
+    ib_context_t *ctx,
+    const char   *parameters,
+    void         *instance_data,
+    void         *cbdata
+)
+{
+    assert(ctx != NULL);
+    assert(instance_data != NULL);
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+    ib_num_t           ttl;
+
+    if (cfg->table == NULL) {
+        ib_log_error(
+            ib_context_get_engine(ctx),
+            "cacheBlock requires the BlockCache directive.");
+        return IB_EINVAL;
+    }
+
+    if (parameters == NULL) {
+        ttl = cfg->ttl;
+    }
+    else {
+        ib_status_t rc = ib_type_atoi(parameters, 10, &ttl);
+        if (rc != IB_OK || ttl <= 0) {
+            ib_log_error(
+                ib_context_get_engine(ctx),
+                "cacheBlock: invalid TTL: %s",
+                parameters);
+            return IB_EINVAL;
+        }
+    }
+
+    *(void **)instance_data = (void *)(intptr_t)ttl;
+    return IB_OK;
+}
+
+/**
+ * Execute function of the cacheBlock action.
+ *
+ * Marks the transaction; the verdict is recorded at postprocess, and
+ * only if the transaction actually ends blocked.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] data The TTL as a value.
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t cache_block_execute(
+    const ib_rule_exec_t *rule_exec,
+    void                 *data,
+    void                 *cbdata
+)
+{
+    assert(rule_exec != NULL);
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+    ib_tx_t           *tx = rule_exec->tx;
+    cache_mark_t      *mark;
+
+    mark = ib_mm_alloc(tx->mm, sizeof(*mark));
+    if (mark == NULL) {
+        return IB_EALLOC;
+    }
+    mark->ttl     = (ib_num_t)(intptr_t)data;
+    mark->rule_id = (rule_exec->rule != NULL) ?
+        rule_exec->rule->meta.id : "-";
+
+    return ib_tx_set_module_data(tx, cfg->module, mark);
+}
+
+/**
+ * Consult the verdict cache right after context selection.
+ *
+ * A hit blocks the transaction immediately and clears its inspection
+ * flags, so the rest of the transaction is a passthrough of the block
+ * response rather than a rule pipeline run.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] tx Current transaction.
+ * @param[in] state Which state; handle_context_tx_state.
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ *
+ * @returns IB_OK.
+ */
+static ib_status_t block_cache_lookup_handler(
+    ib_engine_t *ib,
+    ib_tx_t     *tx,
+    ib_state_t   state,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(tx != NULL);
+    assert(state == handle_context_tx_state);
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+    ib_timeval_t       tv;
+
+    if (cfg->table == NULL || tx->remote_ipstr == NULL) {
+        return IB_OK;
+    }
+
+    ib_clock_gettimeofday(&tv);
+
+    if (verdict_lookup(cfg, tx_key(tx), (uint64_t)tv.tv_sec)) {
+        ib_log_info_tx(
+            tx,
+            "Blocking %s from cached verdict.",
+            tx->remote_ipstr);
+
+        ib_tx_enable_blocking(tx);
+        ib_tx_block(tx);
+
+        /* Inspection cannot change the verdict; turn it off. */
+        ib_tx_flags_unset(
+            tx,
+            IB_TX_FINSPECT_REQURI |
+            IB_TX_FINSPECT_REQPARAMS |
+            IB_TX_FINSPECT_REQHDR |
+            IB_TX_FINSPECT_REQBODY |
+            IB_TX_FINSPECT_RESHDR |
+            IB_TX_FINSPECT_RESBODY);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Record a cacheable verdict at postprocess.
+ *
+ * Nothing is recorded unless the transaction ends blocked: a later
+ * allow overrides the mark.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] tx Current transaction.
+ * @param[in] state Which state; handle_postprocess_state.
+ * @param[in] cbdata A @ref block_cache_cfg_t.
+ *
+ * @returns IB_OK.
+ */
+static ib_status_t block_cache_record_handler(
+    ib_engine_t *ib,
+    ib_tx_t     *tx,
+    ib_state_t   state,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(tx != NULL);
+    assert(state == handle_postprocess_state);
+    assert(cbdata != NULL);
+
+    block_cache_cfg_t *cfg = (block_cache_cfg_t *)cbdata;
+    cache_mark_t      *mark;
+    ib_timeval_t       tv;
+    ib_status_t        rc;
+
+    if (cfg->table == NULL || tx->remote_ipstr == NULL) {
+        return IB_OK;
+    }
+
+    rc = ib_tx_get_module_data(tx, cfg->module, &mark);
+    if (rc != IB_OK || mark == NULL) {
+        return IB_OK;
+    }
+
+    if (! ib_tx_is_blocked(tx) || ib_tx_is_allowed(tx)) {
+        return IB_OK;
+    }
+
+    ib_clock_gettimeofday(&tv);
+
+    if (verdict_insert(
+            cfg,
+            tx_key(tx),
+            (uint64_t)tv.tv_sec,
+            (uint64_t)tv.tv_sec + (uint64_t)mark->ttl))
+    {
+        ib_log_debug_tx(
+            tx,
+            "Cached block verdict for %s (rule %s, ttl %" PRId64 "s).",
+            tx->remote_ipstr,
+            mark->rule_id,
+            mark->ttl);
+    }
+    else {
+        ib_log_debug_tx(
+            tx,
+            "Block verdict cache full; not caching verdict for %s.",
+            tx->remote_ipstr);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Module init.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] module Module structure.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns
+ * - IB_OK On success.
+ */
+static ib_status_t block_cache_init(
+    ib_engine_t *ib,
+    ib_module_t *module,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(module != NULL);
+
+    ib_status_t        rc;
+    ib_mm_t            mm = ib_engine_mm_main_get(ib);
+    block_cache_cfg_t *cfg;
+
+    cfg = ib_mm_calloc(mm, 1, sizeof(*cfg));
+    if (cfg == NULL) {
+        return IB_EALLOC;
+    }
+    cfg->module = module;
+
+    rc = ib_config_register_directive(
+        ib,
+        "BlockCache",
+        IB_DIRTYPE_PARAM2,
+        (ib_void_fn_t)block_cache_dir,
+        NULL,
+        cfg,
+        NULL,
+        NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_action_create_and_register(
+        NULL, ib,
+        "cacheBlock",
+        cache_block_create, cfg,
+        NULL, NULL, /* No destroy function. */
+        cache_block_execute, cfg
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_hook_tx_register(
+        ib,
+        handle_context_tx_state,
+        block_cache_lookup_handler,
+        cfg);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_hook_tx_register(
+        ib,
+        handle_postprocess_state,
+        block_cache_record_handler,
+        cfg);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+IB_MODULE_INIT(
+    IB_MODULE_HEADER_DEFAULTS,    /* Header defaults. */
+    MODULE_NAME_STR,              /* Module name. */
+    IB_MODULE_CONFIG_NULL,        /* NULL Configuration. */
+    NULL,                         /* Config map. */
+    NULL,                         /* Directive map. Dynamically built. */
+    block_cache_init,             /* Initialization. */
+    NULL,                         /* Callback data. */
+    NULL,                         /* Finalization. */
+    NULL,                         /* Callback data. */
+);
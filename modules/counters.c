@@ -0,0 +1,807 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Counters Module
+ *
+ * This module provides fixed-width atomic counters for cross-transaction
+ * state such as request rates. Counters live in a shared anonymous
+ * mapping created at configuration time, so server workers forked after
+ * configuration share them. Each counter keeps a two-bucket sliding
+ * window, updated and read with single atomic operations; no locks, no
+ * allocation, and no persistence round trip are involved at transaction
+ * time.
+ *
+ * Configuration:
+ * - <tt>CounterTable name slots window-secs</tt> defines a table.
+ *
+ * Rules:
+ * - <tt>counterIncrement:name=key</tt> (action) increments the counter
+ *   for the expanded @c key. E.g.
+ *   <tt>rule REQUEST_LINE \@true x id:1 "counterIncrement:rate=%{REMOTE_ADDR}"</tt>
+ * - <tt>\@counterThreshold "name limit"</tt> (operator) is true if the
+ *   sliding-window count for the key in the input field is at least
+ *   @c limit. E.g.
+ *   <tt>rule REMOTE_ADDR \@counterThreshold "rate 100" id:2 block</tt>
+ *
+ * Counters are addressed by a 64 bit hash of the key with a short probe
+ * sequence. When a table is full, colliding keys share a slot, which can
+ * only over-count; size tables generously for the expected key
+ * population.
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/action.h>
+#include <ironbee/bytestr.h>
+#include <ironbee/capture.h>
+#include <ironbee/clock.h>
+#include <ironbee/config.h>
+#include <ironbee/context.h>
+#include <ironbee/engine.h>
+#include <ironbee/field.h>
+#include <ironbee/hash.h>
+#include <ironbee/module.h>
+#include <ironbee/mm.h>
+#include <ironbee/operator.h>
+#include <ironbee/rule_engine.h>
+#include <ironbee/string.h>
+#include <ironbee/type_convert.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+
+/* Define the module name as well as a string version of it. */
+#define MODULE_NAME        counters
+#define MODULE_NAME_STR    IB_XSTRINGIFY(MODULE_NAME)
+
+/* Declare the public module symbol. */
+IB_MODULE_DECLARE();
+
+/** How many slots are probed before colliding keys share a slot. */
+static const size_t MAX_PROBES = 8;
+
+/**
+ * One counter.
+ *
+ * The @c state word packs the window bookkeeping so it can be advanced
+ * with one compare-and-swap:
+ * - bits 48-63: window index (current window start / window length).
+ * - bits 24-47: count in the previous window.
+ * - bits  0-23: count in the current window.
+ *
+ * Counts saturate at 2^24-1 per window. The window index wraps at
+ * 2^16; after long idleness a counter can very rarely misread one
+ * stale window, which for rate limiting is harmless.
+ */
+struct counter_slot_t {
+    uint64_t key;   /**< Hash of the key. 0 marks an unclaimed slot. */
+    uint64_t state; /**< Packed window index and counts. */
+};
+typedef struct counter_slot_t counter_slot_t;
+
+/** Saturation limit of a single window count. */
+#define COUNT_MAX 0xffffffULL
+
+/* Packing and unpacking of counter_slot_t::state. */
+#define STATE_WINDOW(s) ((uint32_t)((s) >> 48))
+#define STATE_PREV(s)   ((uint32_t)(((s) >> 24) & COUNT_MAX))
+#define STATE_CURR(s)   ((uint32_t)((s) & COUNT_MAX))
+#define STATE_PACK(w, p, c) \
+    ( ((uint64_t)((w) & 0xffff) << 48) \
+    | ((uint64_t)((p) & COUNT_MAX) << 24) \
+    | ((uint64_t)((c) & COUNT_MAX)) )
+
+/**
+ * A named table of counters in shared memory.
+ */
+struct counter_table_t {
+    const char     *name;   /**< Table name from the directive. */
+    size_t          slots;  /**< Slot count; a power of two. */
+    uint32_t        window; /**< Window length in seconds. */
+    counter_slot_t *table;  /**< The shared mapping. */
+};
+typedef struct counter_table_t counter_table_t;
+
+/**
+ * Module configuration.
+ */
+struct counters_cfg_t {
+    ib_hash_t *tables; /**< Map of name to @ref counter_table_t. */
+};
+typedef struct counters_cfg_t counters_cfg_t;
+
+/**
+ * Instance data of the counterIncrement action.
+ */
+struct increment_inst_t {
+    counter_table_t       *table;  /**< Table to increment in. */
+    const ib_var_expand_t *expand; /**< Expansion producing the key. */
+};
+typedef struct increment_inst_t increment_inst_t;
+
+/**
+ * Instance data of the counterThreshold operator.
+ */
+struct threshold_inst_t {
+    counter_table_t *table;     /**< Table to read. */
+    ib_num_t         threshold; /**< Compare limit. */
+};
+typedef struct threshold_inst_t threshold_inst_t;
+
+/**
+ * Hash a key to a non-zero 64 bit value (FNV-1a).
+ *
+ * @param[in] key The key bytes.
+ * @param[in] key_length Length of @a key.
+ *
+ * @returns The hash. Never 0, as 0 marks unclaimed slots.
+ */
+static uint64_t hash_key(const uint8_t *key, size_t key_length)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < key_length; ++i) {
+        h ^= key[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return (h == 0) ? 1 : h;
+}
+
+/**
+ * Find the slot for @a hash, claiming an empty one if needed.
+ *
+ * Probes @ref MAX_PROBES slots. If every probed slot is claimed by
+ * other keys, the first probed slot is shared; colliding keys then
+ * pool their counts, which can only over-count.
+ *
+ * @param[in] table The counter table.
+ * @param[in] hash Key hash from hash_key().
+ *
+ * @returns The slot to use.
+ */
+static counter_slot_t *find_slot(counter_table_t *table, uint64_t hash)
+{
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        counter_slot_t *slot =
+            &table->table[(hash + probe) & (table->slots - 1)];
+        uint64_t slot_key = slot->key;
+
+        if (slot_key == hash) {
+            return slot;
+        }
+        if (slot_key == 0) {
+            /* Claim it. A racing claimer is fine if it used our key. */
+            if (__sync_bool_compare_and_swap(&slot->key, 0, hash)) {
+                return slot;
+            }
+            if (slot->key == hash) {
+                return slot;
+            }
+        }
+    }
+
+    return &table->table[hash & (table->slots - 1)];
+}
+
+/**
+ * Advance @a state to the window containing @a now.
+ *
+ * @param[in] state The packed state to advance.
+ * @param[in] now_window The window index of the current time.
+ *
+ * @returns The advanced packed state.
+ */
+static uint64_t state_advance(uint64_t state, uint32_t now_window)
+{
+    uint32_t window = STATE_WINDOW(state);
+
+    if (window == now_window) {
+        return state;
+    }
+    if (((window + 1) & 0xffff) == now_window) {
+        /* The previous window just ended; rotate it out. */
+        return STATE_PACK(now_window, STATE_CURR(state), 0);
+    }
+    /* Idle for more than a full window; nothing recent to keep. */
+    return STATE_PACK(now_window, 0, 0);
+}
+
+/**
+ * Atomically increment the counter for @a hash.
+ *
+ * @param[in] table The counter table.
+ * @param[in] hash Key hash from hash_key().
+ */
+static void counter_increment(counter_table_t *table, uint64_t hash)
+{
+    counter_slot_t *slot = find_slot(table, hash);
+    ib_timeval_t    tv;
+    uint32_t        now_window;
+
+    ib_clock_gettimeofday(&tv);
+    now_window = (uint32_t)(tv.tv_sec / table->window) & 0xffff;
+
+    for (;;) {
+        uint64_t state = slot->state;
+        uint64_t advanced = state_advance(state, now_window);
+        uint32_t curr = STATE_CURR(advanced);
+
+        if (curr < COUNT_MAX) {
+            ++curr;
+        }
+
+        if (__sync_bool_compare_and_swap(
+                &slot->state,
+                state,
+                STATE_PACK(now_window, STATE_PREV(advanced), curr)))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Estimate the sliding-window count for @a hash.
+ *
+ * The estimate is the full current window count plus the previous
+ * window count scaled by how much of the sliding window still overlaps
+ * it, the standard two-bucket approximation.
+ *
+ * @param[in] table The counter table.
+ * @param[in] hash Key hash from hash_key().
+ *
+ * @returns The estimated count.
+ */
+static ib_num_t counter_estimate(counter_table_t *table, uint64_t hash)
+{
+    counter_slot_t *slot = find_slot(table, hash);
+    ib_timeval_t    tv;
+    uint32_t        now_window;
+    uint64_t        state;
+    uint64_t        elapsed;
+
+    ib_clock_gettimeofday(&tv);
+    now_window = (uint32_t)(tv.tv_sec / table->window) & 0xffff;
+    elapsed    = tv.tv_sec % table->window;
+
+    state = state_advance(slot->state, now_window);
+
+    return (ib_num_t)(
+        STATE_CURR(state)
+        + (STATE_PREV(state) * (table->window - elapsed)) / table->window);
+}
+
+/**
+ * Look up a table by name.
+ *
+ * @param[in] cfg Module configuration.
+ * @param[in] name Table name; NUL terminated.
+ * @param[out] table The table found.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If no such table is defined.
+ */
+static ib_status_t table_lookup(
+    counters_cfg_t   *cfg,
+    const char       *name,
+    counter_table_t **table
+)
+{
+    return ib_hash_get(cfg->tables, table, name);
+}
+
+/**
+ * Implement the CounterTable directive.
+ *
+ * Usage: @c CounterTable name slots window-secs
+ *
+ * The slot count is rounded up to a power of two. The mapping is
+ * shared and anonymous; it must be created before server workers fork,
+ * which configuration time guarantees.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] directive CounterTable.
+ * @param[in] vars List of `char *` parameters.
+ * @param[in] cbdata A @ref counters_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On bad parameters or a duplicate table name.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t counter_table_fn(
+    ib_cfgparser_t  *cp,
+    const char      *directive,
+    const ib_list_t *vars,
+    void            *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(directive != NULL);
+    assert(vars != NULL);
+    assert(cbdata != NULL);
+
+    counters_cfg_t       *cfg = (counters_cfg_t *)cbdata;
+    counter_table_t      *table;
+    const ib_list_node_t *node;
+    const char           *name;
+    ib_num_t              slots;
+    ib_num_t              window;
+    size_t                rounded;
+    ib_mm_t               mm = ib_engine_mm_main_get(cp->ib);
+    ib_status_t           rc;
+
+    node = ib_list_first_const(vars);
+    if (node == NULL) {
+        ib_cfg_log_error(cp, "%s: no table name given.", directive);
+        return IB_EINVAL;
+    }
+    name = (const char *)ib_list_node_data_const(node);
+
+    node = ib_list_node_next_const(node);
+    if (node == NULL) {
+        ib_cfg_log_error(cp, "%s: no slot count given.", directive);
+        return IB_EINVAL;
+    }
+    rc = ib_type_atoi((const char *)ib_list_node_data_const(node), 10, &slots);
+    if (rc != IB_OK || slots <= 0) {
+        ib_cfg_log_error(cp, "%s: invalid slot count.", directive);
+        return IB_EINVAL;
+    }
+
+    node = ib_list_node_next_const(node);
+    if (node == NULL) {
+        ib_cfg_log_error(cp, "%s: no window length given.", directive);
+        return IB_EINVAL;
+    }
+    rc = ib_type_atoi((const char *)ib_list_node_data_const(node), 10, &window);
+    if (rc != IB_OK || window <= 0) {
+        ib_cfg_log_error(cp, "%s: invalid window length.", directive);
+        return IB_EINVAL;
+    }
+
+    rc = table_lookup(cfg, name, &table);
+    if (rc == IB_OK) {
+        ib_cfg_log_error(cp, "%s: table %s already defined.", directive, name);
+        return IB_EINVAL;
+    }
+
+    /* Round the slot count up to a power of two for mask addressing. */
+    for (rounded = 1; rounded < (size_t)slots; rounded <<= 1) {
+        /* Nop. */
+    }
+
+    table = ib_mm_alloc(mm, sizeof(*table));
+    if (table == NULL) {
+        return IB_EALLOC;
+    }
+
+    table->name = ib_mm_strdup(mm, name);
+    if (table->name == NULL) {
+        return IB_EALLOC;
+    }
+    table->slots  = rounded;
+    table->window = (uint32_t)window;
+
+    /* A shared mapping so workers forked after configuration share
+     * the counters. It is zero-filled, which is the empty state. */
+    table->table = mmap(
+        NULL,
+        rounded * sizeof(counter_slot_t),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (table->table == MAP_FAILED) {
+        ib_cfg_log_error(
+            cp,
+            "%s: failed to map %zu counter slots.",
+            directive,
+            rounded);
+        return IB_EALLOC;
+    }
+
+    rc = ib_hash_set(cfg->tables, table->name, table);
+    if (rc != IB_OK) {
+        munmap(table->table, rounded * sizeof(counter_slot_t));
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Create function of the counterIncrement action.
+ *
+ * The parameter has the form @c table=key where @c key may contain var
+ * expansions.
+ *
+ * @param[in] mm Memory manager.
+ * @param[in] ctx Context.
+ * @param[in] parameters Parameters.
+ * @param[out] instance_data An @ref increment_inst_t is placed here.
+ * @param[in] cbdata A @ref counters_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On a malformed parameter or unknown table.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t increment_create(
+    ib_mm_t       mm,
+    ib_context_t *ctx,
+    const char   *parameters,
+    void         *instance_data,
+    void         *cbdata
+)
+{
+    assert(ctx != NULL);
+    assert(instance_data != NULL);
+    assert(cbdata != NULL);
+
+    ib_engine_t      *ib = ib_context_get_engine(ctx);
+    counters_cfg_t   *cfg = (counters_cfg_t *)cbdata;
+    increment_inst_t *inst;
+    ib_var_expand_t  *expand;
+    const char       *eqsign;
+    char             *name;
+    ib_status_t       rc;
+
+    if (parameters == NULL) {
+        return IB_EINVAL;
+    }
+
+    eqsign = strchr(parameters, '=');
+    if (eqsign == NULL || eqsign == parameters || *(eqsign + 1) == '\0') {
+        ib_log_error(
+            ib,
+            "counterIncrement requires a table=key parameter: %s",
+            parameters);
+        return IB_EINVAL;
+    }
+
+    inst = ib_mm_alloc(mm, sizeof(*inst));
+    if (inst == NULL) {
+        return IB_EALLOC;
+    }
+
+    name = ib_mm_memdup_to_str(mm, parameters, eqsign - parameters);
+    if (name == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = table_lookup(cfg, name, &inst->table);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "counterIncrement: no counter table %s.", name);
+        return IB_EINVAL;
+    }
+
+    rc = ib_var_expand_acquire(
+        &expand,
+        mm,
+        IB_S2SL(eqsign + 1),
+        ib_engine_var_config_get(ib)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    inst->expand = expand;
+
+    *(void **)instance_data = inst;
+    return IB_OK;
+}
+
+/**
+ * Execute function of the counterIncrement action.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] data An @ref increment_inst_t.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on var expansion failure.
+ */
+static ib_status_t increment_execute(
+    const ib_rule_exec_t *rule_exec,
+    void                 *data,
+    void                 *cbdata
+)
+{
+    assert(rule_exec != NULL);
+    assert(data != NULL);
+
+    increment_inst_t *inst = (increment_inst_t *)data;
+    const char       *key;
+    size_t            key_length;
+    ib_status_t       rc;
+
+    rc = ib_var_expand_execute(
+        inst->expand,
+        &key, &key_length,
+        rule_exec->tx->mm,
+        rule_exec->tx->var_store
+    );
+    if (rc != IB_OK) {
+        ib_rule_log_error(
+            rule_exec,
+            "counterIncrement: failed to expand key: %s",
+            ib_status_to_string(rc));
+        return rc;
+    }
+
+    counter_increment(
+        inst->table,
+        hash_key((const uint8_t *)key, key_length));
+
+    return IB_OK;
+}
+
+/**
+ * Create function of the counterThreshold operator.
+ *
+ * The parameter has the form @c "table limit".
+ *
+ * @param[in] ctx Context.
+ * @param[in] mm Memory manager.
+ * @param[in] parameters Parameters.
+ * @param[out] instance_data A @ref threshold_inst_t is placed here.
+ * @param[in] cbdata A @ref counters_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On a malformed parameter or unknown table.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t threshold_create(
+    ib_context_t *ctx,
+    ib_mm_t       mm,
+    const char   *parameters,
+    void         *instance_data,
+    void         *cbdata
+)
+{
+    assert(ctx != NULL);
+    assert(instance_data != NULL);
+    assert(cbdata != NULL);
+
+    ib_engine_t      *ib = ib_context_get_engine(ctx);
+    counters_cfg_t   *cfg = (counters_cfg_t *)cbdata;
+    threshold_inst_t *inst;
+    const char       *space;
+    char             *name;
+    ib_status_t       rc;
+
+    if (parameters == NULL) {
+        return IB_EINVAL;
+    }
+
+    space = strchr(parameters, ' ');
+    if (space == NULL || space == parameters || *(space + 1) == '\0') {
+        ib_log_error(
+            ib,
+            "counterThreshold requires a \"table limit\" parameter: %s",
+            parameters);
+        return IB_EINVAL;
+    }
+
+    inst = ib_mm_alloc(mm, sizeof(*inst));
+    if (inst == NULL) {
+        return IB_EALLOC;
+    }
+
+    name = ib_mm_memdup_to_str(mm, parameters, space - parameters);
+    if (name == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = table_lookup(cfg, name, &inst->table);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "counterThreshold: no counter table %s.", name);
+        return IB_EINVAL;
+    }
+
+    rc = ib_type_atoi(space + 1, 10, &inst->threshold);
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "counterThreshold: invalid limit: %s",
+            space + 1);
+        return IB_EINVAL;
+    }
+
+    *(void **)instance_data = inst;
+    return IB_OK;
+}
+
+/**
+ * Execute function of the counterThreshold operator.
+ *
+ * The input field supplies the key. The result is true if the
+ * sliding-window estimate is at least the configured limit. The
+ * estimate is captured as item 0 when capture is requested.
+ *
+ * @param[in] tx Current transaction.
+ * @param[in] field The field supplying the key.
+ * @param[in] capture If non-NULL, the collection to capture to.
+ * @param[out] result The result of the operator: 1=true, 0=false.
+ * @param[in] instance_data A @ref threshold_inst_t.
+ * @param[in] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If the field is not a string type.
+ */
+static ib_status_t threshold_execute(
+    ib_tx_t          *tx,
+    const ib_field_t *field,
+    ib_field_t       *capture,
+    ib_num_t         *result,
+    void             *instance_data,
+    void             *cbdata
+)
+{
+    assert(tx != NULL);
+    assert(field != NULL);
+    assert(result != NULL);
+    assert(instance_data != NULL);
+
+    threshold_inst_t *inst = (threshold_inst_t *)instance_data;
+    const uint8_t    *key;
+    size_t            key_length;
+    ib_num_t          estimate;
+    ib_status_t       rc;
+
+    if (field->type == IB_FTYPE_NULSTR) {
+        const char *s;
+        rc = ib_field_value(field, ib_ftype_nulstr_out(&s));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        key = (const uint8_t *)s;
+        key_length = strlen(s);
+    }
+    else if (field->type == IB_FTYPE_BYTESTR) {
+        const ib_bytestr_t *bs;
+        rc = ib_field_value(field, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        key = ib_bytestr_const_ptr(bs);
+        key_length = ib_bytestr_length(bs);
+    }
+    else {
+        return IB_EINVAL;
+    }
+
+    estimate = counter_estimate(inst->table, hash_key(key, key_length));
+
+    *result = (estimate >= inst->threshold) ? 1 : 0;
+
+    if (capture != NULL && *result) {
+        ib_field_t *count_field;
+
+        ib_capture_clear(capture);
+        rc = ib_field_create(
+            &count_field,
+            tx->mm,
+            IB_S2SL("0"),
+            IB_FTYPE_NUM,
+            ib_ftype_num_in(&estimate));
+        if (rc == IB_OK) {
+            ib_capture_set_item(capture, 0, tx->mm, count_field);
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Module init.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] module Module structure.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns
+ * - IB_OK On success.
+ */
+static ib_status_t counters_init(
+    ib_engine_t *ib,
+    ib_module_t *module,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(module != NULL);
+
+    ib_status_t     rc;
+    ib_mm_t         mm = ib_engine_mm_main_get(ib);
+    counters_cfg_t *cfg;
+
+    cfg = ib_mm_alloc(mm, sizeof(*cfg));
+    if (cfg == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_hash_create(&(cfg->tables), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_config_register_directive(
+        ib,
+        "CounterTable",
+        IB_DIRTYPE_LIST,
+        (ib_void_fn_t)counter_table_fn,
+        NULL,
+        cfg,
+        NULL,
+        NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_action_create_and_register(
+        NULL, ib,
+        "counterIncrement",
+        increment_create, cfg,
+        NULL, NULL, /* No destroy function. */
+        increment_execute, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_operator_create_and_register(
+        NULL,
+        ib,
+        "counterThreshold",
+        IB_OP_CAPABILITY_CAPTURE,
+        threshold_create, cfg,
+        NULL, NULL, /* No destroy function. */
+        threshold_execute, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+IB_MODULE_INIT(
+    IB_MODULE_HEADER_DEFAULTS,    /* Header defaults. */
+    MODULE_NAME_STR,              /* Module name. */
+    IB_MODULE_CONFIG_NULL,        /* NULL Configuration. */
+    NULL,                         /* Config map. */
+    NULL,                         /* Directive map. Dynamically built. */
+    counters_init,                /* Initialization. */
+    NULL,                         /* Callback data. */
+    NULL,                         /* Finalization. */
+    NULL,                         /* Callback data. */
+);
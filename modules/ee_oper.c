@@ -31,16 +31,24 @@
 
 #include <ironbee/capture.h>
 #include <ironbee/context.h>
+#include <ironbee/engine.h>
 #include <ironbee/engine_state.h>
 #include <ironbee/hash.h>
+#include <ironbee/list.h>
+#include <ironbee/lock.h>
+#include <ironbee/logevent.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/module.h>
 #include <ironbee/operator.h>
 #include <ironbee/path.h>
 #include <ironbee/rule_engine.h>
+#include <ironbee/stream_io.h>
+#include <ironbee/stream_processor.h>
+#include <ironbee/stream_pump.h>
 #include <ironbee/util.h>
 
 #include <assert.h>
+#include <stdio.h>
 #include <unistd.h>
 
 /** Module name. */
@@ -54,20 +62,93 @@ IB_MODULE_DECLARE();
 
 /* See definition below for documentation. */
 typedef struct ee_config_t ee_config_t;
+typedef struct ee_epoch_t ee_epoch_t;
+typedef struct ee_automata_t ee_automata_t;
 typedef struct ee_operator_data_t ee_operator_data_t;
 typedef struct ee_tx_data_t ee_tx_data_t;
 
 struct ee_config_t {
     /** Hash of eudoxus patterns defined via the LoadEudoxus directive. */
     ib_hash_t *eudoxus_pattern_hash;
+    /**
+     * Patterns selected by EudoxusStreamInspect, or NULL.
+     *
+     * Value type is @ref ee_stream_pattern_t.  When non-empty, the
+     * eudoxus stream processor is attached to every request body pump
+     * and scans body chunks against these patterns as they arrive.
+     */
+    ib_list_t *stream_patterns;
+};
+
+/**
+ * One version of a named automata: a base plus an optional hotfix delta.
+ *
+ * A signature hotfix does not require recompiling the base automata:
+ * LoadEudoxusPatch attaches a small side automata whose outputs are live
+ * alongside the base, and EudoxusTombstone suppresses individual base
+ * outputs.  Both are folded into the base at the next full compile, at
+ * which point the regenerated configuration simply stops mentioning them.
+ *
+ * Versions are published by the @c ee_reload runtime command (see
+ * ee_reload_cmd()).  A transaction pins the version that is current when
+ * it first runs the operator and uses it for its whole life; a replaced
+ * version is destroyed when its last pinned transaction finishes.
+ */
+struct ee_epoch_t {
+    /** Monotonic version number, for diagnostics. */
+    uint64_t epoch;
+    /** Base automata loaded by LoadEudoxus or ee_reload. */
+    ia_eudoxus_t *base;
+    /** Side automata loaded by LoadEudoxusPatch, or NULL. */
+    ia_eudoxus_t *patch;
+    /** Base outputs suppressed by EudoxusTombstone, or NULL. */
+    ib_hash_t *tombstones;
+    /**
+     * Interned base outputs, keyed by output address, or NULL.
+     *
+     * Outputs are deduplicated at compile time and stored once in the
+     * automata, so the address of an output identifies it.  Each value
+     * is an ib_bytestr_t copy of the output made once at load time from
+     * the engine's main memory manager; the capture path references
+     * these instead of copying the payload per match.
+     */
+    ib_hash_t *base_interns;
+    /** Interned patch outputs, keyed by output address, or NULL. */
+    ib_hash_t *patch_interns;
+    /** Number of in-flight transactions using this version. */
+    size_t pins;
+    /** The automata slot this version belongs to. */
+    ee_automata_t *owner;
+    /** Next entry in the owner's retired list. */
+    ee_epoch_t *next;
+};
+
+/**
+ * One named automata slot: the current version plus replaced versions
+ * still pinned by in-flight transactions.
+ *
+ * The slot pointer is what operator instances hold, so it is stable for
+ * the engine lifetime; only @c current moves.  @c lock guards @c current,
+ * @c retired and the pin counts; it is taken briefly at transaction
+ * start, transaction finish and reload, never per input byte.
+ */
+struct ee_automata_t {
+    /** Version used by transactions starting now. */
+    ee_epoch_t *current;
+    /** Replaced versions not yet free of pinned transactions. */
+    ee_epoch_t *retired;
+    /** Guards current, retired and pin counts. */
+    ib_lock_t *lock;
+    /** Last version number handed out. */
+    uint64_t last_epoch;
 };
 
 /* Operator instance data. */
 struct ee_operator_data_t {
     /** Unique ID for this operator instance. */
     char id[IB_UUID_LENGTH];
-    /** Pointer to the eudoxus pattern for this instance. */
-    ia_eudoxus_t *eudoxus;
+    /** Pointer to the automata set for this instance. */
+    ee_automata_t *automata;
 };
 
 /* Callback data for ee match */
@@ -76,18 +157,80 @@ struct ee_callback_data_t
     ib_tx_t *tx;
     ib_field_t *capture;
     uint32_t match_len;
+    /** Outputs to ignore in the current run, or NULL. */
+    const ib_hash_t *tombstones;
+    /** Interned outputs for the current run, or NULL. */
+    const ib_hash_t *interns;
 };
 typedef struct ee_callback_data_t ee_callback_data_t;
 
 /* Per-tx inter-call data */
 struct ee_tx_data_t
 {
+    /** Automata version pinned for this transaction, or NULL. */
+    ee_epoch_t *epoch;
     /** Eudoxus state */
     ia_eudoxus_state_t *eudoxus_state;
+    /** Eudoxus state for the patch automata, or NULL. */
+    ia_eudoxus_state_t *patch_state;
     /** automata callback data */
     ee_callback_data_t *ee_cbdata;
     /** Have we reached the end of the automata? */
     bool end_of_automata;
+    /** Have we reached the end of the patch automata? */
+    bool end_of_patch;
+};
+
+/** Name (and stream data type) of the body-scanning stream processor. */
+static const char *c_stream_processor_name = "eudoxus";
+
+/** One pattern selected for streaming body inspection. */
+typedef struct {
+    /** Pattern name, used in match events. */
+    const char *name;
+    /** Automata slot the pattern resolves to. */
+    ee_automata_t *automata;
+} ee_stream_pattern_t;
+
+/* See definition below. */
+typedef struct ee_stream_scan_t ee_stream_scan_t;
+
+/** Callback data for one automata run within a streaming scan. */
+typedef struct {
+    /** The scan this run belongs to. */
+    ee_stream_scan_t *scan;
+    /** Outputs to suppress, or NULL. */
+    const ib_hash_t *tombstones;
+} ee_stream_cbdata_t;
+
+/**
+ * Streaming scan of one pattern over one transaction's request body.
+ *
+ * The eudoxus states persist across body chunks, so scanning is
+ * constant-memory no matter the body size: no chunk is ever buffered.
+ * Scanning a pattern stops at its first non-suppressed match -- one
+ * event per pattern per transaction, mirroring the first-match
+ * semantics of the @c ee operator -- or when its automata dead-ends.
+ */
+struct ee_stream_scan_t {
+    /** Pattern name, used in match events. */
+    const char *name;
+    /** Transaction being scanned. */
+    ib_tx_t *tx;
+    /** Automata version pinned for this transaction. */
+    ee_epoch_t *epoch;
+    /** Execution state over the base automata. */
+    ia_eudoxus_state_t *base_state;
+    /** Execution state over the patch automata, or NULL. */
+    ia_eudoxus_state_t *patch_state;
+    /** True when the base automata matched, dead-ended or failed. */
+    bool base_done;
+    /** True when the patch automata matched, dead-ended or failed. */
+    bool patch_done;
+    /** Callback data for the base run (tombstones applied). */
+    ee_stream_cbdata_t base_cbdata;
+    /** Callback data for the patch run. */
+    ee_stream_cbdata_t patch_cbdata;
 };
 
 /**
@@ -256,13 +399,215 @@ ib_status_t set_ee_tx_data(
     return rc;
 }
 
-static void ia_eudoxus_destroy_wrapper(void *cbdata)
+/**
+ * Destroy one automata version's eudoxus engines.
+ *
+ * The tombstone hash and the structure itself are memory manager owned.
+ *
+ * @param[in] epoch The version to destroy.
+ */
+static void ee_epoch_destroy(ee_epoch_t *epoch)
+{
+    assert(epoch != NULL);
+
+    if (epoch->base != NULL) {
+        ia_eudoxus_destroy(epoch->base);
+        epoch->base = NULL;
+    }
+    if (epoch->patch != NULL) {
+        ia_eudoxus_destroy(epoch->patch);
+        epoch->patch = NULL;
+    }
+}
+
+/**
+ * Engine shutdown cleanup for an automata slot.
+ *
+ * Destroys the current version and any retired versions still waiting on
+ * pinned transactions; at engine destruction no transactions remain.
+ *
+ * @param[in] cbdata The @ref ee_automata_t to clean up.
+ */
+static void ee_automata_destroy_wrapper(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    ee_automata_t *automata = (ee_automata_t *)cbdata;
+    ee_epoch_t *epoch;
+
+    if (automata->current != NULL) {
+        ee_epoch_destroy(automata->current);
+        automata->current = NULL;
+    }
+    for (epoch = automata->retired; epoch != NULL; epoch = epoch->next) {
+        ee_epoch_destroy(epoch);
+    }
+    automata->retired = NULL;
+}
+
+/** Callback data for ee_intern_output_callback(). */
+typedef struct {
+    /** Memory manager the interned copies are made from. */
+    ib_mm_t mm;
+    /** Table being built: output address to ib_bytestr_t. */
+    ib_hash_t *hash;
+    /** First error encountered, or IB_OK. */
+    ib_status_t rc;
+} ee_intern_data_t;
+
+/**
+ * ia_eudoxus_all_outputs() callback interning one output.
+ */
+static
+ia_eudoxus_command_t ee_intern_output_callback(ia_eudoxus_t *engine,
+                                               const char *output,
+                                               size_t output_length,
+                                               const uint8_t *input,
+                                               void *cbdata)
 {
     assert(cbdata != NULL);
+    assert(output != NULL);
+
+    ee_intern_data_t *data = cbdata;
+    ib_bytestr_t *bs;
+    char *key;
+    ib_status_t rc;
+
+    rc = ib_bytestr_dup_mem(&bs, data->mm,
+                            (const uint8_t *)output, output_length);
+    if (rc != IB_OK) {
+        data->rc = rc;
+        return IA_EUDOXUS_CMD_STOP;
+    }
+
+    key = ib_mm_memdup(data->mm, &output, sizeof(output));
+    if (key == NULL) {
+        data->rc = IB_EALLOC;
+        return IA_EUDOXUS_CMD_STOP;
+    }
+
+    rc = ib_hash_set_ex(data->hash, key, sizeof(output), bs);
+    if (rc != IB_OK) {
+        data->rc = rc;
+        return IA_EUDOXUS_CMD_STOP;
+    }
+
+    return IA_EUDOXUS_CMD_CONTINUE;
+}
+
+/**
+ * Intern all outputs of @a eudoxus into a lookup table.
+ *
+ * Walks the automata's output section once at load time and copies each
+ * distinct output into @a mm.  Match-time capture then references the
+ * interned bytestring rather than copying the payload into the
+ * transaction pool per match, which removes the allocation churn of
+ * match-storms on scanner traffic.
+ *
+ * @param[in] mm Memory manager for the table and the interned copies.
+ * @param[in] eudoxus Loaded automata to intern outputs of.
+ * @param[out] out_hash The table, keyed by output address.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL on a malformed automata.
+ */
+static
+ib_status_t ee_intern_outputs(
+    ib_mm_t        mm,
+    ia_eudoxus_t  *eudoxus,
+    ib_hash_t    **out_hash
+)
+{
+    assert(eudoxus != NULL);
+    assert(out_hash != NULL);
+
+    ib_status_t rc;
+    ia_eudoxus_result_t ia_rc;
+    ee_intern_data_t data;
+
+    rc = ib_hash_create(&data.hash, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    data.mm = mm;
+    data.rc = IB_OK;
+
+    ia_rc = ia_eudoxus_all_outputs(eudoxus,
+                                   ee_intern_output_callback,
+                                   &data);
+    if (data.rc != IB_OK) {
+        return data.rc;
+    }
+    if (ia_rc != IA_EUDOXUS_OK) {
+        return IB_EINVAL;
+    }
+
+    *out_hash = data.hash;
+
+    return IB_OK;
+}
+
+/**
+ * Pin the current version of @a automata for a transaction.
+ *
+ * @param[in] automata Automata slot to pin.
+ *
+ * @returns The pinned version, or NULL on lock failure.
+ */
+static ee_epoch_t *ee_epoch_pin(ee_automata_t *automata)
+{
+    assert(automata != NULL);
+
+    ee_epoch_t *epoch;
+
+    if (ib_lock_lock(automata->lock) != IB_OK) {
+        return NULL;
+    }
+    epoch = automata->current;
+    ++(epoch->pins);
+    ib_lock_unlock(automata->lock);
+
+    return epoch;
+}
+
+/**
+ * Release a transaction's pin on @a epoch.
+ *
+ * A retired version whose last pin is released is destroyed here; this
+ * is what bounds the lifetime of replaced automata to the transactions
+ * that were in flight when ee_reload_cmd() published the replacement.
+ *
+ * @param[in] epoch The version to unpin.
+ */
+static void ee_epoch_unpin(ee_epoch_t *epoch)
+{
+    assert(epoch != NULL);
+    assert(epoch->owner != NULL);
 
-    ia_eudoxus_t *eudoxus = (ia_eudoxus_t *)cbdata;
+    ee_automata_t *automata = epoch->owner;
 
-    ia_eudoxus_destroy(eudoxus);
+    if (ib_lock_lock(automata->lock) != IB_OK) {
+        return;
+    }
+    assert(epoch->pins > 0);
+    --(epoch->pins);
+    if (epoch->pins == 0 && epoch != automata->current) {
+        ee_epoch_t **link;
+        for (
+            link = &(automata->retired);
+            *link != NULL;
+            link = &((*link)->next)
+        ) {
+            if (*link == epoch) {
+                *link = epoch->next;
+                break;
+            }
+        }
+        ee_epoch_destroy(epoch);
+    }
+    ib_lock_unlock(automata->lock);
 }
 
 /**
@@ -294,6 +639,7 @@ ib_status_t load_eudoxus_pattern_param2(ib_cfgparser_t *cp,
     ia_eudoxus_result_t ia_rc;
     ib_hash_t *eudoxus_pattern_hash;
     ia_eudoxus_t *eudoxus;
+    ee_automata_t *automata;
     const ee_config_t* config;
     ib_mm_t mm_tmp;
     void *tmp;
@@ -330,7 +676,14 @@ ib_status_t load_eudoxus_pattern_param2(ib_cfgparser_t *cp,
         return IB_EINVAL;
     }
 
-    ia_rc = ia_eudoxus_create_from_path(&eudoxus, automata_file);
+    /* Map the automata read-only and shared: a large automata is paged
+     * once per host no matter how many worker processes load it, and
+     * startup does not copy it through read().  Fall back to the copying
+     * loader for file systems that cannot be mapped. */
+    ia_rc = ia_eudoxus_create_from_path_mmap(&eudoxus, automata_file);
+    if (ia_rc != IA_EUDOXUS_OK) {
+        ia_rc = ia_eudoxus_create_from_path(&eudoxus, automata_file);
+    }
     if (ia_rc != IA_EUDOXUS_OK) {
         ib_log_error(cp->ib,
                      MODULE_NAME_STR ": Error loading eudoxus automata file[%d]: %s.",
@@ -338,18 +691,51 @@ ib_status_t load_eudoxus_pattern_param2(ib_cfgparser_t *cp,
         return IB_EINVAL;
     }
 
-    /* Destroy this machine when the engine is destroyed. */
+    automata = ib_mm_calloc(ib_engine_mm_main_get(ib),
+                            sizeof(*automata), 1);
+    if (automata == NULL) {
+        ia_eudoxus_destroy(eudoxus);
+        return IB_EALLOC;
+    }
+    automata->current = ib_mm_calloc(ib_engine_mm_main_get(ib),
+                                     sizeof(*automata->current), 1);
+    if (automata->current == NULL) {
+        ia_eudoxus_destroy(eudoxus);
+        return IB_EALLOC;
+    }
+    rc = ib_lock_create(&(automata->lock), ib_engine_mm_main_get(ib));
+    if (rc != IB_OK) {
+        ia_eudoxus_destroy(eudoxus);
+        return rc;
+    }
+    automata->last_epoch = 1;
+    automata->current->epoch = automata->last_epoch;
+    automata->current->base = eudoxus;
+    automata->current->owner = automata;
+
+    /* Destroy this slot's automata when the engine is destroyed. */
     rc = ib_mm_register_cleanup(
         ib_engine_mm_main_get(ib),
-        ia_eudoxus_destroy_wrapper,
-        eudoxus
+        ee_automata_destroy_wrapper,
+        automata
     );
     if (rc != IB_OK) {
         ib_log_error(cp->ib, "Failed to register eudoxus cleanup function.");
+        ia_eudoxus_destroy(eudoxus);
+        return rc;
+    }
+
+    rc = ee_intern_outputs(ib_engine_mm_main_get(ib),
+                           eudoxus,
+                           &(automata->current->base_interns));
+    if (rc != IB_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": Error interning eudoxus outputs: %s.",
+                     ib_status_to_string(rc));
         return rc;
     }
 
-    rc = ib_hash_set(eudoxus_pattern_hash, pattern_name, eudoxus);
+    rc = ib_hash_set(eudoxus_pattern_hash, pattern_name, automata);
     if (rc != IB_OK) {
         return rc;
     }
@@ -358,108 +744,360 @@ ib_status_t load_eudoxus_pattern_param2(ib_cfgparser_t *cp,
 }
 
 /**
- * Eudoxus first match callback function.  Called when a match occurs.
+ * Attach a hotfix patch automata to an already loaded pattern.
  *
- * Always returns IA_EUDOXUS_CMD_STOP to stop matching (unless an
- * error occurs). If capture is enabled the matched text will be stored in the
- * capture variable.
+ * The patch is a small compiled automata holding just the added
+ * signatures.  Its outputs are reported alongside the base automata's, so
+ * new signatures deploy by compiling only the delta -- sub-second --
+ * instead of recompiling the full set.  The patch is dropped when the
+ * next full compile replaces the configuration.
  *
- * @param[in] engine Eudoxus engine.
- * @param[in] output Output defined by automata.
- * @param[in] output_length Length of output.
- * @param[in] input Current location in the input (first character
- *                  after the match).
- * @param[in,out] cbdata Pointer to the ee_callback_data_t instance we are
- *                       handling. This is needed for handling capture
- *                       of the match.
+ * @param[in] cp Configuration parser.
+ * @param[in] name Directive name.
+ * @param[in] pattern_name Name of the pattern to patch.
+ * @param[in] filename Patch automata file to load.
+ * @param[in] cbdata Callback data (unused)
  * @return
- * - IA_EUDOXUS_CMD_ERROR on error
- * - IA_EUDOXUS_CMD_STOP otherwise.
+ * - IB_OK on success.
+ * - IB_ENOENT if the pattern has not been loaded.
+ * - IB_EEXIST if the pattern already has a patch.
+ * - IB_EINVAL if there was an error loading the automata.
  */
 static
-ia_eudoxus_command_t ee_first_match_callback(ia_eudoxus_t* engine,
-                                             const char *output,
-                                             size_t output_length,
-                                             const uint8_t *input,
-                                             void *cbdata)
+ib_status_t load_eudoxus_patch_param2(ib_cfgparser_t *cp,
+                                      const char *name,
+                                      const char *pattern_name,
+                                      const char *filename,
+                                      void *cbdata)
 {
-    assert(cbdata != NULL);
-    assert(output != NULL);
-
+    ib_engine_t *ib;
     ib_status_t rc;
-    ee_callback_data_t *ee_cbdata = cbdata;
-    ib_tx_t *tx = ee_cbdata->tx;
-    ib_field_t *capture = ee_cbdata->capture;
-    ib_bytestr_t *bs;
-    ib_field_t *field;
-    const char *name;
+    const char *automata_file;
+    ia_eudoxus_result_t ia_rc;
+    ia_eudoxus_t *eudoxus;
+    ee_automata_t *automata;
+    const ee_config_t *config;
+    ib_mm_t mm_tmp;
 
-    assert(tx != NULL);
+    assert(cp != NULL);
+    assert(cp->ib != NULL);
+    assert(pattern_name != NULL);
+    assert(filename != NULL);
 
-    /* If the match length is not zero, we've already matched something.
-     * In this case, set match to 0 and return that we should continue. */
-    if (ee_cbdata->match_len > 0) {
-        ee_cbdata->match_len = 0;
-        return IA_EUDOXUS_CMD_CONTINUE;
+    mm_tmp = ib_engine_mm_temp_get(cp->ib);
+    ib = cp->ib;
+    config = ee_get_config(ib);
+    assert(config != NULL);
+    assert(config->eudoxus_pattern_hash != NULL);
+
+    rc = ib_hash_get(config->eudoxus_pattern_hash, &automata, pattern_name);
+    if (rc != IB_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": No eudoxus automata named \"%s\" to"
+                     " patch; LoadEudoxus it first.",
+                     pattern_name);
+        return IB_ENOENT;
+    }
+    if (automata->current->patch != NULL) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": Pattern \"%s\" already has a patch;"
+                     " fold it into the base and recompile.",
+                     pattern_name);
+        return IB_EEXIST;
     }
 
-    ee_cbdata->match_len = output_length;
+    automata_file = ib_util_relative_file(mm_tmp, cp->curr->file, filename);
 
-    if (capture != NULL) {
-        rc = ib_capture_clear(capture);
-        if (rc != IB_OK) {
-            ib_log_error_tx(tx, "Error clearing captures: %s",
-                            ib_status_to_string(rc));
-            return IA_EUDOXUS_CMD_ERROR;
-        }
-        /* Create a byte-string representation */
-        rc = ib_bytestr_dup_mem(&bs,
-                                tx->mm,
-                                (const uint8_t *)output, output_length);
-        if (rc != IB_OK) {
-            return IA_EUDOXUS_CMD_ERROR;
-        }
-        name = ib_capture_name(0);
-        rc = ib_field_create(&field, tx->mm, name, strlen(name),
-                             IB_FTYPE_BYTESTR, ib_ftype_bytestr_in(bs));
-        if (rc != IB_OK) {
-            return IA_EUDOXUS_CMD_ERROR;
-        }
-        rc = ib_capture_set_item(capture, 0, tx->mm, field);
-        if (rc != IB_OK) {
-            return IA_EUDOXUS_CMD_ERROR;
-        }
+    if (access(automata_file, R_OK) != 0) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": Error accessing eudoxus patch file: %s.",
+                     automata_file);
+        return IB_EINVAL;
     }
 
-    return IA_EUDOXUS_CMD_STOP;
+    ia_rc = ia_eudoxus_create_from_path_mmap(&eudoxus, automata_file);
+    if (ia_rc != IA_EUDOXUS_OK) {
+        ia_rc = ia_eudoxus_create_from_path(&eudoxus, automata_file);
+    }
+    if (ia_rc != IA_EUDOXUS_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": Error loading eudoxus patch file[%d]: %s.",
+                     ia_rc, automata_file);
+        return IB_EINVAL;
+    }
+
+    rc = ee_intern_outputs(ib_engine_mm_main_get(ib),
+                           eudoxus,
+                           &(automata->current->patch_interns));
+    if (rc != IB_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": Error interning eudoxus outputs: %s.",
+                     ib_status_to_string(rc));
+        ia_eudoxus_destroy(eudoxus);
+        return rc;
+    }
+
+    /* The slot's engine-shutdown cleanup covers the patch. */
+    automata->current->patch = eudoxus;
+
+    return IB_OK;
 }
 
 /**
- * Create an instance of the @c ee operator.
+ * Suppress one output of an already loaded pattern.
  *
- * Looks up the automata name and adds the automata to the operator instance.
+ * The matching half of a hotfix: a signature withdrawn from the base
+ * automata is tombstoned by output rather than waiting for a full
+ * recompile.  Tombstoned outputs are skipped during matching as if the
+ * signature were not in the automata.
  *
- * @param[in] ctx Current context.
- * @param[in] mm Memory manager.
- * @param[in] parameters Automata name.
- * @param[out] instance_data Instance data.
- * @param[in] cbdata Callback data (unused).
+ * @param[in] cp Configuration parser.
+ * @param[in] name Directive name.
+ * @param[in] pattern_name Name of the pattern.
+ * @param[in] output The automata output to suppress.
+ * @param[in] cbdata Callback data (unused)
+ * @return
+ * - IB_OK on success.
+ * - IB_ENOENT if the pattern has not been loaded.
+ * - IB_EALLOC on allocation failure.
  */
 static
-ib_status_t ee_operator_create(
-    ib_context_t *ctx,
-    ib_mm_t       mm,
-    const char   *parameters,
-    void         *instance_data,
-    void         *cbdata
-)
+ib_status_t eudoxus_tombstone_param2(ib_cfgparser_t *cp,
+                                     const char *name,
+                                     const char *pattern_name,
+                                     const char *output,
+                                     void *cbdata)
 {
-    assert(ctx != NULL);
-    assert(parameters != NULL);
+    ib_status_t rc;
+    ee_automata_t *automata;
+    const ee_config_t *config;
+    ib_mm_t mm;
+    char *interned_output;
+
+    assert(cp != NULL);
+    assert(cp->ib != NULL);
+    assert(pattern_name != NULL);
+    assert(output != NULL);
+
+    mm = ib_engine_mm_main_get(cp->ib);
+    config = ee_get_config(cp->ib);
+    assert(config != NULL);
+    assert(config->eudoxus_pattern_hash != NULL);
+
+    rc = ib_hash_get(config->eudoxus_pattern_hash, &automata, pattern_name);
+    if (rc != IB_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": No eudoxus automata named \"%s\" to"
+                     " tombstone in; LoadEudoxus it first.",
+                     pattern_name);
+        return IB_ENOENT;
+    }
+
+    if (automata->current->tombstones == NULL) {
+        rc = ib_hash_create(&(automata->current->tombstones), mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    interned_output = ib_mm_strdup(mm, output);
+    if (interned_output == NULL) {
+        return IB_EALLOC;
+    }
+
+    return ib_hash_set(automata->current->tombstones,
+                       interned_output, interned_output);
+}
+
+/**
+ * Select a pattern for streaming request body inspection.
+ *
+ * Transactions with a request body get the eudoxus stream processor
+ * attached to their body pump; each named pattern is scanned against the
+ * body chunks as they arrive, with the automata state carried across
+ * chunks.  A match raises an observation event against the transaction.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name Directive name.
+ * @param[in] pattern_name Name of the pattern to scan with.
+ * @param[in] cbdata Callback data (unused)
+ * @return
+ * - IB_OK on success.
+ * - IB_ENOENT if the pattern has not been loaded.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t eudoxus_stream_inspect_param1(ib_cfgparser_t *cp,
+                                          const char *name,
+                                          const char *pattern_name,
+                                          void *cbdata)
+{
+    ib_status_t rc;
+    ee_automata_t *automata;
+    ee_config_t *config;
+    ee_stream_pattern_t *pattern;
+    ib_mm_t mm;
+
+    assert(cp != NULL);
+    assert(cp->ib != NULL);
+    assert(pattern_name != NULL);
+
+    mm = ib_engine_mm_main_get(cp->ib);
+    config = ee_get_config(cp->ib);
+    assert(config != NULL);
+    assert(config->eudoxus_pattern_hash != NULL);
+
+    rc = ib_hash_get(config->eudoxus_pattern_hash, &automata, pattern_name);
+    if (rc != IB_OK) {
+        ib_log_error(cp->ib,
+                     MODULE_NAME_STR ": No eudoxus automata named \"%s\" to"
+                     " stream; LoadEudoxus it first.",
+                     pattern_name);
+        return IB_ENOENT;
+    }
+
+    if (config->stream_patterns == NULL) {
+        rc = ib_list_create(&(config->stream_patterns), mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    pattern = ib_mm_alloc(mm, sizeof(*pattern));
+    if (pattern == NULL) {
+        return IB_EALLOC;
+    }
+    pattern->name = ib_mm_strdup(mm, pattern_name);
+    if (pattern->name == NULL) {
+        return IB_EALLOC;
+    }
+    pattern->automata = automata;
+
+    return ib_list_push(config->stream_patterns, pattern);
+}
+
+/**
+ * Eudoxus first match callback function.  Called when a match occurs.
+ *
+ * Always returns IA_EUDOXUS_CMD_STOP to stop matching (unless an
+ * error occurs). If capture is enabled the matched text will be stored in the
+ * capture variable.
+ *
+ * @param[in] engine Eudoxus engine.
+ * @param[in] output Output defined by automata.
+ * @param[in] output_length Length of output.
+ * @param[in] input Current location in the input (first character
+ *                  after the match).
+ * @param[in,out] cbdata Pointer to the ee_callback_data_t instance we are
+ *                       handling. This is needed for handling capture
+ *                       of the match.
+ * @return
+ * - IA_EUDOXUS_CMD_ERROR on error
+ * - IA_EUDOXUS_CMD_STOP otherwise.
+ */
+static
+ia_eudoxus_command_t ee_first_match_callback(ia_eudoxus_t* engine,
+                                             const char *output,
+                                             size_t output_length,
+                                             const uint8_t *input,
+                                             void *cbdata)
+{
+    assert(cbdata != NULL);
+    assert(output != NULL);
+
+    ib_status_t rc;
+    ee_callback_data_t *ee_cbdata = cbdata;
+    ib_tx_t *tx = ee_cbdata->tx;
+    ib_field_t *capture = ee_cbdata->capture;
+    ib_bytestr_t *bs;
+    ib_field_t *field;
+    const char *name;
+
+    assert(tx != NULL);
+
+    /* If the match length is not zero, we've already matched something.
+     * In this case, set match to 0 and return that we should continue. */
+    if (ee_cbdata->match_len > 0) {
+        ee_cbdata->match_len = 0;
+        return IA_EUDOXUS_CMD_CONTINUE;
+    }
+
+    /* Tombstoned outputs are withdrawn signatures; skip them as if they
+     * were not in the automata. */
+    if (ee_cbdata->tombstones != NULL) {
+        rc = ib_hash_get_ex(ee_cbdata->tombstones, NULL,
+                            output, output_length);
+        if (rc == IB_OK) {
+            return IA_EUDOXUS_CMD_CONTINUE;
+        }
+    }
+
+    ee_cbdata->match_len = output_length;
+
+    if (capture != NULL) {
+        rc = ib_capture_clear(capture);
+        if (rc != IB_OK) {
+            ib_log_error_tx(tx, "Error clearing captures: %s",
+                            ib_status_to_string(rc));
+            return IA_EUDOXUS_CMD_ERROR;
+        }
+        /* Prefer the copy interned at load time: outputs are deduped at
+         * compile time, so the output address identifies it. */
+        bs = NULL;
+        if (ee_cbdata->interns != NULL) {
+            ib_hash_get_ex(ee_cbdata->interns, &bs,
+                           (const char *)&output, sizeof(output));
+        }
+        if (bs == NULL) {
+            /* Not interned; copy into the transaction pool. */
+            rc = ib_bytestr_dup_mem(&bs,
+                                    tx->mm,
+                                    (const uint8_t *)output, output_length);
+            if (rc != IB_OK) {
+                return IA_EUDOXUS_CMD_ERROR;
+            }
+        }
+        name = ib_capture_name(0);
+        rc = ib_field_create(&field, tx->mm, name, strlen(name),
+                             IB_FTYPE_BYTESTR, ib_ftype_bytestr_in(bs));
+        if (rc != IB_OK) {
+            return IA_EUDOXUS_CMD_ERROR;
+        }
+        rc = ib_capture_set_item(capture, 0, tx->mm, field);
+        if (rc != IB_OK) {
+            return IA_EUDOXUS_CMD_ERROR;
+        }
+    }
+
+    return IA_EUDOXUS_CMD_STOP;
+}
+
+/**
+ * Create an instance of the @c ee operator.
+ *
+ * Looks up the automata name and adds the automata to the operator instance.
+ *
+ * @param[in] ctx Current context.
+ * @param[in] mm Memory manager.
+ * @param[in] parameters Automata name.
+ * @param[out] instance_data Instance data.
+ * @param[in] cbdata Callback data (unused).
+ */
+static
+ib_status_t ee_operator_create(
+    ib_context_t *ctx,
+    ib_mm_t       mm,
+    const char   *parameters,
+    void         *instance_data,
+    void         *cbdata
+)
+{
+    assert(ctx != NULL);
+    assert(parameters != NULL);
     assert(instance_data != NULL);
 
     ib_status_t rc;
-    ia_eudoxus_t* eudoxus;
+    ee_automata_t *automata;
     ee_operator_data_t *operator_data;
     ib_module_t *module;
     ib_engine_t *ib = ib_context_get_engine(ctx);
@@ -484,7 +1122,7 @@ ib_status_t ee_operator_create(
 
     eudoxus_pattern_hash = config->eudoxus_pattern_hash;
 
-    rc = ib_hash_get(eudoxus_pattern_hash, &eudoxus, parameters);
+    rc = ib_hash_get(eudoxus_pattern_hash, &automata, parameters);
     if (rc == IB_ENOENT ) {
         ib_log_error(ib,
                      MODULE_NAME_STR ": No eudoxus automata named %s found.",
@@ -497,7 +1135,7 @@ ib_status_t ee_operator_create(
         return rc;
     }
 
-    operator_data->eudoxus = eudoxus;
+    operator_data->automata = automata;
     rc = ib_uuid_create_v4(operator_data->id);
     if (rc != IB_OK) {
         ib_log_error(ib,
@@ -510,9 +1148,82 @@ ib_status_t ee_operator_create(
     return IB_OK;
 }
 
+/**
+ * Run one automata over one input buffer until match, end, or error.
+ *
+ * @param[in] state Execution state to feed.
+ * @param[in] ee_cbdata Callback data shared with @ref ee_first_match_callback.
+ * @param[in,out] end_of_automata Set to true when the automata dead-ends.
+ * @param[in] input Input buffer.
+ * @param[in] input_len Length of @a input.
+ * @param[in] full_match If true, the full input text must be matched.
+ * @param[out] result Set to 1 on match; unchanged otherwise.
+ */
+static
+ib_status_t ee_run_automata(
+    ia_eudoxus_state_t *state,
+    ee_callback_data_t *ee_cbdata,
+    bool *end_of_automata,
+    const char *input,
+    size_t input_len,
+    bool full_match,
+    ib_num_t *result
+)
+{
+    if (*end_of_automata) {
+        /* Nothing to do. */
+        return IB_OK;
+    }
+
+    /* Loop until we exit by error or success. */
+    for (;;) {
+        ia_eudoxus_result_t ia_rc;
+
+        /* Execute the automata. */
+        ia_rc = ia_eudoxus_execute(state, (const uint8_t *)input, input_len);
+
+        if (ia_rc == IA_EUDOXUS_STOP) {
+
+            if (full_match) {
+                /* We have a full match. Return OK. */
+                if (ee_cbdata->match_len == input_len) {
+                    *result = 1;
+                    return IB_OK;
+                }
+                /* We do not have a full match. Continue matching. */
+                else {
+                    /* Signal that the search should continue. */
+                    input = NULL;
+                }
+            }
+            /* We have a partial or full match. Great. */
+            else {
+                *result = 1;
+                return IB_OK;
+            }
+        }
+        else if (ia_rc == IA_EUDOXUS_END) {
+            *end_of_automata = true;
+            return IB_OK;
+        }
+        else if (ia_rc != IA_EUDOXUS_OK) {
+            return IB_EUNKNOWN;
+        }
+        else {
+            return IB_OK;
+        }
+    }
+
+    return IB_OK;
+}
+
 /**
  * Helper function for stream and non-stream execution.
  *
+ * Runs the base automata with its tombstones applied; if that does not
+ * match and a patch automata is attached, runs the patch over the same
+ * input.
+ *
  * @param[in] tx Transaction
  * @param[in] operator_data Operator data.
  * @param[in] data Per-transaction data for this operator instance.
@@ -537,6 +1248,7 @@ ib_status_t ee_operator_execute_common(
     assert(tx != NULL);
     assert(operator_data != NULL);
     assert(data != NULL);
+    assert(data->epoch != NULL);
 
     *result = 0;
 
@@ -563,52 +1275,28 @@ ib_status_t ee_operator_execute_common(
         return IB_EINVAL;
     }
 
-    if (data->end_of_automata) {
-        /* Nothing to do. */
-        return IB_OK;
+    /* Base automata, with any tombstones applied. */
+    data->ee_cbdata->tombstones = data->epoch->tombstones;
+    data->ee_cbdata->interns = data->epoch->base_interns;
+    rc = ee_run_automata(
+        data->eudoxus_state, data->ee_cbdata, &data->end_of_automata,
+        input, input_len, full_match, result
+    );
+    if (rc != IB_OK || *result != 0) {
+        return rc;
     }
 
-    /* Loop until we exit by error or success. */
-    for (;;) {
-        ia_eudoxus_state_t  *state = data->eudoxus_state;
-        ia_eudoxus_result_t  ia_rc;
-
-        /* Execute the automata. */
-        ia_rc = ia_eudoxus_execute(state, (const uint8_t *)input, input_len);
-
-        if (ia_rc == IA_EUDOXUS_STOP) {
-
-            if (full_match) {
-                /* We have a full match. Return OK. */
-                if (data->ee_cbdata->match_len == input_len) {
-                    *result = 1;
-                    return IB_OK;
-                }
-                /* We do not have a full match. Continue matching. */
-                else {
-                    /* Signal that the search should continue. */
-                    input = NULL;
-                }
-            }
-            /* We have a partial or full match. Great. */
-            else {
-                *result = 1;
-                return IB_OK;
-            }
-        }
-        else if (ia_rc == IA_EUDOXUS_END) {
-            data->end_of_automata = true;
-            return IB_OK;
-        }
-        else if (ia_rc != IA_EUDOXUS_OK) {
-            return IB_EUNKNOWN;
-        }
-        else {
-            return IB_OK;
-        }
+    /* Patch automata: hotfix signatures live alongside the base. */
+    if (data->patch_state != NULL) {
+        data->ee_cbdata->tombstones = NULL;
+        data->ee_cbdata->interns = data->epoch->patch_interns;
+        rc = ee_run_automata(
+            data->patch_state, data->ee_cbdata, &data->end_of_patch,
+            input, input_len, full_match, result
+        );
     }
 
-    return IB_OK;
+    return rc;
 }
 
 /**
@@ -642,36 +1330,63 @@ ib_status_t ee_match_operator_execute_nonstream(
     ib_status_t rc;
     ia_eudoxus_result_t ia_rc;
     ee_operator_data_t *operator_data = instance_data;
-    ia_eudoxus_t* eudoxus = operator_data->eudoxus;
 
     assert(tx != NULL);
     assert(instance_data != NULL);
 
     *result = 0;
 
-    /* Not streaming, so create data for this use only */
-    ee_callback_data_t local_cbdata = { tx, capture, 0 };
+    /* Not streaming, so create data for this use only.  The automata
+     * state does not outlive this call, so pin per evaluation: each
+     * evaluation uses the newest published version. */
+    ee_callback_data_t local_cbdata = { tx, capture, 0, NULL, NULL };
     ee_tx_data_t local_data;
     local_data.ee_cbdata = &local_cbdata;
+    local_data.patch_state = NULL;
+
+    local_data.epoch = ee_epoch_pin(operator_data->automata);
+    if (local_data.epoch == NULL) {
+        return IB_EOTHER;
+    }
 
     ia_rc = ia_eudoxus_create_state(&local_data.eudoxus_state,
-                                    eudoxus,
+                                    local_data.epoch->base,
                                     ee_first_match_callback,
                                     (void *)&local_cbdata);
     if (ia_rc != IA_EUDOXUS_OK) {
         if (local_data.eudoxus_state != NULL) {
             ia_eudoxus_destroy_state(local_data.eudoxus_state);
         }
+        ee_epoch_unpin(local_data.epoch);
         return IB_EINVAL;
     }
     local_data.end_of_automata = false;
+    local_data.end_of_patch = false;
 
+    if (local_data.epoch->patch != NULL) {
+        ia_rc = ia_eudoxus_create_state(&local_data.patch_state,
+                                        local_data.epoch->patch,
+                                        ee_first_match_callback,
+                                        (void *)&local_cbdata);
+        if (ia_rc != IA_EUDOXUS_OK) {
+            if (local_data.patch_state != NULL) {
+                ia_eudoxus_destroy_state(local_data.patch_state);
+            }
+            ia_eudoxus_destroy_state(local_data.eudoxus_state);
+            ee_epoch_unpin(local_data.epoch);
+            return IB_EINVAL;
+        }
+    }
 
     rc = ee_operator_execute_common(
         tx, operator_data, &local_data, field, full_match, result
     );
 
+    if (local_data.patch_state != NULL) {
+        ia_eudoxus_destroy_state(local_data.patch_state);
+    }
     ia_eudoxus_destroy_state(local_data.eudoxus_state);
+    ee_epoch_unpin(local_data.epoch);
 
     return rc;
 }
@@ -762,7 +1477,6 @@ ib_status_t ee_operator_execute_stream(
     ib_status_t rc;
     ia_eudoxus_result_t ia_rc;
     ee_operator_data_t *operator_data = instance_data;
-    ia_eudoxus_t* eudoxus = operator_data->eudoxus;
     ee_tx_data_t* data = NULL;
     ee_callback_data_t *ee_cbdata;
     const ib_module_t *m = (const ib_module_t *)cbdata;
@@ -784,10 +1498,20 @@ ib_status_t ee_operator_execute_stream(
         }
         ee_cbdata->tx = tx;
         ee_cbdata->capture = capture;
+        ee_cbdata->tombstones = NULL;
+        ee_cbdata->interns = NULL;
         data->ee_cbdata = ee_cbdata;
+        data->patch_state = NULL;
+
+        /* The automata state spans calls, so the version is pinned for
+         * the life of the transaction; ee_tx_finished_handler() unpins. */
+        data->epoch = ee_epoch_pin(operator_data->automata);
+        if (data->epoch == NULL) {
+            return IB_EOTHER;
+        }
 
         ia_rc = ia_eudoxus_create_state(&data->eudoxus_state,
-                                        eudoxus,
+                                        data->epoch->base,
                                         ee_first_match_callback,
                                         (void *)ee_cbdata);
         if (ia_rc != IA_EUDOXUS_OK) {
@@ -795,9 +1519,30 @@ ib_status_t ee_operator_execute_stream(
                 ia_eudoxus_destroy_state(data->eudoxus_state);
                 data->eudoxus_state = NULL;
             }
-            return IB_EINVAL;
+            ee_epoch_unpin(data->epoch);
+            data->epoch = NULL;
+            return IB_EINVAL;
+        }
+        data->end_of_automata = false;
+        data->end_of_patch = false;
+
+        if (data->epoch->patch != NULL) {
+            ia_rc = ia_eudoxus_create_state(&data->patch_state,
+                                            data->epoch->patch,
+                                            ee_first_match_callback,
+                                            (void *)ee_cbdata);
+            if (ia_rc != IA_EUDOXUS_OK) {
+                if (data->patch_state != NULL) {
+                    ia_eudoxus_destroy_state(data->patch_state);
+                    data->patch_state = NULL;
+                }
+                ia_eudoxus_destroy_state(data->eudoxus_state);
+                data->eudoxus_state = NULL;
+                ee_epoch_unpin(data->epoch);
+                data->epoch = NULL;
+                return IB_EINVAL;
+            }
         }
-        data->end_of_automata = false;
         set_ee_tx_data(m, tx, operator_data, data);
     }
     else if (rc != IB_OK) {
@@ -867,6 +1612,14 @@ ib_status_t ee_tx_finished_handler(ib_engine_t *ib,
             ia_eudoxus_destroy_state(data->eudoxus_state);
             data->eudoxus_state = NULL;
         }
+        if (data->patch_state != NULL) {
+            ia_eudoxus_destroy_state(data->patch_state);
+            data->patch_state = NULL;
+        }
+        if (data->epoch != NULL) {
+            ee_epoch_unpin(data->epoch);
+            data->epoch = NULL;
+        }
     }
 
     ib_mpool_lite_destroy(mpl);
@@ -875,6 +1628,478 @@ ib_status_t ee_tx_finished_handler(ib_engine_t *ib,
 }
 
 
+/**
+ * Match callback for the streaming body scanner.
+ *
+ * Raises an observation event against the transaction and stops the
+ * scan for this automata; one event per pattern per transaction.
+ *
+ * @param[in] engine Eudoxus engine.
+ * @param[in] output Output defined by automata.
+ * @param[in] output_length Length of output.
+ * @param[in] input Current location in the input.
+ * @param[in,out] cbdata The @ref ee_stream_cbdata_t for this run.
+ * @return
+ * - IA_EUDOXUS_CMD_CONTINUE for suppressed outputs.
+ * - IA_EUDOXUS_CMD_STOP otherwise.
+ */
+static
+ia_eudoxus_command_t ee_stream_match_callback(ia_eudoxus_t* engine,
+                                              const char *output,
+                                              size_t output_length,
+                                              const uint8_t *input,
+                                              void *cbdata)
+{
+    assert(cbdata != NULL);
+    assert(output != NULL);
+
+    ib_status_t rc;
+    ee_stream_cbdata_t *ee_cbdata = cbdata;
+    ib_tx_t *tx = ee_cbdata->scan->tx;
+    ib_logevent_t *event;
+
+    /* Tombstoned outputs are withdrawn signatures; skip them as if they
+     * were not in the automata. */
+    if (ee_cbdata->tombstones != NULL) {
+        rc = ib_hash_get_ex(ee_cbdata->tombstones, NULL,
+                            output, output_length);
+        if (rc == IB_OK) {
+            return IA_EUDOXUS_CMD_CONTINUE;
+        }
+    }
+
+    rc = ib_logevent_create(
+        &event,
+        tx->mm,
+        "ee/stream",
+        IB_LEVENT_TYPE_OBSERVATION,
+        IB_LEVENT_ACTION_UNKNOWN,
+        90,
+        90,
+        "Streaming match of eudoxus pattern \"%s\": %.*s",
+        ee_cbdata->scan->name,
+        (int)output_length,
+        output
+    );
+    if (rc != IB_OK) {
+        return IA_EUDOXUS_CMD_ERROR;
+    }
+    rc = ib_logevent_add(tx, event);
+    if (rc != IB_OK) {
+        return IA_EUDOXUS_CMD_ERROR;
+    }
+
+    return IA_EUDOXUS_CMD_STOP;
+}
+
+/**
+ * Destroy a streaming scan's eudoxus states and release its pin.
+ *
+ * @param[in] scan The scan to tear down.
+ */
+static void ee_stream_scan_teardown(ee_stream_scan_t *scan)
+{
+    assert(scan != NULL);
+
+    if (scan->base_state != NULL) {
+        ia_eudoxus_destroy_state(scan->base_state);
+        scan->base_state = NULL;
+    }
+    if (scan->patch_state != NULL) {
+        ia_eudoxus_destroy_state(scan->patch_state);
+        scan->patch_state = NULL;
+    }
+    if (scan->epoch != NULL) {
+        ee_epoch_unpin(scan->epoch);
+        scan->epoch = NULL;
+    }
+}
+
+/**
+ * Feed one body chunk to a scan.
+ *
+ * @param[in] scan The scan to feed.
+ * @param[in] buf Chunk data.
+ * @param[in] buf_len Length of @a buf.
+ */
+static void ee_stream_scan_chunk(
+    ee_stream_scan_t *scan,
+    const uint8_t *buf,
+    size_t buf_len
+)
+{
+    assert(scan != NULL);
+
+    ia_eudoxus_result_t ia_rc;
+
+    if (! scan->base_done) {
+        ia_rc = ia_eudoxus_execute(scan->base_state, buf, buf_len);
+        if (ia_rc == IA_EUDOXUS_STOP) {
+            /* Matched; the event is raised in the callback.  One event
+             * per pattern: stop scanning it entirely. */
+            scan->base_done = true;
+            scan->patch_done = true;
+        }
+        else if (ia_rc != IA_EUDOXUS_OK) {
+            /* Dead end or error; no more base matches are possible. */
+            scan->base_done = true;
+        }
+    }
+
+    if (scan->patch_state != NULL && ! scan->patch_done) {
+        ia_rc = ia_eudoxus_execute(scan->patch_state, buf, buf_len);
+        if (ia_rc == IA_EUDOXUS_STOP) {
+            scan->base_done = true;
+            scan->patch_done = true;
+        }
+        else if (ia_rc != IA_EUDOXUS_OK) {
+            scan->patch_done = true;
+        }
+    }
+}
+
+/* ib_stream_processor_create_fn */
+static ib_status_t ee_stream_create_fn(
+    void    *instance_data,
+    ib_tx_t *tx,
+    void    *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(tx != NULL);
+
+    ib_status_t rc;
+    ia_eudoxus_result_t ia_rc;
+    const ee_config_t *config;
+    const ib_list_node_t *node;
+    ib_list_t *scans;
+
+    config = ee_get_config(tx->ib);
+    assert(config != NULL);
+    assert(config->stream_patterns != NULL);
+
+    rc = ib_list_create(&scans, tx->mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    IB_LIST_LOOP_CONST(config->stream_patterns, node) {
+        const ee_stream_pattern_t *pattern =
+            (const ee_stream_pattern_t *)ib_list_node_data_const(node);
+        ee_stream_scan_t *scan;
+
+        scan = ib_mm_calloc(tx->mm, 1, sizeof(*scan));
+        if (scan == NULL) {
+            rc = IB_EALLOC;
+            goto failed;
+        }
+        scan->name = pattern->name;
+        scan->tx = tx;
+        scan->base_cbdata.scan = scan;
+        scan->patch_cbdata.scan = scan;
+
+        scan->epoch = ee_epoch_pin(pattern->automata);
+        if (scan->epoch == NULL) {
+            rc = IB_EOTHER;
+            goto failed;
+        }
+        scan->base_cbdata.tombstones = scan->epoch->tombstones;
+
+        ia_rc = ia_eudoxus_create_state(&scan->base_state,
+                                        scan->epoch->base,
+                                        ee_stream_match_callback,
+                                        (void *)&scan->base_cbdata);
+        if (ia_rc != IA_EUDOXUS_OK) {
+            rc = IB_EINVAL;
+            ee_stream_scan_teardown(scan);
+            goto failed;
+        }
+
+        if (scan->epoch->patch != NULL) {
+            ia_rc = ia_eudoxus_create_state(&scan->patch_state,
+                                            scan->epoch->patch,
+                                            ee_stream_match_callback,
+                                            (void *)&scan->patch_cbdata);
+            if (ia_rc != IA_EUDOXUS_OK) {
+                rc = IB_EINVAL;
+                ee_stream_scan_teardown(scan);
+                goto failed;
+            }
+        }
+
+        rc = ib_list_push(scans, scan);
+        if (rc != IB_OK) {
+            ee_stream_scan_teardown(scan);
+            goto failed;
+        }
+    }
+
+    *(void **)instance_data = scans;
+    return IB_OK;
+
+failed:
+    IB_LIST_LOOP_CONST(scans, node) {
+        ee_stream_scan_teardown((ee_stream_scan_t *)ib_list_node_data_const(node));
+    }
+    return rc;
+}
+
+/* ib_stream_processor_execute_fn */
+static ib_status_t ee_stream_execute_fn(
+    void              *instance_data,
+    ib_tx_t           *tx,
+    ib_mm_t            mm_eval,
+    ib_stream_io_tx_t *io_tx,
+    void              *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(tx != NULL);
+    assert(io_tx != NULL);
+
+    ib_list_t *scans = (ib_list_t *)instance_data;
+    ib_status_t rc;
+
+    while (ib_stream_io_data_depth(io_tx) > 0) {
+        ib_stream_io_data_t *data;
+        uint8_t             *buf;
+        size_t               buf_len;
+        ib_stream_io_type_t  data_type;
+        const ib_list_node_t *node;
+
+        rc = ib_stream_io_data_take(io_tx, &data, &buf, &buf_len, &data_type);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        if (data_type == IB_STREAM_IO_DATA && buf_len > 0) {
+            IB_LIST_LOOP_CONST(scans, node) {
+                ee_stream_scan_chunk(
+                    (ee_stream_scan_t *)ib_list_node_data_const(node),
+                    buf,
+                    buf_len
+                );
+            }
+        }
+
+        /* Pure observer: forward every segment untouched. */
+        rc = ib_stream_io_data_put(io_tx, data);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/* ib_stream_processor_destroy_fn */
+static void ee_stream_destroy_fn(
+    void *instance_data,
+    void *cbdata
+)
+{
+    assert(instance_data != NULL);
+
+    ib_list_t *scans = (ib_list_t *)instance_data;
+    const ib_list_node_t *node;
+
+    IB_LIST_LOOP_CONST(scans, node) {
+        ee_stream_scan_teardown(
+            (ee_stream_scan_t *)ib_list_node_data_const(node)
+        );
+    }
+}
+
+/**
+ * On request headers, attach the body scanner when patterns are selected.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] tx Current transaction.
+ * @param[in] state State.
+ * @param[in] cbdata Callback data (unused).
+ *
+ * @returns IB_OK on success.
+ */
+static
+ib_status_t ee_stream_attach_handler(ib_engine_t *ib,
+                                     ib_tx_t *tx,
+                                     ib_state_t state,
+                                     void *cbdata)
+{
+    ib_status_t rc;
+    const ee_config_t *config;
+
+    config = ee_get_config(ib);
+    assert(config != NULL);
+
+    if (config->stream_patterns == NULL ||
+        ib_list_elements(config->stream_patterns) == 0)
+    {
+        return IB_OK;
+    }
+
+    rc = ib_stream_pump_processor_add(
+        ib_tx_request_body_pump(tx),
+        c_stream_processor_name
+    );
+    if (rc != IB_OK) {
+        ib_log_error_tx(
+            tx,
+            "Failed to add eudoxus stream processor: %s",
+            ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Runtime command: publish a new version of a loaded pattern's automata.
+ *
+ * Invoked through the engine manager control channel as
+ * <tt>engine ee_reload \<pattern\> \<file\></tt>.  The named pattern must
+ * have been loaded by LoadEudoxus; the file is a freshly compiled
+ * automata, expected to be a full compile (any hotfix patch and
+ * tombstones on the replaced version are not carried over).
+ *
+ * Transactions starting after the swap use the new version; in-flight
+ * transactions keep the version they pinned, and a replaced version is
+ * destroyed when its last pinned transaction finishes.  This replaces
+ * the full engine reload -- and its connection churn -- for signature
+ * updates.
+ *
+ * @param[in] ib Engine to act on.
+ * @param[in] mm Memory manager for @a result.
+ * @param[in] name The name this command is called by.
+ * @param[in] args Arguments: pattern name and automata file path.
+ * @param[out] result Result message.
+ * @param[in] cbdata Callback data (unused).
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL on malformed arguments or automata load failure.
+ * - IB_ENOENT if the pattern has not been loaded.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ee_reload_cmd(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(args != NULL);
+    assert(result != NULL);
+
+    ib_status_t rc;
+    ia_eudoxus_result_t ia_rc;
+    ia_eudoxus_t *eudoxus;
+    const ee_config_t *config;
+    ee_automata_t *automata;
+    ee_epoch_t *new_epoch;
+    ee_epoch_t *old_epoch;
+    const char *filename;
+    char *pattern_name;
+    size_t stale;
+    char *msg;
+
+    filename = strchr(args, ' ');
+    if (filename == NULL || filename[1] == '\0') {
+        *result = "Usage: ee_reload <pattern> <file>";
+        return IB_EINVAL;
+    }
+    pattern_name = ib_mm_memdup_to_str(mm, args, filename - args);
+    if (pattern_name == NULL) {
+        return IB_EALLOC;
+    }
+    ++filename;
+
+    config = ee_get_config(ib);
+    assert(config != NULL);
+    assert(config->eudoxus_pattern_hash != NULL);
+
+    rc = ib_hash_get(config->eudoxus_pattern_hash, &automata, pattern_name);
+    if (rc != IB_OK) {
+        *result = "No such pattern; LoadEudoxus it first.";
+        return IB_ENOENT;
+    }
+
+    if (access(filename, R_OK) != 0) {
+        *result = "Cannot read automata file.";
+        return IB_EINVAL;
+    }
+
+    ia_rc = ia_eudoxus_create_from_path_mmap(&eudoxus, filename);
+    if (ia_rc != IA_EUDOXUS_OK) {
+        ia_rc = ia_eudoxus_create_from_path(&eudoxus, filename);
+    }
+    if (ia_rc != IA_EUDOXUS_OK) {
+        *result = "Error loading automata file.";
+        return IB_EINVAL;
+    }
+
+    new_epoch = ib_mm_calloc(ib_engine_mm_main_get(ib),
+                             sizeof(*new_epoch), 1);
+    if (new_epoch == NULL) {
+        ia_eudoxus_destroy(eudoxus);
+        return IB_EALLOC;
+    }
+    new_epoch->base = eudoxus;
+    new_epoch->owner = automata;
+
+    rc = ee_intern_outputs(ib_engine_mm_main_get(ib),
+                           eudoxus,
+                           &(new_epoch->base_interns));
+    if (rc != IB_OK) {
+        ia_eudoxus_destroy(eudoxus);
+        *result = "Error interning automata outputs.";
+        return rc;
+    }
+
+    rc = ib_lock_lock(automata->lock);
+    if (rc != IB_OK) {
+        ia_eudoxus_destroy(eudoxus);
+        return rc;
+    }
+    new_epoch->epoch = ++(automata->last_epoch);
+    old_epoch = automata->current;
+    automata->current = new_epoch;
+    if (old_epoch->pins == 0) {
+        ee_epoch_destroy(old_epoch);
+    }
+    else {
+        old_epoch->next = automata->retired;
+        automata->retired = old_epoch;
+    }
+    stale = 0;
+    for (old_epoch = automata->retired;
+         old_epoch != NULL;
+         old_epoch = old_epoch->next)
+    {
+        ++stale;
+    }
+    ib_lock_unlock(automata->lock);
+
+    msg = ib_mm_alloc(mm, 128);
+    if (msg == NULL) {
+        return IB_EALLOC;
+    }
+    snprintf(msg, 128,
+             "Reloaded \"%s\"; now epoch %llu; "
+             "%zu stale version(s) pinned by in-flight transactions.",
+             pattern_name,
+             (unsigned long long)new_epoch->epoch,
+             stale);
+    *result = msg;
+
+    return IB_OK;
+}
+
 /**
  * Initialize the eudoxus operator module.
  *
@@ -968,6 +2193,68 @@ ib_status_t ee_module_init(ib_engine_t *ib,
         return rc;
     }
 
+    rc = ib_engine_ctlcmd_register(ib, "ee_reload", ee_reload_cmd, NULL);
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "Error registering ee_reload runtime command: %s",
+            ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* Register the streaming body scanner. */
+    {
+        ib_mpool_lite_t *mpl;
+        ib_list_t *types;
+
+        rc = ib_mpool_lite_create(&mpl);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_list_create(&types, ib_mm_mpool_lite(mpl));
+        if (rc == IB_OK) {
+            rc = ib_list_push(types, (void *)c_stream_processor_name);
+        }
+        if (rc == IB_OK) {
+            rc = ib_stream_processor_registry_register(
+                ib_engine_stream_processor_registry(ib),
+                c_stream_processor_name,
+                types,
+                ee_stream_create_fn, NULL,
+                ee_stream_execute_fn, NULL,
+                ee_stream_destroy_fn, NULL
+            );
+        }
+        if (rc == IB_OK) {
+            /* The scanner inspects but never alters data. */
+            rc = ib_stream_processor_registry_observe_only_set(
+                ib_engine_stream_processor_registry(ib),
+                c_stream_processor_name,
+                true
+            );
+        }
+        ib_mpool_lite_destroy(mpl);
+        if (rc != IB_OK) {
+            ib_log_error(
+                ib,
+                "Error registering eudoxus stream processor: %s",
+                ib_status_to_string(rc));
+            return rc;
+        }
+    }
+
+    rc = ib_hook_tx_register(ib,
+                             request_header_finished_state,
+                             ee_stream_attach_handler,
+                             NULL);
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "Error registering request header state for ee operator: %s",
+            ib_status_to_string(rc));
+        return rc;
+    }
+
     return IB_OK;
 }
 
@@ -994,7 +2281,7 @@ ib_status_t ee_module_finish(ib_engine_t *ib,
  * This static will *only* be passed to IronBee as part of module
  * definition.  It will never be read or written by any code in this file.
  */
-static ee_config_t g_ee_config = {NULL};
+static ee_config_t g_ee_config = {NULL, NULL};
 
 #ifndef DOXYGEN_SKIP
 static IB_DIRMAP_INIT_STRUCTURE(eudoxus_directive_map) = {
@@ -1004,6 +2291,24 @@ static IB_DIRMAP_INIT_STRUCTURE(eudoxus_directive_map) = {
         NULL
     ),
 
+    IB_DIRMAP_INIT_PARAM2(
+        "LoadEudoxusPatch",
+        load_eudoxus_patch_param2,
+        NULL
+    ),
+
+    IB_DIRMAP_INIT_PARAM2(
+        "EudoxusTombstone",
+        eudoxus_tombstone_param2,
+        NULL
+    ),
+
+    IB_DIRMAP_INIT_PARAM1(
+        "EudoxusStreamInspect",
+        eudoxus_stream_inspect_param1,
+        NULL
+    ),
+
     /* signal the end of the list */
     IB_DIRMAP_INIT_LAST
 };
@@ -29,6 +29,7 @@
 #include <ironbeepp/configuration_directives.hpp>
 #include <ironbeepp/configuration_parser.hpp>
 #include <ironbeepp/c_trampoline.hpp>
+#include <ironbeepp/hooks.hpp>
 #include <ironbeepp/module.hpp>
 #include <ironbeepp/module_bootstrap.hpp>
 #include <ironbeepp/module_delegate.hpp>
@@ -45,10 +46,10 @@
 #pragma clang diagnostic ignored "-Wunused-local-typedef"
 #endif
 #endif
-#include <boost/algorithm/string/replace.hpp>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/shared_ptr.hpp>
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
@@ -60,6 +61,10 @@
 #endif
 #include <inttypes.h>
 
+#include <cstring>
+#include <utility>
+#include <vector>
+
 /**
  * Error Page Module implementation.
  */
@@ -101,6 +106,14 @@ private:
         const char                   *param1,
         const char                   *param2
     );
+
+    /**
+     * Pre-render the configured error pages when a context closes.
+     *
+     * @param[in] ib The engine.
+     * @param[in] ctx The closing context.
+     */
+    void on_context_close(IronBee::Engine ib, IronBee::Context ctx);
 };
 
 IBPP_BOOTSTRAP_MODULE_DELEGATE("ErrorPageModule", ErrorPageModule);
@@ -110,6 +123,36 @@ IBPP_BOOTSTRAP_MODULE_DELEGATE("ErrorPageModule", ErrorPageModule);
  */
 typedef std::map<ib_num_t, std::string> status_to_file_map_t;
 
+/**
+ * An error page pre-rendered at context close.
+ *
+ * Holds the page bytes and the literal segments around every
+ * @c ${TRANSACTION_ID} placeholder, so serving a block is a single
+ * exact-size assembly of those segments and the transaction id --- or a
+ * zero-copy alias of the shared buffer when the page has no
+ * placeholder. The buffer is reference counted and shared with every
+ * context that inherits the page.
+ */
+struct PrerenderedPage {
+
+    /**
+     * The page bytes, placeholders included.
+     */
+    std::string data;
+
+    /**
+     * Literal (offset, length) ranges of @c data.
+     *
+     * A transaction id belongs between each consecutive pair.
+     */
+    std::vector<std::pair<size_t, size_t> > segments;
+};
+
+/**
+ * A reference counted, immutable @ref PrerenderedPage.
+ */
+typedef boost::shared_ptr<const PrerenderedPage> prerendered_page_p;
+
 /**
  * Context configuration value for the ErrorPageModule.
  */
@@ -125,8 +168,55 @@ struct ErrorPageCtxConfig {
      */
     std::map<ib_num_t, boost::iostreams::mapped_file_source>
         status_to_mapped_file_source;
+
+    /**
+     * The mapping from an HTTP status code to the pre-rendered page.
+     *
+     * Populated when the context closes.
+     */
+    std::map<ib_num_t, prerendered_page_p> status_to_page;
 };
 
+namespace {
+
+/**
+ * The text replaced with the transaction id when a page is served.
+ */
+const char TX_ID_PLACEHOLDER[]      = "${TRANSACTION_ID}";
+const size_t TX_ID_PLACEHOLDER_LEN  = sizeof(TX_ID_PLACEHOLDER) - 1;
+
+/**
+ * Split @a source into literal segments around every placeholder.
+ *
+ * @param[in] source The memory mapped error page file.
+ *
+ * @returns The pre-rendered page.
+ */
+prerendered_page_p prerender_page(
+    const boost::iostreams::mapped_file_source& source
+)
+{
+    boost::shared_ptr<PrerenderedPage> page(new PrerenderedPage());
+
+    page->data.assign(source.data(), source.size());
+
+    size_t start = 0;
+    for (;;) {
+        size_t pos = page->data.find(TX_ID_PLACEHOLDER, start);
+        if (pos == std::string::npos) {
+            break;
+        }
+        page->segments.push_back(std::make_pair(start, pos - start));
+        start = pos + TX_ID_PLACEHOLDER_LEN;
+    }
+    page->segments.push_back(
+        std::make_pair(start, page->data.size() - start));
+
+    return page;
+}
+
+} // anonymous namespace
+
 /* Implementation */
 
 ErrorPageModule::ErrorPageModule(IronBee::Module module):
@@ -146,9 +236,36 @@ ErrorPageModule::ErrorPageModule(IronBee::Module module):
                 &ErrorPageModule::errorPageMapDirective,
                 this, _1, _2, _3, _4));
 
+    module.engine().register_hooks()
+        .context_close(
+            boost::bind(&ErrorPageModule::on_context_close, this, _1, _2));
+
     module.set_configuration_data<ErrorPageCtxConfig>();
 }
 
+void ErrorPageModule::on_context_close(
+    IronBee::Engine  ib,
+    IronBee::Context ctx
+)
+{
+    ErrorPageCtxConfig &cfg =
+        module().configuration_data<ErrorPageCtxConfig>(ctx);
+
+    /* Render every mapped page once, here, so serving a block does no
+     * parsing and at most one allocation. Pages inherited from an
+     * enclosing context are rendered again per context; the cost is
+     * configuration-time only. */
+    for (
+        std::map<ib_num_t, boost::iostreams::mapped_file_source>::iterator
+            itr = cfg.status_to_mapped_file_source.begin();
+        itr != cfg.status_to_mapped_file_source.end();
+        ++itr
+    )
+    {
+        cfg.status_to_page[itr->first] = prerender_page(itr->second);
+    }
+}
+
 void ErrorPageModule::errorPageMapDirective(
         IronBee::ConfigurationParser  cp,
         const char                   *name,
@@ -189,11 +306,11 @@ void ErrorPageModule::post_block(
     ErrorPageCtxConfig &cfg =
         module().configuration_data<ErrorPageCtxConfig>(tx.context());
 
-    status_to_file_map_t::iterator itr =
-        cfg.status_to_file.find(info.status);
+    std::map<ib_num_t, prerendered_page_p>::const_iterator itr =
+        cfg.status_to_page.find(info.status);
 
     /* If we can't find a mapping, decline. The default will take over. */
-    if (itr == cfg.status_to_file.end()) {
+    if (itr == cfg.status_to_page.end()) {
         ib_log_debug2_tx(
             tx.ib(),
             "No custom page mapped for status %d and context %s. "
@@ -204,39 +321,10 @@ void ErrorPageModule::post_block(
         return;
     }
 
-#ifndef NDEBUG
-    const std::string& file = itr->second;
-#endif
-    const boost::iostreams::mapped_file_source &source =
-        cfg.status_to_mapped_file_source[info.status];
-
-    /* The error page to be handed to the server is written to this
-     * output string stream. */
-    std::ostringstream error_page_output_stream;
-
-    /* Optimization: Reserve the document size + 37 characters for a UUID.
-     * We assume that the transaction ID is only replaced once. */
-    error_page_output_stream.str().reserve(source.size() + 37);
-
-    /* Replace holder text with transaction id. */
-    boost::algorithm::replace_all_copy(
-        /* Output iterator. */
-        std::ostream_iterator<char>(error_page_output_stream),
-
-        /* The range. */
-        std::pair<const char *, const char *>(
-            source.data(),
-            source.data()+ source.size()
-        ),
-
-        /* The text to replace. */
-        "${TRANSACTION_ID}",
-
-        /* What to replace the text with. */
-        tx.id()
-    );
+    const PrerenderedPage &page = *(itr->second);
 
 #ifndef NDEBUG
+    const std::string& file = cfg.status_to_file[info.status];
     ib_log_debug2_tx(
         tx.ib(),
         "Using custom error page file %.*s.",
@@ -245,11 +333,45 @@ void ErrorPageModule::post_block(
     );
 #endif
 
-    IronBee::ByteString body = IronBee::ByteString::create(
-        tx.memory_manager(),
-        error_page_output_stream.str().data(),
-        error_page_output_stream.str().size()
-    );
+    IronBee::ByteString body;
+
+    if (page.segments.size() == 1) {
+        /* No placeholder: alias the shared buffer. The configuration
+         * holding it outlives every transaction. */
+        body = IronBee::ByteString::create_alias(
+            tx.memory_manager(),
+            page.data.data() + page.segments[0].first,
+            page.segments[0].second
+        );
+    }
+    else {
+        /* Assemble the literal segments and the transaction id into a
+         * single buffer of exactly the right size. */
+        const char  *tx_id = tx.id();
+        const size_t tx_id_len = strlen(tx_id);
+
+        size_t total = tx_id_len * (page.segments.size() - 1);
+        for (size_t i = 0; i < page.segments.size(); ++i) {
+            total += page.segments[i].second;
+        }
+
+        char *buffer = tx.memory_manager().allocate<char>(total);
+        char *out = buffer;
+        for (size_t i = 0; i < page.segments.size(); ++i) {
+            memcpy(
+                out,
+                page.data.data() + page.segments[i].first,
+                page.segments[i].second);
+            out += page.segments[i].second;
+            if (i + 1 < page.segments.size()) {
+                memcpy(out, tx_id, tx_id_len);
+                out += tx_id_len;
+            }
+        }
+
+        body = IronBee::ByteString::create_alias(
+            tx.memory_manager(), buffer, total);
+    }
 
     ib_status_t rc = ib_tx_response(tx.ib(), info.status, NULL, body.ib());
     if ((rc == IB_DECLINED) || (rc == IB_ENOTIMPL)) {
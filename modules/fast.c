@@ -21,9 +21,10 @@
  *
  * This module adds support for fast rules.  See fast/fast.html for details.
  *
- * Provides a single directive:
+ * Provides two directives:
  * @code
  * FastAutomata <path>
+ * FastAutomataGenerate on
  * @endcode
  *
  * @c FastAutomata must occur in the main context and at most once in
@@ -33,6 +34,13 @@
  * rules into a set of scripts which creates the automata (see
  * fast/fast.html).
  *
+ * @c FastAutomataGenerate (only available when IronBee is built with C++
+ * support) replaces the offline toolchain: it claims every eligible
+ * positive @c @@rx rule, extracts a required literal anchor from its
+ * pattern, and compiles the automata in process when the main context
+ * closes.  Rules need not carry the @c fast action; ineligible rules are
+ * left to run normally.  The two directives are mutually exclusive.
+ *
  * In general, @c EOTHER is used to indicate IronBee related failures and
  * @c EINVAL is used to indicate IronAutomata related failures.
  *
@@ -53,7 +61,14 @@
 #include <ironbee/rule_engine.h>
 #include <ironbee/string.h>
 
+#ifdef FAST_ENABLE_GENERATE
+#include "fast_compile.h"
+#include "rule_engine_private.h"
+#endif
+
 #include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
 
 /** Module name. */
 #define MODULE_NAME        fast
@@ -71,6 +86,7 @@ typedef struct fast_search_t                  fast_search_t;
 typedef struct fast_collection_spec_t         fast_collection_spec_t;
 typedef struct fast_collection_runtime_spec_t fast_collection_runtime_spec_t;
 typedef struct fast_specs_t                   fast_specs_t;
+typedef struct fast_generate_t                fast_generate_t;
 
 /**
  * Module runtime data.
@@ -91,6 +107,30 @@ struct fast_runtime_t
 
     /** Specs on what to feed. */
     fast_specs_t *specs;
+
+    /** Automata generation state; NULL unless @c FastAutomataGenerate. */
+    fast_generate_t *gen;
+};
+
+/**
+ * Automata generation state.
+ *
+ * Accumulates literal anchors and claimed rules as ownership is evaluated
+ * at each context close; the automata itself is compiled from this once
+ * the main context closes.  The Nth element of @c patterns is the anchor
+ * of the Nth element of @c rules, and N is the automata output for that
+ * anchor, mirroring the index of offline-built automata.
+ */
+struct fast_generate_t
+{
+    /** AC patterns (@c const @c char *), in index order. */
+    ib_list_t *patterns;
+
+    /** Claimed rules (@c const @c ib_rule_t *), in index order. */
+    ib_list_t *rules;
+
+    /** Hash of rule id (@c const @c char *) to index (@c uint32_t *). */
+    ib_hash_t *index_by_id;
 };
 
 /**
@@ -1142,6 +1182,578 @@ done:
     return rc;
 }
 
+#ifdef FAST_ENABLE_GENERATE
+
+/**
+ * Minimum length of an extracted literal anchor.
+ *
+ * Shorter anchors match so often that the prefilter stops filtering;
+ * rules whose patterns yield no anchor at least this long run unfiltered.
+ */
+static const size_t c_min_anchor_length = 4;
+
+/**
+ * Fetch the names fed to the automata during @a phase.
+ *
+ * @param[in]  phase       Phase to look up.
+ * @param[out] bytestrings NULL terminated array of bytestring var names.
+ * @param[out] collections NULL terminated array of collection specs.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if the fast module does not run in @a phase.
+ */
+static
+ib_status_t fast_phase_feed_names(
+    ib_rule_phase_num_t             phase,
+    const char                   ***bytestrings,
+    const fast_collection_spec_t  **collections
+)
+{
+    assert(bytestrings != NULL);
+    assert(collections != NULL);
+
+    switch (phase) {
+    case IB_PHASE_REQUEST_HEADER:
+        *bytestrings = (const char **)c_request_header_bytestrings;
+        *collections = c_request_header_collections;
+        return IB_OK;
+    case IB_PHASE_REQUEST:
+        *bytestrings = (const char **)c_request_body_bytestrings;
+        *collections = c_request_body_collections;
+        return IB_OK;
+    case IB_PHASE_RESPONSE_HEADER:
+        *bytestrings = (const char **)c_response_header_bytestrings;
+        *collections = c_response_header_collections;
+        return IB_OK;
+    case IB_PHASE_RESPONSE:
+        *bytestrings = (const char **)c_response_body_bytestrings;
+        *collections = c_response_body_collections;
+        return IB_OK;
+    default:
+        return IB_ENOENT;
+    }
+}
+
+/**
+ * Is the var named @a name (length @a len) among the fed names?
+ *
+ * @param[in] name        Var name; not NUL terminated.
+ * @param[in] len         Length of @a name.
+ * @param[in] bytestrings NULL terminated array of bytestring var names.
+ * @param[in] collections NULL terminated array of collection specs.
+ *
+ * @returns True iff @a name is fed to the automata.
+ */
+static
+bool fast_name_fed(
+    const char                    *name,
+    size_t                         len,
+    const char                   **bytestrings,
+    const fast_collection_spec_t  *collections
+)
+{
+    assert(name        != NULL);
+    assert(bytestrings != NULL);
+    assert(collections != NULL);
+
+    for (const char **b = bytestrings; *b != NULL; ++b) {
+        if (strlen(*b) == len && strncasecmp(*b, name, len) == 0) {
+            return true;
+        }
+    }
+    for (const fast_collection_spec_t *c = collections;
+         c->name != NULL;
+         ++c)
+    {
+        if (strlen(c->name) == len && strncasecmp(c->name, name, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Extract a required literal anchor from regular expression @a regex.
+ *
+ * Scans @a regex for the longest run of literal bytes that any matching
+ * input must contain, considering only the top level of the pattern:
+ * groups, classes, and single-byte wildcards end a run without
+ * invalidating earlier ones, a trailing <tt>?</tt>, <tt>*</tt>, or
+ * <tt>{0,...}</tt> drops the byte it quantifies, and a top level
+ * alternation means no byte is required at all.  The extraction is
+ * deliberately conservative: failure only costs the rule its prefilter.
+ *
+ * The anchor is emitted as an Aho-Corasick pattern with every letter
+ * case-insensitive (<tt>\\iX</tt>), so case-insensitive regexps are
+ * covered; for case-sensitive ones this merely over-matches, injecting a
+ * rule whose operator then decides.
+ *
+ * @param[in]  mm          Memory manager for @a out_pattern.
+ * @param[in]  regex       Regular expression to extract from.
+ * @param[out] out_pattern AC pattern of the anchor, on IB_OK.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_DECLINED if no anchor of at least @ref c_min_anchor_length could
+ *   be extracted.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t fast_extract_anchor(
+    ib_mm_t      mm,
+    const char  *regex,
+    const char **out_pattern
+)
+{
+    assert(regex       != NULL);
+    assert(out_pattern != NULL);
+
+/* These macros are local to this function. */
+#ifndef DOXYGEN_SKIP
+#define FAST_END_RUN() \
+    { \
+        if (cur_len > best_len) { \
+            memcpy(best, cur, cur_len); \
+            best_len = cur_len; \
+        } \
+        cur_len = 0; \
+    }
+#define FAST_DROP_LAST() \
+    { \
+        if (cur_len > 0) { \
+            --cur_len; \
+        } \
+    }
+#endif
+
+    uint8_t     cur[256];
+    uint8_t     best[256];
+    size_t      cur_len  = 0;
+    size_t      best_len = 0;
+    size_t      depth    = 0;
+    bool        in_class = false;
+    const char *p;
+
+    for (p = regex; *p != '\0'; ++p) {
+        const char c = *p;
+
+        if (in_class) {
+            if (c == '\\' && p[1] != '\0') {
+                ++p;
+            }
+            else if (c == ']') {
+                in_class = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+        case '[':
+            in_class = true;
+            if (depth == 0) {
+                FAST_END_RUN();
+            }
+            break;
+        case '(':
+            ++depth;
+            if (depth == 1) {
+                FAST_END_RUN();
+            }
+            break;
+        case ')':
+            if (depth == 0) {
+                /* Malformed; leave it to the operator. */
+                return IB_DECLINED;
+            }
+            --depth;
+            break;
+        case '|':
+            if (depth == 0) {
+                /* Top level alternation; nothing is required. */
+                return IB_DECLINED;
+            }
+            break;
+        case '^':
+        case '$':
+        case '.':
+            if (depth == 0) {
+                FAST_END_RUN();
+            }
+            break;
+        case '?':
+        case '*':
+            if (depth == 0) {
+                FAST_DROP_LAST();
+                FAST_END_RUN();
+            }
+            break;
+        case '+':
+            /* The quantified byte is still required once. */
+            if (depth == 0) {
+                FAST_END_RUN();
+            }
+            break;
+        case '{':
+        {
+            const char *q = p;
+            if (depth == 0) {
+                if (p[1] == '0') {
+                    FAST_DROP_LAST();
+                }
+                FAST_END_RUN();
+            }
+            while (*q != '\0' && *q != '}') {
+                ++q;
+            }
+            if (*q == '\0') {
+                return IB_DECLINED;
+            }
+            p = q;
+            break;
+        }
+        case '\\':
+            ++p;
+            if (*p == '\0') {
+                return IB_DECLINED;
+            }
+            if (isalnum((unsigned char)*p)) {
+                /* Shortcut, anchor, or backreference. */
+                if (depth == 0) {
+                    FAST_END_RUN();
+                }
+            }
+            else if (depth == 0) {
+                /* Escaped literal. */
+                if (cur_len < sizeof(cur)) {
+                    cur[cur_len++] = (uint8_t)*p;
+                }
+                else {
+                    FAST_END_RUN();
+                }
+            }
+            break;
+        default:
+            if (depth == 0) {
+                if (cur_len < sizeof(cur)) {
+                    cur[cur_len++] = (uint8_t)c;
+                }
+                else {
+                    FAST_END_RUN();
+                }
+            }
+            break;
+        }
+    }
+
+    if (in_class || depth != 0) {
+        return IB_DECLINED;
+    }
+    FAST_END_RUN();
+
+#undef FAST_END_RUN
+#undef FAST_DROP_LAST
+
+    if (best_len < c_min_anchor_length) {
+        return IB_DECLINED;
+    }
+
+    /* Worst case is four output bytes (\xHH) per anchor byte. */
+    {
+        char   *pattern = ib_mm_alloc(mm, 4 * best_len + 1);
+        size_t  o = 0;
+
+        if (pattern == NULL) {
+            return IB_EALLOC;
+        }
+        for (size_t i = 0; i < best_len; ++i) {
+            const uint8_t b = best[i];
+            if (isalpha(b)) {
+                pattern[o++] = '\\';
+                pattern[o++] = 'i';
+                pattern[o++] = (char)b;
+            }
+            else if (b == '\\' || b == '[' || b == ']') {
+                pattern[o++] = '\\';
+                pattern[o++] = (char)b;
+            }
+            else if (isprint(b)) {
+                pattern[o++] = (char)b;
+            }
+            else {
+                o += sprintf(pattern + o, "\\x%02X", b);
+            }
+        }
+        pattern[o] = '\0';
+        *out_pattern = pattern;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Ownership function used when generating automata.
+ *
+ * Claims @a rule if it can be prefiltered without changing behavior: a
+ * positive, unchained @c @@rx rule without false actions, every target of
+ * which is fed untransformed to the automata during the rule's phase, and
+ * whose pattern yields a literal anchor.  Everything else is declined and
+ * runs normally.
+ *
+ * @param[in] ib     IronBee engine.
+ * @param[in] rule   Rule to evaluate claim.
+ * @param[in] ctx    Context @a rule is enabled in.
+ * @param[in] cbdata Runtime.
+ *
+ * @returns
+ * - IB_OK if claimed.
+ * - IB_DECLINED if the rule cannot be prefiltered.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on IronBee API failure.
+ */
+static
+ib_status_t fast_generate_ownership(
+    const ib_engine_t  *ib,
+    const ib_rule_t    *rule,
+    const ib_context_t *ctx,
+    void               *cbdata
+)
+{
+    assert(ib     != NULL);
+    assert(rule   != NULL);
+    assert(cbdata != NULL);
+
+    fast_config_t  *cfg     = fast_get_config(ib, ctx);
+    fast_runtime_t *runtime = (fast_runtime_t *)cbdata;
+
+    assert(cfg          != NULL);
+    assert(cfg->rules   != NULL);
+    assert(runtime      != NULL);
+    assert(runtime->gen != NULL);
+    assert(runtime == cfg->runtime);
+
+    fast_generate_t              *gen = runtime->gen;
+    const char                  **bytestrings;
+    const fast_collection_spec_t *collections;
+    const ib_list_node_t         *node;
+    uint32_t                     *index;
+    ib_status_t                   rc;
+
+    /* Does the fast module run in this rule's phase at all? */
+    rc = fast_phase_feed_names(rule->meta.phase, &bytestrings, &collections);
+    if (rc != IB_OK) {
+        return IB_DECLINED;
+    }
+
+    /* Only simple, positive @rx rules.  A skipped rule behaves as if its
+     * operator returned false, so false actions rule out prefiltering, as
+     * do inversion and chains. */
+    if (rule->meta.id == NULL || rule->opinst == NULL) {
+        return IB_DECLINED;
+    }
+    if (rule->opinst->invert) {
+        return IB_DECLINED;
+    }
+    if (strcmp(
+            ib_operator_name(ib_operator_inst_operator(rule->opinst->opinst)),
+            "rx"
+        ) != 0)
+    {
+        return IB_DECLINED;
+    }
+    if (ib_rule_is_chained(rule) || rule->chained_rule != NULL) {
+        return IB_DECLINED;
+    }
+    if (
+        rule->false_actions != NULL &&
+        ib_list_elements(rule->false_actions) > 0
+    ) {
+        return IB_DECLINED;
+    }
+    if (
+        rule->target_fields == NULL ||
+        ib_list_elements(rule->target_fields) == 0
+    ) {
+        return IB_DECLINED;
+    }
+
+    /* Every target must be fed to the automata, untransformed; a
+     * transformation or unfed var would make the anchor meaningless. */
+    IB_LIST_LOOP_CONST(rule->target_fields, node) {
+        const ib_rule_target_t *target =
+            (const ib_rule_target_t *)ib_list_node_data_const(node);
+        const char             *name;
+        size_t                  len;
+
+        if (target->target == NULL) {
+            return IB_DECLINED;
+        }
+        if (target->tfn_list != NULL && ib_list_elements(target->tfn_list) > 0)
+        {
+            return IB_DECLINED;
+        }
+        ib_var_target_source_name(target->target, &name, &len);
+        if (! fast_name_fed(name, len, bytestrings, collections)) {
+            return IB_DECLINED;
+        }
+    }
+
+    rc = ib_hash_get(gen->index_by_id, &index, rule->meta.id);
+    if (rc == IB_ENOENT) {
+        ib_mm_t     mm = ib_engine_mm_main_get(ib);
+        const char *pattern;
+        const char *params = ib_operator_inst_parameters(rule->opinst->opinst);
+
+        if (params == NULL) {
+            return IB_DECLINED;
+        }
+        rc = fast_extract_anchor(mm, params, &pattern);
+        if (rc == IB_DECLINED) {
+            ib_log_debug(
+                ib,
+                "fast: No anchor in pattern of rule %s; not prefiltered.",
+                rule->meta.id
+            );
+            return IB_DECLINED;
+        }
+        else if (rc != IB_OK) {
+            return rc;
+        }
+
+        index = ib_mm_alloc(mm, sizeof(*index));
+        if (index == NULL) {
+            return IB_EALLOC;
+        }
+        *index = (uint32_t)ib_list_elements(gen->rules);
+
+        rc = ib_list_push(gen->patterns, (void *)pattern);
+        if (rc != IB_OK) {
+            return IB_EOTHER;
+        }
+        rc = ib_list_push(gen->rules, (void *)rule);
+        if (rc != IB_OK) {
+            return IB_EOTHER;
+        }
+        rc = ib_hash_set(gen->index_by_id, rule->meta.id, index);
+        if (rc != IB_OK) {
+            return IB_EOTHER;
+        }
+
+        ib_log_debug(
+            ib,
+            "fast: Anchor \"%s\" extracted for rule %s.",
+            pattern,
+            rule->meta.id
+        );
+    }
+    else if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "fast: Error accessing generation index: %s",
+            ib_status_to_string(rc)
+        );
+        return IB_EOTHER;
+    }
+
+    /* Mark as eligible in this context. */
+    {
+        void *dummy_value = NULL;
+        rc = ib_hash_set_ex(
+            cfg->rules,
+            (const char *)index,
+            sizeof(*index),
+            &dummy_value
+        );
+        if (rc != IB_OK) {
+            ib_log_error(
+                ib,
+                "fast: Rule %s unable to be added to eligible rules: %s",
+                rule->meta.id,
+                ib_status_to_string(rc)
+            );
+            return IB_EOTHER;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Compile the generated automata and build the rule index.
+ *
+ * Called at main context close, once every context has had its rules
+ * claimed.  With no claimed rules the runtime's Eudoxus engine stays
+ * NULL and injection does nothing.
+ *
+ * @param[in] ib      IronBee engine.
+ * @param[in] runtime Runtime whose automata to build.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL on compilation failure; claimed rules would otherwise be
+ *   lost, so this aborts configuration.
+ */
+static
+ib_status_t fast_generate_build(
+    ib_engine_t    *ib,
+    fast_runtime_t *runtime
+)
+{
+    assert(ib           != NULL);
+    assert(runtime      != NULL);
+    assert(runtime->gen != NULL);
+
+    fast_generate_t      *gen   = runtime->gen;
+    const size_t          count = ib_list_elements(gen->rules);
+    const ib_list_node_t *node;
+    size_t                i;
+    ib_status_t           rc;
+
+    if (count == 0) {
+        ib_log_notice(
+            ib,
+            "fast: No rules eligible for generated automata; "
+            "prefilter disabled."
+        );
+        return IB_OK;
+    }
+
+    runtime->index = ib_mm_calloc(
+        ib_engine_mm_main_get(ib),
+        count,
+        sizeof(*runtime->index)
+    );
+    if (runtime->index == NULL) {
+        return IB_EALLOC;
+    }
+    i = 0;
+    IB_LIST_LOOP_CONST(gen->rules, node) {
+        runtime->index[i] = (const ib_rule_t *)ib_list_node_data_const(node);
+        ++i;
+    }
+
+    rc = fast_compile_automata(ib, gen->patterns, &runtime->eudoxus);
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "fast: Error compiling generated automata: %s",
+            ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    ib_log_info(
+        ib,
+        "fast: Generated automata prefilters %zd rules.",
+        count
+    );
+
+    return IB_OK;
+}
+
+#endif /* FAST_ENABLE_GENERATE */
+
 /**
  * Evaluate automata for a single phase.
  *
@@ -1182,9 +1794,13 @@ ib_status_t fast_rule_injection(
     const fast_config_t *cfg = fast_get_config_module(m, rule_exec->tx->ctx);
     assert(cfg != NULL);
     const fast_runtime_t *runtime = cfg->runtime;
-    assert(runtime          != NULL);
-    assert(runtime->eudoxus != NULL);
-    assert(runtime->index   != NULL);
+    assert(runtime != NULL);
+
+    /* Generated automata with no claimed rules; nothing to inject. */
+    if (runtime->eudoxus == NULL) {
+        return IB_OK;
+    }
+    assert(runtime->index != NULL);
 
     ia_eudoxus_result_t   irc;
     ia_eudoxus_state_t   *state = NULL;
@@ -1480,6 +2096,7 @@ ib_status_t fast_ctx_close(
 
     if (ib_context_type(ctx) == IB_CTYPE_MAIN) {
         fast_config_t *cfg = fast_get_config(ib, ctx);
+        ib_status_t    rc;
         if (cfg == NULL) {
             return IB_EOTHER;
         }
@@ -1491,7 +2108,125 @@ ib_status_t fast_ctx_close(
             return IB_EALLOC;
         }
 
-        return fast_convert_specs(ib, cfg->runtime->specs);
+        rc = fast_convert_specs(ib, cfg->runtime->specs);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+#ifdef FAST_ENABLE_GENERATE
+        /* All contexts have closed; compile the generated automata. */
+        if (cfg->runtime->gen != NULL) {
+            return fast_generate_build(ib, cfg->runtime);
+        }
+#endif
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Register the callbacks shared by both fast directives.
+ *
+ * Registers the injection functions for each supported phase, the
+ * ownership function @a ownership_fn, the @c fast action, and the context
+ * open/close hooks.  Called exactly once, by whichever directive enables
+ * the module.
+ *
+ * @param[in] ib           IronBee engine.
+ * @param[in] module       The fast module.
+ * @param[in] runtime      Runtime; ownership callback data.
+ * @param[in] ownership_fn Ownership function to register.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Any error of the registration routines.
+ */
+static
+ib_status_t fast_register_callbacks(
+    ib_engine_t            *ib,
+    ib_module_t            *module,
+    fast_runtime_t         *runtime,
+    ib_rule_ownership_fn_t  ownership_fn
+)
+{
+    assert(ib           != NULL);
+    assert(module       != NULL);
+    assert(runtime      != NULL);
+    assert(ownership_fn != NULL);
+
+    ib_status_t rc;
+
+    /* Register hooks */
+    rc = ib_rule_register_injection_fn(
+        ib,
+        MODULE_NAME_STR,
+        IB_PHASE_REQUEST_HEADER,
+        fast_rule_injection_request_header, module
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_rule_register_injection_fn(
+        ib,
+        MODULE_NAME_STR,
+        IB_PHASE_REQUEST,
+        fast_rule_injection_request_body, module
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_rule_register_injection_fn(
+        ib,
+        MODULE_NAME_STR,
+        IB_PHASE_RESPONSE_HEADER,
+        fast_rule_injection_response_header, module
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_rule_register_injection_fn(
+        ib,
+        MODULE_NAME_STR,
+        IB_PHASE_RESPONSE,
+        fast_rule_injection_response_body, module
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_rule_register_ownership_fn(
+        ib,
+        MODULE_NAME_STR,
+        ownership_fn, runtime
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Register the fast "action" */
+    rc = ib_action_create_and_register(
+        NULL, ib,
+        c_fast_action,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Register context open hook to setup per-context data. */
+    rc = ib_hook_context_register(ib, context_open_state,
+                                  fast_ctx_open, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    /* Register context close hook to convert specs once all vars are
+     * registered. */
+    rc = ib_hook_context_register(ib, context_close_state,
+                                  fast_ctx_close, NULL);
+    if (rc != IB_OK) {
+        return rc;
     }
 
     return IB_OK;
@@ -1705,67 +2440,124 @@ ib_status_t fast_dir_fast_automata(
         }
     }
 
-    /* Register hooks */
-    rc = ib_rule_register_injection_fn(
-        ib,
-        MODULE_NAME_STR,
-        IB_PHASE_REQUEST_HEADER,
-        fast_rule_injection_request_header, module
-    );
-    FAST_CHECK_RC("Error registering injection for request header phase.");
-    rc = ib_rule_register_injection_fn(
-        ib,
-        MODULE_NAME_STR,
-        IB_PHASE_REQUEST,
-        fast_rule_injection_request_body, module
-    );
-    FAST_CHECK_RC("Error registering injection for request header phase.");
-    rc = ib_rule_register_injection_fn(
-        ib,
-        MODULE_NAME_STR,
-        IB_PHASE_RESPONSE_HEADER,
-        fast_rule_injection_response_header, module
-    );
-    FAST_CHECK_RC("Error registering injection for response header phase.");
-    rc = ib_rule_register_injection_fn(
-        ib,
-        MODULE_NAME_STR,
-        IB_PHASE_RESPONSE,
-        fast_rule_injection_response_body, module
-    );
-    FAST_CHECK_RC("Error registering injection for response header phase.");
+    rc = fast_register_callbacks(ib, module, runtime, fast_ownership);
+    FAST_CHECK_RC("Error registering callbacks");
 
-    rc = ib_rule_register_ownership_fn(
-        ib,
-        MODULE_NAME_STR,
-        fast_ownership, runtime
-    );
-    FAST_CHECK_RC("Error registering ownership");
+    return IB_OK;
+#undef FAST_METADATA_ERROR
+#undef FAST_IB_ERROR
+}
 
-    /* Register the fast "action" */
-    rc = ib_action_create_and_register(
-        NULL, ib,
-        c_fast_action,
-        NULL, NULL,
-        NULL, NULL,
-        NULL, NULL
-    );
-    FAST_CHECK_RC("Error registering action");
+#ifdef FAST_ENABLE_GENERATE
+/**
+ * Called when @c FastAutomataGenerate directive appears in configuration.
+ *
+ * @param[in] cp     Configuration parser; used for logging.
+ * @param[in] name   Name; ignored.
+ * @param[in] onoff  Enable generation?
+ * @param[in] cbdata Ignored.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL on use outside the main context, duplicate use, or
+ *   combination with @c FastAutomata; will emit log message.
+ * - IB_EOTHER on failures due to IronBee API failures; will emit log
+ *   message.
+ * - IB_EALLOC on failures due to memory allocation; no log message.
+ **/
+static
+ib_status_t fast_dir_fast_automata_generate(
+    ib_cfgparser_t *cp,
+    const char     *name,
+    int             onoff,
+    void           *cbdata
+)
+{
+    assert(cp     != NULL);
+    assert(cp->ib != NULL);
+    assert(name   != NULL);
 
-    /* Register context open hook to setup per-context data. */
-    rc = ib_hook_context_register(ib, context_open_state,
-                                  fast_ctx_open, NULL);
-    FAST_CHECK_RC("Error registering context close.");
-    /* Register context close hook to convert specs once all vars are
-     * registered. */
-    rc = ib_hook_context_register(ib, context_close_state,
-                                  fast_ctx_close, NULL);
-    FAST_CHECK_RC("Error registering context close.");
+    ib_engine_t     *ib = cp->ib;
+    ib_mm_t          mm;
+    fast_runtime_t  *runtime;
+    fast_generate_t *gen;
+    fast_config_t   *config;
+    ib_module_t     *module;
+    ib_status_t      rc;
+
+    if (! onoff) {
+        return IB_OK;
+    }
+
+    if (cp->cur_ctx != ib_context_main(ib)) {
+        ib_cfg_log_error(
+            cp,
+            "fast: FastAutomataGenerate directive must occur in "
+            "main context."
+        );
+        return IB_EINVAL;
+    }
+
+    mm     = ib_engine_mm_main_get(ib);
+    config = fast_get_config(ib, cp->cur_ctx);
+
+    assert(config != NULL);
+
+    if (config->runtime != NULL) {
+        ib_cfg_log_error(
+            cp,
+            "fast: FastAutomataGenerate directive must be unique and may "
+            "not be combined with FastAutomata."
+        );
+        return IB_EINVAL;
+    }
+
+    rc = ib_engine_module_get(ib, MODULE_NAME_STR, &module);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(
+            cp,
+            "fast: Unable to get my own module: %s",
+            ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    /* Create Runtime */
+    config->runtime = runtime =
+        ib_mm_calloc(mm, 1, sizeof(*config->runtime));
+    if (config->runtime == NULL) {
+        return IB_EALLOC;
+    }
+    runtime->gen = gen = ib_mm_calloc(mm, 1, sizeof(*runtime->gen));
+    if (gen == NULL) {
+        return IB_EALLOC;
+    }
+    rc = ib_list_create(&gen->patterns, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_list_create(&gen->rules, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_hash_create(&gen->index_by_id, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = fast_register_callbacks(ib, module, runtime, fast_generate_ownership);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(
+            cp,
+            "fast: Error registering callbacks: %s",
+            ib_status_to_string(rc)
+        );
+        return IB_EOTHER;
+    }
 
     return IB_OK;
-#undef FAST_METADATA_ERROR
-#undef FAST_IB_ERROR
 }
+#endif /* FAST_ENABLE_GENERATE */
 
 /**
  * Called when module unloads.
@@ -1817,6 +2609,13 @@ static IB_DIRMAP_INIT_STRUCTURE(fast_directive_map) = {
         fast_dir_fast_automata,
         NULL
     ),
+#ifdef FAST_ENABLE_GENERATE
+    IB_DIRMAP_INIT_ONOFF(
+        "FastAutomataGenerate",
+        fast_dir_fast_automata_generate,
+        NULL
+    ),
+#endif
 
     /* End */
     IB_DIRMAP_INIT_LAST
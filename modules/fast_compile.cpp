@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Fast Pattern Module --- In-process automata compiler.
+ *
+ * Builds a Eudoxus automata from patterns at configuration time, doing in
+ * process what fast/generate.cpp and fast/build.rb do offline.  The
+ * automata carries no Index/IndexSize metadata; the fast module builds its
+ * rule index directly when generating.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "fast_compile.h"
+
+#include <ironbee/log.h>
+
+#include <ironautomata/buffer.hpp>
+#include <ironautomata/deduplicate_outputs.hpp>
+#include <ironautomata/eudoxus_compiler.hpp>
+#include <ironautomata/generator/aho_corasick.hpp>
+#include <ironautomata/intermediate.hpp>
+#include <ironautomata/optimize_edges.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+extern "C" {
+
+ib_status_t fast_compile_automata(
+    ib_engine_t     *ib,
+    const ib_list_t *patterns,
+    ia_eudoxus_t   **out_eudoxus
+)
+{
+    assert(ib          != NULL);
+    assert(patterns    != NULL);
+    assert(out_eudoxus != NULL);
+
+    namespace ia = IronAutomata;
+
+    try {
+        ia::Intermediate::Automata a;
+
+        {
+            ia::buffer_t index_data;
+            ia::BufferAssembler index_assembler(index_data);
+            const ib_list_node_t *node;
+            uint32_t index = 0;
+
+            ia::Generator::aho_corasick_begin(a);
+            IB_LIST_LOOP_CONST(patterns, node) {
+                const char *pattern =
+                    (const char *)ib_list_node_data_const(node);
+                index_data.clear();
+                index_assembler.append_object(index);
+                ia::Generator::aho_corasick_add_pattern(
+                    a, pattern, index_data
+                );
+                ++index;
+            }
+            ia::Generator::aho_corasick_finish(a);
+        }
+
+        ia::Intermediate::breadth_first(a, ia::Intermediate::optimize_edges);
+        ia::Intermediate::deduplicate_outputs(a);
+
+        a.metadata()["Output-Type"] = "integer";
+
+        ia::EudoxusCompiler::result_t result =
+            ia::EudoxusCompiler::compile(a);
+        if (result.buffer.empty()) {
+            ib_log_error(ib, "fast: Generated automata is empty.");
+            return IB_EINVAL;
+        }
+
+        /* ia_eudoxus_create() takes ownership of a malloc()d buffer. */
+        char *buffer = (char *)malloc(result.buffer.size());
+        if (buffer == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(buffer, &result.buffer.front(), result.buffer.size());
+
+        ia_eudoxus_result_t irc = ia_eudoxus_create(out_eudoxus, buffer);
+        if (irc != IA_EUDOXUS_OK) {
+            free(buffer);
+            ib_log_error(
+                ib,
+                "fast: Error loading generated automata: %d",
+                irc
+            );
+            return IB_EINVAL;
+        }
+    }
+    catch (const std::bad_alloc&) {
+        return IB_EALLOC;
+    }
+    catch (const std::exception& e) {
+        ib_log_error(
+            ib,
+            "fast: Error generating automata: %s",
+            e.what()
+        );
+        return IB_EINVAL;
+    }
+
+    return IB_OK;
+}
+
+} /* extern "C" */
@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_MODULE_FAST_COMPILE_H_
+#define _IB_MODULE_FAST_COMPILE_H_
+
+/**
+ * @file
+ * @brief IronBee --- Fast Pattern Module --- In-process automata compiler.
+ *
+ * Declares the bridge between fast.c (C) and the IronAutomata generator
+ * and compiler (C++).  Only built when C++ support is enabled; fast.c
+ * guards all use with @c FAST_ENABLE_GENERATE.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include <ironautomata/eudoxus.h>
+
+#include <ironbee/engine.h>
+#include <ironbee/list.h>
+#include <ironbee/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compile an Aho-Corasick automata from a list of patterns.
+ *
+ * Each element of @a patterns is a <tt>const char *</tt> Aho-Corasick
+ * pattern in the syntax of IronAutomata's aho_corasick_add_pattern().
+ * The automata output for the Nth pattern is N as a @c uint32_t, i.e.,
+ * the index of the pattern in @a patterns, matching the output format
+ * the fast module expects from offline-built automata.
+ *
+ * The returned engine owns its buffer and should be destroyed with
+ * ia_eudoxus_destroy().
+ *
+ * @param[in]  ib          IronBee engine; used for logging.
+ * @param[in]  patterns    List of AC patterns to add, in index order.
+ * @param[out] out_eudoxus Compiled Eudoxus engine on IB_OK.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL on generation or compilation failure; will emit log message.
+ */
+ib_status_t fast_compile_automata(
+    ib_engine_t    *ib,
+    const ib_list_t *patterns,
+    ia_eudoxus_t   **out_eudoxus
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_MODULE_FAST_COMPILE_H_ */
@@ -21,12 +21,16 @@
  */
 
 #include <ironbee/cfgmap.h>
+#include <ironbee/clock.h>
 #include <ironbee/config.h>
 #include <ironbee/context.h>
 #include <ironbee/engine.h>
 #include <ironbee/engine_state.h>
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
+#include <ironbee/list.h>
+#include <ironbee/lock.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm.h>
 #include <ironbee/module.h>
 #include <ironbee/string.h>
@@ -48,11 +52,84 @@
 typedef struct {
     GeoIP           *geoip_db;   /**< The GeoIP database */
     ib_var_source_t *geoip_source; /**< Var source for GEO */
+    ib_lock_t       *db_lock;    /**< Guards lazy default database open */
+    bool             db_probed;  /**< Default database open attempted? */
+    ib_module_t     *module;     /**< This module; keys per-conn data */
 } module_data_t;
 
+/**
+ * Per-connection cache of a GeoIP lookup.
+ *
+ * The remote address cannot change mid-connection, so the database is
+ * consulted once per connection and later transactions reuse the
+ * connection-lifetime fields.
+ */
+typedef struct {
+    const char *ip;     /**< IP the fields describe */
+    ib_list_t  *fields; /**< List of ib_field_t, connection lifetime */
+} geoip_conn_cache_t;
+
 /* Declare the public module symbol. */
 IB_MODULE_DECLARE();
 
+/**
+ * Cache the fields of a completed lookup on the connection, best effort.
+ *
+ * The fields in @a geoip_lst must be allocated from connection-lifetime
+ * memory so that later transactions can share them.  Allocation failure
+ * just means the next transaction looks the address up again.
+ *
+ * @param[in] tx Transaction whose connection receives the cache.
+ * @param[in] mod_data Module data (keys the per-connection slot).
+ * @param[in] ip IP address the fields describe.
+ * @param[in] geoip_lst List field holding the lookup results.
+ */
+static void geoip_cache_store(
+    ib_tx_t       *tx,
+    module_data_t *mod_data,
+    const char    *ip,
+    ib_field_t    *geoip_lst
+)
+{
+    assert(tx != NULL);
+    assert(mod_data != NULL);
+    assert(ip != NULL);
+    assert(geoip_lst != NULL);
+
+    ib_mm_t               conn_mm = tx->conn->mm;
+    geoip_conn_cache_t   *cache;
+    ib_list_t            *src = NULL;
+    const ib_list_node_t *node;
+    ib_status_t           rc;
+
+    rc = ib_field_value(geoip_lst, ib_ftype_list_mutable_out(&src));
+    if (rc != IB_OK) {
+        return;
+    }
+
+    cache = ib_mm_alloc(conn_mm, sizeof(*cache));
+    if (cache == NULL) {
+        return;
+    }
+    cache->ip = ib_mm_strdup(conn_mm, ip);
+    if (cache->ip == NULL) {
+        return;
+    }
+    rc = ib_list_create(&(cache->fields), conn_mm);
+    if (rc != IB_OK) {
+        return;
+    }
+    IB_LIST_LOOP_CONST(src, node) {
+        rc = ib_list_push(cache->fields,
+                          (void *)ib_list_node_data_const(node));
+        if (rc != IB_OK) {
+            return;
+        }
+    }
+
+    ib_conn_set_module_data(tx->conn, mod_data->module, cache);
+}
+
 /**
  * Lookup the IP address in the GeoIP database
  *
@@ -74,8 +151,11 @@ static ib_status_t geoip_lookup(
     assert(data != NULL);
 
     const char          *ip = tx->remote_ipstr;
-    const module_data_t *mod_data = (const module_data_t *)data;
-    ib_mm_t              mm = tx->mm;
+    module_data_t       *mod_data = (module_data_t *)data;
+
+    /* Fields are built in connection memory so the per-connection cache
+     * below can hand them to later transactions on the same connection. */
+    ib_mm_t              mm = tx->conn->mm;
 
     if (ip == NULL) {
         ib_log_notice_tx(tx, "GeoIP: Trying to lookup NULL IP");
@@ -122,6 +202,45 @@ static ib_status_t geoip_lookup(
         return IB_EINVAL;
     }
 
+    /* The remote address cannot change mid-connection; reuse fields
+     * cached by an earlier transaction on this connection. */
+    {
+        geoip_conn_cache_t *cache = NULL;
+        rc = ib_conn_get_module_data(tx->conn, mod_data->module,
+                                     (void *)&cache);
+        if (rc == IB_OK && cache != NULL && strcmp(cache->ip, ip) == 0) {
+            const ib_list_node_t *node;
+            IB_LIST_LOOP_CONST(cache->fields, node) {
+                ib_field_list_add(
+                    geoip_lst,
+                    (ib_field_t *)ib_list_node_data_const(node));
+            }
+            {
+                static const ib_metric_t *metric = NULL;
+                if (metric == NULL) {
+                    metric = ib_metric_acquire(
+                        "geoip.cache.hit", IB_METRIC_COUNTER);
+                }
+                ib_metric_add(metric, 1);
+            }
+            return IB_OK;
+        }
+    }
+
+    /* Open the default database lazily, on the first lookup.  Probing
+     * the default system locations at module init is wasted startup
+     * work for engines that configure GeoIPDatabaseFile explicitly or
+     * never see a transaction. */
+    if (mod_data->geoip_db == NULL && ! mod_data->db_probed) {
+        ib_lock_lock(mod_data->db_lock);
+        if (mod_data->geoip_db == NULL && ! mod_data->db_probed) {
+            ib_log_debug_tx(tx, "GeoIP: Opening default database...");
+            mod_data->geoip_db = GeoIP_new(GEOIP_MMAP_CACHE);
+            mod_data->db_probed = true;
+        }
+        ib_lock_unlock(mod_data->db_lock);
+    }
+
     if (mod_data->geoip_db == NULL) {
         ib_log_error_tx(tx,
                         "GeoIP: Database was never opened. Perhaps the "
@@ -130,7 +249,18 @@ static ib_status_t geoip_lookup(
         return IB_EINVAL;
     }
 
-    geoip_id = GeoIP_id_by_addr(mod_data->geoip_db, ip);
+    {
+        ib_time_t start = ib_clock_get_time();
+        geoip_id = GeoIP_id_by_addr(mod_data->geoip_db, ip);
+        {
+            static const ib_metric_t *metric = NULL;
+            if (metric == NULL) {
+                metric = ib_metric_acquire(
+                    "geoip.lookup.us", IB_METRIC_HISTOGRAM);
+            }
+            ib_metric_record(metric, ib_clock_get_time() - start);
+        }
+    }
 
     if (geoip_id > 0) {
         const char *tmp_str;
@@ -259,6 +389,8 @@ static ib_status_t geoip_lookup(
         ib_field_list_add(geoip_lst, tmp_field);
     }
 
+    geoip_cache_store(tx, mod_data, ip, geoip_lst);
+
     return IB_OK;
 }
 
@@ -355,7 +487,6 @@ static ib_dirmap_init_t geoip_directive_map[] = {
 static ib_status_t geoip_init(ib_engine_t *ib, ib_module_t *m, void *cbdata)
 {
     ib_status_t    rc;
-    GeoIP         *geoip_db = NULL;
     module_data_t *mod_data;
 
     mod_data = ib_mm_calloc(ib_engine_mm_main_get(ib),
@@ -364,17 +495,17 @@ static ib_status_t geoip_init(ib_engine_t *ib, ib_module_t *m, void *cbdata)
         return IB_EALLOC;
     }
 
-    ib_log_debug(ib, "GeoIP: Initializing default database...");
-    geoip_db = GeoIP_new(GEOIP_MMAP_CACHE);
-    if (geoip_db == NULL) {
-        ib_log_error(ib, "GeoIP: Failed to initialize database.");
-        return IB_EUNKNOWN;
+    /* The default database is opened lazily by geoip_lookup(); here we
+     * only create the lock that guards the open. */
+    rc = ib_lock_create(&(mod_data->db_lock), ib_engine_mm_main_get(ib));
+    if (rc != IB_OK) {
+        ib_log_error(ib, "GeoIP: Failed to create database lock.");
+        return rc;
     }
 
-    /* Store off pointer to our module data structure */
-    mod_data->geoip_db = geoip_db;
+    mod_data->module = m;
 
-    /* And point the generic module data at it */
+    /* Point the generic module data at our module data structure */
     m->data = mod_data;
 
     rc = ib_hook_tx_register(ib,
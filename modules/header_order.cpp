@@ -50,6 +50,8 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <strings.h>
+
 using boost::bind;
 using namespace std;
 using namespace IronBee;
@@ -110,8 +112,24 @@ static const char* c_response_directive = "HeaderOrderResponse";
 
 // END CONFIGURATION
 
-//! Map of header key to abbreviation.  Keys must be lowercase.
-typedef map<string, string> header_map_t;
+//! One configured header: lowercased name and its abbreviation.
+struct header_entry_t
+{
+    //! Header name, lowercased.
+    string key;
+    //! Abbreviation emitted when the header is seen.
+    string abbrev;
+};
+
+/**
+ * Compiled header map: entries bucketed by name length.
+ *
+ * Compiled once at configuration time so that the per-transaction lookup
+ * is a bucket scan with case-insensitive compares against the raw header
+ * bytes -- no per-header string copy, lowercasing pass, or tree walk.
+ * Index is name length; most buckets hold zero or one entry.
+ **/
+typedef vector<vector<header_entry_t> > header_map_t;
 
 //! Per context data.
 struct PerContext
@@ -211,12 +229,19 @@ void configure_header_map(
             );
         }
 
-        string abbrev = part.substr(0, equal_pos);
-        string key = part.substr(equal_pos + 1);
+        header_entry_t entry;
+        entry.abbrev = part.substr(0, equal_pos);
+        entry.key = part.substr(equal_pos + 1);
 
-        transform(key.begin(), key.end(), key.begin(), ::tolower);
+        transform(
+            entry.key.begin(), entry.key.end(),
+            entry.key.begin(), ::tolower
+        );
 
-        header_map.insert(header_map_t::value_type(key, abbrev));
+        if (header_map.size() <= entry.key.length()) {
+            header_map.resize(entry.key.length() + 1);
+        }
+        header_map[entry.key.length()].push_back(entry);
     }
 }
 
@@ -311,15 +336,22 @@ void Delegate::handle_header_state(
     }
 
     string result;
-    string key;
-    header_map_t::const_iterator key_i;
     while (header) {
-        key = header.name().to_s();
-        transform(key.begin(), key.end(), key.begin(), ::tolower);
-
-        key_i = header_map->find(key);
-        if (key_i != header_map->end()) {
-            result += key_i->second;
+        ConstByteString name = header.name();
+        size_t length = name.length();
+
+        if (length < header_map->size()) {
+            const vector<header_entry_t>& bucket = (*header_map)[length];
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                if (
+                    strncasecmp(
+                        bucket[i].key.data(), name.const_data(), length
+                    ) == 0
+                ) {
+                    result += bucket[i].abbrev;
+                    break;
+                }
+            }
         }
 
         header = header.next();
@@ -31,7 +31,8 @@
 #include <ironbee/context.h>
 #include <ironbee/engine.h>
 #include <ironbee/engine_state.h>
-#include <ironbee/file.h>
+#include <ironbee/field_codec.h>
+#include <ironbee/hash.h>
 #include <ironbee/json.h>
 #include <ironbee/module.h>
 #include <ironbee/path.h>
@@ -45,6 +46,7 @@
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -68,6 +70,15 @@ IB_MODULE_DECLARE();
 struct init_collection_cfg_t {
     ib_persist_fw_t *persist_fw; /**< Handle to the persistence framework. */
 
+    /**
+     * Cache of @ref json_t keyed by resolved file path.
+     *
+     * Contexts that initialize collections from the same file (common
+     * with many tenant contexts sharing one reputation list) share a
+     * single parsed copy instead of each holding their own.
+     */
+    ib_hash_t *source_cache;
+
     /**
      * The current configuration value.
      *
@@ -85,12 +96,121 @@ typedef struct init_collection_cfg_t init_collection_cfg_t;
  */
 struct json_t {
     const char *file; /**< The file containing the JSON. */
+
+    /**
+     * Fields parsed from @c file at configuration time.
+     *
+     * Transactions reference these shared fields; the file is not
+     * re-read or re-parsed per transaction.
+     */
+    const ib_list_t *fields;
 };
 typedef struct json_t json_t;
 
+/**
+ * Parse @a file into @a fields, once, at configuration time.
+ *
+ * The file is memory mapped and examined. A file beginning with
+ * @ref IB_FIELD_CODEC_MARKER holds pre-parsed fields and is decoded
+ * with ib_field_codec_decode(), which is far cheaper than JSON parsing
+ * for large sources. Anything else is parsed as JSON.
+ *
+ * @param[in] ib IronBee engine. Used for logging.
+ * @param[in] mm Memory manager @a fields contents are allocated from.
+ * @param[in] file The file to parse.
+ * @param[in] fields Populated with the parsed fields.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If the file cannot be read or parsed.
+ * - IB_EALLOC On allocation errors.
+ */
+static ib_status_t json_parse_file(
+    ib_engine_t *ib,
+    ib_mm_t      mm,
+    const char  *file,
+    ib_list_t   *fields
+)
+{
+    assert(ib != NULL);
+    assert(file != NULL);
+    assert(fields != NULL);
+
+    ib_status_t  rc;
+    const char  *err_msg;
+    int          fd;
+    struct stat  sb;
+    void        *map;
+    size_t       sz;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        ib_log_error(
+            ib,
+            "Error opening file \"%s\": %s",
+            file,
+            strerror(errno));
+        return IB_EINVAL;
+    }
+
+    if (fstat(fd, &sb) != 0) {
+        ib_log_error(
+            ib,
+            "Error examining file \"%s\": %s",
+            file,
+            strerror(errno));
+        close(fd);
+        return IB_EINVAL;
+    }
+    sz = sb.st_size;
+
+    /* An empty file is an empty collection. */
+    if (sz == 0) {
+        close(fd);
+        return IB_OK;
+    }
+
+    map = mmap(NULL, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ib_log_error(
+            ib,
+            "Error mapping file \"%s\": %s",
+            file,
+            strerror(errno));
+        close(fd);
+        return IB_EINVAL;
+    }
+
+    if (*(const uint8_t *)map == IB_FIELD_CODEC_MARKER) {
+        rc = ib_field_codec_decode(mm, (const uint8_t *)map, sz, fields, &err_msg);
+    }
+    else {
+        rc = ib_json_decode_ex(mm, (const uint8_t *)map, sz, fields, &err_msg);
+    }
+
+    munmap(map, sz);
+    close(fd);
+
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "Error decoding file \"%s\": %s",
+            file,
+            (err_msg != NULL) ? err_msg : ib_status_to_string(rc));
+        return rc;
+    }
+
+    return IB_OK;
+}
+
 /**
  * JSON Load callback.
  *
+ * The fields were parsed when the store was created; this only
+ * references them into the transaction's list. Fields are shared
+ * read-only across contexts and transactions, exactly as var_load_fn()
+ * shares its fields.
+ *
  * @param[in] impl The implementation created by json_create_fn().
  * @param[in] tx The transaction.
  * @param[in] key Unused.
@@ -115,37 +235,21 @@ static ib_status_t json_load_fn(
     assert(tx != NULL);
     assert(fields != NULL);
 
-    json_t        *json_cfg = (json_t *)impl;
-    ib_status_t    rc;
-    const char    *err_msg;
-    const uint8_t *buf = NULL;
-    size_t         sz;
+    json_t               *json_cfg = (json_t *)impl;
+    const ib_list_node_t *node;
 
-    /* Load the file into a buffer. */
-    rc = ib_file_readall(tx->mm, json_cfg->file, &buf, &sz);
-    if (rc != IB_OK) {
-        if (rc == IB_EOTHER || rc == IB_EINVAL) {
-            ib_log_error_tx(
-                tx,
-                "Error reading file \"%s\": %s",
-                json_cfg->file,
-                strerror(errno));
-        }
-        else {
-            ib_log_error_tx(tx, "Failed to read JSON file \"%s\"", json_cfg->file);
-        }
-        return rc;
-    }
+    assert(json_cfg->fields != NULL);
 
-    /* Parse the buffer into the fields list. */
-    rc = ib_json_decode_ex(tx->mm, buf, sz, fields, &err_msg);
-    if (rc != IB_OK) {
-        ib_log_error_tx(
-            tx,
-            "Error decoding JSON file \"%s\": %s",
-            json_cfg->file,
-            err_msg);
-        return rc;
+    IB_LIST_LOOP_CONST(json_cfg->fields, node) {
+        ib_status_t rc;
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+        assert(field != NULL);
+        rc = ib_list_push(fields, (void *)field);
+        if (rc != IB_OK) {
+            ib_log_error_tx(tx, "Failed to populate fields.");
+            return rc;
+        }
     }
 
     return IB_OK;
@@ -177,7 +281,9 @@ static ib_status_t json_create_fn(
     assert(cbdata != NULL);
 
     ib_mm_t                mm = ib_engine_mm_main_get(ib);
+    ib_status_t            rc;
     json_t                *json_cfg;
+    ib_list_t             *fields;
     const ib_list_node_t  *node;
     const char            *json_file;
     init_collection_cfg_t *cfg = (init_collection_cfg_t *)cbdata;
@@ -216,6 +322,33 @@ static ib_status_t json_create_fn(
         return IB_EALLOC;
     }
 
+    /* If another context already loaded this file, share its copy. */
+    {
+        json_t *cached = NULL;
+        rc = ib_hash_get(cfg->source_cache, &cached, json_cfg->file);
+        if (rc == IB_OK) {
+            *(json_t **)impl = cached;
+            return IB_OK;
+        }
+    }
+
+    /* First sighting of this file; parse it once, now. */
+    rc = ib_list_create(&fields, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = json_parse_file(ib, mm, json_cfg->file, fields);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    json_cfg->fields = fields;
+
+    rc = ib_hash_set(cfg->source_cache, json_cfg->file, json_cfg);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     *(json_t **)impl = json_cfg;
     return IB_OK;
 }
@@ -782,6 +915,12 @@ static ib_status_t init_collection_init(
 
     cfg->persist_fw = NULL;
 
+    rc = ib_hash_create(&(cfg->source_cache), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to create source cache.");
+        return rc;
+    }
+
     rc = ib_persist_fw_create(ib, module, &(cfg->persist_fw));
     if (rc != IB_OK) {
         ib_log_error(
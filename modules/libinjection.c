@@ -38,6 +38,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <ironbee/context.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/module.h>
 #include <ironbee/path.h>
@@ -56,6 +57,8 @@
 #endif
 
 #include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -378,6 +381,34 @@ ib_status_t sqli_op_create(
     return IB_OK;
 }
 
+/**
+ * True if @a data could produce a multi-token SQLi fingerprint.
+ *
+ * A value consisting solely of alphanumerics and underscores tokenizes
+ * to a single bareword, and every fingerprint in the built-in set spans
+ * multiple tokens, so such values cannot be flagged and the tokenizer
+ * need not run.  Policies that apply the sqli operator to every ARGS
+ * member see mostly such values on clean traffic.
+ *
+ * @param[in] data Value bytes.
+ * @param[in] len Length of @a data.
+ *
+ * @returns True if the tokenizer must be consulted.
+ */
+static bool sqli_value_needs_scan(const uint8_t *data, size_t len)
+{
+    assert(data != NULL || len == 0);
+
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t b = data[i];
+        if (! isalnum(b) && b != '_') {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static
 ib_status_t sqli_op_execute(
     ib_tx_t *tx,
@@ -411,6 +442,32 @@ ib_status_t sqli_op_execute(
         return rc;
     }
 
+    /* Screen out values that cannot match before running the tokenizer.
+     * Custom fingerprint sets may hold unusual fingerprints, so the
+     * screen applies only to the built-in set. */
+    if (ps == NULL
+        && ! sqli_value_needs_scan(
+                 ib_bytestr_const_ptr(bs), ib_bytestr_length(bs)))
+    {
+        {
+            static const ib_metric_t *metric = NULL;
+            if (metric == NULL) {
+                metric = ib_metric_acquire(
+                    "sqli.prefilter.skip", IB_METRIC_COUNTER);
+            }
+            ib_metric_add(metric, 1);
+        }
+        return IB_OK;
+    }
+
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire("sqli.scans", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+
     /* Run through libinjection. */
     libinjection_sqli_init(
         &sf,
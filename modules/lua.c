@@ -535,6 +535,64 @@ static ib_status_t modlua_injection_fn(
     return IB_OK;
 }
 
+/**
+ * Pre-create Lua stacks for the expected worker concurrency.
+ *
+ * Lua stacks are expensive to build and are otherwise created on
+ * first demand, so a freshly configured engine pays their cost on the
+ * first requests. This raises the stack pool's pre-create watermark
+ * to the worker concurrency; the pool's replenisher thread then fills
+ * it in the background before traffic arrives.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] concurrency Expected worker concurrency.
+ * @param[in] cbdata The lua module.
+ *
+ * @returns
+ * - IB_OK On success, including when the pool already pre-creates
+ *   enough stacks.
+ * - Other on failure to fetch the module configuration.
+ */
+static ib_status_t modlua_prewarm(
+    ib_engine_t *ib,
+    size_t       concurrency,
+    void        *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(cbdata != NULL);
+
+    ib_module_t  *module = (ib_module_t *)cbdata;
+    modlua_cfg_t *cfg = NULL;
+    ib_status_t   rc;
+
+    rc = ib_context_module_config(ib_context_main(ib), module, &cfg);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Cannot retrieve module configuration.");
+        return rc;
+    }
+
+    assert(cfg->lua_pool != NULL);
+
+    /* Only raise the watermark; LuaStackMin may already ask for more. */
+    if (concurrency <= ib_resource_pool_min_get(cfg->lua_pool)) {
+        return IB_OK;
+    }
+
+    rc = ib_resource_pool_set_min(cfg->lua_pool, concurrency);
+    if (rc == IB_EINVAL) {
+        /* The concurrency is above LuaStackMax. The cap is the user's
+         * explicit choice, so warm nothing extra rather than fight it. */
+        ib_log_debug(
+            ib,
+            "Not prewarming %zd Lua stacks: above LuaStackMax.",
+            concurrency);
+        return IB_OK;
+    }
+
+    return rc;
+}
+
 /**
  * Initialize the ModLua Module.
  *
@@ -596,6 +654,21 @@ static ib_status_t modlua_init(
         return rc;
     }
 
+    /* Record runtimes pinned by worker threads so they can be returned
+     * to the pool at engine destruction. The cleanup must be registered
+     * before the pool is created so it runs before the pool's cleanup. */
+    rc = ib_list_create(&(cfg->lua_pinned), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to create pinned Lua runtime list.");
+        return rc;
+    }
+    cfg->lua_pool_generation = modlua_runtime_generation_next();
+    rc = ib_mm_register_cleanup(mm, modlua_runtime_pinned_cleanup, cfg);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to register pinned Lua runtime cleanup.");
+        return rc;
+    }
+
     rc = modlua_runtime_resource_pool_create(
         &(cfg->lua_pool),
         ib,
@@ -652,6 +725,15 @@ static ib_status_t modlua_init(
         return rc;
     }
 
+    /* Prewarm the Lua stack pool when the server announces its
+     * worker concurrency. */
+    rc = ib_engine_prewarm_register(ib, modlua_prewarm, module);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to register prewarm function: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     /* Register an ownership function to take ownership of all waggle rules. */
     rc = ib_rule_register_ownership_fn(
         ib,
@@ -26,8 +26,168 @@
 
 #include <ironbee/types.h>
 
+#include <lauxlib.h>
 #include <lua.h>
+
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * An entry in the process-wide Lua bytecode cache.
+ *
+ * Lua sources are loaded into every pooled stack, and again into every
+ * stack of every engine an engine manager builds. Compiling each source
+ * once and replaying the dumped bytecode makes those loads cheap, and
+ * because the cache is process-global it survives engine reloads.
+ *
+ * Entries are malloc()ed and live for the process; the set of Lua
+ * sources is small and bounded by the configuration.
+ */
+typedef struct modlua_bc_entry_t modlua_bc_entry_t;
+struct modlua_bc_entry_t {
+    char              *file;         /**< Source path. */
+    char              *chunkname;    /**< "@" + file, for error messages. */
+    time_t             mtime;        /**< Source mtime at compile time. */
+    off_t              size;         /**< Source size at compile time. */
+    char              *bytecode;     /**< Dumped chunk. */
+    size_t             bytecode_len; /**< Length of bytecode. */
+    modlua_bc_entry_t *next;         /**< Next cache entry. */
+};
+
+//! Head of the bytecode cache list.
+static modlua_bc_entry_t *g_bc_cache = NULL;
+
+//! Serializes all access to @ref g_bc_cache.
+static pthread_mutex_t g_bc_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//! Growing buffer that bc_writer() accumulates dumped bytecode into.
+typedef struct bc_buffer_t {
+    char   *data;
+    size_t  len;
+} bc_buffer_t;
+
+/**
+ * lua_dump() writer that appends to a @ref bc_buffer_t.
+ *
+ * @returns 0 on success, non-zero on allocation failure.
+ */
+static int bc_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    bc_buffer_t *buf = (bc_buffer_t *)ud;
+
+    char *tmp = realloc(buf->data, buf->len + sz);
+    if (tmp == NULL) {
+        return 1;
+    }
+
+    memcpy(tmp + buf->len, p, sz);
+    buf->data = tmp;
+    buf->len += sz;
+
+    return 0;
+}
+
+int ib_lua_loadfile_cached(ib_engine_t *ib, lua_State *L, const char *file)
+{
+    assert(ib   != NULL);
+    assert(L    != NULL);
+    assert(file != NULL);
+
+    int                lua_rc;
+    struct stat        st;
+    modlua_bc_entry_t *entry;
+
+    /* If the file cannot be examined, let luaL_loadfile() report it. */
+    if (stat(file, &st) != 0) {
+        return luaL_loadfile(L, file);
+    }
+
+    pthread_mutex_lock(&g_bc_cache_lock);
+
+    for (entry = g_bc_cache; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->file, file) == 0) {
+            break;
+        }
+    }
+
+    /* Cache hit: replay the bytecode into this state. */
+    if (
+        entry != NULL &&
+        entry->mtime == st.st_mtime &&
+        entry->size == st.st_size
+    )
+    {
+        lua_rc = luaL_loadbuffer(
+            L,
+            entry->bytecode,
+            entry->bytecode_len,
+            entry->chunkname);
+        pthread_mutex_unlock(&g_bc_cache_lock);
+        return lua_rc;
+    }
+
+    /* Miss or stale entry: compile from source. */
+    lua_rc = luaL_loadfile(L, file);
+    if (lua_rc != 0) {
+        pthread_mutex_unlock(&g_bc_cache_lock);
+        return lua_rc;
+    }
+
+    /* Cache the compiled chunk. Failures here only lose the caching. */
+    {
+        bc_buffer_t buf = { NULL, 0 };
+
+        if (lua_dump(L, bc_writer, &buf) != 0) {
+            free(buf.data);
+            goto finish;
+        }
+
+        if (entry == NULL) {
+            entry = calloc(1, sizeof(*entry));
+            if (entry == NULL) {
+                free(buf.data);
+                goto finish;
+            }
+
+            entry->file = strdup(file);
+            entry->chunkname = malloc(strlen(file) + 2);
+            if (entry->file == NULL || entry->chunkname == NULL) {
+                free(entry->file);
+                free(entry->chunkname);
+                free(entry);
+                free(buf.data);
+                goto finish;
+            }
+            entry->chunkname[0] = '@';
+            strcpy(entry->chunkname + 1, file);
+
+            entry->next = g_bc_cache;
+            g_bc_cache = entry;
+        }
+        else {
+            /* Stale entry: replace the bytecode in place. */
+            free(entry->bytecode);
+        }
+
+        entry->bytecode     = buf.data;
+        entry->bytecode_len = buf.len;
+        entry->mtime        = st.st_mtime;
+        entry->size         = st.st_size;
+
+        ib_log_debug(
+            ib,
+            "Cached %zd bytes of Lua bytecode for \"%s\".",
+            entry->bytecode_len,
+            file);
+    }
+
+finish:
+    pthread_mutex_unlock(&g_bc_cache_lock);
+    return 0;
+}
 
 ib_status_t ib_lua_load_eval(ib_engine_t *ib, lua_State *L, const char *file)
 {
@@ -35,7 +195,7 @@ ib_status_t ib_lua_load_eval(ib_engine_t *ib, lua_State *L, const char *file)
     assert(L    != NULL);
     assert(file != NULL);
 
-    int lua_rc = luaL_loadfile(L, file);
+    int lua_rc = ib_lua_loadfile_cached(ib, L, file);
 
     if (lua_rc != 0) {
         ib_log_error(ib, "Error loading \"%s\": %s (%d)",
@@ -96,7 +256,7 @@ ib_status_t ib_lua_load_func(
     assert(func_name != NULL);
 
     /* Load (compile) the lua module. */
-    ib_status_t ib_rc = luaL_loadfile(L, file);
+    ib_status_t ib_rc = ib_lua_loadfile_cached(ib, L, file);
 
     if (ib_rc != 0) {
         ib_log_error(
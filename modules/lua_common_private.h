@@ -36,6 +36,27 @@
 
 #include <lua.h>
 
+/**
+ * Load a Lua file as a chunk on @a L, through a bytecode cache.
+ *
+ * A drop-in replacement for luaL_loadfile(). The first load of a file
+ * compiles it and stores the dumped bytecode in a process-wide cache;
+ * later loads into any state (pooled stacks, rebuilt engines) reuse the
+ * bytecode instead of re-reading and re-compiling the source. Entries
+ * are validated against the file's size and modification time, so an
+ * edited source recompiles on the next engine reload.
+ *
+ * On any cache failure this silently falls back to luaL_loadfile().
+ *
+ * @param[in] ib IronBee engine used to log.
+ * @param[in,out] L The Lua state to load the chunk into.
+ * @param[in] file File to load.
+ *
+ * @returns As luaL_loadfile(): 0 on success with the chunk pushed onto
+ *          the stack, or a Lua error code with the error message pushed.
+ */
+int ib_lua_loadfile_cached(ib_engine_t *ib, lua_State *L, const char *file);
+
 /**
  * Load the lua file into the given Lua state and execute it with no args.
  *
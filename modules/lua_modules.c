@@ -618,7 +618,8 @@ static ib_status_t modlua_logevent(
         }
     }
 
-    rc = modlua_reload_ctx_except_main(ib, modlua_modules->modlua, tx->ctx, L);
+    rc = modlua_reload_ctx_except_main(
+        ib, modlua_modules->modlua, tx->ctx, runtime);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to configure Lua stack.");
         goto exit;
@@ -740,7 +741,8 @@ ib_status_t modlua_null(
         }
     }
 
-    rc = modlua_reload_ctx_except_main(ib, modlua_modules->modlua, ctx, L);
+    rc = modlua_reload_ctx_except_main(
+        ib, modlua_modules->modlua, ctx, runtime);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to configure Lua stack.");
         goto exit;
@@ -1274,7 +1276,8 @@ static ib_status_t modlua_ctx(
         }
     }
 
-    rc = modlua_reload_ctx_except_main(ib, modlua_modules->modlua, ctx, L);
+    rc = modlua_reload_ctx_except_main(
+        ib, modlua_modules->modlua, ctx, runtime);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to configure Lua stack.");
         goto exit;
@@ -2243,7 +2246,7 @@ static ib_status_t modlua_load_module_push_stack(
         lua_pushnil(L);
     }
 
-    lua_rc = luaL_loadfile(L, file);
+    lua_rc = ib_lua_loadfile_cached(ib, L, file);
     switch(lua_rc) {
         case 0:
             /* NOP */
@@ -58,6 +58,8 @@ struct modlua_cfg_t {
     ib_resource_pool_t   *lua_pool;      /**< Pool of Lua stacks. */
     ib_lock_t            *lua_pool_lock; /**< Pool lock. */
     modlua_runtime_cfg_t *lua_pool_cfg;  /**< Pool configuration. */
+    ib_list_t            *lua_pinned;    /**< Pool resources pinned by threads. */
+    uint64_t              lua_pool_generation; /**< Distinguishes pool rebuilds. */
     ib_resource_t        *lua_resource;  /**< Resource modlua_cfg_t::L. */
     lua_State            *L;             /**< Lua stack used for config. */
 };
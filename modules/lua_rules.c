@@ -84,7 +84,7 @@ static ib_status_t lua_operator_execute(
 
     module = modlua_rules_cbdata->module;
 
-    rc = modlua_reload_ctx_except_main(ib, module, ctx, luart->L);
+    rc = modlua_reload_ctx_except_main(ib, module, ctx, luart);
     if (rc != IB_OK) {
         ib_log_error_tx(tx, "Failed to reload Lua stack.");
         goto exit;
@@ -32,6 +32,7 @@
 #include "lua_private.h"
 
 #include <ironbee/context.h>
+#include <ironbee/list.h>
 #include <ironbee/mm_mpool_lite.h>
 
 #include <lauxlib.h>
@@ -52,6 +53,72 @@
 //! Maximum number of times a resource pool Lua stack should be used.
 static size_t MAX_LUA_STACK_USES = 1000;
 
+/**
+ * A per-thread pin of a Lua runtime to keep LuaJIT traces warm.
+ *
+ * Rotating every acquisition through the resource pool spreads work over
+ * every pooled stack, so each stack JIT-compiles the hot rule paths
+ * independently and most requests run cold, interpreted code.  Instead,
+ * each thread keeps one runtime checked out of the pool for the life of
+ * the engine and reuses it without touching the pool or its lock.
+ *
+ * Pinned resources are recorded in modlua_cfg_t::lua_pinned and returned
+ * to the pool by modlua_runtime_pinned_cleanup() at engine destruction.
+ * The generation number distinguishes a pool created after an engine
+ * reload from the pool a stale pin belongs to.
+ */
+struct modlua_pin_t {
+    const ib_resource_pool_t *owner;      /**< Pool the runtime belongs to. */
+    uint64_t                  generation; /**< Pool generation at pin time. */
+    modlua_runtime_t         *runtime;    /**< The pinned runtime. */
+};
+static __thread struct modlua_pin_t g_pinned_runtime = { NULL, 0, NULL };
+
+//! Source of modlua_cfg_t::lua_pool_generation values.
+static uint64_t g_lua_pool_generation = 0;
+
+/**
+ * Lua chunk run in each new state to count JIT trace compiles and aborts.
+ *
+ * The counters are published in the global table `__modlua_jit_counters`
+ * and read back by lua_pool_destroy_fn() when the state is destroyed.
+ */
+static const char *c_jit_counter_lua =
+    "local counters = { traces = 0, aborts = 0 }\n"
+    "local jit = require('jit')\n"
+    "jit.attach(\n"
+    "    function(what)\n"
+    "        if what == 'stop' then\n"
+    "            counters.traces = counters.traces + 1\n"
+    "        elseif what == 'abort' then\n"
+    "            counters.aborts = counters.aborts + 1\n"
+    "        end\n"
+    "    end,\n"
+    "    'trace')\n"
+    "rawset(_G, '__modlua_jit_counters', counters)\n";
+
+uint64_t modlua_runtime_generation_next(void)
+{
+    /* Engines may be configured concurrently under an engine manager. */
+    return __sync_add_and_fetch(&g_lua_pool_generation, 1);
+}
+
+void modlua_runtime_pinned_cleanup(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    modlua_cfg_t   *cfg = (modlua_cfg_t *)cbdata;
+    ib_list_node_t *node;
+
+    assert(cfg->lua_pinned != NULL);
+
+    /* Engine destruction is quiesced and the pool lock has already been
+     * destroyed by an earlier memory cleanup; no locking here. */
+    IB_LIST_LOOP(cfg->lua_pinned, node) {
+        ib_resource_release((ib_resource_t *)ib_list_node_data(node));
+    }
+}
+
 /**
  * Opaque runtime structure passed back to the user.
  *
@@ -299,9 +366,20 @@ static ib_status_t modlua_newstate(
         lua_setglobal(L, "cpath");
     }
 
-    lua_rc = luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE|LUAJIT_MODE_OFF);
+    lua_rc = luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE|LUAJIT_MODE_ON);
     if (lua_rc == 0) {
-        ib_log_error(ib, "Failed to disable Lua JIT");
+        ib_log_error(ib, "Failed to enable Lua JIT.");
+    }
+
+    /* Count compiled and aborted traces so JIT health is observable when
+     * this stack is eventually destroyed. */
+    lua_rc = luaL_dostring(L, c_jit_counter_lua);
+    if (lua_rc != 0) {
+        ib_log_error(
+            ib,
+            "Failed to install JIT trace counters: %s",
+            lua_tostring(L, -1));
+        lua_pop(L, 1);
     }
 
     *Lout = L;
@@ -456,10 +534,10 @@ ib_status_t modlua_reload_ctx_main(
 }
 
 /**
- * Reload all the contexts except the main context.
+ * Recursively reload @a ctx and its parents, excepting the main context.
  */
-ib_status_t modlua_reload_ctx_except_main(
-    ib_engine_t *ib,
+static ib_status_t modlua_reload_ctx_recurse(
+    ib_engine_t  *ib,
     ib_module_t  *module,
     ib_context_t *ctx,
     lua_State    *L
@@ -478,7 +556,7 @@ ib_status_t modlua_reload_ctx_except_main(
     }
 
     /* Reload the parent context first. */
-    rc = modlua_reload_ctx_except_main(
+    rc = modlua_reload_ctx_recurse(
         ib,
         module,
         ib_context_parent_get(ctx),
@@ -500,6 +578,40 @@ ib_status_t modlua_reload_ctx_except_main(
     return IB_OK;
 }
 
+/**
+ * Reload all the contexts except the main context.
+ */
+ib_status_t modlua_reload_ctx_except_main(
+    ib_engine_t      *ib,
+    ib_module_t      *module,
+    ib_context_t     *ctx,
+    modlua_runtime_t *runtime
+)
+{
+    assert(ib      != NULL);
+    assert(module  != NULL);
+    assert(ctx     != NULL);
+    assert(runtime != NULL);
+
+    ib_status_t rc;
+
+    /* The stack already has this context's environment loaded; with each
+     * thread pinning a runtime this amortizes environment setup over all
+     * the rules and events a context dispatches, not one Lua call. */
+    if (runtime->cfg_ctx == ctx) {
+        return IB_OK;
+    }
+
+    rc = modlua_reload_ctx_recurse(ib, module, ctx, runtime->L);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    runtime->cfg_ctx = ctx;
+
+    return IB_OK;
+}
+
 /**
  * Resource pool callback to create a new Lua runtime.
  *
@@ -568,6 +680,7 @@ static ib_status_t lua_pool_create_fn(void *resource, void *cbdata)
         ib_log_error(ib, "Failed to configure Lua stack.");
         goto exit_failure;
     }
+    modlua_runtime->cfg_ctx = ctx;
 
     *(void **)resource = modlua_runtime;
 
@@ -587,8 +700,11 @@ exit_failure:
 static void lua_pool_destroy_fn(void *resource, void *cbdata)
 {
     assert(resource != NULL);
+    assert(cbdata != NULL);
 
     modlua_runtime_t *modlua_runtime = (modlua_runtime_t *)resource;
+    modlua_runtime_cbdata_t *modlua_runtime_cbdata =
+        (modlua_runtime_cbdata_t *)cbdata;
 
     ib_mpool_lite_t *mp = modlua_runtime->mp;
     lua_State       *L  = modlua_runtime->L;
@@ -596,6 +712,22 @@ static void lua_pool_destroy_fn(void *resource, void *cbdata)
     assert(mp != NULL);
     assert(L != NULL);
 
+    /* Report JIT health for this stack before it is lost. */
+    lua_getglobal(L, "__modlua_jit_counters");
+    if (lua_istable(L, -1)) {
+        lua_getfield(L, -1, "traces");
+        lua_getfield(L, -2, "aborts");
+        ib_log_debug(
+            modlua_runtime_cbdata->ib,
+            "Destroying Lua stack after %zd uses: "
+            "%d JIT traces compiled, %d trace aborts.",
+            modlua_runtime->use_count,
+            (int)lua_tointeger(L, -2),
+            (int)lua_tointeger(L, -1));
+        lua_pop(L, 2);
+    }
+    lua_pop(L, 1);
+
     /* Clear the struct to provoke faster crashes. */
     memset(modlua_runtime, 0, sizeof(*modlua_runtime));
 
@@ -716,6 +848,15 @@ ib_status_t modlua_runtime_resource_pool_create(
         return rc;
     }
 
+    /* Lua stack creation is milliseconds of work; replenish the
+     * reserve in the background so requests that drain the pool do
+     * not pay it. Failure to start the thread is not fatal: stacks
+     * are then created on demand, as before. */
+    rc = ib_resource_pool_replenisher_start(*resource_pool);
+    if (rc != IB_OK) {
+        ib_log_warning(ib, "Failed to start Lua stack replenisher.");
+    }
+
     *cfg = &(modlua_runtime_cbdata->cfg);
 
     return IB_OK;
@@ -732,6 +873,17 @@ ib_status_t modlua_releasestate(
 
     ib_status_t rc;
 
+    /* Keep the pinned runtime checked out so its JIT traces stay warm.
+     * It is returned to the pool by modlua_runtime_pinned_cleanup(). */
+    if (
+        modlua_runtime == g_pinned_runtime.runtime &&
+        g_pinned_runtime.owner == cfg->lua_pool &&
+        g_pinned_runtime.generation == cfg->lua_pool_generation
+    )
+    {
+        return IB_OK;
+    }
+
     rc = ib_lock_lock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
@@ -763,6 +915,18 @@ ib_status_t modlua_acquirestate(
     ib_status_t    rc;
     ib_resource_t *resource;
 
+    /* Fast path: reuse this thread's pinned runtime with no pool traffic. */
+    if (
+        g_pinned_runtime.runtime != NULL &&
+        g_pinned_runtime.owner == cfg->lua_pool &&
+        g_pinned_runtime.generation == cfg->lua_pool_generation
+    )
+    {
+        ++(g_pinned_runtime.runtime->use_count);
+        *modlua_runtime = g_pinned_runtime.runtime;
+        return IB_OK;
+    }
+
     rc = ib_lock_lock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
@@ -774,6 +938,23 @@ ib_status_t modlua_acquirestate(
         return rc;
     }
 
+    /* Pin this runtime to the thread if the pin slot is free or stale
+     * (left over from a pool that has since been rebuilt).  A slot
+     * holding a runtime from a newer pool is left alone; that resource
+     * stays recorded in its own pool's pinned list. */
+    if (
+        g_pinned_runtime.runtime == NULL ||
+        g_pinned_runtime.generation < cfg->lua_pool_generation
+    )
+    {
+        if (ib_list_push(cfg->lua_pinned, resource) == IB_OK) {
+            g_pinned_runtime.owner      = cfg->lua_pool;
+            g_pinned_runtime.generation = cfg->lua_pool_generation;
+            g_pinned_runtime.runtime    =
+                (modlua_runtime_t *)ib_resource_get(resource);
+        }
+    }
+
     rc = ib_lock_unlock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
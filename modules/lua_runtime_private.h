@@ -45,6 +45,7 @@ struct modlua_runtime_t {
     ssize_t          use_count; /**< Number of times this stack is used. */
     ib_mpool_lite_t *mp;        /**< Memory pool for this runtime. */
     ib_resource_t   *resource;  /**< Bookkeeping for modlua_releasestate(). */
+    ib_context_t    *cfg_ctx;   /**< Context the stack last loaded. */
 };
 typedef struct modlua_runtime_t modlua_runtime_t;
 
@@ -130,13 +131,18 @@ ib_status_t modlua_runtime_resource_pool_create(
  * it is assumed that the stack has all the files referenced in the main
  * context already loaded. All site-specific scripts must be reloaded.
  *
+ * The reload is recorded in modlua_runtime_t::cfg_ctx and skipped while
+ * the runtime keeps servicing the same context, so the cost of setting
+ * up the environment is paid once per context change rather than once
+ * per rule or event dispatch.
+ *
  * @param[in] ib The IronBee engine.
  * @param[in] module The module object for the Lua module.
  * @param[in] ctx The configuration context. If this is the main context,
  *            this function does nothing. If this is a context other than
  *            the main context it's parent is recursively passed
  *            to this function until @a ctx is the main context.
- * @param[in] L The Lua State to reload Lua scripts into.
+ * @param[in] runtime The runtime whose Lua state is reloaded into.
  *
  * @returns
  * - IB_OK On success or if @a ctx is the main context.
@@ -144,10 +150,10 @@ ib_status_t modlua_runtime_resource_pool_create(
  * - IB_EINVAL If the Lua script fails to load.
  */
 ib_status_t modlua_reload_ctx_except_main(
-    ib_engine_t  *ib,
-    ib_module_t  *module,
-    ib_context_t *ctx,
-    lua_State    *L
+    ib_engine_t      *ib,
+    ib_module_t      *module,
+    ib_context_t     *ctx,
+    modlua_runtime_t *runtime
 );
 
 /**
@@ -226,4 +232,28 @@ ib_status_t modlua_acquirestate(
     modlua_runtime_t **modlua_runtime
 );
 
+/**
+ * Return the next value for modlua_cfg_t::lua_pool_generation.
+ *
+ * Each resource pool of Lua runtimes is assigned a unique generation so
+ * that per-thread runtime pins can tell a rebuilt pool from the pool they
+ * were taken out of.
+ *
+ * @returns The next generation number.
+ */
+uint64_t modlua_runtime_generation_next(void);
+
+/**
+ * Memory cleanup function that releases thread-pinned Lua runtimes.
+ *
+ * Runtimes pinned by worker threads stay checked out of the resource pool
+ * between uses. This returns them to the pool so it can destroy them.
+ * Register this before creating the pool: memory cleanup functions run in
+ * registration order and the pinned resources must be released before the
+ * pool destroys its stacks.
+ *
+ * @param[in] cbdata A @ref modlua_cfg_t pointer.
+ */
+void modlua_runtime_pinned_cleanup(void *cbdata);
+
 #endif /* __MODULES__LUA_RUNTIME_H */
@@ -536,11 +536,14 @@ static ib_status_t modhtp_set_header(
             value = "";
             vlen = 0;
         }
+        /* Reuse the IronBee buffers rather than copying them: header
+         * names and values live in the transaction memory manager,
+         * which outlives the htp_tx_t (destroyed at tx_finished). */
         hrc = fn(txdata->htx,
                  (const char *)ib_bytestr_const_ptr(node->name),
                  ib_bytestr_length(node->name),
                  value, vlen,
-                 HTP_ALLOC_COPY);
+                 HTP_ALLOC_REUSE);
         irc = modhtp_check_htprc(hrc, txdata, fname);
         if (irc != IB_OK) {
             return irc;
@@ -606,25 +609,22 @@ static inline ib_status_t modhtp_set_bytestr(
     }
 
     /*
-     * If the target bytestring is NULL, create it, otherwise
-     * append to the zero-length bytestring.
+     * If the target bytestring is NULL, create it, otherwise point the
+     * zero-length bytestring at the source buffer.
+     *
+     * Both paths alias the libhtp buffer rather than copying it: the
+     * htp_tx_t is not destroyed until the tx_finished state, after the
+     * phase rules and audit logging that read these bytestrings. The
+     * alias is read-only, so anything wanting to mutate one must take
+     * its own copy.
      */
     if (*ib_bstr == NULL) {
-        rc = ib_bytestr_dup_mem(ib_bstr, itx->mm, ptr, len);
-    }
-    else if (force) {
-        void *new = ib_mm_memdup(itx->mm, ptr, len);
-        if (new == NULL) {
-            rc = IB_EALLOC;
-            goto done;
-        }
-        rc = ib_bytestr_setv(*ib_bstr, new, len);
+        rc = ib_bytestr_alias_mem(ib_bstr, itx->mm, ptr, len);
     }
     else {
-        rc = ib_bytestr_append_mem(*ib_bstr, ptr, len);
+        rc = ib_bytestr_setv_const(*ib_bstr, ptr, len);
     }
 
-done:
     if (rc != IB_OK) {
         ib_log_error_tx(itx, "Error setting %s: %s",
                         label, ib_status_to_string(rc));
@@ -2540,11 +2540,13 @@ ib_status_t modhtp_request_started(
                     (int)ib_bytestr_length(line->raw),
                     (const char *)ib_bytestr_const_ptr(line->raw));
 
-    /* Hand the whole request line to libhtp */
+    /* Hand the whole request line to libhtp. The raw line lives in the
+     * transaction memory manager, which outlives the htp_tx_t
+     * (destroyed at tx_finished), so libhtp can reuse the buffer. */
     hrc = htp_tx_req_set_line(txdata->htx,
                               (const char *)ib_bytestr_const_ptr(line->raw),
                               ib_bytestr_length(line->raw),
-                              HTP_ALLOC_COPY);
+                              HTP_ALLOC_REUSE);
     irc = modhtp_check_htprc(hrc, txdata, "htp_tx_req_set_line");
     if (irc != IB_OK) {
         return irc;
@@ -2852,12 +2854,13 @@ ib_status_t modhtp_response_started(
 
     htx = txdata->htx;
 
-    /* Hand off the status line */
+    /* Hand off the status line. As with the request line, the raw line
+     * outlives the htp_tx_t, so libhtp can reuse the buffer. */
     hrc = htp_tx_res_set_status_line(
         htx,
         (const char *)ib_bytestr_const_ptr(line->raw),
         ib_bytestr_length(line->raw),
-        HTP_ALLOC_COPY);
+        HTP_ALLOC_REUSE);
     irc = modhtp_check_htprc(hrc, txdata, "htp_tx_res_set_status_line");
     if (irc != IB_OK) {
         return irc;
@@ -0,0 +1,853 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Streaming multipart body processor.
+ *
+ * Parses multipart/form-data request bodies incrementally as a stream
+ * pump processor.  Part boundaries and headers are recognized as chunks
+ * arrive; per-part headers are published to the `MULTIPART` var as each
+ * part's header block completes and part body bytes are streamed onward
+ * for inspection.  Unlike the buffering parser in libhtp, no part and no
+ * message is ever materialized in full.
+ *
+ * Vars published (all appended to the `MULTIPART` list var):
+ *  - `part_name`: value of the Content-Disposition `name` parameter.
+ *  - `part_filename`: value of the `filename` parameter, when present.
+ *  - One field per part header, named after the header.
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include <ironbee/bytestr.h>
+#include <ironbee/engine.h>
+#include <ironbee/engine_state.h>
+#include <ironbee/field.h>
+#include <ironbee/list.h>
+#include <ironbee/log.h>
+#include <ironbee/mm.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/module.h>
+#include <ironbee/parsed_content.h>
+#include <ironbee/stream_io.h>
+#include <ironbee/stream_processor.h>
+#include <ironbee/stream_pump.h>
+#include <ironbee/string.h>
+#include <ironbee/var.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Define the module name as well as a string version of it. */
+#define MODULE_NAME        multipart
+#define MODULE_NAME_STR    IB_XSTRINGIFY(MODULE_NAME)
+
+/** Name the processor is registered under. */
+static const char *c_processor_name = "multipart";
+
+/** Stream data type the processor handles. */
+static const char *c_processor_type = "multipart/form-data";
+
+/** Var the per-part fields are published into. */
+static const char *c_var_name = "MULTIPART";
+
+/** Largest part header block we will buffer before failing. */
+static const size_t c_max_header_block = 8192;
+
+/** Parser states. */
+typedef enum {
+    MP_STATE_PREAMBLE, /**< Before the first boundary. */
+    MP_STATE_HEADERS,  /**< Accumulating a part header block. */
+    MP_STATE_BODY,     /**< Streaming a part body. */
+    MP_STATE_EPILOGUE  /**< After the closing boundary; discard. */
+} mp_state_t;
+
+/** Per-transaction parser instance. */
+typedef struct {
+    ib_tx_t    *tx;           /**< Transaction this instance serves. */
+    const char *boundary;     /**< Dash-boundary ("--" + boundary token). */
+    size_t      boundary_len; /**< Length of @ref boundary. */
+    const char *delim;        /**< CRLF + dash-boundary. */
+    size_t      delim_len;    /**< Length of @ref delim. */
+    mp_state_t  state;        /**< Current parser state. */
+    uint8_t    *carry;        /**< Bytes held across execute calls. */
+    size_t      carry_len;    /**< Bytes used in @ref carry. */
+    size_t      carry_size;   /**< Capacity of @ref carry. */
+    size_t      part_count;   /**< Completed part header blocks. */
+} mp_inst_t;
+
+/**
+ * Find @a needle in @a hay.
+ *
+ * @param[in] hay        Data to search.
+ * @param[in] hay_len    Length of @a hay.
+ * @param[in] needle     Bytes to find.
+ * @param[in] needle_len Length of @a needle.
+ * @return Offset of first match or @a hay_len if not found.
+ **/
+static size_t mp_find(
+    const uint8_t *hay,
+    size_t         hay_len,
+    const uint8_t *needle,
+    size_t         needle_len
+)
+{
+    if (needle_len == 0 || hay_len < needle_len) {
+        return hay_len;
+    }
+    const uint8_t *cur = hay;
+    const uint8_t *end = hay + hay_len - needle_len + 1;
+    while (cur < end) {
+        const uint8_t *hit = memchr(cur, needle[0], end - cur);
+        if (hit == NULL) {
+            break;
+        }
+        if (memcmp(hit, needle, needle_len) == 0) {
+            return hit - hay;
+        }
+        cur = hit + 1;
+    }
+    return hay_len;
+}
+
+/**
+ * Append bytes to the instance carry buffer, growing it as needed.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] data Bytes to append.
+ * @param[in] data_len Length of @a data.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static ib_status_t mp_carry_append(
+    mp_inst_t     *inst,
+    const uint8_t *data,
+    size_t         data_len
+)
+{
+    if (inst->carry_len + data_len > inst->carry_size) {
+        size_t new_size = inst->carry_size == 0 ? 4096 : inst->carry_size;
+        while (new_size < inst->carry_len + data_len) {
+            new_size *= 2;
+        }
+        uint8_t *new_carry = ib_mm_alloc(inst->tx->mm, new_size);
+        if (new_carry == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(new_carry, inst->carry, inst->carry_len);
+        inst->carry      = new_carry;
+        inst->carry_size = new_size;
+    }
+    memcpy(inst->carry + inst->carry_len, data, data_len);
+    inst->carry_len += data_len;
+    return IB_OK;
+}
+
+/**
+ * Drop the first @a n bytes of the carry buffer.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] n Bytes to drop.
+ **/
+static void mp_carry_consume(mp_inst_t *inst, size_t n)
+{
+    assert(n <= inst->carry_len);
+
+    memmove(inst->carry, inst->carry + n, inst->carry_len - n);
+    inst->carry_len -= n;
+}
+
+/**
+ * Append a bytestr field to the MULTIPART list var.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] name Field name.
+ * @param[in] name_len Length of @a name.
+ * @param[in] value Field value; copied.
+ * @param[in] value_len Length of @a value.
+ * @return Status code.
+ **/
+static ib_status_t mp_publish_field(
+    mp_inst_t     *inst,
+    const char    *name,
+    size_t         name_len,
+    const uint8_t *value,
+    size_t         value_len
+)
+{
+    ib_status_t      rc;
+    ib_var_source_t *source;
+    ib_field_t      *list_field;
+    ib_list_t       *list;
+    ib_field_t      *field;
+    ib_bytestr_t    *bs;
+    ib_tx_t         *tx = inst->tx;
+
+    rc = ib_var_source_acquire(
+        &source,
+        tx->mm,
+        ib_engine_var_config_get(tx->ib),
+        IB_S2SL(c_var_name)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_var_source_get(source, &list_field, tx->var_store);
+    if (rc == IB_ENOENT) {
+        rc = ib_var_source_initialize(
+            source, &list_field, tx->var_store, IB_FTYPE_LIST
+        );
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_field_value(list_field, ib_ftype_list_mutable_out(&list));
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_bytestr_dup_mem(&bs, tx->mm, value, value_len);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_field_create(
+        &field,
+        tx->mm,
+        name, name_len,
+        IB_FTYPE_BYTESTR,
+        ib_ftype_bytestr_in(bs)
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_list_push(list, field);
+}
+
+/**
+ * Extract a quoted Content-Disposition parameter value.
+ *
+ * @param[in] data Header value to search.
+ * @param[in] data_len Length of @a data.
+ * @param[in] param Parameter name including trailing `=` (e.g. `name=`).
+ * @param[out] value Points into @a data on success.
+ * @param[out] value_len Length of @a value.
+ * @return IB_OK if found, IB_ENOENT otherwise.
+ **/
+static ib_status_t mp_disposition_param(
+    const uint8_t  *data,
+    size_t          data_len,
+    const char     *param,
+    const uint8_t **value,
+    size_t         *value_len
+)
+{
+    size_t param_len = strlen(param);
+    size_t pos = mp_find(data, data_len, (const uint8_t *)param, param_len);
+    if (pos == data_len) {
+        return IB_ENOENT;
+    }
+    pos += param_len;
+    if (pos < data_len && data[pos] == '"') {
+        ++pos;
+        size_t end = pos;
+        while (end < data_len && data[end] != '"') {
+            ++end;
+        }
+        *value     = data + pos;
+        *value_len = end - pos;
+    }
+    else {
+        size_t end = pos;
+        while (end < data_len && data[end] != ';' && data[end] != ' ') {
+            ++end;
+        }
+        *value     = data + pos;
+        *value_len = end - pos;
+    }
+    return IB_OK;
+}
+
+/**
+ * Publish vars for a completed part header block.
+ *
+ * The block contains CRLF-separated `Name: value` lines without the
+ * final blank line.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] block Header block.
+ * @param[in] block_len Length of @a block.
+ * @return Status code.
+ **/
+static ib_status_t mp_publish_headers(
+    mp_inst_t     *inst,
+    const uint8_t *block,
+    size_t         block_len
+)
+{
+    ib_status_t rc;
+
+    while (block_len > 0) {
+        size_t line_len = mp_find(block, block_len, (const uint8_t *)"\r\n", 2);
+        if (line_len > 0) {
+            size_t colon = mp_find(block, line_len, (const uint8_t *)":", 1);
+            if (colon < line_len) {
+                const uint8_t *value     = block + colon + 1;
+                size_t         value_len = line_len - colon - 1;
+                while (value_len > 0 && *value == ' ') {
+                    ++value;
+                    --value_len;
+                }
+                rc = mp_publish_field(
+                    inst,
+                    (const char *)block, colon,
+                    value, value_len
+                );
+                if (rc != IB_OK) {
+                    return rc;
+                }
+                if (
+                    colon == sizeof("Content-Disposition") - 1 &&
+                    strncasecmp(
+                        (const char *)block, "Content-Disposition", colon
+                    ) == 0
+                )
+                {
+                    const uint8_t *param;
+                    size_t param_len;
+                    if (
+                        mp_disposition_param(
+                            value, value_len, "name=", &param, &param_len
+                        ) == IB_OK
+                    )
+                    {
+                        rc = mp_publish_field(
+                            inst, IB_S2SL("part_name"), param, param_len
+                        );
+                        if (rc != IB_OK) {
+                            return rc;
+                        }
+                    }
+                    if (
+                        mp_disposition_param(
+                            value, value_len, "filename=", &param, &param_len
+                        ) == IB_OK
+                    )
+                    {
+                        rc = mp_publish_field(
+                            inst, IB_S2SL("part_filename"), param, param_len
+                        );
+                        if (rc != IB_OK) {
+                            return rc;
+                        }
+                    }
+                }
+            }
+        }
+        if (line_len + 2 > block_len) {
+            break;
+        }
+        block     += line_len + 2;
+        block_len -= line_len + 2;
+    }
+
+    ++inst->part_count;
+
+    return IB_OK;
+}
+
+/**
+ * Emit the first @a n carry bytes as part body data and consume them.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] io_tx IO transaction to put data into.
+ * @param[in] n Bytes to emit.
+ * @return Status code.
+ **/
+static ib_status_t mp_emit_body(
+    mp_inst_t         *inst,
+    ib_stream_io_tx_t *io_tx,
+    size_t             n
+)
+{
+    ib_status_t          rc;
+    ib_stream_io_data_t *out_data;
+    uint8_t             *out_buf;
+
+    if (n == 0) {
+        return IB_OK;
+    }
+
+    rc = ib_stream_io_data_alloc(io_tx, n, &out_data, &out_buf);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    memcpy(out_buf, inst->carry, n);
+    rc = ib_stream_io_data_put(io_tx, out_data);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mp_carry_consume(inst, n);
+    return IB_OK;
+}
+
+/**
+ * Run the parser over the current carry buffer.
+ *
+ * Consumes as much of the carry as the state machine can decide on,
+ * leaving only bytes that may be a partial delimiter or an incomplete
+ * header block for the next call.
+ *
+ * @param[in] inst Parser instance.
+ * @param[in] io_tx IO transaction to put part body data into.
+ * @return Status code.
+ **/
+static ib_status_t mp_parse(
+    mp_inst_t         *inst,
+    ib_stream_io_tx_t *io_tx
+)
+{
+    ib_status_t rc;
+
+    for (;;) {
+        switch (inst->state) {
+        case MP_STATE_PREAMBLE:
+        {
+            size_t pos = mp_find(
+                inst->carry, inst->carry_len,
+                (const uint8_t *)inst->boundary, inst->boundary_len
+            );
+            if (pos == inst->carry_len) {
+                /* Keep only a possible partial delimiter tail. */
+                if (inst->carry_len >= inst->boundary_len) {
+                    mp_carry_consume(
+                        inst, inst->carry_len - inst->boundary_len + 1
+                    );
+                }
+                return IB_OK;
+            }
+            /* Find the end of the delimiter line. */
+            size_t eol = pos + inst->boundary_len +
+                mp_find(
+                    inst->carry + pos + inst->boundary_len,
+                    inst->carry_len - pos - inst->boundary_len,
+                    (const uint8_t *)"\r\n", 2
+                );
+            if (eol == inst->carry_len) {
+                mp_carry_consume(inst, pos);
+                return IB_OK;
+            }
+            if (
+                inst->carry_len >= pos + inst->boundary_len + 2 &&
+                memcmp(
+                    inst->carry + pos + inst->boundary_len, "--", 2
+                ) == 0
+            )
+            {
+                inst->state = MP_STATE_EPILOGUE;
+                break;
+            }
+            mp_carry_consume(inst, eol + 2);
+            inst->state = MP_STATE_HEADERS;
+            break;
+        }
+        case MP_STATE_HEADERS:
+        {
+            if (inst->carry_len >= 2 &&
+                memcmp(inst->carry, "\r\n", 2) == 0)
+            {
+                /* Empty header block. */
+                ++inst->part_count;
+                mp_carry_consume(inst, 2);
+                inst->state = MP_STATE_BODY;
+                break;
+            }
+            size_t pos = mp_find(
+                inst->carry, inst->carry_len,
+                (const uint8_t *)"\r\n\r\n", 4
+            );
+            if (pos == inst->carry_len) {
+                if (inst->carry_len > c_max_header_block) {
+                    ib_stream_io_data_error(
+                        io_tx, IB_S2SL("Multipart part header too large")
+                    );
+                    return IB_EOTHER;
+                }
+                return IB_OK;
+            }
+            rc = mp_publish_headers(inst, inst->carry, pos + 2);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            mp_carry_consume(inst, pos + 4);
+            inst->state = MP_STATE_BODY;
+            break;
+        }
+        case MP_STATE_BODY:
+        {
+            size_t pos = mp_find(
+                inst->carry, inst->carry_len,
+                (const uint8_t *)inst->delim, inst->delim_len
+            );
+            if (pos == inst->carry_len) {
+                /* No full delimiter; emit all but a possible partial
+                 * delimiter tail. */
+                size_t keep = inst->delim_len - 1;
+                if (keep > inst->carry_len) {
+                    keep = inst->carry_len;
+                }
+                return mp_emit_body(inst, io_tx, inst->carry_len - keep);
+            }
+            rc = mp_emit_body(inst, io_tx, pos);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            /* Delimiter now at carry start; two more bytes classify it
+             * as a close-delimiter or another part. */
+            if (inst->carry_len < inst->delim_len + 2) {
+                return IB_OK;
+            }
+            if (memcmp(inst->carry + inst->delim_len, "--", 2) == 0) {
+                inst->state = MP_STATE_EPILOGUE;
+                break;
+            }
+            /* Consume through the delimiter line's CRLF. */
+            size_t eol = inst->delim_len + mp_find(
+                inst->carry + inst->delim_len,
+                inst->carry_len - inst->delim_len,
+                (const uint8_t *)"\r\n", 2
+            );
+            if (eol == inst->carry_len) {
+                return IB_OK;
+            }
+            mp_carry_consume(inst, eol + 2);
+            inst->state = MP_STATE_HEADERS;
+            break;
+        }
+        case MP_STATE_EPILOGUE:
+            inst->carry_len = 0;
+            return IB_OK;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Extract the multipart boundary from the request Content-Type header.
+ *
+ * @param[in] tx Transaction.
+ * @param[out] boundary Dash-boundary ("--" + token), tx lifetime.
+ * @param[out] boundary_len Length of @a boundary.
+ * @return
+ * - IB_OK on success.
+ * - IB_ENOENT if there is no multipart boundary.
+ * - IB_EALLOC on allocation failure.
+ **/
+static ib_status_t mp_boundary(
+    ib_tx_t     *tx,
+    const char **boundary,
+    size_t      *boundary_len
+)
+{
+    const ib_parsed_header_t *header;
+
+    if (tx->request_header == NULL) {
+        return IB_ENOENT;
+    }
+
+    for (
+        header = tx->request_header->head;
+        header != NULL;
+        header = header->next
+    )
+    {
+        if (
+            ib_bytestr_length(header->name) == sizeof("Content-Type") - 1 &&
+            strncasecmp(
+                (const char *)ib_bytestr_const_ptr(header->name),
+                "Content-Type",
+                sizeof("Content-Type") - 1
+            ) == 0
+        )
+        {
+            const uint8_t *value     = ib_bytestr_const_ptr(header->value);
+            size_t         value_len = ib_bytestr_length(header->value);
+            const uint8_t *param;
+            size_t         param_len;
+            if (
+                mp_disposition_param(
+                    value, value_len, "boundary=", &param, &param_len
+                ) != IB_OK ||
+                param_len == 0
+            )
+            {
+                return IB_ENOENT;
+            }
+            char *dash_boundary = ib_mm_alloc(tx->mm, param_len + 3);
+            if (dash_boundary == NULL) {
+                return IB_EALLOC;
+            }
+            dash_boundary[0] = '-';
+            dash_boundary[1] = '-';
+            memcpy(dash_boundary + 2, param, param_len);
+            dash_boundary[param_len + 2] = '\0';
+            *boundary     = dash_boundary;
+            *boundary_len = param_len + 2;
+            return IB_OK;
+        }
+    }
+
+    return IB_ENOENT;
+}
+
+/* ib_stream_processor_create_fn */
+static ib_status_t mp_create_fn(
+    void    *instance_data,
+    ib_tx_t *tx,
+    void    *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(tx != NULL);
+
+    ib_status_t rc;
+    mp_inst_t *inst;
+
+    inst = ib_mm_calloc(tx->mm, 1, sizeof(*inst));
+    if (inst == NULL) {
+        return IB_EALLOC;
+    }
+
+    inst->tx    = tx;
+    inst->state = MP_STATE_PREAMBLE;
+
+    rc = mp_boundary(tx, &inst->boundary, &inst->boundary_len);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Delimiter as seen from inside a part body: CRLF + dash-boundary. */
+    char *delim = ib_mm_alloc(tx->mm, inst->boundary_len + 3);
+    if (delim == NULL) {
+        return IB_EALLOC;
+    }
+    delim[0] = '\r';
+    delim[1] = '\n';
+    memcpy(delim + 2, inst->boundary, inst->boundary_len + 1);
+    inst->delim     = delim;
+    inst->delim_len = inst->boundary_len + 2;
+
+    *(void **)instance_data = inst;
+    return IB_OK;
+}
+
+/* ib_stream_processor_execute_fn */
+static ib_status_t mp_execute_fn(
+    void              *instance_data,
+    ib_tx_t           *tx,
+    ib_mm_t            mm_eval,
+    ib_stream_io_tx_t *io_tx,
+    void              *cbdata
+)
+{
+    assert(instance_data != NULL);
+    assert(tx != NULL);
+    assert(io_tx != NULL);
+
+    mp_inst_t   *inst = (mp_inst_t *)instance_data;
+    ib_status_t  rc = IB_OK;
+
+    for (;;) {
+        ib_stream_io_data_t *data;
+        uint8_t             *buf;
+        size_t               buf_len;
+        ib_stream_io_type_t  data_type;
+
+        rc = ib_stream_io_data_take(io_tx, &data, &buf, &buf_len, &data_type);
+        if (rc == IB_ENOENT) {
+            rc = IB_OK;
+            break;
+        }
+        if (rc != IB_OK) {
+            break;
+        }
+        if (data_type == IB_STREAM_IO_FLUSH) {
+            /* Parse what we can, then forward the flush. */
+            rc = mp_parse(inst, io_tx);
+            if (rc != IB_OK) {
+                ib_stream_io_data_unref(io_tx, data);
+                break;
+            }
+            rc = ib_stream_io_data_put(io_tx, data);
+            if (rc != IB_OK) {
+                break;
+            }
+            continue;
+        }
+
+        rc = mp_carry_append(inst, buf, buf_len);
+        ib_stream_io_data_unref(io_tx, data);
+        if (rc != IB_OK) {
+            break;
+        }
+        rc = mp_parse(inst, io_tx);
+        if (rc != IB_OK) {
+            break;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * On request headers, attach the processor to multipart transactions.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] tx Transaction.
+ * @param[in] state State.
+ * @param[in] cbdata Callback data (unused).
+ * @return Status code.
+ **/
+static ib_status_t mp_on_request_header(
+    ib_engine_t *ib,
+    ib_tx_t     *tx,
+    ib_state_t   state,
+    void        *cbdata
+)
+{
+    ib_status_t rc;
+    const char *boundary;
+    size_t      boundary_len;
+
+    rc = mp_boundary(tx, &boundary, &boundary_len);
+    if (rc == IB_ENOENT) {
+        return IB_OK;
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_stream_pump_processor_add(
+        ib_tx_request_body_pump(tx),
+        c_processor_name
+    );
+    if (rc != IB_OK) {
+        ib_log_error_tx(
+            tx,
+            "Failed to add multipart processor: %s",
+            ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Initialize the multipart module.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] m Module object.
+ * @param[in] cbdata Callback data (unused).
+ * @return Status code.
+ **/
+static ib_status_t mp_init(ib_engine_t *ib, ib_module_t *m, void *cbdata)
+{
+    ib_status_t      rc;
+    ib_mpool_lite_t *mpl;
+    ib_list_t       *types;
+
+    rc = ib_mpool_lite_create(&mpl);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_list_create(&types, ib_mm_mpool_lite(mpl));
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    rc = ib_list_push(types, (void *)c_processor_type);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    rc = ib_stream_processor_registry_register(
+        ib_engine_stream_processor_registry(ib),
+        c_processor_name,
+        types,
+        mp_create_fn, NULL,
+        mp_execute_fn, NULL,
+        NULL, NULL
+    );
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to register multipart stream processor.");
+        goto cleanup;
+    }
+
+    rc = ib_var_source_register(
+        NULL,
+        ib_engine_var_config_get(ib),
+        IB_S2SL(c_var_name),
+        IB_PHASE_NONE, IB_PHASE_NONE
+    );
+    if (rc != IB_OK && rc != IB_EEXIST) {
+        ib_log_warning(
+            ib,
+            "Error registering \"%s\": %s",
+            c_var_name,
+            ib_status_to_string(rc)
+        );
+        /* Continue. */
+        rc = IB_OK;
+    }
+
+    rc = ib_hook_tx_register(
+        ib,
+        request_header_finished_state,
+        mp_on_request_header,
+        NULL
+    );
+    if (rc != IB_OK) {
+        ib_log_error(
+            ib,
+            "Error registering multipart hook: %s",
+            ib_status_to_string(rc)
+        );
+    }
+
+cleanup:
+    ib_mpool_lite_destroy(mpl);
+    return rc;
+}
+
+IB_MODULE_INIT(
+    IB_MODULE_HEADER_DEFAULTS,           /* Default metadata */
+    MODULE_NAME_STR,                     /* Module name */
+    IB_MODULE_CONFIG_NULL,               /* Global config data */
+    NULL,                                /* Module config map */
+    NULL,                                /* Module directive map */
+    mp_init,                             /* Initialize function */
+    NULL,                                /* Callback data */
+    NULL,                                /* Finish function */
+    NULL,                                /* Callback data */
+);
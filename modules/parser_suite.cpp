@@ -37,6 +37,10 @@
 #pragma clang diagnostic pop
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 // Tell Fusion about the result structures.
@@ -157,6 +161,146 @@ void parse_indirect(
     input = span_t(begin, end);
 }
 
+/**
+ * @name Boundary scanners
+ *
+ * The hottest parsers below (request/response line and headers) scan for
+ * structural bytes --- line ends, colons, token separators --- instead of
+ * iterating a Spirit grammar byte-at-a-time.  With SSE2, sixteen bytes are
+ * examined per step; a scalar loop covers the tail and non-SSE2 builds.
+ **/
+///@{
+
+//! Advance @a p to the first CR or LF in [@a p, @a end), or @a end.
+const char* scan_to_eol(const char* p, const char* end)
+{
+#if defined(__SSE2__)
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, cr),
+                _mm_cmpeq_epi8(chunk, lf)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '\r' && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+//! Advance @a p to the first of " \t:\r\n" in [@a p, @a end), or @a end.
+const char* scan_key_end(const char* p, const char* end)
+{
+#if defined(__SSE2__)
+    const __m128i sp    = _mm_set1_epi8(' ');
+    const __m128i tab   = _mm_set1_epi8('\t');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i cr    = _mm_set1_epi8('\r');
+    const __m128i lf    = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, sp),
+                _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, colon),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, cr),
+                    _mm_cmpeq_epi8(chunk, lf))));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (
+        p < end &&
+        *p != ' ' && *p != '\t' && *p != ':' && *p != '\r' && *p != '\n'
+    ) {
+        ++p;
+    }
+    return p;
+}
+
+//! Advance @a p to the first of " \t\r\n" in [@a p, @a end), or @a end.
+const char* scan_token_end(const char* p, const char* end)
+{
+#if defined(__SSE2__)
+    const __m128i sp  = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr  = _mm_set1_epi8('\r');
+    const __m128i lf  = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, sp),
+                _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, cr),
+                _mm_cmpeq_epi8(chunk, lf)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (
+        p < end &&
+        *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n'
+    ) {
+        ++p;
+    }
+    return p;
+}
+
+//! Skip spaces and tabs.
+const char* skip_ws(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * Consume a line ending at @a p as Spirit's @c eol does.
+ *
+ * @returns The position just after "\r\n", "\r", or "\n", or NULL if
+ *          @a p does not begin a line ending.
+ **/
+const char* consume_eol(const char* p, const char* end)
+{
+    if (p < end && *p == '\n') {
+        return p + 1;
+    }
+    if (p < end && *p == '\r') {
+        if (p + 1 < end && p[1] == '\n') {
+            return p + 2;
+        }
+        return p + 1;
+    }
+    return NULL;
+}
+
+///@}
+
 }
 
 ostream& operator<<(
@@ -184,63 +328,129 @@ ostream& operator<<(
 
 parse_headers_result_t parse_headers(span_t& input)
 {
-    namespace p = boost::phoenix;
-    using namespace boost::spirit::qi;
-    using ascii::char_;
+    // Hand-rolled equivalent of the previous Spirit grammar:
+    //   header  = (key ':' *[ \t] value (eol|eoi))
+    //           | (+[ \t] value (eol|eoi))         [continuation]
+    //   grammar = +header >> -((*[ \t] >> eol) [terminated = true])
+    // where key = *(byte - " \t:\r\n") and value = +(byte - "\r\n").
+    // As with the grammar's semantic actions, a key is recorded as soon
+    // as its colon matches, even if no value follows; such a trailing
+    // valueless header ends the parse but remains in the result.
+    typedef parse_headers_result_t::header_t header_t;
 
     parse_headers_result_t R;
 
-    typedef parse_headers_result_t::header_t header_t;
-    const indirect_rule_t value =
-        raw[+(byte_-char_("\r\n"))] [
-            p::push_back((&p::back(p::ref(R.headers)))->*&header_t::value, _1)
-        ]
-        ;
-    const indirect_rule_t key =
-        (raw[*(byte_-char_(" \t:\r\n"))] >> omit[lit(":")]) [
-            p::push_back(p::ref(R.headers), p::construct<header_t>(_1))
-        ]
-        ;
-    const indirect_rule_t header =
-        (
-              key
-           >> *char_(" \t")
-           >> value
-           >> (eol|eoi)
-        ) |
-        (
-              +char_(" \t")
-           >> value
-           >> (eol|eoi)
-        )
-        ;
-    const indirect_rule_t grammar =
-           +header
-        >> -((*char_(" \t") >> eol) [p::ref(R.terminated) = true])
-        ;
+    const char* begin = input.begin();
+    const char* end   = input.end();
+    const char* p     = begin;
+    size_t      num_parsed = 0;
+    bool        done = false;
+
+    while (! done) {
+        done = true;
+        const char* line    = p;
+        const char* key_end = scan_key_end(line, end);
+
+        if (key_end < end && *key_end == ':') {
+            R.headers.push_back(header_t(span_t(line, key_end)));
+
+            const char* value_begin = skip_ws(key_end + 1, end);
+            const char* value_end   = scan_to_eol(value_begin, end);
+            if (value_end > value_begin) {
+                R.headers.back().value.push_back(
+                    span_t(value_begin, value_end));
+                p = value_end;
+                if (p < end) {
+                    p = consume_eol(p, end);
+                }
+                ++num_parsed;
+                done = false;
+            }
+            continue;
+        }
+
+        // Continuation line: folded into the previous header's value.
+        const char* value_begin = skip_ws(line, end);
+        if (value_begin > line && ! R.headers.empty()) {
+            const char* value_end = scan_to_eol(value_begin, end);
+            if (value_end > value_begin) {
+                R.headers.back().value.push_back(
+                    span_t(value_begin, value_end));
+                p = value_end;
+                if (p < end) {
+                    p = consume_eol(p, end);
+                }
+                ++num_parsed;
+                done = false;
+            }
+        }
+    }
+
+    // Optional terminating blank line.
+    {
+        const char* t     = skip_ws(p, end);
+        const char* after = consume_eol(t, end);
+        if (after != NULL) {
+            R.terminated = true;
+            p = after;
+        }
+    }
 
-    parse_indirect("headers", input, grammar);
+    if (num_parsed == 0) {
+        BOOST_THROW_EXCEPTION(error()
+            << errinfo_what("Incomplete headers.")
+            << errinfo_location(begin)
+        );
+    }
 
+    input = span_t(p, end);
     return R;
 }
 
 parse_request_line_result_t parse_request_line(span_t& input)
 {
-    using namespace boost::spirit::qi;
-    using ascii::char_;
+    // Hand-rolled equivalent of the previous Spirit grammar:
+    //   *[ \t] method *[ \t] uri *[ \t] -version (eol|eoi)
+    // where each word is +(byte - " \t\r\n").
 
-    const rule<const char*, span_t()> word =
-        raw[+(byte_-char_(" \t\r\n"))];
-
-    return parse_direct<parse_request_line_result_t>(
-        "request line", input,
-           omit[*char_(" \t")]
-        >> word  // method
-        >> omit[*char_(" \t")]
-        >> word  // uri
-        >> omit[*char_(" \t")]
-        >> -word // version
-        >> omit[eol|eoi]
+    parse_request_line_result_t R;
+
+    const char* begin = input.begin();
+    const char* end   = input.end();
+    const char* p     = skip_ws(begin, end);
+    const char* e;
+    const char* after;
+
+    e = scan_token_end(p, end);
+    if (e == p) {
+        goto fail;
+    }
+    R.method = span_t(p, e);
+
+    p = skip_ws(e, end);
+    e = scan_token_end(p, end);
+    if (e == p) {
+        goto fail;
+    }
+    R.uri = span_t(p, e);
+
+    p = skip_ws(e, end);
+    e = scan_token_end(p, end);
+    after = (e == end) ? end : consume_eol(e, end);
+    if (after == NULL) {
+        goto fail;
+    }
+    if (e > p) {
+        R.version = span_t(p, e);
+    }
+
+    input = span_t(after, end);
+    return R;
+
+fail:
+    BOOST_THROW_EXCEPTION(error()
+        << errinfo_what("Incomplete request line.")
+        << errinfo_location(begin)
     );
 }
 
@@ -259,21 +469,48 @@ ostream& operator<<(
 
 parse_response_line_result_t parse_response_line(span_t& input)
 {
-    using namespace boost::spirit::qi;
-    using ascii::char_;
+    // Hand-rolled equivalent of the previous Spirit grammar:
+    //   *[ \t] version *[ \t] status *[ \t] message (eol|eoi)
+    // where version and status are +(byte - " \t\r\n") and message is
+    // *(byte - "\r\n"), possibly empty.
 
-    const rule<const char *, span_t()> word =
-        raw[+(byte_-char_(" \t\r\n"))];
-
-    return parse_direct<parse_response_line_result_t>(
-        "response line", input,
-           omit[*char_(" \t")]
-        >> word                        // version
-        >> omit[*char_(" \t")]
-        >> word                        // status
-        >> omit[*char_(" \t")]
-        >> raw[*(byte_-char_("\r\n"))] // message
-        >> omit[eol|eoi]
+    parse_response_line_result_t R;
+
+    const char* begin = input.begin();
+    const char* end   = input.end();
+    const char* p     = skip_ws(begin, end);
+    const char* e;
+    const char* after;
+
+    e = scan_token_end(p, end);
+    if (e == p) {
+        goto fail;
+    }
+    R.version = span_t(p, e);
+
+    p = skip_ws(e, end);
+    e = scan_token_end(p, end);
+    if (e == p) {
+        goto fail;
+    }
+    R.status = span_t(p, e);
+
+    p = skip_ws(e, end);
+    e = scan_to_eol(p, end);
+    R.message = span_t(p, e);
+
+    after = (e == end) ? end : consume_eol(e, end);
+    if (after == NULL) {
+        goto fail;
+    }
+
+    input = span_t(after, end);
+    return R;
+
+fail:
+    BOOST_THROW_EXCEPTION(error()
+        << errinfo_what("Incomplete response line.")
+        << errinfo_location(begin)
     );
 }
 
@@ -29,6 +29,7 @@
 #include <ironbee/engine.h>
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm.h>
 #include <ironbee/module.h>
 #include <ironbee/operator.h>
@@ -92,6 +93,21 @@ struct modpcre_cfg_t {
 };
 typedef struct modpcre_cfg_t modpcre_cfg_t;
 
+/**
+ * Engine-wide module data.
+ *
+ * Compiled patterns are interned here so identical patterns compiled
+ * under identical settings share one compiled pattern, study data and
+ * JIT code across configuration contexts.  The cache is written only at
+ * configuration time, which is single threaded; at runtime entries are
+ * read-only, with per-tx JIT stacks and DFA workspaces keeping all
+ * mutable match state out of the shared data.
+ */
+struct modpcre_module_data_t {
+    ib_hash_t *cpat_cache;  /**< Cache key to @ref modpcre_cpat_data_t. */
+};
+typedef struct modpcre_module_data_t modpcre_module_data_t;
+
 /**
  * Internal representation of PCRE compiled patterns.
  */
@@ -103,6 +119,10 @@ struct modpcre_cpat_data_t {
     bool                 is_dfa;          /**< Is this a DFA? */
     bool                 is_jit;          /**< Is this JIT compiled? */
     int                  dfa_ws_size;     /**< Size of DFA workspace */
+    int                  first_byte;      /**< Fixed first byte or -1 */
+    int                  last_literal;    /**< Required literal byte or -1 */
+    const char          *literal;         /**< Required literal prefix */
+    size_t               literal_len;     /**< Length of literal; 0=none */
 };
 typedef struct modpcre_cpat_data_t modpcre_cpat_data_t;
 
@@ -132,6 +152,9 @@ struct pcre_tx_data_t {
     ib_hash_t      *dfa_workspace_hash;
     int            *ovector;    /** Array of N matches that is 3 * N long. */
     int             ovector_sz; /* The size of ovector. 3 * N. */
+    const char     *map_subject;     /**< Subject subject_map was built on */
+    size_t          map_subject_len; /**< Length of map_subject */
+    uint32_t        subject_map[8];  /**< Byte-presence bitmap of subject */
 };
 typedef struct pcre_tx_data_t pcre_tx_data_t;
 
@@ -255,6 +278,10 @@ ib_status_t get_or_create_operator_data(
         return IB_EALLOC;
     }
 
+    /* No subject map has been built yet. */
+    data_tmp->map_subject = NULL;
+    data_tmp->map_subject_len = 0;
+
     /* Create the DFA Hash. */
     {
         rc = ib_hash_create(&data_tmp->dfa_workspace_hash, tx->mm);
@@ -381,11 +408,102 @@ static ib_status_t compile_pattern(
     return IB_OK;
 }
 
+/**
+ * Extract a required literal prefix from @a patt.
+ *
+ * Takes the leading run of plain characters and accepts it only when no
+ * top-level alternation later in the pattern could bypass it.  The
+ * extraction is deliberately conservative: any escape, class, group,
+ * anchor or other metacharacter ends the run, and a quantifier
+ * additionally drops the character it modifies since that character may
+ * match zero times.  Runs shorter than two characters are not recorded;
+ * the single-byte requirements already cover them.
+ *
+ * @param[in] mm Memory manager to copy the prefix out of.
+ * @param[in] patt The pattern text.
+ * @param[out] literal The prefix, or NULL if none was extracted.
+ * @param[out] literal_len Length of @a literal, or 0.
+ *
+ * @returns IB_OK or IB_EALLOC.
+ */
+static ib_status_t pcre_extract_literal_prefix(
+    ib_mm_t      mm,
+    const char  *patt,
+    const char **literal,
+    size_t      *literal_len
+)
+{
+    assert(patt != NULL);
+    assert(literal != NULL);
+    assert(literal_len != NULL);
+
+    static const char meta[] = "\\^$.[]()?*+{}|";
+    size_t run = 0;
+
+    *literal = NULL;
+    *literal_len = 0;
+
+    while (patt[run] != '\0' && strchr(meta, patt[run]) == NULL) {
+        ++run;
+    }
+
+    /* A quantifier makes the character before it optional. */
+    if (run > 0 && (patt[run] == '?' || patt[run] == '*' || patt[run] == '{'))
+    {
+        --run;
+    }
+
+    if (run < 2) {
+        return IB_OK;
+    }
+
+    /* A top-level alternation after the run means some branch does not
+     * require the prefix. */
+    {
+        int depth = 0;
+        bool in_class = false;
+        for (const char *p = patt + run; *p != '\0'; ++p) {
+            if (*p == '\\' && p[1] != '\0') {
+                ++p;
+            }
+            else if (in_class) {
+                if (*p == ']') {
+                    in_class = false;
+                }
+            }
+            else if (*p == '[') {
+                in_class = true;
+            }
+            else if (*p == '(') {
+                ++depth;
+            }
+            else if (*p == ')') {
+                --depth;
+            }
+            else if (*p == '|' && depth == 0) {
+                return IB_OK;
+            }
+        }
+    }
+
+    *literal = ib_mm_memdup(mm, patt, run);
+    if (*literal == NULL) {
+        return IB_EALLOC;
+    }
+    *literal_len = run;
+
+    return IB_OK;
+}
+
 /**
  * Internal compilation of the modpcre pattern.
  *
+ * Compiled patterns are interned engine-wide keyed on the pattern text
+ * and every configuration value that affects compilation; repeated
+ * compilations of the same pattern under the same settings return the
+ * shared, engine-lifetime compilation instead of a new copy.
+ *
  * @param[in] ib IronBee engine for logging.
- * @param[in] mm The memory manager to allocate memory out of.
  * @param[in] config Module configuration
  * @param[in] is_dfa Set to true for DFA
  * @param[out] pcpdata Pointer to new struct containing the compilation.
@@ -399,7 +517,6 @@ static ib_status_t compile_pattern(
 static ib_status_t pcre_compile_internal(
     ib_module_t          *module,
     ib_engine_t          *ib,
-    ib_mm_t               mm,
     const modpcre_cfg_t  *config,
     bool                  is_dfa,
     modpcre_cpat_data_t **pcpdata,
@@ -412,12 +529,45 @@ static ib_status_t pcre_compile_internal(
     assert(config != NULL);
     assert(pcpdata != NULL);
     assert(patt != NULL);
+    assert(module != NULL);
+    assert(module->data != NULL);
 
     /* Pattern data structure we'll create */
     modpcre_cpat_data_t *cpdata;
 
     ib_status_t ib_rc;
 
+    modpcre_module_data_t *mod_data = (modpcre_module_data_t *)module->data;
+
+    /* Compilations are interned for the life of the engine. */
+    const ib_mm_t mm = ib_engine_mm_main_get(ib);
+
+    char *key;
+    size_t key_sz;
+
+    /* Probe the intern cache.  The key is the pattern and every
+     * configuration value that influences the compilation; JIT stack
+     * sizes are per-tx runtime state and deliberately excluded. */
+    key_sz = strlen(patt) + 128;
+    key = malloc(key_sz);
+    if (key == NULL) {
+        return IB_EALLOC;
+    }
+    snprintf(key, key_sz, "%d:%ld:%ld:%ld:%ld:%ld:%s",
+             is_dfa ? 1 : 0,
+             (long)config->study,
+             (long)config->use_jit,
+             (long)config->match_limit,
+             (long)config->match_limit_recursion,
+             (long)config->dfa_workspace_size,
+             patt);
+    ib_rc = ib_hash_get(mod_data->cpat_cache, &cpdata, key);
+    if (ib_rc == IB_OK) {
+        free(key);
+        *pcpdata = cpdata;
+        return IB_OK;
+    }
+
 #ifdef PCRE_HAVE_JIT
     /* Are we using JIT? */
     bool use_jit;
@@ -440,6 +590,7 @@ static ib_status_t pcre_compile_internal(
         ib_log_error(ib,
                      "Failed to allocate cpdata of size: %zd",
                      sizeof(*cpdata));
+        free(key);
         return IB_EALLOC;
     }
 
@@ -448,6 +599,7 @@ static ib_status_t pcre_compile_internal(
     /* Populate cpdata->cpatt and cpdata->patt. */
     ib_rc = compile_pattern(ib, cpdata, mm, patt, errptr, erroffset);
     if (ib_rc != IB_OK) {
+        free(key);
         return ib_rc;
     }
 
@@ -471,6 +623,7 @@ static ib_status_t pcre_compile_internal(
             edata = pcre_study(cpdata->cpatt, 0, errptr);
             if (*errptr != NULL)  {
                 ib_log_error(ib, "PCRE study failed: %s", *errptr);
+                free(key);
                 return IB_EINVAL;
             }
             ib_mm_register_cleanup(mm, pcre_free_study_wrapper, edata);
@@ -536,6 +689,36 @@ static ib_status_t pcre_compile_internal(
     }
 #endif /*PCRE_HAVE_JIT*/
 
+    /* Extract byte requirements used to pre-filter subjects at execution
+     * time.  A fixed first byte or required literal that is absent from a
+     * subject proves the pattern cannot match it without running the
+     * matcher at all.  Alphabetic bytes are tested in both cases at
+     * execution since the pattern may have been compiled caseless. */
+    cpdata->first_byte = -1;
+    cpdata->last_literal = -1;
+    if (! is_dfa) {
+        int value;
+        if (pcre_fullinfo(cpdata->cpatt, cpdata->edata,
+                          PCRE_INFO_FIRSTBYTE, &value) == 0
+            && value >= 0)
+        {
+            cpdata->first_byte = value;
+        }
+        if (pcre_fullinfo(cpdata->cpatt, cpdata->edata,
+                          PCRE_INFO_LASTLITERAL, &value) == 0
+            && value >= 0)
+        {
+            cpdata->last_literal = value;
+        }
+
+        ib_rc = pcre_extract_literal_prefix(
+            mm, patt, &cpdata->literal, &cpdata->literal_len);
+        if (ib_rc != IB_OK) {
+            free(key);
+            return ib_rc;
+        }
+    }
+
     cpdata->is_dfa = is_dfa;
     cpdata->is_jit = use_jit;
 
@@ -556,6 +739,21 @@ static ib_status_t pcre_compile_internal(
                  cpdata->is_dfa ? "yes" : "no",
                  cpdata->dfa_ws_size,
                  cpdata->is_jit ? "yes" : "no");
+
+    /* Intern the compilation.  The key must outlive the hash entry, so
+     * it is copied into the engine-lifetime manager. */
+    {
+        char *interned_key = ib_mm_strdup(mm, key);
+        free(key);
+        if (interned_key == NULL) {
+            return IB_EALLOC;
+        }
+        ib_rc = ib_hash_set(mod_data->cpat_cache, interned_key, cpdata);
+        if (ib_rc != IB_OK) {
+            return ib_rc;
+        }
+    }
+
     *pcpdata = cpdata;
 
     return IB_OK;
@@ -622,7 +820,6 @@ ib_status_t pcre_operator_create(
      * the compiled pattern type */
     rc = pcre_compile_internal(module,
                                ib,
-                               mm,
                                config,
                                false,
                                &cpdata,
@@ -673,6 +870,8 @@ ib_status_t pcre_set_matches(
     assert(ovector != NULL);
 
     ib_status_t rc;
+    ib_bytestr_t *subject_bs;
+    size_t subject_end = 0;
     int i;
 
     rc = ib_capture_clear(capture);
@@ -681,33 +880,59 @@ ib_status_t pcre_set_matches(
                         ib_status_to_string(rc));
     }
 
+    /* Copy the matched-against prefix of the subject once; each capture
+     * below is a zero-copy view into that copy.  Overlapping groups no
+     * longer duplicate the same bytes, and the views stay valid for the
+     * transaction no matter which buffer the subject came from. */
+    for (i = 0; i < matches; ++i) {
+        if (ovector[i*2+1] > (int)subject_end) {
+            subject_end = ovector[i*2+1];
+        }
+    }
+    rc = ib_bytestr_dup_mem(&subject_bs,
+                            tx->mm,
+                            (const uint8_t *)subject,
+                            subject_end);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* We have a match! Now populate TX:0-9 in tx->data. */
     for (i = 0; i < matches; ++i)
     {
         /* The length of the match. */
         size_t match_len;
 
-        /* The first character in the match. */
-        const char *match_start;
-
-        /* Field name */
-        const char *name;
+        /* The offset of the match in the subject. */
+        size_t match_start;
 
-        /* Holder for a copy of the field value when creating a new field. */
+        /* Holder for the view of the field value when creating a new field. */
         ib_bytestr_t *bs;
 
         /* Field holder. */
         ib_field_t *field;
 
-        /* Readability. Mark the start and length of the string. */
-        match_start = subject+ovector[i*2];
-        match_len = ovector[i*2+1] - ovector[i*2];
+        /* Field name */
+        const char *name;
+
+        /* Readability. Mark the start and length of the string.  A group
+         * that did not participate in the match has offset -1 and is
+         * captured as an empty string. */
+        if (ovector[i*2] < 0) {
+            match_start = 0;
+            match_len = 0;
+        }
+        else {
+            match_start = ovector[i*2];
+            match_len = ovector[i*2+1] - ovector[i*2];
+        }
 
-        /* Create a byte-string representation */
-        rc = ib_bytestr_dup_mem(&bs,
-                                tx->mm,
-                                (const uint8_t*)match_start,
-                                match_len);
+        /* Create a view of the match. */
+        rc = ib_bytestr_alias_range(&bs,
+                                    tx->mm,
+                                    subject_bs,
+                                    match_start,
+                                    match_len);
         if (rc != IB_OK) {
             return rc;
         }
@@ -1157,6 +1382,104 @@ const char* pcre_error_str(int rc)
     return "Unexpected error code.";
 }
 
+/**
+ * Test @a byte, and its case-mate if alphabetic, against a byte map.
+ *
+ * @param[in] map 256-bit byte-presence map.
+ * @param[in] byte Byte to test, 0-255.
+ *
+ * @returns True if the byte (in either case) occurs in the map.
+ */
+static bool subject_map_test(const uint32_t *map, int byte)
+{
+    assert(map != NULL);
+    assert(byte >= 0 && byte <= 255);
+
+    if (map[byte >> 5] & (1U << (byte & 0x1f))) {
+        return true;
+    }
+
+    if (isalpha(byte)) {
+        int mate = isupper(byte) ? tolower(byte) : toupper(byte);
+        return (map[mate >> 5] & (1U << (mate & 0x1f))) != 0;
+    }
+
+    return false;
+}
+
+/**
+ * Reject subjects that provably cannot match a pattern.
+ *
+ * Builds (or reuses) a 256-bit map of the bytes occurring in @a subject
+ * and tests the pattern's fixed first byte and required literal byte
+ * against it, then searches for the pattern's required literal prefix,
+ * if one was extracted at compile time.  The map is cached per transaction keyed on the subject pointer and
+ * length, so a phase running many regex rules against the same target
+ * reads the subject once and answers the remaining rules with two bit
+ * tests each instead of a regex engine start-up per rule.  Subjects are
+ * transaction-lifetime allocations, so pointer and length identify the
+ * content for the life of the cache.
+ *
+ * @param[in,out] tx_data Per-transaction data holding the cached map.
+ * @param[in] cpdata Compiled pattern data.
+ * @param[in] subject Subject bytes.
+ * @param[in] subject_len Length of @a subject.
+ *
+ * @returns True if the pattern may match, false if it cannot.
+ */
+static bool pcre_prefilter(
+    pcre_tx_data_t            *tx_data,
+    const modpcre_cpat_data_t *cpdata,
+    const char                *subject,
+    size_t                     subject_len
+)
+{
+    assert(tx_data != NULL);
+    assert(cpdata != NULL);
+    assert(subject != NULL);
+
+    if (cpdata->first_byte >= 0 || cpdata->last_literal >= 0) {
+        if (   subject != tx_data->map_subject
+            || subject_len != tx_data->map_subject_len)
+        {
+            memset(tx_data->subject_map, 0, sizeof(tx_data->subject_map));
+            for (size_t i = 0; i < subject_len; ++i) {
+                unsigned char b = (unsigned char)subject[i];
+                tx_data->subject_map[b >> 5] |= 1U << (b & 0x1f);
+            }
+            tx_data->map_subject = subject;
+            tx_data->map_subject_len = subject_len;
+        }
+
+        if (   cpdata->first_byte >= 0
+            && ! subject_map_test(tx_data->subject_map, cpdata->first_byte))
+        {
+            return false;
+        }
+
+        if (   cpdata->last_literal >= 0
+            && ! subject_map_test(tx_data->subject_map, cpdata->last_literal))
+        {
+            return false;
+        }
+    }
+
+    /* Required literal prefix: the pattern cannot match a subject that
+     * does not contain it. */
+    if (cpdata->literal_len > 0) {
+        if (cpdata->literal_len > subject_len) {
+            return false;
+        }
+        if (memmem(subject, subject_len,
+                   cpdata->literal, cpdata->literal_len) == NULL)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief Execute the PCRE operator
  *
@@ -1236,6 +1559,34 @@ static ib_status_t pcre_operator_execute(
         return ib_rc;
     }
 
+    /* Count every screened invocation so skip rates can be computed
+     * against pcre.prefilter.skip. */
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "pcre.prefilter.total", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+
+    /* Cheap byte-presence and literal-prefix test before engaging the
+     * regex engine. */
+    if (! pcre_prefilter(tx_data, operator_data->cpdata,
+                         subject, subject_len))
+    {
+        {
+            static const ib_metric_t *metric = NULL;
+            if (metric == NULL) {
+                metric = ib_metric_acquire(
+                    "pcre.prefilter.skip", IB_METRIC_COUNTER);
+            }
+            ib_metric_add(metric, 1);
+        }
+        *result = 0;
+        return IB_OK;
+    }
+
     matches = pcre_exec_internal(
         operator_data->cpdata,
         tx_data->stack,
@@ -1363,7 +1714,6 @@ ib_status_t dfa_operator_create(
 
     rc = pcre_compile_internal(module,
                                ib,
-                               mm,
                                config,
                                true,
                                &cpdata,
@@ -1396,6 +1746,84 @@ ib_status_t dfa_operator_create(
     return IB_OK;
 }
 
+/**
+ * A pooled DFA workspace buffer.
+ *
+ * The integer workspace pcre_dfa_exec() requires lives for the whole
+ * transaction (restart state spans invocations), so buffers are pooled
+ * per thread and recycled when the transaction is destroyed rather
+ * than allocated per transaction per operator.  The payload follows
+ * the header.
+ */
+typedef struct dfa_ws_buf_t dfa_ws_buf_t;
+struct dfa_ws_buf_t {
+    dfa_ws_buf_t *next;    /**< Next free buffer. */
+    int           wscount; /**< Capacity of the payload in ints. */
+};
+
+/** Per-thread free list of DFA workspace buffers. */
+static __thread dfa_ws_buf_t *s_dfa_ws_pool = NULL;
+
+/** Number of buffers in @ref s_dfa_ws_pool. */
+static __thread int s_dfa_ws_pool_len = 0;
+
+/** Maximum buffers parked in @ref s_dfa_ws_pool. */
+static const int DFA_WS_POOL_MAX = 8;
+
+/**
+ * Acquire a workspace of at least @a wscount ints.
+ *
+ * Reuses the first pooled buffer large enough, falling back to malloc.
+ *
+ * @param[in] wscount Required capacity in ints.
+ *
+ * @returns The workspace or NULL on allocation failure.
+ */
+static int *dfa_ws_acquire(int wscount)
+{
+    dfa_ws_buf_t **prev = &s_dfa_ws_pool;
+
+    for (dfa_ws_buf_t *buf = s_dfa_ws_pool; buf != NULL; buf = buf->next) {
+        if (buf->wscount >= wscount) {
+            *prev = buf->next;
+            --s_dfa_ws_pool_len;
+            return (int *)(buf + 1);
+        }
+        prev = &buf->next;
+    }
+
+    dfa_ws_buf_t *buf = malloc(sizeof(*buf) + sizeof(int) * wscount);
+    if (buf == NULL) {
+        return NULL;
+    }
+    buf->wscount = wscount;
+
+    return (int *)(buf + 1);
+}
+
+/**
+ * Return a workspace acquired with dfa_ws_acquire() to the pool.
+ *
+ * Registered as a memory manager cleanup against the transaction.
+ *
+ * @param[in] payload The workspace.
+ */
+static void dfa_ws_release(void *payload)
+{
+    assert(payload != NULL);
+
+    dfa_ws_buf_t *buf = ((dfa_ws_buf_t *)payload) - 1;
+
+    if (s_dfa_ws_pool_len >= DFA_WS_POOL_MAX) {
+        free(buf);
+        return;
+    }
+
+    buf->next = s_dfa_ws_pool;
+    s_dfa_ws_pool = buf;
+    ++s_dfa_ws_pool_len;
+}
+
 /**
  * Create the per-transaction data for use with the dfa operator.
  *
@@ -1426,7 +1854,6 @@ ib_status_t alloc_dfa_tx_data(
     ib_hash_t       *hash;
     ib_status_t      rc;
     dfa_workspace_t *ws;
-    size_t           size;
 
     *workspace = NULL;
 
@@ -1441,12 +1868,18 @@ ib_status_t alloc_dfa_tx_data(
     ws->partial_sz = 0;
     ws->options    = 0;
     ws->wscount    = cpatt_data->dfa_ws_size;
-    size           = sizeof(*(ws->workspace)) * (ws->wscount);
-    ws->workspace  = (int *)ib_mm_alloc(tx->mm, size);
+    ws->workspace  = dfa_ws_acquire(ws->wscount);
     if (ws->workspace == NULL) {
         return IB_EALLOC;
     }
 
+    /* Return the workspace to the thread pool at tx destroy. */
+    rc = ib_mm_register_cleanup(tx->mm, dfa_ws_release, ws->workspace);
+    if (rc != IB_OK) {
+        dfa_ws_release(ws->workspace);
+        return rc;
+    }
+
     rc = ib_hash_set(hash, id, ws);
     if (rc != IB_OK) {
         return rc;
@@ -2071,7 +2504,6 @@ ib_status_t filter_rx_create(
     rc = pcre_compile_internal(
         m,
         ib,
-        mm,
         &modpcre_global_cfg,
         false,
         &cpdata,
@@ -2285,6 +2717,19 @@ static ib_status_t modpcre_init(ib_engine_t *ib,
     assert(m != NULL);
 
     ib_status_t rc;
+    modpcre_module_data_t *mod_data;
+
+    /* Create the engine-wide compiled pattern intern cache. */
+    mod_data = ib_mm_calloc(
+        ib_engine_mm_main_get(ib), 1, sizeof(*mod_data));
+    if (mod_data == NULL) {
+        return IB_EALLOC;
+    }
+    rc = ib_hash_create(&mod_data->cpat_cache, ib_engine_mm_main_get(ib));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    m->data = mod_data;
 
     /* Register operators. */
     rc = ib_operator_create_and_register(
@@ -26,11 +26,14 @@
 
 #include <ironbee/context.h>
 #include <ironbee/engine.h>
+#include <ironbee/field_codec.h>
 #include <ironbee/json.h>
 #include <ironbee/kvstore.h>
 #include <ironbee/kvstore_filesystem.h>
+#include <ironbee/kvstore_journal.h>
 #include <ironbee/list.h>
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool_lite.h>
 #include <ironbee/module.h>
 #include <ironbee/string.h>
 #include <ironbee/type_convert.h>
@@ -49,6 +52,7 @@ static const ib_num_t DEFAULT_EXPIRATION = 60;
 
 static const char FILE_URI_PREFIX[] = "persist-fs://";
 static const char JSON_TYPE[] = "application_json";
+static const char BINARY_TYPE[] = "application_vnd_ironbee_fields";
 
 /* Define the module name as well as a string version of it. */
 #define MODULE_NAME persist
@@ -131,6 +135,8 @@ ib_status_t file_rw_create_fn(
     ib_mm_t               mm = ib_engine_mm_main_get(ib);
     const ib_list_node_t *node;
     const char           *uri;
+    const char           *journal_dir = NULL;
+    ib_num_t              journal_sync = 0;
     file_rw_t            *file_rw;
     ib_status_t           rc;
 
@@ -171,6 +177,23 @@ ib_status_t file_rw_create_fn(
                 ib_log_warning(ib, "Failed to copy key.");
                 return IB_EALLOC;
             }
+            continue;
+        }
+
+        val = get_val("journal=", opt);
+        if (val != NULL) {
+            journal_dir = val;
+            continue;
+        }
+
+        val = get_val("journal-sync=", opt);
+        if (val != NULL) {
+            rc = ib_type_atoi(val, 10, &journal_sync);
+            if (rc != IB_OK || journal_sync < 0) {
+                ib_log_error(ib, "Failed to parse journal-sync value %s.", val);
+                return IB_EINVAL;
+            }
+            continue;
         }
     }
 
@@ -186,6 +209,24 @@ ib_status_t file_rw_create_fn(
             return rc;
         }
 
+        /* When journaling, the journal store decorates the filesystem
+         * store and connecting it connects (and replays into) the
+         * backing store. */
+        if (journal_dir != NULL) {
+            ib_kvstore_t *backing = file_rw->kvstore;
+
+            file_rw->kvstore = ib_mm_alloc(mm, ib_kvstore_size());
+            rc = ib_kvstore_journal_init(
+                file_rw->kvstore,
+                backing,
+                journal_dir,
+                (uint32_t)journal_sync);
+            if (rc != IB_OK) {
+                ib_log_error(ib, "Failed to initialize kvstore journal.");
+                return rc;
+            }
+        }
+
         rc = ib_kvstore_connect(file_rw->kvstore);
         if (rc != IB_OK) {
             ib_log_error(ib, "Failed to connect to kvstore.");
@@ -266,11 +307,30 @@ static ib_status_t file_rw_load_fn(
     ib_kvstore_value_value_get(kv_val, &value, &value_length);
 
     /* Deserialize the data. */
-    if (  sizeof(JSON_TYPE)-1 == type_length
-       && strncmp(JSON_TYPE, type, type_length) == 0)
+    if (  sizeof(BINARY_TYPE)-1 == type_length
+       && strncmp(BINARY_TYPE, type, type_length) == 0)
+    {
+
+        /* Deserialize the binary field codec. */
+        const char *err_msg;
+        ib_mm_t mm = ib_engine_mm_main_get(ib);
+
+        rc = ib_field_codec_decode(
+            mm,
+            value,
+            value_length,
+            list,
+            &err_msg);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Error decoding stored fields: %s", err_msg);
+            return rc;
+        }
+    }
+    else if (  sizeof(JSON_TYPE)-1 == type_length
+            && strncmp(JSON_TYPE, type, type_length) == 0)
     {
 
-        /* Deserialize JSON. */
+        /* Deserialize JSON written by older versions. */
         const char *err_msg;
         ib_mm_t mm = ib_engine_mm_main_get(ib);
 
@@ -311,7 +371,8 @@ static ib_status_t file_rw_store_fn(
 
     file_rw_t          *file_rw = (file_rw_t *)impl;
     ib_engine_t        *ib = file_rw->ib;
-    ib_mm_t             mm = tx->mm;
+    ib_mpool_lite_t    *mp;
+    ib_mm_t             mm;
     ib_status_t         rc;
     ib_kvstore_key_t   *kv_key;
     ib_kvstore_value_t *kv_val;
@@ -323,31 +384,39 @@ static ib_status_t file_rw_store_fn(
 
     assert(file_rw->kvstore != NULL);
 
-    rc = ib_json_encode(
+    /* Allocations here are temporaries; the kvstore copies what it
+     * keeps. Use a local pool rather than tx->mm so this handler also
+     * works from the write-behind flush thread, where tx is NULL. */
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    rc = ib_field_codec_encode(
         mm,
         list,
-        true,
-        (char **)&data,
+        (uint8_t **)&data,
         &dlen);
     if (rc != IB_OK) {
-        ib_log_error(ib, "Failed to encode json.");
-        return rc;
+        ib_log_error(ib, "Failed to encode fields.");
+        goto cleanup;
     }
 
     rc = ib_kvstore_key_create(&kv_key, mm, (const uint8_t *)key, key_len);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to create key.");
-        return rc;
+        goto cleanup;
     }
 
     rc = ib_kvstore_value_create(&kv_val, mm);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to create kvstore value.");
-        return rc;
+        goto cleanup;
     }
 
     ib_kvstore_value_value_set(kv_val, data, dlen);
-    ib_kvstore_value_type_set(kv_val, JSON_TYPE, sizeof(JSON_TYPE)-1);
+    ib_kvstore_value_type_set(kv_val, BINARY_TYPE, sizeof(BINARY_TYPE)-1);
     ib_kvstore_value_creation_set(kv_val, IB_CLOCK_TIMEVAL_TIME(creation));
     ib_kvstore_value_expiration_set(kv_val, expiration);
 
@@ -358,10 +427,12 @@ static ib_status_t file_rw_store_fn(
             "Failed to store key-value \"%.*s\".",
             (int)key_len,
             (const char *)key);
-        return rc;
+        goto cleanup;
     }
 
-    return IB_OK;
+cleanup:
+    ib_mpool_lite_destroy(mp);
+    return rc;
 }
 
 /**
@@ -642,6 +713,143 @@ static ib_status_t persistence_map_fn(
     return IB_OK;
 }
 
+/**
+ * Handle the PersistenceWriteBehind directive.
+ *
+ * When on, collections are stored by a background flush thread rather
+ * than synchronously at the end of the transaction.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name The directive name.
+ * @param[in] onoff The directive value.
+ * @param[in] cbdata A @ref persist_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on failure to start the flush thread.
+ */
+static ib_status_t persistence_write_behind_fn(
+    ib_cfgparser_t *cp,
+    const char     *name,
+    int             onoff,
+    void           *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(cbdata != NULL);
+
+    persist_cfg_t *cfg = (persist_cfg_t *)cbdata;
+    ib_status_t    rc;
+
+    /* Off is the default. Once the flush thread is started it is not
+     * stopped until the engine shuts down. */
+    if (onoff == 0) {
+        return IB_OK;
+    }
+
+    rc = ib_persist_fw_write_behind(cfg->persist_fw);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(cp, "Failed to enable write-behind persistence.");
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Handle the PersistenceCache directive.
+ *
+ * Syntax: `PersistenceCache <max-entries> [ttl=secs] [negative-ttl=secs]`
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] directive This is PersistenceCache.
+ * @param[in] vars Parameters.
+ * @param[in] cbdata A @ref persist_cfg_t.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On a missing or unparsable parameter.
+ * - Other on failure to enable the cache.
+ */
+static ib_status_t persistence_cache_fn(
+    ib_cfgparser_t  *cp,
+    const char      *directive,
+    const ib_list_t *vars,
+    void            *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(directive != NULL);
+    assert(vars != NULL);
+    assert(cbdata != NULL);
+
+    persist_cfg_t        *cfg          = (persist_cfg_t *)cbdata;
+    const ib_list_node_t *node;
+    ib_num_t              max_entries;
+    ib_num_t              ttl          = 30;
+    ib_num_t              negative_ttl = 10;
+    ib_status_t           rc;
+
+    node = ib_list_first_const(vars);
+    if (node == NULL) {
+        ib_cfg_log_error(cp, "Cache size missing.");
+        return IB_EINVAL;
+    }
+    rc = ib_type_atoi(
+        (const char *)ib_list_node_data_const(node), 10, &max_entries);
+    if (rc != IB_OK || max_entries <= 0) {
+        ib_cfg_log_error(cp, "Cache size must be a positive number.");
+        return IB_EINVAL;
+    }
+
+    node = ib_list_node_next_const(node);
+    for ( ; node != NULL; node = ib_list_node_next_const(node)) {
+        const char *config_str = (const char *)ib_list_node_data_const(node);
+        const char *tmp_str;
+
+        tmp_str = get_val("ttl=", config_str);
+        if (tmp_str != NULL) {
+            rc = ib_type_atoi(tmp_str, 10, &ttl);
+            if (rc != IB_OK || ttl < 0) {
+                ib_cfg_log_error(cp, "Failed to parse ttl value %s.", tmp_str);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        tmp_str = get_val("negative-ttl=", config_str);
+        if (tmp_str != NULL) {
+            rc = ib_type_atoi(tmp_str, 10, &negative_ttl);
+            if (rc != IB_OK || negative_ttl < 0) {
+                ib_cfg_log_error(
+                    cp,
+                    "Failed to parse negative-ttl value %s.",
+                    tmp_str);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        ib_cfg_log_warning(
+            cp,
+            "Unsupported configuration option for directive %s: %s",
+            directive,
+            config_str);
+    }
+
+    rc = ib_persist_fw_cache(
+        cfg->persist_fw,
+        max_entries,
+        ttl,
+        negative_ttl);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(cp, "Failed to enable persistence cache.");
+        return rc;
+    }
+
+    return IB_OK;
+}
+
 /**
  * Register directives so as to define a callback data struct.
  *
@@ -689,6 +897,34 @@ static ib_status_t register_directives(
         return rc;
     }
 
+    rc = ib_config_register_directive(
+        ib,
+        "PersistenceCache",
+        IB_DIRTYPE_LIST,
+        (ib_void_fn_t)persistence_cache_fn,
+        NULL,
+        cfg,
+        NULL,
+        NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_config_register_directive(
+        ib,
+        "PersistenceWriteBehind",
+        IB_DIRTYPE_ONOFF,
+        (ib_void_fn_t)persistence_write_behind_fn,
+        NULL,
+        cfg,
+        NULL,
+        NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     return IB_OK;
 }
 
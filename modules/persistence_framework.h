@@ -32,6 +32,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -193,6 +194,122 @@ ib_status_t DLL_PUBLIC ib_persist_fw_map_collection(
     const char      *store
 );
 
+/**
+ * Switch this framework instance to write-behind storing.
+ *
+ * In write-behind mode the transaction path does not call store
+ * callbacks. Instead, the collection is copied off the transaction
+ * and enqueued, and a background flush thread calls the store
+ * callbacks. A write enqueued while an earlier write to the same
+ * store and key is still pending replaces the pending write, so a hot
+ * key costs one store call per flush, not one per transaction.
+ *
+ * Store callbacks registered on an instance in write-behind mode are
+ * called with a NULL transaction and a list that lives only for the
+ * duration of the call; they must not touch the transaction.
+ *
+ * Pending writes are flushed before the stores are destroyed with the
+ * main context.
+ *
+ * @param[in] persist_fw The persistence instance.
+ *
+ * @returns
+ * - IB_OK On success, or if already in write-behind mode.
+ * - IB_EALLOC On allocation errors.
+ * - IB_EOTHER If the flush thread cannot be started.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_write_behind(
+    ib_persist_fw_t *persist_fw
+);
+
+/**
+ * Report write-behind metrics for this framework instance.
+ *
+ * The coalesce ratio is @a coalesced over @a enqueued: the fraction of
+ * accepted writes that were superseded by a newer write to the same
+ * key before they were flushed.
+ *
+ * @param[in] persist_fw The persistence instance.
+ * @param[out] enqueued Writes accepted by the queue. May be NULL.
+ * @param[out] coalesced Writes superseded before flushing. May be NULL.
+ * @param[out] flush_lag Age, in useconds, of the oldest entry in the
+ *             most recently flushed batch. May be NULL.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If the instance is not in write-behind mode.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_write_behind_metrics(
+    ib_persist_fw_t *persist_fw,
+    uint64_t        *enqueued,
+    uint64_t        *coalesced,
+    ib_time_t       *flush_lag
+);
+
+/**
+ * Put a bounded LRU cache in front of this instance's load callbacks.
+ *
+ * A collection loaded or stored for a (store, key) pair is kept, and
+ * later loads of that pair within @a ttl are served from the copy
+ * without calling the backend. A load the backend fails is kept as a
+ * negative entry for @a negative_ttl, so repeated lookups of absent
+ * keys (for example, first-seen client IPs) skip the backend too.
+ * Stores refresh the cached copy, so cached data stays coherent with
+ * both synchronous and write-behind storing.
+ *
+ * When more than @a max_entries pairs are cached the least recently
+ * used entries are evicted. Each entry holds a deep copy of its
+ * collection plus fixed bookkeeping, so memory use is bounded by
+ * @a max_entries times the typical collection size.
+ *
+ * @param[in] persist_fw The persistence instance.
+ * @param[in] max_entries Maximum cached (store, key) pairs. Must not
+ *            be zero.
+ * @param[in] ttl Seconds a cached collection is served before the
+ *            backend is consulted again. Zero means entries expire
+ *            only by eviction.
+ * @param[in] negative_ttl Seconds an absent key is remembered. Zero
+ *            disables negative caching.
+ *
+ * @returns
+ * - IB_OK On success, or if caching is already enabled.
+ * - IB_EINVAL If @a max_entries is zero.
+ * - IB_EALLOC On allocation errors.
+ * - IB_EOTHER If the cache lock cannot be initialized.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_cache(
+    ib_persist_fw_t *persist_fw,
+    size_t           max_entries,
+    ib_time_t        ttl,
+    ib_time_t        negative_ttl
+);
+
+/**
+ * Report cache metrics for this framework instance.
+ *
+ * The hit ratio is @a hits plus @a negative_hits over all lookups:
+ * the fraction of loads that never reached the backend.
+ *
+ * @param[in] persist_fw The persistence instance.
+ * @param[out] hits Loads served from a cached collection. May be NULL.
+ * @param[out] negative_hits Loads served from a cached miss. May be
+ *             NULL.
+ * @param[out] misses Loads that called the backend. May be NULL.
+ * @param[out] evictions Entries evicted to respect the size bound.
+ *             May be NULL.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If caching is not enabled.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_cache_metrics(
+    ib_persist_fw_t *persist_fw,
+    uint64_t        *hits,
+    uint64_t        *negative_hits,
+    uint64_t        *misses,
+    uint64_t        *evictions
+);
+
 /**
  * @}
  */
@@ -24,13 +24,17 @@
 
 #include "persistence_framework_private.h"
 
+#include <ironbee/clock.h>
 #include <ironbee/context.h>
 #include <ironbee/engine.h>
 #include <ironbee/engine_state.h>
+#include <ironbee/mm_mpool_lite.h>
 #include <ironbee/module.h>
 #include <ironbee/string.h>
 
 #include <assert.h>
+#include <inttypes.h>
+#include <string.h>
 
 ib_status_t ib_persist_fw_cfg_create(
     ib_mm_t               mm,
@@ -186,6 +190,825 @@ static ib_status_t add_module_config(
 }
 
 
+/**
+ * One write waiting to be flushed by the write-behind thread.
+ *
+ * All entry memory, including the entry itself, comes from the
+ * entry's memory pool, destroyed when the entry is flushed or
+ * discarded.
+ */
+typedef struct wb_entry_t {
+    ib_mpool_lite_t       *mp;           /**< Owns all entry memory. */
+    ib_persist_fw_store_t *store;        /**< The store to write to. */
+    const char            *key;          /**< Copy of the expanded key. */
+    size_t                 key_length;   /**< Length of wb_entry_t::key. */
+    ib_time_t              expiration;   /**< Record expiration in usec. */
+    const ib_list_t       *list;         /**< Copy of the collection. */
+    ib_time_t              enqueue_time; /**< Epoch usec at enqueue. */
+    bool                   superseded;   /**< Replaced by a newer write. */
+} wb_entry_t;
+
+/**
+ * Copy a collection off the transaction into @a mm.
+ *
+ * Fields are deep-copied, recursing into list fields, so the copy
+ * stays valid after the transaction is destroyed.
+ *
+ * @param[in] mm Memory manager the copy is allocated from.
+ * @param[in] src The collection to copy.
+ * @param[out] dst The copy.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other on field copy failures.
+ */
+static ib_status_t wb_copy_list(
+    ib_mm_t           mm,
+    const ib_list_t  *src,
+    ib_list_t       **dst
+)
+{
+    assert(src != NULL);
+    assert(dst != NULL);
+
+    ib_list_t            *out;
+    const ib_list_node_t *node;
+    ib_status_t           rc;
+
+    rc = ib_list_create(&out, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    IB_LIST_LOOP_CONST(src, node) {
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+        ib_field_t *field_copy;
+
+        if (field->type == IB_FTYPE_LIST) {
+            /* ib_field_copy() aliases list values. Copy the elements. */
+            const ib_list_t *sub      = NULL;
+            ib_list_t       *sub_copy = NULL;
+
+            rc = ib_field_value(field, ib_ftype_list_out(&sub));
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = wb_copy_list(mm, sub, &sub_copy);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_field_create(
+                &field_copy,
+                mm,
+                field->name, field->nlen,
+                IB_FTYPE_LIST,
+                ib_ftype_list_in(sub_copy));
+        }
+        else {
+            rc = ib_field_copy(
+                &field_copy,
+                mm,
+                field->name, field->nlen,
+                field);
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = ib_list_push(out, field_copy);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *dst = out;
+    return IB_OK;
+}
+
+/**
+ * Enqueue a write for the flush thread, never blocking on the store.
+ *
+ * If a write to the same store and key is already pending it is marked
+ * superseded and the flusher discards it unwritten, so repeated writes
+ * to a hot key coalesce into the newest one.
+ *
+ * @param[in] persist_fw The framework instance. Must be in
+ *            write-behind mode.
+ * @param[in] store The store to write to.
+ * @param[in] key The expanded key. Copied.
+ * @param[in] key_length Length of @a key.
+ * @param[in] expiration Record expiration in useconds.
+ * @param[in] list The collection to store. Deep-copied.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other on copy failures.
+ */
+static ib_status_t wb_enqueue(
+    ib_persist_fw_t       *persist_fw,
+    ib_persist_fw_store_t *store,
+    const char            *key,
+    size_t                 key_length,
+    ib_time_t              expiration,
+    const ib_list_t       *list
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->wb != NULL);
+    assert(store != NULL);
+    assert(key != NULL);
+    assert(list != NULL);
+
+    ib_persist_fw_wb_t *wb = persist_fw->wb;
+    ib_mpool_lite_t    *mp;
+    ib_mm_t             mm;
+    wb_entry_t         *entry;
+    ib_list_t          *list_copy = NULL;
+    ib_timeval_t        tv;
+    ib_status_t         rc;
+    size_t              pending;
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    entry = (wb_entry_t *)ib_mm_calloc(mm, 1, sizeof(*entry));
+    if (entry == NULL) {
+        rc = IB_EALLOC;
+        goto fail;
+    }
+
+    entry->key = (const char *)ib_mm_memdup(mm, key, key_length);
+    if (entry->key == NULL) {
+        rc = IB_EALLOC;
+        goto fail;
+    }
+
+    rc = wb_copy_list(mm, list, &list_copy);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    ib_clock_gettimeofday(&tv);
+
+    entry->mp           = mp;
+    entry->store        = store;
+    entry->key_length   = key_length;
+    entry->expiration   = expiration;
+    entry->list         = list_copy;
+    entry->enqueue_time = IB_CLOCK_TIMEVAL_TIME(tv);
+    entry->superseded   = false;
+
+    pthread_mutex_lock(&wb->lock);
+
+    /* Coalesce: supersede a pending write to the same store and key. */
+    pending = ib_queue_size(wb->pending);
+    for (size_t i = 0; i < pending; ++i) {
+        wb_entry_t *other = NULL;
+
+        if (ib_queue_get(wb->pending, i, &other) != IB_OK) {
+            break;
+        }
+        if (
+            ! other->superseded &&
+            other->store == store &&
+            other->key_length == key_length &&
+            memcmp(other->key, key, key_length) == 0
+        ) {
+            other->superseded = true;
+            ++wb->coalesced;
+            break;
+        }
+    }
+
+    rc = ib_queue_push_back(wb->pending, entry);
+    if (rc != IB_OK) {
+        pthread_mutex_unlock(&wb->lock);
+        goto fail;
+    }
+    ++wb->enqueued;
+
+    pthread_cond_signal(&wb->cond);
+    pthread_mutex_unlock(&wb->lock);
+
+    return IB_OK;
+
+fail:
+    ib_mpool_lite_destroy(mp);
+    return rc;
+}
+
+/**
+ * The write-behind flush thread.
+ *
+ * Drains the pending queue, calling store callbacks with a NULL
+ * transaction, until ib_persist_fw_wb_t::running is cleared and the
+ * queue is empty.
+ *
+ * @param[in] arg The @ref ib_persist_fw_t this thread flushes for.
+ *
+ * @returns NULL.
+ */
+static void *wb_flusher(void *arg)
+{
+    assert(arg != NULL);
+
+    ib_persist_fw_t    *persist_fw = (ib_persist_fw_t *)arg;
+    ib_persist_fw_wb_t *wb         = persist_fw->wb;
+
+    pthread_mutex_lock(&wb->lock);
+    for (;;) {
+        wb_entry_t *entry     = NULL;
+        ib_time_t   batch_lag = 0;
+        size_t      flushed   = 0;
+
+        while (wb->running && ib_queue_size(wb->pending) == 0) {
+            pthread_cond_wait(&wb->cond, &wb->lock);
+        }
+        if (ib_queue_size(wb->pending) == 0) {
+            /* Stopped and drained. */
+            break;
+        }
+
+        while (ib_queue_pop_front(wb->pending, &entry) == IB_OK) {
+            if (entry->superseded) {
+                ib_mpool_lite_destroy(entry->mp);
+                continue;
+            }
+
+            if (flushed == 0) {
+                ib_timeval_t tv;
+
+                ib_clock_gettimeofday(&tv);
+                batch_lag = IB_CLOCK_TIMEVAL_TIME(tv) - entry->enqueue_time;
+            }
+
+            /* Call the store outside the lock; enqueuers never wait
+             * on store latency. */
+            pthread_mutex_unlock(&wb->lock);
+            if (
+                entry->store->handler != NULL &&
+                entry->store->handler->store_fn != NULL
+            ) {
+                ib_status_t rc = entry->store->handler->store_fn(
+                    entry->store->impl,
+                    NULL,
+                    entry->key, entry->key_length,
+                    entry->expiration,
+                    entry->list,
+                    entry->store->handler->store_data);
+                if (rc != IB_OK) {
+                    ib_log_error(
+                        persist_fw->ib,
+                        "Write-behind store to %s failed: %s",
+                        entry->store->name,
+                        ib_status_to_string(rc));
+                }
+            }
+            ib_mpool_lite_destroy(entry->mp);
+            pthread_mutex_lock(&wb->lock);
+            ++flushed;
+        }
+
+        if (flushed > 0) {
+            wb->flush_lag = batch_lag;
+            ib_log_debug(
+                persist_fw->ib,
+                "Write-behind flushed %zu entries: "
+                "lag=%" PRIu64 "usec enqueued=%" PRIu64 " coalesced=%" PRIu64,
+                flushed,
+                batch_lag,
+                wb->enqueued,
+                wb->coalesced);
+        }
+    }
+    pthread_mutex_unlock(&wb->lock);
+
+    return NULL;
+}
+
+/**
+ * Drain the pending queue and join the flush thread.
+ *
+ * Called before the stores the flusher writes to are destroyed.
+ * A no-op if @a persist_fw is not in write-behind mode.
+ *
+ * @param[in] persist_fw The framework instance.
+ */
+static void wb_stop(ib_persist_fw_t *persist_fw)
+{
+    assert(persist_fw != NULL);
+
+    ib_persist_fw_wb_t *wb = persist_fw->wb;
+
+    if (wb == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&wb->lock);
+    wb->running = false;
+    pthread_cond_signal(&wb->cond);
+    pthread_mutex_unlock(&wb->lock);
+
+    pthread_join(wb->thread, NULL);
+
+    persist_fw->wb = NULL;
+}
+
+ib_status_t ib_persist_fw_write_behind(
+    ib_persist_fw_t *persist_fw
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->ib != NULL);
+
+    ib_mm_t             mm = ib_engine_mm_main_get(persist_fw->ib);
+    ib_persist_fw_wb_t *wb;
+    ib_status_t         rc;
+
+    if (persist_fw->wb != NULL) {
+        return IB_OK;
+    }
+
+    wb = (ib_persist_fw_wb_t *)ib_mm_calloc(mm, 1, sizeof(*wb));
+    if (wb == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_queue_create(&wb->pending, mm, IB_QUEUE_NONE);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (
+        pthread_mutex_init(&wb->lock, NULL) != 0 ||
+        pthread_cond_init(&wb->cond, NULL) != 0
+    ) {
+        return IB_EOTHER;
+    }
+
+    wb->running    = true;
+    persist_fw->wb = wb;
+
+    if (pthread_create(&wb->thread, NULL, wb_flusher, persist_fw) != 0) {
+        persist_fw->wb = NULL;
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_persist_fw_write_behind_metrics(
+    ib_persist_fw_t *persist_fw,
+    uint64_t        *enqueued,
+    uint64_t        *coalesced,
+    ib_time_t       *flush_lag
+)
+{
+    assert(persist_fw != NULL);
+
+    ib_persist_fw_wb_t *wb = persist_fw->wb;
+
+    if (wb == NULL) {
+        return IB_ENOENT;
+    }
+
+    pthread_mutex_lock(&wb->lock);
+    if (enqueued != NULL) {
+        *enqueued = wb->enqueued;
+    }
+    if (coalesced != NULL) {
+        *coalesced = wb->coalesced;
+    }
+    if (flush_lag != NULL) {
+        *flush_lag = wb->flush_lag;
+    }
+    pthread_mutex_unlock(&wb->lock);
+
+    return IB_OK;
+}
+
+/**
+ * One cached collection, owned by its own memory pool.
+ *
+ * The hash key is the store pointer followed by the expanded key, so
+ * identical keys in different stores do not collide. An entry with a
+ * NULL list is a negative entry: the backend reported the key absent.
+ */
+struct ib_persist_fw_cache_entry_t {
+    ib_mpool_lite_t *mp;             /**< Owns all entry memory. */
+    const char      *hashkey;        /**< Store pointer + expanded key. */
+    size_t           hashkey_length; /**< Length of hashkey. */
+    ib_time_t        expires;        /**< Epoch usec. 0 = only evicted. */
+    const ib_list_t *list;           /**< Collection, or NULL if negative. */
+
+    ib_persist_fw_cache_entry_t *newer; /**< Toward the LRU head. */
+    ib_persist_fw_cache_entry_t *older; /**< Toward the LRU tail. */
+};
+
+/**
+ * Remove @a entry from the LRU list. The caller holds the cache lock.
+ */
+static void cache_unlink(
+    ib_persist_fw_cache_t       *cache,
+    ib_persist_fw_cache_entry_t *entry
+)
+{
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    }
+    else {
+        cache->lru_head = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    }
+    else {
+        cache->lru_tail = entry->newer;
+    }
+    entry->newer = entry->older = NULL;
+}
+
+/**
+ * Make @a entry the most recently used. The caller holds the cache lock.
+ */
+static void cache_push_head(
+    ib_persist_fw_cache_t       *cache,
+    ib_persist_fw_cache_entry_t *entry
+)
+{
+    entry->newer = NULL;
+    entry->older = cache->lru_head;
+    if (cache->lru_head != NULL) {
+        cache->lru_head->newer = entry;
+    }
+    cache->lru_head = entry;
+    if (cache->lru_tail == NULL) {
+        cache->lru_tail = entry;
+    }
+}
+
+/**
+ * Remove @a entry from the index and LRU list and destroy it.
+ *
+ * The entry owns its hash key bytes, so it is removed from the index
+ * before its pool is destroyed. The caller holds the cache lock.
+ */
+static void cache_drop(
+    ib_persist_fw_cache_t       *cache,
+    ib_persist_fw_cache_entry_t *entry
+)
+{
+    ib_hash_remove_ex(
+        cache->index,
+        NULL,
+        entry->hashkey,
+        entry->hashkey_length);
+    cache_unlink(cache, entry);
+    --cache->size;
+    ib_mpool_lite_destroy(entry->mp);
+}
+
+/**
+ * Epoch time in useconds.
+ */
+static ib_time_t cache_now(void)
+{
+    ib_timeval_t tv;
+
+    ib_clock_gettimeofday(&tv);
+    return IB_CLOCK_TIMEVAL_TIME(tv);
+}
+
+/**
+ * Serve a load from the cache if (store, key) has a live entry.
+ *
+ * On a positive hit the cached collection is deep-copied into
+ * @a list. On a negative hit @a list is left as-is; the backend
+ * previously reported this key absent. Both are IB_OK to the caller:
+ * do not call the backend.
+ *
+ * @param[in] persist_fw The framework instance. Must have a cache.
+ * @param[in] store The store the load targets.
+ * @param[in] key The expanded key.
+ * @param[in] key_length Length of @a key.
+ * @param[in] mm Memory manager copies for @a list are made from.
+ * @param[out] list Hit collections are appended to this.
+ *
+ * @returns
+ * - IB_OK On a positive or negative hit.
+ * - IB_ENOENT On a miss; the caller should load from the backend.
+ * - IB_EALLOC On allocation errors.
+ */
+static ib_status_t cache_get(
+    ib_persist_fw_t             *persist_fw,
+    const ib_persist_fw_store_t *store,
+    const char                  *key,
+    size_t                       key_length,
+    ib_mm_t                      mm,
+    ib_list_t                   *list
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->cache != NULL);
+    assert(store != NULL);
+    assert(key != NULL);
+    assert(list != NULL);
+
+    ib_persist_fw_cache_t       *cache = persist_fw->cache;
+    ib_persist_fw_cache_entry_t *entry = NULL;
+    char                        *hashkey;
+    size_t                       hashkey_length;
+    ib_status_t                  rc;
+
+    hashkey_length = sizeof(store) + key_length;
+    hashkey = (char *)ib_mm_alloc(mm, hashkey_length);
+    if (hashkey == NULL) {
+        return IB_EALLOC;
+    }
+    memcpy(hashkey, &store, sizeof(store));
+    memcpy(hashkey + sizeof(store), key, key_length);
+
+    pthread_mutex_lock(&cache->lock);
+
+    rc = ib_hash_get_ex(cache->index, &entry, hashkey, hashkey_length);
+    if (rc != IB_OK) {
+        ++cache->misses;
+        pthread_mutex_unlock(&cache->lock);
+        return IB_ENOENT;
+    }
+
+    if (entry->expires != 0 && entry->expires <= cache_now()) {
+        cache_drop(cache, entry);
+        ++cache->misses;
+        pthread_mutex_unlock(&cache->lock);
+        return IB_ENOENT;
+    }
+
+    cache_unlink(cache, entry);
+    cache_push_head(cache, entry);
+
+    if (entry->list == NULL) {
+        ++cache->negative_hits;
+        pthread_mutex_unlock(&cache->lock);
+        return IB_OK;
+    }
+
+    /* Copy out under the lock; eviction may destroy the entry the
+     * moment the lock is released. */
+    {
+        ib_list_t            *copy = NULL;
+        const ib_list_node_t *node;
+
+        rc = wb_copy_list(mm, entry->list, &copy);
+        if (rc == IB_OK) {
+            IB_LIST_LOOP_CONST(copy, node) {
+                rc = ib_list_push(list, (void *)ib_list_node_data_const(node));
+                if (rc != IB_OK) {
+                    break;
+                }
+            }
+        }
+    }
+    if (rc != IB_OK) {
+        pthread_mutex_unlock(&cache->lock);
+        return rc;
+    }
+
+    ++cache->hits;
+    pthread_mutex_unlock(&cache->lock);
+    return IB_OK;
+}
+
+/**
+ * Cache a collection, or the backend's report that @a key is absent.
+ *
+ * Replaces any existing entry for (store, key) and evicts the least
+ * recently used entries past the size bound.
+ *
+ * @param[in] persist_fw The framework instance. Must have a cache.
+ * @param[in] store The store the collection belongs to.
+ * @param[in] key The expanded key. Copied.
+ * @param[in] key_length Length of @a key.
+ * @param[in] list The collection to cache. Deep-copied. NULL caches a
+ *            negative entry, which is a no-op when negative caching
+ *            is disabled.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other on copy failures.
+ */
+static ib_status_t cache_put(
+    ib_persist_fw_t             *persist_fw,
+    const ib_persist_fw_store_t *store,
+    const char                  *key,
+    size_t                       key_length,
+    const ib_list_t             *list
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->cache != NULL);
+    assert(store != NULL);
+    assert(key != NULL);
+
+    ib_persist_fw_cache_t       *cache = persist_fw->cache;
+    ib_persist_fw_cache_entry_t *entry;
+    ib_persist_fw_cache_entry_t *old   = NULL;
+    ib_mpool_lite_t             *mp;
+    ib_mm_t                      mm;
+    char                        *hashkey;
+    ib_time_t                    ttl;
+    ib_status_t                  rc;
+
+    ttl = (list == NULL) ? cache->negative_ttl : cache->ttl;
+    if (list == NULL && ttl == 0) {
+        /* Negative caching is disabled. */
+        return IB_OK;
+    }
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    entry = (ib_persist_fw_cache_entry_t *)
+        ib_mm_calloc(mm, 1, sizeof(*entry));
+    if (entry == NULL) {
+        rc = IB_EALLOC;
+        goto fail;
+    }
+
+    entry->hashkey_length = sizeof(store) + key_length;
+    hashkey = (char *)ib_mm_alloc(mm, entry->hashkey_length);
+    if (hashkey == NULL) {
+        rc = IB_EALLOC;
+        goto fail;
+    }
+    memcpy(hashkey, &store, sizeof(store));
+    memcpy(hashkey + sizeof(store), key, key_length);
+    entry->hashkey = hashkey;
+
+    if (list != NULL) {
+        ib_list_t *copy = NULL;
+
+        rc = wb_copy_list(mm, list, &copy);
+        if (rc != IB_OK) {
+            goto fail;
+        }
+        entry->list = copy;
+    }
+
+    entry->mp      = mp;
+    entry->expires = (ttl == 0) ? 0 : cache_now() + ttl;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (
+        ib_hash_get_ex(
+            cache->index,
+            &old,
+            entry->hashkey,
+            entry->hashkey_length) == IB_OK
+    ) {
+        cache_drop(cache, old);
+    }
+
+    rc = ib_hash_set_ex(
+        cache->index,
+        entry->hashkey,
+        entry->hashkey_length,
+        entry);
+    if (rc != IB_OK) {
+        pthread_mutex_unlock(&cache->lock);
+        goto fail;
+    }
+    cache_push_head(cache, entry);
+    ++cache->size;
+
+    while (cache->size > cache->max_entries && cache->lru_tail != NULL) {
+        cache_drop(cache, cache->lru_tail);
+        ++cache->evictions;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return IB_OK;
+
+fail:
+    ib_mpool_lite_destroy(mp);
+    return rc;
+}
+
+/**
+ * Destroy all cache entries and the cache lock.
+ *
+ * Called when the main context, and so the stores, are destroyed.
+ * A no-op if @a persist_fw has no cache.
+ *
+ * @param[in] persist_fw The framework instance.
+ */
+static void cache_stop(ib_persist_fw_t *persist_fw)
+{
+    assert(persist_fw != NULL);
+
+    ib_persist_fw_cache_t *cache = persist_fw->cache;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    while (cache->lru_head != NULL) {
+        cache_drop(cache, cache->lru_head);
+    }
+    pthread_mutex_destroy(&cache->lock);
+
+    persist_fw->cache = NULL;
+}
+
+ib_status_t ib_persist_fw_cache(
+    ib_persist_fw_t *persist_fw,
+    size_t           max_entries,
+    ib_time_t        ttl,
+    ib_time_t        negative_ttl
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->ib != NULL);
+
+    ib_mm_t                mm = ib_engine_mm_main_get(persist_fw->ib);
+    ib_persist_fw_cache_t *cache;
+    ib_status_t            rc;
+
+    if (persist_fw->cache != NULL) {
+        return IB_OK;
+    }
+    if (max_entries == 0) {
+        return IB_EINVAL;
+    }
+
+    cache = (ib_persist_fw_cache_t *)ib_mm_calloc(mm, 1, sizeof(*cache));
+    if (cache == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_hash_create(&cache->index, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        return IB_EOTHER;
+    }
+
+    cache->max_entries  = max_entries;
+    cache->ttl          = ttl * 1000000;
+    cache->negative_ttl = negative_ttl * 1000000;
+
+    persist_fw->cache = cache;
+
+    return IB_OK;
+}
+
+ib_status_t ib_persist_fw_cache_metrics(
+    ib_persist_fw_t *persist_fw,
+    uint64_t        *hits,
+    uint64_t        *negative_hits,
+    uint64_t        *misses,
+    uint64_t        *evictions
+)
+{
+    assert(persist_fw != NULL);
+
+    ib_persist_fw_cache_t *cache = persist_fw->cache;
+
+    if (cache == NULL) {
+        return IB_ENOENT;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    if (hits != NULL) {
+        *hits = cache->hits;
+    }
+    if (negative_hits != NULL) {
+        *negative_hits = cache->negative_hits;
+    }
+    if (misses != NULL) {
+        *misses = cache->misses;
+    }
+    if (evictions != NULL) {
+        *evictions = cache->evictions;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return IB_OK;
+}
+
 /**
  * When a context is selected, populate the transaction from the handlers.
  *
@@ -280,6 +1103,19 @@ ib_status_t populate_data_in_context(
                 continue;
             }
 
+            /* A cache hit, positive or negative, skips the backend. */
+            if (persist_fw->cache != NULL) {
+                rc = cache_get(
+                    persist_fw,
+                    store,
+                    key, key_length,
+                    tx->mm,
+                    list);
+                if (rc == IB_OK) {
+                    continue;
+                }
+            }
+
             rc = store->handler->load_fn(
                 store->impl,
                 tx,
@@ -289,6 +1125,15 @@ ib_status_t populate_data_in_context(
             if (rc != IB_OK) {
                 ib_log_debug(ib, "Failed to load collection %s", name);
             }
+
+            /* Cache what the backend said, including "not there". */
+            if (persist_fw->cache != NULL) {
+                cache_put(
+                    persist_fw,
+                    store,
+                    key, key_length,
+                    (rc == IB_OK) ? list : NULL);
+            }
         }
     }
 
@@ -380,6 +1225,29 @@ ib_status_t persist_data_in_context(
                 continue;
             }
 
+            /* Refresh the cache so reads of this key stay coherent
+             * with the write, synchronous or write-behind. */
+            if (persist_fw->cache != NULL) {
+                cache_put(persist_fw, store, key, key_length, list);
+            }
+
+            /* In write-behind mode, hand off to the flush thread
+             * rather than paying store latency in the transaction. */
+            if (persist_fw->wb != NULL) {
+                rc = wb_enqueue(
+                    persist_fw,
+                    store,
+                    key, key_length, mapping->expiration,
+                    list);
+                if (rc != IB_OK) {
+                    ib_log_error(
+                        ib,
+                        "Failed to enqueue collection %s for write-behind.",
+                        name);
+                }
+                continue;
+            }
+
             rc = store->handler->store_fn(
                 store->impl,
                 tx,
@@ -429,6 +1297,13 @@ ib_status_t destroy_stores(
         return IB_EALLOC;
     }
 
+    /* The flush thread writes to the stores destroyed below. Drain
+     * and stop it before the main context's stores go away. */
+    if (ctx == ib_context_main(ib)) {
+        wb_stop(persist_fw);
+        cache_stop(persist_fw);
+    }
+
     rc = get_ctx_persist_fw(persist_fw, ctx, &persist_fw_cfg);
     if (rc != IB_OK) {
         return IB_OK;
@@ -681,6 +1556,8 @@ ib_status_t ib_persist_fw_create(
 
     persist_fw_out->ib          = ib;
     persist_fw_out->user_module = user_module;
+    persist_fw_out->wb          = NULL;
+    persist_fw_out->cache       = NULL;
 
     /* Assign persist_fw_out->persist_fw_module. */
     rc = ib_engine_module_get(
@@ -36,9 +36,12 @@
 #include <ironbee/field.h>
 #include <ironbee/hash.h>
 #include <ironbee/module.h>
+#include <ironbee/queue.h>
 
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -113,6 +116,82 @@ struct ib_persist_fw_mapping_t {
 };
 typedef struct ib_persist_fw_mapping_t ib_persist_fw_mapping_t;
 
+/**
+ * Write-behind state for one framework instance.
+ *
+ * Stores are enqueued here at postprocess and written by a background
+ * flush thread, so the transaction path never blocks on a store.
+ * Entries for a key that is already pending supersede the pending
+ * entry, and the flusher discards superseded entries unwritten.
+ */
+struct ib_persist_fw_wb_t {
+    pthread_mutex_t  lock;    /**< Guards all fields below. */
+    pthread_cond_t   cond;    /**< Signaled when work is enqueued. */
+    pthread_t        thread;  /**< The flush thread. */
+    bool             running; /**< Cleared to stop the flush thread. */
+
+    /**
+     * FIFO of pending writes, including superseded entries.
+     *
+     * Elements are write entries owning their own memory pool. A new
+     * write scans this queue for a pending entry with the same store
+     * and key and marks it superseded; the flusher discards such
+     * entries unwritten.
+     */
+    ib_queue_t      *pending;
+
+    uint64_t         enqueued;  /**< Writes accepted. */
+    uint64_t         coalesced; /**< Writes superseded before flushing. */
+
+    /**
+     * Age, in useconds, of the oldest entry in the last flushed batch.
+     */
+    ib_time_t        flush_lag;
+};
+typedef struct ib_persist_fw_wb_t ib_persist_fw_wb_t;
+
+/**
+ * One cached collection. Defined in persistence_framework_api.c.
+ */
+typedef struct ib_persist_fw_cache_entry_t ib_persist_fw_cache_entry_t;
+
+/**
+ * A bounded LRU cache of loaded collections for one framework instance.
+ *
+ * Collections are cached by (store, key) when loaded or stored, so
+ * back-to-back transactions for the same key are served without
+ * calling the backend. Keys the backend reported absent are cached as
+ * negative entries so repeated misses do not call through either.
+ * Stores update the cached copy, keeping it coherent in both
+ * write-through and write-behind modes.
+ */
+struct ib_persist_fw_cache_t {
+    pthread_mutex_t lock; /**< Guards all fields below. */
+
+    /**
+     * Index of entries by store pointer and expanded key.
+     *
+     * Values are @ref ib_persist_fw_cache_entry_t. Each entry owns its
+     * hash key bytes, so entries are always removed from this hash
+     * before they are destroyed.
+     */
+    ib_hash_t *index;
+
+    size_t max_entries;  /**< Entries past this are evicted, oldest first. */
+    size_t size;         /**< Current entry count. */
+    ib_time_t ttl;       /**< Positive entry lifetime in usec. 0 = forever. */
+    ib_time_t negative_ttl; /**< Negative entry lifetime in usec. 0 = off. */
+
+    ib_persist_fw_cache_entry_t *lru_head; /**< Most recently used. */
+    ib_persist_fw_cache_entry_t *lru_tail; /**< Least recently used. */
+
+    uint64_t hits;          /**< Lookups served from a positive entry. */
+    uint64_t negative_hits; /**< Lookups served from a negative entry. */
+    uint64_t misses;        /**< Lookups that went to the backend. */
+    uint64_t evictions;     /**< Entries evicted to respect the bound. */
+};
+typedef struct ib_persist_fw_cache_t ib_persist_fw_cache_t;
+
 /**
  * Persistence framework structure given to a user module.
  *
@@ -123,6 +202,20 @@ struct ib_persist_fw_t {
     ib_engine_t *ib;                /**< The engine registered to. */
     ib_module_t *persist_fw_module; /**< The persistence framework's module. */
     ib_module_t *user_module;       /**< User's module structure. */
+
+    /**
+     * Write-behind state, or NULL when stores are written synchronously.
+     *
+     * @sa ib_persist_fw_write_behind().
+     */
+    ib_persist_fw_wb_t *wb;
+
+    /**
+     * Collection cache, or NULL when every load calls the backend.
+     *
+     * @sa ib_persist_fw_cache().
+     */
+    ib_persist_fw_cache_t *cache;
 };
 
 /**
@@ -46,6 +46,7 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <cstring>
 #include <string>
 
 using namespace IronBee;
@@ -143,6 +144,17 @@ ConstField ReplaceComments::operator()(
         return field_in;
     }
 
+    /* Fast passthrough: comments in any supported dialect must contain
+     * '/', '-', or '#'.  Most values are clean, so a memchr scan avoids
+     * running the parser (and its output allocation) entirely. */
+    if (
+        memchr(first, '/', last - first) == NULL &&
+        memchr(first, '-', last - first) == NULL &&
+        memchr(first, '#', last - first) == NULL
+    )
+    {
+        return field_in;
+    }
 
     /* Parse a single comment. */
     parse_success = qi::phrase_parse(
@@ -27,6 +27,8 @@
  * @author Brian Rectanus <brectanus@qualys.com>
  */
 
+#include <ironbee/hash.h>
+#include <ironbee/metrics.h>
 #include <ironbee/mm.h>
 #include <ironbee/module.h>
 #include <ironbee/transformation.h>
@@ -35,6 +37,8 @@
 #include <sqltfn.h>
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* Define the module name as well as a string version of it. */
 #define MODULE_NAME        sqltfn
@@ -44,6 +48,91 @@
 IB_MODULE_DECLARE();
 
 
+/*********************************
+ * Normalization cache
+ *********************************/
+
+/** Number of slots in the per-thread normalization cache. */
+#define SQLTFN_CACHE_SLOTS 256
+
+/** Largest input cached; longer values are always re-normalized. */
+#define SQLTFN_CACHE_MAX_LEN 1024
+
+/**
+ * One cache slot: malloc'd copies of an input and its normalization.
+ *
+ * The cache is direct mapped and per thread: API traffic repeats the
+ * same query fragments constantly, and a bounded overwrite-on-collision
+ * table captures those repeats without locking or eviction bookkeeping.
+ * Worst-case memory is SQLTFN_CACHE_SLOTS * 2 * SQLTFN_CACHE_MAX_LEN
+ * bytes per thread.
+ */
+typedef struct {
+    uint8_t *in;      /**< Input bytes, or NULL if the slot is empty. */
+    size_t   in_len;  /**< Length of in. */
+    uint8_t *out;     /**< Normalized bytes. */
+    size_t   out_len; /**< Length of out. */
+} sqltfn_cache_slot_t;
+
+/** Per-thread normalization cache. */
+static __thread sqltfn_cache_slot_t s_cache[SQLTFN_CACHE_SLOTS];
+
+/**
+ * Find the cache slot for an input.
+ *
+ * @param[in] data Input bytes.
+ * @param[in] len Length of @a data.
+ *
+ * @returns The slot @a data hashes to.
+ */
+static sqltfn_cache_slot_t *sqltfn_cache_slot(const uint8_t *data, size_t len)
+{
+    uint32_t h = ib_hashfunc_djb2((const char *)data, len, 0, NULL);
+    return &s_cache[h % SQLTFN_CACHE_SLOTS];
+}
+
+/**
+ * Store a normalization result in its cache slot, best effort.
+ *
+ * @param[in] in Input bytes.
+ * @param[in] in_len Length of @a in.
+ * @param[in] out Normalized bytes.
+ * @param[in] out_len Length of @a out.
+ */
+static void sqltfn_cache_store(
+    const uint8_t *in,
+    size_t         in_len,
+    const uint8_t *out,
+    size_t         out_len
+)
+{
+    sqltfn_cache_slot_t *slot;
+    uint8_t *in_copy;
+    uint8_t *out_copy;
+
+    if (in_len > SQLTFN_CACHE_MAX_LEN) {
+        return;
+    }
+
+    in_copy = malloc(in_len);
+    out_copy = malloc(out_len);
+    if (in_copy == NULL || out_copy == NULL) {
+        free(in_copy);
+        free(out_copy);
+        return;
+    }
+    memcpy(in_copy, in, in_len);
+    memcpy(out_copy, out, out_len);
+
+    slot = sqltfn_cache_slot(in, in_len);
+    free(slot->in);
+    free(slot->out);
+    slot->in      = in_copy;
+    slot->in_len  = in_len;
+    slot->out     = out_copy;
+    slot->out_len = out_len;
+}
+
 /*********************************
  * Transformations
  *********************************/
@@ -90,6 +179,53 @@ ib_status_t sqltfn_normalize_pg_tfn(
         return IB_OK;
     }
 
+    /* Repeated identical fragments hit the per-thread cache and skip
+     * the parser; only novel inputs are normalized below. */
+    {
+        sqltfn_cache_slot_t *slot = sqltfn_cache_slot(
+            ib_bytestr_const_ptr(bs_in), ib_bytestr_length(bs_in));
+        if (   slot->in != NULL
+            && slot->in_len == ib_bytestr_length(bs_in)
+            && memcmp(slot->in,
+                      ib_bytestr_const_ptr(bs_in), slot->in_len) == 0)
+        {
+            uint8_t *cached_out = ib_mm_memdup(mm, slot->out, slot->out_len);
+            if (cached_out == NULL) {
+                return IB_EALLOC;
+            }
+            rc = ib_bytestr_alias_mem(&bs_out, mm, cached_out, slot->out_len);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_field_create(&field_new, mm,
+                                 field_in->name, field_in->nlen,
+                                 IB_FTYPE_BYTESTR,
+                                 ib_ftype_bytestr_mutable_in(bs_out));
+            if (rc != IB_OK) {
+                return rc;
+            }
+            {
+                static const ib_metric_t *metric = NULL;
+                if (metric == NULL) {
+                    metric = ib_metric_acquire(
+                        "sqltfn.cache.hit", IB_METRIC_COUNTER);
+                }
+                ib_metric_add(metric, 1);
+            }
+            *field_out = field_new;
+            return IB_OK;
+        }
+    }
+
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "sqltfn.cache.miss", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+
     /* Create a buffer for normalization. */
     buf_out = buf_out_end = (char *)ib_mm_alloc(mm, ib_bytestr_length(bs_in));
     if (buf_out == NULL) {
@@ -139,6 +275,11 @@ ib_status_t sqltfn_normalize_pg_tfn(
 
     /* Create the output field wrapping bs_out. */
     buf_out_len += lead_len;
+
+    sqltfn_cache_store(
+        ib_bytestr_const_ptr(bs_in), ib_bytestr_length(bs_in),
+        (const uint8_t *)buf_out, buf_out_len);
+
     rc = ib_bytestr_alias_mem(&bs_out, mm, (uint8_t *)buf_out, buf_out_len);
     if (rc != IB_OK) {
         return rc;
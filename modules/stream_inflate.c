@@ -28,8 +28,38 @@
 #include <ironbee/log.h>
 
 #include "stream_inflate_private.h"
+
+#include <ironbee/logevent.h>
+
+#include <stdlib.h>
 #include <zlib.h>
 
+/* Decompression-ratio guard. Output larger than
+ * INFLATE_MAX_RATIO * input + INFLATE_RATIO_GRACE aborts the stream.
+ * Legitimate text tops out well under 1000:1; zip bombs run orders of
+ * magnitude past it. The grace amount keeps tiny inputs from tripping
+ * the ratio before it is meaningful. */
+static const uint64_t INFLATE_MAX_RATIO   = 1000;
+static const uint64_t INFLATE_RATIO_GRACE = 1024 * 1024;
+
+/*! A pooled inflate state. */
+struct inflate_state_t {
+    z_stream                strm; /**< The zlib stream. */
+    struct inflate_state_t *next; /**< Next free state. */
+};
+typedef struct inflate_state_t inflate_state_t;
+
+/* Inflate states pooled per thread.
+ *
+ * inflateInit() allocates the inflate window and internal tables on
+ * every call. A transaction's create and destroy both run on the
+ * worker thread driving it, so finished states are parked here and
+ * revived with inflateReset(), which keeps those allocations.
+ * The pool's depth is bounded by the thread's peak number of live
+ * inflate processors.
+ */
+static __thread inflate_state_t *s_state_pool = NULL;
+
 //ib_stream_processor_create_fn
 ib_status_t create_inflate_processor(
     void    *instance_data,
@@ -37,24 +67,36 @@ ib_status_t create_inflate_processor(
     void    *cbdata
 )
 {
-  z_stream *strm;
+  inflate_state_t *state;
   int ret;
 
-  strm = (z_stream *) ib_mm_alloc(tx->mm, sizeof(z_stream));
-  if (strm == NULL) {
-    return IB_EALLOC;
+  if (s_state_pool != NULL) {
+    state = s_state_pool;
+    s_state_pool = state->next;
+    ret = inflateReset(&state->strm);
+    if (ret != Z_OK) {
+      free(state);
+      return IB_EOTHER;
+    }
   }
-  // Use default memory allocation routines.
-  strm->zalloc = Z_NULL;
-  strm->zfree = Z_NULL;
-  strm->opaque = Z_NULL;
-  strm->avail_in = 0;
-  strm->next_in = Z_NULL;
-  ret = inflateInit(strm);
-  if (ret != Z_OK) {
-    return IB_EOTHER;
+  else {
+    state = (inflate_state_t *) malloc(sizeof(*state));
+    if (state == NULL) {
+      return IB_EALLOC;
+    }
+    // Use default memory allocation routines.
+    state->strm.zalloc = Z_NULL;
+    state->strm.zfree = Z_NULL;
+    state->strm.opaque = Z_NULL;
+    state->strm.avail_in = 0;
+    state->strm.next_in = Z_NULL;
+    ret = inflateInit(&state->strm);
+    if (ret != Z_OK) {
+      free(state);
+      return IB_EOTHER;
+    }
   }
-  *(void **)instance_data = (void *)strm;
+  *(void **)instance_data = (void *)state;
   return IB_OK;
 }
 
@@ -63,7 +105,49 @@ void destroy_inflate_processor(
     void *cbdata
 )
 {
-    //NOOP
+    inflate_state_t *state = (inflate_state_t *)instance_data;
+
+    if (state == NULL) {
+        return;
+    }
+
+    /* Park the state for the next transaction on this thread. Any
+     * leftover error state is cleared by inflateReset() on reuse. */
+    state->next = s_state_pool;
+    s_state_pool = state;
+}
+
+/**
+ * Log an event against @a tx recording an excessive compression ratio.
+ *
+ * @param[in] tx The transaction.
+ * @param[in] strm The stream whose totals tripped the guard.
+ */
+static void log_ratio_event(
+    ib_tx_t        *tx,
+    const z_stream *strm
+)
+{
+    ib_logevent_t *event;
+    ib_status_t    rc;
+
+    rc = ib_logevent_create(
+        &event,
+        tx->mm,
+        "stream_inflate/ratio",
+        IB_LEVENT_TYPE_ALERT,
+        IB_LEVENT_ACTION_UNKNOWN,
+        100,
+        80,
+        "Decompression ratio guard: %lu bytes inflated to %lu.",
+        (unsigned long)strm->total_in,
+        (unsigned long)strm->total_out
+    );
+    if (rc != IB_OK) {
+        return;
+    }
+
+    (void)ib_logevent_add(tx, event);
 }
 
 //ib_stream_processor_execute_fn
@@ -75,7 +159,7 @@ ib_status_t execute_inflate_processor(
     void                *cbdata
 )
 {
-    z_stream *strm = (z_stream *) instance_data;
+    z_stream *strm = &((inflate_state_t *) instance_data)->strm;
     int ret;
     ib_status_t rc;
     ib_stream_io_data_t *stream_data;
@@ -108,12 +192,22 @@ ib_status_t execute_inflate_processor(
             ret = inflate(strm, Z_NO_FLUSH);
             if (ret == Z_DATA_ERROR || ret == Z_NEED_DICT) {
                 ib_stream_io_data_error(io_tx, IB_S2SL("Invalid compressed data"));
-                (void)inflateEnd(strm);
                 return IB_EOTHER;
             }
             else if (ret < 0) {
                 ib_stream_io_data_error(io_tx, IB_S2SL("Internal error inflating stream"));
-                (void)inflateEnd(strm);
+                return IB_EOTHER;
+            }
+
+            /* Stop zip bombs before they finish expanding. */
+            if (
+                (uint64_t)strm->total_out >
+                INFLATE_MAX_RATIO * (uint64_t)strm->total_in
+                    + INFLATE_RATIO_GRACE
+            )
+            {
+                log_ratio_event(tx, strm);
+                ib_stream_io_data_error(io_tx, IB_S2SL("Decompression ratio exceeded"));
                 return IB_EOTHER;
             }
 
@@ -143,9 +237,5 @@ ib_status_t execute_inflate_processor(
         ib_stream_io_data_unref(io_tx, stream_data);
     } while (ib_stream_io_data_depth(io_tx) > 0);
 
-    if (rc != IB_OK) {
-        (void)inflateEnd(strm);
-    }
-
     return rc;
 }
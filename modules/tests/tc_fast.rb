@@ -137,4 +137,58 @@ class TestFast < CLIPPTest::TestCase
     assert_no_issues
     assert_log_no_match /CLIPP ANNOUNCE: foobar/
   end
+
+  GENERATE_CONFIG = [
+    'LoadModule "ibmod_fast.so"',
+    'LoadModule "ibmod_pcre.so"',
+    'FastAutomataGenerate on'
+  ].join("\n")
+
+  def test_generate_match
+    clipp(
+      :input_hashes => [make_request('foobar')],
+      :config => GENERATE_CONFIG,
+      :default_site_config => <<-EOS
+        Rule REQUEST_URI_RAW @rx foobar id:1 phase:REQUEST_HEADER clipp_announce:generated_rule
+      EOS
+    )
+    assert_no_issues
+    assert_log_match /CLIPP ANNOUNCE: generated_rule/
+  end
+
+  def test_generate_no_match
+    clipp(
+      :input_hashes => [make_request('nothere')],
+      :config => GENERATE_CONFIG,
+      :default_site_config => <<-EOS
+        Rule REQUEST_URI_RAW @rx foobar id:1 phase:REQUEST_HEADER clipp_announce:generated_rule
+      EOS
+    )
+    assert_no_issues
+    assert_log_no_match /CLIPP ANNOUNCE: generated_rule/
+  end
+
+  def test_generate_case_insensitive
+    clipp(
+      :input_hashes => [make_request('FooBar')],
+      :config => GENERATE_CONFIG,
+      :default_site_config => <<-EOS
+        Rule REQUEST_URI_RAW @rx "(?i)foobar" id:1 phase:REQUEST_HEADER clipp_announce:ci_rule
+      EOS
+    )
+    assert_no_issues
+    assert_log_match /CLIPP ANNOUNCE: ci_rule/
+  end
+
+  def test_generate_declined_runs_normally
+    clipp(
+      :input_hashes => [make_request('barbaz')],
+      :config => GENERATE_CONFIG,
+      :default_site_config => <<-EOS
+        Rule REQUEST_URI_RAW @rx "foobar|barbaz" id:1 phase:REQUEST_HEADER clipp_announce:alternation_rule
+      EOS
+    )
+    assert_no_issues
+    assert_log_match /CLIPP ANNOUNCE: alternation_rule/
+  end
 end
@@ -125,3 +125,55 @@ TEST_F(PersistencePersistTest, LoadStore) {
     configureIronBeeByString(config.c_str());
     performTx();
 }
+
+TEST_F(PersistencePersistTest, CachedLoadStore) {
+    std::string config(
+        "LogLevel DEBUG\n"
+        "SensorId B9C1B52B-C24A-4309-B9F9-0EF4CD577A3E\n"
+        "SensorName UnitTesting\n"
+        "SensorHostname unit-testing.sensor.tld\n"
+        "LoadModule \"ibmod_rules.so\"\n"
+        "LoadModule \"ibmod_persistence_framework.so\"\n"
+        "LoadModule \"ibmod_persist.so\"\n"
+        "PersistenceCache 1000 ttl=30 negative-ttl=10\n"
+    );
+
+    config += "PersistenceStore ASTORE persist-fs://"+m_path.string()+"\n";
+    config +=
+        "PersistenceMap A ASTORE\n"
+        "<Site test-site>\n"
+        "   SiteId AAAABBBB-1111-2222-3333-000000000000\n"
+        "   Hostname *\n"
+        "   Rule ARGS @ne 1 phase:REQUEST id:a1 rev:1 setvar:A=1\n"
+        "   RuleEnable all\n"
+        "</Site>\n"
+    ;
+    configureIronBeeByString(config.c_str());
+    performTx();
+}
+
+TEST_F(PersistencePersistTest, WriteBehindLoadStore) {
+    std::string config(
+        "LogLevel DEBUG\n"
+        "SensorId B9C1B52B-C24A-4309-B9F9-0EF4CD577A3E\n"
+        "SensorName UnitTesting\n"
+        "SensorHostname unit-testing.sensor.tld\n"
+        "LoadModule \"ibmod_rules.so\"\n"
+        "LoadModule \"ibmod_persistence_framework.so\"\n"
+        "LoadModule \"ibmod_persist.so\"\n"
+        "PersistenceWriteBehind On\n"
+    );
+
+    config += "PersistenceStore ASTORE persist-fs://"+m_path.string()+"\n";
+    config +=
+        "PersistenceMap A ASTORE\n"
+        "<Site test-site>\n"
+        "   SiteId AAAABBBB-1111-2222-3333-000000000000\n"
+        "   Hostname *\n"
+        "   Rule ARGS @ne 1 phase:REQUEST id:a1 rev:1 setvar:A=1\n"
+        "   RuleEnable all\n"
+        "</Site>\n"
+    ;
+    configureIronBeeByString(config.c_str());
+    performTx();
+}
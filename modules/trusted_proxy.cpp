@@ -41,6 +41,9 @@
 
 #include <vector>
 
+#include <cstring>
+#include <strings.h>
+
 using namespace std;
 
 namespace {
@@ -306,55 +309,92 @@ void TrustedProxyModule::set_effective_ip(
     IronBee::Transaction tx
 )
 {
-    using namespace boost::algorithm;
-
     ib_status_t rc;
     IronBee::Context ctx = tx.context();
     TrustedProxyConfig& config =
         module().configuration_data<TrustedProxyConfig>(ctx);
 
-    ib_log_debug_tx(tx.ib(), "checking: %s",
-                    tx.connection().remote_ip_string());
-    // check actual remote ip against trusted ips
-    if (! config.is_trusted(tx.connection().remote_ip_string())) {
+    // The trust decision depends only on the connection's remote address,
+    // so resolve it once per connection and cache it as module data.
+    static char conn_trusted_marker;
+    static char conn_untrusted_marker;
+    bool trusted;
+    void *conn_data = NULL;
+    rc = ib_conn_get_module_data(
+        tx.connection().ib(), module().ib(), &conn_data);
+    if (rc == IB_OK) {
+        trusted = (conn_data == &conn_trusted_marker);
+    }
+    else {
+        trusted = config.is_trusted(tx.connection().remote_ip_string());
+        IronBee::throw_if_error(
+            ib_conn_set_module_data(
+                tx.connection().ib(),
+                module().ib(),
+                trusted ? &conn_trusted_marker : &conn_untrusted_marker),
+            "Failed to cache trusted proxy state on connection.");
+    }
+    if (! trusted) {
         ib_log_debug_tx(tx.ib(), "Remote address '%s' not a trusted proxy.",
                         tx.connection().remote_ip_string());
         return;
     }
 
     // Last remote address is trusted, get the last X-Forwarded-For value.
-    string forwarded;
+    const char *fwd = NULL;
+    size_t fwd_len = 0;
     for (
         IronBee::ParsedHeader header = tx.request_header();
         header;
         header = header.next()
     )
     {
-        if (iequals("X-Forwarded-For", header.name().to_s())) {
-            forwarded = header.value().to_s();
+        if (
+            header.name().length() == sizeof("X-Forwarded-For") - 1 &&
+            strncasecmp(
+                header.name().const_data(),
+                "X-Forwarded-For",
+                header.name().length()) == 0
+        )
+        {
+            fwd     = header.value().const_data();
+            fwd_len = header.value().length();
         }
     }
 
-    if (forwarded.length() == 0) {
+    if (fwd == NULL || fwd_len == 0) {
         return;
     }
 
-    list<string> forwarded_list;
-
-    split(forwarded_list, forwarded, is_any_of(","));
+    // Single right-to-left scan: the effective client is the last
+    // comma-separated hop; no per-hop strings are materialized.
+    const char* end = fwd + fwd_len;
+    while (end > fwd && (end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+    const char* start = end;
+    while (start > fwd && start[-1] != ',') {
+        --start;
+    }
+    while (start < end && (*start == ' ' || *start == '\t')) {
+        ++start;
+    }
+    if (start == end) {
+        return;
+    }
 
-    string remote_ip = trim_copy(forwarded_list.back());
+    char* buf = static_cast<char*>(tx.memory_manager().alloc(end - start + 1));
+    memcpy(buf, start, end - start);
+    buf[end - start] = '\0';
 
     /* Verify that it looks like a valid IP address, ignore it if not */
-    rc = ib_ip_validate(remote_ip.c_str());
+    rc = ib_ip_validate(buf);
     if (rc != IB_OK) {
         ib_log_error_tx(tx.ib(),
                         "X-Forwarded-For \"%s\" is not a valid IP address",
-                        remote_ip.c_str());
+                        buf);
         return;
     }
-    char* buf = static_cast<char*>(tx.memory_manager().alloc(remote_ip.length()+1));
-    strcpy(buf, remote_ip.c_str());
 
     /* This will lose the pointer to the original address
      * buffer, but it should be cleaned up with the rest
@@ -1097,6 +1097,13 @@ static ib_status_t txdump_tx(
         txdump_v(tx, txdump, 2, "Path = %s", tx->path);
         txdump_v(tx, txdump, 2, "Blocking Mode = %s",
                  ib_flags_any(tx->flags, IB_TX_FBLOCKING_MODE) ? "On" : "Off");
+        if (tx->mm_budget != NULL) {
+            txdump_v(tx, txdump, 2, "Memory = %zu / %zu bytes%s",
+                     ib_mm_budget_used(tx->mm_budget),
+                     ib_mm_budget_limit(tx->mm_budget),
+                     ib_mm_budget_exceeded(tx->mm_budget) ?
+                         " (exceeded)" : "");
+        }
 
         if (ib_tx_is_blocked(tx)) {
             txdump_v(tx, txdump, 2, "IsBlocked");
@@ -36,7 +36,6 @@
 #include <ironbeepp/data.hpp>
 #include <ironbeepp/hooks.hpp>
 #include <ironbeepp/module.hpp>
-#include <ironbeepp/json.hpp>
 #include <ironbeepp/module_bootstrap.hpp>
 #include <ironbeepp/module_delegate.hpp>
 #include <ironbeepp/parsed_header.hpp>
@@ -63,7 +62,7 @@
 #include <boost/date_time/time_facet.hpp>
 #include <boost/function.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
-#include <boost/lexical_cast.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/shared_ptr.hpp>
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -75,9 +74,333 @@
 #define __STDC_FORMAT_MACROS
 #endif
 #include <inttypes.h>
+#include <pthread.h>
 
 namespace {
 
+/**
+ * Minimal streaming JSON serializer used to render transaction logs.
+ *
+ * This appends JSON text directly to a caller-owned std::string so that a
+ * thread may reuse one buffer across transactions. No intermediate document
+ * is built and, once the buffer has grown to the size of a typical record,
+ * rendering a transaction makes no allocations of its own.
+ *
+ * Keys and string values are escaped as they are appended. Fragments
+ * escaped ahead of time, such as those built by
+ * TxLogConfig::rerenderLogData(), may be spliced in with fragment().
+ */
+class TxLogJsonWriter {
+public:
+    /**
+     * Construct a writer that appends to @a out.
+     *
+     * @param[in] out The output buffer. It is cleared, but its capacity
+     *            is retained.
+     */
+    explicit TxLogJsonWriter(std::string& out);
+
+    //! Open an anonymous map (the root value or an array element).
+    TxLogJsonWriter& openMap();
+
+    //! Open a map stored under @a key in the enclosing map.
+    TxLogJsonWriter& openMap(const char* key);
+
+    //! Close the current map.
+    TxLogJsonWriter& closeMap();
+
+    //! Open an array stored under @a key in the enclosing map.
+    TxLogJsonWriter& openArray(const char* key);
+
+    //! Close the current array.
+    TxLogJsonWriter& closeArray();
+
+    //! Append a string array element of @a val_sz bytes.
+    TxLogJsonWriter& value(const char* val, size_t val_sz);
+
+    //! Append @a key with a string value of @a val_sz bytes.
+    TxLogJsonWriter& entry(const char* key, const char* val, size_t val_sz);
+
+    //! Append @a key with a NUL-terminated string value.
+    TxLogJsonWriter& entry(const char* key, const char* val);
+
+    //! Append @a key with a string value.
+    TxLogJsonWriter& entry(const char* key, const std::string& val);
+
+    //! Append @a key with an integer value.
+    TxLogJsonWriter& entry(const char* key, int64_t val);
+
+    //! Append @a key with a floating point value.
+    TxLogJsonWriter& entryDouble(const char* key, double val);
+
+    /**
+     * Append @a key with @a val formatted as a string.
+     *
+     * The format is `%Y-%m-%dT%H:%M:%S.%f-00:00` with the fractional
+     * seconds trimmed to 3 places, matching what IronBee::Json::withTime()
+     * produced.
+     */
+    TxLogJsonWriter& entryTime(
+        const char*                     key,
+        const boost::posix_time::ptime& val);
+
+    /**
+     * Splice pre-rendered `"key":"value"` pairs into the current map.
+     *
+     * @param[in] rendered Empty, or a comma-joined list of pre-escaped
+     *            pairs as built by TxLogConfig::rerenderLogData().
+     */
+    TxLogJsonWriter& fragment(const std::string& rendered);
+
+    //! Append @a val_sz bytes of @a val to @a out with JSON escaping.
+    static void escape(std::string& out, const char* val, size_t val_sz);
+
+private:
+    //! Append a comma if the current container already has an element.
+    void separator();
+
+    //! Append an escaped, quoted @a key followed by a colon.
+    void key(const char* key);
+
+    //! The output buffer.
+    std::string& m_out;
+
+    //! Does the next element need a comma before it?
+    bool m_need_comma;
+};
+
+TxLogJsonWriter::TxLogJsonWriter(std::string& out) :
+    m_out(out),
+    m_need_comma(false)
+{
+    m_out.clear();
+}
+
+void TxLogJsonWriter::separator()
+{
+    if (m_need_comma) {
+        m_out += ',';
+    }
+}
+
+void TxLogJsonWriter::key(const char* key)
+{
+    separator();
+    m_out += '"';
+    escape(m_out, key, strlen(key));
+    m_out += "\":";
+}
+
+TxLogJsonWriter& TxLogJsonWriter::openMap()
+{
+    separator();
+    m_out += '{';
+    m_need_comma = false;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::openMap(const char* key)
+{
+    this->key(key);
+    m_out += '{';
+    m_need_comma = false;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::closeMap()
+{
+    m_out += '}';
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::openArray(const char* key)
+{
+    this->key(key);
+    m_out += '[';
+    m_need_comma = false;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::closeArray()
+{
+    m_out += ']';
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::value(const char* val, size_t val_sz)
+{
+    separator();
+    m_out += '"';
+    escape(m_out, val, val_sz);
+    m_out += '"';
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entry(
+    const char* key,
+    const char* val,
+    size_t      val_sz
+)
+{
+    this->key(key);
+    m_out += '"';
+    escape(m_out, val, val_sz);
+    m_out += '"';
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entry(const char* key, const char* val)
+{
+    return entry(key, val, strlen(val));
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entry(
+    const char*        key,
+    const std::string& val
+)
+{
+    return entry(key, val.data(), val.length());
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entry(const char* key, int64_t val)
+{
+    char num[24];
+    int  num_sz = snprintf(num, sizeof(num), "%" PRId64, val);
+
+    this->key(key);
+    m_out.append(num, num_sz);
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entryDouble(const char* key, double val)
+{
+    /* Render as yajl_gen_double() does. */
+    char num[40];
+    int  num_sz = snprintf(num, sizeof(num), "%.17g", val);
+
+    this->key(key);
+    m_out.append(num, num_sz);
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::entryTime(
+    const char*                     key,
+    const boost::posix_time::ptime& val
+)
+{
+    boost::gregorian::date           date = val.date();
+    boost::posix_time::time_duration time = val.time_of_day();
+
+    /* Fractional seconds, truncated to milliseconds. */
+    long ms = static_cast<long>(
+        time.fractional_seconds() /
+        (boost::posix_time::time_duration::ticks_per_second() / 1000));
+
+    char tstr[40];
+    int  tstr_sz = snprintf(
+        tstr,
+        sizeof(tstr),
+        "\"%04d-%02d-%02dT%02d:%02d:%02d.%03ld-00:00\"",
+        static_cast<int>(date.year()),
+        static_cast<int>(date.month().as_number()),
+        static_cast<int>(date.day().as_number()),
+        static_cast<int>(time.hours()),
+        static_cast<int>(time.minutes()),
+        static_cast<int>(time.seconds()),
+        ms);
+
+    this->key(key);
+    m_out.append(tstr, tstr_sz);
+    m_need_comma = true;
+    return *this;
+}
+
+TxLogJsonWriter& TxLogJsonWriter::fragment(const std::string& rendered)
+{
+    if (! rendered.empty()) {
+        separator();
+        m_out += rendered;
+        m_need_comma = true;
+    }
+    return *this;
+}
+
+void TxLogJsonWriter::escape(std::string& out, const char* val, size_t val_sz)
+{
+    for (size_t i = 0; i < val_sz; ++i) {
+        const unsigned char c = static_cast<unsigned char>(val[i]);
+
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b";  break;
+        case '\f': out += "\\f";  break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            }
+            else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+}
+
+//! Key for the per-thread render buffer. Never deleted; lives as long
+//! as the process, like the format function that uses it.
+pthread_key_t g_txlog_buffer_key;
+
+//! Initializer guard for g_txlog_buffer_key.
+pthread_once_t g_txlog_buffer_key_once = PTHREAD_ONCE_INIT;
+
+//! Destroy a thread's render buffer when the thread exits.
+void txlogBufferDestroy(void* buffer)
+{
+    delete reinterpret_cast<std::string*>(buffer);
+}
+
+//! Create g_txlog_buffer_key.
+void txlogBufferKeyCreate()
+{
+    pthread_key_create(&g_txlog_buffer_key, txlogBufferDestroy);
+}
+
+/**
+ * Fetch the calling thread's render buffer, cleared and ready for use.
+ *
+ * The buffer keeps its capacity between transactions, so steady-state
+ * rendering does not allocate.
+ *
+ * @throws std::bad_alloc on allocation failure.
+ */
+std::string& txlogBuffer()
+{
+    pthread_once(&g_txlog_buffer_key_once, txlogBufferKeyCreate);
+
+    std::string* buffer = reinterpret_cast<std::string*>(
+        pthread_getspecific(g_txlog_buffer_key));
+
+    if (buffer == NULL) {
+        buffer = new std::string();
+        buffer->reserve(8192);
+        pthread_setspecific(g_txlog_buffer_key, buffer);
+    }
+
+    buffer->clear();
+    return *buffer;
+}
+
 /**
  * State data built and stored in transactions.
  */
@@ -265,57 +588,59 @@ void TxLogData::recordAuditLogData(
 
 void eventsToJson(
     IronBee::ConstTransaction tx,
-    IronBee::Json& txLogJson
+    TxLogJsonWriter&          writer
 )
 {
     IronBee::ConstList<ib_logevent_t *> ib_eventList(tx.ib()->logevents);
 
-    txLogJson.withString("events");
-    IronBee::JsonArray<IronBee::Json> events = txLogJson.withArray();
+    writer.openArray("events");
 
     BOOST_FOREACH(const ib_logevent_t *e, ib_eventList) {
+        char event_id[16];
+        int  event_id_sz;
 
         /* Skip suppressed events. */
         if (e->suppress != IB_LEVENT_SUPPRESS_NONE) {
             continue;
         }
 
-        /* Open a map to the rendering of JSON. */
-        IronBee::JsonMap<IronBee::Json> eventMap = txLogJson.withMap();
+        writer.openMap();
 
         /* Conditionally add the tags list. */
         if (e->tags && ib_list_elements(e->tags) > 0) {
-            IronBee::JsonArray<IronBee::JsonMap<IronBee::Json> > tags =
-                eventMap.withArray("tags");
+            writer.openArray("tags");
             IronBee::ConstList<const char *> ib_tagList(e->tags);
             BOOST_FOREACH(const char *tag, ib_tagList) {
                 if (tag) {
-                    tags.withString(tag);
+                    writer.value(tag, strlen(tag));
                 }
             }
-            tags.close();
+            writer.closeArray();
         }
 
-        eventMap
-            .withString("type", ib_logevent_type_name(e->type))
-            .withString("rule", e->rule_id ? e->rule_id : "")
-            .withString("message", e->msg ? e->msg : "")
-            .withInt("confidence", e->confidence)
-            .withInt("severity", e->severity)
-            .withString("id", boost::lexical_cast<std::string>(e->event_id))
-            .close();
+        /* The id is rendered as a string, as it always has been. */
+        event_id_sz =
+            snprintf(event_id, sizeof(event_id), "%" PRIu32, e->event_id);
+
+        writer
+            .entry("type", ib_logevent_type_name(e->type))
+            .entry("rule", e->rule_id ? e->rule_id : "")
+            .entry("message", e->msg ? e->msg : "")
+            .entry("confidence", static_cast<int64_t>(e->confidence))
+            .entry("severity", static_cast<int64_t>(e->severity))
+            .entry("id", event_id, event_id_sz)
+            .closeMap();
     }
 
-    events.close();
+    writer.closeArray();
 }
 
 void requestHeadersToJson(
     IronBee::ConstTransaction tx,
-    IronBee::Json& txLogJson
+    TxLogJsonWriter&          writer
 )
 {
-    txLogJson.withString("headers");
-    IronBee::JsonArray<IronBee::Json> headers = txLogJson.withArray();
+    writer.openArray("headers");
 
     if (tx.request_header()) {
         for (
@@ -324,8 +649,11 @@ void requestHeadersToJson(
             headerNvp = headerNvp.next()
         )
         {
-            std::string headerName = headerNvp.name().to_s();
-            std::string headerValue = headerNvp.value().to_s();
+            IronBee::ConstByteString name = headerNvp.name();
+            boost::iterator_range<const char *> headerName =
+                boost::make_iterator_range(
+                    name.const_data(),
+                    name.const_data() + name.length());
 
             // TODO: These need to be configurable (string set?).
             if (boost::algorithm::istarts_with(headerName, "Content-") ||
@@ -334,24 +662,24 @@ void requestHeadersToJson(
                 boost::algorithm::iequals(headerName, "Referer") ||
                 boost::algorithm::iequals(headerName, "TE"))
             {
-                headers.withMap()
-                        .withString("name", headerNvp.name().to_s())
-                        .withString("value", headerNvp.value().to_s())
-                    .close();
+                IronBee::ConstByteString value = headerNvp.value();
+                writer.openMap()
+                    .entry("name", name.const_data(), name.length())
+                    .entry("value", value.const_data(), value.length())
+                    .closeMap();
             }
         }
     }
 
-    headers.close();
+    writer.closeArray();
 }
 
 void responseHeadersToJson(
     IronBee::ConstTransaction tx,
-    IronBee::Json& txLogJson
+    TxLogJsonWriter&          writer
 )
 {
-    txLogJson.withString("headers");
-    IronBee::JsonArray<IronBee::Json> headers = txLogJson.withArray();
+    writer.openArray("headers");
 
     if (tx.response_header()) {
         for (
@@ -360,8 +688,11 @@ void responseHeadersToJson(
             headerNvp = headerNvp.next()
         )
         {
-            std::string headerName = headerNvp.name().to_s();
-            std::string headerValue = headerNvp.value().to_s();
+            IronBee::ConstByteString name = headerNvp.name();
+            boost::iterator_range<const char *> headerName =
+                boost::make_iterator_range(
+                    name.const_data(),
+                    name.const_data() + name.length());
 
             // TODO: These need to be configurable (string set?).
             if (boost::algorithm::istarts_with(headerName, "Content-") ||
@@ -369,15 +700,16 @@ void responseHeadersToJson(
                 boost::algorithm::iequals(headerName, "Server") ||
                 boost::algorithm::iequals(headerName, "Allow"))
             {
-                headers.withMap()
-                        .withString("name", headerNvp.name().to_s())
-                        .withString("value", headerNvp.value().to_s())
-                    .close();
+                IronBee::ConstByteString value = headerNvp.value();
+                writer.openMap()
+                    .entry("name", name.const_data(), name.length())
+                    .entry("value", value.const_data(), value.length())
+                    .closeMap();
             }
         }
     }
 
-    headers.close();
+    writer.closeArray();
 }
 
 /**
@@ -388,7 +720,7 @@ void responseHeadersToJson(
  * On any error, this renders nothing.
  *
  * @param[in] tx The transaction.
- * @param[in] txLogJson The JSON structure which should be in the middle of
+ * @param[in] writer The writer which should be in the middle of
  *            rendering a JSON map.
  * @param[in] name The name to render the source value as.
  * @param[in] source The var source to render.
@@ -400,7 +732,7 @@ void responseHeadersToJson(
  */
 void varSourceToJson(
     IronBee::ConstTransaction tx,
-    IronBee::Json&                txLogJson,
+    TxLogJsonWriter&          writer,
     const std::string         name,
     IronBee::ConstVarSource   source
 )
@@ -416,12 +748,14 @@ void varSourceToJson(
             if (field) {
                 switch (field.type()) {
                     case IronBee::ConstField::NUMBER:
-                        txLogJson.withString(name);
-                        txLogJson.withInt(field.value_as_number());
+                        writer.entry(
+                            name.c_str(),
+                            static_cast<int64_t>(field.value_as_number()));
                         break;
                     case IronBee::ConstField::FLOAT:
-                        txLogJson.withString(name);
-                        txLogJson.withDouble(field.value_as_float());
+                        writer.entryDouble(
+                            name.c_str(),
+                            field.value_as_float());
                         break;
                     case IronBee::ConstField::NULL_STRING:
                         ib_log_error(
@@ -430,9 +764,15 @@ void varSourceToJson(
                             "when processing var sources.");
                         break;
                     case IronBee::ConstField::BYTE_STRING:
-                        txLogJson.withString(name);
-                        txLogJson.withString(field.value_as_byte_string().to_s());
+                    {
+                        IronBee::ConstByteString bs =
+                            field.value_as_byte_string();
+                        writer.entry(
+                            name.c_str(),
+                            bs.const_data(),
+                            bs.length());
                         break;
+                    }
                     default:
                         ib_log_error(
                             tx.engine().ib(),
@@ -452,29 +792,25 @@ void varSourceToJson(
  *
  * If the length of @a val is 0, then nothing is done.
  *
- * This function is intended for use with calls to
- * IronBee::JsonMap::withFunction() to render optional fields.
- *
  * @param[in] name The name of the value to render.
  * @param[in] val The value to render if val.length() > 0.
- * @param[in] txLogJson Used to render the values.
+ * @param[in] writer Used to render the values.
  */
 void renderNonemptyString(
     const char*        name,
     const std::string& val,
-    IronBee::Json&     txLogJson
+    TxLogJsonWriter&   writer
 )
 {
     if (val.length() > 0) {
-        txLogJson.withString(name);
-        txLogJson.withString(val);
+        writer.entry(name, val);
     }
 }
 
 void addThreatLevel(
     IronBee::ConstContext     ctx,
     IronBee::ConstTransaction tx,
-    IronBee::Json&            txLogJson
+    TxLogJsonWriter&          writer
 )
 {
     try
@@ -489,18 +825,18 @@ void addThreatLevel(
                 .get(tx.var_store());
 
         // Add the threat level.
-        txLogJson.withString("threatLevel");
-
         switch(threat_level.type()) {
         case IronBee::ConstField::NUMBER:
-            txLogJson.withInt(threat_level.value_as_number());
+            writer.entry(
+                "threatLevel",
+                static_cast<int64_t>(threat_level.value_as_number()));
             break;
         case IronBee::ConstField::FLOAT:
-            txLogJson.withDouble(threat_level.value_as_float());
+            writer.entryDouble("threatLevel", threat_level.value_as_float());
             break;
         case IronBee::ConstField::BYTE_STRING:
         case IronBee::ConstField::NULL_STRING:
-            txLogJson.withString(threat_level.to_s());
+            writer.entry("threatLevel", threat_level.to_s());
             break;
         default:
             BOOST_THROW_EXCEPTION(
@@ -516,18 +852,27 @@ void addThreatLevel(
 }
 
 /**
- * Render a C++ map of strings to strings into JSON w/ var expansion.
+ * Render var-expanding TxLogData pairs for a transaction.
+ *
+ * Pairs whose values do not var-expand are pre-rendered once, at
+ * configuration time, by TxLogConfig::rerenderLogData() and spliced into
+ * the record with TxLogJsonWriter::fragment(). Only the pairs that must
+ * be expanded against the transaction's var store pass through here.
  *
  * @param[in] tx The transaction.
- * @param[in] pairs The pairs to render.
- * @param[in] json The JSON values.
+ * @param[in] pairs The expanding pairs to render.
+ * @param[in] writer The writer rendering the enclosing map.
  */
-void renderMap(
+void renderExpandMap(
     IronBee::Transaction                tx,
     std::map<std::string, std::string>& pairs,
-    IronBee::Json&                      json
+    TxLogJsonWriter&                    writer
 )
 {
+    if (pairs.empty()) {
+        return;
+    }
+
     IronBee::MemoryManager mm         = tx.memory_manager();
     IronBee::VarStore      var_store  = tx.var_store();
     IronBee::VarConfig     var_config =
@@ -535,22 +880,15 @@ void renderMap(
 
     std::pair<std::string, std::string> p;
     BOOST_FOREACH(p, pairs) {
-        if (IronBee::VarExpand::test(p.second)) {
-            IronBee::VarExpand exp = IronBee::VarExpand::acquire(
-                mm,
-                p.second,
-                var_config
-            );
+        IronBee::VarExpand exp = IronBee::VarExpand::acquire(
+            mm,
+            p.second,
+            var_config
+        );
 
-            std::pair<const char *, size_t> val = exp.execute(mm, var_store);
+        std::pair<const char *, size_t> val = exp.execute(mm, var_store);
 
-            json.withString(p.first);
-            json.withString(val.first, val.second);
-        }
-        else {
-            json.withString(p.first);
-            json.withString(p.second);
-        }
+        writer.entry(p.first.c_str(), val.first, val.second);
     }
 }
 
@@ -578,6 +916,32 @@ struct TxLogConfig
         >
     > logData;
 
+    /**
+     * Per-section, comma-joined, pre-escaped `"key":"value"` fragments.
+     *
+     * Built at configuration time from the TxLogData pairs whose values
+     * do not var-expand, so rendering a transaction only splices bytes.
+     */
+    std::map<std::string, std::string> renderedLogData;
+
+    //! Per-section TxLogData pairs that var-expand per transaction.
+    std::map<
+        std::string,
+        std::map<
+            std::string,
+            std::string
+        >
+    > expandLogData;
+
+    /**
+     * Rebuild renderedLogData and expandLogData for @a section.
+     *
+     * Call this at directive time whenever logData for @a section
+     * changes. Configurations are read-only once the configuration
+     * phase ends, so no rendering may be deferred past it.
+     */
+    void rerenderLogData(const std::string& section);
+
     //! Constructor.
     TxLogConfig();
 };
@@ -589,6 +953,35 @@ TxLogConfig::TxLogConfig():
     stdlog_enabled(true)
 {}
 
+void TxLogConfig::rerenderLogData(const std::string& section)
+{
+    std::string&                        rendered = renderedLogData[section];
+    std::map<std::string, std::string>& expand   = expandLogData[section];
+
+    rendered.clear();
+    expand.clear();
+
+    std::pair<std::string, std::string> p;
+    BOOST_FOREACH(p, logData[section]) {
+        if (IronBee::VarExpand::test(p.second)) {
+            expand[p.first] = p.second;
+        }
+        else {
+            if (! rendered.empty()) {
+                rendered += ',';
+            }
+            rendered += '"';
+            TxLogJsonWriter::escape(rendered, p.first.data(), p.first.length());
+            rendered += "\":\"";
+            TxLogJsonWriter::escape(
+                rendered,
+                p.second.data(),
+                p.second.length());
+            rendered += '"';
+        }
+    }
+}
+
 /**
  * Callback data for txlog_logger_format_fn().
  *
@@ -747,129 +1140,118 @@ static ib_status_t txlog_logger_format_fn(
     }
 
     try {
-        IronBee::Json()
-            .withMap()
-                .withTime("timestamp", tx.started_time())
-                .withInt("duration",
-                    (tx.finished_time() - tx.started_time())
-                        .total_milliseconds())
-                .withString("id", tx.id())
-                .withString("clientIp", tx.effective_remote_ip_string())
-                .withInt("clientPort", conn.remote_port())
-                .withString("sensorId", tx.engine().sensor_id())
-                .withString("siteId", siteId)
-                .withMap("connection")
-                    .withFunction(
-                        boost::bind(
-                            renderMap,
-                            tx,
-                            boost::ref(cfg.logData["connection"]),
-                            _1
-                        )
-                    )
-                    .withString("id", conn.id())
-                    .withString("clientIp", conn.remote_ip_string())
-                    .withInt("clientPort", conn.remote_port())
-                    .withString("serverIp", conn.local_ip_string())
-                    .withInt("serverPort", conn.local_port())
-                .close()
-                .withMap("request")
-                    .withFunction(
-                        boost::bind(
-                            renderMap,
-                            tx,
-                            boost::ref(cfg.logData["request"]),
-                            _1
-                        )
-                    )
-                    .withString("method", tx.request_line().method().to_s())
-                    .withString("uri", tx.request_line().uri().to_s())
-                    .withString("protocol", tx.request_line().protocol().to_s())
-                    .withString("host", tx.hostname())
-                    .withString("path", tx.path())
-                    .withInt("bandwidth", tx.request_length())
-                    .withFunction(boost::bind(requestHeadersToJson, tx, _1))
-                    .withFunction(
-                        boost::bind(
-                            varSourceToJson,
-                            tx,
-                            _1,
-                            "headerOrder",
-                            fmt_cbdata.request_header_order))
-                .close()
-                .withMap("response")
-                    .withFunction(
-                        boost::bind(
-                            renderMap,
-                            tx,
-                            boost::ref(cfg.logData["response"]),
-                            _1
-                        )
-                    )
-                    .withString("protocol", tx.response_line().protocol().to_s())
-                    .withString("status", tx.response_line().status().to_s())
-                    .withString("message", tx.response_line().message().to_s())
-                    .withInt("bandwidth", tx.response_length())
-                    .withFunction(boost::bind(responseHeadersToJson, tx, _1))
-                    .withFunction(
-                        boost::bind(
-                            varSourceToJson,
-                            tx,
-                            _1,
-                            "headerOrder",
-                            fmt_cbdata.response_header_order))
-                .close()
-                .withMap("security")
-                    .withFunction(
-                        boost::bind(
-                            renderMap,
-                            tx,
-                            boost::ref(cfg.logData["security"]),
-                            _1
-                        )
-                    )
-                    .withFunction(
-                        boost::bind(
-                            renderNonemptyString,
-                            "auditLogRef",
-                            boost::ref(txlogdata.auditlogId()),
-                            _1))
-                    .withFunction(boost::bind(addThreatLevel, ctx, tx, _1))
-                    .withFunction(boost::bind(eventsToJson, tx, _1))
-                    .withFunction(
-                        boost::bind(
-                            renderNonemptyString,
-                            "action",
-                            boost::ref(txlogdata.blockAction()),
-                            _1))
-                    .withFunction(
-                        boost::bind(
-                            renderNonemptyString,
-                            "actionMethod",
-                            boost::ref(txlogdata.blockMethod()),
-                            _1))
-                    .withFunction(
-                        boost::bind(
-                            renderNonemptyString,
-                            "actionPhase",
-                            boost::ref(txlogdata.blockPhase()),
-                            _1))
-                .close()
-                .withFunction(
-                    boost::bind(
-                        renderMap,
-                        tx,
-                        boost::ref(cfg.logData["root"]),
-                        _1
-                    )
-                )
-            .close()
-            .render(
-                reinterpret_cast<char*&>(stdmsg->msg),
-                stdmsg->msg_sz
-            );
+        /* Render into this thread's reusable buffer; the final bytes are
+         * copied into stdmsg once the record is complete. */
+        std::string&    buffer = txlogBuffer();
+        TxLogJsonWriter writer(buffer);
+
+        IronBee::ConstParsedRequestLine  reqLine = tx.request_line();
+        IronBee::ConstParsedResponseLine rspLine = tx.response_line();
+
+        writer.openMap();
+
+        writer.entryTime("timestamp", tx.started_time());
+        writer.entry(
+            "duration",
+            static_cast<int64_t>(
+                (tx.finished_time() - tx.started_time())
+                    .total_milliseconds()));
+        writer.entry("id", tx.id());
+        writer.entry("clientIp", tx.effective_remote_ip_string());
+        writer.entry("clientPort", static_cast<int64_t>(conn.remote_port()));
+        writer.entry("sensorId", tx.engine().sensor_id());
+        writer.entry("siteId", siteId);
+
+        writer.openMap("connection");
+        writer.fragment(cfg.renderedLogData["connection"]);
+        renderExpandMap(tx, cfg.expandLogData["connection"], writer);
+        writer.entry("id", conn.id());
+        writer.entry("clientIp", conn.remote_ip_string());
+        writer.entry("clientPort", static_cast<int64_t>(conn.remote_port()));
+        writer.entry("serverIp", conn.local_ip_string());
+        writer.entry("serverPort", static_cast<int64_t>(conn.local_port()));
+        writer.closeMap();
+
+        writer.openMap("request");
+        writer.fragment(cfg.renderedLogData["request"]);
+        renderExpandMap(tx, cfg.expandLogData["request"], writer);
+        writer.entry(
+            "method",
+            reqLine.method().const_data(),
+            reqLine.method().length());
+        writer.entry(
+            "uri",
+            reqLine.uri().const_data(),
+            reqLine.uri().length());
+        writer.entry(
+            "protocol",
+            reqLine.protocol().const_data(),
+            reqLine.protocol().length());
+        writer.entry("host", tx.hostname());
+        writer.entry("path", tx.path());
+        writer.entry(
+            "bandwidth",
+            static_cast<int64_t>(tx.request_length()));
+        requestHeadersToJson(tx, writer);
+        varSourceToJson(
+            tx,
+            writer,
+            "headerOrder",
+            fmt_cbdata.request_header_order);
+        writer.closeMap();
+
+        writer.openMap("response");
+        writer.fragment(cfg.renderedLogData["response"]);
+        renderExpandMap(tx, cfg.expandLogData["response"], writer);
+        writer.entry(
+            "protocol",
+            rspLine.protocol().const_data(),
+            rspLine.protocol().length());
+        writer.entry(
+            "status",
+            rspLine.status().const_data(),
+            rspLine.status().length());
+        writer.entry(
+            "message",
+            rspLine.message().const_data(),
+            rspLine.message().length());
+        writer.entry(
+            "bandwidth",
+            static_cast<int64_t>(tx.response_length()));
+        responseHeadersToJson(tx, writer);
+        varSourceToJson(
+            tx,
+            writer,
+            "headerOrder",
+            fmt_cbdata.response_header_order);
+        writer.closeMap();
+
+        writer.openMap("security");
+        writer.fragment(cfg.renderedLogData["security"]);
+        renderExpandMap(tx, cfg.expandLogData["security"], writer);
+        renderNonemptyString("auditLogRef", txlogdata.auditlogId(), writer);
+        addThreatLevel(ctx, tx, writer);
+        eventsToJson(tx, writer);
+        renderNonemptyString("action", txlogdata.blockAction(), writer);
+        renderNonemptyString("actionMethod", txlogdata.blockMethod(), writer);
+        renderNonemptyString("actionPhase", txlogdata.blockPhase(), writer);
+        writer.closeMap();
+
+        writer.fragment(cfg.renderedLogData["root"]);
+        renderExpandMap(tx, cfg.expandLogData["root"], writer);
+
+        writer.closeMap();
+
+        stdmsg->msg = reinterpret_cast<uint8_t *>(malloc(buffer.length()));
+        if (stdmsg->msg == NULL) {
+            free(stdmsg);
+            return IB_EALLOC;
+        }
+        memcpy(stdmsg->msg, buffer.data(), buffer.length());
+        stdmsg->msg_sz = buffer.length();
     }
     catch (...) {
+        free(stdmsg);
         return IronBee::convert_exception(IronBee::ConstEngine(rec->tx->ib));
     }
 
@@ -1124,6 +1506,7 @@ void TxLogModule::logDataDirective(
             sub_name,
             value);
         cfg.logData["request"][sub_name] = value;
+        cfg.rerenderLogData("request");
     }
     else if (0 == strncasecmp("response.", name, sizeof("response.")-1)) {
         const char *sub_name = name + sizeof("response.")-1;
@@ -1133,6 +1516,7 @@ void TxLogModule::logDataDirective(
             sub_name,
             value);
         cfg.logData["response"][sub_name] = value;
+        cfg.rerenderLogData("response");
     }
     else if (0 == strncasecmp("security.", name, sizeof("security.")-1)) {
         const char *sub_name = name + sizeof("security.")-1;
@@ -1142,6 +1526,7 @@ void TxLogModule::logDataDirective(
             sub_name,
             value);
         cfg.logData["security"][sub_name] = value;
+        cfg.rerenderLogData("security");
     }
     else if (0 == strncasecmp("connection.", name, sizeof("connection.")-1)) {
         const char *sub_name = name + sizeof("connection.")-1;
@@ -1151,6 +1536,7 @@ void TxLogModule::logDataDirective(
             sub_name,
             value);
         cfg.logData["connection"][sub_name] = value;
+        cfg.rerenderLogData("connection");
     }
     else {
         ib_cfg_log_debug(
@@ -1159,6 +1545,7 @@ void TxLogModule::logDataDirective(
             name,
             value);
         cfg.logData["root"][name] = value;
+        cfg.rerenderLogData("root");
     }
 }
 
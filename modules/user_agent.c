@@ -43,6 +43,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -370,6 +371,106 @@ static ib_status_t modua_store_field(ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Per-connection cache of the last classified user agent.
+ *
+ * Keep-alive connections repeat the same User-Agent for every request,
+ * so the parse and the walk over the category rules run once per
+ * connection instead of once per transaction.  All strings are
+ * connection-lifetime copies.
+ */
+typedef struct {
+    const uint8_t            *ua;       /**< Cached raw agent bytes */
+    size_t                    ua_len;   /**< Length of ua */
+    bool                      parse_ok; /**< Did the agent string parse? */
+    char                     *agent;    /**< Agent string copy */
+    char                     *product;  /**< Parsed product, or NULL */
+    char                     *platform; /**< Parsed platform, or NULL */
+    char                     *extra;    /**< Parsed extra, or NULL */
+    const modua_match_rule_t *rule;     /**< Matched rule, or NULL */
+} modua_conn_cache_t;
+
+/**
+ * Best-effort record of a classification in the per-connection cache.
+ *
+ * Failure to cache is not an error; the next transaction on the
+ * connection simply re-classifies.
+ *
+ * @param[in] tx Transaction whose connection caches the result.
+ * @param[in] m User agent module.
+ * @param[in] bs Raw agent bytes.
+ * @param[in] parse_ok Whether the agent string parsed.
+ * @param[in] agent Copy of the agent string.
+ * @param[in] product Parsed product, or NULL.
+ * @param[in] platform Parsed platform, or NULL.
+ * @param[in] extra Parsed extra, or NULL.
+ * @param[in] rule Matched category rule, or NULL.
+ */
+static void modua_cache_classification(
+    ib_tx_t                  *tx,
+    const ib_module_t        *m,
+    const ib_bytestr_t       *bs,
+    bool                      parse_ok,
+    const char               *agent,
+    const char               *product,
+    const char               *platform,
+    const char               *extra,
+    const modua_match_rule_t *rule
+)
+{
+    assert(tx != NULL);
+    assert(tx->conn != NULL);
+    assert(m != NULL);
+    assert(bs != NULL);
+
+    ib_mm_t             mm = tx->conn->mm;
+    modua_conn_cache_t *cache;
+    size_t              len = ib_bytestr_length(bs);
+
+    cache = (modua_conn_cache_t *)ib_mm_calloc(mm, 1, sizeof(*cache));
+    if (cache == NULL) {
+        return;
+    }
+
+    if (len > 0) {
+        cache->ua = (const uint8_t *)ib_mm_memdup(
+            mm, ib_bytestr_const_ptr(bs), len);
+        if (cache->ua == NULL) {
+            return;
+        }
+    }
+    cache->ua_len   = len;
+    cache->parse_ok = parse_ok;
+    cache->rule     = rule;
+
+    if (agent != NULL) {
+        cache->agent = ib_mm_strdup(mm, agent);
+        if (cache->agent == NULL) {
+            return;
+        }
+    }
+    if (product != NULL) {
+        cache->product = ib_mm_strdup(mm, product);
+        if (cache->product == NULL) {
+            return;
+        }
+    }
+    if (platform != NULL) {
+        cache->platform = ib_mm_strdup(mm, platform);
+        if (cache->platform == NULL) {
+            return;
+        }
+    }
+    if (extra != NULL) {
+        cache->extra = ib_mm_strdup(mm, extra);
+        if (cache->extra == NULL) {
+            return;
+        }
+    }
+
+    ib_conn_set_module_data(tx->conn, m, cache);
+}
+
 /**
  * Parse the user agent header, splitting into component fields.
  *
@@ -377,12 +478,14 @@ static ib_status_t modua_store_field(ib_engine_t *ib,
  * result in the DPI associated with the transaction.
  *
  * @param[in] ib IronBee object
+ * @param[in] m User agent module
  * @param[in,out] tx Transaction object
  * @param[in] bs Byte string containing the agent string
  *
  * @returns Status code
  */
 static ib_status_t modua_agent_fields(ib_engine_t *ib,
+                                      const ib_module_t *m,
                                       ib_tx_t *tx,
                                       const ib_bytestr_t *bs)
 {
@@ -396,10 +499,31 @@ static ib_status_t modua_agent_fields(ib_engine_t *ib,
     size_t                    len;
     ib_status_t               rc;
     ib_var_source_t          *source;
+    modua_conn_cache_t       *cache = NULL;
 
     /* Get the length of the byte string */
     len = ib_bytestr_length(bs);
 
+    /* Consult the per-connection cache. */
+    rc = ib_conn_get_module_data(tx->conn, m, &cache);
+    if (rc != IB_OK) {
+        cache = NULL;
+    }
+    if (   cache != NULL
+        && cache->ua_len == len
+        && (len == 0 || memcmp(cache->ua, ib_bytestr_const_ptr(bs), len) == 0))
+    {
+        if (! cache->parse_ok) {
+            return IB_OK;
+        }
+        agent    = cache->agent;
+        product  = cache->product;
+        platform = cache->platform;
+        extra    = cache->extra;
+        rule     = cache->rule;
+        goto store_fields;
+    }
+
     /* Allocate memory for a copy of the string to split up below. */
     buf = (char *)ib_mm_calloc(tx->mm, 1, len+1);
     if (buf == NULL) {
@@ -421,6 +545,8 @@ static ib_status_t modua_agent_fields(ib_engine_t *ib,
     rc = modua_parse_uastring(buf, &product, &platform, &extra);
     if (rc != IB_OK) {
         ib_log_debug_tx(tx, "Failed to parse User Agent string \"%s\".", agent);
+        modua_cache_classification(
+            tx, m, bs, false, agent, product, platform, extra, NULL);
         return IB_OK;
     }
 
@@ -434,6 +560,11 @@ static ib_status_t modua_agent_fields(ib_engine_t *ib,
                         rule->rule_num, rule->category );
     }
 
+    /* Record the classification for later requests on this connection. */
+    modua_cache_classification(
+        tx, m, bs, true, agent, product, platform, extra, rule);
+
+store_fields:
     /* Build a new list. */
     rc = ib_var_source_acquire(
         &source, tx->mm, ib_engine_var_config_get(ib), IB_S2SL("UA")
@@ -569,7 +700,7 @@ static ib_status_t modua_user_agent(ib_engine_t *ib,
     }
 
     /* Finally, split it up & store the components */
-    rc = modua_agent_fields(ib, tx, bs);
+    rc = modua_agent_fields(ib, m, tx, bs);
     return rc;
 }
 
@@ -52,6 +52,9 @@
 #include <sstream>
 #include <vector>
 
+#include <cstring>
+#include <stdint.h>
+
 namespace {
 
 typedef std::map<std::string, char> utf8ToAscii_t;
@@ -79,6 +82,71 @@ public:
     explicit Utf8ModuleDelegate(Module m);
 };
 
+/**
+ * Fetch the raw bytes of a string-typed field without copying.
+ *
+ * @param[in] f The field.
+ * @param[out] data Set to the start of the field data.
+ * @param[out] len Set to the data length.
+ *
+ * @returns True if @a f is a string type and @a data / @a len were set.
+ */
+bool fieldData(ConstField f, const char*& data, size_t& len)
+{
+    if (f.type() == Field::BYTE_STRING) {
+        ConstByteString bs = f.value_as_byte_string();
+        data = bs.const_data();
+        len = bs.length();
+        return data != NULL;
+    }
+
+    if (f.type() == Field::NULL_STRING) {
+        data = f.value_as_null_string();
+        if (data == NULL) {
+            return false;
+        }
+        len = strlen(data);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * True if every byte of @a data has the high bit clear.
+ *
+ * Scans a machine word at a time; a set high bit anywhere in the word
+ * shows in a single mask test, so pure-ASCII input (the overwhelmingly
+ * common case) is detected at eight bytes per iteration.  Pure ASCII is
+ * both valid UTF-8 and already in shortest form, so callers can skip
+ * validation and normalization outright.
+ *
+ * @param[in] data Bytes to scan.
+ * @param[in] len Length of @a data.
+ *
+ * @returns True if @a data is pure ASCII.
+ */
+bool isAscii(const char* data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080)) {
+            return false;
+        }
+    }
+
+    for (; i < len; ++i) {
+        if (data[i] & 0x80) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * Replace the UTF-8 character given in the sequence of bytes in @a v.
  *
@@ -214,16 +282,19 @@ int validateUtf8(Transaction tx, ConstField in)
         return 0;
     }
 
-    if (in.type() != Field::NULL_STRING && in.type() != Field::BYTE_STRING) {
+    const char *data;
+    size_t len;
+
+    if (! fieldData(in, data, len)) {
         return 0;
     }
 
-    std::istringstream in_stringstream(in.to_s());
-
-    std::istream_iterator<char> it(in_stringstream);
-    std::istream_iterator<char> eos;
+    /* Pure ASCII is valid UTF-8; skip the decoder. */
+    if (isAscii(data, len)) {
+        return 1;
+    }
 
-    if (utf8::is_valid(it, eos)) {
+    if (utf8::is_valid(data, data + len)) {
         return 1;
     }
     else {
@@ -623,6 +694,16 @@ ConstField normalizeUtf8(MemoryManager mm, ConstField f)
         return f;
     }
 
+    /* Pure ASCII is already in shortest form: normalization is the
+     * identity, so hand the input field back untouched. */
+    {
+        const char *data;
+        size_t len;
+        if (fieldData(f, data, len) && isAscii(data, len)) {
+            return f;
+        }
+    }
+
     std::string str = f.to_s();
 
     std::string new_str;
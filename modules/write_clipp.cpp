@@ -34,6 +34,22 @@
  *
  * If multiple actions fire, the last overrides any former.
  *
+ * Four directives tune capture for always-on use:
+ *
+ * - `WriteClippSampleRate` *n* -- Capture only 1 of every *n* action
+ *   firings (default 1, i.e., all).  Sampling is a deterministic counter,
+ *   so a given corpus replays identically.
+ * - `WriteClippRedactHeader` *name...* -- Replace the values of the named
+ *   headers (case insensitive) with `<redacted>` at capture time, so
+ *   sensitive headers never reach disk.
+ * - `WriteClippBufferSize` *bytes* -- Buffer serialized inputs in memory
+ *   and write them in batches of at least *bytes* (default 0:
+ *   every input is written immediately).  Buffered data is flushed at
+ *   exit; a crash may lose the tail.
+ * - `WriteClippRotateSize` *bytes* -- Write to numbered files
+ *   (*path*.0, *path*.1, ...), advancing whenever the current file
+ *   exceeds *bytes* (default 0: write to *path* without rotation).
+ *
  * @warning These actions can have a significant performance impact in both
  *          time and space.
  *
@@ -79,8 +95,18 @@
 #include <ironbeepp/all.hpp>
 
 #include <ironbee/rule_engine.h>
+#include <ironbee/type_convert.h>
 
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 
 using namespace std;
 using namespace IronBee;
@@ -92,6 +118,104 @@ static const char* c_tx_action = "write_clipp_tx";
 //! Name of action to write rest of connection.
 static const char* c_conn_action = "write_clipp_conn";
 
+/**
+ * Buffered, rotating writer for one output path.
+ *
+ * Serialized inputs from any thread are appended under a mutex and
+ * written out in batches once the buffer threshold is reached, so capture
+ * does not pay file I/O per transaction.  With rotation enabled, output
+ * goes to numbered files (path.0, path.1, ...), advancing whenever the
+ * current file exceeds the size cap.
+ **/
+class BufferedWriter
+{
+public:
+    explicit
+    BufferedWriter(const string& path) :
+        m_path(path),
+        m_rotate_size(0),
+        m_index(0),
+        m_bytes_written(0)
+    {
+        // nop
+    }
+
+    ~BufferedWriter()
+    {
+        boost::lock_guard<boost::mutex> guard(m_mutex);
+        flush();
+    }
+
+    /**
+     * Append @a data, flushing at @a buffer_size bytes.
+     *
+     * @param[in] data        Serialized input to append.
+     * @param[in] buffer_size Flush threshold; 0 flushes every append.
+     * @param[in] rotate_size Rotation threshold; 0 disables rotation.
+     **/
+    void append(const string& data, size_t buffer_size, size_t rotate_size)
+    {
+        boost::lock_guard<boost::mutex> guard(m_mutex);
+        m_rotate_size = rotate_size;
+        m_buffer += data;
+        if (m_buffer.size() >= buffer_size) {
+            flush();
+        }
+    }
+
+private:
+    //! Write the buffer out.  Call with @c m_mutex held.
+    void flush()
+    {
+        if (m_buffer.empty()) {
+            return;
+        }
+        if (! m_file.is_open()) {
+            string target = m_path;
+            if (m_rotate_size > 0) {
+                target += "." + boost::lexical_cast<string>(m_index);
+            }
+            m_file.open(target.c_str(), ios::binary | ios::app);
+            m_file.seekp(0, ios::end);
+            m_bytes_written = m_file.tellp();
+        }
+        m_file.write(m_buffer.data(), m_buffer.size());
+        m_file.flush();
+        m_bytes_written += m_buffer.size();
+        m_buffer.clear();
+        if (m_rotate_size > 0 && m_bytes_written >= m_rotate_size) {
+            m_file.close();
+            ++m_index;
+            m_bytes_written = 0;
+        }
+    }
+
+    string        m_path;
+    boost::mutex  m_mutex;
+    string        m_buffer;
+    ofstream      m_file;
+    size_t        m_rotate_size;
+    size_t        m_index;
+    size_t        m_bytes_written;
+};
+
+//! Pointer to BufferedWriter.
+typedef boost::shared_ptr<BufferedWriter> writer_p;
+
+//! Writer for @a path, shared by every user of that path.
+writer_p writer_for(const string& path)
+{
+    static boost::mutex           s_mutex;
+    static map<string, writer_p>  s_writers;
+
+    boost::lock_guard<boost::mutex> guard(s_mutex);
+    writer_p& writer = s_writers[path];
+    if (! writer) {
+        writer.reset(new BufferedWriter(path));
+    }
+    return writer;
+}
+
 /**
  * Per connection data.
  *
@@ -186,6 +310,45 @@ private:
      * @param[in] connection Current connection.
      **/
     void on_connection_close(Connection connection) const;
+
+    //! Handle @c WriteClippSampleRate.
+    void sample_rate_directive(
+        ConfigurationParser cp,
+        const char*         name,
+        const char*         param1
+    );
+
+    //! Handle @c WriteClippRedactHeader.
+    void redact_header_directive(
+        ConfigurationParser cp,
+        const char*         name,
+        List<const char*>   params
+    );
+
+    //! Handle @c WriteClippBufferSize.
+    void buffer_size_directive(
+        ConfigurationParser cp,
+        const char*         name,
+        const char*         param1
+    );
+
+    //! Handle @c WriteClippRotateSize.
+    void rotate_size_directive(
+        ConfigurationParser cp,
+        const char*         name,
+        const char*         param1
+    );
+
+    //! Capture 1 of every this many action firings.
+    size_t m_sample_rate;
+    //! Action firings seen; drives sampling.
+    mutable size_t m_firings;
+    //! Lowercased names of headers to redact at capture.
+    set<string> m_redact;
+    //! Flush threshold of output writers; 0 writes immediately.
+    size_t m_buffer_size;
+    //! Rotation threshold of output files; 0 disables rotation.
+    size_t m_rotate_size;
 };
 
 /**
@@ -199,36 +362,44 @@ CLIPP::Input::input_p start_input(Connection connection);
 /**
  * Finish an input.
  *
- * @param[in] input Input to write out.
- * @param[in] to    Where to write it.  Empty string means cerr.
+ * @param[in] input       Input to write out.
+ * @param[in] to          Where to write it.  Empty string means cerr.
+ * @param[in] buffer_size Writer flush threshold; 0 writes immediately.
+ * @param[in] rotate_size Output rotation threshold; 0 disables rotation.
  **/
 void finish_input(
     const CLIPP::Input::input_p& input,
-    const char*                  to
+    const char*                  to,
+    size_t                       buffer_size,
+    size_t                       rotate_size
 );
 
 /**
  * Add headers starting with @a first to @a e.
  *
- * @param[in] mm    MemoryManager to allocate from.
- * @param[in] e     HeaderEvent to add headers to.
- * @param[in] first Beginning of list of headers.
+ * @param[in] mm     MemoryManager to allocate from.
+ * @param[in] e      HeaderEvent to add headers to.
+ * @param[in] first  Beginning of list of headers.
+ * @param[in] redact Lowercased names of headers whose values to redact.
  **/
 void add_headers(
     MemoryManager              mm,
     CLIPP::Input::HeaderEvent& e,
-    ConstParsedHeader          first
+    ConstParsedHeader          first,
+    const set<string>&         redact
 );
 
 /**
  * Add transaction @a tx to @a input.
  *
- * @param[in] input Input to add transaction to.
- * @param[in] tx    Transaction to add.
+ * @param[in] input  Input to add transaction to.
+ * @param[in] tx     Transaction to add.
+ * @param[in] redact Lowercased names of headers whose values to redact.
  **/
 void add_transaction(
     const CLIPP::Input::input_p& input,
-    ConstTransaction             tx
+    ConstTransaction             tx,
+    const set<string>&           redact
 );
 
 /**
@@ -277,7 +448,11 @@ IBPP_BOOTSTRAP_MODULE_DELEGATE("constant", Delegate)
 namespace {
 
 Delegate::Delegate(IronBee::Module module) :
-    IronBee::ModuleDelegate(module)
+    IronBee::ModuleDelegate(module),
+    m_sample_rate(1),
+    m_firings(0),
+    m_buffer_size(0),
+    m_rotate_size(0)
 {
     using boost::bind;
 
@@ -303,6 +478,92 @@ Delegate::Delegate(IronBee::Module module) :
         c_conn_action,
         bind(&Delegate::action_generator, this, true, _1, _3)
     ).register_with(module.engine());
+
+    module.engine().register_configuration_directives()
+        .param1(
+            "WriteClippSampleRate",
+            bind(&Delegate::sample_rate_directive, this, _1, _2, _3)
+        )
+        .list(
+            "WriteClippRedactHeader",
+            bind(&Delegate::redact_header_directive, this, _1, _2, _3)
+        )
+        .param1(
+            "WriteClippBufferSize",
+            bind(&Delegate::buffer_size_directive, this, _1, _2, _3)
+        )
+        .param1(
+            "WriteClippRotateSize",
+            bind(&Delegate::rotate_size_directive, this, _1, _2, _3)
+        )
+        ;
+}
+
+void Delegate::sample_rate_directive(
+    ConfigurationParser cp,
+    const char*         name,
+    const char*         param1
+)
+{
+    ib_num_t num;
+    throw_if_error(ib_type_atoi(param1, 10, &num));
+    if (num < 1) {
+        BOOST_THROW_EXCEPTION(
+            einval() << errinfo_what(
+                "WriteClippSampleRate must be at least 1."
+            )
+        );
+    }
+    m_sample_rate = num;
+}
+
+void Delegate::redact_header_directive(
+    ConfigurationParser cp,
+    const char*         name,
+    List<const char*>   params
+)
+{
+    BOOST_FOREACH(const char* param, params) {
+        string header(param);
+        transform(header.begin(), header.end(), header.begin(), ::tolower);
+        m_redact.insert(header);
+    }
+}
+
+void Delegate::buffer_size_directive(
+    ConfigurationParser cp,
+    const char*         name,
+    const char*         param1
+)
+{
+    ib_num_t num;
+    throw_if_error(ib_type_atoi(param1, 10, &num));
+    if (num < 0) {
+        BOOST_THROW_EXCEPTION(
+            einval() << errinfo_what(
+                "WriteClippBufferSize must be non-negative."
+            )
+        );
+    }
+    m_buffer_size = num;
+}
+
+void Delegate::rotate_size_directive(
+    ConfigurationParser cp,
+    const char*         name,
+    const char*         param1
+)
+{
+    ib_num_t num;
+    throw_if_error(ib_type_atoi(param1, 10, &num));
+    if (num < 0) {
+        BOOST_THROW_EXCEPTION(
+            einval() << errinfo_what(
+                "WriteClippRotateSize must be non-negative."
+            )
+        );
+    }
+    m_rotate_size = num;
 }
 
 Action::action_instance_t Delegate::action_generator(
@@ -327,6 +588,14 @@ void Delegate::action_execute(
 {
     assert(rule_exec);
 
+    /* Deterministic 1-in-N sampling of action firings. */
+    if (m_sample_rate > 1) {
+        size_t firing = __sync_fetch_and_add(&m_firings, 1);
+        if (firing % m_sample_rate != 0) {
+            return;
+        }
+    }
+
     Connection conn(rule_exec->tx->conn);
     per_connection_p per_connection;
     try {
@@ -364,7 +633,7 @@ void Delegate::on_logging(Transaction tx) const
     if (! per_connection->input) {
         per_connection->input = start_input(tx.connection());
     }
-    add_transaction(per_connection->input, tx);
+    add_transaction(per_connection->input, tx, m_redact);
     if (! per_connection->all_tx) {
 
         const char* to = per_connection->to;
@@ -377,7 +646,7 @@ void Delegate::on_logging(Transaction tx) const
             to = to_s.c_str();
         }
 
-        finish_input(per_connection->input, to);
+        finish_input(per_connection->input, to, m_buffer_size, m_rotate_size);
         per_connection->active = false;
         per_connection->input.reset();
     }
@@ -414,7 +683,7 @@ void Delegate::on_connection_close(Connection connection) const
         to = to_s.c_str();
     }
 
-    finish_input(per_connection->input, to);
+    finish_input(per_connection->input, to, m_buffer_size, m_rotate_size);
     per_connection->active = false;
     per_connection->input.reset();
 }
@@ -485,7 +754,12 @@ CLIPP::Input::input_p start_input(Connection connection)
     return input;
 }
 
-void finish_input(const CLIPP::Input::input_p& input, const char* to)
+void finish_input(
+    const CLIPP::Input::input_p& input,
+    const char*                  to,
+    size_t                       buffer_size,
+    size_t                       rotate_size
+)
 {
     input->connection.connection_closed();
 
@@ -494,15 +768,21 @@ void finish_input(const CLIPP::Input::input_p& input, const char* to)
         consumer(input);
     }
     else {
-        CLIPP::PBConsumer consumer(to);
-        consumer(input);
+        /* Serialize here; the shared writer batches and rotates. */
+        ostringstream record;
+        {
+            CLIPP::PBConsumer consumer(record);
+            consumer(input);
+        }
+        writer_for(to)->append(record.str(), buffer_size, rotate_size);
     }
 }
 
 void add_headers(
     MemoryManager              mm,
     CLIPP::Input::HeaderEvent& e,
-    ConstParsedHeader          first
+    ConstParsedHeader          first,
+    const set<string>&         redact
 )
 {
     for (
@@ -511,6 +791,17 @@ void add_headers(
         h = h.next()
     )
     {
+        if (! redact.empty()) {
+            string name(h.name().const_data(), h.name().length());
+            transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if (redact.count(name)) {
+                e.add(
+                    bs_to_buf(mm, h.name()),
+                    s_to_buf(mm, "<redacted>")
+                );
+                continue;
+            }
+        }
         e.add(
             bs_to_buf(mm, h.name()),
             bs_to_buf(mm, h.value())
@@ -518,7 +809,11 @@ void add_headers(
     }
 }
 
-void add_transaction(const CLIPP::Input::input_p& input, ConstTransaction tx)
+void add_transaction(
+    const CLIPP::Input::input_p& input,
+    ConstTransaction             tx,
+    const set<string>&           redact
+)
 {
     CLIPP::Input::Transaction& clipp_tx = input->connection.add_transaction();
     MemoryManager mm = tx.connection().memory_manager();
@@ -530,7 +825,7 @@ void add_transaction(const CLIPP::Input::input_p& input, ConstTransaction tx)
         bs_to_buf(mm, tx.request_line().protocol())
     );
 
-    add_headers(mm, clipp_tx.request_header(), tx.request_header());
+    add_headers(mm, clipp_tx.request_header(), tx.request_header(), redact);
     clipp_tx.request_header_finished();
 
     clipp_tx.request_body(
@@ -546,7 +841,7 @@ void add_transaction(const CLIPP::Input::input_p& input, ConstTransaction tx)
         bs_to_buf(mm, tx.response_line().message())
     );
 
-    add_headers(mm, clipp_tx.response_header(), tx.response_header());
+    add_headers(mm, clipp_tx.response_header(), tx.response_header(), redact);
     clipp_tx.response_header_finished();
 
     clipp_tx.response_body(
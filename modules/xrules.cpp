@@ -554,7 +554,7 @@ XRulesModule::XRulesModule(IronBee::Module module) :
         )
         .context_close(
             boost::bind(
-                &XRulesModule::build_ip_xrule,
+                &XRulesModule::build_compiled_xrules,
                 this,
                 _1,
                 _2
@@ -644,11 +644,22 @@ XRulesModule::XRulesModule(IronBee::Module module) :
     module.set_configuration_data<XRulesModuleConfig>(module);
 }
 
-void XRulesModule::build_ip_xrule(IronBee::Engine ib, IronBee::Context ctx) {
+void XRulesModule::build_compiled_xrules(
+    IronBee::Engine ib,
+    IronBee::Context ctx
+) {
     XRulesModuleConfig &cfg =
         module().configuration_data<XRulesModuleConfig>(ctx);
 
     cfg.req_xrules.push_back(xrule_ptr(new XRuleIP(cfg)));
+
+    if (!cfg.path_list.empty()) {
+        cfg.req_xrules.push_back(xrule_ptr(new XRulePathTree(cfg)));
+    }
+
+    if (!cfg.time_list.empty()) {
+        cfg.req_xrules.push_back(xrule_ptr(new XRuleTimeSet(cfg)));
+    }
 }
 
 void XRulesModule::disable_xrule_events(IronBee::Engine ib, IronBee::Transaction tx) {
@@ -816,9 +827,9 @@ void XRulesModule::xrule_directive(
             ": "+
             action->logevent_msg();
         action->logevent_tag() = "xrule/path";
-        cfg.req_xrules.push_back(
-            xrule_ptr(
-                new XRulePath(params.front(), action)));
+        cfg.path_list.push_back(
+            XRulesModuleConfig::path_entry_t(
+                std::string(params.front()), action));
     }
     else if (boost::iequals(name_str, "XRuleTime")) {
         action->logevent_msg() =
@@ -827,9 +838,8 @@ void XRulesModule::xrule_directive(
             ": "+
             action->logevent_msg();
         action->logevent_tag() = "xrule/time";
-        cfg.req_xrules.push_back(
-            xrule_ptr(
-                new XRuleTime(cp, params.front(), action)));
+        cfg.time_list.push_back(
+            XRuleTimeSet::parse_window(cp, params.front(), action));
     }
     else if (boost::iequals(name_str, "XRuleRequestContentType")) {
         action->logevent_msg() =
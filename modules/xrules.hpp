@@ -53,7 +53,10 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <stdint.h>
+
 #include <string>
+#include <utility>
 #include <vector>
 
 class Action;
@@ -412,12 +415,35 @@ public:
     virtual ~XRule();
 };
 
+/**
+ * A parsed XRuleTime window.
+ *
+ * Windows are collected during configuration and compiled into a single
+ * XRuleTimeSet when the configuration context closes.  All times are
+ * plain seconds so the per-transaction check is integer comparison.
+ */
+struct XRuleTimeWindow {
+    int32_t    offset;   //!< Time zone offset, in seconds.
+    int32_t    start;    //!< Window start, in seconds of the local day.
+    int32_t    end;      //!< Window end, in seconds of the local day.
+    uint8_t    day_mask; //!< Bit @c d set = window applies on day @c d
+                         //!< (0 = Sunday).  Zero means every day.
+    bool       invert;   //!< Match outside the window instead of inside.
+    action_ptr action;   //!< Action to apply on match.
+};
+
 /**
  * Module configuration.
  */
 class XRulesModuleConfig {
 
 public:
+    //! A path prefix and the action it carries.
+    typedef std::pair<std::string, action_ptr> path_entry_t;
+
+    //! List of path prefixes and their actions.
+    typedef std::vector<path_entry_t> path_list_t;
+
     //! Are XRules enabled for this context.
     bool generate_events;
 
@@ -427,6 +453,12 @@ public:
     //! List of IPv6 configurations.
     std::vector<ib_ipset6_entry_t> ipv6_list;
 
+    //! Path prefixes and their actions, compiled into an XRulePathTree.
+    path_list_t path_list;
+
+    //! Time windows, compiled into an XRuleTimeSet.
+    std::vector<XRuleTimeWindow> time_list;
+
     //! List of xrules to execute for the request.
     std::list<xrule_ptr> req_xrules;
 
@@ -485,12 +517,15 @@ private:
     /**
      * Context close callback.
      *
-     * Currently this will only roll-up IP checks into a single IP check rule.
+     * Rolls the IP checks up into a single IP check rule and compiles
+     * the collected path prefixes and time windows into an XRulePathTree
+     * and an XRuleTimeSet, so each is a single indexed check per
+     * transaction instead of one rule per directive.
      *
      * @param[in] ib IronBee engine.
      * @param[in] ctx IronBee configuration context.
      */
-    void build_ip_xrule(IronBee::Engine ib, IronBee::Context ctx);
+    void build_compiled_xrules(IronBee::Engine ib, IronBee::Context ctx);
 
     /**
      * Disable XRules event generation.
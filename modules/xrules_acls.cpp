@@ -31,6 +31,8 @@
 #include <ironbee/logevent.h>
 #include <ironbee/string.h>
 
+#include <algorithm>
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #if __has_warning("-Wunused-local-typedef")
@@ -430,43 +432,94 @@ void XRuleContentType::xrule_impl(
 }
 /* End XRuleContentType Impl */
 
-/* XRulePath Impl */
-XRulePath::XRulePath(const char *path, action_ptr action)
-:
-    XRule(action),
-    m_path(path)
-{}
+/* XRulePathTree Impl */
+XRulePathTree::XRulePathTree(XRulesModuleConfig& cfg)
+{
+    /* Node 0 is the root. */
+    m_nodes.resize(1);
 
-void XRulePath::xrule_impl(
+    BOOST_FOREACH(XRulesModuleConfig::path_list_t::reference p, cfg.path_list)
+    {
+        /* Walk the prefix into the trie, adding nodes as needed.
+         * Indexes are used because push_back may reallocate m_nodes. */
+        size_t node = 0;
+        BOOST_FOREACH(char c, p.first) {
+            std::map<char, size_t>::const_iterator itr =
+                m_nodes[node].children.find(c);
+            if (itr == m_nodes[node].children.end()) {
+                m_nodes.push_back(node_t());
+                m_nodes[node].children[c] = m_nodes.size() - 1;
+                node = m_nodes.size() - 1;
+            }
+            else {
+                node = itr->second;
+            }
+        }
+
+        m_nodes[node].actions.push_back(p.second);
+    }
+}
+
+void XRulePathTree::xrule_impl(
     IronBee::Transaction tx,
     ActionSet&            actions
 )
 {
-    if (actions.overrides(m_action)) {
-        const std::string tx_path(tx.ib()->path);
+    const char *tx_path = tx.ib()->path;
 
-        if (tx_path.length() >= m_path.length() &&
-            tx_path.compare(0, m_path.length(), m_path) == 0)
-        {
-            actions.set(m_action);
+    ib_log_debug_tx(tx.ib(), "Checking path %s", tx_path);
+
+    /* Walk the path through the trie. Every node reached marks the end
+     * of a matched prefix; apply its actions. */
+    size_t node = 0;
+    for (const char *c = tx_path; ; ++c) {
+        BOOST_FOREACH(action_ptr& action, m_nodes[node].actions) {
+            ib_log_debug_tx(tx.ib(), "Path matched %s", tx_path);
+            actions.set(action);
         }
-    }
-    else {
-        ib_log_debug_tx(
-            tx.ib(),
-            "Skipping rule as action does not override tx actions.");
+
+        if (*c == '\0') {
+            break;
+        }
+
+        std::map<char, size_t>::const_iterator itr =
+            m_nodes[node].children.find(*c);
+        if (itr == m_nodes[node].children.end()) {
+            break;
+        }
+
+        node = itr->second;
     }
 }
-/* End XRulePath Impl */
+/* End XRulePathTree Impl */
 
-/* XRuleTime Impl */
-XRuleTime::XRuleTime(
+/* XRuleTimeSet Impl */
+
+namespace {
+
+//! Order XRuleTimeWindow values by start second.
+bool time_window_less(
+    const XRuleTimeWindow& a,
+    const XRuleTimeWindow& b
+)
+{
+    return a.start < b.start;
+}
+
+} // anonymous namespace
+
+XRuleTimeSet::XRuleTimeSet(XRulesModuleConfig& cfg)
+:
+    m_windows(cfg.time_list.begin(), cfg.time_list.end())
+{
+    std::sort(m_windows.begin(), m_windows.end(), time_window_less);
+}
+
+XRuleTimeWindow XRuleTimeSet::parse_window(
     IronBee::ConfigurationParser cp,
     const char *time,
     action_ptr action
-) :
-    XRule(action),
-    m_invert(false)
+)
 {
     assert(time);
 
@@ -484,9 +537,10 @@ XRuleTime::XRuleTime(
         );
     }
 
-    if (mr[1] == "!") {
-        m_invert = true;
-    }
+    XRuleTimeWindow window;
+    window.day_mask = 0;
+    window.invert   = (mr[1] == "!");
+    window.action   = action;
 
     /* Parse comma-separated days. */
     if (mr[2].length() > 0) {
@@ -498,19 +552,29 @@ XRuleTime::XRuleTime(
         while (boost::regex_match(c, days_mr, days_re)) {
 
             /* Convert the front of the match to a digit. */
-            m_days.insert(atoi(days_mr[1].first));
+            window.day_mask |= 1 << (atoi(days_mr[1].first) % 7);
 
             /* Advance c past it's match and the , or @ character. */
             c += days_mr[1].length() + 1;
         }
     }
 
-    parse_date_time(cp, mr[3].first, m_start_time);
-    parse_date_time(cp, mr[4].first, m_end_time);
-    parse_time_zone(cp, mr[5].first, m_zone_info);
+    boost::posix_time::ptime start_time;
+    boost::posix_time::ptime end_time;
+    boost::local_time::time_zone_ptr zone_info;
+
+    parse_date_time(cp, mr[3].first, start_time);
+    parse_date_time(cp, mr[4].first, end_time);
+    parse_time_zone(cp, mr[5].first, zone_info);
+
+    window.offset = zone_info->base_utc_offset().total_seconds();
+    window.start  = start_time.time_of_day().total_seconds();
+    window.end    = end_time.time_of_day().total_seconds();
+
+    return window;
 }
 
-void XRuleTime::parse_time_zone(
+void XRuleTimeSet::parse_time_zone(
     IronBee::ConfigurationParser      cp,
     const char*                       str,
     boost::local_time::time_zone_ptr& zone
@@ -554,7 +618,7 @@ void XRuleTime::parse_time_zone(
     }
 }
 
-void XRuleTime::parse_date_time(
+void XRuleTimeSet::parse_date_time(
     IronBee::ConfigurationParser  cp,
     const char                   *str,
     boost::posix_time::ptime&     p
@@ -584,65 +648,63 @@ void XRuleTime::parse_date_time(
     }
 }
 
-void XRuleTime::xrule_impl(
+void XRuleTimeSet::xrule_impl(
     IronBee::Transaction  tx,
     ActionSet&            actions
 )
 {
-    if (actions.overrides(m_action)) {
+    /* Compute the UTC start second and day of week once. */
+    boost::posix_time::ptime tx_start = tx.started_time();
+
+    const int32_t utc_sec =
+        tx_start.time_of_day().total_seconds();
+    const int     utc_dow =
+        boost::gregorian::gregorian_calendar::day_of_week(
+            tx_start.date().year_month_day());
+
+    ib_log_debug_tx(
+        tx.ib(),
+        "Checking current time %d (day %d) against %zu windows.",
+        static_cast<int>(utc_sec),
+        utc_dow,
+        m_windows.size());
+
+    BOOST_FOREACH(XRuleTimeWindow& w, m_windows) {
+
+        /* Shift into the window's time zone, carrying into the
+         * adjacent day when the shift crosses midnight. */
+        int32_t sec = utc_sec + w.offset;
+        int     dow = utc_dow;
+        if (sec >= 86400) {
+            sec -= 86400;
+            dow = (dow + 1) % 7;
+        }
+        else if (sec < 0) {
+            sec += 86400;
+            dow = (dow + 6) % 7;
+        }
 
-        /* Get tx start time, shifted into the local time zone. */
-        boost::posix_time::ptime tx_start =
-            tx.started_time() + m_zone_info->base_utc_offset();
-
-        std::ostringstream os;
-        std::locale loc(
-            os.getloc(),
-            new boost::posix_time::time_facet("%H:%M:%S"));
-        os.imbue(loc);
-        os << "Checking current time "
-           << tx_start
-           << " against window "
-           << m_start_time
-           << "-"
-           << m_end_time
-           << ".";
-        ib_log_debug_tx(tx.ib(), "%s", os.str().c_str());
-
-        bool in_window = (
-            m_start_time.time_of_day() <= tx_start.time_of_day() &&
-            tx_start.time_of_day()     <  m_end_time.time_of_day()
-        );
+        bool in_window = (w.start <= sec && sec < w.end);
 
         // If any days of the week are specified in our window...
-        if (m_days.size() > 0) {
-            // ...get the day of the week...
-            short dow =
-                boost::gregorian::gregorian_calendar::day_of_week(
-                    tx_start.date().year_month_day());
-
-            // ...and update the in_window boolean.
-            in_window &= (m_days.find(dow) != m_days.end());
+        if (w.day_mask != 0) {
+            // ...update the in_window boolean.
+            in_window &= ((w.day_mask >> dow) & 1) != 0;
         }
 
         // If we are in the window specified (considering the
-        // m_invert member) then execute the associated action.
-        if (in_window ^ m_invert) {
+        // invert flag) then execute the associated action.
+        if (in_window ^ w.invert) {
             ib_log_debug_tx(tx.ib(), "XRuleTime was matched.");
-            actions.set(m_action);
+            actions.set(w.action);
         }
         else {
             ib_log_debug_tx(tx.ib(), "XRuleTime was not matched.");
         }
     }
-    else {
-        ib_log_debug_tx(
-            tx.ib(),
-            "Skipping rule as action does not override tx actions.");
-    }
 }
 
-/* End XRuleTime Impl */
+/* End XRuleTimeSet Impl */
 
 /* RuleIP Impl */
 XRuleIP::XRuleIP(XRulesModuleConfig& cfg)
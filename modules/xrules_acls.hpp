@@ -311,26 +311,43 @@ private:
 };
 
 /**
- * Check that the request path prefix starts with a known string.
+ * Check the request path against all path prefixes of a context.
+ *
+ * Like XRuleIP, this XRule is constructed when the configuration context
+ * closes and compiles every XRulePath directive of the context into a
+ * single structure --- here a byte-wise prefix trie --- so one walk of
+ * the request path finds every matching prefix, however many path rules
+ * the context carries.
  */
-class XRulePath : public XRule {
+class XRulePathTree : public XRule {
 
 public:
 
     /**
-     * Constructor.
+     * Build the path trie for the closing configuration context.
      *
-     * @param[in] path The path prefix to match.
-     * @param[in] action Action to take on match.
+     * @param[in] cfg The configuration for the closing configuration
+     *            context.  The path list is used from this configuration
+     *            context to build the trie.
      */
-    XRulePath(const char *path, action_ptr action);
+    explicit XRulePathTree(XRulesModuleConfig& cfg);
 
 private:
-    //! Path to check the HTTP request for.
-    std::string m_path;
+
+    //! A node in the prefix trie.
+    struct node_t {
+        //! Edges to child nodes, keyed by the next path byte.
+        std::map<char, size_t> children;
+
+        //! Actions of the path prefixes ending at this node.
+        std::vector<action_ptr> actions;
+    };
+
+    //! All trie nodes.  Node 0 is the root (the empty prefix).
+    std::vector<node_t> m_nodes;
 
     /**
-     * Check if the request path in @a tx is prefixed with m_path.
+     * Walk the request path through the trie, applying matched actions.
      *
      * @param[in] tx The transaction.
      * @param[in] actions The action set to modify if a match is found.
@@ -342,14 +359,30 @@ private:
 };
 
 /**
- * Check if the start time of a tx falls in (or out of) a time window.
+ * Check the start time of a tx against all time windows of a context.
+ *
+ * Like XRuleIP, this XRule is constructed when the configuration context
+ * closes and compiles every XRuleTime directive of the context into a
+ * single array of integer intervals, sorted by start time.  Evaluating a
+ * transaction is a few integer comparisons per window on a start time
+ * computed once, rather than posix time arithmetic per rule.
  */
-class XRuleTime : public XRule {
+class XRuleTimeSet : public XRule {
 
 public:
 
     /**
-     * Constructor.
+     * Build the time window set for the closing configuration context.
+     *
+     * @param[in] cfg The configuration for the closing configuration
+     *            context.  The time window list is used from this
+     *            configuration context to build the set.
+     */
+    explicit XRuleTimeSet(XRulesModuleConfig& cfg);
+
+    /**
+     * Parse a time window specification.
+     *
      * @param[in] cp Configuration parser.
      * @param[in] time Time window string. This string has a
      *            specific format.
@@ -363,27 +396,17 @@ public:
      *            apply to.
      * @param[in] action The action executed if a given
      *            IronBee::Transaction started in the @a time window.
+     *
+     * @returns The parsed window.
      */
-    XRuleTime(
+    static XRuleTimeWindow parse_window(
         IronBee::ConfigurationParser cp,
         const char *time,
         action_ptr action);
 
 private:
-    //! A set of days of the week (0 through 6 where 0 is Sunday).
-    std::set<int> m_days;
-
-    //! The posix start time for this filter.
-    boost::posix_time::ptime m_start_time;
-
-    //! The posix end time for this filter.
-    boost::posix_time::ptime m_end_time;
-
-    //! Should the rule check result be inverted (outside the window).
-    bool m_invert;
-
-    //! The amount incoming times to be checked are shifted.
-    boost::local_time::time_zone_ptr m_zone_info;
+    //! The time windows of the context, sorted by start second.
+    std::vector<XRuleTimeWindow> m_windows;
 
     /**
      * Parse a time value.
@@ -411,17 +434,18 @@ private:
     );
 
     /**
-     * Check if @a tx is in the time window.
+     * Check every window against IronBee::Transaction::started_time().
      *
-     * The rule check is true if IronBee::Transaction::started_time()
-     * - occurs in any specified days in XRuleTime::m_days
-     * - and occurs at or after the XRuleTime::m_start_time
-     * - and occurs before the XRuleTime::m_end_time.
+     * A window check is true if the start time, shifted into the
+     * window's time zone,
+     * - occurs in any specified days of the window
+     * - and occurs at or after the window start
+     * - and occurs before the window end.
      *
-     * If XRuleTime::m_invert is true, then the rule check is inverted.
+     * If the window is inverted, then the window check is inverted.
      *
-     * If the rule check is true, then the associated action is executed.
-     * Otherwise the action is not executed.
+     * For each true window check the associated action is executed.
+     * Other actions are not executed.
      */
     virtual void xrule_impl(
         IronBee::Transaction tx,
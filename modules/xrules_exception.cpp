@@ -389,9 +389,9 @@ void XRuleException::xrule_directive(
                 val +
                 " matched";
             action->logevent_tag() = "xrules/path";
-            cfg.req_xrules.push_back(
-                xrule_ptr(
-                    new XRulePath(val, action)));
+            cfg.path_list.push_back(
+                XRulesModuleConfig::path_entry_t(
+                    std::string(val), action));
         }
         else if (IB_OK == parse_arg("Param:", param, &val)) {
             action->logevent_msg() = std::string("Param ") + val + " matched";
@@ -443,9 +443,8 @@ void XRuleException::xrule_directive(
         else if (IB_OK == parse_arg("Time:", param, &val)) {
             action->logevent_msg() = std::string("Time ") + val + " matched";
             action->logevent_tag() = "xrule/time";
-            cfg.req_xrules.push_back(
-                xrule_ptr(
-                    new XRuleTime(cp, val, action)));
+            cfg.time_list.push_back(
+                XRuleTimeSet::parse_window(cp, val, action));
         }
         else {
             BOOST_THROW_EXCEPTION(
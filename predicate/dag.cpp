@@ -203,6 +203,14 @@ void Node::pre_eval(Environment environment, NodeReporter reporter)
 void Node::set_index(size_t index)
 {
     m_index = index;
+
+    // Indexing happens once the graph is frozen, so children will no
+    // longer change; snapshot them into a contiguous array for evaluation.
+    m_indexed_children.clear();
+    m_indexed_children.reserve(m_children.size());
+    BOOST_FOREACH(const node_p& child, m_children) {
+        m_indexed_children.push_back(child.get());
+    }
 }
 
 void Node::eval_initialize(
@@ -30,6 +30,8 @@
 
 #include <ironbee/rule_engine.h>
 
+#include <boost/foreach.hpp>
+
 using namespace std;
 
 namespace IronBee {
@@ -159,6 +161,34 @@ void NodeEvalState::append_to_list(Value value)
     m_local_values.push_back(value);
 }
 
+void NodeEvalState::append_to_list(ConstList<Value> values)
+{
+    if (is_forwarding()) {
+        BOOST_THROW_EXCEPTION(
+            einval() << errinfo_what(
+                "Can't add value to forwarded node."
+            )
+        );
+    }
+    if (is_finished()) {
+        BOOST_THROW_EXCEPTION(
+            IronBee::einval() << errinfo_what(
+                "Can't add value to finished node."
+            )
+        );
+    }
+    if (! m_local_values) {
+        BOOST_THROW_EXCEPTION(
+            IronBee::einval() << errinfo_what(
+                "Attempting to add value before setting up local list."
+            )
+        );
+    }
+    BOOST_FOREACH(const Value& value, values) {
+        m_local_values.push_back(value);
+    }
+}
+
 void NodeEvalState::finish()
 {
     if (is_forwarding()) {
@@ -289,12 +319,25 @@ GraphEvalProfileData* GraphEvalProfileData::parent() const {
 GraphEvalState::GraphEvalState(size_t index_limit):
     m_vector(index_limit),
     m_initialized(index_limit),
+    m_settled(index_limit),
     m_profile(false),
     m_parent_profile_data(NULL)
 {
     // nop
 }
 
+void GraphEvalState::reset()
+{
+    // Assignment releases per-transaction state (values, lists, any's) held
+    // by each node state while the vector keeps its allocation.
+    fill(m_vector.begin(), m_vector.end(), NodeEvalState());
+    m_initialized.reset();
+    m_settled.reset();
+    m_profile = false;
+    m_profile_data.clear();
+    m_parent_profile_data = NULL;
+}
+
 NodeEvalState& GraphEvalState::final(const Node* node, EvalContext context)
 {
     size_t index = node->index();
@@ -364,6 +407,12 @@ void GraphEvalState::eval(const Node* node, EvalContext context)
     cout << "EVAL " << node->to_s() << endl;
 #endif
 
+    // Settled nodes are finished and can never change value again; skip
+    // all further bookkeeping.
+    if (m_settled[node->index()]) {
+        return;
+    }
+
     // In certain cases, e.g., literals, we run without a context or
     // rule_exec.  Then, always calculate.
     ib_rule_phase_num_t phase = IB_PHASE_NONE;
@@ -401,6 +450,14 @@ void GraphEvalState::eval(const Node* node, EvalContext context)
         }
     }
 
+    // Note eval_calculate() may have forwarded the node; forwarded state
+    // is not final, so re-check before settling.  Settle the node asked
+    // about as well as the end of its forwarding chain.
+    if (! node_eval_state.is_forwarding() && node_eval_state.is_finished()) {
+        m_settled.set(node->index());
+        m_settled.set(final_node->index());
+    }
+
 #ifdef EVAL_TRACE
     cout << "VALUE " << node->to_s() << " = " << value(node->index()) << endl;
 #endif
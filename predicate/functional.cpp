@@ -415,8 +415,8 @@ void Simple::eval(
     value_vec_t args(num_dynamic_args());
 
     size_t i = 0;
-    BOOST_FOREACH(const node_p& child, me->children()) {
-        NodeEvalState& child_nes = ges.final(child.get(), context);
+    BOOST_FOREACH(const Node* child, me->indexed_children()) {
+        NodeEvalState& child_nes = ges.final(child, context);
         if (i >= num_static_args()) {
             if (! child_nes.is_finished()) {
                 return;
@@ -463,8 +463,8 @@ void Primary::eval(
     size_t i = 0;
     size_t n = me->children().size();
     const NodeEvalState* primary_state = NULL;
-    BOOST_FOREACH(const node_p& child, me->children()) {
-        NodeEvalState& child_nes = ges.final(child.get(), context);
+    BOOST_FOREACH(const Node* child, me->indexed_children()) {
+        NodeEvalState& child_nes = ges.final(child, context);
         if (i == n - 1) {
             // Primary argument.
             primary_state = &child_nes;
@@ -44,9 +44,9 @@
 
 #include <ironbee/predicate/bfs.hpp>
 #include <ironbee/predicate/eval.hpp>
+#include <ironbee/predicate/leaves.hpp>
 #include <ironbee/predicate/merge_graph.hpp>
 #include <ironbee/predicate/parse.hpp>
-#include <ironbee/predicate/pre_eval_graph.hpp>
 #include <ironbee/predicate/reporter.hpp>
 #include <ironbee/predicate/standard.hpp>
 #include <ironbee/predicate/standard_template.hpp>
@@ -76,6 +76,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
 
 using namespace std;
 using boost::bind;
@@ -119,6 +120,9 @@ const char* c_profile_directive = "PredicateProfile";
 //! Directory to write profiling information out to.
 const char* c_profile_directive_dir = "PredicateProfileDir";
 
+//! Directive to load a profile layout file.
+const char* c_profile_layout_directive = "PredicateProfileLayout";
+
 //! Directive to define a template.
 const char* c_define_directive = "PredicateDefine";
 
@@ -215,6 +219,28 @@ public:
         IB::ConstTransaction tx
     ) const;
 
+    /**
+     * Acquire a graph evaluation state for a single transaction.
+     *
+     * Reuses a state from this thread's pool when one is available and
+     * constructs one otherwise.  Must be paired with a call to
+     * release_graph_eval_state().  Only valid at runtime, i.e., after
+     * close().
+     *
+     * @return Graph evaluation state; ownership passes to caller.
+     **/
+    P::GraphEvalState* acquire_graph_eval_state() const;
+
+    /**
+     * Return a graph evaluation state acquired from this PerContext.
+     *
+     * Resets @a state and parks it in this thread's pool for reuse by a
+     * later transaction, or deletes it if the pool is full.
+     *
+     * @param[in] state State to return.
+     **/
+    void release_graph_eval_state(P::GraphEvalState* state) const;
+
     //! Turn debug report on.
     void set_debug_report(const string& to);
 
@@ -224,6 +250,19 @@ public:
     //! Set the directory to write profiling files into.
     void set_profile_dir(const string& dir);
 
+    /**
+     * Set the profile layout file.
+     *
+     * The file lists node sexprs, one per line, hottest first; blank lines
+     * and lines starting with # are ignored.  Node indices are assigned in
+     * layout order at context close, so the per-transaction eval state of
+     * hot nodes becomes contiguous while cold subtrees move out of line.
+     * Generate the file from the output of profile_report.rb.
+     *
+     * @param[in] path Path of layout file.
+     **/
+    void set_profile_layout(const string& path);
+
     /**
      * Run internal validations.
      *
@@ -277,9 +316,19 @@ private:
     //! Type of @ref m_roots.
     typedef vector<P::node_cp> roots_t;
 
-    //! Pre-evaluate all nodes.
+    //! Pre-evaluate all nodes, assigning indices and filling @ref m_traversal.
     void pre_evaluate();
 
+    /**
+     * Reorder @a nodes according to @ref m_profile_layout.
+     *
+     * Nodes named in the layout file move to the front in file order;
+     * unnamed nodes keep their breadth first order behind them.
+     *
+     * @param[in, out] nodes Nodes to reorder.
+     **/
+    void apply_profile_layout(vector<P::node_p>& nodes) const;
+
     //! Run MergeGraph through lifecycle.
     void graph_lifecycle();
 
@@ -304,6 +353,8 @@ private:
     bool m_profile;
     //! Where should the profiling information be written to?
     string m_profile_to;
+    //! Path of profile layout file; empty means none.
+    string m_profile_layout;
 
     //! MergeGraph.  Only valid during configuration, i.e., before close().
     boost::scoped_ptr<P::MergeGraph> m_merge_graph;
@@ -322,6 +373,23 @@ private:
 
     //! A breadth-first traversal of roots.begin() to roots.end().
     traversal_t m_traversal;
+
+    //! Type of @ref m_eval_state_pool.
+    typedef vector<P::GraphEvalState*> eval_state_pool_t;
+
+    //! Cleanup function for @ref m_eval_state_pool on thread exit.
+    static void cleanup_eval_state_pool(eval_state_pool_t* pool);
+
+    /**
+     * Per-thread pool of graph evaluation states.
+     *
+     * Graph evaluation states are sized to the graph and reusable after
+     * GraphEvalState::reset(), so they are recycled across transactions
+     * rather than reallocated per transaction.  Pools are per thread, so
+     * no locking is needed; states are acquired and released on the
+     * transaction's worker thread.
+     **/
+    mutable boost::thread_specific_ptr<eval_state_pool_t> m_eval_state_pool;
 };
 
 /**
@@ -336,20 +404,23 @@ public:
     /**
      * Constructor.
      *
-     * Initializes graph evaluation state.
+     * Acquires graph evaluation state from @a per_context 's pool.
      *
-     * @param[in] traversal   The traversal to initialize the nodes by.
+     * @param[in] per_context PerContext this state is for.
      * @param[in] tx          Transaction this state is for.
      * @param[in] profile     Turn on or off profiling.
      * @param[in] profile_t   Where to write profiling information.
      **/
     PerTransaction(
-        const PerContext::traversal_t& traversal,
-        IB::Transaction                tx,
-        bool                           profile,
-        const string&                  profile_to
+        const PerContext& per_context,
+        IB::Transaction   tx,
+        bool              profile,
+        const string&     profile_to
     );
 
+    //! Destructor.  Returns graph evaluation state to the pool.
+    ~PerTransaction();
+
     /**
      * Query a root.
      *
@@ -364,13 +435,13 @@ public:
     P::GraphEvalState& graph_eval_state()
     {
         // Intentionally inline.
-        return m_graph_eval_state;
+        return *m_graph_eval_state;
     }
     //! Access graph eval state.
     const P::GraphEvalState& graph_eval_state() const
     {
         // Intentionally inline.
-        return m_graph_eval_state;
+        return *m_graph_eval_state;
     }
     //! Access profiling state of this graph.
     bool profiler_enabled() const
@@ -386,8 +457,10 @@ public:
     //! Write out the eval graph's current profiling information.
     void write_profile_file();
 private:
-    //! Graph evaluation state.
-    P::GraphEvalState m_graph_eval_state;
+    //! PerContext this state is for; owns the eval state pool.
+    const PerContext& m_per_context;
+    //! Graph evaluation state.  Owned; returned to pool on destruction.
+    P::GraphEvalState* m_graph_eval_state;
     //! Current transaction.
     IB::Transaction m_tx;
     //! Enable/disable profiling.
@@ -488,6 +561,19 @@ private:
         const char*              to
     ) const;
 
+    /**
+     * Handle @ref c_profile_layout_directive.
+     *
+     * See PerContext::set_profile_layout().
+     *
+     * @param[in] cp   Configuration parser.
+     * @param[in] path Path of layout file.
+     **/
+    void dir_profile_layout(
+        IB::ConfigurationParser& cp,
+        const char*              path
+    ) const;
+
     /**
      * Handle @ref c_define_directive.
      *
@@ -575,7 +661,8 @@ PerContext::PerContext(Delegate& delegate) :
     m_write_debug_report(false),
     m_profile(false),
     m_profile_to("/tmp"),
-    m_merge_graph(new P::MergeGraph())
+    m_merge_graph(new P::MergeGraph()),
+    m_eval_state_pool(&PerContext::cleanup_eval_state_pool)
 {
     // nop
 }
@@ -588,9 +675,11 @@ PerContext::PerContext(const PerContext& other) :
     m_debug_report_to(other.m_debug_report_to),
     m_profile(other.m_profile),
     m_profile_to(other.m_profile_to),
+    m_profile_layout(other.m_profile_layout),
     m_merge_graph(
         new P::MergeGraph(*other.m_merge_graph, m_delegate.call_factory())
-    )
+    ),
+    m_eval_state_pool(&PerContext::cleanup_eval_state_pool)
     // Note: Runtime members are not copied.
 {
     // nop
@@ -608,18 +697,11 @@ void PerContext::close(IB::Context context)
 
     // Life cycle.
     graph_lifecycle();
-    // Pre evaluate.
+    // Pre evaluate and index nodes; one sweep for both (see pre_evaluate()).
     pre_evaluate();
 
     roots_t roots;
 
-    // Index nodes.
-    size_t index_limit = 0;
-    P::bfs_down(
-        m_merge_graph->roots().first, m_merge_graph->roots().second,
-        P::make_indexer(index_limit, m_traversal)
-    );
-
     // Build roots
     roots.resize(m_merge_graph->size());
     copy(
@@ -773,6 +855,60 @@ void PerContext::assert_valid() const
     }
 }
 
+/**
+ * Pre-evaluate and collect a node; helper for PerContext::pre_evaluate().
+ *
+ * Pre-evaluation and index assignment each need a full breadth first sweep
+ * of the graph from the roots, so the sweep is done once, pre-evaluating
+ * and collecting the nodes for index assignment.  This halves the graph
+ * traversals done while a context closes, which is the window during which
+ * a reloading engine is not yet serving.  The work itself must stay on one
+ * thread: Node::pre_eval() acquires var sources and creates operator
+ * instances against engine facilities that are not safe to use
+ * concurrently.
+ **/
+class preeval_and_collect_helper
+{
+public:
+    preeval_and_collect_helper(
+        P::reporter_t         reporter,
+        P::Environment        environment,
+        vector<P::node_p>&    nodes
+    ) :
+        m_reporter(reporter),
+        m_environment(environment),
+        m_nodes(nodes)
+    {
+        // nop
+    }
+
+    void operator()(const P::node_p& node)
+    {
+        node->pre_eval(
+            m_environment,
+            P::NodeReporter(m_reporter, node.get())
+        );
+        m_nodes.push_back(node);
+    }
+
+private:
+    P::reporter_t      m_reporter;
+    P::Environment     m_environment;
+    vector<P::node_p>& m_nodes;
+};
+
+//! Order by layout rank only, leaving ties in pre-existing order.
+struct profile_layout_order
+{
+    bool operator()(
+        const pair<size_t, P::node_p>& a,
+        const pair<size_t, P::node_p>& b
+    ) const
+    {
+        return a.first < b.first;
+    }
+};
+
 void PerContext::pre_evaluate()
 {
     size_t num_errors = 0;
@@ -783,11 +919,28 @@ void PerContext::pre_evaluate()
         boost::ref(num_errors),
         _1, _2, _3
     );
-    P::pre_eval_graph(
-        reporter,
-        *m_merge_graph,
-        m_context
+
+    vector<P::node_p> nodes;
+    P::bfs_down(
+        m_merge_graph->roots().first, m_merge_graph->roots().second,
+        boost::make_function_output_iterator(
+            preeval_and_collect_helper(reporter, m_context, nodes)
+        )
     );
+
+    // Node indices determine where per-transaction eval state lives, so
+    // ordering nodes hottest first packs the state of hot nodes together
+    // and moves cold subtrees out of line.
+    if (! m_profile_layout.empty()) {
+        apply_profile_layout(nodes);
+    }
+
+    size_t index_limit = 0;
+    BOOST_FOREACH(const P::node_p& node, nodes) {
+        node->set_index(index_limit);
+        ++index_limit;
+        m_traversal.push_back(node.get());
+    }
     if (num_errors > 0) {
         BOOST_THROW_EXCEPTION(
             IB::einval() << IB::errinfo_what(
@@ -798,6 +951,59 @@ void PerContext::pre_evaluate()
     }
 }
 
+void PerContext::apply_profile_layout(vector<P::node_p>& nodes) const
+{
+    ifstream in(m_profile_layout.c_str());
+    if (! in) {
+        BOOST_THROW_EXCEPTION(
+            IB::einval() << IB::errinfo_what(
+                "Could not read profile layout file: " + m_profile_layout
+            )
+        );
+    }
+
+    map<string, size_t> rank_by_sexpr;
+    string line;
+    size_t rank = 0;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (rank_by_sexpr.insert(make_pair(line, rank)).second) {
+            ++rank;
+        }
+    }
+
+    typedef pair<size_t, P::node_p> keyed_node_t;
+    vector<keyed_node_t> keyed;
+    keyed.reserve(nodes.size());
+    size_t num_matched = 0;
+    BOOST_FOREACH(const P::node_p& node, nodes) {
+        size_t key = numeric_limits<size_t>::max();
+        map<string, size_t>::const_iterator i =
+            rank_by_sexpr.find(node->to_s());
+        if (i != rank_by_sexpr.end()) {
+            key = i->second;
+            ++num_matched;
+        }
+        keyed.push_back(make_pair(key, node));
+    }
+
+    stable_sort(keyed.begin(), keyed.end(), profile_layout_order());
+
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        nodes[i] = keyed[i].second;
+    }
+
+    ib_log_debug(
+        m_delegate.module().engine().ib(),
+        "predicate: profile layout %s matched %zu of %zu node(s).",
+        m_profile_layout.c_str(),
+        num_matched,
+        nodes.size()
+    );
+}
+
 void PerContext::graph_lifecycle()
 {
     ostream* debug_out;
@@ -872,12 +1078,39 @@ void PerContext::graph_lifecycle()
     {
         bool needs_transform = true;
         num_errors = 0;
+        size_t pass_num = 0;
+
+        // First pass sweeps up from every leaf; later passes sweep only
+        // from the subtrees the previous pass introduced, as a transform
+        // result can only change when the node or its descendants did.
+        P::node_list_t seeds;
+        P::node_list_t changed;
+        P::find_leaves(
+            m_merge_graph->roots().first, m_merge_graph->roots().second,
+            back_inserter(seeds)
+        );
+
         while (needs_transform) {
+            ib_time_t pass_start = ib_clock_precise_get_time();
+            changed.clear();
             needs_transform = P::transform_graph(
                 reporter,
                 *m_merge_graph,
                 delegate().call_factory(),
-                m_context
+                m_context,
+                seeds,
+                changed
+            );
+            ++pass_num;
+            ib_log_debug(
+                m_delegate.module().engine().ib(),
+                "predicate: transform pass %zu:"
+                " %zu node(s) changed in %lu usec.",
+                pass_num,
+                changed.size(),
+                static_cast<unsigned long>(
+                    ib_clock_precise_get_time() - pass_start
+                )
             );
             if (num_errors > 0) {
                 BOOST_THROW_EXCEPTION(
@@ -887,6 +1120,25 @@ void PerContext::graph_lifecycle()
                     )
                 );
             }
+
+            // Re-seed from what changed.  A changed node may itself have
+            // been replaced again later in the pass; resolve it first and
+            // drop any that were removed outright.
+            seeds.clear();
+            P::node_list_t live;
+            BOOST_FOREACH(const P::node_p& c, changed) {
+                P::node_p resolved;
+                try {
+                    resolved = m_merge_graph->find_transform(c);
+                }
+                catch (IB::enoent) {
+                    resolved = c;
+                }
+                if (resolved) {
+                    live.push_back(resolved);
+                }
+            }
+            P::find_leaves(live.begin(), live.end(), back_inserter(seeds));
         }
     }
 
@@ -943,7 +1195,7 @@ PerTransaction& PerContext::fetch_per_transaction(IB::Transaction tx) const
     // If failure, initialize px, schedule its destruction and store it.
     if (!px) {
         // Create px.
-        px = new PerTransaction(m_traversal, tx, m_profile, m_profile_to);
+        px = new PerTransaction(*this, tx, m_profile, m_profile_to);
 
         // Schedule px to be destroyed with this tx.
         tx.memory_manager().register_cleanup(
@@ -966,6 +1218,43 @@ const PerTransaction& PerContext::fetch_per_transaction(
     return fetch_per_transaction(IB::Transaction::remove_const(tx));
 }
 
+//! Maximum number of eval states parked per thread per context.
+const size_t c_eval_state_pool_max = 8;
+
+void PerContext::cleanup_eval_state_pool(eval_state_pool_t* pool)
+{
+    BOOST_FOREACH(P::GraphEvalState* state, *pool) {
+        delete state;
+    }
+    delete pool;
+}
+
+P::GraphEvalState* PerContext::acquire_graph_eval_state() const
+{
+    eval_state_pool_t* pool = m_eval_state_pool.get();
+    if (pool && ! pool->empty()) {
+        P::GraphEvalState* state = pool->back();
+        pool->pop_back();
+        return state;
+    }
+    return new P::GraphEvalState(m_traversal.size());
+}
+
+void PerContext::release_graph_eval_state(P::GraphEvalState* state) const
+{
+    eval_state_pool_t* pool = m_eval_state_pool.get();
+    if (! pool) {
+        pool = new eval_state_pool_t();
+        m_eval_state_pool.reset(pool);
+    }
+    if (pool->size() >= c_eval_state_pool_max) {
+        delete state;
+        return;
+    }
+    state->reset();
+    pool->push_back(state);
+}
+
 void PerContext::set_debug_report(const string& to)
 {
     m_write_debug_report = true;
@@ -982,6 +1271,11 @@ void PerContext::set_profile_dir(const string& to)
     m_profile_to = to;
 }
 
+void PerContext::set_profile_layout(const string& path)
+{
+    m_profile_layout = path;
+}
+
 const Delegate& PerContext::delegate() const
 {
     return m_delegate;
@@ -995,17 +1289,23 @@ Delegate& PerContext::delegate()
 // PerTransaction
 
 PerTransaction::PerTransaction(
-    const PerContext::traversal_t&  traversal,
-    IB::Transaction                 tx,
-    bool                            profile,
-    const string&                   profile_to
+    const PerContext& per_context,
+    IB::Transaction   tx,
+    bool              profile,
+    const string&     profile_to
 ) :
-    m_graph_eval_state(traversal.size()),
+    m_per_context(per_context),
+    m_graph_eval_state(per_context.acquire_graph_eval_state()),
     m_tx(tx),
     m_profile(profile),
     m_profile_to(profile_to)
 {
-    m_graph_eval_state.profiler_enabled(m_profile);
+    m_graph_eval_state->profiler_enabled(m_profile);
+}
+
+PerTransaction::~PerTransaction()
+{
+    m_per_context.release_graph_eval_state(m_graph_eval_state);
 }
 
 void PerTransaction::write_profile_file()
@@ -1046,8 +1346,8 @@ void PerTransaction::write_profile_file()
 
     for (
         P::GraphEvalState::profiler_data_list_t::const_iterator i =
-            m_graph_eval_state.profiler_data().begin();
-        i != m_graph_eval_state.profiler_data().end();
+            m_graph_eval_state->profiler_data().begin();
+        i != m_graph_eval_state->profiler_data().end();
         ++i
     )
     {
@@ -1071,15 +1371,15 @@ void PerTransaction::write_profile_file()
     }
 
     profile_out.close();
-    m_graph_eval_state.profiler_clear();
+    m_graph_eval_state->profiler_clear();
 }
 
 IBModPredicateCore::result_t PerTransaction::query(
     const P::node_cp& root
 )
 {
-    m_graph_eval_state.eval(root.get(), m_tx);
-    P::NodeEvalState& nes = m_graph_eval_state.final(root.get(), m_tx);
+    m_graph_eval_state->eval(root.get(), m_tx);
+    P::NodeEvalState& nes = m_graph_eval_state->final(root.get(), m_tx);
 
     return IBModPredicateCore::result_t(
         nes.value(), nes.is_finished()
@@ -1130,6 +1430,10 @@ Delegate::Delegate(IB::Module module) :
             c_profile_directive_dir,
             bind(&Delegate::dir_profile_dir, this, _1, _3)
         )
+        .param1(
+            c_profile_layout_directive,
+            bind(&Delegate::dir_profile_layout, this, _1, _3)
+        )
         .list(
             c_define_directive,
             bind(&Delegate::dir_define, this, _1, _3)
@@ -1230,6 +1534,14 @@ void Delegate::dir_profile_dir(
     fetch_per_context(cp.current_context()).set_profile_dir(to);
 }
 
+void Delegate::dir_profile_layout(
+    IB::ConfigurationParser& cp,
+    const char*              path
+) const
+{
+    fetch_per_context(cp.current_context()).set_profile_layout(path);
+}
+
 void Delegate::dir_define(
     IB::ConfigurationParser& cp,
     IB::List<const char*>    params
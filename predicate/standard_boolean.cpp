@@ -288,8 +288,7 @@ void Or::eval_calculate(
     assert(children().size() >= 2);
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
     bool unfinished_child = false;
-    BOOST_FOREACH(const node_p& childp, children()) {
-        Node *child = childp.get();
+    BOOST_FOREACH(const Node* child, indexed_children()) {
         graph_eval_state.eval(child, context);
         NodeEvalState& child_nes = graph_eval_state.final(child, context);
         if (child_nes.value()) {
@@ -368,8 +367,7 @@ void And::eval_calculate(
     assert(children().size() >= 2);
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
     bool unfinished_child = false;
-    BOOST_FOREACH(const node_p& childp, children()) {
-        const Node* child = childp.get();
+    BOOST_FOREACH(const Node* child, indexed_children()) {
         graph_eval_state.eval(child, context);
         NodeEvalState& nes = graph_eval_state.final(child, context);
         if (nes.is_finished() && ! nes.value()) {
@@ -579,8 +577,7 @@ void OrSC::eval_calculate(
 {
     assert(children().size() >= 2);
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
-    BOOST_FOREACH(const node_p& childp, children()) {
-        const Node* child = childp.get();
+    BOOST_FOREACH(const Node* child, indexed_children()) {
         graph_eval_state.eval(child, context);
         NodeEvalState& child_nes = graph_eval_state.final(child, context);
         if (child_nes.value()) {
@@ -658,8 +655,7 @@ void AndSC::eval_calculate(
 {
     assert(children().size() >= 2);
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
-    BOOST_FOREACH(const node_p& childp, children()) {
-        const Node* child = childp.get();
+    BOOST_FOREACH(const Node* child, indexed_children()) {
         graph_eval_state.eval(child, context);
         NodeEvalState& child_nes = graph_eval_state.final(child, context);
         if (! child_nes.value()) {
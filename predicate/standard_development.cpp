@@ -85,8 +85,7 @@ public:
     ) const
     {
         list<string> value_strings;
-        BOOST_FOREACH(const node_p& childp, children()) {
-            const Node* n = childp.get();
+        BOOST_FOREACH(const Node* n, indexed_children()) {
             graph_eval_state.eval(n, context);
             value_strings.push_back(
                 graph_eval_state.value(n, context).to_s()
@@ -96,7 +95,7 @@ public:
          cerr << boost::algorithm::join(value_strings, "; ") << endl;
 
          const NodeEvalState& primary =
-             graph_eval_state.final(children().back().get(), context);
+             graph_eval_state.final(indexed_children().back(), context);
          NodeEvalState& me = graph_eval_state.node_eval_state(this, context);
          if (primary.is_finished()) {
              if (! me.is_aliased()) {
@@ -30,7 +30,9 @@
 #include <ironbee/predicate/meta_call.hpp>
 #include <ironbee/predicate/validate.hpp>
 
+#include <ironbeepp/connection.hpp>
 #include <ironbeepp/logevent.hpp>
+#include <ironbeepp/module.hpp>
 #include <ironbeepp/operator.hpp>
 #include <ironbeepp/rule.hpp>
 #include <ironbeepp/transformation.hpp>
@@ -66,6 +68,7 @@ const string CALL_NAME_FOPERATOR("foperator");
 const string CALL_NAME_WAITPHASE("waitPhase");
 const string CALL_NAME_ASK("ask");
 const string CALL_NAME_FINISHPHASE("finishPhase");
+const string CALL_NAME_PERCONNECTION("perConnection");
 const string CALL_NAME_GENEVENT("genEvent");
 const string CALL_NAME_SET_PREDICATE_VAR("setPredicateVars");
 const string CLALL_NAME_RULEMSG("ruleMsg");
@@ -327,6 +330,54 @@ private:
     boost::scoped_ptr<data_t> m_data;
 };
 
+/**
+ * Cache the finished value of the only child per connection.
+ *
+ * Subtrees that depend only on connection-level data (e.g., vars derived
+ * from the remote address) produce the same value for every transaction
+ * on a keep-alive connection.  Wrapping such a subtree in perConnection
+ * stores its finished value on the connection the first time it finishes
+ * and replays it, without evaluating the subtree, for later transactions
+ * on the same connection.  Connection-constancy is asserted by the rule
+ * writer; nothing verifies that the child cannot vary per transaction.
+ *
+ * Cached values are duplicated into the connection's memory manager.  The
+ * cache is keyed by node, lives in the predicate core module's per
+ * connection data, and is only touched from the connection's transactions,
+ * which the engine runs sequentially, so no locking is needed.  If the
+ * predicate core module is not loaded (e.g., unit tests), caching is
+ * disabled and perConnection is a pass-through.
+ **/
+class PerConnection :
+    public Call
+{
+public:
+    //! Constructor.
+    PerConnection();
+
+    //! See Call:name()
+    virtual const std::string& name() const;
+
+    //! See Node::validate()
+    virtual bool validate(NodeReporter reporter) const;
+
+    //! See Node::pre_eval()
+    virtual void pre_eval(Environment environment, NodeReporter reporter);
+
+protected:
+    virtual void eval_calculate(
+        GraphEvalState& graph_eval_state,
+        EvalContext     context
+    ) const;
+
+private:
+    //! Hidden complex implementation details.
+    struct data_t;
+
+    //! Hidden complex implementation details.
+    boost::scoped_ptr<data_t> m_data;
+};
+
 /**
  * Ask a dynamic collection a question.
  **/
@@ -674,11 +725,20 @@ void Var::eval_calculate(
         return;
     }
 
-    try {
-        value = Value(m_data->source.get(context.var_store()));
-    }
-    catch (enoent) {
-        return;
+    {
+        // Polling a var that is not set yet is common: unfinished subtrees
+        // are re-evaluated every phase and many vars only appear in later
+        // phases.  Use the C API directly so that absence is a status code
+        // rather than an exception thrown and caught once per phase.
+        const ib_field_t* field = NULL;
+        ib_status_t rc = ib_var_source_get_const(
+            m_data->source.ib(), &field, context.var_store().ib()
+        );
+        if (rc == IB_ENOENT) {
+            return;
+        }
+        throw_if_error(rc);
+        value = Value(field);
     }
 
     if (
@@ -1006,6 +1066,121 @@ void FinishPhase::eval_calculate(
 
 namespace {
 
+//! Per-connection value cache: node to finished value; NULL for null values.
+typedef map<const Node*, const ib_field_t*> per_connection_cache_t;
+
+//! Cleanup function for @ref per_connection_cache_t.
+void delete_per_connection_cache(per_connection_cache_t* cache)
+{
+    delete cache;
+}
+
+}
+
+struct PerConnection::data_t
+{
+    data_t() : enabled(false) {}
+
+    //! Module whose per-connection data slot holds the cache.
+    Module module;
+    //! True iff @ref module was found and caching is enabled.
+    bool enabled;
+};
+
+PerConnection::PerConnection() :
+    m_data(new data_t())
+{
+    // nop
+}
+
+const string& PerConnection::name() const
+{
+    return CALL_NAME_PERCONNECTION;
+}
+
+bool PerConnection::validate(NodeReporter reporter) const
+{
+    return Validate::n_children(reporter, 1);
+}
+
+void PerConnection::pre_eval(Environment environment, NodeReporter reporter)
+{
+    try {
+        m_data->module =
+            Module::with_name(environment.engine(), "predicate_core");
+        m_data->enabled = true;
+    }
+    catch (enoent) {
+        // No predicate core module, e.g., unit tests.  Pass through.
+        m_data->enabled = false;
+    }
+}
+
+void PerConnection::eval_calculate(
+    GraphEvalState& graph_eval_state,
+    EvalContext     context
+) const
+{
+    NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
+
+    Connection conn;
+    per_connection_cache_t* cache = NULL;
+    if (m_data->enabled) {
+        conn = context.connection();
+        try {
+            cache =
+                conn.get_module_data<per_connection_cache_t*>(m_data->module);
+        }
+        catch (enoent) {
+            // No cache on this connection yet.
+        }
+        if (cache) {
+            per_connection_cache_t::const_iterator i = cache->find(this);
+            if (i != cache->end()) {
+                if (i->second) {
+                    my_state.finish(Value(i->second));
+                }
+                else {
+                    my_state.finish();
+                }
+                return;
+            }
+        }
+    }
+
+    const Node* child = children().front().get();
+    graph_eval_state.eval(child, context);
+    NodeEvalState& child_state = graph_eval_state.final(child, context);
+    if (! child_state.is_finished()) {
+        return;
+    }
+
+    Value value = child_state.value();
+    if (m_data->enabled) {
+        if (! cache) {
+            cache = new per_connection_cache_t();
+            conn.memory_manager().register_cleanup(
+                boost::bind(&delete_per_connection_cache, cache)
+            );
+            conn.set_module_data(m_data->module, cache);
+        }
+        if (value) {
+            // Copy from transaction lifetime to connection lifetime.
+            value = value.dup(conn.memory_manager());
+        }
+        (*cache)[this] = value.ib();
+    }
+
+    if (value) {
+        my_state.finish(value);
+    }
+    else {
+        my_state.finish();
+    }
+}
+
+namespace {
+
 bool ask_caseless_compare(char a, char b)
 {
     return (a == b || tolower(a) == tolower(b));
@@ -1754,6 +1929,7 @@ void load_ironbee(CallFactory& to)
         .add("transformation", Functional::generate<Transformation>)
         .add<WaitPhase>()
         .add<FinishPhase>()
+        .add<PerConnection>()
         .add<Ask>()
         ;
 }
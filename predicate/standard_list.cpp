@@ -364,9 +364,7 @@ protected:
     {
         if (primary_value.type() == Value::LIST) {
             if (subvalue.type() == Value::LIST) {
-                BOOST_FOREACH(const Value& v, subvalue.as_list()) {
-                    my_state.append_to_list(v);
-                }
+                my_state.append_to_list(subvalue.as_list());
             }
             else {
                 my_state.append_to_list(subvalue);
@@ -458,7 +456,7 @@ protected:
 /**
  * Implementation details of Cat.
  *
- * To implement Cat, we track two iterators (per thread):
+ * To implement Cat, we track a child index and an iterator (per thread):
  * - last_unfinished is the child we last processed.  That is, the last time
  *   calculate was run, we added all children of last_unfinished but it was
  *   unfinished so we did not advance to the next child.
@@ -487,9 +485,9 @@ public:
      * Set last unfinished child to be first child.
      **/
     explicit
-    cat_impl_t(const Cat& me)
+    cat_impl_t(const Cat&)
     {
-        m_last_unfinished = me.children().begin();
+        m_last_unfinished = 0;
         m_last_value_added_good = false;
     }
 
@@ -507,7 +505,9 @@ public:
         // Add any new children from last_unfinished.
         add_from_current(me, graph_eval_state, context);
         // If last_unfinished is still unfinished, nothing more to do.
-        if (! graph_eval_state.is_finished(m_last_unfinished->get(), context)) {
+        if (! graph_eval_state.is_finished(
+                me.indexed_children()[m_last_unfinished], context
+        )) {
             return;
         }
 
@@ -516,7 +516,7 @@ public:
         add_until_next_unfinished(me, graph_eval_state, context);
 
         // If no new leftmost unfinished child, all done.  Finish.
-        if (m_last_unfinished == me.children().end()) {
+        if (m_last_unfinished == me.indexed_children().size()) {
             graph_eval_state.node_eval_state(&me, context).finish();
         }
         // Otherwise, need to add children from the new last_unfinished.
@@ -538,12 +538,13 @@ private:
         EvalContext     context
     )
     {
-        graph_eval_state.eval(m_last_unfinished->get(), context);
-        Value value = graph_eval_state.value(m_last_unfinished->get(), context);
+        const Node* n = me.indexed_children()[m_last_unfinished];
+        graph_eval_state.eval(n, context);
+        Value value = graph_eval_state.value(n, context);
 
         if (
             ! value &&
-            ! graph_eval_state.is_finished(m_last_unfinished->get(), context)
+            ! graph_eval_state.is_finished(n, context)
         ) {
             return;
         }
@@ -572,7 +573,7 @@ private:
             }
             else {
                 assert(
-                    graph_eval_state.is_finished(m_last_unfinished->get(), context)
+                    graph_eval_state.is_finished(n, context)
                 );
                 graph_eval_state.node_eval_state(&me, context).append_to_list(value);
             }
@@ -592,14 +593,16 @@ private:
         EvalContext     context
     )
     {
-        assert(graph_eval_state.is_finished(m_last_unfinished->get(), context));
+        assert(graph_eval_state.is_finished(
+            me.indexed_children()[m_last_unfinished], context
+        ));
         NodeEvalState& my_state = graph_eval_state.node_eval_state(&me, context);
         for (
             ++m_last_unfinished;
-            m_last_unfinished != me.children().end();
+            m_last_unfinished != me.indexed_children().size();
             ++m_last_unfinished
         ) {
-            const Node* n = m_last_unfinished->get();
+            const Node* n = me.indexed_children()[m_last_unfinished];
             graph_eval_state.eval(n, context);
             if (!graph_eval_state.final(n, context).is_finished()) {
                 break;
@@ -609,9 +612,7 @@ private:
             Value v = nes.value();
             if (v) {
                 if (v.type() == Value::LIST) {
-                    BOOST_FOREACH(Value v, v.as_list()) {
-                        my_state.append_to_list(v);
-                    }
+                    my_state.append_to_list(v.as_list());
                 }
                 else {
                     my_state.append_to_list(v);
@@ -620,8 +621,8 @@ private:
         }
     }
 
-    //! Last unfinished child processed.
-    node_list_t::const_iterator m_last_unfinished;
+    //! Index into Node::indexed_children() of last unfinished child processed.
+    size_t m_last_unfinished;
 
     //! Is m_last_value_added meaningful?
     bool m_last_value_added_good;
@@ -798,8 +799,7 @@ void List::eval_initialize(
 ) const
 {
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this->index());
-    node_list_t::const_iterator last_unfinished = children().begin();
-    my_state.state() = last_unfinished;
+    my_state.state() = size_t(0);
     my_state.setup_local_list(context.memory_manager());
 }
 
@@ -810,10 +810,9 @@ void List::eval_calculate(
 {
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
 
-    node_list_t::const_iterator last_unfinished =
-        boost::any_cast<node_list_t::const_iterator>(my_state.state());
-    while (last_unfinished != children().end()) {
-        const Node* n = last_unfinished->get();
+    size_t last_unfinished = boost::any_cast<size_t>(my_state.state());
+    while (last_unfinished != indexed_children().size()) {
+        const Node* n = indexed_children()[last_unfinished];
         graph_eval_state.eval(n, context);
         NodeEvalState& nes = graph_eval_state.final(n, context);
         Value v = nes.value();
@@ -825,7 +824,7 @@ void List::eval_calculate(
         ++last_unfinished;
     }
 
-    if (last_unfinished == children().end()) {
+    if (last_unfinished == indexed_children().size()) {
         my_state.finish();
     }
 
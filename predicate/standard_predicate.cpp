@@ -354,8 +354,7 @@ void FinishAll::eval_initialize(
 ) const
 {
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this->index());
-    node_list_t::const_iterator last_unfinished = children().begin();
-    my_state.state() = last_unfinished;
+    my_state.state() = size_t(0);
     my_state.setup_local_list(context.memory_manager());
 }
 
@@ -366,16 +365,16 @@ void FinishAll::eval_calculate(
 {
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
 
-    node_list_t::const_iterator last_unfinished = children().end();
+    const node_ptr_vector_t& cs = indexed_children();
+    size_t last_unfinished = cs.size();
 
     for (
-        node_list_t::const_iterator i =
-            boost::any_cast<node_list_t::const_iterator>(my_state.state());
-        i != children().end();
+        size_t i = boost::any_cast<size_t>(my_state.state());
+        i != cs.size();
         ++i
     )
     {
-        const Node *n = i->get();
+        const Node *n = cs[i];
 
         // We may re-check a node that is already done on subsequent evals.
         if (graph_eval_state.is_finished(n, context)) {
@@ -392,13 +391,13 @@ void FinishAll::eval_calculate(
             my_state.append_to_list(v);
         }
         // If i is not finished and last_unfinished == end, update it.
-        else if (last_unfinished == children().end()) {
+        else if (last_unfinished == cs.size()) {
             last_unfinished = i;
         }
     }
 
     // If last_unfinished was never updated to an unfinished i, we are done!
-    if (last_unfinished == children().end()) {
+    if (last_unfinished == cs.size()) {
         my_state.finish();
     }
 
@@ -447,13 +446,7 @@ void FinishAny::eval_calculate(
     EvalContext     context
 ) const
 {
-    for (
-        node_list_t::const_iterator i = children().begin();
-        i != children().end();
-        ++i
-    )
-    {
-        const Node* n = i->get();
+    BOOST_FOREACH(const Node* n, indexed_children()) {
         graph_eval_state.eval(n, context);
         NodeEvalState& nes = graph_eval_state.final(n, context);
 
@@ -236,6 +236,24 @@ TEST_F(TestDAG, DeepCall)
     EXPECT_EQ("(dummy_call (dummy_call (dummy_call (dummy_call))))", n->to_s());
 }
 
+TEST_F(TestDAG, IndexedChildren)
+{
+    node_p p(new DummyCall);
+    node_p c1(new DummyCall);
+    node_p c2(new DummyCall2);
+
+    p->add_child(c1);
+    p->add_child(c2);
+
+    // Not snapshotted until indexed.
+    EXPECT_TRUE(p->indexed_children().empty());
+
+    p->set_index(0);
+    ASSERT_EQ(2UL, p->indexed_children().size());
+    EXPECT_EQ(c1.get(), p->indexed_children()[0]);
+    EXPECT_EQ(c2.get(), p->indexed_children()[1]);
+}
+
 TEST_F(TestDAG, ModifyChildren)
 {
     node_p p(new DummyCall);
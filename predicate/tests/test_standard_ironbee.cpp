@@ -153,6 +153,16 @@ TEST_F(TestStandardIronBee, phase)
     m_transaction.ib()->rule_exec = old_rule_exec;
 }
 
+TEST_F(TestStandardIronBee, perConnection)
+{
+    // No predicate core module in unit tests, so caching is disabled and
+    // perConnection passes its child's value through.
+    EXPECT_EQ("'foo'", eval("(perConnection 'foo')"));
+
+    EXPECT_THROW(eval("(perConnection)"), IronBee::einval);
+    EXPECT_THROW(eval("(perConnection 'a' 'b')"), IronBee::einval);
+}
+
 class TestAsk :
     public Call
 {
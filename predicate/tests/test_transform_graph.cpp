@@ -24,6 +24,7 @@
 
 #include <ironbee/predicate/transform_graph.hpp>
 
+#include <ironbee/predicate/leaves.hpp>
 #include <ironbee/predicate/standard_boolean.hpp>
 #include <ironbee/predicate/parse.hpp>
 #include <ironbee/predicate/merge_graph.hpp>
@@ -81,3 +82,49 @@ TEST_F(TestTransformGraph, Simple)
     EXPECT_FALSE(transform_graph_once(g));
     EXPECT_TRUE(g.write_validation_report(cerr));
 }
+
+TEST_F(TestTransformGraph, Incremental)
+{
+    MergeGraph g;
+    node_p a = parse("(not (not (false)))");
+    size_t a_i = g.add_root(a);
+
+    Reporter reporter;
+    node_list_t seeds;
+    node_list_t changed;
+    bool needs_transform = true;
+
+    find_leaves(g.roots().first, g.roots().second, back_inserter(seeds));
+    while (needs_transform) {
+        changed.clear();
+        needs_transform = transform_graph(
+            reporter, g, factory(), Environment(),
+            seeds, changed
+        );
+        if (reporter.num_errors() || reporter.num_warnings()) {
+            throw runtime_error("Expected no errors/warnings.");
+        }
+        if (needs_transform) {
+            EXPECT_FALSE(changed.empty());
+        }
+
+        seeds.clear();
+        node_list_t live;
+        BOOST_FOREACH(const node_p& c, changed) {
+            node_p resolved;
+            try {
+                resolved = g.find_transform(c);
+            }
+            catch (IronBee::enoent) {
+                resolved = c;
+            }
+            if (resolved) {
+                live.push_back(resolved);
+            }
+        }
+        find_leaves(live.begin(), live.end(), back_inserter(seeds));
+    }
+
+    EXPECT_TRUE(g.write_validation_report(cerr));
+    EXPECT_EQ(":", g.root(a_i)->to_s());
+}
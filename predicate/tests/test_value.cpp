@@ -236,3 +236,30 @@ TEST(TestValue, DeepDup)
     EXPECT_NE(l2, m2);
     EXPECT_NE(m1, m2);
 }
+
+TEST(TestValue, CopyListValues)
+{
+    IronBee::ScopedMemoryPoolLite mpl;
+
+    IronBee::List<Value> l = IronBee::List<Value>::create(mpl);
+    l.push_back(Value::create_number(mpl, 5));
+    l.push_back(Value::create_number(mpl, 10));
+
+    Value v = Value::alias_list(mpl, l);
+
+    value_vec_t vec;
+    copy_list_values(v, vec);
+
+    ASSERT_EQ(2UL, vec.size());
+    EXPECT_EQ("5", vec[0].to_s());
+    EXPECT_EQ("10", vec[1].to_s());
+
+    // Appends rather than replaces.
+    copy_list_values(v, vec);
+    ASSERT_EQ(4UL, vec.size());
+
+    EXPECT_THROW(
+        copy_list_values(Value::create_number(mpl, 5), vec),
+        IronBee::einval
+    );
+}
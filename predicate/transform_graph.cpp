@@ -44,23 +44,27 @@ using namespace std;
 namespace IronBee {
 namespace Predicate {
 
-bool transform_graph(
+namespace {
+
+/**
+ * Shared worker for both transform_graph() overloads.
+ *
+ * Consumes @a todo, sweeping upward; see transform_graph() for details.
+ * If @a changed is non-NULL, records post-replacement nodes of reported
+ * changes there.
+ **/
+bool transform_nodes(
     reporter_t         reporter,
     MergeGraph&        graph,
     const CallFactory& call_factory,
-    Environment        environment
+    Environment        environment,
+    node_list_t&       todo,
+    node_list_t*       changed
 )
 {
     bool result = false;
-    node_list_t todo;
     set<node_p> visited;
 
-    // find_leaves guarantees no duplicates in output.
-    find_leaves(
-        graph.roots().first, graph.roots().second,
-        back_inserter(todo)
-    );
-
     while (! todo.empty()) {
         // Node added to list in the past.
         node_p n = todo.front();
@@ -89,12 +93,13 @@ bool transform_graph(
             continue;
         }
 
-        result = tn->transform(
+        bool transformed = tn->transform(
             graph,
             call_factory,
             environment,
             NodeReporter(reporter, tn.get())
-        ) || result;
+        );
+        result = transformed || result;
 
         try {
             ttn = graph.find_transform(n);
@@ -105,6 +110,9 @@ bool transform_graph(
 
         if (ttn) {
             visited.insert(ttn);
+            if (transformed && changed != NULL) {
+                changed->push_back(ttn);
+            }
             BOOST_FOREACH(const weak_node_p& parent, ttn->parents()) {
                 todo.push_back(parent.lock());
             }
@@ -114,5 +122,45 @@ bool transform_graph(
     return result;
 }
 
+} // Anonymous
+
+bool transform_graph(
+    reporter_t         reporter,
+    MergeGraph&        graph,
+    const CallFactory& call_factory,
+    Environment        environment
+)
+{
+    node_list_t todo;
+
+    // find_leaves guarantees no duplicates in output.
+    find_leaves(
+        graph.roots().first, graph.roots().second,
+        back_inserter(todo)
+    );
+
+    return transform_nodes(
+        reporter, graph, call_factory, environment,
+        todo, NULL
+    );
+}
+
+bool transform_graph(
+    reporter_t         reporter,
+    MergeGraph&        graph,
+    const CallFactory& call_factory,
+    Environment        environment,
+    const node_list_t& initial,
+    node_list_t&       changed
+)
+{
+    node_list_t todo(initial);
+
+    return transform_nodes(
+        reporter, graph, call_factory, environment,
+        todo, &changed
+    );
+}
+
 } // Predicate
 } // IronBee
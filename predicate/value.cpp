@@ -239,6 +239,22 @@ Value::type_e Value::type() const
     return static_cast<type_e>(m_field.type());
 }
 
+void copy_list_values(Value from, value_vec_t& to)
+{
+    if (from.type() != Value::LIST) {
+        BOOST_THROW_EXCEPTION(
+            einval() << errinfo_what(
+                "Can only copy elements of list values: " + from.to_s()
+            )
+        );
+    }
+    ConstList<Value> elements = from.as_list();
+    to.reserve(to.size() + elements.size());
+    BOOST_FOREACH(const Value& v, elements) {
+        to.push_back(v);
+    }
+}
+
 ostream& operator<<(ostream& o, const Value& v)
 {
     o << v.to_s();
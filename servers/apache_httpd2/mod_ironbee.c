@@ -1167,7 +1167,15 @@ static void ironbee_filter_insert(request_rec *r)
     if (rr != r) {
         ap_set_module_config(r->request_config, &ironbee_module, rctx);
     }
-    if (cfg->filter_input && !(rctx->state & NO_REQUEST_BODY))
+
+    /* Consult the context's inspection profile (InspectionEngineOptions,
+     * copied onto the tx flags at creation and refined by context
+     * selection).  If a direction's body is not inspected, don't insert
+     * its filter at all: passthrough traffic then runs the stock filter
+     * chain and pays no WAF cost after the header phase.
+     */
+    if (cfg->filter_input && !(rctx->state & NO_REQUEST_BODY)
+        && ib_flags_all(rctx->tx->flags, IB_TX_FINSPECT_REQBODY))
         ap_add_input_filter("ironbee", NULL, r, r->connection);
     else {
         /* We already fed Ironbee the headers.  If we're not
@@ -1179,7 +1187,8 @@ static void ironbee_filter_insert(request_rec *r)
             rctx->state |= NOTIFY_REQ_END;
         }
     }
-    if (cfg->filter_output)
+    if (cfg->filter_output
+        && ib_flags_all(rctx->tx->flags, IB_TX_FINSPECT_RESBODY))
         ap_add_output_filter("ironbee", NULL, r, r->connection);
     ap_add_output_filter("ironbee-headers", NULL, r, r->connection);
 }
@@ -46,6 +46,8 @@ typedef struct ironbee_proc_t {
     ngx_uint_t log_level;
     ngx_flag_t use_ngxib_logger;
     ngx_uint_t max_engines;
+    ngx_str_t thread_pool;
+    size_t shared_config_size;
 } ironbee_proc_t;
 
 static ngx_command_t  ngx_ironbee_commands[] =
@@ -86,6 +88,24 @@ static ngx_command_t  ngx_ironbee_commands[] =
         NULL
     },
 
+    {
+        ngx_string("ironbee_thread_pool"),
+        NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+        ngx_conf_set_str_slot,
+        NGX_HTTP_MAIN_CONF_OFFSET,
+        offsetof(ironbee_proc_t, thread_pool),
+        NULL
+    },
+
+    {
+        ngx_string("ironbee_shared_config_size"),
+        NGX_HTTP_MAIN_CONF|NGX_CONF_TAKE1,
+        ngx_conf_set_size_slot,
+        NGX_HTTP_MAIN_CONF_OFFSET,
+        offsetof(ironbee_proc_t, shared_config_size),
+        NULL
+    },
+
       ngx_null_command
 };
 
@@ -588,6 +608,8 @@ static ngx_int_t ironbee_headers_out(ngx_http_request_t *r)
 
     ngx_list_part_t *part;
     ngx_table_elt_t *hdr;
+    struct iovec *hdr_vec;
+    size_t nhdrs;
     unsigned int i;
     char proto[12];
     char *status;
@@ -642,20 +664,32 @@ static ngx_int_t ironbee_headers_out(ngx_http_request_t *r)
     if (rc != IB_OK)
         cleanup_return NGX_ERROR;
 
+    /* Batch the whole header block into a single engine call. */
+    nhdrs = 0;
+    for (part = &r->headers_out.headers.part; part != NULL; part = part->next) {
+        nhdrs += part->nelts;
+    }
+    hdr_vec = ngx_palloc(r->pool, 2 * nhdrs * sizeof(*hdr_vec));
+    if (hdr_vec == NULL)
+        cleanup_return NGX_ERROR;
+    nhdrs = 0;
     for (part = &r->headers_out.headers.part; part != NULL; part = part->next) {
         hdr = part->elts;
         for (i = 0; i < part->nelts; ++i) {
             /* Empty header --> NULL value --> assert in parsed_contents */
             if (hdr->key.data != NULL && hdr->value.data != NULL) {
-                ib_parsed_headers_add(ibhdrs,
-                                      (const char*)hdr->key.data,
-                                      hdr->key.len,
-                                      (const char*)hdr->value.data,
-                                      hdr->value.len);
+                hdr_vec[2 * nhdrs].iov_base     = hdr->key.data;
+                hdr_vec[2 * nhdrs].iov_len      = hdr->key.len;
+                hdr_vec[2 * nhdrs + 1].iov_base = hdr->value.data;
+                hdr_vec[2 * nhdrs + 1].iov_len  = hdr->value.len;
+                ++nhdrs;
             }
             ++hdr;
         }
     }
+    rc = ib_parsed_headers_add_batch(ibhdrs, hdr_vec, nhdrs);
+    if (rc != IB_OK)
+        cleanup_return NGX_ERROR;
 
     /* IronBee currently crashes if called here with no headers,
      * even perfectly correctly on a 204/304 response.
@@ -695,32 +729,32 @@ static ngx_int_t ironbee_headers_out(ngx_http_request_t *r)
  * @param[in]  r     The nginx request object.
  * @return     Declined (ignored) or error status.
  */
-static ngx_int_t ironbee_post_read_request(ngx_http_request_t *r)
+/**
+ * Notify IronBee of the request line and headers.
+ *
+ * This runs the engine's request header rule phases, so it may be
+ * expensive.  It is called either inline on the event loop or, when an
+ * ironbee_thread_pool is configured, on a thread pool worker so that a
+ * slow rule phase does not stall unrelated connections on the worker.
+ * Only this request's tx is touched, so no locking is needed; the
+ * request itself is suspended while the notification runs.
+ *
+ * @param[in]  ctx   The per-request plugin context.
+ * @return     NGX_DECLINED on success, or error status.
+ */
+static ngx_int_t ironbee_notify_request_headers(ngxib_req_ctx *ctx)
 {
-    ngxib_req_ctx *ctx;
-    ib_conn_t *iconn;
+    ngx_http_request_t *r = ctx->r;
     ib_parsed_req_line_t *rline;
     ib_parsed_headers_t *ibhdrs;
     ib_status_t rc;
 
     ngx_list_part_t *part;
     ngx_table_elt_t *hdr;
+    struct iovec *hdr_vec;
+    size_t nhdrs;
     unsigned int i;
 
-    /* Don't process internal requests */
-    if (r->internal)
-        return NGX_DECLINED;
-
-    ngx_regex_malloc_init(r->pool);
-
-    ctx = ngx_pcalloc(r->pool, sizeof(ngxib_req_ctx));
-    ctx->r = r;
-    ngx_http_set_ctx(r, ctx, ngx_ironbee_module);
-
-    iconn = ngxib_conn_get(ctx);
-
-    ib_tx_create(&ctx->tx, iconn, ctx);
-
     /* Notify IronBee of request line and headers */
     rc = ib_parsed_req_line_create(&rline, ctx->tx->mm,
                                    (const char*)r->request_line.data,
@@ -732,40 +766,181 @@ static ngx_int_t ironbee_post_read_request(ngx_http_request_t *r)
                                    (const char*)r->http_protocol.data,
                                    r->http_protocol.len);
     if (rc != IB_OK)
-        cleanup_return NGX_ERROR;
+        return NGX_ERROR;
 
     ib_state_notify_request_started(ctx->tx->ib, ctx->tx, rline);
 
     rc = ib_parsed_headers_create(&ibhdrs, ctx->tx->mm);
     if (rc != IB_OK)
-        cleanup_return NGX_ERROR;
+        return NGX_ERROR;
 
+    /* Batch the whole header block into a single engine call. */
+    nhdrs = 0;
+    for (part = &r->headers_in.headers.part; part != NULL; part = part->next) {
+        nhdrs += part->nelts;
+    }
+    hdr_vec = ngx_palloc(r->pool, 2 * nhdrs * sizeof(*hdr_vec));
+    if (hdr_vec == NULL)
+        return NGX_ERROR;
+    nhdrs = 0;
     for (part = &r->headers_in.headers.part; part != NULL; part = part->next) {
         hdr = part->elts;
         for (i = 0; i < part->nelts; ++i) {
-            ib_parsed_headers_add(ibhdrs,
-                                               (const char*)hdr->key.data,
-                                               hdr->key.len,
-                                               (const char*)hdr->value.data,
-                                               hdr->value.len);
+            hdr_vec[2 * nhdrs].iov_base     = hdr->key.data;
+            hdr_vec[2 * nhdrs].iov_len      = hdr->key.len;
+            hdr_vec[2 * nhdrs + 1].iov_base = hdr->value.data;
+            hdr_vec[2 * nhdrs + 1].iov_len  = hdr->value.len;
+            ++nhdrs;
             ++hdr;
         }
     }
+    rc = ib_parsed_headers_add_batch(ibhdrs, hdr_vec, nhdrs);
+    if (rc != IB_OK)
+        return NGX_ERROR;
 
     rc = ib_state_notify_request_header_data(ctx->tx->ib, ctx->tx, ibhdrs);
     if (rc != IB_OK)
-        cleanup_return NGX_ERROR;
+        return NGX_ERROR;
 
     rc = ib_state_notify_request_header_finished(ctx->tx->ib, ctx->tx);
     if (rc != IB_OK)
-        cleanup_return NGX_ERROR;
+        return NGX_ERROR;
 
     if (!ngxib_has_request_body(r, ctx)) {
         rc = ib_state_notify_request_finished(ctx->tx->ib, ctx->tx);
         if (rc != IB_OK)
-            cleanup_return NGX_ERROR;
+            return NGX_ERROR;
     }
     ctx->hdrs_in = 1;
+    return NGX_DECLINED;
+}
+
+#if (NGX_THREADS)
+/**
+ * Context passed to the notification thread task.
+ */
+typedef struct ngxib_notify_task_t {
+    ngxib_req_ctx *ctx;        /* The request the task works on */
+    ngx_int_t result;          /* Result of the notification */
+} ngxib_notify_task_t;
+
+/**
+ * Thread pool handler: run the header notification off the event loop.
+ *
+ * @param[in]  data  The @ref ngxib_notify_task_t.
+ * @param[in]  log   Thread log (unused).
+ */
+static void ironbee_notify_thread_handler(void *data, ngx_log_t *log)
+{
+    ngxib_notify_task_t *task = data;
+
+    ngx_regex_malloc_init(task->ctx->r->pool);
+    task->result = ironbee_notify_request_headers(task->ctx);
+    ngx_regex_malloc_done();
+}
+
+/**
+ * Completion event, posted back to the event loop when the
+ * notification thread task finishes.  Resumes request processing.
+ *
+ * @param[in]  ev    The task completion event.
+ */
+static void ironbee_notify_thread_done(ngx_event_t *ev)
+{
+    ngxib_notify_task_t *task = ev->data;
+    ngxib_req_ctx *ctx = task->ctx;
+    ngx_http_request_t *r = ctx->r;
+
+    ctx->notify_inflight = 0;
+    ctx->notify_result = task->result;
+
+    r->main->blocked--;
+    r->aio = 0;
+
+    /* Re-enter the phase engine; our post-read handler picks up the
+     * saved result and lets the request continue (or error out).
+     */
+    ngx_http_core_run_phases(r);
+}
+#endif /* NGX_THREADS */
+/**
+ * nginx post-read-request handler to feed request line and headers to IronBee.
+ *
+ * When an ironbee_thread_pool is configured, the engine notification
+ * (and hence the request header rule phases) runs on a pool thread and
+ * the request is suspended; the completion event resumes it here.
+ *
+ * @param[in]  r     The nginx request object.
+ * @return     Declined (ignored) or error status.
+ */
+static ngx_int_t ironbee_post_read_request(ngx_http_request_t *r)
+{
+    ngxib_req_ctx *ctx;
+    ib_conn_t *iconn;
+    ngx_int_t rv;
+
+    /* Don't process internal requests */
+    if (r->internal)
+        return NGX_DECLINED;
+
+    ctx = ngx_http_get_module_ctx(r, ngx_ironbee_module);
+    if (ctx != NULL) {
+        /* Re-entered after asynchronous notification. */
+        if (ctx->notify_inflight)
+            return NGX_DONE;
+        if (STATUS_IS_ERROR(ctx->status)) {
+            ctx->internal_errordoc = 1;
+            return ctx->status;
+        }
+        return ctx->notify_result;
+    }
+
+    ngx_regex_malloc_init(r->pool);
+
+    ctx = ngx_pcalloc(r->pool, sizeof(ngxib_req_ctx));
+    ctx->r = r;
+    ngx_http_set_ctx(r, ctx, ngx_ironbee_module);
+
+    iconn = ngxib_conn_get(ctx);
+
+    ib_tx_create(&ctx->tx, iconn, ctx);
+
+#if (NGX_THREADS)
+    if (module_data.thread_pool != NULL) {
+        ngx_thread_task_t *task;
+        ngxib_notify_task_t *ntask;
+
+        task = ngx_thread_task_alloc(r->pool, sizeof(*ntask));
+        if (task == NULL)
+            cleanup_return NGX_ERROR;
+
+        ntask = task->ctx;
+        ntask->ctx = ctx;
+        task->handler = ironbee_notify_thread_handler;
+        task->event.handler = ironbee_notify_thread_done;
+        task->event.data = ntask;
+
+        if (ngx_thread_task_post(module_data.thread_pool, task) == NGX_OK) {
+            ctx->notify_inflight = 1;
+            r->main->blocked++;
+            r->aio = 1;
+            cleanup_return NGX_DONE;
+        }
+
+        /* Pool saturated: degrade to synchronous notification rather
+         * than failing the request.
+         */
+        ngx_log_error(NGX_LOG_WARN, r->connection->log, 0,
+                      "ironbee: thread pool exhausted;"
+                      " notifying synchronously");
+    }
+#endif
+
+    rv = ironbee_notify_request_headers(ctx);
+    ctx->notify_result = rv;
+    if (rv != NGX_DECLINED)
+        cleanup_return rv;
+
     if (STATUS_IS_ERROR(ctx->status)) {
         ctx->internal_errordoc = 1;
         cleanup_return ctx->status;
@@ -809,6 +984,40 @@ static ngx_int_t ironbee_init(ngx_conf_t *cf)
     mod_data->log = cf->log;
     mod_data->log_level = proc->log_level;
 
+    /* Resolve the thread pool for async engine notification, if any */
+    if (proc->thread_pool.len > 0) {
+#if (NGX_THREADS)
+        mod_data->thread_pool = ngx_thread_pool_add(cf, &proc->thread_pool);
+        if (mod_data->thread_pool == NULL) {
+            cleanup_return NGX_ERROR;
+        }
+#else
+        ngx_log_error(NGX_LOG_WARN, cf->log, 0,
+                      "ironbee_thread_pool ignored:"
+                      " nginx built without --with-threads");
+#endif
+    }
+
+    /* Build configuration into a shared mapping so forked workers
+     * share one copy of it rather than duplicating it by copy-on-write.
+     * Must be in place before the first engine is created.
+     */
+    if (proc->shared_config_size != NGX_CONF_UNSET_SIZE
+        && proc->shared_config_size > 0)
+    {
+        rc = ib_shm_arena_create(&mod_data->config_arena,
+                                 proc->shared_config_size);
+        if (rc != IB_OK) {
+            ngx_log_error(NGX_LOG_ERR, cf->log, 0,
+                          "ironbee: failed to create shared config arena: %s",
+                          ib_status_to_string(rc));
+            cleanup_return NGX_ERROR;
+        }
+        ib_shm_arena_select(mod_data->config_arena);
+        ib_engine_config_allocators_set(ib_shm_arena_mpool_malloc,
+                                        ib_shm_arena_mpool_free);
+    }
+
     rc = ib_initialize();
     if (rc != IB_OK) {
         cleanup_return IB2NG(rc);
@@ -844,6 +1053,16 @@ static ngx_int_t ironbee_init(ngx_conf_t *cf)
     }
     free(buf);
 
+    /* Seal the shared arena: the configuration is complete, and any
+     * engine created after fork falls back to private worker memory.
+     */
+    if (mod_data->config_arena != NULL) {
+        ib_shm_arena_seal(mod_data->config_arena);
+        ngx_log_error(NGX_LOG_NOTICE, cf->log, 0,
+                      "ironbee: %uz bytes of configuration in shared arena",
+                      ib_shm_arena_used(mod_data->config_arena));
+    }
+
     cleanup_return rc == IB_OK ? NGX_OK : IB2NG(rc);
 }
 
@@ -923,6 +1142,7 @@ static void *create_main_conf(ngx_conf_t *cf)
         conf->log_level = NGX_CONF_UNSET_UINT;
         conf->use_ngxib_logger = NGX_CONF_UNSET;
         conf->max_engines = NGX_CONF_UNSET_UINT;
+        conf->shared_config_size = NGX_CONF_UNSET_SIZE;
     }
     return conf;
 }
@@ -959,6 +1179,10 @@ static void ironbee_exit(ngx_cycle_t *cycle)
         ib_manager_destroy(module_data.manager);
         module_data.manager = NULL;
     }
+    if (module_data.config_arena != NULL) {
+        ib_shm_arena_destroy(module_data.config_arena);
+        module_data.config_arena = NULL;
+    }
 }
 
 
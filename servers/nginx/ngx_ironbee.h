@@ -26,10 +26,14 @@
 #define NGXIB_H
 
 #include <ngx_http.h>
+#if (NGX_THREADS)
+#include <ngx_thread_pool.h>
+#endif
 #include <ironbee/config.h>
 #include <ironbee/engine_state.h>
 #include <ironbee/engine_types.h>
 #include <ironbee/engine.h>
+#include <ironbee/shm_arena.h>
 
 /* HTTP statuses we'll support when IronBee asks us to return them */
 #define STATUS_IS_ERROR(code) ( ((code) >= 200) && ((code) <  600) )
@@ -76,6 +80,8 @@ typedef struct ngxib_req_ctx {
     edit_filter_ctx out;          /* Output stream edit ctx */
     // edit_filter_ctx in;        /* NOTIMPL */
     int edit_flags;               /* Are we editing HTTP payloads? */
+    int notify_result;            /* Result of async header notification */
+    int notify_inflight:1;        /* Notification running on a thread */
     int body_done:1;              /* State flags */
     int body_wait:1;              /* State flags */
     int has_request_body:1;       /* State flags */
@@ -160,6 +166,10 @@ typedef struct module_data_t {
     int                    ib_log_active;
     ngx_log_t             *log;
     int                    log_level;
+    ib_shm_arena_t        *config_arena; /**< Pre-fork shared config arena */
+#if (NGX_THREADS)
+    ngx_thread_pool_t     *thread_pool;  /**< Pool for async notification */
+#endif
 } module_data_t;
 
 ib_status_t ngxib_module(ib_module_t**, ib_engine_t*, void*);
@@ -178,6 +178,33 @@ static ib_status_t flush_data(tsib_filter_ctx *fctx, int64_t nbytes, int last)
     return rc;
 }
 
+/**
+ * Reference held on TSIOBuffer data aliased into the engine.
+ *
+ * A private buffer holding a refcounted copy of the chunk keeps the
+ * underlying block data alive until the engine drops its last
+ * reference, so body inspection needs no data copy.
+ */
+typedef struct body_ref_t body_ref_t;
+struct body_ref_t {
+    TSIOBuffer       buffer;
+    TSIOBufferReader reader;
+};
+
+/**
+ * Release callback for data aliased by ib_notify_body_alias.
+ *
+ * @param[in] cbdata The @ref body_ref_t to release.
+ */
+static void body_ref_release(void *cbdata)
+{
+    body_ref_t *ref = cbdata;
+
+    TSIOBufferReaderFree(ref->reader);
+    TSIOBufferDestroy(ref->buffer);
+    TSfree(ref);
+}
+
 /**
  * Function to buffer data, and flush buffer according to buffering rules.
  *
@@ -417,7 +444,24 @@ static void process_data(TSCont contp, ibd_ctx *ibd)
     while (navail = TSIOBufferReaderAvail(input_reader), navail > 0) {
         block = TSIOBufferReaderStart(input_reader);
         buf = TSIOBufferBlockReadStart(block, input_reader, &nbytes);
-        rc = (*ibd->ibd->ib_notify_body)(txndata->tx->ib, txndata->tx, buf, nbytes);
+        if (ibd->ibd->ib_notify_body_alias != NULL && nbytes > 0) {
+            /* Hand the block data to the engine without copying it.  A
+             * refcounted clone of the chunk keeps the block data valid
+             * after we consume the input reader below; the engine
+             * releases the clone when it drops its last reference.
+             */
+            body_ref_t *ref = TSmalloc(sizeof(*ref));
+            ref->buffer = TSIOBufferCreate();
+            ref->reader = TSIOBufferReaderAlloc(ref->buffer);
+            /* It's only a refcount here */
+            TSIOBufferCopy(ref->buffer, input_reader, nbytes, 0);
+            rc = (*ibd->ibd->ib_notify_body_alias)(txndata->tx->ib,
+                                                   txndata->tx, buf, nbytes,
+                                                   body_ref_release, ref);
+        }
+        else {
+            rc = (*ibd->ibd->ib_notify_body)(txndata->tx->ib, txndata->tx, buf, nbytes);
+        }
         if (rc != IB_OK) {
             ib_log_error_tx(txndata->tx, "Error %d notifying body data.", rc);
         }
@@ -50,6 +50,7 @@ tsib_direction_data_t tsib_direction_client_req = {
     ib_state_notify_request_header_data,
     ib_state_notify_request_header_finished,
     ib_state_notify_request_body_data,
+    ib_state_notify_request_body_data_alias,
     ib_state_notify_request_finished,
     NULL,
     NULL
@@ -62,6 +63,7 @@ tsib_direction_data_t tsib_direction_server_resp = {
     ib_state_notify_response_header_data,
     ib_state_notify_response_header_finished,
     ib_state_notify_response_body_data,
+    ib_state_notify_response_body_data_alias,
     ib_state_notify_response_finished,
     ib_state_notify_postprocess,
     ib_state_notify_logging
@@ -74,6 +76,7 @@ tsib_direction_data_t tsib_direction_client_resp = {
     ib_state_notify_response_header_data,
     ib_state_notify_response_header_finished,
     ib_state_notify_response_body_data,
+    ib_state_notify_response_body_data_alias,
     ib_state_notify_response_finished,
     ib_state_notify_postprocess,
     ib_state_notify_logging
@@ -801,6 +804,20 @@ tsib_hdr_outcome process_hdr(tsib_txn_ctx *txndata,
     /* RNS506 fix: enforce strict lineend first time round (jumping over the request/response line) */
     int l_status;
 
+    /* Collect all headers into an iovec block and hand them to the
+     * engine in one batch call.  Grow the block if a message carries
+     * an unusual number of headers.
+     */
+    size_t hdr_cap = 64;
+    struct iovec *hdr_vec = ib_mm_alloc(txndata->tx->mm,
+                                        2 * hdr_cap * sizeof(*hdr_vec));
+    if (hdr_vec == NULL) {
+        ibplugin.err_fn(txndata->tx, 500, NULL);
+        ib_log_error_tx(txndata->tx, "Failed to allocate header vector.  Disabling.");
+        ret = HDR_ERROR;
+        goto process_hdr_cleanup;
+    }
+
     for (l_status = next_line(&line, &line_len);
          l_status > 0;
          l_status = next_line(&line, &line_len)) {
@@ -816,9 +833,24 @@ tsib_hdr_outcome process_hdr(tsib_txn_ctx *txndata,
         /* IronBee presumably wants to know of anything zero-length
          * so don't reject on those grounds!
          */
-        rv = ib_parsed_headers_add(ibhdrs,
-                                                line, n_len,
-                                                lptr, v_len);
+        if ((size_t)nhdrs == hdr_cap) {
+            struct iovec *new_vec;
+            new_vec = ib_mm_alloc(txndata->tx->mm,
+                                  4 * hdr_cap * sizeof(*new_vec));
+            if (new_vec == NULL) {
+                ibplugin.err_fn(txndata->tx, 500, NULL);
+                ib_log_error_tx(txndata->tx, "Failed to grow header vector.  Disabling.");
+                ret = HDR_ERROR;
+                goto process_hdr_cleanup;
+            }
+            memcpy(new_vec, hdr_vec, 2 * hdr_cap * sizeof(*new_vec));
+            hdr_vec = new_vec;
+            hdr_cap *= 2;
+        }
+        hdr_vec[2 * nhdrs].iov_base     = (void *)line;
+        hdr_vec[2 * nhdrs].iov_len      = n_len;
+        hdr_vec[2 * nhdrs + 1].iov_base = (void *)lptr;
+        hdr_vec[2 * nhdrs + 1].iov_len  = v_len;
         if (!body_len && (ibd->dir == IBD_REQ)) {
             /* Check for expectation of a request body */
             if ((n_len == 14) && !strncasecmp(line, "Content-Length", n_len)) {
@@ -848,12 +880,14 @@ tsib_hdr_outcome process_hdr(tsib_txn_ctx *txndata,
                 body_len = -1;  /* nonzero - body and length yet to come */
             }
         }
-        if (rv != IB_OK)
-            ib_log_error_tx(txndata->tx, "Failed to add header '%.*s: %.*s' to IronBee list",
-                            (int)n_len, line, (int)v_len, lptr);
         ++nhdrs;
     }
 
+    rv = ib_parsed_headers_add_batch(ibhdrs, hdr_vec, nhdrs);
+    if (rv != IB_OK)
+        ib_log_error_tx(txndata->tx, "Failed to add %d headers to IronBee list",
+                        nhdrs);
+
     /* Notify headers if present */
     if (nhdrs > 0) {
         ib_log_debug2_tx(txndata->tx, "process_hdr: notifying header data");
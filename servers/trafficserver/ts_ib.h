@@ -25,6 +25,8 @@
 #ifndef TS_IB_H
 #define TS_IB_H
 
+#include <ironbee/stream_io.h>
+
 #define ADDRSIZE 48 /* what's the longest IPV6 addr ? */
 #define DEFAULT_LOG "ts-ironbee"
 #define DEFAULT_TXLOG "txlogs/tx-ironbee"
@@ -126,6 +128,8 @@ struct tsib_direction_data_t {
                  ib_parsed_headers_t*);
     ib_status_t (*ib_notify_header_finished)(ib_engine_t*, ib_tx_t*);
     ib_status_t (*ib_notify_body)(ib_engine_t*, ib_tx_t*, const char*, size_t);
+    ib_status_t (*ib_notify_body_alias)(ib_engine_t*, ib_tx_t*, const char*,
+                 size_t, ib_stream_io_release_fn_t, void*);
     ib_status_t (*ib_notify_end)(ib_engine_t*, ib_tx_t*);
     ib_status_t (*ib_notify_post)(ib_engine_t*, ib_tx_t*);
     ib_status_t (*ib_notify_log)(ib_engine_t*, ib_tx_t*);
@@ -55,6 +55,7 @@ struct module_data_t {
     //! The manager control channel for manager.
     ib_engine_manager_control_channel_t *manager_ctl;
     size_t           max_engines;    /**< Max # of simultaneous engines */
+    size_t           engine_replicas; /**< Engine replicas per name */
     const char      *config_file;    /**< IronBee configuration file */
     const char      *log_file;       /**< IronBee log file */
     int              log_level;      /**< IronBee log level */
@@ -73,6 +74,7 @@ static module_data_t module_data =
     NULL,                            /* .manager */
     NULL,                            /* .manager_ctl. */
     IB_MANAGER_DEFAULT_MAX_ENGINES,  /* .max_engines */
+    1,                               /* .engine_replicas */
     NULL,                            /* .config_file */
     NULL,                            /* .log_file */
     IB_LOG_WARNING,                  /* .log_level */
@@ -500,7 +502,7 @@ static ib_status_t read_ibconf(
     mod_data->log_level = 4;
 
     /* const-ness mismatch looks like an oversight, so casting should be fine */
-    while (c = getopt(argc, (char**)argv, "l:Lv:d:m:x:"), c != -1) {
+    while (c = getopt(argc, (char**)argv, "l:Lv:d:m:x:r:"), c != -1) {
         switch(c) {
         case 'L':
             mod_data->log_disable = true;
@@ -515,6 +517,9 @@ static ib_status_t read_ibconf(
         case 'm':
             mod_data->max_engines = atoi(optarg);
             break;
+        case 'r':
+            mod_data->engine_replicas = atoi(optarg);
+            break;
         case 'x':
             mod_data->txlogfile = strdup(optarg);
             break;
@@ -591,6 +596,28 @@ static int ironbee_init(module_data_t *mod_data)
         TSError("[ironbee] Failed to register diag commands to ctrl channel.");
     }
 
+    /* Register the sampling profiler command.
+     * Failure is not fatal. */
+    rc = ib_engine_manager_control_profiler_register(mod_data->manager_ctl);
+    if (rc != IB_OK) {
+        TSError("[ironbee] Failed to register profiler command to ctrl channel.");
+    }
+
+    /* Register the allocation profiler command.
+     * Failure is not fatal.
+     * The command reports an error when not compiled w/ IB_MM_PROFILE. */
+    rc = ib_engine_manager_control_mm_profile_register(mod_data->manager_ctl);
+    if (rc != IB_OK) {
+        TSError("[ironbee] Failed to register mmprofile command to ctrl channel.");
+    }
+
+    /* Register the metrics command.
+     * Failure is not fatal. */
+    rc = ib_engine_manager_control_metrics_register(mod_data->manager_ctl);
+    if (rc != IB_OK) {
+        TSError("[ironbee] Failed to register metrics command to ctrl channel.");
+    }
+
     /* Start the channel. This is stopped when it is destroyed. */
     rc = ib_engine_manager_control_channel_start(mod_data->manager_ctl);
     if (rc != IB_OK) {
@@ -773,6 +800,21 @@ static ib_status_t tsib_pre_init(TSCont *contp)
     if (rc != IB_OK) {
         TSError("[ironbee] Error creating IronBee engine manager: %s",
                 ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* Replicated engines (-r): each event thread is pinned to its own
+     * engine replica, keeping mutable engine state core-local. */
+    if (module_data.engine_replicas > 1) {
+        rc = ib_manager_replicas_set(module_data.manager,
+                                     module_data.engine_replicas);
+        if (rc != IB_OK) {
+            TSError("[ironbee] Error setting engine replicas to %d"
+                    " (max engines %d must be at least twice replicas): %s",
+                    (int)module_data.engine_replicas,
+                    (int)module_data.max_engines,
+                    ib_status_to_string(rc));
+        }
     }
     return rc;
 }
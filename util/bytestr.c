@@ -205,6 +205,34 @@ ib_status_t ib_bytestr_alias(
     return rc;
 }
 
+ib_status_t ib_bytestr_alias_range(
+    ib_bytestr_t       **pdst,
+    ib_mm_t              mm,
+    const ib_bytestr_t  *src,
+    size_t               offset,
+    size_t               length
+)
+{
+    assert(pdst != NULL);
+
+    const uint8_t *data;
+
+    if (src == NULL) {
+        return IB_EINVAL;
+    }
+    if (offset > src->length || length > src->length - offset) {
+        return IB_EINVAL;
+    }
+
+    /* An empty source has no storage; the view is empty too. */
+    data = ib_bytestr_const_ptr(src);
+    if (data == NULL) {
+        return ib_bytestr_alias_mem(pdst, mm, NULL, 0);
+    }
+
+    return ib_bytestr_alias_mem(pdst, mm, data + offset, length);
+}
+
 ib_status_t ib_bytestr_alias_mem(
     ib_bytestr_t   **pdst,
     ib_mm_t          mm,
@@ -232,6 +260,36 @@ ib_status_t ib_bytestr_alias_mem(
     return IB_OK;
 }
 
+size_t ib_bytestr_struct_size(void)
+{
+    return sizeof(ib_bytestr_t);
+}
+
+ib_status_t ib_bytestr_alias_mem_init(
+    ib_bytestr_t   *dst,
+    ib_mm_t         mm,
+    const uint8_t  *data,
+    size_t          data_length
+)
+{
+    assert(dst != NULL);
+
+    if (data == NULL && data_length > 0) {
+        return IB_EINVAL;
+    }
+
+    dst->mm     = mm;
+    /* As ib_bytestr_alias_mem(): the flag enforces that the user can not
+     * recover a non-const pointer.
+     */
+    dst->flags  = IB_BYTESTR_FREADONLY;
+    dst->data   = (uint8_t *)data;
+    dst->length = data_length;
+    dst->size   = data_length;
+
+    return IB_OK;
+}
+
 ib_status_t ib_bytestr_alias_nulstr(
     ib_bytestr_t **pdst,
     ib_mm_t        mm,
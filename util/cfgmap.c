@@ -241,3 +241,19 @@ ib_status_t ib_cfgmap_get(const ib_cfgmap_t *cm,
     rc = ib_field_value(f, out_val);
     return rc;
 }
+
+ib_status_t ib_cfgmap_entry(const ib_cfgmap_t *cm,
+                            const char *name,
+                            ib_field_t **pfield)
+{
+    ib_field_t *f;
+    ib_status_t rc;
+
+    rc = ib_hash_get(cm->hash, &f, name);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *pfield = f;
+    return IB_OK;
+}
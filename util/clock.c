@@ -148,6 +148,60 @@ ib_time_t ib_clock_get_time(void)
     return usec;
 }
 
+/*
+ * Per-thread coarse clock cache.
+ *
+ * Transactions read the clock many times (timestamps, rule timing, logger
+ * records) and each uncached read is a clock_gettime()/gettimeofday() call.
+ * Consumers that tolerate ~1ms precision instead read these cached values,
+ * which are refreshed once per state transition via
+ * ib_clock_coarse_refresh() and whenever a read finds the cache older than
+ * @ref c_coarse_max_age.  The age bound keeps threads that never pass a
+ * state transition (background workers, the control channel) from serving
+ * an ever-staler timestamp.
+ */
+static __thread ib_time_t    g_coarse_time = 0;
+static __thread ib_timeval_t g_coarse_tv   = { 0, 0 };
+
+/*! Maximum tolerated age of the coarse cache, in microseconds. */
+static const ib_time_t c_coarse_max_age = 1000;
+
+ib_time_t ib_clock_coarse_refresh(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    g_coarse_tv.tv_sec  = (uint32_t)tv.tv_sec;
+    g_coarse_tv.tv_usec = (uint32_t)tv.tv_usec;
+
+    g_coarse_time = ib_clock_get_time();
+
+    return g_coarse_time;
+}
+
+ib_time_t ib_clock_coarse_get_time(void)
+{
+    /* g_coarse_time is monotonic, so its distance from the monotonic
+     * clock is the cache's age.  The age check is cheap: IB_CLOCK is
+     * CLOCK_MONOTONIC_COARSE where available. */
+    if (ib_clock_get_time() - g_coarse_time > c_coarse_max_age) {
+        return ib_clock_coarse_refresh();
+    }
+    return g_coarse_time;
+}
+
+void ib_clock_coarse_gettimeofday(ib_timeval_t *tp)
+{
+    assert(tp != NULL);
+
+    if (g_coarse_tv.tv_sec == 0 ||
+        ib_clock_get_time() - g_coarse_time > c_coarse_max_age)
+    {
+        ib_clock_coarse_refresh();
+    }
+    *tp = g_coarse_tv;
+}
+
 ib_time_t ib_clock_precise_get_time(void)
 {
 #ifdef IB_PRECISE_CLOCK
@@ -72,6 +72,20 @@ struct ib_field_val_t {
     ib_field_val_union_t  u;             /**< Union of value types */
 };
 
+/**
+ * A field and its value in a single allocation.
+ *
+ * Used by ib_field_create_alias() so that non-dynamic values, numerics in
+ * particular, are stored inline after the field header rather than in a
+ * separate heap object.  The compiler inserts any padding needed to align
+ * the value union.
+ */
+struct ib_field_and_val_t {
+    ib_field_t      field; /**< The field header. */
+    ib_field_val_t  val;   /**< The value, pointed to by field.val. */
+};
+typedef struct ib_field_and_val_t ib_field_and_val_t;
+
 const char *ib_field_type_name(
     ib_ftype_t ftype
 )
@@ -409,16 +423,21 @@ ib_status_t ib_field_create_alias(
 {
     ib_status_t rc;
     char *name_copy;
+    ib_field_and_val_t *fv;
 
-    /* Allocate the field structure. */
-    *pf = (ib_field_t *)ib_mm_alloc(mm, sizeof(**pf));
-    if (*pf == NULL) {
+    /* Allocate the field and its value as a single block so that
+     * non-dynamic values, in particular numerics, live inline after the
+     * field header instead of in a separate heap object. */
+    fv = (ib_field_and_val_t *)ib_mm_calloc(mm, 1, sizeof(*fv));
+    if (fv == NULL) {
         rc = IB_EALLOC;
         goto failed;
     }
+    *pf = &fv->field;
     (*pf)->mm = mm;
     (*pf)->type = type;
     (*pf)->tfn = NULL;
+    (*pf)->val = &fv->val;
 
     /* Copy the name. */
     (*pf)->nlen = nlen;
@@ -430,14 +449,6 @@ ib_status_t ib_field_create_alias(
     memcpy(name_copy, name, nlen);
     (*pf)->name = (const char *)name_copy;
 
-    (*pf)->val = (ib_field_val_t *)ib_mm_calloc(mm,
-        1, sizeof(*((*pf)->val))
-    );
-    if ((*pf)->val == NULL) {
-        rc = IB_EALLOC;
-        goto failed;
-    }
-
     (*pf)->val->pval = storage_pval;
 
     ib_field_util_log_debug("FIELD_CREATE_ALIAS", (*pf));
@@ -640,6 +651,100 @@ failed:
     return rc;
 }
 
+ib_status_t ib_field_create_bytestr_alias_batch(
+    ib_field_t                     ***pfields,
+    ib_mm_t                           mm,
+    const ib_field_bytestr_descr_t   *descrs,
+    size_t                            count
+)
+{
+    assert(pfields != NULL);
+
+    const size_t fv_align   = __alignof__(ib_field_and_val_t);
+    size_t       names_size = 0;
+    size_t       fv_size;
+    size_t       bs_size;
+    size_t       ptr_size;
+    char        *block;
+    char        *bytestrs;
+    char        *names;
+    ib_field_and_val_t *fvs;
+    ib_field_t **fields;
+
+    *pfields = NULL;
+
+    if (count == 0) {
+        return IB_OK;
+    }
+    if (descrs == NULL) {
+        return IB_EINVAL;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (
+            (descrs[i].name == NULL && descrs[i].nlen > 0) ||
+            (descrs[i].value == NULL && descrs[i].vlen > 0)
+        ) {
+            return IB_EINVAL;
+        }
+        names_size += descrs[i].nlen;
+    }
+
+    /* One block for everything.  The field/value pairs are the most
+     * strictly aligned objects (the value union holds an ib_float_t), so
+     * they lead and each following section starts on a multiple of the
+     * preceding element size.  Memory managers only guarantee pointer
+     * alignment, so over-allocate and round the base up. */
+    fv_size  = count * sizeof(ib_field_and_val_t);
+    bs_size  = count * ib_bytestr_struct_size();
+    ptr_size = count * sizeof(ib_field_t *);
+    block = (char *)ib_mm_calloc(
+        mm, 1,
+        fv_size + bs_size + ptr_size + names_size + fv_align - 1);
+    if (block == NULL) {
+        return IB_EALLOC;
+    }
+    block = (char *)(
+        ((uintptr_t)block + fv_align - 1) & ~(uintptr_t)(fv_align - 1));
+    fvs      = (ib_field_and_val_t *)block;
+    bytestrs = block + fv_size;
+    fields   = (ib_field_t **)(block + fv_size + bs_size);
+    names    = block + fv_size + bs_size + ptr_size;
+
+    for (size_t i = 0; i < count; ++i) {
+        ib_field_and_val_t *fv = &fvs[i];
+        ib_bytestr_t *bs =
+            (ib_bytestr_t *)(bytestrs + i * ib_bytestr_struct_size());
+        ib_status_t rc;
+
+        rc = ib_bytestr_alias_mem_init(
+            bs, mm, descrs[i].value, descrs[i].vlen);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        memcpy(names, descrs[i].name, descrs[i].nlen);
+
+        fv->field.mm    = mm;
+        fv->field.type  = IB_FTYPE_BYTESTR;
+        fv->field.name  = names;
+        fv->field.nlen  = descrs[i].nlen;
+        fv->field.tfn   = NULL;
+        fv->field.val   = &fv->val;
+        fv->val.pval    = &fv->val.u;
+        fv->val.u.bytestr = bs;
+
+        names += descrs[i].nlen;
+        fields[i] = &fv->field;
+
+        ib_field_util_log_debug("FIELD_CREATE_BYTESTR_ALIAS_BATCH",
+                                fields[i]);
+    }
+
+    *pfields = fields;
+    return IB_OK;
+}
+
 ib_status_t ib_field_list_add_const(
     ib_field_t *f,
     const ib_field_t *fval
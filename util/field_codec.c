@@ -0,0 +1,716 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Binary Field Collection Codec
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/field_codec.h>
+
+#include <ironbee/bytestr.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/string_assembly.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The first byte of every encoded buffer.
+ */
+static const uint8_t CODEC_MARKER = IB_FIELD_CODEC_MARKER;
+
+/**
+ * How many fields a name table holds before it stops growing.
+ *
+ * A name past this limit is written in full instead of interned.
+ */
+static const size_t NAME_TABLE_MAX = 1024;
+
+/**
+ * One interned name.
+ */
+typedef struct codec_name_t {
+    const char *name;   /**< The name bytes. Not NUL-terminated. */
+    size_t      length; /**< Length of codec_name_t::name. */
+} codec_name_t;
+
+/**
+ * A growable table of interned names, shared by one encode or decode.
+ */
+typedef struct codec_names_t {
+    ib_mm_t       mm;    /**< Table storage is allocated from this. */
+    codec_name_t *names; /**< The interned names, by index. */
+    size_t        size;  /**< Number of interned names. */
+    size_t        alloc; /**< Capacity of codec_names_t::names. */
+} codec_names_t;
+
+/**
+ * Append @a name to @a table, or report the table full with IB_ENOENT.
+ */
+static ib_status_t names_add(
+    codec_names_t *table,
+    const char    *name,
+    size_t         length
+)
+{
+    assert(table != NULL);
+
+    if (table->size >= NAME_TABLE_MAX) {
+        return IB_ENOENT;
+    }
+
+    if (table->size == table->alloc) {
+        size_t        new_alloc = (table->alloc == 0) ? 16 : 2 * table->alloc;
+        codec_name_t *new_names =
+            ib_mm_alloc(table->mm, new_alloc * sizeof(*new_names));
+
+        if (new_names == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(new_names, table->names, table->size * sizeof(*new_names));
+        table->names = new_names;
+        table->alloc = new_alloc;
+    }
+
+    table->names[table->size].name   = name;
+    table->names[table->size].length = length;
+    ++table->size;
+
+    return IB_OK;
+}
+
+/**
+ * Append a varint (LEB128) to the assembly.
+ */
+static ib_status_t encode_varint(ib_sa_t *sa, uint64_t value)
+{
+    uint8_t buf[10];
+    size_t  len = 0;
+
+    do {
+        uint8_t byte = value & 0x7f;
+
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        buf[len++] = byte;
+    } while (value != 0);
+
+    return ib_sa_append_copy(sa, (const char *)buf, len);
+}
+
+/**
+ * Append a zigzag coded signed varint to the assembly.
+ */
+static ib_status_t encode_signed(ib_sa_t *sa, int64_t value)
+{
+    return encode_varint(sa, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+/**
+ * Append a field name to the assembly, interning it in @a table.
+ *
+ * A name already in the table is written as varint(index). A new name
+ * is written as varint(table size), its index-to-be, followed by its
+ * length and bytes; the decoder appends it to its own table at the
+ * same index.
+ */
+static ib_status_t encode_name(
+    ib_sa_t       *sa,
+    codec_names_t *table,
+    const char    *name,
+    size_t         length
+)
+{
+    assert(sa != NULL);
+    assert(table != NULL);
+
+    ib_status_t rc;
+
+    for (size_t i = 0; i < table->size; ++i) {
+        if (
+            table->names[i].length == length &&
+            memcmp(table->names[i].name, name, length) == 0
+        ) {
+            return encode_varint(sa, i);
+        }
+    }
+
+    rc = encode_varint(sa, table->size);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = encode_varint(sa, length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_sa_append(sa, name, length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = names_add(table, name, length);
+    if (rc == IB_ENOENT) {
+        /* Table full. The name was written in full, so the decoder,
+         * whose table filled at the same point, stays in sync. */
+        return IB_OK;
+    }
+    return rc;
+}
+
+/**
+ * Append one field record: type tag, name, value.
+ *
+ * List fields recurse.
+ */
+static ib_status_t encode_field(
+    ib_sa_t          *sa,
+    codec_names_t    *table,
+    const ib_field_t *field
+)
+{
+    assert(sa != NULL);
+    assert(table != NULL);
+    assert(field != NULL);
+
+    uint8_t     tag = (uint8_t)field->type;
+    ib_status_t rc;
+
+    rc = ib_sa_append_copy(sa, (const char *)&tag, 1);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = encode_name(sa, table, field->name, field->nlen);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    switch (field->type) {
+    case IB_FTYPE_NUM: {
+        ib_num_t num;
+
+        rc = ib_field_value(field, ib_ftype_num_out(&num));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        return encode_signed(sa, num);
+    }
+    case IB_FTYPE_TIME: {
+        ib_time_t time;
+
+        rc = ib_field_value(field, ib_ftype_time_out(&time));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        return encode_varint(sa, time);
+    }
+    case IB_FTYPE_FLOAT: {
+        /* Stored as an IEEE double, little-endian. Like the JSON
+         * path, this narrows the long double ib_float_t. */
+        ib_float_t value;
+        double     dbl;
+        uint64_t   bits;
+        uint8_t    buf[8];
+
+        rc = ib_field_value(field, ib_ftype_float_out(&value));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        dbl = (double)value;
+        memcpy(&bits, &dbl, sizeof(bits));
+        for (size_t i = 0; i < 8; ++i) {
+            buf[i] = (bits >> (8 * i)) & 0xff;
+        }
+        return ib_sa_append_copy(sa, (const char *)buf, sizeof(buf));
+    }
+    case IB_FTYPE_NULSTR: {
+        const char *str;
+        size_t      length;
+
+        rc = ib_field_value(field, ib_ftype_nulstr_out(&str));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        length = strlen(str);
+        rc = encode_varint(sa, length);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        return ib_sa_append(sa, str, length);
+    }
+    case IB_FTYPE_BYTESTR: {
+        const ib_bytestr_t *bs;
+
+        rc = ib_field_value(field, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = encode_varint(sa, ib_bytestr_length(bs));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        return ib_sa_append(
+            sa,
+            (const char *)ib_bytestr_const_ptr(bs),
+            ib_bytestr_length(bs));
+    }
+    case IB_FTYPE_LIST: {
+        const ib_list_t      *list;
+        const ib_list_node_t *node;
+
+        rc = ib_field_value(field, ib_ftype_list_out(&list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = encode_varint(sa, ib_list_elements(list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        IB_LIST_LOOP_CONST(list, node) {
+            rc = encode_field(
+                sa,
+                table,
+                (const ib_field_t *)ib_list_node_data_const(node));
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        return IB_OK;
+    }
+    default:
+        return IB_EINVAL;
+    }
+}
+
+ib_status_t ib_field_codec_encode(
+    ib_mm_t           mm,
+    const ib_list_t  *list,
+    uint8_t         **obuf,
+    size_t           *olen
+)
+{
+    assert(list != NULL);
+    assert(obuf != NULL);
+    assert(olen != NULL);
+
+    ib_sa_t              *sa = NULL;
+    ib_mpool_lite_t      *mp = NULL;
+    codec_names_t         table;
+    const ib_list_node_t *node;
+    const char           *out;
+    uint8_t               header[2];
+    ib_status_t           rc;
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    table.mm    = ib_mm_mpool_lite(mp);
+    table.names = NULL;
+    table.size  = 0;
+    table.alloc = 0;
+
+    rc = ib_sa_begin(&sa);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    header[0] = CODEC_MARKER;
+    header[1] = IB_FIELD_CODEC_VERSION;
+    rc = ib_sa_append_copy(sa, (const char *)header, sizeof(header));
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    rc = encode_varint(sa, ib_list_elements(list));
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    IB_LIST_LOOP_CONST(list, node) {
+        rc = encode_field(
+            sa,
+            &table,
+            (const ib_field_t *)ib_list_node_data_const(node));
+        if (rc != IB_OK) {
+            goto fail;
+        }
+    }
+
+    rc = ib_sa_finish(&sa, &out, olen, mm);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+    *obuf = (uint8_t *)out;
+
+    ib_mpool_lite_destroy(mp);
+    return IB_OK;
+
+fail:
+    if (sa != NULL) {
+        ib_sa_abort(&sa);
+    }
+    ib_mpool_lite_destroy(mp);
+    return rc;
+}
+
+/**
+ * A decode cursor over the input buffer.
+ */
+typedef struct codec_cursor_t {
+    const uint8_t *p;   /**< Next byte to read. */
+    const uint8_t *end; /**< One past the last byte. */
+} codec_cursor_t;
+
+/**
+ * Read @a length raw bytes, failing with IB_EINVAL when truncated.
+ */
+static ib_status_t decode_bytes(
+    codec_cursor_t  *cursor,
+    size_t           length,
+    const uint8_t  **out
+)
+{
+    if ((size_t)(cursor->end - cursor->p) < length) {
+        return IB_EINVAL;
+    }
+    *out = cursor->p;
+    cursor->p += length;
+    return IB_OK;
+}
+
+/**
+ * Read a varint, failing with IB_EINVAL when truncated or oversized.
+ */
+static ib_status_t decode_varint(codec_cursor_t *cursor, uint64_t *out)
+{
+    uint64_t value = 0;
+    int      shift = 0;
+
+    while (cursor->p < cursor->end && shift < 64) {
+        uint8_t byte = *(cursor->p)++;
+
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = value;
+            return IB_OK;
+        }
+        shift += 7;
+    }
+
+    return IB_EINVAL;
+}
+
+/**
+ * Read a zigzag coded signed varint.
+ */
+static ib_status_t decode_signed(codec_cursor_t *cursor, int64_t *out)
+{
+    uint64_t    value;
+    ib_status_t rc;
+
+    rc = decode_varint(cursor, &value);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    *out = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    return IB_OK;
+}
+
+/**
+ * Read a field name, mirroring the encoder's interning.
+ *
+ * The returned name aliases the input buffer or the name table;
+ * ib_field_create() copies it.
+ */
+static ib_status_t decode_name(
+    codec_cursor_t  *cursor,
+    codec_names_t   *table,
+    const char     **name,
+    size_t          *length
+)
+{
+    uint64_t    ref;
+    ib_status_t rc;
+
+    rc = decode_varint(cursor, &ref);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (ref < table->size) {
+        *name   = table->names[ref].name;
+        *length = table->names[ref].length;
+        return IB_OK;
+    }
+    if (ref != table->size) {
+        /* Forward references never occur in a valid buffer. */
+        return IB_EINVAL;
+    }
+
+    uint64_t       name_length;
+    const uint8_t *name_bytes;
+
+    rc = decode_varint(cursor, &name_length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = decode_bytes(cursor, name_length, &name_bytes);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *name   = (const char *)name_bytes;
+    *length = name_length;
+
+    rc = names_add(table, *name, *length);
+    if (rc == IB_ENOENT) {
+        /* Table full; the encoder stopped interning here too. */
+        return IB_OK;
+    }
+    return rc;
+}
+
+/**
+ * Read one field record, recursing into lists.
+ */
+static ib_status_t decode_field(
+    codec_cursor_t *cursor,
+    codec_names_t  *table,
+    ib_mm_t         mm,
+    ib_field_t    **field
+)
+{
+    const uint8_t *tag;
+    const char    *name;
+    size_t         name_length;
+    ib_status_t    rc;
+
+    rc = decode_bytes(cursor, 1, &tag);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = decode_name(cursor, table, &name, &name_length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    switch (*tag) {
+    case IB_FTYPE_NUM: {
+        int64_t num;
+
+        rc = decode_signed(cursor, &num);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        ib_num_t value = num;
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_NUM,
+            ib_ftype_num_in(&value));
+    }
+    case IB_FTYPE_TIME: {
+        uint64_t time;
+
+        rc = decode_varint(cursor, &time);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        ib_time_t value = time;
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_TIME,
+            ib_ftype_time_in(&value));
+    }
+    case IB_FTYPE_FLOAT: {
+        const uint8_t *buf;
+        uint64_t       bits = 0;
+        double         dbl;
+
+        rc = decode_bytes(cursor, 8, &buf);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            bits |= (uint64_t)buf[i] << (8 * i);
+        }
+        memcpy(&dbl, &bits, sizeof(dbl));
+        ib_float_t value = dbl;
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_FLOAT,
+            ib_ftype_float_in(&value));
+    }
+    case IB_FTYPE_NULSTR: {
+        uint64_t       length;
+        const uint8_t *bytes;
+        char          *str;
+
+        rc = decode_varint(cursor, &length);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = decode_bytes(cursor, length, &bytes);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        str = ib_mm_alloc(mm, length + 1);
+        if (str == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(str, bytes, length);
+        str[length] = '\0';
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_NULSTR,
+            ib_ftype_nulstr_in(str));
+    }
+    case IB_FTYPE_BYTESTR: {
+        uint64_t       length;
+        const uint8_t *bytes;
+        ib_bytestr_t  *bs;
+
+        rc = decode_varint(cursor, &length);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = decode_bytes(cursor, length, &bytes);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_bytestr_dup_mem(&bs, mm, bytes, length);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_BYTESTR,
+            ib_ftype_bytestr_in(bs));
+    }
+    case IB_FTYPE_LIST: {
+        uint64_t   count;
+        ib_list_t *list;
+
+        rc = decode_varint(cursor, &count);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_list_create(&list, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            ib_field_t *element;
+
+            rc = decode_field(cursor, table, mm, &element);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_list_push(list, element);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        return ib_field_create(
+            field, mm, name, name_length,
+            IB_FTYPE_LIST,
+            ib_ftype_list_in(list));
+    }
+    default:
+        return IB_EINVAL;
+    }
+}
+
+ib_status_t ib_field_codec_decode(
+    ib_mm_t         mm,
+    const uint8_t  *data_in,
+    size_t          dlen_in,
+    ib_list_t      *list_out,
+    const char    **error
+)
+{
+    assert(data_in != NULL);
+    assert(list_out != NULL);
+
+    codec_cursor_t   cursor;
+    codec_names_t    table;
+    ib_mpool_lite_t *mp;
+    uint64_t         count;
+    const char      *err = NULL;
+    ib_status_t      rc;
+
+    if (dlen_in < 2 || data_in[0] != CODEC_MARKER) {
+        err = "Not a binary field collection.";
+        rc  = IB_EINVAL;
+        goto done;
+    }
+    if (data_in[1] != IB_FIELD_CODEC_VERSION) {
+        err = "Unsupported binary field collection version.";
+        rc  = IB_EINVAL;
+        goto done;
+    }
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        err = "Allocation error.";
+        goto done;
+    }
+    table.mm    = ib_mm_mpool_lite(mp);
+    table.names = NULL;
+    table.size  = 0;
+    table.alloc = 0;
+
+    cursor.p   = data_in + 2;
+    cursor.end = data_in + dlen_in;
+
+    rc = decode_varint(&cursor, &count);
+    for (uint64_t i = 0; rc == IB_OK && i < count; ++i) {
+        ib_field_t *field;
+
+        rc = decode_field(&cursor, &table, mm, &field);
+        if (rc == IB_OK) {
+            rc = ib_list_push(list_out, field);
+        }
+    }
+    if (rc == IB_OK && cursor.p != cursor.end) {
+        rc = IB_EINVAL;
+    }
+    if (rc == IB_EINVAL) {
+        err = "Truncated or corrupt binary field collection.";
+    }
+    else if (rc != IB_OK) {
+        err = "Allocation error.";
+    }
+
+    ib_mpool_lite_destroy(mp);
+
+done:
+    if (error != NULL) {
+        *error = err;
+    }
+    return rc;
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Flight Recorder Implementation
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/flightrec.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/** One trace record. */
+typedef struct {
+    ib_time_t            time;  /**< Time recorded; zero if never used. */
+    const char          *label; /**< Static label. */
+    uint64_t             value; /**< Kind-specific value. */
+    ib_flightrec_kind_t  kind;  /**< What the record describes. */
+} flightrec_record_t;
+
+/** The calling thread's ring. Zero-initialized TLS; no setup needed. */
+static __thread struct {
+    flightrec_record_t records[IB_FLIGHTREC_RECORDS];
+    size_t             next;
+} s_ring;
+
+/** Upper bound of a rendered line, excluding its label. */
+static const size_t FLIGHTREC_LINE_OVERHEAD = 64;
+
+/** Map a record kind to its name in a dump. */
+static const char *flightrec_kind_name(ib_flightrec_kind_t kind)
+{
+    switch (kind) {
+    case IB_FLIGHTREC_STATE:
+        return "state";
+    case IB_FLIGHTREC_RULE:
+        return "rule";
+    case IB_FLIGHTREC_PUMP:
+        return "pump";
+    }
+    return "unknown";
+}
+
+void ib_flightrec_record(
+    ib_flightrec_kind_t  kind,
+    const char          *label,
+    uint64_t             value
+)
+{
+    assert(label != NULL);
+
+    flightrec_record_t *rec = &s_ring.records[s_ring.next];
+
+    s_ring.next = (s_ring.next + 1) % IB_FLIGHTREC_RECORDS;
+
+    rec->time  = ib_clock_get_time();
+    rec->label = label;
+    rec->value = value;
+    rec->kind  = kind;
+}
+
+ib_status_t ib_flightrec_dump(
+    ib_mm_t      mm,
+    ib_time_t    since,
+    const char **dump
+)
+{
+    assert(dump != NULL);
+
+    char *buf;
+    char *out;
+    size_t size = 1;
+    size_t i;
+
+    /* Size pass: upper-bound the rendered text. */
+    for (i = 0; i < IB_FLIGHTREC_RECORDS; ++i) {
+        const flightrec_record_t *rec = &s_ring.records[i];
+
+        if ((rec->time != 0) && (rec->time >= since)) {
+            size += strlen(rec->label) + FLIGHTREC_LINE_OVERHEAD;
+        }
+    }
+
+    buf = (char *)ib_mm_alloc(mm, size);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+    out = buf;
+
+    /* Render pass, oldest record first. The slot at next is the oldest
+     * once the ring has wrapped; slots never used render as empty. */
+    for (i = 0; i < IB_FLIGHTREC_RECORDS; ++i) {
+        const flightrec_record_t *rec =
+            &s_ring.records[(s_ring.next + i) % IB_FLIGHTREC_RECORDS];
+
+        if ((rec->time == 0) || (rec->time < since)) {
+            continue;
+        }
+
+        if (rec->value != 0) {
+            out += snprintf(out, size - (out - buf),
+                            "+%" PRIu64 "us %s %s %" PRIu64 "\n",
+                            rec->time - since,
+                            flightrec_kind_name(rec->kind),
+                            rec->label,
+                            rec->value);
+        }
+        else {
+            out += snprintf(out, size - (out - buf),
+                            "+%" PRIu64 "us %s %s\n",
+                            rec->time - since,
+                            flightrec_kind_name(rec->kind),
+                            rec->label);
+        }
+    }
+    *out = '\0';
+
+    *dump = buf;
+
+    return IB_OK;
+}
@@ -33,6 +33,10 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /* Internal Declarations */
 
 /**
@@ -50,15 +54,20 @@
 #define IB_HASH_INITIAL_SIZE 16
 
 /**
- * See ib_hash_entry_t()
+ * See ib_hash_slot_t()
  */
-typedef struct ib_hash_entry_t ib_hash_entry_t;
+typedef struct ib_hash_slot_t ib_hash_slot_t;
 
 /**
- * Entry in a ib_hash_t.
+ * Slot in a ib_hash_t.
+ *
+ * The table is open addressed: slots are stored inline in one contiguous
+ * array and collisions are resolved by linear probing, so a lookup touches
+ * consecutive memory instead of walking a per-entry linked list.  An empty
+ * slot is marked by @c key being NULL.
  **/
-struct ib_hash_entry_t {
-    /** Key. */
+struct ib_hash_slot_t {
+    /** Key; NULL marks the slot empty. */
     const char          *key;
     /** Length of @c key. */
     size_t               key_length;
@@ -66,24 +75,19 @@ struct ib_hash_entry_t {
     void                *value;
     /** Hash of @c key. */
     uint32_t             hash_value;
-    /** Next entry in slot for @c hash. */
-    ib_hash_entry_t     *next_entry;
 };
 
 /**
  * External iterator for ib_hash_t.
  *
- * The end of the sequence is indicated by @c current_entry being NULL.
- * Any iterator is invalidated by any mutating operation on the hash.
+ * The end of the sequence is indicated by @c slot_index exceeding the
+ * maximum slot index.  Any iterator is invalidated by any mutating
+ * operation on the hash.
  **/
 struct ib_hash_iterator_t {
     /** Hash table we are iterating through. */
     const ib_hash_t     *hash;
-    /** Current entry. */
-    ib_hash_entry_t     *current_entry;
-    /** Next entry. */
-    ib_hash_entry_t     *next_entry;
-    /** Which slot to look in next. */
+    /** Current (occupied) slot, or max_slot+1 at end of sequence. */
     size_t               slot_index;
 };
 
@@ -103,16 +107,16 @@ struct ib_hash_t {
     /**
      * Slots.
      *
-     * Each slot holds a (possibly empty) linked list of ib_hash_entry_t's,
-     * all of which have the same hash value.
+     * Contiguous array of max_slot+1 slots, probed linearly from the
+     * slot the key hashes to.  Robin-hood insertion keeps every entry's
+     * probe distance minimal, which bounds lookups and lets a miss stop
+     * as soon as it finds an entry closer to home than itself.
      **/
-    ib_hash_entry_t    **slots;
+    ib_hash_slot_t      *slots;
     /** Maximum slot index. */
     size_t               max_slot;
     /** Memory manager. */
     ib_mm_t              mm;
-    /** Linked list of removed hash entries to use for recycling. */
-    ib_hash_entry_t     *free;
     /** Number of entries. */
     size_t               size;
     /** Randomizer value. */
@@ -120,45 +124,57 @@ struct ib_hash_t {
 };
 
 /**
- * Search for an entry in @a hash matching @a key.
+ * Distance of the entry in slot @a slot_index from the slot it hashes to.
+ *
+ * @param[in] hash       Hash table.
+ * @param[in] slot_index Index of an occupied slot.
+ *
+ * @returns Probe distance of the entry at @a slot_index.
+ */
+static size_t ib_hash_probe_distance(
+    const ib_hash_t *hash,
+    size_t           slot_index
+);
+
+/**
+ * Search for the slot in @a hash holding @a key.
  *
  * @param[in]  hash       Hash table.
- * @param[out] hash_entry Hash entry.
+ * @param[out] slot_index Index of the slot holding @a key.
  * @param[in]  key        Key.
  * @param[in]  key_length Length of @a key.
+ * @param[in]  hash_value Hash value of @a key.
  *
  * @returns
  * - IB_OK on success.
  * - IB_ENOENT if @a key not found.
  */
-static ib_status_t ib_hash_find_entry(
-    const ib_hash_t  *hash,
-    ib_hash_entry_t **hash_entry,
-    const char       *key,
-    size_t            key_length
+static ib_status_t ib_hash_find_slot(
+    const ib_hash_t *hash,
+    size_t          *slot_index,
+    const char      *key,
+    size_t           key_length,
+    uint32_t         hash_value
 );
 
 /**
- * Search for a hash entry in the list of entries starting at @a first.
+ * Insert @a slot, known not to be present, into @a hash's slot array.
  *
- * @param[in] hash       Hash table.
- * @param[in] first      Beginning of list to search.
- * @param[in] key        Key to search for.
- * @param[in] key_length Length of @a key.
- * @param[in] hash_value Hash value of @a key.
+ * Uses robin-hood probing: whenever the entry being placed has probed
+ * further than the entry occupying the current slot, the two swap and
+ * probing continues with the displaced entry.  The array must have at
+ * least one empty slot.
  *
- * @returns Hash entry if found and NULL otherwise.
+ * @param[in,out] hash Hash table.
+ * @param[in]     slot Entry to insert.
  */
-static ib_hash_entry_t *ib_hash_find_htentry(
-     const ib_hash_t *hash,
-     ib_hash_entry_t *first,
-     const char      *key,
-     size_t           key_length,
-     uint32_t         hash_value
+static void ib_hash_place_slot(
+    ib_hash_t            *hash,
+    const ib_hash_slot_t *slot
 );
 
 /**
- * Set @a entry to every entry in @a hash in sequence.
+ * Set @a iterator to every entry in @a hash in sequence.
  *
  * @code
  * ib_hash_iterator_t iterator;
@@ -178,7 +194,7 @@ static ib_hash_entry_t *ib_hash_find_htentry(
     )
 
 /**
- * Resize the number of slots in @a hash.
+ * Double the number of slots in @a hash.
  *
  * @returns
  * - IB_OK on success.
@@ -199,76 +215,104 @@ static char ib_hash_tolower(
     char c
 );
 
+/**
+ * Downcase eight bytes at once.
+ *
+ * SWAR equivalent of applying ib_hash_tolower() to every byte of @a w:
+ * adds 0x20 to each byte in [A-Z] and leaves all others, including bytes
+ * with the high bit set, unchanged.  Used so the case-insensitive hash
+ * and compare need no per-byte table lookup on their bulk of the input.
+ *
+ * @param[in] w Eight bytes, packed in memory order.
+ * @return @a w with every ASCII uppercase byte downcased.
+ */
+inline
+static uint64_t ib_hash_tolower8(
+    uint64_t w
+);
+
 /* End Internal Declarations */
 
 /* Internal Definitions */
 
-ib_hash_entry_t *ib_hash_find_htentry(
+size_t ib_hash_probe_distance(
     const ib_hash_t *hash,
-    ib_hash_entry_t *first,
+    size_t           slot_index
+) {
+    assert(hash                              != NULL);
+    assert(hash->slots[slot_index].key != NULL);
+
+    /* hash->max_slot+1 is a power of 2 */
+    return
+        (slot_index - (hash->slots[slot_index].hash_value & hash->max_slot))
+        & hash->max_slot;
+}
+
+ib_status_t ib_hash_find_slot(
+    const ib_hash_t *hash,
+    size_t          *slot_index,
     const char      *key,
     size_t           key_length,
     uint32_t         hash_value
 ) {
-    assert(hash != NULL);
-    assert(key  != NULL);
+    assert(hash       != NULL);
+    assert(slot_index != NULL);
+    assert(key        != NULL);
 
-    for (
-        ib_hash_entry_t* current_entry = first;
-        current_entry != NULL;
-        current_entry = current_entry->next_entry
-    )
-    {
+    size_t current_index = hash_value & hash->max_slot;
+
+    for (size_t distance = 0; ; ++distance) {
+        const ib_hash_slot_t *current_slot = &hash->slots[current_index];
+
+        if (current_slot->key == NULL) {
+            return IB_ENOENT;
+        }
         if (
-            current_entry->hash_value == hash_value &&
+            current_slot->hash_value == hash_value &&
             hash->equal_predicate(
-                key,                key_length,
-                current_entry->key, current_entry->key_length,
+                key,               key_length,
+                current_slot->key, current_slot->key_length,
                 hash->equal_cbdata
             )
         ) {
-            return current_entry;
+            *slot_index = current_index;
+            return IB_OK;
         }
+        /* Robin-hood invariant: were the key present, it could not sit
+         * further from its home slot than the entry occupying this one. */
+        if (ib_hash_probe_distance(hash, current_index) < distance) {
+            return IB_ENOENT;
+        }
+        current_index = (current_index + 1) & hash->max_slot;
     }
-    return NULL;
 }
 
-ib_status_t ib_hash_find_entry(
-     const ib_hash_t  *hash,
-     ib_hash_entry_t **hash_entry,
-     const char       *key,
-     size_t            key_length
+void ib_hash_place_slot(
+    ib_hash_t            *hash,
+    const ib_hash_slot_t *slot
 ) {
-    assert(hash_entry != NULL);
-    assert(hash       != NULL);
-    assert(key        != NULL);
-
-    ib_hash_entry_t *current_slot  = NULL;
-    ib_hash_entry_t *current_entry = NULL;
-    uint32_t         hash_value    = 0;
-
-    hash_value = hash->hash_function(
-        key, key_length,
-        hash->randomizer,
-        hash->hash_cbdata
-    );
-
-    /* hash->max_slot+1 is a power of 2 */
-    current_slot = hash->slots[hash_value & hash->max_slot];
-    current_entry = ib_hash_find_htentry(
-        hash,
-        current_slot,
-        key,
-        key_length,
-        hash_value
-    );
-    if (current_entry == NULL) {
-        *hash_entry = NULL;
-        return IB_ENOENT;
+    assert(hash      != NULL);
+    assert(slot      != NULL);
+    assert(slot->key != NULL);
+
+    ib_hash_slot_t current       = *slot;
+    size_t         current_index = current.hash_value & hash->max_slot;
+    size_t         distance      = 0;
+
+    while (hash->slots[current_index].key != NULL) {
+        size_t existing_distance =
+            ib_hash_probe_distance(hash, current_index);
+
+        if (existing_distance < distance) {
+            ib_hash_slot_t displaced      = hash->slots[current_index];
+            hash->slots[current_index] = current;
+            current                       = displaced;
+            distance                      = existing_distance;
+        }
+        current_index = (current_index + 1) & hash->max_slot;
+        ++distance;
     }
-    *hash_entry = current_entry;
-
-    return IB_OK;
+    hash->slots[current_index] = current;
 }
 
 ib_hash_iterator_t *ib_hash_iterator_create(ib_mm_t mm)
@@ -286,7 +330,7 @@ ib_hash_iterator_t *ib_hash_iterator_create_malloc()
 
 bool ib_hash_iterator_at_end(const ib_hash_iterator_t *iterator)
 {
-    return iterator->current_entry == NULL;
+    return iterator->slot_index > iterator->hash->max_slot;
 }
 
 void ib_hash_iterator_first(
@@ -297,9 +341,13 @@ void ib_hash_iterator_first(
     assert(iterator != NULL);
     assert(hash     != NULL);
 
-    memset(iterator, 0, sizeof(*iterator));
-    iterator->hash = hash;
-    ib_hash_iterator_next(iterator);
+    iterator->hash       = hash;
+    iterator->slot_index = 0;
+    if (
+        hash->slots[0].key == NULL
+    ) {
+        ib_hash_iterator_next(iterator);
+    }
 }
 
 void ib_hash_iterator_fetch(
@@ -311,14 +359,17 @@ void ib_hash_iterator_fetch(
 {
     assert(iterator != NULL);
 
+    const ib_hash_slot_t *slot =
+        &iterator->hash->slots[iterator->slot_index];
+
     if (key != NULL) {
-        *key            = iterator->current_entry->key;
+        *key            = slot->key;
     }
     if (key_length != NULL) {
-        *key_length     = iterator->current_entry->key_length;
+        *key_length     = slot->key_length;
     }
     if (value != NULL) {
-        *(void **)value = iterator->current_entry->value;
+        *(void **)value = slot->value;
     }
 }
 
@@ -327,15 +378,12 @@ void ib_hash_iterator_next(
 ) {
     assert(iterator != NULL);
 
-    iterator->current_entry = iterator->next_entry;
-    while (! iterator->current_entry) {
-        if (iterator->slot_index > iterator->hash->max_slot) {
-            return;
-        }
-        iterator->current_entry = iterator->hash->slots[iterator->slot_index];
+    do {
         ++iterator->slot_index;
-    }
-    iterator->next_entry = iterator->current_entry->next_entry;
+    } while (
+        iterator->slot_index <= iterator->hash->max_slot &&
+        iterator->hash->slots[iterator->slot_index].key == NULL
+    );
 }
 
 void ib_hash_iterator_copy(
@@ -352,10 +400,8 @@ bool ib_hash_iterator_equal(
 )
 {
     return
-        a->hash          == b->hash          &&
-        a->current_entry == b->current_entry &&
-        a->next_entry    == b->next_entry    &&
-        a->slot_index    == b->slot_index
+        a->hash       == b->hash &&
+        a->slot_index == b->slot_index
         ;
 }
 
@@ -364,29 +410,28 @@ ib_status_t ib_hash_resize_slots(
 ) {
     assert(hash != NULL);
 
-    ib_hash_entry_t    **new_slots     = NULL;
-    size_t               new_max_slot = 0;
-    ib_hash_iterator_t   i;
+    ib_hash_slot_t *old_slots    = hash->slots;
+    size_t          old_max_slot = hash->max_slot;
+    ib_hash_slot_t *new_slots    = NULL;
 
     /* Maintain power of 2 slots */
-    new_max_slot = 2 * hash->max_slot + 1;
-    new_slots = (ib_hash_entry_t **)ib_mm_calloc(
+    new_slots = (ib_hash_slot_t *)ib_mm_calloc(
         hash->mm,
-        new_max_slot + 1,
+        2 * (old_max_slot + 1),
         sizeof(*new_slots)
     );
     if (new_slots == NULL) {
         return IB_EALLOC;
     }
 
-    IB_HASH_LOOP(i, hash) {
-        size_t j =
-            i.current_entry->hash_value & new_max_slot;
-        i.current_entry->next_entry = new_slots[j];
-        new_slots[j] = i.current_entry;
+    hash->max_slot = 2 * old_max_slot + 1;
+    hash->slots    = new_slots;
+
+    for (size_t i = 0; i <= old_max_slot; ++i) {
+        if (old_slots[i].key != NULL) {
+            ib_hash_place_slot(hash, &old_slots[i]);
+        }
     }
-    hash->max_slot = new_max_slot;
-    hash->slots     = new_slots;
 
     return IB_OK;
 }
@@ -434,6 +479,47 @@ static char ib_hash_tolower(
     return s_table[(unsigned char)c];
 }
 
+inline
+static uint64_t ib_hash_tolower8(
+    uint64_t w
+)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t high = 0x8080808080808080ULL;
+
+    /* Per byte: high bit of ge_a is set iff the low seven bits are >= 'A',
+     * high bit of gt_z iff they are > 'Z'.  Clearing bytes of w with the
+     * high bit already set restricts the result to ASCII uppercase. */
+    uint64_t heptets  = w & ~high;
+    uint64_t ge_a     = heptets + ((0x80 - 'A') * ones);
+    uint64_t gt_z     = heptets + ((0x7f - 'Z') * ones);
+    uint64_t is_upper = (ge_a & ~gt_z & ~w) & high;
+
+    return w | (is_upper >> 2);
+}
+
+#if defined(__SSE2__)
+/**
+ * Downcase sixteen bytes at once.
+ *
+ * Vector equivalent of ib_hash_tolower8(); bytes with the high bit set
+ * compare as negative and so are never adjusted.
+ *
+ * @param[in] w Sixteen input bytes.
+ * @return @a w with every ASCII uppercase byte downcased.
+ */
+static inline __m128i ib_hash_tolower16(
+    __m128i w
+)
+{
+    __m128i is_upper = _mm_and_si128(
+        _mm_cmpgt_epi8(w, _mm_set1_epi8('A' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), w)
+    );
+    return _mm_add_epi8(w, _mm_and_si128(is_upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
 /* End Internal Definitions */
 
 uint32_t ib_hashfunc_djb2(
@@ -464,8 +550,28 @@ uint32_t ib_hashfunc_djb2_nocase(
 
     uint32_t             hash  = randomizer;
     const unsigned char *key_s = (const unsigned char *)key;
-
-    for (size_t i = 0; i < key_length; ++i) {
+    size_t               i     = 0;
+
+    /* The multiply chain is serial, but downcasing eight bytes per
+     * iteration replaces eight dependent table loads with register
+     * arithmetic. */
+    while (i + sizeof(uint64_t) <= key_length) {
+        uint64_t w;
+        /* char, not unsigned char: the byte-wise loop below adds the
+         * sign-extended result of ib_hash_tolower() and hash values must
+         * not depend on which loop processed a byte. */
+        char     lowered[sizeof(uint64_t)];
+
+        memcpy(&w, key_s + i, sizeof(w));
+        w = ib_hash_tolower8(w);
+        memcpy(lowered, &w, sizeof(lowered));
+
+        for (size_t j = 0; j < sizeof(lowered); ++j) {
+            hash = ((hash << 5) + hash) + lowered[j];
+        }
+        i += sizeof(uint64_t);
+    }
+    for (; i < key_length; ++i) {
         hash = ((hash << 5) + hash) + ib_hash_tolower(key_s[i]);
     }
 
@@ -497,12 +603,38 @@ int ib_hashequal_nocase(
 
     const unsigned char *a_s = (const unsigned char *)a;
     const unsigned char *b_s = (const unsigned char *)b;
+    size_t               i   = 0;
 
     if (a_length != b_length) {
         return 0;
     }
 
-    for (size_t i = 0; i < a_length; ++i) {
+#if defined(__SSE2__)
+    while (i + 16 <= a_length) {
+        __m128i va = ib_hash_tolower16(
+            _mm_loadu_si128((const __m128i *)(a_s + i))
+        );
+        __m128i vb = ib_hash_tolower16(
+            _mm_loadu_si128((const __m128i *)(b_s + i))
+        );
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff) {
+            return 0;
+        }
+        i += 16;
+    }
+#endif
+    while (i + sizeof(uint64_t) <= a_length) {
+        uint64_t wa;
+        uint64_t wb;
+
+        memcpy(&wa, a_s + i, sizeof(wa));
+        memcpy(&wb, b_s + i, sizeof(wb));
+        if (ib_hash_tolower8(wa) != ib_hash_tolower8(wb)) {
+            return 0;
+        }
+        i += sizeof(uint64_t);
+    }
+    for (; i < a_length; ++i) {
         if (ib_hash_tolower(a_s[i]) != ib_hash_tolower(b_s[i])) {
             return 0;
         }
@@ -547,9 +679,9 @@ ib_status_t ib_hash_create_ex(
         return IB_EALLOC;
     }
 
-    ib_hash_entry_t **slots = (ib_hash_entry_t **)ib_mm_calloc(
+    ib_hash_slot_t *slots = (ib_hash_slot_t *)ib_mm_calloc(
         mm,
-        size + 1,
+        size,
         sizeof(*slots)
     );
     if (slots == NULL) {
@@ -564,7 +696,6 @@ ib_status_t ib_hash_create_ex(
     new_hash->max_slot        = size-1;
     new_hash->slots           = slots;
     new_hash->mm              = mm;
-    new_hash->free            = NULL;
     new_hash->size            = 0;
     new_hash->randomizer      = (uint32_t)clock();
 
@@ -627,25 +758,31 @@ ib_status_t ib_hash_get_ex(
 ) {
     assert(hash  != NULL);
 
-    ib_status_t      rc;
-    ib_hash_entry_t *current_entry = NULL;
+    ib_status_t rc;
+    size_t      slot_index = 0;
+    uint32_t    hash_value;
 
     if (key == NULL) {
         *(void **)value = NULL;
         return IB_EINVAL;
     }
 
-    rc = ib_hash_find_entry(
+    hash_value = hash->hash_function(
+        key, key_length,
+        hash->randomizer,
+        hash->hash_cbdata
+    );
+
+    rc = ib_hash_find_slot(
         hash,
-        &current_entry,
+        &slot_index,
         key,
-        key_length
+        key_length,
+        hash_value
     );
     if (value != NULL) {
         if (rc == IB_OK) {
-            assert(current_entry != NULL);
-
-            *(void **)value = current_entry->value;
+            *(void **)value = hash->slots[slot_index].value;
         }
         else {
             *(void **)value = NULL;
@@ -686,7 +823,7 @@ ib_status_t ib_hash_get_all(
 
     ib_hash_iterator_t i;
     IB_HASH_LOOP(i, hash) {
-        ib_list_push(list, i.current_entry->value);
+        ib_list_push(list, hash->slots[i.slot_index].value);
     }
 
     if (ib_list_elements(list) <= 0) {
@@ -705,94 +842,63 @@ ib_status_t ib_hash_set_ex(
     assert(hash != NULL);
     assert(key  != NULL);
 
-    uint32_t     hash_value = 0;
-    size_t       slot_index = 0;
-    int          found      = 0;
-
-    ib_hash_entry_t  *current_entry         = NULL;
-    /* Points to pointer that points to current_entry */
-    ib_hash_entry_t **current_entry_handle  = NULL;
+    ib_status_t rc;
+    uint32_t    hash_value;
+    size_t      slot_index = 0;
 
     hash_value = hash->hash_function(
         key, key_length,
         hash->randomizer,
         hash->hash_cbdata
     );
-    slot_index = (hash_value & hash->max_slot);
-
-    current_entry_handle = &hash->slots[slot_index];
-
-    while (*current_entry_handle != NULL) {
-        current_entry = *current_entry_handle;
-        if (
-            current_entry->hash_value == hash_value &&
-            hash->equal_predicate(
-               current_entry->key, current_entry->key_length,
-               key,                key_length,
-               hash->equal_cbdata
-            )
-        ) {
-            found = 1;
-            break;
-        }
-        current_entry_handle = &(current_entry->next_entry);
-    }
-    /* current_entry is now the entry to change, and current_entry_handler
-     * points to the pointer to it.
-     */
-    if (found) {
-        assert(current_entry != NULL);
-        assert(current_entry == *current_entry_handle);
 
+    rc = ib_hash_find_slot(hash, &slot_index, key, key_length, hash_value);
+    if (rc == IB_OK) {
         /* Update. */
-        current_entry->value = value;
+        hash->slots[slot_index].value = value;
 
         /* Delete if appropriate. */
         if (value == NULL) {
-            /* Delete */
+            /* Delete, shifting subsequent entries back so no gap
+             * interrupts any entry's probe sequence. */
             --hash->size;
 
-            /* Remove from slot list. */
-            *current_entry_handle = current_entry->next_entry;
+            for (;;) {
+                size_t next_index = (slot_index + 1) & hash->max_slot;
 
-            /* Add to free list. */
-            current_entry->next_entry = hash->free;
-            hash->free                = current_entry;
+                if (
+                    hash->slots[next_index].key == NULL ||
+                    ib_hash_probe_distance(hash, next_index) == 0
+                ) {
+                    break;
+                }
+                hash->slots[slot_index] = hash->slots[next_index];
+                slot_index = next_index;
+            }
+            hash->slots[slot_index].key = NULL;
         }
     }
     else {
-        /* It's not in the list. Add it if value != NULL. */
+        /* It's not in the table. Add it if value != NULL. */
         if (value != NULL) {
-            ib_hash_entry_t *entry = NULL;
+            ib_hash_slot_t slot;
 
-            if (hash->free != NULL) {
-                entry = hash->free;
-                hash->free = entry->next_entry;
-            }
-            else {
-                entry = (ib_hash_entry_t *)ib_mm_alloc(
-                    hash->mm,
-                    sizeof(*entry)
-                );
-                if (entry == NULL) {
-                    return IB_EALLOC;
+            /* Grow at 3/4 load to keep probe sequences short. */
+            if (4 * (hash->size + 1) > 3 * (hash->max_slot + 1)) {
+                rc = ib_hash_resize_slots(hash);
+                if (rc != IB_OK) {
+                    return rc;
                 }
             }
 
-            entry->hash_value = hash_value;
-            entry->key        = key;
-            entry->key_length = key_length;
-            entry->value      = value;
-            entry->next_entry = hash->slots[slot_index];
+            slot.hash_value = hash_value;
+            slot.key        = key;
+            slot.key_length = key_length;
+            slot.value      = value;
 
-            hash->slots[slot_index] = entry;
+            ib_hash_place_slot(hash, &slot);
 
             ++hash->size;
-
-            /* If we have more elements that slots, resize. */
-            if (hash->size > hash->max_slot+1) {
-                return ib_hash_resize_slots(hash);
-            }
         }
         /* Else value == NULL and no changes are needed. */
     }
@@ -819,22 +925,7 @@ ib_status_t ib_hash_set(
 void ib_hash_clear(ib_hash_t *hash) {
     assert(hash != NULL);
 
-    for (size_t i = 0; i <= hash->max_slot; ++i) {
-        if (hash->slots[i] != NULL) {
-            ib_hash_entry_t *current_entry;
-            for (
-                current_entry = hash->slots[i];
-                current_entry->next_entry != NULL;
-                current_entry = current_entry->next_entry
-            ) {
-                current_entry->value = NULL;
-            }
-
-            current_entry->next_entry = hash->free;
-            hash->free                = hash->slots[i];
-            hash->slots[i]            = NULL;
-        }
-    }
+    memset(hash->slots, 0, (hash->max_slot + 1) * sizeof(*hash->slots));
     hash->size = 0;
 
     return;
@@ -28,6 +28,7 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/ipset.h>
+#include <ironbee/mm.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -310,6 +311,536 @@ int ib_ipset6_compare(
     return ib_ipset6_compare_strict(a, b);
 }
 
+/* Trie index
+ *
+ * The optional index built by ib_ipset4_init_ex() and ib_ipset6_init_ex()
+ * is a path-compressed binary trie over the entry arrays.  Each node covers
+ * a canonical network; a child covers a strictly longer network of which the
+ * parent is a prefix, and is selected by the key bit at the parent's prefix
+ * length.  Because path compression can skip bits, each step re-checks that
+ * the node's full prefix matches the key.  A descent visits every network
+ * containing the key, most general first, so a single pass yields both the
+ * most general and most specific matching entries.
+ */
+
+/**
+ * A node of the trie index (v4 version).
+ */
+struct ib_ipset4_node_t
+{
+    ib_ip4_network_t         network;     /**< Canonical network of node. */
+    const ib_ipset4_entry_t *entry;       /**< Entry for network; or NULL. */
+    ib_ipset4_node_t        *children[2]; /**< Subtries, keyed by the bit of
+                                               the key at @c network.size. */
+};
+
+/**
+ * A node of the trie index (v6 version).
+ *
+ * @sa ib_ipset4_node_t
+ */
+struct ib_ipset6_node_t
+{
+    ib_ip6_network_t         network;     /**< Canonical network of node. */
+    const ib_ipset6_entry_t *entry;       /**< Entry for network; or NULL. */
+    ib_ipset6_node_t        *children[2]; /**< Subtries, keyed by the bit of
+                                               the key at @c network.size. */
+};
+
+/**
+ * Bit @a i of @a ip, counting from the most significant bit. (v4 version)
+ *
+ * @param[in] ip IP to extract a bit of.
+ * @param[in] i  Bit index; must be less than 32.
+ * @return 0 or 1.
+ */
+static
+int ib_ipset4_bit(ib_ip4_t ip, size_t i)
+{
+    assert(i < 32);
+
+    return (ip >> (31 - i)) & 1;
+}
+
+/**
+ * Bit @a i of @a ip, counting from the most significant bit. (v6 version)
+ *
+ * @param[in] ip IP to extract a bit of.
+ * @param[in] i  Bit index; must be less than 128.
+ * @return 0 or 1.
+ */
+static
+int ib_ipset6_bit(const ib_ip6_t *ip, size_t i)
+{
+    assert(i < 128);
+
+    return (ip->ip[i / 32] >> (31 - (i % 32))) & 1;
+}
+
+/**
+ * Length of the common initial bits of @a a and @a b. (v4 version)
+ *
+ * @param[in] a     LHS.
+ * @param[in] b     RHS.
+ * @param[in] limit Maximum length to report.
+ * @return Number of common initial bits, at most @a limit.
+ */
+static
+size_t ib_ipset4_common_prefix(ib_ip4_t a, ib_ip4_t b, size_t limit)
+{
+    uint32_t difference = a ^ b;
+    size_t   length;
+
+    if (difference == 0) {
+        length = 32;
+    }
+    else {
+        length = __builtin_clz(difference);
+    }
+    return length < limit ? length : limit;
+}
+
+/**
+ * Length of the common initial bits of @a a and @a b. (v6 version)
+ *
+ * @param[in] a     LHS.
+ * @param[in] b     RHS.
+ * @param[in] limit Maximum length to report.
+ * @return Number of common initial bits, at most @a limit.
+ */
+static
+size_t ib_ipset6_common_prefix(
+    const ib_ip6_t *a,
+    const ib_ip6_t *b,
+    size_t          limit
+)
+{
+    size_t length = 0;
+
+    for (size_t i = 0; i < 4; ++i) {
+        uint32_t difference = a->ip[i] ^ b->ip[i];
+        if (difference == 0) {
+            length += 32;
+            continue;
+        }
+        length += __builtin_clz(difference);
+        break;
+    }
+    return length < limit ? length : limit;
+}
+
+/**
+ * Insert @a entry into the trie rooted at @a *root. (v4 version)
+ *
+ * Assumes @a entry holds a canonical network.  If the network is already
+ * present, the existing entry is kept.
+ *
+ * @param[in]     mm    Memory manager to allocate nodes from.
+ * @param[in,out] root  Root of trie; updated as needed.
+ * @param[in]     entry Entry to insert.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ib_ipset4_trie_insert(
+    ib_mm_t                  mm,
+    ib_ipset4_node_t       **root,
+    const ib_ipset4_entry_t *entry
+)
+{
+    ib_ipset4_node_t **link = root;
+    ib_ip4_network_t   net  = entry->network;
+
+    for (;;) {
+        ib_ipset4_node_t *node = *link;
+        ib_ipset4_node_t *split;
+        size_t            common;
+
+        if (node == NULL) {
+            node = (ib_ipset4_node_t *)ib_mm_calloc(mm, 1, sizeof(*node));
+            if (node == NULL) {
+                return IB_EALLOC;
+            }
+            node->network = net;
+            node->entry   = entry;
+            *link = node;
+            return IB_OK;
+        }
+
+        common = ib_ipset4_common_prefix(
+            node->network.ip,
+            net.ip,
+            node->network.size < net.size ? node->network.size : net.size
+        );
+
+        if (common == node->network.size) {
+            if (common == net.size) {
+                /* Same network; keep the existing entry. */
+                if (node->entry == NULL) {
+                    node->entry = entry;
+                }
+                return IB_OK;
+            }
+            /* Node is a proper prefix of net; descend. */
+            link = &node->children[ib_ipset4_bit(net.ip, common)];
+            continue;
+        }
+
+        /* Prefixes diverge below node; split at the common prefix. */
+        split = (ib_ipset4_node_t *)ib_mm_calloc(mm, 1, sizeof(*split));
+        if (split == NULL) {
+            return IB_EALLOC;
+        }
+        split->network.ip   = net.ip & ib_ipset4_mask(common);
+        split->network.size = common;
+        split->children[ib_ipset4_bit(node->network.ip, common)] = node;
+        if (common == net.size) {
+            split->entry = entry;
+        }
+        else {
+            ib_ipset4_node_t *leaf =
+                (ib_ipset4_node_t *)ib_mm_calloc(mm, 1, sizeof(*leaf));
+            if (leaf == NULL) {
+                return IB_EALLOC;
+            }
+            leaf->network = net;
+            leaf->entry   = entry;
+            split->children[ib_ipset4_bit(net.ip, common)] = leaf;
+        }
+        *link = split;
+        return IB_OK;
+    }
+}
+
+/**
+ * Insert @a entry into the trie rooted at @a *root. (v6 version)
+ *
+ * @sa ib_ipset4_trie_insert()
+ *
+ * @param[in]     mm    Memory manager to allocate nodes from.
+ * @param[in,out] root  Root of trie; updated as needed.
+ * @param[in]     entry Entry to insert.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ib_ipset6_trie_insert(
+    ib_mm_t                  mm,
+    ib_ipset6_node_t       **root,
+    const ib_ipset6_entry_t *entry
+)
+{
+    ib_ipset6_node_t **link = root;
+    ib_ip6_network_t   net  = entry->network;
+
+    for (;;) {
+        ib_ipset6_node_t *node = *link;
+        ib_ipset6_node_t *split;
+        ib_ip6_network_t  prefix;
+        size_t            common;
+
+        if (node == NULL) {
+            node = (ib_ipset6_node_t *)ib_mm_calloc(mm, 1, sizeof(*node));
+            if (node == NULL) {
+                return IB_EALLOC;
+            }
+            node->network = net;
+            node->entry   = entry;
+            *link = node;
+            return IB_OK;
+        }
+
+        common = ib_ipset6_common_prefix(
+            &node->network.ip,
+            &net.ip,
+            node->network.size < net.size ? node->network.size : net.size
+        );
+
+        if (common == node->network.size) {
+            if (common == net.size) {
+                /* Same network; keep the existing entry. */
+                if (node->entry == NULL) {
+                    node->entry = entry;
+                }
+                return IB_OK;
+            }
+            /* Node is a proper prefix of net; descend. */
+            link = &node->children[ib_ipset6_bit(&net.ip, common)];
+            continue;
+        }
+
+        /* Prefixes diverge below node; split at the common prefix. */
+        split = (ib_ipset6_node_t *)ib_mm_calloc(mm, 1, sizeof(*split));
+        if (split == NULL) {
+            return IB_EALLOC;
+        }
+        prefix.ip   = net.ip;
+        prefix.size = common;
+        split->network.ip   = ib_ipset6_canonical(prefix);
+        split->network.size = common;
+        split->children[ib_ipset6_bit(&node->network.ip, common)] = node;
+        if (common == net.size) {
+            split->entry = entry;
+        }
+        else {
+            ib_ipset6_node_t *leaf =
+                (ib_ipset6_node_t *)ib_mm_calloc(mm, 1, sizeof(*leaf));
+            if (leaf == NULL) {
+                return IB_EALLOC;
+            }
+            leaf->network = net;
+            leaf->entry   = entry;
+            split->children[ib_ipset6_bit(&net.ip, common)] = leaf;
+        }
+        *link = split;
+        return IB_OK;
+    }
+}
+
+/**
+ * Aggregate networks that exactly cover their parent. (v4 version)
+ *
+ * If both children of an entry-less node carry fully covered networks one
+ * bit longer than the node's, then membership in the node's network implies
+ * membership in the set and the node is marked with one of the child
+ * entries so queries can stop descending.  Only safe for the negative
+ * networks, which are tested solely for membership; positive entries have
+ * identity (data) that aggregation would discard.
+ *
+ * @param[in] node Subtrie to aggregate; may be NULL.
+ * @return true iff the subtrie fully covers @a node's network.
+ */
+static
+bool ib_ipset4_trie_aggregate(ib_ipset4_node_t *node)
+{
+    bool left_full;
+    bool right_full;
+
+    if (node == NULL) {
+        return false;
+    }
+
+    left_full  = ib_ipset4_trie_aggregate(node->children[0]);
+    right_full = ib_ipset4_trie_aggregate(node->children[1]);
+
+    if (node->entry != NULL) {
+        return true;
+    }
+
+    if (
+        left_full && right_full &&
+        node->children[0]->network.size == (size_t)node->network.size + 1 &&
+        node->children[1]->network.size == (size_t)node->network.size + 1
+    ) {
+        node->entry = node->children[0]->entry;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Aggregate networks that exactly cover their parent. (v6 version)
+ *
+ * @sa ib_ipset4_trie_aggregate()
+ *
+ * @param[in] node Subtrie to aggregate; may be NULL.
+ * @return true iff the subtrie fully covers @a node's network.
+ */
+static
+bool ib_ipset6_trie_aggregate(ib_ipset6_node_t *node)
+{
+    bool left_full;
+    bool right_full;
+
+    if (node == NULL) {
+        return false;
+    }
+
+    left_full  = ib_ipset6_trie_aggregate(node->children[0]);
+    right_full = ib_ipset6_trie_aggregate(node->children[1]);
+
+    if (node->entry != NULL) {
+        return true;
+    }
+
+    if (
+        left_full && right_full &&
+        node->children[0]->network.size == (size_t)node->network.size + 1 &&
+        node->children[1]->network.size == (size_t)node->network.size + 1
+    ) {
+        node->entry = node->children[0]->entry;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Find the most general and most specific entries containing @a ip.
+ * (v4 version)
+ *
+ * @param[in]  node         Trie to search; may be NULL.
+ * @param[in]  ip           IP to search for.
+ * @param[out] out_general  Most general containing entry; unchanged if no
+ *                          entry contains @a ip.  May not be NULL.
+ * @param[out] out_specific Most specific containing entry; unchanged if no
+ *                          entry contains @a ip.  May not be NULL.
+ */
+static
+void ib_ipset4_trie_find(
+    const ib_ipset4_node_t   *node,
+    ib_ip4_t                  ip,
+    const ib_ipset4_entry_t **out_general,
+    const ib_ipset4_entry_t **out_specific
+)
+{
+    while (node != NULL) {
+        /* Path compression skips bits; check the full prefix. */
+        if ((ip & ib_ipset4_mask(node->network.size)) != node->network.ip) {
+            return;
+        }
+        if (node->entry != NULL) {
+            if (*out_general == NULL) {
+                *out_general = node->entry;
+            }
+            *out_specific = node->entry;
+        }
+        if (node->network.size >= 32) {
+            return;
+        }
+        node = node->children[ib_ipset4_bit(ip, node->network.size)];
+    }
+}
+
+/**
+ * Find the most general and most specific entries containing @a ip.
+ * (v6 version)
+ *
+ * @sa ib_ipset4_trie_find()
+ *
+ * @param[in]  node         Trie to search; may be NULL.
+ * @param[in]  ip           IP to search for.
+ * @param[out] out_general  Most general containing entry; unchanged if no
+ *                          entry contains @a ip.  May not be NULL.
+ * @param[out] out_specific Most specific containing entry; unchanged if no
+ *                          entry contains @a ip.  May not be NULL.
+ */
+static
+void ib_ipset6_trie_find(
+    const ib_ipset6_node_t   *node,
+    const ib_ip6_t           *ip,
+    const ib_ipset6_entry_t **out_general,
+    const ib_ipset6_entry_t **out_specific
+)
+{
+    while (node != NULL) {
+        /* Path compression skips bits; check the full prefix. */
+        if (
+            ib_ipset6_common_prefix(&node->network.ip, ip, node->network.size)
+            != node->network.size
+        ) {
+            return;
+        }
+        if (node->entry != NULL) {
+            if (*out_general == NULL) {
+                *out_general = node->entry;
+            }
+            *out_specific = node->entry;
+        }
+        if (node->network.size >= 128) {
+            return;
+        }
+        node = node->children[ib_ipset6_bit(ip, node->network.size)];
+    }
+}
+
+/**
+ * Build a trie over @a entries. (v4 version)
+ *
+ * Assumes @a entries is canonical, i.e., after ib_ipset4_init().
+ *
+ * @param[in]  mm          Memory manager to allocate nodes from.
+ * @param[in]  entries     Entries to index.
+ * @param[in]  num_entries Number of entries in @a entries.
+ * @param[in]  aggregate   Aggregate covering networks; only valid for
+ *                         entries queried solely for membership.
+ * @param[out] out_trie    The built trie; NULL if @a num_entries is 0.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ib_ipset4_trie_build(
+    ib_mm_t                  mm,
+    const ib_ipset4_entry_t *entries,
+    size_t                   num_entries,
+    bool                     aggregate,
+    const ib_ipset4_node_t **out_trie
+)
+{
+    ib_ipset4_node_t *root = NULL;
+
+    for (size_t i = 0; i < num_entries; ++i) {
+        ib_status_t rc = ib_ipset4_trie_insert(mm, &root, &entries[i]);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    if (aggregate) {
+        ib_ipset4_trie_aggregate(root);
+    }
+
+    *out_trie = root;
+    return IB_OK;
+}
+
+/**
+ * Build a trie over @a entries. (v6 version)
+ *
+ * @sa ib_ipset4_trie_build()
+ *
+ * @param[in]  mm          Memory manager to allocate nodes from.
+ * @param[in]  entries     Entries to index.
+ * @param[in]  num_entries Number of entries in @a entries.
+ * @param[in]  aggregate   Aggregate covering networks; only valid for
+ *                         entries queried solely for membership.
+ * @param[out] out_trie    The built trie; NULL if @a num_entries is 0.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ib_ipset6_trie_build(
+    ib_mm_t                  mm,
+    const ib_ipset6_entry_t *entries,
+    size_t                   num_entries,
+    bool                     aggregate,
+    const ib_ipset6_node_t **out_trie
+)
+{
+    ib_ipset6_node_t *root = NULL;
+
+    for (size_t i = 0; i < num_entries; ++i) {
+        ib_status_t rc = ib_ipset6_trie_insert(mm, &root, &entries[i]);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    if (aggregate) {
+        ib_ipset6_trie_aggregate(root);
+    }
+
+    *out_trie = root;
+    return IB_OK;
+}
+
 /**
  * Generic query routine for an entry of entries.
  *
@@ -495,6 +1026,181 @@ ib_status_t ib_ipset_query(
     return IB_OK;
 }
 
+/**
+ * Query the trie indexes of @a set for @a ip. (v4 version)
+ *
+ * As ib_ipset4_query(), but descends the tries built by
+ * ib_ipset4_init_ex() instead of binary searching the arrays.
+ *
+ * @param[in]  set                IP set to query.
+ * @param[in]  ip                 IP to query.
+ * @param[out] out_entry          See ib_ipset4_query().
+ * @param[out] out_specific_entry See ib_ipset4_query().
+ * @param[out] out_general_entry  See ib_ipset4_query().
+ *
+ * @return
+ * - IB_OK if @a ip is in @a set.
+ * - IB_ENOENT if @a ip is not in @a set.
+ */
+static
+ib_status_t ib_ipset4_query_trie(
+    const ib_ipset4_t        *set,
+    ib_ip4_t                  ip,
+    const ib_ipset4_entry_t **out_entry,
+    const ib_ipset4_entry_t **out_specific_entry,
+    const ib_ipset4_entry_t **out_general_entry
+)
+{
+    const ib_ipset4_entry_t *general  = NULL;
+    const ib_ipset4_entry_t *specific = NULL;
+
+    if (out_entry != NULL) {
+        *out_entry = NULL;
+    }
+    if (out_specific_entry != NULL) {
+        *out_specific_entry = NULL;
+    }
+    if (out_general_entry != NULL) {
+        *out_general_entry = NULL;
+    }
+
+    ib_ipset4_trie_find(set->negative_trie, ip, &general, &specific);
+    if (specific != NULL) {
+        return IB_ENOENT;
+    }
+
+    general  = NULL;
+    specific = NULL;
+    ib_ipset4_trie_find(set->positive_trie, ip, &general, &specific);
+    if (specific == NULL) {
+        return IB_ENOENT;
+    }
+
+    /* Reproduce the array path's outputs: extend from the most specific
+     * entry to the contiguous run of matching entries around it, so
+     * [general, specific] can be treated as an array of matches exactly
+     * as without the trie. */
+    {
+        ib_ip4_network_t net = {ip, 32};
+        const ib_ipset4_entry_t *last =
+            set->positive + set->num_positive - 1;
+        while (
+            specific < last &&
+            ib_ipset4_compare(&specific[1].network, &net) == 0
+        )
+        {
+            ++specific;
+        }
+        general = specific;
+        while (
+            general > set->positive &&
+            ib_ipset4_compare(&general[-1].network, &net) == 0
+        )
+        {
+            --general;
+        }
+    }
+
+    if (out_entry != NULL) {
+        *out_entry = specific;
+    }
+    if (out_specific_entry != NULL) {
+        *out_specific_entry = specific;
+    }
+    if (out_general_entry != NULL) {
+        *out_general_entry = general;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Query the trie indexes of @a set for @a ip. (v6 version)
+ *
+ * @sa ib_ipset4_query_trie()
+ *
+ * @param[in]  set                IP set to query.
+ * @param[in]  ip                 IP to query.
+ * @param[out] out_entry          See ib_ipset6_query().
+ * @param[out] out_specific_entry See ib_ipset6_query().
+ * @param[out] out_general_entry  See ib_ipset6_query().
+ *
+ * @return
+ * - IB_OK if @a ip is in @a set.
+ * - IB_ENOENT if @a ip is not in @a set.
+ */
+static
+ib_status_t ib_ipset6_query_trie(
+    const ib_ipset6_t        *set,
+    const ib_ip6_t           *ip,
+    const ib_ipset6_entry_t **out_entry,
+    const ib_ipset6_entry_t **out_specific_entry,
+    const ib_ipset6_entry_t **out_general_entry
+)
+{
+    const ib_ipset6_entry_t *general  = NULL;
+    const ib_ipset6_entry_t *specific = NULL;
+
+    if (out_entry != NULL) {
+        *out_entry = NULL;
+    }
+    if (out_specific_entry != NULL) {
+        *out_specific_entry = NULL;
+    }
+    if (out_general_entry != NULL) {
+        *out_general_entry = NULL;
+    }
+
+    ib_ipset6_trie_find(set->negative_trie, ip, &general, &specific);
+    if (specific != NULL) {
+        return IB_ENOENT;
+    }
+
+    general  = NULL;
+    specific = NULL;
+    ib_ipset6_trie_find(set->positive_trie, ip, &general, &specific);
+    if (specific == NULL) {
+        return IB_ENOENT;
+    }
+
+    /* Reproduce the array path's outputs: extend from the most specific
+     * entry to the contiguous run of matching entries around it, so
+     * [general, specific] can be treated as an array of matches exactly
+     * as without the trie. */
+    {
+        ib_ip6_network_t net = {*ip, 128};
+        const ib_ipset6_entry_t *last =
+            set->positive + set->num_positive - 1;
+        while (
+            specific < last &&
+            ib_ipset6_compare(&specific[1].network, &net) == 0
+        )
+        {
+            ++specific;
+        }
+        general = specific;
+        while (
+            general > set->positive &&
+            ib_ipset6_compare(&general[-1].network, &net) == 0
+        )
+        {
+            --general;
+        }
+    }
+
+    if (out_entry != NULL) {
+        *out_entry = specific;
+    }
+    if (out_specific_entry != NULL) {
+        *out_specific_entry = specific;
+    }
+    if (out_general_entry != NULL) {
+        *out_general_entry = general;
+    }
+
+    return IB_OK;
+}
+
 /* Public API */
 
 ib_status_t ib_ipset4_query(
@@ -511,6 +1217,16 @@ ib_status_t ib_ipset4_query(
         return IB_EINVAL;
     }
 
+    if (set->negative_trie != NULL || set->positive_trie != NULL) {
+        return ib_ipset4_query_trie(
+            set,
+            ip,
+            out_entry,
+            out_specific_entry,
+            out_general_entry
+        );
+    }
+
     return ib_ipset_query(
         &net,
         set->negative,
@@ -539,6 +1255,16 @@ ib_status_t ib_ipset6_query(
         return IB_EINVAL;
     }
 
+    if (set->negative_trie != NULL || set->positive_trie != NULL) {
+        return ib_ipset6_query_trie(
+            set,
+            &ip,
+            out_entry,
+            out_specific_entry,
+            out_general_entry
+        );
+    }
+
     return ib_ipset_query(
         &net,
         set->negative,
@@ -569,10 +1295,12 @@ ib_status_t ib_ipset4_init(
         return IB_EINVAL;
     }
 
-    set->negative     = negative;
-    set->num_negative = num_negative;
-    set->positive     = positive;
-    set->num_positive = num_positive;
+    set->negative      = negative;
+    set->num_negative  = num_negative;
+    set->positive      = positive;
+    set->num_positive  = num_positive;
+    set->negative_trie = NULL;
+    set->positive_trie = NULL;
 
     for (size_t i = 0; i < set->num_negative; ++i) {
         set->negative[i].network.ip =
@@ -600,6 +1328,49 @@ ib_status_t ib_ipset4_init(
     return IB_OK;
 }
 
+ib_status_t ib_ipset4_init_ex(
+    ib_ipset4_t       *set,
+    ib_ipset4_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset4_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm,
+    ib_flags_t         flags
+)
+{
+    ib_status_t rc = ib_ipset4_init(
+        set,
+        negative, num_negative,
+        positive, num_positive
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (flags & IB_IPSET_TRIE) {
+        rc = ib_ipset4_trie_build(
+            mm,
+            set->negative, set->num_negative,
+            true,
+            &set->negative_trie
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_ipset4_trie_build(
+            mm,
+            set->positive, set->num_positive,
+            false,
+            &set->positive_trie
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
 ib_status_t ib_ipset6_init(
     ib_ipset6_t       *set,
     ib_ipset6_entry_t *negative,
@@ -616,10 +1387,12 @@ ib_status_t ib_ipset6_init(
         return IB_EINVAL;
     }
 
-    set->negative     = negative;
-    set->num_negative = num_negative;
-    set->positive     = positive;
-    set->num_positive = num_positive;
+    set->negative      = negative;
+    set->num_negative  = num_negative;
+    set->positive      = positive;
+    set->num_positive  = num_positive;
+    set->negative_trie = NULL;
+    set->positive_trie = NULL;
 
     for (size_t i = 0; i < set->num_negative; ++i) {
         set->negative[i].network.ip =
@@ -646,3 +1419,46 @@ ib_status_t ib_ipset6_init(
 
     return IB_OK;
 }
+
+ib_status_t ib_ipset6_init_ex(
+    ib_ipset6_t       *set,
+    ib_ipset6_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset6_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm,
+    ib_flags_t         flags
+)
+{
+    ib_status_t rc = ib_ipset6_init(
+        set,
+        negative, num_negative,
+        positive, num_positive
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (flags & IB_IPSET_TRIE) {
+        rc = ib_ipset6_trie_build(
+            mm,
+            set->negative, set->num_negative,
+            true,
+            &set->negative_trie
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_ipset6_trie_build(
+            mm,
+            set->positive, set->num_positive,
+            false,
+            &set->positive_trie
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
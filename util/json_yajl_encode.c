@@ -48,6 +48,149 @@
 
 static const size_t float_buf_size = 64;
 
+/**
+ * Scratch buffer size for json_gen_string().
+ *
+ * Strings whose escaped, quoted form fits in this many bytes are
+ * appended to the generator in a single raw write. Longer strings fall
+ * back to yajl_gen_string().
+ */
+#define JSON_ESCAPE_BUF_SIZE 2048
+
+/**
+ * Does the byte @a c need escaping inside a JSON string?
+ *
+ * yajl escapes control characters, double quotes and backslashes;
+ * everything else passes through unmodified.
+ *
+ * @param[in] c Byte to test.
+ *
+ * @returns True if @a c needs escaping.
+ */
+static bool json_escape_needed_char(unsigned char c)
+{
+    return (c < 0x20) || (c == '"') || (c == '\\');
+}
+
+/**
+ * Does any byte in @a word need escaping inside a JSON string?
+ *
+ * This tests all eight bytes of @a word at once using portable
+ * word-at-a-time bit tricks: a byte-wise "has zero" test applied to
+ * copies of @a word xor-ed with the quote and backslash bytes, and a
+ * byte-wise "less than 0x20" test for control characters.
+ *
+ * @param[in] word Eight bytes of string data.
+ *
+ * @returns Nonzero if some byte needs escaping.
+ */
+static uint64_t json_escape_needed_word(uint64_t word)
+{
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t high = UINT64_C(0x8080808080808080);
+    uint64_t quote  = word ^ (ones * '"');
+    uint64_t bslash = word ^ (ones * '\\');
+    uint64_t ctrl;
+
+    ctrl   = (word - (ones * 0x20)) & ~word & high;
+    quote  = (quote - ones) & ~quote & high;
+    bslash = (bslash - ones) & ~bslash & high;
+
+    return ctrl | quote | bslash;
+}
+
+/**
+ * Append the string @a str to @a handle as an escaped JSON string.
+ *
+ * This scans @a str a word at a time, memcpy()s the runs that need no
+ * escaping and expands only the characters that do, then hands the
+ * quoted result to the generator in one raw write. A clean string --
+ * the common case for field names and most values -- reduces to a pair
+ * of quotes and a single memcpy().
+ *
+ * yajl requires map keys to pass through its own encoder, and escaped
+ * forms longer than the scratch buffer are not worth staging; both
+ * cases fall back to yajl_gen_string(), which escapes byte by byte.
+ *
+ * @param[in,out] handle YAJL generator handle
+ * @param[in] str String to append.
+ * @param[in] len Length of @a str.
+ *
+ * @returns YAJL generator status.
+ */
+static yajl_gen_status json_gen_string(
+    yajl_gen             handle,
+    const unsigned char *str,
+    size_t               len
+)
+{
+    yajl_gen_status status;
+    char            buf[JSON_ESCAPE_BUF_SIZE];
+    char           *out = buf;
+    /* Leave room for a worst-case escape and the closing quote. */
+    const char     *end = buf + sizeof(buf) - 8;
+    size_t          i = 0;
+
+    *out++ = '"';
+
+    while (i < len) {
+        size_t        run = i;
+        unsigned char c;
+
+        /* Find the next character needing an escape. Whole words are
+         * rejected at once; the byte loop finishes the word that
+         * stopped the scan and the unaligned tail. */
+        while (i + sizeof(uint64_t) <= len) {
+            uint64_t word;
+            memcpy(&word, str + i, sizeof(word));
+            if (json_escape_needed_word(word) != 0) {
+                break;
+            }
+            i += sizeof(word);
+        }
+        while ( (i < len) && !json_escape_needed_char(str[i]) ) {
+            ++i;
+        }
+
+        /* Copy the clean run. */
+        if (out + (i - run) > end) {
+            return yajl_gen_string(handle, str, len);
+        }
+        memcpy(out, str + run, i - run);
+        out += i - run;
+
+        if (i >= len) {
+            break;
+        }
+
+        /* Expand the escape. */
+        c = str[i];
+        ++i;
+        switch (c) {
+        case '"':  *out++ = '\\'; *out++ = '"';  break;
+        case '\\': *out++ = '\\'; *out++ = '\\'; break;
+        case '\b': *out++ = '\\'; *out++ = 'b';  break;
+        case '\f': *out++ = '\\'; *out++ = 'f';  break;
+        case '\n': *out++ = '\\'; *out++ = 'n';  break;
+        case '\r': *out++ = '\\'; *out++ = 'r';  break;
+        case '\t': *out++ = '\\'; *out++ = 't';  break;
+        default:
+            out += snprintf(out, 7, "\\u%04x", c);
+        }
+    }
+
+    *out++ = '"';
+
+    /* Raw append. The generator treats the buffer as a complete,
+     * pre-formatted value and inserts separators as for any value. */
+    status = yajl_gen_number(handle, buf, out - buf);
+    if (status == yajl_gen_keys_must_be_strings) {
+        /* Map keys must be built by yajl itself. */
+        status = yajl_gen_string(handle, str, len);
+    }
+    return status;
+}
+
 /**
  * JSON YAJL encode: Encode a list
  *
@@ -159,7 +302,7 @@ static ib_status_t encode_field(
             rc = tmprc;
         }
         else if (str != NULL) {
-            status = yajl_gen_string(handle,
+            status = json_gen_string(handle,
                                      (unsigned char *)str,
                                      strlen(str));
             if (status != yajl_gen_status_ok) {
@@ -179,7 +322,7 @@ static ib_status_t encode_field(
             rc = tmprc;
         }
         else if (bs != NULL) {
-            status = yajl_gen_string(handle,
+            status = json_gen_string(handle,
                                      ib_bytestr_const_ptr(bs),
                                      ib_bytestr_length(bs));
             if (status != yajl_gen_status_ok) {
@@ -121,6 +121,10 @@ ib_status_t ib_kvstore_init(ib_kvstore_t *kvstore)
 {
     assert(kvstore != NULL);
 
+    /* Zero first so optional methods, such as mget and mset, are
+     * NULL unless the implementation provides them. */
+    memset(kvstore, 0, sizeof(*kvstore));
+
     kvstore->malloc = &kvstore_malloc;
     kvstore->free = &kvstore_free;
     kvstore->default_merge_policy = &default_merge_policy;
@@ -238,6 +242,153 @@ ib_status_t ib_kvstore_set(
     return rc;
 }
 
+ib_status_t ib_kvstore_mget(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    ib_mm_t                        mm,
+    const ib_kvstore_key_t *const *keys,
+    size_t                         count,
+    ib_kvstore_value_t           **vals
+)
+{
+    assert(kvstore != NULL);
+    assert(keys != NULL);
+    assert(vals != NULL);
+
+    ib_status_t      rc;
+    ib_mm_t          mm_tmp;
+    ib_mpool_lite_t *mp_tmp;
+
+    ib_kvstore_value_t ***values;
+    size_t               *values_lengths;
+
+    if (count == 0) {
+        return IB_OK;
+    }
+
+    if ( merge_policy == NULL ) {
+        merge_policy = kvstore->default_merge_policy;
+    }
+
+    /* Without a batching implementation, do the gets one by one. */
+    if (kvstore->mget == NULL) {
+        for (size_t i = 0; i < count; ++i) {
+            rc = ib_kvstore_get(kvstore, merge_policy, mm, keys[i], &vals[i]);
+            if (rc == IB_ENOENT) {
+                vals[i] = NULL;
+            }
+            else if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        return IB_OK;
+    }
+
+    rc = ib_mpool_lite_create(&mp_tmp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm_tmp = ib_mm_mpool_lite(mp_tmp);
+
+    values = ib_mm_calloc(mm_tmp, count, sizeof(*values));
+    values_lengths = ib_mm_calloc(mm_tmp, count, sizeof(*values_lengths));
+    if (values == NULL || values_lengths == NULL) {
+        rc = IB_EALLOC;
+        goto exit_mget;
+    }
+
+    rc = kvstore->mget(
+        kvstore,
+        mm_tmp,
+        keys,
+        count,
+        values,
+        values_lengths,
+        kvstore->mget_cbdata);
+    if (rc != IB_OK) {
+        goto exit_mget;
+    }
+
+    /* Merge and copy out each key's values, as ib_kvstore_get does. */
+    for (size_t i = 0; i < count; ++i) {
+        if (values_lengths[i] > 1) {
+            ib_kvstore_value_t *merged_value = NULL;
+
+            rc = merge_policy(
+                kvstore,
+                keys[i],
+                values[i],
+                values_lengths[i],
+                &merged_value,
+                kvstore->merge_policy_cbdata);
+            if (rc != IB_OK) {
+                goto exit_mget;
+            }
+
+            rc = ib_kvstore_value_dup(mm, merged_value, &vals[i]);
+        }
+        else if (values_lengths[i] == 1) {
+            rc = ib_kvstore_value_dup(mm, values[i][0], &vals[i]);
+        }
+        else {
+            vals[i] = NULL;
+        }
+        if (rc != IB_OK) {
+            goto exit_mget;
+        }
+    }
+
+exit_mget:
+
+    ib_mpool_lite_destroy(mp_tmp);
+
+    return rc;
+}
+
+ib_status_t ib_kvstore_mset(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    const ib_kvstore_key_t *const *keys,
+    ib_kvstore_value_t *const     *vals,
+    size_t                         count
+)
+{
+    assert(kvstore != NULL);
+    assert(keys != NULL);
+    assert(vals != NULL);
+
+    ib_status_t rc;
+
+    if (count == 0) {
+        return IB_OK;
+    }
+
+    if ( merge_policy == NULL ) {
+        merge_policy = kvstore->default_merge_policy;
+    }
+
+    /* Without a batching implementation, do the sets one by one. */
+    if (kvstore->mset == NULL) {
+        for (size_t i = 0; i < count; ++i) {
+            rc = ib_kvstore_set(kvstore, merge_policy, keys[i], vals[i]);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        return IB_OK;
+    }
+
+    rc = kvstore->mset(
+        kvstore,
+        merge_policy,
+        keys,
+        vals,
+        count,
+        kvstore->mset_cbdata);
+
+    return rc;
+}
+
 ib_status_t ib_kvstore_remove(
     ib_kvstore_t *kvstore,
     const ib_kvstore_key_t *key)
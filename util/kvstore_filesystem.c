@@ -30,7 +30,6 @@
 #include "kvstore_private.h"
 
 #include <ironbee/clock.h>
-#include <ironbee/file.h>
 #include <ironbee/kvstore.h>
 #include <ironbee/path.h>
 #include <ironbee/util.h>
@@ -41,12 +40,15 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <strings.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 /**
@@ -241,6 +243,8 @@ static ib_status_t build_key_path(
     path_size =
         server->directory_length /* length of path */
         + 1                      /* path separator */
+        + server->fanout         /* shard directory. */
+        + 1                      /* path separator */
         + UUID_LEN_STR           /* key length */
         + 1                      /* path separator */
         + prefix_len             /* Prefix length */
@@ -265,6 +269,13 @@ static ib_status_t build_key_path(
     path_tmp = (strncpy(path_tmp, server->directory, server->directory_length)
                 + server->directory_length);
 
+    /* Append the shard directory, a prefix of the key hash. */
+    if (server->fanout > 0) {
+        path_tmp = strncpy(path_tmp, "/", 1) + 1;
+        path_tmp = strncpy(path_tmp, key_uuid_str, server->fanout)
+                   + server->fanout;
+    }
+
     /* Append the key. */
     path_tmp = strncpy(path_tmp, "/", 1) + 1;
     path_tmp = strncpy(path_tmp, key_uuid_str, UUID_LEN_STR) + UUID_LEN_STR;
@@ -590,13 +601,19 @@ static ib_status_t load_kv_value(
 
     /* Remove expired file and signal there is no entry for that file. */
     if (now > expiration) {
-
-        /* Remove the expired file. */
-        unlink(file_path);
-
-        /* Try to remove the key directory, though it may not be empty.
-         * Failure is OK. */
-        rmdir(dpath);
+        ib_kvstore_filesystem_server_t *server =
+            (ib_kvstore_filesystem_server_t *)(kvstore->server);
+
+        /* If a sweeper thread is running, leave removal to it and keep
+         * deletion system calls off the read path. */
+        if (!server->sweeper_running) {
+            /* Remove the expired file. */
+            unlink(file_path);
+
+            /* Try to remove the key directory, though it may not be empty.
+             * Failure is OK. */
+            rmdir(dpath);
+        }
 
         return IB_DECLINED;
     }
@@ -625,18 +642,45 @@ static ib_status_t load_kv_value(
         ib_kvstore_value_type_set(value, type, type_length);
     }
 
-    /* Populate value and value_length. */
+    /* Populate value and value_length.
+     * The file is mapped rather than read so the contents are copied
+     * from the page cache into the value in one pass, with no
+     * intermediate read buffer. */
     {
-        uint8_t *data;
-        size_t   data_length;
-        rc = ib_file_readall(
-            mm,
-            file_path,
-            (const uint8_t**)&data,
-            &data_length);
-        if (rc != IB_OK) {
+        uint8_t     *data;
+        size_t       data_length;
+        int          fd;
+        struct stat  sb;
+
+        fd = open(file_path, O_RDONLY);
+        if (fd < 0) {
             return IB_EOTHER;
         }
+
+        if (fstat(fd, &sb) != 0) {
+            close(fd);
+            return IB_EOTHER;
+        }
+        data_length = sb.st_size;
+
+        data = ib_mm_alloc(mm, data_length);
+        if (data == NULL) {
+            close(fd);
+            return IB_EALLOC;
+        }
+
+        /* Zero-length files (e.g. kvset() place holders) map to nothing. */
+        if (data_length > 0) {
+            void *map = mmap(NULL, data_length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                close(fd);
+                return IB_EOTHER;
+            }
+            memcpy(data, map, data_length);
+            munmap(map, data_length);
+        }
+
+        close(fd);
         ib_kvstore_value_value_set(value, data, data_length);
     }
 
@@ -984,6 +1028,101 @@ static ib_status_t create_tmp_kv_file(
     return IB_OK;
 }
 
+#ifdef O_TMPFILE
+/**
+ * Write @a value through an unnamed file and link it into place.
+ *
+ * The data is written to an @c O_TMPFILE file, which has no name until
+ * it is complete, and is then linked over the place holder created by
+ * create_empty_kv_file().  Compared to the mkstemp() path this never
+ * exposes a partially written file, creates one file instead of two,
+ * and leaves no stray temporary file behind if the process dies
+ * mid-write.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] key The key being written.
+ * @param[in] value The value to write.
+ * @param[in] server The filesystem server object.
+ * @param[in] mm Temporary allocations are made from this.
+ * @param[in] path_real The place holder path reserved by
+ *            create_empty_kv_file().
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_ENOTIMPL if the kernel or filesystem does not support
+ *     @c O_TMPFILE. The caller should fall back to mkstemp().
+ *   - IB_EOTHER on other system call failure.
+ *   - IB_EALLOC if a memory allocation fails.
+ */
+static ib_status_t write_kv_tmpfile(
+    ib_kvstore_t                   *kvstore,
+    const ib_kvstore_key_t         *key,
+    ib_kvstore_value_t             *value,
+    ib_kvstore_filesystem_server_t *server,
+    ib_mm_t                         mm,
+    const char                     *path_real
+)
+{
+    assert(kvstore != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+    assert(server != NULL);
+    assert(path_real != NULL);
+
+    ib_status_t    rc;
+    int            fd;
+    ssize_t        written;
+    char          *dir_path = NULL;
+    const uint8_t *data;
+    size_t         data_length;
+    char           proc_path[64];
+
+    /* Build the key directory path; the unnamed file lives there. */
+    rc = build_key_path(kvstore, key, 0, NULL, 0, NULL, NULL, mm, &dir_path);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    fd = open(dir_path, O_TMPFILE | O_WRONLY, server->fmode);
+    if (fd < 0) {
+        /* Old kernels and some filesystems reject O_TMPFILE. */
+        if (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL) {
+            return IB_ENOTIMPL;
+        }
+        return IB_EOTHER;
+    }
+
+    ib_kvstore_value_value_get(value, &data, &data_length);
+
+    written = write(fd, data, data_length);
+    if (written < (ssize_t)data_length) {
+        close(fd);
+        return IB_EOTHER;
+    }
+
+    if (fchmod(fd, server->fmode) != 0) {
+        close(fd);
+        return IB_EOTHER;
+    }
+
+    /* Give the finished file the place holder's name. The place holder
+     * name is unique (mkstemp()), so no other writer can take it while
+     * it is briefly unlinked. */
+    snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+    unlink(path_real);
+    if (linkat(AT_FDCWD, proc_path, AT_FDCWD, path_real, AT_SYMLINK_FOLLOW)
+        != 0)
+    {
+        close(fd);
+        return IB_EOTHER;
+    }
+
+    close(fd);
+
+    return IB_OK;
+}
+#endif /* O_TMPFILE */
+
 /**
  * Set callback.
  *
@@ -1058,6 +1197,15 @@ static ib_status_t kvset(
         goto cleanup;
     }
 
+#ifdef O_TMPFILE
+    /* Prefer an unnamed temporary file where supported; fall through to
+     * the mkstemp() scheme only if the filesystem declines. */
+    rc = write_kv_tmpfile(kvstore, key, value, server, mm, path_real);
+    if (rc != IB_ENOTIMPL) {
+        goto cleanup;
+    }
+#endif
+
     rc = create_tmp_kv_file(
         kvstore,
         key,
@@ -1106,6 +1254,224 @@ cleanup:
     return rc;
 }
 
+/**
+ * Callback user data for the sweeper directory walk.
+ */
+struct sweep_t {
+    ib_kvstore_t *kvstore; /**< Key-value store being swept. */
+    ib_time_t     now;     /**< Time the sweep started. */
+};
+typedef struct sweep_t sweep_t;
+
+/**
+ * Unlink @a file under @a path if its name says it has expired.
+ *
+ * Unlike the read path, this also removes expired temporary files
+ * (leading '.'), reclaiming files orphaned by writers that died
+ * mid-commit.
+ *
+ * @param[in] path The key directory path.
+ * @param[in] file The file name to examine.
+ * @param[in,out] data A @ref sweep_t pointer.
+ *
+ * @returns
+ *   - IB_OK on success, including files that are kept or unparsable.
+ *   - IB_EALLOC if a memory allocation fails.
+ */
+static ib_status_t sweep_file(const char *path, const char *file, void *data)
+{
+    assert(path != NULL);
+    assert(file != NULL);
+    assert(data != NULL);
+
+    sweep_t     *sweep = (sweep_t *)data;
+    ib_time_t    expiration;
+    ib_time_t    creation;
+    char        *full_path;
+    ib_status_t  rc;
+
+    if ( (*file == '.') && (strlen(file) <= 2) ) {
+        return IB_OK;
+    }
+
+    /* Leave files with unparsable names alone. */
+    rc = extract_time_info(sweep->kvstore, file, &expiration, &creation);
+    if (rc != IB_OK) {
+        return IB_OK;
+    }
+
+    if (sweep->now <= expiration) {
+        return IB_OK;
+    }
+
+    full_path = malloc(strlen(path) + strlen(file) + 2);
+    if (full_path == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(full_path, "%s/%s", path, file);
+
+    unlink(full_path);
+
+    free(full_path);
+
+    return IB_OK;
+}
+
+/**
+ * Sweep one key directory and remove it if it ends up empty.
+ *
+ * @param[in] path The parent directory path.
+ * @param[in] dirent The key directory name.
+ * @param[in,out] data A @ref sweep_t pointer.
+ *
+ * @returns IB_OK. Directories that vanish mid-sweep are not an error.
+ */
+static ib_status_t sweep_key_dir(
+    const char *path,
+    const char *dirent,
+    void *data)
+{
+    assert(path != NULL);
+    assert(dirent != NULL);
+    assert(data != NULL);
+
+    char *dir_path;
+
+    if ( (*dirent == '.') && (strlen(dirent) <= 2) ) {
+        return IB_OK;
+    }
+
+    dir_path = malloc(strlen(path) + strlen(dirent) + 2);
+    if (dir_path == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(dir_path, "%s/%s", path, dirent);
+
+    /* Ignore walk errors; a concurrent kvremove() may have taken the
+     * directory away, and anything missed is retried next interval. */
+    each_dir(dir_path, sweep_file, data);
+
+    /* Attempt to remove the key directory, though it may not be empty.
+     * Failure is OK. */
+    rmdir(dir_path);
+
+    free(dir_path);
+
+    return IB_OK;
+}
+
+/**
+ * Sweep one shard directory by sweeping each key directory in it.
+ *
+ * Used only when a directory fanout is configured.
+ *
+ * @param[in] path The base directory path.
+ * @param[in] dirent The shard directory name.
+ * @param[in,out] data A @ref sweep_t pointer.
+ *
+ * @returns IB_OK.
+ */
+static ib_status_t sweep_shard_dir(
+    const char *path,
+    const char *dirent,
+    void *data)
+{
+    assert(path != NULL);
+    assert(dirent != NULL);
+    assert(data != NULL);
+
+    char *dir_path;
+
+    if ( (*dirent == '.') && (strlen(dirent) <= 2) ) {
+        return IB_OK;
+    }
+
+    dir_path = malloc(strlen(path) + strlen(dirent) + 2);
+    if (dir_path == NULL) {
+        return IB_EALLOC;
+    }
+    sprintf(dir_path, "%s/%s", path, dirent);
+
+    each_dir(dir_path, sweep_key_dir, data);
+
+    /* Empty shards may be removed; build_key_path() recreates them. */
+    rmdir(dir_path);
+
+    free(dir_path);
+
+    return IB_OK;
+}
+
+/**
+ * Walk the whole store once, removing expired entries.
+ *
+ * @param[in] kvstore Key-value store to sweep.
+ */
+static void sweep_expired(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_filesystem_server_t *server =
+        (ib_kvstore_filesystem_server_t *)(kvstore->server);
+    ib_timeval_t tv;
+    sweep_t      sweep;
+
+    ib_clock_gettimeofday(&tv);
+    sweep.kvstore = kvstore;
+    sweep.now     = IB_CLOCK_TIMEVAL_TIME(tv);
+
+    each_dir(
+        server->directory,
+        (server->fanout > 0) ? sweep_shard_dir : sweep_key_dir,
+        &sweep);
+}
+
+/**
+ * Main function of the expiration sweeper thread.
+ *
+ * Sweeps the store, then waits on the sweeper condition variable for
+ * the configured interval (or until woken for shutdown), until asked
+ * to stop.
+ *
+ * @param[in] arg The @ref ib_kvstore_t being swept.
+ *
+ * @returns NULL.
+ */
+static void *sweeper_main(void *arg)
+{
+    assert(arg != NULL);
+
+    ib_kvstore_t *kvstore = (ib_kvstore_t *)arg;
+    ib_kvstore_filesystem_server_t *server =
+        (ib_kvstore_filesystem_server_t *)(kvstore->server);
+
+    pthread_mutex_lock(&server->sweeper_lock);
+    while (!server->sweeper_stop) {
+        ib_timeval_t    tv;
+        struct timespec deadline;
+
+        pthread_mutex_unlock(&server->sweeper_lock);
+
+        sweep_expired(kvstore);
+
+        ib_clock_gettimeofday(&tv);
+        deadline.tv_sec  = tv.tv_sec + IB_CLOCK_SECS(server->sweeper_interval);
+        deadline.tv_nsec = (long)tv.tv_usec * 1000;
+
+        pthread_mutex_lock(&server->sweeper_lock);
+        if (!server->sweeper_stop) {
+            pthread_cond_timedwait(
+                &server->sweeper_cond,
+                &server->sweeper_lock,
+                &deadline);
+        }
+    }
+    pthread_mutex_unlock(&server->sweeper_lock);
+
+    return NULL;
+}
+
 /**
  * Remove all entries from key directory.
  *
@@ -1213,6 +1579,19 @@ static void kvdestroy(ib_kvstore_t* kvstore, ib_kvstore_cbdata_t *cbdata)
 
     ib_kvstore_filesystem_server_t *server =
         (ib_kvstore_filesystem_server_t *)(kvstore->server);
+
+    /* Stop and join the sweeper thread, if one was started. */
+    if (server->sweeper_running) {
+        pthread_mutex_lock(&server->sweeper_lock);
+        server->sweeper_stop = true;
+        pthread_cond_signal(&server->sweeper_cond);
+        pthread_mutex_unlock(&server->sweeper_lock);
+        pthread_join(server->sweeper, NULL);
+        server->sweeper_running = false;
+    }
+    pthread_cond_destroy(&server->sweeper_cond);
+    pthread_mutex_destroy(&server->sweeper_lock);
+
     free((void *)server->directory);
     free(server);
     kvstore->server = NULL;
@@ -1240,12 +1619,29 @@ ib_status_t ib_kvstore_filesystem_init(
     server->directory_length = strlen(directory);
     server->fmode = DEFAULT_FILE_MODE;
     server->dmode = DEFAULT_DIRECTORY_MODE;
+    server->fanout = 0;
+    server->sweeper_running = false;
+    server->sweeper_stop = false;
+    server->sweeper_interval = 0;
 
     if ( server->directory == NULL ) {
         free(server);
         return IB_EALLOC;
     }
 
+    if (pthread_mutex_init(&server->sweeper_lock, NULL) != 0) {
+        free((void *)server->directory);
+        free(server);
+        return IB_EOTHER;
+    }
+
+    if (pthread_cond_init(&server->sweeper_cond, NULL) != 0) {
+        pthread_mutex_destroy(&server->sweeper_lock);
+        free((void *)server->directory);
+        free(server);
+        return IB_EOTHER;
+    }
+
     kvstore->server = (ib_kvstore_server_t *)server;
     kvstore->get = kvget;
     kvstore->set = kvset;
@@ -1288,3 +1684,44 @@ void ib_kvstore_filesystem_set_file_mode(ib_kvstore_t *kvstore, mode_t mode)
         (ib_kvstore_filesystem_server_t *)(kvstore->server);
     server->fmode = mode;
 }
+
+void ib_kvstore_filesystem_set_fanout(ib_kvstore_t *kvstore, size_t fanout)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    ib_kvstore_filesystem_server_t *server =
+        (ib_kvstore_filesystem_server_t *)(kvstore->server);
+
+    /* The first hyphen in the key hash string is at offset 8. */
+    if (fanout > 8) {
+        fanout = 8;
+    }
+    server->fanout = fanout;
+}
+
+ib_status_t ib_kvstore_filesystem_sweeper_start(
+    ib_kvstore_t *kvstore,
+    uint32_t interval_seconds)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_filesystem_server_t *server =
+        (ib_kvstore_filesystem_server_t *)(kvstore->server);
+    int sys_rc;
+
+    if (interval_seconds == 0 || server->sweeper_running) {
+        return IB_EINVAL;
+    }
+
+    server->sweeper_stop = false;
+    server->sweeper_interval = (ib_time_t)interval_seconds * 1000000;
+
+    sys_rc = pthread_create(&server->sweeper, NULL, sweeper_main, kvstore);
+    if (sys_rc != 0) {
+        return IB_EOTHER;
+    }
+    server->sweeper_running = true;
+
+    return IB_OK;
+}
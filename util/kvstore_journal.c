@@ -0,0 +1,725 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Crash-consistent journal decorating a kvstore.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_journal.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** Magic number opening every journal record. */
+static const uint32_t RECORD_MAGIC = 0x4a524e31; /* "JRN1" */
+
+/** Magic number closing every record; absence marks a torn write. */
+static const uint32_t RECORD_COMMIT = 0x434f4d54; /* "COMT" */
+
+/** Record operations. */
+enum {
+    RECORD_OP_SET    = 1,
+    RECORD_OP_REMOVE = 2
+};
+
+/** Default segment rotation threshold. */
+static const size_t DEFAULT_SEGMENT_SIZE = 16 * 1024 * 1024;
+
+/** Prefix of segment file names, followed by the sequence number. */
+#define SEGMENT_PREFIX "journal-"
+
+/** Suffix of segment file names. */
+#define SEGMENT_SUFFIX ".log"
+
+/**
+ * Fixed-width portion of a record, written before the variable bytes.
+ *
+ * Records are read and written on the same host, so fields are stored
+ * in host order.
+ */
+struct record_header_t {
+    uint32_t magic;      /**< RECORD_MAGIC. */
+    uint8_t  op;         /**< RECORD_OP_SET or RECORD_OP_REMOVE. */
+    uint64_t expiration; /**< Value expiration. 0 for removes. */
+    uint64_t creation;   /**< Value creation. 0 for removes. */
+    uint32_t key_length; /**< Length of the key bytes. */
+    uint32_t type_length;/**< Length of the type bytes. 0 for removes. */
+    uint32_t value_length; /**< Length of the value bytes. 0 for removes. */
+};
+typedef struct record_header_t record_header_t;
+
+/**
+ * Build the path of segment @a seq into a malloc'ed string.
+ *
+ * @param[in] server The journal server.
+ * @param[in] seq The segment sequence number.
+ *
+ * @returns The path or NULL on allocation failure. Caller frees.
+ */
+static char *segment_path(ib_kvstore_journal_server_t *server, uint64_t seq)
+{
+    size_t len = strlen(server->directory)
+               + sizeof(SEGMENT_PREFIX) + sizeof(SEGMENT_SUFFIX) + 32;
+    char *path = malloc(len);
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    snprintf(
+        path,
+        len,
+        "%s/" SEGMENT_PREFIX "%020" PRIu64 SEGMENT_SUFFIX,
+        server->directory,
+        seq);
+
+    return path;
+}
+
+/**
+ * Open segment @a seq for appending, creating it.
+ *
+ * The server's fd, seq and segment_bytes are updated.
+ *
+ * @param[in] server The journal server.
+ * @param[in] seq The segment sequence number.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on system call failure.
+ */
+static ib_status_t segment_open(
+    ib_kvstore_journal_server_t *server,
+    uint64_t seq
+)
+{
+    char *path = segment_path(server, seq);
+
+    if (path == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    free(path);
+    if (server->fd < 0) {
+        return IB_EOTHER;
+    }
+
+    server->seq = seq;
+    server->segment_bytes = 0;
+
+    return IB_OK;
+}
+
+/**
+ * Close the current segment, fsyncing it first.
+ *
+ * @param[in] server The journal server.
+ */
+static void segment_close(ib_kvstore_journal_server_t *server)
+{
+    if (server->fd >= 0) {
+        fsync(server->fd);
+        close(server->fd);
+        server->fd = -1;
+    }
+}
+
+/**
+ * Append one record for @a key (and @a value, for sets).
+ *
+ * The record is assembled into one buffer and issued as a single
+ * write() so concurrent appenders cannot interleave, then the segment
+ * is fsynced if the group-commit interval has passed. The segment is
+ * rotated first when it has grown past the threshold.
+ *
+ * @param[in] server The journal server.
+ * @param[in] op RECORD_OP_SET or RECORD_OP_REMOVE.
+ * @param[in] key The key.
+ * @param[in] value The value for sets, NULL for removes.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on system call failure.
+ */
+static ib_status_t journal_append(
+    ib_kvstore_journal_server_t *server,
+    uint8_t                      op,
+    const ib_kvstore_key_t      *key,
+    ib_kvstore_value_t          *value
+)
+{
+    assert(server != NULL);
+    assert(key != NULL);
+
+    record_header_t  header;
+    const uint8_t   *key_data;
+    size_t           key_length;
+    const char      *type = NULL;
+    size_t           type_length = 0;
+    const uint8_t   *value_data = NULL;
+    size_t           value_length = 0;
+    uint8_t         *record;
+    uint8_t         *at;
+    size_t           record_length;
+    ssize_t          written;
+    ib_timeval_t     tv;
+    ib_time_t        now;
+    ib_status_t      rc = IB_OK;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    if (value != NULL) {
+        ib_kvstore_value_type_get(value, &type, &type_length);
+        ib_kvstore_value_value_get(value, &value_data, &value_length);
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic        = RECORD_MAGIC;
+    header.op           = op;
+    header.key_length   = (uint32_t)key_length;
+    header.type_length  = (uint32_t)type_length;
+    header.value_length = (uint32_t)value_length;
+    if (value != NULL) {
+        header.expiration = ib_kvstore_value_expiration_get(value);
+        header.creation   = ib_kvstore_value_creation_get(value);
+    }
+
+    record_length = sizeof(header)
+                  + key_length + type_length + value_length
+                  + sizeof(RECORD_COMMIT);
+    record = malloc(record_length);
+    if (record == NULL) {
+        return IB_EALLOC;
+    }
+
+    at = record;
+    memcpy(at, &header, sizeof(header));
+    at += sizeof(header);
+    memcpy(at, key_data, key_length);
+    at += key_length;
+    memcpy(at, type, type_length);
+    at += type_length;
+    memcpy(at, value_data, value_length);
+    at += value_length;
+    memcpy(at, &RECORD_COMMIT, sizeof(RECORD_COMMIT));
+
+    ib_clock_gettimeofday(&tv);
+    now = IB_CLOCK_TIMEVAL_TIME(tv);
+
+    pthread_mutex_lock(&server->lock);
+
+    /* Rotate a full segment before appending. */
+    if (server->segment_bytes >= server->segment_size) {
+        segment_close(server);
+        rc = segment_open(server, server->seq + 1);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+    }
+
+    written = write(server->fd, record, record_length);
+    if (written < (ssize_t)record_length) {
+        rc = IB_EOTHER;
+        goto cleanup;
+    }
+    server->segment_bytes += record_length;
+
+    /* Group commit: at most one fsync per interval, paid by whichever
+     * writer crosses it. */
+    if (now - server->last_sync >= server->sync_interval) {
+        if (fsync(server->fd) != 0) {
+            rc = IB_EOTHER;
+            goto cleanup;
+        }
+        server->last_sync = now;
+    }
+
+cleanup:
+    pthread_mutex_unlock(&server->lock);
+    free(record);
+
+    return rc;
+}
+
+/**
+ * Read exactly @a length bytes, detecting truncation.
+ *
+ * @param[in] fd File to read.
+ * @param[out] buf Buffer to fill.
+ * @param[in] length Bytes to read.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT on clean end of file (0 bytes read).
+ * - IB_EINVAL on a short read (torn record).
+ */
+static ib_status_t read_fully(int fd, void *buf, size_t length)
+{
+    size_t have = 0;
+
+    while (have < length) {
+        ssize_t got = read(fd, (uint8_t *)buf + have, length - have);
+        if (got < 0) {
+            return IB_EINVAL;
+        }
+        if (got == 0) {
+            return (have == 0) ? IB_ENOENT : IB_EINVAL;
+        }
+        have += got;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Replay one segment file into the backing store.
+ *
+ * Replay stops quietly at the first torn or corrupt record; everything
+ * before it is applied. Sets are idempotent, so records the backing
+ * store already saw are harmless.
+ *
+ * @param[in] kvstore The journal store (for its backing store).
+ * @param[in] path The segment file.
+ *
+ * @returns
+ * - IB_OK on success, including a partially valid segment.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER if the file cannot be opened.
+ */
+static ib_status_t segment_replay(ib_kvstore_t *kvstore, const char *path)
+{
+    assert(kvstore != NULL);
+    assert(path != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    int         fd;
+    ib_status_t rc = IB_OK;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return IB_EOTHER;
+    }
+
+    for (;;) {
+        record_header_t  header;
+        uint32_t         commit;
+        ib_mpool_lite_t *mp;
+        ib_mm_t          mm;
+        uint8_t         *bytes;
+        size_t           bytes_length;
+        ib_kvstore_key_t *key;
+
+        rc = read_fully(fd, &header, sizeof(header));
+        if (rc == IB_ENOENT) {
+            rc = IB_OK;
+            break;
+        }
+        if (rc != IB_OK || header.magic != RECORD_MAGIC) {
+            ib_util_log_error(
+                "kvstore journal: truncated record in %s; "
+                "replay stopped.",
+                path);
+            rc = IB_OK;
+            break;
+        }
+
+        rc = ib_mpool_lite_create(&mp);
+        if (rc != IB_OK) {
+            break;
+        }
+        mm = ib_mm_mpool_lite(mp);
+
+        bytes_length = (size_t)header.key_length
+                     + header.type_length
+                     + header.value_length;
+        bytes = ib_mm_alloc(mm, bytes_length);
+        if (bytes == NULL) {
+            ib_mpool_lite_destroy(mp);
+            rc = IB_EALLOC;
+            break;
+        }
+
+        rc = read_fully(fd, bytes, bytes_length);
+        if (rc == IB_OK) {
+            rc = read_fully(fd, &commit, sizeof(commit));
+        }
+        if (rc != IB_OK || commit != RECORD_COMMIT) {
+            ib_util_log_error(
+                "kvstore journal: torn record in %s; replay stopped.",
+                path);
+            ib_mpool_lite_destroy(mp);
+            rc = IB_OK;
+            break;
+        }
+
+        rc = ib_kvstore_key_create(&key, mm, bytes, header.key_length);
+        if (rc != IB_OK) {
+            ib_mpool_lite_destroy(mp);
+            break;
+        }
+
+        if (header.op == RECORD_OP_SET) {
+            ib_kvstore_value_t *value;
+
+            rc = ib_kvstore_value_create(&value, mm);
+            if (rc != IB_OK) {
+                ib_mpool_lite_destroy(mp);
+                break;
+            }
+            ib_kvstore_value_value_set(
+                value,
+                bytes + header.key_length + header.type_length,
+                header.value_length);
+            ib_kvstore_value_type_set(
+                value,
+                (const char *)(bytes + header.key_length),
+                header.type_length);
+            ib_kvstore_value_expiration_set(value, header.expiration);
+            ib_kvstore_value_creation_set(value, header.creation);
+
+            rc = ib_kvstore_set(server->backing, NULL, key, value);
+        }
+        else if (header.op == RECORD_OP_REMOVE) {
+            rc = ib_kvstore_remove(server->backing, key);
+            /* The key may never have reached the backing store. */
+            if (rc == IB_ENOENT) {
+                rc = IB_OK;
+            }
+        }
+
+        ib_mpool_lite_destroy(mp);
+
+        if (rc != IB_OK) {
+            break;
+        }
+    }
+
+    close(fd);
+
+    return rc;
+}
+
+/**
+ * Connect callback: connect the backing store and replay the journal.
+ *
+ * Surviving segments are replayed in sequence order and removed, then
+ * a fresh segment is opened.
+ */
+static ib_status_t kvconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    ib_status_t    rc;
+    DIR           *dir;
+    struct dirent *entry;
+    uint64_t      *seqs = NULL;
+    size_t         seq_count = 0;
+    size_t         seq_capacity = 0;
+    uint64_t       next_seq = 0;
+
+    rc = ib_kvstore_connect(server->backing);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (mkdir(server->directory, 0755) != 0 && errno != EEXIST) {
+        return IB_EOTHER;
+    }
+
+    /* Collect surviving segment sequence numbers. */
+    dir = opendir(server->directory);
+    if (dir == NULL) {
+        return IB_EOTHER;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        uint64_t seq;
+
+        if (sscanf(
+                entry->d_name,
+                SEGMENT_PREFIX "%" SCNu64 SEGMENT_SUFFIX,
+                &seq) != 1)
+        {
+            continue;
+        }
+
+        if (seq_count == seq_capacity) {
+            uint64_t *tmp;
+            seq_capacity = (seq_capacity == 0) ? 16 : seq_capacity * 2;
+            tmp = realloc(seqs, seq_capacity * sizeof(*seqs));
+            if (tmp == NULL) {
+                free(seqs);
+                closedir(dir);
+                return IB_EALLOC;
+            }
+            seqs = tmp;
+        }
+        seqs[seq_count] = seq;
+        ++seq_count;
+    }
+    closedir(dir);
+
+    /* Replay in sequence order (insertion sort; segments are few). */
+    for (size_t i = 1; i < seq_count; ++i) {
+        uint64_t v = seqs[i];
+        size_t   j = i;
+        while (j > 0 && seqs[j-1] > v) {
+            seqs[j] = seqs[j-1];
+            --j;
+        }
+        seqs[j] = v;
+    }
+
+    for (size_t i = 0; i < seq_count; ++i) {
+        char *path = segment_path(server, seqs[i]);
+
+        if (path == NULL) {
+            free(seqs);
+            return IB_EALLOC;
+        }
+
+        rc = segment_replay(kvstore, path);
+        if (rc == IB_OK) {
+            unlink(path);
+        }
+        free(path);
+        if (rc != IB_OK) {
+            free(seqs);
+            return rc;
+        }
+
+        next_seq = seqs[i] + 1;
+    }
+    free(seqs);
+
+    return segment_open(server, next_seq);
+}
+
+/**
+ * Disconnect callback: sync and close the segment, disconnect backing.
+ */
+static ib_status_t kvdisconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+
+    pthread_mutex_lock(&server->lock);
+    segment_close(server);
+    pthread_mutex_unlock(&server->lock);
+
+    return ib_kvstore_disconnect(server->backing);
+}
+
+/**
+ * Get callback: forwarded to the backing store.
+ *
+ * The backing store merges its own values, so a single value is
+ * returned.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    ib_kvstore_value_t *value = NULL;
+    ib_status_t         rc;
+
+    rc = ib_kvstore_get(server->backing, NULL, mm, key, &value);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *values = ib_mm_alloc(mm, sizeof(**values));
+    if (*values == NULL) {
+        return IB_EALLOC;
+    }
+    (*values)[0] = value;
+    *values_length = 1;
+
+    return IB_OK;
+}
+
+/**
+ * Set callback: journal the write, then forward it.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    ib_status_t rc;
+
+    rc = journal_append(server, RECORD_OP_SET, key, value);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_kvstore_set(server->backing, merge_policy, key, value);
+}
+
+/**
+ * Remove callback: journal the remove, then forward it.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    ib_status_t rc;
+
+    rc = journal_append(server, RECORD_OP_REMOVE, key, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_kvstore_remove(server->backing, key);
+}
+
+/**
+ * Destroy callback: destroy the owned backing store and this server.
+ */
+static void kvdestroy(ib_kvstore_t *kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+
+    segment_close(server);
+    ib_kvstore_destroy(server->backing);
+    pthread_mutex_destroy(&server->lock);
+    free(server->directory);
+    free(server);
+    kvstore->server = NULL;
+}
+
+ib_status_t ib_kvstore_journal_init(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_t *backing,
+    const char   *directory,
+    uint32_t      sync_interval_seconds)
+{
+    assert(kvstore != NULL);
+    assert(backing != NULL);
+    assert(directory != NULL);
+
+    ib_kvstore_init(kvstore);
+
+    ib_kvstore_journal_server_t *server = malloc(sizeof(*server));
+
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->backing       = backing;
+    server->fd            = -1;
+    server->seq           = 0;
+    server->segment_bytes = 0;
+    server->segment_size  = DEFAULT_SEGMENT_SIZE;
+    server->sync_interval = (ib_time_t)sync_interval_seconds * 1000000;
+    server->last_sync     = 0;
+
+    server->directory = strdup(directory);
+    if (server->directory == NULL) {
+        free(server);
+        return IB_EALLOC;
+    }
+
+    if (pthread_mutex_init(&server->lock, NULL) != 0) {
+        free(server->directory);
+        free(server);
+        return IB_EOTHER;
+    }
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+    kvstore->default_merge_policy = backing->default_merge_policy;
+
+    return IB_OK;
+}
+
+void ib_kvstore_journal_set_segment_size(ib_kvstore_t *kvstore, size_t size)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_journal_server_t *server =
+        (ib_kvstore_journal_server_t *)kvstore->server;
+    server->segment_size = size;
+}
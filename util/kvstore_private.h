@@ -102,6 +102,60 @@ typedef ib_status_t (*ib_kvstore_set_fn_t)(
     ib_kvstore_cbdata_t          *cbdata
 );
 
+/**
+ * Get many values from the data store in one round.
+ *
+ * Optional. Backends that can batch or pipeline requests implement
+ * this; ib_kvstore_mget() falls back to per-key
+ * @ref ib_kvstore_get_fn_t calls when it is NULL.
+ *
+ * A key that is absent is not an error: the implementation records a
+ * zero length and a NULL value array for it and continues.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] mm Memory manager the value arrays are allocated out of.
+ * @param[in] keys The keys to get.
+ * @param[in] key_count The length of @a keys.
+ * @param[out] values Caller-allocated array of @a key_count entries.
+ *             Entry i is set to an array of the values stored at
+ *             keys[i], or NULL if the key is absent.
+ * @param[out] values_lengths Caller-allocated array of @a key_count
+ *             entries. Entry i is the length of values[i].
+ * @param[in,out] cbdata Callback data passed in during initialization.
+ */
+typedef ib_status_t (*ib_kvstore_mget_fn_t)(
+    ib_kvstore_t                   *kvstore,
+    ib_mm_t                         mm,
+    const ib_kvstore_key_t *const  *keys,
+    size_t                          key_count,
+    ib_kvstore_value_t           ***values,
+    size_t                         *values_lengths,
+    ib_kvstore_cbdata_t            *cbdata
+);
+
+/**
+ * Set many values in the data store in one round.
+ *
+ * Optional. Backends that can batch or pipeline requests implement
+ * this; ib_kvstore_mset() falls back to per-key
+ * @ref ib_kvstore_set_fn_t calls when it is NULL.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] merge_policy As @ref ib_kvstore_set_fn_t.
+ * @param[in] keys The keys to set.
+ * @param[in] values The value to write for each key in @a keys.
+ * @param[in] count The length of @a keys and @a values.
+ * @param[in,out] cbdata Callback data passed in during initialization.
+ */
+typedef ib_status_t (*ib_kvstore_mset_fn_t)(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    const ib_kvstore_key_t *const *keys,
+    ib_kvstore_value_t *const     *values,
+    size_t                         count,
+    ib_kvstore_cbdata_t           *cbdata
+);
+
 /**
  * Remove a value from the data store.
  *
@@ -176,6 +230,12 @@ struct ib_kvstore_t {
     ib_kvstore_set_fn_t set; /**< Set a value in the key-value store. */
     ib_kvstore_cbdata_t *set_cbdata; /**< Set cbdata. */
 
+    ib_kvstore_mget_fn_t mget; /**< Batched get, or NULL. */
+    ib_kvstore_cbdata_t *mget_cbdata; /**< Batched get cbdata. */
+
+    ib_kvstore_mset_fn_t mset; /**< Batched set, or NULL. */
+    ib_kvstore_cbdata_t *mset_cbdata; /**< Batched set cbdata. */
+
     ib_kvstore_remove_fn_t remove; /**< Remove a value from the kv store. */
     ib_kvstore_cbdata_t *remove_cbdata; /**< Remove cbdata. */
 
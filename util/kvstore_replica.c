@@ -0,0 +1,815 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Write-behind replication composing two kvstores.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_replica.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/kvstore.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Default bound of the pending delta queue. */
+static const size_t DEFAULT_MAX_PENDING = 4096;
+
+/**
+ * A queued write awaiting propagation to the remote store.
+ *
+ * The key and value are deep copies owned by the delta's pool, so a
+ * delta outlives the transaction that produced it.
+ */
+struct ib_kvstore_replica_delta_t {
+    ib_kvstore_replica_delta_t  *next;    /**< Next older queued delta. */
+    ib_mpool_lite_t             *mp;      /**< Owns the key and value. */
+    ib_kvstore_key_t            *key;     /**< The written key. */
+    ib_kvstore_value_t          *value;   /**< The value. NULL = remove. */
+    bool                         numeric; /**< Propagate additively? */
+    int64_t                      amount;  /**< The addend when numeric. */
+
+    /** The caller's merge policy, for non-numeric propagation. */
+    ib_kvstore_merge_policy_fn_t merge_policy;
+};
+
+/**
+ * Parse @a data as a decimal integer.
+ *
+ * Only values that are entirely an optionally signed decimal integer
+ * participate in additive propagation.
+ *
+ * @param[in] data The value bytes.
+ * @param[in] data_length Length of @a data.
+ * @param[out] num The parsed number.
+ *
+ * @returns True if @a data parses completely.
+ */
+static bool parse_num(const uint8_t *data, size_t data_length, int64_t *num)
+{
+    char  buffer[32];
+    char *end;
+
+    if (data_length == 0 || data_length >= sizeof(buffer)) {
+        return false;
+    }
+
+    memcpy(buffer, data, data_length);
+    buffer[data_length] = '\0';
+
+    errno = 0;
+    *num = strtoll(buffer, &end, 10);
+    return (errno == 0 && end == buffer + data_length);
+}
+
+/**
+ * Compare two keys for equality.
+ *
+ * @param[in] a A key.
+ * @param[in] b A key.
+ *
+ * @returns True if the key bytes are identical.
+ */
+static bool keys_equal(const ib_kvstore_key_t *a, const ib_kvstore_key_t *b)
+{
+    const uint8_t *a_data;
+    const uint8_t *b_data;
+    size_t         a_length;
+    size_t         b_length;
+
+    ib_kvstore_key_get(a, &a_data, &a_length);
+    ib_kvstore_key_get(b, &b_data, &b_length);
+
+    return (a_length == b_length && memcmp(a_data, b_data, a_length) == 0);
+}
+
+/**
+ * Destroy a delta and the copies it owns.
+ *
+ * @param[in] delta The delta. May be NULL.
+ */
+static void delta_destroy(ib_kvstore_replica_delta_t *delta)
+{
+    if (delta == NULL) {
+        return;
+    }
+    ib_mpool_lite_destroy(delta->mp);
+    free(delta);
+}
+
+/**
+ * Create a delta holding copies of @a key and @a value.
+ *
+ * @param[out] out The created delta.
+ * @param[in] key The written key.
+ * @param[in] value The value. NULL records a remove.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t delta_create(
+    ib_kvstore_replica_delta_t **out,
+    const ib_kvstore_key_t      *key,
+    const ib_kvstore_value_t    *value
+)
+{
+    ib_kvstore_replica_delta_t *delta;
+    ib_status_t                 rc;
+
+    delta = calloc(1, sizeof(*delta));
+    if (delta == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_mpool_lite_create(&delta->mp);
+    if (rc != IB_OK) {
+        free(delta);
+        return rc;
+    }
+
+    rc = ib_kvstore_key_dup(ib_mm_mpool_lite(delta->mp), key, &delta->key);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    if (value != NULL) {
+        rc = ib_kvstore_value_dup(
+            ib_mm_mpool_lite(delta->mp),
+            value,
+            &delta->value);
+        if (rc != IB_OK) {
+            goto fail;
+        }
+    }
+
+    *out = delta;
+    return IB_OK;
+
+fail:
+    delta_destroy(delta);
+    return rc;
+}
+
+/**
+ * Detach the whole pending queue. Called with the lock held.
+ *
+ * @param[in] server The replica server.
+ *
+ * @returns The oldest delta of the detached chain, or NULL.
+ */
+static ib_kvstore_replica_delta_t *queue_detach(
+    ib_kvstore_replica_server_t *server
+)
+{
+    ib_kvstore_replica_delta_t *head = server->head;
+
+    server->head    = NULL;
+    server->tail    = NULL;
+    server->pending = 0;
+
+    return head;
+}
+
+/**
+ * Re-queue a detached chain at the front. Called with the lock held.
+ *
+ * @param[in] server The replica server.
+ * @param[in] head The oldest delta of the chain.
+ */
+static void queue_requeue(
+    ib_kvstore_replica_server_t *server,
+    ib_kvstore_replica_delta_t  *head
+)
+{
+    ib_kvstore_replica_delta_t *tail = head;
+    size_t                      count = 1;
+
+    if (head == NULL) {
+        return;
+    }
+
+    while (tail->next != NULL) {
+        tail = tail->next;
+        ++count;
+    }
+
+    tail->next = server->head;
+    server->head = head;
+    if (server->tail == NULL) {
+        server->tail = tail;
+    }
+    server->pending += count;
+}
+
+/**
+ * Queue @a delta, coalescing with a pending delta for the same key.
+ *
+ * Called with the lock held. Numeric deltas for the same key sum;
+ * a non-numeric delta replaces any pending delta for its key.
+ *
+ * @param[in] server The replica server.
+ * @param[in] delta The delta. Ownership is taken, even on coalesce.
+ */
+static void queue_append(
+    ib_kvstore_replica_server_t *server,
+    ib_kvstore_replica_delta_t  *delta
+)
+{
+    for (
+        ib_kvstore_replica_delta_t *pending = server->head;
+        pending != NULL;
+        pending = pending->next
+    )
+    {
+        if (! keys_equal(pending->key, delta->key)) {
+            continue;
+        }
+
+        if (pending->numeric && delta->numeric) {
+            pending->amount += delta->amount;
+            delta_destroy(delta);
+            return;
+        }
+
+        /* A remove or an overwrite supersedes the pending write.
+         * Swap the payloads so the queue position is kept. */
+        if (! delta->numeric) {
+            ib_mpool_lite_t    *mp    = pending->mp;
+            ib_kvstore_key_t   *key   = pending->key;
+            ib_kvstore_value_t *value = pending->value;
+
+            pending->mp           = delta->mp;
+            pending->key          = delta->key;
+            pending->value        = delta->value;
+            pending->numeric      = delta->numeric;
+            pending->amount       = delta->amount;
+            pending->merge_policy = delta->merge_policy;
+
+            delta->mp    = mp;
+            delta->key   = key;
+            delta->value = value;
+            delta_destroy(delta);
+            return;
+        }
+
+        break;
+    }
+
+    delta->next = NULL;
+    if (server->tail == NULL) {
+        server->head = delta;
+    }
+    else {
+        server->tail->next = delta;
+    }
+    server->tail = delta;
+    ++server->pending;
+}
+
+/**
+ * Propagate one numeric delta: add it to the remote total and pull the
+ * total back into the local store.
+ *
+ * @param[in] server The replica server.
+ * @param[in] delta The delta.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Other codes from the remote store.
+ */
+static ib_status_t propagate_numeric(
+    ib_kvstore_replica_server_t *server,
+    ib_kvstore_replica_delta_t  *delta
+)
+{
+    ib_mpool_lite_t    *mp;
+    ib_mm_t             mm;
+    ib_kvstore_value_t *remote_value = NULL;
+    ib_kvstore_value_t *total_value;
+    const char         *type;
+    size_t              type_length;
+    int64_t             total = delta->amount;
+    char               *buffer;
+    int                 length;
+    ib_status_t         rc;
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    rc = ib_kvstore_get(server->remote, NULL, mm, delta->key, &remote_value);
+    if (rc == IB_OK) {
+        const uint8_t *data;
+        size_t         data_length;
+        int64_t        remote_num;
+
+        ib_kvstore_value_value_get(remote_value, &data, &data_length);
+        if (parse_num(data, data_length, &remote_num)) {
+            total += remote_num;
+        }
+    }
+    else if (rc != IB_ENOENT) {
+        goto cleanup;
+    }
+
+    buffer = ib_mm_alloc(mm, 32);
+    if (buffer == NULL) {
+        rc = IB_EALLOC;
+        goto cleanup;
+    }
+    length = snprintf(buffer, 32, "%" PRId64, total);
+
+    rc = ib_kvstore_value_create(&total_value, mm);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    ib_kvstore_value_value_set(total_value, (uint8_t *)buffer, length);
+    ib_kvstore_value_type_get(delta->value, &type, &type_length);
+    ib_kvstore_value_type_set(total_value, type, type_length);
+    ib_kvstore_value_expiration_set(
+        total_value,
+        ib_kvstore_value_expiration_get(delta->value));
+    ib_kvstore_value_creation_set(
+        total_value,
+        ib_kvstore_value_creation_get(delta->value));
+
+    rc = ib_kvstore_set(server->remote, NULL, delta->key, total_value);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    /* Fold the other nodes' contributions into the local copy. A
+     * failure here is local-only and must not re-queue the delta. */
+    ib_kvstore_set(server->local, NULL, delta->key, total_value);
+
+cleanup:
+    ib_mpool_lite_destroy(mp);
+    return rc;
+}
+
+/**
+ * Propagate a detached chain of deltas to the remote store.
+ *
+ * On the first remote failure the unpropagated remainder is re-queued
+ * for the next interval.
+ *
+ * @param[in] server The replica server.
+ * @param[in] head The oldest delta of the chain.
+ *
+ * @returns
+ * - IB_OK if the chain drained.
+ * - IB_EOTHER if the remote store rejected a write.
+ */
+static ib_status_t propagate(
+    ib_kvstore_replica_server_t *server,
+    ib_kvstore_replica_delta_t  *head
+)
+{
+    while (head != NULL) {
+        ib_kvstore_replica_delta_t *delta = head;
+        ib_status_t                 rc;
+
+        if (delta->value == NULL) {
+            rc = ib_kvstore_remove(server->remote, delta->key);
+            if (rc == IB_ENOENT) {
+                rc = IB_OK;
+            }
+        }
+        else if (delta->numeric) {
+            rc = propagate_numeric(server, delta);
+        }
+        else {
+            rc = ib_kvstore_set(
+                server->remote,
+                delta->merge_policy,
+                delta->key,
+                delta->value);
+        }
+
+        if (rc != IB_OK) {
+            pthread_mutex_lock(&server->lock);
+            queue_requeue(server, head);
+            pthread_mutex_unlock(&server->lock);
+            return IB_EOTHER;
+        }
+
+        head = head->next;
+        delta_destroy(delta);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Main of the propagation thread.
+ *
+ * Wakes every flush interval, or early when the queue bound is hit,
+ * and propagates the pending deltas.
+ *
+ * @param[in] data The @ref ib_kvstore_replica_server_t.
+ *
+ * @returns NULL.
+ */
+static void *flusher_main(void *data)
+{
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)data;
+
+    pthread_mutex_lock(&server->lock);
+    while (server->running) {
+        ib_kvstore_replica_delta_t *head;
+        struct timespec             deadline;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += server->flush_interval / 1000000;
+        deadline.tv_nsec += (server->flush_interval % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            deadline.tv_sec  += 1;
+        }
+        pthread_cond_timedwait(&server->cond, &server->lock, &deadline);
+
+        head = queue_detach(server);
+        if (head != NULL) {
+            /* Propagation does remote I/O; never hold the lock. */
+            pthread_mutex_unlock(&server->lock);
+            propagate(server, head);
+            pthread_mutex_lock(&server->lock);
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    return NULL;
+}
+
+/**
+ * Connect callback: connect both stores and start the flusher.
+ */
+static ib_status_t kvconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_status_t rc;
+
+    rc = ib_kvstore_connect(server->local);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_kvstore_connect(server->remote);
+    if (rc != IB_OK) {
+        ib_kvstore_disconnect(server->local);
+        return rc;
+    }
+
+    server->running = true;
+    if (pthread_create(&server->flusher, NULL, flusher_main, server) != 0) {
+        server->running = false;
+        ib_kvstore_disconnect(server->remote);
+        ib_kvstore_disconnect(server->local);
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Disconnect callback: stop the flusher, drain, disconnect both.
+ */
+static ib_status_t kvdisconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_status_t local_rc;
+    ib_status_t remote_rc;
+
+    pthread_mutex_lock(&server->lock);
+    if (server->running) {
+        server->running = false;
+        pthread_cond_signal(&server->cond);
+        pthread_mutex_unlock(&server->lock);
+        pthread_join(server->flusher, NULL);
+    }
+    else {
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    /* One final, best-effort drain. */
+    ib_kvstore_replica_flush(kvstore);
+
+    remote_rc = ib_kvstore_disconnect(server->remote);
+    local_rc  = ib_kvstore_disconnect(server->local);
+
+    return (local_rc != IB_OK) ? local_rc : remote_rc;
+}
+
+/**
+ * Get callback: serve locally; fall back to remote and seed on a miss.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_kvstore_value_t *value = NULL;
+    ib_status_t         rc;
+
+    rc = ib_kvstore_get(server->local, NULL, mm, key, &value);
+    if (rc == IB_ENOENT) {
+        rc = ib_kvstore_get(server->remote, NULL, mm, key, &value);
+        if (rc == IB_OK) {
+            /* Seed the local copy; a failure only costs the next
+             * reader another remote round trip. */
+            ib_kvstore_set(server->local, NULL, key, value);
+        }
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *values = ib_mm_alloc(mm, sizeof(**values));
+    if (*values == NULL) {
+        return IB_EALLOC;
+    }
+    (*values)[0] = value;
+    *values_length = 1;
+
+    return IB_OK;
+}
+
+/**
+ * Set callback: write locally, queue the delta.
+ *
+ * When both the previous local value and the new value are decimal
+ * integers, the queued delta is their difference and is propagated
+ * additively; otherwise the new value propagates as written.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_kvstore_replica_delta_t *delta;
+    ib_kvstore_replica_delta_t *overflow = NULL;
+    const uint8_t              *data;
+    size_t                      data_length;
+    int64_t                     new_num;
+    ib_status_t                 rc;
+
+    rc = delta_create(&delta, key, value);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_kvstore_value_value_get(value, &data, &data_length);
+    if (parse_num(data, data_length, &new_num)) {
+        ib_mpool_lite_t    *mp;
+        ib_kvstore_value_t *old_value = NULL;
+        int64_t             old_num = 0;
+
+        rc = ib_mpool_lite_create(&mp);
+        if (rc != IB_OK) {
+            delta_destroy(delta);
+            return rc;
+        }
+
+        rc = ib_kvstore_get(
+            server->local,
+            NULL,
+            ib_mm_mpool_lite(mp),
+            key,
+            &old_value);
+        if (rc == IB_OK) {
+            ib_kvstore_value_value_get(old_value, &data, &data_length);
+            if (! parse_num(data, data_length, &old_num)) {
+                old_num = 0;
+            }
+        }
+
+        delta->numeric = true;
+        delta->amount  = new_num - old_num;
+        ib_mpool_lite_destroy(mp);
+    }
+    delta->merge_policy = merge_policy;
+
+    rc = ib_kvstore_set(server->local, merge_policy, key, value);
+    if (rc != IB_OK) {
+        delta_destroy(delta);
+        return rc;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    queue_append(server, delta);
+    if (server->pending >= server->max_pending) {
+        if (server->running) {
+            pthread_cond_signal(&server->cond);
+        }
+        else {
+            overflow = queue_detach(server);
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    /* Without a flusher, the bounded queue drains inline. The local
+     * write already succeeded, so a remote failure re-queues. */
+    if (overflow != NULL) {
+        propagate(server, overflow);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Remove callback: remove locally, queue the remove.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_kvstore_replica_delta_t *delta;
+    ib_status_t                 rc;
+
+    rc = delta_create(&delta, key, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_kvstore_remove(server->local, key);
+    if (rc != IB_OK) {
+        delta_destroy(delta);
+        return rc;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    queue_append(server, delta);
+    pthread_mutex_unlock(&server->lock);
+
+    return IB_OK;
+}
+
+/**
+ * Destroy callback: drop the queue, destroy both owned stores.
+ */
+static void kvdestroy(ib_kvstore_t *kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_kvstore_replica_delta_t *head;
+
+    head = queue_detach(server);
+    while (head != NULL) {
+        ib_kvstore_replica_delta_t *next = head->next;
+        delta_destroy(head);
+        head = next;
+    }
+
+    ib_kvstore_destroy(server->remote);
+    ib_kvstore_destroy(server->local);
+    pthread_cond_destroy(&server->cond);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+    kvstore->server = NULL;
+}
+
+ib_status_t ib_kvstore_replica_init(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_t *local,
+    ib_kvstore_t *remote,
+    uint32_t      flush_interval_seconds)
+{
+    assert(kvstore != NULL);
+    assert(local != NULL);
+    assert(remote != NULL);
+
+    ib_kvstore_init(kvstore);
+
+    ib_kvstore_replica_server_t *server = calloc(1, sizeof(*server));
+
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->local          = local;
+    server->remote         = remote;
+    server->flush_interval = (ib_time_t)flush_interval_seconds * 1000000;
+    server->max_pending    = DEFAULT_MAX_PENDING;
+
+    if (pthread_mutex_init(&server->lock, NULL) != 0) {
+        free(server);
+        return IB_EOTHER;
+    }
+    if (pthread_cond_init(&server->cond, NULL) != 0) {
+        pthread_mutex_destroy(&server->lock);
+        free(server);
+        return IB_EOTHER;
+    }
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+    kvstore->default_merge_policy = local->default_merge_policy;
+
+    return IB_OK;
+}
+
+ib_status_t ib_kvstore_replica_flush(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    ib_kvstore_replica_delta_t *head;
+
+    pthread_mutex_lock(&server->lock);
+    head = queue_detach(server);
+    pthread_mutex_unlock(&server->lock);
+
+    return propagate(server, head);
+}
+
+void ib_kvstore_replica_set_max_pending(
+    ib_kvstore_t *kvstore,
+    size_t        max_pending)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ib_kvstore_replica_server_t *server =
+        (ib_kvstore_replica_server_t *)kvstore->server;
+    server->max_pending = (max_pending == 0) ? 1 : max_pending;
+}
@@ -34,6 +34,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+/** Pooled easy handles per store; the batch in-flight request limit. */
+#define RIAK_POOL_SIZE 16
+
 #define EXPIRATION "X-Riak-Meta-Expiration"
 #define CREATION "X-Riak-Meta-Creation"
 #define VCLOCK "X-Riak-Vclock"
@@ -1023,6 +1026,407 @@ exit:
     kvfree(kvstore, url);
     return rc;
 }
+/**
+ * One request in a batched (mget/mset) round.
+ */
+struct riak_batch_op_t {
+    size_t             index;       /**< Index into the caller's arrays. */
+    CURL              *curl;        /**< The pooled handle running this. */
+    char              *url;         /**< The key URL. */
+    membuffer_t        response;    /**< Response body. */
+    membuffer_t        value;       /**< Request body, for PUTs. */
+    riak_headers_t     headers;     /**< Parsed response headers. */
+    struct curl_slist *header_list; /**< Custom request headers. */
+    int                added;       /**< Added to the multi handle. */
+    int                failed;      /**< Setup or transfer failed. */
+};
+typedef struct riak_batch_op_t riak_batch_op_t;
+
+/**
+ * Common easy handle setup for one batched request.
+ *
+ * Initializes the response buffer and header capture and points the
+ * handle at @a op's key URL. TCP keep-alive is requested; together
+ * with curl's connection cache, which curl_easy_reset() preserves,
+ * pooled handles reuse their Riak connections across batches instead
+ * of paying connection setup per operation.
+ */
+static ib_status_t riak_batch_common_setup(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_riak_server_t *riak,
+    riak_batch_op_t *op,
+    const ib_kvstore_key_t *key)
+{
+    assert(kvstore != NULL);
+    assert(riak != NULL);
+    assert(op != NULL);
+    assert(key != NULL);
+
+    membuffer_init(kvstore, &op->response);
+    membuffer_init(kvstore, &op->value);
+    riak_headers_init(kvstore, &op->headers);
+    op->header_list = NULL;
+    op->added = 0;
+    op->failed = 0;
+
+    op->url = build_key_url(kvstore, riak, key);
+    if (op->url == NULL) {
+        return IB_EALLOC;
+    }
+
+    if (curl_easy_setopt(op->curl, CURLOPT_URL, op->url)) {
+        return IB_EOTHER;
+    }
+#if LIBCURL_VERSION_NUM >= 0x071900
+    if (curl_easy_setopt(op->curl, CURLOPT_TCP_KEEPALIVE, 1L)) {
+        return IB_EOTHER;
+    }
+#endif
+    if (curl_easy_setopt(
+            op->curl,
+            CURLOPT_WRITEFUNCTION,
+            membuffer_writefunction))
+    {
+        return IB_EOTHER;
+    }
+    if (curl_easy_setopt(op->curl, CURLOPT_WRITEDATA, &op->response)) {
+        return IB_EOTHER;
+    }
+    if (curl_easy_setopt(
+            op->curl,
+            CURLOPT_HEADERFUNCTION,
+            &riak_header_capture))
+    {
+        return IB_EOTHER;
+    }
+    if (curl_easy_setopt(op->curl, CURLOPT_WRITEHEADER, &op->headers)) {
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Release everything @a op holds and return its handle to the pool.
+ *
+ * curl_easy_reset() clears the options set for this request but keeps
+ * the handle's live connections, preserving keep-alive for the next
+ * batch.
+ */
+static void riak_batch_op_cleanup(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_riak_server_t *riak,
+    riak_batch_op_t *op)
+{
+    if (op->added) {
+        curl_multi_remove_handle(riak->multi, op->curl);
+    }
+    if (op->header_list) {
+        curl_slist_free_all(op->header_list);
+    }
+    cleanup_membuffer(&op->response);
+    cleanup_riak_headers(&op->headers);
+    curl_easy_reset(op->curl);
+    if (op->url) {
+        kvfree(kvstore, op->url);
+    }
+}
+
+/**
+ * Drive the multi handle until every added request has completed.
+ */
+static ib_status_t riak_multi_run(ib_kvstore_riak_server_t *riak)
+{
+    assert(riak != NULL);
+    assert(riak->multi != NULL);
+
+    int running = 0;
+
+    do {
+        CURLMcode multi_rc = curl_multi_perform(riak->multi, &running);
+
+        if (multi_rc == CURLM_CALL_MULTI_PERFORM) {
+            continue;
+        }
+        if (multi_rc != CURLM_OK) {
+            return IB_EOTHER;
+        }
+        if (running > 0) {
+            if (curl_multi_wait(riak->multi, NULL, 0, 1000, NULL)
+                != CURLM_OK)
+            {
+                return IB_EOTHER;
+            }
+        }
+    } while (running > 0);
+
+    return IB_OK;
+}
+
+/**
+ * Batched get: fetch up to pool_size keys concurrently per round.
+ *
+ * A key whose object has siblings (HTTP 300) is re-fetched through
+ * the sequential kvget() path, as sibling resolution requires
+ * follow-up requests. Batched gets do not update the store's vclock
+ * and etag; those remain per-request state of the sequential path.
+ */
+static ib_status_t kvmget(
+    ib_kvstore_t                   *kvstore,
+    ib_mm_t                         mm,
+    const ib_kvstore_key_t *const  *keys,
+    size_t                          key_count,
+    ib_kvstore_value_t           ***values,
+    size_t                         *values_lengths,
+    ib_kvstore_cbdata_t            *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(keys != NULL);
+    assert(values != NULL);
+    assert(values_lengths != NULL);
+
+    ib_kvstore_riak_server_t *riak =
+        (ib_kvstore_riak_server_t *)kvstore->server;
+    riak_batch_op_t *ops;
+    ib_status_t      rc   = IB_OK;
+    size_t           done = 0;
+
+    assert(riak->multi != NULL);
+    assert(riak->pool != NULL);
+
+    ops = kvmalloc(kvstore, sizeof(*ops) * riak->pool_size);
+    if (ops == NULL) {
+        return IB_EALLOC;
+    }
+
+    while (done < key_count) {
+        size_t batch = key_count - done;
+
+        if (batch > riak->pool_size) {
+            batch = riak->pool_size;
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            riak_batch_op_t *op = &ops[i];
+
+            op->index = done + i;
+            op->curl  = riak->pool[i];
+
+            if (
+                riak_batch_common_setup(kvstore, riak, op, keys[op->index])
+                    != IB_OK ||
+                curl_easy_setopt(op->curl, CURLOPT_HTTPGET, 1)
+            ) {
+                op->failed = 1;
+                rc = IB_EOTHER;
+                continue;
+            }
+
+            op->header_list = build_custom_headers(kvstore, riak, NULL);
+            if (op->header_list) {
+                if (curl_easy_setopt(
+                        op->curl,
+                        CURLOPT_HTTPHEADER,
+                        op->header_list))
+                {
+                    op->failed = 1;
+                    rc = IB_EOTHER;
+                    continue;
+                }
+            }
+
+            if (curl_multi_add_handle(riak->multi, op->curl) != CURLM_OK) {
+                op->failed = 1;
+                rc = IB_EOTHER;
+                continue;
+            }
+            op->added = 1;
+        }
+
+        if (riak_multi_run(riak) != IB_OK) {
+            rc = IB_EOTHER;
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            riak_batch_op_t *op  = &ops[i];
+            size_t           idx = op->index;
+
+            values[idx]         = NULL;
+            values_lengths[idx] = 0;
+
+            if (! op->failed && op->headers.status == 200) {
+                values[idx] = ib_mm_alloc(mm, sizeof(*values[idx]));
+                if (values[idx] == NULL) {
+                    rc = IB_EALLOC;
+                }
+                else if (
+                    http_to_kvstore_value(
+                        kvstore,
+                        riak,
+                        &op->response,
+                        &op->headers,
+                        mm,
+                        &(values[idx][0])) == IB_OK
+                ) {
+                    values_lengths[idx] = 1;
+                }
+                else {
+                    values[idx] = NULL;
+                    rc = IB_EOTHER;
+                }
+            }
+            else if (! op->failed && op->headers.status == 300) {
+                /* Siblings. Resolve through the sequential path. */
+                ib_status_t get_rc = kvget(
+                    kvstore,
+                    mm,
+                    keys[idx],
+                    &values[idx],
+                    &values_lengths[idx],
+                    cbdata);
+                if (get_rc == IB_ENOENT) {
+                    values[idx]         = NULL;
+                    values_lengths[idx] = 0;
+                }
+                else if (get_rc != IB_OK) {
+                    rc = get_rc;
+                }
+            }
+            /* 404 and anything else: the key is treated as absent. */
+
+            riak_batch_op_cleanup(kvstore, riak, op);
+        }
+
+        done += batch;
+    }
+
+    kvfree(kvstore, ops);
+    return rc;
+}
+
+/**
+ * Batched set: write up to pool_size keys concurrently per round.
+ */
+static ib_status_t kvmset(
+    ib_kvstore_t                  *kvstore,
+    ib_kvstore_merge_policy_fn_t   merge_policy,
+    const ib_kvstore_key_t *const *keys,
+    ib_kvstore_value_t *const     *values,
+    size_t                         count,
+    ib_kvstore_cbdata_t           *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(keys != NULL);
+    assert(values != NULL);
+
+    ib_kvstore_riak_server_t *riak =
+        (ib_kvstore_riak_server_t *)kvstore->server;
+    riak_batch_op_t *ops;
+    ib_status_t      rc   = IB_OK;
+    size_t           done = 0;
+
+    assert(riak->multi != NULL);
+    assert(riak->pool != NULL);
+
+    ops = kvmalloc(kvstore, sizeof(*ops) * riak->pool_size);
+    if (ops == NULL) {
+        return IB_EALLOC;
+    }
+
+    while (done < count) {
+        size_t batch = count - done;
+
+        if (batch > riak->pool_size) {
+            batch = riak->pool_size;
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            riak_batch_op_t *op = &ops[i];
+
+            op->index = done + i;
+            op->curl  = riak->pool[i];
+
+            if (riak_batch_common_setup(kvstore, riak, op, keys[op->index])
+                != IB_OK)
+            {
+                op->failed = 1;
+                rc = IB_EOTHER;
+                continue;
+            }
+
+            /* The request body aliases the caller's value; it is not
+             * freed with the op. */
+            ib_kvstore_value_value_get(
+                values[op->index],
+                (const uint8_t **)&(op->value.buffer),
+                &(op->value.size));
+
+            if (
+                curl_easy_setopt(op->curl, CURLOPT_UPLOAD, 1) ||
+                curl_easy_setopt(op->curl, CURLOPT_READDATA, &op->value) ||
+                curl_easy_setopt(
+                    op->curl,
+                    CURLOPT_INFILESIZE,
+                    op->value.size) ||
+                curl_easy_setopt(
+                    op->curl,
+                    CURLOPT_READFUNCTION,
+                    membuffer_readfunction)
+            ) {
+                op->failed = 1;
+                rc = IB_EOTHER;
+                continue;
+            }
+
+            op->header_list =
+                build_custom_headers(kvstore, riak, values[op->index]);
+            if (op->header_list) {
+                if (curl_easy_setopt(
+                        op->curl,
+                        CURLOPT_HTTPHEADER,
+                        op->header_list))
+                {
+                    op->failed = 1;
+                    rc = IB_EOTHER;
+                    continue;
+                }
+            }
+
+            if (curl_multi_add_handle(riak->multi, op->curl) != CURLM_OK) {
+                op->failed = 1;
+                rc = IB_EOTHER;
+                continue;
+            }
+            op->added = 1;
+        }
+
+        if (riak_multi_run(riak) != IB_OK) {
+            rc = IB_EOTHER;
+        }
+
+        for (size_t i = 0; i < batch; ++i) {
+            riak_batch_op_t *op = &ops[i];
+
+            if (
+                ! op->failed &&
+                (op->headers.status < 200 || op->headers.status >= 300)
+            ) {
+                rc = IB_EOTHER;
+            }
+            riak_batch_op_cleanup(kvstore, riak, op);
+        }
+
+        done += batch;
+    }
+
+    kvfree(kvstore, ops);
+    return rc;
+}
+
 static ib_status_t kvconnect(
     ib_kvstore_t *kvstore,
     ib_kvstore_cbdata_t *cbdata)
@@ -1036,6 +1440,44 @@ static ib_status_t kvconnect(
     if (riak->curl == NULL) {
         return IB_EOTHER;
     }
+
+    /* Build the batch machinery: a multi handle and a pool of easy
+     * handles that keep their connections alive between batches. */
+    riak->multi = curl_multi_init();
+    if (riak->multi == NULL) {
+        curl_easy_cleanup(riak->curl);
+        riak->curl = NULL;
+        return IB_EOTHER;
+    }
+
+    riak->pool = kvmalloc(
+        kvstore,
+        sizeof(*riak->pool) * RIAK_POOL_SIZE);
+    if (riak->pool == NULL) {
+        curl_multi_cleanup(riak->multi);
+        riak->multi = NULL;
+        curl_easy_cleanup(riak->curl);
+        riak->curl = NULL;
+        return IB_EALLOC;
+    }
+
+    for (size_t i = 0; i < RIAK_POOL_SIZE; ++i) {
+        riak->pool[i] = curl_easy_init();
+        if (riak->pool[i] == NULL) {
+            for (size_t j = 0; j < i; ++j) {
+                curl_easy_cleanup(riak->pool[j]);
+            }
+            kvfree(kvstore, riak->pool);
+            riak->pool = NULL;
+            curl_multi_cleanup(riak->multi);
+            riak->multi = NULL;
+            curl_easy_cleanup(riak->curl);
+            riak->curl = NULL;
+            return IB_EOTHER;
+        }
+    }
+    riak->pool_size = RIAK_POOL_SIZE;
+
     return IB_OK;
 }
 static ib_status_t kvdisconnect(
@@ -1047,6 +1489,19 @@ static ib_status_t kvdisconnect(
 
     ib_kvstore_riak_server_t *riak =
         (ib_kvstore_riak_server_t *)kvstore->server;
+
+    if (riak->pool != NULL) {
+        for (size_t i = 0; i < riak->pool_size; ++i) {
+            curl_easy_cleanup(riak->pool[i]);
+        }
+        kvfree(kvstore, riak->pool);
+        riak->pool = NULL;
+        riak->pool_size = 0;
+    }
+    if (riak->multi != NULL) {
+        curl_multi_cleanup(riak->multi);
+        riak->multi = NULL;
+    }
     curl_easy_cleanup(riak->curl);
     return IB_OK;
 }
@@ -1105,6 +1560,9 @@ ib_status_t ib_kvstore_riak_init(
     }
     server->vclock = NULL;
     server->etag = NULL;
+    server->multi = NULL;
+    server->pool = NULL;
+    server->pool_size = 0;
     server->riak_url_len = strlen(riak_url);
     server->bucket_len = strlen(bucket);
     server->mm = mm;
@@ -1152,6 +1610,8 @@ ib_status_t ib_kvstore_riak_init(
 
     kvstore->get = kvget;
     kvstore->set = kvset;
+    kvstore->mget = kvmget;
+    kvstore->mset = kvmset;
     kvstore->remove = kvremove;
     kvstore->connect = kvconnect;
     kvstore->disconnect = kvdisconnect;
@@ -1163,6 +1623,8 @@ ib_status_t ib_kvstore_riak_init(
     kvstore->disconnect_cbdata = NULL;
     kvstore->get_cbdata = NULL;
     kvstore->set_cbdata = NULL;
+    kvstore->mget_cbdata = NULL;
+    kvstore->mset_cbdata = NULL;
     kvstore->remove_cbdata = NULL;
     kvstore->merge_policy_cbdata = NULL;
     kvstore->destroy_cbdata = NULL;
@@ -0,0 +1,790 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Persist to a shared, mapped segment.
+ *
+ * Records live in a fixed-size bucket table in a file-backed mapping.
+ * Readers are lock-free: each record carries a sequence counter that a
+ * writer makes odd before mutating the record and even again after, and
+ * readers re-check the counter to validate their copy. Writers serialize
+ * on the backing file's `flock()`, which the kernel releases if a writer
+ * dies, plus a process-local mutex for threads sharing one store.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_shm.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/clock.h>
+#include <ironbee/hash.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/lock.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Marks a segment as holding a bucket table.
+ */
+static const uint32_t SEGMENT_MAGIC = 0x49424b56; /* "IBKV" */
+
+/**
+ * The record layout version. Bump when shm_record_t changes.
+ */
+static const uint32_t SEGMENT_VERSION = 1;
+
+/**
+ * How many buckets past the hash bucket a key may be displaced to.
+ */
+static const size_t PROBE_LIMIT = 8;
+
+/**
+ * How often a reader retries a record a writer is concurrently changing.
+ */
+static const int READ_RETRIES = 3;
+
+/**
+ * The segment header, followed in the segment by the bucket table.
+ */
+typedef struct shm_header_t {
+    uint32_t magic;       /**< SEGMENT_MAGIC. */
+    uint32_t version;     /**< SEGMENT_VERSION. */
+    uint32_t num_buckets; /**< Buckets in the table. */
+    uint32_t data_size;   /**< Maximum value length per record. */
+    uint32_t initialized; /**< Written last during setup. */
+} shm_header_t;
+
+/**
+ * One bucket. The variable-length data array holds data_size bytes.
+ *
+ * A key_length of 0 marks an empty bucket. The seq counter is odd
+ * while a writer is mutating the record.
+ */
+typedef struct shm_record_t {
+    volatile uint32_t seq;          /**< Seqlock counter. */
+    uint32_t          key_length;   /**< Key length. 0 = empty. */
+    uint32_t          type_length;  /**< Type name length. */
+    uint32_t          value_length; /**< Value length. */
+    uint64_t          expiration;   /**< Epoch usec expiration. 0 = never. */
+    uint64_t          creation;     /**< Epoch usec creation time. */
+    uint8_t           key[IB_KVSTORE_SHM_MAX_KEY];  /**< The key. */
+    char              type[IB_KVSTORE_SHM_MAX_TYPE]; /**< The type name. */
+    uint8_t           data[];       /**< The value. data_size bytes. */
+} shm_record_t;
+
+/**
+ * Shared memory store internal state.
+ *
+ * The public ib_kvstore_shm_server_t is the leading member so the
+ * kvstore server pointer can be used with either view.
+ */
+typedef struct shm_store_t {
+    ib_kvstore_shm_server_t server;      /**< Public configuration. */
+    size_t                  record_size; /**< Stride of one bucket. */
+    ib_lock_t              *thread_lock; /**< Serializes in-process writers. */
+} shm_store_t;
+
+/**
+ * Return the stride, in bytes, of one bucket holding @a data_size bytes.
+ */
+static size_t record_stride(size_t data_size)
+{
+    return (offsetof(shm_record_t, data) + data_size + 7) & ~(size_t)7;
+}
+
+/**
+ * Return bucket @a idx of the mapped table.
+ */
+static shm_record_t *record_at(const shm_store_t *store, size_t idx)
+{
+    assert(store != NULL);
+    assert(store->server.segment != NULL);
+    assert(idx < store->server.num_buckets);
+
+    return (shm_record_t *)(
+        (char *)store->server.segment
+        + sizeof(shm_header_t)
+        + idx * store->record_size);
+}
+
+/**
+ * Current wall-clock time in epoch microseconds.
+ */
+static uint64_t now_usec(void)
+{
+    ib_timeval_t tv;
+
+    ib_clock_gettimeofday(&tv);
+
+    return IB_CLOCK_TIMEVAL_TIME(tv);
+}
+
+/**
+ * Serialize writers: threads in this process, then other processes.
+ *
+ * @returns
+ * - IB_OK On success, with both locks held.
+ * - IB_EOTHER If the file lock cannot be taken.
+ * - Other on thread lock failures.
+ */
+static ib_status_t write_lock(shm_store_t *store)
+{
+    assert(store != NULL);
+
+    ib_status_t rc;
+
+    rc = ib_lock_lock(store->thread_lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (flock(store->server.fd, LOCK_EX) != 0) {
+        ib_lock_unlock(store->thread_lock);
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Release the locks taken by write_lock().
+ */
+static void write_unlock(shm_store_t *store)
+{
+    assert(store != NULL);
+
+    flock(store->server.fd, LOCK_UN);
+    ib_lock_unlock(store->thread_lock);
+}
+
+/**
+ * Read one record under seqlock validation.
+ *
+ * The caller picks a bucket; this copies the record out if its key is
+ * @a key, retrying a bounded number of times when a writer changes the
+ * record mid-copy.
+ *
+ * @param[in] store The store.
+ * @param[in] rec The bucket to read.
+ * @param[in] mm Memory manager the copied value is allocated from.
+ * @param[in] key The key sought.
+ * @param[out] value On IB_OK, the record copied into a fresh value.
+ *
+ * @returns
+ * - IB_OK The record held @a key and was copied consistently.
+ * - IB_ENOENT The record holds another key, is empty, is expired, or
+ *   could not be read consistently.
+ * - IB_EALLOC On allocation errors.
+ */
+static ib_status_t record_read(
+    const shm_store_t       *store,
+    const shm_record_t      *rec,
+    ib_mm_t                  mm,
+    const ib_kvstore_key_t  *key,
+    ib_kvstore_value_t     **value
+)
+{
+    assert(store != NULL);
+    assert(rec != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    const uint8_t *key_data;
+    size_t         key_length;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+
+    for (int tries = 0; tries < READ_RETRIES; ++tries) {
+        uint32_t            s1 = rec->seq;
+        uint64_t            expiration;
+        uint64_t            creation;
+        size_t              type_length;
+        size_t              value_length;
+        uint8_t            *data;
+        char               *type;
+        ib_kvstore_value_t *val;
+        ib_status_t         rc;
+
+        if (s1 & 1) {
+            /* Mid-write. Re-read the counter and try again. */
+            continue;
+        }
+        __sync_synchronize();
+
+        if (
+            rec->key_length != key_length ||
+            memcmp(rec->key, key_data, key_length) != 0
+        ) {
+            __sync_synchronize();
+            if (rec->seq == s1) {
+                /* The mismatch was read consistently. */
+                return IB_ENOENT;
+            }
+            continue;
+        }
+
+        expiration   = rec->expiration;
+        creation     = rec->creation;
+        type_length  = rec->type_length;
+        value_length = rec->value_length;
+
+        if (
+            type_length > IB_KVSTORE_SHM_MAX_TYPE ||
+            value_length > store->server.data_size
+        ) {
+            /* Torn read. The lengths are validated at write time. */
+            continue;
+        }
+
+        data = ib_mm_alloc(mm, value_length);
+        type = ib_mm_alloc(mm, type_length + 1);
+        if (data == NULL || type == NULL) {
+            return IB_EALLOC;
+        }
+        memcpy(data, rec->data, value_length);
+        memcpy(type, rec->type, type_length);
+        type[type_length] = '\0';
+
+        __sync_synchronize();
+        if (rec->seq != s1) {
+            continue;
+        }
+
+        /* The copy is consistent. Expired records are misses. */
+        if (expiration != 0 && expiration <= now_usec()) {
+            return IB_ENOENT;
+        }
+
+        rc = ib_kvstore_value_create(&val, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        ib_kvstore_value_value_set(val, data, value_length);
+        ib_kvstore_value_type_set(val, type, type_length);
+        ib_kvstore_value_expiration_set(val, expiration);
+        ib_kvstore_value_creation_set(val, creation);
+
+        *value = val;
+        return IB_OK;
+    }
+
+    /* Persistently contended. Report a miss rather than block. */
+    return IB_ENOENT;
+}
+
+/**
+ * Pick the bucket a write of @a key should use. Call under write_lock().
+ *
+ * Prefers the bucket already holding @a key, then an empty or expired
+ * bucket, and finally evicts the oldest record in the probe window.
+ * A bucket left with an odd seq by a crashed writer holds garbage and
+ * counts as empty.
+ */
+static shm_record_t *record_for_write(
+    shm_store_t   *store,
+    const uint8_t *key_data,
+    size_t         key_length
+)
+{
+    assert(store != NULL);
+    assert(key_data != NULL);
+
+    const uint64_t  now    = now_usec();
+    shm_record_t   *vacant = NULL;
+    shm_record_t   *oldest = NULL;
+    size_t          idx;
+
+    idx = ib_hashfunc_djb2((const char *)key_data, key_length, 0, NULL)
+        % store->server.num_buckets;
+
+    for (size_t probe = 0; probe < PROBE_LIMIT; ++probe) {
+        shm_record_t *rec =
+            record_at(store, (idx + probe) % store->server.num_buckets);
+
+        if (
+            (rec->seq & 1) ||
+            rec->key_length == 0 ||
+            (rec->expiration != 0 && rec->expiration <= now)
+        ) {
+            if (vacant == NULL) {
+                vacant = rec;
+            }
+            continue;
+        }
+
+        if (
+            rec->key_length == key_length &&
+            memcmp(rec->key, key_data, key_length) == 0
+        ) {
+            return rec;
+        }
+
+        if (oldest == NULL || rec->creation < oldest->creation) {
+            oldest = rec;
+        }
+    }
+
+    return (vacant != NULL) ? vacant : oldest;
+}
+
+/**
+ * Begin mutating @a rec, leaving its seq counter odd.
+ *
+ * @returns The counter value to pass to record_write_end().
+ */
+static uint32_t record_write_begin(shm_record_t *rec)
+{
+    /* Or-ing with 1 also repairs a counter a crashed writer left odd. */
+    uint32_t seq = rec->seq | 1;
+
+    rec->seq = seq;
+    __sync_synchronize();
+
+    return seq;
+}
+
+/**
+ * Publish a mutation begun with record_write_begin().
+ */
+static void record_write_end(shm_record_t *rec, uint32_t seq)
+{
+    __sync_synchronize();
+    rec->seq = seq + 1;
+}
+
+/**
+ * Map the segment, rebuilding the bucket table if it is not usable.
+ *
+ * Setup runs under the backing file's lock so only one process builds
+ * the table. The header's initialized flag is written last, so a
+ * segment a crashed process left half-built fails validation and is
+ * rebuilt here.
+ */
+static ib_status_t kvconnect(
+    ib_kvstore_t        *kvstore,
+    ib_kvstore_cbdata_t *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    shm_store_t  *store = (shm_store_t *)kvstore->server;
+    shm_header_t *header;
+    struct stat   sb;
+    void         *segment;
+    int           fd;
+
+    if (store->server.segment != NULL) {
+        return IB_OK;
+    }
+
+    fd = open(store->server.file, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return IB_EOTHER;
+    }
+
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return IB_EOTHER;
+    }
+
+    if (fstat(fd, &sb) != 0) {
+        goto fail;
+    }
+    if (
+        (size_t)sb.st_size != store->server.segment_size &&
+        ftruncate(fd, store->server.segment_size) != 0
+    ) {
+        goto fail;
+    }
+
+    segment = mmap(
+        NULL,
+        store->server.segment_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        fd,
+        0);
+    if (segment == MAP_FAILED) {
+        goto fail;
+    }
+
+    header = (shm_header_t *)segment;
+    if (
+        header->magic != SEGMENT_MAGIC ||
+        header->version != SEGMENT_VERSION ||
+        header->num_buckets != store->server.num_buckets ||
+        header->data_size != store->server.data_size ||
+        header->initialized != 1
+    ) {
+        memset(segment, 0, store->server.segment_size);
+        header->magic       = SEGMENT_MAGIC;
+        header->version     = SEGMENT_VERSION;
+        header->num_buckets = store->server.num_buckets;
+        header->data_size   = store->server.data_size;
+        __sync_synchronize();
+        header->initialized = 1;
+    }
+
+    flock(fd, LOCK_UN);
+
+    store->server.fd      = fd;
+    store->server.segment = segment;
+
+    return IB_OK;
+
+fail:
+    flock(fd, LOCK_UN);
+    close(fd);
+    return IB_EOTHER;
+}
+
+/**
+ * Unmap the segment. The backing file, and so the data, persists.
+ */
+static ib_status_t kvdisconnect(
+    ib_kvstore_t        *kvstore,
+    ib_kvstore_cbdata_t *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    shm_store_t *store = (shm_store_t *)kvstore->server;
+
+    if (store->server.segment != NULL) {
+        munmap(store->server.segment, store->server.segment_size);
+        close(store->server.fd);
+        store->server.segment = NULL;
+        store->server.fd      = -1;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Look up @a key without taking any lock.
+ *
+ * A key maps to one bucket, so at most one value is returned and the
+ * merge policy never runs.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    shm_store_t   *store = (shm_store_t *)kvstore->server;
+    const uint8_t *key_data;
+    size_t         key_length;
+    size_t         idx;
+
+    if (store->server.segment == NULL) {
+        return IB_EOTHER;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    idx = ib_hashfunc_djb2((const char *)key_data, key_length, 0, NULL)
+        % store->server.num_buckets;
+
+    for (size_t probe = 0; probe < PROBE_LIMIT; ++probe) {
+        const shm_record_t *rec =
+            record_at(store, (idx + probe) % store->server.num_buckets);
+        ib_kvstore_value_t *value = NULL;
+        ib_status_t         rc;
+
+        rc = record_read(store, rec, mm, key, &value);
+        if (rc == IB_ENOENT) {
+            continue;
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        *values = (ib_kvstore_value_t **)ib_mm_alloc(mm, sizeof(**values));
+        if (*values == NULL) {
+            return IB_EALLOC;
+        }
+        (*values)[0]   = value;
+        *values_length = 1;
+
+        return IB_OK;
+    }
+
+    return IB_ENOENT;
+}
+
+/**
+ * Write @a value under @a key, replacing any previous record.
+ *
+ * A relative expiration in @a value is converted to the absolute
+ * expiry time stored in the record.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    shm_store_t   *store = (shm_store_t *)kvstore->server;
+    const uint8_t *key_data;
+    size_t         key_length;
+    const uint8_t *value_data;
+    size_t         value_length;
+    const char    *type;
+    size_t         type_length;
+    ib_time_t      expiration;
+    uint64_t       now;
+    shm_record_t  *rec;
+    uint32_t       seq;
+    ib_status_t    rc;
+
+    if (store->server.segment == NULL) {
+        return IB_EOTHER;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_kvstore_value_value_get(value, &value_data, &value_length);
+    ib_kvstore_value_type_get(value, &type, &type_length);
+    expiration = ib_kvstore_value_expiration_get(value);
+
+    if (
+        key_length == 0 ||
+        key_length > IB_KVSTORE_SHM_MAX_KEY ||
+        type_length > IB_KVSTORE_SHM_MAX_TYPE ||
+        value_length > store->server.data_size
+    ) {
+        return IB_EINVAL;
+    }
+
+    rc = write_lock(store);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    now = now_usec();
+    rec = record_for_write(store, key_data, key_length);
+
+    seq = record_write_begin(rec);
+    rec->key_length   = key_length;
+    rec->type_length  = type_length;
+    rec->value_length = value_length;
+    rec->expiration   = (expiration != 0) ? now + expiration : 0;
+    rec->creation     = now;
+    memcpy(rec->key, key_data, key_length);
+    memcpy(rec->type, type, type_length);
+    memcpy(rec->data, value_data, value_length);
+    record_write_end(rec, seq);
+
+    write_unlock(store);
+
+    return IB_OK;
+}
+
+/**
+ * Remove the record stored under @a key, if any.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    shm_store_t   *store = (shm_store_t *)kvstore->server;
+    const uint8_t *key_data;
+    size_t         key_length;
+    size_t         idx;
+    ib_status_t    rc;
+
+    if (store->server.segment == NULL) {
+        return IB_EOTHER;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    idx = ib_hashfunc_djb2((const char *)key_data, key_length, 0, NULL)
+        % store->server.num_buckets;
+
+    rc = write_lock(store);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = IB_ENOENT;
+    for (size_t probe = 0; probe < PROBE_LIMIT; ++probe) {
+        shm_record_t *rec =
+            record_at(store, (idx + probe) % store->server.num_buckets);
+
+        if (
+            !(rec->seq & 1) &&
+            rec->key_length == key_length &&
+            memcmp(rec->key, key_data, key_length) == 0
+        ) {
+            uint32_t seq = record_write_begin(rec);
+            rec->key_length = 0;
+            record_write_end(rec, seq);
+            rc = IB_OK;
+            break;
+        }
+    }
+
+    write_unlock(store);
+
+    return rc;
+}
+
+/**
+ * A key holds at most one value, so merging only picks the first.
+ */
+static ib_status_t kvstore_shm_merge_policy(
+    ib_kvstore_t            *kvstore,
+    const ib_kvstore_key_t  *key,
+    ib_kvstore_value_t     **values,
+    size_t                   value_size,
+    ib_kvstore_value_t     **resultant_value,
+    ib_kvstore_cbdata_t     *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(values != NULL);
+
+    if (value_size > 0) {
+        *resultant_value = values[0];
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Release process-local state. The segment's backing file persists.
+ */
+static void kvdestroy(
+    ib_kvstore_t        *kvstore,
+    ib_kvstore_cbdata_t *cbdata
+)
+{
+    assert(kvstore != NULL);
+
+    shm_store_t *store = (shm_store_t *)kvstore->server;
+
+    if (store != NULL) {
+        kvdisconnect(kvstore, NULL);
+        ib_lock_destroy_malloc(store->thread_lock);
+        free((void *)store->server.file);
+        free(store);
+        kvstore->server = NULL;
+    }
+}
+
+ib_status_t ib_kvstore_shm_init(
+    ib_kvstore_t *kvstore,
+    const char   *file,
+    size_t        num_buckets,
+    size_t        data_size)
+{
+    assert(kvstore != NULL);
+    assert(file != NULL);
+
+    shm_store_t *store;
+    ib_status_t  rc;
+
+    if (num_buckets == 0 || data_size == 0) {
+        return IB_EINVAL;
+    }
+
+    /* There is no callback data used for this implementation. */
+    ib_kvstore_init(kvstore);
+
+    store = calloc(1, sizeof(*store));
+    if (store == NULL) {
+        return IB_EALLOC;
+    }
+
+    store->server.file = strdup(file);
+    if (store->server.file == NULL) {
+        free(store);
+        return IB_EALLOC;
+    }
+
+    rc = ib_lock_create_malloc(&store->thread_lock);
+    if (rc != IB_OK) {
+        free((void *)store->server.file);
+        free(store);
+        return rc;
+    }
+
+    store->record_size         = record_stride(data_size);
+    store->server.num_buckets  = num_buckets;
+    store->server.data_size    = data_size;
+    store->server.segment_size =
+        sizeof(shm_header_t) + num_buckets * store->record_size;
+    store->server.fd           = -1;
+    store->server.segment      = NULL;
+
+    kvstore->server = (ib_kvstore_server_t *)store;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+    kvstore->default_merge_policy = kvstore_shm_merge_policy;
+
+    kvstore->malloc_cbdata = NULL;
+    kvstore->free_cbdata = NULL;
+    kvstore->connect_cbdata = NULL;
+    kvstore->disconnect_cbdata = NULL;
+    kvstore->get_cbdata = NULL;
+    kvstore->set_cbdata = NULL;
+    kvstore->remove_cbdata = NULL;
+    kvstore->merge_policy_cbdata = NULL;
+    kvstore->destroy_cbdata = NULL;
+
+    return IB_OK;
+}
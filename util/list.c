@@ -31,6 +31,70 @@
 
 #include <assert.h>
 
+/**
+ * Number of nodes allocated per node block.
+ *
+ * Nodes are carved out of blocks allocated several at a time so that
+ * consecutive insertions land on the same cache lines, and removed nodes
+ * are recycled through a per-list free list instead of being abandoned to
+ * the memory manager.
+ */
+#define IB_LIST_NODE_BLOCK_SIZE 8
+
+/**
+ * Acquire a zeroed node for @a list.
+ *
+ * Pops a recycled node off the free list if one is available, otherwise
+ * allocates a block of @ref IB_LIST_NODE_BLOCK_SIZE nodes, returns the
+ * first and chains the remainder onto the free list.
+ *
+ * @param list List the node will belong to
+ *
+ * @returns Node or NULL on allocation failure.
+ */
+static ib_list_node_t *ib_list_node_acquire(ib_list_t *list)
+{
+    ib_list_node_t *node;
+
+    if (list->free_nodes != NULL) {
+        node = list->free_nodes;
+        list->free_nodes = node->next;
+        node->next = NULL;
+        node->prev = NULL;
+        node->data = NULL;
+        return node;
+    }
+
+    node = (ib_list_node_t *)ib_mm_calloc(list->mm,
+        IB_LIST_NODE_BLOCK_SIZE, sizeof(*node)
+    );
+    if (node == NULL) {
+        return NULL;
+    }
+
+    /* Chain the spare nodes so they are handed out in address order. */
+    for (size_t i = IB_LIST_NODE_BLOCK_SIZE - 1; i > 0; --i) {
+        node[i].next = list->free_nodes;
+        list->free_nodes = &node[i];
+    }
+
+    return node;
+}
+
+/**
+ * Return a node removed from @a list to the free list.
+ *
+ * @param list List the node belonged to
+ * @param node Node to recycle
+ */
+static void ib_list_node_release(ib_list_t *list, ib_list_node_t *node)
+{
+    node->data = NULL;
+    node->prev = NULL;
+    node->next = list->free_nodes;
+    list->free_nodes = node;
+}
+
 ib_status_t ib_list_create(ib_list_t **plist, ib_mm_t mm)
 {
     /* Create the structure. */
@@ -89,9 +153,7 @@ ib_status_t ib_list_copy(const ib_list_t *src,
 
 ib_status_t ib_list_push(ib_list_t *list, void *data)
 {
-    ib_list_node_t *node = (ib_list_node_t *)ib_mm_calloc(list->mm,
-        1, sizeof(*node)
-    );
+    ib_list_node_t *node = ib_list_node_acquire(list);
     if (node == NULL) {
         return IB_EALLOC;
     }
@@ -119,16 +181,18 @@ ib_status_t ib_list_pop(ib_list_t *list, void *pdata)
     if (pdata != NULL) {
         *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->tail);
     }
-    IB_LIST_GEN_NODE_REMOVE_LAST(list);
+    {
+        ib_list_node_t *node = list->tail;
+        IB_LIST_GEN_NODE_REMOVE_LAST(list);
+        ib_list_node_release(list, node);
+    }
 
     return IB_OK;
 }
 
 ib_status_t ib_list_unshift(ib_list_t *list, void *data)
 {
-    ib_list_node_t *node = (ib_list_node_t *)ib_mm_calloc(list->mm,
-        1, sizeof(*node)
-    );
+    ib_list_node_t *node = ib_list_node_acquire(list);
     if (node == NULL) {
         return IB_EALLOC;
     }
@@ -156,13 +220,26 @@ ib_status_t ib_list_shift(ib_list_t *list, void *pdata)
     if (pdata != NULL) {
         *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->head);
     }
-    IB_LIST_GEN_NODE_REMOVE_FIRST(list);
+    {
+        ib_list_node_t *node = list->head;
+        IB_LIST_GEN_NODE_REMOVE_FIRST(list);
+        ib_list_node_release(list, node);
+    }
 
     return IB_OK;
 }
 
 void ib_list_clear(ib_list_t *list)
 {
+    ib_list_node_t *node = list->head;
+
+    /* Recycle the nodes; the elements themselves are untouched. */
+    while (node != NULL) {
+        ib_list_node_t *next = node->next;
+        ib_list_node_release(list, node);
+        node = next;
+    }
+
     list->nelts = 0;
     list->head = list->tail = NULL;
     return;
@@ -216,6 +293,7 @@ const ib_list_node_t *ib_list_node_prev_const(const ib_list_node_t *node)
 void ib_list_node_remove(ib_list_t *list, ib_list_node_t *node)
 {
     IB_LIST_GEN_NODE_REMOVE(list, node);
+    ib_list_node_release(list, node);
     return;
 }
 
@@ -239,6 +317,38 @@ void ib_list_node_data_set(
     node->data = data;
 }
 
+ib_status_t ib_list_to_array(
+    const ib_list_t   *list,
+    ib_mm_t            mm,
+    void            ***parray
+)
+{
+    assert(list != NULL);
+    assert(parray != NULL);
+
+    void                 **array;
+    const ib_list_node_t  *node;
+    size_t                 i = 0;
+
+    if (list->nelts == 0) {
+        *parray = NULL;
+        return IB_OK;
+    }
+
+    array = (void **)ib_mm_alloc(mm, list->nelts * sizeof(*array));
+    if (array == NULL) {
+        return IB_EALLOC;
+    }
+
+    IB_LIST_LOOP_CONST(list, node) {
+        array[i] = (void *)ib_list_node_data_const(node);
+        ++i;
+    }
+
+    *parray = array;
+    return IB_OK;
+}
+
 ib_status_t ib_list_insert(ib_list_t *list, void *data, const size_t index)
 {
     assert(list != NULL);
@@ -251,8 +361,7 @@ ib_status_t ib_list_insert(ib_list_t *list, void *data, const size_t index)
     }
 
     /* Create the new node. */
-    insert_node =
-        (ib_list_node_t *)ib_mm_calloc(list->mm, 1, sizeof(*insert_node));
+    insert_node = ib_list_node_acquire(list);
     if (insert_node == NULL) {
         return IB_EALLOC;
     }
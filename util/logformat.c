@@ -147,6 +147,67 @@ static ib_status_t create_item_field(ib_logformat_t *lf,
     return IB_OK;
 }
 
+/**
+ * Compile the parsed item list into a contiguous array.
+ *
+ * Resolves each literal's short/long string representation to a plain
+ * pointer and length once, so that ib_logformat_format() renders with a
+ * simple memcpy() per literal instead of re-inspecting the union and
+ * walking list nodes for every line.
+ *
+ * @param[in,out] lf Logformat helper with a fully parsed item list
+ *
+ * @returns Status code
+ */
+static ib_status_t compile_items(ib_logformat_t *lf)
+{
+    assert(lf != NULL);
+
+    ib_logformat_citem_t *citems;
+    const ib_list_node_t *node;
+    size_t num_items = ib_list_elements(lf->items);
+    size_t i = 0;
+
+    citems = (ib_logformat_citem_t *)
+        ib_mm_calloc(lf->mm, num_items, sizeof(*citems));
+    if (citems == NULL) {
+        return IB_EALLOC;
+    }
+
+    IB_LIST_LOOP_CONST(lf->items, node) {
+        const ib_logformat_item_t *item =
+            (const ib_logformat_item_t *)ib_list_node_data_const(node);
+        ib_logformat_citem_t *citem = &citems[i];
+
+        citem->itype = item->itype;
+        switch (item->itype) {
+        case item_type_literal:
+            citem->literal_len = item->item.literal.len;
+            if (citem->literal_len <= IB_LOGFORMAT_MAX_SHORT_LITERAL) {
+                citem->literal = item->item.literal.buf.short_str;
+            }
+            else {
+                citem->literal = item->item.literal.buf.str;
+            }
+            break;
+
+        case item_type_format:
+            citem->field = item->item.field;
+            break;
+
+        default:
+            assert(0);
+            return IB_EINVAL;
+        }
+        ++i;
+    }
+
+    lf->citems = citems;
+    lf->num_items = num_items;
+
+    return IB_OK;
+}
+
 ib_status_t ib_logformat_parse(ib_logformat_t *lf,
                                const char *format)
 {
@@ -264,6 +325,11 @@ ib_status_t ib_logformat_parse(ib_logformat_t *lf,
 
     /* Add any literal string we might be in the middle of */
     rc = create_item_literal(lf, literal_buf, literal_cur);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    rc = compile_items(lf);
 
 cleanup:
     if (literal_buf != NULL) {
@@ -285,30 +351,24 @@ ib_status_t ib_logformat_format(const ib_logformat_t *lf,
     assert(fn != NULL);
 
     ib_status_t rc;
-    const ib_list_node_t *node;
     size_t line_remain = line_size - 1;
     char *line_cur = line;
     bool truncated = false;
+    size_t i;
 
-    IB_LIST_LOOP_CONST(lf->items, node) {
-        const ib_logformat_item_t *item =
-            (const ib_logformat_item_t *)ib_list_node_data_const(node);
+    for (i = 0; i < lf->num_items; ++i) {
+        const ib_logformat_citem_t *citem = &lf->citems[i];
         const char *str;
         size_t len;
 
-        switch (item->itype) {
+        switch (citem->itype) {
         case item_type_literal:
-            len = item->item.literal.len;
-            if (len <= IB_LOGFORMAT_MAX_SHORT_LITERAL) {
-                str = item->item.literal.buf.short_str;
-            }
-            else {
-                str = item->item.literal.buf.str;
-            }
+            str = citem->literal;
+            len = citem->literal_len;
             break;
 
         case item_type_format:
-            rc = fn(lf, &(item->item.field), fndata, &str);
+            rc = fn(lf, &citem->field, fndata, &str);
             if (rc != IB_OK) {
                 return rc;
             }
@@ -321,11 +381,11 @@ ib_status_t ib_logformat_format(const ib_logformat_t *lf,
         }
 
         /* Copy into buffer */
-        strncpy(line_cur, str, line_remain);
         if (len > line_remain) {
             len = line_remain;
             truncated = true;
         }
+        memcpy(line_cur, str, len);
         line_cur += len;
         line_remain -= len;
 
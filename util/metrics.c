@@ -0,0 +1,298 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Runtime Metrics Registry Implementation
+ *
+ * See @ref IronBeeUtilMetrics for details.
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ * @nosubgrouping
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/metrics.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** A registered metric. */
+struct ib_metric_t {
+    const char      *name;   /**< Metric name. Not owned. */
+    ib_metric_type_t type;   /**< The kind of metric. */
+    size_t           offset; /**< First cell index in each thread block. */
+};
+
+/**
+ * Per-thread cell block. Registered globally; never freed.
+ *
+ * Counters and gauges use one cell each; histograms use
+ * #IB_METRICS_HIST_BUCKETS consecutive cells. Cell offsets are fixed
+ * at registration time, so blocks created before and after a
+ * registration index identically.
+ */
+typedef struct cells_t cells_t;
+struct cells_t {
+    uint64_t cells[IB_METRICS_MAX_CELLS]; /**< Metric cells. */
+    cells_t *next;                        /**< Next registered block. */
+};
+
+/** The calling thread's cell block; lazily created. */
+static __thread cells_t *s_cells = NULL;
+
+/** All registered cell blocks, for reporting. Guarded by s_lock. */
+static cells_t *s_all_cells = NULL;
+
+/** Registered metrics. Guarded by s_lock; read lock-free after
+ *  acquisition since entries are never changed or removed. */
+static ib_metric_t s_metrics[IB_METRICS_MAX_METRICS];
+
+/** Number of registered metrics. Guarded by s_lock. */
+static size_t s_num_metrics = 0;
+
+/** Cells handed out so far. Cell 0 is the sink. Guarded by s_lock. */
+static size_t s_num_cells = 1;
+
+/**
+ * The metric returned when registration cannot be satisfied.
+ *
+ * Its cell is the reserved cell 0, so updates through it are accepted
+ * and discarded without any branch in the update paths.
+ */
+static const ib_metric_t s_sink_metric = { "", IB_METRIC_COUNTER, 0 };
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Fetch the calling thread's cell block, creating and registering it
+ * if needed.
+ *
+ * @returns The block or NULL on allocation failure.
+ */
+static cells_t *cells_get(void)
+{
+    cells_t *cells = s_cells;
+
+    if (cells == NULL) {
+        /* Allocated with calloc, not a memory manager: the block must
+         * outlive every pool and engine that updates metrics. */
+        cells = calloc(1, sizeof(*cells));
+        if (cells == NULL) {
+            return NULL;
+        }
+        pthread_mutex_lock(&s_lock);
+        cells->next = s_all_cells;
+        s_all_cells = cells;
+        pthread_mutex_unlock(&s_lock);
+        s_cells = cells;
+    }
+
+    return cells;
+}
+
+const ib_metric_t *ib_metric_acquire(
+    const char       *name,
+    ib_metric_type_t  type
+)
+{
+    assert(name != NULL);
+
+    ib_metric_t *metric = NULL;
+    size_t       width;
+    size_t       i;
+
+    width = (type == IB_METRIC_HISTOGRAM) ? IB_METRICS_HIST_BUCKETS : 1;
+
+    pthread_mutex_lock(&s_lock);
+
+    for (i = 0; i < s_num_metrics; ++i) {
+        if (strcmp(s_metrics[i].name, name) == 0) {
+            metric = &s_metrics[i];
+            break;
+        }
+    }
+
+    if (metric == NULL) {
+        if (
+            (s_num_metrics >= IB_METRICS_MAX_METRICS) ||
+            (s_num_cells + width > IB_METRICS_MAX_CELLS)
+        )
+        {
+            pthread_mutex_unlock(&s_lock);
+            return &s_sink_metric;
+        }
+        metric         = &s_metrics[s_num_metrics];
+        metric->name   = name;
+        metric->type   = type;
+        metric->offset = s_num_cells;
+        s_num_cells   += width;
+        ++s_num_metrics;
+    }
+
+    pthread_mutex_unlock(&s_lock);
+
+    if (metric->type != type) {
+        return &s_sink_metric;
+    }
+
+    return metric;
+}
+
+void ib_metric_add(const ib_metric_t *metric, uint64_t n)
+{
+    assert(metric != NULL);
+
+    cells_t *cells = cells_get();
+
+    if (cells != NULL) {
+        cells->cells[metric->offset] += n;
+    }
+}
+
+void ib_metric_max(const ib_metric_t *metric, uint64_t value)
+{
+    assert(metric != NULL);
+
+    cells_t *cells = cells_get();
+
+    if ( (cells != NULL) && (value > cells->cells[metric->offset]) ) {
+        cells->cells[metric->offset] = value;
+    }
+}
+
+void ib_metric_record(const ib_metric_t *metric, uint64_t value)
+{
+    assert(metric != NULL);
+
+    cells_t *cells = cells_get();
+    size_t   bucket = 0;
+
+    if (cells == NULL) {
+        return;
+    }
+
+    /* Bucket n counts values below 2^n. */
+    if (value != 0) {
+        bucket = 64 - __builtin_clzll(value);
+        if (bucket > IB_METRICS_HIST_BUCKETS - 1) {
+            bucket = IB_METRICS_HIST_BUCKETS - 1;
+        }
+    }
+
+    cells->cells[metric->offset + bucket] += 1;
+}
+
+ib_status_t ib_metrics_report(ib_mm_t mm, const char **report)
+{
+    assert(report != NULL);
+
+    const cells_t *cells;
+    uint64_t       merged[IB_METRICS_MAX_CELLS];
+    size_t         num_metrics;
+    size_t         i;
+    char          *out;
+    size_t         out_len;
+    size_t         used = 0;
+
+    memset(merged, 0, sizeof(merged));
+
+    pthread_mutex_lock(&s_lock);
+
+    num_metrics = s_num_metrics;
+
+    for (cells = s_all_cells; cells != NULL; cells = cells->next) {
+        for (i = 0; i < IB_METRICS_MAX_CELLS; ++i) {
+            merged[i] += cells->cells[i];
+        }
+    }
+
+    /* High-water gauges take the highest mark, not the sum. */
+    for (i = 0; i < num_metrics; ++i) {
+        if (s_metrics[i].type == IB_METRIC_GAUGE_MAX) {
+            uint64_t high = 0;
+            for (cells = s_all_cells; cells != NULL; cells = cells->next) {
+                if (cells->cells[s_metrics[i].offset] > high) {
+                    high = cells->cells[s_metrics[i].offset];
+                }
+            }
+            merged[s_metrics[i].offset] = high;
+        }
+    }
+
+    pthread_mutex_unlock(&s_lock);
+
+    /* Worst case line: type, name, 20-digit bound and value. */
+    out_len = 1;
+    for (i = 0; i < num_metrics; ++i) {
+        size_t lines = (s_metrics[i].type == IB_METRIC_HISTOGRAM) ?
+            IB_METRICS_HIST_BUCKETS : 1;
+        out_len += lines * (strlen(s_metrics[i].name) + 64);
+    }
+
+    out = ib_mm_alloc(mm, out_len);
+    if (out == NULL) {
+        return IB_EALLOC;
+    }
+    *out = '\0';
+
+    for (i = 0; i < num_metrics; ++i) {
+        const ib_metric_t *metric = &s_metrics[i];
+
+        switch (metric->type) {
+        case IB_METRIC_COUNTER:
+            used += snprintf(
+                out + used, out_len - used,
+                "counter %s %" PRIu64 "\n",
+                metric->name,
+                merged[metric->offset]);
+            break;
+        case IB_METRIC_GAUGE_MAX:
+            used += snprintf(
+                out + used, out_len - used,
+                "gauge %s %" PRIu64 "\n",
+                metric->name,
+                merged[metric->offset]);
+            break;
+        case IB_METRIC_HISTOGRAM:
+        {
+            size_t bucket;
+            for (bucket = 0; bucket < IB_METRICS_HIST_BUCKETS; ++bucket) {
+                if (merged[metric->offset + bucket] == 0) {
+                    continue;
+                }
+                used += snprintf(
+                    out + used, out_len - used,
+                    "hist %s %" PRIu64 " %" PRIu64 "\n",
+                    metric->name,
+                    UINT64_C(1) << bucket,
+                    merged[metric->offset + bucket]);
+            }
+            break;
+        }
+        }
+    }
+
+    *report = out;
+
+    return IB_OK;
+}
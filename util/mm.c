@@ -29,6 +29,10 @@
 
 #include <ironbee/mm.h>
 
+#ifdef IB_MM_PROFILE
+#include <ironbee/mm_profile.h>
+#endif
+
 #include <assert.h>
 #include <string.h>
 
@@ -46,6 +50,19 @@ void *ib_mm_alloc(
 {
     assert(mm.alloc != NULL);
 
+#ifdef IB_MM_PROFILE
+    {
+        /* Sample 1 in IB_MM_PROFILE_SAMPLE_RATE allocations per thread.
+         * See mm_profile.h. */
+        static __thread unsigned s_tick = 0;
+        if (++s_tick >= IB_MM_PROFILE_SAMPLE_RATE) {
+            s_tick = 0;
+            ib_mm_profile_record(
+                __builtin_return_address(0), size, mm.alloc_data);
+        }
+    }
+#endif
+
     return mm.alloc(size, mm.alloc_data);
 }
 
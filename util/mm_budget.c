@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Memory Manager: Budget Implementation
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ * @nosubgrouping
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/mm_budget.h>
+
+#include <assert.h>
+
+struct ib_mm_budget_t {
+    ib_mm_t backing;  /**< Where allocations are drawn from. */
+    size_t  limit;    /**< Cumulative bytes allowed. */
+    size_t  used;     /**< Bytes successfully allocated. */
+    bool    exceeded; /**< An allocation has been refused. */
+};
+
+/** See @ref ib_mm_alloc_fn_t.  Do not call directly. */
+static void *ib_mm_budget_alloc(
+    size_t  size,
+    void   *cbdata
+)
+{
+    ib_mm_budget_t *budget = (ib_mm_budget_t *)cbdata;
+    void           *ptr;
+
+    if (size > budget->limit - budget->used) {
+        budget->exceeded = true;
+        return NULL;
+    }
+
+    ptr = ib_mm_alloc(budget->backing, size);
+    if (ptr != NULL) {
+        budget->used += size;
+    }
+
+    return ptr;
+}
+
+/** See @ref ib_mm_register_cleanup_fn_t.  Do not call directly. */
+static ib_status_t ib_mm_budget_register_cleanup(
+    ib_mm_cleanup_fn_t  fn,
+    void               *fndata,
+    void               *cbdata
+)
+{
+    ib_mm_budget_t *budget = (ib_mm_budget_t *)cbdata;
+
+    return ib_mm_register_cleanup(budget->backing, fn, fndata);
+}
+
+ib_status_t ib_mm_budget_create(
+    ib_mm_budget_t **budget,
+    ib_mm_t          backing,
+    size_t           limit
+)
+{
+    assert(budget != NULL);
+
+    ib_mm_budget_t *tmp;
+
+    /* The budget itself is not counted against the limit. */
+    tmp = (ib_mm_budget_t *)ib_mm_alloc(backing, sizeof(*tmp));
+    if (tmp == NULL) {
+        return IB_EALLOC;
+    }
+
+    tmp->backing  = backing;
+    tmp->limit    = limit;
+    tmp->used     = 0;
+    tmp->exceeded = false;
+
+    *budget = tmp;
+    return IB_OK;
+}
+
+ib_mm_t ib_mm_budget_mm(ib_mm_budget_t *budget)
+{
+    assert(budget != NULL);
+
+    ib_mm_t mm = {
+        &ib_mm_budget_alloc, budget,
+        &ib_mm_budget_register_cleanup, budget
+    };
+    return mm;
+}
+
+size_t ib_mm_budget_used(const ib_mm_budget_t *budget)
+{
+    assert(budget != NULL);
+
+    return budget->used;
+}
+
+size_t ib_mm_budget_limit(const ib_mm_budget_t *budget)
+{
+    assert(budget != NULL);
+
+    return budget->limit;
+}
+
+bool ib_mm_budget_exceeded(const ib_mm_budget_t *budget)
+{
+    assert(budget != NULL);
+
+    return budget->exceeded;
+}
@@ -0,0 +1,285 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Memory Manager Allocation Profiler Implementation
+ *
+ * See @ref IronBeeUtilMMProfile for details.
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ * @nosubgrouping
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/mm_profile.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Recently seen pools tracked per call site. */
+#define POOL_RING_SIZE 4
+
+/** Give up probing after this many slots; count the sample as dropped. */
+#define MAX_PROBES 16
+
+/** One call site in a thread table. */
+typedef struct site_t {
+    const void *caller;                /**< Call site; NULL = free slot. */
+    uint64_t    samples;               /**< Sampled allocations. */
+    uint64_t    bytes;                 /**< Sampled bytes. */
+    uint8_t     pools;                 /**< Distinct pools, capped at 255. */
+    uint8_t     pool_next;             /**< Next ring slot to replace. */
+    const void *pool_ring[POOL_RING_SIZE]; /**< Recently seen pools. */
+} site_t;
+
+/** Per-thread sample table.  Registered globally; never freed. */
+typedef struct table_t table_t;
+struct table_t {
+    site_t    sites[IB_MM_PROFILE_TABLE_SIZE];
+    uint64_t  dropped;                 /**< Samples lost to full table. */
+    table_t  *next;                    /**< Next registered table. */
+};
+
+/** The calling thread's table; lazily created. */
+static __thread table_t *s_table = NULL;
+
+/** All registered tables, for reporting.  Guarded by s_lock. */
+static table_t *s_tables = NULL;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+bool ib_mm_profile_enabled(void)
+{
+#ifdef IB_MM_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Fetch the calling thread's table, creating and registering it if
+ * needed.
+ *
+ * @returns The table or NULL on allocation failure.
+ */
+static table_t *table_get(void)
+{
+    table_t *table = s_table;
+
+    if (table == NULL) {
+        /* Allocated with calloc, not a memory manager: the table must
+         * outlive any pool and its allocation must not recurse into
+         * ib_mm_alloc(). */
+        table = calloc(1, sizeof(*table));
+        if (table == NULL) {
+            return NULL;
+        }
+        pthread_mutex_lock(&s_lock);
+        table->next = s_tables;
+        s_tables = table;
+        pthread_mutex_unlock(&s_lock);
+        s_table = table;
+    }
+
+    return table;
+}
+
+void ib_mm_profile_record(
+    const void *caller,
+    size_t      size,
+    const void *pool
+)
+{
+    assert(caller != NULL);
+
+    table_t *table = table_get();
+    site_t  *site  = NULL;
+    size_t   index;
+    int      probe;
+    int      i;
+
+    if (table == NULL) {
+        return;
+    }
+
+    /* Open addressing with linear probing.  Only this thread writes
+     * the table, so no synchronization is needed. */
+    index = ((uintptr_t)caller >> 4) * 2654435761UL
+            % IB_MM_PROFILE_TABLE_SIZE;
+    for (probe = 0; probe < MAX_PROBES; ++probe) {
+        site_t *candidate =
+            &table->sites[(index + probe) % IB_MM_PROFILE_TABLE_SIZE];
+        if (candidate->caller == caller || candidate->caller == NULL) {
+            site = candidate;
+            break;
+        }
+    }
+    if (site == NULL) {
+        ++table->dropped;
+        return;
+    }
+
+    site->caller = caller;
+    ++site->samples;
+    site->bytes += size;
+
+    for (i = 0; i < POOL_RING_SIZE; ++i) {
+        if (site->pool_ring[i] == pool) {
+            return;
+        }
+    }
+    if (site->pools < UINT8_MAX) {
+        ++site->pools;
+    }
+    site->pool_ring[site->pool_next] = pool;
+    site->pool_next = (site->pool_next + 1) % POOL_RING_SIZE;
+}
+
+/** Aggregated call site, merged across thread tables. */
+typedef struct merged_t {
+    const void *caller;
+    uint64_t    samples;
+    uint64_t    bytes;
+    unsigned    pools;
+} merged_t;
+
+/** qsort comparator: descending sampled bytes. */
+static int merged_cmp(const void *lhs, const void *rhs)
+{
+    const merged_t *l = (const merged_t *)lhs;
+    const merged_t *r = (const merged_t *)rhs;
+
+    if (l->bytes > r->bytes) {
+        return -1;
+    }
+    if (l->bytes < r->bytes) {
+        return 1;
+    }
+    return 0;
+}
+
+ib_status_t ib_mm_profile_report(ib_mm_t mm, const char **report)
+{
+    assert(report != NULL);
+
+    const table_t *table;
+    merged_t      *merged;
+    size_t         num_merged = 0;
+    size_t         capacity   = 0;
+    uint64_t       dropped    = 0;
+    size_t         i;
+    char          *out;
+    size_t         out_len;
+    size_t         used = 0;
+
+    pthread_mutex_lock(&s_lock);
+
+    for (table = s_tables; table != NULL; table = table->next) {
+        capacity += IB_MM_PROFILE_TABLE_SIZE;
+    }
+    if (capacity == 0) {
+        pthread_mutex_unlock(&s_lock);
+        *report = "";
+        return IB_OK;
+    }
+
+    merged = malloc(capacity * sizeof(*merged));
+    if (merged == NULL) {
+        pthread_mutex_unlock(&s_lock);
+        return IB_EALLOC;
+    }
+
+    for (table = s_tables; table != NULL; table = table->next) {
+        dropped += table->dropped;
+        for (i = 0; i < IB_MM_PROFILE_TABLE_SIZE; ++i) {
+            const site_t *site = &table->sites[i];
+            size_t        j;
+            if (site->caller == NULL) {
+                continue;
+            }
+            for (j = 0; j < num_merged; ++j) {
+                if (merged[j].caller == site->caller) {
+                    break;
+                }
+            }
+            if (j == num_merged) {
+                merged[j].caller  = site->caller;
+                merged[j].samples = 0;
+                merged[j].bytes   = 0;
+                merged[j].pools   = 0;
+                ++num_merged;
+            }
+            merged[j].samples += site->samples;
+            merged[j].bytes   += site->bytes;
+            merged[j].pools   += site->pools;
+        }
+    }
+
+    pthread_mutex_unlock(&s_lock);
+
+    qsort(merged, num_merged, sizeof(*merged), merged_cmp);
+
+    /* Worst case line: pointer, two 20-digit counters, pool count. */
+    out_len = (num_merged + 2) * 80;
+    out = ib_mm_alloc(mm, out_len);
+    if (out == NULL) {
+        free(merged);
+        return IB_EALLOC;
+    }
+
+    for (i = 0; i < num_merged; ++i) {
+        used += snprintf(
+            out + used, out_len - used,
+            "%p %" PRIu64 " %" PRIu64 " %u\n",
+            merged[i].caller,
+            merged[i].samples,
+            merged[i].bytes,
+            merged[i].pools > UINT8_MAX ? UINT8_MAX : merged[i].pools
+        );
+    }
+    if (dropped > 0) {
+        used += snprintf(
+            out + used, out_len - used,
+            "(dropped) %" PRIu64 "\n",
+            dropped
+        );
+    }
+    out[used < out_len ? used : out_len - 1] = '\0';
+
+    free(merged);
+
+    *report = out;
+    return IB_OK;
+}
+
+void ib_mm_profile_reset(void)
+{
+    table_t *table;
+
+    pthread_mutex_lock(&s_lock);
+    for (table = s_tables; table != NULL; table = table->next) {
+        memset(table->sites, 0, sizeof(table->sites));
+        table->dropped = 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
@@ -34,6 +34,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /**
  * Check if a character is a valid hex character
  *
@@ -52,31 +56,61 @@
 /** ASCII code for a non-breaking space. */
 #define NBSP 160
 
+/** Hex digit values per byte; 0xff marks non-hex bytes. */
+static const uint8_t c_hex_value[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
 /**
- * Convert a 2-character string from hex to a digit.
+ * Find the next byte the URL decoder must act on ('%' or '+').
  *
- * Converts the two chars @a ptr given as its hexadecimal representation
- * into a proper byte. Handles uppercase and lowercase letters
- * but does not check for overflows.
+ * Scans 16 bytes at a time with SSE2 when available so that runs of
+ * clean bytes (the common case for inspected values) cost a couple of
+ * vector compares rather than a branch per character.
  *
- * @param[in] ptr Pointer to input
+ * @param[in] in Start of data.
+ * @param[in] end End of data.
  *
- * @returns The digit
+ * @returns Pointer to the first '%' or '+' in [in, end) or @a end.
  */
-static uint8_t x2c(const uint8_t *ptr)
+static const uint8_t *url_decode_scan(const uint8_t *in, const uint8_t *end)
 {
-    uint8_t digit;
-    uint8_t c;
-
-    c = *(ptr + 0);
-    digit = ( (c >= 'A') ? ((c & 0xdf) - 'A') + 10 : (c - '0') );
-
-    digit *= 16;
-
-    c = *(ptr + 1);
-    digit += ( (c >= 'A') ? ((c & 0xdf) - 'A') + 10 : (c - '0') );
-
-    return digit;
+#if defined(__SSE2__)
+    const __m128i pct  = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+
+    while (in + 16 <= end) {
+        __m128i block = _mm_loadu_si128((const __m128i *)in);
+        __m128i hits  = _mm_or_si128(
+            _mm_cmpeq_epi8(block, pct),
+            _mm_cmpeq_epi8(block, plus)
+        );
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return in + __builtin_ctz(mask);
+        }
+        in += 16;
+    }
+#endif
+    while (in < end && *in != '%' && *in != '+') {
+        ++in;
+    }
+    return in;
 }
 
 ib_status_t ib_util_decode_url(
@@ -95,17 +129,29 @@ ib_status_t ib_util_decode_url(
     const uint8_t *end = data_in + dlen_in;
 
     while (in < end) {
+        /* Bulk-copy the run of bytes that decode to themselves. */
+        const uint8_t *run_end = url_decode_scan(in, end);
+        if (run_end != in) {
+            if (out != in) {
+                memmove(out, in, run_end - in);
+            }
+            out += run_end - in;
+            in   = run_end;
+            if (in >= end) {
+                break;
+            }
+        }
         if (*in == '%') {
             /* Character is a percent sign. */
 
             /* Are there enough bytes available? */
             if (in + 2 < end) {
-                char c1 = *(in + 1);
-                char c2 = *(in + 2);
+                uint8_t v1 = c_hex_value[*(in + 1)];
+                uint8_t v2 = c_hex_value[*(in + 2)];
 
-                if (IS_HEX_CHAR(c1) && IS_HEX_CHAR(c2)) {
+                if (v1 != 0xff && v2 != 0xff) {
                     /* Valid encoding - decode it. */
-                    *out++ = x2c(in + 1);
+                    *out++ = (uint8_t)((v1 << 4) | v2);
                     in += 3;
                 }
                 else {
@@ -131,24 +177,426 @@ ib_status_t ib_util_decode_url(
             }
         }
         else {
-            /* Character is not a percent sign. */
-            if (*in == '+') {
+            /* Only '+' survives the scan. */
+            *out++ = ' ';
+            ++in;
+        }
+    }
+    *dlen_out = (out - data_out);
+
+    return IB_OK;
+}
+
+ib_status_t ib_util_decode_url_stream(
+    ib_decode_url_state_t *state,
+    const uint8_t         *data_in,
+    size_t                 dlen_in,
+    uint8_t               *data_out,
+    size_t                *dlen_out,
+    bool                   final
+)
+{
+    assert(state != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+    assert(data_in != NULL || dlen_in == 0);
+
+    uint8_t *out = data_out;
+    const uint8_t *in  = data_in;
+    const uint8_t *end = data_in + dlen_in;
+
+    while (in < end) {
+        uint8_t c;
+
+        if (state->pending_len == 0) {
+            /* Bulk-copy the run of bytes that decode to themselves. */
+            const uint8_t *run_end = url_decode_scan(in, end);
+            if (run_end != in) {
+                memcpy(out, in, run_end - in);
+                out += run_end - in;
+                in   = run_end;
+                continue;
+            }
+
+            c = *in++;
+            if (c == '+') {
                 *out++ = ' ';
             }
-            else if (out != in) {
-                *out++ = *in;
+            else {
+                /* Start of a possible escape. */
+                state->pending[0] = '%';
+                state->pending_len = 1;
+            }
+        }
+        else if (state->pending_len == 1) {
+            c = *in;
+            if (c_hex_value[c] != 0xff) {
+                state->pending[1] = c;
+                state->pending_len = 2;
+                ++in;
             }
             else {
-                ++out;
+                /* Not a valid encoding; emit the '%' and re-examine the
+                 * byte as ordinary input. */
+                *out++ = '%';
+                state->pending_len = 0;
+            }
+        }
+        else {
+            c = *in;
+            if (c_hex_value[c] != 0xff) {
+                *out++ = (uint8_t)(
+                    (c_hex_value[state->pending[1]] << 4) | c_hex_value[c]
+                );
+                state->pending_len = 0;
+                ++in;
+            }
+            else {
+                /* As in the one-shot decoder, only the '%' is rejected;
+                 * the held digit and the current byte are re-examined. */
+                *out++ = '%';
+                *out++ = state->pending[1];
+                state->pending_len = 0;
             }
-            ++in;
         }
     }
+
+    if (final && state->pending_len > 0) {
+        /* Not enough bytes arrived; copy the raw bytes. */
+        memcpy(out, state->pending, state->pending_len);
+        out += state->pending_len;
+        state->pending_len = 0;
+    }
+
     *dlen_out = (out - data_out);
 
     return IB_OK;
 }
 
+/**
+ * Map a text HTML entity name to its byte value.
+ *
+ * @param[in]  name  NUL-terminated entity name, without the '&' or ';'.
+ * @param[out] value The decoded byte.
+ *
+ * @returns True iff @a name is a known entity.
+ */
+static bool html_entity_value(const char *name, uint8_t *value)
+{
+    /* ENH What about others? */
+    if (strcasecmp(name, "quot") == 0) {
+        *value = '"';
+    }
+    else if (strcasecmp(name, "amp") == 0) {
+        *value = '&';
+    }
+    else if (strcasecmp(name, "lt") == 0) {
+        *value = '<';
+    }
+    else if (strcasecmp(name, "gt") == 0) {
+        *value = '>';
+    }
+    else if (strcasecmp(name, "nbsp") == 0) {
+        *value = NBSP;
+    }
+
+    /* Remaining 1-byte entities. */
+    /* ENH Rewrite this to be faster lookup. */
+    else if (strcasecmp(name, "quot") == 0) {
+        *value = 0x22;
+    }
+    else if (strcasecmp(name, "iexcl") == 0) {
+        *value = 0xa1;
+    }
+    else if (strcasecmp(name, "cent") == 0) {
+        *value = 0xa2;
+    }
+    else if (strcasecmp(name, "pound") == 0) {
+        *value = 0xa3;
+    }
+    else if (strcasecmp(name, "curren") == 0) {
+        *value = 0xa4;
+    }
+    else if (strcasecmp(name, "yen") == 0) {
+        *value = 0xa5;
+    }
+    else if (strcasecmp(name, "brvbar") == 0) {
+        *value = 0xa6;
+    }
+    else if (strcasecmp(name, "sect") == 0) {
+        *value = 0xa7;
+    }
+    else if (strcasecmp(name, "uml") == 0) {
+        *value = 0xa8;
+    }
+    else if (strcasecmp(name, "copy") == 0) {
+        *value = 0xa9;
+    }
+    else if (strcasecmp(name, "ordf") == 0) {
+        *value = 0xaa;
+    }
+    else if (strcasecmp(name, "laquo") == 0) {
+        *value = 0xab;
+    }
+    else if (strcasecmp(name, "not") == 0) {
+        *value = 0xac;
+    }
+    else if (strcasecmp(name, "shy") == 0) {
+        *value = 0xad;
+    }
+    else if (strcasecmp(name, "reg") == 0) {
+        *value = 0xae;
+    }
+    else if (strcasecmp(name, "macr") == 0) {
+        *value = 0xaf;
+    }
+    else if (strcasecmp(name, "deg") == 0) {
+        *value = 0xb0;
+    }
+    else if (strcasecmp(name, "plusmn") == 0) {
+        *value = 0xb1;
+    }
+    else if (strcasecmp(name, "sup2") == 0) {
+        *value = 0xb2;
+    }
+    else if (strcasecmp(name, "sup3") == 0) {
+        *value = 0xb3;
+    }
+    else if (strcasecmp(name, "acute") == 0) {
+        *value = 0xb4;
+    }
+    else if (strcasecmp(name, "micro") == 0) {
+        *value = 0xb5;
+    }
+    else if (strcasecmp(name, "para") == 0) {
+        *value = 0xb6;
+    }
+    else if (strcasecmp(name, "middot") == 0) {
+        *value = 0xb7;
+    }
+    else if (strcasecmp(name, "cedil") == 0) {
+        *value = 0xb8;
+    }
+    else if (strcasecmp(name, "sup1") == 0) {
+        *value = 0xb9;
+    }
+    else if (strcasecmp(name, "ordm") == 0) {
+        *value = 0xba;
+    }
+    else if (strcasecmp(name, "raquo") == 0) {
+        *value = 0xbb;
+    }
+    else if (strcasecmp(name, "frac14") == 0) {
+        *value = 0xbc;
+    }
+    else if (strcasecmp(name, "frac12") == 0) {
+        *value = 0xbd;
+    }
+    else if (strcasecmp(name, "frac34") == 0) {
+        *value = 0xbe;
+    }
+    else if (strcasecmp(name, "iquest") == 0) {
+        *value = 0xbf;
+    }
+    else if (strcasecmp(name, "Agrave") == 0) {
+        *value = 0xc0;
+    }
+    else if (strcasecmp(name, "Aacute") == 0) {
+        *value = 0xc1;
+    }
+    else if (strcasecmp(name, "Acirc") == 0) {
+        *value = 0xc2;
+    }
+    else if (strcasecmp(name, "Atilde") == 0) {
+        *value = 0xc3;
+    }
+    else if (strcasecmp(name, "Auml") == 0) {
+        *value = 0xc4;
+    }
+    else if (strcasecmp(name, "Aring") == 0) {
+        *value = 0xc5;
+    }
+    else if (strcasecmp(name, "AElig") == 0) {
+        *value = 0xc6;
+    }
+    else if (strcasecmp(name, "Ccedil") == 0) {
+        *value = 0xc7;
+    }
+    else if (strcasecmp(name, "Egrave") == 0) {
+        *value = 0xc8;
+    }
+    else if (strcasecmp(name, "Eacute") == 0) {
+        *value = 0xc9;
+    }
+    else if (strcasecmp(name, "Ecirc") == 0) {
+        *value = 0xca;
+    }
+    else if (strcasecmp(name, "Euml") == 0) {
+        *value = 0xcb;
+    }
+    else if (strcasecmp(name, "Igrave") == 0) {
+        *value = 0xcc;
+    }
+    else if (strcasecmp(name, "Iacute") == 0) {
+        *value = 0xcd;
+    }
+    else if (strcasecmp(name, "Icirc") == 0) {
+        *value = 0xce;
+    }
+    else if (strcasecmp(name, "Iuml") == 0) {
+        *value = 0xcf;
+    }
+    else if (strcasecmp(name, "ETH") == 0) {
+        *value = 0xd0;
+    }
+    else if (strcasecmp(name, "Ntilde") == 0) {
+        *value = 0xd1;
+    }
+    else if (strcasecmp(name, "Ograve") == 0) {
+        *value = 0xd2;
+    }
+    else if (strcasecmp(name, "Oacute") == 0) {
+        *value = 0xd3;
+    }
+    else if (strcasecmp(name, "Ocirc") == 0) {
+        *value = 0xd4;
+    }
+    else if (strcasecmp(name, "Otilde") == 0) {
+        *value = 0xd5;
+    }
+    else if (strcasecmp(name, "Ouml") == 0) {
+        *value = 0xd6;
+    }
+    else if (strcasecmp(name, "times") == 0) {
+        *value = 0xd7;
+    }
+    else if (strcasecmp(name, "Oslash") == 0) {
+        *value = 0xd8;
+    }
+    else if (strcasecmp(name, "Ugrave") == 0) {
+        *value = 0xd9;
+    }
+    else if (strcasecmp(name, "Uacute") == 0) {
+        *value = 0xda;
+    }
+    else if (strcasecmp(name, "Ucirc") == 0) {
+        *value = 0xdb;
+    }
+    else if (strcasecmp(name, "Uuml") == 0) {
+        *value = 0xdc;
+    }
+    else if (strcasecmp(name, "Yacute") == 0) {
+        *value = 0xdd;
+    }
+    else if (strcasecmp(name, "THORN") == 0) {
+        *value = 0xde;
+    }
+    else if (strcasecmp(name, "szlig") == 0) {
+        *value = 0xdf;
+    }
+    else if (strcasecmp(name, "agrave") == 0) {
+        *value = 0xe0;
+    }
+    else if (strcasecmp(name, "aacute") == 0) {
+        *value = 0xe1;
+    }
+    else if (strcasecmp(name, "acirc") == 0) {
+        *value = 0xe2;
+    }
+    else if (strcasecmp(name, "atilde") == 0) {
+        *value = 0xe3;
+    }
+    else if (strcasecmp(name, "auml") == 0) {
+        *value = 0xe4;
+    }
+    else if (strcasecmp(name, "aring") == 0) {
+        *value = 0xe5;
+    }
+    else if (strcasecmp(name, "aelig") == 0) {
+        *value = 0xe6;
+    }
+    else if (strcasecmp(name, "ccedil") == 0) {
+        *value = 0xe7;
+    }
+    else if (strcasecmp(name, "egrave") == 0) {
+        *value = 0xe8;
+    }
+    else if (strcasecmp(name, "eacute") == 0) {
+        *value = 0xe9;
+    }
+    else if (strcasecmp(name, "ecirc") == 0) {
+        *value = 0xea;
+    }
+    else if (strcasecmp(name, "euml") == 0) {
+        *value = 0xeb;
+    }
+    else if (strcasecmp(name, "igrave") == 0) {
+        *value = 0xec;
+    }
+    else if (strcasecmp(name, "iacute") == 0) {
+        *value = 0xed;
+    }
+    else if (strcasecmp(name, "icirc") == 0) {
+        *value = 0xee;
+    }
+    else if (strcasecmp(name, "iuml") == 0) {
+        *value = 0xef;
+    }
+    else if (strcasecmp(name, "eth") == 0) {
+        *value = 0xf0;
+    }
+    else if (strcasecmp(name, "ntilde") == 0) {
+        *value = 0xf1;
+    }
+    else if (strcasecmp(name, "ograve") == 0) {
+        *value = 0xf2;
+    }
+    else if (strcasecmp(name, "oacute") == 0) {
+        *value = 0xf3;
+    }
+    else if (strcasecmp(name, "ocirc") == 0) {
+        *value = 0xf4;
+    }
+    else if (strcasecmp(name, "otilde") == 0) {
+        *value = 0xf5;
+    }
+    else if (strcasecmp(name, "ouml") == 0) {
+        *value = 0xf6;
+    }
+    else if (strcasecmp(name, "divide") == 0) {
+        *value = 0xf7;
+    }
+    else if (strcasecmp(name, "oslash") == 0) {
+        *value = 0xf8;
+    }
+    else if (strcasecmp(name, "ugrave") == 0) {
+        *value = 0xf9;
+    }
+    else if (strcasecmp(name, "uacute") == 0) {
+        *value = 0xfa;
+    }
+    else if (strcasecmp(name, "ucirc") == 0) {
+        *value = 0xfb;
+    }
+    else if (strcasecmp(name, "uuml") == 0) {
+        *value = 0xfc;
+    }
+    else if (strcasecmp(name, "yacute") == 0) {
+        *value = 0xfd;
+    }
+    else if (strcasecmp(name, "thorn") == 0) {
+        *value = 0xfe;
+    }
+    else if (strcasecmp(name, "yuml") == 0) {
+        *value = 0xff;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
 ib_status_t ib_util_decode_html_entity(
     const uint8_t  *data_in,
     size_t          dlen_in,
@@ -266,321 +714,17 @@ ib_status_t ib_util_decode_html_entity(
                         return IB_EALLOC;
                     }
 
-                    /* Decode the entity. */
-                    /* ENH What about others? */
-                    if (strcasecmp(tmp, "quot") == 0) {
-                        *out++ = '"';
-                    }
-                    else if (strcasecmp(tmp, "amp") == 0) {
-                        *out++ = '&';
-                    }
-                    else if (strcasecmp(tmp, "lt") == 0) {
-                        *out++ = '<';
-                    }
-                    else if (strcasecmp(tmp, "gt") == 0) {
-                        *out++ = '>';
-                    }
-                    else if (strcasecmp(tmp, "nbsp") == 0) {
-                        *out++ = NBSP;
-                    }
+                    uint8_t value;
 
-                    /* Remaining 1-byte entities. */
-                    /* ENH Rewrite this to be faster lookup. */
-                    else if (strcasecmp(tmp, "quot") == 0) {
-                        *out++ = 0x22;
-                    }
-                    else if (strcasecmp(tmp, "iexcl") == 0) {
-                        *out++ = 0xa1;
-                    }
-                    else if (strcasecmp(tmp, "cent") == 0) {
-                        *out++ = 0xa2;
-                    }
-                    else if (strcasecmp(tmp, "pound") == 0) {
-                        *out++ = 0xa3;
-                    }
-                    else if (strcasecmp(tmp, "curren") == 0) {
-                        *out++ = 0xa4;
-                    }
-                    else if (strcasecmp(tmp, "yen") == 0) {
-                        *out++ = 0xa5;
-                    }
-                    else if (strcasecmp(tmp, "brvbar") == 0) {
-                        *out++ = 0xa6;
-                    }
-                    else if (strcasecmp(tmp, "sect") == 0) {
-                        *out++ = 0xa7;
-                    }
-                    else if (strcasecmp(tmp, "uml") == 0) {
-                        *out++ = 0xa8;
-                    }
-                    else if (strcasecmp(tmp, "copy") == 0) {
-                        *out++ = 0xa9;
-                    }
-                    else if (strcasecmp(tmp, "ordf") == 0) {
-                        *out++ = 0xaa;
-                    }
-                    else if (strcasecmp(tmp, "laquo") == 0) {
-                        *out++ = 0xab;
-                    }
-                    else if (strcasecmp(tmp, "not") == 0) {
-                        *out++ = 0xac;
-                    }
-                    else if (strcasecmp(tmp, "shy") == 0) {
-                        *out++ = 0xad;
-                    }
-                    else if (strcasecmp(tmp, "reg") == 0) {
-                        *out++ = 0xae;
-                    }
-                    else if (strcasecmp(tmp, "macr") == 0) {
-                        *out++ = 0xaf;
-                    }
-                    else if (strcasecmp(tmp, "deg") == 0) {
-                        *out++ = 0xb0;
-                    }
-                    else if (strcasecmp(tmp, "plusmn") == 0) {
-                        *out++ = 0xb1;
-                    }
-                    else if (strcasecmp(tmp, "sup2") == 0) {
-                        *out++ = 0xb2;
-                    }
-                    else if (strcasecmp(tmp, "sup3") == 0) {
-                        *out++ = 0xb3;
-                    }
-                    else if (strcasecmp(tmp, "acute") == 0) {
-                        *out++ = 0xb4;
-                    }
-                    else if (strcasecmp(tmp, "micro") == 0) {
-                        *out++ = 0xb5;
-                    }
-                    else if (strcasecmp(tmp, "para") == 0) {
-                        *out++ = 0xb6;
-                    }
-                    else if (strcasecmp(tmp, "middot") == 0) {
-                        *out++ = 0xb7;
-                    }
-                    else if (strcasecmp(tmp, "cedil") == 0) {
-                        *out++ = 0xb8;
-                    }
-                    else if (strcasecmp(tmp, "sup1") == 0) {
-                        *out++ = 0xb9;
-                    }
-                    else if (strcasecmp(tmp, "ordm") == 0) {
-                        *out++ = 0xba;
-                    }
-                    else if (strcasecmp(tmp, "raquo") == 0) {
-                        *out++ = 0xbb;
-                    }
-                    else if (strcasecmp(tmp, "frac14") == 0) {
-                        *out++ = 0xbc;
-                    }
-                    else if (strcasecmp(tmp, "frac12") == 0) {
-                        *out++ = 0xbd;
-                    }
-                    else if (strcasecmp(tmp, "frac34") == 0) {
-                        *out++ = 0xbe;
-                    }
-                    else if (strcasecmp(tmp, "iquest") == 0) {
-                        *out++ = 0xbf;
-                    }
-                    else if (strcasecmp(tmp, "Agrave") == 0) {
-                        *out++ = 0xc0;
-                    }
-                    else if (strcasecmp(tmp, "Aacute") == 0) {
-                        *out++ = 0xc1;
-                    }
-                    else if (strcasecmp(tmp, "Acirc") == 0) {
-                        *out++ = 0xc2;
-                    }
-                    else if (strcasecmp(tmp, "Atilde") == 0) {
-                        *out++ = 0xc3;
-                    }
-                    else if (strcasecmp(tmp, "Auml") == 0) {
-                        *out++ = 0xc4;
-                    }
-                    else if (strcasecmp(tmp, "Aring") == 0) {
-                        *out++ = 0xc5;
-                    }
-                    else if (strcasecmp(tmp, "AElig") == 0) {
-                        *out++ = 0xc6;
-                    }
-                    else if (strcasecmp(tmp, "Ccedil") == 0) {
-                        *out++ = 0xc7;
-                    }
-                    else if (strcasecmp(tmp, "Egrave") == 0) {
-                        *out++ = 0xc8;
-                    }
-                    else if (strcasecmp(tmp, "Eacute") == 0) {
-                        *out++ = 0xc9;
-                    }
-                    else if (strcasecmp(tmp, "Ecirc") == 0) {
-                        *out++ = 0xca;
-                    }
-                    else if (strcasecmp(tmp, "Euml") == 0) {
-                        *out++ = 0xcb;
-                    }
-                    else if (strcasecmp(tmp, "Igrave") == 0) {
-                        *out++ = 0xcc;
-                    }
-                    else if (strcasecmp(tmp, "Iacute") == 0) {
-                        *out++ = 0xcd;
-                    }
-                    else if (strcasecmp(tmp, "Icirc") == 0) {
-                        *out++ = 0xce;
-                    }
-                    else if (strcasecmp(tmp, "Iuml") == 0) {
-                        *out++ = 0xcf;
-                    }
-                    else if (strcasecmp(tmp, "ETH") == 0) {
-                        *out++ = 0xd0;
-                    }
-                    else if (strcasecmp(tmp, "Ntilde") == 0) {
-                        *out++ = 0xd1;
-                    }
-                    else if (strcasecmp(tmp, "Ograve") == 0) {
-                        *out++ = 0xd2;
-                    }
-                    else if (strcasecmp(tmp, "Oacute") == 0) {
-                        *out++ = 0xd3;
-                    }
-                    else if (strcasecmp(tmp, "Ocirc") == 0) {
-                        *out++ = 0xd4;
-                    }
-                    else if (strcasecmp(tmp, "Otilde") == 0) {
-                        *out++ = 0xd5;
-                    }
-                    else if (strcasecmp(tmp, "Ouml") == 0) {
-                        *out++ = 0xd6;
-                    }
-                    else if (strcasecmp(tmp, "times") == 0) {
-                        *out++ = 0xd7;
-                    }
-                    else if (strcasecmp(tmp, "Oslash") == 0) {
-                        *out++ = 0xd8;
-                    }
-                    else if (strcasecmp(tmp, "Ugrave") == 0) {
-                        *out++ = 0xd9;
-                    }
-                    else if (strcasecmp(tmp, "Uacute") == 0) {
-                        *out++ = 0xda;
-                    }
-                    else if (strcasecmp(tmp, "Ucirc") == 0) {
-                        *out++ = 0xdb;
-                    }
-                    else if (strcasecmp(tmp, "Uuml") == 0) {
-                        *out++ = 0xdc;
-                    }
-                    else if (strcasecmp(tmp, "Yacute") == 0) {
-                        *out++ = 0xdd;
-                    }
-                    else if (strcasecmp(tmp, "THORN") == 0) {
-                        *out++ = 0xde;
-                    }
-                    else if (strcasecmp(tmp, "szlig") == 0) {
-                        *out++ = 0xdf;
-                    }
-                    else if (strcasecmp(tmp, "agrave") == 0) {
-                        *out++ = 0xe0;
-                    }
-                    else if (strcasecmp(tmp, "aacute") == 0) {
-                        *out++ = 0xe1;
-                    }
-                    else if (strcasecmp(tmp, "acirc") == 0) {
-                        *out++ = 0xe2;
-                    }
-                    else if (strcasecmp(tmp, "atilde") == 0) {
-                        *out++ = 0xe3;
-                    }
-                    else if (strcasecmp(tmp, "auml") == 0) {
-                        *out++ = 0xe4;
-                    }
-                    else if (strcasecmp(tmp, "aring") == 0) {
-                        *out++ = 0xe5;
-                    }
-                    else if (strcasecmp(tmp, "aelig") == 0) {
-                        *out++ = 0xe6;
-                    }
-                    else if (strcasecmp(tmp, "ccedil") == 0) {
-                        *out++ = 0xe7;
-                    }
-                    else if (strcasecmp(tmp, "egrave") == 0) {
-                        *out++ = 0xe8;
-                    }
-                    else if (strcasecmp(tmp, "eacute") == 0) {
-                        *out++ = 0xe9;
-                    }
-                    else if (strcasecmp(tmp, "ecirc") == 0) {
-                        *out++ = 0xea;
-                    }
-                    else if (strcasecmp(tmp, "euml") == 0) {
-                        *out++ = 0xeb;
-                    }
-                    else if (strcasecmp(tmp, "igrave") == 0) {
-                        *out++ = 0xec;
-                    }
-                    else if (strcasecmp(tmp, "iacute") == 0) {
-                        *out++ = 0xed;
-                    }
-                    else if (strcasecmp(tmp, "icirc") == 0) {
-                        *out++ = 0xee;
-                    }
-                    else if (strcasecmp(tmp, "iuml") == 0) {
-                        *out++ = 0xef;
-                    }
-                    else if (strcasecmp(tmp, "eth") == 0) {
-                        *out++ = 0xf0;
-                    }
-                    else if (strcasecmp(tmp, "ntilde") == 0) {
-                        *out++ = 0xf1;
-                    }
-                    else if (strcasecmp(tmp, "ograve") == 0) {
-                        *out++ = 0xf2;
-                    }
-                    else if (strcasecmp(tmp, "oacute") == 0) {
-                        *out++ = 0xf3;
-                    }
-                    else if (strcasecmp(tmp, "ocirc") == 0) {
-                        *out++ = 0xf4;
-                    }
-                    else if (strcasecmp(tmp, "otilde") == 0) {
-                        *out++ = 0xf5;
-                    }
-                    else if (strcasecmp(tmp, "ouml") == 0) {
-                        *out++ = 0xf6;
-                    }
-                    else if (strcasecmp(tmp, "divide") == 0) {
-                        *out++ = 0xf7;
-                    }
-                    else if (strcasecmp(tmp, "oslash") == 0) {
-                        *out++ = 0xf8;
-                    }
-                    else if (strcasecmp(tmp, "ugrave") == 0) {
-                        *out++ = 0xf9;
-                    }
-                    else if (strcasecmp(tmp, "uacute") == 0) {
-                        *out++ = 0xfa;
-                    }
-                    else if (strcasecmp(tmp, "ucirc") == 0) {
-                        *out++ = 0xfb;
-                    }
-                    else if (strcasecmp(tmp, "uuml") == 0) {
-                        *out++ = 0xfc;
-                    }
-                    else if (strcasecmp(tmp, "yacute") == 0) {
-                        *out++ = 0xfd;
-                    }
-                    else if (strcasecmp(tmp, "thorn") == 0) {
-                        *out++ = 0xfe;
-                    }
-                    else if (strcasecmp(tmp, "yuml") == 0) {
-                        *out++ = 0xff;
-                    }
-                    else {
+                    /* Decode the entity. */
+                    if (! html_entity_value(tmp, &value)) {
                         /* We do no want to convert this entity,
                          * copy the raw data over. */
                         copy = t1 - t2 + 1;
                         free(tmp);
                         goto HTML_ENT_OUT;
                     }
+                    *out++ = value;
                     free(tmp);
 
                     /* Skip over the semicolon if it's there. */
@@ -609,6 +753,195 @@ ib_status_t ib_util_decode_html_entity(
     return IB_OK;
 }
 
+/**
+ * Flush the held entity candidate of @a state verbatim.
+ *
+ * @param[in,out] state State whose carry to flush.
+ * @param[in,out] out   Output cursor; advanced past the flushed bytes.
+ */
+static void html_entity_flush_raw(
+    ib_decode_html_entity_state_t *state,
+    uint8_t                      **out
+)
+{
+    memcpy(*out, state->carry, state->carry_len);
+    *out += state->carry_len;
+    state->carry_len = 0;
+}
+
+/**
+ * Decode the completed entity candidate held in @a state.
+ *
+ * The carry must hold a complete candidate: "&#" or "&#x"/"&#X" followed
+ * by at least one digit, or "&" followed by an entity name.  Unknown
+ * names are flushed verbatim.
+ *
+ * @param[in,out] state State whose carry to decode.
+ * @param[in,out] out   Output cursor; advanced past the output.
+ *
+ * @returns True iff the candidate decoded; false if flushed verbatim.
+ */
+static bool html_entity_decode_carry(
+    ib_decode_html_entity_state_t *state,
+    uint8_t                      **out
+)
+{
+    char    tmp[IB_DECODE_HTML_ENTITY_CARRY + 1];
+    uint8_t value;
+
+    if (state->carry[1] == '#') {
+        int base = 10;
+        size_t digits_at = 2;
+
+        if (state->carry[2] == 'x' || state->carry[2] == 'X') {
+            base = 16;
+            digits_at = 3;
+        }
+        memcpy(tmp, state->carry + digits_at, state->carry_len - digits_at);
+        tmp[state->carry_len - digits_at] = '\0';
+        **out = (uint8_t)strtol(tmp, NULL, base);
+        ++(*out);
+        state->carry_len = 0;
+
+        return true;
+    }
+
+    memcpy(tmp, state->carry + 1, state->carry_len - 1);
+    tmp[state->carry_len - 1] = '\0';
+    if (! html_entity_value(tmp, &value)) {
+        html_entity_flush_raw(state, out);
+        return false;
+    }
+
+    **out = value;
+    ++(*out);
+    state->carry_len = 0;
+
+    return true;
+}
+
+ib_status_t ib_util_decode_html_entity_stream(
+    ib_decode_html_entity_state_t *state,
+    const uint8_t                 *data_in,
+    size_t                         dlen_in,
+    uint8_t                       *data_out,
+    size_t                        *dlen_out,
+    bool                           final
+)
+{
+    assert(state != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+    assert(data_in != NULL || dlen_in == 0);
+
+    uint8_t *out = data_out;
+    size_t i = 0;
+
+    while (i < dlen_in) {
+        uint8_t c = data_in[i];
+
+        if (state->carry_len == 0) {
+            const uint8_t *amp;
+            size_t run;
+
+            if (c == '&') {
+                state->carry[0] = '&';
+                state->carry_len = 1;
+                ++i;
+                continue;
+            }
+
+            /* Bulk-copy up to the next ampersand. */
+            amp = (const uint8_t *)memchr(data_in + i, '&', dlen_in - i);
+            run = (amp != NULL) ? (size_t)(amp - (data_in + i)) : dlen_in - i;
+            memcpy(out, data_in + i, run);
+            out += run;
+            i += run;
+            continue;
+        }
+
+        /* A candidate entity is held; decide whether @a c extends it.
+         * When it does not, the candidate is completed or rejected and
+         * @a c is re-examined as ordinary input (no increment of i). */
+        if (state->carry_len >= IB_DECODE_HTML_ENTITY_CARRY) {
+            /* Longer than any real entity; give up on decoding it. */
+            html_entity_flush_raw(state, &out);
+            continue;
+        }
+
+        if (state->carry_len == 1) {
+            /* After "&". */
+            if (c == '#' || isalnum(c)) {
+                state->carry[state->carry_len++] = c;
+                ++i;
+            }
+            else {
+                html_entity_flush_raw(state, &out);
+            }
+        }
+        else if (state->carry[1] == '#') {
+            /* Numerical entity. */
+            bool hex =
+                state->carry_len >= 3 &&
+                (state->carry[2] == 'x' || state->carry[2] == 'X');
+            size_t digits_at = hex ? 3 : 2;
+
+            if (
+                (state->carry_len == 2 && (c == 'x' || c == 'X')) ||
+                (hex ? isxdigit(c) : isdigit(c))
+            ) {
+                state->carry[state->carry_len++] = c;
+                ++i;
+            }
+            else if (state->carry_len > digits_at) {
+                /* At least one digit: decode it. */
+                html_entity_decode_carry(state, &out);
+                if (c == ';') {
+                    ++i;
+                }
+            }
+            else {
+                html_entity_flush_raw(state, &out);
+            }
+        }
+        else {
+            /* Text entity. */
+            if (isalnum(c)) {
+                state->carry[state->carry_len++] = c;
+                ++i;
+            }
+            else {
+                /* Skip over the semicolon, but only if the entity was
+                 * known; an unknown entity is flushed verbatim and the
+                 * semicolon passes through as ordinary input. */
+                if (html_entity_decode_carry(state, &out) && c == ';') {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    if (final && state->carry_len > 0) {
+        bool hex =
+            state->carry_len >= 3 &&
+            state->carry[1] == '#' &&
+            (state->carry[2] == 'x' || state->carry[2] == 'X');
+        size_t digits_at = (state->carry[1] == '#') ? (hex ? 3 : 2) : 1;
+
+        if (state->carry_len > digits_at) {
+            html_entity_decode_carry(state, &out);
+        }
+        else {
+            /* "&", "&#" or "&#x" with nothing after; copy raw. */
+            html_entity_flush_raw(state, &out);
+        }
+    }
+
+    *dlen_out = (out - data_out);
+
+    return IB_OK;
+}
+
 ib_status_t ib_util_normalize_path(
     ib_mm_t mm,
     const uint8_t *data_in,
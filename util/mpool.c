@@ -30,6 +30,7 @@
 #include <ironbee/mpool.h>
 
 #include <ironbee/lock.h>
+#include <ironbee/metrics.h>
 
 #ifdef IB_MPOOL_VALGRIND
 #include <valgrind/memcheck.h>
@@ -149,6 +150,18 @@ static char s_zero_length_buffer[1];
     #error "IB_MPOOL_NUM_TRACKS - IB_MPOOL_TRACK_ZERO_SIZE > 32"
 #endif
 
+/**
+ * Alignment of small allocations.
+ *
+ * Small allocations are rounded up so that every pointer handed out from a
+ * page is aligned for any fundamental type.  Without this, a struct
+ * allocation following an odd-sized string allocation from the same track
+ * would be returned misaligned.  The padding is charged to the allocation
+ * and shows up in reports as the difference between bytes requested and
+ * bytes used.
+ **/
+#define IB_MPOOL_ALIGNMENT sizeof(void *)
+
 /* Structures */
 
 /** See struct ib_mpool_page_t */
@@ -177,6 +190,12 @@ struct ib_mpool_page_t
      *  If this address does not match the page address, then this is a
      *  sub-page and MUST NOT be freed. */
     void *slab;
+    /** Number of pages in the slab.
+     *
+     *  Only meaningful on the page that begins the slab.  Single-page
+     *  slabs are eligible for the per-thread page cache; multi-page
+     *  slabs must be freed as a unit. */
+    size_t slab_pages;
     /**
      * First byte of page.
      *
@@ -389,6 +408,27 @@ struct ib_mpool_t
      **/
     ib_lock_t *lock;
 
+    /**
+     * Number of small allocations served per track.
+     *
+     * Reset on create and clear.  Together with @c track_requested this
+     * lets ib_mpool_analyze() show the small-object size distribution
+     * and how much of each track's use is alignment padding.
+     **/
+    size_t                   track_allocations[IB_MPOOL_NUM_TRACKS];
+    /**
+     * Bytes requested by small allocations per track.
+     *
+     * Requested bytes only; excludes alignment padding and redzones.
+     **/
+    size_t                   track_requested[IB_MPOOL_NUM_TRACKS];
+    /**
+     * Number of large allocations served.
+     *
+     * Reset on create and clear.
+     **/
+    size_t                   large_allocation_count;
+
     /**
      * Tracks of pages.
      *
@@ -639,6 +679,7 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
 #endif
 
         mpage->slab = slab;
+        mpage->slab_pages = pages;
         mpage->next = mpage_list;
         mpage_list = mpage;
     }
@@ -646,6 +687,106 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
     return mpage_list;
 }
 
+/**
+ * Default limit for the per-thread page cache.
+ *
+ * @sa ib_mpool_pagecache_limit_set()
+ **/
+#define IB_MPOOL_PAGECACHE_DEFAULT_LIMIT 16
+
+/**
+ * Per-thread cache of freed pages.
+ *
+ * Pages freed by ib_mpool_destroy() are parked here, linked through their
+ * @c next pointers, and handed to later pools on the same thread without
+ * going through malloc.  All cached pages on a thread share one page size,
+ * recorded in @c tls_page_cache_pagesize; in practice every pool uses the
+ * same (minimum-clamped) page size, so mismatches simply bypass the cache.
+ * Only pools on the default malloc/free functions participate, since a
+ * cached page must be freeable by whichever pool eventually drops it.
+ **/
+static __thread ib_mpool_page_t *tls_page_cache          = NULL;
+/** Number of pages in the calling thread's cache. */
+static __thread size_t           tls_page_cache_count    = 0;
+/** Maximum number of pages to cache on the calling thread. */
+static __thread size_t           tls_page_cache_limit    =
+    IB_MPOOL_PAGECACHE_DEFAULT_LIMIT;
+/** Page size of the cached pages. */
+static __thread size_t           tls_page_cache_pagesize = 0;
+
+/**
+ * Pop a page from the calling thread's page cache for @a mp.
+ *
+ * @param[in] mp Memory pool the page will belong to.
+ * @return Page, or NULL if the cache is empty or unsuitable for @a mp.
+ **/
+static
+ib_mpool_page_t *ib_mpool_pagecache_pop(
+    const ib_mpool_t *mp
+)
+{
+    assert(mp != NULL);
+
+    ib_mpool_page_t *mpage;
+
+    if (
+        tls_page_cache          == NULL         ||
+        tls_page_cache_pagesize != mp->pagesize ||
+        mp->malloc_fn           != &malloc      ||
+        mp->free_fn             != &free
+    ) {
+        return NULL;
+    }
+
+    mpage = tls_page_cache;
+    tls_page_cache = mpage->next;
+    --tls_page_cache_count;
+
+#ifdef IB_MPOOL_VALGRIND
+    {
+        int vrc = VALGRIND_MAKE_MEM_NOACCESS(&(mpage->page), mp->pagesize);
+        assert(vrc < 2);
+    }
+#endif
+
+    return mpage;
+}
+
+/**
+ * Offer a page freed by @a mp to the calling thread's page cache.
+ *
+ * @param[in] mp    Memory pool the page belonged to.
+ * @param[in] mpage Page beginning its slab.
+ * @return true if the cache took the page; false if the caller must free it.
+ **/
+static
+bool ib_mpool_pagecache_push(
+    const ib_mpool_t *mp,
+    ib_mpool_page_t  *mpage
+)
+{
+    assert(mp           != NULL);
+    assert(mpage        != NULL);
+    assert(mpage->slab  == mpage);
+
+    if (
+        mpage->slab_pages     != 1                    ||
+        tls_page_cache_count  >= tls_page_cache_limit ||
+        mp->malloc_fn         != &malloc              ||
+        mp->free_fn           != &free                ||
+        (tls_page_cache != NULL && tls_page_cache_pagesize != mp->pagesize)
+    ) {
+        return false;
+    }
+
+    mpage->next = tls_page_cache;
+    tls_page_cache = mpage;
+    tls_page_cache_pagesize = mp->pagesize;
+    ++tls_page_cache_count;
+
+    return true;
+}
+
 /**
  * Acquire a new page.
  *
@@ -669,7 +810,10 @@ ib_mpool_page_t *ib_mpool_acquire_page(
         mp->free_pages = mp->free_pages->next;
     }
     else {
-        mpage = ib_mpool_alloc_pages(mp, 1);
+        mpage = ib_mpool_pagecache_pop(mp);
+        if (mpage == NULL) {
+            mpage = ib_mpool_alloc_pages(mp, 1);
+        }
     }
 
     return mpage;
@@ -1265,10 +1409,12 @@ bool ib_mpool_analyze_helper(
         }
         IMR_PRINTF(
             "  %2zd (<= %-5zd): cost=%12zd use=%12zd waste=%12zd "
-            "efficiency=%4.1f%%\n",
+            "efficiency=%4.1f%% allocs=%12zd requested=%12zd\n",
             track_num, track_size, track_cost, track_use,
             track_cost - track_use,
-            100*(double)track_use / track_cost
+            100*(double)track_use / track_cost,
+            mp->track_allocations[track_num],
+            mp->track_requested[track_num]
         );
         page_use  += track_use;
         page_cost += track_cost;
@@ -1335,8 +1481,9 @@ bool ib_mpool_analyze_helper(
         )
     );
     IMR_PRINTF(
-        "LargeAllocations: use=%12zd (all others N/A)\n",
-        mp->large_allocation_inuse
+        "LargeAllocations: use=%12zd allocs=%12zd (all others N/A)\n",
+        mp->large_allocation_inuse,
+        mp->large_allocation_count
     );
     IMR_PRINTF(
         "Cleanups:         use=%12zd cost=%12zd waste=%12zd free=%12zd "
@@ -1538,7 +1685,10 @@ ib_status_t ib_mpool_create_ex(
     mp->free_fn                = free_fn;
     mp->inuse                  = 0;
     mp->large_allocation_inuse = 0;
+    mp->large_allocation_count = 0;
     mp->parent                 = parent;
+    memset(mp->track_allocations, 0, sizeof(mp->track_allocations));
+    memset(mp->track_requested,   0, sizeof(mp->track_requested));
 
     rc = ib_mpool_setname(mp, name);
     if (rc != IB_OK) {
@@ -1664,6 +1814,37 @@ ib_status_t ib_mpool_prealloc_pages(
     return IB_OK;
 }
 
+void ib_mpool_pagecache_limit_set(
+    size_t limit
+)
+{
+    tls_page_cache_limit = limit;
+
+    while (tls_page_cache_count > tls_page_cache_limit) {
+        ib_mpool_page_t *mpage = tls_page_cache;
+        tls_page_cache = mpage->next;
+        --tls_page_cache_count;
+        free(mpage);
+    }
+
+    return;
+}
+
+size_t ib_mpool_pagecache_drain(void)
+{
+    size_t freed = 0;
+
+    while (tls_page_cache != NULL) {
+        ib_mpool_page_t *mpage = tls_page_cache;
+        tls_page_cache = mpage->next;
+        ++freed;
+        free(mpage);
+    }
+    tls_page_cache_count = 0;
+
+    return freed;
+}
+
 void *ib_mpool_alloc(
     ib_mpool_t *mp,
     size_t      size
@@ -1685,6 +1866,10 @@ void *ib_mpool_alloc(
         /* Small allocation */
         /* Need to make sure we leave red zone at end. */
         actual_size += IB_MPOOL_REDZONE_SIZE;
+        /* Keep the bump pointer aligned for the next allocation. */
+        actual_size =
+            (actual_size + IB_MPOOL_ALIGNMENT - 1) &
+            ~(IB_MPOOL_ALIGNMENT - 1);
         if (mp->tracks[track_number] == NULL ||
             (mp->pagesize -
              mp->tracks[track_number]->used -
@@ -1712,6 +1897,9 @@ void *ib_mpool_alloc(
         ptr = &(mpage->page) + mpage->used + IB_MPOOL_REDZONE_SIZE;
         mpage->used += actual_size;
 
+        ++mp->track_allocations[track_number];
+        mp->track_requested[track_number] += size;
+
 #ifdef IB_MPOOL_VALGRIND
         VALGRIND_MEMPOOL_ALLOC(mp, ptr, size);
 #endif
@@ -1751,10 +1939,22 @@ void *ib_mpool_alloc(
         ++mp->large_allocations->next_pointer;
 
         mp->large_allocation_inuse += size;
+        ++mp->large_allocation_count;
     }
 
     mp->inuse += actual_size;
 
+    /* Track the highest in-use figure seen in any one pool. */
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "mpool.inuse.high",
+                IB_METRIC_GAUGE_MAX);
+        }
+        ib_metric_max(metric, mp->inuse);
+    }
+
     return ptr;
 }
 
@@ -1808,6 +2008,9 @@ void ib_mpool_clear(
 
     mp->inuse                  = 0;
     mp->large_allocation_inuse = 0;
+    mp->large_allocation_count = 0;
+    memset(mp->track_allocations, 0, sizeof(mp->track_allocations));
+    memset(mp->track_requested,   0, sizeof(mp->track_requested));
 
     IB_MPOOL_FOREACH(ib_mpool_t, child, mp->children) {
         ib_mpool_clear(child);
@@ -1862,7 +2065,9 @@ void ib_mpool_destroy(
     }
 
     IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, freeable) {
-        mp->free_fn(mpage);
+        if (! ib_mpool_pagecache_push(mp, mpage)) {
+            mp->free_fn(mpage);
+        }
     }
 
    /* We remove the child's parent link so that the child does not
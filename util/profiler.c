@@ -0,0 +1,410 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Sampling Profiler Utility Implementation
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/profiler.h>
+
+#include <ironbee/string_assembly.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/** One recorded sample: the tag stack of the interrupted thread. */
+typedef struct {
+    uint8_t depth;                         /**< Recorded stack depth. */
+    uint8_t tags[IB_PROFILER_MAX_DEPTH];   /**< Tags, root first. */
+} profiler_sample_t;
+
+/**
+ * Registered tag names, indexed by tag.
+ *
+ * Appended under g_tag_lock, read lock-free: g_num_tags is only
+ * incremented after the name pointer is stored.
+ */
+static const char *g_tag_names[IB_PROFILER_MAX_TAGS];
+
+/** Number of registered tags. */
+static volatile int g_num_tags = 0;
+
+/** Serializes tag registration. */
+static pthread_mutex_t g_tag_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Sample buffer. Allocated on first ib_profiler_start(), never freed. */
+static profiler_sample_t *g_samples = NULL;
+
+/**
+ * Next sample slot.
+ *
+ * May exceed IB_PROFILER_MAX_SAMPLES; slots past the end are counted
+ * in g_dropped instead of being written.
+ */
+static volatile uint32_t g_next_sample = 0;
+
+/** Samples dropped because the buffer was full. */
+static volatile uint32_t g_dropped = 0;
+
+/** Is the interval timer armed? */
+static bool g_running = false;
+
+/**
+ * Per-thread tag scope stack.
+ *
+ * Depth is incremented after the tag is stored so the signal handler,
+ * which interrupts this thread, never reads an unwritten slot.  Depth
+ * beyond IB_PROFILER_MAX_DEPTH is tracked (so exits balance) but not
+ * recorded.
+ */
+static __thread uint8_t g_tag_stack[IB_PROFILER_MAX_DEPTH];
+
+/** Current depth of g_tag_stack, including truncated scopes. */
+static __thread volatile int g_tag_depth = 0;
+
+int ib_profiler_tag(const char *name)
+{
+    assert(name != NULL);
+
+    int num_tags = g_num_tags;
+
+    /* Lock-free fast path: the table is append-only. */
+    for (int i = 0; i < num_tags; ++i) {
+        if (g_tag_names[i] == name || strcmp(g_tag_names[i], name) == 0) {
+            return i;
+        }
+    }
+
+    pthread_mutex_lock(&g_tag_lock);
+
+    /* Re-check entries registered while we waited for the lock. */
+    for (int i = num_tags; i < g_num_tags; ++i) {
+        if (strcmp(g_tag_names[i], name) == 0) {
+            pthread_mutex_unlock(&g_tag_lock);
+            return i;
+        }
+    }
+
+    if (g_num_tags >= IB_PROFILER_MAX_TAGS) {
+        pthread_mutex_unlock(&g_tag_lock);
+        return -1;
+    }
+
+    num_tags = g_num_tags;
+    g_tag_names[num_tags] = name;
+
+    /* Publish the entry. The name store above must be visible first. */
+    __sync_synchronize();
+    g_num_tags = num_tags + 1;
+
+    pthread_mutex_unlock(&g_tag_lock);
+
+    return num_tags;
+}
+
+void ib_profiler_enter(int tag)
+{
+    int depth = g_tag_depth;
+
+    if (tag >= 0 && depth < IB_PROFILER_MAX_DEPTH) {
+        g_tag_stack[depth] = (uint8_t)tag;
+    }
+    g_tag_depth = depth + 1;
+}
+
+void ib_profiler_exit(void)
+{
+    int depth = g_tag_depth;
+
+    if (depth > 0) {
+        g_tag_depth = depth - 1;
+    }
+}
+
+void ib_profiler_sample(void)
+{
+    profiler_sample_t *sample;
+    uint32_t           idx;
+    int                depth;
+
+    if (g_samples == NULL) {
+        return;
+    }
+
+    idx = __sync_fetch_and_add(&g_next_sample, 1);
+    if (idx >= IB_PROFILER_MAX_SAMPLES) {
+        __sync_fetch_and_add(&g_dropped, 1);
+        return;
+    }
+
+    depth = g_tag_depth;
+    if (depth > IB_PROFILER_MAX_DEPTH) {
+        depth = IB_PROFILER_MAX_DEPTH;
+    }
+
+    sample = &g_samples[idx];
+    sample->depth = (uint8_t)depth;
+    for (int i = 0; i < depth; ++i) {
+        sample->tags[i] = g_tag_stack[i];
+    }
+}
+
+/**
+ * SIGPROF handler. Records the interrupted thread's tag stack.
+ *
+ * @param[in] signum Signal number. Unused.
+ */
+static void profiler_signal_handler(int signum)
+{
+    ib_profiler_sample();
+}
+
+ib_status_t ib_profiler_start(uint32_t interval_usec)
+{
+    struct sigaction sa;
+    struct itimerval it;
+
+    if (interval_usec == 0 || g_running) {
+        return IB_EINVAL;
+    }
+
+    if (g_samples == NULL) {
+        g_samples = malloc(
+            IB_PROFILER_MAX_SAMPLES * sizeof(*g_samples));
+        if (g_samples == NULL) {
+            return IB_EALLOC;
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = profiler_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0) {
+        return IB_EOTHER;
+    }
+
+    it.it_interval.tv_sec  = interval_usec / 1000000;
+    it.it_interval.tv_usec = interval_usec % 1000000;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) != 0) {
+        signal(SIGPROF, SIG_IGN);
+        return IB_EOTHER;
+    }
+
+    g_running = true;
+
+    return IB_OK;
+}
+
+ib_status_t ib_profiler_stop(void)
+{
+    struct itimerval it;
+
+    if (! g_running) {
+        return IB_OK;
+    }
+
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+
+    /* Ignore, rather than reset, SIGPROF: a signal already in flight
+     * when the timer was disarmed must not kill the process. */
+    signal(SIGPROF, SIG_IGN);
+
+    g_running = false;
+
+    return IB_OK;
+}
+
+void ib_profiler_reset(void)
+{
+    g_dropped = 0;
+    g_next_sample = 0;
+}
+
+/**
+ * Encode a sample's tag stack as one integer for sorting.
+ *
+ * The root tag lands in the most significant used byte, so sorting
+ * keys groups identical stacks and clusters shared prefixes.  Tags are
+ * stored plus one so that zero means "no tag at this depth".
+ *
+ * @param[in] sample Sample to encode.
+ *
+ * @returns The key.
+ */
+static uint64_t profiler_sample_key(const profiler_sample_t *sample)
+{
+    uint64_t key = 0;
+
+    for (int i = 0; i < sample->depth; ++i) {
+        key = (key << 8) | (uint64_t)(sample->tags[i] + 1);
+    }
+
+    return key;
+}
+
+/**
+ * Compare two sample keys for qsort().
+ */
+static int profiler_key_cmp(const void *lhs, const void *rhs)
+{
+    uint64_t l = *(const uint64_t *)lhs;
+    uint64_t r = *(const uint64_t *)rhs;
+
+    if (l < r) {
+        return -1;
+    }
+    if (l > r) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Append one folded-stack line for @a key to @a sa.
+ *
+ * @param[in] sa String assembly to append to.
+ * @param[in] key Encoded tag stack.
+ * @param[in] count Number of samples with this stack.
+ *
+ * @returns As ib_sa_printf().
+ */
+static ib_status_t profiler_append_line(
+    ib_sa_t  *sa,
+    uint64_t  key,
+    uint32_t  count
+)
+{
+    ib_status_t rc;
+    uint8_t     tags[IB_PROFILER_MAX_DEPTH];
+    int         depth = 0;
+
+    /* Decode, least-recent tag last, then emit in reverse. */
+    while (key != 0) {
+        tags[depth] = (uint8_t)((key & 0xff) - 1);
+        key >>= 8;
+        ++depth;
+    }
+
+    if (depth == 0) {
+        rc = ib_sa_printf(sa, "(untagged) %u\n", count);
+        return rc;
+    }
+
+    for (int i = depth - 1; i >= 0; --i) {
+        rc = ib_sa_printf(
+            sa,
+            "%s%c",
+            g_tag_names[tags[i]],
+            (i == 0) ? ' ' : ';');
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return ib_sa_printf(sa, "%u\n", count);
+}
+
+ib_status_t ib_profiler_report(ib_mm_t mm, const char **report)
+{
+    assert(report != NULL);
+
+    ib_status_t  rc;
+    ib_sa_t     *sa = NULL;
+    uint64_t    *keys = NULL;
+    uint32_t     num_samples = g_next_sample;
+    uint32_t     dropped = g_dropped;
+    const char  *dst;
+    size_t       dst_length;
+
+    if (num_samples > IB_PROFILER_MAX_SAMPLES) {
+        num_samples = IB_PROFILER_MAX_SAMPLES;
+    }
+
+    rc = ib_sa_begin(&sa);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (num_samples > 0) {
+        keys = malloc(num_samples * sizeof(*keys));
+        if (keys == NULL) {
+            rc = IB_EALLOC;
+            goto cleanup;
+        }
+
+        for (uint32_t i = 0; i < num_samples; ++i) {
+            keys[i] = profiler_sample_key(&g_samples[i]);
+        }
+
+        qsort(keys, num_samples, sizeof(*keys), profiler_key_cmp);
+
+        /* Emit one line per run of equal keys. */
+        for (uint32_t i = 0; i < num_samples; ) {
+            uint32_t j = i + 1;
+            while (j < num_samples && keys[j] == keys[i]) {
+                ++j;
+            }
+            rc = profiler_append_line(sa, keys[i], j - i);
+            if (rc != IB_OK) {
+                goto cleanup;
+            }
+            i = j;
+        }
+    }
+
+    if (dropped > 0) {
+        rc = ib_sa_printf(sa, "(dropped) %u\n", dropped);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+    }
+
+    rc = ib_sa_append(sa, "", 1); /* NUL terminate. */
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    rc = ib_sa_finish(&sa, &dst, &dst_length, mm);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    *report = dst;
+    rc = IB_OK;
+
+cleanup:
+    if (sa != NULL) {
+        ib_sa_abort(&sa);
+    }
+    if (keys != NULL) {
+        free(keys);
+    }
+
+    return rc;
+}
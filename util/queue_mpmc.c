@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Lock-Free MPMC Queue Implementation
+ *
+ * @author Sam Baskinger <sbaskinger@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/queue_mpmc.h>
+
+#include <ironbee/mm.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Assumed cache line size, used to keep the producer and consumer
+ * cursors on separate lines so that pushes and pops do not false-share.
+ */
+#define IB_QUEUE_MPMC_CACHELINE 64
+
+/**
+ * One slot of the ring.
+ *
+ * The sequence number encodes the slot's state relative to the cursors
+ * (Vyukov's bounded MPMC scheme): a slot whose sequence equals the
+ * producer's position is free, one whose sequence is position + 1 holds
+ * an element for the consumer at that position.
+ */
+typedef struct {
+    volatile size_t  sequence; /**< State of the slot; see above. */
+    void            *data;     /**< The stored element. */
+} ib_queue_mpmc_cell_t;
+
+/**
+ * A lock-free queue structure.
+ */
+struct ib_queue_mpmc_t {
+    ib_queue_mpmc_cell_t *cells;       /**< Ring of capacity slots. */
+    size_t                mask;        /**< Capacity - 1; capacity is a
+                                            power of 2. */
+
+    /** Keep the cursors off each other's cache line. */
+    char                  pad1[IB_QUEUE_MPMC_CACHELINE];
+    volatile size_t       enqueue_pos; /**< Producer cursor. */
+    char                  pad2[IB_QUEUE_MPMC_CACHELINE];
+    volatile size_t       dequeue_pos; /**< Consumer cursor. */
+};
+
+ib_status_t ib_queue_mpmc_create(
+    ib_queue_mpmc_t **queue,
+    ib_mm_t           mm,
+    size_t            capacity
+)
+{
+    assert(queue != NULL);
+
+    ib_queue_mpmc_t *q;
+    size_t           i;
+
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return IB_EINVAL;
+    }
+
+    q = (ib_queue_mpmc_t *)ib_mm_calloc(mm, 1, sizeof(*q));
+    if (q == NULL) {
+        return IB_EALLOC;
+    }
+
+    q->cells = (ib_queue_mpmc_cell_t *)ib_mm_calloc(
+        mm, capacity, sizeof(*q->cells));
+    if (q->cells == NULL) {
+        return IB_EALLOC;
+    }
+
+    q->mask = capacity - 1;
+    for (i = 0; i < capacity; ++i) {
+        q->cells[i].sequence = i;
+    }
+    q->enqueue_pos = 0;
+    q->dequeue_pos = 0;
+
+    *queue = q;
+    return IB_OK;
+}
+
+ib_status_t ib_queue_mpmc_try_push(
+    ib_queue_mpmc_t *queue,
+    void            *element
+)
+{
+    assert(queue != NULL);
+
+    ib_queue_mpmc_cell_t *cell;
+    size_t                pos = queue->enqueue_pos;
+
+    for (;;) {
+        size_t   seq;
+        intptr_t dif;
+
+        cell = &queue->cells[pos & queue->mask];
+        seq  = cell->sequence;
+        __sync_synchronize();
+
+        dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            /* The slot is free for position pos; claim it. */
+            if (__sync_bool_compare_and_swap(
+                    &queue->enqueue_pos, pos, pos + 1))
+            {
+                break;
+            }
+            /* Another producer claimed it first. */
+            pos = queue->enqueue_pos;
+        }
+        else if (dif < 0) {
+            /* The slot still holds an element a lap behind us. */
+            return IB_EAGAIN;
+        }
+        else {
+            /* Stale position; reload and retry. */
+            pos = queue->enqueue_pos;
+        }
+    }
+
+    cell->data = element;
+
+    /* Publish the element before handing the slot to the consumer. */
+    __sync_synchronize();
+    cell->sequence = pos + 1;
+
+    return IB_OK;
+}
+
+ib_status_t ib_queue_mpmc_try_pop(
+    ib_queue_mpmc_t  *queue,
+    void            **element
+)
+{
+    assert(queue != NULL);
+    assert(element != NULL);
+
+    ib_queue_mpmc_cell_t *cell;
+    size_t                pos = queue->dequeue_pos;
+
+    for (;;) {
+        size_t   seq;
+        intptr_t dif;
+
+        cell = &queue->cells[pos & queue->mask];
+        seq  = cell->sequence;
+        __sync_synchronize();
+
+        dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            /* The slot holds the element for position pos; claim it. */
+            if (__sync_bool_compare_and_swap(
+                    &queue->dequeue_pos, pos, pos + 1))
+            {
+                break;
+            }
+            /* Another consumer claimed it first. */
+            pos = queue->dequeue_pos;
+        }
+        else if (dif < 0) {
+            /* No producer has filled this slot yet. */
+            return IB_ENOENT;
+        }
+        else {
+            /* Stale position; reload and retry. */
+            pos = queue->dequeue_pos;
+        }
+    }
+
+    *element = cell->data;
+
+    /* Release the slot to the producer one lap ahead. */
+    __sync_synchronize();
+    cell->sequence = pos + queue->mask + 1;
+
+    return IB_OK;
+}
+
+size_t ib_queue_mpmc_capacity(
+    const ib_queue_mpmc_t *queue
+)
+{
+    assert(queue != NULL);
+
+    return queue->mask + 1;
+}
+
+size_t ib_queue_mpmc_size(
+    const ib_queue_mpmc_t *queue
+)
+{
+    assert(queue != NULL);
+
+    size_t enqueue_pos = queue->enqueue_pos;
+    size_t dequeue_pos = queue->dequeue_pos;
+
+    /* Concurrent pops can make the snapshot inconsistent. */
+    if (enqueue_pos < dequeue_pos) {
+        return 0;
+    }
+
+    return enqueue_pos - dequeue_pos;
+}
@@ -26,9 +26,15 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/resource_pool.h>
+
+#include <ironbee/clock.h>
+#include <ironbee/lock.h>
 #include <ironbee/util.h>
 
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <unistd.h>
 
 /**
@@ -78,6 +84,31 @@ struct ib_resource_pool_t {
      * free queue.
      */
     size_t min_count;
+
+    /**
+     * Guards all pool state.
+     *
+     * Pool operations historically relied on external locking; the
+     * pool now locks itself so timed acquires and the replenisher
+     * thread can coordinate with releasing threads. External locks
+     * remain harmless.
+     */
+    ib_lock_t *lock;
+
+    pthread_cond_t released; /**< Signaled when a resource is released. */
+    size_t         waiters;  /**< Threads waiting on @c released. */
+
+    pthread_t      replenisher;         /**< Background create thread. */
+    bool           replenisher_running; /**< True if started. */
+    bool           replenisher_stop;    /**< Ask the replenisher to exit. */
+    pthread_cond_t replenish;           /**< Wakes the replenisher. */
+
+    /* Cumulative counters, reported by ib_resource_pool_stats_get(). */
+    uint64_t  acquires;          /**< Total acquire calls. */
+    uint64_t  empty_acquires;    /**< Acquires that found no free resource. */
+    uint64_t  timeouts;          /**< Timed acquires that gave up. */
+    uint64_t  creates;           /**< Calls to the user create function. */
+    ib_time_t create_time_total; /**< Time spent creating, in useconds. */
 };
 
 /**
@@ -91,6 +122,18 @@ static void ib_resource_pool_destroy(void *data) {
     ib_status_t rc;
     ib_resource_pool_t *rp = (ib_resource_pool_t *)data;
 
+    /* Stop and join the replenisher before tearing anything down. */
+    if (rp->replenisher_running) {
+        ib_lock_lock(rp->lock);
+        rp->replenisher_stop = true;
+        pthread_cond_signal(&rp->replenish);
+        ib_lock_unlock(rp->lock);
+        pthread_join(rp->replenisher, NULL);
+        rp->replenisher_running = false;
+    }
+    pthread_cond_destroy(&rp->released);
+    pthread_cond_destroy(&rp->replenish);
+
     while (ib_queue_size(rp->resources) > 0) {
         void *v;
         rc = ib_queue_pop_front(rp->resources, &v);
@@ -126,14 +169,24 @@ static ib_status_t create_resource(
 
     ib_resource_t *tmp_resource = NULL;
     ib_status_t rc;
+    ib_timeval_t tv;
+    ib_time_t start;
 
     void *user_resource = NULL;
 
+    ib_clock_gettimeofday(&tv);
+    start = IB_CLOCK_TIMEVAL_TIME(tv);
+
     /* It is most likely that resource creation will fail.
     * Do this first to detect most likely errors fast. */
     rc = (resource_pool->create_fn)(
             &user_resource,
             resource_pool->create_data);
+
+    ib_clock_gettimeofday(&tv);
+    resource_pool->create_time_total += IB_CLOCK_TIMEVAL_TIME(tv) - start;
+    ++(resource_pool->creates);
+
     if (rc != IB_OK) {
         return rc;
     }
@@ -259,6 +312,20 @@ ib_status_t ib_resource_pool_create(
     *(size_t *)&(rp->max_count) = max_count;
     *(size_t *)&(rp->min_count) = min_count;
 
+    rc = ib_lock_create(&(rp->lock), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (pthread_cond_init(&(rp->released), NULL) != 0) {
+        return IB_EOTHER;
+    }
+
+    if (pthread_cond_init(&(rp->replenish), NULL) != 0) {
+        pthread_cond_destroy(&(rp->released));
+        return IB_EOTHER;
+    }
+
     rc = ib_mm_register_cleanup(mm, ib_resource_pool_destroy, rp);
     if (rc != IB_OK) {
         return rc;
@@ -275,7 +342,18 @@ ib_status_t ib_resource_pool_create(
     return IB_OK;
 }
 
-ib_status_t ib_resource_acquire(
+/**
+ * Pop a free resource or create one. The pool lock must be held.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[out] resource The resource acquired.
+ *
+ * @returns
+ * - IB_OK If a resource is acquired.
+ * - IB_DECLINED If the pool is empty and at its maximum.
+ * - Other on unexpected errors.
+ */
+static ib_status_t acquire_unlocked(
     ib_resource_pool_t *resource_pool,
     ib_resource_t **resource
 )
@@ -292,17 +370,22 @@ ib_status_t ib_resource_acquire(
             resource_pool->resources,
             &tmp_resource);
         if (rc != IB_OK) {
-            goto failure;
+            return rc;
         }
 
         /* Ensure that we have a resource. */
         if (tmp_resource == NULL) {
             ib_util_log_error("Resource queue returned NULL.");
-            rc = IB_DECLINED;
-            goto failure;
+            return IB_DECLINED;
         }
 
-        goto success;
+        /* If this drained the pool below its watermark, wake the
+         * replenisher (if any) to top it back up. */
+        if (ib_queue_size(resource_pool->resources)
+            < resource_pool->min_count)
+        {
+            pthread_cond_signal(&resource_pool->replenish);
+        }
     }
     /* If we may create a new resource, do so. */
     else if (   (resource_pool->max_count == 0)
@@ -310,26 +393,20 @@ ib_status_t ib_resource_acquire(
     {
         rc = create_resource(resource_pool, &tmp_resource);
         if (rc != IB_OK) {
-            goto failure;
+            return rc;
         }
 
         /* Ensure that we have a resource. */
         if (tmp_resource == NULL) {
             ib_util_log_error("Creation function created NULL resource.");
-            rc = IB_DECLINED;
-            goto failure;
+            return IB_DECLINED;
         }
-
-        goto success;
     }
     /* If we may not wait for the resource, fail w/ IB_DECLINED. */
     else {
-        rc = IB_DECLINED;
-        goto failure;
+        return IB_DECLINED;
     }
 
-success:
-
     if (resource_pool->preuse_fn != NULL) {
         (resource_pool->preuse_fn)(
             tmp_resource->resource,
@@ -339,9 +416,75 @@ success:
     ++(tmp_resource->use);
 
     *resource = tmp_resource;
-    return rc;
+    return IB_OK;
+}
+
+ib_status_t ib_resource_acquire(
+    ib_resource_pool_t *resource_pool,
+    ib_resource_t **resource
+)
+{
+    return ib_resource_acquire_timeout(resource_pool, 0, resource);
+}
+
+ib_status_t ib_resource_acquire_timeout(
+    ib_resource_pool_t *resource_pool,
+    ib_time_t timeout,
+    ib_resource_t **resource
+)
+{
+    assert(resource_pool != NULL);
+    assert(resource != NULL);
+
+    ib_status_t     rc;
+    struct timespec deadline;
+
+    rc = ib_lock_lock(resource_pool->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ++(resource_pool->acquires);
+    if (ib_queue_size(resource_pool->resources) == 0) {
+        ++(resource_pool->empty_acquires);
+    }
+
+    if (timeout > 0) {
+        ib_timeval_t tv;
+        long nsec;
+
+        ib_clock_gettimeofday(&tv);
+        nsec = ((long)tv.tv_usec + (long)(timeout % 1000000)) * 1000;
+        deadline.tv_sec  = tv.tv_sec + IB_CLOCK_SECS(timeout)
+                           + nsec / 1000000000L;
+        deadline.tv_nsec = nsec % 1000000000L;
+    }
+
+    for (;;) {
+        int wait_rc;
+
+        rc = acquire_unlocked(resource_pool, resource);
+        if (rc != IB_DECLINED || timeout == 0) {
+            break;
+        }
+
+        /* Empty and at the maximum; wait for a release. */
+        ++(resource_pool->waiters);
+        wait_rc = pthread_cond_timedwait(
+            &resource_pool->released,
+            resource_pool->lock,
+            &deadline);
+        --(resource_pool->waiters);
+
+        if (wait_rc == ETIMEDOUT) {
+            ++(resource_pool->timeouts);
+            rc = IB_ETIMEDOUT;
+            break;
+        }
+    }
+
+    ib_lock_unlock(resource_pool->lock);
 
-failure:
     return rc;
 }
 
@@ -386,20 +529,40 @@ ib_status_t ib_resource_release(
     assert(resource->owner != NULL);
 
     ib_status_t rc;
+    ib_resource_pool_t *pool = resource->owner;
+
+    rc = ib_lock_lock(pool->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
 
     /* If a postuse function is defined, handle it. */
-    if (resource->owner->postuse_fn != NULL) {
-        rc = (resource->owner->postuse_fn)(
+    if (pool->postuse_fn != NULL) {
+        rc = (pool->postuse_fn)(
             resource->resource,
-            resource->owner->postuse_data);
+            pool->postuse_data);
 
         /* If the user says that the resource is invalid, destroy it. */
         if (rc == IB_EINVAL) {
-            return destroy_resource(resource);
+            rc = destroy_resource(resource);
+            ib_lock_unlock(pool->lock);
+            return rc;
         }
     }
 
-    rc = ib_queue_push_back(resource->owner->resources, resource);
+    /* Release to the front of the queue so the next acquisition gets the
+     * most recently used resource.  Resources often carry caches (JIT
+     * traces, interned data) that stay warm when a small set of resources
+     * services most acquisitions, rather than rotating through all of
+     * them. */
+    rc = ib_queue_push_front(pool->resources, resource);
+
+    /* Wake one waiter blocked in a timed acquire, if any. */
+    if (pool->waiters > 0) {
+        pthread_cond_signal(&pool->released);
+    }
+
+    ib_lock_unlock(pool->lock);
 
     return rc;
 }
@@ -420,25 +583,200 @@ ib_status_t ib_resource_pool_set_min(ib_resource_pool_t *pool, size_t limit)
 {
     assert(pool != NULL);
 
+    ib_status_t rc = IB_OK;
+
+    ib_lock_lock(pool->lock);
+
     if (pool->max_count != 0 && pool->max_count < limit) {
-        return IB_EINVAL;
+        rc = IB_EINVAL;
     }
+    else {
+        pool->min_count = limit;
 
-    pool->min_count = limit;
+        /* A raised watermark may mean there is filling to do. */
+        pthread_cond_signal(&pool->replenish);
+    }
 
-    return IB_OK;
+    ib_lock_unlock(pool->lock);
+
+    return rc;
+}
+
+size_t ib_resource_pool_min_get(ib_resource_pool_t *pool)
+{
+    assert(pool != NULL);
+
+    size_t limit;
+
+    ib_lock_lock(pool->lock);
+    limit = pool->min_count;
+    ib_lock_unlock(pool->lock);
+
+    return limit;
 }
 
 ib_status_t ib_resource_pool_set_max(ib_resource_pool_t *pool, size_t limit)
 {
     assert(pool != NULL);
 
+    ib_status_t rc = IB_OK;
+
+    ib_lock_lock(pool->lock);
+
     /* MAX cannot be less than MIN. */
     if (limit != 0 && limit < pool->min_count) {
+        rc = IB_EINVAL;
+    }
+    else {
+        pool->max_count = limit;
+    }
+
+    ib_lock_unlock(pool->lock);
+
+    return rc;
+}
+
+void ib_resource_pool_stats_get(
+    ib_resource_pool_t       *pool,
+    ib_resource_pool_stats_t *stats
+)
+{
+    assert(pool != NULL);
+    assert(stats != NULL);
+
+    ib_lock_lock(pool->lock);
+
+    stats->count             = pool->count;
+    stats->free_count        = ib_queue_size(pool->resources);
+    stats->waiters           = pool->waiters;
+    stats->acquires          = pool->acquires;
+    stats->empty_acquires    = pool->empty_acquires;
+    stats->timeouts          = pool->timeouts;
+    stats->creates           = pool->creates;
+    stats->create_time_total = pool->create_time_total;
+
+    ib_lock_unlock(pool->lock);
+}
+
+/**
+ * Main function of the replenisher thread.
+ *
+ * Whenever fewer than min_count resources are free and the maximum
+ * permits another, a resource is created. The user create function
+ * runs with the pool unlocked (it may be slow; that is the point of
+ * this thread), with the slot reserved in the count so concurrent
+ * acquirers cannot overshoot the maximum.
+ *
+ * @param[in] arg The @ref ib_resource_pool_t to replenish.
+ *
+ * @returns NULL.
+ */
+static void *replenisher_main(void *arg)
+{
+    assert(arg != NULL);
+
+    ib_resource_pool_t *pool = (ib_resource_pool_t *)arg;
+
+    ib_lock_lock(pool->lock);
+    while (!pool->replenisher_stop) {
+        while (  !pool->replenisher_stop
+              && ib_queue_size(pool->resources) < pool->min_count
+              && (pool->max_count == 0 || pool->count < pool->max_count) )
+        {
+            ib_status_t   rc;
+            ib_timeval_t  tv;
+            ib_time_t     start;
+            void         *user_resource = NULL;
+            ib_resource_t *tmp_resource = NULL;
+
+            /* Reserve the slot, then create without holding the lock. */
+            ++(pool->count);
+            ib_lock_unlock(pool->lock);
+
+            ib_clock_gettimeofday(&tv);
+            start = IB_CLOCK_TIMEVAL_TIME(tv);
+
+            rc = (pool->create_fn)(&user_resource, pool->create_data);
+
+            ib_clock_gettimeofday(&tv);
+
+            ib_lock_lock(pool->lock);
+            pool->create_time_total += IB_CLOCK_TIMEVAL_TIME(tv) - start;
+            ++(pool->creates);
+
+            if (rc != IB_OK || user_resource == NULL) {
+                /* Give the slot back and retry on the next wake up. */
+                --(pool->count);
+                break;
+            }
+
+            /* Wrap the user resource, reusing a struct if one is free. */
+            if (ib_queue_size(pool->free_queue) > 0) {
+                rc = ib_queue_pop_front(pool->free_queue, &tmp_resource);
+            }
+            else {
+                tmp_resource = ib_mm_alloc(pool->mm, sizeof(*tmp_resource));
+                rc = (tmp_resource == NULL) ? IB_EALLOC : IB_OK;
+            }
+            if (rc != IB_OK) {
+                (pool->destroy_fn)(user_resource, pool->destroy_data);
+                --(pool->count);
+                break;
+            }
+
+            tmp_resource->use      = 0;
+            tmp_resource->owner    = pool;
+            tmp_resource->resource = user_resource;
+
+            rc = ib_queue_push_back(pool->resources, tmp_resource);
+            if (rc != IB_OK) {
+                (pool->destroy_fn)(user_resource, pool->destroy_data);
+                --(pool->count);
+                break;
+            }
+
+            if (pool->waiters > 0) {
+                pthread_cond_signal(&pool->released);
+            }
+        }
+
+        if (pool->replenisher_stop) {
+            break;
+        }
+
+        /* Wait to be woken by a draining acquire; recheck periodically
+         * to pick up destroyed resources and watermark changes. */
+        {
+            ib_timeval_t    tv;
+            struct timespec deadline;
+
+            ib_clock_gettimeofday(&tv);
+            deadline.tv_sec  = tv.tv_sec + 1;
+            deadline.tv_nsec = (long)tv.tv_usec * 1000;
+
+            pthread_cond_timedwait(&pool->replenish, pool->lock, &deadline);
+        }
+    }
+    ib_lock_unlock(pool->lock);
+
+    return NULL;
+}
+
+ib_status_t ib_resource_pool_replenisher_start(ib_resource_pool_t *pool)
+{
+    assert(pool != NULL);
+
+    if (pool->replenisher_running) {
         return IB_EINVAL;
     }
 
-    pool->max_count = limit;
+    pool->replenisher_stop = false;
+
+    if (pthread_create(&pool->replenisher, NULL, replenisher_main, pool) != 0)
+    {
+        return IB_EOTHER;
+    }
+    pool->replenisher_running = true;
 
     return IB_OK;
 }
@@ -449,7 +787,9 @@ ib_status_t ib_resource_pool_flush(
 {
     assert(resource_pool != NULL);
 
-    ib_status_t rc;
+    ib_status_t rc = IB_OK;
+
+    ib_lock_lock(resource_pool->lock);
 
     /* Destroy all the resources. */
     while (resource_pool->count > 0) {
@@ -457,7 +797,7 @@ ib_status_t ib_resource_pool_flush(
 
         rc = ib_queue_pop_front(resource_pool->resources, &r);
         if (rc != IB_OK) {
-            return rc;
+            goto cleanup;
         }
 
         destroy_resource(r);
@@ -466,10 +806,13 @@ ib_status_t ib_resource_pool_flush(
     /* Fill to the minimum. */
     rc = fill_to_min(resource_pool);
     if (rc != IB_OK) {
-        return rc;
+        goto cleanup;
     }
 
-    return IB_OK;
+cleanup:
+    ib_lock_unlock(resource_pool->lock);
+
+    return rc;
 }
 
 /** @} */
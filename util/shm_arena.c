@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Shared Memory Arena Implementation
+ *
+ * @author Nick Kew <nkew@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/shm_arena.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Arena bookkeeping, kept inside the mapping itself so that forked
+ * processes share one view of the allocation offset and sealed flag.
+ * It occupies the first page, which is never write-protected.
+ */
+typedef struct arena_header_t {
+    pthread_mutex_t lock;    /**< Process-shared allocation lock. */
+    size_t          offset;  /**< Next free byte, relative to base. */
+    size_t          size;    /**< Total mapping size in bytes. */
+    size_t          payload; /**< Offset of the first payload byte. */
+    int             sealed;  /**< Non-zero once sealed. */
+} arena_header_t;
+
+struct ib_shm_arena_t {
+    uint8_t        *base;    /**< Mapping base address. */
+    arena_header_t *header;  /**< Header at the start of the mapping. */
+};
+
+//! Arena behind the memory pool allocator hooks.
+static ib_shm_arena_t *s_selected = NULL;
+
+//! Alignment of arena allocations.
+#define ARENA_ALIGN 16
+
+ib_status_t ib_shm_arena_create(
+    ib_shm_arena_t **arena,
+    size_t           size
+)
+{
+    assert(arena != NULL);
+
+    ib_shm_arena_t      *tmp;
+    arena_header_t      *header;
+    uint8_t             *base;
+    pthread_mutexattr_t  attr;
+    size_t               pagesize = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Round up to whole pages; the first page is bookkeeping. */
+    size = (size + pagesize - 1) & ~(pagesize - 1);
+    if (size < 2 * pagesize) {
+        size = 2 * pagesize;
+    }
+
+    base = mmap(
+        NULL,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (base == MAP_FAILED) {
+        return IB_EALLOC;
+    }
+
+    header = (arena_header_t *)base;
+    header->size    = size;
+    header->payload = pagesize;
+    header->offset  = pagesize;
+    header->sealed  = 0;
+
+    if (
+        pthread_mutexattr_init(&attr) != 0 ||
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0 ||
+        pthread_mutex_init(&header->lock, &attr) != 0
+    )
+    {
+        munmap(base, size);
+        return IB_EOTHER;
+    }
+    pthread_mutexattr_destroy(&attr);
+
+    tmp = malloc(sizeof(*tmp));
+    if (tmp == NULL) {
+        munmap(base, size);
+        return IB_EALLOC;
+    }
+    tmp->base   = base;
+    tmp->header = header;
+
+    *arena = tmp;
+    return IB_OK;
+}
+
+void * ib_shm_arena_malloc(
+    ib_shm_arena_t *arena,
+    size_t          size
+)
+{
+    assert(arena != NULL);
+
+    arena_header_t *header = arena->header;
+    void           *ptr = NULL;
+
+    size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+    pthread_mutex_lock(&header->lock);
+    if (! header->sealed && header->offset + size <= header->size) {
+        ptr = arena->base + header->offset;
+        header->offset += size;
+    }
+    pthread_mutex_unlock(&header->lock);
+
+    return ptr;
+}
+
+void ib_shm_arena_seal(
+    ib_shm_arena_t *arena
+)
+{
+    assert(arena != NULL);
+
+    arena_header_t *header = arena->header;
+
+    pthread_mutex_lock(&header->lock);
+    header->sealed = 1;
+    pthread_mutex_unlock(&header->lock);
+}
+
+bool ib_shm_arena_contains(
+    const ib_shm_arena_t *arena,
+    const void           *ptr
+)
+{
+    assert(arena != NULL);
+
+    const uint8_t *p = ptr;
+
+    return (p >= arena->base && p < arena->base + arena->header->size);
+}
+
+size_t ib_shm_arena_used(
+    const ib_shm_arena_t *arena
+)
+{
+    assert(arena != NULL);
+
+    return arena->header->offset - arena->header->payload;
+}
+
+void ib_shm_arena_destroy(
+    ib_shm_arena_t *arena
+)
+{
+    assert(arena != NULL);
+
+    if (s_selected == arena) {
+        s_selected = NULL;
+    }
+
+    munmap(arena->base, arena->header->size);
+    free(arena);
+}
+
+void ib_shm_arena_select(
+    ib_shm_arena_t *arena
+)
+{
+    s_selected = arena;
+}
+
+void * ib_shm_arena_mpool_malloc(size_t size)
+{
+    if (s_selected != NULL) {
+        void *ptr = ib_shm_arena_malloc(s_selected, size);
+        if (ptr != NULL) {
+            return ptr;
+        }
+        /* Sealed or full: degrade to private memory. */
+    }
+
+    return malloc(size);
+}
+
+void ib_shm_arena_mpool_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    /* Arena allocations are never individually freed. */
+    if (s_selected != NULL && ib_shm_arena_contains(s_selected, ptr)) {
+        return;
+    }
+
+    free(ptr);
+}
@@ -24,17 +24,52 @@
 
 #include "ironbee_config_auto.h"
 
+#include <ironbee/metrics.h>
 #include <ironbee/queue.h>
-#include <ironbee/mm_mpool_lite.h>
-#include <ironbee/mpool_freeable.h>
-#include <ironbee/mpool_lite.h>
 #include <ironbee/stream_io.h>
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A reference counted buffer backing zero or more data segments.
+ *
+ * Buffers are allocated with malloc() with the payload placed inline,
+ * directly after this header. When the last reference is released a
+ * buffer is not freed but returned to a per-stream free list so the
+ * next chunk of equal or smaller size reuses it without touching the
+ * allocator. A pump processes one chunk at a time, so after the first
+ * few chunks a transaction's body typically flows through the whole
+ * processor chain with no allocations at all.
+ *
+ * Aliased buffers (ib_stream_io_tx_data_alias_add()) own no payload;
+ * they carry only the user's release function and are freed, not
+ * pooled, when their last reference is released.
+ *
+ * Streams are owned by a single transaction and are never shared
+ * across threads, so no locking is done.
+ */
+typedef struct stream_io_buffer_t stream_io_buffer_t;
+struct stream_io_buffer_t {
+    size_t                     capacity;       /**< Inline payload size. */
+    size_t                     refs;           /**< Outstanding references. */
+    bool                       external;       /**< Payload is aliased. */
+    ib_stream_io_release_fn_t  release_fn;     /**< Alias release. May be NULL. */
+    void                      *release_cbdata; /**< Callback data. */
+    stream_io_buffer_t        *prev;           /**< Previous live buffer. */
+    stream_io_buffer_t        *next;           /**< Next live or free buffer. */
+};
+
+/** The inline payload of buffer @a b. */
+#define BUFFER_PAYLOAD(b) ((uint8_t *)((b) + 1))
 
 struct ib_stream_io_t {
-    ib_mm_t              mm;
-    ib_mpool_freeable_t *mp;
+    ib_mm_t              mm;           /**< Lifetime of this stream. */
+    stream_io_buffer_t  *live_buffers; /**< All buffers holding references. */
+    stream_io_buffer_t  *free_buffers; /**< Pooled buffers awaiting reuse. */
+    ib_stream_io_data_t *free_data;    /**< Recycled data descriptors. */
 };
 
 struct ib_stream_io_tx_t {
@@ -44,21 +79,306 @@ struct ib_stream_io_tx_t {
 };
 
 struct ib_stream_io_data_t {
-    ib_mpool_freeable_segment_t *segment; /**< Memory backing. */
-    uint8_t                     *ptr;     /**< Pointer into segment. */
-    size_t                       len;     /**< The length in bytes. */
-    ib_stream_io_type_t          type;    /**< Type of data this is. */
+    stream_io_buffer_t  *buf;       /**< Memory backing. NULL for flush etc. */
+    uint8_t             *ptr;       /**< Pointer into the buffer. */
+    size_t               len;       /**< The length in bytes. */
+    ib_stream_io_type_t  type;      /**< Type of data this is. */
+    ib_stream_io_data_t *next_free; /**< Free list link when recycled. */
 };
 
+/**
+ * Get a buffer with at least @a len bytes of payload.
+ *
+ * The free list is searched first-fit and the allocator is only
+ * consulted when no pooled buffer is large enough. The returned buffer
+ * holds one reference and is linked into the live list.
+ *
+ * @param[in] io The stream to allocate from.
+ * @param[in] len Required payload size in bytes.
+ *
+ * @returns The buffer or NULL on allocation failure.
+ */
+static stream_io_buffer_t *stream_io_buffer_alloc(
+    ib_stream_io_t *io,
+    size_t          len
+)
+{
+    assert(io != NULL);
+
+    stream_io_buffer_t *buf;
+    stream_io_buffer_t *prev = NULL;
+
+    for (buf = io->free_buffers; buf != NULL; prev = buf, buf = buf->next) {
+        if (buf->capacity >= len) {
+            if (prev == NULL) {
+                io->free_buffers = buf->next;
+            }
+            else {
+                prev->next = buf->next;
+            }
+            {
+                static const ib_metric_t *metric = NULL;
+                if (metric == NULL) {
+                    metric = ib_metric_acquire(
+                        "pump.buffer.reuse", IB_METRIC_COUNTER);
+                }
+                ib_metric_add(metric, 1);
+            }
+            goto found;
+        }
+    }
+
+    buf = malloc(sizeof(*buf) + len);
+    if (buf == NULL) {
+        return NULL;
+    }
+    buf->capacity = len;
+    {
+        static const ib_metric_t *metric = NULL;
+        if (metric == NULL) {
+            metric = ib_metric_acquire(
+                "pump.buffer.alloc", IB_METRIC_COUNTER);
+        }
+        ib_metric_add(metric, 1);
+    }
+
+found:
+    buf->refs           = 1;
+    buf->external       = false;
+    buf->release_fn     = NULL;
+    buf->release_cbdata = NULL;
+
+    /* Link into the live list. */
+    buf->prev = NULL;
+    buf->next = io->live_buffers;
+    if (io->live_buffers != NULL) {
+        io->live_buffers->prev = buf;
+    }
+    io->live_buffers = buf;
+
+    return buf;
+}
+
+/**
+ * Release a reference to @a buf.
+ *
+ * When the last reference is released, owned buffers are moved to the
+ * free list for reuse and aliased buffers have their release function
+ * run and are freed.
+ *
+ * @param[in] io The stream @a buf belongs to.
+ * @param[in] buf The buffer.
+ */
+static void stream_io_buffer_unref(
+    ib_stream_io_t     *io,
+    stream_io_buffer_t *buf
+)
+{
+    assert(io != NULL);
+    assert(buf != NULL);
+    assert(buf->refs > 0);
+
+    --(buf->refs);
+    if (buf->refs > 0) {
+        return;
+    }
+
+    /* Unlink from the live list. */
+    if (buf->prev == NULL) {
+        io->live_buffers = buf->next;
+    }
+    else {
+        buf->prev->next = buf->next;
+    }
+    if (buf->next != NULL) {
+        buf->next->prev = buf->prev;
+    }
+
+    if (buf->external) {
+        if (buf->release_fn != NULL) {
+            buf->release_fn(buf->release_cbdata);
+        }
+        free(buf);
+        return;
+    }
+
+    buf->prev        = NULL;
+    buf->next        = io->free_buffers;
+    io->free_buffers = buf;
+}
+
+/**
+ * Get a data descriptor, recycled if one is available.
+ *
+ * Descriptors are allocated from the stream's memory manager and
+ * recycled through a free list when unreferenced, so their number is
+ * bounded by the deepest the queues ever get.
+ *
+ * @param[in] io The stream to allocate from.
+ *
+ * @returns The descriptor or NULL on allocation failure.
+ */
+static ib_stream_io_data_t *stream_io_data_create(
+    ib_stream_io_t *io
+)
+{
+    assert(io != NULL);
+
+    ib_stream_io_data_t *data;
+
+    if (io->free_data != NULL) {
+        data          = io->free_data;
+        io->free_data = data->next_free;
+    }
+    else {
+        data = ib_mm_alloc(io->mm, sizeof(*data));
+    }
+
+    return data;
+}
+
+/**
+ * Return the descriptor @a data to the stream's free list.
+ *
+ * @param[in] io The stream @a data belongs to.
+ * @param[in] data The descriptor. Must not be in any queue.
+ */
+static void stream_io_data_recycle(
+    ib_stream_io_t      *io,
+    ib_stream_io_data_t *data
+)
+{
+    assert(io != NULL);
+    assert(data != NULL);
+
+    data->buf       = NULL;
+    data->next_free = io->free_data;
+    io->free_data   = data;
+}
+
+/**
+ * Enqueue a new dataless segment of @a type to @a queue.
+ *
+ * @param[in] io_tx The IO transaction.
+ * @param[in] queue The queue to append to.
+ * @param[in] type The segment type. Flush, close or similar.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other on queue failures.
+ */
+static ib_status_t stream_io_type_add(
+    ib_stream_io_tx_t   *io_tx,
+    ib_queue_t          *queue,
+    ib_stream_io_type_t  type
+)
+{
+    assert(io_tx != NULL);
+    assert(io_tx->io != NULL);
+    assert(queue != NULL);
+
+    ib_status_t          rc;
+    ib_stream_io_data_t *data;
+
+    data = stream_io_data_create(io_tx->io);
+    if (data == NULL) {
+        return IB_EALLOC;
+    }
+
+    data->buf  = NULL;
+    data->ptr  = NULL;
+    data->len  = 0;
+    data->type = type;
+
+    rc = ib_queue_enqueue(queue, data);
+    if (rc != IB_OK) {
+        stream_io_data_recycle(io_tx->io, data);
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Enqueue a new segment holding a copy of @a msg to @a queue.
+ *
+ * @param[in] io_tx The IO transaction.
+ * @param[in] queue The queue to append to.
+ * @param[in] msg The error message.
+ * @param[in] len The length of @a msg.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other on queue failures.
+ */
+static ib_status_t stream_io_error_add(
+    ib_stream_io_tx_t *io_tx,
+    ib_queue_t        *queue,
+    const char        *msg,
+    size_t             len
+)
+{
+    assert(io_tx != NULL);
+    assert(io_tx->io != NULL);
+    assert(queue != NULL);
+    assert(msg != NULL);
+
+    ib_status_t          rc;
+    ib_stream_io_data_t *data;
+    stream_io_buffer_t  *buf;
+
+    data = stream_io_data_create(io_tx->io);
+    if (data == NULL) {
+        return IB_EALLOC;
+    }
+
+    buf = stream_io_buffer_alloc(io_tx->io, len);
+    if (buf == NULL) {
+        stream_io_data_recycle(io_tx->io, data);
+        return IB_EALLOC;
+    }
+
+    data->buf  = buf;
+    data->ptr  = BUFFER_PAYLOAD(buf);
+    data->len  = len;
+    data->type = IB_STREAM_IO_ERROR;
+
+    /* Copy the error message into the buffer. */
+    memcpy(data->ptr, msg, len);
+
+    rc = ib_queue_enqueue(queue, data);
+    if (rc != IB_OK) {
+        ib_stream_io_data_unref(io_tx, data);
+        return rc;
+    }
+
+    return IB_OK;
+}
+
 static void stream_io_cleanup(void *cbdata)
 {
     assert(cbdata != NULL);
 
-    ib_stream_io_t *io = (ib_stream_io_t *)cbdata;
+    ib_stream_io_t     *io = (ib_stream_io_t *)cbdata;
+    stream_io_buffer_t *buf;
+    stream_io_buffer_t *next;
 
-    assert(io->mp != NULL);
+    /* Buffers still referenced at stream destruction. */
+    for (buf = io->live_buffers; buf != NULL; buf = next) {
+        next = buf->next;
+        if (buf->external && buf->release_fn != NULL) {
+            buf->release_fn(buf->release_cbdata);
+        }
+        free(buf);
+    }
 
-    ib_mpool_freeable_destroy(io->mp);
+    /* The reuse pool. */
+    for (buf = io->free_buffers; buf != NULL; buf = next) {
+        next = buf->next;
+        free(buf);
+    }
 }
 
 ib_status_t ib_stream_io_create(
@@ -76,10 +396,9 @@ ib_status_t ib_stream_io_create(
         return IB_EALLOC;
     }
 
-    rc = ib_mpool_freeable_create(&tmp->mp);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    tmp->live_buffers = NULL;
+    tmp->free_buffers = NULL;
+    tmp->free_data    = NULL;
 
     rc = ib_mm_register_cleanup(mm, stream_io_cleanup, tmp);
     if (rc != IB_OK) {
@@ -147,72 +466,94 @@ ib_status_t ib_stream_io_tx_data_add(
 
     rc = ib_queue_enqueue(io_tx->input, stream_data);
     if (rc != IB_OK) {
+        ib_stream_io_data_unref(io_tx, stream_data);
         return rc;
     }
 
     return IB_OK;
 }
 
-ib_status_t ib_stream_io_tx_flush_add(
-    ib_stream_io_tx_t *io_tx
+ib_status_t ib_stream_io_tx_data_alias_add(
+    ib_stream_io_tx_t         *io_tx,
+    const uint8_t             *data,
+    size_t                     len,
+    ib_stream_io_release_fn_t  release_fn,
+    void                      *release_cbdata
 )
 {
     assert(io_tx != NULL);
-    assert(io_tx->input != NULL);
+    assert(data != NULL);
+    assert(len > 0);
 
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
+    ib_status_t          rc;
+    ib_stream_io_data_t *stream_data;
+    stream_io_buffer_t  *buf;
+    ib_stream_io_t      *io = io_tx->io;
+
+    stream_data = stream_io_data_create(io);
+    if (stream_data == NULL) {
+        if (release_fn != NULL) {
+            release_fn(release_cbdata);
+        }
+        return IB_EALLOC;
+    }
 
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data));
-    if (segment == NULL) {
+    /* The buffer carries no payload. The bytes are aliased. */
+    buf = malloc(sizeof(*buf));
+    if (buf == NULL) {
+        stream_io_data_recycle(io, stream_data);
+        if (release_fn != NULL) {
+            release_fn(release_cbdata);
+        }
         return IB_EALLOC;
     }
 
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = NULL;
-    data->len     = 0;
-    data->type    = IB_STREAM_IO_FLUSH;
+    buf->capacity       = 0;
+    buf->refs           = 1;
+    buf->external       = true;
+    buf->release_fn     = release_fn;
+    buf->release_cbdata = release_cbdata;
+
+    buf->prev = NULL;
+    buf->next = io->live_buffers;
+    if (io->live_buffers != NULL) {
+        io->live_buffers->prev = buf;
+    }
+    io->live_buffers = buf;
+
+    stream_data->buf  = buf;
+    stream_data->ptr  = (uint8_t *)data;
+    stream_data->len  = len;
+    stream_data->type = IB_STREAM_IO_DATA;
 
-    rc = ib_queue_enqueue(io_tx->input, data);
+    rc = ib_queue_enqueue(io_tx->input, stream_data);
     if (rc != IB_OK) {
+        /* Unreferencing the buffer runs the release function. */
+        ib_stream_io_data_unref(io_tx, stream_data);
         return rc;
     }
 
     return IB_OK;
 }
 
-ib_status_t ib_stream_io_tx_close_add(
+ib_status_t ib_stream_io_tx_flush_add(
     ib_stream_io_tx_t *io_tx
 )
 {
     assert(io_tx != NULL);
     assert(io_tx->input != NULL);
 
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
-
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data));
-    if (segment == NULL) {
-        return IB_EALLOC;
-    }
-
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = NULL;
-    data->len     = 0;
-    data->type    = IB_STREAM_IO_CLOSE;
+    return stream_io_type_add(io_tx, io_tx->input, IB_STREAM_IO_FLUSH);
+}
 
-    rc = ib_queue_enqueue(io_tx->input, data);
-    if (rc != IB_OK) {
-        return rc;
-    }
+ib_status_t ib_stream_io_tx_close_add(
+    ib_stream_io_tx_t *io_tx
+)
+{
+    assert(io_tx != NULL);
+    assert(io_tx->input != NULL);
 
-    return IB_OK;
+    return stream_io_type_add(io_tx, io_tx->input, IB_STREAM_IO_CLOSE);
 }
 
 ib_status_t ib_stream_io_tx_error_add(
@@ -225,31 +566,7 @@ ib_status_t ib_stream_io_tx_error_add(
     assert(io_tx->input != NULL);
     assert(msg != NULL);
 
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
-
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data));
-    if (segment == NULL) {
-        return IB_EALLOC;
-    }
-
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = ((uint8_t *)data) + sizeof(data);
-    data->len     = len;
-    data->type    = IB_STREAM_IO_FLUSH;
-
-    /* Copy the error message. */
-    memcpy(data->ptr, msg, len);
-
-    rc = ib_queue_enqueue(io_tx->input, data);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    return IB_OK;
+    return stream_io_error_add(io_tx, io_tx->input, msg, len);
 }
 
 static void stream_clear_queue(ib_queue_t *q, ib_stream_io_tx_t *io_tx)
@@ -306,7 +623,6 @@ void ib_stream_io_tx_cleanup(
 )
 {
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
     assert(io_tx->input != NULL);
     assert(io_tx->output != NULL);
 
@@ -443,30 +759,9 @@ ib_status_t ib_stream_io_data_flush(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
-
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
-
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data));
-    if (segment == NULL) {
-        return IB_EALLOC;
-    }
-
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = NULL;
-    data->len     = 0;
-    data->type    = IB_STREAM_IO_FLUSH;
-
-    rc = ib_stream_io_data_put(io_tx, data);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    assert(io_tx->output != NULL);
 
-    return IB_OK;
+    return stream_io_type_add(io_tx, io_tx->output, IB_STREAM_IO_FLUSH);
 }
 
 ib_status_t ib_stream_io_data_close(
@@ -475,30 +770,9 @@ ib_status_t ib_stream_io_data_close(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
-
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
-
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data));
-    if (segment == NULL) {
-        return IB_EALLOC;
-    }
-
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = NULL;
-    data->len     = 0;
-    data->type    = IB_STREAM_IO_CLOSE;
-
-    rc = ib_stream_io_data_put(io_tx, data);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    assert(io_tx->output != NULL);
 
-    return IB_OK;
+    return stream_io_type_add(io_tx, io_tx->output, IB_STREAM_IO_CLOSE);
 }
 
 ib_status_t ib_stream_io_data_error(
@@ -509,34 +783,10 @@ ib_status_t ib_stream_io_data_error(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
+    assert(io_tx->output != NULL);
     assert(msg != NULL);
 
-    ib_status_t                  rc;
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *data;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
-
-    segment = ib_mpool_freeable_segment_alloc(mp, sizeof(*data)+len);
-    if (segment == NULL) {
-        return IB_EALLOC;
-    }
-
-    data          = ib_mpool_freeable_segment_ptr(segment);
-    data->segment = segment;
-    data->ptr     = ((uint8_t *)data) + sizeof(*data);
-    data->len     = len;
-    data->type    = IB_STREAM_IO_ERROR;
-
-    /* Copy the error message into the segment. */
-    memcpy(data->ptr, msg, len);
-
-    rc = ib_stream_io_data_put(io_tx, data);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    return IB_OK;
+    return stream_io_error_add(io_tx, io_tx->output, msg, len);
 }
 
 ib_status_t ib_stream_io_data_alloc(
@@ -548,22 +798,26 @@ ib_status_t ib_stream_io_data_alloc(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
 
-    ib_mpool_freeable_segment_t *segment;
-    ib_stream_io_data_t         *d;
-    ib_mpool_freeable_t         *mp = io_tx->io->mp;
+    ib_stream_io_data_t *d;
+    stream_io_buffer_t  *buf;
+    ib_stream_io_t      *io = io_tx->io;
 
-    segment = ib_mpool_freeable_segment_alloc(mp, len + sizeof(*d));
-    if (segment == NULL) {
+    d = stream_io_data_create(io);
+    if (d == NULL) {
         return IB_EALLOC;
     }
 
-    d          = ib_mpool_freeable_segment_ptr(segment);
-    d->segment = segment;
-    d->ptr     = (uint8_t *)(((char *)d) + sizeof(*d));
-    d->len     = len;
-    d->type    = IB_STREAM_IO_DATA;
+    buf = stream_io_buffer_alloc(io, len);
+    if (buf == NULL) {
+        stream_io_data_recycle(io, d);
+        return IB_EALLOC;
+    }
+
+    d->buf  = buf;
+    d->ptr  = BUFFER_PAYLOAD(buf);
+    d->len  = len;
+    d->type = IB_STREAM_IO_DATA;
 
     *data = d;
     *ptr  = d->ptr;
@@ -582,12 +836,9 @@ ib_status_t DLL_PUBLIC ib_stream_io_data_slice(
     assert(io_tx != NULL);
     assert(io_tx->input != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
     assert(dst != NULL);
 
-    ib_mpool_freeable_t *mp = io_tx->io->mp;
     ib_stream_io_data_t *d;
-    ib_status_t          rc;
 
     /* Make sure this is a data type. */
     if (src->type != IB_STREAM_IO_DATA) {
@@ -599,21 +850,18 @@ ib_status_t DLL_PUBLIC ib_stream_io_data_slice(
         return IB_EINVAL;
     }
 
-    d = (ib_stream_io_data_t *)ib_mpool_freeable_alloc(mp, sizeof(*d));
+    d = stream_io_data_create(io_tx->io);
     if (d == NULL) {
         return IB_EALLOC;
     }
 
-    /* Increase the references to the segment. */
-    rc = ib_mpool_freeable_segment_ref(mp, src->segment);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    /* The slice shares the source's buffer. */
+    ++(src->buf->refs);
 
-    d->segment = src->segment;
-    d->ptr     = (void *)((((char *)src->ptr)) + start);
-    d->len     = length;
-    d->type    = src->type;
+    d->buf  = src->buf;
+    d->ptr  = src->ptr + start;
+    d->len  = length;
+    d->type = src->type;
 
     *dst = d;
     if (ptr != NULL) {
@@ -673,11 +921,11 @@ void ib_stream_io_data_ref(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
-
-    ib_mpool_freeable_t *mp = io_tx->io->mp;
+    assert(data != NULL);
 
-    ib_mpool_freeable_segment_ref(mp, data->segment);
+    if (data->buf != NULL) {
+        ++(data->buf->refs);
+    }
 }
 
 void ib_stream_io_data_unref(
@@ -687,11 +935,11 @@ void ib_stream_io_data_unref(
 {
     assert(io_tx != NULL);
     assert(io_tx->io != NULL);
-    assert(io_tx->io->mp != NULL);
+    assert(data != NULL);
 
-    ib_mpool_freeable_t *mp = io_tx->io->mp;
+    if (data->buf != NULL) {
+        stream_io_buffer_unref(io_tx->io, data->buf);
+    }
 
-    ib_mpool_freeable_segment_free(mp, data->segment);
+    stream_io_data_recycle(io_tx->io, data);
 }
-
-
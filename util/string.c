@@ -39,6 +39,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 const char *ib_strstr(
@@ -48,9 +49,6 @@ const char *ib_strstr(
     size_t      needle_len
 ) {
 
-    /* The last index in haystack that can contain needle. */
-    const size_t haystack_max = haystack_len - (needle_len - 1);
-
     /* To match strstr(3), return the haystack when the needle is empty. */
     if (needle == NULL || needle_len == 0) {
         return haystack;
@@ -63,33 +61,54 @@ const char *ib_strstr(
         return NULL;
     }
 
-    /* If the needle cannot fit in the haystack, no match is found.
-     * We cannot use haystack_max to capture this concept because it is
-     * unsigned.
-     */
+    /* If the needle cannot fit in the haystack, no match is found. */
     if (needle_len > haystack_len) {
         return NULL;
     }
 
-    /* Search for the needle. */
-    for (size_t haystack_i = 0; haystack_i < haystack_max; ++haystack_i)
-    {
-        size_t needle_i;
+    /* Search with memmem(3); the C library picks the fastest substring
+     * kernel for the platform, which a byte-at-a-time scan here cannot
+     * approach. */
+    return (const char *)memmem(haystack, haystack_len, needle, needle_len);
+}
 
-        /* Check for needle knowing we will not overrun haystack. */
-        for (needle_i = 0; needle_i < needle_len; ++needle_i) {
-            if (haystack[haystack_i+needle_i] != needle[needle_i]) {
-                break;
+bool ib_streq_nocase(
+    const char *a,
+    const char *b,
+    size_t      length
+)
+{
+    assert(a != NULL);
+    assert(b != NULL);
+
+    /* Compare in small blocks.  Equal blocks, the common case when the
+     * two strings only differ in case occasionally, are handled by
+     * memcmp() at full register width; only blocks that differ fall back
+     * to byte-wise folding. */
+    const size_t block = 16;
+    size_t       i     = 0;
+
+    while (length - i >= block) {
+        if (memcmp(a + i, b + i, block) != 0) {
+            for (size_t j = i; j < i + block; ++j) {
+                if (
+                    tolower((unsigned char)a[j]) !=
+                    tolower((unsigned char)b[j])
+                ) {
+                    return false;
+                }
             }
         }
+        i += block;
+    }
 
-        /* The above loop exhausted needle's length. A match is found. */
-        if (needle_i == needle_len) {
-            return haystack + haystack_i;
+    for (; i < length; ++i) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) {
+            return false;
         }
     }
 
-    return NULL;
+    return true;
 }
 
 ib_status_t ib_string_join(
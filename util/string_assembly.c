@@ -29,8 +29,14 @@
 #include <ironbee/mpool_lite.h>
 
 #include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
+/** Minimum size of a writable block allocated for copying appends. */
+static const size_t c_sa_block_size = 256;
+
 /**
  * Chunk of data to build string out of.
  **/
@@ -55,6 +61,12 @@ struct ib_sa_t
     ib_sa_chunk_t *current_chunk;
     /** Length of all chunks */
     size_t length;
+    /** Free space at the tail of the most recent writable block. */
+    char *tail;
+    /** Bytes available at @ref tail. */
+    size_t tail_available;
+    /** Does @ref current_chunk end exactly at @ref tail? */
+    bool current_chunk_writable;
 };
 
 ib_status_t ib_sa_begin(
@@ -77,10 +89,13 @@ ib_status_t ib_sa_begin(
         return IB_EALLOC;
     }
 
-    local_sa->mpl           = sa_mpl;
-    local_sa->first_chunk   = NULL;
-    local_sa->current_chunk = NULL;
-    local_sa->length        = 0;
+    local_sa->mpl                    = sa_mpl;
+    local_sa->first_chunk            = NULL;
+    local_sa->current_chunk          = NULL;
+    local_sa->length                 = 0;
+    local_sa->tail                   = NULL;
+    local_sa->tail_available         = 0;
+    local_sa->current_chunk_writable = false;
 
     *sa = local_sa;
 
@@ -113,9 +128,183 @@ ib_status_t ib_sa_append(
     chunk->data   = data;
     chunk->length = data_length;
 
+    /* The new chunk references caller data; it cannot be grown in place. */
+    sa->current_chunk_writable = false;
+
+    return IB_OK;
+}
+
+/**
+ * Ensure at least @a needed bytes of writable tail space.
+ *
+ * Allocates a fresh writable block when the current tail is too small.
+ * Existing chunks are unaffected; they continue to reference earlier
+ * blocks, which live until the assembly is finished or aborted.
+ *
+ * @param[in] sa     String assembly state.
+ * @param[in] needed Bytes required.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static ib_status_t sa_reserve(
+    ib_sa_t *sa,
+    size_t   needed
+)
+{
+    assert(sa != NULL);
+
+    if (sa->tail_available >= needed) {
+        return IB_OK;
+    }
+
+    size_t block_size = needed > c_sa_block_size ? needed : c_sa_block_size;
+    char *block = ib_mpool_lite_alloc(sa->mpl, block_size);
+    if (block == NULL) {
+        return IB_EALLOC;
+    }
+
+    sa->tail                   = block;
+    sa->tail_available         = block_size;
+    sa->current_chunk_writable = false;
+
     return IB_OK;
 }
 
+/**
+ * Commit @a length bytes just written at the tail.
+ *
+ * Extends the current chunk when it ends exactly at the tail; otherwise
+ * appends a new chunk referencing the written bytes.
+ *
+ * @param[in] sa     String assembly state.
+ * @param[in] length Bytes written at the tail.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static ib_status_t sa_commit_tail(
+    ib_sa_t *sa,
+    size_t   length
+)
+{
+    assert(sa != NULL);
+    assert(length <= sa->tail_available);
+
+    if (sa->current_chunk_writable) {
+        sa->current_chunk->length += length;
+    }
+    else {
+        ib_sa_chunk_t *chunk = ib_mpool_lite_alloc(sa->mpl, sizeof(*chunk));
+        if (chunk == NULL) {
+            return IB_EALLOC;
+        }
+        chunk->next   = NULL;
+        chunk->data   = sa->tail;
+        chunk->length = length;
+
+        if (sa->first_chunk == NULL) {
+            sa->first_chunk = sa->current_chunk = chunk;
+        }
+        else {
+            sa->current_chunk = sa->current_chunk->next = chunk;
+        }
+        sa->current_chunk_writable = true;
+    }
+
+    sa->length         += length;
+    sa->tail           += length;
+    sa->tail_available -= length;
+
+    return IB_OK;
+}
+
+ib_status_t ib_sa_append_copy(
+    ib_sa_t    *sa,
+    const char *data,
+    size_t      data_length
+)
+{
+    assert(sa   != NULL);
+    assert(data != NULL);
+
+    ib_status_t rc;
+
+    rc = sa_reserve(sa, data_length);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    memcpy(sa->tail, data, data_length);
+
+    return sa_commit_tail(sa, data_length);
+}
+
+ib_status_t ib_sa_vprintf(
+    ib_sa_t    *sa,
+    const char *format,
+    va_list     ap
+)
+{
+    assert(sa     != NULL);
+    assert(format != NULL);
+
+    ib_status_t rc;
+    va_list ap_retry;
+    int length;
+
+    va_copy(ap_retry, ap);
+    length = vsnprintf(sa->tail, sa->tail_available, format, ap);
+    if (length < 0) {
+        va_end(ap_retry);
+        return IB_EINVAL;
+    }
+    if ((size_t)length >= sa->tail_available) {
+        /* Did not fit; reserve enough for the output and the NUL that
+         * vsnprintf() writes, then format again into the fresh tail. */
+        rc = sa_reserve(sa, (size_t)length + 1);
+        if (rc != IB_OK) {
+            va_end(ap_retry);
+            return rc;
+        }
+        length = vsnprintf(sa->tail, sa->tail_available, format, ap_retry);
+        if (length < 0 || (size_t)length >= sa->tail_available) {
+            va_end(ap_retry);
+            return IB_EINVAL;
+        }
+    }
+    va_end(ap_retry);
+
+    /* Commit only the formatted bytes; the trailing NUL stays in the tail
+     * and will be overwritten by the next append. */
+    return sa_commit_tail(sa, (size_t)length);
+}
+
+ib_status_t ib_sa_printf(
+    ib_sa_t    *sa,
+    const char *format,
+    ...
+)
+{
+    assert(sa     != NULL);
+    assert(format != NULL);
+
+    ib_status_t rc;
+    va_list ap;
+
+    va_start(ap, format);
+    rc = ib_sa_vprintf(sa, format, ap);
+    va_end(ap);
+
+    return rc;
+}
+
+size_t ib_sa_length(const ib_sa_t *sa)
+{
+    assert(sa != NULL);
+
+    return sa->length;
+}
+
 ib_status_t ib_sa_finish(
     ib_sa_t    **sa,
     const char **dst,
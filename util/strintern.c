@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- String Interning Implementation
+ *
+ * See @ref ib_strintern_t for details.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/strintern.h>
+
+#include <ironbee/hash.h>
+
+#include <assert.h>
+
+struct ib_strintern_t
+{
+    /** Memory manager canonical copies are allocated from. */
+    ib_mm_t mm;
+
+    /**
+     * Hash of string to its canonical copy.  Value: `char *`.
+     *
+     * The canonical copy doubles as the key, so key bytes live exactly as
+     * long as the entry.
+     **/
+    ib_hash_t *hash;
+};
+
+ib_status_t ib_strintern_create(
+    ib_strintern_t **interns,
+    ib_mm_t          mm
+)
+{
+    assert(interns != NULL);
+
+    ib_status_t     rc;
+    ib_strintern_t *local_interns;
+
+    local_interns = ib_mm_alloc(mm, sizeof(*local_interns));
+    if (local_interns == NULL) {
+        return IB_EALLOC;
+    }
+
+    local_interns->mm = mm;
+
+    rc = ib_hash_create_nocase(&local_interns->hash, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *interns = local_interns;
+
+    return IB_OK;
+}
+
+ib_status_t ib_strintern_intern(
+    ib_strintern_t  *interns,
+    const char      *string,
+    size_t           length,
+    const char     **interned
+)
+{
+    assert(interns  != NULL);
+    assert(string   != NULL);
+    assert(interned != NULL);
+
+    ib_status_t  rc;
+    char        *local_interned;
+
+    rc = ib_hash_get_ex(interns->hash, &local_interned, string, length);
+    if (rc == IB_OK) {
+        *interned = local_interned;
+        return IB_OK;
+    }
+    if (rc != IB_ENOENT) {
+        return rc;
+    }
+
+    local_interned = ib_mm_memdup(interns->mm, string, length);
+    if (local_interned == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_hash_set_ex(
+        interns->hash,
+        local_interned, length,
+        local_interned
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *interned = local_interned;
+
+    return IB_OK;
+}
+
+ib_status_t ib_strintern_lookup(
+    const ib_strintern_t  *interns,
+    const char            *string,
+    size_t                 length,
+    const char           **interned
+)
+{
+    assert(interns  != NULL);
+    assert(string   != NULL);
+    assert(interned != NULL);
+
+    return ib_hash_get_ex(
+        interns->hash,
+        (char **)interned,
+        string, length
+    );
+}
@@ -108,6 +108,40 @@ TEST_F(TestIBUtilByteStr, test_bytestr_alias_mem)
     ASSERT_EQ(IB_EINVAL, rc);
 }
 
+/// @test Test util bytestr library - ib_bytestr_alias_range()
+TEST_F(TestIBUtilByteStr, test_bytestr_alias_range)
+{
+    ib_bytestr_t *bs;
+    ib_bytestr_t *view;
+    ib_status_t rc;
+    uint8_t data[] = { 'a', 'b', 'c', 'd', 'e', 'f' };
+    const uint8_t *ptr;
+
+    rc = ib_bytestr_dup_mem(&bs, MM(), data, sizeof(data));
+    ASSERT_EQ(IB_OK, rc);
+
+    rc = ib_bytestr_alias_range(&view, MM(), bs, 2, 3);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(view);
+    ASSERT_EQ(3UL, ib_bytestr_length(view));
+    ptr = ib_bytestr_const_ptr(view);
+    ASSERT_EQ(ib_bytestr_const_ptr(bs) + 2, ptr);
+    ASSERT_EQ(0, strncmp("cde", (char *)ptr, 3));
+    rc = ib_bytestr_append_nulstr(view, "foo");
+    ASSERT_EQ(IB_EINVAL, rc);
+
+    /* Empty view at the end of the source. */
+    rc = ib_bytestr_alias_range(&view, MM(), bs, 6, 0);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(0UL, ib_bytestr_length(view));
+
+    /* Ranges outside the source are rejected. */
+    rc = ib_bytestr_alias_range(&view, MM(), bs, 7, 0);
+    ASSERT_EQ(IB_EINVAL, rc);
+    rc = ib_bytestr_alias_range(&view, MM(), bs, 4, 3);
+    ASSERT_EQ(IB_EINVAL, rc);
+}
+
 /// @test Test util bytestr library - ib_bytestr_alias_nulstr()
 TEST_F(TestIBUtilByteStr, test_bytestr_alias_nulstr)
 {
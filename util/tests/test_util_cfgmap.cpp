@@ -134,6 +134,31 @@ TEST_F(TestIBUtilCfgMap, test_get)
     ASSERT_EQ(n, m_config.num1);
 }
 
+TEST_F(TestIBUtilCfgMap, test_entry)
+{
+    ib_status_t rc;
+    ib_field_t *f;
+    ib_num_t n;
+
+    rc = ib_cfgmap_entry(m_cfgmap, "xyzzy", &f);
+    ASSERT_EQ(IB_ENOENT, rc);
+
+    rc = ib_cfgmap_entry(m_cfgmap, "num1", &f);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(f);
+
+    /* The resolved entry reads and writes the map's storage directly. */
+    m_config.num1 = 1234;
+    rc = ib_field_value(f, ib_ftype_num_out(&n));
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1234, n);
+
+    n = 5678;
+    rc = ib_field_setv(f, ib_ftype_num_in(&n));
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(5678, m_config.num1);
+}
+
 TEST_F(TestIBUtilCfgMap, test_set)
 {
     ib_status_t rc;
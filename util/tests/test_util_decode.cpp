@@ -126,3 +126,111 @@ TEST(TestUtilHTMLEntity, Invalid)
     EXPECT_EQ("&#xg;&#Xg;&#xg0;\x02g;&#a;\0&#a2;\x03""a&#a00;\x01""a0;\x0a""a;&foo;", decode_html_entity("&#xg;&#Xg;&#xg0;&#X2g;&#a;\0&#a2;&#3" "a&#a00;&#1""a0;&#10a;&foo;"));
     EXPECT_EQ("&#xg&#Xg&#xg0\x02g&#a\0&#a2\x03""a&#a00\x01""a0\x0a""a&foo", decode_html_entity("&#xg&#Xg&#xg0&#X2g&#a\0&#a2&#3a" "&#a00&#1" "a0&#10a&foo"));
 }
+
+namespace {
+
+string decode_url_stream(const string& s, size_t split)
+{
+    ib_decode_url_state_t state;
+    memset(&state, 0, sizeof(state));
+
+    string out;
+    const string chunks[2] = { s.substr(0, split), s.substr(split) };
+    for (int i = 0; i < 2; ++i) {
+        vector<char> result(chunks[i].length() + 2);
+        size_t result_size;
+        throw_if_error(
+            ib_util_decode_url_stream(
+                &state,
+                reinterpret_cast<const uint8_t*>(chunks[i].data()),
+                chunks[i].length(),
+                reinterpret_cast<uint8_t *>(&result.front()),
+                &result_size,
+                i == 1
+            )
+        );
+        out.append(&result.front(), result_size);
+    }
+    return out;
+}
+
+string decode_html_entity_stream(const string& s, size_t split)
+{
+    ib_decode_html_entity_state_t state;
+    memset(&state, 0, sizeof(state));
+
+    string out;
+    const string chunks[2] = { s.substr(0, split), s.substr(split) };
+    for (int i = 0; i < 2; ++i) {
+        vector<char> result(
+            chunks[i].length() + IB_DECODE_HTML_ENTITY_CARRY
+        );
+        size_t result_size;
+        throw_if_error(
+            ib_util_decode_html_entity_stream(
+                &state,
+                reinterpret_cast<const uint8_t*>(chunks[i].data()),
+                chunks[i].length(),
+                reinterpret_cast<uint8_t *>(&result.front()),
+                &result_size,
+                i == 1
+            )
+        );
+        out.append(&result.front(), result_size);
+    }
+    return out;
+}
+
+}
+
+TEST(TestUtilDecodeUrl, Stream)
+{
+    const char* inputs[] = {
+        "",
+        "Test+Case",
+        "Test%20Case",
+        "%41%42%43",
+        "%",
+        "%4",
+        "%4g",
+        "%g4",
+        "%%41",
+        "a%2",
+        "trailing%"
+    };
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i) {
+        const string input(inputs[i]);
+        const string expected = decode_url(input);
+        for (size_t split = 0; split <= input.length(); ++split) {
+            EXPECT_EQ(expected, decode_url_stream(input, split))
+                << "input=" << input << " split=" << split;
+        }
+    }
+}
+
+TEST(TestUtilHTMLEntity, Stream)
+{
+    const char* inputs[] = {
+        "",
+        "TestCase",
+        "&quot;&amp;&lt;&gt;&nbsp;",
+        "&#x20;&#X20;&#32;&#100;",
+        "&#x20&#32&quot&amp",
+        "&#xg;&#a;&foo;&#10a;",
+        "&",
+        "&#",
+        "&#x",
+        "&#;&#x;&#xZ;&;",
+        "trailing&amp",
+        "trailing&#4",
+        "a&b&&c"
+    };
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i) {
+        const string input(inputs[i]);
+        const string expected = decode_html_entity(input);
+        for (size_t split = 0; split <= input.length(); ++split) {
+            EXPECT_EQ(expected, decode_html_entity_stream(input, split))
+                << "input=" << input << " split=" << split;
+        }
+    }
+}
@@ -691,3 +691,52 @@ TEST_F(TestIBUtilField, AliasConvert)
     ASSERT_EQ(IB_OK, rc);
     ASSERT_FLOAT_EQ(1.1, flt);
 }
+
+TEST_F(TestIBUtilField, BytestrAliasBatch)
+{
+    static const char *names[] = { "Host", "User-Agent", "X-Empty" };
+    static const char *values[] = { "example.com", "curl/8.0", "" };
+    ib_field_bytestr_descr_t descrs[3];
+    ib_field_t **fields;
+    const ib_bytestr_t *obs;
+    ib_status_t rc;
+
+    for (size_t i = 0; i < 3; ++i) {
+        descrs[i].name  = names[i];
+        descrs[i].nlen  = strlen(names[i]);
+        descrs[i].value = (const uint8_t *)values[i];
+        descrs[i].vlen  = strlen(values[i]);
+    }
+    /* NULL value is allowed when the length is 0. */
+    descrs[2].value = NULL;
+
+    /* Empty batch. */
+    fields = (ib_field_t **)&descrs;
+    rc = ib_field_create_bytestr_alias_batch(&fields, MM(), NULL, 0);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_FALSE(fields);
+
+    /* Invalid descriptors. */
+    rc = ib_field_create_bytestr_alias_batch(&fields, MM(), NULL, 1);
+    ASSERT_EQ(IB_EINVAL, rc);
+
+    rc = ib_field_create_bytestr_alias_batch(&fields, MM(), descrs, 3);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(fields);
+
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(IB_FTYPE_BYTESTR, fields[i]->type);
+        ASSERT_EQ(strlen(names[i]), fields[i]->nlen);
+        ASSERT_EQ(0, memcmp(names[i], fields[i]->name, fields[i]->nlen));
+        /* Names are copied, not aliased. */
+        ASSERT_NE(names[i], fields[i]->name);
+
+        rc = ib_field_value(fields[i], ib_ftype_bytestr_out(&obs));
+        ASSERT_EQ(IB_OK, rc);
+        ASSERT_EQ(strlen(values[i]), ib_bytestr_length(obs));
+        if (ib_bytestr_length(obs) > 0) {
+            /* Values are aliased, not copied. */
+            ASSERT_EQ((const uint8_t *)values[i], ib_bytestr_const_ptr(obs));
+        }
+    }
+}
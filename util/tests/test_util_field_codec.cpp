@@ -0,0 +1,255 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+/// @file
+/// @brief IronBee --- Binary Field Collection Codec Test Functions
+///
+/// @author Sam Baskinger <sbaskinger@qualys.com>
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ironbee_config_auto.h"
+
+#include "gtest/gtest.h"
+#include "simple_fixture.hpp"
+
+#include <ironbee/bytestr.h>
+#include <ironbee/field.h>
+#include <ironbee/field_codec.h>
+#include <ironbee/list.h>
+#include <ironbee/mm.h>
+#include <ironbee/string.h>
+#include <ironbee/util.h>
+
+#include <string>
+
+class TestIBUtilFieldCodec : public SimpleFixture
+{
+public:
+    TestIBUtilFieldCodec()
+    {
+        ib_util_initialize();
+    }
+
+    ~TestIBUtilFieldCodec()
+    {
+        ib_util_shutdown();
+    }
+
+    void AddNum(ib_list_t *list, const char *name, ib_num_t value)
+    {
+        ib_field_t *f;
+        ASSERT_EQ(IB_OK, ib_field_create(
+            &f, MM(), name, strlen(name),
+            IB_FTYPE_NUM, ib_ftype_num_in(&value)));
+        ASSERT_EQ(IB_OK, ib_list_push(list, f));
+    }
+
+    ib_list_t *RoundTrip(const ib_list_t *in)
+    {
+        uint8_t    *buf;
+        size_t      len;
+        ib_list_t  *out;
+        const char *error;
+
+        EXPECT_EQ(IB_OK, ib_field_codec_encode(MM(), in, &buf, &len));
+        EXPECT_EQ(IB_OK, ib_list_create(&out, MM()));
+        EXPECT_EQ(IB_OK, ib_field_codec_decode(MM(), buf, len, out, &error));
+
+        return out;
+    }
+};
+
+/* -- Tests -- */
+
+/// @test Round trip every supported scalar type.
+TEST_F(TestIBUtilFieldCodec, test_scalar_round_trip)
+{
+    ib_list_t    *in;
+    ib_list_t    *out;
+    ib_field_t   *f;
+    ib_num_t      num = -42;
+    ib_float_t    flt = 1.5;
+    ib_time_t     time = 123456789;
+    const char   *nulstr = "hello";
+    ib_bytestr_t *bs;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&in, MM()));
+
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("num"), IB_FTYPE_NUM, ib_ftype_num_in(&num)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("flt"), IB_FTYPE_FLOAT, ib_ftype_float_in(&flt)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("time"), IB_FTYPE_TIME, ib_ftype_time_in(&time)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("str"),
+        IB_FTYPE_NULSTR, ib_ftype_nulstr_in(nulstr)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    ASSERT_EQ(IB_OK, ib_bytestr_dup_nulstr(&bs, MM(), "bytes\0!"));
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("bs"), IB_FTYPE_BYTESTR, ib_ftype_bytestr_in(bs)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    out = RoundTrip(in);
+    ASSERT_EQ(5UL, ib_list_elements(out));
+
+    const ib_list_node_t *node = ib_list_first_const(out);
+
+    f = (ib_field_t *)ib_list_node_data_const(node);
+    ASSERT_EQ(IB_FTYPE_NUM, f->type);
+    ASSERT_EQ(std::string("num"), std::string(f->name, f->nlen));
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_num_out(&num)));
+    ASSERT_EQ(-42, num);
+
+    node = ib_list_node_next_const(node);
+    f = (ib_field_t *)ib_list_node_data_const(node);
+    ASSERT_EQ(IB_FTYPE_FLOAT, f->type);
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_float_out(&flt)));
+    ASSERT_EQ(1.5, flt);
+
+    node = ib_list_node_next_const(node);
+    f = (ib_field_t *)ib_list_node_data_const(node);
+    ASSERT_EQ(IB_FTYPE_TIME, f->type);
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_time_out(&time)));
+    ASSERT_EQ(123456789UL, time);
+
+    node = ib_list_node_next_const(node);
+    f = (ib_field_t *)ib_list_node_data_const(node);
+    ASSERT_EQ(IB_FTYPE_NULSTR, f->type);
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_nulstr_out(&nulstr)));
+    ASSERT_STREQ("hello", nulstr);
+
+    node = ib_list_node_next_const(node);
+    f = (ib_field_t *)ib_list_node_data_const(node);
+    ASSERT_EQ(IB_FTYPE_BYTESTR, f->type);
+    const ib_bytestr_t *bs_out;
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_bytestr_out(&bs_out)));
+    ASSERT_EQ(5UL, ib_bytestr_length(bs_out));
+    ASSERT_EQ(0, memcmp("bytes", ib_bytestr_const_ptr(bs_out), 5));
+}
+
+/// @test Round trip a nested list field.
+TEST_F(TestIBUtilFieldCodec, test_nested_list)
+{
+    ib_list_t  *in;
+    ib_list_t  *out;
+    ib_list_t  *sub;
+    ib_field_t *f;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&in, MM()));
+    ASSERT_EQ(IB_OK, ib_list_create(&sub, MM()));
+
+    AddNum(sub, "a", 1);
+    AddNum(sub, "b", 2);
+
+    ASSERT_EQ(IB_OK, ib_field_create(
+        &f, MM(), IB_S2SL("sub"), IB_FTYPE_LIST, ib_ftype_list_in(sub)));
+    ASSERT_EQ(IB_OK, ib_list_push(in, f));
+
+    out = RoundTrip(in);
+    ASSERT_EQ(1UL, ib_list_elements(out));
+
+    f = (ib_field_t *)ib_list_node_data_const(ib_list_first_const(out));
+    ASSERT_EQ(IB_FTYPE_LIST, f->type);
+    ASSERT_EQ(std::string("sub"), std::string(f->name, f->nlen));
+
+    const ib_list_t *sub_out;
+    ASSERT_EQ(IB_OK, ib_field_value(f, ib_ftype_list_out(&sub_out)));
+    ASSERT_EQ(2UL, ib_list_elements(sub_out));
+
+    f = (ib_field_t *)ib_list_node_data_const(ib_list_first_const(sub_out));
+    ASSERT_EQ(std::string("a"), std::string(f->name, f->nlen));
+}
+
+/// @test Repeated names are interned, not repeated in the buffer.
+TEST_F(TestIBUtilFieldCodec, test_name_interning)
+{
+    ib_list_t *one_name;
+    ib_list_t *many_names;
+    uint8_t   *buf;
+    size_t     interned_len;
+    size_t     distinct_len;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&one_name, MM()));
+    ASSERT_EQ(IB_OK, ib_list_create(&many_names, MM()));
+
+    for (int i = 0; i < 10; ++i) {
+        char distinct[32];
+        snprintf(distinct, sizeof(distinct), "quite_a_long_name_%d", i);
+        AddNum(one_name, "quite_a_long_name_0", i);
+        AddNum(many_names, distinct, i);
+    }
+
+    ASSERT_EQ(IB_OK,
+        ib_field_codec_encode(MM(), one_name, &buf, &interned_len));
+    ASSERT_EQ(IB_OK,
+        ib_field_codec_encode(MM(), many_names, &buf, &distinct_len));
+
+    /* The repeated name is written once; nine records carry an index. */
+    ASSERT_LT(interned_len + 9 * strlen("quite_a_long_name_0"), distinct_len + 9);
+
+    /* And it still decodes. */
+    ib_list_t *out = RoundTrip(one_name);
+    ASSERT_EQ(10UL, ib_list_elements(out));
+    const ib_field_t *f =
+        (const ib_field_t *)ib_list_node_data_const(ib_list_last_const(out));
+    ASSERT_EQ(std::string("quite_a_long_name_0"), std::string(f->name, f->nlen));
+}
+
+/// @test Bad marker, bad version and truncation fail with IB_EINVAL.
+TEST_F(TestIBUtilFieldCodec, test_decode_errors)
+{
+    ib_list_t  *in;
+    ib_list_t  *out;
+    uint8_t    *buf;
+    size_t      len;
+    const char *error;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&in, MM()));
+    AddNum(in, "n", 1);
+    ASSERT_EQ(IB_OK, ib_field_codec_encode(MM(), in, &buf, &len));
+
+    /* Not this codec's format at all. */
+    ASSERT_EQ(IB_OK, ib_list_create(&out, MM()));
+    ASSERT_EQ(IB_EINVAL, ib_field_codec_decode(
+        MM(), (const uint8_t *)"{\"n\":1}", 7, out, &error));
+    ASSERT_TRUE(error != NULL);
+
+    /* Future version. */
+    uint8_t versioned[2] = { buf[0], IB_FIELD_CODEC_VERSION + 1 };
+    ASSERT_EQ(IB_EINVAL, ib_field_codec_decode(
+        MM(), versioned, sizeof(versioned), out, &error));
+
+    /* Truncated buffer. */
+    ASSERT_EQ(IB_EINVAL, ib_field_codec_decode(
+        MM(), buf, len - 1, out, &error));
+
+    /* Trailing garbage. */
+    uint8_t *padded = (uint8_t *)ib_mm_alloc(MM(), len + 1);
+    memcpy(padded, buf, len);
+    padded[len] = 0x00;
+    ASSERT_EQ(IB_EINVAL, ib_field_codec_decode(
+        MM(), padded, len + 1, out, &error));
+}
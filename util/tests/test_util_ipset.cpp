@@ -28,6 +28,8 @@
 #include "gtest/gtest.h"
 
 #include <ironbee/ipset.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
 
 #include <stdexcept>
 #include <set>
@@ -620,3 +622,216 @@ TEST_F(TestIPSet, Inval)
         ib_ipset6_query(NULL, ib_ip6_t(), NULL, NULL, NULL)
     );
 }
+
+TEST_F(TestIPSet, Trie4)
+{
+    ib_status_t rc;
+    ib_ipset4_t set;
+    ib_mpool_t* mp;
+    vector<ib_ipset4_entry_t> positive;
+    vector<ib_ipset4_entry_t> negative;
+
+    static int marker_a = 1;
+    static int marker_b = 2;
+    static int marker_c = 3;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "Trie4", NULL));
+
+    positive.push_back(entry4(2, 1, 0, 0, 16));
+    positive.push_back(entry4(2, 5, 0, 0, 16));
+    positive.push_back(entry4(2, 4, 0, 0, 16));
+    positive.push_back(entry4(2, 6, 1, 0, 24));
+    positive.push_back(entry4(1, 0, 0, 0, 8, &marker_a));
+    positive.push_back(entry4(2, 0, 0, 0, 8));
+    positive.push_back(entry4(2, 3, 0, 0, 16, &marker_b));
+    positive.push_back(entry4(2, 3, 1, 0, 24, &marker_c));
+    positive.push_back(entry4(2, 2, 0, 0, 16));
+
+    negative.push_back(entry4(2, 5, 128, 0, 17));
+    negative.push_back(entry4(2, 2, 3,   0, 24));
+    negative.push_back(entry4(2, 2, 7,   0, 24));
+    negative.push_back(entry4(2, 2, 1,   0, 24));
+    negative.push_back(entry4(3, 0, 0,   0, 8));
+
+    rc = ib_ipset4_init_ex(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        ib_mm_mpool(mp), IB_IPSET_TRIE
+    );
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_TRUE(set.positive_trie);
+    EXPECT_TRUE(set.negative_trie);
+
+    const ib_ipset4_entry_t* entry    = NULL;
+    const ib_ipset4_entry_t* specific = NULL;
+    const ib_ipset4_entry_t* general  = NULL;
+
+    rc = ib_ipset4_query(
+        &set, ip4(1, 2, 100, 20),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_OK, rc);
+    EXPECT_EQ(entry, specific);
+    EXPECT_EQ(entry, general);
+    EXPECT_EQ(&marker_a, reinterpret_cast<const int*>(entry->data));
+    rc = ib_ipset4_query(
+        &set, ip4(2, 3, 1,   2),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_OK, rc);
+    EXPECT_LT(general, specific);
+    EXPECT_TRUE(entry == specific || entry == general);
+    EXPECT_EQ(&marker_b, reinterpret_cast<const int*>(general->data));
+    EXPECT_EQ(&marker_c, reinterpret_cast<const int*>(specific->data));
+    rc = ib_ipset4_query(
+        &set, ip4(2, 5, 130, 1),
+        &entry, &specific, &general
+    );
+    EXPECT_FALSE(entry);
+    EXPECT_FALSE(specific);
+    EXPECT_FALSE(general);
+    EXPECT_EQ(IB_ENOENT, rc);
+
+    ib_mpool_release(mp);
+}
+
+TEST_F(TestIPSet, TrieAggregation4)
+{
+    // Two negative /17s exactly cover 5.5.0.0/16 and are aggregated in the
+    // trie; membership must be as if the /16 itself were negative.
+    ib_status_t rc;
+    ib_ipset4_t set;
+    ib_mpool_t* mp;
+    vector<ib_ipset4_entry_t> positive;
+    vector<ib_ipset4_entry_t> negative;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "TrieAggregation4", NULL));
+
+    positive.push_back(entry4(5, 0, 0, 0, 8));
+    negative.push_back(entry4(5, 5, 0,   0, 17));
+    negative.push_back(entry4(5, 5, 128, 0, 17));
+
+    rc = ib_ipset4_init_ex(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        ib_mm_mpool(mp), IB_IPSET_TRIE
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    EXPECT_EQ(
+        IB_ENOENT,
+        ib_ipset4_query(&set, ip4(5, 5, 1, 1), NULL, NULL, NULL)
+    );
+    EXPECT_EQ(
+        IB_ENOENT,
+        ib_ipset4_query(&set, ip4(5, 5, 200, 1), NULL, NULL, NULL)
+    );
+    EXPECT_EQ(
+        IB_OK,
+        ib_ipset4_query(&set, ip4(5, 6, 0, 1), NULL, NULL, NULL)
+    );
+
+    ib_mpool_release(mp);
+}
+
+TEST_F(TestIPSet, Trie6)
+{
+    ib_status_t rc;
+    ib_ipset6_t set;
+    ib_mpool_t* mp;
+    vector<ib_ipset6_entry_t> positive;
+    vector<ib_ipset6_entry_t> negative;
+
+    static int marker_a = 1;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "Trie6", NULL));
+
+    positive.push_back(entry6(1, 0, 0, 0, 32, &marker_a));
+    negative.push_back(entry6(1, 2, 3, 0, 96));
+
+    rc = ib_ipset6_init_ex(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        ib_mm_mpool(mp), IB_IPSET_TRIE
+    );
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_TRUE(set.positive_trie);
+    EXPECT_TRUE(set.negative_trie);
+
+    const ib_ipset6_entry_t* result;
+    rc = ib_ipset6_query(&set, ip6(1, 2, 100, 20), &result, NULL, NULL);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(&marker_a, reinterpret_cast<const int*>(result->data));
+    rc = ib_ipset6_query(&set, ip6(1, 2, 3,   20), &result, NULL, NULL);
+    EXPECT_EQ(IB_ENOENT, rc);
+    EXPECT_FALSE(result);
+    rc = ib_ipset6_query(&set, ip6(3, 2, 3,   20), &result, NULL, NULL);
+    EXPECT_EQ(IB_ENOENT, rc);
+    EXPECT_FALSE(result);
+
+    ib_mpool_release(mp);
+}
+
+TEST_F(TestIPSet, TrieStructured4)
+{
+    static const size_t c_num_tests = (size_t)1e5;
+
+    ib_status_t rc;
+    ib_ipset4_t set;
+    ib_mpool_t* mp;
+    vector<ib_ipset4_entry_t> positive;
+    vector<ib_ipset4_entry_t> negative;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "TrieStructured4", NULL));
+
+    // As Structured4, but via the trie index.
+    for (size_t i = 1; i < 32; ++i) {
+        ib_ipset4_entry_t entry;
+        make_ones(entry.network.ip, i);
+        entry.network.size = i;
+        entry.data = NULL;
+        positive.push_back(entry);
+
+        if (entry.network.size <= 30) {
+            entry.network.size += 2;
+            negative.push_back(entry);
+        }
+    }
+
+    rc = ib_ipset4_init_ex(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        ib_mm_mpool(mp), IB_IPSET_TRIE
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    // Test a bunch of positives.
+    for (size_t i = 0; i < c_num_tests; ++i) {
+        ib_ip4_t ip;
+        size_t num_ones = random(1, 32);
+        make_ones(ip, num_ones);
+        if (num_ones <= 30) {
+            set_bit(ip, num_ones + 1);
+            for (size_t j = num_ones + 2; j <= 32; ++j) {
+                set_bit(ip, j, random(0,1));
+            }
+        }
+        rc = ib_ipset4_query(&set, ip, NULL, NULL, NULL);
+        ASSERT_EQ(IB_OK, rc);
+    }
+
+    // Test a bunch of negatives.
+    for (size_t i = 0; i < c_num_tests; ++i) {
+        ib_ip4_t ip;
+        char num_ones = random(1, 30);
+        make_ones(ip, num_ones);
+        rc = ib_ipset4_query(&set, ip, NULL, NULL, NULL);
+        ASSERT_EQ(IB_ENOENT, rc);
+    }
+
+    ib_mpool_release(mp);
+}
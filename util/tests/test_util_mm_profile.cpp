@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+/// @file
+/// @brief IronBee --- Memory manager allocation profiler tests
+///
+/// @author Sam Baskinger <sbaskinger@qualys.com>
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ironbee_config_auto.h"
+#include "simple_fixture.hpp"
+
+#include "gtest/gtest.h"
+
+#include <ironbee/mm_profile.h>
+
+#include <sstream>
+#include <string>
+
+class TestIBUtilMMProfile : public SimpleFixture
+{
+public:
+    virtual void SetUp()
+    {
+        SimpleFixture::SetUp();
+        ib_mm_profile_reset();
+    }
+
+    virtual void TearDown()
+    {
+        ib_mm_profile_reset();
+        SimpleFixture::TearDown();
+    }
+
+    std::string Report()
+    {
+        const char *report = NULL;
+        ib_status_t rc = ib_mm_profile_report(MM(), &report);
+        if (rc != IB_OK) {
+            throw std::runtime_error("Failed to build report.");
+        }
+        return std::string(report);
+    }
+};
+
+TEST_F(TestIBUtilMMProfile, EmptyReport)
+{
+    EXPECT_EQ(std::string(""), Report());
+}
+
+TEST_F(TestIBUtilMMProfile, RecordAndReport)
+{
+    int site_a;
+    int site_b;
+    int pool_1;
+    int pool_2;
+
+    ib_mm_profile_record(&site_a, 100, &pool_1);
+    ib_mm_profile_record(&site_a, 50,  &pool_2);
+    ib_mm_profile_record(&site_b, 10,  &pool_1);
+
+    std::string report = Report();
+
+    // site_a has more sampled bytes, so it is reported first.
+    std::ostringstream expected_first;
+    expected_first << (void *)&site_a << " 2 150 2";
+    EXPECT_EQ(0U, report.find(expected_first.str()));
+
+    std::ostringstream expected_second;
+    expected_second << (void *)&site_b << " 1 10 1";
+    EXPECT_NE(std::string::npos, report.find(expected_second.str()));
+}
+
+TEST_F(TestIBUtilMMProfile, Reset)
+{
+    int site;
+    int pool;
+
+    ib_mm_profile_record(&site, 100, &pool);
+    ib_mm_profile_reset();
+
+    EXPECT_EQ(std::string(""), Report());
+}
+
+TEST_F(TestIBUtilMMProfile, RepeatedPoolCountedOnce)
+{
+    int site;
+    int pool;
+
+    for (int i = 0; i < 10; ++i) {
+        ib_mm_profile_record(&site, 8, &pool);
+    }
+
+    std::ostringstream expected;
+    expected << (void *)&site << " 10 80 1";
+    EXPECT_EQ(0U, Report().find(expected.str()));
+}
@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+/// @file
+/// @brief IronBee --- Sampling profiler tests
+///
+/// @author Sam Baskinger <sbaskinger@qualys.com>
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ironbee_config_auto.h"
+#include "simple_fixture.hpp"
+
+#include "gtest/gtest.h"
+
+#include <ironbee/profiler.h>
+
+#include <string>
+
+class TestIBUtilProfiler : public SimpleFixture
+{
+public:
+    virtual void SetUp()
+    {
+        SimpleFixture::SetUp();
+
+        /* A long interval: samples in these tests are taken by hand. */
+        ASSERT_EQ(IB_OK, ib_profiler_start(10 * 1000 * 1000));
+        ASSERT_EQ(IB_OK, ib_profiler_stop());
+        ib_profiler_reset();
+    }
+
+    virtual void TearDown()
+    {
+        ib_profiler_reset();
+        SimpleFixture::TearDown();
+    }
+
+    std::string Report()
+    {
+        const char *report = NULL;
+        ib_status_t rc = ib_profiler_report(MM(), &report);
+        if (rc != IB_OK) {
+            throw std::runtime_error("Failed to build report.");
+        }
+        return std::string(report);
+    }
+};
+
+TEST_F(TestIBUtilProfiler, test_tags)
+{
+    int tag_a = ib_profiler_tag("test_tags_a");
+    int tag_b = ib_profiler_tag("test_tags_b");
+
+    ASSERT_GE(tag_a, 0);
+    ASSERT_GE(tag_b, 0);
+    ASSERT_NE(tag_a, tag_b);
+
+    /* Same name resolves to the same tag. */
+    ASSERT_EQ(tag_a, ib_profiler_tag("test_tags_a"));
+}
+
+TEST_F(TestIBUtilProfiler, test_folded_stacks)
+{
+    int tag_a = ib_profiler_tag("test_fold_a");
+    int tag_b = ib_profiler_tag("test_fold_b");
+
+    ib_profiler_enter(tag_a);
+    ib_profiler_sample();
+    ib_profiler_sample();
+
+    ib_profiler_enter(tag_b);
+    ib_profiler_sample();
+    ib_profiler_exit();
+
+    ib_profiler_exit();
+    ib_profiler_sample();
+
+    const std::string report = Report();
+
+    ASSERT_NE(std::string::npos, report.find("test_fold_a 2\n"));
+    ASSERT_NE(std::string::npos, report.find("test_fold_a;test_fold_b 1\n"));
+    ASSERT_NE(std::string::npos, report.find("(untagged) 1\n"));
+}
+
+TEST_F(TestIBUtilProfiler, test_reset)
+{
+    ib_profiler_enter(ib_profiler_tag("test_reset_a"));
+    ib_profiler_sample();
+    ib_profiler_exit();
+
+    ib_profiler_reset();
+
+    ASSERT_EQ("", Report());
+}
+
+TEST_F(TestIBUtilProfiler, test_depth_truncation)
+{
+    int tag = ib_profiler_tag("test_deep");
+
+    /* Enter twice the recordable depth; the sample is truncated but
+     * exits stay balanced. */
+    for (int i = 0; i < 2 * IB_PROFILER_MAX_DEPTH; ++i) {
+        ib_profiler_enter(tag);
+    }
+    ib_profiler_sample();
+    for (int i = 0; i < 2 * IB_PROFILER_MAX_DEPTH; ++i) {
+        ib_profiler_exit();
+    }
+    ib_profiler_sample();
+
+    const std::string report = Report();
+
+    std::string deep_stack = "test_deep";
+    for (int i = 1; i < IB_PROFILER_MAX_DEPTH; ++i) {
+        deep_stack += ";test_deep";
+    }
+
+    ASSERT_NE(std::string::npos, report.find(deep_stack + " 1\n"));
+    ASSERT_NE(std::string::npos, report.find("(untagged) 1\n"));
+}
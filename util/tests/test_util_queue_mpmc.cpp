@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+/// @file
+/// @brief IronBee --- Lock-Free MPMC Queue Test Functions
+///
+/// @author Sam Baskinger <sbaskinger@qualys.com>
+//////////////////////////////////////////////////////////////////////////////
+#include "ironbee_config_auto.h"
+
+#include <ironbee/mm_mpool.h>
+#include <ironbee/queue_mpmc.h>
+
+#include "gtest/gtest.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <vector>
+
+namespace {
+    const int NUM_PRODUCERS = 4;
+    const int NUM_CONSUMERS = 4;
+    const size_t PER_PRODUCER = 10000;
+    const size_t TOTAL = NUM_PRODUCERS * PER_PRODUCER;
+}
+
+class QueueMpmcTest : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        ASSERT_EQ(IB_OK, ib_mpool_create(&m_mp, "QueueMpmcTest", NULL));
+        ASSERT_EQ(
+            IB_OK,
+            ib_queue_mpmc_create(&m_q, ib_mm_mpool(m_mp), 128));
+    }
+    virtual void TearDown() {
+        ib_mpool_release(m_mp);
+    }
+    virtual ~QueueMpmcTest() {
+    }
+protected:
+    ib_mpool_t      *m_mp;
+    ib_queue_mpmc_t *m_q;
+};
+
+TEST_F(QueueMpmcTest, Init) {
+    ASSERT_FALSE(NULL == m_q);
+    ASSERT_EQ(128U, ib_queue_mpmc_capacity(m_q));
+    ASSERT_EQ(0U, ib_queue_mpmc_size(m_q));
+}
+
+TEST_F(QueueMpmcTest, BadCapacity) {
+    ib_queue_mpmc_t *q;
+    ASSERT_EQ(IB_EINVAL, ib_queue_mpmc_create(&q, ib_mm_mpool(m_mp), 0));
+    ASSERT_EQ(IB_EINVAL, ib_queue_mpmc_create(&q, ib_mm_mpool(m_mp), 1));
+    ASSERT_EQ(IB_EINVAL, ib_queue_mpmc_create(&q, ib_mm_mpool(m_mp), 48));
+}
+
+TEST_F(QueueMpmcTest, PushPopOrder) {
+    void *v;
+    ASSERT_EQ(IB_ENOENT, ib_queue_mpmc_try_pop(m_q, &v));
+    for (uintptr_t i = 1; i <= 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_queue_mpmc_try_push(m_q, (void *)i));
+    }
+    ASSERT_EQ(10U, ib_queue_mpmc_size(m_q));
+    for (uintptr_t i = 1; i <= 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_queue_mpmc_try_pop(m_q, &v));
+        ASSERT_EQ(i, (uintptr_t)v);
+    }
+    ASSERT_EQ(IB_ENOENT, ib_queue_mpmc_try_pop(m_q, &v));
+}
+
+TEST_F(QueueMpmcTest, Full) {
+    ib_queue_mpmc_t *q;
+    void *v;
+    ASSERT_EQ(IB_OK, ib_queue_mpmc_create(&q, ib_mm_mpool(m_mp), 4));
+    for (uintptr_t i = 1; i <= 4; ++i) {
+        ASSERT_EQ(IB_OK, ib_queue_mpmc_try_push(q, (void *)i));
+    }
+    ASSERT_EQ(IB_EAGAIN, ib_queue_mpmc_try_push(q, (void *)5));
+    ASSERT_EQ(IB_OK, ib_queue_mpmc_try_pop(q, &v));
+    ASSERT_EQ(IB_OK, ib_queue_mpmc_try_push(q, (void *)5));
+}
+
+TEST_F(QueueMpmcTest, WrapAround) {
+    ib_queue_mpmc_t *q;
+    void *v;
+    ASSERT_EQ(IB_OK, ib_queue_mpmc_create(&q, ib_mm_mpool(m_mp), 4));
+    for (uintptr_t lap = 0; lap < 100; ++lap) {
+        for (uintptr_t i = 1; i <= 3; ++i) {
+            ASSERT_EQ(IB_OK, ib_queue_mpmc_try_push(q, (void *)(lap + i)));
+        }
+        for (uintptr_t i = 1; i <= 3; ++i) {
+            ASSERT_EQ(IB_OK, ib_queue_mpmc_try_pop(q, &v));
+            ASSERT_EQ(lap + i, (uintptr_t)v);
+        }
+    }
+    ASSERT_EQ(0U, ib_queue_mpmc_size(q));
+}
+
+extern "C" {
+
+typedef struct {
+    ib_queue_mpmc_t *queue;
+    size_t           base;
+    size_t          *seen;          /* TOTAL slots, incremented per pop. */
+    volatile size_t *consumed;
+} worker_data_t;
+
+static void *producer_fn(void *arg)
+{
+    worker_data_t *data = (worker_data_t *)arg;
+    for (size_t i = 0; i < PER_PRODUCER; ++i) {
+        while (ib_queue_mpmc_try_push(
+                   data->queue,
+                   (void *)(uintptr_t)(data->base + i + 1)) != IB_OK)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer_fn(void *arg)
+{
+    worker_data_t *data = (worker_data_t *)arg;
+    for (;;) {
+        void *element;
+        if (*data->consumed >= TOTAL) {
+            if (ib_queue_mpmc_try_pop(data->queue, &element) != IB_OK) {
+                return NULL;
+            }
+            __sync_fetch_and_add(
+                &data->seen[(uintptr_t)element - 1], (size_t)1);
+            continue;
+        }
+        if (ib_queue_mpmc_try_pop(data->queue, &element) == IB_OK) {
+            __sync_fetch_and_add(
+                &data->seen[(uintptr_t)element - 1], (size_t)1);
+            __sync_fetch_and_add(data->consumed, (size_t)1);
+        }
+        else {
+            sched_yield();
+        }
+    }
+}
+
+}
+
+/* Each pushed element must be popped exactly once under contention. */
+TEST_F(QueueMpmcTest, ConcurrentStress) {
+    pthread_t producers[NUM_PRODUCERS];
+    pthread_t consumers[NUM_CONSUMERS];
+    worker_data_t producer_data[NUM_PRODUCERS];
+    worker_data_t consumer_data[NUM_CONSUMERS];
+    std::vector<size_t> seen(TOTAL, 0);
+    volatile size_t consumed = 0;
+
+    for (int i = 0; i < NUM_PRODUCERS; ++i) {
+        producer_data[i].queue = m_q;
+        producer_data[i].base = i * PER_PRODUCER;
+        producer_data[i].seen = NULL;
+        producer_data[i].consumed = NULL;
+        ASSERT_EQ(
+            0,
+            pthread_create(
+                &producers[i], NULL, producer_fn, &producer_data[i]));
+    }
+    for (int i = 0; i < NUM_CONSUMERS; ++i) {
+        consumer_data[i].queue = m_q;
+        consumer_data[i].base = 0;
+        consumer_data[i].seen = &seen[0];
+        consumer_data[i].consumed = &consumed;
+        ASSERT_EQ(
+            0,
+            pthread_create(
+                &consumers[i], NULL, consumer_fn, &consumer_data[i]));
+    }
+    for (int i = 0; i < NUM_PRODUCERS; ++i) {
+        ASSERT_EQ(0, pthread_join(producers[i], NULL));
+    }
+    for (int i = 0; i < NUM_CONSUMERS; ++i) {
+        ASSERT_EQ(0, pthread_join(consumers[i], NULL));
+    }
+
+    for (size_t i = 0; i < TOTAL; ++i) {
+        ASSERT_EQ(1U, seen[i]) << "element " << i;
+    }
+    ASSERT_EQ(0U, ib_queue_mpmc_size(m_q));
+}
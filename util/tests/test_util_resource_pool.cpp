@@ -206,6 +206,62 @@ TEST_F(ResourcePoolTest, limit_reached) {
     }
 }
 
+TEST_F(ResourcePoolTest, acquire_timeout_and_stats) {
+    ib_resource_t *ib_r[10];
+    ib_resource_pool_stats_t stats;
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[i]));
+    }
+
+    /* Empty and at the maximum; a short timed acquire must time out. */
+    {
+        ib_resource_t *extra;
+        ASSERT_EQ(
+            IB_ETIMEDOUT,
+            ib_resource_acquire_timeout(m_rp, 10000, &extra));
+    }
+
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r[0]));
+
+    /* With a free resource a timed acquire succeeds immediately. */
+    ASSERT_EQ(IB_OK, ib_resource_acquire_timeout(m_rp, 10000, &ib_r[0]));
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_release(ib_r[i]));
+    }
+
+    ib_resource_pool_stats_get(m_rp, &stats);
+    ASSERT_EQ(10U, stats.count);
+    ASSERT_EQ(10U, stats.free_count);
+    ASSERT_EQ(0U, stats.waiters);
+    ASSERT_EQ(12U, stats.acquires);
+    ASSERT_EQ(1U, stats.timeouts);
+    ASSERT_EQ(10U, stats.creates);
+}
+
+TEST_F(ResourcePoolTest, replenisher) {
+    ib_resource_t *ib_r;
+    ib_resource_pool_stats_t stats;
+
+    ASSERT_EQ(IB_OK, ib_resource_pool_set_min(m_rp, 3));
+    ASSERT_EQ(IB_OK, ib_resource_pool_replenisher_start(m_rp));
+
+    /* Draining the pool below the watermark wakes the replenisher. */
+    ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r));
+
+    for (int i = 0; i < 100; ++i) {
+        ib_resource_pool_stats_get(m_rp, &stats);
+        if (stats.free_count >= 3) {
+            break;
+        }
+        usleep(10000);
+    }
+    ASSERT_GE(stats.free_count, 3U);
+
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r));
+}
+
 /* Randomly create and destroy resources to potentially find
  * management problems. */
 TEST_F(ResourcePoolTest, create_destroy) {
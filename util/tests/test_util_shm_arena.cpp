@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Shared Memory Arena Tests
+ */
+
+#include <ironbee/shm_arena.h>
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+TEST(ShmArena, CreateAllocDestroy)
+{
+    ib_shm_arena_t *arena;
+    void *p1;
+    void *p2;
+
+    ASSERT_EQ(IB_OK, ib_shm_arena_create(&arena, 1024 * 1024));
+
+    p1 = ib_shm_arena_malloc(arena, 100);
+    ASSERT_TRUE(p1 != NULL);
+    p2 = ib_shm_arena_malloc(arena, 100);
+    ASSERT_TRUE(p2 != NULL);
+    ASSERT_NE(p1, p2);
+
+    /* Allocations are usable and tracked. */
+    memset(p1, 0xab, 100);
+    ASSERT_TRUE(ib_shm_arena_contains(arena, p1));
+    ASSERT_TRUE(ib_shm_arena_contains(arena, p2));
+    ASSERT_FALSE(ib_shm_arena_contains(arena, &arena));
+    ASSERT_LE(200UL, ib_shm_arena_used(arena));
+
+    ib_shm_arena_destroy(arena);
+}
+
+TEST(ShmArena, SealStopsAllocation)
+{
+    ib_shm_arena_t *arena;
+
+    ASSERT_EQ(IB_OK, ib_shm_arena_create(&arena, 1024 * 1024));
+    ASSERT_TRUE(ib_shm_arena_malloc(arena, 16) != NULL);
+
+    ib_shm_arena_seal(arena);
+    ASSERT_TRUE(ib_shm_arena_malloc(arena, 16) == NULL);
+
+    ib_shm_arena_destroy(arena);
+}
+
+TEST(ShmArena, ExhaustionReturnsNull)
+{
+    ib_shm_arena_t *arena;
+
+    ASSERT_EQ(IB_OK, ib_shm_arena_create(&arena, 8192));
+    ASSERT_TRUE(ib_shm_arena_malloc(arena, 1024 * 1024) == NULL);
+
+    ib_shm_arena_destroy(arena);
+}
+
+TEST(ShmArena, MpoolHooksFallBack)
+{
+    ib_shm_arena_t *arena;
+    void *in_arena;
+    void *on_heap;
+
+    ASSERT_EQ(IB_OK, ib_shm_arena_create(&arena, 1024 * 1024));
+    ib_shm_arena_select(arena);
+
+    in_arena = ib_shm_arena_mpool_malloc(64);
+    ASSERT_TRUE(in_arena != NULL);
+    ASSERT_TRUE(ib_shm_arena_contains(arena, in_arena));
+
+    /* Freeing an arena pointer is a no-op. */
+    ib_shm_arena_mpool_free(in_arena);
+
+    /* Once sealed, the hooks degrade to the heap. */
+    ib_shm_arena_seal(arena);
+    on_heap = ib_shm_arena_mpool_malloc(64);
+    ASSERT_TRUE(on_heap != NULL);
+    ASSERT_FALSE(ib_shm_arena_contains(arena, on_heap));
+    ib_shm_arena_mpool_free(on_heap);
+
+    ib_shm_arena_select(NULL);
+    ib_shm_arena_destroy(arena);
+}
@@ -110,6 +110,24 @@ TEST(TestString, strstr)
     EXPECT_FALSE(result);
 }
 
+TEST(TestString, streq_nocase)
+{
+    EXPECT_TRUE(ib_streq_nocase("hello", "HELLO", 5));
+    EXPECT_TRUE(ib_streq_nocase("hello", "hello", 5));
+    EXPECT_FALSE(ib_streq_nocase("hello", "jello", 5));
+    EXPECT_TRUE(ib_streq_nocase("", "", 0));
+
+    /* Embedded NULs do not terminate the compare. */
+    EXPECT_FALSE(ib_streq_nocase("a\0bc", "a\0bd", 4));
+    EXPECT_TRUE(ib_streq_nocase("a\0bc", "A\0BC", 4));
+
+    /* Longer than one compare block. */
+    const char *a = "The Quick Brown Fox Jumps Over The Lazy Dog";
+    const char *b = "the quick brown fox jumps over the lazy dog";
+    EXPECT_TRUE(ib_streq_nocase(a, b, strlen(a)));
+    EXPECT_FALSE(ib_streq_nocase(a + 1, b + 2, strlen(a) - 2));
+}
+
 TEST(TestString, num_to_string)
 {
     IronBee::ScopedMemoryPoolLite mpl;
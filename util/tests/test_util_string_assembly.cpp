@@ -63,3 +63,41 @@ TEST(TestStringAssembly, Basic)
     EXPECT_EQ("foobarbaz", string(s, s_length));
     EXPECT_FALSE(sa);
 }
+
+TEST(TestStringAssembly, CopyAndPrintf)
+{
+    ScopedMemoryPool smp;
+    MemoryPool mp(smp);
+
+    ib_status_t rc;
+    ib_sa_t *sa;
+
+    rc = ib_sa_begin(&sa);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(sa);
+
+    {
+        string temporary("foo");
+        rc = ib_sa_append_copy(sa, temporary.data(), temporary.length());
+        ASSERT_EQ(IB_OK, rc);
+    }
+    rc = ib_sa_printf(sa, "-%d-%s", 17, "bar");
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_sa_append(sa, "baz", 3);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(13UL, ib_sa_length(sa));
+
+    // Large enough to force a fresh writable block.
+    string big(1000, 'x');
+    rc = ib_sa_append_copy(sa, big.data(), big.length());
+    ASSERT_EQ(IB_OK, rc);
+
+    const char *s;
+    size_t s_length;
+
+    rc = ib_sa_finish(&sa, &s, &s_length, ib_mm_mpool(mp.ib()));
+    ASSERT_EQ(IB_OK, rc);
+
+    EXPECT_EQ("foo-17-bar" "baz" + big, string(s, s_length));
+    EXPECT_FALSE(sa);
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- String Interning Tests
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ **/
+
+#include "ironbee_config_auto.h"
+#include "gtest/gtest.h"
+
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/string.h>
+#include <ironbee/strintern.h>
+
+#include <string>
+
+using namespace std;
+
+namespace {
+
+class TestStrIntern : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        ASSERT_EQ(IB_OK, ib_mpool_lite_create(&m_mpl));
+        ASSERT_EQ(
+            IB_OK,
+            ib_strintern_create(&m_interns, ib_mm_mpool_lite(m_mpl))
+        );
+    }
+
+    void TearDown()
+    {
+        ib_mpool_lite_destroy(m_mpl);
+    }
+
+    ib_mpool_lite_t *m_mpl;
+    ib_strintern_t  *m_interns;
+};
+
+}
+
+TEST_F(TestStrIntern, Basic)
+{
+    const char *a = NULL;
+    const char *b = NULL;
+
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("foo"), &a));
+    ASSERT_TRUE(a);
+    EXPECT_NE(static_cast<const char *>("foo"), a);
+    EXPECT_EQ("foo", string(a, 3));
+
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("foo"), &b));
+    EXPECT_EQ(a, b);
+
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("bar"), &b));
+    EXPECT_NE(a, b);
+    EXPECT_EQ("bar", string(b, 3));
+}
+
+TEST_F(TestStrIntern, CaseInsensitive)
+{
+    const char *a = NULL;
+    const char *b = NULL;
+
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("Foo"), &a));
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("fOO"), &b));
+
+    EXPECT_EQ(a, b);
+    /* First spelling is canonical. */
+    EXPECT_EQ("Foo", string(a, 3));
+}
+
+TEST_F(TestStrIntern, Lookup)
+{
+    const char *a = NULL;
+    const char *b = NULL;
+
+    EXPECT_EQ(
+        IB_ENOENT,
+        ib_strintern_lookup(m_interns, IB_S2SL("foo"), &b)
+    );
+
+    ASSERT_EQ(IB_OK, ib_strintern_intern(m_interns, IB_S2SL("foo"), &a));
+    ASSERT_EQ(IB_OK, ib_strintern_lookup(m_interns, IB_S2SL("FOO"), &b));
+    EXPECT_EQ(a, b);
+}
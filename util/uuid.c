@@ -19,49 +19,170 @@
  * @file
  * @brief UUID helper functions
  * @author Christopher Alfeld <calfeld@qualys.com>
- * @todo Add bin to ascii
  */
 
 #include "ironbee_config_auto.h"
 
-#include <uuid.h>
-
 #include <ironbee/uuid.h>
 
-#include <ironbee/lock.h>
-
 #include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 /*
- * These are initialized by ib_uuid_init();
- * OSSP UUID is ... generous .. in what it creates for a UUID.  E.g., it will
- * do multiple allocations, check its MAC (it may have changed?), etc. for
- * every creation.  So we only keep one at reuse it.
+ * V4 UUIDs are pure randomness, so all we need per thread is a PRNG seeded
+ * once from the system random source.  Earlier versions delegated to OSSP
+ * UUID under a global lock, which serialized every transaction at high
+ * rates; a per-thread xorshift128+ state generates the 16 random bytes
+ * lock-free and a lookup table formats two hex characters per byte store.
  */
-static ib_lock_t *g_uuid_lock;
-static uuid_t    *g_ossp_uuid;
 
-ib_status_t ib_uuid_initialize(void)
+/** Per-thread PRNG state (xorshift128+). */
+typedef struct uuid_prng_t uuid_prng_t;
+struct uuid_prng_t {
+    uint64_t s[2];
+    /*! Pid the state was seeded in; a forked child must not replay the
+     *  parent's sequence, so a mismatch forces a reseed. */
+    pid_t    pid;
+};
+
+/** Key for per-thread PRNG state; created in ib_uuid_initialize(). */
+static pthread_key_t g_uuid_prng_key;
+
+/** Was @ref g_uuid_prng_key created? */
+static bool g_uuid_initialized = false;
+
+/** Hex pairs for every byte value: "000102...ff". */
+static const char c_hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+static void uuid_prng_destroy(void *data)
 {
-    ib_status_t rc;
+    free(data);
+}
 
-    if (uuid_create(&g_ossp_uuid) != UUID_RC_OK) {
-        return IB_EOTHER;
+/**
+ * Seed a PRNG state from the system random source.
+ *
+ * Falls back to mixing the clock, pid, and thread id if /dev/urandom is
+ * unavailable.
+ *
+ * @param[out] prng State to seed.
+ **/
+static void uuid_prng_seed(uuid_prng_t *prng)
+{
+    assert(prng != NULL);
+
+    bool seeded = false;
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if (fp != NULL) {
+        seeded = (fread(prng->s, sizeof(prng->s), 1, fp) == 1);
+        fclose(fp);
+    }
+    if (! seeded) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        prng->s[0] = ((uint64_t)tv.tv_sec << 32) ^ (uint64_t)tv.tv_usec;
+        prng->s[1] = ((uint64_t)getpid() << 32) ^
+                     (uint64_t)(uintptr_t)pthread_self();
     }
+    /* xorshift128+ requires a non-zero state. */
+    if (prng->s[0] == 0 && prng->s[1] == 0) {
+        prng->s[0] = 1;
+    }
+    prng->pid = getpid();
+}
+
+/**
+ * Fetch this thread's PRNG state, creating and seeding it on first use.
+ *
+ * Reseeds state inherited across fork(): servers that embed the engine
+ * typically create it in the master process before forking workers, and
+ * without this every worker would emit the master's UUID sequence.
+ *
+ * @return State or NULL on allocation failure.
+ **/
+static uuid_prng_t *uuid_prng_get(void)
+{
+    uuid_prng_t *prng = pthread_getspecific(g_uuid_prng_key);
+    if (prng == NULL) {
+        prng = malloc(sizeof(*prng));
+        if (prng == NULL) {
+            return NULL;
+        }
+        uuid_prng_seed(prng);
+        if (pthread_setspecific(g_uuid_prng_key, prng) != 0) {
+            free(prng);
+            return NULL;
+        }
+    }
+    else if (prng->pid != getpid()) {
+        uuid_prng_seed(prng);
+    }
+    return prng;
+}
 
-    rc = ib_lock_create_malloc(&g_uuid_lock);
-    if ( rc != IB_OK ) {
-        return rc;
+/**
+ * Generate the next 64 random bits (xorshift128+).
+ *
+ * @param[in] prng PRNG state.
+ * @return Random bits.
+ **/
+static uint64_t uuid_prng_next(uuid_prng_t *prng)
+{
+    uint64_t x = prng->s[0];
+    const uint64_t y = prng->s[1];
+
+    prng->s[0] = y;
+    x ^= x << 23;
+    prng->s[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+
+    return prng->s[1] + y;
+}
+
+ib_status_t ib_uuid_initialize(void)
+{
+    if (g_uuid_initialized) {
+        return IB_OK;
+    }
+    if (pthread_key_create(&g_uuid_prng_key, uuid_prng_destroy) != 0) {
+        return IB_EOTHER;
     }
+    g_uuid_initialized = true;
 
-    return rc;
+    return IB_OK;
 }
 
 ib_status_t ib_uuid_shutdown(void)
 {
-    ib_lock_destroy_malloc(g_uuid_lock);
-    uuid_destroy(g_ossp_uuid);
+    if (g_uuid_initialized) {
+        /* This thread's state is the only one we can still reach; states
+         * of other (exited) threads were released by the key destructor. */
+        uuid_prng_destroy(pthread_getspecific(g_uuid_prng_key));
+        pthread_key_delete(g_uuid_prng_key);
+        g_uuid_initialized = false;
+    }
 
     return IB_OK;
 }
@@ -70,42 +191,31 @@ ib_status_t ib_uuid_create_v4(char *uuid)
 {
     assert(uuid != NULL);
 
-    ib_status_t rc;
-    uuid_rc_t uuid_rc;
-    size_t uuid_len = UUID_LEN_STR+1;
-
-    rc = ib_lock_lock(g_uuid_lock);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    uuid_rc = uuid_make(g_ossp_uuid, UUID_MAKE_V4);
-    if (uuid_rc == UUID_RC_MEM) {
-        rc = IB_EALLOC;
-        goto finish;
-    }
-    else if (uuid_rc != UUID_RC_OK) {
-        rc = IB_EOTHER;
-        goto finish;
-    }
+    uint8_t octets[16];
+    uint64_t r;
 
-    uuid_rc = uuid_export(
-        g_ossp_uuid, UUID_FMT_STR,
-        (void *)&uuid, &uuid_len
-    );
-    if (uuid_rc == UUID_RC_MEM) {
-        rc = IB_EALLOC;
-        goto finish;
-    }
-    else if (uuid_rc != UUID_RC_OK || uuid_len != UUID_LEN_STR+1) {
-        rc = IB_EOTHER;
-        goto finish;
+    uuid_prng_t *prng = uuid_prng_get();
+    if (prng == NULL) {
+        return IB_EALLOC;
     }
 
-finish:
-    if (ib_lock_unlock(g_uuid_lock) != IB_OK) {
-        return IB_EOTHER;
+    r = uuid_prng_next(prng);
+    memcpy(octets, &r, 8);
+    r = uuid_prng_next(prng);
+    memcpy(octets + 8, &r, 8);
+
+    /* RFC 4122: version 4, variant 10. */
+    octets[6] = (octets[6] & 0x0f) | 0x40;
+    octets[8] = (octets[8] & 0x3f) | 0x80;
+
+    for (int i = 0, out = 0; i < 16; ++i) {
+        memcpy(uuid + out, c_hex_pairs + 2 * octets[i], 2);
+        out += 2;
+        if (i == 3 || i == 5 || i == 7 || i == 9) {
+            uuid[out++] = '-';
+        }
     }
+    uuid[IB_UUID_LENGTH - 1] = '\0';
 
-    return rc;
+    return IB_OK;
 }